@@ -198,7 +198,7 @@ api_doc_structure = {
               r'mitsuba.Color([\w]+)',
               r'mitsuba.Ray([\w]+)'],
     'Constants': [r'mitsuba.MI_([\w]+)', r'mitsuba.is_([\w]+)', 'mitsuba.DEBUG'],
-    'Denoiser': ['mitsuba.OptixDenoiser'],
+    'Denoiser': ['mitsuba.OptixDenoiser', 'mitsuba.OIDNDenoiser'],
     'BSDF': [r'mitsuba.BSDF([\w]*)', 'mitsuba.TransportMode',
              r'mitsuba.Microfacet([\w]+)'],
     'Integrator': [r'mitsuba.(.*)Integrator([\w]*)', 'mitsuba.ad.common.mis_weight'],
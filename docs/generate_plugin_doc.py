@@ -14,6 +14,7 @@ SHAPE_ORDERING = [
     'serialized',
     'cube'
     'sphere',
+    'spheres',
     'disk',
     'cylinder',
     'bsplinecurve',
@@ -22,7 +23,10 @@ SHAPE_ORDERING = [
     'cube',
     'sdfgrid',
     'shapegroup',
-    'instance'
+    'instance',
+    'lazymesh',
+    'lod',
+    'displacement'
 ]
 
 BSDF_ORDERING = [
@@ -68,6 +72,8 @@ TEXTURE_ORDERING = [
     'bitmap',
     'checkerboard',
     'mesh_attribute',
+    'tiledbitmap',
+    'udim',
     'volume'
 ]
 
@@ -85,12 +91,15 @@ SAMPLER_ORDERING = [
     'stratified',
     'multijitter',
     'orthogonal',
-    'ldsampler'
+    'ldsampler',
+    'zsobol'
 ]
 
 INTEGRATOR_ORDERING = [
     'direct',
     'path',
+    'guided',
+    'irrcache',
     'aov',
     'volpath',
     'volpathmis',
@@ -128,7 +137,8 @@ PHASE_ORDERING = [
 
 VOLUME_ORDERING = [
     'constvolume',
-    'gridvolume'
+    'gridvolume',
+    'sparsegridvolume'
 ]
 
 
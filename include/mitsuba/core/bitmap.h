@@ -1,9 +1,12 @@
 #pragma once
 
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/struct.h>
 #include <mitsuba/core/vector.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/rfilter.h>
+#include <memory>
+#include <mutex>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -387,10 +390,69 @@ public:
     void write(const fs::path &path, FileFormat format = FileFormat::Auto,
                int quality = -1) const;
 
-    /// Equivalent to \ref write(), but executes asynchronously on a different thread
+    /**
+     * \brief Equivalent to \ref write(), but executes asynchronously on a
+     * different thread
+     *
+     * At most \ref async_write_limit() writes are pending at any time: when
+     * the limit is reached, this function blocks until an earlier write has
+     * finished, which bounds the memory held by queued images. Use \ref
+     * Thread::wait_for_tasks() to wait for all pending writes.
+     */
     void write_async(const fs::path &path, FileFormat format = FileFormat::Auto,
                      int quality = -1) const;
 
+    /**
+     * \brief Set the maximum number of pending \ref write_async() calls
+     *
+     * The default value is 4.
+     */
+    static void set_async_write_limit(uint32_t limit);
+
+    /// Return the maximum number of pending \ref write_async() calls
+    static uint32_t async_write_limit();
+
+    /**
+     * \brief Write several bitmaps as the named parts of a multi-part
+     * OpenEXR file
+     *
+     * The parts may differ in resolution and channel layout. The \c quality
+     * parameter has the same meaning as in \ref write().
+     */
+    static void write_exr_multipart(
+        Stream *stream,
+        const std::vector<std::pair<std::string, ref<Bitmap>>> &parts,
+        int quality = -1);
+
+    /// Equivalent to the above, but writes to a file
+    static void write_exr_multipart(
+        const fs::path &path,
+        const std::vector<std::pair<std::string, ref<Bitmap>>> &parts,
+        int quality = -1);
+
+    /**
+     * \brief Set the tile size of OpenEXR files written by \ref write()
+     *
+     * Tiled files can be read region by region (e.g. by \ref
+     * BitmapRegionReader). The default value of 0 writes scanline files.
+     */
+    static void set_exr_tile_size(uint32_t size);
+
+    /// Return the tile size of written OpenEXR files (0: scanline files)
+    static uint32_t exr_tile_size();
+
+    /**
+     * \brief Set the number of line buffers or tiles that OpenEXR compresses
+     * and decompresses in parallel
+     *
+     * The default value of -1 matches \ref Thread::thread_count(), and 0
+     * disables multithreading.
+     */
+    static void set_exr_thread_count(int count);
+
+    /// Return the number of line buffers or tiles processed in parallel by OpenEXR
+    static int exr_thread_count();
+
     /**
      * \brief Up- or down-sample this image to a different resolution
      *
@@ -652,6 +714,7 @@ public:
      bool m_premultiplied_alpha;
      bool m_owns_data;
      Properties m_metadata;
+     MemoryAllocation m_memory { MemoryCategory::Bitmap };
 };
 
 
@@ -724,6 +787,116 @@ void accumulate_2d(ConstT source,
     }
 }
 
+/**
+ * \brief Reads rectangular regions of an OpenEXR image on demand
+ *
+ * In contrast to \ref Bitmap, which loads an image in its entirety, this
+ * class only reads the header of the file when it is constructed. The pixels
+ * of a region are decoded by \ref read(), which only touches the tiles (for
+ * tiled files) or scanlines (for scanline files) that intersect it.
+ * MIP-mapped files are read at their full resolution level.
+ *
+ * The image is exposed as linear single precision data with one (luminance
+ * or the first channel) or three (RGB) channels. All methods are thread-safe.
+ */
+class MI_EXPORT_LIB BitmapRegionReader : public Object {
+public:
+    using Vector2u = Bitmap::Vector2u;
+
+    /// Open the OpenEXR file at the given path and read its header
+    BitmapRegionReader(const fs::path &path);
+
+    /// Return the resolution of the image
+    const Vector2u &size() const { return m_size; }
+
+    /// Return the number of channels (1 or 3) produced by \ref read()
+    uint32_t channel_count() const { return m_channel_count; }
+
+    /// Is the image stored in tiles (as opposed to scanlines)?
+    bool tiled() const;
+
+    /**
+     * \brief Read the pixels of the region with the given offset and size
+     *
+     * The region must lie within the image. Its pixels are written to
+     * \c dest in row-major order with \ref channel_count() values each.
+     */
+    void read(const Vector2u &offset, const Vector2u &size, float *dest) const;
+
+    std::string to_string() const override;
+
+    MI_DECLARE_CLASS()
+protected:
+    ~BitmapRegionReader();
+
+    struct EXRFile;
+    std::unique_ptr<EXRFile> m_file;
+    fs::path m_path;
+    Vector2u m_size;
+    uint32_t m_channel_count;
+    mutable std::mutex m_mutex;
+};
+
+/**
+ * \brief Writes a tiled OpenEXR image incrementally, one row of tiles at a time
+ *
+ * This makes it possible to write images that do not fit into memory as a
+ * whole. The file is created when the first row is written, using the
+ * channels and metadata of that bitmap. All rows must have the same channel
+ * layout. The file is complete once every row has been written and the
+ * writer is destroyed. All methods are thread-safe.
+ */
+class MI_EXPORT_LIB BitmapTileWriter : public Object {
+public:
+    using Vector2u = Bitmap::Vector2u;
+
+    /**
+     * \brief Prepare writing an image of the given size to \c path
+     *
+     * \param tile_size
+     *    Width and height of the tiles of the file
+     *
+     * \param quality
+     *    Compression setting with the same meaning as in \ref Bitmap::write()
+     */
+    BitmapTileWriter(const fs::path &path, const Vector2u &size,
+                     uint32_t tile_size, int quality = -1);
+
+    /// Return the resolution of the image
+    const Vector2u &size() const { return m_size; }
+
+    /// Return the width and height of the tiles
+    uint32_t tile_size() const { return m_tile_size; }
+
+    /// Return the number of rows of tiles
+    uint32_t row_count() const {
+        return (m_size.y() + m_tile_size - 1) / m_tile_size;
+    }
+
+    /**
+     * \brief Write the row of tiles with index \c row
+     *
+     * The bitmap must span the width of the image, and it must be \ref
+     * tile_size() pixels tall (or less for the last row).
+     */
+    void write_row(uint32_t row, const Bitmap *bitmap);
+
+    std::string to_string() const override;
+
+    MI_DECLARE_CLASS()
+protected:
+    ~BitmapTileWriter();
+
+    struct EXRFile;
+    std::unique_ptr<EXRFile> m_file;
+    fs::path m_path;
+    Vector2u m_size;
+    uint32_t m_tile_size;
+    int m_quality;
+    uint32_t m_rows_written = 0;
+    std::mutex m_mutex;
+};
+
 extern MI_EXPORT_LIB std::ostream &operator<<(std::ostream &os, Bitmap::PixelFormat value);
 extern MI_EXPORT_LIB std::ostream &operator<<(std::ostream &os, Bitmap::FileFormat value);
 extern MI_EXPORT_LIB std::ostream &operator<<(std::ostream &os, Bitmap::AlphaTransform value);
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <mitsuba/core/stream.h>
+#include <cstring>
+
+NAMESPACE_BEGIN(mitsuba)
+
+NAMESPACE_BEGIN(detail)
+/// Default size of the read buffer of a \ref BufferedStream
+constexpr size_t kBufferedStreamSize = 1024 * 1024;
+NAMESPACE_END(detail)
+
+/**
+ * \brief Read buffer layered on top of another (seekable) stream
+ *
+ * Loaders often read files using many small reads of individual values,
+ * each of which results in a virtual function call and a request to the
+ * child stream (e.g. to ``std::fstream`` in the case of a \ref FileStream).
+ * This class instead fetches large sequential chunks of the child stream,
+ * from which subsequent reads are served. Reads that are larger than the
+ * buffer directly access the child stream.
+ *
+ * The templated \ref read() function is furthermore inlined: when the
+ * static type of a stream is \c BufferedStream, reading an arithmetic value
+ * reduces to a copy from the buffer.
+ *
+ * Writes are passed through to the child stream and discard the contents of
+ * the buffer. The child stream must implement \ref seek(), \ref tell() and
+ * \ref size(), hence e.g. a \ref ZStream cannot be buffered.
+ */
+class MI_EXPORT_LIB BufferedStream : public Stream {
+public:
+    using Stream::write;
+
+    /** \brief Creates a new buffered stream on top of the given child stream
+     *
+     * The buffered stream takes ownership of the child stream, and reads
+     * start at the current position of the child stream.
+     */
+    BufferedStream(Stream *child_stream,
+                   size_t buffer_size = detail::kBufferedStreamSize);
+
+    /// Destructor
+    ~BufferedStream();
+
+    /// Returns a string representation
+    std::string to_string() const override;
+
+    /** \brief Closes the stream and the underlying child stream.
+     * No further read or write operations are permitted.
+     *
+     * This function is idempotent.
+     */
+    void close() override;
+
+    /// Whether the stream is closed (no read or write are then permitted).
+    bool is_closed() const override { return m_child_stream->is_closed(); }
+
+    // =========================================================================
+    //! @{ \name Buffered stream-specific features
+    // =========================================================================
+
+    /// Returns the child stream of this buffered stream
+    const Stream *child_stream() const { return m_child_stream.get(); }
+
+    /// Returns the child stream of this buffered stream
+    Stream *child_stream() { return m_child_stream; }
+
+    /// Returns the size of the read buffer in bytes
+    size_t buffer_size() const { return m_buffer_size; }
+
+    /**
+     * \brief Reads one object of type T from the stream
+     *
+     * Arithmetic values that are available in the buffer and don't require
+     * an endianness swap are copied directly. All other reads go through
+     * \ref Stream::read().
+     */
+    template <typename T> void read(T &value) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            if (likely(m_pos + sizeof(T) <= m_end && !needs_endianness_swap())) {
+                std::memcpy(&value, m_buffer.get() + m_pos, sizeof(T));
+                m_pos += sizeof(T);
+                return;
+            }
+        }
+        Stream::read(value);
+    }
+
+    /// Convenience function for reading a line of text from an ASCII file
+    std::string read_line() override;
+
+    //! @}
+    // =========================================================================
+
+    // =========================================================================
+    //! @{ \name Implementation of the Stream interface
+    // =========================================================================
+
+    /**
+     * \brief Reads a specified amount of data from the stream.
+     * Throws an exception when the stream ended prematurely.
+     */
+    void read(void *p, size_t size) override;
+
+    /**
+     * \brief Writes a specified amount of data into the child stream.
+     * Throws an exception when not all data could be written.
+     */
+    void write(const void *p, size_t size) override;
+
+    /// Seeks to a position inside the stream, reusing the buffer if possible
+    void seek(size_t pos) override;
+
+    /// Truncates the child stream to a given size
+    void truncate(size_t size) override;
+
+    /// Gets the current position inside the stream
+    size_t tell() const override { return m_offset + m_pos; }
+
+    /// Returns the size of the child stream
+    size_t size() const override { return m_child_stream->size(); }
+
+    /// Flushes the child stream
+    void flush() override { m_child_stream->flush(); }
+
+    /// Can we write to the stream?
+    bool can_write() const override { return m_child_stream->can_write(); }
+
+    /// Can we read from the stream?
+    bool can_read() const override { return m_child_stream->can_read(); }
+
+    //! @}
+    // =========================================================================
+
+    MI_DECLARE_CLASS()
+
+private:
+    /// Discard the buffer and fetch the data that follows the current position
+    void fill();
+
+    /// Discard the buffer, keeping the current position
+    void discard() {
+        m_offset += m_pos;
+        m_pos = m_end = 0;
+    }
+
+    ref<Stream> m_child_stream;
+    std::unique_ptr<uint8_t[]> m_buffer;
+    size_t m_buffer_size;
+    /// Position of the buffer within the child stream
+    size_t m_offset;
+    /// Read position and amount of valid data within the buffer
+    size_t m_pos, m_end;
+    /// Whether the child stream must be flushed before reading from it
+    bool m_did_write;
+};
+
+NAMESPACE_END(mitsuba)
@@ -4,6 +4,8 @@
 #include <mitsuba/core/vector.h>
 #include <mitsuba/core/math.h>
 #include <drjit/dynamic.h>
+#include <nanothread/nanothread.h>
+#include <algorithm>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -16,6 +18,12 @@ NAMESPACE_BEGIN(mitsuba)
  * probability mass functions (PMFs) will automatically be normalized during
  * initialization. The associated scale factor can be retrieved using the
  * function \ref normalization().
+ *
+ * By default, samples are generated by inverting the cumulative distribution
+ * function using a binary search, which takes logarithmic time. Optionally,
+ * an alias table (Walker/Vose) can be built during initialization, in which
+ * case the sampling routines run in constant time using two lookups. Note
+ * that the two methods map a given uniform sample to different indices.
  */
 template <typename Value> struct DiscreteDistribution {
     using Float = std::conditional_t<dr::is_static_array_v<Value>,
@@ -33,21 +41,28 @@ public:
     /// Create an uninitialized DiscreteDistribution instance
     DiscreteDistribution() { }
 
-    /// Initialize from a given probability mass function
-    DiscreteDistribution(const FloatStorage &pmf)
-        : m_pmf(pmf) {
+    /**
+     * \brief Initialize from a given probability mass function
+     *
+     * When \c alias_table is \c true, sampling uses an alias table (see the
+     * class description).
+     */
+    DiscreteDistribution(const FloatStorage &pmf, bool alias_table = false)
+        : m_pmf(pmf), m_use_alias_table(alias_table) {
         update();
     }
 
     /// Initialize from a given probability mass function (rvalue version)
-    DiscreteDistribution(FloatStorage &&pmf)
-        : m_pmf(std::move(pmf)) {
+    DiscreteDistribution(FloatStorage &&pmf, bool alias_table = false)
+        : m_pmf(std::move(pmf)), m_use_alias_table(alias_table) {
         update();
     }
 
     /// Initialize from a given floating point array
-    DiscreteDistribution(const ScalarFloat *values, size_t size)
-        : m_pmf(dr::load<FloatStorage>(values, size)) {
+    DiscreteDistribution(const ScalarFloat *values, size_t size,
+                         bool alias_table = false)
+        : m_pmf(dr::load<FloatStorage>(values, size)),
+          m_use_alias_table(alias_table) {
         compute_cdf_scalar(values, size);
     }
 
@@ -71,6 +86,19 @@ public:
     /// Return the unnormalized cumulative distribution function (const version)
     const FloatStorage &cdf() const { return m_cdf; }
 
+    /// Does this distribution sample using an alias table?
+    bool has_alias_table() const { return m_use_alias_table; }
+
+    /**
+     * \brief Enable or disable sampling using an alias table
+     *
+     * This function updates the internal state (see \ref update()).
+     */
+    void set_alias_table(bool value) {
+        m_use_alias_table = value;
+        update();
+    }
+
     /// \brief Return the original sum of PMF entries before normalization
     Float sum() const { return m_sum; }
 
@@ -116,6 +144,9 @@ public:
     Index sample(Value sample, Mask active = true) const {
         MI_MASK_ARGUMENT(active);
 
+        if (m_use_alias_table)
+            return sample_alias(sample, active).first;
+
         sample *= m_sum;
 
         return dr::binary_search<Index>(
@@ -173,6 +204,9 @@ public:
     sample_reuse(Value value, Mask active = true) const {
         MI_MASK_ARGUMENT(active);
 
+        if (m_use_alias_table)
+            return sample_alias(value, active);
+
         Index index = sample(value, active);
 
         Value pmf = eval_pmf_normalized(index, active),
@@ -202,6 +236,11 @@ public:
     sample_reuse_pmf(Value value, Mask active = true) const {
         MI_MASK_ARGUMENT(active);
 
+        if (m_use_alias_table) {
+            auto [index, reused] = sample_alias(value, active);
+            return { index, reused, eval_pmf_normalized(index, active) };
+        }
+
         auto [index, pdf] = sample_pmf(value, active);
 
         Value pmf = eval_pmf_normalized(index, active),
@@ -215,6 +254,113 @@ public:
     }
 
 private:
+    /**
+     * \brief Sample using the alias table and return the chosen index along
+     * with the re-scaled sample value
+     */
+    std::pair<Index, Value> sample_alias(Value value, Mask active) const {
+        uint32_t size = (uint32_t) m_pmf.size();
+        Value scaled = value * (ScalarFloat) size;
+        Index bin = dr::minimum(Index(scaled), size - 1u);
+        scaled -= Value(bin);
+
+        Value prob = dr::gather<Value>(m_alias_prob, bin, active);
+        Index alias = dr::gather<Index>(m_alias_index, bin, active);
+        Mask keep = scaled < prob;
+
+        return { dr::select(keep, bin, alias),
+                 dr::select(keep, scaled / prob,
+                            (scaled - prob) / (1.f - prob)) };
+    }
+
+    /**
+     * \brief Build the alias table
+     *
+     * Entries are scaled so that their mean is 1 and split into "light"
+     * (< 1) and "heavy" (>= 1) ones. Sweeping both lists in order, every
+     * light entry donates its remaining capacity to the current heavy one,
+     * which itself becomes light once its excess is used up (following
+     * "Parallel Weighted Random Sampling" by Hübschle-Schneider and Sanders).
+     * Given prefix sums of the deficits and excesses, the partner of every
+     * entry is known in advance, so that both lists are processed in
+     * parallel blocks using one binary search per block.
+     */
+    void compute_alias_table(const ScalarFloat *pmf, size_t size) {
+        double sum = 0.0;
+        for (size_t i = 0; i < size; ++i)
+            sum += (double) pmf[i];
+
+        double scale = (double) size / sum;
+        std::vector<uint32_t> light, heavy;
+        std::vector<double> light_sum(1, 0.0), heavy_sum(1, 0.0);
+        for (size_t i = 0; i < size; ++i) {
+            double q = (double) pmf[i] * scale;
+            if (q < 1.0) {
+                light.push_back((uint32_t) i);
+                light_sum.push_back(light_sum.back() + (1.0 - q));
+            } else {
+                heavy.push_back((uint32_t) i);
+                heavy_sum.push_back(heavy_sum.back() + (q - 1.0));
+            }
+        }
+
+        std::vector<ScalarFloat> prob(size, 1.f);
+        std::vector<uint32_t> alias(size);
+        for (size_t i = 0; i < size; ++i)
+            alias[i] = (uint32_t) i;
+
+        size_t n_light = light.size(), n_heavy = heavy.size(),
+               grain = 4096;
+
+        // Without light entries, all entries are exactly full
+        if (n_light > 0 && n_heavy > 0) {
+            // Light entries: pair with the first heavy entry whose cumulative excess suffices
+            dr::parallel_for(
+                dr::blocked_range<size_t>(0, n_light, grain),
+                [&](const dr::blocked_range<size_t> &range) {
+                    size_t j = std::lower_bound(heavy_sum.begin() + 1,
+                                                heavy_sum.end(),
+                                                light_sum[range.begin()]) -
+                               (heavy_sum.begin() + 1);
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        while (j < n_heavy && heavy_sum[j + 1] < light_sum[i])
+                            ++j;
+                        uint32_t index = light[i];
+                        prob[index]  = (ScalarFloat) ((double) pmf[index] * scale);
+                        alias[index] = heavy[std::min(j, n_heavy - 1)];
+                    }
+                }
+            );
+        }
+
+        if (n_light > 0 && n_heavy > 1) {
+            // Heavy entries: keep the remainder once their excess is used up
+            dr::parallel_for(
+                dr::blocked_range<size_t>(0, n_heavy - 1, grain),
+                [&](const dr::blocked_range<size_t> &range) {
+                    size_t i = std::upper_bound(light_sum.begin(),
+                                                light_sum.end(),
+                                                heavy_sum[range.begin() + 1]) -
+                               light_sum.begin();
+                    for (size_t j = range.begin(); j != range.end(); ++j) {
+                        while (i <= n_light && light_sum[i] <= heavy_sum[j + 1])
+                            ++i;
+                        if (i > n_light)
+                            break; // Rounding errors, remaining entries are full
+                        uint32_t index = heavy[j];
+                        double remainder = (double) pmf[index] * scale -
+                                           light_sum[i] + heavy_sum[j];
+                        prob[index]  = (ScalarFloat) std::clamp(remainder, 0.0, 1.0);
+                        alias[index] = heavy[j + 1];
+                    }
+                }
+            );
+        }
+
+        m_alias_prob  = dr::load<FloatStorage>(prob.data(), size);
+        m_alias_index = dr::load<UInt32Storage>(alias.data(), size);
+    }
+
     void compute_cdf() {
         if (m_pmf.empty())
             Throw("DiscreteDistribution: empty distribution!");
@@ -228,12 +374,19 @@ private:
         m_sum = dr::gather<Float>(m_cdf, m_valid.y());
         m_normalization = dr::rcp(m_sum);
         dr::make_opaque(m_valid, m_sum, m_normalization);
+
+        if (m_use_alias_table) {
+            auto &&pmf = dr::migrate(m_pmf, AllocType::Host);
+            dr::sync_thread();
+            compute_alias_table(pmf.data(), pmf.size());
+        }
     }
 
     void compute_cdf_scalar(const ScalarFloat *pmf, size_t size) {
         if (size == 0)
             Throw("DiscreteDistribution: empty distribution!");
 
+        const ScalarFloat *values = pmf;
         std::vector<ScalarFloat> cdf(size);
         ScalarVector2u valid = (uint32_t) -1;
 
@@ -261,14 +414,317 @@ private:
         m_sum = dr::gather<Float>(m_cdf, m_valid.y());
         m_normalization = dr::rcp(m_sum);
         dr::make_opaque(m_valid, m_sum, m_normalization);
+
+        if (m_use_alias_table)
+            compute_alias_table(values, size);
     }
 
 private:
+    using UInt32Storage = DynamicBuffer<UInt32>;
+
     FloatStorage m_pmf;
     FloatStorage m_cdf;
     Float m_sum = 0.f;
     Float m_normalization = 0.f;
     Vector2u m_valid;
+    bool m_use_alias_table = false;
+    FloatStorage m_alias_prob;
+    UInt32Storage m_alias_index;
+};
+
+/**
+ * \brief Discrete 1D probability distribution with incremental updates
+ *
+ * This data structure represents the same kind of distribution as \ref
+ * DiscreteDistribution, but stores it as a Fenwick tree (binary indexed tree)
+ * instead of a cumulative distribution function: the one-based node \c i
+ * holds the sum of the entries <tt>(i - lsb(i), i]</tt>, where \c lsb(i) is
+ * the lowest set bit of \c i. Changing an entry only touches a logarithmic
+ * number of nodes, and sampling descends the tree using one lookup per level.
+ * It is preferable to \ref DiscreteDistribution when a few entries of a large
+ * distribution change frequently, e.g. the sampling weights of the emitters
+ * of a scene during an optimization.
+ *
+ * The entries are maintained on the host. Changes made using \ref set() only
+ * take effect after calling \ref update(), which scatters the modified nodes
+ * into the arrays used for sampling without any synchronization, unless a
+ * large fraction of them changed (in which case they are uploaded again).
+ */
+template <typename Value> struct FenwickDistribution {
+    using Float = std::conditional_t<dr::is_static_array_v<Value>,
+                                     dr::value_t<Value>, Value>;
+    using FloatStorage   = DynamicBuffer<Float>;
+    using UInt32         = dr::uint32_array_t<Float>;
+    using Index          = dr::uint32_array_t<Value>;
+    using Mask           = dr::mask_t<Value>;
+    using Vector2u       = dr::Array<UInt32, 2>;
+
+    using ScalarFloat    = dr::scalar_t<Float>;
+
+public:
+    /// Create an uninitialized FenwickDistribution instance
+    FenwickDistribution() { }
+
+    /// Initialize from a given probability mass function
+    FenwickDistribution(const FloatStorage &pmf) {
+        if constexpr (dr::is_jit_v<Float>) {
+            auto &&host = dr::migrate(pmf, AllocType::Host);
+            dr::sync_thread();
+            build(host.data(), host.size());
+        } else {
+            build(pmf.data(), pmf.size());
+        }
+    }
+
+    /// Initialize from a given floating point array
+    FenwickDistribution(const ScalarFloat *values, size_t size) {
+        build(values, size);
+    }
+
+    /**
+     * \brief Change the (unnormalized) value of the entry \c index
+     *
+     * This only updates the host-side tree. Call \ref update() once all
+     * entries have been set to make the changes visible to the sampling
+     * routines.
+     */
+    void set(uint32_t index, ScalarFloat value) {
+        if (index >= m_pmf_host.size())
+            Throw("FenwickDistribution: index %u is out of bounds!", index);
+        if (!(value >= 0.f))
+            Throw("FenwickDistribution: entries must be non-negative!");
+
+        double delta = (double) value - (double) m_pmf_host[index];
+        if (delta == 0.0)
+            return;
+
+        m_pmf_host[index] = value;
+        m_dirty_entries.push_back(index);
+        for (size_t i = index + 1; i <= m_tree_host.size(); i += i & (0 - i)) {
+            m_tree_host[i - 1] += delta;
+            m_dirty_nodes.push_back((uint32_t) i - 1);
+        }
+    }
+
+    /// Apply the changes made using \ref set() since the last update
+    void update() {
+        if (m_dirty_entries.empty())
+            return;
+
+        size_t size = m_pmf_host.size();
+        if (m_dirty_nodes.size() * 4 >= size) {
+            upload();
+        } else {
+            scatter_dirty(m_tree, m_tree_host, m_dirty_nodes);
+            scatter_dirty(m_pmf, m_pmf_host, m_dirty_entries);
+        }
+
+        m_dirty_entries.clear();
+        m_dirty_nodes.clear();
+        update_sum();
+    }
+
+    /// Return the unnormalized probability mass function
+    const FloatStorage &pmf() const { return m_pmf; }
+
+    /// Return the nodes of the Fenwick tree
+    const FloatStorage &tree() const { return m_tree; }
+
+    /// \brief Return the original sum of PMF entries before normalization
+    Float sum() const { return m_sum; }
+
+    /// \brief Return the normalization factor (i.e. the inverse of \ref sum())
+    Float normalization() const { return m_normalization; }
+
+    /// Return the number of entries
+    size_t size() const { return m_pmf_host.size(); }
+
+    /// Is the distribution object empty/uninitialized?
+    bool empty() const { return m_pmf_host.empty(); }
+
+    /// Evaluate the unnormalized probability mass function (PMF) at index \c index
+    Value eval_pmf(Index index, Mask active = true) const {
+        return dr::gather<Value>(m_pmf, index, active);
+    }
+
+    /// Evaluate the normalized probability mass function (PMF) at index \c index
+    Value eval_pmf_normalized(Index index, Mask active = true) const {
+        return dr::gather<Value>(m_pmf, index, active) * m_normalization;
+    }
+
+    /**
+     * \brief %Transform a uniformly distributed sample to the stored
+     * distribution
+     *
+     * \param value
+     *     A uniformly distributed sample on the interval [0, 1].
+     *
+     * \return
+     *     The discrete index associated with the sample
+     */
+    Index sample(Value value, Mask active = true) const {
+        return sample_reuse(value, active).first;
+    }
+
+    /**
+     * \brief %Transform a uniformly distributed sample to the stored
+     * distribution
+     *
+     * The original sample is value adjusted so that it can be reused as a
+     * uniform variate.
+     *
+     * \param value
+     *     A uniformly distributed sample on the interval [0, 1].
+     *
+     * \return
+     *     A tuple consisting of
+     *
+     *     1. the discrete index associated with the sample, and
+     *     2. the re-scaled sample value.
+     */
+    std::pair<Index, Value> sample_reuse(Value value, Mask active = true) const {
+        MI_MASK_ARGUMENT(active);
+
+        uint32_t size = (uint32_t) m_pmf_host.size();
+        Value target = value * m_sum;
+        Index index = 0;
+
+        // Find the last entry whose exclusive prefix sum does not exceed `target`
+        for (uint32_t step = m_top; step != 0; step >>= 1) {
+            Index next = index + step;
+            Mask valid = active && next <= size;
+            Value node = dr::gather<Value>(m_tree, next - 1, valid);
+            Mask descend = valid && node <= target;
+            target -= dr::select(descend, node, 0.f);
+            index = dr::select(descend, next, index);
+        }
+
+        // Samples outside of [0, 1) map to the first/last nonzero entry
+        index = dr::clip(index, m_valid.x(), m_valid.y());
+
+        Value pmf = dr::gather<Value>(m_pmf, index, active);
+        return { index, dr::minimum(target / pmf, dr::OneMinusEpsilon<Value>) };
+    }
+
+    /**
+     * \brief %Transform a uniformly distributed sample to the stored
+     * distribution.
+     *
+     * The original sample is value adjusted so that it can be reused as a
+     * uniform variate.
+     *
+     * \param value
+     *     A uniformly distributed sample on the interval [0, 1].
+     *
+     * \return
+     *     A tuple consisting of
+     *
+     *     1. the discrete index associated with the sample
+     *     2. the re-scaled sample value
+     *     3. the normalized probability value of the sample
+     */
+    std::tuple<Index, Value, Value>
+    sample_reuse_pmf(Value value, Mask active = true) const {
+        MI_MASK_ARGUMENT(active);
+
+        auto [index, reused] = sample_reuse(value, active);
+        return { index, reused, eval_pmf_normalized(index, active) };
+    }
+
+private:
+    void build(const ScalarFloat *values, size_t size) {
+        if (size == 0)
+            Throw("FenwickDistribution: empty distribution!");
+
+        m_pmf_host.assign(values, values + size);
+        m_tree_host.assign(size, 0.0);
+
+        // Linear-time construction: every node adds its sum to its parent
+        for (size_t i = 1; i <= size; ++i) {
+            if (!(values[i - 1] >= 0.f))
+                Throw("FenwickDistribution: entries must be non-negative!");
+            m_tree_host[i - 1] += (double) values[i - 1];
+            size_t parent = i + (i & (0 - i));
+            if (parent <= size)
+                m_tree_host[parent - 1] += m_tree_host[i - 1];
+        }
+
+        m_top = 1;
+        while ((size_t) m_top * 2 <= size)
+            m_top *= 2;
+
+        m_dirty_entries.clear();
+        m_dirty_nodes.clear();
+        upload();
+        update_sum();
+    }
+
+    void upload() {
+        size_t size = m_pmf_host.size();
+        std::vector<ScalarFloat> tree(size);
+        for (size_t i = 0; i < size; ++i)
+            tree[i] = (ScalarFloat) m_tree_host[i];
+        m_tree = dr::load<FloatStorage>(tree.data(), size);
+        m_pmf = dr::load<FloatStorage>(m_pmf_host.data(), size);
+    }
+
+    /// Write the host values of the given (possibly repeated) indices to \c target
+    template <typename T>
+    static void scatter_dirty(FloatStorage &target, const std::vector<T> &source,
+                              std::vector<uint32_t> &indices) {
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+        std::vector<ScalarFloat> values(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+            values[i] = (ScalarFloat) source[indices[i]];
+
+        if constexpr (dr::is_jit_v<Float>) {
+            using UInt32Storage = DynamicBuffer<UInt32>;
+            dr::scatter(target,
+                        dr::load<FloatStorage>(values.data(), values.size()),
+                        dr::load<UInt32Storage>(indices.data(), indices.size()));
+        } else {
+            for (size_t i = 0; i < indices.size(); ++i)
+                target.data()[indices[i]] = values[i];
+        }
+    }
+
+    void update_sum() {
+        double sum = 0.0;
+        for (size_t i = m_tree_host.size(); i > 0; i -= i & (0 - i))
+            sum += m_tree_host[i - 1];
+
+        uint32_t first = 0, last = (uint32_t) m_pmf_host.size();
+        while (last > 0 && m_pmf_host[last - 1] == 0.f)
+            --last;
+        while (first < last && m_pmf_host[first] == 0.f)
+            ++first;
+
+        if (last == 0 || !(sum > 0.0))
+            Throw("FenwickDistribution: no probability mass found!");
+
+        m_sum = (ScalarFloat) sum;
+        m_normalization = (ScalarFloat) (1.0 / sum);
+        m_valid = Vector2u(first, last - 1);
+        dr::make_opaque(m_sum, m_normalization, m_valid);
+    }
+
+private:
+    FloatStorage m_pmf;
+    FloatStorage m_tree;
+    Float m_sum = 0.f;
+    Float m_normalization = 0.f;
+    /// First and last entry with nonzero mass
+    Vector2u m_valid;
+
+    /// Host copies of the entries and nodes (the latter in double precision)
+    std::vector<ScalarFloat> m_pmf_host;
+    std::vector<double> m_tree_host;
+    /// Largest power of two not exceeding the number of entries
+    uint32_t m_top = 0;
+    /// Entries and nodes modified since the last \ref update()
+    std::vector<uint32_t> m_dirty_entries, m_dirty_nodes;
 };
 
 /**
@@ -707,14 +1163,7 @@ public:
 
         active &= x >= m_range.x() && x <= m_range.y();
 
-        Index index = dr::binary_search<Index>(
-            0, (uint32_t) m_nodes.size(),
-            [&](Index index) DRJIT_INLINE_LAMBDA {
-                return dr::gather<Value>(m_nodes, index, active) < x;
-            }
-        );
-
-        index = dr::maximum(dr::minimum(index, (uint32_t) m_nodes.size() - 1u), 1u) - 1u;
+        Index index = find_interval(x, active);
 
         Value x0 = dr::gather<Value>(m_nodes, index,      active),
               x1 = dr::gather<Value>(m_nodes, index + 1u, active),
@@ -737,14 +1186,7 @@ public:
     Value eval_cdf(Value x, Mask active = true) const {
         MI_MASK_ARGUMENT(active);
 
-        Index index = dr::binary_search<Index>(
-            0, (uint32_t) m_nodes.size(),
-            [&](Index index) DRJIT_INLINE_LAMBDA {
-                return dr::gather<Value>(m_nodes, index, active) < x;
-            }
-        );
-
-        index = dr::maximum(dr::minimum(index, (uint32_t) m_nodes.size() - 1u), 1u) - 1u;
+        Index index = find_interval(x, active);
 
         Value x0 = dr::gather<Value>(m_nodes, index,      active),
               x1 = dr::gather<Value>(m_nodes, index + 1u, active),
@@ -872,6 +1314,83 @@ public:
     }
 
 private:
+    /**
+     * \brief Find the index of the interval containing \c x
+     *
+     * Positions outside of the range map to the first or last interval. When
+     * a lookup table was built (see \ref compute_lookup()), the search starts
+     * at the interval stored for the uniform bin containing \c x and steps
+     * forward at most \c m_lookup_steps times. Otherwise, it falls back to a
+     * binary search over all nodes.
+     */
+    Index find_interval(const Value &x, Mask active) const {
+        uint32_t last = (uint32_t) m_nodes.size() - 2u;
+
+        if (m_lookup_steps == 0) {
+            Index index = dr::binary_search<Index>(
+                0, (uint32_t) m_nodes.size(),
+                [&](Index index) DRJIT_INLINE_LAMBDA {
+                    return dr::gather<Value>(m_nodes, index, active) < x;
+                }
+            );
+
+            return dr::maximum(dr::minimum(index, last + 1u), 1u) - 1u;
+        }
+
+        uint32_t bins = (uint32_t) m_lookup.size();
+        Value scaled = dr::maximum((x - m_range.x()) * m_lookup_scale, 0.f);
+        Index bin = dr::minimum(Index(scaled), bins - 1u),
+              index = dr::gather<Index>(m_lookup, bin, active);
+
+        for (uint32_t i = 0; i < m_lookup_steps; ++i) {
+            Mask step = index < last &&
+                        dr::gather<Value>(m_nodes, index + 1u, active) < x;
+            index = dr::select(step, index + 1u, index);
+        }
+
+        return index;
+    }
+
+    /**
+     * \brief Build a table of interval indices over uniform bins of the range
+     *
+     * This turns the search for the interval containing a position into a
+     * lookup followed by a few forward steps. The table starts one interval
+     * early to be robust to rounding when positions are mapped to bins. It
+     * is not used if the nodes are too unevenly spaced for a small number of
+     * steps to suffice.
+     */
+    void compute_lookup(const ScalarFloat *nodes, size_t size) {
+        uint32_t intervals = (uint32_t) size - 1u,
+                 bins = std::min(4u * intervals, 1u << 16);
+        double lo = (double) nodes[0],
+               scale = bins / ((double) nodes[intervals] - lo);
+
+        std::vector<uint32_t> lookup(bins);
+        uint32_t index = 0, steps = 0;
+        for (uint32_t b = 0; b < bins; ++b) {
+            // Interval containing the end of the current bin
+            double end = lo + (b + 1) / scale;
+            uint32_t start = index;
+            while (index < intervals - 1u && (double) nodes[index + 1] < end)
+                ++index;
+            lookup[b] = start > 0u ? start - 1u : 0u;
+            steps = std::max(steps, index - lookup[b] + 1u);
+        }
+
+        /* The bisection takes fewer steps in case of very unevenly spaced
+           nodes, e.g. a dense cluster in a wide range */
+        if (steps > std::max(4u, dr::log2i(intervals + 1u))) {
+            m_lookup = UInt32Storage();
+            m_lookup_steps = 0;
+            return;
+        }
+
+        m_lookup = dr::load<UInt32Storage>(lookup.data(), bins);
+        m_lookup_scale = (ScalarFloat) scale;
+        m_lookup_steps = steps;
+    }
+
     void compute_cdf() {
         if (m_pdf.size() < 2)
             Throw("IrregularContinuousDistribution: needs at least two entries!");
@@ -904,12 +1423,19 @@ private:
         dr::make_opaque(m_valid, m_integral, m_normalization);
         m_interval_size = dr::slice(dr::min(nodes_next - nodes_curr));
         m_max = dr::slice(dr::max(m_pdf));
+
+        auto &&nodes_host = dr::migrate(dr::detach(m_nodes), AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+        compute_lookup(nodes_host.data(), m_nodes.size());
     }
 
     void compute_cdf_scalar(const ScalarFloat *nodes, const ScalarFloat *pdf, size_t size) {
         if (size < 2)
             Throw("IrregularContinuousDistribution: needs at least two entries!");
 
+        const ScalarFloat *nodes_start = nodes;
+
         m_interval_size = dr::Infinity<Float>;
         ScalarVector2u valid = (uint32_t) -1;
         m_range = ScalarVector2f(
@@ -961,9 +1487,13 @@ private:
         m_integral = dr::gather<Float>(m_cdf, m_valid.y());
         m_normalization = dr::rcp(m_integral);
         dr::make_opaque(m_integral, m_normalization);
+
+        compute_lookup(nodes_start, size);
     }
 
 private:
+    using UInt32Storage = DynamicBuffer<UInt32>;
+
     FloatStorage m_nodes;
     FloatStorage m_pdf;
     FloatStorage m_cdf;
@@ -973,6 +1503,10 @@ private:
     Vector2u m_valid;
     ScalarFloat m_interval_size = 0.f;
     ScalarFloat m_max = 0.f;
+    /// Interval indices over uniform bins of the range (see \ref find_interval())
+    UInt32Storage m_lookup;
+    ScalarFloat m_lookup_scale = 0.f;
+    uint32_t m_lookup_steps = 0;
 };
 
 template <typename Value>
@@ -985,6 +1519,16 @@ std::ostream &operator<<(std::ostream &os, const DiscreteDistribution<Value> &di
     return os;
 }
 
+template <typename Value>
+std::ostream &operator<<(std::ostream &os, const FenwickDistribution<Value> &distr) {
+    os << "FenwickDistribution[" << std::endl
+        << "  size = " << distr.size() << "," << std::endl
+        << "  sum = " << distr.sum() << "," << std::endl
+        << "  pmf = " << distr.pmf() << std::endl
+        << "]";
+    return os;
+}
+
 template <typename Value>
 std::ostream &operator<<(std::ostream &os, const ContinuousDistribution<Value> &distr) {
     os << "ContinuousDistribution[" << std::endl
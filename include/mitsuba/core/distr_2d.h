@@ -12,10 +12,33 @@
 #include <mitsuba/core/warp.h>
 #include <mitsuba/core/util.h>
 #include <drjit/dynamic.h>
+#include <nanothread/nanothread.h>
 #include <array>
 
 NAMESPACE_BEGIN(mitsuba)
 
+NAMESPACE_BEGIN(detail)
+/**
+ * \brief Run <tt>func(i)</tt> for all <tt>i</tt> in <tt>[0, count)</tt> on the
+ * thread pool, where each call processes about \c work entries.
+ *
+ * The construction routines below use this to process rows of the input
+ * independently. Rows are grouped so that small distributions are still
+ * built on the calling thread.
+ */
+template <typename Func>
+void distr_2d_parallel_for(uint32_t count, uint32_t work, Func &&func) {
+    uint32_t grain = std::max(1u, 16384u / std::max(work, 1u));
+    dr::parallel_for(
+        dr::blocked_range<uint32_t>(0, count, grain),
+        [&](const dr::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i)
+                func(i);
+        }
+    );
+}
+NAMESPACE_END(detail)
+
 /** =======================================================================
  * @{ \name Data-driven warping techniques for two dimensions
  *
@@ -95,17 +118,23 @@ public:
 
         std::unique_ptr<ScalarFloat[]> cond_cdf(new ScalarFloat[dr::prod(m_size)]);
         std::unique_ptr<ScalarFloat[]> marg_cdf(new ScalarFloat[m_size.y()]);
+        std::unique_ptr<double[]> cond_cdf_sum(new double[m_size.y()]);
 
-        // Construct conditional and marginal CDFs
-        double accum_marg = 0.0;
-        for (uint32_t y = 0; y < m_size.y(); ++y) {
+        // Construct conditional CDFs (in parallel, one row at a time)
+        detail::distr_2d_parallel_for(m_size.y(), m_size.x(), [&](uint32_t y) {
             double accum_cond = 0.0;
             uint32_t idx = m_size.x() * y;
             for (uint32_t x = 0; x < m_size.x(); ++x, ++idx) {
                 accum_cond += (double) data[idx];
                 cond_cdf[idx] = (ScalarFloat) accum_cond;
             }
-            accum_marg += accum_cond;
+            cond_cdf_sum[y] = accum_cond;
+        });
+
+        // Construct marginal CDF
+        double accum_marg = 0.0;
+        for (uint32_t y = 0; y < m_size.y(); ++y) {
+            accum_marg += cond_cdf_sum[y];
             marg_cdf[y] = (ScalarFloat) accum_marg;
         }
 
@@ -393,24 +422,25 @@ public:
             m_levels.reserve(1);
             m_levels.emplace_back(size, m_slices);
 
-            for (uint32_t slice = 0; slice < m_slices; ++slice) {
-                ScalarFloat *p = m_levels[0].data.data();
-                uint32_t offset = m_levels[0].size * slice;
+            ScalarFloat *p = m_levels[0].data.data();
+            uint32_t level_size = m_levels[0].size;
+
+            detail::distr_2d_parallel_for(m_slices, level_size, [&](uint32_t slice) {
+                uint32_t offset = level_size * slice;
 
                 ScalarFloat scale = 1.f;
                 if (normalize) {
                     double sum = 0.0;
-                    for (uint32_t i = 0; i < m_levels[0].size; ++i)
+                    for (uint32_t i = 0; i < level_size; ++i)
                         sum += (double) data[offset + i];
                     scale = dr::prod(n_patches) / (ScalarFloat) sum;
                 }
 
-                for (uint32_t i = 0; i < m_levels[0].size; ++i)
+                for (uint32_t i = 0; i < level_size; ++i)
                     p[offset + i] = data[offset + i] * scale;
+            });
 
-                m_levels[0].ready();
-            }
-
+            m_levels[0].ready();
             return;
         }
 
@@ -427,54 +457,70 @@ public:
 
         ScalarFloat *l0p = m_levels[0].data.data(),
                     *l1p = m_levels[1].data.data();
-
-        for (uint32_t slice = 0; slice < m_slices; ++slice) {
-            uint32_t offset0 = m_levels[0].size * slice,
-                     offset1 = m_levels[1].size * slice;
-
-            // Integrate linear interpolant
-            const ScalarFloat *in = data + offset0;
-
+        const Level &l0 = m_levels[0], &l1 = m_levels[1];
+
+        /* The rows of each slice are processed in parallel. Sums over a
+           slice are accumulated in a fixed order, hence the result does not
+           depend on the number of threads. */
+
+        // Integrate linear interpolant
+        detail::distr_2d_parallel_for(m_slices * n_patches.y(), n_patches.x(), [&](uint32_t i) {
+            uint32_t slice = i / n_patches.y(), y = i % n_patches.y();
+            const ScalarFloat *in = data + l0.size * slice + y * size.x();
+            ScalarFloat *out = l1p + l1.size * slice;
+            for (uint32_t x = 0; x < n_patches.x(); ++x, ++in)
+                out[l1.index(ScalarVector2u(x, y))] =
+                    .25f * (in[0] + in[1] + in[size.x()] + in[size.x() + 1]);
+        });
+
+        std::unique_ptr<ScalarFloat[]> scale(new ScalarFloat[m_slices]);
+        detail::distr_2d_parallel_for(m_slices, dr::prod(n_patches), [&](uint32_t slice) {
             double sum = 0.0;
-            for (uint32_t y = 0; y < n_patches.y(); ++y) {
-                for (uint32_t x = 0; x < n_patches.x(); ++x) {
-                    ScalarFloat avg = .25f * (in[0] + in[1] + in[size.x()] +
-                                              in[size.x() + 1]);
-                    sum += (double) avg;
-                    *(l1p + m_levels[1].index(ScalarVector2u(x, y)) + offset1) = avg;
-                    ++in;
-                }
-                ++in;
+            if (normalize) {
+                const ScalarFloat *in = l1p + l1.size * slice;
+                for (uint32_t y = 0; y < n_patches.y(); ++y)
+                    for (uint32_t x = 0; x < n_patches.x(); ++x)
+                        sum += (double) in[l1.index(ScalarVector2u(x, y))];
             }
-
-            // Copy and normalize fine resolution interpolant
-            ScalarFloat scale = normalize ? (ScalarFloat) (dr::prod(n_patches) / sum) : 1.f;
-            for (uint32_t i = 0; i < m_levels[0].size; ++i)
-                l0p[offset0 + i] = data[offset0 + i] * scale;
-            for (uint32_t i = 0; i < m_levels[1].size; ++i)
-                l1p[offset1 + i] *= scale;
-
-            // Build a MIP hierarchy
-            level_size = n_patches;
-            for (uint32_t level = 2; level <= max_level + 1; ++level) {
-                const Level &l0 = m_levels[level - 1];
-                Level &l1 = m_levels[level];
-                offset0 = l0.size * slice;
-                offset1 = l1.size * slice;
-                level_size = dr::sr<1>(level_size + 1u);
-
-                const ScalarFloat *l0p_ = l0.data.data();
-                ScalarFloat *l1p_ = l1.data.data();
-
-                // Downsample
-                for (uint32_t y = 0; y < level_size.y(); ++y) {
-                    for (uint32_t x = 0; x < level_size.x(); ++x) {
-                        ScalarFloat *d1 = l1p_ + l1.index(ScalarVector2u(x, y)) + offset1;
-                        const ScalarFloat *d0 = l0p_ + l0.index(ScalarVector2u(x*2, y*2)) + offset0;
-                        *d1 = d0[0] + d0[1] + d0[2] + d0[3];
-                    }
+            scale[slice] = normalize ? (ScalarFloat) (dr::prod(n_patches) / sum) : 1.f;
+        });
+
+        // Copy and normalize fine resolution interpolant
+        detail::distr_2d_parallel_for(m_slices * size.y(), size.x(), [&](uint32_t i) {
+            uint32_t slice = i / size.y(), offset = i * size.x();
+            for (uint32_t x = 0; x < size.x(); ++x)
+                l0p[offset + x] = data[offset + x] * scale[slice];
+        });
+
+        uint32_t l1_rows = l1.size / l1.width;
+        detail::distr_2d_parallel_for(m_slices * l1_rows, l1.width, [&](uint32_t i) {
+            uint32_t slice = i / l1_rows, offset = i * l1.width;
+            for (uint32_t x = 0; x < l1.width; ++x)
+                l1p[offset + x] *= scale[slice];
+        });
+
+        // Build a MIP hierarchy
+        level_size = n_patches;
+        for (uint32_t level = 2; level <= max_level + 1; ++level) {
+            const Level &l0_ = m_levels[level - 1];
+            Level &l1_ = m_levels[level];
+            level_size = dr::sr<1>(level_size + 1u);
+
+            const ScalarFloat *l0p_ = l0_.data.data();
+            ScalarFloat *l1p_ = l1_.data.data();
+
+            // Downsample
+            uint32_t rows = level_size.y(), cols = level_size.x();
+            detail::distr_2d_parallel_for(m_slices * rows, 4 * cols, [&](uint32_t i) {
+                uint32_t slice = i / rows, y = i % rows,
+                         offset0 = l0_.size * slice,
+                         offset1 = l1_.size * slice;
+                for (uint32_t x = 0; x < cols; ++x) {
+                    ScalarFloat *d1 = l1p_ + l1_.index(ScalarVector2u(x, y)) + offset1;
+                    const ScalarFloat *d0 = l0p_ + l0_.index(ScalarVector2u(x*2, y*2)) + offset0;
+                    *d1 = d0[0] + d0[1] + d0[2] + d0[3];
                 }
-            }
+            });
         }
 
         for (auto& level : m_levels)
@@ -894,77 +940,76 @@ public:
                         *cond_cdf_ptr = cond_cdf.get(),
                         *data_out_ptr = data_out.get();
 
-            std::unique_ptr<double[]> cond_cdf_sum(new double[h]);
-
-            for (uint32_t slice = 0; slice < m_slices; ++slice) {
-                ScalarFloat norm = 1.f;
-
-                /* The marginal/probability distribution computation
-                   differs for the Continuous=false/true cases */
-                if constexpr (Continuous) {
-                    // Construct conditional CDF
-                    for (uint32_t y = 0; y < h; ++y) {
-                        double accum = 0.0;
-                        uint32_t i = y * w, j = y * (w - 1);
-                        for (uint32_t x = 0; x < w - 1; ++x, ++i, ++j) {
-                            accum += scale_x * ((double) data[i] +
-                                                (double) data[i + 1]);
-                            cond_cdf_ptr[j] = (ScalarFloat) accum;
-                        }
-                        cond_cdf_sum[y] = accum;
-                    }
-
-                    // Construct marginal CDF
-                    double accum = 0.0;
-                    for (uint32_t y = 0; y < h - 1; ++y) {
-                        accum += scale_y * (cond_cdf_sum[y] + cond_cdf_sum[y + 1]);
-                        marg_cdf_ptr[y] = (ScalarFloat) accum;
-                    }
-
-                    if (normalize)
-                        norm = ScalarFloat(1.0 / accum);
-                } else {
-                    double scale = scale_x * scale_y;
+            /* The marginal/probability distribution computation
+               differs for the Continuous=false/true cases */
+            uint32_t n_rows = Continuous ? h : (h - 1);
+            std::unique_ptr<double[]> cond_cdf_sum(new double[m_slices * h]);
+            std::unique_ptr<ScalarFloat[]> norm(new ScalarFloat[m_slices]);
+
+            // Construct conditional CDFs (in parallel, one row at a time)
+            detail::distr_2d_parallel_for(m_slices * n_rows, w, [&](uint32_t k) {
+                uint32_t slice = k / n_rows, y = k % n_rows;
+                const ScalarFloat *in = data + slice * n_data;
+                ScalarFloat *out = cond_cdf_ptr + slice * n_cond;
+
+                double accum = 0.0;
+                uint32_t i = y * w, j = y * (w - 1);
+                for (uint32_t x = 0; x < w - 1; ++x, ++i, ++j) {
+                    if constexpr (Continuous)
+                        accum += scale_x * ((double) in[i] +
+                                            (double) in[i + 1]);
+                    else
+                        accum += scale_x * scale_y *
+                                 ((double) in[i] +
+                                  (double) in[i + 1] +
+                                  (double) in[i + w] +
+                                  (double) in[i + w + 1]);
+                    out[j] = (ScalarFloat) accum;
+                }
+                cond_cdf_sum[slice * h + y] = accum;
+            });
 
-                    // Construct conditional CDF
-                    for (uint32_t y = 0; y < h - 1; ++y) {
-                        double accum = 0.0;
-                        uint32_t i = y * w, j = y * (w - 1);
-                        for (uint32_t x = 0; x < w - 1; ++x, ++i, ++j) {
-                            accum += scale * ((double) data[i] +
-                                              (double) data[i + 1] +
-                                              (double) data[i + w] +
-                                              (double) data[i + w + 1]);
-                            cond_cdf_ptr[j] = (ScalarFloat) accum;
-                        }
-                        cond_cdf_sum[y] = accum;
-                    }
+            // Construct marginal CDFs
+            detail::distr_2d_parallel_for(m_slices, h, [&](uint32_t slice) {
+                const double *sum = cond_cdf_sum.get() + slice * h;
+                ScalarFloat *out = marg_cdf_ptr + slice * n_marg;
+
+                double accum = 0.0;
+                for (uint32_t y = 0; y < h - 1; ++y) {
+                    if constexpr (Continuous)
+                        accum += scale_y * (sum[y] + sum[y + 1]);
+                    else
+                        accum += sum[y];
+                    out[y] = (ScalarFloat) accum;
+                }
 
-                    // Construct marginal CDF
-                    double accum = 0.0;
-                    for (uint32_t y = 0; y < h - 1; ++y) {
-                        accum += cond_cdf_sum[y];
-                        marg_cdf_ptr[y] = (ScalarFloat) accum;
-                    }
+                norm[slice] = normalize ? ScalarFloat(1.0 / accum) : 1.f;
+            });
 
-                    if (normalize)
-                        norm = ScalarFloat(1.0 / accum);
+            // Normalize
+            detail::distr_2d_parallel_for(m_slices * h, w, [&](uint32_t k) {
+                uint32_t slice = k / h, y = k % h;
+                ScalarFloat scale = norm[slice];
+
+                for (uint32_t i = k * w; i < (k + 1) * w; ++i)
+                    data_out_ptr[i] = data[i] * scale;
+                if (y < n_rows) {
+                    ScalarFloat *cdf = cond_cdf_ptr + slice * n_cond + y * (w - 1);
+                    for (uint32_t x = 0; x < w - 1; ++x)
+                        cdf[x] *= scale;
                 }
-
-                for (size_t i = 0; i < n_cond; ++i)
-                    *cond_cdf_ptr++ *= norm;
-                for (size_t i = 0; i < n_marg; ++i)
-                    *marg_cdf_ptr++ *= norm;
-                for (size_t i = 0; i < n_data; ++i)
-                    *data_out_ptr++ = *data++ * norm;
-            }
+                if (y < n_marg)
+                    marg_cdf_ptr[slice * n_marg + y] *= scale;
+            });
 
             m_marg_cdf = dr::load<FloatStorage>(marg_cdf.get(), m_slices * n_marg);
             m_cond_cdf = dr::load<FloatStorage>(cond_cdf.get(), m_slices * n_cond);
         } else {
             ScalarFloat *data_out_ptr = data_out.get();
 
-            for (uint32_t slice = 0; slice < m_slices; ++slice) {
+            detail::distr_2d_parallel_for(m_slices, n_data, [&](uint32_t slice) {
+                const ScalarFloat *in = data + slice * n_data;
+                ScalarFloat *out = data_out_ptr + slice * n_data;
                 ScalarFloat norm = 1.f;
 
                 if (normalize) {
@@ -972,18 +1017,18 @@ public:
                     for (uint32_t y = 0; y < h - 1; ++y) {
                         size_t i = y * w;
                         for (uint32_t x = 0; x < w - 1; ++x, ++i) {
-                            sum += (double) data[i] +
-                                   (double) data[i + 1] +
-                                   (double) data[i + w] +
-                                   (double) data[i + w + 1];
+                            sum += (double) in[i] +
+                                   (double) in[i + 1] +
+                                   (double) in[i + w] +
+                                   (double) in[i + w + 1];
                         }
                     }
                     norm = ScalarFloat(1.0 / (scale_x * scale_y * sum));
                 }
 
                 for (uint32_t k = 0; k < n_data; ++k)
-                    *data_out_ptr++ = *data++ * norm;
-            }
+                    out[k] = in[k] * norm;
+            });
         }
 
         m_data = dr::load<FloatStorage>(data_out.get(), m_slices * n_data);
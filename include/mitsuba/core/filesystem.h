@@ -208,6 +208,11 @@ extern MI_EXPORT_LIB bool exists(const path& p) noexcept;
  */
 extern MI_EXPORT_LIB size_t file_size(const path& p);
 
+/** \brief Returns the time of the last modification of the file system object
+ * at <tt>p</tt>, in seconds since the epoch.
+ */
+extern MI_EXPORT_LIB int64_t last_write_time(const path& p);
+
 /** \brief Checks whether two paths refer to the same file system object.
  * Both must refer to an existing file or directory.
  * Symlinks are followed to determine equivalence.
@@ -220,6 +225,13 @@ extern MI_EXPORT_LIB bool equivalent(const path& p1, const path& p2);
  * does nothing (this condition is not treated as an error).
  */
 extern MI_EXPORT_LIB bool create_directory(const path& p) noexcept;
+
+/** \brief Creates a directory at <tt>p</tt> along with all of its missing
+ * parent directories, as if <tt>mkdir -p</tt> was used. Returns true if
+ * <tt>p</tt> is a directory afterwards, false otherwise. Directories that
+ * are concurrently created by other processes are not treated as an error.
+ */
+extern MI_EXPORT_LIB bool create_directories(const path& p) noexcept;
 /** \brief Changes the size of the regular file named by <tt>p</tt> as if
  * <tt>truncate</tt> was called. If the file was larger than <tt>target_length</tt>,
  * the remainder is discarded. The file must exist.
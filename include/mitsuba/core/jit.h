@@ -35,15 +35,16 @@ struct MI_EXPORT_LIB Jit {
     /**
      * \brief Statically initialize the JIT runtime
      *
-     * This function also does a runtime-check to ensure that the host
-     * processor supports all instruction sets which were selected at compile
-     * time. If not, the application is terminated via ``abort()``.
+     * The runtime itself is only created by the first call to \ref
+     * get_instance(), hence applications that never JIT-compile a routine
+     * don't pay for its construction.
      */
     static void static_initialization();
 
     /// Release all memory used by JIT-compiled routines
     static void static_shutdown();
 
+    /// Return the JIT runtime, creating it if necessary
     static Jit *get_instance();
 
 private:
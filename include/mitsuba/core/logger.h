@@ -106,6 +106,24 @@ public:
     /// Return the logger's formatter implementation (const)
     const Formatter *formatter() const;
 
+    /**
+     * \brief Enable or disable asynchronous logging
+     *
+     * In asynchronous mode, \ref log() only enqueues messages using a
+     * lock-free list, and a background thread formats them and passes them
+     * to the appenders. This prevents verbose logging from serializing
+     * worker threads. Pending messages are flushed before progress messages,
+     * before exceptions are thrown, at the end of a render job, and when
+     * asynchronous mode is disabled.
+     */
+    void set_asynchronous(bool value);
+
+    /// Is asynchronous logging enabled?
+    bool asynchronous() const;
+
+    /// Pass all pending messages of the asynchronous mode to the appenders
+    void flush();
+
     /**
      * \brief Return the contents of the log file as a string
      *
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <mitsuba/mitsuba.h>
+#include <string>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/// Subsystems whose memory usage is tracked by the \ref MemoryTracker
+enum class MemoryCategory : int {
+    Mesh = 0,                   /* Mesh vertex, face and attribute buffers */
+    Bitmap,                     /* Bitmap pixel data */
+    VolumeGrid,                 /* VolumeGrid voxel data */
+    KDTree,                     /* Native kd-tree/BVH nodes and build storage */
+    Embree,                     /* Embree acceleration data structures */
+    OptiX,                      /* OptiX acceleration data structures */
+    ImageBlock,                 /* ImageBlock storage */
+
+    MemoryCategoryCount
+};
+
+constexpr const char
+    *memory_category_id[int(MemoryCategory::MemoryCategoryCount)] = {
+        "Meshes",
+        "Bitmaps",
+        "Volume grids",
+        "Native acceleration data structures",
+        "Embree acceleration data structures",
+        "OptiX acceleration data structures",
+        "Image blocks"
+    };
+
+/**
+ * \brief Accounts for the memory held by the main subsystems of Mitsuba
+ *
+ * Allocations are tagged with a \ref MemoryCategory and with the location of
+ * the memory (host or GPU). The tracker maintains the current usage and the
+ * high-water mark of every category, which helps to find out which parts of
+ * a scene are responsible for its memory footprint. The peak resident memory
+ * of the process is reported alongside, since it additionally includes all
+ * untracked allocations, e.g. the state of JIT-compiled wavefronts.
+ *
+ * Subsystems normally don't call \ref allocate() and \ref release()
+ * directly, but hold a \ref MemoryAllocation whose size they update.
+ */
+class MI_EXPORT_LIB MemoryTracker {
+public:
+    /// Record an allocation of \c size bytes
+    static void allocate(MemoryCategory category, size_t size, bool device = false);
+
+    /// Record that \c size bytes were released
+    static void release(MemoryCategory category, size_t size, bool device = false);
+
+    /// Return the number of bytes currently held by a category
+    static size_t usage(MemoryCategory category);
+
+    /// Return the high-water mark of a category in bytes
+    static size_t peak_usage(MemoryCategory category);
+
+    /// Return the number of tracked bytes held in host (or GPU) memory
+    static size_t total_usage(bool device = false);
+
+    /// Return the high-water mark of the tracked host (or GPU) memory
+    static size_t peak_total_usage(bool device = false);
+
+    /// Return the peak resident memory of the process in bytes
+    static size_t peak_rss();
+
+    /// Reset the high-water marks to the current usage
+    static void reset_peak_usage();
+
+    /// Return a human-readable report of the tracked memory usage
+    static std::string report();
+
+    /// Return a one-line summary, which is e.g. logged after loading a scene
+    static std::string summary();
+};
+
+/**
+ * \brief Memory held by an object and accounted for by the \ref MemoryTracker
+ *
+ * The tracked size is updated via \ref set() whenever the storage of the
+ * owning object is (re)allocated, and released when the object is destroyed.
+ * Copies account for the same amount of memory once more.
+ */
+class MemoryAllocation {
+public:
+    MemoryAllocation(MemoryCategory category) : m_category(category) { }
+
+    MemoryAllocation(const MemoryAllocation &other)
+        : m_category(other.m_category) {
+        set(other.m_size, other.m_device);
+    }
+
+    MemoryAllocation &operator=(const MemoryAllocation &other) {
+        if (this != &other) {
+            set(0);
+            m_category = other.m_category;
+            set(other.m_size, other.m_device);
+        }
+        return *this;
+    }
+
+    ~MemoryAllocation() { set(0); }
+
+    /// Update the amount of memory and its location
+    void set(size_t size, bool device = false) {
+        if (size == m_size && device == m_device)
+            return;
+        if (m_size)
+            MemoryTracker::release(m_category, m_size, m_device);
+        if (size)
+            MemoryTracker::allocate(m_category, size, device);
+        m_size = size;
+        m_device = device;
+    }
+
+    /// Return the tracked amount of memory in bytes
+    size_t size() const { return m_size; }
+
+private:
+    MemoryCategory m_category;
+    size_t m_size = 0;
+    bool m_device = false;
+};
+
+NAMESPACE_END(mitsuba)
@@ -45,6 +45,9 @@ public:
     /// Return whether the mapped memory region can be modified
     bool can_write() const;
 
+    /// Return whether modifications of the mapped memory region are private
+    bool is_copy_on_write() const;
+
     /// Return a string representation
     std::string to_string() const override;
 
@@ -58,6 +61,15 @@ public:
      */
     static ref<MemoryMappedFile> create_temporary(size_t size);
 
+    /**
+     * \brief Map an existing file into memory using copy-on-write semantics
+     *
+     * The mapped region can be modified, but modifications remain private to
+     * the process and are never written back to the file. Pages are only
+     * copied once they are written to. Such mappings cannot be resized.
+     */
+    static ref<MemoryMappedFile> map_copy_on_write(const fs::path &filename);
+
     MI_DECLARE_CLASS()
 protected:
     /// Internal constructor
@@ -85,6 +85,18 @@ public:
      */
     virtual void parameters_changed(const std::vector<std::string> &/*keys*/ = {});
 
+    /**
+     * \brief Replace a child object that was passed to the constructor
+     *
+     * This is used by the reload mode of the XML scene loader (see
+     * \ref xml::load_file()), which swaps the changed children of an
+     * otherwise unchanged object instead of instantiating it again.
+     * Returns \c true when \c old_child was replaced by \c new_child.
+     *
+     * \remark The default implementation does nothing and returns \c false.
+     */
+    virtual bool replace_object(Object *old_child, Object *new_child);
+
     /**
      * \brief Return a \ref Class instance containing run-time type information
      * about this Object
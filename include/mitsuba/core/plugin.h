@@ -35,6 +35,9 @@ public:
     /// Return the list of loaded plugins
     std::vector<std::string> loaded_plugins() const;
 
+    /// Return the total time (in milliseconds) spent loading plugin libraries
+    float load_time() const;
+
     /// Register a Python plugin
     void register_python_plugin(const std::string &plugin_name,
                                 const std::string &variant);
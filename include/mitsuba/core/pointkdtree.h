@@ -0,0 +1,284 @@
+#pragma once
+
+#include <mitsuba/core/bbox.h>
+#include <mitsuba/core/logger.h>
+#include <mitsuba/core/thread.h>
+#include <mitsuba/core/vector.h>
+#include <nanothread/nanothread.h>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Balanced kd-tree over a set of points for nearest neighbor and
+ * radius queries (e.g. photon lookups)
+ *
+ * The tree is stored implicitly: after \ref build(), the points are reordered
+ * so that the median of any range <tt>[begin, end)</tt> of the array is the
+ * node splitting that range, and its two halves form the left and right
+ * subtrees. No child pointers are needed, and the nodes of a subtree occupy
+ * a contiguous region of memory.
+ *
+ * The reordering is reported by \ref permutation(), which can be used to
+ * store any data associated with the points in the same (cache-friendly)
+ * order. The indices returned by queries refer to this order.
+ *
+ * Only scalar point types are supported.
+ */
+template <typename Point_> class PointKDTree {
+public:
+    using Point       = Point_;
+    using Scalar      = dr::value_t<Point>;
+    using BBox        = BoundingBox<Point>;
+    using Index       = uint32_t;
+
+    static constexpr size_t Dimension = dr::size_v<Point>;
+
+    /// Search result of a nearest neighbor query
+    struct SearchResult {
+        /// Squared distance to the query point
+        Scalar dist2;
+        /// Index of the point (in the order of the tree)
+        Index index;
+
+        bool operator<(const SearchResult &other) const {
+            return dist2 < other.dist2;
+        }
+    };
+
+    /// Create an empty kd-tree
+    PointKDTree() = default;
+
+    /// Create a kd-tree over the given points (see \ref build())
+    PointKDTree(std::vector<Point> &&points) { build(std::move(points)); }
+
+    /**
+     * \brief Build the kd-tree over the given set of points
+     *
+     * Every node splits its range along the axis of largest extent. The top
+     * levels of the tree are split on the calling thread, after which the
+     * remaining subtrees are built in parallel.
+     */
+    void build(std::vector<Point> &&points) {
+        size_t size = points.size();
+        if (size >= (size_t) std::numeric_limits<Index>::max())
+            Throw("PointKDTree: too many points (%zu)!", size);
+
+        m_permutation.resize(size);
+        std::iota(m_permutation.begin(), m_permutation.end(), Index(0));
+        m_axis.assign(size, 0);
+        m_points = std::move(points);
+
+        // Split the top levels until there is enough parallel work
+        std::vector<std::pair<Index, Index>> ranges = { { 0, (Index) size } },
+                                             next;
+        size_t target = 4 * std::max((size_t) pool_size(), (size_t) 1);
+        while (ranges.size() < target) {
+            next.clear();
+            bool split_any = false;
+            for (auto [begin, end] : ranges) {
+                if (end - begin <= 1)
+                    continue;
+                Index mid = split(begin, end);
+                next.emplace_back(begin, mid);
+                next.emplace_back(mid + 1, end);
+                split_any = true;
+            }
+            if (!split_any)
+                break;
+            ranges.swap(next);
+        }
+
+        ThreadEnvironment env;
+        dr::parallel_for(
+            dr::blocked_range<size_t>(0, ranges.size(), 1),
+            [&](const dr::blocked_range<size_t> &range) {
+                ScopedSetThreadEnvironment set_env(env);
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    build_recursive(ranges[i].first, ranges[i].second);
+            }
+        );
+
+        // Reorder the points themselves
+        std::vector<Point> sorted(size);
+        for (size_t i = 0; i < size; ++i)
+            sorted[i] = m_points[m_permutation[i]];
+        m_points.swap(sorted);
+    }
+
+    /// Return the number of points
+    size_t size() const { return m_points.size(); }
+
+    /// Return the i-th point (in the order of the tree)
+    const Point &point(size_t i) const { return m_points[i]; }
+
+    /**
+     * \brief Return the original index of every point, in the order of
+     * the tree
+     */
+    const std::vector<Index> &permutation() const { return m_permutation; }
+
+    /**
+     * \brief Find the (up to) \c k nearest neighbors of a point
+     *
+     * \param p
+     *     Query point
+     *
+     * \param k
+     *     Maximum number of neighbors to return
+     *
+     * \param radius2
+     *     Squared maximum search radius. When \c k points were found, this
+     *     is set to the squared distance of the farthest one upon return.
+     *
+     * \param results
+     *     Storage for at least \c k search results. They are not sorted
+     *     by distance.
+     *
+     * \return The number of points that were found
+     */
+    size_t nn_search(const Point &p, size_t k, Scalar &radius2,
+                     SearchResult *results) const {
+        struct StackEntry {
+            Index begin, end;
+            Scalar plane_dist2;
+        };
+
+        if (m_points.empty() || k == 0)
+            return 0;
+
+        StackEntry stack[128];
+        uint32_t stack_index = 0;
+        stack[stack_index++] = { 0, (Index) m_points.size(), 0.f };
+        size_t count = 0;
+
+        while (stack_index > 0) {
+            StackEntry entry = stack[--stack_index];
+            if (entry.begin >= entry.end || entry.plane_dist2 > radius2)
+                continue;
+
+            Index mid = (entry.begin + entry.end) / 2;
+            const Point &node = m_points[mid];
+            Scalar dist2 = dr::squared_norm(p - node);
+
+            if (dist2 < radius2) {
+                if (count < k) {
+                    results[count++] = { dist2, mid };
+                    if (count == k) {
+                        std::make_heap(results, results + k);
+                        radius2 = results[0].dist2;
+                    }
+                } else {
+                    std::pop_heap(results, results + k);
+                    results[k - 1] = { dist2, mid };
+                    std::push_heap(results, results + k);
+                    radius2 = results[0].dist2;
+                }
+            }
+
+            if (entry.end - entry.begin == 1)
+                continue;
+
+            // Visit the subtree containing the query point first
+            uint8_t axis = m_axis[mid];
+            Scalar diff = p[axis] - node[axis];
+            StackEntry left  { entry.begin, mid, diff * diff },
+                       right { mid + 1, entry.end, diff * diff };
+            if (diff < 0.f) {
+                left.plane_dist2 = 0.f;
+                stack[stack_index++] = right;
+                stack[stack_index++] = left;
+            } else {
+                right.plane_dist2 = 0.f;
+                stack[stack_index++] = left;
+                stack[stack_index++] = right;
+            }
+        }
+
+        return count;
+    }
+
+    /**
+     * \brief Invoke <tt>func(index, dist2)</tt> for every point within
+     * \c radius of \c p, where \c dist2 is the squared distance to \c p.
+     *
+     * \return The number of points that were found
+     */
+    template <typename Func>
+    size_t radius_search(const Point &p, Scalar radius, Func &&func) const {
+        if (m_points.empty())
+            return 0;
+
+        Scalar radius2 = radius * radius;
+        std::pair<Index, Index> stack[128];
+        uint32_t stack_index = 0;
+        stack[stack_index++] = { 0, (Index) m_points.size() };
+        size_t count = 0;
+
+        while (stack_index > 0) {
+            auto [begin, end] = stack[--stack_index];
+            if (begin >= end)
+                continue;
+
+            Index mid = (begin + end) / 2;
+            const Point &node = m_points[mid];
+            Scalar dist2 = dr::squared_norm(p - node);
+            if (dist2 < radius2) {
+                func(mid, dist2);
+                count++;
+            }
+
+            uint8_t axis = m_axis[mid];
+            Scalar diff = p[axis] - node[axis];
+            if (diff < radius)
+                stack[stack_index++] = { begin, mid };
+            if (diff > -radius)
+                stack[stack_index++] = { mid + 1, end };
+        }
+
+        return count;
+    }
+
+protected:
+    /**
+     * \brief Partition the range <tt>[begin, end)</tt> of the permutation
+     * around its median along the axis of largest extent, and return the
+     * index of the median
+     */
+    Index split(Index begin, Index end) {
+        BBox bbox;
+        for (Index i = begin; i < end; ++i)
+            bbox.expand(m_points[m_permutation[i]]);
+
+        Point extents = bbox.extents();
+        uint8_t axis = 0;
+        for (uint8_t i = 1; i < (uint8_t) Dimension; ++i)
+            if (extents[i] > extents[axis])
+                axis = i;
+        Index mid = (begin + end) / 2;
+        std::nth_element(
+            m_permutation.begin() + begin, m_permutation.begin() + mid,
+            m_permutation.begin() + end, [&](Index a, Index b) {
+                return m_points[a][axis] < m_points[b][axis];
+            });
+        m_axis[mid] = axis;
+        return mid;
+    }
+
+    void build_recursive(Index begin, Index end) {
+        while (end - begin > 1) {
+            Index mid = split(begin, end);
+            build_recursive(begin, mid);
+            begin = mid + 1;
+        }
+    }
+
+protected:
+    std::vector<Point> m_points;
+    std::vector<Index> m_permutation;
+    std::vector<uint8_t> m_axis;
+};
+
+NAMESPACE_END(mitsuba)
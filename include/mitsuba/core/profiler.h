@@ -1,6 +1,7 @@
 #pragma once
 
 #include <mitsuba/core/object.h>
+#include <atomic>
 
 #if defined(MI_ENABLE_ITTNOTIFY)
 #  include <ittnotify.h>
@@ -78,12 +79,49 @@ constexpr const char
         "Texture::eval()"
     };
 
+/**
+ * List of ray traversal statistics that are collected when Mitsuba is
+ * compiled with the \c MI_ENABLE_RAY_STATISTICS CMake option.
+ */
+enum class RayStatistic : int {
+    RayIntersect = 0,           /* Rays traced via Scene::ray_intersect*() */
+    RayTest,                    /* Shadow rays traced via Scene::ray_test() */
+    TraversedNodes,             /* Visited nodes of the native acceleration data structures */
+    PrimitiveTests,             /* Ray-primitive intersection tests */
+
+    RayStatisticCount
+};
+
+constexpr const char
+    *ray_statistic_id[int(RayStatistic::RayStatisticCount)] = {
+        "Scene::ray_intersect()",
+        "Scene::ray_test()",
+        "Traversed nodes",
+        "Primitive intersection tests"
+    };
+
 #if defined(MI_ENABLE_ITTNOTIFY)
 extern MI_EXPORT_LIB __itt_domain *mitsuba_itt_domain;
 extern MI_EXPORT_LIB __itt_string_handle *
     mitsuba_itt_phase[int(ProfilerPhase::ProfilerPhaseCount)];
 #endif
 
+NAMESPACE_BEGIN(detail)
+/// Features of the built-in profiler that are currently enabled
+enum ProfilerFlags : uint32_t {
+    /// Phase profile, see \ref Profiler::set_phase_profiling()
+    ProfilerPhases = 1,
+    /// Timeline trace, see \ref Profiler::start_trace()
+    ProfilerTrace = 2,
+    /// Kernel instrumentation, see \ref Profiler::set_kernel_instrumentation()
+    ProfilerKernelLabels = 4
+};
+
+extern MI_EXPORT_LIB std::atomic<uint32_t> profiler_flags;
+extern MI_EXPORT_LIB void profiler_enter_phase(ProfilerPhase phase);
+extern MI_EXPORT_LIB void profiler_leave_phase();
+NAMESPACE_END(detail)
+
 struct ScopedPhase {
     ScopedPhase(ProfilerPhase phase) {
         /// Interface with various external visual profilers
@@ -95,10 +133,18 @@ struct ScopedPhase {
 #if defined(MI_ENABLE_NVTX)
         nvtxRangePush(profiler_phase_id[(int) phase]);
 #endif
-        (void) phase;
+
+        // Built-in profiler, which costs a single load when it is disabled
+        if (unlikely(detail::profiler_flags.load(std::memory_order_relaxed))) {
+            detail::profiler_enter_phase(phase);
+            m_profiled = true;
+        }
     }
 
     ~ScopedPhase() {
+        if (unlikely(m_profiled))
+            detail::profiler_leave_phase();
+
 #if defined(MI_ENABLE_ITTNOTIFY)
         __itt_task_end(mitsuba_itt_domain);
 #endif
@@ -110,12 +156,304 @@ struct ScopedPhase {
 
     ScopedPhase(const ScopedPhase &) = delete;
     ScopedPhase &operator=(const ScopedPhase &) = delete;
+
+private:
+    bool m_profiled = false;
+};
+
+/**
+ * \brief Statistics of the JIT kernels launched while a \ref
+ * ScopedKernelStatistics was active
+ *
+ * The values are collected from the kernel history of Dr.Jit, which records
+ * every kernel launch when kernel profiling is enabled (see \ref
+ * Profiler::set_kernel_profiling()). All times are in milliseconds.
+ */
+struct MI_EXPORT_LIB KernelStatistics {
+    /// Number of kernel launches (including reductions and other operations)
+    uint32_t kernel_count = 0;
+    /// Number of launches of kernels that didn't need to be compiled
+    uint32_t cache_hits = 0;
+    /// Number of cache hits that were loaded from the on-disk kernel cache
+    uint32_t disk_cache_hits = 0;
+    /// Time spent generating the kernel IR
+    double codegen_time = 0.0;
+    /// Time spent compiling the IR with the backend (NVRTC/PTX or LLVM)
+    double backend_time = 0.0;
+    /// Time spent executing the kernels
+    double execution_time = 0.0;
+    /// High-water mark of the tracked memory of the backend in bytes
+    size_t peak_memory = 0;
+
+    /// Fraction of the launches that didn't need to compile their kernel
+    double cache_hit_rate() const {
+        return kernel_count > 0 ? (double) cache_hits / kernel_count : 0.0;
+    }
+
+    /// Accumulate the statistics of another interval
+    KernelStatistics &operator+=(const KernelStatistics &other);
+
+    /// Return a one-line human-readable summary
+    std::string to_string() const;
 };
 
 class MI_EXPORT_LIB Profiler {
 public:
     static void static_initialization();
     static void static_shutdown();
+
+    /// Were the ray traversal statistics enabled at compile time?
+    static constexpr bool has_ray_statistics() {
+#if defined(MI_ENABLE_RAY_STATISTICS)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * \brief Add the given values (one per \ref RayStatistic) to the ray
+     * traversal statistics of the calling thread
+     */
+    static void add_ray_statistics(const uint64_t *values);
+
+    /// Return a ray traversal statistic of the calling thread
+    static uint64_t thread_ray_statistic(RayStatistic stat);
+
+    /// Return a ray traversal statistic accumulated over all threads
+    static uint64_t ray_statistic(RayStatistic stat);
+
+    /// Reset the ray traversal statistics of all threads
+    static void reset_ray_statistics();
+
+    /// Return a human-readable summary of the ray traversal statistics
+    static std::string ray_statistics_report();
+
+    /**
+     * \brief Enable or disable the built-in phase profiler
+     *
+     * While enabled, every \ref ScopedPhase records the time spent in its
+     * phase on a stack of the calling thread, which yields a tree of nested
+     * phases per thread. When disabled (the default), a \ref ScopedPhase only
+     * checks a flag. In JIT (LLVM/CUDA) variants, the phases are only entered
+     * while the computation is traced, hence the profile then covers the
+     * tracing rather than the execution of the kernels.
+     *
+     * When enabled, the report is also written to the log at shutdown.
+     */
+    static void set_phase_profiling(bool enabled);
+
+    /// Is the built-in phase profiler enabled?
+    static bool phase_profiling();
+
+    /// Reset the phase profile of all threads
+    static void reset_phase_profile();
+
+    /**
+     * \brief Return a hierarchical summary of the phase profile
+     *
+     * Every phase is listed below the phase it was entered from, with its
+     * share of the time accumulated over all threads (including and
+     * excluding nested phases) and the number of times it was entered.
+     */
+    static std::string phase_profile_report();
+
+    /**
+     * \brief Start recording a timeline trace
+     *
+     * While a trace is recorded, every \ref ScopedPhase and \ref
+     * ScopedTraceEvent adds an event with its start and end time to the
+     * timeline of the calling thread. Previously recorded events are
+     * discarded.
+     */
+    static void start_trace();
+
+    /// Stop recording the timeline trace (the events are kept)
+    static void stop_trace();
+
+    /// Is a timeline trace currently being recorded?
+    static bool tracing();
+
+    /**
+     * \brief Write the recorded timeline trace to a file
+     *
+     * The file uses the JSON trace event format of Chrome, which can be
+     * opened in Perfetto (https://ui.perfetto.dev) or in
+     * ``chrome://tracing``. Every thread appears as a separate track.
+     */
+    static void write_trace(const fs::path &path);
+
+    /**
+     * \brief Enable or disable the collection of JIT kernel statistics
+     *
+     * While enabled, every \ref ScopedKernelStatistics gathers the number
+     * of kernel launches, the kernel cache hit rate, the compilation and
+     * execution times, and the peak memory usage (see \ref KernelStatistics)
+     * of the JIT variants, which e.g. yields a summary per call to
+     * Integrator::render(). The statistics are also accumulated per \ref
+     * ProfilerPhase. This enables the kernel history of Dr.Jit whose entries
+     * are consumed by the profiler. It has no effect in scalar variants.
+     *
+     * When enabled, the report is also written to the log at shutdown.
+     */
+    static void set_kernel_profiling(bool enabled);
+
+    /// Is the collection of JIT kernel statistics enabled?
+    static bool kernel_profiling();
+
+    /// Return the kernel statistics accumulated by a phase
+    static KernelStatistics kernel_statistics(ProfilerPhase phase);
+
+    /// Reset the accumulated kernel statistics of all phases
+    static void reset_kernel_statistics();
+
+    /// Return a human-readable summary of the kernel statistics per phase
+    static std::string kernel_statistics_report();
+
+    /**
+     * \brief Enable or disable the instrumentation of JIT kernels with the
+     * profiler phases
+     *
+     * In JIT variants, plugins only trace their computation, which is then
+     * fused into large kernels, hence the phase profile can't tell which
+     * plugins are responsible for the execution time. While the
+     * instrumentation is enabled, every \ref ScopedPhase pushes its name
+     * onto the label prefix stack of Dr.Jit, which labels the variables
+     * created within the phase (e.g. <tt>Integrator::render()/BSDF::sample()
+     * </tt>). Dr.Jit includes these labels as comments in the generated IR
+     * (LLVM IR or PTX). Every \ref ScopedKernelStatistics then splits the
+     * execution time of each kernel among the phases in proportion to the
+     * number of IR instructions generated by each of them, see \ref
+     * kernel_phase_report(). This is an estimate, since instructions differ
+     * in cost, but it has almost no runtime overhead.
+     *
+     * The labels change the generated code, hence instrumented kernels are
+     * compiled separately from the regular ones. When enabled, the report is
+     * also written to the log at shutdown.
+     */
+    static void set_kernel_instrumentation(bool enabled);
+
+    /// Is the instrumentation of JIT kernels enabled?
+    static bool kernel_instrumentation();
+
+    /**
+     * \brief Return the kernel execution time (in milliseconds) attributed
+     * to a phase by the kernel instrumentation
+     *
+     * The time is exclusive, i.e. it doesn't include the time of the nested
+     * phases.
+     */
+    static double kernel_phase_time(ProfilerPhase phase);
+
+    /// Return a human-readable summary of the kernel execution time per phase
+    static std::string kernel_phase_report();
+};
+
+/**
+ * \brief Collects the statistics of the JIT kernels launched during its
+ * lifetime on behalf of a \ref ProfilerPhase
+ *
+ * This object is only active while kernel profiling or instrumentation is
+ * enabled (see \ref Profiler::set_kernel_profiling() and \ref
+ * Profiler::set_kernel_instrumentation()), a JIT backend was specified, and no
+ * other instance is active. Kernels launched before its construction are
+ * not accounted for. The statistics are added to those of the phase when
+ * \ref finish() is called, or at the latest by the destructor.
+ */
+class MI_EXPORT_LIB ScopedKernelStatistics {
+public:
+    ScopedKernelStatistics(ProfilerPhase phase, uint32_t backend);
+    ~ScopedKernelStatistics() { finish(); }
+
+    /// Is this object collecting kernel statistics?
+    bool active() const { return m_active; }
+
+    /**
+     * \brief Stop collecting and return the statistics of the kernels
+     * launched so far
+     *
+     * This waits for the kernels to finish. Subsequent calls return the
+     * same statistics.
+     */
+    const KernelStatistics &finish();
+
+    ScopedKernelStatistics(const ScopedKernelStatistics &) = delete;
+    ScopedKernelStatistics &operator=(const ScopedKernelStatistics &) = delete;
+
+private:
+    ProfilerPhase m_phase;
+    uint32_t m_backend;
+    bool m_active = false;
+    bool m_history_flag = false;
+    KernelStatistics m_stats;
+};
+
+/**
+ * \brief Adds an event to the trace timeline of the calling thread while a
+ * trace is recorded (see \ref Profiler::start_trace())
+ *
+ * The event lasts from the construction until the destruction of this
+ * object. When no trace is recorded, this only checks a flag.
+ */
+struct MI_EXPORT_LIB ScopedTraceEvent {
+    ScopedTraceEvent(const char *category, const std::string &name,
+                     const std::string &info = "") {
+        if (unlikely(detail::profiler_flags.load(std::memory_order_relaxed) &
+                     detail::ProfilerTrace))
+            begin(category, name, info);
+    }
+
+    ~ScopedTraceEvent() {
+        if (unlikely(m_index != (size_t) -1))
+            end();
+    }
+
+    /// Is this event being recorded?
+    bool active() const { return m_index != (size_t) -1; }
+
+    /// Set additional information that is shown with the event
+    void set_info(const std::string &info);
+
+    ScopedTraceEvent(const ScopedTraceEvent &) = delete;
+    ScopedTraceEvent &operator=(const ScopedTraceEvent &) = delete;
+
+private:
+    void begin(const char *category, const std::string &name,
+               const std::string &info);
+    void end();
+
+private:
+    /// Index of the event in the timeline of the thread
+    size_t m_index = (size_t) -1;
+    /// Detects whether the timeline was cleared in the meantime
+    uint32_t m_generation = 0;
+};
+
+/**
+ * \brief Local accumulator of ray traversal statistics
+ *
+ * Traversal routines increment the counters of a local instance, which adds
+ * them to the statistics of the calling thread once it goes out of scope.
+ * When Mitsuba is compiled without \c MI_ENABLE_RAY_STATISTICS, this class
+ * is empty and all of its operations compile to nothing.
+ */
+struct ScopedRayStatistics {
+#if defined(MI_ENABLE_RAY_STATISTICS)
+    ScopedRayStatistics() = default;
+    ~ScopedRayStatistics() { Profiler::add_ray_statistics(values); }
+
+    void add(RayStatistic stat, uint64_t value = 1) {
+        values[(int) stat] += value;
+    }
+
+    uint64_t values[int(RayStatistic::RayStatisticCount)] { };
+#else
+    ScopedRayStatistics() = default;
+    void add(RayStatistic, uint64_t = 1) { }
+#endif
+
+    ScopedRayStatistics(const ScopedRayStatistics &) = delete;
+    ScopedRayStatistics &operator=(const ScopedRayStatistics &) = delete;
 };
 
 NAMESPACE_END(mitsuba)
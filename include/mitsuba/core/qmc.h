@@ -251,4 +251,60 @@ Float sobol_2(UInt index, UInt scramble = 0) {
     }
 }
 
+/// Reverse the order of the bits of a 32 bit unsigned integer
+template <typename UInt32> UInt32 reverse_bits_32(UInt32 v) {
+    v = (v << 16) | (v >> 16);
+    v = ((v & 0x00ff00ff) << 8) | ((v & 0xff00ff00) >> 8);
+    v = ((v & 0x0f0f0f0f) << 4) | ((v & 0xf0f0f0f0) >> 4);
+    v = ((v & 0x33333333) << 2) | ((v & 0xcccccccc) >> 2);
+    v = ((v & 0x55555555) << 1) | ((v & 0xaaaaaaaa) >> 1);
+    return v;
+}
+
+/**
+ * \brief Return the 32 bit fixed-point representation of the second
+ * dimension of the Sobol' sequence
+ *
+ * This is the unscrambled value of \ref sobol_2() prior to its conversion to
+ * a floating point number. The first dimension is given by \ref
+ * reverse_bits_32().
+ */
+template <typename UInt32> UInt32 sobol_2_bits(UInt32 index) {
+    UInt32 v = 1U << 31, result = 0;
+
+    std::tie(v, result, index) = dr::while_loop(
+        std::make_tuple(v, result, index),
+        [](const UInt32&, const UInt32&, const UInt32& index) {
+            return index != 0U;
+        },
+        [](UInt32& v, UInt32& result, UInt32& index) {
+            dr::masked(result, ((index & 1U) == 1U)) ^= v;
+            index >>= 1;
+            v ^= v >> 1;
+        },
+        "sobol_2_bits");
+
+    return result;
+}
+
+/**
+ * \brief Apply a hash-based Owen scrambling to a 32 bit fixed-point sample
+ * of a base-2 sequence
+ *
+ * Every bit of the sample is flipped depending on the bits preceding it,
+ * which preserves the stratification of (0, m, 2)-nets such as the first
+ * two dimensions of the Sobol' sequence. This is the Laine-Karras style
+ * permutation proposed by Burley (Practical Hash-based Owen Scrambling, JCGT
+ * 2020), with different seeds producing statistically independent scramblings.
+ */
+template <typename UInt32> UInt32 owen_scramble_2(UInt32 v, UInt32 seed) {
+    v = reverse_bits_32(v);
+    v ^= v * 0x3d20adeau;
+    v += seed;
+    v *= (seed >> 16) | 1u;
+    v ^= v * 0x05526c56u;
+    v ^= v * 0x53a22864u;
+    return reverse_bits_32(v);
+}
+
 NAMESPACE_END(mitsuba)
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/filesystem.h>
+#include <functional>
+#include <typeinfo>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Process-wide cache of resources that were loaded from files
+ *
+ * Plugins that load large immutable data (e.g. bitmaps or volume grids) from
+ * a file can request it through this cache, so that a file which is
+ * referenced several times, e.g. by textures with different wrap modes or
+ * by several media, is only read and stored once.
+ *
+ * Entries are identified by the absolute path of the file, its size and last
+ * modification time, and a string describing any parameters that affect how
+ * the file is loaded. A file that changed on disk is therefore loaded again.
+ * Concurrent requests for the same entry (e.g. during parallel scene loading)
+ * wait for the first one to finish loading it.
+ *
+ * The cache only keeps resources alive as long as they are used elsewhere:
+ * entries that are no longer referenced by any other object are released by
+ * subsequent requests. While a \ref ResourceCache::Scope exists (e.g. during
+ * scene loading), all entries are kept instead, since plugins often convert
+ * the loaded data and release it before the next reference is instantiated.
+ * The returned objects are shared, and callers must copy them before making
+ * any modifications.
+ */
+class MI_EXPORT_LIB ResourceCache {
+public:
+    /// Keeps all cached resources alive during its lifetime
+    struct MI_EXPORT_LIB Scope {
+        Scope();
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+    /// Function that loads a resource from the given (resolved) path
+    using LoadFunction = std::function<ref<Object>(const fs::path &)>;
+
+    /**
+     * \brief Return the cached resource for a file, or load it
+     *
+     * \param path
+     *     Path of the file, which must already be resolved (e.g. using
+     *     \ref FileResolver).
+     *
+     * \param params
+     *     Description of further parameters that affect the loaded resource.
+     *     Requests with different parameters refer to different entries.
+     *
+     * \param load
+     *     Function that is called to load the resource if no entry exists.
+     */
+    static ref<Object> get(const fs::path &path, const std::string &params,
+                           const LoadFunction &load);
+
+    /**
+     * \brief Typed version of \ref get() that constructs a \c T from the path
+     *
+     * The type is part of the entry, hence e.g. the volume grids of different
+     * variants are cached separately.
+     */
+    template <typename T>
+    static ref<T> get(const fs::path &path, const std::string &params = "") {
+        std::string key = std::string(typeid(T).name()) + ";" + params;
+        ref<Object> object = get(path, key, [](const fs::path &p) {
+            return ref<Object>(new T(p));
+        });
+        return ref<T>(static_cast<T *>(object.get()));
+    }
+
+    /**
+     * \brief Asynchronously load a resource into the cache
+     *
+     * Starts loading the entry on the thread pool and returns immediately.
+     * A subsequent \ref get() with the same arguments waits for the load to
+     * finish (it does not load the file a second time). Errors are only
+     * logged, since the subsequent \ref get() reports them.
+     *
+     * This is meant to be used within a \ref Scope, which keeps the loaded
+     * entry alive until it is requested. The destructor of the scope waits
+     * for all pending loads.
+     */
+    static void prefetch(const fs::path &path, const std::string &params,
+                         const LoadFunction &load);
+
+    /// Typed version of \ref prefetch(), see \ref get() for details
+    template <typename T>
+    static void prefetch(const fs::path &path, const std::string &params = "") {
+        std::string key = std::string(typeid(T).name()) + ";" + params;
+        prefetch(path, key, [](const fs::path &p) {
+            return ref<Object>(new T(p));
+        });
+    }
+
+    /// Wait for all loads started by \ref prefetch() to finish
+    static void wait();
+
+    /// Return the number of resources in the cache
+    static size_t size();
+
+    /// Release all cached resources
+    static void clear();
+
+    /// Release all cached resources at shutdown
+    static void static_shutdown();
+};
+
+NAMESPACE_END(mitsuba)
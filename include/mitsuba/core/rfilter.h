@@ -44,6 +44,9 @@ enum class FilterBoundaryCondition {
  * Because image filters are generally too expensive to evaluate for each
  * sample, the implementation of this class internally precomputes an discrete
  * representation, whose resolution given by \ref MI_FILTER_RESOLUTION.
+ * In scalar variants, it furthermore tabulates the weights of all pixels
+ * covered by a sample as a function of its sub-pixel offset (see \ref
+ * offset_weights()).
  */
 template <typename Float, typename Spectrum>
 class MI_EXPORT_LIB ReconstructionFilter : public Object {
@@ -77,6 +80,43 @@ public:
         }
     }
 
+    /**
+     * \brief Return the tabulated weights of the pixels surrounding a sample
+     * with sub-pixel offset \c u (in <tt>[0, 1)</tt>)
+     *
+     * Entry \c i of the returned row equals the value of \ref
+     * eval_discretized() at <tt>offset_first_tap() + i - u</tt>, i.e. the
+     * weight of the pixel (center) located \c offset_first_tap() + i pixels
+     * after the one containing the sample. The row has \ref offset_taps()
+     * entries, which are zero outside of the support of the filter.
+     *
+     * The offsets are quantized so that all offsets mapping to the same table
+     * row produce the same discretized weights. This function returns \c
+     * nullptr when no table is available (in JIT variants, or when the radius
+     * of the filter does not permit such a quantization), and when \c u lies
+     * too close to the boundary between two rows to decide reliably. Callers
+     * should fall back to \ref eval_discretized() in this case.
+     */
+    MI_INLINE const ScalarFloat *offset_weights(ScalarFloat u) const {
+        if (m_offset_weights.empty())
+            return nullptr;
+
+        ScalarFloat t = u * m_offset_resolution;
+        uint32_t row = (uint32_t) t;
+        ScalarFloat frac = t - (ScalarFloat) row;
+
+        if (row >= m_offset_resolution || frac < 1e-3f || frac > 1.f - 1e-3f)
+            return nullptr;
+
+        return m_offset_weights.data() + row * m_offset_taps;
+    }
+
+    /// Return the number of entries of the rows returned by \ref offset_weights()
+    uint32_t offset_taps() const { return m_offset_taps; }
+
+    /// Return the pixel offset of the first entry of \ref offset_weights()
+    int32_t offset_first_tap() const { return m_offset_first_tap; }
+
     MI_DECLARE_CLASS()
 protected:
     /// Create a new reconstruction filter
@@ -89,6 +129,10 @@ protected:
     ScalarFloat m_radius, m_scale_factor;
     std::vector<ScalarFloat> m_values;
     uint32_t m_border_size;
+    std::vector<ScalarFloat> m_offset_weights;
+    uint32_t m_offset_resolution;
+    uint32_t m_offset_taps;
+    int32_t m_offset_first_tap;
 };
 
 /**
@@ -292,6 +336,73 @@ template <typename Scalar_> struct Resampler {
     }
 
 
+    /**
+     * \brief Resample many adjacent columns of an image at once
+     *
+     * This is equivalent to calling \ref resample() with a single channel
+     * for each of the \c count columns starting at \c source and \c target,
+     * and it produces the same values. However, it traverses the data one
+     * row at a time, which accesses memory contiguously and lets the inner
+     * loop vectorize across columns.
+     *
+     * \param source
+     *     Pointer to the first column of the source array
+     * \param source_row_stride
+     *     Number of values between consecutive source rows
+     * \param target
+     *     Pointer to the first column of the target array
+     * \param target_row_stride
+     *     Number of values between consecutive target rows
+     * \param count
+     *     Number of adjacent columns to be resampled
+     */
+    void resample_columns(const Scalar *source, size_t source_row_stride,
+                          Scalar *target, size_t target_row_stride,
+                          uint32_t count) const {
+        const uint32_t taps = m_taps, half_taps = m_taps / 2;
+        const Scalar min = std::get<0>(m_clamp);
+        const Scalar max = std::get<1>(m_clamp);
+        const bool clamp = m_clamp != std::make_pair(
+            -std::numeric_limits<Scalar>::infinity(),
+             std::numeric_limits<Scalar>::infinity());
+
+        for (uint32_t i = 0; i < m_target_res; ++i) {
+            const int32_t offset =
+                m_start ? m_start[i] : ((int32_t) i - (int32_t) half_taps);
+            const Scalar *weights = m_weights.get() + (m_start ? i * taps : 0);
+            Scalar *out = target + i * target_row_stride;
+
+            for (uint32_t k = 0; k < count; ++k)
+                out[k] = Scalar(0);
+
+            for (uint32_t j = 0; j < taps; ++j) {
+                int32_t pos = offset + (int32_t) j;
+                const Scalar weight = weights[j];
+
+                if (unlikely(pos < 0 || pos >= (int32_t) m_source_res)) {
+                    if (m_bc == FilterBoundaryCondition::One ||
+                        m_bc == FilterBoundaryCondition::Zero) {
+                        const Scalar value =
+                            Scalar(m_bc == FilterBoundaryCondition::One ? 1 : 0);
+                        for (uint32_t k = 0; k < count; ++k)
+                            out[k] += value * weight;
+                        continue;
+                    }
+                    pos = boundary_position(pos);
+                }
+
+                const Scalar *row = source + pos * source_row_stride;
+                for (uint32_t k = 0; k < count; ++k)
+                    out[k] += row[k] * weight;
+            }
+
+            if (clamp) {
+                for (uint32_t k = 0; k < count; ++k)
+                    out[k] = dr::template clip<Scalar>(out[k], min, max);
+            }
+        }
+    }
+
     /// Return a human-readable summary
     std::string to_string() const {
         return tfm::format("Resampler[source_res=%i, target_res=%i]",
@@ -332,22 +443,29 @@ private:
                 weights += taps;
         }
 
-        /* Use a faster branch-free loop for resampling the main portion */
+        /* Use a faster branch-free loop for resampling the main portion. The
+           innermost loop runs over channels so that it can be vectorized,
+           while each channel still accumulates its taps in the same order. */
         for (uint32_t i = m_fast_start; i < m_fast_end; ++i) {
             const int32_t offset =
                 Resample ? (*start++) : ((int32_t) i - half_taps);
 
-            for (uint32_t ch = 0; ch < channels; ++ch) {
-                Scalar result = 0;
-                for (uint32_t j = 0; j < taps; ++j)
-                    result +=
-                        source[source_stride * (offset + (int32_t) j) + ch] *
-                        weights[j];
+            for (uint32_t ch = 0; ch < channels; ++ch)
+                target[ch] = Scalar(0);
 
-                *target++ = Clamp ? dr::template clip<Scalar>(result, min, max) : result;
+            for (uint32_t j = 0; j < taps; ++j) {
+                const Scalar *s = source + source_stride * (offset + (int32_t) j);
+                const Scalar weight = weights[j];
+                for (uint32_t ch = 0; ch < channels; ++ch)
+                    target[ch] += s[ch] * weight;
             }
 
-            target += target_stride;
+            if (Clamp) {
+                for (uint32_t ch = 0; ch < channels; ++ch)
+                    target[ch] = dr::template clip<Scalar>(target[ch], min, max);
+            }
+
+            target += channels + target_stride;
 
             if (Resample)
                 weights += taps;
@@ -376,32 +494,39 @@ private:
 
     Scalar lookup(const Scalar *source, int32_t pos, uint32_t stride, uint32_t ch) const {
         if (unlikely(pos < 0 || pos >= (int32_t) m_source_res)) {
-            switch (m_bc) {
-                case FilterBoundaryCondition::Clamp:
-                    pos = dr::clip(pos, 0, (int32_t) m_source_res - 1);
-                    break;
-
-                case FilterBoundaryCondition::Repeat:
-                    pos = math::modulo(pos, (int32_t) m_source_res);
-                    break;
-
-                case FilterBoundaryCondition::Mirror:
-                    pos = math::modulo(pos, 2 * (int32_t) m_source_res - 2);
-                    if (pos >= (int32_t) m_source_res - 1)
-                        pos = 2 * m_source_res - 2 - pos;
-                    break;
-
-                case FilterBoundaryCondition::One:
-                    return Scalar(1);
-
-                case FilterBoundaryCondition::Zero:
-                    return Scalar(0);
-            }
+            if (m_bc == FilterBoundaryCondition::One)
+                return Scalar(1);
+            else if (m_bc == FilterBoundaryCondition::Zero)
+                return Scalar(0);
+            pos = boundary_position(pos);
         }
 
         return source[pos * stride + ch];
     }
 
+    /// Map an out-of-range position to the domain (for positional boundary conditions)
+    int32_t boundary_position(int32_t pos) const {
+        switch (m_bc) {
+            case FilterBoundaryCondition::Clamp:
+                pos = dr::clip(pos, 0, (int32_t) m_source_res - 1);
+                break;
+
+            case FilterBoundaryCondition::Repeat:
+                pos = math::modulo(pos, (int32_t) m_source_res);
+                break;
+
+            case FilterBoundaryCondition::Mirror:
+                pos = math::modulo(pos, 2 * (int32_t) m_source_res - 2);
+                if (pos >= (int32_t) m_source_res - 1)
+                    pos = 2 * m_source_res - 2 - pos;
+                break;
+
+            default:
+                break;
+        }
+        return pos;
+    }
+
 private:
     std::unique_ptr<int32_t[]> m_start;
     std::unique_ptr<Scalar[]> m_weights;
@@ -5,6 +5,7 @@
 #include <mitsuba/core/math.h>
 #include <drjit/matrix.h>
 #include <drjit/dynamic.h>
+#include <atomic>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -161,14 +162,23 @@ const float d65_table[MI_CIE_SAMPLES] = {
  * \ref cie1931_y as well as corresponding precomputed ITU-R Rec. BT.709 linear
  * RGB tables.
  */
+/**
+ * \brief Allocate arrays for the color space tables
+ *
+ * This function is called on demand by the first evaluation of a color
+ * matching function. Calling it during startup merely moves this (small)
+ * cost ahead of time.
+ */
+extern MI_EXPORT_LIB void color_management_static_initialization(bool cuda, bool llvm);
+extern MI_EXPORT_LIB void color_management_static_shutdown();
+
 NAMESPACE_BEGIN(detail)
 template <typename Float> struct CIE1932Tables {
     using FloatStorage = DynamicBuffer<Float>;
 
     void initialize(const float* ptr) {
-        if (initialized)
+        if (is_initialized())
             return;
-        initialized = true;
 
         xyz = Color<FloatStorage, 3>(
             dr::load<FloatStorage>(ptr, MI_CIE_SAMPLES),
@@ -179,17 +189,47 @@ template <typename Float> struct CIE1932Tables {
         srgb = xyz_to_srgb(xyz);
 
         d65 = dr::load<FloatStorage>(d65_table, MI_CIE_SAMPLES);
+
+        initialized.store(true, std::memory_order_release);
+    }
+
+    /**
+     * \brief Initialize the tables from a copy of the (already initialized)
+     * host tables
+     *
+     * This doesn't record any arithmetic, and is therefore safe to call while
+     * a JIT backend traces a symbolic loop or virtual function call.
+     */
+    void initialize(const CIE1932Tables<float> &host) {
+        if (is_initialized())
+            return;
+
+        auto copy = [](const DynamicBuffer<float> &value) {
+            return dr::load<FloatStorage>(value.data(), value.size());
+        };
+
+        xyz  = Color<FloatStorage, 3>(copy(host.xyz.x()), copy(host.xyz.y()),
+                                      copy(host.xyz.z()));
+        srgb = Color<FloatStorage, 3>(copy(host.srgb.x()), copy(host.srgb.y()),
+                                      copy(host.srgb.z()));
+        d65  = copy(host.d65);
+
+        initialized.store(true, std::memory_order_release);
     }
 
     void release() {
-        if (!initialized)
+        if (!is_initialized())
             return;
-        initialized = false;
+        initialized.store(false, std::memory_order_release);
 
         xyz = srgb = Color<FloatStorage, 3>();
         d65 = FloatStorage();
     }
 
+    bool is_initialized() const {
+        return initialized.load(std::memory_order_acquire);
+    }
+
     /// CIE 1931 XYZ color tables
     Color<FloatStorage, 3> xyz;
     /// ITU-R Rec. BT.709 linear RGB tables
@@ -198,7 +238,7 @@ template <typename Float> struct CIE1932Tables {
     FloatStorage d65;
 
 private:
-    bool initialized = false;
+    std::atomic<bool> initialized { false };
 };
 
 extern MI_EXPORT_LIB CIE1932Tables<float> color_space_tables_scalar;
@@ -209,25 +249,30 @@ extern MI_EXPORT_LIB CIE1932Tables<dr::LLVMArray<float>> color_space_tables_llvm
 extern MI_EXPORT_LIB CIE1932Tables<dr::CUDAArray<float>> color_space_tables_cuda;
 #endif
 
-template <typename Float> auto get_color_space_tables() {
+/// Return the color space tables of a backend, initializing them if necessary
+template <typename Float> const auto &get_color_space_tables() {
 #if defined(MI_ENABLE_LLVM)
-    if constexpr (dr::is_llvm_v<Float>)
+    if constexpr (dr::is_llvm_v<Float>) {
+        if (unlikely(!color_space_tables_llvm.is_initialized()))
+            color_management_static_initialization(false, true);
         return color_space_tables_llvm;
-    else
+    } else
 #endif
 #if defined(MI_ENABLE_CUDA)
-    if constexpr (dr::is_cuda_v<Float>)
+    if constexpr (dr::is_cuda_v<Float>) {
+        if (unlikely(!color_space_tables_cuda.is_initialized()))
+            color_management_static_initialization(true, false);
         return color_space_tables_cuda;
-    else
+    } else
 #endif
-    return color_space_tables_scalar;
+    {
+        if (unlikely(!color_space_tables_scalar.is_initialized()))
+            color_management_static_initialization(false, false);
+        return color_space_tables_scalar;
+    }
 }
 NAMESPACE_END(detail)
 
-/// Allocate arrays for the color space tables
-extern MI_EXPORT_LIB void color_management_static_initialization(bool cuda, bool llvm);
-extern MI_EXPORT_LIB void color_management_static_shutdown();
-
 /**
  * \brief Evaluate the CIE 1931 XYZ color matching functions given a wavelength
  * in nanometers
@@ -248,7 +293,7 @@ Result cie1931_xyz(Float wavelength, dr::mask_t<Float> active = true) {
     UInt32 i0 = dr::clip(UInt32(t), dr::zeros<UInt32>(), UInt32(MI_CIE_SAMPLES - 2)),
            i1 = i0 + 1;
 
-    auto tables = detail::get_color_space_tables<Float32>();
+    const auto &tables = detail::get_color_space_tables<Float32>();
     Float v0_x = (Float) dr::gather<Float32>(tables.xyz.x(), i0, active);
     Float v1_x = (Float) dr::gather<Float32>(tables.xyz.x(), i1, active);
     Float v0_y = (Float) dr::gather<Float32>(tables.xyz.y(), i0, active);
@@ -284,7 +329,7 @@ Float cie1931_y(Float wavelength, dr::mask_t<Float> active = true) {
     UInt32 i0 = dr::clip(UInt32(t), dr::zeros<UInt32>(), UInt32(MI_CIE_SAMPLES - 2)),
           i1 = i0 + 1;
 
-    auto tables = detail::get_color_space_tables<Float32>();
+    const auto &tables = detail::get_color_space_tables<Float32>();
     Float v0 = (Float) dr::gather<Float32>(tables.xyz.y(), i0, active);
     Float v1 = (Float) dr::gather<Float32>(tables.xyz.y(), i1, active);
 
@@ -314,7 +359,7 @@ Float cie_d65(Float wavelength, dr::mask_t<Float> active = true) {
     UInt32 i0 = dr::clip(UInt32(t), dr::zeros<UInt32>(), UInt32(MI_CIE_SAMPLES - 2)),
            i1 = i0 + 1;
 
-    auto tables = detail::get_color_space_tables<Float32>();
+    const auto &tables = detail::get_color_space_tables<Float32>();
     Float v0 = (Float) dr::gather<Float32>(tables.d65, i0, active);
     Float v1 = (Float) dr::gather<Float32>(tables.d65, i1, active);
 
@@ -345,7 +390,7 @@ Result linear_rgb_rec(Float wavelength, dr::mask_t<Float> active = true) {
     UInt32 i0 = dr::clip(UInt32(t), dr::zeros<UInt32>(), UInt32(MI_CIE_SAMPLES - 2)),
            i1 = i0 + 1;
 
-    auto tables = detail::get_color_space_tables<Float32>();
+    const auto &tables = detail::get_color_space_tables<Float32>();
     Float v0_r = (Float) dr::gather<Float32>(tables.srgb.x(), i0, active);
     Float v1_r = (Float) dr::gather<Float32>(tables.srgb.x(), i1, active);
     Float v0_g = (Float) dr::gather<Float32>(tables.srgb.y(), i0, active);
@@ -360,8 +360,10 @@ MI_DECLARE_ENUM_OPERATORS(Struct::Flags)
  * this reason, the implementation of this class relies on a JIT compiler that
  * generates fast conversion code on demand for each specific conversion. The
  * function is cached and reused in case the same conversion is needed later
- * on. Note that JIT compilation only works on x86_64 processors; other
- * platforms use a slow generic fallback implementation.
+ * on. Note that JIT compilation only works on x86_64 processors. There is no
+ * code generator for other architectures (e.g. AArch64): they use a generic
+ * interpreter that resolves all fields once upon construction and is
+ * typically several times slower than the generated code.
  */
 class MI_EXPORT_LIB StructConverter : public Object {
     using FuncType = bool (*) (size_t, size_t, const void *, void *);
@@ -428,6 +430,16 @@ protected:
         };
     };
 
+    /// Source data of a target field, resolved once in the constructor
+    struct FieldPlan {
+        /// Source field (unused if \c blend is nonempty or \c use_default is set)
+        Struct::Field source;
+        /// Weighted source fields of a blended target field
+        std::vector<std::pair<Float, Struct::Field>> blend;
+        /// Use the default value of the target field
+        bool use_default = false;
+    };
+
     bool load(const uint8_t *src, const Struct::Field &f, Value &value) const;
     void linearize(Value &value) const;
     void save(uint8_t *dst, const Struct::Field &f, Value value, size_t x, size_t y) const;
@@ -440,6 +452,12 @@ protected:
     FuncType m_func;
 #else
     bool m_dither;
+    bool m_source_swap, m_target_swap;
+    bool m_has_weight = false, m_has_alpha = false,
+         m_has_multiple_alpha_channels = false;
+    Struct::Field m_weight_field, m_alpha_field;
+    std::vector<Struct::Field> m_assert_fields;
+    std::vector<FieldPlan> m_plan;
 #endif
 };
 
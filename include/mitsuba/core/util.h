@@ -4,8 +4,10 @@
 #include <mitsuba/core/string.h>
 #include <mitsuba/core/logger.h>
 #include <tinyformat.h>
+#include <functional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 NAMESPACE_BEGIN(mitsuba)
 NAMESPACE_BEGIN(util)
@@ -18,6 +20,15 @@ NAMESPACE_BEGIN(util)
 /// Determine the number of available CPU cores (including virtual cores)
 extern MI_EXPORT_LIB int core_count();
 
+/**
+ * \brief Determine the NUMA node of every available CPU core
+ *
+ * The cores are listed in the same order as the indices accepted by
+ * \ref Thread::set_core_affinity(). On systems where the topology cannot be
+ * queried, all cores are reported as belonging to node 0.
+ */
+extern MI_EXPORT_LIB std::vector<uint32_t> core_numa_nodes();
+
 /**
  * \brief Convert a time difference (in seconds) to a string representation
  * \param time Time difference in (fractional) sections
@@ -38,6 +49,21 @@ extern MI_EXPORT_LIB void trap_debugger();
 /// Return the absolute path to <tt>libmitsuba-core.dylib/so/dll<tt>
 extern MI_EXPORT_LIB fs::path library_path();
 
+/**
+ * \brief Atomically create or replace the file \c filename
+ *
+ * The function \c write is called with the path of a temporary file in the
+ * same directory, which is subsequently renamed to \c filename. The name of
+ * the temporary file is unique to the calling process and invocation,
+ * hence other processes (or threads) that concurrently write the same file
+ * never share it, and readers never observe a partially written file.
+ * Missing parent directories are created. Throws an exception upon failure,
+ * in which case the temporary file is removed.
+ */
+extern MI_EXPORT_LIB void
+write_file_atomic(const fs::path &filename,
+                  const std::function<void(const fs::path &)> &write);
+
 /// Determine the width of the terminal window that is used to run Mitsuba
 extern MI_EXPORT_LIB int terminal_width();
 
@@ -175,6 +175,75 @@ MI_INLINE Value square_to_uniform_triangle_pdf(const Point<Value, 2> &p) {
 
 // =======================================================================
 
+/**
+ * \brief Uniformly sample a direction within the spherical triangle spanned
+ * by the unit vectors \c a, \c b, and \c c
+ *
+ * This is the solid angle sampling technique by James Arvo ("Stratified
+ * sampling of spherical triangles", SIGGRAPH 1995): the first sample
+ * dimension chooses a sub-triangle with the desired area, and the second one
+ * positions the direction along the arc connecting its third vertex with
+ * \c b. Degenerate triangles produce invalid (NaN) directions.
+ */
+template <typename Value>
+MI_INLINE Vector<Value, 3>
+square_to_spherical_triangle(const Point<Value, 2> &sample,
+                             const Vector<Value, 3> &a,
+                             const Vector<Value, 3> &b,
+                             const Vector<Value, 3> &c) {
+    using Vector3 = Vector<Value, 3>;
+
+    // Interior angles of the spherical triangle
+    Vector3 n_ab = dr::normalize(dr::cross(a, b)),
+            n_bc = dr::normalize(dr::cross(b, c)),
+            n_ca = dr::normalize(dr::cross(c, a));
+
+    Value alpha = dr::unit_angle(n_ab, -n_ca),
+          beta  = dr::unit_angle(n_bc, -n_ab),
+          gamma = dr::unit_angle(n_ca, -n_bc);
+
+    // Area of the sub-triangle (plus pi) selected by the first sample
+    Value area_pi = dr::lerp(dr::Pi<Value>, alpha + beta + gamma, sample.x());
+
+    auto [sin_alpha, cos_alpha] = dr::sincos(alpha);
+    auto [sin_area, cos_area] = dr::sincos(area_pi);
+
+    Value sin_phi = sin_area * cos_alpha - cos_area * sin_alpha,
+          cos_phi = cos_area * cos_alpha + sin_area * sin_alpha,
+          k1 = cos_phi + cos_alpha,
+          k2 = sin_phi - sin_alpha * dr::dot(a, b);
+
+    // Third vertex of the sub-triangle on the arc between 'a' and 'c'
+    Value cos_b = dr::clip((k2 + (k2 * cos_phi - k1 * sin_phi) * cos_alpha) /
+                           ((k2 * sin_phi + k1 * cos_phi) * sin_alpha), -1.f, 1.f),
+          sin_b = dr::safe_sqrt(1.f - dr::square(cos_b));
+    Vector3 c_p = cos_b * a + sin_b * dr::normalize(dr::fnmadd(a, dr::dot(c, a), c));
+
+    // Position along the arc between 'b' and the new vertex
+    Value cos_theta = 1.f - sample.y() * (1.f - dr::dot(c_p, b)),
+          sin_theta = dr::safe_sqrt(1.f - dr::square(cos_theta));
+
+    return cos_theta * b + sin_theta * dr::normalize(dr::fnmadd(b, dr::dot(c_p, b), c_p));
+}
+
+/**
+ * \brief Density of \ref square_to_spherical_triangle() per unit solid angle,
+ * i.e. the inverse of the solid angle spanned by the unit vectors \c a,
+ * \c b, and \c c
+ */
+template <typename Value>
+MI_INLINE Value square_to_spherical_triangle_pdf(const Vector<Value, 3> &a,
+                                                 const Vector<Value, 3> &b,
+                                                 const Vector<Value, 3> &c) {
+    // Van Oosterom and Strackee, "The Solid Angle of a Plane Triangle"
+    Value solid_angle = dr::abs(2.f * dr::atan2(
+        dr::dot(a, dr::cross(b, c)),
+        1.f + dr::dot(a, b) + dr::dot(a, c) + dr::dot(b, c)));
+    return dr::rcp(solid_angle);
+}
+
+// =======================================================================
+
 /// Sample a point on a 2D standard normal distribution. Internally uses the Box-Muller transformation
 template <typename Value>
 MI_INLINE Point<Value, 2> square_to_std_normal(const Point<Value, 2> &sample) {
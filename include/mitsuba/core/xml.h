@@ -52,13 +52,31 @@ using ParameterList = std::vector<std::tuple<std::string, std::string, bool>>;
  *
  * \param parallel
  *     Whether the loading should be executed on multiple threads in parallel
+ *
+ * \param cache_dir
+ *     Optional directory of a cache of parsed scene descriptions. A cached
+ *     description is keyed by the file name, variant and parameters, and is
+ *     used as long as the scene file and the files it includes are unchanged.
+ *     It skips the XML parsing, but the objects are still instantiated.
+ *
+ * \param reload
+ *     Reuse the objects of the previous load of this file in reload mode
+ *     whose description and referenced files are unchanged, and only
+ *     instantiate the changed objects and the objects that depend on them.
+ *     Shapes whose BSDF changed are reused with the new BSDF. Objects whose
+ *     parameters were changed by the application (see invalidate_reload())
+ *     are instantiated again. The scene itself is always created again, and
+ *     the other objects of the last load of every file in this mode are kept
+ *     alive for this purpose.
  */
 extern MI_EXPORT_LIB std::vector<ref<Object>> load_file(
                                         const fs::path &path,
                                         const std::string &variant,
                                         ParameterList parameters = ParameterList(),
                                         bool update_scene = false,
-                                        bool parallel = true);
+                                        bool parallel = true,
+                                        const fs::path &cache_dir = fs::path(),
+                                        bool reload = false);
 
 /// Load a Mitsuba scene from an XML string
 extern MI_EXPORT_LIB std::vector<ref<Object>> load_string(
@@ -67,6 +85,41 @@ extern MI_EXPORT_LIB std::vector<ref<Object>> load_string(
                                         ParameterList parameters = ParameterList(),
                                         bool parallel = true);
 
+/**
+ * \brief Write the instantiation times of subsequently loaded XML scenes
+ * to a CSV file
+ *
+ * Every load measures the time taken by the instantiation of each object,
+ * the thread instantiating it, and the time it waited for its dependencies,
+ * and logs the 20 slowest objects. When a path is specified, every load
+ * additionally writes (overwrites) a CSV file listing all objects sorted by
+ * their instantiation time. An empty path disables the report.
+ */
+extern MI_EXPORT_LIB void set_instantiation_report(const fs::path &path);
+
+/**
+ * \brief Set the size (in bytes) above which XML files are parsed in
+ * streaming mode
+ *
+ * The regular parser holds the text and the DOM of the entire document in
+ * memory. In streaming mode, the elements nested in the root element of the
+ * file are instead parsed and converted one at a time, which keeps the
+ * memory usage of large files (e.g. with millions of instances) bounded.
+ * Files that are upgraded and written back to disk, or that use version 1
+ * of the format, are always parsed as a whole. The default is 64 MiB.
+ */
+extern MI_EXPORT_LIB void set_streaming_threshold(size_t size);
+
+/**
+ * \brief Exclude an object from being reused by the reload mode of
+ * load_file()
+ *
+ * Should be called when the application changes the parameters of an
+ * object, so that the next reload of its scene file instantiates it again
+ * instead of carrying the change over. This is done by
+ * <tt>SceneParameters.update()</tt> for all updated objects.
+ */
+extern MI_EXPORT_LIB void invalidate_reload(const Object *object);
 
 
 NAMESPACE_BEGIN(detail)
@@ -92,6 +145,18 @@ extern MI_EXPORT_LIB ref<Object> create_texture_from_spectrum(
 extern MI_EXPORT_LIB std::vector<ref<Object>> expand_node(
                                         const ref<Object> &top_node);
 
+/**
+ * \brief Start loading the files referenced by the given objects in parallel
+ *
+ * Bitmap textures only decode their image when they are instantiated, which
+ * can happen late in the dependency graph of a scene. This function instead
+ * submits the loads of all referenced images to the \ref ResourceCache
+ * upfront (largest files first), so that reading and decoding them overlaps
+ * with the instantiation of the other objects.
+ */
+extern MI_EXPORT_LIB void prefetch_resources(
+                                        const std::vector<const Properties *> &props);
+
 /// Read a Mitsuba XML file and return a list of pairs containing the
 /// name of the plugin and the corresponding populated Properties object
 extern MI_EXPORT_LIB std::vector<std::pair<std::string, Properties>> xml_to_properties(
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <mitsuba/core/stream.h>
+#include <deque>
+#include <vector>
 
 extern "C" {
     struct z_stream_s;
@@ -12,6 +14,8 @@ NAMESPACE_BEGIN(mitsuba)
 NAMESPACE_BEGIN(detail)
 /// Buffer size used to communicate with zlib. The larger, the better.
 constexpr size_t kZStreamBufferSize = 32768;
+/// Default size of the independently compressed blocks of \ref ZStream::EBlockStream
+constexpr size_t kZStreamBlockSize = 1024 * 1024;
 NAMESPACE_END(detail)
 
 /**
@@ -19,13 +23,22 @@ NAMESPACE_END(detail)
  *
  * This class transparently decompresses and compresses reads and writes
  * to a nested stream, respectively.
+ *
+ * In addition to the standard deflate and gzip formats, the stream supports
+ * a block format (\ref EBlockStream) that splits the data into blocks of
+ * fixed size. These are compressed independently, which allows the stream to
+ * compress and decompress several blocks in parallel on the thread pool. Each
+ * block is stored as its uncompressed and compressed size (two little endian
+ * 32 bit integers) followed by the zlib-compressed data, and an empty block
+ * marks the end of the stream.
  */
 class MI_EXPORT_LIB ZStream : public Stream {
 public:
 
     enum EStreamType {
         EDeflateStream, /// A raw deflate stream
-        EGZipStream /// A gzip-compatible stream
+        EGZipStream, /// A gzip-compatible stream
+        EBlockStream /// Independently compressed blocks, processed in parallel
     };
 
     using Stream::read;
@@ -34,9 +47,12 @@ public:
     /** \brief Creates a new compression stream with the given underlying stream.
      * This new instance takes ownership of the child stream. The child stream
      * must outlive the ZStream.
+     *
+     * The parameter \c block_size specifies the uncompressed size of the
+     * blocks written by an \ref EBlockStream, and is ignored otherwise.
      */
     ZStream(Stream *child_stream, EStreamType stream_type = EDeflateStream,
-            int level = -1);
+            int level = -1, size_t block_size = detail::kZStreamBlockSize);
 
     /// Destructor
     ~ZStream();
@@ -65,6 +81,9 @@ public:
     /// Returns the child stream of this compression stream
     Stream *child_stream() { return m_child_stream; }
 
+    /// Returns the type of the compressed stream
+    EStreamType stream_type() const { return m_stream_type; }
+
     //! @}
     // =========================================================================
 
@@ -126,12 +145,36 @@ public:
 
     MI_DECLARE_CLASS()
 
+private:
+    struct Block;
+
+    /// Compress the pending data of an \ref EBlockStream asynchronously
+    void submit_block();
+
+    /// Wait for the oldest block being compressed and write it
+    void write_block();
+
+    /// Read and start decompressing blocks until enough are in flight
+    void fetch_blocks();
+
+    /// Wait for all pending blocks and release them
+    void release_blocks();
+
 private:
     ref<Stream> m_child_stream;
     std::unique_ptr<z_stream> m_deflate_stream, m_inflate_stream;
     uint8_t m_deflate_buffer[detail::kZStreamBufferSize];
     uint8_t m_inflate_buffer[detail::kZStreamBufferSize];
     bool m_did_write;
+
+    // State of EBlockStream streams
+    EStreamType m_stream_type;
+    int m_level;
+    size_t m_block_size;
+    std::vector<uint8_t> m_pending;
+    std::deque<std::unique_ptr<Block>> m_write_blocks, m_read_blocks;
+    size_t m_read_pos;
+    bool m_read_done;
 };
 
 NAMESPACE_END(mitsuba)
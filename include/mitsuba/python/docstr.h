@@ -391,6 +391,18 @@ static const char *__doc_mitsuba_AdjointIntegrator_AdjointIntegrator = R"doc(Cre
 
 static const char *__doc_mitsuba_AdjointIntegrator_class = R"doc()doc";
 
+static const char *__doc_mitsuba_AdjointIntegrator_connect_sensor =
+R"doc(Attempt connecting the given point to the sensor.
+
+If the point to connect is on the surface (non-null ``bsdf`` values),
+evaluate the BSDF in the direction of the sensor.
+
+Finally, splat ``weight`` (with all appropriate factors) to the given
+image block.
+
+Returns:
+    The quantity that was accumulated to the block.)doc";
+
 static const char *__doc_mitsuba_AdjointIntegrator_m_max_depth =
 R"doc(Longest visualized path depth (\c -1 = infinite). A value of ``1``
 will visualize only directly visible light sources. ``2`` will lead to
@@ -604,6 +616,9 @@ See also:
 See also:
     mitsuba.BSDFSample3f)doc";
 
+static const char *__doc_mitsuba_BSDFFlags_Depolarizing =
+R"doc(The BSDF does not polarize light: in polarized variants, all of its Mueller matrices are depolarizers (and no basis rotation is needed))doc";
+
 static const char *__doc_mitsuba_BSDF_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_BSDF_3 = R"doc()doc";
@@ -902,11 +917,14 @@ R"doc(Jointly evaluate the BSDF f(wi, wo), the probability per unit solid
 angle of sampling the given direction ``wo`` and importance sample the
 BSDF model.
 
-This is simply a wrapper around two separate function calls to
-eval_pdf() and sample(). The function exists to perform a smaller
-number of virtual function calls, which has some performance benefits
-on highly vectorized JIT variants of the renderer. (A ~20% performance
-improvement for the basic path tracer on CUDA)
+The default implementation is simply a wrapper around two separate
+function calls to eval_pdf() and sample(). The function exists to
+perform a smaller number of virtual function calls, which has some
+performance benefits on highly vectorized JIT variants of the
+renderer. (A ~20% performance improvement for the basic path tracer on
+CUDA) BSDFs with an expensive setup (texture lookups, construction of
+microfacet distributions, etc.) override it to perform this work only
+once for both queries.
 
 Parameter ``ctx``:
     A context data structure describing which lobes to evaluate, and
@@ -982,6 +1000,14 @@ Parameter ``si``:
 Parameter ``wo``:
     The outgoing direction)doc";
 
+static const char *__doc_mitsuba_BSDF_ray_flags =
+R"doc(Return the RayFlags of the surface interaction fields read by this
+BSDF (excluding its nested textures and BSDFs)
+
+The default implementation requests the shading frame, along with the
+UV parameterization of anisotropic BSDFs (which are oriented along the
+position partials) and of BSDFs needing texture differentials.)doc";
+
 static const char *__doc_mitsuba_BSDF_sample =
 R"doc(Importance sample the BSDF model
 
@@ -1042,6 +1068,15 @@ PNG and OpenEXR files are optionally annotated with string-valued
 metadata, and the gamma setting can be stored as well. Please see the
 class methods and enumerations for further detail.)doc";
 
+static const char *__doc_mitsuba_BitmapTileWriter =
+R"doc(Writes a tiled OpenEXR image incrementally, one row of tiles at a time
+
+This makes it possible to write images that do not fit into memory as a
+whole. The file is created when the first row is written, using the
+channels and metadata of that bitmap. All rows must have the same
+channel layout. The file is complete once every row has been written and
+the writer is destroyed. All methods are thread-safe.)doc";
+
 static const char *__doc_mitsuba_Bitmap_AlphaTransform = R"doc(Type of alpha transformation)doc";
 
 static const char *__doc_mitsuba_Bitmap_AlphaTransform_Empty = R"doc(No transformation (default))doc";
@@ -1247,6 +1282,8 @@ Remark:
     This function throws an exception when the bitmaps use different
     component formats or channels.)doc";
 
+static const char *__doc_mitsuba_Bitmap_async_write_limit = R"doc(Return the maximum number of pending write_async() calls)doc";
+
 static const char *__doc_mitsuba_Bitmap_buffer_size = R"doc(Return the bitmap size in bytes (excluding metadata))doc";
 
 static const char *__doc_mitsuba_Bitmap_bytes_per_pixel = R"doc(Return the number bytes of storage used per pixel)doc";
@@ -1310,6 +1347,13 @@ static const char *__doc_mitsuba_Bitmap_data_2 = R"doc(Return a pointer to the u
 
 static const char *__doc_mitsuba_Bitmap_detect_file_format = R"doc(Attempt to detect the bitmap file format in a given stream)doc";
 
+static const char *__doc_mitsuba_Bitmap_exr_thread_count =
+R"doc(Return the number of line buffers or tiles processed in parallel by
+OpenEXR)doc";
+
+static const char *__doc_mitsuba_Bitmap_exr_tile_size =
+R"doc(Return the tile size of written OpenEXR files (0: scanline files))doc";
+
 static const char *__doc_mitsuba_Bitmap_has_alpha = R"doc(Return whether this image has an alpha channel)doc";
 
 static const char *__doc_mitsuba_Bitmap_height = R"doc(Return the bitmap's height in pixels)doc";
@@ -1318,6 +1362,8 @@ static const char *__doc_mitsuba_Bitmap_m_component_format = R"doc()doc";
 
 static const char *__doc_mitsuba_Bitmap_m_data = R"doc()doc";
 
+static const char *__doc_mitsuba_Bitmap_m_memory = R"doc()doc";
+
 static const char *__doc_mitsuba_Bitmap_m_metadata = R"doc()doc";
 
 static const char *__doc_mitsuba_Bitmap_m_owns_data = R"doc()doc";
@@ -1429,6 +1475,24 @@ Parameter ``clamp``:
     Filtered image pixels will be clamped to the following range.
     Default: -infinity..infinity (i.e. no clamping is used))doc";
 
+static const char *__doc_mitsuba_Bitmap_set_async_write_limit =
+R"doc(Set the maximum number of pending write_async() calls
+
+The default value is 4.)doc";
+
+static const char *__doc_mitsuba_Bitmap_set_exr_thread_count =
+R"doc(Set the number of line buffers or tiles that OpenEXR compresses and
+decompresses in parallel
+
+The default value of -1 matches Thread::thread_count(), and 0 disables
+multithreading.)doc";
+
+static const char *__doc_mitsuba_Bitmap_set_exr_tile_size =
+R"doc(Set the tile size of OpenEXR files written by write()
+
+Tiled files can be read region by region (e.g. by BitmapRegionReader).
+The default value of 0 writes scanline files.)doc";
+
 static const char *__doc_mitsuba_Bitmap_set_metadata = R"doc(Set the a Properties object containing the image metadata)doc";
 
 static const char *__doc_mitsuba_Bitmap_set_premultiplied_alpha = R"doc(Specify whether the bitmap uses premultiplied alpha)doc";
@@ -1523,10 +1587,23 @@ compressor.)doc";
 
 static const char *__doc_mitsuba_Bitmap_write_async =
 R"doc(Equivalent to write(), but executes asynchronously on a different
-thread)doc";
+thread
+
+At most async_write_limit() writes are pending at any time: when the
+limit is reached, this function blocks until an earlier write has
+finished, which bounds the memory held by queued images. Use
+Thread::wait_for_tasks() to wait for all pending writes.)doc";
 
 static const char *__doc_mitsuba_Bitmap_write_exr = R"doc(Write a file using the OpenEXR file format)doc";
 
+static const char *__doc_mitsuba_Bitmap_write_exr_multipart =
+R"doc(Write several bitmaps as the named parts of a multi-part OpenEXR file
+
+The parts may differ in resolution and channel layout. The ``quality``
+parameter has the same meaning as in write().)doc";
+
+static const char *__doc_mitsuba_Bitmap_write_exr_multipart_2 = R"doc(Equivalent to the above, but writes to a file)doc";
+
 static const char *__doc_mitsuba_Bitmap_write_jpeg = R"doc(Save a file using the JPEG file format)doc";
 
 static const char *__doc_mitsuba_Bitmap_write_pfm = R"doc(Save a file using the PFM file format)doc";
@@ -1537,6 +1614,17 @@ static const char *__doc_mitsuba_Bitmap_write_ppm = R"doc(Save a file using the
 
 static const char *__doc_mitsuba_Bitmap_write_rgbe = R"doc(Save a file using the RGBE file format)doc";
 
+static const char *__doc_mitsuba_BlockOrder = R"doc(Order in which Spiral visits the blocks of an image)doc";
+
+static const char *__doc_mitsuba_BlockOrder_Hilbert =
+R"doc(Hilbert curve. Consecutive blocks are always adjacent, hence blocks
+that are rendered concurrently by different threads cover a compact
+region of the image and share cached scene data.)doc";
+
+static const char *__doc_mitsuba_BlockOrder_Morton = R"doc(Morton (Z-order) curve, a cheaper but less compact alternative)doc";
+
+static const char *__doc_mitsuba_BlockOrder_Spiral = R"doc(Outward spiral starting from the center of the image (default))doc";
+
 static const char *__doc_mitsuba_BoundingBox =
 R"doc(Generic n-dimensional bounding box data structure
 
@@ -1730,6 +1818,80 @@ static const char *__doc_mitsuba_BoundingSphere_radius = R"doc()doc";
 
 static const char *__doc_mitsuba_BoundingSphere_ray_intersect = R"doc(Check if a ray intersects a bounding box)doc";
 
+static const char *__doc_mitsuba_BufferedStream =
+R"doc(Read buffer layered on top of another (seekable) stream
+
+Loaders often read files using many small reads of individual values,
+each of which results in a virtual function call and a request to the
+child stream (e.g. to ``std::fstream`` in the case of a FileStream).
+This class instead fetches large sequential chunks of the child
+stream, from which subsequent reads are served. Reads that are larger
+than the buffer directly access the child stream.
+
+The templated read() function is furthermore inlined: when the static
+type of a stream is ``BufferedStream``, reading an arithmetic value
+reduces to a copy from the buffer.
+
+Writes are passed through to the child stream and discard the contents
+of the buffer. The child stream must implement seek(), tell() and
+size(), hence e.g. a ZStream cannot be buffered.)doc";
+
+static const char *__doc_mitsuba_BufferedStream_BufferedStream =
+R"doc(Creates a new buffered stream on top of the given child stream
+
+The buffered stream takes ownership of the child stream, and reads
+start at the current position of the child stream.)doc";
+
+static const char *__doc_mitsuba_BufferedStream_buffer_size = R"doc(Returns the size of the read buffer in bytes)doc";
+
+static const char *__doc_mitsuba_BufferedStream_can_read = R"doc(Can we read from the stream?)doc";
+
+static const char *__doc_mitsuba_BufferedStream_can_write = R"doc(Can we write to the stream?)doc";
+
+static const char *__doc_mitsuba_BufferedStream_child_stream = R"doc(Returns the child stream of this buffered stream)doc";
+
+static const char *__doc_mitsuba_BufferedStream_child_stream_2 = R"doc(Returns the child stream of this buffered stream)doc";
+
+static const char *__doc_mitsuba_BufferedStream_close =
+R"doc(Closes the stream and the underlying child stream. No further read or
+write operations are permitted.
+
+This function is idempotent.)doc";
+
+static const char *__doc_mitsuba_BufferedStream_flush = R"doc(Flushes the child stream)doc";
+
+static const char *__doc_mitsuba_BufferedStream_is_closed =
+R"doc(Whether the stream is closed (no read or write are then permitted).)doc";
+
+static const char *__doc_mitsuba_BufferedStream_read =
+R"doc(Reads one object of type T from the stream
+
+Arithmetic values that are available in the buffer and don't require
+an endianness swap are copied directly. All other reads go through
+Stream::read().)doc";
+
+static const char *__doc_mitsuba_BufferedStream_read_2 =
+R"doc(Reads a specified amount of data from the stream. Throws an exception
+when the stream ended prematurely.)doc";
+
+static const char *__doc_mitsuba_BufferedStream_read_line =
+R"doc(Convenience function for reading a line of text from an ASCII file)doc";
+
+static const char *__doc_mitsuba_BufferedStream_seek =
+R"doc(Seeks to a position inside the stream, reusing the buffer if possible)doc";
+
+static const char *__doc_mitsuba_BufferedStream_size = R"doc(Returns the size of the child stream)doc";
+
+static const char *__doc_mitsuba_BufferedStream_tell = R"doc(Gets the current position inside the stream)doc";
+
+static const char *__doc_mitsuba_BufferedStream_to_string = R"doc(Returns a string representation)doc";
+
+static const char *__doc_mitsuba_BufferedStream_truncate = R"doc(Truncates the child stream to a given size)doc";
+
+static const char *__doc_mitsuba_BufferedStream_write =
+R"doc(Writes a specified amount of data into the child stream. Throws an
+exception when not all data could be written.)doc";
+
 static const char *__doc_mitsuba_Class =
 R"doc(Stores meta-information about Object instances.
 
@@ -2115,7 +2277,14 @@ and provides various routines for transforming uniformly distributed
 samples so that they follow the stored distribution. Note that
 unnormalized probability mass functions (PMFs) will automatically be
 normalized during initialization. The associated scale factor can be
-retrieved using the function normalization().)doc";
+retrieved using the function normalization().
+
+By default, samples are generated by inverting the cumulative
+distribution function using a binary search, which takes logarithmic
+time. Optionally, an alias table (Walker/Vose) can be built during
+initialization, in which case the sampling routines run in constant
+time using two lookups. Note that the two methods map a given uniform
+sample to different indices.)doc";
 
 static const char *__doc_mitsuba_DiscreteDistribution2D =
 R"doc(======================================================================
@@ -2212,7 +2381,11 @@ static const char *__doc_mitsuba_DiscreteDistribution2D_to_string = R"doc()doc";
 
 static const char *__doc_mitsuba_DiscreteDistribution_DiscreteDistribution = R"doc(Create an uninitialized DiscreteDistribution instance)doc";
 
-static const char *__doc_mitsuba_DiscreteDistribution_DiscreteDistribution_2 = R"doc(Initialize from a given probability mass function)doc";
+static const char *__doc_mitsuba_DiscreteDistribution_DiscreteDistribution_2 =
+R"doc(Initialize from a given probability mass function
+
+When ``alias_table`` is ``True``, sampling uses an alias table (see
+the class description).)doc";
 
 static const char *__doc_mitsuba_DiscreteDistribution_DiscreteDistribution_3 = R"doc(Initialize from a given probability mass function (rvalue version))doc";
 
@@ -2224,6 +2397,8 @@ static const char *__doc_mitsuba_DiscreteDistribution_cdf_2 =
 R"doc(Return the unnormalized cumulative distribution function (const
 version))doc";
 
+static const char *__doc_mitsuba_DiscreteDistribution_compute_alias_table = R"doc(Build the alias table)doc";
+
 static const char *__doc_mitsuba_DiscreteDistribution_compute_cdf = R"doc()doc";
 
 static const char *__doc_mitsuba_DiscreteDistribution_compute_cdf_scalar = R"doc()doc";
@@ -2246,6 +2421,13 @@ static const char *__doc_mitsuba_DiscreteDistribution_eval_pmf_normalized =
 R"doc(Evaluate the normalized probability mass function (PMF) at index
 ``index``)doc";
 
+static const char *__doc_mitsuba_DiscreteDistribution_has_alias_table =
+R"doc(Does this distribution sample using an alias table?)doc";
+
+static const char *__doc_mitsuba_DiscreteDistribution_m_alias_index = R"doc()doc";
+
+static const char *__doc_mitsuba_DiscreteDistribution_m_alias_prob = R"doc()doc";
+
 static const char *__doc_mitsuba_DiscreteDistribution_m_cdf = R"doc()doc";
 
 static const char *__doc_mitsuba_DiscreteDistribution_m_normalization = R"doc()doc";
@@ -2254,6 +2436,8 @@ static const char *__doc_mitsuba_DiscreteDistribution_m_pmf = R"doc()doc";
 
 static const char *__doc_mitsuba_DiscreteDistribution_m_sum = R"doc()doc";
 
+static const char *__doc_mitsuba_DiscreteDistribution_m_use_alias_table = R"doc()doc";
+
 static const char *__doc_mitsuba_DiscreteDistribution_m_valid = R"doc()doc";
 
 static const char *__doc_mitsuba_DiscreteDistribution_normalization = R"doc(Return the normalization factor (i.e. the inverse of sum()))doc";
@@ -2271,6 +2455,10 @@ Parameter ``sample``:
 Returns:
     The discrete index associated with the sample)doc";
 
+static const char *__doc_mitsuba_DiscreteDistribution_sample_alias =
+R"doc(Sample using the alias table and return the chosen index along with
+the re-scaled sample value)doc";
+
 static const char *__doc_mitsuba_DiscreteDistribution_sample_pmf =
 R"doc(%Transform a uniformly distributed sample to the stored distribution
 
@@ -2313,6 +2501,11 @@ Returns:
 1. the discrete index associated with the sample 2. the re-scaled
 sample value 3. the normalized probability value of the sample)doc";
 
+static const char *__doc_mitsuba_DiscreteDistribution_set_alias_table =
+R"doc(Enable or disable sampling using an alias table
+
+This function updates the internal state (see update()).)doc";
+
 static const char *__doc_mitsuba_DiscreteDistribution_size = R"doc(Return the number of entries)doc";
 
 static const char *__doc_mitsuba_DiscreteDistribution_sum = R"doc(Return the original sum of PMF entries before normalization)doc";
@@ -2421,18 +2614,28 @@ static const char *__doc_mitsuba_Emitter_Emitter = R"doc()doc";
 
 static const char *__doc_mitsuba_Emitter_class = R"doc()doc";
 
-static const char *__doc_mitsuba_Emitter_dirty = R"doc(Return whether the emitter parameters have changed)doc";
+static const char *__doc_mitsuba_Emitter_dirty =
+R"doc(Return whether the emitter parameters have changed in a way that
+affects the scene's emitter sampling distributions
+
+This is the case for all parameter updates except those that only
+modify the emitted radiance (e.g. ``radiance``, ``intensity``, or
+``data``), see parameters_changed().)doc";
 
 static const char *__doc_mitsuba_Emitter_flags = R"doc(Flags for all components combined.)doc";
 
 static const char *__doc_mitsuba_Emitter_is_environment = R"doc(Is this an environment map light emitter?)doc";
 
-static const char *__doc_mitsuba_Emitter_m_dirty = R"doc(True if the emitters's parameters have changed)doc";
+static const char *__doc_mitsuba_Emitter_m_dirty = R"doc(True if the emitters's sampling weight or placement have changed)doc";
 
 static const char *__doc_mitsuba_Emitter_m_flags = R"doc(Combined flags for all properties of this emitter.)doc";
 
 static const char *__doc_mitsuba_Emitter_m_sampling_weight = R"doc(Sampling weight)doc";
 
+static const char *__doc_mitsuba_Emitter_m_scene_index = R"doc(Index of this emitter in the scene's list of emitters)doc";
+
+static const char *__doc_mitsuba_Emitter_m_training = R"doc(Is a training pass in progress? (see set_training()))doc";
+
 static const char *__doc_mitsuba_Emitter_operator_delete = R"doc()doc";
 
 static const char *__doc_mitsuba_Emitter_operator_delete_2 = R"doc()doc";
@@ -2443,10 +2646,50 @@ static const char *__doc_mitsuba_Emitter_operator_new_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Emitter_parameters_changed = R"doc()doc";
 
+static const char *__doc_mitsuba_Emitter_record_visibility =
+R"doc(Record the visibility of a direction sample during a training pass
+
+Parameter ``it``:
+    The reference point passed to sample_direction().
+
+Parameter ``ds``:
+    The direction sample generated by sample_direction().
+
+Parameter ``weight``:
+    The sampling weight of the direction sample, i.e. the emitted
+    radiance divided by the sampling density.
+
+Parameter ``visible``:
+    Whether the sampled point is visible from the reference point.)doc";
+
 static const char *__doc_mitsuba_Emitter_sampling_weight = R"doc(The emitter's sampling weight.)doc";
 
+static const char *__doc_mitsuba_Emitter_scene_index =
+R"doc(Return the index of this emitter in the scene's list of emitters)doc";
+
 static const char *__doc_mitsuba_Emitter_set_dirty = R"doc(Modify the emitter's "dirty" flag)doc";
 
+static const char *__doc_mitsuba_Emitter_set_scene_index =
+R"doc(Set the index of this emitter in the scene's list of emitters)doc";
+
+static const char *__doc_mitsuba_Emitter_set_training =
+R"doc(Start or stop a training pass
+
+Stopping a training pass updates the learned sampling distribution.)doc";
+
+static const char *__doc_mitsuba_Emitter_training = R"doc(Is a training pass in progress?)doc";
+
+static const char *__doc_mitsuba_Emitter_training_spp =
+R"doc(Return the number of samples per pixel of the training pass that the
+emitter requests before the next render job, or zero if it doesn't need
+one (the default)
+
+Emitters that learn their sampling distribution from the visibility of
+their samples request a training pass, during which (see
+set_training()) the scene reports the result of every visibility test
+of their direction samples via record_visibility(). This is currently
+only supported for the environment emitter of a scene.)doc";
+
 static const char *__doc_mitsuba_Emitter_traverse = R"doc()doc";
 
 static const char *__doc_mitsuba_Endpoint =
@@ -2622,6 +2865,29 @@ Parameter ``ps``:
 Returns:
     The corresponding sampling density.)doc";
 
+static const char *__doc_mitsuba_Endpoint_pdf_ray_direction =
+R"doc(Evaluate the directional density of the ray sampling method
+implemented by sample_ray().
+
+Given the origin of a ray generated by sample_ray(), this function
+returns the density of its direction with respect to solid angles,
+conditioned on the origin. Multiplied by pdf_position(), this yields
+the density of the ray itself, which bidirectional techniques need to
+weight the subpaths that start at the endpoint.
+
+The default implementation throws an exception.
+
+Parameter ``ps``:
+    The origin of the ray (only the world space position and normal
+    are used).
+
+Parameter ``d``:
+    The world space direction of the ray.
+
+Returns:
+    The corresponding sampling density, which is zero for directions
+    that sample_ray() never generates.)doc";
+
 static const char *__doc_mitsuba_Endpoint_pdf_wavelengths =
 R"doc(Evaluate the probability density of the wavelength sampling method
 implemented by sample_wavelengths().
@@ -2761,6 +3027,12 @@ function is invoked by the Scene constructor.)doc";
 
 static const char *__doc_mitsuba_Endpoint_set_shape = R"doc(Set the shape associated with this endpoint.)doc";
 
+static const char *__doc_mitsuba_Endpoint_set_world_transform =
+R"doc(Set the local space to world space transformation
+
+This function also notifies the endpoint via parameters_changed()
+so that it can update any data that depends on the transformation.)doc";
+
 static const char *__doc_mitsuba_Endpoint_shape = R"doc(Return the shape, to which the emitter is currently attached)doc";
 
 static const char *__doc_mitsuba_Endpoint_shape_2 =
@@ -2771,6 +3043,102 @@ static const char *__doc_mitsuba_Endpoint_traverse = R"doc(//! @})doc";
 
 static const char *__doc_mitsuba_Endpoint_world_transform = R"doc(Return the local space to world space transformation)doc";
 
+static const char *__doc_mitsuba_FenwickDistribution =
+R"doc(Discrete 1D probability distribution with incremental updates
+
+This data structure represents the same kind of distribution as
+DiscreteDistribution, but stores it as a Fenwick tree (binary indexed
+tree) instead of a cumulative distribution function: the one-based
+node ``i`` holds the sum of the entries ``(i - lsb(i), i]``, where
+``lsb(i)`` is the lowest set bit of ``i``. Changing an entry only
+touches a logarithmic number of nodes, and sampling descends the tree
+using one lookup per level. It is preferable to DiscreteDistribution
+when a few entries of a large distribution change frequently, e.g. the
+sampling weights of the emitters of a scene during an optimization.
+
+The entries are maintained on the host. Changes made using set() only
+take effect after calling update(), which scatters the modified nodes
+into the arrays used for sampling without any synchronization, unless
+a large fraction of them changed (in which case they are uploaded
+again).)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_FenwickDistribution =
+R"doc(Create an uninitialized FenwickDistribution instance)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_FenwickDistribution_2 =
+R"doc(Initialize from a given probability mass function)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_FenwickDistribution_3 =
+R"doc(Initialize from a given floating point array)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_empty = R"doc(Is the distribution object empty/uninitialized?)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_eval_pmf =
+R"doc(Evaluate the unnormalized probability mass function (PMF) at index
+``index``)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_eval_pmf_normalized =
+R"doc(Evaluate the normalized probability mass function (PMF) at index
+``index``)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_normalization =
+R"doc(Return the normalization factor (i.e. the inverse of sum()))doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_pmf = R"doc(Return the unnormalized probability mass function)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_sample =
+R"doc(%Transform a uniformly distributed sample to the stored distribution
+
+Parameter ``value``:
+    A uniformly distributed sample on the interval [0, 1].
+
+Returns:
+    The discrete index associated with the sample)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_sample_reuse =
+R"doc(%Transform a uniformly distributed sample to the stored distribution
+
+The original sample is value adjusted so that it can be reused as a
+uniform variate.
+
+Parameter ``value``:
+    A uniformly distributed sample on the interval [0, 1].
+
+Returns:
+    A tuple consisting of
+
+1. the discrete index associated with the sample, and 2. the re-scaled
+sample value.)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_sample_reuse_pmf =
+R"doc(%Transform a uniformly distributed sample to the stored distribution.
+
+The original sample is value adjusted so that it can be reused as a
+uniform variate.
+
+Parameter ``value``:
+    A uniformly distributed sample on the interval [0, 1].
+
+Returns:
+    A tuple consisting of
+
+1. the discrete index associated with the sample 2. the re-scaled
+sample value 3. the normalized probability value of the sample)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_set =
+R"doc(Change the (unnormalized) value of the entry ``index``
+
+This only updates the host-side tree. Call update() once all entries
+have been set to make the changes visible to the sampling routines.)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_size = R"doc(Return the number of entries)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_sum = R"doc(Return the original sum of PMF entries before normalization)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_tree = R"doc(Return the nodes of the Fenwick tree)doc";
+
+static const char *__doc_mitsuba_FenwickDistribution_update = R"doc(Apply the changes made using set() since the last update)doc";
+
 static const char *__doc_mitsuba_FileResolver =
 R"doc(Simple class for resolving paths on Linux/Windows/Mac OS
 
@@ -2963,8 +3331,32 @@ static const char *__doc_mitsuba_Film_crop_size = R"doc(Return the size of the c
 
 static const char *__doc_mitsuba_Film_develop = R"doc(Return a image buffer object storing the developed image)doc";
 
+static const char *__doc_mitsuba_Film_develop_dirty =
+R"doc(Develop the regions of the film that changed since the last call
+
+This is useful for progressive previews, which can then update only the
+parts of the image that received samples. Returns pairs of offsets
+(relative to the crop window) and developed images. The default
+implementation treats the entire film as changed and returns the output
+of develop().)doc";
+
+static const char *__doc_mitsuba_Film_develop_region =
+R"doc(Develop a rectangular region of the film
+
+The region is specified relative to the crop window and must lie
+within it. The default implementation throws an exception.)doc";
+
 static const char *__doc_mitsuba_Film_flags = R"doc(Flags for all properties combined.)doc";
 
+static const char *__doc_mitsuba_Film_flush_rows =
+R"doc(Notify a streaming film that all samples in the rows above ``y``
+(relative to the crop window) have been added
+
+Rows that cannot receive further contributions (taking the
+reconstruction filter into account) are then developed and written to
+disk. A value of ``y`` that is at least the crop height completes the
+output. The default implementation does nothing.)doc";
+
 static const char *__doc_mitsuba_Film_m_crop_offset = R"doc()doc";
 
 static const char *__doc_mitsuba_Film_m_crop_size = R"doc()doc";
@@ -3022,6 +3414,25 @@ static const char *__doc_mitsuba_Film_put_block =
 R"doc(Merge an image block into the film. This methods should be thread-
 safe.)doc";
 
+static const char *__doc_mitsuba_Film_put_tile =
+R"doc(Merge an image block produced by a tiled rendering loop into the film
+
+The caller guarantees that the interiors of all blocks that are merged
+concurrently don't overlap, and that they all use the same border size
+(see ImageBlock::put_tile()). The film can then accumulate most of the
+block without any synchronization. The default implementation calls
+put_block().)doc";
+
+static const char *__doc_mitsuba_Film_read_storage =
+R"doc(Restore the internal film storage from a binary stream created by
+write_storage(). Must be called after prepare().
+
+When ``accumulate`` is set to ``True``, the stored contents are added
+to the current film storage, e.g. to merge the partial results of a
+render job that was distributed over several processes.
+
+The default implementation throws an exception.)doc";
+
 static const char *__doc_mitsuba_Film_rfilter = R"doc(Return the image reconstruction filter (const version))doc";
 
 static const char *__doc_mitsuba_Film_sample_border =
@@ -3063,12 +3474,33 @@ static const char *__doc_mitsuba_Film_size =
 R"doc(Ignoring the crop window, return the resolution of the underlying
 sensor)doc";
 
+static const char *__doc_mitsuba_Film_streaming =
+R"doc(Does this film write its contents to disk while rendering?
+
+Streaming films only keep a sliding window of rows in memory, and their
+contents cannot be developed as a whole. Integrators must then render
+the image from top to bottom and call flush_rows() as they go.)doc";
+
 static const char *__doc_mitsuba_Film_to_string = R"doc(//! @})doc";
 
 static const char *__doc_mitsuba_Film_traverse = R"doc()doc";
 
 static const char *__doc_mitsuba_Film_write = R"doc(Write the developed contents of the film to a file on disk)doc";
 
+static const char *__doc_mitsuba_Film_write_async =
+R"doc(Equivalent to write(), but encodes and writes the image in the
+background
+
+The film is still developed right away, hence its storage can be
+reused by the next render job, while the file is written via
+Bitmap::write_async(). The default implementation calls write().)doc";
+
+static const char *__doc_mitsuba_Film_write_storage =
+R"doc(Serialize the (undeveloped) internal film storage to a binary stream,
+e.g. to checkpoint a long-running render job.
+
+The default implementation throws an exception.)doc";
+
 static const char *__doc_mitsuba_FilterBoundaryCondition =
 R"doc(When resampling data to a different resolution using
 Resampler::resample(), this enumeration specifies how lookups
@@ -3494,6 +3926,8 @@ static const char *__doc_mitsuba_ImageBlock_m_coalesce = R"doc()doc";
 
 static const char *__doc_mitsuba_ImageBlock_m_compensate = R"doc()doc";
 
+static const char *__doc_mitsuba_ImageBlock_m_memory = R"doc()doc";
+
 static const char *__doc_mitsuba_ImageBlock_m_normalize = R"doc()doc";
 
 static const char *__doc_mitsuba_ImageBlock_m_offset = R"doc()doc";
@@ -3549,6 +3983,23 @@ Parameter ``values``:
 
 static const char *__doc_mitsuba_ImageBlock_put_block = R"doc(Accumulate another image block into this one)doc";
 
+static const char *__doc_mitsuba_ImageBlock_put_tile =
+R"doc(Accumulate another image block into this one, concurrently with other
+calls of this function
+
+The caller must guarantee that the interiors (i.e. the regions without
+the border) of the blocks that are merged at the same time don't
+overlap, and that all of them have the same border size. The pixels
+that only the interior of ``block`` can reach are then accumulated
+without any synchronization. The remaining ones, i.e. those within
+twice the border size of the edges of the interior, are protected by
+the lock of their row.
+
+Parameter ``row_locks``:
+    One mutex per row of this image block (including its border)
+
+This function is only supported in scalar variants.)doc";
+
 static const char *__doc_mitsuba_ImageBlock_read =
 R"doc(Fetch a single sample or a wavefront of samples from the image block.
 
@@ -3564,6 +4015,18 @@ Parameter ``values``:
     the result of the read operation for each channel. In Python, the
     function returns these values as a list.)doc";
 
+static const char *__doc_mitsuba_ImageBlock_read_2 =
+R"doc(Restore the contents of the image block from a binary stream created
+by write().
+
+The size, border, and channel count stored in the stream must match
+the configuration of this image block.
+
+Parameter ``accumulate``:
+    If set to ``True``, the stored values are added to the current
+    contents of the image block instead of replacing them. This is
+    useful to merge the results of separate render jobs.)doc";
+
 static const char *__doc_mitsuba_ImageBlock_rfilter = R"doc(Return the image reconstruction filter underlying the ImageBlock)doc";
 
 static const char *__doc_mitsuba_ImageBlock_set_coalesce = R"doc(Try to coalesce reads/writes in JIT modes?)doc";
@@ -3579,6 +4042,21 @@ This corresponds to the offset from the top-left corner of a larger
 image (e.g. a Film) to the top-left corner of this ImageBlock
 instance.)doc";
 
+static const char *__doc_mitsuba_ImageBlock_set_partial_images =
+R"doc(Accumulate into several partial images in LLVM variants
+
+Particle tracers splat their samples at random positions of the image
+block, which turns into atomic additions that contend across the worker
+threads of the LLVM backend. With ``count > 1``, put() instead maps
+contiguous ranges of the wavefront (and hence, of the work processed by
+a thread) to separate copies of the image tensor, which are summed up
+when the block contents are accessed (e.g. via tensor()).
+
+A count of zero selects one partial image per CPU core. The count is
+reduced so that the partial images occupy at most ``memory_limit``
+bytes. This setting has no effect in other variants and when
+error-compensated accumulation is enabled.)doc";
+
 static const char *__doc_mitsuba_ImageBlock_set_size = R"doc(Set the block size. This potentially destroys the block's content.)doc";
 
 static const char *__doc_mitsuba_ImageBlock_set_warn_invalid = R"doc(Warn when writing invalid (NaN, +/- infinity) sample values?)doc";
@@ -3593,12 +4071,21 @@ static const char *__doc_mitsuba_ImageBlock_tensor_2 = R"doc(Return the underlyi
 
 static const char *__doc_mitsuba_ImageBlock_to_string = R"doc(//! @})doc";
 
+static const char *__doc_mitsuba_ImageBlock_update_memory_usage =
+R"doc(Update the tracked size of the image storage (see MemoryTracker))doc";
+
 static const char *__doc_mitsuba_ImageBlock_warn_invalid = R"doc(Warn when writing invalid (NaN, +/- infinity) sample values?)doc";
 
 static const char *__doc_mitsuba_ImageBlock_warn_negative = R"doc(Warn when writing negative sample values?)doc";
 
 static const char *__doc_mitsuba_ImageBlock_width = R"doc(Return the bitmap's width in pixels)doc";
 
+static const char *__doc_mitsuba_ImageBlock_write =
+R"doc(Serialize the contents of the image block to a binary stream
+
+This includes the error compensation state (if enabled), which makes
+it possible to resume an interrupted accumulation exactly.)doc";
+
 static const char *__doc_mitsuba_Integrator =
 R"doc(Abstract integrator base class, which does not make any assumptions
 with regards to how radiance is computed.
@@ -3631,21 +4118,87 @@ R"doc(For integrators that return one or more arbitrary output variables
 (AOVs), this function specifies a list of associated channel names.
 The default implementation simply returns an empty vector.)doc";
 
+static const char *__doc_mitsuba_Integrator_budget_exhausted =
+R"doc(Indicates whether the time budget specified via m_timeout has been
+used up. In progressive mode, the timeout is only enforced between
+blocks and passes (see should_stop()).)doc";
+
 static const char *__doc_mitsuba_Integrator_cancel = R"doc(Cancel a running render job (e.g. after receiving Ctrl-C))doc";
 
+static const char *__doc_mitsuba_Integrator_capture_begin =
+R"doc(Start recording the rays of a render job (if a RayCapture is in
+progress))doc";
+
+static const char *__doc_mitsuba_Integrator_capture_end =
+R"doc(Stop recording the rays of a render job and append them to the capture
+file)doc";
+
 static const char *__doc_mitsuba_Integrator_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Integrator_m_checkpoint_interval = R"doc(Time between checkpoints in seconds)doc";
+
+static const char *__doc_mitsuba_Integrator_m_checkpoint_path = R"doc(Checkpoint filename (see set_checkpoint()))doc";
+
+static const char *__doc_mitsuba_Integrator_m_collect_stats =
+R"doc(Are the statistics of the current render job being collected?)doc";
+
 static const char *__doc_mitsuba_Integrator_m_hide_emitters = R"doc(Flag for disabling direct visibility of emitters)doc";
 
+static const char *__doc_mitsuba_Integrator_m_partition_count = R"doc(Total number of partitions)doc";
+
+static const char *__doc_mitsuba_Integrator_m_partition_index = R"doc(Partition to render (see set_partition()))doc";
+
+static const char *__doc_mitsuba_Integrator_m_passes_completed =
+R"doc(Number of passes completed so far (see passes_completed()))doc";
+
+static const char *__doc_mitsuba_Integrator_m_progressive =
+R"doc(Render in open-ended progressive mode
+
+When set, the integrator keeps rendering passes until the timeout
+expires, the noise estimate drops below m_target_error, or cancel()
+is called. The film remains normalized after every pass.)doc";
+
+static const char *__doc_mitsuba_Integrator_m_render_stats =
+R"doc(Statistics of the last render job (see render_statistics()))doc";
+
 static const char *__doc_mitsuba_Integrator_m_render_timer = R"doc(Timer used to enforce the timeout.)doc";
 
+static const char *__doc_mitsuba_Integrator_m_resume = R"doc(Continue from an existing checkpoint?)doc";
+
+static const char *__doc_mitsuba_Integrator_m_stats_counters =
+R"doc(Counters and maximum path length of the render job in JIT variants)doc";
+
+static const char *__doc_mitsuba_Integrator_m_stats_max_length = R"doc()doc";
+
 static const char *__doc_mitsuba_Integrator_m_stop = R"doc(Integrators should stop all work when this flag is set to true.)doc";
 
+static const char *__doc_mitsuba_Integrator_m_target_error =
+R"doc(Target relative error at which progressive rendering stops (0:
+disabled))doc";
+
 static const char *__doc_mitsuba_Integrator_m_timeout =
 R"doc(Maximum amount of time to spend rendering (excluding scene parsing).
 
 Specified in seconds. A negative values indicates no timeout.)doc";
 
+static const char *__doc_mitsuba_Integrator_passes_completed =
+R"doc(Return the number of passes that have been fully accumulated into the
+film during the current (or last) render job.
+
+This function may be called from another thread to poll the progress
+of a progressive render job, in which case the film can be developed
+once the returned count increases.)doc";
+
+static const char *__doc_mitsuba_Integrator_record_event = R"doc(Count an event for every active lane (see RenderStatistics))doc";
+
+static const char *__doc_mitsuba_Integrator_record_event_impl = R"doc()doc";
+
+static const char *__doc_mitsuba_Integrator_record_path = R"doc(Record the termination of the paths of the active lanes)doc";
+
+static const char *__doc_mitsuba_Integrator_record_path_impl = R"doc()doc";
+
+static const char *__doc_mitsuba_Integrator_record_ray = R"doc(Record the rays of the active lanes (see RayCapture))doc";
+
 static const char *__doc_mitsuba_Integrator_render =
 R"doc(Render the scene
 
@@ -3828,13 +4381,70 @@ This function is just a thin wrapper around the previous
 render_forward() function. It accepts a sensor *index* instead and
 renders the scene using sensor 0 by default.)doc";
 
+static const char *__doc_mitsuba_Integrator_render_statistics =
+R"doc(Return the statistics of the last render job
+
+They are only collected while RenderStatistics::enabled() is set, and
+not when a JIT variant renders without evaluating the image.)doc";
+
+static const char *__doc_mitsuba_Integrator_set_checkpoint =
+R"doc(Periodically checkpoint the state of subsequent render jobs
+
+When a checkpoint path is specified, the integrator regularly writes
+the accumulated film storage along with the set of completed work
+units (blocks in scalar variants, passes in JIT variants) to ``path``.
+A final checkpoint is also written when the render job is interrupted.
+The file is removed once the render job finishes.
+
+Parameter ``path``:
+    Checkpoint filename. An empty path disables checkpointing.
+
+Parameter ``interval``:
+    Time between checkpoints in seconds. If non-positive, a checkpoint
+    is only written when the render job is interrupted.
+
+Parameter ``resume``:
+    If set to ``True`` and the checkpoint file exists, the next render
+    job continues from it instead of starting from scratch. The render
+    job must have the same configuration as the interrupted one.)doc";
+
+static const char *__doc_mitsuba_Integrator_set_partition =
+R"doc(Restrict subsequent render jobs to a subset of the work
+
+This makes it possible to distribute a single render job over several
+processes or machines: each process renders partition ``index`` out of
+``count``, stores the raw film contents via Film::write_storage(), and
+the partial results are then accumulated using Film::read_storage().
+
+Scalar variants interleave the image blocks between partitions, and
+the merged result is identical to that of a render job that is not
+partitioned. JIT variants interleave the sample passes instead (see
+``samples_per_pass``), each of which is seeded separately.
+
+Parameter ``index``:
+    Index of the partition that should be rendered.
+
+Parameter ``count``:
+    Total number of partitions. A value of 1 disables partitioning.)doc";
+
 static const char *__doc_mitsuba_Integrator_should_stop =
 R"doc(Indicates whether cancel() or a timeout have occurred. Should be
 checked regularly in the integrator's main loop so that timeouts are
 enforced accurately.
 
 Note that accurate timeouts rely on m_render_timer, which needs to be
-reset at the beginning of the rendering phase.)doc";
+reset at the beginning of the rendering phase.
+
+In progressive mode, this function only reports cancellation. Timeouts
+should then be checked via budget_exhausted() at a granularity that
+preserves the normalization of the film.)doc";
+
+static const char *__doc_mitsuba_Integrator_statistics_begin =
+R"doc(Start collecting the statistics of a render job (if enabled))doc";
+
+static const char *__doc_mitsuba_Integrator_statistics_end =
+R"doc(Stop collecting the statistics of a render job and store them in
+m_render_stats, logging a summary when ``log`` is set)doc";
 
 static const char *__doc_mitsuba_Interaction = R"doc(Generic surface interaction data structure)doc";
 
@@ -4022,7 +4632,7 @@ static const char *__doc_mitsuba_Jit_Jit = R"doc()doc";
 
 static const char *__doc_mitsuba_Jit_Jit_2 = R"doc()doc";
 
-static const char *__doc_mitsuba_Jit_get_instance = R"doc()doc";
+static const char *__doc_mitsuba_Jit_get_instance = R"doc(Return the JIT runtime, creating it if necessary)doc";
 
 static const char *__doc_mitsuba_Jit_mutex = R"doc()doc";
 
@@ -4031,12 +4641,102 @@ static const char *__doc_mitsuba_Jit_runtime = R"doc()doc";
 static const char *__doc_mitsuba_Jit_static_initialization =
 R"doc(Statically initialize the JIT runtime
 
-This function also does a runtime-check to ensure that the host
-processor supports all instruction sets which were selected at compile
-time. If not, the application is terminated via ``abort()``.)doc";
+The runtime itself is only created by the first call to get_instance(),
+hence applications that never JIT-compile a routine don't pay for its
+construction.)doc";
 
 static const char *__doc_mitsuba_Jit_static_shutdown = R"doc(Release all memory used by JIT-compiled routines)doc";
 
+static const char *__doc_mitsuba_KernelStatistics =
+R"doc(Statistics of the JIT kernels launched while a ScopedKernelStatistics
+was active
+
+The values are collected from the kernel history of Dr.Jit, which
+records every kernel launch when kernel profiling is enabled (see
+Profiler::set_kernel_profiling()). All times are in milliseconds.)doc";
+
+static const char *__doc_mitsuba_KernelStatistics_backend_time =
+R"doc(Time spent compiling the IR with the backend (NVRTC/PTX or LLVM))doc";
+
+static const char *__doc_mitsuba_KernelStatistics_cache_hit_rate =
+R"doc(Fraction of the launches that didn't need to compile their kernel)doc";
+
+static const char *__doc_mitsuba_KernelStatistics_cache_hits =
+R"doc(Number of launches of kernels that didn't need to be compiled)doc";
+
+static const char *__doc_mitsuba_KernelStatistics_codegen_time = R"doc(Time spent generating the kernel IR)doc";
+
+static const char *__doc_mitsuba_KernelStatistics_disk_cache_hits =
+R"doc(Number of cache hits that were loaded from the on-disk kernel cache)doc";
+
+static const char *__doc_mitsuba_KernelStatistics_execution_time = R"doc(Time spent executing the kernels)doc";
+
+static const char *__doc_mitsuba_KernelStatistics_kernel_count =
+R"doc(Number of kernel launches (including reductions and other operations))doc";
+
+static const char *__doc_mitsuba_KernelStatistics_operator_iadd = R"doc(Accumulate the statistics of another interval)doc";
+
+static const char *__doc_mitsuba_KernelStatistics_peak_memory =
+R"doc(High-water mark of the tracked memory of the backend in bytes)doc";
+
+static const char *__doc_mitsuba_KernelStatistics_to_string = R"doc(Return a one-line human-readable summary)doc";
+
+static const char *__doc_mitsuba_LightBVH =
+R"doc(Bounding volume hierarchy over the emitters of a scene for many-light
+importance sampling
+
+Every node stores conservative bounds of the emitters below it: an
+axis aligned bounding box, a cone bounding the surface normals (θo)
+together with the spread of emission around them (θe), and the total
+power. When sampling an emitter for a reference point, the hierarchy
+is traversed from the root, and at every inner node a child is chosen
+proportionally to a conservative estimate of its contribution
+("importance") at that point. This follows the light BVH from PBRT-v4
+(itself based on "Importance Sampling of Many Lights with Adaptive
+Tree Splitting" by Conty Estevez and Kulla), with one emitter per
+leaf.
+
+Since leaves are entire emitters, the hierarchy pays off in scenes
+with many small emitters, such as point and spot lights or emissive
+shapes that are small compared to their distance to the receivers. An
+area emitter attached to a mesh is bounded as a whole: the triangles
+of a large or curved emissive mesh are not distinguished, and within
+the chosen emitter, points are still sampled proportionally to their
+area. PBRT-v4 instead creates one leaf per emissive triangle, which is
+not supported here.
+
+The emitter's ``sampling_weight`` serves as its power. Emitters
+without a finite position (environment maps, directional emitters)
+cannot be bounded and are chosen uniformly with a probability
+proportional to their count (where the entire hierarchy counts as
+one). Emitters with a zero sampling weight are never chosen.
+
+The hierarchy is stored in flat arrays, so that the same traversal
+code runs in scalar, vectorized and JIT-compiled variants.)doc";
+
+static const char *__doc_mitsuba_LightBVH_LightBVH = R"doc(Build the hierarchy over the given list of emitters)doc";
+
+static const char *__doc_mitsuba_LightBVH_infinite_count =
+R"doc(Return the number of emitters that are sampled outside of the hierarchy)doc";
+
+static const char *__doc_mitsuba_LightBVH_node_count = R"doc(Return the number of nodes of the hierarchy)doc";
+
+static const char *__doc_mitsuba_LightBVH_pdf =
+R"doc(Evaluate the probability of choosing the emitter with index ``index``
+at the reference point ``ref`` with sample().)doc";
+
+static const char *__doc_mitsuba_LightBVH_sample =
+R"doc(Sample an emitter proportionally to its estimated contribution at the
+reference point ``ref``
+
+Returns:
+    A tuple containing the index of the chosen emitter, its sampling
+    weight (i.e. the inverse of its selection probability, or zero if
+    no emitter could be chosen), and the transformed random sample for
+    reuse.)doc";
+
+static const char *__doc_mitsuba_LightBVH_to_string = R"doc(Return a human-readable string representation of the hierarchy)doc";
+
 static const char *__doc_mitsuba_LogLevel = R"doc(Available Log message types)doc";
 
 static const char *__doc_mitsuba_LogLevel_Debug = R"doc(Trace message, for extremely verbose debugging)doc";
@@ -4068,6 +4768,8 @@ static const char *__doc_mitsuba_Logger_appender_2 = R"doc(Return one of the app
 
 static const char *__doc_mitsuba_Logger_appender_count = R"doc(Return the number of registered appenders)doc";
 
+static const char *__doc_mitsuba_Logger_asynchronous = R"doc(Is asynchronous logging enabled?)doc";
+
 static const char *__doc_mitsuba_Logger_class = R"doc()doc";
 
 static const char *__doc_mitsuba_Logger_clear_appenders = R"doc(Remove all appenders from this logger)doc";
@@ -4076,6 +4778,8 @@ static const char *__doc_mitsuba_Logger_d = R"doc()doc";
 
 static const char *__doc_mitsuba_Logger_error_level = R"doc(Return the current error level)doc";
 
+static const char *__doc_mitsuba_Logger_flush = R"doc(Pass all pending messages of the asynchronous mode to the appenders)doc";
+
 static const char *__doc_mitsuba_Logger_formatter = R"doc(Return the logger's formatter implementation)doc";
 
 static const char *__doc_mitsuba_Logger_formatter_2 = R"doc(Return the logger's formatter implementation (const))doc";
@@ -4132,6 +4836,16 @@ Throws a runtime exception upon failure)doc";
 
 static const char *__doc_mitsuba_Logger_remove_appender = R"doc(Remove an appender from this logger)doc";
 
+static const char *__doc_mitsuba_Logger_set_asynchronous =
+R"doc(Enable or disable asynchronous logging
+
+In asynchronous mode, log() only enqueues messages using a lock-free
+list, and a background thread formats them and passes them to the
+appenders. This prevents verbose logging from serializing worker
+threads. Pending messages are flushed before progress messages, before
+exceptions are thrown, at the end of a render job, and when
+asynchronous mode is disabled.)doc";
+
 static const char *__doc_mitsuba_Logger_set_error_level =
 R"doc(Set the error log level (this level and anything above will throw
 exceptions).
@@ -4248,6 +4962,10 @@ static const char *__doc_mitsuba_Marginal2D_to_string = R"doc()doc";
 
 static const char *__doc_mitsuba_Medium = R"doc()doc";
 
+static const char *__doc_mitsuba_MediumInteraction_depth =
+R"doc(Number of scattering events on the path before this interaction. Media
+may use it to look up coarser levels of detail on secondary paths.)doc";
+
 static const char *__doc_mitsuba_Medium_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Medium_3 = R"doc()doc";
@@ -4316,7 +5034,16 @@ static const char *__doc_mitsuba_Medium_Medium_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Medium_class = R"doc()doc";
 
-static const char *__doc_mitsuba_Medium_get_majorant = R"doc(Returns the medium's majorant used for delta tracking)doc";
+static const char *__doc_mitsuba_Medium_get_control_extinction =
+R"doc(Returns the extinction of the medium's control component
+
+Decomposition tracking splits the extinction into a control component,
+whose free-flight distances are sampled analytically, and a residual
+that is tracked with null collisions. The control extinction should be
+constant over the medium and not exceed Sigma_t anywhere. The default
+implementation returns zero, i.e. the medium has no control component.)doc";
+
+static const char *__doc_mitsuba_Medium_get_majorant = R"doc(Returns the medium's majorant used for delta tracking)doc";
 
 static const char *__doc_mitsuba_Medium_get_scattering_coefficients =
 R"doc(Returns the medium coefficients Sigma_s, Sigma_n and Sigma_t evaluated
@@ -4350,6 +5077,21 @@ static const char *__doc_mitsuba_Medium_operator_new_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Medium_phase_function = R"doc(Return the phase function of this medium)doc";
 
+static const char *__doc_mitsuba_Medium_sample_distance =
+R"doc(Sample a tentative free-flight distance along a ray segment
+
+This function is used by sample_interaction() once the ray has been
+clipped to the segment ``[mint, maxt]`` within the medium's bounding
+box. The default implementation samples an exponential distribution
+with the constant majorant returned by get_majorant(), reduced by
+``majorant_offset`` (clamped to zero). Media with spatially varying
+majorants can override it.
+
+Returns:
+    A pair containing the sampled distance along the ray (larger than
+    ``maxt`` if no interaction occurs within the segment) and the
+    majorant at that distance.)doc";
+
 static const char *__doc_mitsuba_Medium_sample_interaction =
 R"doc(Sample a free-flight distance in the medium.
 
@@ -4368,6 +5110,15 @@ Parameter ``channel``:
     The channel according to which we will sample the free-flight
     distance. This argument is only used when rendering in RGB modes.
 
+Parameter ``majorant_offset``:
+    Value subtracted from the majorant, e.g. to sample the residual
+    of decomposition tracking (see get_control_extinction()). The
+    reduced majorant is returned in ``combined_extinction``.
+
+Parameter ``depth``:
+    Number of scattering events on the path so far, which is stored
+    in the returned interaction (see MediumInteraction::depth).
+
 Returns:
     This method returns a MediumInteraction. The MediumInteraction
     will always be valid, except if the ray missed the Medium's
@@ -4396,6 +5147,47 @@ static const char *__doc_mitsuba_Medium_traverse = R"doc()doc";
 
 static const char *__doc_mitsuba_Medium_use_emitter_sampling = R"doc(Returns whether this specific medium instance uses emitter sampling)doc";
 
+static const char *__doc_mitsuba_MemoryAllocation =
+R"doc(Memory held by an object and accounted for by the MemoryTracker
+
+The tracked size is updated via set() whenever the storage of the
+owning object is (re)allocated, and released when the object is destroyed.
+Copies account for the same amount of memory once more.)doc";
+
+static const char *__doc_mitsuba_MemoryAllocation_MemoryAllocation = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryAllocation_MemoryAllocation_2 = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryAllocation_m_category = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryAllocation_m_device = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryAllocation_m_size = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryAllocation_operator_assign = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryAllocation_set = R"doc(Update the amount of memory and its location)doc";
+
+static const char *__doc_mitsuba_MemoryAllocation_size = R"doc(Return the tracked amount of memory in bytes)doc";
+
+static const char *__doc_mitsuba_MemoryCategory = R"doc(Subsystems whose memory usage is tracked by the MemoryTracker)doc";
+
+static const char *__doc_mitsuba_MemoryCategory_Bitmap = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_Embree = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_ImageBlock = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_KDTree = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_MemoryCategoryCount = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_Mesh = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_OptiX = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_VolumeGrid = R"doc()doc";
+
 static const char *__doc_mitsuba_MemoryMappedFile =
 R"doc(Basic cross-platform abstraction for memory mapped files
 
@@ -4433,6 +5225,16 @@ static const char *__doc_mitsuba_MemoryMappedFile_data_2 = R"doc(Return a pointe
 
 static const char *__doc_mitsuba_MemoryMappedFile_filename = R"doc(Return the associated filename)doc";
 
+static const char *__doc_mitsuba_MemoryMappedFile_is_copy_on_write =
+R"doc(Return whether modifications of the mapped memory region are private)doc";
+
+static const char *__doc_mitsuba_MemoryMappedFile_map_copy_on_write =
+R"doc(Map an existing file into memory using copy-on-write semantics
+
+The mapped region can be modified, but modifications remain private to
+the process and are never written back to the file. Pages are only
+copied once they are written to. Such mappings cannot be resized.)doc";
+
 static const char *__doc_mitsuba_MemoryMappedFile_resize =
 R"doc(Resize the memory-mapped file
 
@@ -4535,6 +5337,42 @@ static const char *__doc_mitsuba_MemoryStream_write =
 R"doc(Writes a specified amount of data into the memory buffer. The capacity
 of the memory buffer is extended if necessary.)doc";
 
+static const char *__doc_mitsuba_MemoryTracker =
+R"doc(Accounts for the memory held by the main subsystems of Mitsuba
+
+Allocations are tagged with a MemoryCategory and with the location of
+the memory (host or GPU). The tracker maintains the current usage and the
+high-water mark of every category, which helps to find out which parts of
+a scene are responsible for its memory footprint. The peak resident memory
+of the process is reported alongside, since it additionally includes all
+untracked allocations, e.g. the state of JIT-compiled wavefronts.
+
+Subsystems normally don't call allocate() and release()
+directly, but hold a MemoryAllocation whose size they update.)doc";
+
+static const char *__doc_mitsuba_MemoryTracker_allocate = R"doc(Record an allocation of ``size`` bytes)doc";
+
+static const char *__doc_mitsuba_MemoryTracker_peak_rss = R"doc(Return the peak resident memory of the process in bytes)doc";
+
+static const char *__doc_mitsuba_MemoryTracker_peak_total_usage =
+R"doc(Return the high-water mark of the tracked host (or GPU) memory)doc";
+
+static const char *__doc_mitsuba_MemoryTracker_peak_usage = R"doc(Return the high-water mark of a category in bytes)doc";
+
+static const char *__doc_mitsuba_MemoryTracker_release = R"doc(Record that ``size`` bytes were released)doc";
+
+static const char *__doc_mitsuba_MemoryTracker_report = R"doc(Return a human-readable report of the tracked memory usage)doc";
+
+static const char *__doc_mitsuba_MemoryTracker_reset_peak_usage = R"doc(Reset the high-water marks to the current usage)doc";
+
+static const char *__doc_mitsuba_MemoryTracker_summary =
+R"doc(Return a one-line summary, which is e.g. logged after loading a scene)doc";
+
+static const char *__doc_mitsuba_MemoryTracker_total_usage =
+R"doc(Return the number of tracked bytes held in host (or GPU) memory)doc";
+
+static const char *__doc_mitsuba_MemoryTracker_usage = R"doc(Return the number of bytes currently held by a category)doc";
+
 static const char *__doc_mitsuba_Mesh = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_2 = R"doc()doc";
@@ -4571,6 +5409,8 @@ static const char *__doc_mitsuba_Mesh_add_attribute = R"doc(Add an attribute buf
 
 static const char *__doc_mitsuba_Mesh_attribute_buffer = R"doc(Return the mesh attribute associated with ``name``)doc";
 
+static const char *__doc_mitsuba_Mesh_attribute_slot = R"doc(Return the attribute associated with a handle, or ``nullptr``)doc";
+
 static const char *__doc_mitsuba_Mesh_barycentric_coordinates = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_bbox = R"doc(//! @{ \name Shape interface implementation)doc";
@@ -4596,6 +5436,14 @@ Internally, this method relies on the directed edge data structure. A
 call to build_directed_edges before a call to this method is therefore
 necessary.)doc";
 
+static const char *__doc_mitsuba_Mesh_build_interleaved_attributes =
+R"doc(Interleave the vertex attributes into a single buffer
+
+In scalar variants, a mesh with several vertex attributes stores a copy
+of them with one record per vertex, so that evaluating them at the
+same shading point touches the same cache lines. Attribute arrays
+otherwise stay separate (which is what vectorized gathers want).)doc";
+
 static const char *__doc_mitsuba_Mesh_build_parameterization =
 R"doc(Initialize the ``m_parameterization`` field for mapping UV coordinates
 to positions
@@ -4611,12 +5459,28 @@ since it uses a mutex.)doc";
 
 static const char *__doc_mitsuba_Mesh_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_compact_vertex_data =
+R"doc(Convert vertex normals and texture coordinates to the compact vertex
+layout
+
+Normals are stored in a 32 bit octahedral encoding, and texture
+coordinates are quantized to 16 bits per component relative to their
+bounding box. The full precision buffers are released afterwards.)doc";
+
 static const char *__doc_mitsuba_Mesh_compute_surface_interaction = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_decode_normal = R"doc(Decode a normal stored in the 32 bit octahedral encoding)doc";
+
+static const char *__doc_mitsuba_Mesh_decode_texcoord = R"doc(Decode a texture coordinate quantized to 16 bits per component)doc";
+
 static const char *__doc_mitsuba_Mesh_differential_motion = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_embree_geometry = R"doc(Return the Embree version of this shape)doc";
 
+static const char *__doc_mitsuba_Mesh_embree_update_geometry =
+R"doc(Update the vertex buffer of an Embree geometry previously created by
+embree_geometry() after a topology-preserving change)doc";
+
 static const char *__doc_mitsuba_Mesh_ensure_pmf_built = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_eval_attribute = R"doc()doc";
@@ -4641,10 +5505,18 @@ static const char *__doc_mitsuba_Mesh_faces_buffer = R"doc(Return face indices b
 
 static const char *__doc_mitsuba_Mesh_faces_buffer_2 = R"doc(Const variant of faces_buffer.)doc";
 
+static const char *__doc_mitsuba_Mesh_flip_normals = R"doc(Are the normals of this mesh flipped?)doc";
+
 static const char *__doc_mitsuba_Mesh_has_attribute = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_has_compact_vertices =
+R"doc(Are vertex normals and texture coordinates stored in compact form?)doc";
+
 static const char *__doc_mitsuba_Mesh_has_face_normals = R"doc(Does this mesh use face normals?)doc";
 
+static const char *__doc_mitsuba_Mesh_has_interleaved_vertices =
+R"doc(Are the vertices also stored in the interleaved layout?)doc";
+
 static const char *__doc_mitsuba_Mesh_has_mesh_attributes = R"doc(Does this mesh have additional mesh attributes?)doc";
 
 static const char *__doc_mitsuba_Mesh_has_vertex_normals = R"doc(Does this mesh have per-vertex normals?)doc";
@@ -4653,6 +5525,18 @@ static const char *__doc_mitsuba_Mesh_has_vertex_texcoords = R"doc(Does this mes
 
 static const char *__doc_mitsuba_Mesh_initialize = R"doc(Must be called at the end of the constructor of Mesh plugins)doc";
 
+static const char *__doc_mitsuba_Mesh_interleave_vertex_data =
+R"doc(Build the interleaved vertex layout
+
+In scalar variants, this stores a copy of the position, normal and
+texture coordinates of every vertex in a single record, which the
+triangle intersection routine and compute_surface_interaction()
+then read instead of the separate buffers. A hit thereby touches one
+or two cache lines per vertex instead of up to three. JIT variants keep
+the separate buffers, whose layout suits vectorized gathers.)doc";
+
+static const char *__doc_mitsuba_Mesh_interleaved_vertex = R"doc(Return a pointer to the interleaved record of a vertex)doc";
+
 static const char *__doc_mitsuba_Mesh_interpolate_attribute = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_invert_silhouette_sample = R"doc()doc";
@@ -4665,6 +5549,9 @@ static const char *__doc_mitsuba_Mesh_m_area_pmf = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_m_bbox = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_m_compact_vertices =
+R"doc(Store normals and texture coordinates compactly, see compact_vertex_data())doc";
+
 static const char *__doc_mitsuba_Mesh_m_face_count = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_m_face_normals =
@@ -4675,6 +5562,8 @@ static const char *__doc_mitsuba_Mesh_m_faces = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_m_flip_normals = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_m_memory = R"doc(Memory held by the vertex, face and attribute buffers)doc";
+
 static const char *__doc_mitsuba_Mesh_m_mesh_attributes = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_m_mutex = R"doc()doc";
@@ -4689,12 +5578,18 @@ static const char *__doc_mitsuba_Mesh_m_sil_dedge_pmf =
 R"doc(Sampling density of silhouette
 (build_indirect_silhouette_distribution))doc";
 
+static const char *__doc_mitsuba_Mesh_m_solid_angle_sampling =
+R"doc(Sample directions towards the mesh by solid angle, see
+sample_direction())doc";
+
 static const char *__doc_mitsuba_Mesh_m_vertex_buffer_ptr = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_m_vertex_count = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_m_vertex_normals = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_m_vertex_normals_compact = R"doc(Compact vertex layout (see compact_vertex_data()))doc";
+
 static const char *__doc_mitsuba_Mesh_m_vertex_positions = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_m_vertex_texcoords = R"doc()doc";
@@ -4738,8 +5633,16 @@ static const char *__doc_mitsuba_Mesh_parameters_changed = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_parameters_grad_enabled = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_pdf_direction = R"doc(Query the probability density of sample_direction())doc";
+
 static const char *__doc_mitsuba_Mesh_pdf_position = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_position_sample =
+R"doc(Create a position sample on the triangle with vertex indices ``fi``
+at the barycentric coordinates ``b``
+
+The ``pdf`` field is set to the area density of sample_position().)doc";
+
 static const char *__doc_mitsuba_Mesh_precompute_silhouette = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_primitive_count = R"doc()doc";
@@ -4779,6 +5682,17 @@ static const char *__doc_mitsuba_Mesh_recompute_bbox = R"doc(Recompute the bound
 
 static const char *__doc_mitsuba_Mesh_recompute_vertex_normals = R"doc(Compute smooth vertex normals and replace the current normal values)doc";
 
+static const char *__doc_mitsuba_Mesh_sample_direction =
+R"doc(Sample a direction towards the mesh
+
+When the mesh was created with the ``solid_angle_sampling`` parameter
+set to ``True``, a triangle is chosen proportionally to its area,
+after which the spherical triangle it subtends at the reference point
+is sampled uniformly. Triangles whose solid angle is too small or too
+large for this method to be numerically robust are sampled by area.
+Otherwise, this function falls back to the area sampling technique
+implemented by Shape.)doc";
+
 static const char *__doc_mitsuba_Mesh_sample_position = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_sample_precomputed_silhouette = R"doc()doc";
@@ -4787,12 +5701,20 @@ static const char *__doc_mitsuba_Mesh_sample_silhouette = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_set_scene = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_spherical_triangle_pdf =
+R"doc(Determine whether the spherical triangle subtended by the given
+triangle at ``p`` can be sampled robustly, and return its density
+with respect to solid angles.)doc";
+
 static const char *__doc_mitsuba_Mesh_surface_area = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_to_string = R"doc(Return a human-readable string representation of the shape contents.)doc";
 
 static const char *__doc_mitsuba_Mesh_traverse = R"doc(@})doc";
 
+static const char *__doc_mitsuba_Mesh_update_memory_usage =
+R"doc(Update the tracked size of the mesh buffers (see MemoryTracker))doc";
+
 static const char *__doc_mitsuba_Mesh_vertex_count = R"doc(Return the total number of vertices)doc";
 
 static const char *__doc_mitsuba_Mesh_vertex_data_bytes = R"doc()doc";
@@ -4803,6 +5725,12 @@ static const char *__doc_mitsuba_Mesh_vertex_normals_buffer = R"doc(Return verte
 
 static const char *__doc_mitsuba_Mesh_vertex_normals_buffer_2 = R"doc(Const variant of vertex_normals_buffer.)doc";
 
+static const char *__doc_mitsuba_Mesh_vertex_normals_data =
+R"doc(Return the vertex normals as a flat buffer
+
+Unlike vertex_normals_buffer(), this function also supports meshes
+with a compact vertex layout, whose normals are decoded.)doc";
+
 static const char *__doc_mitsuba_Mesh_vertex_position = R"doc(Returns the world-space position of the vertex with index ``index``)doc";
 
 static const char *__doc_mitsuba_Mesh_vertex_positions_buffer = R"doc(Return vertex positions buffer)doc";
@@ -4815,6 +5743,8 @@ static const char *__doc_mitsuba_Mesh_vertex_texcoords_buffer = R"doc(Return ver
 
 static const char *__doc_mitsuba_Mesh_vertex_texcoords_buffer_2 = R"doc(Const variant of vertex_texcoords_buffer.)doc";
 
+static const char *__doc_mitsuba_Mesh_vertex_texcoords_data = R"doc(Texture coordinate variant of vertex_normals_data())doc";
+
 static const char *__doc_mitsuba_Mesh_write_ply =
 R"doc(Write the mesh to a binary PLY file
 
@@ -5042,6 +5972,109 @@ static const char *__doc_mitsuba_Normal_operator_assign = R"doc()doc";
 
 static const char *__doc_mitsuba_Normal_operator_assign_2 = R"doc()doc";
 
+static const char *__doc_mitsuba_OIDNDenoiser =
+R"doc(Wrapper for the Intel Open Image Denoise (OIDN) CPU denoiser
+
+This object provides the interface of OptixDenoiser on the CPU, and
+can therefore be used with all variants. The inputs of JIT variants
+are migrated to host memory before denoising.
+
+The denoiser uses as many threads as Mitsuba's thread pool. Like the
+OptiX denoiser, it works best with noisy renderings that were produced
+with a Film which used the `box` ReconstructionFilter.)doc";
+
+static const char *__doc_mitsuba_OIDNDenoiser_OIDNDenoiser =
+R"doc(Constructs an OIDN denoiser
+
+Parameter ``input_size``:
+    Resolution of noisy images that will be fed to the denoiser.
+
+Parameter ``albedo``:
+    Whether or not albedo information will also be given to the
+    denoiser.
+
+Parameter ``normals``:
+    Whether or not shading normals information will also be given to
+    the Denoiser.
+
+Parameter ``prefilter``:
+    Whether the albedo and normals should be denoised before they
+    guide the denoising of the noisy input. This improves the quality
+    when the guides are noisy themselves, e.g. due to depth of field
+    or motion blur.
+
+Returns:
+    A callable object which will apply the OIDN denoiser.)doc";
+
+static const char *__doc_mitsuba_OIDNDenoiser_operator_call =
+R"doc(Apply denoiser on inputs which are TensorXf objects.
+
+The noisy input is copied into the output, which is then denoised in
+place.
+
+Parameter ``noisy``:
+    The noisy input. (tensor shape: (width, height, 3 | 4))
+
+Parameter ``denoise_alpha``:
+    Whether or not the alpha channel (if specified in the noisy input)
+    should be denoised too. Otherwise, it is copied to the output.
+    This parameter is optional, by default it is true.
+
+Parameter ``albedo``:
+    Albedo information of the noisy rendering. This parameter is
+    optional unless the OIDNDenoiser was built with albedo support.
+    (tensor shape: (width, height, 3))
+
+Parameter ``normals``:
+    Shading normal information of the noisy rendering. This parameter
+    is optional unless the OIDNDenoiser was built with normals
+    support. (tensor shape: (width, height, 3))
+
+Parameter ``to_sensor``:
+    A Transform4f which is applied to the ``normals`` parameter before
+    denoising. OIDN accepts normals in any coordinate frame, as long
+    as it is the same for all pixels. This parameter is optional, by
+    default no transformation is applied.
+
+Returns:
+    The denoised input.)doc";
+
+static const char *__doc_mitsuba_OIDNDenoiser_operator_call_2 =
+R"doc(Apply denoiser on inputs which are Bitmap objects.
+
+Parameter ``noisy``:
+    The noisy input. When passing additional information like albedo
+    or normals to the denoiser, this Bitmap object must be a
+    MultiChannel bitmap, such as the output of the `aov` integrator.
+
+Parameter ``denoise_alpha``:
+    Whether or not the alpha channel (if specified in the noisy input)
+    should be denoised too. This parameter is optional, by default it
+    is true.
+
+Parameter ``albedo_ch``:
+    The name of the channel in the ``noisy`` parameter which contains
+    the albedo information of the noisy rendering. This parameter is
+    optional unless the OIDNDenoiser was built with albedo support.
+
+Parameter ``normals_ch``:
+    The name of the channel in the ``noisy`` parameter which contains
+    the shading normal information of the noisy rendering. This
+    parameter is optional unless the OIDNDenoiser was built with
+    normals support.
+
+Parameter ``to_sensor``:
+    A Transform4f which is applied to the ``normals`` parameter before
+    denoising. This parameter is optional, by default no
+    transformation is applied.
+
+Parameter ``noisy_ch``:
+    The name of the channel in the ``noisy`` parameter which contains
+    the noisy rendering.
+
+Returns:
+    The denoised input.)doc";
+
 static const char *__doc_mitsuba_Object =
 R"doc(Object base class with builtin reference counting
 
@@ -5120,6 +6153,17 @@ See also:
 
 static const char *__doc_mitsuba_Object_ref_count = R"doc(Return the current reference count)doc";
 
+static const char *__doc_mitsuba_Object_replace_object =
+R"doc(Replace a child object that was passed to the constructor
+
+This is used by the reload mode of the XML scene loader (see
+xml::load_file()), which swaps the changed children of an otherwise
+unchanged object instead of instantiating it again. Returns ``True``
+when ``old_child`` was replaced by ``new_child``.
+
+Remark:
+    The default implementation does nothing and returns ``False``.)doc";
+
 static const char *__doc_mitsuba_Object_set_id = R"doc(Set an identifier to the current instance (if applicable))doc";
 
 static const char *__doc_mitsuba_Object_to_string =
@@ -5162,6 +6206,8 @@ static const char *__doc_mitsuba_OptixAccelData_linear_curves = R"doc()doc";
 
 static const char *__doc_mitsuba_OptixAccelData_meshes = R"doc()doc";
 
+static const char *__doc_mitsuba_OptixAccelData_spheres = R"doc()doc";
+
 static const char *__doc_mitsuba_OptixDenoiser =
 R"doc(Wrapper for the OptiX AI denoiser
 
@@ -5376,10 +6422,14 @@ static const char *__doc_mitsuba_PCG32Sampler_PCG32Sampler_2 = R"doc(Copy state
 
 static const char *__doc_mitsuba_PCG32Sampler_class = R"doc()doc";
 
+static const char *__doc_mitsuba_PCG32Sampler_gather_state = R"doc()doc";
+
 static const char *__doc_mitsuba_PCG32Sampler_loop_put = R"doc()doc";
 
 static const char *__doc_mitsuba_PCG32Sampler_m_rng = R"doc()doc";
 
+static const char *__doc_mitsuba_PCG32Sampler_scatter_state = R"doc()doc";
+
 static const char *__doc_mitsuba_PCG32Sampler_schedule_state = R"doc()doc";
 
 static const char *__doc_mitsuba_PCG32Sampler_seed = R"doc()doc";
@@ -5400,6 +6450,16 @@ discontinuities)doc";
 
 static const char *__doc_mitsuba_ParamFlags_NonDifferentiable = R"doc(Tracking gradients w.r.t. this parameter is not allowed)doc";
 
+static const char *__doc_mitsuba_PathTermination = R"doc(Reasons for the termination of a path (see RenderStatistics))doc";
+
+static const char *__doc_mitsuba_PathTermination_Absorbed = R"doc()doc";
+
+static const char *__doc_mitsuba_PathTermination_Escaped = R"doc()doc";
+
+static const char *__doc_mitsuba_PathTermination_MaxDepth = R"doc()doc";
+
+static const char *__doc_mitsuba_PathTermination_RussianRoulette = R"doc()doc";
+
 static const char *__doc_mitsuba_PhaseFunction = R"doc()doc";
 
 static const char *__doc_mitsuba_PhaseFunction_2 = R"doc()doc";
@@ -5584,6 +6644,9 @@ static const char *__doc_mitsuba_PluginManager_get_plugin_class = R"doc(Return t
 
 static const char *__doc_mitsuba_PluginManager_instance = R"doc(Return the global plugin manager)doc";
 
+static const char *__doc_mitsuba_PluginManager_load_time =
+R"doc(Return the total time (in milliseconds) spent loading plugin libraries)doc";
+
 static const char *__doc_mitsuba_PluginManager_loaded_plugins = R"doc(Return the list of loaded plugins)doc";
 
 static const char *__doc_mitsuba_PluginManager_register_python_plugin = R"doc(Register a Python plugin)doc";
@@ -5658,6 +6721,10 @@ static const char *__doc_mitsuba_PositionSample_p = R"doc(Sampled position)doc";
 
 static const char *__doc_mitsuba_PositionSample_pdf = R"doc(Probability density at the sample)doc";
 
+static const char *__doc_mitsuba_PositionSample_prim_index =
+R"doc(Optional: index of the primitive (e.g. triangle) containing the
+position)doc";
+
 static const char *__doc_mitsuba_PositionSample_time = R"doc(Associated time value)doc";
 
 static const char *__doc_mitsuba_PositionSample_uv =
@@ -5814,10 +6881,125 @@ static const char *__doc_mitsuba_ProfilerPhase_TextureEvaluate = R"doc()doc";
 
 static const char *__doc_mitsuba_ProfilerPhase_TextureSample = R"doc()doc";
 
+static const char *__doc_mitsuba_Profiler_add_ray_statistics =
+R"doc(Add the given values (one per RayStatistic) to the ray traversal
+statistics of the calling thread)doc";
+
+static const char *__doc_mitsuba_Profiler_has_ray_statistics =
+R"doc(Were the ray traversal statistics enabled at compile time?)doc";
+
+static const char *__doc_mitsuba_Profiler_kernel_instrumentation = R"doc(Is the instrumentation of JIT kernels enabled?)doc";
+
+static const char *__doc_mitsuba_Profiler_kernel_phase_report =
+R"doc(Return a human-readable summary of the kernel execution time per phase)doc";
+
+static const char *__doc_mitsuba_Profiler_kernel_phase_time =
+R"doc(Return the kernel execution time (in milliseconds) attributed to a
+phase by the kernel instrumentation
+
+The time is exclusive, i.e. it doesn't include the time of the nested
+phases.)doc";
+
+static const char *__doc_mitsuba_Profiler_kernel_profiling = R"doc(Is the collection of JIT kernel statistics enabled?)doc";
+
+static const char *__doc_mitsuba_Profiler_kernel_statistics = R"doc(Return the kernel statistics accumulated by a phase)doc";
+
+static const char *__doc_mitsuba_Profiler_kernel_statistics_report =
+R"doc(Return a human-readable summary of the kernel statistics per phase)doc";
+
+static const char *__doc_mitsuba_Profiler_phase_profile_report =
+R"doc(Return a hierarchical summary of the phase profile
+
+Every phase is listed below the phase it was entered from, with its
+share of the time accumulated over all threads (including and excluding
+nested phases) and the number of times it was entered.)doc";
+
+static const char *__doc_mitsuba_Profiler_phase_profiling = R"doc(Is the built-in phase profiler enabled?)doc";
+
+static const char *__doc_mitsuba_Profiler_ray_statistic =
+R"doc(Return a ray traversal statistic accumulated over all threads)doc";
+
+static const char *__doc_mitsuba_Profiler_ray_statistics_report =
+R"doc(Return a human-readable summary of the ray traversal statistics)doc";
+
+static const char *__doc_mitsuba_Profiler_reset_kernel_statistics =
+R"doc(Reset the accumulated kernel statistics of all phases)doc";
+
+static const char *__doc_mitsuba_Profiler_reset_phase_profile = R"doc(Reset the phase profile of all threads)doc";
+
+static const char *__doc_mitsuba_Profiler_reset_ray_statistics = R"doc(Reset the ray traversal statistics of all threads)doc";
+
+static const char *__doc_mitsuba_Profiler_set_kernel_instrumentation =
+R"doc(Enable or disable the instrumentation of JIT kernels with the
+profiler phases
+
+In JIT variants, plugins only trace their computation, which is then
+fused into large kernels, hence the phase profile can't tell which
+plugins are responsible for the execution time. While the
+instrumentation is enabled, every ScopedPhase pushes its name onto the
+label prefix stack of Dr.Jit, which labels the variables created within
+the phase (e.g. <tt>Integrator::render()/BSDF::sample() </tt>). Dr.Jit
+includes these labels as comments in the generated IR (LLVM IR or PTX).
+Every ScopedKernelStatistics then splits the execution time of each
+kernel among the phases in proportion to the number of IR instructions
+generated by each of them, see kernel_phase_report(). This is an
+estimate, since instructions differ in cost, but it has almost no
+runtime overhead.
+
+The labels change the generated code, hence instrumented kernels are
+compiled separately from the regular ones. When enabled, the report is
+also written to the log at shutdown.)doc";
+
+static const char *__doc_mitsuba_Profiler_set_kernel_profiling =
+R"doc(Enable or disable the collection of JIT kernel statistics
+
+While enabled, every ScopedKernelStatistics gathers the number of
+kernel launches, the kernel cache hit rate, the compilation and
+execution times, and the peak memory usage (see KernelStatistics) of
+the JIT variants, which e.g. yields a summary per call to
+Integrator::render(). The statistics are also accumulated per
+ProfilerPhase. This enables the kernel history of Dr.Jit whose entries
+are consumed by the profiler. It has no effect in scalar variants.
+
+When enabled, the report is also written to the log at shutdown.)doc";
+
+static const char *__doc_mitsuba_Profiler_set_phase_profiling =
+R"doc(Enable or disable the built-in phase profiler
+
+While enabled, every ScopedPhase records the time spent in its phase on
+a stack of the calling thread, which yields a tree of nested phases per
+thread. When disabled (the default), a ScopedPhase only checks a flag.
+In JIT (LLVM/CUDA) variants, the phases are only entered while the
+computation is traced, hence the profile then covers the tracing rather
+than the execution of the kernels.
+
+When enabled, the report is also written to the log at shutdown.)doc";
+
+static const char *__doc_mitsuba_Profiler_start_trace =
+R"doc(Start recording a timeline trace
+
+While a trace is recorded, every ScopedPhase and ScopedTraceEvent adds
+an event with its start and end time to the timeline of the calling
+thread. Previously recorded events are discarded.)doc";
+
 static const char *__doc_mitsuba_Profiler_static_initialization = R"doc()doc";
 
 static const char *__doc_mitsuba_Profiler_static_shutdown = R"doc()doc";
 
+static const char *__doc_mitsuba_Profiler_stop_trace = R"doc(Stop recording the timeline trace (the events are kept))doc";
+
+static const char *__doc_mitsuba_Profiler_thread_ray_statistic =
+R"doc(Return a ray traversal statistic of the calling thread)doc";
+
+static const char *__doc_mitsuba_Profiler_tracing = R"doc(Is a timeline trace currently being recorded?)doc";
+
+static const char *__doc_mitsuba_Profiler_write_trace =
+R"doc(Write the recorded timeline trace to a file
+
+The file uses the JSON trace event format of Chrome, which can be opened
+in Perfetto (https://ui.perfetto.dev) or in ``chrome://tracing``. Every
+thread appears as a separate track.)doc";
+
 static const char *__doc_mitsuba_ProgressReporter =
 R"doc(General-purpose progress reporter
 
@@ -6209,6 +7391,45 @@ Along with the ray origin and direction, this data structure
 additionally stores a maximum ray position ``maxt``, a time value
 ``time`` as well a the wavelength information associated with the ray.)doc";
 
+static const char *__doc_mitsuba_RayCapture =
+R"doc(Capture of the rays traced by render jobs, which can be replayed to
+benchmark the acceleration data structures (see
+:py:mod:`mitsuba.benchmark.replay`)
+
+While a capture is in progress (see start()), every ``interval``-th
+render job of SamplingIntegrator::render() and
+AdjointIntegrator::render() records the extension rays and shadow rays
+of the ``path`` integrator, along with their depth and whether they
+were traced as a coherent batch. At the end of the job, the rays are
+appended to the capture file.
+
+The file starts with the characters MRC and a version byte. It then
+contains one section per recorded render job, consisting of the index
+of the job (uint32_t) and the number of rays (uint64_t), followed by
+the rays as Record entries.
+
+Like RenderStatistics, rays are only captured by JIT variants when the
+render job evaluates its image. Capturing atomically appends every ray
+to a buffer, which slows down rendering.)doc";
+
+static const char *__doc_mitsuba_RayCapture_Record = R"doc(A captured ray (32 bytes))doc";
+
+static const char *__doc_mitsuba_RayCapture_enabled = R"doc(Is a capture in progress?)doc";
+
+static const char *__doc_mitsuba_RayCapture_start =
+R"doc(Start capturing the rays of subsequent render jobs into the given
+file, which is truncated
+
+Parameter ``interval``:
+    Only every ``interval``-th render job is recorded, starting with
+    the first one.
+
+Parameter ``max_rays``:
+    Maximum number of rays recorded per render job. Further rays are
+    dropped, and a warning is logged.)doc";
+
+static const char *__doc_mitsuba_RayCapture_stop = R"doc(Stop capturing rays)doc";
+
 static const char *__doc_mitsuba_RayDifferential =
 R"doc(Ray differential -- enhances the basic ray class with offset rays for
 two adjacent pixels on the view plane)doc";
@@ -6287,6 +7508,20 @@ static const char *__doc_mitsuba_RayFlags_dNSdUV = R"doc(Compute the shading nor
 
 static const char *__doc_mitsuba_RayFlags_dPdUV = R"doc(Compute position partials wrt. UV coordinates)doc";
 
+static const char *__doc_mitsuba_RayStatistic =
+R"doc(List of ray traversal statistics that are collected when Mitsuba is
+compiled with the ``MI_ENABLE_RAY_STATISTICS`` CMake option.)doc";
+
+static const char *__doc_mitsuba_RayStatistic_PrimitiveTests = R"doc()doc";
+
+static const char *__doc_mitsuba_RayStatistic_RayIntersect = R"doc()doc";
+
+static const char *__doc_mitsuba_RayStatistic_RayStatisticCount = R"doc()doc";
+
+static const char *__doc_mitsuba_RayStatistic_RayTest = R"doc()doc";
+
+static const char *__doc_mitsuba_RayStatistic_TraversedNodes = R"doc()doc";
+
 static const char *__doc_mitsuba_Ray_Ray = R"doc(Construct a new ray (o, d) at time 'time')doc";
 
 static const char *__doc_mitsuba_Ray_Ray_2 = R"doc(Construct a new ray (o, d) with time)doc";
@@ -6347,7 +7582,9 @@ Various kinds are implemented as subclasses of this interface.
 Because image filters are generally too expensive to evaluate for each
 sample, the implementation of this class internally precomputes an
 discrete representation, whose resolution given by
-MI_FILTER_RESOLUTION.)doc";
+MI_FILTER_RESOLUTION. In scalar variants, it furthermore tabulates the
+weights of all pixels covered by a sample as a function of its sub-
+pixel offset (see offset_weights()).)doc";
 
 static const char *__doc_mitsuba_ReconstructionFilter_2 = R"doc()doc";
 
@@ -6375,14 +7612,107 @@ static const char *__doc_mitsuba_ReconstructionFilter_is_box_filter = R"doc(Chec
 
 static const char *__doc_mitsuba_ReconstructionFilter_m_border_size = R"doc()doc";
 
+static const char *__doc_mitsuba_ReconstructionFilter_m_offset_first_tap = R"doc()doc";
+
+static const char *__doc_mitsuba_ReconstructionFilter_m_offset_resolution = R"doc()doc";
+
+static const char *__doc_mitsuba_ReconstructionFilter_m_offset_taps = R"doc()doc";
+
+static const char *__doc_mitsuba_ReconstructionFilter_m_offset_weights = R"doc()doc";
+
 static const char *__doc_mitsuba_ReconstructionFilter_m_radius = R"doc()doc";
 
 static const char *__doc_mitsuba_ReconstructionFilter_m_scale_factor = R"doc()doc";
 
 static const char *__doc_mitsuba_ReconstructionFilter_m_values = R"doc()doc";
 
+static const char *__doc_mitsuba_ReconstructionFilter_offset_first_tap =
+R"doc(Return the pixel offset of the first entry of offset_weights())doc";
+
+static const char *__doc_mitsuba_ReconstructionFilter_offset_taps =
+R"doc(Return the number of entries of the rows returned by offset_weights())doc";
+
+static const char *__doc_mitsuba_ReconstructionFilter_offset_weights =
+R"doc(Return the tabulated weights of the pixels surrounding a sample with
+sub-pixel offset ``u`` (in ``[0, 1)``)
+
+Entry ``i`` of the returned row equals the value of
+eval_discretized() at ``offset_first_tap() + i - u``, i.e. the weight
+of the pixel (center) located ``offset_first_tap() + i`` pixels after
+the one containing the sample. The row has offset_taps() entries,
+which are zero outside of the support of the filter.
+
+The offsets are quantized so that all offsets mapping to the same
+table row produce the same discretized weights. This function returns
+``nullptr`` when no table is available (in JIT variants, or when the
+radius of the filter does not permit such a quantization), and when
+``u`` lies too close to the boundary between two rows to decide
+reliably. Callers should fall back to eval_discretized() in this case.)doc";
+
 static const char *__doc_mitsuba_ReconstructionFilter_radius = R"doc(Return the filter's width)doc";
 
+static const char *__doc_mitsuba_RenderCounter = R"doc(Events counted by the render job statistics (see RenderStatistics))doc";
+
+static const char *__doc_mitsuba_RenderCounter_Absorbed = R"doc(Paths whose throughput dropped to zero)doc";
+
+static const char *__doc_mitsuba_RenderCounter_Escaped = R"doc(Paths that left the scene)doc";
+
+static const char *__doc_mitsuba_RenderCounter_ExtensionRays = R"doc(Rays traced to extend a path)doc";
+
+static const char *__doc_mitsuba_RenderCounter_MaxDepth = R"doc(Paths that reached the maximum depth)doc";
+
+static const char *__doc_mitsuba_RenderCounter_PathVertices = R"doc(Sum of the lengths of these paths)doc";
+
+static const char *__doc_mitsuba_RenderCounter_Paths = R"doc(Paths whose termination was recorded)doc";
+
+static const char *__doc_mitsuba_RenderCounter_RenderCounterCount = R"doc()doc";
+
+static const char *__doc_mitsuba_RenderCounter_RussianRoulette = R"doc(Paths terminated by Russian roulette)doc";
+
+static const char *__doc_mitsuba_RenderCounter_Samples = R"doc(Samples taken by the render job)doc";
+
+static const char *__doc_mitsuba_RenderCounter_ShadowRays = R"doc(Rays traced to test the visibility of emitter samples)doc";
+
+static const char *__doc_mitsuba_RenderStatistics =
+R"doc(Statistics of a render job
+
+When enabled via set_enabled(), SamplingIntegrator::render() and
+AdjointIntegrator::render() collect the statistics of their render
+job. The number of samples is counted by all sampling integrators and
+by the ``ptracer`` integrator, which (like the ``path`` integrator)
+additionally records the length and the termination cause of every
+path as well as the number of extension and shadow rays. The summary
+is logged at the end of the render job and available via
+Integrator::render_statistics().
+
+In scalar variants, the counters are local to every thread and merged
+at the end of the job, hence render jobs running concurrently in
+scalar variants share their counters. In JIT variants, every event
+adds an atomic operation to the rendering kernels.)doc";
+
+static const char *__doc_mitsuba_RenderStatistics_average_path_length =
+R"doc(Return the average length of the recorded paths)doc";
+
+static const char *__doc_mitsuba_RenderStatistics_counter = R"doc(Return the value of a counter)doc";
+
+static const char *__doc_mitsuba_RenderStatistics_counters = R"doc(Value of every RenderCounter)doc";
+
+static const char *__doc_mitsuba_RenderStatistics_enabled = R"doc(Is the collection of render statistics enabled?)doc";
+
+static const char *__doc_mitsuba_RenderStatistics_max_path_length = R"doc(Length of the longest path)doc";
+
+static const char *__doc_mitsuba_RenderStatistics_samples_per_second = R"doc(Return the number of samples per second)doc";
+
+static const char *__doc_mitsuba_RenderStatistics_set_enabled =
+R"doc(Enable or disable the collection of render statistics (off by default))doc";
+
+static const char *__doc_mitsuba_RenderStatistics_shadow_ray_ratio =
+R"doc(Return the number of shadow rays per extension ray)doc";
+
+static const char *__doc_mitsuba_RenderStatistics_time = R"doc(Duration of the render job in seconds)doc";
+
+static const char *__doc_mitsuba_RenderStatistics_to_string = R"doc(Return a human-readable summary)doc";
+
 static const char *__doc_mitsuba_Resampler =
 R"doc(Utility class for efficiently resampling discrete datasets to
 different resolutions
@@ -6410,6 +7740,10 @@ static const char *__doc_mitsuba_Resampler_boundary_condition =
 R"doc(Return the boundary condition that should be used when looking up
 samples outside of the defined input domain)doc";
 
+static const char *__doc_mitsuba_Resampler_boundary_position =
+R"doc(Map an out-of-range position to the domain (for positional boundary
+conditions))doc";
+
 static const char *__doc_mitsuba_Resampler_clamp =
 R"doc(Returns the range to which resampled values will be clamped
 
@@ -6456,23 +7790,115 @@ Parameter ``target_stride``:
 Parameter ``channels``:
     Number of channels to be resampled)doc";
 
-static const char *__doc_mitsuba_Resampler_resample_internal = R"doc()doc";
+static const char *__doc_mitsuba_Resampler_resample_columns =
+R"doc(Resample many adjacent columns of an image at once
+
+This is equivalent to calling resample() with a single channel for
+each of the ``count`` columns starting at ``source`` and ``target``,
+and it produces the same values. However, it traverses the data one
+row at a time, which accesses memory contiguously and lets the inner
+loop vectorize across columns.
+
+Parameter ``source``:
+    Pointer to the first column of the source array
+
+Parameter ``source_row_stride``:
+    Number of values between consecutive source rows
+
+Parameter ``target``:
+    Pointer to the first column of the target array
+
+Parameter ``target_row_stride``:
+    Number of values between consecutive target rows
+
+Parameter ``count``:
+    Number of adjacent columns to be resampled)doc";
+
+static const char *__doc_mitsuba_Resampler_resample_internal = R"doc()doc";
+
+static const char *__doc_mitsuba_Resampler_set_boundary_condition =
+R"doc(Set the boundary condition that should be used when looking up samples
+outside of the defined input domain
+
+The default is FilterBoundaryCondition::Clamp)doc";
+
+static const char *__doc_mitsuba_Resampler_set_clamp = R"doc(If specified, resampled values will be clamped to the given range)doc";
+
+static const char *__doc_mitsuba_Resampler_source_resolution = R"doc(Return the reconstruction filter's source resolution)doc";
+
+static const char *__doc_mitsuba_Resampler_taps = R"doc(Return the number of taps used by the reconstruction filter)doc";
+
+static const char *__doc_mitsuba_Resampler_target_resolution = R"doc(Return the reconstruction filter's target resolution)doc";
+
+static const char *__doc_mitsuba_Resampler_to_string = R"doc(Return a human-readable summary)doc";
+
+static const char *__doc_mitsuba_ResourceCache =
+R"doc(Process-wide cache of resources that were loaded from files
+
+Plugins that load large immutable data (e.g. bitmaps or volume grids)
+from a file can request it through this cache, so that a file which is
+referenced several times, e.g. by textures with different wrap modes
+or by several media, is only read and stored once.
+
+Entries are identified by the absolute path of the file, its size and
+last modification time, and a string describing any parameters that
+affect how the file is loaded. A file that changed on disk is
+therefore loaded again. Concurrent requests for the same entry (e.g.
+during parallel scene loading) wait for the first one to finish
+loading it.
+
+The cache only keeps resources alive as long as they are used
+elsewhere: entries that are no longer referenced by any other object
+are released by subsequent requests. While a ResourceCache::Scope
+exists (e.g. during scene loading), all entries are kept instead,
+since plugins often convert the loaded data and release it before the
+next reference is instantiated. The returned objects are shared, and
+callers must copy them before making any modifications.)doc";
+
+static const char *__doc_mitsuba_ResourceCache_Scope = R"doc(Keeps all cached resources alive during its lifetime)doc";
+
+static const char *__doc_mitsuba_ResourceCache_clear = R"doc(Release all cached resources)doc";
+
+static const char *__doc_mitsuba_ResourceCache_get =
+R"doc(Return the cached resource for a file, or load it
+
+Parameter ``path``:
+    Path of the file, which must already be resolved (e.g. using
+    FileResolver).
+
+Parameter ``params``:
+    Description of further parameters that affect the loaded
+    resource. Requests with different parameters refer to different
+    entries.
+
+Parameter ``load``:
+    Function that is called to load the resource if no entry exists.)doc";
+
+static const char *__doc_mitsuba_ResourceCache_get_2 =
+R"doc(Typed version of get() that constructs a ``T`` from the path
+
+The type is part of the entry, hence e.g. the volume grids of
+different variants are cached separately.)doc";
 
-static const char *__doc_mitsuba_Resampler_set_boundary_condition =
-R"doc(Set the boundary condition that should be used when looking up samples
-outside of the defined input domain
+static const char *__doc_mitsuba_ResourceCache_prefetch =
+R"doc(Asynchronously load a resource into the cache
 
-The default is FilterBoundaryCondition::Clamp)doc";
+Starts loading the entry on the thread pool and returns immediately. A
+subsequent get() with the same arguments waits for the load to finish
+(it does not load the file a second time). Errors are only logged,
+since the subsequent get() reports them.
 
-static const char *__doc_mitsuba_Resampler_set_clamp = R"doc(If specified, resampled values will be clamped to the given range)doc";
+This is meant to be used within a Scope, which keeps the loaded entry
+alive until it is requested. The destructor of the scope waits for all
+pending loads.)doc";
 
-static const char *__doc_mitsuba_Resampler_source_resolution = R"doc(Return the reconstruction filter's source resolution)doc";
+static const char *__doc_mitsuba_ResourceCache_prefetch_2 = R"doc(Typed version of prefetch(), see get() for details)doc";
 
-static const char *__doc_mitsuba_Resampler_taps = R"doc(Return the number of taps used by the reconstruction filter)doc";
+static const char *__doc_mitsuba_ResourceCache_size = R"doc(Return the number of resources in the cache)doc";
 
-static const char *__doc_mitsuba_Resampler_target_resolution = R"doc(Return the reconstruction filter's target resolution)doc";
+static const char *__doc_mitsuba_ResourceCache_static_shutdown = R"doc(Release all cached resources at shutdown)doc";
 
-static const char *__doc_mitsuba_Resampler_to_string = R"doc(Return a human-readable summary)doc";
+static const char *__doc_mitsuba_ResourceCache_wait = R"doc(Wait for all loads started by prefetch() to finish)doc";
 
 static const char *__doc_mitsuba_SGGXPhaseFunctionParams =
 R"doc(The parameters of the SGGX phase function stored as a pair of 3D
@@ -6563,12 +7989,31 @@ Remark:
 
 May throw an exception if not supported.)doc";
 
+static const char *__doc_mitsuba_Sampler_compact =
+R"doc(Create a copy of this sampler restricted to a subset of the lanes of
+its wavefront
+
+Lane ``i`` of the returned sampler continues the sequence of the
+current sample of lane ``index[i]``, and thus produces the same random
+numbers. This is used to compact the wavefront of a rendering loop
+once most of its lanes have terminated. The returned sampler should
+not be advanced to subsequent samples.)doc";
+
 static const char *__doc_mitsuba_Sampler_compute_per_sequence_seed =
 R"doc(Generates a array of seeds where the seed values are unique per
 sequence)doc";
 
 static const char *__doc_mitsuba_Sampler_current_sample_index = R"doc(Return the index of the current sample)doc";
 
+static const char *__doc_mitsuba_Sampler_expand =
+R"doc(Write the state of a sampler created by compact() back to the lanes
+``index`` of this sampler
+
+Afterwards, this sampler continues as if the compacted lanes had never
+been separated from its wavefront.)doc";
+
+static const char *__doc_mitsuba_Sampler_film_width = R"doc(Return the width specified via set_film_width())doc";
+
 static const char *__doc_mitsuba_Sampler_fork =
 R"doc(Create a fork of this sampler.
 
@@ -6577,12 +8022,16 @@ internal state of the sampler.
 
 May throw an exception if not supported.)doc";
 
+static const char *__doc_mitsuba_Sampler_gather_state = R"doc(Gather the per-lane state of the sampler (see compact()))doc";
+
 static const char *__doc_mitsuba_Sampler_loop_put = R"doc(Register internal state of this sampler with a symbolic loop)doc";
 
 static const char *__doc_mitsuba_Sampler_m_base_seed = R"doc(Base seed value)doc";
 
 static const char *__doc_mitsuba_Sampler_m_dimension_index = R"doc(Index of the current dimension in the sample)doc";
 
+static const char *__doc_mitsuba_Sampler_m_film_width = R"doc(Width of the image covered by the wavefront (or 0, if unknown))doc";
+
 static const char *__doc_mitsuba_Sampler_m_sample_count = R"doc(Number of samples per pixel)doc";
 
 static const char *__doc_mitsuba_Sampler_m_sample_index = R"doc(Index of the current sample in the sequence)doc";
@@ -6597,6 +8046,9 @@ static const char *__doc_mitsuba_Sampler_next_2d = R"doc(Retrieve the next two c
 
 static const char *__doc_mitsuba_Sampler_sample_count = R"doc(Return the number of samples per pixel)doc";
 
+static const char *__doc_mitsuba_Sampler_scatter_state =
+R"doc(Scatter the per-lane state of a compacted sampler (see expand()))doc";
+
 static const char *__doc_mitsuba_Sampler_schedule_state = R"doc(dr::schedule() variables that represent the internal sampler state)doc";
 
 static const char *__doc_mitsuba_Sampler_seed =
@@ -6608,6 +8060,15 @@ the wavefront.)doc";
 
 static const char *__doc_mitsuba_Sampler_seeded = R"doc(Return whether the sampler was seeded)doc";
 
+static const char *__doc_mitsuba_Sampler_set_film_width =
+R"doc(Set the width of the image covered by the sample sequences of a
+wavefront in scanline order
+
+In wavefront modes, sequence ``y * width + x`` of the wavefront renders
+pixel ``(x, y)``. Samplers that correlate the sequences of neighboring
+pixels use this to recover their coordinates. A value of zero (the
+default) denotes an unknown layout.)doc";
+
 static const char *__doc_mitsuba_Sampler_set_sample_count = R"doc(Set the number of samples per pixel)doc";
 
 static const char *__doc_mitsuba_Sampler_set_samples_per_wavefront =
@@ -6639,8 +8100,49 @@ static const char *__doc_mitsuba_SamplingIntegrator_SamplingIntegrator = R"doc(/
 
 static const char *__doc_mitsuba_SamplingIntegrator_class = R"doc()doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_m_adaptive_min_passes =
+R"doc(Minimum number of passes before blocks may be retired (adaptive
+sampling))doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_m_adaptive_threshold =
+R"doc(Target relative error for adaptive sampling (scalar variants).
+
+When positive, the rendering is split into multiple passes. After each
+pass, the relative standard error of the mean pixel luminance is
+estimated and averaged over each block. Blocks that fall below this
+threshold don't receive any further samples. A value of zero disables
+adaptive sampling (default).)doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_m_block_order =
+R"doc(Order in which the image blocks are rendered (scalar variants).
+
+Specified as ``block_order``, which is either ``"spiral"`` (default),
+``"hilbert"``, or ``"morton"``. Along a space-filling curve, the blocks
+rendered concurrently by the worker threads are adjacent, which improves
+the reuse of cached textures and geometry. The block identifiers (and
+hence the seeds) depend on the order.)doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_m_block_size = R"doc(Size of (square) image blocks to render in parallel (in scalar mode))doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_m_max_wavefront_memory =
+R"doc(Upper bound on the memory used by the state of a wavefront (JIT
+variants, in bytes).
+
+When positive, the per-lane state footprint is estimated, and the
+render job is split into passes with fewer samples and, if needed,
+horizontal bands of the image that fit into this budget. The chunks
+are only a function of this parameter, the film size, and the sample
+count, hence results are reproducible. A value of zero disables the
+limit (default).)doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_m_numa =
+R"doc(Enable NUMA-aware scheduling (scalar variants).
+
+On systems with several NUMA nodes, worker threads are pinned to the
+cores of a node, and each of them preferentially renders the blocks of
+a horizontal stripe of the image assigned to its node. Image blocks
+are allocated after pinning and hence reside in node-local memory.)doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_m_samples_per_pass =
 R"doc(Number of samples to compute for each pass over the image blocks.
 
@@ -6746,6 +8248,11 @@ static const char *__doc_mitsuba_Scene_class = R"doc()doc";
 
 static const char *__doc_mitsuba_Scene_clear_shapes_dirty = R"doc(Unmarks all shapes as dirty)doc";
 
+static const char *__doc_mitsuba_Scene_emitter_training_spp =
+R"doc(Return the number of samples per pixel of the training pass requested
+by the environment emitter, or zero if it doesn't need one (see
+Emitter::training_spp()))doc";
+
 static const char *__doc_mitsuba_Scene_emitters = R"doc(Return the list of emitters)doc";
 
 static const char *__doc_mitsuba_Scene_emitters_2 = R"doc(Return the list of emitters (const version))doc";
@@ -6805,6 +8312,8 @@ Parameter ``ss``:
 Returns:
     The corresponding boundary sample space point)doc";
 
+static const char *__doc_mitsuba_Scene_light_bvh = R"doc(Return the light BVH used to sample emitters (if enabled))doc";
+
 static const char *__doc_mitsuba_Scene_m_accel = R"doc(Acceleration data structure (IAS) (type depends on implementation))doc";
 
 static const char *__doc_mitsuba_Scene_m_accel_handle = R"doc(Handle to the IAS used to ensure its lifetime in jit variants)doc";
@@ -6825,6 +8334,8 @@ static const char *__doc_mitsuba_Scene_m_environment = R"doc()doc";
 
 static const char *__doc_mitsuba_Scene_m_integrator = R"doc()doc";
 
+static const char *__doc_mitsuba_Scene_m_light_bvh = R"doc(Hierarchy for reference point-aware emitter sampling (if enabled))doc";
+
 static const char *__doc_mitsuba_Scene_m_sensors = R"doc()doc";
 
 static const char *__doc_mitsuba_Scene_m_sensors_dr = R"doc()doc";
@@ -6843,12 +8354,18 @@ static const char *__doc_mitsuba_Scene_m_silhouette_shapes = R"doc()doc";
 
 static const char *__doc_mitsuba_Scene_m_silhouette_shapes_dr = R"doc()doc";
 
+static const char *__doc_mitsuba_Scene_m_use_light_bvh = R"doc()doc";
+
 static const char *__doc_mitsuba_Scene_parameters_changed = R"doc(Update internal state following a parameter update)doc";
 
 static const char *__doc_mitsuba_Scene_pdf_emitter =
 R"doc(Evaluate the discrete probability of the sample_emitter() technique
 for the given a emitter index.)doc";
 
+static const char *__doc_mitsuba_Scene_pdf_emitter_2 =
+R"doc(Evaluate the discrete probability of the reference point-aware
+sample_emitter() technique for the given a emitter index.)doc";
+
 static const char *__doc_mitsuba_Scene_pdf_emitter_direction =
 R"doc(Evaluate the PDF of direct illumination sampling
 
@@ -6868,6 +8385,16 @@ Parameter ``ds``:
 Returns:
     The solid angle density of the sample)doc";
 
+static const char *__doc_mitsuba_Scene_ray_flags =
+R"doc(Return the RayFlags of the surface interaction fields read by the
+materials and textures of the scene
+
+Integrators pass these flags to ray_intersect() to skip the
+computation of unused fields, e.g. the UV parameterization of
+untextured scenes. The scene parameter ``minimal_ray_flags`` (default:
+``true``) disables this analysis, in which case RayFlags::All is
+returned.)doc";
+
 static const char *__doc_mitsuba_Scene_ray_intersect =
 R"doc(Intersect a ray with the shapes comprising the scene and return a
 detailed data structure describing the intersection, if one is found.
@@ -7087,6 +8614,32 @@ static const char *__doc_mitsuba_Scene_ray_test_cpu = R"doc(Trace a shadow ray)d
 
 static const char *__doc_mitsuba_Scene_ray_test_gpu = R"doc()doc";
 
+static const char *__doc_mitsuba_Scene_ray_test_multi =
+R"doc(Test several rays for occlusion at once
+
+This function is equivalent to calling ray_test() for each of the
+``count`` rays, but it is meant for groups of rays that share their
+origin, such as the shadow rays of several emitter samples taken at the
+same shading point. The native CPU backend then traces them as packets
+through the kd-tree, so that the traversal of its upper levels is
+shared. Other backends test the rays one after the other.
+
+Parameter ``rays``:
+    Array of ``count`` rays
+
+Parameter ``active``:
+    Array of ``count`` masks specifying the enabled rays
+
+Parameter ``result``:
+    Array of ``count`` masks that are set to ``true`` for the rays that
+    found an intersection (output))doc";
+
+static const char *__doc_mitsuba_Scene_ray_test_multi_cpu = R"doc()doc";
+
+static const char *__doc_mitsuba_Scene_record_emitter_visibility =
+R"doc(Report the visibility of a direction sample to a training environment
+emitter)doc";
+
 static const char *__doc_mitsuba_Scene_sample_emitter =
 R"doc(Sample one emitter in the scene and rescale the input sample for
 reuse.
@@ -7094,6 +8647,28 @@ reuse.
 Currently, the sampling scheme implemented by the Scene class is very
 simplistic (uniform).
 
+Parameter ``sample``:
+    A uniformly distributed number in [0, 1).
+
+Returns:
+    The index of the chosen emitter along with the sampling weight
+    (equal to the inverse PDF), and the transformed random sample for
+    reuse.)doc";
+
+static const char *__doc_mitsuba_Scene_sample_emitter_2 =
+R"doc(Sample one emitter in the scene for a given reference point and
+rescale the input sample for reuse.
+
+When the scene was created with the ``light_bvh`` parameter set to
+``True``, the emitter is chosen using a LightBVH, i.e. approximately
+proportionally to its contribution at ``ref``. Otherwise, this
+function is equivalent to sample_emitter(). The hierarchy bounds every
+emitter as a whole, which is most effective for scenes with many
+small emitters (e.g. point lights), see LightBVH.
+
+Parameter ``ref``:
+    A reference point somewhere within the scene.
+
 Parameter ``sample``:
     A uniformly distributed number in [0, 1).
 
@@ -7144,6 +8719,22 @@ were involved, etc.)
 the radiance incident from the emitter and the sample probability per
 unit solid angle.)doc";
 
+static const char *__doc_mitsuba_Scene_sample_emitter_directions =
+R"doc(Take several direct illumination samples at the same location
+
+This function is equivalent to calling sample_emitter_direction()
+with each of the ``count`` samples, except that the visibility of all
+samples is tested using a single call to ray_test_multi().
+
+Parameter ``samples``:
+    Array of ``count`` uniformly distributed 2D samples
+
+Parameter ``ds``:
+    Array of ``count`` direction samples (output)
+
+Parameter ``spec``:
+    Array of ``count`` sampling weights (output))doc";
+
 static const char *__doc_mitsuba_Scene_sample_emitter_ray =
 R"doc(Sample a ray according to the emission profile of scene emitters
 
@@ -7201,12 +8792,30 @@ Parameter ``flags``:
 Returns:
     Silhouette sample record.)doc";
 
+static const char *__doc_mitsuba_Scene_select_view_dependent_shapes =
+R"doc(Make the shapes of the scene depend on the view of its primary
+sensor
+
+Replaces every level-of-detail shape (see Shape::lod_levels()) by
+the level that matches its projected size on the film of the first
+sensor. When ``culling`` is set, shapes marked as view-cullable are
+further skipped when their bounding box lies outside of the view
+frustum, after dilating the film by the fraction ``margin`` on every
+side. Only projective cameras define a frustum: otherwise, the finest
+levels are used and no shapes are culled.)doc";
+
 static const char *__doc_mitsuba_Scene_sensors = R"doc(Return the list of sensors)doc";
 
 static const char *__doc_mitsuba_Scene_sensors_2 = R"doc(Return the list of sensors (const version))doc";
 
 static const char *__doc_mitsuba_Scene_sensors_dr = R"doc(Return the list of sensors as a Dr.Jit array)doc";
 
+static const char *__doc_mitsuba_Scene_set_emitter_training =
+R"doc(Start or stop the training pass of the environment emitter
+
+While it is in progress, sample_emitter_direction() reports the result
+of its visibility tests to the environment emitter.)doc";
+
 static const char *__doc_mitsuba_Scene_shapes = R"doc(Return the list of shapes)doc";
 
 static const char *__doc_mitsuba_Scene_shapes_2 = R"doc(Return the list of shapes)doc";
@@ -7231,22 +8840,73 @@ static const char *__doc_mitsuba_Scene_static_accel_shutdown_cpu = R"doc()doc";
 
 static const char *__doc_mitsuba_Scene_static_accel_shutdown_gpu = R"doc()doc";
 
+static const char *__doc_mitsuba_Scene_structure_version =
+R"doc(Counter that is incremented whenever parameters_changed() rebuilds
+the acceleration data structure or the emitter sampling distributions
+
+Recorded (frozen) rendering kernels reference these data structures
+and must be recorded again when the counter changes.)doc";
+
 static const char *__doc_mitsuba_Scene_to_string = R"doc(Return a human-readable string representation of the scene contents.)doc";
 
 static const char *__doc_mitsuba_Scene_traverse = R"doc(Traverse the scene graph and invoke the given callback for each object)doc";
 
 static const char *__doc_mitsuba_Scene_update_emitter_sampling_distribution = R"doc(Updates the discrete distribution used to select an emitter)doc";
 
+static const char *__doc_mitsuba_Scene_update_ray_flags =
+R"doc(Combines the RayFlags requested by the BSDFs and textures of the scene)doc";
+
 static const char *__doc_mitsuba_Scene_update_silhouette_sampling_distribution = R"doc(Updates the discrete distribution used to select a shape's silhouette)doc";
 
+static const char *__doc_mitsuba_ScopedKernelStatistics =
+R"doc(Collects the statistics of the JIT kernels launched during its
+lifetime on behalf of a ProfilerPhase
+
+This object is only active while kernel profiling or instrumentation is
+enabled (see Profiler::set_kernel_profiling() and
+Profiler::set_kernel_instrumentation()), a JIT backend was specified,
+and no other instance is active. Kernels launched before its
+construction are not accounted for. The statistics are added to those
+of the phase when finish() is called, or at the latest by the
+destructor.)doc";
+
+static const char *__doc_mitsuba_ScopedKernelStatistics_ScopedKernelStatistics = R"doc()doc";
+
+static const char *__doc_mitsuba_ScopedKernelStatistics_active = R"doc(Is this object collecting kernel statistics?)doc";
+
+static const char *__doc_mitsuba_ScopedKernelStatistics_finish =
+R"doc(Stop collecting and return the statistics of the kernels launched so
+far
+
+This waits for the kernels to finish. Subsequent calls return the same
+statistics.)doc";
+
 static const char *__doc_mitsuba_ScopedPhase = R"doc()doc";
 
 static const char *__doc_mitsuba_ScopedPhase_ScopedPhase = R"doc()doc";
 
 static const char *__doc_mitsuba_ScopedPhase_ScopedPhase_2 = R"doc()doc";
 
+static const char *__doc_mitsuba_ScopedPhase_m_profiled = R"doc()doc";
+
 static const char *__doc_mitsuba_ScopedPhase_operator_assign = R"doc()doc";
 
+static const char *__doc_mitsuba_ScopedRayStatistics =
+R"doc(Local accumulator of ray traversal statistics
+
+Traversal routines increment the counters of a local instance, which
+adds them to the statistics of the calling thread once it goes out of
+scope. When Mitsuba is compiled without ``MI_ENABLE_RAY_STATISTICS``,
+this class is empty and all of its operations compile to nothing.)doc";
+
+static const char *__doc_mitsuba_ScopedRayStatistics_ScopedRayStatistics = R"doc()doc";
+
+static const char *__doc_mitsuba_ScopedRayStatistics_add = R"doc()doc";
+
+static const char *__doc_mitsuba_ScopedRayStatistics_operator_assign = R"doc()doc";
+
+static const char *__doc_mitsuba_ScopedRayStatistics_values = R"doc()doc";
+
 static const char *__doc_mitsuba_ScopedSetThreadEnvironment =
 R"doc(RAII-style class to temporarily switch to another thread's logger/file
 resolver)doc";
@@ -7261,6 +8921,32 @@ static const char *__doc_mitsuba_ScopedSetThreadEnvironment_m_logger = R"doc()do
 
 static const char *__doc_mitsuba_ScopedSetThreadEnvironment_operator_assign = R"doc()doc";
 
+static const char *__doc_mitsuba_ScopedTraceEvent =
+R"doc(Adds an event to the trace timeline of the calling thread while a trace
+is recorded (see Profiler::start_trace())
+
+The event lasts from the construction until the destruction of this
+object. When no trace is recorded, this only checks a flag.)doc";
+
+static const char *__doc_mitsuba_ScopedTraceEvent_ScopedTraceEvent = R"doc()doc";
+
+static const char *__doc_mitsuba_ScopedTraceEvent_ScopedTraceEvent_2 = R"doc()doc";
+
+static const char *__doc_mitsuba_ScopedTraceEvent_active = R"doc(Is this event being recorded?)doc";
+
+static const char *__doc_mitsuba_ScopedTraceEvent_begin = R"doc()doc";
+
+static const char *__doc_mitsuba_ScopedTraceEvent_end = R"doc()doc";
+
+static const char *__doc_mitsuba_ScopedTraceEvent_m_generation =
+R"doc(Detects whether the timeline was cleared in the meantime)doc";
+
+static const char *__doc_mitsuba_ScopedTraceEvent_m_index = R"doc(Index of the event in the timeline of the thread)doc";
+
+static const char *__doc_mitsuba_ScopedTraceEvent_operator_assign = R"doc()doc";
+
+static const char *__doc_mitsuba_ScopedTraceEvent_set_info = R"doc(Set additional information that is shown with the event)doc";
+
 static const char *__doc_mitsuba_Sensor = R"doc()doc";
 
 static const char *__doc_mitsuba_Sensor_2 = R"doc()doc";
@@ -7380,14 +9066,124 @@ times to provide each participating worker thread with its own
 instance (see Scene::sampler()). Therefore, this sampler should never
 be used for anything except creating clones.)doc";
 
+static const char *__doc_mitsuba_Sensor_set_shutter_open =
+R"doc(Change the time value of the shutter opening event (e.g. to render a
+sequence))doc";
+
 static const char *__doc_mitsuba_Sensor_shutter_open = R"doc(Return the time value of the shutter opening event)doc";
 
 static const char *__doc_mitsuba_Sensor_shutter_open_time = R"doc(Return the length, for which the shutter remains open)doc";
 
+static const char *__doc_mitsuba_Sensor_sub_sensors =
+R"doc(Return the child sensors of a meta-sensor that renders several
+views at once (e.g. ``batch``)
+
+The views are tiled horizontally in the film of the meta-sensor, in the
+order of this list. The list is empty for all other sensors.)doc";
+
 static const char *__doc_mitsuba_Sensor_traverse = R"doc(//! @})doc";
 
 static const char *__doc_mitsuba_Shape = R"doc(Forward declaration for `SilhouetteSample`)doc";
 
+static const char *__doc_mitsuba_ShapeBVH =
+R"doc(Wide bounding volume hierarchy over a set of shapes
+
+This class is an alternative to ShapeKDTree for builds without Embree.
+It is constructed using a binned surface area heuristic, after which
+the resulting binary hierarchy is collapsed into nodes with 4 or 8
+children. The bounds of the children of a node are stored in a
+structure-of-arrays layout, so that a single ray is tested against all
+of them at once using SIMD instructions (SSE/AVX/NEON, depending on
+the target).
+
+Compared to the kd-tree, the construction is considerably faster,
+while the traversal performance is similar or better in most scenes.
+Like the kd-tree, the hierarchy is only traversed by one ray at a
+time.)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_Node =
+R"doc(BVH node with ``Width`` children
+
+Unused child slots have empty bounds, which are never intersected. A
+child with a nonzero primitive count is a leaf.)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_Node_child = R"doc(Index of an inner child node, or primitive offset of a leaf)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_Node_count = R"doc(Number of primitives of a leaf child (zero for inner nodes))doc";
+
+static const char *__doc_mitsuba_ShapeBVH_Node_min_x = R"doc(Bounds of the children (structure-of-arrays layout))doc";
+
+static const char *__doc_mitsuba_ShapeBVH_ShapeBVH =
+R"doc(Create an empty BVH and take build-related parameters from ``props``.
+
+Parameter ``width``:
+    Number of children per node (4 or 8))doc";
+
+static const char *__doc_mitsuba_ShapeBVH_add_shape = R"doc(Register a new shape with the BVH (to be called before build()))doc";
+
+static const char *__doc_mitsuba_ShapeBVH_bbox = R"doc(Return the bounding box of the entire hierarchy)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_build = R"doc(Build the BVH)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_clear = R"doc(Clear the BVH (build-related parameters remain))doc";
+
+static const char *__doc_mitsuba_ShapeBVH_intersect_prim =
+R"doc(Check whether a primitive is intersected by the given ray.
+
+The primitive is specified by its index in the (reordered) primitive
+list of the BVH.)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_m_prim_shape =
+R"doc(Shape and primitive index of every entry of the reordered primitive list)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_primitive_count = R"doc(Return the number of registered primitives)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_ray_intersect_naive =
+R"doc(Brute force intersection routine for debugging purposes)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_shape = R"doc(Return the i-th shape)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_shape_count = R"doc(Return the number of registered shapes)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_to_string =
+R"doc(Return a human-readable string representation of the scene contents.)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_traverse = R"doc(Ray traversal of a BVH with ``Width`` children per node)doc";
+
+static const char *__doc_mitsuba_ShapeBVH_width = R"doc(Return the number of children per node)doc";
+
+static const char *__doc_mitsuba_ShapeGroup_bounds =
+R"doc(Return a small set of bounding boxes whose union encloses the geometry
+of the shape group
+
+These boxes are tighter than bbox() and are used by instances to
+compute tight world-space bounds under arbitrary transformations.)doc";
+
+static const char *__doc_mitsuba_ShapeGroup_has_spheres = R"doc(Return whether this shapegroup contains sphere shapes)doc";
+
+static const char *__doc_mitsuba_ShapeGroup_m_has_spheres = R"doc()doc";
+
+static const char *__doc_mitsuba_ShapeKDTree_cache_key =
+R"doc(Compute a key identifying the built kd-tree
+
+The key is a hash of the geometry of all registered shapes and of the
+build-related parameters, which together fully determine the tree.)doc";
+
+static const char *__doc_mitsuba_ShapeKDTree_cache_load =
+R"doc(Try to load a previously built kd-tree with the given key from a cache file)doc";
+
+static const char *__doc_mitsuba_ShapeKDTree_cache_store = R"doc(Store the built kd-tree in a cache file under the given key)doc";
+
+static const char *__doc_mitsuba_ShapeKDTree_m_cache_dir =
+R"doc(Directory of the on-disk kd-tree cache (disabled when empty))doc";
+
+static const char *__doc_mitsuba_ShapeKDTree_m_cache_file = R"doc(Cache file that stores m_nodes and m_indices when mapped)doc";
+
+static const char *__doc_mitsuba_ShapeKDTree_m_cache_map =
+R"doc(Map cached kd-trees from their file instead of copying them?)doc";
+
+static const char *__doc_mitsuba_ShapeType_Spheres = R"doc(Sphere collections (`spheres`))doc";
+
 static const char *__doc_mitsuba_Shape_2 = R"doc(Forward declaration for `SilhouetteSample`)doc";
 
 static const char *__doc_mitsuba_Shape_3 = R"doc()doc";
@@ -7555,6 +9351,18 @@ static const char *__doc_mitsuba_Shape_Shape = R"doc(//! @})doc";
 
 static const char *__doc_mitsuba_Shape_Shape_2 = R"doc()doc";
 
+static const char *__doc_mitsuba_Shape_attribute_handle =
+R"doc(Return a handle that identifies the attribute with the given name
+
+Handles are small integers shared by all shapes, which are assigned the
+first time a name is queried. Evaluating an attribute through its handle
+avoids the name lookup that is otherwise performed at every shading
+point, hence callers in the rendering hot path (e.g. the
+:monosp:`mesh_attribute` texture) should resolve it once at
+construction time.)doc";
+
+static const char *__doc_mitsuba_Shape_attribute_name = R"doc(Return the name of the attribute associated with a handle)doc";
+
 static const char *__doc_mitsuba_Shape_bbox =
 R"doc(Return an axis aligned box that bounds all shape primitives (including
 any transformations that may have been applied to them))doc";
@@ -7648,6 +9456,10 @@ the scene by this shape
 Includes instanced geometry. The default implementation simply returns
 the same value as primitive_count().)doc";
 
+static const char *__doc_mitsuba_Shape_embree_build_quality =
+R"doc(Return the Embree build quality requested for this shape (``"low"``,
+``"medium"``, ``"high"``, or empty to use the scene's))doc";
+
 static const char *__doc_mitsuba_Shape_embree_geometry = R"doc(Return the Embree version of this shape)doc";
 
 static const char *__doc_mitsuba_Shape_emitter = R"doc(Return the area emitter associated with this shape (if any))doc";
@@ -7687,6 +9499,14 @@ Parameter ``si``:
 Returns:
     An scalar intensity or reflectance value)doc";
 
+static const char *__doc_mitsuba_Shape_eval_attribute_1_2 =
+R"doc(Monochromatic evaluation of a shape attribute identified by a handle)doc";
+
+static const char *__doc_mitsuba_Shape_eval_attribute_2 =
+R"doc(Evaluate a shape attribute identified by a handle (see attribute_handle())
+
+The default implementation falls back to the name-based version.)doc";
+
 static const char *__doc_mitsuba_Shape_eval_attribute_3 =
 R"doc(Trichromatic evaluation of a shape attribute at the given surface
 interaction
@@ -7704,6 +9524,9 @@ Parameter ``si``:
 Returns:
     An trichromatic intensity or reflectance value)doc";
 
+static const char *__doc_mitsuba_Shape_eval_attribute_3_2 =
+R"doc(Trichromatic evaluation of a shape attribute identified by a handle)doc";
+
 static const char *__doc_mitsuba_Shape_eval_parameterization =
 R"doc(Parameterize the mesh using UV values
 
@@ -7721,10 +9544,20 @@ R"doc(Returns whether this shape contains the specified attribute.
 Parameter ``name``:
     Name of the attribute)doc";
 
+static const char *__doc_mitsuba_Shape_has_motion = R"doc(Does this shape have a time-dependent (keyframed) transformation?)doc";
+
 static const char *__doc_mitsuba_Shape_id = R"doc(Return a string identifier)doc";
 
 static const char *__doc_mitsuba_Shape_initialize = R"doc()doc";
 
+static const char *__doc_mitsuba_Shape_instance_transform =
+R"doc(Return the object-to-world transformation of an instance at the given
+time
+
+Other shapes apply their transformation to the geometry itself, in
+which case this function returns the identity. This is e.g. used to
+compute the motion vectors of animated sequences.)doc";
+
 static const char *__doc_mitsuba_Shape_interior_medium = R"doc(Return the medium that lies on the interior of this shape)doc";
 
 static const char *__doc_mitsuba_Shape_invert_silhouette_sample =
@@ -7754,6 +9587,23 @@ static const char *__doc_mitsuba_Shape_is_sensor = R"doc(Is this shape also an a
 
 static const char *__doc_mitsuba_Shape_is_shapegroup = R"doc(Is this shape a shapegroup?)doc";
 
+static const char *__doc_mitsuba_Shape_is_view_cullable =
+R"doc(May the scene skip this shape when it lies outside of the view
+frustum of its primary sensor?
+
+Set by the ``view_cullable`` parameter, which marks shapes that don't
+affect the lighting of the visible parts of the scene. The shapes are
+only skipped when the scene enables the ``view_culling`` parameter.)doc";
+
+static const char *__doc_mitsuba_Shape_lod_levels =
+R"doc(Return the alternative versions of a level-of-detail shape
+
+The levels are ordered from the finest to the coarsest, and each is
+paired with the minimum size (in pixels) that the shape must cover on
+the film of the primary sensor for the level to be used. The scene
+replaces the shape by one of its levels when it is loaded. Other shapes
+return an empty list.)doc";
+
 static const char *__doc_mitsuba_Shape_m_bsdf = R"doc()doc";
 
 static const char *__doc_mitsuba_Shape_m_dirty = R"doc(True if the shape's geometry has changed)doc";
@@ -7784,10 +9634,23 @@ static const char *__doc_mitsuba_Shape_m_to_object = R"doc()doc";
 
 static const char *__doc_mitsuba_Shape_m_to_world = R"doc()doc";
 
+static const char *__doc_mitsuba_Shape_m_topology_dirty =
+R"doc(True if the shape's geometry has changed beyond its vertex positions)doc";
+
+static const char *__doc_mitsuba_Shape_m_view_cullable =
+R"doc(True if the scene may skip the shape when it lies outside of the view)doc";
+
 static const char *__doc_mitsuba_Shape_mark_as_instance = R"doc()doc";
 
 static const char *__doc_mitsuba_Shape_mark_dirty = R"doc(Mark that the shape's geometry has changed)doc";
 
+static const char *__doc_mitsuba_Shape_mark_vertices_dirty =
+R"doc(Mark that the shape's vertex positions have changed, while its
+topology (vertex and face counts, face indices) remains the same
+
+This enables acceleration data structures to refit their bounds
+instead of performing a full rebuild.)doc";
+
 static const char *__doc_mitsuba_Shape_operator_delete = R"doc()doc";
 
 static const char *__doc_mitsuba_Shape_operator_delete_2 = R"doc()doc";
@@ -8043,6 +9906,9 @@ static const char *__doc_mitsuba_Shape_ray_test_packet_3 = R"doc()doc";
 
 static const char *__doc_mitsuba_Shape_ray_test_scalar = R"doc()doc";
 
+static const char *__doc_mitsuba_Shape_replace_object =
+R"doc(Replace the BSDF of the shape (used by the reload mode of the XML loader))doc";
+
 static const char *__doc_mitsuba_Shape_sample_direction =
 R"doc(Sample a direction towards this shape with respect to solid angles
 measured at a reference position within the scene
@@ -8140,6 +10006,13 @@ static const char *__doc_mitsuba_Shape_silhouette_discontinuity_types = R"doc(//
 
 static const char *__doc_mitsuba_Shape_silhouette_sampling_weight = R"doc(Return this shape's sampling weight w.r.t. all shapes in the scene)doc";
 
+static const char *__doc_mitsuba_Shape_sphere_primitive =
+R"doc(Return the center and radius of a single spherical primitive
+
+This is used by the native kd-tree to intersect the primitives of
+ShapeType::Spheres shapes in packets, and must be implemented by all
+shapes of this type. The default implementation throws an exception.)doc";
+
 static const char *__doc_mitsuba_Shape_surface_area =
 R"doc(Return the shape's surface area.
 
@@ -8148,6 +10021,9 @@ time-dependent scaling.
 
 The default implementation throws an exception.)doc";
 
+static const char *__doc_mitsuba_Shape_topology_dirty =
+R"doc(Return whether the shape's geometry has changed in a way that requires a rebuild)doc";
+
 static const char *__doc_mitsuba_Shape_traverse = R"doc()doc";
 
 static const char *__doc_mitsuba_SilhouetteSample =
@@ -8250,6 +10126,15 @@ static const char *__doc_mitsuba_Spectrum_operator_assign_2 = R"doc()doc";
 static const char *__doc_mitsuba_Spiral =
 R"doc(Generates a spiral of blocks to be rendered.
 
+Instead of a spiral, the blocks can also be visited along a space-
+filling curve (see BlockOrder). The order is computed once upon
+construction and stored in an immutable table. Blocks are then handed
+out to worker threads using a single atomic counter, which means that
+next_block() is lock-free and can be called concurrently from any
+number of threads. The returned block identifiers only depend on the
+position of the block within the traversal (and not on the thread
+that requested it), hence seeding remains deterministic.
+
 Author:
     Adam Arbree Aug 25, 2005 RayTracer.java Used with permission.
     Copyright 2005 Program of Computer Graphics, Cornell University)doc";
@@ -8268,44 +10153,81 @@ static const char *__doc_mitsuba_Spiral_Spiral =
 R"doc(Create a new spiral generator for the given size, offset into a larger
 frame, and block size)doc";
 
+static const char *__doc_mitsuba_Spiral_block =
+R"doc(Return the offset, size, and unique identifier of the block with the
+given global index (spanning all passes).
+
+This is useful for schedulers that partition the index range ``[0,
+block_count() * passes())`` themselves (e.g. using
+``dr::parallel_for``). The result is identical to what the
+``index``-th call to next_block() would have returned.)doc";
+
 static const char *__doc_mitsuba_Spiral_block_count = R"doc(Return the total number of blocks)doc";
 
 static const char *__doc_mitsuba_Spiral_class = R"doc()doc";
 
-static const char *__doc_mitsuba_Spiral_direction = R"doc()doc";
-
 static const char *__doc_mitsuba_Spiral_m_block_count = R"doc()doc";
 
 static const char *__doc_mitsuba_Spiral_m_block_counter = R"doc()doc";
 
+static const char *__doc_mitsuba_Spiral_m_block_order = R"doc(Order in which the blocks are visited)doc";
+
 static const char *__doc_mitsuba_Spiral_m_block_size = R"doc()doc";
 
 static const char *__doc_mitsuba_Spiral_m_blocks = R"doc()doc";
 
-static const char *__doc_mitsuba_Spiral_m_mutex = R"doc()doc";
-
 static const char *__doc_mitsuba_Spiral_m_offset = R"doc()doc";
 
-static const char *__doc_mitsuba_Spiral_m_passes_left = R"doc()doc";
+static const char *__doc_mitsuba_Spiral_m_order = R"doc()doc";
 
-static const char *__doc_mitsuba_Spiral_m_position = R"doc()doc";
+static const char *__doc_mitsuba_Spiral_m_partition_counter = R"doc(Index of the next block within each partition)doc";
 
-static const char *__doc_mitsuba_Spiral_m_size = R"doc()doc";
+static const char *__doc_mitsuba_Spiral_m_partition_order =
+R"doc(Global block indices of each partition (see set_partitions()))doc";
 
-static const char *__doc_mitsuba_Spiral_m_spiral_size = R"doc()doc";
+static const char *__doc_mitsuba_Spiral_m_passes = R"doc()doc";
 
-static const char *__doc_mitsuba_Spiral_m_steps_left = R"doc()doc";
+static const char *__doc_mitsuba_Spiral_m_size = R"doc()doc";
 
 static const char *__doc_mitsuba_Spiral_max_block_size = R"doc(Return the maximum block size)doc";
 
 static const char *__doc_mitsuba_Spiral_next_block =
 R"doc(Return the offset, size, and unique identifier of the next block.
 
-A size of zero indicates that the spiral traversal is done.)doc";
+A size of zero indicates that the spiral traversal is done. This
+function is lock-free and may be called concurrently.)doc";
+
+static const char *__doc_mitsuba_Spiral_next_block_2 =
+R"doc(Return the offset, size, and unique identifier of the next block of
+the given partition (see set_partitions()).
+
+A size of zero indicates that the traversal of all partitions is done.
+This function is lock-free and may be called concurrently.)doc";
+
+static const char *__doc_mitsuba_Spiral_order = R"doc(Return the order in which the blocks are visited)doc";
+
+static const char *__doc_mitsuba_Spiral_partitions = R"doc(Return the number of partitions (see set_partitions()))doc";
+
+static const char *__doc_mitsuba_Spiral_passes = R"doc(Return the number of passes over the image)doc";
 
 static const char *__doc_mitsuba_Spiral_reset =
 R"doc(Reset the spiral to its initial state. Does not affect the number of
-passes.)doc";
+passes.
+
+This function restarts the pass that is currently in progress (or the
+last pass, if the traversal is done). It is not thread-safe and must
+not be called while other threads are querying blocks.)doc";
+
+static const char *__doc_mitsuba_Spiral_set_partitions =
+R"doc(Split the blocks into ``count`` partitions consisting of horizontal
+stripes of the image (e.g. one per NUMA node).
+
+Blocks of a partition are subsequently handed out in spiral order via
+next_block(uint32_t). Once a partition is exhausted, its callers
+continue with the blocks of the other partitions. The block
+identifiers are the same as in the non-partitioned traversal. This
+function is not thread-safe, and the two variants of next_block()
+should not be mixed.)doc";
 
 static const char *__doc_mitsuba_Stream =
 R"doc(Abstract seekable stream class
@@ -9165,6 +11087,13 @@ static const char *__doc_mitsuba_TShapeKDTree_EdgeEvent_type = R"doc(Event type:
 
 static const char *__doc_mitsuba_TShapeKDTree_EdgeEvent_valid = R"doc()doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_IndexDeleter = R"doc(Releases index arrays created with <tt>new Index[]</tt>)doc";
+
+static const char *__doc_mitsuba_TShapeKDTree_IndexDeleter_operator_call = R"doc()doc";
+
+static const char *__doc_mitsuba_TShapeKDTree_IndexDeleter_owned =
+R"doc(Set when the indices are stored elsewhere (e.g. in a mapped file))doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_KDNode = R"doc(kd-tree node in 8 bytes.)doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_KDNode_axis = R"doc(Return the split axis (for interior nodes))doc";
@@ -9258,6 +11187,13 @@ left and right subtrees and return associated primitive lists.)doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_MinMaxBins_put = R"doc()doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_NodeDeleter = R"doc(Releases node arrays created by allocate_nodes())doc";
+
+static const char *__doc_mitsuba_TShapeKDTree_NodeDeleter_operator_call = R"doc()doc";
+
+static const char *__doc_mitsuba_TShapeKDTree_NodeDeleter_owned =
+R"doc(Set when the nodes are stored elsewhere (e.g. in a mapped file))doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_PrimClassification =
 R"doc(Enumeration representing the state of a classified primitive in the
 O(N log N) builder)doc";
@@ -9288,6 +11224,9 @@ static const char *__doc_mitsuba_TShapeKDTree_SplitCandidate_split = R"doc()doc"
 
 static const char *__doc_mitsuba_TShapeKDTree_TShapeKDTree = R"doc()doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_allocate_nodes =
+R"doc(Allocate an (uninitialized) array of nodes aligned to a cache line)doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_bbox = R"doc(Return the bounding box of the entire kd-tree)doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_build = R"doc()doc";
@@ -9296,6 +11235,12 @@ static const char *__doc_mitsuba_TShapeKDTree_class = R"doc()doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_clip_primitives = R"doc(Return whether primitive clipping is used during tree construction)doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_compact =
+R"doc(Return whether the nodes and indices are stored in the compact layout)doc";
+
+static const char *__doc_mitsuba_TShapeKDTree_compact_layout =
+R"doc(Convert the nodes and indices of a built tree to the compact layout)doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_compute_statistics = R"doc()doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_cost_model = R"doc(Return the cost model used by the tree construction algorithm)doc";
@@ -9309,12 +11254,21 @@ R"doc(Return the number of primitives, at which the builder will switch from
 (approximate) Min-Max binning to the accurate O(n log n) optimization
 method.)doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_leaf_indices =
+R"doc(Return the primitive indices referenced by a leaf node
+
+In the compact layout (see set_compact()), the index of a leaf with a
+single primitive is stored in the node, in which case it is copied to
+``storage``.)doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_log_level = R"doc(Return the log level of kd-tree status messages)doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_m_bbox = R"doc()doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_m_clip_primitives = R"doc()doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_m_compact = R"doc()doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_m_cost_model = R"doc()doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_m_exact_prim_threshold = R"doc()doc";
@@ -9329,6 +11283,8 @@ static const char *__doc_mitsuba_TShapeKDTree_m_max_bad_refines = R"doc()doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_m_max_depth = R"doc()doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_m_memory = R"doc(Accounts for m_nodes and m_indices)doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_m_min_max_bins = R"doc()doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_m_node_count = R"doc()doc";
@@ -9353,11 +11309,25 @@ static const char *__doc_mitsuba_TShapeKDTree_retract_bad_splits = R"doc(Return
 
 static const char *__doc_mitsuba_TShapeKDTree_set_clip_primitives = R"doc(Set whether primitive clipping is used during tree construction)doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_set_compact =
+R"doc(Specify whether the nodes and indices are stored in the compact layout
+after the tree construction.
+
+In this layout, leaves referencing a single primitive store its index
+directly (which removes it from the index list) and the nodes are
+reordered into cache-line-sized treelets, i.e. groups of sibling pairs
+close to the root of a subtree that share a cache line. This reduces
+the memory footprint as well as the number of cache lines touched by a
+traversal.)doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_set_exact_primitive_threshold =
 R"doc(Specify the number of primitives, at which the builder will switch
 from (approximate) Min-Max binning to the accurate O(n log n)
 optimization method.)doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_set_indices =
+R"doc(Replace the index array, which is released later on if owned is set)doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_set_log_level = R"doc(Return the log level of kd-tree status messages)doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_set_max_bad_refines =
@@ -9368,6 +11338,9 @@ static const char *__doc_mitsuba_TShapeKDTree_set_max_depth = R"doc(Set the maxi
 
 static const char *__doc_mitsuba_TShapeKDTree_set_min_max_bins = R"doc(Set the number of bins used for Min-Max binning)doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_set_nodes =
+R"doc(Replace the node array, which is released later on if owned is set)doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_set_retract_bad_splits = R"doc(Specify whether or not bad splits can be "retracted".)doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_set_stop_primitives =
@@ -9528,6 +11501,14 @@ Returns:
     A density value for each wavelength in ``si.wavelengths`` (hence
     the Wavelength type).)doc";
 
+static const char *__doc_mitsuba_Texture_ray_flags =
+R"doc(Return the RayFlags of the surface interaction fields read by this
+texture (excluding nested objects)
+
+The default implementation requests the UV coordinates of spatially
+varying textures. The scene combines these flags to avoid computing
+unused fields at every intersection (see Scene::ray_flags()).)doc";
+
 static const char *__doc_mitsuba_Texture_resolution =
 R"doc(Returns the resolution of the texture, assuming that it is based on a
 discrete representation.
@@ -9946,6 +11927,18 @@ static const char *__doc_mitsuba_Vector_operator_assign_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Volume = R"doc(Abstract base class for 3D volumes.)doc";
 
+static const char *__doc_mitsuba_VolumeGrid_compute_max = R"doc(Compute the maximum values of the grid (in parallel))doc";
+
+static const char *__doc_mitsuba_VolumeGrid_is_mapped = R"doc(Is the volume storage memory-mapped from a file?)doc";
+
+static const char *__doc_mitsuba_VolumeGrid_m_data_ptr = R"doc()doc";
+
+static const char *__doc_mitsuba_VolumeGrid_m_memory = R"doc(Accounts for m_data (memory-mapped files are not included))doc";
+
+static const char *__doc_mitsuba_VolumeGrid_m_mmap = R"doc()doc";
+
+static const char *__doc_mitsuba_VolumeGrid_read_header = R"doc(Read the header of a volume file and return its encoding)doc";
+
 static const char *__doc_mitsuba_Volume_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Volume_3 = R"doc()doc";
@@ -10030,13 +12023,19 @@ static const char *__doc_mitsuba_VolumeGrid_write =
 R"doc(Write an encoded form of the bitmap to a binary volume file
 
 Parameter ``path``:
-    Target file name (expected to end in ".vol"))doc";
+    Target file name (expected to end in ".vol")
+
+Parameter ``half``:
+    Store the voxel values in half precision (encoding 2))doc";
 
 static const char *__doc_mitsuba_VolumeGrid_write_2 =
 R"doc(Write an encoded form of the volume grid to a stream
 
 Parameter ``stream``:
-    Target stream that will receive the encoded output)doc";
+    Target stream that will receive the encoded output
+
+Parameter ``half``:
+    Store the voxel values in half precision (encoding 2))doc";
 
 static const char *__doc_mitsuba_Volume_Volume = R"doc()doc";
 
@@ -10069,6 +12068,13 @@ static const char *__doc_mitsuba_Volume_eval_gradient =
 R"doc(Evaluate the volume at the given surface interaction, and compute the
 gradients of the linear interpolant as well.)doc";
 
+static const char *__doc_mitsuba_Volume_eval_mip =
+R"doc(Evaluate the volume at a given level of its MIP pyramid
+
+Level 0 is the full resolution, and larger levels are clamped to the
+coarsest one (see mip_levels()). The default implementation ignores
+the level and calls eval().)doc";
+
 static const char *__doc_mitsuba_Volume_eval_n =
 R"doc(Evaluate this volume as a n-channel float quantity
 
@@ -10084,12 +12090,27 @@ static const char *__doc_mitsuba_Volume_m_to_local = R"doc(Used to bring points
 
 static const char *__doc_mitsuba_Volume_max = R"doc(Returns the maximum value of the volume over all dimensions.)doc";
 
+static const char *__doc_mitsuba_Volume_max_per_cell =
+R"doc(Compute the maximum of the volume over the cells of a coarse grid
+
+The unit cube of the volume's local coordinate system is subdivided
+into ``res.x() * res.y() * res.z()`` cells. For each cell, the
+function writes an upper bound of the values that lookups within it
+can return (including interpolation) to ``out``, with the x coordinate
+varying fastest. The default implementation uses max() for all
+cells.
+
+Pointer allocation/deallocation must be performed by the caller.)doc";
+
 static const char *__doc_mitsuba_Volume_max_per_channel =
 R"doc(In the case of a multi-channel volume, this function returns the
 maximum value for each channel.
 
 Pointer allocation/deallocation must be performed by the caller.)doc";
 
+static const char *__doc_mitsuba_Volume_mip_levels =
+R"doc(Returns the number of levels of the volume's MIP pyramid (1 if it has none))doc";
+
 static const char *__doc_mitsuba_Volume_resolution =
 R"doc(Returns the resolution of the volume, assuming that it is based on a
 discrete representation.
@@ -10100,14 +12121,28 @@ static const char *__doc_mitsuba_Volume_to_string = R"doc(Returns a human-reable
 
 static const char *__doc_mitsuba_Volume_update_bbox = R"doc()doc";
 
+static const char *__doc_mitsuba_Volume_world_to_local =
+R"doc(Returns the transformation from world space to the local coordinates
+of the volume)doc";
+
 static const char *__doc_mitsuba_ZStream =
 R"doc(Transparent compression/decompression stream based on ``zlib``.
 
 This class transparently decompresses and compresses reads and writes
-to a nested stream, respectively.)doc";
+to a nested stream, respectively.
+
+In addition to the standard deflate and gzip formats, the stream
+supports a block format (EBlockStream) that splits the data into
+blocks of fixed size. These are compressed independently, which allows
+the stream to compress and decompress several blocks in parallel on
+the thread pool. Each block is stored as its uncompressed and
+compressed size (two little endian 32 bit integers) followed by the
+zlib-compressed data, and an empty block marks the end of the stream.)doc";
 
 static const char *__doc_mitsuba_ZStream_EStreamType = R"doc()doc";
 
+static const char *__doc_mitsuba_ZStream_EStreamType_EBlockStream = R"doc(A gzip-compatible stream)doc";
+
 static const char *__doc_mitsuba_ZStream_EStreamType_EDeflateStream = R"doc()doc";
 
 static const char *__doc_mitsuba_ZStream_EStreamType_EGZipStream = R"doc(A raw deflate stream)doc";
@@ -10115,7 +12150,10 @@ static const char *__doc_mitsuba_ZStream_EStreamType_EGZipStream = R"doc(A raw d
 static const char *__doc_mitsuba_ZStream_ZStream =
 R"doc(Creates a new compression stream with the given underlying stream.
 This new instance takes ownership of the child stream. The child
-stream must outlive the ZStream.)doc";
+stream must outlive the ZStream.
+
+The parameter ``block_size`` specifies the uncompressed size of the
+blocks written by an EBlockStream, and is ignored otherwise.)doc";
 
 static const char *__doc_mitsuba_ZStream_can_read = R"doc(Can we read from the stream?)doc";
 
@@ -10134,6 +12172,8 @@ read or write operations are permitted.
 This function is idempotent. It is called automatically by the
 destructor.)doc";
 
+static const char *__doc_mitsuba_ZStream_fetch_blocks = R"doc(Read and start decompressing blocks until enough are in flight)doc";
+
 static const char *__doc_mitsuba_ZStream_flush = R"doc(Flushes any buffered data)doc";
 
 static const char *__doc_mitsuba_ZStream_is_closed = R"doc(Whether the stream is closed (no read or write are then permitted).)doc";
@@ -10155,10 +12195,16 @@ R"doc(Reads a specified amount of data from the stream, decompressing it
 first using ZLib. Throws an exception when the stream ended
 prematurely.)doc";
 
+static const char *__doc_mitsuba_ZStream_release_blocks = R"doc(Wait for all pending blocks and release them)doc";
+
 static const char *__doc_mitsuba_ZStream_seek = R"doc(Unsupported. Always throws.)doc";
 
 static const char *__doc_mitsuba_ZStream_size = R"doc(Unsupported. Always throws.)doc";
 
+static const char *__doc_mitsuba_ZStream_stream_type = R"doc(Returns the type of the compressed stream)doc";
+
+static const char *__doc_mitsuba_ZStream_submit_block = R"doc(Compress the pending data of an EBlockStream asynchronously)doc";
+
 static const char *__doc_mitsuba_ZStream_tell = R"doc(Unsupported. Always throws.)doc";
 
 static const char *__doc_mitsuba_ZStream_to_string = R"doc(Returns a string representation)doc";
@@ -10170,6 +12216,8 @@ R"doc(Writes a specified amount of data into the stream, compressing it
 first using ZLib. Throws an exception when not all data could be
 written.)doc";
 
+static const char *__doc_mitsuba_ZStream_write_block = R"doc(Wait for the oldest block being compressed and write it)doc";
+
 static const char *__doc_mitsuba_accumulate_2d =
 R"doc(Accumulate the contents of a source bitmap into a target bitmap with
 specified offsets for both.
@@ -10180,6 +12228,10 @@ Out-of-bounds regions are safely ignored. It is assumed that ``source
 The function supports `T` being a raw pointer or an arbitrary Dr.Jit
 array that can potentially live on the GPU and/or be differentiable.)doc";
 
+static const char *__doc_mitsuba_block_order_from_string =
+R"doc(Parse the name of a block order (``"spiral"``, ``"hilbert"``, or
+``"morton"``))doc";
+
 static const char *__doc_mitsuba_bsdf =
 R"doc(Returns the BSDF of the intersected shape.
 
@@ -10193,8 +12245,8 @@ static const char *__doc_mitsuba_build_gas =
 R"doc(Build OptiX geometry acceleration structures (GAS) for a given list of
 shapes.
 
-Two different GAS will be created for the meshes and the custom
-shapes. Optix handles to those GAS will be stored in an
+Separate GAS will be created for the meshes, curves, built-in spheres
+and the custom shapes. Optix handles to those GAS will be stored in an
 OptixAccelData.)doc";
 
 static const char *__doc_mitsuba_cie1931_xyz =
@@ -10212,7 +12264,12 @@ nanometers, normalized to ensures that it integrates to a luminance of
 
 static const char *__doc_mitsuba_class = R"doc()doc";
 
-static const char *__doc_mitsuba_color_management_static_initialization = R"doc(Allocate arrays for the color space tables)doc";
+static const char *__doc_mitsuba_color_management_static_initialization =
+R"doc(Allocate arrays for the color space tables
+
+This function is called on demand by the first evaluation of a color
+matching function. Calling it during startup merely moves this (small)
+cost ahead of time.)doc";
 
 static const char *__doc_mitsuba_color_management_static_shutdown = R"doc()doc";
 
@@ -10257,8 +12314,17 @@ static const char *__doc_mitsuba_detail_CIE1932Tables_d65 = R"doc(CIE D65 illumi
 
 static const char *__doc_mitsuba_detail_CIE1932Tables_initialize = R"doc()doc";
 
+static const char *__doc_mitsuba_detail_CIE1932Tables_initialize_2 =
+R"doc(Initialize the tables from a copy of the (already initialized) host
+tables
+
+This doesn't record any arithmetic, and is therefore safe to call while
+a JIT backend traces a symbolic loop or virtual function call.)doc";
+
 static const char *__doc_mitsuba_detail_CIE1932Tables_initialized = R"doc()doc";
 
+static const char *__doc_mitsuba_detail_CIE1932Tables_is_initialized = R"doc()doc";
+
 static const char *__doc_mitsuba_detail_CIE1932Tables_release = R"doc()doc";
 
 static const char *__doc_mitsuba_detail_CIE1932Tables_srgb = R"doc(ITU-R Rec. BT.709 linear RGB tables)doc";
@@ -10329,6 +12395,8 @@ static const char *__doc_mitsuba_detail_OrderedChunkAllocator_chunk_count = R"do
 
 static const char *__doc_mitsuba_detail_OrderedChunkAllocator_m_chunks = R"doc()doc";
 
+static const char *__doc_mitsuba_detail_OrderedChunkAllocator_m_memory = R"doc()doc";
+
 static const char *__doc_mitsuba_detail_OrderedChunkAllocator_m_min_allocation = R"doc()doc";
 
 static const char *__doc_mitsuba_detail_OrderedChunkAllocator_release = R"doc()doc";
@@ -10339,9 +12407,21 @@ static const char *__doc_mitsuba_detail_OrderedChunkAllocator_size = R"doc(Retur
 
 static const char *__doc_mitsuba_detail_OrderedChunkAllocator_used = R"doc(Return the total amount of used memory in bytes)doc";
 
+static const char *__doc_mitsuba_detail_ProfilerFlags = R"doc(Features of the built-in profiler that are currently enabled)doc";
+
+static const char *__doc_mitsuba_detail_ProfilerFlags_ProfilerKernelLabels =
+R"doc(Kernel instrumentation, see Profiler::set_kernel_instrumentation())doc";
+
+static const char *__doc_mitsuba_detail_ProfilerFlags_ProfilerPhases =
+R"doc(Phase profile, see Profiler::set_phase_profiling())doc";
+
+static const char *__doc_mitsuba_detail_ProfilerFlags_ProfilerTrace = R"doc(Timeline trace, see Profiler::start_trace())doc";
+
 static const char *__doc_mitsuba_detail_Throw = R"doc()doc";
 
-static const char *__doc_mitsuba_detail_get_color_space_tables = R"doc()doc";
+static const char *__doc_mitsuba_detail_get_color_space_tables =
+R"doc(Return the color space tables of a backend, initializing them if
+necessary)doc";
 
 static const char *__doc_mitsuba_detail_get_construct_functor = R"doc()doc";
 
@@ -10353,6 +12433,12 @@ static const char *__doc_mitsuba_detail_get_unserialize_functor_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_detail_is_constructible = R"doc()doc";
 
+static const char *__doc_mitsuba_detail_profiler_enter_phase = R"doc()doc";
+
+static const char *__doc_mitsuba_detail_profiler_flags = R"doc()doc";
+
+static const char *__doc_mitsuba_detail_profiler_leave_phase = R"doc()doc";
+
 static const char *__doc_mitsuba_detail_serialization_helper =
 R"doc(The serialization_helper<T> implementations for new types should in
 general be implemented as a series of calls to the lower-level
@@ -10455,6 +12541,14 @@ static const char *__doc_mitsuba_emitter =
 R"doc(Return the emitter associated with the intersection (if any) \note
 Defined in scene.h)doc";
 
+static const char *__doc_mitsuba_eval_albedo =
+R"doc(Compute the directional albedo of a microfacet distribution without
+Fresnel factor, i.e. the fraction of the light arriving from the
+directions ``wi`` that leaves the surface after a single reflection
+
+This is used to compensate the energy lost by microfacet models that
+neglect multiple scattering, see e.g. the ``roughconductor`` plugin.)doc";
+
 static const char *__doc_mitsuba_eval_reflectance = R"doc()doc";
 
 static const char *__doc_mitsuba_eval_transmittance = R"doc()doc";
@@ -10489,6 +12583,12 @@ relative to ``base``.
 See also:
     http ://en.cppreference.com/w/cpp/experimental/fs/absolute))doc";
 
+static const char *__doc_mitsuba_filesystem_create_directories =
+R"doc(Creates a directory at ``p`` along with all of its missing parent
+directories, as if ``mkdir -p`` was used. Returns true if ``p`` is a
+directory afterwards, false otherwise. Directories that are
+concurrently created by other processes are not treated as an error.)doc";
+
 static const char *__doc_mitsuba_filesystem_create_directory =
 R"doc(Creates a directory at ``p`` as if ``mkdir`` was used. Returns true if
 directory creation was successful, false otherwise. If ``p`` already
@@ -10515,6 +12615,10 @@ static const char *__doc_mitsuba_filesystem_is_regular_file =
 R"doc(Checks if ``p`` points to a regular file, as opposed to a directory or
 symlink.)doc";
 
+static const char *__doc_mitsuba_filesystem_last_write_time =
+R"doc(Returns the time of the last modification of the file system object
+at ``p``, in seconds since the epoch.)doc";
+
 static const char *__doc_mitsuba_filesystem_path =
 R"doc(Represents a path to a filesystem resource. On construction, the path
 is parsed and stored in a system-agnostic representation. The path can
@@ -10789,6 +12893,9 @@ static const char *__doc_mitsuba_hasher_operator_call = R"doc()doc";
 
 static const char *__doc_mitsuba_ior_from_file = R"doc()doc";
 
+static const char *__doc_mitsuba_is_builtin_sphere =
+R"doc(Is the shape traced as a built-in OptiX sphere? (see optix_builtin_spheres()))doc";
+
 static const char *__doc_mitsuba_librender_nop =
 R"doc(Dummy function which can be called to ensure that the librender shared
 library is loaded)doc";
@@ -11307,12 +13414,32 @@ static const char *__doc_mitsuba_operator_sub = R"doc(Subtracting two points sho
 
 static const char *__doc_mitsuba_operator_sub_2 = R"doc(Subtracting a vector from a point should always yield a point)doc";
 
+static const char *__doc_mitsuba_optix_builtin_spheres =
+R"doc(Are spheres traced as built-in OptiX primitives on the current device?
+
+Built-in spheres are intersected by the RT cores of recent GPUs, which
+is much faster than the custom intersection program of the ``sphere``
+shape. They require OptiX 7.5, which is detected once per device by
+loading the corresponding built-in intersection module. Otherwise,
+spheres fall back to the custom intersection program.)doc";
+
 static const char *__doc_mitsuba_optix_initialize = R"doc()doc";
 
 static const char *__doc_mitsuba_orthographic_projection =
 R"doc(Helper function to create a orthographic projection transformation
 matrix)doc";
 
+static const char *__doc_mitsuba_owen_scramble_2 =
+R"doc(Apply a hash-based Owen scrambling to a 32 bit fixed-point sample of a
+base-2 sequence
+
+Every bit of the sample is flipped depending on the bits preceding it,
+which preserves the stratification of (0, m, 2)-nets such as the first
+two dimensions of the Sobol' sequence. This is the Laine-Karras style
+permutation proposed by Burley (Practical Hash-based Owen Scrambling,
+JCGT 2020), with different seeds producing statistically independent
+scramblings.)doc";
+
 static const char *__doc_mitsuba_parse_fov = R"doc(Helper function to parse the field of view field of a camera)doc";
 
 static const char *__doc_mitsuba_pdf_rgb_spectrum =
@@ -11548,6 +13675,8 @@ Parameter ``cos_theta_t``:
 Parameter ``eta_ti``:
     Relative index of refraction (transmitted / incident))doc";
 
+static const char *__doc_mitsuba_reverse_bits_32 = R"doc(Reverse the order of the bits of a 32 bit unsigned integer)doc";
+
 static const char *__doc_mitsuba_sample_rgb_spectrum =
 R"doc(Importance sample a "importance spectrum" that concentrates the
 computation on wavelengths that are relevant for rendering of RGB data
@@ -11721,6 +13850,14 @@ static const char *__doc_mitsuba_sggx_sample_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_sobol_2 = R"doc(Sobol' radical inverse in base 2)doc";
 
+static const char *__doc_mitsuba_sobol_2_bits =
+R"doc(Return the 32 bit fixed-point representation of the second dimension
+of the Sobol' sequence
+
+This is the unscrambled value of sobol_2() prior to its conversion to
+a floating point number. The first dimension is given by
+reverse_bits_32().)doc";
+
 static const char *__doc_mitsuba_spectrum_from_file =
 R"doc(Read a spectral power distribution from an ASCII file.
 
@@ -12336,6 +14473,13 @@ static const char *__doc_mitsuba_util_Version_patch = R"doc()doc";
 
 static const char *__doc_mitsuba_util_core_count = R"doc(Determine the number of available CPU cores (including virtual cores))doc";
 
+static const char *__doc_mitsuba_util_core_numa_nodes =
+R"doc(Determine the NUMA node of every available CPU core
+
+The cores are listed in the same order as the indices accepted by
+Thread::set_core_affinity(). On systems where the topology cannot be
+queried, all cores are reported as belonging to node 0.)doc";
+
 static const char *__doc_mitsuba_util_detect_debugger = R"doc(Returns 'true' if the application is running inside a debugger)doc";
 
 static const char *__doc_mitsuba_util_info_build = R"doc(Return human-readable information about the Mitsuba build)doc";
@@ -12364,6 +14508,17 @@ static const char *__doc_mitsuba_util_trap_debugger =
 R"doc(Generate a trap instruction if running in a debugger; otherwise,
 return.)doc";
 
+static const char *__doc_mitsuba_util_write_file_atomic =
+R"doc(Atomically create or replace the file ``filename``
+
+The function ``write`` is called with the path of a temporary file in
+the same directory, which is subsequently renamed to ``filename``. The
+name of the temporary file is unique to the calling process and
+invocation, hence other processes (or threads) that concurrently write
+the same file never share it, and readers never observe a partially
+written file. Missing parent directories are created. Throws an
+exception upon failure, in which case the temporary file is removed.)doc";
+
 static const char *__doc_mitsuba_variant = R"doc()doc";
 
 static const char *__doc_mitsuba_variant_data = R"doc()doc";
@@ -12465,6 +14620,21 @@ distribution)doc";
 
 static const char *__doc_mitsuba_warp_square_to_rough_fiber_pdf = R"doc(Probability density of square_to_rough_fiber())doc";
 
+static const char *__doc_mitsuba_warp_square_to_spherical_triangle =
+R"doc(Uniformly sample a direction within the spherical triangle spanned by
+the unit vectors ``a``, ``b``, and ``c``
+
+This is the solid angle sampling technique by James Arvo ("Stratified
+sampling of spherical triangles", SIGGRAPH 1995): the first sample
+dimension chooses a sub-triangle with the desired area, and the second
+one positions the direction along the arc connecting its third vertex
+with ``b``. Degenerate triangles produce invalid (NaN) directions.)doc";
+
+static const char *__doc_mitsuba_warp_square_to_spherical_triangle_pdf =
+R"doc(Density of square_to_spherical_triangle() per unit solid angle, i.e.
+the inverse of the solid angle spanned by the unit vectors ``a``,
+``b``, and ``c``)doc";
+
 static const char *__doc_mitsuba_warp_square_to_std_normal =
 R"doc(Sample a point on a 2D standard normal distribution. Internally uses
 the Box-Muller transformation)doc";
@@ -12574,10 +14744,28 @@ static const char *__doc_mitsuba_xml_detail_expand_node =
 R"doc(Expands a node (if it does not expand it is wrapped into a
 std::vector))doc";
 
+static const char *__doc_mitsuba_xml_detail_prefetch_resources =
+R"doc(Start loading the files referenced by the given objects in parallel
+
+Bitmap textures only decode their image when they are instantiated,
+which can happen late in the dependency graph of a scene. This
+function instead submits the loads of all referenced images to the
+ResourceCache upfront (largest files first), so that reading and
+decoding them overlaps with the instantiation of the other objects.)doc";
+
 static const char *__doc_mitsuba_xml_detail_xml_to_properties =
 R"doc(Read a Mitsuba XML file and return a list of pairs containing the name
 of the plugin and the corresponding populated Properties object)doc";
 
+static const char *__doc_mitsuba_xml_invalidate_reload =
+R"doc(Exclude an object from being reused by the reload mode of
+load_file()
+
+Should be called when the application changes the parameters of an
+object, so that the next reload of its scene file instantiates it
+again instead of carrying the change over. This is done by
+``SceneParameters.update()`` for all updated objects.)doc";
+
 static const char *__doc_mitsuba_xml_load_file =
 R"doc(Load a Mitsuba scene from an XML file
 
@@ -12598,10 +14786,49 @@ Parameter ``update_scene``:
 
 Parameter ``parallel``:
     Whether the loading should be executed on multiple threads in
-    parallel)doc";
+    parallel
+
+Parameter ``cache_dir``:
+    Optional directory of a cache of parsed scene descriptions. A cached
+    description is keyed by the file name, variant and parameters, and
+    is used as long as the scene file and the files it includes are
+    unchanged. It skips the XML parsing, but the objects are still
+    instantiated.
+
+Parameter ``reload``:
+    Reuse the objects of the previous load of this file in reload mode
+    whose description and referenced files are unchanged, and only
+    instantiate the changed objects and the objects that depend on
+    them. Shapes whose BSDF changed are reused with the new BSDF.
+    Objects whose parameters were changed by the application (see
+    invalidate_reload()) are instantiated again. The scene itself is
+    always created again, and the other objects of the last load of
+    every file in this mode are kept alive for this purpose.)doc";
 
 static const char *__doc_mitsuba_xml_load_string = R"doc(Load a Mitsuba scene from an XML string)doc";
 
+static const char *__doc_mitsuba_xml_set_instantiation_report =
+R"doc(Write the instantiation times of subsequently loaded XML scenes
+to a CSV file
+
+Every load measures the time taken by the instantiation of each object,
+the thread instantiating it, and the time it waited for its dependencies,
+and logs the 20 slowest objects. When a path is specified, every load
+additionally writes (overwrites) a CSV file listing all objects sorted by
+their instantiation time. An empty path disables the report.)doc";
+
+static const char *__doc_mitsuba_xml_set_streaming_threshold =
+R"doc(Set the size (in bytes) above which XML files are parsed in streaming
+mode
+
+The regular parser holds the text and the DOM of the entire document
+in memory. In streaming mode, the elements nested in the root element
+of the file are instead parsed and converted one at a time, which
+keeps the memory usage of large files (e.g. with millions of
+instances) bounded. Files that are upgraded and written back to disk,
+or that use version 1 of the format, are always parsed as a whole. The
+default is 64 MiB.)doc";
+
 static const char *__doc_mitsuba_xyz_to_srgb = R"doc(Convert XYZ tristimulus values to ITU-R Rec. BT.709 linear RGB)doc";
 
 static const char *__doc_operator_lshift = R"doc(Turns a vector of elements into a human-readable representation)doc";
@@ -85,6 +85,10 @@ enum class BSDFFlags : uint32_t {
     /// Does the implementation require access to texture-space differentials
     NeedsDifferentials   = 0x20000,
 
+    /// The BSDF does not polarize light: in polarized variants, all of its
+    /// Mueller matrices are depolarizers (and no basis rotation is needed)
+    Depolarizing         = 0x40000,
+
     // =============================================================
     //!                 Compound lobe attributes
     // =============================================================
@@ -425,11 +429,14 @@ public:
      * solid angle of sampling the given direction \c wo and importance sample
      * the BSDF model.
      *
-     * This is simply a wrapper around two separate function calls to eval_pdf()
-     * and sample(). The function exists to perform a smaller number of virtual
-     * function calls, which has some performance benefits on highly vectorized
-     * JIT variants of the renderer. (A ~20% performance improvement for the
-     * basic path tracer on CUDA)
+     * The default implementation is simply a wrapper around two separate
+     * function calls to eval_pdf() and sample(). The function exists to
+     * perform a smaller number of virtual function calls, which has some
+     * performance benefits on highly vectorized JIT variants of the renderer.
+     * (A ~20% performance improvement for the basic path tracer on CUDA)
+     * BSDFs with an expensive setup (texture lookups, construction of
+     * microfacet distributions, etc.) override it to perform this work only
+     * once for both queries.
      *
      * \param ctx
      *     A context data structure describing which lobes to evaluate,
@@ -561,6 +568,22 @@ public:
         return has_flag(m_flags, BSDFFlags::NeedsDifferentials);
     }
 
+    /**
+     * \brief Return the \ref RayFlags of the surface interaction fields
+     * read by this BSDF (excluding its nested textures and BSDFs)
+     *
+     * The default implementation requests the shading frame, along with the
+     * UV parameterization of anisotropic BSDFs (which are oriented along
+     * the position partials) and of BSDFs needing texture differentials.
+     */
+    virtual uint32_t ray_flags() const {
+        uint32_t flags = +RayFlags::ShadingFrame;
+        if (has_flag(m_flags, BSDFFlags::Anisotropic) ||
+            has_flag(m_flags, BSDFFlags::NeedsDifferentials))
+            flags |= RayFlags::UV | RayFlags::dPdUV;
+        return flags;
+    }
+
     /// Number of components this BSDF is comprised of.
     size_t component_count(Mask /*active*/ = true) const {
         return m_components.size();
@@ -636,7 +659,7 @@ std::ostream &operator<<(std::ostream &os, const BSDFSample3<Float, Spectrum>& b
 template <typename Float, typename Spectrum>
 typename SurfaceInteraction<Float, Spectrum>::BSDFPtr SurfaceInteraction<Float, Spectrum>::bsdf(
     const typename SurfaceInteraction<Float, Spectrum>::RayDifferential3f &ray) {
-    const BSDFPtr bsdf = shape->bsdf();
+    const BSDFPtr bsdf = this->bsdf();
 
     if (!has_uv_partials() && dr::any(bsdf->needs_differentials()))
         compute_uv_partials(ray);
@@ -0,0 +1,332 @@
+#pragma once
+
+#include <mitsuba/core/bbox.h>
+#include <mitsuba/core/fwd.h>
+#include <mitsuba/core/logger.h>
+#include <mitsuba/core/memory.h>
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/core/vector.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/mesh.h>
+#include <vector>
+
+/// Compile-time BVH depth limit to enable traversal with stack memory
+#define MI_BVH_MAXDEPTH 64u
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Wide bounding volume hierarchy over a set of shapes
+ *
+ * This class is an alternative to \ref ShapeKDTree for builds without Embree.
+ * It is constructed using a binned surface area heuristic, after which the
+ * resulting binary hierarchy is collapsed into nodes with 4 or 8 children.
+ * The bounds of the children of a node are stored in a structure-of-arrays
+ * layout, so that a single ray is tested against all of them at once using
+ * SIMD instructions (SSE/AVX/NEON, depending on the target).
+ *
+ * Compared to the kd-tree, the construction is considerably faster, while
+ * the traversal performance is similar or better in most scenes. Like the
+ * kd-tree, the hierarchy is only traversed by one ray at a time.
+ */
+template <typename Float, typename Spectrum>
+class MI_EXPORT_LIB ShapeBVH : public Object {
+public:
+    MI_IMPORT_TYPES(Shape, Mesh)
+
+    using ScalarRay3f = Ray<ScalarPoint3f, Spectrum>;
+    using Index = uint32_t;
+
+    /**
+     * \brief BVH node with \c Width children
+     *
+     * Unused child slots have empty bounds, which are never intersected.
+     * A child with a nonzero primitive count is a leaf.
+     */
+    template <size_t Width> struct Node {
+        using FloatP = dr::Array<ScalarFloat, Width>;
+
+        /// Bounds of the children (structure-of-arrays layout)
+        FloatP min_x, min_y, min_z, max_x, max_y, max_z;
+
+        /// Index of an inner child node, or primitive offset of a leaf
+        Index child[Width];
+
+        /// Number of primitives of a leaf child (zero for inner nodes)
+        Index count[Width];
+    };
+
+    /**
+     * \brief Create an empty BVH and take build-related parameters from
+     * \c props.
+     *
+     * \param width
+     *     Number of children per node (4 or 8)
+     */
+    ShapeBVH(const Properties &props, uint32_t width);
+
+    /// Clear the BVH (build-related parameters remain)
+    void clear();
+
+    /// Register a new shape with the BVH (to be called before \ref build())
+    void add_shape(Shape *shape);
+
+    /// Build the BVH
+    void build();
+
+    /// Return the number of children per node
+    uint32_t width() const { return m_width; }
+
+    /// Return the number of registered shapes
+    Index shape_count() const { return Index(m_shapes.size()); }
+
+    /// Return the number of registered primitives
+    Index primitive_count() const { return m_primitive_map.back(); }
+
+    /// Return the i-th shape
+    const Shape *shape(size_t i) const { Assert(i < m_shapes.size()); return m_shapes[i]; }
+
+    /// Return the bounding box of the entire hierarchy
+    const ScalarBoundingBox3f &bbox() const { return m_bbox; }
+
+    template <bool ShadowRay>
+    MI_INLINE PreliminaryIntersection3f ray_intersect_preliminary(const Ray3f &ray,
+                                                                   Mask active) const {
+        DRJIT_MARK_USED(active);
+        if constexpr (!dr::is_array_v<Float>)
+            return ray_intersect_scalar<ShadowRay>(ray);
+        else
+            Throw("BVH should only be used in scalar mode");
+    }
+
+    template <bool ShadowRay>
+    MI_INLINE PreliminaryIntersection<ScalarFloat, Shape>
+    ray_intersect_scalar(const ScalarRay3f &ray) const {
+        if (m_width == 8)
+            return traverse<8, ShadowRay>(ray, m_nodes_8);
+        else
+            return traverse<4, ShadowRay>(ray, m_nodes_4);
+    }
+
+    /// Brute force intersection routine for debugging purposes
+    template <bool ShadowRay>
+    MI_INLINE PreliminaryIntersection3f
+    ray_intersect_naive(Ray3f ray, Mask active) const {
+        DRJIT_MARK_USED(active);
+        if constexpr (!dr::is_array_v<Float>) {
+            PreliminaryIntersection3f pi = dr::zeros<PreliminaryIntersection3f>();
+            ScopedRayStatistics stats;
+
+            for (Index i = 0; i < primitive_count(); ++i) {
+                stats.add(RayStatistic::PrimitiveTests);
+                PreliminaryIntersection3f prim_pi =
+                    intersect_prim<ShadowRay>(i, ray);
+
+                if (prim_pi.is_valid()) {
+                    if constexpr (ShadowRay)
+                        return prim_pi;
+                    pi = prim_pi;
+                    ray.maxt = prim_pi.t;
+                }
+            }
+
+            return pi;
+        } else {
+            Throw("BVH should only be used in scalar mode");
+        }
+    }
+
+    /// Return a human-readable string representation of the scene contents.
+    virtual std::string to_string() const override;
+
+    MI_DECLARE_CLASS()
+protected:
+    /// Ray traversal of a BVH with \c Width children per node
+    template <size_t Width, bool ShadowRay>
+    MI_INLINE PreliminaryIntersection<ScalarFloat, Shape>
+    traverse(ScalarRay3f ray, const std::vector<Node<Width>> &nodes) const {
+        using FloatP = dr::Array<ScalarFloat, Width>;
+
+        /// Ray traversal stack entry
+        struct StackEntry {
+            // Ray distance to the node's bounding box
+            ScalarFloat t;
+            // Index of the node
+            Index node;
+        };
+
+        // Resulting intersection struct
+        PreliminaryIntersection<ScalarFloat, Shape> pi;
+
+        if (unlikely(nodes.empty()))
+            return pi;
+
+        // Traversal statistics (no-op unless MI_ENABLE_RAY_STATISTICS is set)
+        ScopedRayStatistics stats;
+
+        // Allocate the node stack
+        StackEntry stack[MI_BVH_MAXDEPTH * (Width - 1) + 1];
+        int32_t stack_index = 0;
+
+        /* Precompute the slab test, selecting the near and far planes based
+           on the sign of the ray direction */
+        ScalarVector3f d_rcp = dr::rcp(ray.d);
+        bool neg_x = d_rcp.x() < 0.f,
+             neg_y = d_rcp.y() < 0.f,
+             neg_z = d_rcp.z() < 0.f;
+
+        FloatP d_rcp_x(d_rcp.x()), d_rcp_y(d_rcp.y()), d_rcp_z(d_rcp.z()),
+               o_x(ray.o.x()), o_y(ray.o.y()), o_z(ray.o.z());
+
+        Index node_index = 0;
+        while (true) {
+            const Node<Width> &node = nodes[node_index];
+            stats.add(RayStatistic::TraversedNodes);
+
+            // Intersect the ray against the bounds of all children at once
+            FloatP t_near_x = ((neg_x ? node.max_x : node.min_x) - o_x) * d_rcp_x,
+                   t_near_y = ((neg_y ? node.max_y : node.min_y) - o_y) * d_rcp_y,
+                   t_near_z = ((neg_z ? node.max_z : node.min_z) - o_z) * d_rcp_z,
+                   t_far_x  = ((neg_x ? node.min_x : node.max_x) - o_x) * d_rcp_x,
+                   t_far_y  = ((neg_y ? node.min_y : node.max_y) - o_y) * d_rcp_y,
+                   t_far_z  = ((neg_z ? node.min_z : node.max_z) - o_z) * d_rcp_z;
+
+            FloatP t_near = dr::maximum(dr::maximum(t_near_x, t_near_y),
+                                        dr::maximum(t_near_z, FloatP(0.f))),
+                   t_far  = dr::minimum(dr::minimum(t_far_x, t_far_y), t_far_z);
+
+            // Conservative far distance to account for rounding errors (Ize 2013)
+            t_far = dr::minimum(t_far * (1.f + 4.f * dr::Epsilon<ScalarFloat>),
+                                FloatP(ray.maxt));
+
+            auto hit = t_near <= t_far;
+
+            // Intersect leaves right away, and sort inner nodes by distance
+            StackEntry inner[Width];
+            uint32_t inner_count = 0;
+
+            if (dr::any(hit)) {
+                for (size_t i = 0; i < Width; ++i) {
+                    if (!hit.entry(i))
+                        continue;
+
+                    Index count = node.count[i];
+                    if (count == 0) {
+                        StackEntry entry { t_near.entry(i), node.child[i] };
+                        uint32_t j = inner_count++;
+                        while (j > 0 && inner[j - 1].t < entry.t) {
+                            inner[j] = inner[j - 1];
+                            --j;
+                        }
+                        inner[j] = entry;
+                        continue;
+                    }
+
+                    if (t_near.entry(i) > ray.maxt)
+                        continue;
+
+                    Index prim_start = node.child[i];
+                    for (Index k = prim_start; k < prim_start + count; ++k) {
+                        stats.add(RayStatistic::PrimitiveTests);
+                        PreliminaryIntersection<ScalarFloat, Shape> prim_pi =
+                            intersect_prim<ShadowRay>(k, ray);
+
+                        if (unlikely(prim_pi.is_valid())) {
+                            if constexpr (ShadowRay)
+                                return prim_pi;
+
+                            Assert(prim_pi.t >= 0.f && prim_pi.t <= ray.maxt);
+                            pi = prim_pi;
+                            ray.maxt = pi.t;
+                        }
+                    }
+                }
+            }
+
+            // Postpone the farther nodes, visit the closest one next
+            for (uint32_t i = 0; i < inner_count; ++i) {
+                Assert(stack_index < (int32_t) (MI_BVH_MAXDEPTH * (Width - 1) + 1));
+                stack[stack_index++] = inner[i];
+            }
+
+            // Fetch the next node that is not occluded by the current hit
+            bool found = false;
+            while (stack_index > 0) {
+                const StackEntry &entry = stack[--stack_index];
+                if (entry.t <= ray.maxt) {
+                    node_index = entry.node;
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found)
+                break;
+        }
+
+        return pi;
+    }
+
+    /**
+     * \brief Check whether a primitive is intersected by the given ray.
+     *
+     * The primitive is specified by its index in the (reordered) primitive
+     * list of the BVH.
+     */
+    template <bool ShadowRay = false>
+    MI_INLINE PreliminaryIntersection<ScalarFloat, Shape>
+    intersect_prim(Index index, const ScalarRay3f &ray) const {
+        Index shape_index  = m_prim_shape[index],
+              prim_index   = m_prim_index[index];
+        const Shape *shape = m_shapes[shape_index];
+        const Mesh *mesh   = (const Mesh *) shape;
+
+        PreliminaryIntersection<ScalarFloat, Shape> pi;
+
+        if constexpr (ShadowRay) {
+            bool hit;
+            if (shape->is_mesh())
+                hit = mesh->ray_intersect_triangle_scalar(prim_index, ray).first != dr::Infinity<ScalarFloat>;
+            else
+                hit = shape->ray_test_scalar(ray, prim_index);
+            pi.t = dr::select(hit, 0.f, pi.t);
+        } else {
+            uint32_t inst_index = (uint32_t) -1;
+            if (shape->is_mesh())
+                std::tie(pi.t, pi.prim_uv) = mesh->ray_intersect_triangle_scalar(prim_index, ray);
+            else
+                std::tie(pi.t, pi.prim_uv, inst_index, prim_index) =
+                    shape->ray_intersect_preliminary_scalar(ray, prim_index);
+            pi.prim_index = prim_index;
+
+            bool hit_inst  = (inst_index != (uint32_t) -1);
+            pi.shape       = hit_inst ? (const Shape *) (size_t) shape_index : shape; // shape_index for LLVM + BVH
+            pi.instance    = hit_inst ? shape : nullptr;
+            pi.shape_index = hit_inst ? inst_index : shape_index;
+        }
+
+        return pi;
+    }
+
+protected:
+    uint32_t m_width;
+    Index m_max_leaf_size;
+    ScalarFloat m_traversal_cost;
+    ScalarFloat m_intersection_cost;
+    ScalarBoundingBox3f m_bbox;
+
+    std::vector<ref<Shape>> m_shapes;
+    std::vector<Index> m_primitive_map;
+
+    /// Shape and primitive index of every entry of the reordered primitive list
+    std::vector<Index> m_prim_shape, m_prim_index;
+
+    std::vector<Node<4>> m_nodes_4;
+    std::vector<Node<8>> m_nodes_8;
+    MemoryAllocation m_memory { MemoryCategory::KDTree };
+};
+
+MI_EXTERN_CLASS(ShapeBVH)
+NAMESPACE_END(mitsuba)
@@ -74,12 +74,84 @@ public:
 
     void parameters_changed(const std::vector<std::string> &keys = {}) override;
 
-    /// Return whether the emitter parameters have changed
+    /**
+     * \brief Return whether the emitter parameters have changed in a way that
+     * affects the scene's emitter sampling distributions
+     *
+     * This is the case for all parameter updates except those that only
+     * modify the emitted radiance (e.g. \c radiance, \c intensity, or
+     * \c data), see \ref parameters_changed().
+     */
     bool dirty() const { return m_dirty; }
 
     /// Modify the emitter's "dirty" flag
     void set_dirty(bool dirty) { m_dirty = dirty; }
 
+    /// Return the index of this emitter in the scene's list of emitters
+    uint32_t scene_index() const { return m_scene_index; }
+
+    /// Set the index of this emitter in the scene's list of emitters
+    void set_scene_index(uint32_t index) { m_scene_index = index; }
+
+    // =============================================================
+    //! @{ \name Learned sampling distributions
+    // =============================================================
+
+    /**
+     * \brief Return the number of samples per pixel of the training pass
+     * that the emitter requests before the next render job, or zero if it
+     * doesn't need one (the default)
+     *
+     * Emitters that learn their sampling distribution from the visibility of
+     * their samples request a training pass, during which (see \ref
+     * set_training()) the scene reports the result of every visibility test
+     * of their direction samples via \ref record_visibility(). This is
+     * currently only supported for the environment emitter of a scene.
+     */
+    virtual uint32_t training_spp() const { return 0; }
+
+    /**
+     * \brief Start or stop a training pass
+     *
+     * Stopping a training pass updates the learned sampling distribution.
+     */
+    virtual void set_training(bool training) { m_training = training; }
+
+    /// Is a training pass in progress?
+    bool training() const { return m_training; }
+
+    /**
+     * \brief Record the visibility of a direction sample during a training
+     * pass
+     *
+     * \param it
+     *     The reference point passed to \ref sample_direction().
+     *
+     * \param ds
+     *     The direction sample generated by \ref sample_direction().
+     *
+     * \param weight
+     *     The sampling weight of the direction sample, i.e. the emitted
+     *     radiance divided by the sampling density.
+     *
+     * \param visible
+     *     Whether the sampled point is visible from the reference point.
+     */
+    virtual void record_visibility(const Interaction3f &it,
+                                   const DirectionSample3f &ds,
+                                   const Spectrum &weight,
+                                   const Mask &visible,
+                                   Mask active = true) const {
+        DRJIT_MARK_USED(it);
+        DRJIT_MARK_USED(ds);
+        DRJIT_MARK_USED(weight);
+        DRJIT_MARK_USED(visible);
+        DRJIT_MARK_USED(active);
+    }
+
+    //! @}
+    // =============================================================
+
     MI_DECLARE_CLASS()
 
 protected:
@@ -92,8 +164,14 @@ protected:
     /// Sampling weight
     ScalarFloat m_sampling_weight;
 
-    /// True if the emitters's parameters have changed
+    /// True if the emitters's sampling weight or placement have changed
     bool m_dirty = false;
+
+    /// Index of this emitter in the scene's list of emitters
+    uint32_t m_scene_index = 0;
+
+    /// Is a training pass in progress? (see \ref set_training())
+    bool m_training = false;
 };
 
 MI_EXTERN_CLASS(Emitter)
@@ -110,6 +188,7 @@ DRJIT_CALL_TEMPLATE_BEGIN(mitsuba::Emitter)
     DRJIT_CALL_METHOD(eval_direction)
     DRJIT_CALL_METHOD(sample_position)
     DRJIT_CALL_METHOD(pdf_position)
+    DRJIT_CALL_METHOD(pdf_ray_direction)
     DRJIT_CALL_METHOD(eval)
     DRJIT_CALL_METHOD(sample_wavelengths)
     DRJIT_CALL_GETTER(is_environment)
@@ -117,6 +196,7 @@ DRJIT_CALL_TEMPLATE_BEGIN(mitsuba::Emitter)
     DRJIT_CALL_GETTER(shape)
     DRJIT_CALL_GETTER(medium)
     DRJIT_CALL_GETTER(sampling_weight)
+    DRJIT_CALL_GETTER(scene_index)
 DRJIT_CALL_END(mitsuba::Emitter)
 
 //! @}
@@ -290,6 +290,33 @@ public:
     virtual Float pdf_position(const PositionSample3f &ps,
                                Mask active = true) const;
 
+    /**
+     * \brief Evaluate the directional density of the ray sampling method
+     * implemented by \ref sample_ray().
+     *
+     * Given the origin of a ray generated by \ref sample_ray(), this function
+     * returns the density of its direction with respect to solid angles,
+     * conditioned on the origin. Multiplied by \ref pdf_position(), this
+     * yields the density of the ray itself, which bidirectional techniques
+     * need to weight the subpaths that start at the endpoint.
+     *
+     * The default implementation throws an exception.
+     *
+     * \param ps
+     *    The origin of the ray (only the world space position and normal
+     *    are used).
+     *
+     * \param d
+     *    The world space direction of the ray.
+     *
+     * \return
+     *    The corresponding sampling density, which is zero for directions
+     *    that \ref sample_ray() never generates.
+     */
+    virtual Float pdf_ray_direction(const PositionSample3f &ps,
+                                    const Vector3f &d,
+                                    Mask active = true) const;
+
     // =============================================================
     //! @{ \name Other query functions
     // =============================================================
@@ -318,6 +345,17 @@ public:
         return m_to_world.value();
     }
 
+    /**
+     * \brief Set the local space to world space transformation
+     *
+     * This function also notifies the endpoint via \ref parameters_changed()
+     * so that it can update any data that depends on the transformation.
+     */
+    void set_world_transform(const Transform4f &to_world) {
+        m_to_world = to_world;
+        parameters_changed({ "to_world" });
+    }
+
     /**
      * \brief Does the method \ref sample_ray() require a uniformly distributed
      * 2D sample for the \c sample2 parameter?
@@ -66,21 +66,104 @@ public:
     /// Merge an image block into the film. This methods should be thread-safe.
     virtual void put_block(const ImageBlock *block) = 0;
 
+    /**
+     * \brief Merge an image block produced by a tiled rendering loop into
+     * the film
+     *
+     * The caller guarantees that the interiors of all blocks that are merged
+     * concurrently don't overlap, and that they all use the same border size
+     * (see \ref ImageBlock::put_tile()). The film can then accumulate most
+     * of the block without any synchronization. The default implementation
+     * calls \ref put_block().
+     */
+    virtual void put_tile(const ImageBlock *block);
+
     /// Clear the film contents to zero.
     virtual void clear() = 0;
 
     /// Return a image buffer object storing the developed image
     virtual TensorXf develop(bool raw = false) const = 0;
 
+    /**
+     * \brief Develop a rectangular region of the film
+     *
+     * The region is specified relative to the crop window and must lie
+     * within it. The default implementation throws an exception.
+     */
+    virtual TensorXf develop_region(const ScalarPoint2u &offset,
+                                    const ScalarVector2u &size,
+                                    bool raw = false) const;
+
+    /**
+     * \brief Develop the regions of the film that changed since the last call
+     *
+     * This is useful for progressive previews, which can then update only the
+     * parts of the image that received samples. Returns pairs of offsets
+     * (relative to the crop window) and developed images. The default
+     * implementation treats the entire film as changed and returns the output
+     * of \ref develop().
+     */
+    virtual std::vector<std::pair<ScalarPoint2u, TensorXf>> develop_dirty();
+
     /// Return a bitmap object storing the developed contents of the film
     virtual ref<Bitmap> bitmap(bool raw = false) const = 0;
 
     /// Write the developed contents of the film to a file on disk
     virtual void write(const fs::path &path) const = 0;
 
+    /**
+     * \brief Equivalent to \ref write(), but encodes and writes the image in
+     * the background
+     *
+     * The film is still developed right away, hence its storage can be reused
+     * by the next render job, while the file is written via \ref
+     * Bitmap::write_async(). The default implementation calls \ref write().
+     */
+    virtual void write_async(const fs::path &path) const;
+
     /// dr::schedule() variables that represent the internal film storage
     virtual void schedule_storage() = 0;
 
+    /**
+     * \brief Serialize the (undeveloped) internal film storage to a binary
+     * stream, e.g. to checkpoint a long-running render job.
+     *
+     * The default implementation throws an exception.
+     */
+    virtual void write_storage(Stream *stream) const;
+
+    /**
+     * \brief Restore the internal film storage from a binary stream created
+     * by \ref write_storage(). Must be called after \ref prepare().
+     *
+     * When \c accumulate is set to \c true, the stored contents are added to
+     * the current film storage, e.g. to merge the partial results of a render
+     * job that was distributed over several processes.
+     *
+     * The default implementation throws an exception.
+     */
+    virtual void read_storage(Stream *stream, bool accumulate = false);
+
+    /**
+     * \brief Does this film write its contents to disk while rendering?
+     *
+     * Streaming films only keep a sliding window of rows in memory, and their
+     * contents cannot be developed as a whole. Integrators must then render
+     * the image from top to bottom and call \ref flush_rows() as they go.
+     */
+    virtual bool streaming() const;
+
+    /**
+     * \brief Notify a streaming film that all samples in the rows above \c y
+     * (relative to the crop window) have been added
+     *
+     * Rows that cannot receive further contributions (taking the
+     * reconstruction filter into account) are then developed and written to
+     * disk. A value of \c y that is at least the crop height completes the
+     * output. The default implementation does nothing.
+     */
+    virtual void flush_rows(uint32_t y);
+
     /**
       * \brief Prepare spectrum samples to be in the format expected by the film
       *
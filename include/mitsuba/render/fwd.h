@@ -7,8 +7,10 @@
 NAMESPACE_BEGIN(mitsuba)
 
 struct BSDFContext;
+enum class BlockOrder : uint32_t;
 template <typename Float, typename Spectrum> class BSDF;
 template <typename Float, typename Spectrum> class OptixDenoiser;
+template <typename Float, typename Spectrum> class OIDNDenoiser;
 template <typename Float, typename Spectrum> class Emitter;
 template <typename Float, typename Spectrum> class Endpoint;
 template <typename Float, typename Spectrum> class Film;
@@ -29,6 +31,8 @@ template <typename Float, typename Spectrum> class ProjectiveCamera;
 template <typename Float, typename Spectrum> class Shape;
 template <typename Float, typename Spectrum> class ShapeGroup;
 template <typename Float, typename Spectrum> class ShapeKDTree;
+template <typename Float, typename Spectrum> class ShapeBVH;
+template <typename Float, typename Spectrum> class LightBVH;
 template <typename Float, typename Spectrum> class Texture;
 template <typename Float, typename Spectrum> class Volume;
 template <typename Float, typename Spectrum> class VolumeGrid;
@@ -77,6 +81,8 @@ template <typename Float_, typename Spectrum_> struct RenderAliases {
     using Shape                  = mitsuba::Shape<FloatU, SpectrumU>;
     using ShapeGroup             = mitsuba::ShapeGroup<FloatU, SpectrumU>;
     using ShapeKDTree            = mitsuba::ShapeKDTree<FloatU, SpectrumU>;
+    using ShapeBVH               = mitsuba::ShapeBVH<FloatU, SpectrumU>;
+    using LightBVH               = mitsuba::LightBVH<FloatU, SpectrumU>;
     using Mesh                   = mitsuba::Mesh<FloatU, SpectrumU>;
     using Integrator             = mitsuba::Integrator<FloatU, SpectrumU>;
     using SamplingIntegrator     = mitsuba::SamplingIntegrator<FloatU, SpectrumU>;
@@ -84,6 +90,7 @@ template <typename Float_, typename Spectrum_> struct RenderAliases {
     using AdjointIntegrator      = mitsuba::AdjointIntegrator<FloatU, SpectrumU>;
     using BSDF                   = mitsuba::BSDF<FloatU, SpectrumU>;
     using OptixDenoiser          = mitsuba::OptixDenoiser<FloatU, SpectrumU>;
+    using OIDNDenoiser           = mitsuba::OIDNDenoiser<FloatU, SpectrumU>;
     using Sensor                 = mitsuba::Sensor<FloatU, SpectrumU>;
     using ProjectiveCamera       = mitsuba::ProjectiveCamera<FloatU, SpectrumU>;
     using Emitter                = mitsuba::Emitter<FloatU, SpectrumU>;
@@ -166,6 +173,8 @@ template <typename Float_, typename Spectrum_> struct RenderAliases {
     using MicrofacetDistribution = typename RenderAliases::MicrofacetDistribution;                 \
     using Shape                  = typename RenderAliases::Shape;                                  \
     using ShapeKDTree            = typename RenderAliases::ShapeKDTree;                            \
+    using ShapeBVH               = typename RenderAliases::ShapeBVH;                               \
+    using LightBVH               = typename RenderAliases::LightBVH;                               \
     using Mesh                   = typename RenderAliases::Mesh;                                   \
     using Integrator             = typename RenderAliases::Integrator;                             \
     using SamplingIntegrator     = typename RenderAliases::SamplingIntegrator;                     \
@@ -173,6 +182,7 @@ template <typename Float_, typename Spectrum_> struct RenderAliases {
     using AdjointIntegrator      = typename RenderAliases::AdjointIntegrator;                      \
     using BSDF                   = typename RenderAliases::BSDF;                                   \
     using OptixDenoiser          = typename RenderAliases::OptixDenoiser;                          \
+    using OIDNDenoiser           = typename RenderAliases::OIDNDenoiser;                           \
     using Sensor                 = typename RenderAliases::Sensor;                                 \
     using ProjectiveCamera       = typename RenderAliases::ProjectiveCamera;                       \
     using Emitter                = typename RenderAliases::Emitter;                                \
@@ -2,11 +2,13 @@
 
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/logger.h>
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/object.h>
 #include <mitsuba/core/vector.h>
 #include <mitsuba/render/fwd.h>
 #include <drjit/dynamic.h>
 #include <drjit/tensor.h>
+#include <mutex>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -161,6 +163,25 @@ public:
     /// Accumulate another image block into this one
     void put_block(const ImageBlock *block);
 
+    /**
+     * \brief Accumulate another image block into this one, concurrently with
+     * other calls of this function
+     *
+     * The caller must guarantee that the interiors (i.e. the regions without
+     * the border) of the blocks that are merged at the same time don't
+     * overlap, and that all of them have the same border size. The pixels
+     * that only the interior of \c block can reach are then accumulated
+     * without any synchronization. The remaining ones, i.e. those within twice
+     * the border size of the edges of the interior, are protected by the lock
+     * of their row.
+     *
+     * \param row_locks
+     *     One mutex per row of this image block (including its border)
+     *
+     * This function is only supported in scalar variants.
+     */
+    void put_tile(const ImageBlock *block, std::mutex *row_locks);
+
     /**
      * \brief Accumulate a single sample or a wavefront of samples into the
      * image block.
@@ -248,6 +269,28 @@ public:
     /// Clear the image block contents to zero.
     void clear();
 
+    /**
+     * \brief Serialize the contents of the image block to a binary stream
+     *
+     * This includes the error compensation state (if enabled), which makes it
+     * possible to resume an interrupted accumulation exactly.
+     */
+    void write(Stream *stream) const;
+
+    /**
+     * \brief Restore the contents of the image block from a binary stream
+     * created by \ref write().
+     *
+     * The size, border, and channel count stored in the stream must match the
+     * configuration of this image block.
+     *
+     * \param accumulate
+     *     If set to \c true, the stored values are added to the current
+     *     contents of the image block instead of replacing them. This is
+     *     useful to merge the results of separate render jobs.
+     */
+    void read(Stream *stream, bool accumulate = false);
+
     // =============================================================
     //! @{ \name Accessors
     // =============================================================
@@ -304,6 +347,27 @@ public:
     /// Use Kahan-style error-compensated floating point accumulation?
     bool compensate() const { return m_compensate; }
 
+    /**
+     * \brief Accumulate into several partial images in LLVM variants
+     *
+     * Particle tracers splat their samples at random positions of the image
+     * block, which turns into atomic additions that contend across the worker
+     * threads of the LLVM backend. With <tt>count > 1</tt>, \ref put() instead
+     * maps contiguous ranges of the wavefront (and hence, of the work
+     * processed by a thread) to separate copies of the image tensor, which are
+     * summed up when the block contents are accessed (e.g. via \ref tensor()).
+     *
+     * A count of zero selects one partial image per CPU core. The count is
+     * reduced so that the partial images occupy at most \c memory_limit
+     * bytes. This setting has no effect in other variants and when
+     * error-compensated accumulation is enabled.
+     */
+    void set_partial_images(uint32_t count,
+                            size_t memory_limit = 256ull * 1024 * 1024);
+
+    /// Return the number of partial images that is currently in use
+    uint32_t partial_images() const { return m_partial_count; }
+
     /// Return the number of channels stored by the image block
     uint32_t channel_count() const { return m_channel_count; }
 
@@ -333,6 +397,15 @@ protected:
     // Implementation detail to atomically accumulate a value into the image block
     void accum(Float value, UInt32 index, Bool active);
 
+    /// Update the tracked size of the image storage (see \ref MemoryTracker)
+    void update_memory_usage();
+
+    /// (Re-)allocate the partial images following a change of the block size
+    void allocate_partial_images();
+
+    /// Sum the pending contents of the partial images into \ref m_tensor
+    void flush_partial_images() const;
+
 protected:
     ScalarPoint2i m_offset;
     ScalarVector2u m_size;
@@ -340,12 +413,18 @@ protected:
     uint32_t m_border_size;
     TensorXf m_tensor;
     mutable TensorXf m_tensor_compensation;
+    mutable typename TensorXf::Array m_tensor_partial;
+    mutable bool m_partial_dirty = false;
+    uint32_t m_partial_count = 1;
+    uint32_t m_partial_request = 1;
+    size_t m_partial_limit = 0;
     ref<const ReconstructionFilter> m_rfilter;
     bool m_normalize;
     bool m_coalesce;
     bool m_compensate;
     bool m_warn_negative;
     bool m_warn_invalid;
+    MemoryAllocation m_memory { MemoryCategory::ImageBlock };
 };
 
 MI_EXTERN_CLASS(ImageBlock)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mitsuba/core/atomic.h>
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/object.h>
 #include <mitsuba/core/properties.h>
@@ -14,9 +15,183 @@
 #include <mitsuba/render/scene.h>
 #include <mitsuba/render/shape.h>
 #include <mitsuba/render/medium.h>
+#include <atomic>
 
 NAMESPACE_BEGIN(mitsuba)
 
+/**
+ * \brief Attributes of the first surface intersection of a path, which
+ * integrators can write to their AOV buffer (see \ref
+ * MonteCarloIntegrator::set_primary_aovs())
+ */
+enum class PrimaryAOV : uint32_t {
+    Albedo,
+    Depth,
+    Position,
+    UV,
+    GeometricNormal,
+    ShadingNormal,
+    dPdU,
+    dPdV,
+    dUVdx,
+    dUVdy,
+    PrimIndex,
+    ShapeIndex
+};
+
+/// Number of channels of a primary AOV
+inline size_t primary_aov_channels(PrimaryAOV type) {
+    switch (type) {
+        case PrimaryAOV::Depth:
+        case PrimaryAOV::PrimIndex:
+        case PrimaryAOV::ShapeIndex:
+            return 1;
+        case PrimaryAOV::UV:
+        case PrimaryAOV::dUVdx:
+        case PrimaryAOV::dUVdy:
+            return 2;
+        default:
+            return 3;
+    }
+}
+
+/// Events counted by the render job statistics (see \ref RenderStatistics)
+enum class RenderCounter : uint32_t {
+    Samples = 0,                /* Samples taken by the render job */
+    Paths,                      /* Paths whose termination was recorded */
+    PathVertices,               /* Sum of the lengths of these paths */
+    Escaped,                    /* Paths that left the scene */
+    RussianRoulette,            /* Paths terminated by Russian roulette */
+    MaxDepth,                   /* Paths that reached the maximum depth */
+    Absorbed,                   /* Paths whose throughput dropped to zero */
+    ExtensionRays,              /* Rays traced to extend a path */
+    ShadowRays,                 /* Rays traced to test the visibility of emitter samples */
+
+    RenderCounterCount
+};
+
+/// Reasons for the termination of a path (see \ref RenderStatistics)
+enum class PathTermination : uint32_t {
+    Escaped = 0,
+    RussianRoulette,
+    MaxDepth,
+    Absorbed
+};
+
+/**
+ * \brief Statistics of a render job
+ *
+ * When enabled via \ref set_enabled(), SamplingIntegrator::render() and
+ * AdjointIntegrator::render() collect the statistics of their render job.
+ * The number of samples is counted by all sampling integrators and by the
+ * \c ptracer integrator, which (like the \c path integrator) additionally
+ * records the length and the termination cause of every path as well as the
+ * number of extension and shadow rays. The summary is logged at the end of the render job and
+ * available via Integrator::render_statistics().
+ *
+ * In scalar variants, the counters are local to every thread and merged at
+ * the end of the job, hence render jobs running concurrently in scalar
+ * variants share their counters. In JIT variants, every event adds an
+ * atomic operation to the rendering kernels.
+ */
+struct MI_EXPORT_LIB RenderStatistics {
+    /// Value of every \ref RenderCounter
+    uint64_t counters[(uint32_t) RenderCounter::RenderCounterCount] { };
+
+    /// Length of the longest path
+    uint32_t max_path_length = 0;
+
+    /// Duration of the render job in seconds
+    double time = 0.0;
+
+    /// Return the value of a counter
+    uint64_t counter(RenderCounter counter) const {
+        return counters[(uint32_t) counter];
+    }
+
+    /// Return the number of samples per second
+    double samples_per_second() const {
+        return time > 0.0 ? counter(RenderCounter::Samples) / time : 0.0;
+    }
+
+    /// Return the average length of the recorded paths
+    double average_path_length() const {
+        uint64_t paths = counter(RenderCounter::Paths);
+        return paths > 0 ? (double) counter(RenderCounter::PathVertices) / paths : 0.0;
+    }
+
+    /// Return the number of shadow rays per extension ray
+    double shadow_ray_ratio() const {
+        uint64_t rays = counter(RenderCounter::ExtensionRays);
+        return rays > 0 ? (double) counter(RenderCounter::ShadowRays) / rays : 0.0;
+    }
+
+    /// Return a human-readable summary
+    std::string to_string() const;
+
+    /// Enable or disable the collection of render statistics (off by default)
+    static void set_enabled(bool enabled);
+
+    /// Is the collection of render statistics enabled?
+    static bool enabled();
+};
+
+/**
+ * \brief Capture of the rays traced by render jobs, which can be replayed to
+ * benchmark the acceleration data structures (see
+ * :py:mod:`mitsuba.benchmark.replay`)
+ *
+ * While a capture is in progress (see \ref start()), every \c interval-th
+ * render job of SamplingIntegrator::render() and AdjointIntegrator::render()
+ * records the extension rays and shadow rays of the \c path integrator,
+ * along with their depth and whether they were traced as a coherent batch.
+ * At the end of the job, the rays are appended to the capture file.
+ *
+ * The file starts with the characters <tt>MRC</tt> and a version byte. It
+ * then contains one section per recorded render job, consisting of the index
+ * of the job (<tt>uint32_t</tt>) and the number of rays (<tt>uint64_t</tt>),
+ * followed by the rays as \ref Record entries.
+ *
+ * Like \ref RenderStatistics, rays are only captured by JIT variants when
+ * the render job evaluates its image. Capturing atomically appends every ray
+ * to a buffer, which slows down rendering.
+ */
+struct MI_EXPORT_LIB RayCapture {
+    /// Flags stored in the \ref Record::info field, along with the depth
+    enum : uint32_t {
+        DepthMask    = 0xFFFFu,
+        ShadowRay    = 1u << 30,
+        CoherentRay  = 1u << 31
+    };
+
+    /// A captured ray (32 bytes)
+    struct Record {
+        float o[3], d[3], maxt;
+        uint32_t info;
+    };
+
+    /**
+     * \brief Start capturing the rays of subsequent render jobs into the
+     * given file, which is truncated
+     *
+     * \param interval
+     *     Only every \c interval-th render job is recorded, starting with
+     *     the first one.
+     *
+     * \param max_rays
+     *     Maximum number of rays recorded per render job. Further rays are
+     *     dropped, and a warning is logged.
+     */
+    static void start(const fs::path &filename, uint32_t interval = 1,
+                      size_t max_rays = 1 << 22);
+
+    /// Stop capturing rays
+    static void stop();
+
+    /// Is a capture in progress?
+    static bool enabled();
+};
+
 /**
  * \brief Abstract integrator base class, which does not make any assumptions
  * with regards to how radiance is computed.
@@ -292,6 +467,52 @@ public:
     /// \brief Cancel a running render job (e.g. after receiving Ctrl-C)
     virtual void cancel();
 
+    /**
+     * \brief Periodically checkpoint the state of subsequent render jobs
+     *
+     * When a checkpoint path is specified, the integrator regularly writes
+     * the accumulated film storage along with the set of completed work
+     * units (blocks in scalar variants, passes in JIT variants) to \c path.
+     * A final checkpoint is also written when the render job is interrupted.
+     * The file is removed once the render job finishes.
+     *
+     * \param path
+     *     Checkpoint filename. An empty path disables checkpointing.
+     *
+     * \param interval
+     *     Time between checkpoints in seconds. If non-positive, a checkpoint
+     *     is only written when the render job is interrupted.
+     *
+     * \param resume
+     *     If set to \c true and the checkpoint file exists, the next render
+     *     job continues from it instead of starting from scratch. The render
+     *     job must have the same configuration as the interrupted one.
+     */
+    void set_checkpoint(const fs::path &path, float interval = -1.f,
+                        bool resume = false);
+
+    /**
+     * \brief Restrict subsequent render jobs to a subset of the work
+     *
+     * This makes it possible to distribute a single render job over several
+     * processes or machines: each process renders partition \c index out of
+     * \c count, stores the raw film contents via \ref Film::write_storage(),
+     * and the partial results are then accumulated using
+     * \ref Film::read_storage().
+     *
+     * Scalar variants interleave the image blocks between partitions, and the
+     * merged result is identical to that of a render job that is not
+     * partitioned. JIT variants interleave the sample passes instead (see
+     * \c samples_per_pass), each of which is seeded separately.
+     *
+     * \param index
+     *     Index of the partition that should be rendered.
+     *
+     * \param count
+     *     Total number of partitions. A value of 1 disables partitioning.
+     */
+    void set_partition(uint32_t index, uint32_t count);
+
     /**
      * Indicates whether \ref cancel() or a timeout have occurred. Should be
      * checked regularly in the integrator's main loop so that timeouts are
@@ -299,12 +520,42 @@ public:
      *
      * Note that accurate timeouts rely on \ref m_render_timer, which needs
      * to be reset at the beginning of the rendering phase.
+     *
+     * In progressive mode, this function only reports cancellation. Timeouts
+     * should then be checked via \ref budget_exhausted() at a granularity
+     * that preserves the normalization of the film.
      */
     bool should_stop() const {
-        return m_stop || (m_timeout > 0.f &&
-                          m_render_timer.value() > 1000.f * m_timeout);
+        return m_stop || (!m_progressive && budget_exhausted());
     }
 
+    /**
+     * Indicates whether the time budget specified via \ref m_timeout has been
+     * used up. In progressive mode, the timeout is only enforced between
+     * blocks and passes (see \ref should_stop()).
+     */
+    bool budget_exhausted() const {
+        return m_timeout > 0.f && m_render_timer.value() > 1000.f * m_timeout;
+    }
+
+    /**
+     * \brief Return the number of passes that have been fully accumulated
+     * into the film during the current (or last) render job.
+     *
+     * This function may be called from another thread to poll the
+     * progress of a progressive render job, in which case the film can be
+     * developed once the returned count increases.
+     */
+    uint32_t passes_completed() const { return m_passes_completed; }
+
+    /**
+     * \brief Return the statistics of the last render job
+     *
+     * They are only collected while \ref RenderStatistics::enabled() is set,
+     * and not when a JIT variant renders without evaluating the image.
+     */
+    const RenderStatistics &render_statistics() const { return m_render_stats; }
+
     /**
      * For integrators that return one or more arbitrary output variables
      * (AOVs), this function specifies a list of associated channel names. The
@@ -324,6 +575,49 @@ protected:
     /// Create an integrator
     Integrator(const Properties & props);
 
+    /// Start collecting the statistics of a render job (if enabled)
+    void statistics_begin(bool evaluate);
+
+    /**
+     * \brief Stop collecting the statistics of a render job and store them
+     * in \ref m_render_stats, logging a summary when \c log is set
+     */
+    void statistics_end(bool log);
+
+    /// Count an event for every active lane (see \ref RenderStatistics)
+    void record_event(RenderCounter counter, const Mask &active) const {
+        if (unlikely(m_collect_stats))
+            record_event_impl(counter, active);
+    }
+
+    /// Record the termination of the paths of the active lanes
+    void record_path(const UInt32 &length, PathTermination cause,
+                     const Mask &active) const {
+        if (unlikely(m_collect_stats))
+            record_path_impl(length, cause, active);
+    }
+
+    /// Start recording the rays of a render job (if a \ref RayCapture is in progress)
+    void capture_begin(bool evaluate);
+
+    /// Stop recording the rays of a render job and append them to the capture file
+    void capture_end();
+
+    /// Record the rays of the active lanes (see \ref RayCapture)
+    void record_ray(const Ray3f &ray, const UInt32 &depth, const Mask &coherent,
+                    bool shadow, const Mask &active) const {
+        if (unlikely(m_capture_rays))
+            record_ray_impl(ray, depth, coherent, shadow, active);
+    }
+
+private:
+    void record_event_impl(RenderCounter counter, const Mask &active) const;
+    void record_path_impl(const UInt32 &length, PathTermination cause,
+                          const Mask &active) const;
+    void record_ray_impl(const Ray3f &ray, const UInt32 &depth,
+                         const Mask &coherent, bool shadow,
+                         const Mask &active) const;
+
 protected:
     /// Integrators should stop all work when this flag is set to true.
     bool m_stop;
@@ -338,11 +632,62 @@ protected:
     /// Timer used to enforce the timeout.
     Timer m_render_timer;
 
+    /**
+     * \brief Render in open-ended progressive mode
+     *
+     * When set, the integrator keeps rendering passes until the timeout
+     * expires, the noise estimate drops below \ref m_target_error, or
+     * \ref cancel() is called. The film remains normalized after every pass.
+     */
+    bool m_progressive;
+
+    /// Target relative error at which progressive rendering stops (0: disabled)
+    float m_target_error;
+
+    /// Number of passes completed so far (see \ref passes_completed())
+    std::atomic<uint32_t> m_passes_completed;
+
+    /// Checkpoint filename (see \ref set_checkpoint())
+    fs::path m_checkpoint_path;
+
+    /// Time between checkpoints in seconds
+    float m_checkpoint_interval;
+
+    /// Continue from an existing checkpoint?
+    bool m_resume;
+
+    /// Partition to render (see \ref set_partition())
+    uint32_t m_partition_index;
+
+    /// Total number of partitions
+    uint32_t m_partition_count;
+
     /// Flag for disabling direct visibility of emitters
     bool m_hide_emitters;
     
     /// Identifier (if available)
     std::string m_id;
+
+    /// Are the statistics of the current render job being collected?
+    bool m_collect_stats = false;
+
+    /// Statistics of the last render job (see \ref render_statistics())
+    RenderStatistics m_render_stats;
+
+    /// Counters and maximum path length of the render job in JIT variants
+    mutable DynamicBuffer<UInt64> m_stats_counters;
+    mutable DynamicBuffer<UInt32> m_stats_max_length;
+
+    /// Are the rays of the current render job being captured?
+    bool m_capture_rays = false;
+
+    /// Index of the captured render job and its maximum number of rays
+    uint32_t m_capture_job = 0;
+    size_t m_capture_capacity = 0;
+
+    /// Captured rays (as \ref RayCapture::Record) and their count in JIT variants
+    mutable DynamicBuffer<UInt32> m_capture_data;
+    mutable DynamicBuffer<UInt32> m_capture_count;
 };
 
 /** \brief Abstract integrator that performs Monte Carlo sampling starting from
@@ -358,9 +703,15 @@ protected:
 template <typename Float, typename Spectrum>
 class MI_EXPORT_LIB SamplingIntegrator : public Integrator<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(Integrator, should_stop, aov_names,
-                    m_stop, m_timeout, m_render_timer, m_hide_emitters)
-    MI_IMPORT_TYPES(Scene, Sensor, Film, ImageBlock, Medium, Sampler)
+    MI_IMPORT_BASE(Integrator, should_stop, budget_exhausted, aov_names,
+                    m_stop, m_timeout, m_render_timer, m_hide_emitters,
+                    m_progressive, m_target_error, m_passes_completed,
+                    m_checkpoint_path, m_checkpoint_interval, m_resume,
+                    m_partition_index, m_partition_count, statistics_begin,
+                    statistics_end, record_event,
+                    capture_begin, capture_end)
+    MI_IMPORT_TYPES(Scene, Shape, Sensor, Film, ImageBlock, Medium, Sampler,
+                    BSDFPtr, ShapePtr)
 
     /// Destructor
     ~SamplingIntegrator();
@@ -425,6 +776,17 @@ public:
     //! @}
     // =========================================================================
 
+    /**
+     * \brief Set the number of samples per pixel rendered in each pass
+     *
+     * The value <tt>(uint32_t) -1</tt> renders all samples in a single pass.
+     * This is used by the tuning mode of the \c mitsuba executable.
+     */
+    void set_samples_per_pass(uint32_t value) { m_samples_per_pass = value; }
+
+    /// Return the number of samples per pass (see \ref set_samples_per_pass())
+    uint32_t samples_per_pass() const { return m_samples_per_pass; }
+
     MI_DECLARE_CLASS()
 protected:
     SamplingIntegrator(const Properties &props);
@@ -437,7 +799,23 @@ protected:
                               uint32_t sample_count,
                               uint32_t seed,
                               uint32_t block_id,
-                              uint32_t block_size) const;
+                              uint32_t block_size,
+                              ScalarFloat *moments = nullptr,
+                              uint32_t pixel_begin = 0,
+                              uint32_t pixel_end = (uint32_t) -1) const;
+
+    /**
+     * \brief Write the attributes \c types of the surface interaction \c si
+     * (found along the camera ray \c ray) to consecutive entries of \c aovs
+     *
+     * Invalid interactions produce zero-valued attributes.
+     */
+    void write_primary_aovs(const std::vector<PrimaryAOV> &types,
+                            const Scene *scene,
+                            const RayDifferential3f &ray,
+                            SurfaceInteraction3f si,
+                            Float *aovs,
+                            Mask active) const;
 
     void render_sample(const Scene *scene,
                        const Sensor *sensor,
@@ -448,11 +826,43 @@ protected:
                        ScalarFloat diff_scale_factor,
                        Mask active = true) const;
 
+    /**
+     * \brief Compute the discrete sample positions of a wavefront of \c size
+     * samples that covers consecutive image rows starting at \c row_offset,
+     * with \c spp_per_pass samples per pixel (JIT variants)
+     */
+    Vector2i sample_positions(const Film *film, uint32_t spp_per_pass,
+                              uint32_t row_offset, size_t size) const;
+
+    /**
+     * \brief Render the image in horizontal bands of \c band_height rows one
+     * after the other, which bounds the size of the wavefront (JIT variants)
+     *
+     * Every band renders \c n_passes passes of \c spp_per_pass samples per
+     * pixel into \c block, using a seed derived from \c seed and the index of
+     * the band.
+     */
+    void render_bands(const Scene *scene, const Sensor *sensor,
+                      Sampler *sampler, ImageBlock *block, Float *aovs,
+                      uint32_t seed, uint32_t spp_per_pass, uint32_t n_passes,
+                      uint32_t band_height, ScalarFloat diff_scale_factor) const;
+
 protected:
 
     /// Size of (square) image blocks to render in parallel (in scalar mode)
     uint32_t m_block_size;
 
+    /**
+     * \brief Order in which the image blocks are rendered (scalar variants).
+     *
+     * Specified as \c block_order, which is either \c "spiral" (default),
+     * \c "hilbert", or \c "morton". Along a space-filling curve, the blocks
+     * rendered concurrently by the worker threads are adjacent, which improves
+     * the reuse of cached textures and geometry. The block identifiers (and
+     * hence the seeds) depend on the order.
+     */
+    BlockOrder m_block_order;
+
     /**
      * \brief Number of samples to compute for each pass over the image blocks.
      *
@@ -460,6 +870,82 @@ protected:
      * If set to (uint32_t) -1, all the work is done in a single pass (default).
      */
     uint32_t m_samples_per_pass;
+
+    /**
+     * \brief Target relative error for adaptive sampling (scalar variants).
+     *
+     * When positive, the rendering is split into multiple passes. After each
+     * pass, the relative standard error of the mean pixel luminance is
+     * estimated and averaged over each block. Blocks that fall below this
+     * threshold don't receive any further samples. A value of zero disables
+     * adaptive sampling (default).
+     */
+    ScalarFloat m_adaptive_threshold;
+
+    /// Minimum number of passes before blocks may be retired (adaptive sampling)
+    uint32_t m_adaptive_min_passes;
+
+    /**
+     * \brief Enable NUMA-aware scheduling (scalar variants).
+     *
+     * On systems with several NUMA nodes, worker threads are pinned to the
+     * cores of a node, and each of them preferentially renders the blocks of
+     * a horizontal stripe of the image assigned to its node. Image blocks are
+     * allocated after pinning and hence reside in node-local memory.
+     */
+    bool m_numa;
+
+    /**
+     * \brief Schedule the blocks of later passes by their measured cost
+     * (scalar variants).
+     *
+     * Every block is timed while it is rendered. Subsequent passes then
+     * render the blocks in order of decreasing cost of the previous pass, and
+     * the most expensive ones are split into their four quadrants, so that
+     * the workers don't idle while a few costly blocks finish at the end of
+     * a pass. Quadrants are seeded like the pixels of the full block, hence
+     * the image does not depend on the schedule.
+     */
+    bool m_cost_aware;
+
+    /**
+     * \brief Add a \c render_cost channel to the film with the average
+     * time spent per sample of every pixel (scalar variants, in
+     * microseconds).
+     */
+    bool m_render_cost;
+
+    /// Index of the \c render_cost channel while rendering (zero if disabled)
+    size_t m_render_cost_channel = 0;
+
+    /**
+     * \brief Upper bound on the memory used by the state of a wavefront
+     * (JIT variants, in bytes).
+     *
+     * When positive, the per-lane state footprint is estimated, and the
+     * render job is split into passes with fewer samples and, if needed,
+     * horizontal bands of the image that fit into this budget. The chunks
+     * are only a function of this parameter, the film size, and the sample
+     * count, hence results are reproducible. A value of zero disables the
+     * limit (default).
+     */
+    size_t m_max_wavefront_memory;
+
+    /**
+     * \brief Estimated number of 32-bit words of wavefront state per lane,
+     * excluding the channels of the image block (see
+     * \ref m_max_wavefront_memory).
+     *
+     * Specified as \c wavefront_lane_words. The default of 128 words is
+     * derived from the live state of a path tracer in an RGB variant: the
+     * sampler state, the ray with its differentials, the throughput and
+     * radiance, the surface interaction, and the BSDF and emitter samples
+     * add up to about 100 words, and the rest accounts for the temporaries
+     * of the kernel. Variants and integrators with more state (e.g.
+     * polarized variants or volumetric path tracers) should use a larger
+     * value to stay within the budget.
+     */
+    uint32_t m_wavefront_lane_words;
 };
 
 /** \brief Abstract integrator that performs *recursive* Monte Carlo sampling
@@ -474,19 +960,139 @@ template <typename Float, typename Spectrum>
 class MI_EXPORT_LIB MonteCarloIntegrator
     : public SamplingIntegrator<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(SamplingIntegrator)
+    MI_IMPORT_BASE(SamplingIntegrator, should_stop, m_progressive,
+                   m_checkpoint_path)
+    MI_IMPORT_TYPES(Scene, Sensor)
 
     /// Destructor
     ~MonteCarloIntegrator();
 
+    using Base::render;
+
+    /**
+     * \brief Render the scene
+     *
+     * When adjoint-driven Russian roulette is enabled (see \ref
+     * parse_adjoint_rr()), this function first renders a sequence of training
+     * passes that learn the radiance estimates used by the roulette.
+     */
+    TensorXf render(Scene *scene,
+                    Sensor *sensor,
+                    uint32_t seed = 0,
+                    uint32_t spp = 0,
+                    bool develop = true,
+                    bool evaluate = true) override;
+
+    /**
+     * \brief Request attributes of the first surface intersection of every
+     * path
+     *
+     * Integrators that support this (see \ref supports_primary_aovs()) then
+     * write the attributes to the \c aovs buffer passed to \ref sample(),
+     * following their own AOVs. This lets the \c aov integrator produce them
+     * without tracing the camera rays a second time. An empty list disables
+     * the feature (default).
+     */
+    void set_primary_aovs(const std::vector<PrimaryAOV> &aovs) {
+        m_primary_aovs = aovs;
+    }
+
+    /// Return the attributes requested via \ref set_primary_aovs()
+    const std::vector<PrimaryAOV> &primary_aovs() const { return m_primary_aovs; }
+
+    /// Does the integrator write the attributes requested via \ref set_primary_aovs()?
+    virtual bool supports_primary_aovs() const { return false; }
+
 protected:
     /// Create an integrator
     MonteCarloIntegrator(const Properties &props);
 
+    /**
+     * \brief Parse the parameters of adjoint-driven Russian roulette
+     *
+     * Integrators that support this termination criterion call this function
+     * from their constructor. With <tt>rr_mode="adjoint"</tt>, the radiance
+     * leaving the cells of a regular grid over the scene is learned during
+     * <tt>rr_training_passes</tt> training passes (the first of which uses
+     * <tt>rr_training_spp</tt> samples per pixel, doubled in every subsequent
+     * pass). Paths whose expected contribution falls below the lower end of a
+     * weight window of size <tt>rr_window</tt> around the estimated pixel
+     * value are then terminated with a correspondingly higher probability,
+     * while paths whose expected contribution lies within or above the
+     * window are never terminated.
+     */
+    void parse_adjoint_rr(const Properties &props);
+
+    /// Are the radiance estimates of adjoint-driven Russian roulette available?
+    bool adjoint_rr() const { return m_rr_estimate_ready; }
+
+    /// Is the integrator currently rendering a training pass?
+    bool rr_recording() const { return m_rr_recording; }
+
+    /**
+     * \brief Learned estimate of the radiance scattered at the position \c p
+     *
+     * The value is negative where no estimate is available.
+     */
+    Float rr_estimate(const Point3f &p, Mask active = true) const;
+
+    /**
+     * \brief Survival probability of a path at the position \c p
+     *
+     * \param throughput
+     *     The throughput of the path, including the scattering weight of the
+     *     vertex at \c p.
+     *
+     * \param pixel_estimate
+     *     The expected contribution of the path after its first vertex, i.e.
+     *     the throughput at that vertex multiplied with its estimate.
+     *
+     * \return The survival probability and a mask indicating whether it is
+     *     available. Otherwise, the caller should fall back to the standard
+     *     Russian roulette criterion.
+     */
+    std::pair<Float, Mask> rr_survival(const Point3f &p,
+                                       const Spectrum &throughput,
+                                       const Float &pixel_estimate,
+                                       Mask active = true) const;
+
+    /**
+     * \brief Record a sample \c value of the radiance scattered at \c p with
+     * weight \c weight during a training pass
+     */
+    void rr_record(const Point3f &p, const Float &value, const Float &weight,
+                   Mask active = true) const;
+
     MI_DECLARE_CLASS()
+private:
+    /// Index of the grid cell containing \c p
+    UInt32 rr_cell(const Point3f &p) const;
+
+    /// Replace the estimates by the statistics of the last training pass
+    void rr_update();
+
 protected:
     uint32_t m_max_depth;
     uint32_t m_rr_depth;
+    std::vector<PrimaryAOV> m_primary_aovs;
+
+    /// Adjoint-driven Russian roulette (see \ref parse_adjoint_rr())
+    bool m_adjoint_rr = false;
+    uint32_t m_rr_training_passes = 0;
+    uint32_t m_rr_training_spp = 0;
+    uint32_t m_rr_resolution = 0;
+    ScalarFloat m_rr_window = 0.f;
+
+private:
+    ScalarBoundingBox3f m_rr_bbox;
+    ScalarVector3f m_rr_scale;
+    DynamicBuffer<Float> m_rr_estimates;
+    bool m_rr_estimate_ready = false;
+    bool m_rr_recording = false;
+
+    /// Sum of weighted radiance samples and weights of every cell
+    mutable DynamicBuffer<Float> m_rr_train;
+    std::unique_ptr<AtomicFloat<ScalarFloat>[]> m_rr_train_host;
 };
 
 /** \brief Abstract adjoint integrator that performs Monte Carlo sampling
@@ -504,8 +1110,12 @@ protected:
 template <typename Float, typename Spectrum>
 class MI_EXPORT_LIB AdjointIntegrator : public Integrator<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(Integrator, should_stop, aov_names, m_stop, m_timeout,
-                    m_render_timer, m_hide_emitters)
+    MI_IMPORT_BASE(Integrator, should_stop, budget_exhausted, aov_names,
+                    m_stop, m_timeout, m_render_timer, m_hide_emitters,
+                    m_progressive, m_target_error, m_passes_completed,
+                    m_checkpoint_path, m_partition_count, statistics_begin,
+                    statistics_end, record_event, record_path,
+                    capture_begin, capture_end)
     MI_IMPORT_TYPES(Scene, Sensor, Film, BSDF, BSDFPtr, ImageBlock, Sampler,
                      EmitterPtr)
 
@@ -556,6 +1166,23 @@ protected:
     /// Create an integrator
     AdjointIntegrator(const Properties &props);
 
+    /**
+     * \brief Attempt connecting the given point to the sensor.
+     *
+     * If the point to connect is on the surface (non-null \c bsdf values),
+     * evaluate the BSDF in the direction of the sensor.
+     *
+     * Finally, splat \c weight (with all appropriate factors) to the
+     * given image block.
+     *
+     * \return The quantity that was accumulated to the block.
+     */
+    Spectrum connect_sensor(const Scene *scene, const SurfaceInteraction3f &si,
+                            const DirectionSample3f &sensor_ds,
+                            const BSDFPtr &bsdf, const Spectrum &weight,
+                            ImageBlock *block, ScalarFloat sample_scale,
+                            Mask active) const;
+
 protected:
     /**
      * \brief Number of samples to compute for each pass over the image blocks.
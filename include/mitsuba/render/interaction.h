@@ -342,8 +342,18 @@ struct SurfaceInteraction : Interaction<Float_, Spectrum_> {
      */
     BSDFPtr bsdf(const RayDifferential3f &ray);
 
-    // Returns the BSDF of the intersected shape
-    BSDFPtr bsdf() const { return shape->bsdf(); }
+    /**
+     * Returns the BSDF of the intersected shape, or the BSDF that overrides
+     * it in the parent instance (if applicable)
+     */
+    BSDFPtr bsdf() const {
+        BSDFPtr result = shape->bsdf();
+        if (dr::any_or<true>(instance != nullptr)) {
+            BSDFPtr override_ = instance->bsdf();
+            result = dr::select(override_ != nullptr, override_, result);
+        }
+        return result;
+    }
 
     /// Computes texture coordinate partials
     void compute_uv_partials(const RayDifferential3f &ray) {
@@ -569,6 +579,12 @@ struct MediumInteraction : Interaction<Float_, Spectrum_> {
     /// mint used when sampling the given distance ``t``
     Float mint;
 
+    /**
+     * Number of scattering events on the path before this interaction. Media
+     * may use it to look up coarser levels of detail on secondary paths.
+     */
+    Index depth;
+
     //! @}
     // =============================================================
 
@@ -589,6 +605,7 @@ struct MediumInteraction : Interaction<Float_, Spectrum_> {
         sigma_t             = dr::zeros<UnpolarizedSpectrum>(size);
         combined_extinction = dr::zeros<UnpolarizedSpectrum>(size);
         mint                = dr::zeros<Float>(size);
+        depth               = dr::zeros<Index>(size);
 
         if constexpr (dr::is_jit_v<Float_>) {
             medium      = dr::zeros<MediumPtr>(size);
@@ -612,7 +629,7 @@ struct MediumInteraction : Interaction<Float_, Spectrum_> {
 
     DRJIT_STRUCT(MediumInteraction, t, time, wavelengths, p, n, medium,
                  sh_frame, wi, sigma_s, sigma_n, sigma_t,
-                 combined_extinction, mint)
+                 combined_extinction, mint, depth)
 };
 
 // -----------------------------------------------------------------------------
@@ -2,13 +2,19 @@
 
 #include <unordered_set>
 #include <atomic>
+#include <chrono>
+#include <new>
 
 #include <nanothread/nanothread.h>
 #include <mitsuba/core/bbox.h>
+#include <mitsuba/core/filesystem.h>
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/math.h>
+#include <mitsuba/core/memory.h>
+#include <mitsuba/core/mmap.h>
 #include <mitsuba/core/object.h>
+#include <mitsuba/core/profiler.h>
 #include <mitsuba/core/ray.h>
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/util.h>
@@ -25,6 +31,9 @@
 /// Grain size for parallelization
 #define MI_KD_GRAIN_SIZE 10240u
 
+/// Alignment of the node array, and size of a treelet in the compact layout (bytes)
+#define MI_KD_NODE_ALIGNMENT 64u
+
 /**
  * Temporary scratch space that is used to cache intersection information
  * (# of floats)
@@ -80,6 +89,7 @@ public:
         std::unique_ptr<uint8_t[]> data(new uint8_t[alloc_size]);
         uint8_t *start = data.get(), *cur = start + size;
         m_chunks.emplace_back(std::move(data), cur, alloc_size);
+        m_memory.set(m_memory.size() + alloc_size);
 
         return reinterpret_cast<T *>(start);
     }
@@ -183,6 +193,7 @@ private:
 
     size_t m_min_allocation;
     std::vector<Chunk> m_chunks;
+    MemoryAllocation m_memory { MemoryCategory::KDTree };
 };
 
 /* Append-only concurrent vector, whose storage is arranged into slices
@@ -412,6 +423,22 @@ public:
     /// Set whether primitive clipping is used during tree construction
     void set_clip_primitives(bool clip) { m_clip_primitives = clip; }
 
+    /// Return whether the nodes and indices are stored in the compact layout
+    bool compact() const { return m_compact; }
+
+    /**
+     * \brief Specify whether the nodes and indices are stored in the compact
+     * layout after the tree construction.
+     *
+     * In this layout, leaves referencing a single primitive store its index
+     * directly (which removes it from the index list) and the nodes are
+     * reordered into cache-line-sized treelets, i.e. groups of sibling pairs
+     * close to the root of a subtree that share a cache line. This reduces
+     * the memory footprint as well as the number of cache lines touched by a
+     * traversal.
+     */
+    void set_compact(bool compact) { m_compact = compact; }
+
     /// Return whether or not bad splits can be "retracted".
     bool retract_bad_splits() const { return m_retract_bad_splits; }
 
@@ -605,6 +632,21 @@ protected:
     static_assert(sizeof(KDNode) == sizeof(Size) + sizeof(Scalar),
                   "kd-tree node has unexpected size. Padding issue?");
 
+    /**
+     * \brief Return the primitive indices referenced by a leaf node
+     *
+     * In the compact layout (see \ref set_compact()), the index of a leaf
+     * with a single primitive is stored in the node, in which case it is
+     * copied to \c storage.
+     */
+    MI_INLINE const Index *leaf_indices(const KDNode *node, Index &storage) const {
+        if (m_compact && node->primitive_count() == 1) {
+            storage = node->primitive_offset();
+            return &storage;
+        }
+        return m_indices.get() + node->primitive_offset();
+    }
+
 protected:
     /// Enumeration representing the state of a classified primitive in the O(N log N) builder
     enum class PrimClassification : uint8_t {
@@ -614,6 +656,16 @@ protected:
         Both   = 3  /// Primitive straddles the split plane
     };
 
+    /// Phases of the kd-tree construction that are timed separately
+    enum class BuildPhase : uint8_t {
+        Binning = 0, /// Min-max binning of the primitives
+        SplitSearch, /// Split candidate search over the min-max bins
+        Partition,   /// Partitioning of the primitives into the child nodes
+        EventSetup,  /// Creation and sorting of the initial edge event list
+        ExactBuild,  /// Recursive O(N log N) build of the lower levels
+        BuildPhaseCount
+    };
+
     /* ==================================================================== */
     /*                    Specialized memory allocators                     */
     /* ==================================================================== */
@@ -691,6 +743,8 @@ protected:
         std::atomic<size_t> pruned {0};
         std::atomic<size_t> temp_storage {0};
         std::atomic<size_t> work_units {0};
+        /* Time spent in the build phases (ns, summed over all threads) */
+        std::atomic<uint64_t> phase_time[(int) BuildPhase::BuildPhaseCount] { };
         double exp_traversal_steps = 0;
         double exp_leaves_visited = 0;
         double exp_primitives_queried = 0;
@@ -702,6 +756,22 @@ protected:
         BuildContext(const Derived &derived) : derived(derived) { }
     };
 
+    /// Adds the time spent within its scope to a build phase of a \ref BuildContext
+    struct ScopedBuildPhase {
+        ScopedBuildPhase(BuildContext &ctx, BuildPhase phase)
+            : ctx(ctx), phase(phase), start(std::chrono::steady_clock::now()) { }
+
+        ~ScopedBuildPhase() {
+            auto duration = std::chrono::steady_clock::now() - start;
+            ctx.phase_time[(int) phase] += (uint64_t)
+                std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        }
+
+        BuildContext &ctx;
+        BuildPhase phase;
+        std::chrono::steady_clock::time_point start;
+    };
+
     /// Data type for split candidates suggested by the tree cost model
     struct SplitCandidate {
         Scalar cost = dr::Infinity<Scalar>;
@@ -1146,17 +1216,20 @@ protected:
 
             /* Accumulate all shapes into bins */
             MinMaxBins bins(derived.min_max_bins(), m_tight_bbox);
-            std::mutex bins_mutex;
-            dr::parallel_for(
-                dr::blocked_range<Size>(0u, prim_count, MI_KD_GRAIN_SIZE),
-                [&](const dr::blocked_range<Index> &range) {
-                    MinMaxBins bins_local(derived.min_max_bins(), m_tight_bbox);
-                    for (Index i = range.begin(); i != range.end(); ++i)
-                        bins_local.put(derived.bbox(m_indices[i]));
-                    std::lock_guard<std::mutex> lock(bins_mutex);
-                    bins += bins_local;
-                }
-            );
+            /* binning */ {
+                ScopedBuildPhase phase(m_ctx, BuildPhase::Binning);
+                std::mutex bins_mutex;
+                dr::parallel_for(
+                    dr::blocked_range<Size>(0u, prim_count, MI_KD_GRAIN_SIZE),
+                    [&](const dr::blocked_range<Index> &range) {
+                        MinMaxBins bins_local(derived.min_max_bins(), m_tight_bbox);
+                        for (Index i = range.begin(); i != range.end(); ++i)
+                            bins_local.put(derived.bbox(m_indices[i]));
+                        std::lock_guard<std::mutex> lock(bins_mutex);
+                        bins += bins_local;
+                    }
+                );
+            }
 
             /* ==================================================================== */
             /*                        Split candidate search                        */
@@ -1164,7 +1237,11 @@ protected:
 
             CostModel model(derived.cost_model());
             model.set_bounding_box(m_bbox);
-            auto best = bins.best_candidate(prim_count, model);
+            SplitCandidate best;
+            /* split search */ {
+                ScopedBuildPhase phase(m_ctx, BuildPhase::SplitSearch);
+                best = bins.best_candidate(prim_count, model);
+            }
 
             Assert(dr::isfinite(best.cost));
             Assert(best.split >= m_bbox.min[best.axis]);
@@ -1186,10 +1263,14 @@ protected:
             /*                            Partitioning                              */
             /* ==================================================================== */
 
-            auto partition = bins.partition(derived, m_indices, best);
+            typename MinMaxBins::Partition partition;
+            /* partition */ {
+                ScopedBuildPhase phase(m_ctx, BuildPhase::Partition);
+                partition = bins.partition(derived, m_indices, best);
 
-            /* Release index list */
-            IndexVector().swap(m_indices);
+                /* Release index list */
+                IndexVector().swap(m_indices);
+            }
 
             /* ==================================================================== */
             /*                              Recursion                               */
@@ -1685,7 +1766,7 @@ protected:
             const auto &derived = m_ctx.derived;
             // m_local = &m_ctx.local; // TODO remove this
 
-            Size prim_count = Size(m_indices.size()), final_prim_count = prim_count;
+            Size prim_count = Size(m_indices.size());
 
             /* We don't yet know how many edge events there will be. Allocate a
                conservative amount and shrink the buffer later on. */
@@ -1695,48 +1776,108 @@ protected:
                 m_local.left_alloc.template allocate<EdgeEvent>(initial_size),
                 *events_end = events_start + initial_size;
 
-            for (Size i = 0; i<prim_count; ++i) {
-                Index prim_index = m_indices[i];
-                BoundingBox prim_bbox = derived.bbox(prim_index, m_bbox);
-                bool valid = prim_bbox.valid() && prim_bbox.surface_area() > 0;
+            /* Large event lists (which occur at the top of the tree when the
+               scene is small, or when the exact primitive threshold is large)
+               are created and sorted in parallel */
+            bool parallel = prim_count > 4 * MI_KD_GRAIN_SIZE;
+            std::atomic<Size> pruned { 0 };
+
+            /* event setup */ {
+                ScopedBuildPhase phase(m_ctx, BuildPhase::EventSetup);
+
+                auto create_events = [&](Size range_start, Size range_end) {
+                    Size pruned_local = 0;
+                    for (Size i = range_start; i < range_end; ++i) {
+                        Index prim_index = m_indices[i];
+                        BoundingBox prim_bbox = derived.bbox(prim_index, m_bbox);
+                        bool valid = prim_bbox.valid() && prim_bbox.surface_area() > 0;
+
+                        if (unlikely(!valid))
+                            pruned_local++;
+
+                        for (Index axis = 0; axis < Dimension; ++axis) {
+                            Scalar min = prim_bbox.min[axis], max = prim_bbox.max[axis];
+                            Index offset = (Index) (axis * prim_count + i) * 2;
+
+                            if (unlikely(!valid)) {
+                                events_start[offset  ].set_invalid();
+                                events_start[offset+1].set_invalid();
+                            } else if (min == max) {
+                                events_start[offset  ] = EdgeEvent(EdgeEvent::Type::EdgePlanar, axis, min, prim_index);
+                                events_start[offset+1].set_invalid();
+                            } else {
+                                events_start[offset  ] = EdgeEvent(EdgeEvent::Type::EdgeStart, axis, min, prim_index);
+                                events_start[offset+1] = EdgeEvent(EdgeEvent::Type::EdgeEnd,   axis, max, prim_index);
+                            }
+                        }
+                    }
+                    pruned += pruned_local;
+                };
 
-                if (unlikely(!valid)) {
-                    --final_prim_count;
-                    m_ctx.pruned++;
+                if (parallel) {
+                    dr::parallel_for(
+                        dr::blocked_range<Size>(0u, prim_count, MI_KD_GRAIN_SIZE),
+                        [&](const dr::blocked_range<Size> &range) {
+                            create_events(range.begin(), range.end());
+                        }
+                    );
+                } else {
+                    create_events(0, prim_count);
                 }
 
-                for (Index axis = 0; axis < Dimension; ++axis) {
-                    Scalar min = prim_bbox.min[axis], max = prim_bbox.max[axis];
-                    Index offset = (Index) (axis * prim_count + i) * 2;
-
-                    if (unlikely(!valid)) {
-                        events_start[offset  ].set_invalid();
-                        events_start[offset+1].set_invalid();
-                    } else if (min == max) {
-                        events_start[offset  ] = EdgeEvent(EdgeEvent::Type::EdgePlanar, axis, min, prim_index);
-                        events_start[offset+1].set_invalid();
-                    } else {
-                        events_start[offset  ] = EdgeEvent(EdgeEvent::Type::EdgeStart, axis, min, prim_index);
-                        events_start[offset+1] = EdgeEvent(EdgeEvent::Type::EdgeEnd,   axis, max, prim_index);
+                /* Release index list */
+                IndexVector().swap(m_indices);
+
+                /* Sort the events list and remove invalid ones from the end */
+                if (parallel) {
+                    /* The events of each axis occupy a separate block, which
+                       can be sorted independently. Invalid events sort to
+                       the end of their block and are then compacted away,
+                       which yields the same list as a global sort. */
+                    EdgeEvent *block_end[Dimension];
+                    dr::parallel_for(
+                        dr::blocked_range<Size>(0u, (Size) Dimension, 1),
+                        [&](const dr::blocked_range<Size> &range) {
+                            for (Size axis = range.begin(); axis != range.end(); ++axis) {
+                                EdgeEvent *start = events_start + axis * prim_count * 2,
+                                          *end   = start + prim_count * 2;
+                                std::sort(start, end);
+                                while (start != end && !(end-1)->valid())
+                                    --end;
+                                block_end[axis] = end;
+                            }
+                        }
+                    );
+
+                    events_end = block_end[0];
+                    for (Size axis = 1; axis < Dimension; ++axis) {
+                        EdgeEvent *start = events_start + axis * prim_count * 2;
+                        if (start == events_end)
+                            events_end = block_end[axis];
+                        else
+                            events_end = std::move(start, block_end[axis], events_end);
                     }
+                } else {
+                    std::sort(events_start, events_end);
+                    while (events_start != events_end && !(events_end-1)->valid())
+                        --events_end;
                 }
             }
 
-            /* Release index list */
-            IndexVector().swap(m_indices);
-
-            /* Sort the events list and remove invalid ones from the end */
-            std::sort(events_start, events_end);
-            while (events_start != events_end && !(events_end-1)->valid())
-                --events_end;
+            m_ctx.pruned += pruned;
+            Size final_prim_count = prim_count - pruned;
 
             m_local.left_alloc.template shrink_allocation<EdgeEvent>(
                 events_start, events_end - events_start);
             m_local.classification_storage.resize(derived.primitive_count());
             m_local.ctx = &m_ctx;
 
-            Scalar cost = build_nlogn(m_node, final_prim_count, events_start,
-                                      events_end, m_bbox, m_depth, 0);
+            Scalar cost;
+            /* exact build */ {
+                ScopedBuildPhase phase(m_ctx, BuildPhase::ExactBuild);
+                cost = build_nlogn(m_node, final_prim_count, events_start,
+                                   events_end, m_bbox, m_depth, 0);
+            }
 
             m_local.left_alloc.release(events_start);
 
@@ -1883,8 +2024,13 @@ protected:
                 util::mem_string(prim_count * sizeof(Index)).c_str());
 
             IndexVector indices(prim_count);
-            for (size_t i = 0; i < prim_count; ++i)
-                indices[i] = (Index) i;
+            dr::parallel_for(
+                dr::blocked_range<Size>(0u, prim_count, MI_KD_GRAIN_SIZE),
+                [&](const dr::blocked_range<Size> &range) {
+                    for (Size i = range.begin(); i != range.end(); ++i)
+                        indices[i] = (Index) i;
+                }
+            );
 
             BuildTask task = BuildTask(ctx, 0, std::move(indices), m_bbox,
                                        m_bbox, 0, 0, &final_cost);
@@ -1900,7 +2046,7 @@ protected:
         m_node_count  = (Index) ctx.node_storage.size();
         m_index_count = (Index) ctx.index_storage.size();
 
-        m_indices.reset(new Index[m_index_count]);
+        set_indices(new Index[m_index_count]);
         dr::parallel_for(
             dr::blocked_range<Size>(0u, m_index_count, MI_KD_GRAIN_SIZE),
             [&](const dr::blocked_range<Size> &range) {
@@ -1910,7 +2056,7 @@ protected:
         );
         ctx.index_storage.release();
 
-        m_nodes.reset(new KDNode[m_node_count]);
+        set_nodes(allocate_nodes(m_node_count));
         dr::parallel_for(
             dr::blocked_range<Size>(0u, m_node_count, MI_KD_GRAIN_SIZE),
             [&](const dr::blocked_range<Size> &range) {
@@ -1919,6 +2065,8 @@ protected:
             }
         );
         ctx.node_storage.release();
+        m_memory.set((size_t) m_node_count * sizeof(KDNode) +
+                     (size_t) m_index_count * sizeof(Index));
 
         /* Slightly avoid the bounding box to avoid numerical issues
            involving geometry that exactly lies on the boundary */
@@ -1991,18 +2139,206 @@ protected:
             Log(m_log_level, "   Final cost                  : %.2f",
                 final_cost);
             Log(m_log_level, "");
+
+            const char *phase_names[(int) BuildPhase::BuildPhaseCount] = {
+                "Min-max binning", "Split candidate search", "Partitioning",
+                "Edge event setup", "O(n log n) build"
+            };
+            Log(m_log_level, "kd-tree build phases (thread time):");
+            for (int i = 0; i < (int) BuildPhase::BuildPhaseCount; ++i)
+                Log(m_log_level, "   %-28s: %s", phase_names[i],
+                    util::time_string((float) (ctx.phase_time[i] / 1e6)));
+            Log(m_log_level, "");
         }
+
+        if (m_compact)
+            compact_layout();
+    }
+
+    /// Convert the nodes and indices of a built tree to the compact layout
+    void compact_layout() {
+        size_t size_before = (size_t) m_node_count * sizeof(KDNode) +
+                             (size_t) m_index_count * sizeof(Index);
+
+        /* ==================================================================== */
+        /*        Store the primitive of single-primitive leaves inline         */
+        /* ==================================================================== */
+
+        Size index_count = 0;
+        for (Size i = 0; i < m_node_count; ++i) {
+            const KDNode &node = m_nodes[i];
+            if (node.leaf() && node.primitive_count() > 1)
+                index_count += node.primitive_count();
+        }
+
+        std::unique_ptr<Index[]> indices(new Index[index_count]);
+        index_count = 0;
+        for (Size i = 0; i < m_node_count; ++i) {
+            KDNode &node = m_nodes[i];
+            if (!node.leaf())
+                continue;
+            Size prim_count = node.primitive_count();
+            if (prim_count == 1) {
+                node.set_leaf_node(m_indices[node.primitive_offset()], 1);
+            } else if (prim_count > 1) {
+                std::copy(m_indices.get() + node.primitive_offset(),
+                          m_indices.get() + node.primitive_offset() + prim_count,
+                          indices.get() + index_count);
+                node.set_leaf_node(index_count, prim_count);
+                index_count += prim_count;
+            }
+        }
+        set_indices(indices.release());
+        m_index_count = index_count;
+
+        /* ==================================================================== */
+        /*            Reorder the nodes into cache-line-sized treelets          */
+        /* ==================================================================== */
+
+        /* The children of a node are stored as a pair of adjacent nodes, and a
+           treelet consists of the pairs encountered by a breadth-first
+           traversal of a subtree until a cache line is full. The pairs that
+           didn't fit start new treelets, which are laid out depth-first. */
+        constexpr bool Aligned = MI_KD_NODE_ALIGNMENT % sizeof(KDNode) == 0;
+        constexpr Size LineNodes =
+            Aligned ? Size(MI_KD_NODE_ALIGNMENT / sizeof(KDNode)) : 8;
+        constexpr Size TreeletPairs = std::max(LineNodes / 2, Size(1));
+
+        // Sibling pair, specified via the left child and the parent (old indices)
+        struct Pair { Size left, parent; };
+
+        std::vector<KDNode> nodes;
+        nodes.reserve(m_node_count + m_node_count / LineNodes + LineNodes);
+        std::vector<Size> remap(m_node_count);
+        std::vector<Pair> stack, treelet, overflow;
+        bool success = true;
+
+        KDNode padding;
+        padding.set_leaf_node(0, 0);
+
+        auto visit = [&](const Pair &root, Size capacity) {
+            treelet.clear();
+            overflow.clear();
+            treelet.push_back(root);
+            for (size_t i = 0; i < treelet.size(); ++i) {
+                for (Size k = 0; k < 2; ++k) {
+                    Size index = treelet[i].left + k;
+                    const KDNode &node = m_nodes[index];
+                    if (node.leaf())
+                        continue;
+                    Pair child { index + node.left_offset(), index };
+                    (treelet.size() < capacity ? treelet : overflow).push_back(child);
+                }
+            }
+
+            /* Start a new cache line unless the treelet fits into the current
+               one. Smaller treelets (near the leaves) fill the gaps instead. */
+            Size used = Size(nodes.size() % LineNodes);
+            if (Aligned && used > 0 && treelet.size() == capacity &&
+                used + 2 * capacity > LineNodes)
+                nodes.resize(nodes.size() + LineNodes - used, padding);
+
+            for (const Pair &pair : treelet) {
+                Size pos = (Size) nodes.size(), parent = remap[pair.parent];
+                remap[pair.left] = pos;
+                remap[pair.left + 1] = pos + 1;
+                nodes.push_back(m_nodes[pair.left]);
+                nodes.push_back(m_nodes[pair.left + 1]);
+
+                KDNode &p = nodes[parent];
+                success &= p.set_inner_node(p.axis(), p.split(), pos - parent);
+            }
+
+            for (auto it = overflow.rbegin(); it != overflow.rend(); ++it)
+                stack.push_back(*it);
+        };
+
+        remap[0] = 0;
+        nodes.push_back(m_nodes[0]);
+        if (!m_nodes[0].leaf()) {
+            // The root shares its cache line with the first levels below it
+            if (Aligned && LineNodes > 2)
+                nodes.push_back(padding);
+            visit(Pair { m_nodes[0].left_offset(), 0 },
+                  std::max(TreeletPairs - 1, Size(1)));
+
+            while (!stack.empty()) {
+                Pair pair = stack.back();
+                stack.pop_back();
+                visit(pair, TreeletPairs);
+            }
+        }
+
+        if (success) {
+            m_node_count = (Size) nodes.size();
+            set_nodes(allocate_nodes(m_node_count));
+            std::copy(nodes.begin(), nodes.end(), m_nodes.get());
+        } else {
+            Log(Warn, "kd-tree: the offsets of the compact node layout can't "
+                      "be represented, keeping the depth-first layout.");
+        }
+
+        size_t size_after = (size_t) m_node_count * sizeof(KDNode) +
+                            (size_t) m_index_count * sizeof(Index);
+        m_memory.set(size_after);
+
+        Log(m_log_level, "Compact kd-tree layout: %i nodes, %i primitive "
+            "references (%s, was %s)", m_node_count, m_index_count,
+            util::mem_string(size_after), util::mem_string(size_before));
     }
 
 protected:
-    std::unique_ptr<KDNode[]> m_nodes;
-    std::unique_ptr<Index[]> m_indices;
+    /// Releases node arrays created by \ref allocate_nodes()
+    struct NodeDeleter {
+        /// Set when the nodes are stored elsewhere (e.g. in a mapped file)
+        bool owned = true;
+        void operator()(KDNode *nodes) const {
+            if (owned)
+                ::operator delete[](nodes, std::align_val_t(MI_KD_NODE_ALIGNMENT));
+        }
+    };
+
+    /// Releases index arrays created with <tt>new Index[]</tt>
+    struct IndexDeleter {
+        /// Set when the indices are stored elsewhere (e.g. in a mapped file)
+        bool owned = true;
+        void operator()(Index *indices) const {
+            if (owned)
+                delete[] indices;
+        }
+    };
+
+    /// Replace the node array, which is released later on if \c owned is set
+    void set_nodes(KDNode *nodes, bool owned = true) {
+        m_nodes.reset();
+        m_nodes.get_deleter().owned = owned;
+        m_nodes.reset(nodes);
+    }
+
+    /// Replace the index array, which is released later on if \c owned is set
+    void set_indices(Index *indices, bool owned = true) {
+        m_indices.reset();
+        m_indices.get_deleter().owned = owned;
+        m_indices.reset(indices);
+    }
+
+    /// Allocate an (uninitialized) array of nodes aligned to a cache line
+    static KDNode *allocate_nodes(Size count) {
+        return (KDNode *) ::operator new[](count * sizeof(KDNode),
+                                           std::align_val_t(MI_KD_NODE_ALIGNMENT));
+    }
+
+    std::unique_ptr<KDNode[], NodeDeleter> m_nodes;
+    std::unique_ptr<Index[], IndexDeleter> m_indices;
     Size m_node_count = 0;
     Size m_index_count = 0;
+    /// Accounts for \ref m_nodes and \ref m_indices
+    MemoryAllocation m_memory { MemoryCategory::KDTree };
 
     CostModel m_cost_model;
     bool m_clip_primitives = true;
     bool m_retract_bad_splits = true;
+    bool m_compact = false;
     Size m_max_depth = 0;
     Size m_stop_primitives = 3;
     Size m_max_bad_refines = 0;
@@ -2135,7 +2471,9 @@ public:
     using Base = TShapeKDTree<ScalarBoundingBox3f, uint32_t, SurfaceAreaHeuristic3f, ShapeKDTree>;
     using typename Base::KDNode;
     using Base::ready;
+    using Base::leaf_indices;
     using Base::set_clip_primitives;
+    using Base::set_compact;
     using Base::set_exact_primitive_threshold;
     using Base::set_max_depth;
     using Base::set_min_max_bins;
@@ -2148,6 +2486,45 @@ public:
     using Base::m_index_count;
     using Base::m_node_count;
 
+    /**
+     * \brief Precomputed triangles of a leaf node, packed for a vectorized
+     * Moeller-Trumbore intersection test with \c Width lanes
+     *
+     * Unused lanes have zero-valued edges, which never produce a hit.
+     */
+    template <size_t Width> struct TrianglePacket {
+        ScalarFloat p0[3][Width];
+        ScalarFloat e1[3][Width];
+        ScalarFloat e2[3][Width];
+        Index shape_index[Width];
+        Index prim_index[Width];
+    };
+
+    /**
+     * \brief Spheres of a leaf node (see \ref Shape::sphere_primitive()),
+     * packed for a vectorized intersection test with \c Width lanes
+     *
+     * Unused lanes have a zero radius and are ignored.
+     */
+    template <size_t Width> struct SpherePacket {
+        ScalarFloat center[3][Width];
+        ScalarFloat radius[Width];
+        Index shape_index[Width];
+        Index prim_index[Width];
+    };
+
+    /// Range of triangle and sphere packets belonging to a leaf node
+    struct LeafPackets {
+        /// Index of the first triangle packet
+        Index offset;
+        /// Number of triangles, which are the first entries of the leaf
+        Index triangle_count;
+        /// Index of the first sphere packet
+        Index sphere_offset;
+        /// Number of spheres, which directly follow the triangles
+        Index sphere_count;
+    };
+
     /// Create an empty kd-tree and take build-related parameters from \c props.
     ShapeKDTree(const Properties &props);
 
@@ -2172,6 +2549,9 @@ public:
     /// Return the i-th shape
     Shape *shape(size_t i) { Assert(i < m_shapes.size()); return m_shapes[i]; }
 
+    /// Are packets of coherent rays traversed jointly in LLVM variants?
+    bool coherent_traversal() const { return m_coherent_traversal; }
+
     /// Return the bounding box of the i-th primitive
     MI_INLINE ScalarBoundingBox3f bbox(Index i) const {
         Index shape_index = find_shape(i);
@@ -2212,6 +2592,9 @@ public:
         // Resulting intersection struct
         PreliminaryIntersection<ScalarFloat, Shape> pi;
 
+        // Traversal statistics (no-op unless MI_ENABLE_RAY_STATISTICS is set)
+        ScopedRayStatistics stats;
+
         // Intersect against the scene bounding box
         auto bbox_result = m_bbox.ray_intersect(ray);
 
@@ -2222,6 +2605,8 @@ public:
 
         const KDNode *node = m_nodes.get();
         while (mint <= maxt) {
+            stats.add(RayStatistic::TraversedNodes);
+
             if (likely(!node->leaf())) { // Inner node
                 const ScalarFloat split = node->split();
                 const uint32_t axis     = node->axis();
@@ -2259,11 +2644,54 @@ public:
                 maxt = t_plane;
                 continue;
             } else if (node->primitive_count() > 0) { // Arrived at a leaf node
-                Index prim_start = node->primitive_offset();
-                Index prim_end = prim_start + node->primitive_count();
+                Index inline_index;
+                const Index *indices = leaf_indices(node, inline_index);
+                Index prim_start = 0, prim_end = node->primitive_count();
+
+                // Intersect precomputed triangles first, if available
+                if (m_packet_width != 0) {
+                    const LeafPackets &lp = m_leaf_packets[node - m_nodes.get()];
+                    stats.add(RayStatistic::PrimitiveTests, lp.triangle_count);
+
+                    bool hit;
+                    if (m_packet_width == 8)
+                        hit = intersect_triangle_packets<8, ShadowRay>(
+                            m_packets_8.data() + lp.offset, lp.triangle_count, ray, pi);
+                    else
+                        hit = intersect_triangle_packets<4, ShadowRay>(
+                            m_packets_4.data() + lp.offset, lp.triangle_count, ray, pi);
+
+                    if constexpr (ShadowRay) {
+                        if (hit)
+                            return pi;
+                    }
+
+                    if (lp.sphere_count > 0) {
+                        stats.add(RayStatistic::PrimitiveTests, lp.sphere_count);
+
+                        if (m_packet_width == 8)
+                            hit = intersect_sphere_packets<8, ShadowRay>(
+                                m_sphere_packets_8.data() + lp.sphere_offset,
+                                lp.sphere_count, ray, pi);
+                        else
+                            hit = intersect_sphere_packets<4, ShadowRay>(
+                                m_sphere_packets_4.data() + lp.sphere_offset,
+                                lp.sphere_count, ray, pi);
+
+                        if constexpr (ShadowRay) {
+                            if (hit)
+                                return pi;
+                        }
+                    }
+
+                    DRJIT_MARK_USED(hit);
+                    prim_start += lp.triangle_count + lp.sphere_count;
+                }
+
                 for (Index i = prim_start; i < prim_end; i++) {
-                    Index prim_index = m_indices[i];
+                    Index prim_index = indices[i];
 
+                    stats.add(RayStatistic::PrimitiveTests);
                     PreliminaryIntersection<ScalarFloat, Shape> prim_pi =
                         intersect_prim<ShadowRay>(prim_index, ray);
 
@@ -2292,16 +2720,39 @@ public:
         return pi;
     }
 
-#if 0
-    template <bool ShadowRay>
-    MI_INLINE PreliminaryIntersection3f ray_intersect_packet(Ray3f ray,
-                                                              Mask active) const {
+    /**
+     * \brief Traverse the kd-tree with a packet of \c Width coherent rays
+     *
+     * All lanes share a single traversal stack: inner nodes are visited in
+     * the order preferred by the majority of the lanes, and lanes that do
+     * not overlap a node are masked out. Leaves are intersected lane by lane.
+     *
+     * When the fraction of idle lanes per visited node exceeds the
+     * divergence threshold (see the \c kd_divergence_threshold parameter),
+     * the packet is abandoned and the remaining lanes are finished using
+     * \ref ray_intersect_scalar(), starting from the closest hits found so
+     * far.
+     *
+     * \param rays
+     *    Array of \c Width rays
+     * \param valid
+     *    Array of \c Width flags specifying the enabled lanes
+     * \param result
+     *    Array of \c Width intersection records (output)
+     */
+    template <size_t Width, bool ShadowRay>
+    void ray_intersect_packet(const ScalarRay3f *rays, const bool *valid,
+                              PreliminaryIntersection<ScalarFloat, Shape> *result) const {
+        using FloatP    = dr::Array<ScalarFloat, Width>;
+        using MaskP     = dr::mask_t<FloatP>;
+        using Vector3fP = Vector<FloatP, 3>;
+
         /// Ray traversal stack entry
         struct KDStackEntry {
-            // Ray distance associated with the node entry and exit point
-            Float mint, maxt;
-            // Is the corresponding SIMD lane enabled?
-            Mask active;
+            // Ray distances associated with the node entry and exit points
+            FloatP mint, maxt;
+            // Lanes that need to visit the node
+            MaskP active;
             // Pointer to the far child
             const KDNode *node;
         };
@@ -2310,115 +2761,172 @@ public:
         KDStackEntry stack[MI_KD_MAXDEPTH];
         int32_t stack_index = 0;
 
-        // Resulting intersection struct
-        PreliminaryIntersection3f pi = dr::zeros<PreliminaryIntersection3f>();
+        // Traversal statistics (no-op unless MI_ENABLE_RAY_STATISTICS is set)
+        ScopedRayStatistics stats;
+
+        /* Convert the rays into a structure of arrays and intersect them
+           against the scene bounding box */
+        Vector3fP o, d;
+        FloatP ray_maxt, mint, maxt;
+        MaskP active, done(false);
+        for (size_t k = 0; k < Width; ++k) {
+            const ScalarRay3f &ray = rays[k];
+            for (size_t j = 0; j < 3; ++j) {
+                o[j].entry(k) = ray.o[j];
+                d[j].entry(k) = ray.d[j];
+            }
 
-        const KDNode *node = m_nodes.get();
+            auto bbox_result = m_bbox.ray_intersect(ray);
+            mint.entry(k)     = std::max(ScalarFloat(0), std::get<1>(bbox_result));
+            maxt.entry(k)     = std::min(ray.maxt, std::get<2>(bbox_result));
+            ray_maxt.entry(k) = ray.maxt;
+            active.entry(k)   = valid[k];
+            result[k]         = PreliminaryIntersection<ScalarFloat, Shape>();
+        }
+        Vector3fP d_rcp = dr::rcp(d);
+        MaskP valid_p = active;
 
-        /* Intersect against the scene bounding box */
-        auto bbox_result = m_bbox.ray_intersect(ray);
-        Float mint = dr::maximum(ray.mint, std::get<1>(bbox_result));
-        Float maxt = dr::minimum(ray.maxt, std::get<2>(bbox_result));
+        // Number of visited nodes and of the lanes that were active there
+        size_t node_visits = 0, lane_visits = 0;
+        bool divergent = false;
 
+        const KDNode *node = m_nodes.get();
         while (true) {
-            active = active && (maxt >= mint);
-            if (ShadowRay)
-                active = active && !pi.is_valid();
+            active &= maxt >= mint && !done;
 
             if (likely(dr::any(active))) {
+                size_t active_count = dr::count(active);
+                stats.add(RayStatistic::TraversedNodes, active_count);
+                node_visits++;
+                lane_visits += active_count;
+
+                // Switch to independent traversal when lanes diverge
+                if (unlikely(node_visits >= 16 &&
+                             (ScalarFloat) lane_visits <
+                                 (ScalarFloat(1) - m_divergence_threshold) *
+                                 (ScalarFloat) (node_visits * Width))) {
+                    divergent = true;
+                    break;
+                }
+
                 if (likely(!node->leaf())) { // Inner node
-                    const dr::scalar_t<Float> split = node->split();
-                    const uint32_t axis = node->axis();
+                    const ScalarFloat split = node->split();
+                    const uint32_t axis     = node->axis();
 
                     // Compute parametric distance along the rays to the split plane
-                    Float t_plane          = (split - ray.o[axis]) * ray.d_rcp[axis];
-                    Mask left_first        = (ray.o[axis] < split) ||
-                                              (dr::eq(ray.o[axis], split) && ray.d[axis] >= 0.f),
-                         start_after       = t_plane < mint,
-                         end_before        = t_plane > maxt || t_plane < 0.f || !dr::isfinite(t_plane),
-                         single_node       = start_after || end_before,
-                         visit_left        = dr::eq(end_before, left_first),
-                         visit_only_left   = single_node &&  visit_left,
-                         visit_only_right  = single_node && !visit_left;
+                    FloatP t_plane = (split - o[axis]) * d_rcp[axis];
+
+                    MaskP left_first  = (o[axis] < split) ||
+                                        (o[axis] == split && d[axis] >= 0.f),
+                          start_after = t_plane < mint,
+                          end_before  = t_plane > maxt || t_plane < 0.f ||
+                                        !dr::isfinite(t_plane),
+                          single_node = start_after || end_before,
+                          visit_left  = end_before == left_first,
+                          visit_only_left  = single_node && visit_left,
+                          visit_only_right = single_node && !visit_left;
 
                     bool all_visit_only_left  = dr::all(visit_only_left || !active),
-                         all_visit_only_right = dr::all(visit_only_right || !active),
-                         all_visit_same_node  = all_visit_only_left || all_visit_only_right;
+                         all_visit_only_right = dr::all(visit_only_right || !active);
 
-                    /* If we only need to visit one node, just pick the correct one and continue */
-                    if (all_visit_same_node) {
+                    // If all lanes only need to visit one node, just pick it and continue
+                    if (all_visit_only_left || all_visit_only_right) {
                         node = node->left() + (all_visit_only_left ? 0 : 1);
                         continue;
                     }
 
-                    size_t left_votes  = count(left_first && active),
-                           right_votes = count(!left_first && active);
+                    // Visit the child nodes in the order preferred by most lanes
+                    bool go_left = dr::count(left_first && active) >=
+                                   dr::count(!left_first && active);
 
-                    bool go_left = left_votes >= right_votes;
+                    MaskP go_left_p     = MaskP(go_left),
+                          correct_order = left_first == go_left_p,
+                          visit_both    = !single_node,
+                          visit_cur     = visit_both || visit_left == go_left_p,
+                          visit_next    = visit_both || visit_left != go_left_p;
 
-                    Mask go_left_bcast = Mask(go_left),
-                         correct_order = dr::eq(left_first, go_left_bcast),
-                         visit_both    = !single_node,
-                         visit_cur     = visit_both || eq (visit_left, go_left_bcast),
-                         visit_next    = visit_both || dr::neq(visit_left, go_left_bcast);
-
-                    /* Visit both child nodes in the right order */
                     Index node_offset = go_left ? 0 : 1;
                     const KDNode *left   = node->left(),
                                  *n_cur  = left + node_offset,
                                  *n_next = left + (1 - node_offset);
 
-                    /* Postpone visit to 'n_next' */
-                    Mask sel0 =  correct_order && visit_both,
-                         sel1 = !correct_order && visit_both;
-                    KDStackEntry& entry = stack[stack_index++];
-                    entry.mint = dr::select(sel0, t_plane, mint);
-                    entry.maxt = dr::select(sel1, t_plane, maxt);
+                    // Postpone visit to 'n_next'
+                    MaskP sel0 =  correct_order && visit_both,
+                          sel1 = !correct_order && visit_both;
+                    KDStackEntry &entry = stack[stack_index++];
+                    entry.mint   = dr::select(sel0, t_plane, mint);
+                    entry.maxt   = dr::select(sel1, t_plane, maxt);
                     entry.active = active && visit_next;
-                    entry.node = n_next;
+                    entry.node   = n_next;
 
-                    /* Visit 'n_cur' now */
-                    mint = dr::select(sel1, t_plane, mint);
-                    maxt = dr::select(sel0, t_plane, maxt);
+                    // Visit 'n_cur' now
+                    mint   = dr::select(sel1, t_plane, mint);
+                    maxt   = dr::select(sel0, t_plane, maxt);
                     active = active && visit_cur;
-                    node = n_cur;
+                    node   = n_cur;
                     continue;
                 } else if (node->primitive_count() > 0) { // Arrived at a leaf node
-                    Index prim_start = node->primitive_offset();
-                    Index prim_end = prim_start + node->primitive_count();
-                    for (Index i = prim_start; i < prim_end; i++) {
-                        Index prim_index = m_indices[i];
-
-                        PreliminaryIntersection3f prim_pi =
-                            intersect_prim<ShadowRay>(prim_index, ray, active);
-
-                        dr::masked(pi, prim_pi.is_valid()) = prim_pi;
-
-                        if constexpr (!ShadowRay) {
-                            Assert(dr::all(!prim_pi.is_valid() ||
-                                       (prim_pi.t >= ray.mint &&
-                                        prim_pi.t <= ray.maxt)));
-                            dr::masked(ray.maxt, prim_pi.is_valid()) = prim_pi.t;
+                    Index inline_index;
+                    const Index *indices = leaf_indices(node, inline_index);
+                    Index prim_start = 0, prim_end = node->primitive_count();
+
+                    for (size_t k = 0; k < Width; ++k) {
+                        if (!active.entry(k))
+                            continue;
+
+                        ScalarRay3f ray = rays[k];
+                        ray.maxt = ray_maxt.entry(k);
+
+                        for (Index i = prim_start; i < prim_end; i++) {
+                            stats.add(RayStatistic::PrimitiveTests);
+                            PreliminaryIntersection<ScalarFloat, Shape> prim_pi =
+                                intersect_prim<ShadowRay>(indices[i], ray);
+
+                            if (unlikely(prim_pi.is_valid())) {
+                                result[k] = prim_pi;
+                                if constexpr (ShadowRay) {
+                                    done.entry(k) = true;
+                                    break;
+                                }
+                                Assert(prim_pi.t >= 0.f && prim_pi.t <= ray.maxt);
+                                ray.maxt = prim_pi.t;
+                            }
                         }
+
+                        ray_maxt.entry(k) = ray.maxt;
                     }
                 }
             }
 
             if (likely(stack_index > 0)) {
                 --stack_index;
-                KDStackEntry& entry = stack[stack_index];
-                mint = entry.mint;
-                maxt = dr::minimum(entry.maxt, ray.maxt);
+                KDStackEntry &entry = stack[stack_index];
+                mint   = entry.mint;
+                maxt   = dr::minimum(entry.maxt, ray_maxt);
                 active = entry.active;
-                node = entry.node;
+                node   = entry.node;
             } else {
                 break;
             }
         }
 
-        return pi;
+        if (unlikely(divergent)) {
+            /* Restart the lanes from the root, keeping the closest hits found
+               so far (shadow rays with a hit are already done) */
+            for (size_t k = 0; k < Width; ++k) {
+                if (!valid_p.entry(k) || done.entry(k))
+                    continue;
+
+                ScalarRay3f ray = rays[k];
+                ray.maxt = ray_maxt.entry(k);
+
+                PreliminaryIntersection<ScalarFloat, Shape> pi =
+                    ray_intersect_scalar<ShadowRay>(ray);
+                if (pi.is_valid())
+                    result[k] = pi;
+            }
+        }
     }
-#endif
 
     /// Brute force intersection routine for debugging purposes
     template <bool ShadowRay>
@@ -2426,8 +2934,10 @@ public:
     ray_intersect_naive(Ray3f ray, Mask active) const {
         if constexpr (!dr::is_array_v<Float>) {
             PreliminaryIntersection3f pi = dr::zeros<PreliminaryIntersection3f>();
+            ScopedRayStatistics stats;
 
             for (Size i = 0; i < primitive_count(); ++i) {
+                stats.add(RayStatistic::PrimitiveTests);
                 PreliminaryIntersection3f prim_pi = intersect_prim<ShadowRay>(i, ray);
 
                 if constexpr (dr::is_array_v<Float>) {
@@ -2499,7 +3009,7 @@ protected:
             if (shape->is_mesh())
                 hit = mesh->ray_intersect_triangle_scalar(prim_index, ray).first != dr::Infinity<ScalarFloat>;
             else
-                hit = shape->ray_test_scalar(ray);
+                hit = shape->ray_test_scalar(ray, prim_index);
             pi.t = dr::select(hit, 0.f , pi.t);
         } else {
             uint32_t inst_index = (uint32_t) -1;
@@ -2507,7 +3017,7 @@ protected:
                 std::tie(pi.t, pi.prim_uv) = mesh->ray_intersect_triangle_scalar(prim_index, ray);
             else
                 std::tie(pi.t, pi.prim_uv, inst_index, prim_index) =
-                    shape->ray_intersect_preliminary_scalar(ray);
+                    shape->ray_intersect_preliminary_scalar(ray, prim_index);
             pi.prim_index = prim_index;
 
             bool hit_inst  = (inst_index != (uint32_t) -1);
@@ -2519,9 +3029,223 @@ protected:
         return pi;
     }
 
+    /**
+     * \brief Intersect a ray against the precomputed triangle packets of a
+     * leaf node containing \c count triangles
+     *
+     * Closest hits shorten the ray and are written to \c pi. Returns whether
+     * any of the triangles was hit.
+     */
+    template <size_t Width, bool ShadowRay>
+    MI_INLINE bool
+    intersect_triangle_packets(const TrianglePacket<Width> *packets, Index count,
+                               ScalarRay3f &ray,
+                               PreliminaryIntersection<ScalarFloat, Shape> &pi) const {
+        using FloatP    = dr::Array<ScalarFloat, Width>;
+        using Vector3fP = Vector<FloatP, 3>;
+
+        Vector3fP o(ray.o), d(ray.d);
+        bool found = false;
+
+        for (Index i = 0; i < count; i += (Index) Width) {
+            const TrianglePacket<Width> &tp = *packets++;
+
+            Vector3fP p0(dr::load<FloatP>(tp.p0[0]), dr::load<FloatP>(tp.p0[1]),
+                         dr::load<FloatP>(tp.p0[2])),
+                      e1(dr::load<FloatP>(tp.e1[0]), dr::load<FloatP>(tp.e1[1]),
+                         dr::load<FloatP>(tp.e1[2])),
+                      e2(dr::load<FloatP>(tp.e2[0]), dr::load<FloatP>(tp.e2[1]),
+                         dr::load<FloatP>(tp.e2[2]));
+
+            // Same arithmetic as Mesh::moeller_trumbore(), for identical hits
+            Vector3fP pvec = dr::cross(d, e2);
+            FloatP inv_det = dr::rcp(dr::dot(e1, pvec));
+
+            Vector3fP tvec = o - p0;
+            FloatP u = dr::dot(tvec, pvec) * inv_det;
+
+            Vector3fP qvec = dr::cross(tvec, e1);
+            FloatP v = dr::dot(d, qvec) * inv_det;
+            FloatP t = dr::dot(e2, qvec) * inv_det;
+
+            dr::mask_t<FloatP> active = u >= 0.f && u <= 1.f && v >= 0.f &&
+                                        u + v <= 1.f && t >= 0.f && t <= ray.maxt;
+
+            if (likely(dr::none(active)))
+                continue;
+
+            if constexpr (ShadowRay) {
+                pi.t = 0.f;
+                return true;
+            }
+
+            // Select the closest hit among the lanes
+            t = dr::select(active, t, dr::Infinity<FloatP>);
+            ScalarFloat t_min = dr::min(t);
+            size_t k = 0;
+            while (t.entry(k) != t_min)
+                ++k;
+
+            pi.t           = t_min;
+            pi.prim_uv     = ScalarPoint2f(u.entry(k), v.entry(k));
+            pi.prim_index  = tp.prim_index[k];
+            pi.shape_index = tp.shape_index[k];
+            pi.shape       = m_shapes[tp.shape_index[k]];
+            pi.instance    = nullptr;
+            ray.maxt       = t_min;
+            found          = true;
+        }
+
+        return found;
+    }
+
+    /**
+     * \brief Intersect a ray against the sphere packets of a leaf node
+     * containing \c count spheres
+     *
+     * Closest hits shorten the ray and are written to \c pi. Returns whether
+     * any of the spheres was hit.
+     */
+    template <size_t Width, bool ShadowRay>
+    MI_INLINE bool
+    intersect_sphere_packets(const SpherePacket<Width> *packets, Index count,
+                             ScalarRay3f &ray,
+                             PreliminaryIntersection<ScalarFloat, Shape> &pi) const {
+        using FloatP    = dr::Array<ScalarFloat, Width>;
+        using Vector3fP = Vector<FloatP, 3>;
+        using Value     = std::conditional_t<dr::is_diff_v<Float>, FloatP,
+                                             dr::float64_array_t<FloatP>>;
+        using Value3    = Vector<Value, 3>;
+
+        Vector3fP of(ray.o), df(ray.d);
+        Value3 o(of), d(df);
+        Value A = dr::squared_norm(d), d_norm = dr::norm(d),
+              maxt = Value(ray.maxt);
+        bool found = false;
+
+        for (Index i = 0; i < count; i += (Index) Width) {
+            const SpherePacket<Width> &sp = *packets++;
+
+            FloatP radius_f = dr::load<FloatP>(sp.radius);
+            Value3 center(Value(dr::load<FloatP>(sp.center[0])),
+                          Value(dr::load<FloatP>(sp.center[1])),
+                          Value(dr::load<FloatP>(sp.center[2])));
+            Value radius(radius_f);
+
+            // Same arithmetic as the 'spheres' plugin, for identical hits
+            Value3 l = o - center;
+            Value plane_t = dr::dot(-l, d) / d_norm;
+
+            dr::mask_t<Value> no_hit =
+                plane_t == Value(0) && dr::all(o != center);
+
+            Value3 plane_p(dr::fmadd(df, FloatP(plane_t), of));
+            no_hit &= dr::norm(plane_p - center) > radius;
+
+            Value3 oc = plane_p - center;
+            Value B = dr::scalar_t<Value>(2.f) * dr::dot(oc, d);
+            Value C = dr::squared_norm(oc) - dr::square(radius);
+
+            auto [solution_found, near_t, far_t] = math::solve_quadratic(A, B, C);
+
+            near_t += plane_t;
+            far_t += plane_t;
+
+            dr::mask_t<Value> out_bounds = !(near_t <= maxt && far_t >= Value(0.0)),
+                              in_bounds  = near_t < Value(0.0) && far_t > maxt;
+
+            dr::mask_t<Value> active_v =
+                solution_found && !no_hit && !out_bounds && !in_bounds;
+            dr::mask_t<FloatP> active =
+                dr::mask_t<FloatP>(active_v) && radius_f > 0.f;
+
+            if (likely(dr::none(active)))
+                continue;
+
+            if constexpr (ShadowRay) {
+                pi.t = 0.f;
+                return true;
+            }
+
+            // Select the closest hit among the lanes
+            FloatP t = dr::select(
+                active, dr::select(near_t < Value(0.0), FloatP(far_t), FloatP(near_t)),
+                dr::Infinity<FloatP>);
+            ScalarFloat t_min = dr::min(t);
+            if (!(t_min < ray.maxt))
+                continue;
+
+            size_t k = 0;
+            while (t.entry(k) != t_min)
+                ++k;
+
+            pi.t           = t_min;
+            pi.prim_uv     = dr::zeros<ScalarPoint2f>();
+            pi.prim_index  = sp.prim_index[k];
+            pi.shape_index = sp.shape_index[k];
+            pi.shape       = m_shapes[sp.shape_index[k]];
+            pi.instance    = nullptr;
+            ray.maxt       = t_min;
+            maxt           = Value(t_min);
+            found          = true;
+        }
+
+        return found;
+    }
+
+    /**
+     * \brief Precompute the packed triangles and spheres of all leaf nodes
+     *
+     * This moves the triangles of every leaf in front of its other
+     * primitives, followed by the spheres of \ref ShapeType::Spheres shapes.
+     */
+    void build_triangle_packets();
+
+    /// Fill the packets with \c Width lanes, see \ref build_triangle_packets()
+    template <size_t Width>
+    void build_triangle_packets(std::vector<TrianglePacket<Width>> &packets,
+                                std::vector<SpherePacket<Width>> &sphere_packets);
+
+    /**
+     * \brief Compute a key identifying the built kd-tree
+     *
+     * The key is a hash of the geometry of all registered shapes and of the
+     * build-related parameters, which together fully determine the tree.
+     */
+    uint64_t cache_key() const;
+
+    /// Try to load a previously built kd-tree with the given key from a cache file
+    bool cache_load(const fs::path &filename, uint64_t key);
+
+    /// Store the built kd-tree in a cache file under the given key
+    void cache_store(const fs::path &filename, uint64_t key) const;
+
 protected:
     std::vector<ref<Shape>> m_shapes;
     std::vector<Size> m_primitive_map;
+
+    /// Directory of the on-disk kd-tree cache (disabled when empty)
+    std::string m_cache_dir;
+
+    /// Map cached kd-trees from their file instead of copying them?
+    bool m_cache_map = false;
+
+    /// Cache file that stores \ref m_nodes and \ref m_indices when mapped
+    ref<MemoryMappedFile> m_cache_file;
+
+    /// Traverse packets of coherent rays jointly (LLVM variants)?
+    bool m_coherent_traversal = true;
+    /// Fraction of idle lanes at which packet traversal is abandoned
+    ScalarFloat m_divergence_threshold = ScalarFloat(.5f);
+
+    /// Lanes per precomputed triangle packet (0: disabled, 4 or 8)
+    uint32_t m_packet_width = 0;
+    /// Range of triangle and sphere packets of every node (only used by leaves)
+    std::vector<LeafPackets> m_leaf_packets;
+    std::vector<TrianglePacket<4>> m_packets_4;
+    std::vector<TrianglePacket<8>> m_packets_8;
+    std::vector<SpherePacket<4>> m_sphere_packets_4;
+    std::vector<SpherePacket<8>> m_sphere_packets_8;
 };
 
 MI_EXTERN_CLASS(ShapeKDTree)
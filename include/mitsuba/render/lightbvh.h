@@ -0,0 +1,203 @@
+#pragma once
+
+#include <mitsuba/core/bbox.h>
+#include <mitsuba/core/fwd.h>
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/vector.h>
+#include <mitsuba/render/fwd.h>
+#include <mitsuba/render/interaction.h>
+#include <vector>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Bounding volume hierarchy over the emitters of a scene for
+ * many-light importance sampling
+ *
+ * Every node stores conservative bounds of the emitters below it: an axis
+ * aligned bounding box, a cone bounding the surface normals (θo) together
+ * with the spread of emission around them (θe), and the total power. When
+ * sampling an emitter for a reference point, the hierarchy is traversed from
+ * the root, and at every inner node a child is chosen proportionally to a
+ * conservative estimate of its contribution ("importance") at that point.
+ * This follows the light BVH from PBRT-v4 (itself based on "Importance
+ * Sampling of Many Lights with Adaptive Tree Splitting" by Conty Estevez and
+ * Kulla).
+ *
+ * The hierarchy has two levels. The upper level has one leaf per emitter,
+ * which determines the probabilities of \ref sample() and \ref pdf().
+ * Area emitters with a uniform radiance that are attached to a mesh
+ * additionally own a subtree with one leaf per triangle: \ref
+ * sample_direction() continues the traversal into it to pick a triangle and
+ * then samples a point uniformly on that triangle. Large or curved emissive
+ * meshes are thus sampled according to the contribution of their parts.
+ * Other emitters sample directions themselves.
+ *
+ * The emitter's \c sampling_weight serves as its power. Emitters without a
+ * finite position (environment maps, directional emitters) cannot be bounded
+ * and are chosen uniformly with a probability proportional to their count
+ * (where the entire hierarchy counts as one). Emitters with a zero sampling
+ * weight are never chosen.
+ *
+ * The hierarchy is stored in flat arrays, so that the same traversal code
+ * runs in scalar, vectorized and JIT-compiled variants.
+ */
+template <typename Float, typename Spectrum>
+class MI_EXPORT_LIB LightBVH : public Object {
+public:
+    MI_IMPORT_TYPES(Emitter, Shape, Mesh)
+
+    using FloatStorage  = DynamicBuffer<Float>;
+    using UInt32Storage = DynamicBuffer<UInt32>;
+    using UInt64Storage = DynamicBuffer<UInt64>;
+
+    /// Build the hierarchy over the given list of emitters
+    LightBVH(const std::vector<ref<Emitter>> &emitters);
+
+    /**
+     * \brief Sample an emitter proportionally to its estimated contribution
+     * at the reference point \c ref
+     *
+     * \return A tuple containing the index of the chosen emitter, its sampling
+     * weight (i.e. the inverse of its selection probability, or zero if no
+     * emitter could be chosen), and the transformed random sample for reuse.
+     */
+    std::tuple<UInt32, Float, Float> sample(const Interaction3f &ref,
+                                            Float sample,
+                                            Mask active = true) const;
+
+    /**
+     * \brief Evaluate the probability of choosing the emitter with index
+     * \c index at the reference point \c ref with \ref sample().
+     */
+    Float pdf(const Interaction3f &ref, UInt32 index, Mask active = true) const;
+
+    /**
+     * \brief Sample a direction from \c ref toward the emitter with index
+     * \c index (as chosen by \ref sample())
+     *
+     * Emissive meshes with per-triangle leaves choose a triangle based on its
+     * estimated contribution at \c ref, on which a point is then sampled
+     * uniformly. The remaining emitters use \ref Emitter::sample_direction().
+     * The returned density and weight do not account for the probability of
+     * choosing the emitter.
+     */
+    std::pair<DirectionSample3f, Spectrum>
+    sample_direction(const Interaction3f &ref, const EmitterPtr &emitter,
+                     UInt32 index, const Point2f &sample,
+                     Mask active = true) const;
+
+    /**
+     * \brief Evaluate the density of \ref sample_direction() for the
+     * emitter with index \c index
+     */
+    Float pdf_direction(const Interaction3f &ref, const DirectionSample3f &ds,
+                        UInt32 index, Mask active = true) const;
+
+    /// Return the number of nodes of the hierarchy
+    uint32_t node_count() const { return m_node_count; }
+
+    /// Return the number of triangles of emissive meshes with per-triangle leaves
+    uint32_t triangle_count() const { return m_triangle_count; }
+
+    /// Return the number of emitters that are sampled outside of the hierarchy
+    uint32_t infinite_count() const { return m_infinite_count; }
+
+    /// Return a human-readable string representation of the hierarchy
+    virtual std::string to_string() const override;
+
+    MI_DECLARE_CLASS()
+
+protected:
+    /// Bounds of a set of emitters (used during construction)
+    struct LightBounds {
+        ScalarBoundingBox3f bbox;
+        ScalarVector3f axis = 0.f;
+        ScalarFloat cos_theta_o = 1.f;
+        ScalarFloat cos_theta_e = 1.f;
+        ScalarFloat power = 0.f;
+        bool valid = false;
+    };
+
+    /// Compute the bounds of a single emitter
+    LightBounds emitter_bounds(const Emitter *emitter) const;
+
+    /**
+     * \brief Compute the bounds of the triangles of an emissive mesh
+     *
+     * Returns an empty list if the emitter does not get per-triangle leaves.
+     * Otherwise, the areas of all faces are appended to \c area.
+     */
+    std::vector<std::pair<uint32_t, LightBounds>>
+    triangle_bounds(const Emitter *emitter, std::vector<ScalarFloat> &area) const;
+
+    /// Compute the union of two sets of bounds
+    static LightBounds merge(const LightBounds &a, const LightBounds &b);
+
+    /// Estimate the cost of sampling from a node with the given bounds
+    static ScalarFloat cost(const LightBounds &b, const ScalarVector3f &extents,
+                            uint32_t axis);
+
+    /**
+     * \brief Recursively build the subtree over <tt>[begin, end)</tt>
+     *
+     * The bit trails of the leaves are written to \c trails, which is
+     * indexed by the first element of the items.
+     */
+    uint32_t build_recursive(std::vector<std::pair<uint32_t, LightBounds>> &items,
+                             size_t begin, size_t end, uint32_t depth,
+                             uint64_t trail, uint64_t *trails);
+
+    /// Conservative estimate of the contribution of a node at a reference point
+    Float importance(const Point3f &p, const Normal3f &n, UInt32 node,
+                     Mask active) const;
+
+    /**
+     * \brief Descend from \c node to a leaf, choosing children proportionally
+     * to their importance
+     *
+     * \return The index stored in the leaf, its probability (zero when no
+     * leaf could be reached), and the transformed random sample.
+     */
+    std::tuple<UInt32, Float, Float> traverse(const Point3f &p, const Normal3f &n,
+                                              UInt32 node, Float sample,
+                                              Mask active) const;
+
+    /// Probability of reaching the leaf with bit trail \c trail from \c node
+    Float traverse_pdf(const Point3f &p, const Normal3f &n, UInt32 node,
+                       UInt64 trail, Mask active) const;
+
+protected:
+    /// Node bounds (3 entries per node)
+    FloatStorage m_node_bbox_min, m_node_bbox_max, m_node_axis;
+    /// Node cones and power, stored as (cos θo, cos θe, power)
+    FloatStorage m_node_cone;
+    /// Index of the second child of inner nodes or emitter index of leaves
+    UInt32Storage m_node_child;
+    /// Bit trail from the root to every emitter (1 = second child)
+    UInt64Storage m_emitter_trail;
+    /// Per-emitter state: 0 = never sampled, 1 = in the hierarchy, 2 = infinite
+    UInt32Storage m_emitter_state;
+    /// Indices of the emitters that are sampled outside of the hierarchy
+    UInt32Storage m_infinite;
+    /// Per-emitter root of the triangle subtree (0 = no per-triangle leaves)
+    UInt32Storage m_emitter_root;
+    /// Per-emitter offset into the per-triangle arrays below
+    UInt32Storage m_emitter_offset;
+    /// Bit trail from the root of the subtree to every triangle
+    UInt64Storage m_triangle_trail;
+    /// Surface area of every triangle
+    FloatStorage m_triangle_area;
+
+    uint32_t m_node_count = 0;
+    uint32_t m_infinite_count = 0;
+    uint32_t m_emitter_count = 0;
+    uint32_t m_triangle_count = 0;
+
+    /// Construction-time node data (flushed into the buffers above)
+    std::vector<ScalarFloat> m_tmp_bbox_min, m_tmp_bbox_max, m_tmp_axis, m_tmp_cone;
+    std::vector<uint32_t> m_tmp_child;
+};
+
+MI_EXTERN_CLASS(LightBVH)
+NAMESPACE_END(mitsuba)
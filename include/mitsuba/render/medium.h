@@ -25,6 +25,19 @@ public:
     get_majorant(const MediumInteraction3f &mi,
                  Mask active = true) const = 0;
 
+    /**
+     * \brief Returns the extinction of the medium's control component
+     *
+     * Decomposition tracking splits the extinction into a control component,
+     * whose free-flight distances are sampled analytically, and a residual
+     * that is tracked with null collisions. The control extinction should be
+     * constant over the medium and not exceed Sigma_t anywhere. The default
+     * implementation returns zero, i.e. the medium has no control component.
+     */
+    virtual UnpolarizedSpectrum
+    get_control_extinction(const MediumInteraction3f &mi,
+                           Mask active = true) const;
+
     /// Returns the medium coefficients Sigma_s, Sigma_n and Sigma_t evaluated
     /// at a given MediumInteraction mi
     virtual std::tuple<UnpolarizedSpectrum, UnpolarizedSpectrum,
@@ -45,13 +58,21 @@ public:
      * \param channel  The channel according to which we will sample the
      * free-flight distance. This argument is only used when rendering in RGB
      * modes.
+     * \param majorant_offset Value subtracted from the majorant, e.g. to
+     * sample the residual of decomposition tracking (see \ref
+     * get_control_extinction()). The reduced majorant is returned in
+     * \c combined_extinction.
+     * \param depth    Number of scattering events on the path so far, which
+     * is stored in the returned interaction (see \ref MediumInteraction::depth).
      *
      * \return         This method returns a MediumInteraction.
      *                 The MediumInteraction will always be valid,
      *                 except if the ray missed the Medium's bounding box.
      */
     MediumInteraction3f sample_interaction(const Ray3f &ray, Float sample,
-                                           UInt32 channel, Mask active) const;
+                                           UInt32 channel, Mask active,
+                                           Float majorant_offset = 0.f,
+                                           UInt32 depth = 0) const;
 
     /**
      * \brief Compute the transmittance and PDF
@@ -106,6 +127,25 @@ protected:
     Medium();
     Medium(const Properties &props);
 
+    /**
+     * \brief Sample a tentative free-flight distance along a ray segment
+     *
+     * This function is used by \ref sample_interaction() once the ray has been
+     * clipped to the segment <tt>[mint, maxt]</tt> within the medium's
+     * bounding box. The default implementation samples an exponential
+     * distribution with the constant majorant returned by \ref get_majorant(),
+     * reduced by \c majorant_offset (clamped to zero). Media with spatially
+     * varying majorants can override it.
+     *
+     * \return A pair containing the sampled distance along the ray (larger
+     * than \c maxt if no interaction occurs within the segment) and the
+     * majorant at that distance.
+     */
+    virtual std::pair<Float, UnpolarizedSpectrum>
+    sample_distance(const MediumInteraction3f &mei, const Ray3f &ray,
+                    Float mint, Float maxt, Float sample, UInt32 channel,
+                    Float majorant_offset, Mask active) const;
+
 protected:
     ref<PhaseFunction> m_phase_function;
     bool m_sample_emitters, m_is_homogeneous, m_has_spectral_extinction;
@@ -127,6 +167,7 @@ DRJIT_CALL_TEMPLATE_BEGIN(mitsuba::Medium)
     DRJIT_CALL_GETTER(is_homogeneous)
     DRJIT_CALL_GETTER(has_spectral_extinction)
     DRJIT_CALL_METHOD(get_majorant)
+    DRJIT_CALL_METHOD(get_control_extinction)
     DRJIT_CALL_METHOD(intersect_aabb)
     DRJIT_CALL_METHOD(sample_interaction)
     DRJIT_CALL_METHOD(transmittance_eval_pdf)
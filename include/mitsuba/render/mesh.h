@@ -6,6 +6,7 @@
 #include <mitsuba/core/struct.h>
 #include <mitsuba/core/transform.h>
 #include <mitsuba/core/distr_1d.h>
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/properties.h>
 #include <unordered_map>
 #include <mutex>
@@ -125,6 +126,12 @@ public:
     MI_INLINE auto vertex_position(Index index,
                                    dr::mask_t<Index> active = true) const {
         using Result = Point<dr::replace_scalar_t<Index, InputFloat>, 3>;
+        if constexpr (!dr::is_jit_v<Float> && !dr::is_array_v<Index>) {
+            if (m_vertex_stride != 0) {
+                const InputFloat *ptr = interleaved_vertex(index);
+                return active ? Result(ptr[0], ptr[1], ptr[2]) : dr::zeros<Result>();
+            }
+        }
         return dr::gather<Result>(m_vertex_positions, index, active);
     }
 
@@ -133,6 +140,15 @@ public:
     MI_INLINE auto vertex_normal(Index index,
                                  dr::mask_t<Index> active = true) const {
         using Result = Normal<dr::replace_scalar_t<Index, InputFloat>, 3>;
+        if constexpr (!dr::is_jit_v<Float> && !dr::is_array_v<Index>) {
+            if (m_vertex_stride != 0) {
+                const InputFloat *ptr = interleaved_vertex(index) + 3;
+                return active ? Result(ptr[0], ptr[1], ptr[2]) : dr::zeros<Result>();
+            }
+        }
+        if (unlikely(dr::width(m_vertex_normals_compact) != 0))
+            return Result(decode_normal(dr::gather<dr::uint32_array_t<Index>>(
+                m_vertex_normals_compact, index, active)));
         return dr::gather<Result>(m_vertex_normals, index, active);
     }
 
@@ -141,6 +157,16 @@ public:
     MI_INLINE auto vertex_texcoord(Index index,
                                    dr::mask_t<Index> active = true) const {
         using Result = Point<dr::replace_scalar_t<Index, InputFloat>, 2>;
+        if constexpr (!dr::is_jit_v<Float> && !dr::is_array_v<Index>) {
+            if (m_vertex_stride != 0) {
+                const InputFloat *ptr =
+                    interleaved_vertex(index) + m_vertex_texcoord_offset;
+                return active ? Result(ptr[0], ptr[1]) : dr::zeros<Result>();
+            }
+        }
+        if (unlikely(dr::width(m_vertex_texcoords_compact) != 0))
+            return Result(decode_texcoord(dr::gather<dr::uint32_array_t<Index>>(
+                m_vertex_texcoords_compact, index, active)));
         return dr::gather<Result>(m_vertex_texcoords, index, active);
     }
 
@@ -165,10 +191,33 @@ public:
     }
 
     /// Does this mesh have per-vertex normals?
-    bool has_vertex_normals() const { return dr::width(m_vertex_normals) != 0; }
+    bool has_vertex_normals() const {
+        return dr::width(m_vertex_normals) != 0 ||
+               dr::width(m_vertex_normals_compact) != 0;
+    }
 
     /// Does this mesh have per-vertex texture coordinates?
-    bool has_vertex_texcoords() const { return dr::width(m_vertex_texcoords) != 0; }
+    bool has_vertex_texcoords() const {
+        return dr::width(m_vertex_texcoords) != 0 ||
+               dr::width(m_vertex_texcoords_compact) != 0;
+    }
+
+    /// Are vertex normals and texture coordinates stored in compact form?
+    bool has_compact_vertices() const { return m_compact_vertices; }
+
+    /// Are the vertices also stored in the interleaved layout?
+    bool has_interleaved_vertices() const { return m_vertex_stride != 0; }
+
+    /**
+     * \brief Return the vertex normals as a flat buffer
+     *
+     * Unlike \ref vertex_normals_buffer(), this function also supports
+     * meshes with a compact vertex layout, whose normals are decoded.
+     */
+    FloatStorage vertex_normals_data() const;
+
+    /// Texture coordinate variant of \ref vertex_normals_data()
+    FloatStorage vertex_texcoords_data() const;
 
     /// Does this mesh have additional mesh attributes?
     bool has_mesh_attributes() const { return m_mesh_attributes.size() > 0; }
@@ -176,6 +225,9 @@ public:
     /// Does this mesh use face normals?
     bool has_face_normals() const { return m_face_normals; }
 
+    /// Are the normals of this mesh flipped?
+    bool flip_normals() const { return m_flip_normals; }
+
     /// @}
     // =========================================================================
 
@@ -198,6 +250,15 @@ public:
     /// Merge two meshes into one
     ref<Mesh> merge(const Mesh *other) const;
 
+    /**
+     * \brief Merge a list of compatible meshes into one
+     *
+     * Unlike repeated calls to \ref merge(const Mesh *) const, this computes
+     * the final vertex and face counts up front, allocates every output
+     * buffer once, and copies the inputs in parallel.
+     */
+    static ref<Mesh> merge(const std::vector<const Mesh *> &meshes);
+
     /// Compute smooth vertex normals and replace the current normal values
     void recompute_vertex_normals();
 
@@ -213,6 +274,15 @@ public:
      */
     void build_directed_edges();
 
+    /**
+     * \brief Build or refit the edge hierarchy used by \ref
+     * precompute_silhouette()
+     *
+     * The hierarchy is rebuilt after the directed edges changed, and only
+     * refitted when the vertex positions were updated.
+     */
+    void update_silhouette_tree() const;
+
     // =============================================================
     //! @{ \name Shape interface implementation
     // =============================================================
@@ -234,6 +304,25 @@ public:
 
     Float pdf_position(const PositionSample3f &ps, Mask active = true) const override;
 
+    /**
+     * \brief Sample a direction towards the mesh
+     *
+     * When the mesh was created with the \c solid_angle_sampling parameter
+     * set to \c true, a triangle is chosen proportionally to its area, after
+     * which the spherical triangle it subtends at the reference point is
+     * sampled uniformly. Triangles whose solid angle is too small or too
+     * large for this method to be numerically robust are sampled by area.
+     * Otherwise, this function falls back to the area sampling technique
+     * implemented by \ref Shape.
+     */
+    DirectionSample3f sample_direction(const Interaction3f &it,
+                                       const Point2f &sample,
+                                       Mask active = true) const override;
+
+    /// Query the probability density of \ref sample_direction()
+    Float pdf_direction(const Interaction3f &it, const DirectionSample3f &ds,
+                        Mask active = true) const override;
+
     Point3f barycentric_coordinates(const SurfaceInteraction3f &si,
                                     Mask active = true) const;
 
@@ -257,6 +346,18 @@ public:
                              const SurfaceInteraction3f &si,
                              Mask active = true) const override;
 
+    UnpolarizedSpectrum eval_attribute(uint32_t handle,
+                                       const SurfaceInteraction3f &si,
+                                       Mask active = true) const override;
+
+    Float eval_attribute_1(uint32_t handle,
+                           const SurfaceInteraction3f &si,
+                           Mask active = true) const override;
+
+    Color3f eval_attribute_3(uint32_t handle,
+                             const SurfaceInteraction3f &si,
+                             Mask active = true) const override;
+
     SurfaceInteraction3f eval_parameterization(const Point2f &uv,
                                                uint32_t ray_flags = +RayFlags::All,
                                                Mask active = true) const override;
@@ -374,6 +475,12 @@ public:
 #if defined(MI_ENABLE_EMBREE)
     /// Return the Embree version of this shape
     RTCGeometry embree_geometry(RTCDevice device) override;
+
+    /**
+     * \brief Update the vertex buffer of an Embree geometry previously created
+     * by \ref embree_geometry() after a topology-preserving change
+     */
+    void embree_update_geometry(RTCGeometry geom);
 #endif
 
 #if defined(MI_ENABLE_CUDA)
@@ -407,6 +514,9 @@ protected:
      */
     void build_pmf();
 
+    /// Update the tracked size of the mesh buffers (see \ref MemoryTracker)
+    void update_memory_usage();
+
     /**
      * /brief Precompute the set of edges that could contribute to the indirect
      * discontinuous integral.
@@ -428,6 +538,74 @@ protected:
      */
     void build_parameterization();
 
+    /**
+     * \brief Create a position sample on the triangle with vertex indices
+     * \c fi at the barycentric coordinates \c b
+     *
+     * The \c pdf field is set to the area density of \ref sample_position().
+     */
+    PositionSample3f position_sample(const Vector3u &fi, const Point2f &b,
+                                     Float time, Mask active) const;
+
+    /**
+     * \brief Determine whether the spherical triangle subtended by the given
+     * triangle at \c p can be sampled robustly, and return its density
+     * with respect to solid angles.
+     */
+    std::pair<Mask, Float> spherical_triangle_pdf(const Point3f &p,
+                                                  const Point3f &p0,
+                                                  const Point3f &p1,
+                                                  const Point3f &p2) const;
+
+    /**
+     * \brief Convert vertex normals and texture coordinates to the compact
+     * vertex layout
+     *
+     * Normals are stored in a 32 bit octahedral encoding, and texture
+     * coordinates are quantized to 16 bits per component relative to their
+     * bounding box. The full precision buffers are released afterwards.
+     */
+    void compact_vertex_data();
+
+    /**
+     * \brief Build the interleaved vertex layout
+     *
+     * In scalar variants, this stores a copy of the position, normal and
+     * texture coordinates of every vertex in a single record, which the
+     * triangle intersection routine and \ref compute_surface_interaction()
+     * then read instead of the separate buffers. A hit thereby touches one
+     * or two cache lines per vertex instead of up to three. JIT variants keep
+     * the separate buffers, whose layout suits vectorized gathers.
+     */
+    void interleave_vertex_data();
+
+    /// Return a pointer to the interleaved record of a vertex
+    MI_INLINE const InputFloat *interleaved_vertex(ScalarIndex index) const {
+        return m_vertex_data_interleaved.data() + index * m_vertex_stride;
+    }
+
+    /// Decode a normal stored in the 32 bit octahedral encoding
+    template <typename UInt32_>
+    MI_INLINE static auto decode_normal(const UInt32_ &value) {
+        using Value = dr::replace_scalar_t<UInt32_, InputFloat>;
+        Value x = Value(value & 0xFFFFu) * (2.f / 65535.f) - 1.f,
+              y = Value(value >> 16) * (2.f / 65535.f) - 1.f,
+              z = 1.f - dr::abs(x) - dr::abs(y),
+              t = dr::maximum(-z, 0.f);
+        x = dr::select(x >= 0.f, x - t, x + t);
+        y = dr::select(y >= 0.f, y - t, y + t);
+        return dr::normalize(Normal<Value, 3>(x, y, z));
+    }
+
+    /// Decode a texture coordinate quantized to 16 bits per component
+    template <typename UInt32_>
+    MI_INLINE auto decode_texcoord(const UInt32_ &value) const {
+        using Value = dr::replace_scalar_t<UInt32_, InputFloat>;
+        using Result = Point<Value, 2>;
+        return dr::fmadd(Result(Value(value & 0xFFFFu), Value(value >> 16)),
+                         Result(m_texcoord_scale), Result(m_texcoord_offset));
+    }
+
     // Ensures that the sampling table are ready.
     DRJIT_INLINE void ensure_pmf_built() const {
         if (unlikely(m_area_pmf.empty()))
@@ -491,15 +669,44 @@ protected:
         size_t size;
         MeshAttributeType type;
         mutable FloatStorage buf;
+        /// Handle of the attribute name (see \ref Shape::attribute_handle())
+        uint32_t handle = 0;
+        /// Offset within a record of \ref m_vertex_attributes_interleaved
+        uint32_t offset = 0;
 
         MeshAttribute migrate(AllocType at) const {
-            return MeshAttribute { size, type, dr::migrate(buf, at) };
+            return MeshAttribute { size, type, dr::migrate(buf, at), handle, offset };
         }
     };
 
+    /// Return the attribute associated with a handle, or \c nullptr
+    const MeshAttribute *attribute_slot(uint32_t handle) const {
+        return handle < m_attribute_slots.size() ? m_attribute_slots[handle]
+                                                 : nullptr;
+    }
+
+    /**
+     * \brief Interleave the vertex attributes into a single buffer
+     *
+     * In scalar variants, a mesh with several vertex attributes stores a copy
+     * of them with one record per vertex, so that evaluating them at the
+     * same shading point touches the same cache lines. Attribute arrays
+     * otherwise stay separate (which is what vectorized gathers want).
+     */
+    void build_interleaved_attributes();
+
+    UnpolarizedSpectrum eval_mesh_attribute(const MeshAttribute &attr,
+                                            const SurfaceInteraction3f &si,
+                                            Mask active) const;
+    Float eval_mesh_attribute_1(const MeshAttribute &attr,
+                                const SurfaceInteraction3f &si,
+                                Mask active) const;
+    Color3f eval_mesh_attribute_3(const MeshAttribute &attr,
+                                  const SurfaceInteraction3f &si,
+                                  Mask active) const;
+
     template <uint32_t Size, bool Raw>
-    auto interpolate_attribute(MeshAttributeType type,
-                               const FloatStorage &buf,
+    auto interpolate_attribute(const MeshAttribute &attr,
                                const SurfaceInteraction3f &si,
                                Mask active) const {
         using StorageType =
@@ -508,13 +715,28 @@ protected:
                                dr::replace_scalar_t<Color3f, InputFloat>>;
         using ReturnType = std::conditional_t<Size == 1, Float, Color3f>;
 
-        if (type == MeshAttributeType::Vertex) {
+        if (attr.type == MeshAttributeType::Vertex) {
             auto fi = face_indices(si.prim_index, active);
             Point3f b = barycentric_coordinates(si, active);
 
-            StorageType v0 = dr::gather<StorageType>(buf, fi[0], active),
-                        v1 = dr::gather<StorageType>(buf, fi[1], active),
-                        v2 = dr::gather<StorageType>(buf, fi[2], active);
+            auto fetch = [&](const UInt32 &vertex) {
+                if constexpr (!dr::is_jit_v<Float>) {
+                    if (m_vertex_attribute_stride > 0 && active) {
+                        const InputFloat *ptr =
+                            m_vertex_attributes_interleaved.data() +
+                            vertex * m_vertex_attribute_stride + attr.offset;
+                        if constexpr (Size == 1)
+                            return StorageType(ptr[0]);
+                        else
+                            return StorageType(ptr[0], ptr[1], ptr[2]);
+                    }
+                }
+                return dr::gather<StorageType>(attr.buf, vertex, active);
+            };
+
+            StorageType v0 = fetch(fi[0]),
+                        v1 = fetch(fi[1]),
+                        v2 = fetch(fi[2]);
 
             // Barycentric interpolation
             if constexpr (is_spectral_v<Spectrum> && Size == 3 && !Raw) {
@@ -532,7 +754,7 @@ protected:
                 return (ReturnType) dr::fmadd(v0, b[0], dr::fmadd(v1, b[1], v2 * b[2]));
             }
         } else {
-            StorageType v = dr::gather<StorageType>(buf, si.prim_index, active);
+            StorageType v = dr::gather<StorageType>(attr.buf, si.prim_index, active);
             if constexpr (is_spectral_v<Spectrum> && Size == 3 && !Raw) {
                 return srgb_model_eval<UnpolarizedSpectrum>(v, si.wavelengths);
             } else {
@@ -552,6 +774,15 @@ protected:
     mutable FloatStorage m_vertex_normals;
     mutable FloatStorage m_vertex_texcoords;
 
+    /// Compact vertex layout (see \ref compact_vertex_data())
+    mutable DynamicBuffer<UInt32> m_vertex_normals_compact;
+    mutable DynamicBuffer<UInt32> m_vertex_texcoords_compact;
+    dr::Array<InputFloat, 2> m_texcoord_offset = 0.f, m_texcoord_scale = 0.f;
+
+    /// Interleaved vertex layout (see \ref interleave_vertex_data())
+    FloatStorage m_vertex_data_interleaved;
+    uint32_t m_vertex_stride = 0, m_vertex_texcoord_offset = 0;
+
     mutable DynamicBuffer<UInt32> m_faces;
 
     /// Directed edges data structures to support neighbor queries
@@ -564,6 +795,38 @@ protected:
     /// Sampling density of silhouette (\ref build_indirect_silhouette_distribution)
     DiscreteDistribution<Float> m_sil_dedge_pmf;
 
+    /// Edge of the silhouette hierarchy (\ref update_silhouette_tree())
+    struct SilhouetteTreeEdge {
+        ScalarIndex dedge;
+        ScalarPoint3f p0, p1;
+        /// Normals of the face of the edge and of its opposite face
+        ScalarVector3f n0, n1;
+    };
+
+    /**
+     * \brief Node of the silhouette hierarchy
+     *
+     * Bounds the endpoints of the edges below it, and the normals of their
+     * adjacent faces with a cone (of half-angle \c theta).
+     */
+    struct SilhouetteTreeNode {
+        ScalarBoundingBox3f bbox;
+        ScalarVector3f axis;
+        ScalarFloat theta;
+        /// Index of the second child (inner nodes) or of the first edge (leaves)
+        uint32_t offset;
+        /// Number of edges of a leaf, zero for inner nodes
+        uint32_t count;
+    };
+
+    /* Host-side hierarchy over the interior edges, and list of boundary edges,
+       used to find the silhouette as seen from a point in sublinear time */
+    mutable std::vector<SilhouetteTreeNode> m_sil_tree_nodes;
+    mutable std::vector<SilhouetteTreeEdge> m_sil_tree_edges;
+    mutable std::vector<SilhouetteTreeEdge> m_sil_boundary_edges;
+    mutable bool m_sil_tree_outdated = true;
+    mutable bool m_sil_tree_refit = false;
+
 #if defined(MI_ENABLE_LLVM) && !defined(MI_ENABLE_EMBREE)
     /* Data pointer to ensure triangle intersection routine doesn't rely on
        drjit-core when called from an LLVM kernel */
@@ -573,6 +836,13 @@ protected:
 
     std::unordered_map<std::string, MeshAttribute> m_mesh_attributes;
 
+    /// Attributes indexed by their handle (see \ref Shape::attribute_handle())
+    std::vector<const MeshAttribute *> m_attribute_slots;
+
+    /// Interleaved copy of the vertex attributes (scalar variants only)
+    FloatStorage m_vertex_attributes_interleaved;
+    uint32_t m_vertex_attribute_stride = 0;
+
 #if defined(MI_ENABLE_CUDA)
     mutable void* m_vertex_buffer_ptr = nullptr;
 #endif
@@ -581,6 +851,15 @@ protected:
     bool m_face_normals = false;
     bool m_flip_normals = false;
 
+    /// Sample directions towards the mesh by solid angle, see \ref sample_direction()
+    bool m_solid_angle_sampling = false;
+
+    /// Store normals and texture coordinates compactly, see \ref compact_vertex_data()
+    bool m_compact_vertices = false;
+
+    /// Also store the vertices interleaved, see \ref interleave_vertex_data()
+    bool m_interleaved_vertices = false;
+
     /* Surface area distribution -- generated on demand when \ref
        prepare_area_pmf() is first called. */
     DiscreteDistribution<Float> m_area_pmf;
@@ -591,6 +870,9 @@ protected:
 
     /// Pointer to the scene that owns this mesh
     Scene<Float, Spectrum>* m_scene = nullptr;
+
+    /// Memory held by the vertex, face and attribute buffers
+    MemoryAllocation m_memory { MemoryCategory::Mesh };
 };
 
 MI_EXTERN_CLASS(Mesh)
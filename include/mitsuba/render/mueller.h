@@ -286,6 +286,56 @@ Vector3 stokes_basis(const Vector3 &forward) {
     return coordinate_system(forward).first;
 }
 
+NAMESPACE_BEGIN(detail)
+
+/**
+ * Cosine and sine of twice the angle between two Stokes bases of the same
+ * direction of travel, which define the rotator that aligns them. They are
+ * computed from the dot and cross product of the bases, without evaluating the
+ * angle itself.
+ */
+template <typename Vector3, typename Float = dr::value_t<Vector3>>
+std::pair<Float, Float> stokes_basis_rotation(const Vector3 &forward,
+                                              const Vector3 &basis_current,
+                                              const Vector3 &basis_target) {
+    Vector3 a = dr::normalize(basis_current),
+            b = dr::normalize(basis_target);
+    Float c = dr::dot(a, b),
+          s = dr::dot(forward, dr::cross(a, b)),
+          r2 = dr::fmadd(c, c, s * s);
+    auto valid = r2 > 0.f;
+    Float inv_r2 = dr::select(valid, dr::rcp(r2), 0.f);
+    return { dr::select(valid, dr::fmsub(c, c, s * s) * inv_r2, 1.f),
+             2.f * c * s * inv_r2 };
+}
+
+/**
+ * Computes <tt>R * M</tt> for the rotator \c R with the given cosine and sine
+ * of twice its angle, which only mixes the second and third rows of \c M
+ */
+template <typename MuellerMatrix, typename Float>
+MuellerMatrix rotate_rows(MuellerMatrix M, const Float &c, const Float &s) {
+    for (size_t j = 0; j < 4; ++j) {
+        auto m1 = M(1, j), m2 = M(2, j);
+        M(1, j) = c * m1 + s * m2;
+        M(2, j) = c * m2 - s * m1;
+    }
+    return M;
+}
+
+/// Computes <tt>M * transpose(R)</tt>, see \ref rotate_rows()
+template <typename MuellerMatrix, typename Float>
+MuellerMatrix rotate_columns(MuellerMatrix M, const Float &c, const Float &s) {
+    for (size_t i = 0; i < 4; ++i) {
+        auto m1 = M(i, 1), m2 = M(i, 2);
+        M(i, 1) = c * m1 + s * m2;
+        M(i, 2) = c * m2 - s * m1;
+    }
+    return M;
+}
+
+NAMESPACE_END(detail)
+
 /**
  * \brief Gives the Mueller matrix that aligns the reference frames (defined by
  * their respective basis vectors) of two collinear stokes vectors.
@@ -315,11 +365,13 @@ template <typename Vector3,
 MuellerMatrix rotate_stokes_basis(const Vector3 &forward,
                                   const Vector3 &basis_current,
                                   const Vector3 &basis_target) {
-    Float theta = unit_angle(dr::normalize(basis_current),
-                             dr::normalize(basis_target));
-
-    dr::masked(theta, dr::dot(forward, dr::cross(basis_current, basis_target)) < 0) *= -1.f;
-    return rotator(theta);
+    auto [c, s] = detail::stokes_basis_rotation(forward, basis_current, basis_target);
+    return MuellerMatrix(
+        1, 0, 0, 0,
+        0, c, s, 0,
+        0, -s, c, 0,
+        0, 0, 0, 1
+    );
 }
 
 /**
@@ -365,9 +417,11 @@ MuellerMatrix rotate_mueller_basis(const MuellerMatrix &M,
                                    const Vector3 &out_forward,
                                    const Vector3 &out_basis_current,
                                    const Vector3 &out_basis_target) {
-    MuellerMatrix R_in  = rotate_stokes_basis(in_forward, in_basis_current, in_basis_target);
-    MuellerMatrix R_out = rotate_stokes_basis(out_forward, out_basis_current, out_basis_target);
-    return R_out * M * transpose(R_in);
+    auto [c_in, s_in] =
+        detail::stokes_basis_rotation(in_forward, in_basis_current, in_basis_target);
+    auto [c_out, s_out] =
+        detail::stokes_basis_rotation(out_forward, out_basis_current, out_basis_target);
+    return detail::rotate_columns(detail::rotate_rows(M, c_out, s_out), c_in, s_in);
 }
 
 /**
@@ -401,8 +455,8 @@ MuellerMatrix rotate_mueller_basis_collinear(const MuellerMatrix &M,
                                              const Vector3 &forward,
                                              const Vector3 &basis_current,
                                              const Vector3 &basis_target) {
-    MuellerMatrix R = rotate_stokes_basis(forward, basis_current, basis_target);
-    return R * M * transpose(R);
+    auto [c, s] = detail::stokes_basis_rotation(forward, basis_current, basis_target);
+    return detail::rotate_columns(detail::rotate_rows(M, c, s), c, s);
 }
 
 NAMESPACE_END(mueller)
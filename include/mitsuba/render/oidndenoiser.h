@@ -0,0 +1,182 @@
+#pragma once
+
+#if defined(MI_ENABLE_OIDN)
+
+#include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/render/fwd.h>
+#include <drjit/tensor.h>
+
+struct OIDNDeviceImpl;
+struct OIDNFilterImpl;
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Wrapper for the Intel Open Image Denoise (OIDN) CPU denoiser
+ *
+ * This object provides the interface of \ref OptixDenoiser on the CPU, and
+ * can therefore be used with all variants. The inputs of JIT variants are
+ * migrated to host memory before denoising.
+ *
+ * The denoiser uses as many threads as Mitsuba's thread pool. Like the OptiX
+ * denoiser, it works best with noisy renderings that were produced with a
+ * \ref Film which used the `box` \ref ReconstructionFilter.
+ */
+template <typename Float, typename Spectrum>
+class MI_EXPORT_LIB OIDNDenoiser : public Object {
+public:
+    MI_IMPORT_TYPES()
+
+    /**
+     * \brief Constructs an OIDN denoiser
+     *
+     * \param input_size
+     *      Resolution of noisy images that will be fed to the denoiser.
+     *
+     * \param albedo
+     *      Whether or not albedo information will also be given to the
+     *      denoiser.
+     *
+     * \param normals
+     *      Whether or not shading normals information will also be given to the
+     *      Denoiser.
+     *
+     * \param prefilter
+     *      Whether the albedo and normals should be denoised before they guide
+     *      the denoising of the noisy input. This improves the quality when
+     *      the guides are noisy themselves, e.g. due to depth of field or
+     *      motion blur.
+     *
+     * \return A callable object which will apply the OIDN denoiser.
+     */
+    OIDNDenoiser(const ScalarVector2u &input_size, bool albedo, bool normals,
+                 bool prefilter);
+
+    OIDNDenoiser(const OIDNDenoiser &other) = delete;
+
+    OIDNDenoiser& operator=(const OIDNDenoiser &other) = delete;
+
+    ~OIDNDenoiser();
+
+    /**
+     * \brief Apply denoiser on inputs which are \ref TensorXf objects.
+     *
+     * The noisy input is copied into the output, which is then denoised in
+     * place.
+     *
+     * \param noisy
+     *      The noisy input. (tensor shape: (width, height, 3 | 4))
+     *
+     * \param denoise_alpha
+     *      Whether or not the alpha channel (if specified in the noisy input)
+     *      should be denoised too. Otherwise, it is copied to the output.
+     *      This parameter is optional, by default it is true.
+     *
+     * \param albedo
+     *      Albedo information of the noisy rendering.
+     *      This parameter is optional unless the OIDNDenoiser was built with
+     *      albedo support. (tensor shape: (width, height, 3))
+     *
+     * \param normals
+     *      Shading normal information of the noisy rendering.
+     *      This parameter is optional unless the OIDNDenoiser was built with
+     *      normals support. (tensor shape: (width, height, 3))
+     *
+     * \param to_sensor
+     *      A \ref Transform4f which is applied to the \c normals parameter
+     *      before denoising. OIDN accepts normals in any coordinate frame, as
+     *      long as it is the same for all pixels.
+     *      This parameter is optional, by default no transformation is
+     *      applied.
+     *
+     * \return The denoised input.
+     */
+    TensorXf operator()(const TensorXf &noisy,
+                        bool denoise_alpha = true,
+                        const TensorXf &albedo = TensorXf(),
+                        const TensorXf &normals = TensorXf(),
+                        const Transform4f &to_sensor = Transform4f()) const;
+
+    /**
+     * \brief Apply denoiser on inputs which are \ref Bitmap objects.
+     *
+     * \param noisy
+     *      The noisy input. When passing additional information like albedo or
+     *      normals to the denoiser, this \ref Bitmap object must be a \ref
+     *      MultiChannel bitmap, such as the output of the `aov` integrator.
+     *
+     * \param denoise_alpha
+     *      Whether or not the alpha channel (if specified in the noisy input)
+     *      should be denoised too.
+     *      This parameter is optional, by default it is true.
+     *
+     * \param albedo_ch
+     *      The name of the channel in the \c noisy parameter which contains
+     *      the albedo information of the noisy rendering.
+     *      This parameter is optional unless the OIDNDenoiser was built with
+     *      albedo support.
+     *
+     * \param normals_ch
+     *      The name of the channel in the \c noisy parameter which contains
+     *      the shading normal information of the noisy rendering.
+     *      This parameter is optional unless the OIDNDenoiser was built with
+     *      normals support.
+     *
+     * \param to_sensor
+     *      A \ref Transform4f which is applied to the \c normals parameter
+     *      before denoising.
+     *      This parameter is optional, by default no transformation is
+     *      applied.
+     *
+     * \param noisy_ch
+     *      The name of the channel in the \c noisy parameter which contains
+     *      the noisy rendering.
+     *
+     * \return The denoised input.
+     */
+    ref<Bitmap> operator()(const ref<Bitmap> &noisy,
+                           bool denoise_alpha = true,
+                           const std::string &albedo_ch = "",
+                           const std::string &normals_ch = "",
+                           const Transform4f &to_sensor = Transform4f(),
+                           const std::string &noisy_ch = "<root>") const;
+
+    virtual std::string to_string() const override;
+
+    MI_DECLARE_CLASS()
+
+private:
+    /// Helper function to validate tensor sizes
+    void validate_input(const TensorXf &noisy,
+                        const TensorXf &albedo,
+                        const TensorXf &normals) const;
+
+    /**
+     * \brief Denoise host images in place
+     *
+     * \c color has \c channels interleaved channels, and \c albedo and
+     * \c normals (if not null) have three. The guides are overwritten when
+     * they are prefiltered.
+     */
+    void denoise(float *color, uint32_t channels, bool denoise_alpha,
+                 float *albedo, float *normals,
+                 const ScalarTransform4f &to_sensor) const;
+
+    /// Raise an exception if the OIDN device reported an error
+    void check_error() const;
+
+    ScalarVector2u m_input_size;
+    bool m_albedo;
+    bool m_normals;
+    bool m_prefilter;
+    OIDNDeviceImpl *m_device;
+    OIDNFilterImpl *m_filter;
+    OIDNFilterImpl *m_albedo_filter;
+    OIDNFilterImpl *m_normals_filter;
+};
+
+MI_EXTERN_CLASS(OIDNDenoiser)
+NAMESPACE_END(mitsuba)
+
+#endif // defined(MI_ENABLE_OIDN)
@@ -17,6 +17,7 @@
 
 #include <drjit-core/optix.h>
 
+#include <mitsuba/core/memory.h>
 #include <mitsuba/render/optix/common.h>
 #include <mitsuba/render/optix_api.h>
 #include <mitsuba/render/shape.h>
@@ -90,33 +91,142 @@ size_t get_shape_descr_idx(Shape *shape) {
           "'OPTIX_SHAPE_TYPE_NAMES' table.", name);
 }
 
+/**
+ * \brief Bit mask of the OptiX shape types of a list of shapes
+ *
+ * Bit \c i is set when a shape of type <tt>OPTIX_SHAPE_ORDER[i]</tt> (see
+ * \ref get_shape_descr_idx()) is in the list. Meshes and instances are
+ * ignored.
+ */
+template <typename Shape>
+uint32_t optix_shape_types(const std::vector<ref<Shape>> &shapes) {
+    uint32_t types = 0;
+    for (const ref<Shape> &shape : shapes)
+        if (!shape->is_mesh() && !shape->is_instance())
+            types |= 1u << get_shape_descr_idx(shape.get());
+    return types;
+}
+
 /// Stores multiple OptiXTraversables: one for the each type
 struct OptixAccelData {
     struct HandleData {
         OptixTraversableHandle handle = 0ull;
         void* buffer = nullptr;
         uint32_t count = 0u;
+        /// Is the buffer owned by the process-wide GAS cache?
+        bool cached = false;
+        /// Size of the buffer (only accounted for here when not cached)
+        size_t size = 0;
+
+        void release() {
+            if (buffer) {
+                if (cached) {
+                    optix_gas_cache_release(buffer);
+                } else {
+                    MemoryTracker::release(MemoryCategory::OptiX, size, true);
+                    jit_free(buffer);
+                }
+            }
+            handle = 0ull;
+            buffer = nullptr;
+            count = 0;
+            cached = false;
+            size = 0;
+        }
     };
     HandleData meshes;
     HandleData bspline_curves;
     HandleData linear_curves;
+    HandleData spheres;
     HandleData custom_shapes;
 
     ~OptixAccelData() {
-        if (meshes.buffer) jit_free(meshes.buffer);
-        if (bspline_curves.buffer) jit_free(bspline_curves.buffer);
-        if (linear_curves.buffer) jit_free(linear_curves.buffer);
-        if (custom_shapes.buffer) jit_free(custom_shapes.buffer);
+        meshes.release();
+        bspline_curves.release();
+        linear_curves.release();
+        spheres.release();
+        custom_shapes.release();
     }
 };
 
+/// Memory usage of the geometry acceleration structures built by \ref build_gas()
+struct OptixGASStatistics {
+    /// Number of GASes
+    size_t count = 0;
+    /// Number of GASes that were found in the GAS cache
+    size_t cache_hits = 0;
+    /// Size of the built GASes before compaction (in bytes)
+    size_t output_size = 0;
+    /// Size of the built GASes after compaction (in bytes)
+    size_t compacted_size = 0;
+};
+
+/**
+ * \brief Compute the key identifying a GAS in the process-wide GAS cache
+ *
+ * The key covers the device, the build options and the contents of all
+ * build inputs (which are read back from the device). Returns zero for
+ * build inputs that cannot be cached (curves and built-in spheres).
+ */
+inline uint64_t optix_gas_cache_key(const OptixAccelBuildOptions &accel_options,
+                                    const std::vector<OptixBuildInput> &build_inputs) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto hash_value = [&hash](uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash ^= (value >> (8 * i)) & 0xFF;
+            hash *= 0x100000001b3ull;
+        }
+    };
+
+    hash_value((uint64_t) jit_cuda_device());
+    hash_value((uint64_t) accel_options.buildFlags);
+
+    for (const OptixBuildInput &input : build_inputs) {
+        hash_value((uint64_t) input.type);
+        if (input.type == OPTIX_BUILD_INPUT_TYPE_TRIANGLES) {
+            const OptixBuildInputTriangleArray &t = input.triangleArray;
+            size_t vertex_stride = t.vertexStrideInBytes ? t.vertexStrideInBytes : 3 * sizeof(float),
+                   index_stride  = t.indexStrideInBytes ? t.indexStrideInBytes : 3 * sizeof(uint32_t);
+            hash_value(t.numVertices);
+            hash_value(t.numIndexTriplets);
+            hash_value((uint64_t) t.vertexFormat);
+            hash_value((uint64_t) t.indexFormat);
+            hash_value(t.numSbtRecords);
+            hash_value(t.flags ? t.flags[0] : 0);
+            hash = optix_hash_device_memory(hash, t.vertexBuffers[0],
+                                            t.numVertices * vertex_stride);
+            hash = optix_hash_device_memory(hash, t.indexBuffer,
+                                            t.numIndexTriplets * index_stride);
+        } else if (input.type == OPTIX_BUILD_INPUT_TYPE_CUSTOM_PRIMITIVES) {
+            const OptixBuildInputCustomPrimitiveArray &c = input.customPrimitiveArray;
+            size_t stride = c.strideInBytes ? c.strideInBytes : 6 * sizeof(float);
+            hash_value(c.numPrimitives);
+            hash_value(c.numSbtRecords);
+            hash_value(c.flags ? c.flags[0] : 0);
+            hash = optix_hash_device_memory(hash, c.aabbBuffers[0],
+                                            c.numPrimitives * stride);
+        } else {
+            return 0;
+        }
+    }
+
+    return hash ? hash : 1;
+}
+
+/// Is the shape traced as a built-in OptiX sphere? (see \ref optix_builtin_spheres())
+template <typename Shape>
+bool is_builtin_sphere(const Shape *shape) {
+    return shape->shape_type() == +ShapeType::Sphere && optix_builtin_spheres();
+}
+
 /// Creates and appends the HitGroupSbtRecord for a given list of shapes
 template <typename Shape>
 void fill_hitgroup_records(std::vector<ref<Shape>> &shapes,
                            std::vector<HitGroupSbtRecord> &out_hitgroup_records,
                            const OptixProgramGroup *program_groups) {
 
-    // Fill records in this order: meshes, b-spline curves, linear curves, other
+    // Fill records in this order: meshes, b-spline curves, linear curves,
+    // built-in spheres, other
     struct {
         size_t idx(const ref<Shape>& shape) const {
             uint32_t type = shape->shape_type();
@@ -126,7 +236,9 @@ void fill_hitgroup_records(std::vector<ref<Shape>> &shapes,
                 return 1;
             if (type == +ShapeType::LinearCurve)
                 return 2;
-            return 3;
+            if (is_builtin_sphere(shape.get()))
+                return 3;
+            return 4;
         };
 
         bool operator()(const ref<Shape> &a, const ref<Shape> &b) const {
@@ -145,17 +257,24 @@ void fill_hitgroup_records(std::vector<ref<Shape>> &shapes,
 /**
  * \brief Build OptiX geometry acceleration structures (GAS) for a given list of shapes.
  *
- * Two different GAS will be created for the meshes and the custom shapes. Optix
- * handles to those GAS will be stored in an \ref OptixAccelData.
+ * Separate GAS will be created for the meshes, curves, built-in spheres and the
+ * custom shapes. Optix handles to those GAS will be stored in an
+ * \ref OptixAccelData.
+ *
+ * The builds are enqueued without intermediate synchronization: the host only
+ * waits once for the shape data to be uploaded and once for the compacted
+ * sizes of all GAS.
  */
 template <typename Shape>
 void build_gas(const OptixDeviceContext &context,
                const std::vector<ref<Shape>> &shapes,
-               OptixAccelData& out_accel) {
+               OptixAccelData& out_accel,
+               bool use_cache = false,
+               OptixGASStatistics *stats = nullptr) {
 
     // Separate geometry types
     std::vector<ref<Shape>> meshes, bspline_curves,
-        linear_curves, custom_shapes;
+        linear_curves, spheres, custom_shapes;
     for (auto shape : shapes) {
         uint32_t type = shape->shape_type();
         if (type == +ShapeType::Mesh)
@@ -164,62 +283,105 @@ void build_gas(const OptixDeviceContext &context,
             bspline_curves.push_back(shape);
         else if (type == +ShapeType::LinearCurve)
             linear_curves.push_back(shape);
+        else if (is_builtin_sphere(shape.get()))
+            spheres.push_back(shape);
         else if (!shape->is_instance())
             custom_shapes.push_back(shape);
     }
 
-    // Build a GAS given a subset of shape pointers
-    auto build_single_gas = [&context](const std::vector<ref<Shape>> &shape_subset,
-                                       OptixAccelData::HandleData &handle) {
-
-        OptixAccelBuildOptions accel_options = {};
-        accel_options.buildFlags = OPTIX_BUILD_FLAG_ALLOW_COMPACTION |
-                                   OPTIX_BUILD_FLAG_PREFER_FAST_TRACE;
-
-        accel_options.operation  = OPTIX_BUILD_OPERATION_BUILD;
-        accel_options.motionOptions.numKeys = 0;
-        if (handle.buffer) {
-            jit_free(handle.buffer);
-            handle.handle = 0ull;
-            handle.buffer = nullptr;
-            handle.count = 0;
-        }
+    OptixAccelBuildOptions accel_options = {};
+    accel_options.buildFlags = OPTIX_BUILD_FLAG_ALLOW_COMPACTION |
+                               OPTIX_BUILD_FLAG_PREFER_FAST_TRACE;
+    accel_options.operation  = OPTIX_BUILD_OPERATION_BUILD;
+    accel_options.motionOptions.numKeys = 0;
 
-        size_t shapes_count = shape_subset.size();
-        if (shapes_count == 0)
-            return;
+    // GAS whose build was enqueued, but which still need to be compacted
+    struct PendingGAS {
+        OptixAccelData::HandleData *handle;
+        OptixTraversableHandle accel;
+        void *output_buffer;
+        size_t output_size;
+        uint32_t count;
+        uint64_t key;
+    };
+
+    // Order: meshes, b-spline curves, linear curves, built-in spheres, other
+    std::pair<const std::vector<ref<Shape>> *, OptixAccelData::HandleData *> subsets[] = {
+        { &custom_shapes, &out_accel.custom_shapes },
+        { &meshes, &out_accel.meshes },
+        { &bspline_curves, &out_accel.bspline_curves },
+        { &linear_curves, &out_accel.linear_curves },
+        { &spheres, &out_accel.spheres }
+    };
+    constexpr size_t subset_count = sizeof(subsets) / sizeof(subsets[0]);
+
+    scoped_optix_context guard;
+
+    std::vector<OptixBuildInput> build_inputs[subset_count];
+    for (size_t i = 0; i < subset_count; ++i) {
+        subsets[i].second->release();
+        const std::vector<ref<Shape>> &shape_subset = *subsets[i].first;
+        build_inputs[i].resize(shape_subset.size());
+        for (size_t j = 0; j < shape_subset.size(); j++)
+            shape_subset[j]->optix_build_input(build_inputs[i][j]);
+    }
 
-        std::vector<OptixBuildInput> build_inputs(shapes_count);
-        for (size_t i = 0; i < shapes_count; i++)
-            shape_subset[i]->optix_build_input(build_inputs[i]);
+    /* Ensure shape data pointers are fully evaluated before building the BVH.
+       A single wait covers the uploads of all shapes, after which the builds
+       of the different GAS are enqueued back to back on the stream. */
+    dr::sync_thread();
 
-        // Ensure shape data pointers are fully evaluated before building the BVH
-        dr::sync_thread();
+    // Compacted sizes of all GAS, emitted by the builds into a single buffer
+    uint64_t *compact_sizes_d =
+        (uint64_t *) jit_malloc(AllocType::Device, subset_count * sizeof(uint64_t));
+    std::vector<PendingGAS> pending;
+
+    for (size_t i = 0; i < subset_count; ++i) {
+        OptixAccelData::HandleData &handle = *subsets[i].second;
+        std::vector<OptixBuildInput> &inputs = build_inputs[i];
+        uint32_t shapes_count = (uint32_t) inputs.size();
+        if (shapes_count == 0)
+            continue;
+
+        // Reuse an identical GAS built for another scene (or an earlier load)
+        uint64_t key = use_cache ? optix_gas_cache_key(accel_options, inputs) : 0;
+        if (key) {
+            void *buffer = optix_gas_cache_acquire(key, &handle.handle);
+            if (buffer) {
+                handle.buffer = buffer;
+                handle.count  = shapes_count;
+                handle.cached = true;
+                if (stats) {
+                    stats->count++;
+                    stats->cache_hits++;
+                }
+                continue;
+            }
+        }
 
         OptixAccelBufferSizes buffer_sizes;
         jit_optix_check(optixAccelComputeMemoryUsage(
             context,
             &accel_options,
-            build_inputs.data(),
-            (unsigned int) shapes_count,
+            inputs.data(),
+            shapes_count,
             &buffer_sizes
         ));
 
         void* d_temp_buffer = jit_malloc(AllocType::Device, buffer_sizes.tempSizeInBytes);
         void* output_buffer = jit_malloc(AllocType::Device, buffer_sizes.outputSizeInBytes);
-        void* compact_size_buffer = jit_malloc(AllocType::Device, 8);
 
         OptixAccelEmitDesc emit_property = {};
         emit_property.type   = OPTIX_PROPERTY_TYPE_COMPACTED_SIZE;
-        emit_property.result = (CUdeviceptr) compact_size_buffer; // needs to be aligned
+        emit_property.result = (CUdeviceptr) (compact_sizes_d + pending.size()); // needs to be aligned
 
         OptixTraversableHandle accel;
         jit_optix_check(optixAccelBuild(
             context,
             (CUstream) jit_cuda_stream(),
             &accel_options,
-            build_inputs.data(),
-            (unsigned int) shapes_count,
+            inputs.data(),
+            shapes_count,
             (CUdeviceptr) d_temp_buffer,
             buffer_sizes.tempSizeInBytes,
             (CUdeviceptr) output_buffer,
@@ -230,41 +392,55 @@ void build_gas(const OptixDeviceContext &context,
         ));
 
         jit_free(d_temp_buffer);
+        pending.push_back({ &handle, accel, output_buffer,
+                            buffer_sizes.outputSizeInBytes, shapes_count, key });
+    }
+
+    // Fetch the compacted sizes of all builds at once
+    uint64_t compact_sizes[subset_count];
+    if (!pending.empty())
+        jit_memcpy(JitBackend::CUDA, compact_sizes, compact_sizes_d,
+                   pending.size() * sizeof(uint64_t));
+    jit_free(compact_sizes_d);
 
-        size_t compact_size;
-        jit_memcpy(JitBackend::CUDA,
-                   &compact_size,
-                   (void*)emit_property.result,
-                   sizeof(size_t));
-        jit_free(emit_property.result);
+    for (size_t i = 0; i < pending.size(); ++i) {
+        PendingGAS &p = pending[i];
+        size_t compact_size = (size_t) compact_sizes[i];
 
-        if (compact_size < buffer_sizes.outputSizeInBytes) {
+        if (compact_size < p.output_size) {
             void* compact_buffer = jit_malloc(AllocType::Device, compact_size);
             // Use handle as input and output
             jit_optix_check(optixAccelCompact(
                 context,
                 (CUstream) jit_cuda_stream(),
-                accel,
+                p.accel,
                 (CUdeviceptr) compact_buffer,
                 compact_size,
-                &accel
+                &p.accel
             ));
-            jit_free(output_buffer);
-            output_buffer = compact_buffer;
+            jit_free(p.output_buffer);
+            p.output_buffer = compact_buffer;
         }
 
-        handle.handle = accel;
-        handle.buffer = output_buffer;
-        handle.count = (uint32_t) shapes_count;
-    };
-
-    scoped_optix_context guard;
+        size_t final_size = std::min(compact_size, p.output_size);
+        if (stats) {
+            stats->count++;
+            stats->output_size += p.output_size;
+            stats->compacted_size += final_size;
+        }
 
-    // Order: meshes, b-spline curves, linear curves, other
-    build_single_gas(custom_shapes, out_accel.custom_shapes);
-    build_single_gas(meshes, out_accel.meshes);
-    build_single_gas(bspline_curves, out_accel.bspline_curves);
-    build_single_gas(linear_curves, out_accel.linear_curves);
+        if (p.key)
+            optix_gas_cache_insert(p.key, p.output_buffer, p.accel, final_size);
+        else
+            MemoryTracker::allocate(MemoryCategory::OptiX, final_size, true);
+
+        OptixAccelData::HandleData &handle = *p.handle;
+        handle.handle = p.accel;
+        handle.buffer = p.output_buffer;
+        handle.count  = p.count;
+        handle.cached = p.key != 0;
+        handle.size   = final_size;
+    }
 }
 
 /// Prepares and fills the \ref OptixInstance array associated with a given list of shapes.
@@ -302,10 +478,11 @@ void prepare_ias(const OptixDeviceContext &context,
         }
     };
 
-    // Order: meshes, b-spline curves, linear curves, other
+    // Order: meshes, b-spline curves, linear curves, built-in spheres, other
     build_optix_instance(accel.meshes);
     build_optix_instance(accel.bspline_curves);
     build_optix_instance(accel.linear_curves);
+    build_optix_instance(accel.spheres);
     build_optix_instance(accel.custom_shapes);
 
     // Apply the same process to every shape instances
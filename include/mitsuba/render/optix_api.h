@@ -3,6 +3,8 @@
 #if defined(MI_ENABLE_CUDA)
 
 #include <iomanip>
+#include <string>
+#include <utility>
 #include <mitsuba/core/platform.h>
 
 // =====================================================
@@ -21,6 +23,7 @@ using OptixBuildInputType    = int;
 using OptixVertexFormat      = int;
 using OptixIndicesFormat     = int;
 using OptixTransformFormat   = int;
+using OptixTraversableType   = int;
 using OptixAccelPropertyType = int;
 using OptixProgramGroupKind  = int;
 using OptixPrimitiveType     = int;
@@ -36,6 +39,7 @@ using OptixDenoiserStructPtr = void*;
 #define OPTIX_BUILD_INPUT_TYPE_CUSTOM_PRIMITIVES 0x2142
 #define OPTIX_BUILD_INPUT_TYPE_INSTANCES         0x2143
 #define OPTIX_BUILD_INPUT_TYPE_CURVES            0x2145
+#define OPTIX_BUILD_INPUT_TYPE_SPHERES           0x2146
 #define OPTIX_BUILD_OPERATION_BUILD              0x2161
 
 #define OPTIX_GEOMETRY_FLAG_NONE           0
@@ -71,10 +75,12 @@ using OptixDenoiserStructPtr = void*;
 
 #define OPTIX_PRIMITIVE_TYPE_ROUND_CUBIC_BSPLINE 0x2502
 #define OPTIX_PRIMITIVE_TYPE_ROUND_LINEAR        0x2503
+#define OPTIX_PRIMITIVE_TYPE_SPHERE              0x2506
 
 #define OPTIX_PRIMITIVE_TYPE_FLAGS_CUSTOM              (1 << 0)
 #define OPTIX_PRIMITIVE_TYPE_FLAGS_ROUND_CUBIC_BSPLINE (1 << 2)
 #define OPTIX_PRIMITIVE_TYPE_FLAGS_ROUND_LINEAR        (1 << 3)
+#define OPTIX_PRIMITIVE_TYPE_FLAGS_SPHERE              (1 << 6)
 #define OPTIX_PRIMITIVE_TYPE_FLAGS_TRIANGLE            (1 << 31)
 
 #define OPTIX_CURVE_ENDCAP_DEFAULT 0
@@ -86,6 +92,10 @@ using OptixDenoiserStructPtr = void*;
 #define OPTIX_INSTANCE_FLAG_NONE              0
 #define OPTIX_INSTANCE_FLAG_DISABLE_TRANSFORM (1u << 6)
 
+#define OPTIX_MOTION_FLAG_NONE                            0
+#define OPTIX_TRAVERSABLE_TYPE_MATRIX_MOTION_TRANSFORM    0x21C2
+#define OPTIX_TRANSFORM_BYTE_ALIGNMENT                    64ull
+
 #define OPTIX_RAY_FLAG_NONE                   0
 #define OPTIX_RAY_FLAG_TERMINATE_ON_FIRST_HIT (1u << 2)
 #define OPTIX_RAY_FLAG_DISABLE_CLOSESTHIT     (1u << 3)
@@ -169,6 +179,22 @@ struct OptixBuildInputCurveArray {
     unsigned int endcapFlags;
 };
 
+/// Built-in spheres (requires OptiX 7.5, see \ref optix_builtin_spheres())
+struct OptixBuildInputSphereArray {
+    const CUdeviceptr* vertexBuffers;
+    unsigned int vertexStrideInBytes;
+    unsigned int numVertices;
+    const CUdeviceptr* radiusBuffers;
+    unsigned int radiusStrideInBytes;
+    int singleRadius;
+    const unsigned int* flags;
+    unsigned int numSbtRecords;
+    CUdeviceptr sbtIndexOffsetBuffer;
+    unsigned int sbtIndexOffsetSizeInBytes;
+    unsigned int sbtIndexOffsetStrideInBytes;
+    unsigned int primitiveIndexOffset;
+};
+
 struct OptixBuildInput {
     OptixBuildInputType type;
     union {
@@ -176,6 +202,7 @@ struct OptixBuildInput {
         OptixBuildInputCustomPrimitiveArray customPrimitiveArray;
         OptixBuildInputInstanceArray instanceArray;
         OptixBuildInputCurveArray curveArray;
+        OptixBuildInputSphereArray sphereArray;
         char pad[1024];
     };
 };
@@ -197,6 +224,14 @@ struct OptixInstance {
     unsigned int pad[2];
 };
 
+/// Variable-size record: the \c transform array holds \c motionOptions.numKeys entries
+struct OptixMatrixMotionTransform {
+    OptixTraversableHandle child;
+    OptixMotionOptions motionOptions;
+    unsigned int pad[3];
+    float transform[2][12];
+};
+
 struct OptixPayloadType {
     unsigned int numPayloadValues;
     const unsigned int *payloadSemantics;
@@ -354,6 +389,8 @@ D(optixProgramGroupCreate, OptixDeviceContext, const OptixProgramGroupDesc *,
   unsigned int, const OptixProgramGroupOptions *, char *, size_t *,
   OptixProgramGroup *);
 D(optixSbtRecordPackHeader, OptixProgramGroup, void *);
+D(optixConvertPointerToTraversableHandle, OptixDeviceContext, CUdeviceptr,
+  OptixTraversableType, OptixTraversableHandle *);
 D(optixAccelCompact, OptixDeviceContext, CUstream, OptixTraversableHandle,
   CUdeviceptr, size_t, OptixTraversableHandle *);
 D(optixDenoiserCreate, OptixDeviceContext, OptixDenoiserModelKind,
@@ -369,6 +406,8 @@ D(optixDenoiserInvoke, OptixDenoiserStructPtr, CUstream,
   unsigned int, unsigned int, CUdeviceptr, size_t);
 D(optixDenoiserComputeIntensity, OptixDenoiserStructPtr, CUstream,
   const OptixImage2D *inputImage, CUdeviceptr, CUdeviceptr, size_t);
+D(optixDeviceContextSetCacheEnabled, OptixDeviceContext, int);
+D(optixDeviceContextSetCacheLocation, OptixDeviceContext, const char *);
 
 #undef D
 
@@ -383,6 +422,67 @@ struct scoped_optix_context {
     scoped_optix_context();
     ~scoped_optix_context();
 };
+
+/**
+ * \brief Are spheres traced as built-in OptiX primitives on the current device?
+ *
+ * Built-in spheres are intersected by the RT cores of recent GPUs, which is
+ * much faster than the custom intersection program of the \c sphere shape.
+ * They require OptiX 7.5, which is detected once per device by loading the
+ * corresponding built-in intersection module. Otherwise, spheres fall back to
+ * the custom intersection program.
+ */
+extern MI_EXPORT_LIB bool optix_builtin_spheres();
+
+/**
+ * \brief Configure the OptiX disk cache of compiled modules
+ *
+ * OptiX stores the modules it compiles in an on-disk database, so that later
+ * processes that compile the same module with the same options load it from
+ * there instead. This function enables or disables the cache of the OptiX
+ * context of the current device, and optionally moves it to the directory
+ * \c path (an empty path keeps the location chosen by OptiX, which can also
+ * be set with the \c OPTIX_CACHE_PATH environment variable). The context is
+ * only reconfigured when the settings change.
+ */
+extern MI_EXPORT_LIB void optix_configure_disk_cache(bool enabled,
+                                                     const std::string &path);
+
+// =====================================================
+//   Process-wide cache of geometry acceleration structures
+// =====================================================
+
+/**
+ * \brief Look up a geometry acceleration structure (GAS) in the cache
+ *
+ * GASes are identified by a 64 bit key, which should cover all inputs of the
+ * build, i.e. the target device, the build options and the geometry itself.
+ * On success, the reference count of the entry is increased and its buffer
+ * is returned (\c nullptr otherwise).
+ */
+extern MI_EXPORT_LIB void *optix_gas_cache_acquire(uint64_t key,
+                                                   OptixTraversableHandle *handle);
+
+/// Register a freshly built GAS with the cache (with a reference count of 1)
+extern MI_EXPORT_LIB void optix_gas_cache_insert(uint64_t key, void *buffer,
+                                                 OptixTraversableHandle handle,
+                                                 size_t size);
+
+/// Release a reference to a cached GAS, freeing it when it is no longer used
+extern MI_EXPORT_LIB void optix_gas_cache_release(void *buffer);
+
+/// Return the number of GASes and the amount of memory held by the cache
+extern MI_EXPORT_LIB std::pair<size_t, size_t> optix_gas_cache_usage();
+
+/**
+ * \brief Update a 64 bit FNV-1a hash with the contents of device memory
+ *
+ * The memory is copied to the host in chunks, hence this is only meant to
+ * be used for opt-in features like the GAS cache.
+ */
+extern MI_EXPORT_LIB uint64_t optix_hash_device_memory(uint64_t hash,
+                                                       const void *ptr,
+                                                       size_t size);
 NAMESPACE_END(mitsuba)
 
 #endif // defined(MI_ENABLE_CUDA)
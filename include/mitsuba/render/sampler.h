@@ -127,9 +127,45 @@ public:
     /// Set the number of samples per pixel per pass in wavefront modes (default is 1)
     void set_samples_per_wavefront(uint32_t samples_per_wavefront);
 
+    /**
+     * \brief Set the width of the image covered by the sample sequences of a
+     * wavefront in scanline order
+     *
+     * In wavefront modes, sequence <tt>y * width + x</tt> of the wavefront
+     * renders pixel <tt>(x, y)</tt>. Samplers that correlate the sequences of
+     * neighboring pixels use this to recover their coordinates. A value of
+     * zero (the default) denotes an unknown layout.
+     */
+    void set_film_width(uint32_t width) { m_film_width = width; }
+
+    /// Return the width specified via \ref set_film_width()
+    uint32_t film_width() const { return m_film_width; }
+
     /// dr::schedule() variables that represent the internal sampler state
     virtual void schedule_state();
 
+    /**
+     * \brief Create a copy of this sampler restricted to a subset of the lanes
+     * of its wavefront
+     *
+     * Lane \c i of the returned sampler continues the sequence of the current
+     * sample of lane <tt>index[i]</tt>, and thus produces the same random
+     * numbers. This is used to compact the wavefront of a rendering loop once
+     * most of its lanes have terminated. The returned sampler should not be
+     * advanced to subsequent samples. Once the compacted lanes are done,
+     * \ref expand() writes their state back into this sampler.
+     */
+    ref<Sampler> compact(const UInt32 &index);
+
+    /**
+     * \brief Write the state of a sampler created by \ref compact() back to
+     * the lanes <tt>index</tt> of this sampler
+     *
+     * Afterwards, this sampler continues as if the compacted lanes had never
+     * been separated from its wavefront.
+     */
+    void expand(const Sampler *compacted, const UInt32 &index);
+
     /// Traversal callback mechanism for symbolic loops
     virtual void traverse_1_cb_ro(void *payload, void (*fn)(void *, uint64_t)) const;
     /// Traversal callback mechanism for symbolic loops
@@ -147,6 +183,12 @@ protected:
     /// Return the index of the current sample
     UInt32 current_sample_index() const;
 
+    /// Gather the per-lane state of the sampler (see \ref compact())
+    virtual void gather_state(const UInt32 &index);
+
+    /// Scatter the per-lane state of a compacted sampler (see \ref expand())
+    virtual void scatter_state(const Sampler *compacted, const UInt32 &index);
+
 protected:
     /// Base seed value
     uint32_t m_base_seed;
@@ -156,6 +198,8 @@ protected:
     uint32_t m_samples_per_wavefront;
     /// Size of the wavefront (or 0, if not seeded)
     uint32_t m_wavefront_size;
+    /// Width of the image covered by the wavefront (or 0, if unknown)
+    uint32_t m_film_width;
     /// Index of the current dimension in the sample
     UInt32 m_dimension_index;
     /// Index of the current sample in the sequence
@@ -179,10 +223,74 @@ public:
 protected:
     PCG32Sampler(const Properties &props);
 
+    void gather_state(const UInt32 &index) override;
+    void scatter_state(const Sampler *compacted, const UInt32 &index) override;
+
+    /**
+     * \brief Return the next uniformly distributed value of \c m_rng in the
+     * interval <tt>[0, 1)</tt>
+     *
+     * The result is identical to <tt>m_rng.next_float<Float>(active)</tt>.
+     * Scalar variants however generate the outputs of the random number
+     * generator \ref BatchSize at a time using SIMD instructions (by jumping
+     * ahead in its sequence) and serve them from a small buffer. In this
+     * case, \c m_rng is ahead of the values that were actually consumed,
+     * and it must not be used directly in conjunction with this function.
+     */
+    MI_INLINE Float next_float_batched(Mask active = true) {
+        if constexpr (!dr::is_array_v<Float>) {
+            if constexpr (std::is_same_v<Float, float>) {
+                uint32_t value = next_uint32_batched(active);
+                return dr::reinterpret_array<float>((value >> 9) | 0x3f800000u) - 1.f;
+            } else {
+                uint64_t v0 = next_uint32_batched(active),
+                         v1 = next_uint32_batched(active),
+                         value = v0 | (v1 << 32);
+                return dr::reinterpret_array<double>(
+                    (value >> 12) | 0x3ff0000000000000ull) - 1.0;
+            }
+        } else {
+            return m_rng.template next_float<Float>(active);
+        }
+    }
+
     /// Copy state to a new PCG32Sampler object
     PCG32Sampler(const PCG32Sampler &sampler);
+
+private:
+    /// Return the next buffered 32-bit output of \c m_rng (scalar variants)
+    MI_INLINE uint32_t next_uint32_batched(bool active) {
+        if (unlikely(m_batch_index == BatchSize))
+            refill_batch();
+        uint32_t value = m_batch[m_batch_index];
+        // Inactive lanes don't advance the random number generator
+        m_batch_index += active ? 1 : 0;
+        return value;
+    }
+
+    /// Generate the next \ref BatchSize outputs of \c m_rng
+    void refill_batch();
+
 protected:
     PCG32 m_rng;
+
+    /// Number of outputs of the random number generator generated at once
+    static constexpr uint32_t BatchSize = 8;
+
+private:
+    /// Buffered outputs of \c m_rng (scalar variants)
+    uint32_t m_batch[BatchSize];
+    /// Index of the next buffered output (\ref BatchSize if the buffer is empty)
+    uint32_t m_batch_index = BatchSize;
+    /// Increment of \c m_rng that the jump-ahead coefficients refer to
+    uint64_t m_batch_inc = 0;
+    /**
+     * Jump-ahead coefficients of the state of \c m_rng: the state \c j steps
+     * ahead of \c s is <tt>m_batch_mult[j] * s + m_batch_add[j]</tt>. The
+     * last entry stores the coefficients of \ref BatchSize steps.
+     */
+    uint64_t m_batch_mult[BatchSize + 1],
+             m_batch_add[BatchSize + 1];
 };
 
 MI_EXTERN_CLASS(Sampler)
@@ -3,6 +3,7 @@
 #include <mitsuba/core/distr_1d.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/render/emitter.h>
+#include <mitsuba/render/lightbvh.h>
 #include <mitsuba/render/shapegroup.h>
 #include <mitsuba/render/fwd.h>
 #include <mitsuba/render/sensor.h>
@@ -38,7 +39,7 @@ class MI_EXPORT_LIB Scene : public Object {
 public:
     MI_IMPORT_TYPES(BSDF, Emitter, EmitterPtr, SensorPtr, Film, Sampler, Shape,
                     ShapePtr, ShapeGroup, Sensor, Integrator, Medium, MediumPtr,
-                    Mesh)
+                    Mesh, LightBVH)
 
     /// Instantiate a scene from a \ref Properties object
     Scene(const Properties &props);
@@ -210,6 +211,29 @@ public:
      */
     Mask ray_test(const Ray3f &ray, Mask coherent, Mask active) const;
 
+    /**
+     * \brief Test several rays for occlusion at once
+     *
+     * This function is equivalent to calling \ref ray_test() for each of the
+     * \c count rays, but it is meant for groups of rays that share their
+     * origin, such as the shadow rays of several emitter samples taken at the
+     * same shading point. The native CPU backend then traces them as packets
+     * through the kd-tree, so that the traversal of its upper levels is
+     * shared. Other backends test the rays one after the other.
+     *
+     * \param rays
+     *    Array of \c count rays
+     *
+     * \param active
+     *    Array of \c count masks specifying the enabled rays
+     *
+     * \param result
+     *    Array of \c count masks that are set to \c true for the rays that
+     *    found an intersection (output)
+     */
+    void ray_test_multi(const Ray3f *rays, const Mask *active, Mask *result,
+                        size_t count) const;
+
     /**
      * \brief Intersect a ray with the shapes comprising the scene and return
      * preliminary information, if one is found
@@ -302,6 +326,42 @@ public:
      */
     Float pdf_emitter(UInt32 index, Mask active = true) const;
 
+    /**
+     * \brief Sample one emitter in the scene for a given reference point
+     * and rescale the input sample for reuse.
+     *
+     * When the scene was created with the \c light_bvh parameter set to
+     * \c true, the emitter is chosen using a \ref LightBVH, i.e.
+     * approximately proportionally to its contribution at \c ref.
+     * Otherwise, this function is equivalent to \ref sample_emitter(). Emissive
+     * meshes additionally receive one leaf per triangle, which
+     * \ref sample_emitter_direction() uses to pick the triangle on which a
+     * position is sampled, see \ref LightBVH.
+     *
+     * \param ref
+     *    A reference point somewhere within the scene.
+     *
+     * \param sample
+     *    A uniformly distributed number in [0, 1).
+     *
+     * \return
+     *    The index of the chosen emitter along with the sampling weight (equal
+     *    to the inverse PDF), and the transformed random sample for reuse.
+     */
+    std::tuple<UInt32, Float, Float>
+    sample_emitter(const Interaction3f &ref, Float index_sample,
+                   Mask active = true) const;
+
+    /**
+     * \brief Evaluate the discrete probability of the reference point-aware
+     * \ref sample_emitter() technique for the given a emitter index.
+     */
+    Float pdf_emitter(const Interaction3f &ref, UInt32 index,
+                      Mask active = true) const;
+
+    /// Return the light BVH used to sample emitters (if enabled)
+    const LightBVH *light_bvh() const { return m_light_bvh.get(); }
+
     /**
      * \brief Sample a ray according to the emission profile of scene emitters
      *
@@ -385,6 +445,30 @@ public:
                              bool test_visibility = true,
                              Mask active = true) const;
 
+    /**
+     * \brief Take several direct illumination samples at the same location
+     *
+     * This function is equivalent to calling \ref sample_emitter_direction()
+     * with each of the \c count samples, except that the visibility of all
+     * samples is tested using a single call to \ref ray_test_multi().
+     *
+     * \param samples
+     *    Array of \c count uniformly distributed 2D samples
+     *
+     * \param ds
+     *    Array of \c count direction samples (output)
+     *
+     * \param spec
+     *    Array of \c count sampling weights (output)
+     */
+    void sample_emitter_directions(const Interaction3f &ref,
+                                   const Point2f *samples,
+                                   size_t count,
+                                   DirectionSample3f *ds,
+                                   Spectrum *spec,
+                                   bool test_visibility = true,
+                                   Mask active = true) const;
+
     /**
      * \brief Evaluate the PDF of direct illumination sampling
      *
@@ -514,6 +598,26 @@ public:
     /// Return the environment emitter (if any)
     const Emitter *environment() const { return m_environment.get(); }
 
+    /**
+     * \brief Return the number of samples per pixel of the training pass
+     * requested by the environment emitter, or zero if it doesn't need one
+     * (see Emitter::training_spp())
+     */
+    uint32_t emitter_training_spp() const {
+        return m_environment ? m_environment->training_spp() : 0;
+    }
+
+    /**
+     * \brief Start or stop the training pass of the environment emitter
+     *
+     * While it is in progress, \ref sample_emitter_direction() reports the
+     * result of its visibility tests to the environment emitter.
+     */
+    void set_emitter_training(bool training) {
+        if (m_environment)
+            m_environment->set_training(training);
+    }
+
     /// Return the list of shapes
     std::vector<ref<Shape>> &shapes() { return m_shapes; }
     /// Return the list of shapes
@@ -527,6 +631,17 @@ public:
     /// Return the scene's integrator
     const Integrator* integrator() const { return m_integrator; }
 
+    /**
+     * \brief Return the \ref RayFlags of the surface interaction fields read
+     * by the materials and textures of the scene
+     *
+     * Integrators pass these flags to \ref ray_intersect() to skip the
+     * computation of unused fields, e.g. the UV parameterization of untextured
+     * scenes. The scene parameter ``minimal_ray_flags`` (default: ``true``)
+     * disables this analysis, in which case \ref RayFlags::All is returned.
+     */
+    uint32_t ray_flags() const { return m_ray_flags; }
+
     /// Return the list of emitters as a Dr.Jit array
     const DynamicBuffer<EmitterPtr> &emitters_dr() const { return m_emitters_dr; }
 
@@ -551,6 +666,16 @@ public:
      */
     bool shapes_grad_enabled() const { return m_shapes_grad_enabled; };
 
+    /**
+     * \brief Counter that is incremented whenever \ref parameters_changed()
+     * rebuilds the acceleration data structure or the emitter sampling
+     * distributions
+     *
+     * Recorded (frozen) rendering kernels reference these data structures
+     * and must be recorded again when the counter changes.
+     */
+    uint32_t structure_version() const { return m_structure_version; }
+
     /// Return a human-readable string representation of the scene contents.
     virtual std::string to_string() const override;
 
@@ -560,6 +685,17 @@ public:
     /// Static shutdown of ray-intersection acceleration data structure
     static void static_accel_shutdown();
 
+#if defined(MI_ENABLE_EMBREE)
+    /**
+     * \brief Return the Embree device shared by all scenes
+     *
+     * The device is created upon the first call, which lets shape groups
+     * build their Embree scene while the rest of the scene is still loading.
+     * This function is thread-safe.
+     */
+    static RTCDevice embree_device();
+#endif
+
     MI_DECLARE_CLASS()
 
 protected:
@@ -570,6 +706,15 @@ protected:
     void accel_init_cpu(const Properties &props);
     void accel_init_gpu(const Properties &props);
 
+    /**
+     * \brief Build the acceleration data structures of all shape groups
+     * concurrently (CPU backends)
+     *
+     * Each group is built by a single worker of the thread pool, hence many
+     * small groups build much faster than one after the other.
+     */
+    void build_shapegroups();
+
     /// Updates the ray-intersection acceleration data structure
     void accel_parameters_changed_cpu();
     void accel_parameters_changed_gpu();
@@ -597,15 +742,53 @@ protected:
     /// Trace a shadow ray
     MI_INLINE Mask ray_test_cpu(const Ray3f &ray, Mask coherent, Mask active) const;
     MI_INLINE Mask ray_test_gpu(const Ray3f &ray, Mask active) const;
+    MI_INLINE void ray_test_multi_cpu(const Ray3f *rays, const Mask *active,
+                                      Mask *result, size_t count) const;
 
     using ShapeKDTree = mitsuba::ShapeKDTree<Float, Spectrum>;
 
+    /**
+     * \brief Replace duplicate meshes by instances of shared shape groups
+     *
+     * Enabled by the \c auto_instancing scene parameter. Meshes are
+     * considered duplicates when they have the same BSDF, topology, and
+     * texture coordinates, and when their vertex positions and normals
+     * differ only by the relative transformation of their \c to_world
+     * transforms. Meshes with attached emitters, sensors, media, or
+     * attributes are left untouched.
+     */
+    void instance_duplicate_meshes();
+
+    /**
+     * \brief Make the shapes of the scene depend on the view of its primary
+     * sensor
+     *
+     * Replaces every level-of-detail shape (see \ref Shape::lod_levels()) by
+     * the level that matches its projected size on the film of the first
+     * sensor. When \c culling is set, shapes marked as view-cullable are
+     * further skipped when their bounding box lies outside of the view
+     * frustum, after dilating the film by the fraction \c margin on every
+     * side. Only projective cameras define a frustum: otherwise, the finest
+     * levels are used and no shapes are culled.
+     */
+    void select_view_dependent_shapes(const std::vector<ref<Shape>> &lods,
+                                      bool culling, ScalarFloat margin);
+
+    /// Report the visibility of a direction sample to a training environment emitter
+    void record_emitter_visibility(const Interaction3f &ref,
+                                   const DirectionSample3f &ds,
+                                   const Spectrum &weight, const Mask &visible,
+                                   Mask active) const;
+
     /// Updates the discrete distribution used to select an emitter
     void update_emitter_sampling_distribution();
 
     /// Updates the discrete distribution used to select a shape's silhouette
     void update_silhouette_sampling_distribution();
 
+    /// Combines the \ref RayFlags requested by the BSDFs and textures of the scene
+    void update_ray_flags();
+
 protected:
     /// Acceleration data structure (IAS) (type depends on implementation)
     void *m_accel = nullptr;
@@ -629,13 +812,20 @@ protected:
     ref<Emitter> m_environment;
 
     ScalarFloat m_emitter_pmf;
-    std::unique_ptr<DiscreteDistribution<Float>> m_emitter_distr = nullptr;
+    std::unique_ptr<FenwickDistribution<Float>> m_emitter_distr = nullptr;
+
+    /// Hierarchy for reference point-aware emitter sampling (if enabled)
+    bool m_use_light_bvh = false;
+    ref<LightBVH> m_light_bvh;
 
     std::vector<ref<Shape>> m_silhouette_shapes;
+    std::vector<ScalarFloat> m_silhouette_weights;
     DynamicBuffer<ShapePtr> m_silhouette_shapes_dr;
     std::unique_ptr<DiscreteDistribution<Float>> m_silhouette_distr = nullptr;
 
     bool m_shapes_grad_enabled;
+    uint32_t m_structure_version = 0;
+    uint32_t m_ray_flags = +RayFlags::All;
 };
 
 /// Dummy function which can be called to ensure that the librender shared library is loaded
@@ -103,9 +103,21 @@ public:
     /// Return the length, for which the shutter remains open
     ScalarFloat shutter_open_time() const { return m_shutter_open_time; }
 
+    /// Change the time value of the shutter opening event (e.g. to render a sequence)
+    void set_shutter_open(ScalarFloat time) { m_shutter_open = time; }
+
     /// Does the sampling technique require a sample for the aperture position?
     bool needs_aperture_sample() const { return m_needs_sample_3; }
 
+    /**
+     * \brief Return the child sensors of a meta-sensor that renders several
+     * views at once (e.g. \c batch)
+     *
+     * The views are tiled horizontally in the film of the meta-sensor, in the
+     * order of this list. The list is empty for all other sensors.
+     */
+    virtual std::vector<ref<Sensor>> sub_sensors() const { return {}; }
+
     /// Return the \ref Film instance associated with this sensor
     Film *film() { return m_film; }
 
@@ -35,8 +35,10 @@ enum class ShapeType : uint32_t {
     Sphere = 7u,
     /// Instance (`instance`)
     Instance = 8u,
+    /// Sphere collections (`spheres`)
+    Spheres = 9u,
     /// Other shapes
-    Other = 9u
+    Other = 10u
 };
 MI_DECLARE_ENUM_OPERATORS(ShapeType)
 
@@ -607,14 +609,20 @@ public:
      * \param ray
      *     The ray to be tested for an intersection
      *
+     * \param prim_index
+     *     Index of the primitive to be intersected. Shapes that consist of a
+     *     single primitive ignore this parameter.
+     *
      * \return
      *     A tuple containing the following field: \c t, \c uv, \c shape_index,
      *     \c prim_index. The \c shape_index should be only used by the
      *     \ref ShapeGroup class and be set to \c (uint32_t)-1 otherwise.
      */
     virtual std::tuple<ScalarFloat, ScalarPoint2f, ScalarUInt32, ScalarUInt32>
-    ray_intersect_preliminary_scalar(const ScalarRay3f &ray) const;
-    virtual bool ray_test_scalar(const ScalarRay3f &ray) const;
+    ray_intersect_preliminary_scalar(const ScalarRay3f &ray,
+                                     ScalarIndex prim_index = 0) const;
+    virtual bool ray_test_scalar(const ScalarRay3f &ray,
+                                 ScalarIndex prim_index = 0) const;
 
     /// Macro to declare packet versions of the scalar routine above
     #define MI_DECLARE_RAY_INTERSECT_PACKET(N)                                  \
@@ -669,6 +677,17 @@ public:
     virtual ScalarBoundingBox3f bbox(ScalarIndex index,
                                      const ScalarBoundingBox3f &clip) const;
 
+    /**
+     * \brief Return the center and radius of a single spherical primitive
+     *
+     * This is used by the native kd-tree to intersect the primitives of
+     * \ref ShapeType::Spheres shapes in packets, and must be implemented by
+     * all shapes of this type. The default implementation throws an
+     * exception.
+     */
+    virtual std::pair<ScalarPoint3f, ScalarFloat>
+    sphere_primitive(ScalarIndex index) const;
+
     /**
      * \brief Return the shape's surface area.
      *
@@ -747,6 +766,41 @@ public:
                                      const SurfaceInteraction3f &si,
                                      Mask active = true) const;
 
+    /**
+     * \brief Return a handle that identifies the attribute with the given name
+     *
+     * Handles are small integers shared by all shapes, which are assigned the
+     * first time a name is queried. Evaluating an attribute through its handle
+     * avoids the name lookup that is otherwise performed at every shading
+     * point, hence callers in the rendering hot path (e.g. the
+     * :monosp:`mesh_attribute` texture) should resolve it once at
+     * construction time.
+     */
+    static uint32_t attribute_handle(const std::string &name);
+
+    /// Return the name of the attribute associated with a handle
+    static const std::string &attribute_name(uint32_t handle);
+
+    /**
+     * \brief Evaluate a shape attribute identified by a handle (see \ref
+     * attribute_handle())
+     *
+     * The default implementation falls back to the name-based version.
+     */
+    virtual UnpolarizedSpectrum eval_attribute(uint32_t handle,
+                                               const SurfaceInteraction3f &si,
+                                               Mask active = true) const;
+
+    /// Monochromatic evaluation of a shape attribute identified by a handle
+    virtual Float eval_attribute_1(uint32_t handle,
+                                   const SurfaceInteraction3f &si,
+                                   Mask active = true) const;
+
+    /// Trichromatic evaluation of a shape attribute identified by a handle
+    virtual Color3f eval_attribute_3(uint32_t handle,
+                                     const SurfaceInteraction3f &si,
+                                     Mask active = true) const;
+
     /**
      * \brief Parameterize the mesh using UV values
      *
@@ -784,6 +838,44 @@ public:
     /// Is this shape an instance?
     bool is_instance() const { return (shape_type() == +ShapeType::Instance); };
 
+    /**
+     * \brief May the scene skip this shape when it lies outside of the view
+     * frustum of its primary sensor?
+     *
+     * Set by the \c view_cullable parameter, which marks shapes that don't
+     * affect the lighting of the visible parts of the scene. The shapes are
+     * only skipped when the scene enables the \c view_culling parameter.
+     */
+    bool is_view_cullable() const { return m_view_cullable; }
+
+    /**
+     * \brief Return the alternative versions of a level-of-detail shape
+     *
+     * The levels are ordered from the finest to the coarsest, and each is
+     * paired with the minimum size (in pixels) that the shape must cover on
+     * the film of the primary sensor for the level to be used. The scene
+     * replaces the shape by one of its levels when it is loaded. Other shapes
+     * return an empty list.
+     */
+    virtual std::vector<std::pair<ref<Shape>, ScalarFloat>> lod_levels() const {
+        return {};
+    }
+
+    /// Does this shape have a time-dependent (keyframed) transformation?
+    virtual bool has_motion() const { return false; }
+
+    /**
+     * \brief Return the object-to-world transformation of an instance at the
+     * given time
+     *
+     * Other shapes apply their transformation to the geometry itself, in
+     * which case this function returns the identity. This is e.g. used to
+     * compute the motion vectors of animated sequences.
+     */
+    virtual ScalarTransform4f instance_transform(ScalarFloat /* time */) const {
+        return ScalarTransform4f();
+    }
+
     /// Does the surface of this shape mark a medium transition?
     bool is_medium_transition() const { return m_interior_medium.get() != nullptr ||
                                                m_exterior_medium.get() != nullptr; }
@@ -838,6 +930,12 @@ public:
 #if defined(MI_ENABLE_EMBREE)
     /// Return the Embree version of this shape
     virtual RTCGeometry embree_geometry(RTCDevice device);
+
+    /**
+     * \brief Return the Embree build quality requested for this shape
+     * (\c "low", \c "medium", \c "high", or empty to use the scene's)
+     */
+    const std::string &embree_build_quality() const { return m_embree_build_quality; }
 #endif
 
 #if defined(MI_ENABLE_CUDA)
@@ -927,11 +1025,26 @@ public:
     void traverse(TraversalCallback *callback) override;
     void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override;
 
+    /// Replace the BSDF of the shape (used by the reload mode of the XML loader)
+    bool replace_object(Object *old_child, Object *new_child) override;
+
     /// Return whether the shape's geometry has changed
     bool dirty() const { return m_dirty; }
 
     /// Mark that the shape's geometry has changed
-    void mark_dirty() { m_dirty = true; }
+    void mark_dirty() { m_dirty = true; m_topology_dirty = true; }
+
+    /**
+     * \brief Mark that the shape's vertex positions have changed, while its
+     * topology (vertex and face counts, face indices) remains the same
+     *
+     * This enables acceleration data structures to refit their bounds instead
+     * of performing a full rebuild.
+     */
+    void mark_vertices_dirty() { m_dirty = true; }
+
+    /// Return whether the shape's geometry has changed in a way that requires a rebuild
+    bool topology_dirty() const { return m_topology_dirty; }
 
     // Mark that shape as an instance
     void mark_as_instance() { m_is_instance = true; }
@@ -978,6 +1091,14 @@ protected:
     /// True if the shape is used in a \c ShapeGroup
     bool m_is_instance = false;
 
+    /// True if the scene may skip the shape when it lies outside of the view
+    bool m_view_cullable = false;
+
+#if defined(MI_ENABLE_EMBREE)
+    /// Embree build quality of this shape (empty: use the scene's)
+    std::string m_embree_build_quality;
+#endif
+
 #if defined(MI_ENABLE_CUDA)
     /// OptiX hitgroup data buffer
     void* m_optix_data_ptr = nullptr;
@@ -987,6 +1108,9 @@ protected:
     /// True if the shape's geometry has changed
     bool m_dirty = true;
 
+    /// True if the shape's geometry has changed beyond its vertex positions
+    bool m_topology_dirty = true;
+
     /// True if the shape has called iniatlize() at least once
     bool m_initialized = false;
 };
@@ -1065,11 +1189,13 @@ NAMESPACE_END(mitsuba)
     }                                                                                       \
     using typename Base::ScalarRay3f;                                                       \
     std::tuple<ScalarFloat, ScalarPoint2f, ScalarUInt32, ScalarUInt32>                      \
-    ray_intersect_preliminary_scalar(const ScalarRay3f &ray) const override {               \
-        return ray_intersect_preliminary_impl<ScalarFloat>(ray, 0, true);                   \
+    ray_intersect_preliminary_scalar(const ScalarRay3f &ray,                                \
+                                     ScalarIndex prim_index) const override {               \
+        return ray_intersect_preliminary_impl<ScalarFloat>(ray, prim_index, true);          \
     }                                                                                       \
-    ScalarMask ray_test_scalar(const ScalarRay3f &ray) const override {                     \
-        return ray_test_impl<ScalarFloat>(ray, 0, true);                                    \
+    ScalarMask ray_test_scalar(const ScalarRay3f &ray,                                      \
+                               ScalarIndex prim_index) const override {                     \
+        return ray_test_impl<ScalarFloat>(ray, prim_index, true);                           \
     }                                                                                       \
     MI_IMPLEMENT_RAY_INTERSECT_PACKET(4)                                                    \
     MI_IMPLEMENT_RAY_INTERSECT_PACKET(8)                                                    \
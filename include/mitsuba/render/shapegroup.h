@@ -6,6 +6,7 @@
 #  include <embree3/rtcore.h>
 #else
 #  include <mitsuba/render/kdtree.h>
+#  include <mitsuba/render/bvh.h>
 #endif
 
 #if defined(MI_ENABLE_CUDA)
@@ -18,8 +19,9 @@ template <typename Float, typename Spectrum>
 class MI_EXPORT_LIB ShapeGroup : public Shape<Float, Spectrum> {
 public:
     MI_IMPORT_BASE(Shape, m_id, m_dirty)
-    MI_IMPORT_TYPES(ShapeKDTree, ShapePtr)
+    MI_IMPORT_TYPES(ShapeKDTree, ShapeBVH, ShapePtr, Mesh)
 
+    using typename Base::ScalarIndex;
     using typename Base::ScalarSize;
     using typename Base::ScalarRay3f;
 
@@ -28,10 +30,43 @@ public:
 
 #if defined(MI_ENABLE_EMBREE)
     RTCGeometry embree_geometry(RTCDevice device) override;
+
+    /**
+     * \brief Build the Embree scene of the shapes in this group if any of
+     * them changed
+     *
+     * Groups loaded by a parallel scene load call this function upon
+     * construction. The scene calls it for all of its other groups
+     * concurrently before building its top-level acceleration data
+     * structure. Otherwise, this happens upon the first call to
+     * \ref embree_geometry().
+     */
+    void embree_build(RTCDevice device);
 #else
+    /**
+     * \brief Build the acceleration data structure of the shapes in this
+     * group (if not done already)
+     *
+     * Groups loaded by a parallel scene load build their acceleration data
+     * structure upon construction, overlapping it with the loading of the
+     * other objects. Otherwise, the scene builds the ones of all its groups
+     * concurrently before its top-level acceleration data structure. Groups
+     * with \c lazy_build are built upon their first intersection, which is
+     * only supported in scalar variants. This function is thread-safe.
+     */
+    void build_accel() const;
+
+    /// Is the acceleration data structure built upon the first intersection?
+    bool lazy_build() const { return m_lazy_build; }
+
+    /// Was the acceleration data structure built already?
+    bool accel_ready() const { return m_accel_ready.load(std::memory_order_acquire); }
+
     std::tuple<ScalarFloat, ScalarPoint2f, ScalarUInt32, ScalarUInt32>
-    ray_intersect_preliminary_scalar(const ScalarRay3f &ray) const override;
-    bool ray_test_scalar(const ScalarRay3f &ray) const override;
+    ray_intersect_preliminary_scalar(const ScalarRay3f &ray,
+                                     ScalarIndex prim_index) const override;
+    bool ray_test_scalar(const ScalarRay3f &ray,
+                         ScalarIndex prim_index) const override;
 #endif
 
     SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
@@ -44,6 +79,15 @@ public:
 
     ScalarBoundingBox3f bbox() const override{ return m_bbox; }
 
+    /**
+     * \brief Return a small set of bounding boxes whose union encloses the
+     * geometry of the shape group
+     *
+     * These boxes are tighter than \ref bbox() and are used by instances to
+     * compute tight world-space bounds under arbitrary transformations.
+     */
+    const std::vector<ScalarBoundingBox3f> &bounds() const { return m_bounds; }
+
     Float surface_area() const override { return 0.f; }
 
     MI_INLINE ScalarSize effective_primitive_count() const override { return 0; }
@@ -57,6 +101,9 @@ public:
     /// Return whether this shapegroup contains linear curve shapes
     bool has_linear_curves() const { return m_has_linear_curves; }
 
+    /// Return whether this shapegroup contains sphere shapes
+    bool has_spheres() const { return m_has_spheres; }
+
     /// Return whether this shapegroup contains other type of shapes
     bool has_others() const { return m_has_others; }
 
@@ -78,13 +125,22 @@ public:
 
     void optix_prepare_geometry() override;
 
-    /// Build OptiX geometry acceleration structures
-    void optix_build_gas(const OptixDeviceContext& context);
+    /// Bit mask of the OptiX shape types in this group (see \ref optix_shape_types())
+    uint32_t optix_shape_types() const { return mitsuba::optix_shape_types(m_shapes); }
+
+    /// Build OptiX geometry acceleration structures (see \ref build_gas())
+    void optix_build_gas(const OptixDeviceContext& context,
+                         bool use_cache = false,
+                         OptixGASStatistics *stats = nullptr);
 #endif
 
     MI_DECLARE_CLASS()
 private:
+    /// Compute the bounding boxes returned by \ref bounds()
+    void compute_bounds();
+
     ScalarBoundingBox3f m_bbox;
+    std::vector<ScalarBoundingBox3f> m_bounds;
     std::vector<ref<Base>> m_shapes;
 
 #if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
@@ -95,7 +151,13 @@ private:
     RTCScene m_embree_scene = nullptr;
     std::vector<int> m_embree_geometries;
 #else
+    /// Exactly one of the two acceleration data structures is used
     ref<ShapeKDTree> m_kdtree;
+    ref<ShapeBVH> m_bvh;
+    /// Is the acceleration data structure built upon the first intersection?
+    bool m_lazy_build;
+    mutable std::atomic<bool> m_accel_ready { false };
+    mutable std::mutex m_accel_mutex;
 #endif
 
 #if defined(MI_ENABLE_CUDA)
@@ -104,7 +166,8 @@ private:
     uint32_t m_sbt_offset;
 #endif
 
-    bool m_has_meshes, m_has_bspline_curves, m_has_linear_curves, m_has_others;
+    bool m_has_meshes, m_has_bspline_curves, m_has_linear_curves, m_has_spheres,
+         m_has_others;
 };
 
 MI_EXTERN_CLASS(ShapeGroup)
@@ -4,7 +4,9 @@
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/render/film.h>
 #include <mitsuba/render/imageblock.h>
-#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 #if !defined(MI_BLOCK_SIZE)
 #  define MI_BLOCK_SIZE 32
@@ -12,9 +14,37 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
+/// Order in which \ref Spiral visits the blocks of an image
+enum class BlockOrder : uint32_t {
+    /// Outward spiral starting from the center of the image (default)
+    Spiral,
+
+    /**
+     * Hilbert curve. Consecutive blocks are always adjacent, hence blocks
+     * that are rendered concurrently by different threads cover a compact
+     * region of the image and share cached scene data.
+     */
+    Hilbert,
+
+    /// Morton (Z-order) curve, a cheaper but less compact alternative
+    Morton
+};
+
+/// Parse the name of a block order (\c "spiral", \c "hilbert", or \c "morton")
+extern MI_EXPORT_LIB BlockOrder block_order_from_string(const std::string &name);
+
 /**
  * \brief Generates a spiral of blocks to be rendered.
  *
+ * Instead of a spiral, the blocks can also be visited along a space-filling
+ * curve (see \ref BlockOrder). The order is computed once upon construction and stored in an
+ * immutable table. Blocks are then handed out to worker threads using a
+ * single atomic counter, which means that \ref next_block() is lock-free and
+ * can be called concurrently from any number of threads. The returned block
+ * identifiers only depend on the position of the block within the traversal
+ * (and not on the thread that requested it), hence seeding remains
+ * deterministic.
+ *
  * \author Adam Arbree
  * Aug 25, 2005
  * RayTracer.java
@@ -32,7 +62,8 @@ public:
     Spiral(const Vector2u &size,
            const Vector2u &offset,
            uint32_t block_size,
-           uint32_t passes = 1);
+           uint32_t passes = 1,
+           BlockOrder order = BlockOrder::Spiral);
 
     /// Return the maximum block size
     uint32_t max_block_size() const { return m_block_size; }
@@ -40,32 +71,89 @@ public:
     /// Return the total number of blocks
     uint32_t block_count() { return m_block_count; }
 
-    /// Reset the spiral to its initial state. Does not affect the number of passes.
+    /// Return the number of passes over the image
+    uint32_t passes() const { return m_passes; }
+
+    /// Return the order in which the blocks are visited
+    BlockOrder order() const { return m_block_order; }
+
+    /**
+     * \brief Reset the spiral to its initial state. Does not affect the
+     * number of passes.
+     *
+     * This function restarts the pass that is currently in progress (or the
+     * last pass, if the traversal is done). It is not thread-safe and must not
+     * be called while other threads are querying blocks.
+     */
     void reset();
 
     /**
      * \brief Return the offset, size, and unique identifier of the next block.
      *
-     * A size of zero indicates that the spiral traversal is done.
+     * A size of zero indicates that the spiral traversal is done. This
+     * function is lock-free and may be called concurrently.
      */
     std::tuple<Vector2i, Vector2u, uint32_t> next_block();
 
+    /**
+     * \brief Return the offset, size, and unique identifier of the block with
+     * the given global index (spanning all passes).
+     *
+     * This is useful for schedulers that partition the index range
+     * <tt>[0, block_count() * passes())</tt> themselves (e.g. using
+     * <tt>dr::parallel_for</tt>). The result is identical to what the
+     * <tt>index</tt>-th call to \ref next_block() would have returned.
+     */
+    std::tuple<Vector2i, Vector2u, uint32_t> block(uint32_t index) const;
+
+    /**
+     * \brief Split the blocks into \c count partitions consisting of
+     * horizontal stripes of the image (e.g. one per NUMA node).
+     *
+     * Blocks of a partition are subsequently handed out in spiral order via
+     * \ref next_block(uint32_t). Once a partition is exhausted, its callers
+     * continue with the blocks of the other partitions. The block identifiers
+     * are the same as in the non-partitioned traversal. This function is not
+     * thread-safe, and the two variants of \ref next_block() should not be
+     * mixed.
+     */
+    void set_partitions(uint32_t count);
+
+    /// Return the number of partitions (see \ref set_partitions())
+    uint32_t partitions() const { return (uint32_t) m_partition_order.size(); }
+
+    /**
+     * \brief Return the offset, size, and unique identifier of the next block
+     * of the given partition (see \ref set_partitions()).
+     *
+     * A size of zero indicates that the traversal of all partitions is done.
+     * This function is lock-free and may be called concurrently.
+     */
+    std::tuple<Vector2i, Vector2u, uint32_t> next_block(uint32_t partition);
+
     MI_DECLARE_CLASS()
 protected:
     enum class Direction { Right, Down, Left, Up };
 
-    std::mutex m_mutex;       //< Protects the state for thread safety
     Vector2u m_size;          //< Size of the 2D image (in pixels)
     Vector2u m_offset;        //< Offset to the crop region on the sensor (pixels)
     Vector2u m_blocks;        //< Number of blocks in each direction
-    Point2i  m_position;      //< Relative position of the current block
-    Direction direction;      //< Current spiral direction
-    uint32_t m_block_counter; //< Number of blocks generated so far
     uint32_t m_block_count;   //< Number of blocks to be generated in pass
-    uint32_t m_passes_left;   //< Remaining spiral passes to be generated
+    uint32_t m_passes;        //< Total number of spiral passes
     uint32_t m_block_size;    //< Size of the (square) blocks (in pixels)
-    uint32_t m_steps_left;    //< Steps before next change of direction
-    uint32_t m_spiral_size;   //< Current spiral size in blocks
+    BlockOrder m_block_order; //< Order in which the blocks are visited
+
+    /// Precomputed block positions (in blocks) in traversal order
+    std::vector<Vector2u> m_order;
+
+    /// Global index of the next block (spanning all passes)
+    std::atomic<uint32_t> m_block_counter;
+
+    /// Global block indices of each partition (see \ref set_partitions())
+    std::vector<std::vector<uint32_t>> m_partition_order;
+
+    /// Index of the next block within each partition
+    std::unique_ptr<std::atomic<uint32_t>[]> m_partition_counter;
 };
 
 NAMESPACE_END(mitsuba)
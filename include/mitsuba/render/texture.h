@@ -5,6 +5,10 @@
 #include <mitsuba/core/transform.h>
 #include <mitsuba/render/interaction.h>
 #include <mitsuba/render/shape.h>
+#include <atomic>
+
+/// Number of evaluations memoized per thread and call site, see \ref Texture::memoize()
+#define MI_TEXTURE_MEMO_SIZE 8
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -216,6 +220,18 @@ public:
     /// Does this texture evaluation depend on the UV coordinates
     virtual bool is_spatially_varying() const { return false; }
 
+    /**
+     * \brief Return the \ref RayFlags of the surface interaction fields
+     * read by this texture (excluding nested objects)
+     *
+     * The default implementation requests the UV coordinates of spatially
+     * varying textures. The scene combines these flags to avoid computing
+     * unused fields at every intersection (see \ref Scene::ray_flags()).
+     */
+    virtual uint32_t ray_flags() const {
+        return is_spatially_varying() ? +RayFlags::UV : +RayFlags::Empty;
+    }
+
     /// Convenience function returning the standard D65 illuminant
     static ref<Texture> D65(ScalarFloat scale = 1.f);
 
@@ -234,8 +250,74 @@ public:
 protected:
     Texture(const Properties &);
 
+    /**
+     * \brief Evaluate \c func, or return its result from a previous call at
+     * the same shading point
+     *
+     * The lobes of a BSDF, the weights of nested BSDFs and the \c sample(),
+     * \c eval() and \c pdf() methods invoked during a single bounce often
+     * query the same texture at the same shading point. When memoization was
+     * enabled using \ref set_memoized(), scalar variants keep the results of
+     * the most recent queries of each call site in a small per-thread cache
+     * keyed by the texture, the texture coordinates and the wavelengths.
+     *
+     * JIT variants always evaluate \c func: lookups of the same texture at
+     * the same coordinates are identical operations within a kernel, which
+     * Dr.Jit already merges.
+     */
+    template <typename Value, typename Func>
+    Value memoize(const SurfaceInteraction3f &si, Mask active,
+                  const Func &func) const {
+        if constexpr (dr::is_array_v<Float>) {
+            DRJIT_MARK_USED(si);
+            DRJIT_MARK_USED(active);
+            return func();
+        } else {
+            if (m_memo_id == 0 || !active)
+                return func();
+
+            struct Entry {
+                uint32_t id = 0;
+                Point2f uv;
+                Wavelength wavelengths;
+                Value value;
+            };
+            static thread_local Entry cache[MI_TEXTURE_MEMO_SIZE];
+            static thread_local uint32_t next = 0;
+
+            for (const Entry &entry : cache) {
+                if (entry.id == m_memo_id && dr::all(entry.uv == si.uv) &&
+                    (!is_spectral_v<Spectrum> ||
+                     dr::all(entry.wavelengths == si.wavelengths)))
+                    return entry.value;
+            }
+
+            Value value = func();
+            cache[next] = Entry{ m_memo_id, si.uv, si.wavelengths, value };
+            next = (next + 1) % MI_TEXTURE_MEMO_SIZE;
+            return value;
+        }
+    }
+
+    /// Enable or disable the memoization of evaluations, see \ref memoize()
+    void set_memoized(bool memoized) {
+        m_memo_id = memoized ? ++memo_counter : 0;
+    }
+
+    /// Discard the memoized evaluations, e.g. when the texture data changes
+    void reset_memoized() {
+        if (m_memo_id != 0)
+            m_memo_id = ++memo_counter;
+    }
+
 protected:
     std::string m_id;
+
+    /// Key of the memoized evaluations of this texture (0 if disabled)
+    uint32_t m_memo_id = 0;
+
+    /// Source of unique keys of memoized evaluations
+    static inline std::atomic<uint32_t> memo_counter { 0 };
 };
 
 MI_EXTERN_CLASS(Texture)
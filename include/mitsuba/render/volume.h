@@ -52,6 +52,19 @@ public:
     virtual std::pair<UnpolarizedSpectrum, Vector3f> eval_gradient(const Interaction3f &it,
                                                                    Mask active = true) const;
 
+    /**
+     * \brief Evaluate the volume at a given level of its MIP pyramid
+     *
+     * Level 0 is the full resolution, and larger levels are clamped to the
+     * coarsest one (see \ref mip_levels()). The default implementation
+     * ignores the level and calls \ref eval().
+     */
+    virtual UnpolarizedSpectrum eval_mip(const Interaction3f &it, UInt32 level,
+                                         Mask active = true) const;
+
+    /// Returns the number of levels of the volume's MIP pyramid (1 if it has none)
+    virtual uint32_t mip_levels() const;
+
     /// Returns the maximum value of the volume over all dimensions.
     virtual ScalarFloat max() const;
 
@@ -63,9 +76,26 @@ public:
      */
     virtual void max_per_channel(ScalarFloat *out) const;
 
+    /**
+     * \brief Compute the maximum of the volume over the cells of a coarse grid
+     *
+     * The unit cube of the volume's local coordinate system is subdivided
+     * into <tt>res.x() * res.y() * res.z()</tt> cells. For each cell, the
+     * function writes an upper bound of the values that lookups within it can
+     * return (including interpolation) to \c out, with the x coordinate
+     * varying fastest. The default implementation uses \ref max() for all
+     * cells.
+     *
+     * Pointer allocation/deallocation must be performed by the caller.
+     */
+    virtual void max_per_cell(const ScalarVector3u &res, ScalarFloat *out) const;
+
     /// Returns the bounding box of the volume
     ScalarBoundingBox3f bbox() const { return m_bbox; }
 
+    /// Returns the transformation from world space to the local coordinates of the volume
+    const ScalarTransform4f &world_to_local() const { return m_to_local; }
+
     /**
      * \brief Returns the resolution of the volume, assuming that it is based
      * on a discrete representation.
@@ -3,6 +3,8 @@
 #include <drjit/tensor.h>
 
 #include <mitsuba/core/bbox.h>
+#include <mitsuba/core/memory.h>
+#include <mitsuba/core/mmap.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/transform.h>
@@ -16,6 +18,10 @@ NAMESPACE_BEGIN(mitsuba)
  * This class handles loading of volumes in the Mitsuba volume file format
  * Please see the documentation of gridvolume (grid3d.cpp) for the file format
  * specification.
+ *
+ * When loading single precision data from a file in the native byte order,
+ * the voxel payload is memory-mapped (copy-on-write) instead of being read
+ * into a separate buffer.
  */
 MI_VARIANT
 class MI_EXPORT_LIB VolumeGrid : public Object {
@@ -48,10 +54,13 @@ public:
     VolumeGrid(ScalarVector3u size, ScalarUInt32 channel_count);
 
     /// Return a pointer to the underlying volume storage
-    ScalarFloat *data() { return m_data.get(); }
+    ScalarFloat *data() { return m_data_ptr; }
 
     /// Return a pointer to the underlying volume storage
-    const ScalarFloat *data() const { return m_data.get(); }
+    const ScalarFloat *data() const { return m_data_ptr; }
+
+    /// Is the volume storage memory-mapped from a file?
+    bool is_mapped() const { return m_mmap.get() != nullptr; }
 
     /// Return the resolution of the voxel grid
     ScalarVector3u size() const { return m_size; }
@@ -93,16 +102,22 @@ public:
      *
      * \param path
      *    Target file name (expected to end in ".vol")
+     *
+     * \param half
+     *    Store the voxel values in half precision (encoding 2)
      */
-    void write(const fs::path &path) const;
+    void write(const fs::path &path, bool half = false) const;
 
     /**
      * Write an encoded form of the volume grid to a stream
      *
      * \param stream
      *    Target stream that will receive the encoded output
+     *
+     * \param half
+     *    Store the voxel values in half precision (encoding 2)
      */
-    void write(Stream *stream) const;
+    void write(Stream *stream, bool half = false) const;
 
     /// Return a human-readable summary of this volume grid
     virtual std::string to_string() const override;
@@ -112,8 +127,18 @@ public:
 protected:
     void read(Stream *stream);
 
+    /// Read the header of a volume file and return its encoding
+    int32_t read_header(Stream *stream);
+
+    /// Compute the maximum values of the grid (in parallel)
+    void compute_max();
+
 protected:
     std::unique_ptr<ScalarFloat[]> m_data;
+    ref<MemoryMappedFile> m_mmap;
+    ScalarFloat *m_data_ptr = nullptr;
+    /// Accounts for \ref m_data (memory-mapped files are not included)
+    MemoryAllocation m_memory { MemoryCategory::VolumeGrid };
 
     ScalarVector3u m_size;
     ScalarUInt32 m_channel_count;
@@ -1,8 +1,10 @@
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/random.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/string.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/texture.h>
+#include <atomic>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -21,6 +23,11 @@ Blended material (:monosp:`blendbsdf`)
      accordingly. (Default: 0.5)
    - |exposed|, |differentiable|
 
+ * - stochastic
+   - |bool|
+   - Evaluate only one of the nested BSDFs, chosen randomly according to the blending weight,
+     instead of both of them (see below). (Default: false)
+
  * - (Nested plugin)
    - |bsdf|
    - Two nested BSDF instances that should be mixed according to the specified blending weight
@@ -38,6 +45,17 @@ rough, reflecting, or transmitting) can be mixed with others in this manner to s
 The association of nested BSDF plugins with the two positions in the interpolation is based on the
 alphanumeric order of their identifiers.
 
+When :paramtype:`stochastic` is set, :monosp:`eval()` and :monosp:`pdf()` return the value and
+the density of a single nested BSDF, which is chosen with a probability equal to its blending
+weight (this is how :monosp:`sample()` always selects a nested BSDF). The result is an unbiased
+estimate of the blend whose cost doesn't grow with the number of nested BSDFs, which matters for
+deep trees of blended materials if their nested :monosp:`blendbsdf` instances are stochastic as
+well. The choice is a deterministic function of the position, the incident and the outgoing
+direction, so that the value and the density of a direction always refer to the same nested BSDF.
+Multiple importance sampling then effectively combines the techniques of each nested BSDF
+separately. The estimate adds noise, in particular when blending BSDFs with very different
+values, and is therefore disabled by default.
+
 The following XML snippet describes the material shown above:
 
 .. tabs::
@@ -90,6 +108,8 @@ public:
         }
 
         m_weight = props.texture<Texture>("weight");
+        m_stochastic = props.get<bool>("stochastic", false);
+        m_seed = seed_counter++;
         if (bsdf_index != 2)
             Throw("BlendBSDF: Two child BSDFs must be specified!");
 
@@ -99,6 +119,11 @@ public:
                 m_components.push_back(m_nested_bsdf[i]->flags(j));
 
         m_flags = m_nested_bsdf[0]->flags() | m_nested_bsdf[1]->flags();
+
+        // The blend only preserves the polarization state if both BSDFs do
+        if (!has_flag(m_nested_bsdf[0]->flags(), BSDFFlags::Depolarizing) ||
+            !has_flag(m_nested_bsdf[1]->flags(), BSDFFlags::Depolarizing))
+            m_flags = m_flags & ~BSDFFlags::Depolarizing;
     }
 
     void traverse(TraversalCallback *callback) override {
@@ -165,6 +190,21 @@ public:
             return weight * m_nested_bsdf[sample_first ? 0 : 1]->eval(ctx2, si, wo, active);
         }
 
+        if (m_stochastic) {
+            Mask m1 = active && select_second(si, wo, weight),
+                 m0 = active && !m1;
+            Float weight_1 = dr::select(m1, weight, 1 - weight);
+
+            Spectrum result(0.f);
+            if (dr::any_or<true>(m0))
+                dr::masked(result, m0) = m_nested_bsdf[0]->eval(ctx, si, wo, m0);
+            if (dr::any_or<true>(m1))
+                dr::masked(result, m1) = m_nested_bsdf[1]->eval(ctx, si, wo, m1);
+
+            // Keep the derivative with respect to the blending weight
+            return result * (weight_1 / dr::detach(weight_1));
+        }
+
         return m_nested_bsdf[0]->eval(ctx, si, wo, active) * (1 - weight) +
                m_nested_bsdf[1]->eval(ctx, si, wo, active) * weight;
     }
@@ -182,6 +222,18 @@ public:
         }
 
         Float weight = eval_weight(si, active);
+        if (m_stochastic) {
+            Mask m1 = active && select_second(si, wo, weight),
+                 m0 = active && !m1;
+
+            Float result(0.f);
+            if (dr::any_or<true>(m0))
+                dr::masked(result, m0) = m_nested_bsdf[0]->pdf(ctx, si, wo, m0);
+            if (dr::any_or<true>(m1))
+                dr::masked(result, m1) = m_nested_bsdf[1]->pdf(ctx, si, wo, m1);
+            return result;
+        }
+
         return m_nested_bsdf[0]->pdf(ctx, si, wo, active) * (1 - weight) +
                m_nested_bsdf[1]->pdf(ctx, si, wo, active) * weight;
     }
@@ -205,6 +257,27 @@ public:
             return { weight * val, pdf };
         }
 
+        if (m_stochastic) {
+            Mask m1 = active && select_second(si, wo, weight),
+                 m0 = active && !m1;
+            Float weight_1 = dr::select(m1, weight, 1 - weight);
+
+            Spectrum value(0.f);
+            Float pdf(0.f);
+            if (dr::any_or<true>(m0)) {
+                auto [val_0, pdf_0] = m_nested_bsdf[0]->eval_pdf(ctx, si, wo, m0);
+                dr::masked(value, m0) = val_0;
+                dr::masked(pdf, m0) = pdf_0;
+            }
+            if (dr::any_or<true>(m1)) {
+                auto [val_1, pdf_1] = m_nested_bsdf[1]->eval_pdf(ctx, si, wo, m1);
+                dr::masked(value, m1) = val_1;
+                dr::masked(pdf, m1) = pdf_1;
+            }
+
+            return { value * (weight_1 / dr::detach(weight_1)), pdf };
+        }
+
         auto [val_0, pdf_0] = m_nested_bsdf[0]->eval_pdf(ctx, si, wo, active);
         auto [val_1, pdf_1] = m_nested_bsdf[1]->eval_pdf(ctx, si, wo, active);
 
@@ -216,6 +289,30 @@ public:
         return dr::clip(m_weight->eval_1(si, active), 0.f, 1.f);
     }
 
+    /**
+     * \brief Randomly choose the nested BSDF that is evaluated in stochastic
+     * mode, returning \c true for the second one
+     *
+     * The random number is a hash of the position and of both directions,
+     * decorrelated from the choices of other blends by a per-instance seed.
+     */
+    Mask select_second(const SurfaceInteraction3f &si, const Vector3f &wo,
+                       const Float &weight) const {
+        using Float32 = dr::float32_array_t<Float>;
+        auto bits = [](const Float &value) {
+            return dr::reinterpret_array<UInt32>(Float32(dr::detach(value)));
+        };
+
+        UInt32 hash = sample_tea_32(bits(si.p.x()) ^ bits(wo.x()),
+                                    bits(si.p.y()) ^ bits(wo.y())).first;
+        hash = sample_tea_32(hash ^ bits(si.p.z()) ^ bits(wo.z()),
+                             bits(si.wi.x()) ^ bits(si.wi.y())).first;
+        Float sample = Float(
+            sample_tea_float32(hash ^ bits(si.wi.z()), UInt32(m_seed)));
+
+        return sample < dr::detach(weight);
+    }
+
     Spectrum eval_diffuse_reflectance(const SurfaceInteraction3f &si,
                                      Mask active) const override {
         Float weight = eval_weight(si, active);
@@ -227,6 +324,7 @@ public:
         std::ostringstream oss;
         oss << "BlendBSDF[" << std::endl
             << "  weight = " << string::indent(m_weight) << "," << std::endl
+            << "  stochastic = " << m_stochastic << "," << std::endl
             << "  nested_bsdf[0] = " << string::indent(m_nested_bsdf[0]) << "," << std::endl
             << "  nested_bsdf[1] = " << string::indent(m_nested_bsdf[1]) << std::endl
             << "]";
@@ -237,6 +335,11 @@ public:
 protected:
     ref<Texture> m_weight;
     ref<Base> m_nested_bsdf[2];
+    bool m_stochastic;
+    uint32_t m_seed;
+
+    /// Seeds of the random choices of the instances in stochastic mode
+    static inline std::atomic<uint32_t> seed_counter { 0 };
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(BlendBSDF, BSDF)
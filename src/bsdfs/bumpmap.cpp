@@ -120,6 +120,11 @@ public:
         callback->put_parameter("scale",        m_scale,                +ParamFlags::NonDifferentiable);
     }
 
+    // The height field is differentiated along the UV parameterization
+    uint32_t ray_flags() const override {
+        return RayFlags::UV | RayFlags::dPdUV | RayFlags::ShadingFrame;
+    }
+
     std::pair<BSDFSample3f, Spectrum> sample(const BSDFContext &ctx,
                                              const SurfaceInteraction3f &si,
                                              Float sample1,
@@ -89,8 +89,9 @@ public:
 
     SmoothDiffuse(const Properties &props) : Base(props) {
         m_reflectance = props.texture<Texture>("reflectance", .5f);
-        m_flags = BSDFFlags::DiffuseReflection | BSDFFlags::FrontSide;
-        m_components.push_back(m_flags);
+        m_components.push_back(BSDFFlags::DiffuseReflection |
+                               BSDFFlags::FrontSide);
+        m_flags = m_components[0] | BSDFFlags::Depolarizing;
     }
 
     void traverse(TraversalCallback *callback) override {
@@ -1,3 +1,4 @@
+#include <mitsuba/core/distr_1d.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/warp.h>
@@ -17,7 +18,7 @@ Hair material (:monosp:`hair`)
 -------------------------------------------
 
 .. pluginparameters::
- :extra-rows: 6
+ :extra-rows: 8
 
  * - eumelanin, pheomelanin
    - |float|
@@ -68,6 +69,15 @@ Hair material (:monosp:`hair`)
    - Relative index of refraction from the exterior to the interior
    - |exposed|, |differentiable|, |discontinuous|
 
+ * - tabulated
+   - |bool|
+   - Evaluate and sample the longitudinal and azimuthal scattering terms using
+     tables computed when the roughness changes (see below). (Default: |false|)
+
+ * - tabulation_resolution
+   - |int|
+   - Resolution of these tables, which controls their accuracy. (Default: 128)
+
 This plugin is an implementation of the hair model described in the paper *A
 Practical and Controllable Hair and Fur Model for Production Path Tracing* by
 Chiang et al. :cite:`Chiang2016hair`.
@@ -75,6 +85,17 @@ Chiang et al. :cite:`Chiang2016hair`.
 When no parameters are given, the plugin activates the default settings,
 which describe a brown-ish hair color.
 
+The longitudinal scattering terms involve modified Bessel functions, which
+make up a large part of the cost of this model. When :monosp:`tabulated` is
+set, the plugin instead tabulates the density of the longitudinal angle of the
+outgoing direction for each lobe on a grid of incident and outgoing angles,
+as well as the azimuthal logistic distribution. Both tables are linearly
+interpolated during evaluation, and importance sampling inverts the
+interpolated densities, so that sampling and evaluation remain consistent.
+Narrow lobes (i.e. a roughness below about 0.15) need a higher
+:monosp:`tabulation_resolution` to be represented accurately. The tables are
+computed from the current roughness values and are not differentiated.
+
 This BSDF is meant to be used with the `bsplinecurve` shape. Attaching this
 material to any other shape might produce unexpected results. This is due to
 assumptions about the local geoemtry and frame in the model itself.
@@ -177,6 +198,12 @@ public:
         }
         m_scale = props.get<ScalarFloat>("scale", 1.f);
 
+        // Tabulated longitudinal and azimuthal scattering
+        m_tabulated = props.get<bool>("tabulated", false);
+        m_resolution = props.get<uint32_t>("tabulation_resolution", 128);
+        if (m_resolution < 4)
+            Throw("The tabulation resolution must be at least 4!");
+
         if (longitudinal_roughness < 0 || longitudinal_roughness > 1.f)
             Throw("The longitudinal roughness should be in the range [0, 1]!");
         if (azimuthal_roughness < 0 || azimuthal_roughness > 1.f)
@@ -196,7 +223,7 @@ public:
                                BSDFFlags::NonSymmetric | BSDFFlags::FrontSide);
         m_components.push_back(BSDFFlags::Null | BSDFFlags::BackSide);
 
-        m_flags = m_components[0] | m_components[1];
+        m_flags = m_components[0] | m_components[1] | BSDFFlags::Depolarizing;
 
         update();
     }
@@ -229,104 +256,12 @@ public:
            Float sample1, const Point2f &sample2, Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::BSDFSample, active);
 
-        BSDFSample3f bs = dr::zeros<BSDFSample3f>(dr::width(si));
-
         if (unlikely(dr::none_or<false>(active) ||
                      !ctx.is_enabled(BSDFFlags::Glossy)))
-            return { bs, 0.f };
-
-        // Parameterization of incident direction
-        Float gamma_i = gamma(si.wi);
-        Float h = dr::sin(gamma_i);
-        auto [sin_theta_i, cos_theta_i] = sincos_theta(si.wi);
-        Float phi_i = azimuthal_angle(si.wi);
-        auto [sin_phi_i, cos_phi_i] = dr::sincos(phi_i);
-
-        // Sample segment length `p`
-        dr::Array<Float, P_MAX + 1> a_p_pdf = attenuation_pdf(cos_theta_i, si);
-
-        Point2f u[2] = { { sample1, 0 }, sample2 };
-        // u[0][1] is the rescaled random number after using u[0][0]
-        u[0][1] = u[0][0] / a_p_pdf[0];
-
-        UInt32 p = dr::zeros<UInt32>(dr::width(si));
-        for (size_t i = 0; i < P_MAX; ++i) {
-            Bool sample_p = a_p_pdf[i] < u[0][0];
-            u[0][0] -= a_p_pdf[i];
-
-            dr::masked(p, sample_p) = (uint32_t)i + 1;
-            dr::masked(u[0][1], sample_p) = u[0][0] / a_p_pdf[i + 1];
-        }
-
-        // Account for scales on hair surface
-        Float sin_theta_ip(0.f);
-        Float cos_theta_ip(0.f);
-        for (size_t j = 0; j < P_MAX; j++) {
-            auto [sin_theta_ij, cos_theta_ij] =
-                reframe_with_scales(sin_theta_i, cos_theta_i, j);
-            dr::masked(sin_theta_ip, p == j) = sin_theta_ij;
-            dr::masked(cos_theta_ip, p == j) = cos_theta_ij;
-        }
-
-        // Sample longitudinal scattering
-        Float cos_theta =
-            1 + m_v[P_MAX] *
-                dr::log(u[1][0] + (1.f - u[1][0]) * dr::exp(-2.f / m_v[P_MAX]));
-        for (size_t i = 0; i < P_MAX; i++)
-            dr::masked(cos_theta, p == i) =
-                1 + m_v[i] * dr::log(u[1][0] + (1.f - u[1][0]) * dr::exp(-2.f / m_v[i]));
-        Float sin_theta = dr::safe_sqrt(1.f - dr::square(cos_theta));
-        Float cos_phi = dr::cos(2 * dr::Pi<ScalarFloat> * u[1][1]);
-        Float sin_theta_o =
-            -cos_theta * sin_theta_ip + sin_theta * cos_phi * cos_theta_ip;
-        Float cos_theta_o = dr::safe_sqrt(1.f - dr::square(sin_theta_o));
-
-        // Transmission angle in azimuthal plane
-        Float eta_p = azimuthal_ior(sin_theta_i, cos_theta_i);
-        Float sin_gamma_t = h / eta_p;
-        Float gamma_t = dr::safe_asin(sin_gamma_t);
-
-        // Sample azimuthal scattering
-        Float perfect_delta_phi =
-            2 * p * gamma_t - 2 * gamma_i + p * dr::Pi<ScalarFloat>;
-        Float delta_phi_first_terms =
-            perfect_delta_phi + trimmed_logistic_sample(u[0][1], m_s);
-        Float delta_phi_remainder = 2 * dr::Pi<ScalarFloat> * u[0][1];
-        Float delta_phi =
-            dr::select(p < P_MAX, delta_phi_first_terms, delta_phi_remainder);
-
-        // Outgoing direction
-        Float phi_o = phi_i + delta_phi;
-        auto [sin_phi_o, cos_phi_o] = dr::sincos(phi_o);
-        Vector3f wo(cos_theta_o * cos_phi_o, sin_theta_o,
-                    cos_theta_o * sin_phi_o);
-
-        // PDF for sampled outgoing direction
-        for (size_t i = 0; i < P_MAX; ++i) {
-            // Account for scales on hair surface
-            auto [sin_theta_ip_, cos_theta_ip_] =
-                reframe_with_scales(sin_theta_i, cos_theta_i, i);
-            Vector3f wi_p(cos_theta_ip_ * cos_phi_i, sin_theta_ip_,
-                          cos_theta_ip_ * sin_phi_i);
-
-            bs.pdf += longitudinal_scattering(wi_p, wo, { 0, 1.f, 0 }, m_v[i]) *
-                      dr::TwoPi<Float> * a_p_pdf[i] *
-                      azimuthal_scattering(delta_phi, i, m_s, gamma_i, gamma_t);
-        }
-        bs.pdf +=
-            longitudinal_scattering(si.wi, wo, { 0, 1.f, 0 }, m_v[P_MAX]) *
-            a_p_pdf[P_MAX];
-
-        bs.wo = dr::normalize(wo);
-        bs.pdf = dr::select(dr::isnan(bs.pdf) || dr::isinf(bs.pdf), 0, bs.pdf);
-        bs.eta = 1.f; // We always completely cross the hair fiber
-        bs.sampled_type = +BSDFFlags::Glossy;
-        bs.sampled_component = 0;
-
-        Spectrum value = dr::select(
-            bs.pdf != 0, eval(ctx, si, bs.wo, active) / bs.pdf, 0);
+            return { dr::zeros<BSDFSample3f>(dr::width(si)), 0.f };
 
-        return { bs, depolarizer<Spectrum>(value) & (active && bs.pdf > 0.f) };
+        return sample_shared(si, sample1, sample2, incident_terms(si, active),
+                             active);
     }
 
     Spectrum eval(const BSDFContext &ctx, const SurfaceInteraction3f &si,
@@ -337,52 +272,8 @@ public:
                      !ctx.is_enabled(BSDFFlags::Glossy)))
             return 0.f;
 
-        // Parameterization of incident and outgoing directions
-        Float gamma_i = gamma(si.wi);
-        Float h = dr::sin(gamma_i);
-        auto [sin_theta_i, cos_theta_i] = sincos_theta(si.wi);
-        Float phi_i = azimuthal_angle(si.wi);
-        auto [sin_phi_i, cos_phi_i] = dr::sincos(phi_i);
-        Float phi_o = azimuthal_angle(wo);
-
-        // Transmission angle in longitudinal plane
-        Float sin_theta_t = sin_theta_i / m_eta;
-        Float cos_theta_t = dr::safe_sqrt(1.f - dr::square(sin_theta_t));
-
-        // Transmission angle in azimuthal plane
-        Float eta_p =
-            dr::safe_sqrt(dr::square(m_eta) - dr::square(sin_theta_i)) / cos_theta_i;
-        Float sin_gamma_t = h / eta_p;
-        Float cos_gamma_t = dr::safe_sqrt(1.f - dr::square(sin_gamma_t));
-        Float gamma_t = dr::safe_asin(sin_gamma_t);
-
-        // Attenuation coefficients
-        UnpolarizedSpectrum sigma_a = absorption(si, active);
-        Float transmitted_length = 2 * cos_gamma_t / cos_theta_t;
-        UnpolarizedSpectrum transmittance = dr::exp(-sigma_a * transmitted_length);
-        AttenuationCoeffs a_p =
-            attenuation(cos_theta_i, m_eta, h, transmittance);
-
-        // Contribution of first `P_MAX` terms
-        Float delta_phi = phi_o - phi_i;
-        UnpolarizedSpectrum value(0.0f);
-        for (int p = 0; p < P_MAX; ++p) {
-            // Account for scales on hair surface
-            auto [sin_theta_ip, cos_theta_ip] =
-                reframe_with_scales(sin_theta_i, cos_theta_i, p);
-            Vector3f wi_p(cos_theta_ip * cos_phi_i, sin_theta_ip,
-                          cos_theta_ip * sin_phi_i);
-
-            value += longitudinal_scattering(wi_p, wo, { 0, 1.f, 0 }, m_v[p]) *
-                     dr::TwoPi<Float> * a_p[p] *
-                     azimuthal_scattering(delta_phi, p, m_s, gamma_i, gamma_t);
-        }
-
-        // Contribution of remaining terms
-        value += longitudinal_scattering(si.wi, wo, { 0, 1.f, 0 }, m_v[P_MAX]) *
-                a_p[P_MAX];
-
-        value = dr::select(dr::isnan(value) || dr::isinf(value), 0, value);
+        UnpolarizedSpectrum value =
+            eval_pdf_shared(wo, incident_terms(si, active)).first;
 
         return depolarizer<Spectrum>(value) & active;
     }
@@ -395,43 +286,7 @@ public:
                      !ctx.is_enabled(BSDFFlags::Glossy)))
             return 0.f;
 
-        // Parameterization of incident and outgoing directions
-        Float gamma_i = gamma(si.wi);
-        Float h = dr::sin(gamma_i);
-        auto [sin_theta_i, cos_theta_i] = sincos_theta(si.wi);
-        Float phi_i = azimuthal_angle(si.wi);
-        auto [sin_phi_i, cos_phi_i] = dr::sincos(phi_i);
-        Float phi_o = azimuthal_angle(wo);
-
-        // Transmission angle in azimuthal plane
-        Float eta_p =
-            dr::safe_sqrt(Float(m_eta * m_eta) - dr::square(sin_theta_i)) /
-            cos_theta_i;
-        Float sin_gamma_t = h / eta_p;
-        Float gamma_t = dr::safe_asin(sin_gamma_t);
-
-        // Attenuation PDF
-        dr::Array<Float, P_MAX + 1> apPdf = attenuation_pdf(cos_theta_i, si);
-
-        // Compute PDF sum for each segment length
-        Float delta_phi  = phi_o - phi_i;
-        Float pdf(0.0f);
-        for (int p = 0; p < P_MAX; ++p) {
-            // Account for scales on hair surface
-            auto [sin_theta_ip, cos_theta_ip] =
-                reframe_with_scales(sin_theta_i, cos_theta_i, p);
-            Vector3f wi_p(cos_theta_ip * cos_phi_i, sin_theta_ip,
-                          cos_theta_ip * sin_phi_i);
-
-            pdf += longitudinal_scattering(wi_p, wo, { 0, 1.f, 0 }, m_v[p]) *
-                    dr::TwoPi<Float> * apPdf[p] *
-                    azimuthal_scattering(delta_phi, p, m_s, gamma_i, gamma_t);
-        }
-        pdf += longitudinal_scattering(si.wi, wo, { 0, 1.f, 0 }, m_v[P_MAX]) *
-                apPdf[P_MAX];
-
-        pdf = dr::select(dr::isnan(pdf) || dr::isinf(pdf), 0, pdf);
-        return pdf;
+        return eval_pdf_shared(wo, incident_terms(si, active)).second;
     }
 
     std::pair<Spectrum, Float> eval_pdf(const BSDFContext &ctx,
@@ -444,72 +299,40 @@ public:
                      !ctx.is_enabled(BSDFFlags::Glossy)))
             return { 0.f, 0.f };
 
-        Float gamma_i = gamma(si.wi);
-        Float h = dr::sin(gamma_i);
-
-        Float phi_o = azimuthal_angle(wo);
-
-        // Parameterization of incident directions
-        auto [sin_theta_i, cos_theta_i] = sincos_theta(si.wi);
-        Float phi_i = azimuthal_angle(si.wi);
-        auto [sin_phi_i, cos_phi_i] = dr::sincos(phi_i);
-
-        // Transmission angle in longitudinal plane
-        Float sin_theta_t = sin_theta_i / m_eta;
-        Float cos_theta_t = dr::safe_sqrt(1.f - dr::square(sin_theta_t));
+        auto [value, pdf] = eval_pdf_shared(wo, incident_terms(si, active));
 
-        // Transmission angle in azimuthal plane
-        Float eta_p =
-            dr::safe_sqrt(Float(m_eta * m_eta) - dr::square(sin_theta_i)) /
-            cos_theta_i;
-        Float sin_gamma_t = h / eta_p;
-        Float cos_gamma_t = dr::safe_sqrt(1.f - dr::square(sin_gamma_t));
-        Float gamma_t = dr::safe_asin(sin_gamma_t);
+        return { depolarizer<Spectrum>(value) & active,
+                 dr::select(active, pdf, 0.f) };
+    }
 
-        // Attenuation coefficients
-        UnpolarizedSpectrum sigma_a = absorption(si, active);
-        Float transmitted_length = 2 * cos_gamma_t / cos_theta_t;
-        UnpolarizedSpectrum transmittance = dr::exp(-sigma_a * transmitted_length);
-        AttenuationCoeffs a_p =
-            attenuation(cos_theta_i, Float(m_eta), h, transmittance);
-        dr::Array<Float, P_MAX + 1> a_p_pdf = attenuation_pdf(cos_theta_i, si);
+    std::tuple<Spectrum, Float, BSDFSample3f, Spectrum>
+    eval_pdf_sample(const BSDFContext &ctx,
+                    const SurfaceInteraction3f &si,
+                    const Vector3f &wo,
+                    Float sample1,
+                    const Point2f &sample2,
+                    Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::BSDFSample, active);
 
-        // Accumulate PDF and contribution for each segment length
-        Float delta_phi = phi_o - phi_i;
-        Float pdf = Float(0.0f);
-        UnpolarizedSpectrum value(0.0f);
-        for (int p = 0; p < P_MAX; ++p) {
-            auto [sin_theta_ip, cos_theta_ip] =
-                reframe_with_scales(sin_theta_i, cos_theta_i, p);
-            Vector3f wi_p(cos_theta_ip * cos_phi_i, sin_theta_ip,
-                          cos_theta_ip * sin_phi_i);
-
-            Float longitudinal =
-                longitudinal_scattering(wi_p, wo, { 0, 1.f, 0 }, m_v[p]);
-            Float azimuthal =
-                azimuthal_scattering(delta_phi, p, m_s, gamma_i, gamma_t);
-
-            pdf   += longitudinal * dr::TwoPi<Float> * a_p_pdf[p] * azimuthal;
-            value += longitudinal * dr::TwoPi<Float> * a_p[p]     * azimuthal;
-        }
+        if (unlikely(dr::none_or<false>(active) ||
+                     !ctx.is_enabled(BSDFFlags::Glossy)))
+            return { 0.f, 0.f, dr::zeros<BSDFSample3f>(dr::width(si)), 0.f };
 
-        // Contribution and PDF of remaining terms
-        Float longitudinal =
-            longitudinal_scattering(si.wi, wo, { 0, 1.f, 0 }, m_v[P_MAX]);
-        pdf += longitudinal * a_p_pdf[P_MAX];
-        value += longitudinal * a_p[P_MAX];
+        // The attenuation and the reframed incident directions are shared
+        IncidentTerms t = incident_terms(si, active);
 
-        pdf   = dr::select(dr::isnan(pdf)   || dr::isinf(pdf),   0, pdf);
-        value = dr::select(dr::isnan(value) || dr::isinf(value), 0, value);
+        auto [value, pdf] = eval_pdf_shared(wo, t);
+        auto [bs, weight] = sample_shared(si, sample1, sample2, t, active);
 
         return { depolarizer<Spectrum>(value) & active,
-                 dr::select(active, pdf, 0.f) };
+                 dr::select(active, pdf, 0.f), bs, weight };
     }
 
     std::string to_string() const override {
         std::ostringstream oss;
-        oss << "Hair["
-            << std::endl
+        oss << "Hair[" << std::endl
+            << "  tabulated = " << m_tabulated << "," << std::endl
+            << "  tabulation_resolution = " << m_resolution << std::endl
             << "]";
         return oss.str();
     }
@@ -560,6 +383,141 @@ private:
         m_v[2] = 4 * m_v[0];
         for (int p = 3; p <= P_MAX; ++p)
             m_v[p] = m_v[2];
+
+        if (m_tabulated)
+            build_tables();
+    }
+
+    /**
+     * \brief Tabulate the longitudinal and azimuthal scattering terms
+     *
+     * The longitudinal table stores the density of the sine of the outgoing
+     * longitudinal angle on a regular grid of the sines of the incident
+     * (slowest varying) and outgoing angles in <tt>[-1, 1]</tt>, for each
+     * distinct variance (the remaining lobes share the variance of the third
+     * one). Every row is normalized w.r.t. the linear interpolation of its
+     * entries, and is accompanied by its cumulative distribution.
+     */
+    void build_tables() {
+        const uint32_t res = m_resolution;
+        const ScalarFloat step = 2.f / (res - 1);
+
+        std::vector<ScalarFloat> pdf(3 * res * res), cdf(3 * res * (res - 1));
+        for (uint32_t t = 0; t < 3; ++t) {
+            ScalarFloat kappa = 1.f / dr::slice(m_v[t]);
+            for (uint32_t i = 0; i < res; ++i) {
+                ScalarFloat sin_theta_i = dr::minimum(i * step - 1.f, 1.f);
+                ScalarVector3f wi(dr::safe_sqrt(1.f - dr::square(sin_theta_i)),
+                                  sin_theta_i, 0.f);
+
+                ScalarFloat *row_pdf = pdf.data() + (t * res + i) * res,
+                            *row_cdf = cdf.data() + (t * res + i) * (res - 1);
+
+                for (uint32_t k = 0; k < res; ++k) {
+                    ScalarFloat sin_theta_o = dr::minimum(k * step - 1.f, 1.f);
+                    ScalarVector3f wo(dr::safe_sqrt(1.f - dr::square(sin_theta_o)),
+                                      sin_theta_o, 0.f);
+                    row_pdf[k] = dr::TwoPi<ScalarFloat> *
+                                 warp::square_to_rough_fiber_pdf<ScalarFloat>(
+                                     wo, wi, ScalarVector3f(0.f, 1.f, 0.f), kappa);
+                    if (!dr::isfinite(row_pdf[k]))
+                        row_pdf[k] = 0.f;
+                }
+
+                double integral = 0.;
+                for (uint32_t k = 0; k < res - 1; ++k) {
+                    integral += .5 * step * ((double) row_pdf[k] + (double) row_pdf[k + 1]);
+                    row_cdf[k] = (ScalarFloat) integral;
+                }
+
+                if (!(integral > 0.))
+                    Throw("Unable to tabulate the longitudinal scattering, "
+                          "try increasing the tabulation resolution!");
+
+                for (uint32_t k = 0; k < res; ++k)
+                    row_pdf[k] = ScalarFloat(row_pdf[k] / integral);
+                for (uint32_t k = 0; k < res - 1; ++k)
+                    row_cdf[k] = ScalarFloat(row_cdf[k] / integral);
+            }
+        }
+
+        m_longitudinal_pdf = dr::load<DynamicBuffer<Float>>(pdf.data(), pdf.size());
+        m_longitudinal_cdf = dr::load<DynamicBuffer<Float>>(cdf.data(), cdf.size());
+
+        // Trimmed logistic distribution of the azimuthal offset
+        ScalarFloat s = dr::slice(m_s);
+        std::vector<ScalarFloat> azimuthal(res);
+        for (uint32_t k = 0; k < res; ++k) {
+            ScalarFloat x = dr::abs(dr::Pi<ScalarFloat> * (k * step - 1.f));
+            azimuthal[k] = dr::exp(-x / s) / (s * dr::square(1.f + dr::exp(-x / s)));
+        }
+        m_azimuthal_distr = ContinuousDistribution<Float>(
+            ScalarVector2f(-dr::Pi<ScalarFloat>, dr::Pi<ScalarFloat>),
+            azimuthal.data(), res);
+    }
+
+    /// Interpolated density of the sine of the outgoing longitudinal angle
+    Float longitudinal_tabulated(const Float &sin_theta_i,
+                                 const Float &sin_theta_o,
+                                 const UInt32 &table) const {
+        const uint32_t res = m_resolution;
+        Float x = dr::clip(dr::fmadd(sin_theta_i, .5f, .5f), 0.f, 1.f) * (res - 1),
+              y = dr::clip(dr::fmadd(sin_theta_o, .5f, .5f), 0.f, 1.f) * (res - 1);
+        UInt32 i = dr::minimum(UInt32(x), res - 2),
+               k = dr::minimum(UInt32(y), res - 2);
+        Float fx = x - Float(i), fy = y - Float(k);
+
+        UInt32 index = (table * res + i) * res + k;
+        Float v00 = dr::gather<Float>(m_longitudinal_pdf, index),
+              v01 = dr::gather<Float>(m_longitudinal_pdf, index + 1),
+              v10 = dr::gather<Float>(m_longitudinal_pdf, index + res),
+              v11 = dr::gather<Float>(m_longitudinal_pdf, index + res + 1);
+
+        return dr::lerp(dr::lerp(v00, v01, fy), dr::lerp(v10, v11, fy), fx);
+    }
+
+    /**
+     * \brief Sample the sine of the outgoing longitudinal angle from the
+     * interpolated density of \ref longitudinal_tabulated()
+     *
+     * The second sample dimension selects one of the two neighboring rows
+     * according to the interpolation weight, the first one inverts the
+     * cumulative distribution of this row.
+     */
+    Float sample_longitudinal_tabulated(const Float &sin_theta_i,
+                                        const UInt32 &table,
+                                        const Point2f &sample,
+                                        Mask active) const {
+        const uint32_t res = m_resolution;
+        Float x = dr::clip(dr::fmadd(sin_theta_i, .5f, .5f), 0.f, 1.f) * (res - 1);
+        UInt32 i = dr::minimum(UInt32(x), res - 2);
+        dr::masked(i, sample.y() < x - Float(i)) = i + 1;
+
+        UInt32 row = table * res + i,
+               pdf_offset = row * res,
+               cdf_offset = row * (res - 1);
+
+        UInt32 index = dr::binary_search<UInt32>(
+            0, res - 2,
+            [&](UInt32 index) DRJIT_INLINE_LAMBDA {
+                return dr::gather<Float>(m_longitudinal_cdf, cdf_offset + index,
+                                         active) < sample.x();
+            }
+        );
+
+        Float y0 = dr::gather<Float>(m_longitudinal_pdf, pdf_offset + index, active),
+              y1 = dr::gather<Float>(m_longitudinal_pdf, pdf_offset + index + 1u, active),
+              c0 = dr::gather<Float>(m_longitudinal_cdf, cdf_offset + index - 1u,
+                                     active && index > 0);
+
+        ScalarFloat w = 2.f / (res - 1);
+        Float value = (sample.x() - c0) / w;
+
+        Float t_linear = (y0 - dr::safe_sqrt(dr::square(y0) + 2.f * value * (y1 - y0))) / (y0 - y1),
+              t_const  = value / y0,
+              t        = dr::select(y0 == y1, t_const, t_linear);
+
+        return dr::clip(dr::fmadd(Float(index) + t, w, -1.f), -1.f, 1.f);
     }
 
     /// Sine / cosine of longitudinal angle for direction `w`
@@ -649,31 +607,12 @@ private:
         return a_p;
     }
 
-    dr::Array<Float, P_MAX + 1> attenuation_pdf(Float cos_theta_i,
-                                                const SurfaceInteraction3f &si,
-                                                Mask active = true) const {
+    /// Probabilities of sampling each segment length given its attenuation
+    dr::Array<Float, P_MAX + 1>
+    attenuation_pdf(const AttenuationCoeffs &a_p,
+                    const SurfaceInteraction3f &si) const {
         using Array_pmax_f = dr::Array<Float, P_MAX + 1>;
 
-        // Parameterization of incident direction
-        Float gamma_i = gamma(si.wi);
-        Float h = dr::sin(gamma_i);
-        Float sin_theta_i = dr::safe_sqrt(1.f - cos_theta_i * cos_theta_i);
-
-        // Transmission angle in longitudinal plane
-        Float sin_theta_t = sin_theta_i / m_eta;
-        Float cos_theta_t = dr::safe_sqrt(1.f - dr::square(sin_theta_t));
-
-        // Transmission angle in azimuthal plane
-        Float eta_p = azimuthal_ior(sin_theta_i, cos_theta_i);
-        Float sin_gamma_t = h / eta_p;
-        Float cos_gamma_t = dr::safe_sqrt(1.f - dr::square(sin_gamma_t));
-
-        // Attenuation coefficients
-        UnpolarizedSpectrum sigma_a = absorption(si, active);
-        Float transmitted_length = 2 * cos_gamma_t / cos_theta_t;
-        UnpolarizedSpectrum transmittance = dr::exp(-sigma_a * transmitted_length);
-        AttenuationCoeffs a_p = attenuation(cos_theta_i, m_eta, h, transmittance);
-
         Array_pmax_f a_p_pdf = dr::zeros<Array_pmax_f>();
         Array_pmax_f a_p_luminance = dr::zeros<Array_pmax_f>();
         Float sum_luminance(0.0f);
@@ -693,6 +632,181 @@ private:
         return a_p_pdf;
     }
 
+    /// Quantities of the scattering model that only depend on `si.wi`
+    struct IncidentTerms {
+        Vector3f wi;
+        Float gamma_i, gamma_t, phi_i;
+        Float sin_theta_i, cos_theta_i;
+        /// Longitudinal angle and direction accounting for the scales
+        Float sin_theta_p[P_MAX], cos_theta_p[P_MAX];
+        Vector3f wi_p[P_MAX];
+        /// Attenuation of each segment length and its sampling probability
+        AttenuationCoeffs a_p;
+        dr::Array<Float, P_MAX + 1> a_p_pdf;
+    };
+
+    /// Parameterize the incident direction and evaluate the attenuation
+    IncidentTerms incident_terms(const SurfaceInteraction3f &si,
+                                 Mask active) const {
+        IncidentTerms t;
+        t.wi = si.wi;
+        t.gamma_i = gamma(si.wi);
+        Float h = dr::sin(t.gamma_i);
+        std::tie(t.sin_theta_i, t.cos_theta_i) = sincos_theta(si.wi);
+        t.phi_i = azimuthal_angle(si.wi);
+        auto [sin_phi_i, cos_phi_i] = dr::sincos(t.phi_i);
+
+        // Transmission angle in longitudinal plane
+        Float sin_theta_t = t.sin_theta_i / m_eta;
+        Float cos_theta_t = dr::safe_sqrt(1.f - dr::square(sin_theta_t));
+
+        // Transmission angle in azimuthal plane
+        Float eta_p = azimuthal_ior(t.sin_theta_i, t.cos_theta_i);
+        Float sin_gamma_t = h / eta_p;
+        Float cos_gamma_t = dr::safe_sqrt(1.f - dr::square(sin_gamma_t));
+        t.gamma_t = dr::safe_asin(sin_gamma_t);
+
+        // Attenuation coefficients
+        UnpolarizedSpectrum sigma_a = absorption(si, active);
+        Float transmitted_length = 2 * cos_gamma_t / cos_theta_t;
+        UnpolarizedSpectrum transmittance = dr::exp(-sigma_a * transmitted_length);
+        t.a_p = attenuation(t.cos_theta_i, m_eta, h, transmittance);
+        t.a_p_pdf = attenuation_pdf(t.a_p, si);
+
+        // Account for scales on hair surface
+        for (size_t p = 0; p < P_MAX; ++p) {
+            std::tie(t.sin_theta_p[p], t.cos_theta_p[p]) =
+                reframe_with_scales(t.sin_theta_i, t.cos_theta_i, p);
+            t.wi_p[p] = Vector3f(t.cos_theta_p[p] * cos_phi_i, t.sin_theta_p[p],
+                                 t.cos_theta_p[p] * sin_phi_i);
+        }
+
+        return t;
+    }
+
+    /// Evaluate the BSDF and its density for `wo` given the incident terms
+    std::pair<UnpolarizedSpectrum, Float>
+    eval_pdf_shared(const Vector3f &wo, const IncidentTerms &t) const {
+        Float delta_phi = azimuthal_angle(wo) - t.phi_i;
+
+        // Accumulate PDF and contribution for each segment length
+        Float pdf = Float(0.0f);
+        UnpolarizedSpectrum value(0.0f);
+        for (size_t p = 0; p < P_MAX; ++p) {
+            Float M_p = longitudinal(t.wi_p[p], wo, p),
+                  N_p = azimuthal_scattering(delta_phi, p, m_s, t.gamma_i,
+                                             t.gamma_t);
+
+            pdf   += M_p * dr::TwoPi<Float> * t.a_p_pdf[p] * N_p;
+            value += M_p * dr::TwoPi<Float> * t.a_p[p]     * N_p;
+        }
+
+        // Contribution and PDF of remaining terms
+        Float M_p = longitudinal(t.wi, wo, P_MAX);
+        pdf   += M_p * t.a_p_pdf[P_MAX];
+        value += M_p * t.a_p[P_MAX];
+
+        pdf   = dr::select(dr::isnan(pdf)   || dr::isinf(pdf),   0, pdf);
+        value = dr::select(dr::isnan(value) || dr::isinf(value), 0, value);
+
+        return { value, pdf };
+    }
+
+    /// Sample the BSDF given the incident terms
+    std::pair<BSDFSample3f, Spectrum>
+    sample_shared(const SurfaceInteraction3f &si, Float sample1,
+                  const Point2f &sample2, const IncidentTerms &t,
+                  Mask active) const {
+        BSDFSample3f bs = dr::zeros<BSDFSample3f>(dr::width(si));
+
+        // Sample segment length `p`
+        const dr::Array<Float, P_MAX + 1> &a_p_pdf = t.a_p_pdf;
+
+        Point2f u[2] = { { sample1, 0 }, sample2 };
+        // u[0][1] is the rescaled random number after using u[0][0]
+        u[0][1] = u[0][0] / a_p_pdf[0];
+
+        UInt32 p = dr::zeros<UInt32>(dr::width(si));
+        for (size_t i = 0; i < P_MAX; ++i) {
+            Bool sample_p = a_p_pdf[i] < u[0][0];
+            u[0][0] -= a_p_pdf[i];
+
+            dr::masked(p, sample_p) = (uint32_t)i + 1;
+            dr::masked(u[0][1], sample_p) = u[0][0] / a_p_pdf[i + 1];
+        }
+
+        // Account for scales on hair surface
+        Float sin_theta_ip(0.f);
+        Float cos_theta_ip(0.f);
+        for (size_t j = 0; j < P_MAX; j++) {
+            dr::masked(sin_theta_ip, p == j) = t.sin_theta_p[j];
+            dr::masked(cos_theta_ip, p == j) = t.cos_theta_p[j];
+        }
+
+        // Sample longitudinal scattering
+        Float sin_theta_o;
+        if (m_tabulated) {
+            sin_theta_o = sample_longitudinal_tabulated(
+                dr::select(p == P_MAX, t.sin_theta_i, sin_theta_ip),
+                dr::minimum(p, 2u), u[1], active);
+        } else {
+            Float cos_theta =
+                1 + m_v[P_MAX] *
+                    dr::log(u[1][0] + (1.f - u[1][0]) * dr::exp(-2.f / m_v[P_MAX]));
+            for (size_t i = 0; i < P_MAX; i++)
+                dr::masked(cos_theta, p == i) =
+                    1 + m_v[i] * dr::log(u[1][0] + (1.f - u[1][0]) * dr::exp(-2.f / m_v[i]));
+            Float sin_theta = dr::safe_sqrt(1.f - dr::square(cos_theta));
+            Float cos_phi = dr::cos(2 * dr::Pi<ScalarFloat> * u[1][1]);
+            sin_theta_o =
+                -cos_theta * sin_theta_ip + sin_theta * cos_phi * cos_theta_ip;
+        }
+        Float cos_theta_o = dr::safe_sqrt(1.f - dr::square(sin_theta_o));
+
+        // Sample azimuthal scattering
+        Float perfect_delta_phi =
+            2 * p * t.gamma_t - 2 * t.gamma_i + p * dr::Pi<ScalarFloat>;
+        Float delta_phi_first_terms =
+            perfect_delta_phi + (m_tabulated
+                                     ? m_azimuthal_distr.sample(u[0][1], active)
+                                     : trimmed_logistic_sample(u[0][1], m_s));
+        Float delta_phi_remainder = 2 * dr::Pi<ScalarFloat> * u[0][1];
+        Float delta_phi =
+            dr::select(p < P_MAX, delta_phi_first_terms, delta_phi_remainder);
+
+        // Outgoing direction
+        Float phi_o = t.phi_i + delta_phi;
+        auto [sin_phi_o, cos_phi_o] = dr::sincos(phi_o);
+        Vector3f wo(cos_theta_o * cos_phi_o, sin_theta_o,
+                    cos_theta_o * sin_phi_o);
+
+        bs.wo = dr::normalize(wo);
+        bs.eta = 1.f; // We always completely cross the hair fiber
+        bs.sampled_type = +BSDFFlags::Glossy;
+        bs.sampled_component = 0;
+
+        // Contribution and PDF for sampled outgoing direction
+        auto [value, pdf] = eval_pdf_shared(bs.wo, t);
+        bs.pdf = pdf;
+
+        Spectrum weight = dr::select(
+            bs.pdf != 0, depolarizer<Spectrum>(value) / bs.pdf, 0);
+
+        return { bs, weight & (active && bs.pdf > 0.f) };
+    }
+
+    /**
+     * \brief Longitudinal scattering of the segment length `p`, where `wi`
+     * accounts for the scales on the hair surface
+     */
+    Float longitudinal(const Vector3f &wi, const Vector3f &wo, size_t p) const {
+        if (m_tabulated)
+            return longitudinal_tabulated(
+                       wi.y(), wo.y(), UInt32((uint32_t) dr::minimum(p, size_t(2)))) *
+                   dr::InvTwoPi<Float>;
+        return longitudinal_scattering(wi, wo, { 0, 1.f, 0 }, m_v[p]);
+    }
+
     /// Longitudinal scattering distribution
     Float longitudinal_scattering(const Vector3f &wi, const Vector3f &wo,
                                   const Vector3f &tangent,
@@ -732,6 +846,9 @@ private:
         dr::masked(phi, phi < dr::Pi<Float>) = phi + 2 * dr::Pi<Float>;
         dr::masked(phi, phi > dr::Pi<Float>) = phi - 2 * dr::Pi<Float>;
 
+        if (m_tabulated)
+            return m_azimuthal_distr.eval_pdf_normalized(phi, true);
+
         // Model roughness with trimmed logistic distribution
         return (
             logistic(phi, s) /
@@ -785,6 +902,12 @@ private:
     Float m_v[P_MAX + 1]; /// Longitudinal variance due to roughness
     Float m_s; /// Azimuthal roughness scaling factor
     Float m_sin_2k_alpha[3], m_cos_2k_alpha[3];
+
+    /// Tabulated scattering terms (see \ref build_tables())
+    bool m_tabulated;
+    uint32_t m_resolution;
+    DynamicBuffer<Float> m_longitudinal_pdf, m_longitudinal_cdf;
+    ContinuousDistribution<Float> m_azimuthal_distr;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(Hair, BSDF)
@@ -6,6 +6,9 @@
 #include <mitsuba/render/bsdf.h>
 #include <array>
 #include <cmath>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 /// Set to 1 to fall back to cosine-weighted sampling (for debugging)
 #define MI_SAMPLE_DIFFUSE     0
@@ -67,6 +70,11 @@ describes how to import one of the spectral measurements from the database.
         'type': 'measured',
         'filename': 'cc_nothern_aurora_spec.bsdf'
 
+Instances that load the same file share their interpolation and sampling
+tables, hence a material can be assigned to many objects (e.g. with different
+:ref:`twosided <bsdf-twosided>` or :ref:`normalmap <bsdf-normalmap>` wrappers)
+without loading it more than once.
+
 */
 template <typename Float, typename Spectrum>
 class Measured final : public BSDF<Float, Spectrum> {
@@ -80,152 +88,16 @@ public:
 
     Measured(const Properties &props) : Base(props) {
         m_components.push_back(BSDFFlags::GlossyReflection | BSDFFlags::FrontSide);
-        m_flags = m_components[0];
+        m_flags = m_components[0] | BSDFFlags::Depolarizing;
 
         auto fs            = Thread::thread()->file_resolver();
         fs::path file_path = fs->resolve(props.string("filename"));
         m_name             = file_path.filename().string();
 
-        ref<TensorFile> tf = new TensorFile(file_path);
-        using Field = TensorFile::Field;
-
-        const Field &theta_i       = tf->field("theta_i");
-        const Field &phi_i         = tf->field("phi_i");
-        const Field &ndf           = tf->field("ndf");
-        const Field &sigma         = tf->field("sigma");
-        const Field &vndf          = tf->field("vndf");
-        const Field &luminance     = tf->field("luminance");
-        const Field &description   = tf->field("description");
-        const Field &jacobian      = tf->field("jacobian");
-
-        Field spectra, wavelengths;
-        bool is_spectral = tf->has_field("wavelengths");
-
-        const ScalarFloat rgb_wavelengths[3] = { 0, 1, 2 };
-        if (is_spectral) {
-            spectra = tf->field("spectra");
-            wavelengths = tf->field("wavelengths");
-            if constexpr (!is_spectral_v<Spectrum>)
-                Throw("Measurements in spectral format require the use of a spectral variant of Mitsuba!");
-        } else {
-            spectra = tf->field("rgb");
-            if constexpr (!is_rgb_v<Spectrum>)
-                Throw("Measurements in RGB format require the use of a RGB variant of Mitsuba!");
-
-            wavelengths.shape.push_back(3);
-            wavelengths.data = rgb_wavelengths;
-        }
-
-        if (!(description.shape.size() == 1 &&
-              description.dtype == Struct::Type::UInt8 &&
-
-              theta_i.shape.size() == 1 &&
-              theta_i.dtype == Struct::Type::Float32 &&
-
-              phi_i.shape.size() == 1 &&
-              phi_i.dtype == Struct::Type::Float32 &&
-
-              (!is_spectral || (
-                  wavelengths.shape.size() == 1 &&
-                  wavelengths.dtype == Struct::Type::Float32
-              )) &&
-
-              ndf.shape.size() == 2 &&
-              ndf.dtype == Struct::Type::Float32 &&
-
-              sigma.shape.size() == 2 &&
-              sigma.dtype == Struct::Type::Float32 &&
-
-              vndf.shape.size() == 4 &&
-              vndf.dtype == Struct::Type::Float32 &&
-              vndf.shape[0] == phi_i.shape[0] &&
-              vndf.shape[1] == theta_i.shape[0] &&
-
-              luminance.shape.size() == 4 &&
-              luminance.dtype == Struct::Type::Float32 &&
-              luminance.shape[0] == phi_i.shape[0] &&
-              luminance.shape[1] == theta_i.shape[0] &&
-              luminance.shape[2] == luminance.shape[3] &&
-
-              spectra.dtype == Struct::Type::Float32 &&
-              spectra.shape.size() == 5 &&
-              spectra.shape[0] == phi_i.shape[0] &&
-              spectra.shape[1] == theta_i.shape[0] &&
-              spectra.shape[2] == (is_spectral ? wavelengths.shape[0] : 3) &&
-              spectra.shape[3] == spectra.shape[4] &&
-
-              luminance.shape[2] == spectra.shape[3] &&
-              luminance.shape[3] == spectra.shape[4] &&
-
-              jacobian.shape.size() == 1 &&
-              jacobian.shape[0] == 1 &&
-              jacobian.dtype == Struct::Type::UInt8))
-              Throw("Invalid file structure: %s", tf);
-
-        m_isotropic = phi_i.shape[0] <= 2;
-        m_jacobian  = ((uint8_t *) jacobian.data)[0];
-
-        if (!m_isotropic) {
-            ScalarFloat *phi_i_data = (ScalarFloat *) phi_i.data;
-            m_reduction = (int) std::rint((2 * dr::Pi<ScalarFloat>) /
-                (phi_i_data[phi_i.shape[0] - 1] - phi_i_data[0]));
-        }
-
-        // Construct NDF interpolant data structure
-        m_ndf = Warp2D0(
-            (ScalarFloat *) ndf.data,
-            ScalarVector2u(ndf.shape[1], ndf.shape[0]),
-            { }, { }, false, false
-        );
-
-        // Construct projected surface area interpolant data structure
-        m_sigma = Warp2D0(
-            (ScalarFloat *) sigma.data,
-            ScalarVector2u(sigma.shape[1], sigma.shape[0]),
-            { }, { }, false, false
-        );
-
-        // Construct VNDF warp data structure
-        m_vndf = Warp2D2(
-            (ScalarFloat *) vndf.data,
-            ScalarVector2u(vndf.shape[3], vndf.shape[2]),
-            {{ (uint32_t) phi_i.shape[0],
-               (uint32_t) theta_i.shape[0] }},
-            {{ (const ScalarFloat *) phi_i.data,
-               (const ScalarFloat *) theta_i.data }}
-        );
-
-        // Construct Luminance warp data structure
-        m_luminance = Warp2D2(
-            (ScalarFloat *) luminance.data,
-            ScalarVector2u(luminance.shape[3], luminance.shape[2]),
-            {{ (uint32_t) phi_i.shape[0],
-               (uint32_t) theta_i.shape[0] }},
-            {{ (const ScalarFloat *) phi_i.data,
-               (const ScalarFloat *) theta_i.data }}
-        );
-
-        // Construct spectral interpolant
-        m_spectra = Warp2D3(
-            (ScalarFloat *) spectra.data,
-            ScalarVector2u(spectra.shape[4], spectra.shape[3]),
-            {{ (uint32_t) phi_i.shape[0],
-               (uint32_t) theta_i.shape[0],
-               (uint32_t) wavelengths.shape[0] }},
-            {{ (const ScalarFloat *) phi_i.data,
-               (const ScalarFloat *) theta_i.data,
-               (const ScalarFloat *) wavelengths.data }},
-            false, false
-        );
-
-        std::string description_str(
-            (const char *) description.data,
-            (const char *) description.data + description.shape[0]
-        );
-
-        Log(Info, "Loaded material \"%s\" (resolution %i x %i x %i x %i x %i)",
-            description_str, spectra.shape[0], spectra.shape[1],
-            spectra.shape[3], spectra.shape[4], spectra.shape[2]);
+        m_tables = load_tables(file_path);
+        m_isotropic = m_tables->isotropic;
+        m_jacobian  = m_tables->jacobian;
+        m_reduction = m_tables->reduction;
     }
 
     /**
@@ -275,10 +147,10 @@ public:
         Float pdf = 1.f;
 
         #if MI_SAMPLE_LUMINANCE == 1
-        std::tie(sample, pdf) = m_luminance.sample(sample, params, active);
+        std::tie(sample, pdf) = m_tables->luminance.sample(sample, params, active);
         #endif
 
-        auto [u_m, ndf_pdf] = m_vndf.sample(sample, params, active);
+        auto [u_m, ndf_pdf] = m_tables->vndf.sample(sample, params, active);
 
         Float phi_m   = u2phi(u_m.y()),
               theta_m = u2theta(u_m.x());
@@ -316,7 +188,7 @@ public:
 
         u_m[1] = u_m[1] - dr::floor(u_m[1]);
 
-    std::tie(sample, std::ignore) = m_vndf.invert(u_m, params, active);
+    std::tie(sample, std::ignore) = m_tables->vndf.invert(u_m, params, active);
 #endif // MI_SAMPLE_DIFFUSE
 
         bs.eta               = 1.f;
@@ -327,12 +199,12 @@ public:
         for (size_t i = 0; i < dr::size_v<UnpolarizedSpectrum>; ++i) {
             Float params_spec[3] = { phi_i, theta_i,
                 is_spectral_v<Spectrum> ? si.wavelengths[i] : Float((float) i) };
-            spec[i] = m_spectra.eval(sample, params_spec, active);
+            spec[i] = m_tables->spectra.eval(sample, params_spec, active);
         }
 
         if (m_jacobian)
-            spec *= m_ndf.eval(u_m, params, active) /
-                    (4 * m_sigma.eval(u_wi, params, active));
+            spec *= m_tables->ndf.eval(u_m, params, active) /
+                    (4 * m_tables->sigma.eval(u_wi, params, active));
 
         bs.wo.x() = dr::mulsign_neg(bs.wo.x(), sx);
         bs.wo.y() = dr::mulsign_neg(bs.wo.y(), sy);
@@ -380,18 +252,18 @@ public:
         u_m[1] = u_m[1] - dr::floor(u_m[1]);
 
         Float params[2] = { phi_i, theta_i };
-        auto [sample, unused] = m_vndf.invert(u_m, params, active);
+        auto [sample, unused] = m_tables->vndf.invert(u_m, params, active);
 
         UnpolarizedSpectrum spec;
         for (size_t i = 0; i < dr::size_v<UnpolarizedSpectrum>; ++i) {
             Float params_spec[3] = { phi_i, theta_i,
                 is_spectral_v<Spectrum> ? si.wavelengths[i] : Float((float) i) };
-            spec[i] = m_spectra.eval(sample, params_spec, active);
+            spec[i] = m_tables->spectra.eval(sample, params_spec, active);
         }
 
         if (m_jacobian)
-            spec *= m_ndf.eval(u_m, params, active) /
-                    (4 * m_sigma.eval(u_wi, params, active));
+            spec *= m_tables->ndf.eval(u_m, params, active) /
+                    (4 * m_tables->sigma.eval(u_wi, params, active));
 
         return depolarizer<Spectrum>(spec) & active;
     }
@@ -437,11 +309,11 @@ public:
         u_m[1] = u_m[1] - dr::floor(u_m[1]);
 
         Float params[2] = { phi_i, theta_i };
-        auto [sample, vndf_pdf] = m_vndf.invert(u_m, params, active);
+        auto [sample, vndf_pdf] = m_tables->vndf.invert(u_m, params, active);
 
         Float pdf = 1.f;
         #if MI_SAMPLE_LUMINANCE == 1
-        pdf = m_luminance.eval(sample, params, active);
+        pdf = m_tables->luminance.eval(sample, params, active);
         #endif
 
         Float jacobian =
@@ -454,21 +326,200 @@ public:
 #endif // MI_SAMPLE_DIFFUSE
     }
 
+    uint32_t ray_flags() const override {
+        uint32_t flags = Base::ray_flags();
+        // Anisotropic measurements are oriented along the position partials
+        if (!m_isotropic)
+            flags |= RayFlags::UV | RayFlags::dPdUV;
+        return flags;
+    }
+
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "Measured[" << std::endl
             << "  filename = \"" << m_name << "\"," << std::endl
-            << "  ndf = " << string::indent(m_ndf.to_string()) << "," << std::endl
-            << "  sigma = " << string::indent(m_sigma.to_string()) << "," << std::endl
-            << "  vndf = " << string::indent(m_vndf.to_string()) << "," << std::endl
-            << "  luminance = " << string::indent(m_luminance.to_string()) << "," << std::endl
-            << "  spectra = " << string::indent(m_spectra.to_string()) << std::endl
+            << "  ndf = " << string::indent(m_tables->ndf.to_string()) << "," << std::endl
+            << "  sigma = " << string::indent(m_tables->sigma.to_string()) << "," << std::endl
+            << "  vndf = " << string::indent(m_tables->vndf.to_string()) << "," << std::endl
+            << "  luminance = " << string::indent(m_tables->luminance.to_string()) << "," << std::endl
+            << "  spectra = " << string::indent(m_tables->spectra.to_string()) << std::endl
             << "]";
         return oss.str();
     }
 
     MI_DECLARE_CLASS()
 private:
+    /// Tables of a material file, which are shared by all instances loading it
+    struct Tables {
+        Warp2D0 ndf;
+        Warp2D0 sigma;
+        Warp2D2 vndf;
+        Warp2D2 luminance;
+        Warp2D3 spectra;
+        bool isotropic;
+        bool jacobian;
+        int reduction = 0;
+    };
+
+    /// Load the tables of a material file, or return those already in use
+    static std::shared_ptr<const Tables> load_tables(const fs::path &file_path) {
+        static std::mutex mutex;
+        static std::unordered_map<std::string, std::weak_ptr<const Tables>> cache;
+
+        std::lock_guard<std::mutex> guard(mutex);
+        std::weak_ptr<const Tables> &entry = cache[file_path.string()];
+        if (std::shared_ptr<const Tables> shared = entry.lock()) {
+            Log(Debug, "Reusing the tables of material file \"%s\"",
+                file_path.string());
+            return shared;
+        }
+
+        std::shared_ptr<Tables> tables = std::make_shared<Tables>();
+        ref<TensorFile> tf = new TensorFile(file_path);
+        using Field = TensorFile::Field;
+
+        const Field &theta_i       = tf->field("theta_i");
+        const Field &phi_i         = tf->field("phi_i");
+        const Field &ndf           = tf->field("ndf");
+        const Field &sigma         = tf->field("sigma");
+        const Field &vndf          = tf->field("vndf");
+        const Field &luminance     = tf->field("luminance");
+        const Field &description   = tf->field("description");
+        const Field &jacobian      = tf->field("jacobian");
+
+        Field spectra, wavelengths;
+        bool is_spectral = tf->has_field("wavelengths");
+
+        const ScalarFloat rgb_wavelengths[3] = { 0, 1, 2 };
+        if (is_spectral) {
+            spectra = tf->field("spectra");
+            wavelengths = tf->field("wavelengths");
+            if constexpr (!is_spectral_v<Spectrum>)
+                Throw("Measurements in spectral format require the use of a spectral variant of Mitsuba!");
+        } else {
+            spectra = tf->field("rgb");
+            if constexpr (!is_rgb_v<Spectrum>)
+                Throw("Measurements in RGB format require the use of a RGB variant of Mitsuba!");
+
+            wavelengths.shape.push_back(3);
+            wavelengths.data = rgb_wavelengths;
+        }
+
+        if (!(description.shape.size() == 1 &&
+              description.dtype == Struct::Type::UInt8 &&
+
+              theta_i.shape.size() == 1 &&
+              theta_i.dtype == Struct::Type::Float32 &&
+
+              phi_i.shape.size() == 1 &&
+              phi_i.dtype == Struct::Type::Float32 &&
+
+              (!is_spectral || (
+                  wavelengths.shape.size() == 1 &&
+                  wavelengths.dtype == Struct::Type::Float32
+              )) &&
+
+              ndf.shape.size() == 2 &&
+              ndf.dtype == Struct::Type::Float32 &&
+
+              sigma.shape.size() == 2 &&
+              sigma.dtype == Struct::Type::Float32 &&
+
+              vndf.shape.size() == 4 &&
+              vndf.dtype == Struct::Type::Float32 &&
+              vndf.shape[0] == phi_i.shape[0] &&
+              vndf.shape[1] == theta_i.shape[0] &&
+
+              luminance.shape.size() == 4 &&
+              luminance.dtype == Struct::Type::Float32 &&
+              luminance.shape[0] == phi_i.shape[0] &&
+              luminance.shape[1] == theta_i.shape[0] &&
+              luminance.shape[2] == luminance.shape[3] &&
+
+              spectra.dtype == Struct::Type::Float32 &&
+              spectra.shape.size() == 5 &&
+              spectra.shape[0] == phi_i.shape[0] &&
+              spectra.shape[1] == theta_i.shape[0] &&
+              spectra.shape[2] == (is_spectral ? wavelengths.shape[0] : 3) &&
+              spectra.shape[3] == spectra.shape[4] &&
+
+              luminance.shape[2] == spectra.shape[3] &&
+              luminance.shape[3] == spectra.shape[4] &&
+
+              jacobian.shape.size() == 1 &&
+              jacobian.shape[0] == 1 &&
+              jacobian.dtype == Struct::Type::UInt8))
+              Throw("Invalid file structure: %s", tf);
+
+        tables->isotropic = phi_i.shape[0] <= 2;
+        tables->jacobian  = ((uint8_t *) jacobian.data)[0];
+
+        if (!tables->isotropic) {
+            ScalarFloat *phi_i_data = (ScalarFloat *) phi_i.data;
+            tables->reduction = (int) std::rint((2 * dr::Pi<ScalarFloat>) /
+                (phi_i_data[phi_i.shape[0] - 1] - phi_i_data[0]));
+        }
+
+        // Construct NDF interpolant data structure
+        tables->ndf = Warp2D0(
+            (ScalarFloat *) ndf.data,
+            ScalarVector2u(ndf.shape[1], ndf.shape[0]),
+            { }, { }, false, false
+        );
+
+        // Construct projected surface area interpolant data structure
+        tables->sigma = Warp2D0(
+            (ScalarFloat *) sigma.data,
+            ScalarVector2u(sigma.shape[1], sigma.shape[0]),
+            { }, { }, false, false
+        );
+
+        // Construct VNDF warp data structure
+        tables->vndf = Warp2D2(
+            (ScalarFloat *) vndf.data,
+            ScalarVector2u(vndf.shape[3], vndf.shape[2]),
+            {{ (uint32_t) phi_i.shape[0],
+               (uint32_t) theta_i.shape[0] }},
+            {{ (const ScalarFloat *) phi_i.data,
+               (const ScalarFloat *) theta_i.data }}
+        );
+
+        // Construct Luminance warp data structure
+        tables->luminance = Warp2D2(
+            (ScalarFloat *) luminance.data,
+            ScalarVector2u(luminance.shape[3], luminance.shape[2]),
+            {{ (uint32_t) phi_i.shape[0],
+               (uint32_t) theta_i.shape[0] }},
+            {{ (const ScalarFloat *) phi_i.data,
+               (const ScalarFloat *) theta_i.data }}
+        );
+
+        // Construct spectral interpolant
+        tables->spectra = Warp2D3(
+            (ScalarFloat *) spectra.data,
+            ScalarVector2u(spectra.shape[4], spectra.shape[3]),
+            {{ (uint32_t) phi_i.shape[0],
+               (uint32_t) theta_i.shape[0],
+               (uint32_t) wavelengths.shape[0] }},
+            {{ (const ScalarFloat *) phi_i.data,
+               (const ScalarFloat *) theta_i.data,
+               (const ScalarFloat *) wavelengths.data }},
+            false, false
+        );
+
+        std::string description_str(
+            (const char *) description.data,
+            (const char *) description.data + description.shape[0]
+        );
+
+        Log(Info, "Loaded material \"%s\" (resolution %i x %i x %i x %i x %i)",
+            description_str, spectra.shape[0], spectra.shape[1],
+            spectra.shape[3], spectra.shape[4], spectra.shape[2]);
+
+        entry = tables;
+        return tables;
+    }
+
     template <typename Value> Value u2theta(Value u) const {
         return dr::square(u) * (dr::Pi<Float> / 2.f);
     }
@@ -487,11 +538,7 @@ private:
 
 private:
     std::string m_name;
-    Warp2D0 m_ndf;
-    Warp2D0 m_sigma;
-    Warp2D2 m_vndf;
-    Warp2D2 m_luminance;
-    Warp2D3 m_spectra;
+    std::shared_ptr<const Tables> m_tables;
     bool m_isotropic;
     bool m_jacobian;
     int m_reduction;
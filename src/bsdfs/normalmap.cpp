@@ -111,6 +111,11 @@ public:
         callback->put_object("normalmap",   m_normalmap.get(),   ParamFlags::Differentiable | ParamFlags::Discontinuous);
     }
 
+    // Tangent-space normals are expressed relative to the position partials
+    uint32_t ray_flags() const override {
+        return RayFlags::UV | RayFlags::dPdUV | RayFlags::ShadingFrame;
+    }
+
     std::pair<BSDFSample3f, Spectrum> sample(const BSDFContext &ctx,
                                              const SurfaceInteraction3f &si,
                                              Float sample1,
@@ -176,7 +176,7 @@ public:
 
         m_components.push_back(BSDFFlags::DeltaReflection | BSDFFlags::FrontSide);
         m_components.push_back(BSDFFlags::DiffuseReflection | BSDFFlags::FrontSide);
-        m_flags = m_components[0] | m_components[1];
+        m_flags = m_components[0] | m_components[1] | BSDFFlags::Depolarizing;
 
         parameters_changed();
     }
@@ -359,6 +359,97 @@ public:
                  dr::select(active, hemi_pdf * prob_diffuse, 0.f) };
     }
 
+    std::tuple<Spectrum, Float, BSDFSample3f, Spectrum>
+    eval_pdf_sample(const BSDFContext &ctx,
+                    const SurfaceInteraction3f &si,
+                    const Vector3f &wo,
+                    Float sample1,
+                    const Point2f &sample2,
+                    Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::BSDFSample, active);
+
+        bool has_specular = ctx.is_enabled(BSDFFlags::DeltaReflection, 0),
+             has_diffuse  = ctx.is_enabled(BSDFFlags::DiffuseReflection, 1);
+
+        Float cos_theta_i = Frame3f::cos_theta(si.wi),
+              cos_theta_o = Frame3f::cos_theta(wo);
+
+        active &= cos_theta_i > 0.f;
+        Mask active_e = active && cos_theta_o > 0.f;
+
+        BSDFSample3f bs = dr::zeros<BSDFSample3f>();
+        if (unlikely((!has_specular && !has_diffuse) || dr::none_or<false>(active)))
+            return { 0.f, 0.f, bs, 0.f };
+
+        // The Fresnel term and the diffuse albedo are shared by both parts
+        Float f_i = std::get<0>(fresnel(cos_theta_i, Float(m_eta)));
+
+        UnpolarizedSpectrum diff(0.f);
+        if (has_diffuse) {
+            diff = m_diffuse_reflectance->eval(si, active);
+            diff /= 1.f - (m_nonlinear ? (diff * m_fdr_int) : m_fdr_int);
+            diff *= m_inv_eta_2 * (1.f - f_i);
+        }
+
+        Float prob_specular = f_i * m_specular_sampling_weight,
+              prob_diffuse  = (1.f - f_i) * (1.f - m_specular_sampling_weight);
+
+        if (unlikely(has_specular != has_diffuse))
+            prob_specular = has_specular ? 1.f : 0.f;
+        else
+            prob_specular = prob_specular / (prob_specular + prob_diffuse);
+
+        prob_diffuse = 1.f - prob_specular;
+
+        // ------------------------ Evaluation ------------------------
+
+        Spectrum value(0.f);
+        Float pdf(0.f);
+
+        if (has_diffuse) {
+            Float f_o      = std::get<0>(fresnel(cos_theta_o, Float(m_eta))),
+                  hemi_pdf = warp::square_to_cosine_hemisphere_pdf(wo);
+
+            value = dr::select(active_e,
+                               depolarizer<Spectrum>(diff * hemi_pdf * (1.f - f_o)),
+                               0.f);
+            pdf = dr::select(active_e, hemi_pdf * prob_diffuse, 0.f);
+        }
+
+        // ------------------------- Sampling -------------------------
+
+        Mask sample_specular = active && (sample1 < prob_specular),
+             sample_diffuse  = active && !sample_specular;
+
+        UnpolarizedSpectrum weight(0.f);
+        bs.eta = 1.f;
+        bs.pdf = 0.f;
+
+        if (dr::any_or<true>(sample_specular)) {
+            dr::masked(bs.wo, sample_specular) = reflect(si.wi);
+            dr::masked(bs.pdf, sample_specular) = prob_specular;
+            dr::masked(bs.sampled_component, sample_specular) = 0;
+            dr::masked(bs.sampled_type, sample_specular) = +BSDFFlags::DeltaReflection;
+
+            UnpolarizedSpectrum spec = f_i / bs.pdf;
+            if (m_specular_reflectance)
+                spec *= m_specular_reflectance->eval(si, sample_specular);
+            weight[sample_specular] = spec;
+        }
+
+        if (dr::any_or<true>(sample_diffuse)) {
+            dr::masked(bs.wo, sample_diffuse) = warp::square_to_cosine_hemisphere(sample2);
+            dr::masked(bs.pdf, sample_diffuse) = prob_diffuse * warp::square_to_cosine_hemisphere_pdf(bs.wo);
+            dr::masked(bs.sampled_component, sample_diffuse) = 1;
+            dr::masked(bs.sampled_type, sample_diffuse) = +BSDFFlags::DiffuseReflection;
+
+            Float f_o = std::get<0>(fresnel(Frame3f::cos_theta(bs.wo), Float(m_eta)));
+            weight[sample_diffuse] = diff * (1.f - f_o) / prob_diffuse;
+        }
+
+        return { value, pdf, bs, depolarizer<Spectrum>(weight) };
+    }
+
     Spectrum eval_diffuse_reflectance(const SurfaceInteraction3f &si,
                                       Mask active) const override {
         return m_diffuse_reflectance->eval(si, active);
@@ -118,6 +118,13 @@ Subsurface Scattering* :cite:`Disney2015` by Brent Burley.
 
     Subsurface scattering and volumetric extinction is not supported!
 
+The lobes are specialized when the BSDF is created: features whose parameter
+is not specified (or set to zero) are excluded from the sampling and evaluation
+code, and the diffuse, retro-reflection, fake subsurface and sheen lobes are
+excluded when :monosp:`metallic` or :monosp:`spec_trans` is set to one. In JIT
+variants, the code traced for such materials is thus simpler. Updating a
+parameter of an excluded lobe (e.g. during an optimization) enables it again.
+
 Images below show how the input parameters affect the appearance of the objects
 while one of the parameters is changed for each column.
 
@@ -206,6 +213,9 @@ public:
         m_metallic = props.texture<Texture>("metallic", 0.0f);
         m_has_clearcoat = get_flag("clearcoat", props);
         m_clearcoat = props.texture<Texture>("clearcoat", 0.0f);
+        // Pure metals and pure dielectrics have no diffuse lobe
+        m_has_diffuse = !has_constant_value("metallic", props, 1.0f) &&
+                        !has_constant_value("spec_trans", props, 1.0f);
         m_clearcoat_gloss = props.texture<Texture>("clearcoat_gloss", 0.0f);
         m_spec_srate = props.get("main_specular_sampling_rate", 1.0f);
         m_clearcoat_srate = props.get("clearcoat_sampling_rate", 1.0f);
@@ -237,9 +247,14 @@ public:
     }
 
     void initialize_lobes() {
+        m_components.clear();
+        m_flags = +BSDFFlags::Empty;
+
         // Diffuse reflection lobe
-        m_components.push_back(BSDFFlags::DiffuseReflection |
-                               BSDFFlags::FrontSide);
+        if (m_has_diffuse) {
+            m_components.push_back(BSDFFlags::DiffuseReflection |
+                                   BSDFFlags::FrontSide);
+        }
 
         // Clearcoat lobe
         if (m_has_clearcoat) {
@@ -265,6 +280,7 @@ public:
 
         for (auto c : m_components)
             m_flags |= c;
+        m_flags = m_flags | BSDFFlags::Depolarizing;
     }
 
     void traverse(TraversalCallback *callback) override {
@@ -309,6 +325,9 @@ public:
             m_has_spec_tint = true;
         if (string::contains(keys, "flatness"))
             m_has_flatness = true;
+        if (string::contains(keys, "metallic") ||
+            string::contains(keys, "spec_trans"))
+            m_has_diffuse = true;
 
         if (!m_eta_specular && string::contains(keys, "specular")) {
             /* Specular=0 is corresponding to eta=1 which is not plausible
@@ -334,32 +353,165 @@ public:
            Float sample1, const Point2f &sample2, Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::BSDFSample, active);
 
-        Float cos_theta_i = Frame3f::cos_theta(si.wi);
-        BSDFSample3f bs   = dr::zeros<BSDFSample3f>();
+        BSDFSample3f bs = dr::zeros<BSDFSample3f>();
 
         // Ignoring perfectly grazing incoming rays
-        active &= cos_theta_i != 0.0f;
+        active &= Frame3f::cos_theta(si.wi) != 0.0f;
 
         if (unlikely(dr::none_or<false>(active)))
             return { bs, 0.0f };
 
+        return sample_shared(ctx, si, sample1, sample2, eval_params(si, active),
+                             active);
+    }
+
+    Spectrum eval(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                  const Vector3f &wo, Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::BSDFEvaluate, active);
+
+        // Ignore perfectly grazing configurations
+        active &= Frame3f::cos_theta(si.wi) != 0.0f;
+
+        if (unlikely(dr::none_or<false>(active)))
+            return 0.0f;
+
+        return eval_shared(ctx, si, wo, eval_params(si, active), active);
+    }
+
+    Float pdf(const BSDFContext &, const SurfaceInteraction3f &si,
+              const Vector3f &wo, Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::BSDFEvaluate, active);
+
+        // Ignore perfectly grazing configurations.
+        active &= Frame3f::cos_theta(si.wi) != 0.0f;
+
+        if (unlikely(dr::none_or<false>(active)))
+            return 0.0f;
+
+        return pdf_shared(si, wo, eval_params(si, active));
+    }
+
+    std::pair<Spectrum, Float> eval_pdf(const BSDFContext &ctx,
+                                        const SurfaceInteraction3f &si,
+                                        const Vector3f &wo,
+                                        Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::BSDFEvaluate, active);
+
+        // Ignore perfectly grazing configurations
+        active &= Frame3f::cos_theta(si.wi) != 0.0f;
+
+        if (unlikely(dr::none_or<false>(active)))
+            return { 0.0f, 0.0f };
+
+        ShadingParams p = eval_params(si, active);
+        return { eval_shared(ctx, si, wo, p, active),
+                 pdf_shared(si, wo, p) };
+    }
+
+    std::tuple<Spectrum, Float, BSDFSample3f, Spectrum>
+    eval_pdf_sample(const BSDFContext &ctx,
+                    const SurfaceInteraction3f &si,
+                    const Vector3f &wo,
+                    Float sample1,
+                    const Point2f &sample2,
+                    Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::BSDFSample, active);
+
+        // Ignore perfectly grazing configurations
+        active &= Frame3f::cos_theta(si.wi) != 0.0f;
+
+        if (unlikely(dr::none_or<false>(active)))
+            return { 0.0f, 0.0f, dr::zeros<BSDFSample3f>(), 0.0f };
+
+        // The texture lookups are shared by all evaluations below
+        ShadingParams p = eval_params(si, active);
+        auto [bs, weight] = sample_shared(ctx, si, sample1, sample2, p, active);
+
+        return { eval_shared(ctx, si, wo, p, active),
+                 pdf_shared(si, wo, p), bs, weight };
+    }
+
+    Spectrum eval_diffuse_reflectance(const SurfaceInteraction3f &si,
+                                      Mask active) const override {
+        return m_base_color->eval(si, active);
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "Principled BSDF :" << std::endl
+            << "base_color: " << m_base_color << "," << std::endl
+            << "spec_trans: " << m_spec_trans << "," << std::endl
+            << "anisotropic: " << m_anisotropic << "," << std::endl
+            << "roughness: " << m_roughness << "," << std::endl
+            << "sheen: " << m_sheen << "," << std::endl
+            << "sheen_tint: " << m_sheen_tint << "," << std::endl
+            << "flatness: " << m_flatness << "," << std::endl;
+        if (m_eta_specular)
+            oss << "eta: " << m_eta << "," << std::endl;
+        else
+            oss << "specular: " << m_specular << "," << std::endl;
+        oss << "clearcoat: " << m_clearcoat << "," << std::endl
+            << "clearcoat_gloss: " << m_clearcoat_gloss << "," << std::endl
+            << "metallic: " << m_metallic << "," << std::endl
+            << "spec_tint: " << m_spec_tint << "," << std::endl;
+
+        return oss.str();
+    }
+    MI_DECLARE_CLASS()
+private:
+    /// Texture lookups and lobe weights at a surface position
+    struct ShadingParams {
+        Float roughness, flatness, metallic, clearcoat, sheen;
+        Float spec_tint, sheen_tint, clearcoat_gloss;
+        UnpolarizedSpectrum base_color;
+
+        /// Weights of BRDF and BSDF major lobes
+        Float brdf, bsdf;
+
+        /// Parameters of the main specular distribution
+        Float ax, ay;
+    };
+
+    /// Evaluate the parameter textures at \c si
+    ShadingParams eval_params(const SurfaceInteraction3f &si, Mask active) const {
+        ShadingParams p;
+
         // Store the weights.
         Float anisotropic = m_has_anisotropic ? m_anisotropic->eval_1(si, active) : 0.0f,
-        roughness = m_roughness->eval_1(si, active),
-        spec_trans = m_has_spec_trans ? m_spec_trans->eval_1(si, active) : 0.0f,
-        metallic = m_has_metallic ? m_metallic->eval_1(si, active) : 0.0f,
-        clearcoat = m_has_clearcoat ? m_clearcoat->eval_1(si, active) : 0.0f;
+              spec_trans = m_has_spec_trans ? m_spec_trans->eval_1(si, active) : 0.0f;
+        p.roughness = m_roughness->eval_1(si, active);
+        p.flatness = m_has_flatness ? m_flatness->eval_1(si, active) : 0.0f;
+        p.metallic = m_has_metallic ? m_metallic->eval_1(si, active) : 0.0f;
+        p.clearcoat = m_has_clearcoat ? m_clearcoat->eval_1(si, active) : 0.0f;
+        p.sheen = m_has_diffuse && m_has_sheen ? m_sheen->eval_1(si, active) : 0.0f;
+        p.spec_tint = m_has_spec_tint ? m_spec_tint->eval_1(si, active) : 0.0f;
+        p.sheen_tint = m_has_diffuse && m_has_sheen && m_has_sheen_tint
+                           ? m_sheen_tint->eval_1(si, active) : 0.0f;
+        p.clearcoat_gloss = m_has_clearcoat ? m_clearcoat_gloss->eval_1(si, active) : 0.0f;
+        p.base_color = m_base_color->eval(si, active);
+
+        p.brdf = (1.0f - p.metallic) * (1.0f - spec_trans);
+        p.bsdf = (1.0f - p.metallic) * spec_trans;
+
+        std::tie(p.ax, p.ay) =
+            calc_dist_params(anisotropic, p.roughness, m_has_anisotropic);
+
+        return p;
+    }
 
-        // Weights of BSDF and BRDF major lobes
-        Float brdf = (1.0f - metallic) * (1.0f - spec_trans),
-        bsdf = m_has_spec_trans ? (1.0f - metallic) * spec_trans : 0.0f;
+    /// Sample the BSDF given the parameters at \c si
+    std::pair<BSDFSample3f, Spectrum>
+    sample_shared(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                  Float sample1, const Point2f &sample2,
+                  const ShadingParams &p, Mask active) const {
+        Float cos_theta_i = Frame3f::cos_theta(si.wi);
+        BSDFSample3f bs   = dr::zeros<BSDFSample3f>();
 
         // Mask for incident side. (wi.z<0)
         Mask front_side = cos_theta_i > 0.0f;
 
         // Defining main specular reflection distribution
-        auto [ax, ay] = calc_dist_params(anisotropic, roughness,m_has_anisotropic);
-        MicrofacetDistribution spec_distr(MicrofacetType::GGX, ax, ay);
+        MicrofacetDistribution spec_distr(MicrofacetType::GGX, p.ax, p.ay);
         Normal3f m_spec = std::get<0>(
                 spec_distr.sample(dr::mulsign(si.wi, cos_theta_i), sample2));
 
@@ -369,28 +521,31 @@ public:
 
         // If BSDF major lobe is turned off, we do not sample the inside
         // case.
-        active &= (front_side || (bsdf > 0.0f));
+        active &= (front_side || (p.bsdf > 0.0f));
 
         // Probability definitions
         /* Inside  the material, just microfacet Reflection and
            microfacet Transmission is sampled. */
         Float prob_spec_reflect = dr::select(
                 front_side,
-                m_spec_srate * (1.0f - bsdf * (1.0f - F_spec_dielectric)),
+                m_spec_srate * (1.0f - p.bsdf * (1.0f - F_spec_dielectric)),
                 F_spec_dielectric);
         Float prob_spec_trans =
                 m_has_spec_trans
                 ? dr::select(front_side,
-                             m_spec_srate * bsdf * (1.0f - F_spec_dielectric),
+                             m_spec_srate * p.bsdf * (1.0f - F_spec_dielectric),
                              (1.0f - F_spec_dielectric))
                              : 0.0f;
         // Clearcoat has 1/4 of the main specular reflection energy.
         Float prob_clearcoat =
                 m_has_clearcoat
-                ? dr::select(front_side, 0.25f * clearcoat * m_clearcoat_srate,
+                ? dr::select(front_side, 0.25f * p.clearcoat * m_clearcoat_srate,
                              0.0f)
                              : 0.0f;
-        Float prob_diffuse = dr::select(front_side, brdf * m_diff_refl_srate, 0.0f);
+        Float prob_diffuse =
+                m_has_diffuse
+                ? dr::select(front_side, p.brdf * m_diff_refl_srate, 0.0f)
+                : 0.0f;
 
         // Normalizing the probabilities.
         Float rcp_tot_prob = dr::rcp(prob_spec_reflect + prob_spec_trans +
@@ -401,7 +556,7 @@ public:
 
         // Sampling mask definitions
         Float curr_prob(0.0f);
-        Mask sample_diffuse = active && (sample1 < prob_diffuse);
+        Mask sample_diffuse = m_has_diffuse && active && (sample1 < prob_diffuse);
         curr_prob += prob_diffuse;
         Mask sample_clearcoat = m_has_clearcoat && active &&
                 (sample1 >= curr_prob) &&
@@ -453,10 +608,8 @@ public:
         }
         // The secondary specular reflection sampling (clearcoat)
         if (m_has_clearcoat && dr::any_or<true>(sample_clearcoat)) {
-            Float clearcoat_gloss = m_clearcoat_gloss->eval_1(si, active);
-
             // Clearcoat roughness is mapped between 0.1 and 0.001.
-            GTR1 cc_dist(dr::lerp(0.1f, 0.001f, clearcoat_gloss));
+            GTR1 cc_dist(dr::lerp(0.1f, 0.001f, p.clearcoat_gloss));
             Normal3f m_cc                = cc_dist.sample(sample2);
             Vector3f wo                         = reflect(si.wi, m_cc);
             dr::masked(bs.wo, sample_clearcoat) = wo;
@@ -474,7 +627,7 @@ public:
                                            reflect));
         }
         // Cosine hemisphere reflection sampling
-        if (dr::any_or<true>(sample_diffuse)) {
+        if (m_has_diffuse && dr::any_or<true>(sample_diffuse)) {
             Vector3f wo = warp::square_to_cosine_hemisphere(sample2);
             dr::masked(bs.wo, sample_diffuse)                = wo;
             dr::masked(bs.sampled_component, sample_diffuse) = 0;
@@ -484,36 +637,22 @@ public:
             active &= (!sample_diffuse || reflect);
         }
 
-        bs.pdf = pdf(ctx, si, bs.wo, active);
+        bs.pdf = pdf_shared(si, bs.wo, p);
         active &= bs.pdf > 0.0f;
-        Spectrum result = eval(ctx, si, bs.wo, active);
+        Spectrum result = eval_shared(ctx, si, bs.wo, p, active);
         return { bs, result / bs.pdf & active };
     }
 
-    Spectrum eval(const BSDFContext &ctx, const SurfaceInteraction3f &si,
-                  const Vector3f &wo, Mask active) const override {
-        MI_MASKED_FUNCTION(ProfilerPhase::BSDFEvaluate, active);
-
+    /// Evaluate the BSDF given the parameters at \c si
+    Spectrum eval_shared(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                         const Vector3f &wo, const ShadingParams &p,
+                         Mask active) const {
         Float cos_theta_i = Frame3f::cos_theta(si.wi);
-        // Ignore perfectly grazing configurations
-        active &= cos_theta_i != 0.0f;
 
-        if (unlikely(dr::none_or<false>(active)))
-            return 0.0f;
-
-        // Store the weights.
-        Float anisotropic = m_has_anisotropic ? m_anisotropic->eval_1(si, active) : 0.0f,
-              roughness = m_roughness->eval_1(si, active),
-              flatness = m_has_flatness ? m_flatness->eval_1(si, active) : 0.0f,
-              spec_trans = m_has_spec_trans ? m_spec_trans->eval_1(si, active) : 0.0f,
-              metallic = m_has_metallic ? m_metallic->eval_1(si, active) : 0.0f,
-              clearcoat = m_has_clearcoat ? m_clearcoat->eval_1(si, active) : 0.0f,
-              sheen = m_has_sheen ? m_sheen->eval_1(si, active) : 0.0f;
-        UnpolarizedSpectrum base_color = m_base_color->eval(si, active);
-
-        // Weights for BRDF and BSDF major lobes.
-        Float brdf = (1.0f - metallic) * (1.0f - spec_trans),
-        bsdf = (1.0f - metallic) * spec_trans;
+        const Float &roughness = p.roughness, &flatness = p.flatness,
+                    &metallic = p.metallic, &clearcoat = p.clearcoat,
+                    &sheen = p.sheen, &brdf = p.brdf, &bsdf = p.bsdf;
+        const UnpolarizedSpectrum &base_color = p.base_color;
 
         Float cos_theta_o = Frame3f::cos_theta(wo);
 
@@ -530,8 +669,7 @@ public:
         Float inv_eta_path = dr::select(front_side, inv_eta, m_eta);
 
         // Main specular reflection and transmission lobe
-        auto [ax, ay] = calc_dist_params(anisotropic, roughness,m_has_anisotropic);
-        MicrofacetDistribution spec_dist(MicrofacetType::GGX, ax, ay);
+        MicrofacetDistribution spec_dist(MicrofacetType::GGX, p.ax, p.ay);
 
         // Halfway vector
         Vector3f wh =
@@ -565,7 +703,8 @@ public:
                 (F_spec_dielectric < 1.0f);
 
         // Diffuse, retro and fake subsurface mask
-        Mask diffuse_active = active && (brdf > 0.0f) && reflect && front_side;
+        Mask diffuse_active = m_has_diffuse && active && (brdf > 0.0f) &&
+                reflect && front_side;
 
         // Sheen mask
         Mask sheen_active = m_has_sheen && active && (sheen > 0.0f) &&
@@ -586,12 +725,9 @@ public:
             Float lum = m_has_spec_tint
                     ? mitsuba::luminance(base_color, si.wavelengths)
                     : 1.0f;
-            Float spec_tint =
-                    m_has_spec_tint ? m_spec_tint->eval_1(si, active) : 0.0f;
-
             // Fresnel term
             UnpolarizedSpectrum F_principled = principled_fresnel(
-                    F_spec_dielectric, metallic, spec_tint, base_color, lum,
+                    F_spec_dielectric, metallic, p.spec_tint, base_color, lum,
                     dr::dot(si.wi, wh), front_side, bsdf,m_eta,m_has_metallic,
                     m_has_spec_tint);
 
@@ -620,15 +756,13 @@ public:
 
         // Secondary isotropic specular reflection.
         if (m_has_clearcoat && dr::any_or<true>(clearcoat_active)) {
-            Float clearcoat_gloss = m_clearcoat_gloss->eval_1(si, active);
-
             // Clearcoat lobe uses the schlick approximation for Fresnel
             // term.
             Float Fcc = calc_schlick<Float>(0.04f, dr::dot(si.wi, wh),m_eta);
 
             /* Clearcoat lobe uses GTR1 distribution. Roughness is mapped
              * between 0.1 and 0.001. */
-            GTR1 mfacet_dist(dr::lerp(0.1f, 0.001f, clearcoat_gloss));
+            GTR1 mfacet_dist(dr::lerp(0.1f, 0.001f, p.clearcoat_gloss));
             Float Dcc = mfacet_dist.eval(wh);
 
             // Shadowing shadowing-masking term
@@ -641,7 +775,7 @@ public:
 
         // Evaluation of diffuse, retro reflection, fake subsurface and
         // sheen.
-        if (dr::any_or<true>(diffuse_active)) {
+        if (m_has_diffuse && dr::any_or<true>(diffuse_active)) {
             Float Fo = schlick_weight(dr::abs(cos_theta_o)),
             Fi = schlick_weight(dr::abs(cos_theta_i));
 
@@ -684,15 +818,13 @@ public:
 
                 // Tint the sheen evaluation towards the base color.
                 if (m_has_sheen_tint) {
-                    Float sheen_tint = m_sheen_tint->eval_1(si, active);
-
                     // Luminance evaluation
                     Float lum = mitsuba::luminance(base_color, si.wavelengths);
 
                     // Normalize color with luminance and tint the result.
                     UnpolarizedSpectrum c_tint =
                             dr::select(lum > 0.0f, base_color / lum, 1.0f);
-                    UnpolarizedSpectrum c_sheen = dr::lerp(1.0f, c_tint, sheen_tint);
+                    UnpolarizedSpectrum c_sheen = dr::lerp(1.0f, c_tint, p.sheen_tint);
 
                     // Adding sheen evaluation with tint.
                     dr::masked(value, sheen_active) +=
@@ -708,30 +840,10 @@ public:
         return depolarizer<Spectrum>(value) & active;
     }
 
-    Float pdf(const BSDFContext &, const SurfaceInteraction3f &si,
-              const Vector3f &wo, Mask active) const override {
-        MI_MASKED_FUNCTION(ProfilerPhase::BSDFEvaluate, active);
-
+    /// Evaluate the sampling density given the parameters at \c si
+    Float pdf_shared(const SurfaceInteraction3f &si, const Vector3f &wo,
+                     const ShadingParams &p) const {
         Float cos_theta_i = Frame3f::cos_theta(si.wi);
-        // Ignore perfectly grazing configurations.
-        active &= cos_theta_i != 0.0f;
-
-        if (unlikely(dr::none_or<false>(active)))
-            return 0.0f;
-
-        // Store the weights.
-        Float anisotropic =
-                m_has_anisotropic ? m_anisotropic->eval_1(si, active) : 0.0f,
-                roughness = m_roughness->eval_1(si, active),
-                spec_trans =
-                        m_has_spec_trans ? m_spec_trans->eval_1(si, active) : 0.0f;
-        Float metallic = m_has_metallic ? m_metallic->eval_1(si, active) : 0.0f,
-        clearcoat =
-                m_has_clearcoat ? m_clearcoat->eval_1(si, active) : 0.0f;
-
-        // BRDF and BSDF major lobe weights
-        Float brdf = (1.0f - metallic) * (1.0f - spec_trans),
-        bsdf = (1.0f - metallic) * spec_trans;
 
         // Masks if incident direction is inside (wi.z<0)
         Mask front_side = cos_theta_i > 0.0f;
@@ -751,8 +863,7 @@ public:
         wh = dr::mulsign(wh, Frame3f::cos_theta(wh));
 
         // Main specular distribution for reflection and transmission.
-        auto [ax, ay] = calc_dist_params(anisotropic, roughness,m_has_anisotropic);
-        MicrofacetDistribution spec_distr(MicrofacetType::GGX, ax, ay);
+        MicrofacetDistribution spec_distr(MicrofacetType::GGX, p.ax, p.ay);
 
         // Dielectric Fresnel calculation
         auto [F_spec_dielectric, cos_theta_t, eta_it, eta_ti] =
@@ -761,21 +872,23 @@ public:
         // Defining the probabilities
         Float prob_spec_reflect = dr::select(
                 front_side,
-                m_spec_srate * (1.0f - bsdf * (1.0f - F_spec_dielectric)),
+                m_spec_srate * (1.0f - p.bsdf * (1.0f - F_spec_dielectric)),
                 F_spec_dielectric);
         Float prob_spec_trans =
                 m_has_spec_trans
                 ? dr::select(front_side,
-                             m_spec_srate * bsdf * (1.0f - F_spec_dielectric),
+                             m_spec_srate * p.bsdf * (1.0f - F_spec_dielectric),
                              (1.0f - F_spec_dielectric))
                              : 0.0f;
         Float prob_clearcoat =
                 m_has_clearcoat
-                ? dr::select(front_side, 0.25f * clearcoat * m_clearcoat_srate,
+                ? dr::select(front_side, 0.25f * p.clearcoat * m_clearcoat_srate,
                              0.0f)
                              : 0.0f;
         Float prob_diffuse =
-                dr::select(front_side, brdf * m_diff_refl_srate, 0.f);
+                m_has_diffuse
+                ? dr::select(front_side, p.brdf * m_diff_refl_srate, 0.f)
+                : 0.0f;
 
         // Normalizing the probabilities.
         Float rcp_tot_prob = dr::rcp(prob_spec_reflect + prob_spec_trans +
@@ -811,8 +924,9 @@ public:
                 prob_spec_reflect *
                 spec_distr.pdf(dr::mulsign(si.wi, cos_theta_i), wh) * dwh_dwo_abs;
         // Adding cosine hemisphere reflection pdf
-        dr::masked(pdf, reflect) +=
-                prob_diffuse * warp::square_to_cosine_hemisphere_pdf(wo);
+        if (m_has_diffuse)
+            dr::masked(pdf, reflect) +=
+                    prob_diffuse * warp::square_to_cosine_hemisphere_pdf(wo);
         // Main specular transmission
         if (m_has_spec_trans) {
             // Macro-micro surface mask for transmission.
@@ -828,42 +942,13 @@ public:
         }
         // Adding the secondary specular reflection pdf.(clearcoat)
         if (m_has_clearcoat) {
-            Float clearcoat_gloss = m_clearcoat_gloss->eval_1(si, active);
-            GTR1 cc_dist(dr::lerp(0.1f, 0.001f, clearcoat_gloss));
+            GTR1 cc_dist(dr::lerp(0.1f, 0.001f, p.clearcoat_gloss));
             dr::masked(pdf, mfacet_reflect_macmic) +=
                     prob_clearcoat * cc_dist.pdf(wh) * dwh_dwo_abs;
         }
         return pdf;
     }
 
-    Spectrum eval_diffuse_reflectance(const SurfaceInteraction3f &si,
-                                      Mask active) const override {
-        return m_base_color->eval(si, active);
-    }
-
-    std::string to_string() const override {
-        std::ostringstream oss;
-        oss << "Principled BSDF :" << std::endl
-            << "base_color: " << m_base_color << "," << std::endl
-            << "spec_trans: " << m_spec_trans << "," << std::endl
-            << "anisotropic: " << m_anisotropic << "," << std::endl
-            << "roughness: " << m_roughness << "," << std::endl
-            << "sheen: " << m_sheen << "," << std::endl
-            << "sheen_tint: " << m_sheen_tint << "," << std::endl
-            << "flatness: " << m_flatness << "," << std::endl;
-        if (m_eta_specular)
-            oss << "eta: " << m_eta << "," << std::endl;
-        else
-            oss << "specular: " << m_specular << "," << std::endl;
-        oss << "clearcoat: " << m_clearcoat << "," << std::endl
-            << "clearcoat_gloss: " << m_clearcoat_gloss << "," << std::endl
-            << "metallic: " << m_metallic << "," << std::endl
-            << "spec_tint: " << m_spec_tint << "," << std::endl;
-
-        return oss.str();
-    }
-    MI_DECLARE_CLASS()
-private:
     /// Parameters
     ref<Texture> m_base_color;
     ref<Texture> m_roughness;
@@ -886,6 +971,7 @@ private:
     ScalarFloat m_clearcoat_srate;
 
     /// Whether the lobes are active or not.
+    bool m_has_diffuse;
     bool m_has_clearcoat;
     bool m_has_sheen;
     bool m_has_spec_trans;
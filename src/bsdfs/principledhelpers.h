@@ -131,6 +131,23 @@ bool get_flag(const std::string &name, const Properties &props) {
     }
 }
 
+/**
+ * \brief Check whether a feature is set to a given constant value.
+ * \param name
+ *     Name of the feature.
+ * \param props
+ *     Given properties.
+ * \param value
+ *     The constant value.
+ * \return whether the feature is a float equal to \c value.
+ */
+bool has_constant_value(const std::string &name, const Properties &props,
+                        float value) {
+    return props.has_property(name) &&
+           props.type(name) == Properties::Type::Float &&
+           std::stof(props.as_string(name)) == value;
+}
+
 /**
  * \brief Computes the schlick weight for Fresnel Schlick approximation.
  * \param cos_i
@@ -216,6 +216,7 @@ public:
 
         for (auto c : m_components)
             m_flags |= c;
+        m_flags = m_flags | BSDFFlags::Depolarizing;
     }
 
     void traverse(TraversalCallback *callback) override {
@@ -1,10 +1,14 @@
 #include <mitsuba/core/string.h>
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/plugin.h>
+#include <mitsuba/core/warp.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/ior.h>
 #include <mitsuba/render/microfacet.h>
 #include <mitsuba/render/texture.h>
+#include <mutex>
+
+#define MI_ROUGH_ALBEDO_RES 32
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -56,6 +60,11 @@ Rough conductor material (:monosp:`roughconductor`)
      focuses computation on the visible parts of the microfacet normal distribution, considerably
      reducing variance in some cases. (Default: |true|, i.e. use visible normal sampling)
 
+ * - energy_compensation
+   - |bool|
+   - Add the energy of the light that is reflected several times between the microfacets (see
+     below). (Default: |false|)
+
 This plugin implements a realistic microfacet scattering model for rendering
 rough conducting materials, such as metals.
 
@@ -142,6 +151,17 @@ approach of sampling all normals is still available and can be enabled
 by setting :monosp:`sample_visible` to :monosp:`false`. However this will lead
 to significantly slower convergence.
 
+Like most microfacet models, this plugin only accounts for a single reflection
+on the microfacets, hence rough surfaces appear darker than they should: the
+light that is reflected towards other microfacets is lost. When
+:monosp:`energy_compensation` is set, the plugin adds the multiple scattering
+lobe of Kulla and Conty :cite:`KullaConty2017`, which restores this energy
+based on the directional albedo of the microfacet distribution. The albedo is
+tabulated over the elevation and the roughness when the first instance using
+a given distribution is created (anisotropic roughness uses the geometric mean
+of :math:`\alpha_u` and :math:`\alpha_v`). The added lobe is nearly diffuse
+and it is sampled with a cosine-weighted distribution.
+
 When using this plugin, you should ideally compile Mitsuba with support for
 spectral rendering to get the most accurate results. While it also works
 in RGB mode, the computations will be more approximate in nature.
@@ -186,6 +206,12 @@ public:
 
         m_sample_visible = props.get<bool>("sample_visible", true);
 
+        m_energy_compensation = props.get<bool>("energy_compensation", false);
+        if (m_energy_compensation) {
+            const std::vector<ScalarFloat> &table = albedo_table(m_type);
+            m_albedo = dr::load<DynamicBuffer<Float>>(table.data(), table.size());
+        }
+
         if (props.has_property("alpha_u") || props.has_property("alpha_v")) {
             if (!props.has_property("alpha_u") || !props.has_property("alpha_v"))
                 Throw("Microfacet model: both 'alpha_u' and 'alpha_v' must be specified.");
@@ -224,7 +250,7 @@ public:
 
     std::pair<BSDFSample3f, Spectrum> sample(const BSDFContext &ctx,
                                              const SurfaceInteraction3f &si,
-                                             Float /* sample1 */,
+                                             Float sample1,
                                              const Point2f &sample2,
                                              Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::BSDFSample, active);
@@ -236,6 +262,9 @@ public:
         if (unlikely(!ctx.is_enabled(BSDFFlags::GlossyReflection) || dr::none_or<false>(active)))
             return { bs, 0.f };
 
+        if (m_energy_compensation)
+            return sample_compensated(ctx, si, sample1, sample2, active);
+
         /* Construct a microfacet distribution matching the
            roughness values at the current surface position. */
         MicrofacetDistribution distr(m_type,
@@ -332,6 +361,9 @@ public:
                                      m_alpha_v->eval_1(si, active),
                                      m_sample_visible);
 
+        // Multiple scattering is evaluated for all pairs of directions
+        Mask active_ms = active;
+
         // Evaluate the microfacet normal distribution
         Float D = distr.eval(H);
 
@@ -384,7 +416,15 @@ public:
         if (m_specular_reflectance)
             result *= m_specular_reflectance->eval(si, active);
 
-        return (F * result) & active;
+        Spectrum value = (F * result) & active;
+        if (m_energy_compensation) {
+            auto [eta_ms, spec_ms] = shading_terms(si, active_ms);
+            value += depolarizer<Spectrum>(eval_ms(distr, eta_ms, spec_ms,
+                                                   cos_theta_i, cos_theta_o,
+                                                   active_ms)) &
+                     active_ms;
+        }
+        return value;
     }
 
     Float pdf(const BSDFContext &ctx, const SurfaceInteraction3f &si,
@@ -401,17 +441,18 @@ public:
            This logic is evaluated in smith_g1() called as part of the eval()
            and sample() methods and needs to be replicated in the probability
            density computation as well. */
-        active &= cos_theta_i > 0.f && cos_theta_o > 0.f &&
-                  dr::dot(si.wi, m) > 0.f && dr::dot(wo, m) > 0.f;
+        Mask active_ms = active && cos_theta_i > 0.f && cos_theta_o > 0.f;
+        active = active_ms && dr::dot(si.wi, m) > 0.f && dr::dot(wo, m) > 0.f;
 
-        if (unlikely(!ctx.is_enabled(BSDFFlags::GlossyReflection) || dr::none_or<false>(active)))
+        if (unlikely(!ctx.is_enabled(BSDFFlags::GlossyReflection) ||
+                     dr::none_or<false>(m_energy_compensation ? active_ms : active)))
             return 0.f;
 
         /* Construct a microfacet distribution matching the
            roughness values at the current surface position. */
         MicrofacetDistribution distr(m_type,
-                                     m_alpha_u->eval_1(si, active),
-                                     m_alpha_v->eval_1(si, active),
+                                     m_alpha_u->eval_1(si, active_ms),
+                                     m_alpha_v->eval_1(si, active_ms),
                                      m_sample_visible);
 
         Float result;
@@ -421,7 +462,11 @@ public:
         else
             result = distr.pdf(si.wi, m) / (4.f * dr::dot(wo, m));
 
-        return dr::select(active, result, 0.f);
+        result = dr::select(active, result, 0.f);
+        if (m_energy_compensation)
+            result = mix_pdf_ms(result, distr, cos_theta_i, cos_theta_o, active_ms);
+
+        return result;
     }
 
     std::pair<Spectrum, Float> eval_pdf(const BSDFContext &ctx,
@@ -440,36 +485,108 @@ public:
            This logic is evaluated in smith_g1() called as part of the eval()
            and sample() methods and needs to be replicated in the probability
            density computation as well. */
-        active &= cos_theta_i > 0.f && cos_theta_o > 0.f &&
-                  dr::dot(si.wi, H) > 0.f && dr::dot(wo, H) > 0.f;
+        Mask active_ms = active && cos_theta_i > 0.f && cos_theta_o > 0.f;
+        active = active_ms && dr::dot(si.wi, H) > 0.f && dr::dot(wo, H) > 0.f;
 
-        if (unlikely(!ctx.is_enabled(BSDFFlags::GlossyReflection) || dr::none_or<false>(active)))
+        if (unlikely(!ctx.is_enabled(BSDFFlags::GlossyReflection) ||
+                     dr::none_or<false>(m_energy_compensation ? active_ms : active)))
             return { 0.f, 0.f };
 
         /* Construct a microfacet distribution matching the
            roughness values at the current surface position. */
+        MicrofacetDistribution distr(m_type,
+                                     m_alpha_u->eval_1(si, active_ms),
+                                     m_alpha_v->eval_1(si, active_ms),
+                                     m_sample_visible);
+
+        auto [eta_c, spec] = shading_terms(si, active_ms);
+
+        return eval_pdf_shared(ctx, si, wo, distr, eta_c, spec, active_ms);
+    }
+
+    std::tuple<Spectrum, Float, BSDFSample3f, Spectrum>
+    eval_pdf_sample(const BSDFContext &ctx,
+                    const SurfaceInteraction3f &si,
+                    const Vector3f &wo,
+                    Float sample1,
+                    const Point2f &sample2,
+                    Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::BSDFSample, active);
+
+        BSDFSample3f bs = dr::zeros<BSDFSample3f>();
+        Float cos_theta_i = Frame3f::cos_theta(si.wi);
+        active &= cos_theta_i > 0.f;
+
+        if (unlikely(!ctx.is_enabled(BSDFFlags::GlossyReflection) || dr::none_or<false>(active)))
+            return { 0.f, 0.f, bs, 0.f };
+
+        /* The microfacet distribution and the remaining texture lookups only
+           depend on 'si' and are shared by the evaluation and the sampling */
         MicrofacetDistribution distr(m_type,
                                      m_alpha_u->eval_1(si, active),
                                      m_alpha_v->eval_1(si, active),
                                      m_sample_visible);
 
-        // Evaluate the microfacet normal distribution
-        Float D = distr.eval(H);
+        auto [eta_c, spec] = shading_terms(si, active);
 
-        active &= D != 0.f;
+        auto [value, pdf] = eval_pdf_shared(ctx, si, wo, distr, eta_c, spec, active);
 
-        // Evaluate Smith's shadow-masking function
-        Float smith_g1_wi = distr.smith_g1(si.wi, H);
-        Float G = smith_g1_wi * distr.smith_g1(wo, H);
+        // Sample M, the microfacet normal
+        auto [m, m_pdf] = distr.sample(si.wi, sample2);
 
-        // Evaluate the full microfacet model (except Fresnel)
-        UnpolarizedSpectrum value = D * G / (4.f * Frame3f::cos_theta(si.wi));
+        bs.eta = 1.f;
+        bs.sampled_component = 0;
+        bs.sampled_type = +BSDFFlags::GlossyReflection;
 
-        // Evaluate the Fresnel factor
+        Spectrum weight;
+        if (m_energy_compensation) {
+            Mask sample_ms = sample1 < prob_ms(distr, cos_theta_i, active);
+            bs.wo = dr::select(sample_ms, warp::square_to_cosine_hemisphere(sample2),
+                               reflect(si.wi, m));
+
+            auto [bs_value, bs_pdf] =
+                eval_pdf_shared(ctx, si, bs.wo, distr, eta_c, spec, active);
+            bs.pdf = bs_pdf;
+            weight = (bs_value / bs.pdf) & (active && bs.pdf > 0.f);
+        } else {
+            // Perfect specular reflection based on the microfacet normal
+            bs.wo = reflect(si.wi, m);
+            bs.pdf = m_pdf;
+
+            // Ensure that this is a valid sample
+            Mask active_s = active && (bs.pdf != 0.f) && Frame3f::cos_theta(bs.wo) > 0.f;
+
+            UnpolarizedSpectrum w;
+            if (likely(m_sample_visible))
+                w = distr.smith_g1(bs.wo, m);
+            else
+                w = distr.G(si.wi, bs.wo, m) * dr::dot(si.wi, m) /
+                    (cos_theta_i * Frame3f::cos_theta(m));
+
+            // Jacobian of the half-direction mapping
+            bs.pdf /= 4.f * dr::dot(bs.wo, m);
+
+            weight = (fresnel_term(ctx, si, bs.wo, m, eta_c) * (w * spec)) & active_s;
+        }
+
+        return { value, pdf, bs, weight };
+    }
+
+    /// Look up the complex index of refraction and the specular reflectance
+    std::pair<dr::Complex<UnpolarizedSpectrum>, UnpolarizedSpectrum>
+    shading_terms(const SurfaceInteraction3f &si, Mask active) const {
         dr::Complex<UnpolarizedSpectrum> eta_c(m_eta->eval(si, active),
-                                           m_k->eval(si, active));
+                                               m_k->eval(si, active));
+        UnpolarizedSpectrum spec(1.f);
+        if (m_specular_reflectance)
+            spec = m_specular_reflectance->eval(si, active);
+        return { eta_c, spec };
+    }
 
-        Spectrum F;
+    /// Fresnel factor of the reflection of \c wo about the microfacet normal \c m
+    Spectrum fresnel_term(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                          const Vector3f &wo, const Vector3f &m,
+                          const dr::Complex<UnpolarizedSpectrum> &eta_c) const {
         if constexpr (is_polarized_v<Spectrum>) {
             /* Due to the coordinate system rotations for polarization-aware
                pBSDFs below we need to know the propagation direction of light.
@@ -479,12 +596,12 @@ public:
                      wi_hat = ctx.mode == TransportMode::Radiance ? si.wi : wo;
 
             // Mueller matrix for specular reflection.
-            F = mueller::specular_reflection(UnpolarizedSpectrum(dot(wo_hat, H)), eta_c);
+            Spectrum F = mueller::specular_reflection(UnpolarizedSpectrum(dot(wo_hat, m)), eta_c);
 
             /* The Stokes reference frame vector of this matrix lies perpendicular
                to the plane of reflection. */
-            Vector3f s_axis_in  = dr::cross(H, -wo_hat);
-            Vector3f s_axis_out = dr::cross(H, wi_hat);
+            Vector3f s_axis_in  = dr::cross(m, -wo_hat);
+            Vector3f s_axis_out = dr::cross(m, wi_hat);
 
             // Singularity when the input & output are collinear with the normal
             Mask collinear = dr::all(s_axis_in == Vector3f(0));
@@ -495,16 +612,52 @@ public:
 
             /* Rotate in/out reference vector of F s.t. it aligns with the implicit
                Stokes bases of -wo_hat & wi_hat. */
-            F = mueller::rotate_mueller_basis(F,
-                                              -wo_hat, s_axis_in, mueller::stokes_basis(-wo_hat),
-                                               wi_hat, s_axis_out, mueller::stokes_basis(wi_hat));
+            return mueller::rotate_mueller_basis(F,
+                                                 -wo_hat, s_axis_in, mueller::stokes_basis(-wo_hat),
+                                                  wi_hat, s_axis_out, mueller::stokes_basis(wi_hat));
         } else {
-            F = fresnel_conductor(UnpolarizedSpectrum(dr::dot(si.wi, H)), eta_c);
+            DRJIT_MARK_USED(ctx);
+            DRJIT_MARK_USED(wo);
+            return fresnel_conductor(UnpolarizedSpectrum(dr::dot(si.wi, m)), eta_c);
         }
+    }
+
+    /**
+     * \brief Evaluate the BSDF and its density for a direction \c wo given
+     * the microfacet distribution and the texture lookups at \c si
+     *
+     * \c active must already exclude directions <tt>si.wi</tt> below the
+     * surface.
+     */
+    std::pair<Spectrum, Float>
+    eval_pdf_shared(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                    const Vector3f &wo, const MicrofacetDistribution &distr,
+                    const dr::Complex<UnpolarizedSpectrum> &eta_c,
+                    const UnpolarizedSpectrum &spec, Mask active) const {
+        Float cos_theta_i = Frame3f::cos_theta(si.wi),
+              cos_theta_o = Frame3f::cos_theta(wo);
+
+        // Calculate the half-direction vector
+        Vector3f H = dr::normalize(wo + si.wi);
+
+        Mask active_ms = active && cos_theta_o > 0.f;
+        active = active_ms && dr::dot(si.wi, H) > 0.f && dr::dot(wo, H) > 0.f;
+
+        // Evaluate the microfacet normal distribution
+        Float D = distr.eval(H);
+
+        active &= D != 0.f;
+
+        // Evaluate Smith's shadow-masking function
+        Float smith_g1_wi = distr.smith_g1(si.wi, H);
+        Float G = smith_g1_wi * distr.smith_g1(wo, H);
+
+        // Evaluate the full microfacet model (except Fresnel)
+        UnpolarizedSpectrum value = D * G / (4.f * cos_theta_i);
 
         // If requested, include the specular reflectance component
         if (m_specular_reflectance)
-            value *= m_specular_reflectance->eval(si, active);
+            value *= spec;
 
         Float pdf;
         if (likely(m_sample_visible))
@@ -512,7 +665,170 @@ public:
         else
             pdf = distr.pdf(si.wi, H) / (4.f * dr::dot(wo, H));
 
-        return { F * value & active, dr::select(active, pdf, 0.f) };
+        Spectrum result = fresnel_term(ctx, si, wo, H, eta_c) * value & active;
+        pdf = dr::select(active, pdf, 0.f);
+
+        if (m_energy_compensation) {
+            result += depolarizer<Spectrum>(eval_ms(distr, eta_c, spec, cos_theta_i,
+                                                    cos_theta_o, active_ms)) &
+                      active_ms;
+            pdf = mix_pdf_ms(pdf, distr, cos_theta_i, cos_theta_o, active_ms);
+        }
+
+        return { result, pdf };
+    }
+
+    /**
+     * \brief Return the albedo tables of a microfacet distribution, which are
+     * computed on first use
+     *
+     * The first <tt>MI_ROUGH_ALBEDO_RES^2</tt> entries hold the directional
+     * albedo without Fresnel factor over a regular grid of the cosine of the
+     * elevation (fastest varying) and of the roughness in <tt>[0, 1]</tt>.
+     * They are followed by the hemispherical average of the albedo for each
+     * roughness value.
+     */
+    static const std::vector<ScalarFloat> &albedo_table(MicrofacetType type) {
+        static std::mutex mutex;
+        static std::vector<ScalarFloat> tables[2];
+
+        std::lock_guard<std::mutex> guard(mutex);
+        std::vector<ScalarFloat> &table = tables[type == MicrofacetType::GGX ? 1 : 0];
+        if (!table.empty())
+            return table;
+
+        using FloatX = DynamicBuffer<ScalarFloat>;
+        using Vector3fX = Vector<FloatX, 3>;
+        using FloatP = dr::Packet<dr::scalar_t<Float>>;
+
+        const size_t res = MI_ROUGH_ALBEDO_RES;
+        FloatX mu = dr::maximum(1e-6f, dr::linspace<FloatX>(0, 1, res));
+        Vector3fX wi = Vector3fX(dr::sqrt(1 - mu * mu), dr::zeros<FloatX>(res), mu);
+
+        table.resize(res * res + res);
+        for (size_t i = 0; i < res; ++i) {
+            ScalarFloat alpha = dr::maximum(1e-3f, ScalarFloat(i) / (res - 1));
+            mitsuba::MicrofacetDistribution<FloatP, Spectrum> distr(type, alpha);
+            FloatX albedo = dr::minimum(eval_albedo(distr, wi), 1.f);
+
+            std::copy(albedo.data(), albedo.data() + res,
+                      table.data() + i * res);
+            table[res * res + i] =
+                dr::minimum(dr::mean(albedo * mu) * 2.f, ScalarFloat(1.f));
+        }
+
+        return table;
+    }
+
+    /// Bilinearly interpolate the albedo tables (\c row == res for the average)
+    Float lerp_albedo(const Float &mu, const Float &alpha, bool average,
+                      Mask active) const {
+        const uint32_t res = MI_ROUGH_ALBEDO_RES;
+        Float x = dr::clip(mu, 0.f, 1.f) * (res - 1),
+              y = dr::clip(alpha, 0.f, 1.f) * (res - 1);
+        UInt32 i = dr::minimum(UInt32(x), res - 2),
+               j = dr::minimum(UInt32(y), res - 2);
+        Float fy = y - Float(j);
+
+        if (average) {
+            UInt32 index = res * res + j;
+            return dr::lerp(dr::gather<Float>(m_albedo, index, active),
+                            dr::gather<Float>(m_albedo, index + 1, active), fy);
+        }
+
+        Float fx = x - Float(i);
+        UInt32 index = j * res + i;
+        Float v00 = dr::gather<Float>(m_albedo, index, active),
+              v10 = dr::gather<Float>(m_albedo, index + 1, active),
+              v01 = dr::gather<Float>(m_albedo, index + res, active),
+              v11 = dr::gather<Float>(m_albedo, index + res + 1, active);
+
+        return dr::lerp(dr::lerp(v00, v10, fx), dr::lerp(v01, v11, fx), fy);
+    }
+
+    /// Roughness used to query the albedo tables
+    Float albedo_roughness(const MicrofacetDistribution &distr) const {
+        return dr::sqrt(distr.alpha_u() * distr.alpha_v());
+    }
+
+    /**
+     * \brief Evaluate the multiple scattering lobe of Kulla and Conty
+     * (including the cosine foreshortening factor)
+     */
+    UnpolarizedSpectrum eval_ms(const MicrofacetDistribution &distr,
+                                const dr::Complex<UnpolarizedSpectrum> &eta_c,
+                                const UnpolarizedSpectrum &spec,
+                                const Float &cos_theta_i,
+                                const Float &cos_theta_o, Mask active) const {
+        Float alpha = albedo_roughness(distr),
+              e_i   = lerp_albedo(cos_theta_i, alpha, false, active),
+              e_o   = lerp_albedo(cos_theta_o, alpha, false, active),
+              e_avg = lerp_albedo(0.f, alpha, true, active);
+
+        // Approximation of the hemispherical average of the Fresnel factor
+        UnpolarizedSpectrum F0 =
+            fresnel_conductor(UnpolarizedSpectrum(1.f), eta_c);
+        UnpolarizedSpectrum F_avg = dr::fmadd(F0, 20.f / 21.f, 1.f / 21.f);
+
+        // Energy of the light leaving after more than one reflection
+        UnpolarizedSpectrum F_ms =
+            dr::square(F_avg) * e_avg / (1.f - F_avg * (1.f - e_avg));
+
+        UnpolarizedSpectrum value =
+            F_ms * (1.f - e_i) * (1.f - e_o) * cos_theta_o /
+            (dr::Pi<Float> * dr::maximum(1.f - e_avg, 1e-4f));
+
+        if (m_specular_reflectance)
+            value *= spec;
+
+        return dr::select(active, value, 0.f);
+    }
+
+    /// Probability of sampling the multiple scattering lobe
+    Float prob_ms(const MicrofacetDistribution &distr, const Float &cos_theta_i,
+                  Mask active) const {
+        return 1.f - lerp_albedo(cos_theta_i, albedo_roughness(distr), false,
+                                 active);
+    }
+
+    /// Combine the density of the microfacet model with that of the multiple scattering lobe
+    Float mix_pdf_ms(const Float &pdf, const MicrofacetDistribution &distr,
+                     const Float &cos_theta_i, const Float &cos_theta_o,
+                     Mask active) const {
+        Float prob = prob_ms(distr, cos_theta_i, active);
+        return dr::select(active,
+                          dr::lerp(pdf, warp::square_to_cosine_hemisphere_pdf(
+                                            Vector3f(0.f, 0.f, cos_theta_o)),
+                                   prob),
+                          0.f);
+    }
+
+    /// Sample the microfacet model or the multiple scattering lobe
+    std::pair<BSDFSample3f, Spectrum>
+    sample_compensated(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                       Float sample1, const Point2f &sample2,
+                       Mask active) const {
+        BSDFSample3f bs = dr::zeros<BSDFSample3f>();
+        MicrofacetDistribution distr(m_type,
+                                     m_alpha_u->eval_1(si, active),
+                                     m_alpha_v->eval_1(si, active),
+                                     m_sample_visible);
+
+        Mask sample_ms =
+            sample1 < prob_ms(distr, Frame3f::cos_theta(si.wi), active);
+
+        Normal3f m = distr.sample(si.wi, sample2).first;
+        bs.wo = dr::select(sample_ms, warp::square_to_cosine_hemisphere(sample2),
+                           reflect(si.wi, m));
+        bs.eta = 1.f;
+        bs.sampled_component = 0;
+        bs.sampled_type = +BSDFFlags::GlossyReflection;
+
+        auto [value, pdf] = eval_pdf(ctx, si, bs.wo, active);
+        bs.pdf = pdf;
+        active &= pdf > 0.f;
+
+        return { bs, (value / pdf) & active };
     }
 
     std::string to_string() const override {
@@ -520,6 +836,7 @@ public:
         oss << "RoughConductor[" << std::endl
             << "  distribution = " << m_type << "," << std::endl
             << "  sample_visible = " << m_sample_visible << "," << std::endl
+            << "  energy_compensation = " << m_energy_compensation << "," << std::endl
             << "  alpha_u = " << string::indent(m_alpha_u) << "," << std::endl
             << "  alpha_v = " << string::indent(m_alpha_v) << "," << std::endl;
         if (m_specular_reflectance)
@@ -544,6 +861,10 @@ private:
     ref<Texture> m_k;
     /// Specular reflectance component
     ref<Texture> m_specular_reflectance;
+    /// Add the multiple scattering lobe?
+    bool m_energy_compensation;
+    /// Albedo tables of the distribution (see \ref albedo_table())
+    DynamicBuffer<Float> m_albedo;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(RoughConductor, BSDF)
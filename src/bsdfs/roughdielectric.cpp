@@ -2,12 +2,17 @@
 #include <mitsuba/core/plugin.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/string.h>
+#include <mitsuba/core/warp.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/ior.h>
 #include <mitsuba/render/microfacet.h>
 #include <mitsuba/render/fresnel.h>
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/sampler.h>
+#include <map>
+#include <mutex>
+
+#define MI_ROUGH_ALBEDO_RES 32
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -60,6 +65,11 @@ Rough dielectric material (:monosp:`roughdielectric`)
      focuses computation on the visible parts of the microfacet normal distribution, considerably
      reducing variance in some cases. (Default: |true|, i.e. use visible normal sampling)
 
+ * - energy_compensation
+   - |bool|
+   - Add the energy of the light that is scattered several times between the microfacets (see
+     below). (Default: |false|)
+
  * - eta
    - |float|
    - Relative index of refraction from the exterior to the interior
@@ -151,6 +161,22 @@ approach of sampling all normals is still available and can be enabled
 by setting :monosp:`sample_visible` to |false|. However this will lead
 to significantly slower convergence.
 
+Like the :ref:`roughconductor <bsdf-roughconductor>` plugin, this model only
+accounts for a single scattering event on the microfacets, hence rough
+interfaces lose the energy of the light that is reflected or refracted towards
+other microfacets. When :monosp:`energy_compensation` is set, the plugin adds a
+multiple scattering lobe in the spirit of Kulla and Conty :cite:`KullaConty2017`
+that restores this energy. It is driven by tables of the directional albedo of
+the reflection and of the transmission over the elevation and the roughness,
+on both sides of the interface. The tables are computed for the relative index
+of refraction of the material when it is first used (and again when
+:monosp:`eta` changes), and are shared by all instances with the same index of
+refraction and distribution. The lost energy is split between reflection and
+transmission in proportion to the hemispherical averages of the single
+scattering albedos, and both lobes are sampled with cosine-weighted
+distributions. The added lobes restore the lost energy up to the resolution of
+the tables, but they are only approximately reciprocal.
+
  */
 
 template <typename Float, typename Spectrum>
@@ -193,6 +219,7 @@ public:
         }
 
         m_sample_visible = props.get<bool>("sample_visible", true);
+        m_energy_compensation = props.get<bool>("energy_compensation", false);
 
         if (props.has_property("alpha_u") || props.has_property("alpha_v")) {
             if (!props.has_property("alpha_u") || !props.has_property("alpha_v"))
@@ -211,7 +238,7 @@ public:
                                BSDFFlags::BackSide | extra);
         m_components.push_back(BSDFFlags::GlossyTransmission | BSDFFlags::FrontSide |
                                BSDFFlags::BackSide | BSDFFlags::NonSymmetric | extra);
-        m_flags = m_components[0] | m_components[1];
+        m_flags = m_components[0] | m_components[1] | BSDFFlags::Depolarizing;
 
         parameters_changed();
     }
@@ -231,8 +258,17 @@ public:
             callback->put_object("specular_transmittance", m_specular_transmittance.get(), +ParamFlags::Differentiable);
     }
 
-    void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
+    void parameters_changed(const std::vector<std::string> &keys = {}) override {
         m_inv_eta = dr::rcp(m_eta);
+
+        // The albedo tables depend on the relative index of refraction
+        if (m_energy_compensation &&
+            (keys.empty() || string::contains(keys, "eta"))) {
+            const std::vector<ScalarFloat> &table =
+                albedo_table(m_type, dr::slice(m_eta));
+            m_albedo = dr::load<DynamicBuffer<Float>>(table.data(), table.size());
+        }
+
         dr::make_opaque(m_eta, m_inv_eta);
     }
 
@@ -243,115 +279,18 @@ public:
                                              Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::BSDFSample, active);
 
-        // Determine the type of interaction
-        bool has_reflection    = ctx.is_enabled(BSDFFlags::GlossyReflection, 0),
-             has_transmission  = ctx.is_enabled(BSDFFlags::GlossyTransmission, 1);
-
-        BSDFSample3f bs = dr::zeros<BSDFSample3f>();
-
-        Float cos_theta_i = Frame3f::cos_theta(si.wi);
-
         // Ignore perfectly grazing configurations
-        active &= cos_theta_i != 0.f;
-
-        /* Construct the microfacet distribution matching the roughness values at the current surface position. */
-        MicrofacetDistribution distr(m_type,
-                                     m_alpha_u->eval_1(si, active),
-                                     m_alpha_v->eval_1(si, active),
-                                     m_sample_visible);
-
-        /* Trick by Walter et al.: slightly scale the roughness values to
-           reduce importance sampling weights. Not needed for the
-           Heitz and D'Eon sampling technique. */
-        MicrofacetDistribution sample_distr(distr);
-        if (unlikely(!m_sample_visible))
-            sample_distr.scale_alpha(1.2f - .2f * dr::sqrt(dr::abs(cos_theta_i)));
-
-        // Sample the microfacet normal
-        Normal3f m;
-        std::tie(m, bs.pdf) =
-            sample_distr.sample(dr::mulsign(si.wi, cos_theta_i), sample2);
-        active &= bs.pdf != 0.f;
-
-        auto [F, cos_theta_t, eta_it, eta_ti] =
-            fresnel(dr::dot(si.wi, m), m_eta);
-
-        // Select the lobe to be sampled
-        UnpolarizedSpectrum weight;
-        Mask selected_r, selected_t;
-        if (likely(has_reflection && has_transmission)) {
-            selected_r = sample1 <= F && active;
-            weight = 1.f;
-            /* For differentiable variants, lobe choice has to be detached to avoid bias.
-                Sampling weights should be computed accordingly. */
-            if constexpr (dr::is_diff_v<Float>) {
-                if (dr::grad_enabled(F)) {
-                    Float r_diff = dr::replace_grad(Float(1.f), F / dr::detach(F));
-                    Float t_diff = dr::replace_grad(Float(1.f), (1.f - F) / (1.f - dr::detach(F)));
-                    weight = dr::select(selected_r, r_diff, t_diff);
-                }
-            }
-            bs.pdf *= dr::detach(dr::select(selected_r, F, 1.f - F));
-        } else {
-            if (has_reflection || has_transmission) {
-                selected_r = Mask(has_reflection) && active;
-                weight = has_reflection ? F : (1.f - F);
-            } else {
-                return { bs, 0.f };
-            }
-        }
-
-        selected_t = !selected_r && active;
-
-        bs.eta               = dr::select(selected_r, Float(1.f), eta_it);
-        bs.sampled_component = dr::select(selected_r, UInt32(0), UInt32(1));
-        bs.sampled_type      = dr::select(selected_r,
-                                      UInt32(+BSDFFlags::GlossyReflection),
-                                      UInt32(+BSDFFlags::GlossyTransmission));
-
-        Float dwh_dwo = 0.f;
-
-        // Reflection sampling
-        if (dr::any_or<true>(selected_r)) {
-            // Perfect specular reflection based on the microfacet normal
-            bs.wo[selected_r] = reflect(si.wi, m);
-
-            if (m_specular_reflectance)
-                weight[selected_r] *= m_specular_reflectance->eval(si, selected_r);
-
-            // Jacobian of the half-direction mapping
-            dwh_dwo = dr::rcp(4.f * dr::dot(bs.wo, m));
-        }
+        active &= Frame3f::cos_theta(si.wi) != 0.f;
 
-        // Transmission sampling
-        if (dr::any_or<true>(selected_t)) {
-            // Perfect specular transmission based on the microfacet normal
-            bs.wo[selected_t]  = refract(si.wi, m, cos_theta_t, eta_ti);
+        auto [distr, sample_distr] = distributions(si, active);
+        auto [spec_r, spec_t] = shading_terms(ctx, si, active);
 
-            /* For transmission, radiance must be scaled to account for the solid
-               angle compression that occurs when crossing the interface. */
-            UnpolarizedSpectrum factor = (ctx.mode == TransportMode::Radiance) ? dr::square(eta_ti) : Float(1.f);
-
-            if (m_specular_transmittance)
-                factor *= m_specular_transmittance->eval(si, selected_t);
-
-            weight[selected_t] *= factor;
+        if (m_energy_compensation)
+            return sample_compensated(ctx, si, distr, sample_distr, spec_r,
+                                      spec_t, sample1, sample2, active);
 
-            // Jacobian of the half-direction mapping
-            dr::masked(dwh_dwo, selected_t) =
-                (dr::square(bs.eta) * dr::dot(bs.wo, m)) /
-                 dr::square(dr::dot(si.wi, m) + bs.eta * dr::dot(bs.wo, m));
-        }
-
-        if (likely(m_sample_visible))
-            weight *= distr.smith_g1(bs.wo, m);
-        else
-            weight *= distr.G(si.wi, bs.wo, m) * dr::dot(si.wi, m) /
-                      (cos_theta_i * Frame3f::cos_theta(m));
-
-        bs.pdf *= dr::abs(dwh_dwo);
-
-        return { bs, depolarizer<Spectrum>(weight) & active };
+        return sample_shared(ctx, si, distr, sample_distr, spec_r, spec_t,
+                             sample1, sample2, active);
     }
 
     Spectrum eval(const BSDFContext &ctx, const SurfaceInteraction3f &si,
@@ -427,6 +366,12 @@ public:
             result[eval_t] = value;
         }
 
+        if (m_energy_compensation) {
+            auto [spec_r, spec_t] = shading_terms(ctx, si, active);
+            result += std::get<0>(
+                eval_pdf_ms(ctx, si, wo, distr, spec_r, spec_t, active));
+        }
+
         return depolarizer<Spectrum>(result);
     }
 
@@ -448,6 +393,9 @@ public:
         active &= (Mask(has_reflection)   &&  reflect) ||
                   (Mask(has_transmission) && !reflect);
 
+        // The multiple scattering lobes are defined for all pairs of directions
+        Mask active_ms = active;
+
         // Determine the relative index of refraction
         Float eta = dr::select(cos_theta_i > 0.f, m_eta, m_inv_eta);
 
@@ -471,18 +419,7 @@ public:
 
         /* Construct the microfacet distribution matching the
            roughness values at the current surface position. */
-        MicrofacetDistribution sample_distr(
-            m_type,
-            m_alpha_u->eval_1(si, active),
-            m_alpha_v->eval_1(si, active),
-            m_sample_visible
-        );
-
-        /* Trick by Walter et al.: slightly scale the roughness values to
-           reduce importance sampling weights. Not needed for the
-           Heitz and D'Eon sampling technique. */
-        if (unlikely(!m_sample_visible))
-            sample_distr.scale_alpha(1.2f - .2f * dr::sqrt(dr::abs(Frame3f::cos_theta(si.wi))));
+        auto [distr, sample_distr] = distributions(si, active_ms);
 
         // Evaluate the microfacet model sampling density function
         Float prob = sample_distr.pdf(dr::mulsign(si.wi, Frame3f::cos_theta(si.wi)), m);
@@ -492,7 +429,16 @@ public:
             prob *= dr::select(reflect, F, 1.f - F);
         }
 
-        return dr::select(active, prob * dr::abs(dwh_dwo), 0.f);
+        Float result = dr::select(active, prob * dr::abs(dwh_dwo), 0.f);
+
+        if (m_energy_compensation) {
+            auto [value_ms, pdf_ms, prob_ms] =
+                eval_pdf_ms(ctx, si, wo, distr, 1.f, 1.f, active_ms);
+            DRJIT_MARK_USED(value_ms);
+            result = dr::fmadd(result, 1.f - prob_ms, pdf_ms);
+        }
+
+        return result;
     }
 
     std::pair<Spectrum, Float> eval_pdf(const BSDFContext &ctx,
@@ -501,11 +447,115 @@ public:
                                         Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::BSDFEvaluate, active);
 
-        Float cos_theta_i = Frame3f::cos_theta(si.wi),
-              cos_theta_o = Frame3f::cos_theta(wo);
+        // Ignore perfectly grazing configurations
+        active &= Frame3f::cos_theta(si.wi) != 0.f;
+
+        auto [distr, sample_distr] = distributions(si, active);
+        auto [spec_r, spec_t] = shading_terms(ctx, si, active);
+
+        return eval_pdf_shared(ctx, si, wo, distr, sample_distr, spec_r, spec_t,
+                               active);
+    }
+
+    std::tuple<Spectrum, Float, BSDFSample3f, Spectrum>
+    eval_pdf_sample(const BSDFContext &ctx,
+                    const SurfaceInteraction3f &si,
+                    const Vector3f &wo,
+                    Float sample1,
+                    const Point2f &sample2,
+                    Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::BSDFSample, active);
 
         // Ignore perfectly grazing configurations
-        active &= cos_theta_i != 0.f;
+        active &= Frame3f::cos_theta(si.wi) != 0.f;
+
+        /* The microfacet distributions and the texture lookups only depend on
+           'si' and are shared by the evaluation and the sampling */
+        auto [distr, sample_distr] = distributions(si, active);
+        auto [spec_r, spec_t] = shading_terms(ctx, si, active);
+
+        auto [value, pdf] = eval_pdf_shared(ctx, si, wo, distr, sample_distr,
+                                            spec_r, spec_t, active);
+        auto [bs, weight] =
+            m_energy_compensation
+                ? sample_compensated(ctx, si, distr, sample_distr, spec_r,
+                                     spec_t, sample1, sample2, active)
+                : sample_shared(ctx, si, distr, sample_distr, spec_r, spec_t,
+                                sample1, sample2, active);
+
+        return { value, pdf, bs, weight };
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "RoughDielectric[" << std::endl
+            << "  distribution = "           << m_type           << "," << std::endl
+            << "  sample_visible = "         << (int) m_sample_visible << "," << std::endl
+            << "  energy_compensation = "    << (int) m_energy_compensation << "," << std::endl;
+
+        if (!has_flag(m_flags, BSDFFlags::Anisotropic)) {
+            oss << "  alpha = "                  << string::indent(m_alpha_v) << "," << std::endl;
+        } else {
+            oss << "  alpha_u = "                << string::indent(m_alpha_u) << "," << std::endl
+                << "  alpha_v = "                << string::indent(m_alpha_v) << "," << std::endl;
+        }
+
+        if (m_specular_reflectance)
+            oss << "  specular_reflectance = "   << string::indent(m_specular_reflectance) << "," << std::endl;
+
+        if (m_specular_transmittance)
+            oss << "  specular_transmittance = " << string::indent(m_specular_transmittance) << ", " << std::endl;
+
+        oss << "  eta = "                    << m_eta << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+private:
+    /**
+     * \brief Construct the microfacet distribution matching the roughness
+     * values at the current surface position, along with the distribution
+     * used for sampling
+     */
+    std::pair<MicrofacetDistribution, MicrofacetDistribution>
+    distributions(const SurfaceInteraction3f &si, Mask active) const {
+        MicrofacetDistribution distr(m_type,
+                                     m_alpha_u->eval_1(si, active),
+                                     m_alpha_v->eval_1(si, active),
+                                     m_sample_visible);
+
+        /* Trick by Walter et al.: slightly scale the roughness values to
+           reduce importance sampling weights. Not needed for the
+           Heitz and D'Eon sampling technique. */
+        MicrofacetDistribution sample_distr(distr);
+        if (unlikely(!m_sample_visible))
+            sample_distr.scale_alpha(1.2f - .2f * dr::sqrt(dr::abs(Frame3f::cos_theta(si.wi))));
+
+        return { distr, sample_distr };
+    }
+
+    /// Look up the specular reflectance and transmittance of the enabled lobes
+    std::pair<UnpolarizedSpectrum, UnpolarizedSpectrum>
+    shading_terms(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                  Mask active) const {
+        UnpolarizedSpectrum spec_r(1.f), spec_t(1.f);
+        if (m_specular_reflectance && ctx.is_enabled(BSDFFlags::GlossyReflection, 0))
+            spec_r = m_specular_reflectance->eval(si, active);
+        if (m_specular_transmittance && ctx.is_enabled(BSDFFlags::GlossyTransmission, 1))
+            spec_t = m_specular_transmittance->eval(si, active);
+        return { spec_r, spec_t };
+    }
+
+    /// Evaluate the BSDF and its density for \c wo given the shading terms
+    std::pair<Spectrum, Float>
+    eval_pdf_shared(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                    const Vector3f &wo, const MicrofacetDistribution &distr,
+                    const MicrofacetDistribution &sample_distr,
+                    const UnpolarizedSpectrum &spec_r,
+                    const UnpolarizedSpectrum &spec_t, Mask active) const {
+        Float cos_theta_i = Frame3f::cos_theta(si.wi),
+              cos_theta_o = Frame3f::cos_theta(wo);
 
         // Determine the type of interaction
         bool has_reflection   = ctx.is_enabled(BSDFFlags::GlossyReflection, 0),
@@ -516,6 +566,9 @@ public:
         active &= (Mask(has_reflection)   &&  reflect) ||
                   (Mask(has_transmission) && !reflect);
 
+        // The multiple scattering lobes are defined for all pairs of directions
+        Mask active_ms = active;
+
         // Determine the relative index of refraction
         Float eta     = dr::select(cos_theta_i > 0.f, m_eta, m_inv_eta),
               inv_eta = dr::select(cos_theta_i > 0.f, m_inv_eta, m_eta);
@@ -536,13 +589,6 @@ public:
         active &= dot_wi_m * cos_theta_i > 0.f &&
                   dot_wo_m * cos_theta_o > 0.f;
 
-        /* Construct the microfacet distribution matching the
-           roughness values at the current surface position. */
-        MicrofacetDistribution distr(m_type,
-                                     m_alpha_u->eval_1(si, active),
-                                     m_alpha_v->eval_1(si, active),
-                                     m_sample_visible);
-
         // Evaluate the microfacet normal distribution
         Float D = distr.eval(m);
 
@@ -561,7 +607,7 @@ public:
             UnpolarizedSpectrum value = F * D * G / (4.f * dr::abs(cos_theta_i));
 
             if (m_specular_reflectance)
-                value *= m_specular_reflectance->eval(si, eval_r);
+                value *= spec_r;
 
             result[eval_r] = value;
         }
@@ -578,19 +624,13 @@ public:
                 (cos_theta_i * dr::square(dot_wi_m + eta * dot_wo_m)));
 
             if (m_specular_transmittance)
-                value *= m_specular_transmittance->eval(si, eval_t);
+                value *= spec_t;
 
             result[eval_t] = value;
         }
 
-        /* Trick by Walter et al.: slightly scale the roughness values to
-           reduce importance sampling weights. Not needed for the
-           Heitz and D'Eon sampling technique. */
-        if (unlikely(!m_sample_visible))
-            distr.scale_alpha(1.2f - .2f * dr::sqrt(dr::abs(cos_theta_i)));
-
         // Evaluate the microfacet model sampling density function
-        Float pdf = distr.pdf(dr::mulsign(si.wi, cos_theta_i), m);
+        Float pdf = sample_distr.pdf(dr::mulsign(si.wi, cos_theta_i), m);
 
         if (likely(has_transmission && has_reflection))
             pdf *= dr::select(reflect, F, 1.f - F);
@@ -600,42 +640,363 @@ public:
                                    (eta * eta * dot_wo_m) /
                                        dr::square(dot_wi_m + eta * dot_wo_m));
 
-        return { depolarizer<Spectrum>(result),
-                 dr::select(active, pdf * dr::abs(dwh_dwo), 0.f) };
+        pdf = dr::select(active, pdf * dr::abs(dwh_dwo), 0.f);
+
+        if (m_energy_compensation) {
+            auto [value_ms, pdf_ms, prob_ms] =
+                eval_pdf_ms(ctx, si, wo, distr, spec_r, spec_t, active_ms);
+            result += value_ms;
+            pdf = dr::fmadd(pdf, 1.f - prob_ms, pdf_ms);
+        }
+
+        return { depolarizer<Spectrum>(result), pdf };
     }
 
-    std::string to_string() const override {
-        std::ostringstream oss;
-        oss << "RoughDielectric[" << std::endl
-            << "  distribution = "           << m_type           << "," << std::endl
-            << "  sample_visible = "         << (int) m_sample_visible << "," << std::endl;
+    /// Sample the BSDF given the shading terms
+    std::pair<BSDFSample3f, Spectrum>
+    sample_shared(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                  const MicrofacetDistribution &distr,
+                  const MicrofacetDistribution &sample_distr,
+                  const UnpolarizedSpectrum &spec_r,
+                  const UnpolarizedSpectrum &spec_t, Float sample1,
+                  const Point2f &sample2, Mask active) const {
+        // Determine the type of interaction
+        bool has_reflection    = ctx.is_enabled(BSDFFlags::GlossyReflection, 0),
+             has_transmission  = ctx.is_enabled(BSDFFlags::GlossyTransmission, 1);
 
-        if (!has_flag(m_flags, BSDFFlags::Anisotropic)) {
-            oss << "  alpha = "                  << string::indent(m_alpha_v) << "," << std::endl;
+        BSDFSample3f bs = dr::zeros<BSDFSample3f>();
+
+        Float cos_theta_i = Frame3f::cos_theta(si.wi);
+
+        // Sample the microfacet normal
+        Normal3f m;
+        std::tie(m, bs.pdf) =
+            sample_distr.sample(dr::mulsign(si.wi, cos_theta_i), sample2);
+        active &= bs.pdf != 0.f;
+
+        auto [F, cos_theta_t, eta_it, eta_ti] =
+            fresnel(dr::dot(si.wi, m), m_eta);
+
+        // Select the lobe to be sampled
+        UnpolarizedSpectrum weight;
+        Mask selected_r, selected_t;
+        if (likely(has_reflection && has_transmission)) {
+            selected_r = sample1 <= F && active;
+            weight = 1.f;
+            /* For differentiable variants, lobe choice has to be detached to avoid bias.
+                Sampling weights should be computed accordingly. */
+            if constexpr (dr::is_diff_v<Float>) {
+                if (dr::grad_enabled(F)) {
+                    Float r_diff = dr::replace_grad(Float(1.f), F / dr::detach(F));
+                    Float t_diff = dr::replace_grad(Float(1.f), (1.f - F) / (1.f - dr::detach(F)));
+                    weight = dr::select(selected_r, r_diff, t_diff);
+                }
+            }
+            bs.pdf *= dr::detach(dr::select(selected_r, F, 1.f - F));
         } else {
-            oss << "  alpha_u = "                << string::indent(m_alpha_u) << "," << std::endl
-                << "  alpha_v = "                << string::indent(m_alpha_v) << "," << std::endl;
+            if (has_reflection || has_transmission) {
+                selected_r = Mask(has_reflection) && active;
+                weight = has_reflection ? F : (1.f - F);
+            } else {
+                return { bs, 0.f };
+            }
         }
 
-        if (m_specular_reflectance)
-            oss << "  specular_reflectance = "   << string::indent(m_specular_reflectance) << "," << std::endl;
+        selected_t = !selected_r && active;
 
-        if (m_specular_transmittance)
-            oss << "  specular_transmittance = " << string::indent(m_specular_transmittance) << ", " << std::endl;
+        bs.eta               = dr::select(selected_r, Float(1.f), eta_it);
+        bs.sampled_component = dr::select(selected_r, UInt32(0), UInt32(1));
+        bs.sampled_type      = dr::select(selected_r,
+                                      UInt32(+BSDFFlags::GlossyReflection),
+                                      UInt32(+BSDFFlags::GlossyTransmission));
 
-        oss << "  eta = "                    << m_eta << std::endl
-            << "]";
-        return oss.str();
+        Float dwh_dwo = 0.f;
+
+        // Reflection sampling
+        if (dr::any_or<true>(selected_r)) {
+            // Perfect specular reflection based on the microfacet normal
+            bs.wo[selected_r] = reflect(si.wi, m);
+
+            if (m_specular_reflectance)
+                weight[selected_r] *= spec_r;
+
+            // Jacobian of the half-direction mapping
+            dwh_dwo = dr::rcp(4.f * dr::dot(bs.wo, m));
+        }
+
+        // Transmission sampling
+        if (dr::any_or<true>(selected_t)) {
+            // Perfect specular transmission based on the microfacet normal
+            bs.wo[selected_t]  = refract(si.wi, m, cos_theta_t, eta_ti);
+
+            /* For transmission, radiance must be scaled to account for the solid
+               angle compression that occurs when crossing the interface. */
+            UnpolarizedSpectrum factor = (ctx.mode == TransportMode::Radiance) ? dr::square(eta_ti) : Float(1.f);
+
+            if (m_specular_transmittance)
+                factor *= spec_t;
+
+            weight[selected_t] *= factor;
+
+            // Jacobian of the half-direction mapping
+            dr::masked(dwh_dwo, selected_t) =
+                (dr::square(bs.eta) * dr::dot(bs.wo, m)) /
+                 dr::square(dr::dot(si.wi, m) + bs.eta * dr::dot(bs.wo, m));
+        }
+
+        if (likely(m_sample_visible))
+            weight *= distr.smith_g1(bs.wo, m);
+        else
+            weight *= distr.G(si.wi, bs.wo, m) * dr::dot(si.wi, m) /
+                      (cos_theta_i * Frame3f::cos_theta(m));
+
+        bs.pdf *= dr::abs(dwh_dwo);
+
+        return { bs, depolarizer<Spectrum>(weight) & active };
+    }
+
+    /**
+     * \brief Return the albedo tables of a microfacet distribution for a
+     * relative index of refraction, which are computed on first use
+     *
+     * The tables of the exterior side (relative index \c eta) are followed
+     * by the ones of the interior side (relative index <tt>1 / eta</tt>).
+     * Each side holds a table of the reflection, followed by one of the
+     * transmission. Each table stores the directional albedo without
+     * radiance scaling over a regular grid of the cosine of the elevation
+     * (fastest varying) and of the roughness in <tt>[0, 1]</tt>, followed by
+     * the hemispherical average of the albedo for each roughness value.
+     */
+    static const std::vector<ScalarFloat> &albedo_table(MicrofacetType type,
+                                                        ScalarFloat eta) {
+        static std::mutex mutex;
+        static std::map<std::pair<int, ScalarFloat>, std::vector<ScalarFloat>> tables;
+
+        std::lock_guard<std::mutex> guard(mutex);
+        std::vector<ScalarFloat> &table = tables[{ (int) type, eta }];
+        if (!table.empty())
+            return table;
+
+        using FloatX = DynamicBuffer<ScalarFloat>;
+        using Vector3fX = Vector<FloatX, 3>;
+        using FloatP = dr::Packet<dr::scalar_t<Float>>;
+
+        const size_t res = MI_ROUGH_ALBEDO_RES, size = res * res + res;
+        FloatX mu = dr::maximum(1e-6f, dr::linspace<FloatX>(0, 1, res));
+        Vector3fX wi = Vector3fX(dr::sqrt(1 - mu * mu), dr::zeros<FloatX>(res), mu);
+
+        table.resize(4 * size);
+        for (size_t side = 0; side < 2; ++side) {
+            ScalarFloat eta_side = side == 0 ? eta : 1.f / eta;
+            ScalarFloat *table_r = table.data() + 2 * side * size,
+                        *table_t = table_r + size;
+
+            for (size_t i = 0; i < res; ++i) {
+                ScalarFloat alpha = dr::maximum(1e-3f, ScalarFloat(i) / (res - 1));
+                mitsuba::MicrofacetDistribution<FloatP, Spectrum> distr(type, alpha);
+                FloatX albedo_r = eval_reflectance(distr, wi, eta_side),
+                       albedo_t = eval_transmittance(distr, wi, eta_side);
+
+                // The quadrature may slightly overestimate the total albedo
+                FloatX scale = dr::minimum(
+                    1.f, dr::rcp(dr::maximum(albedo_r + albedo_t, 1e-6f)));
+                albedo_r *= scale;
+                albedo_t *= scale;
+
+                std::copy(albedo_r.data(), albedo_r.data() + res, table_r + i * res);
+                std::copy(albedo_t.data(), albedo_t.data() + res, table_t + i * res);
+                table_r[res * res + i] =
+                    dr::minimum(dr::mean(albedo_r * mu) * 2.f, ScalarFloat(1.f));
+                table_t[res * res + i] =
+                    dr::minimum(dr::mean(albedo_t * mu) * 2.f, ScalarFloat(1.f));
+            }
+        }
+
+        return table;
+    }
+
+    /**
+     * \brief Bilinearly interpolate the albedo table of the reflection
+     * (<tt>lobe == 0</tt>) or transmission (<tt>lobe == 1</tt>) on the given
+     * side of the interface (0: exterior, 1: interior)
+     */
+    Float lerp_albedo(const Float &mu, const Float &alpha, const UInt32 &side,
+                      uint32_t lobe, bool average, Mask active) const {
+        const uint32_t res = MI_ROUGH_ALBEDO_RES, size = res * res + res;
+        UInt32 base = (side * 2u + lobe) * size;
+        Float x = dr::clip(mu, 0.f, 1.f) * (res - 1),
+              y = dr::clip(alpha, 0.f, 1.f) * (res - 1);
+        UInt32 i = dr::minimum(UInt32(x), res - 2),
+               j = dr::minimum(UInt32(y), res - 2);
+        Float fy = y - Float(j);
+
+        if (average) {
+            UInt32 index = base + res * res + j;
+            return dr::lerp(dr::gather<Float>(m_albedo, index, active),
+                            dr::gather<Float>(m_albedo, index + 1, active), fy);
+        }
+
+        Float fx = x - Float(i);
+        UInt32 index = base + j * res + i;
+        Float v00 = dr::gather<Float>(m_albedo, index, active),
+              v10 = dr::gather<Float>(m_albedo, index + 1, active),
+              v01 = dr::gather<Float>(m_albedo, index + res, active),
+              v11 = dr::gather<Float>(m_albedo, index + res + 1, active);
+
+        return dr::lerp(dr::lerp(v00, v10, fx), dr::lerp(v01, v11, fx), fy);
+    }
+
+    /// Roughness used to query the albedo tables
+    Float albedo_roughness(const MicrofacetDistribution &distr) const {
+        return dr::sqrt(distr.alpha_u() * distr.alpha_v());
+    }
+
+    /**
+     * \brief Compute the energy that the single scattering model loses for
+     * light arriving from \c si.wi, the fraction of it that is reflected by
+     * the multiple scattering lobes, and the probability of sampling the
+     * reflection among the enabled multiple scattering lobes
+     */
+    std::tuple<Float, Float, Float> ms_terms(const BSDFContext &ctx,
+                                             const SurfaceInteraction3f &si,
+                                             const MicrofacetDistribution &distr,
+                                             Mask active) const {
+        bool has_reflection   = ctx.is_enabled(BSDFFlags::GlossyReflection, 0),
+             has_transmission = ctx.is_enabled(BSDFFlags::GlossyTransmission, 1);
+        if (!has_reflection && !has_transmission)
+            return { 0.f, 0.f, 0.f };
+
+        Float cos_theta_i = Frame3f::cos_theta(si.wi),
+              mu_i        = dr::abs(cos_theta_i),
+              alpha       = albedo_roughness(distr);
+        UInt32 side = dr::select(cos_theta_i > 0.f, UInt32(0), UInt32(1));
+
+        Float e_i   = lerp_albedo(mu_i, alpha, side, 0, false, active) +
+                      lerp_albedo(mu_i, alpha, side, 1, false, active),
+              avg_r = lerp_albedo(0.f, alpha, side, 0, true, active),
+              avg_t = lerp_albedo(0.f, alpha, side, 1, true, active);
+
+        Float loss   = dr::clip(1.f - e_i, 0.f, 1.f),
+              frac_r = avg_r / dr::maximum(avg_r + avg_t, 1e-6f),
+              prob_r = has_reflection ? (has_transmission ? frac_r : Float(1.f))
+                                      : Float(0.f);
+
+        return { dr::select(active, loss, 0.f), frac_r, prob_r };
+    }
+
+    /**
+     * \brief Evaluate the multiple scattering lobes (including the cosine
+     * foreshortening factor) and their sampling density
+     *
+     * Returns the value, the density of the lobes weighted by the
+     * probability of sampling them, and that probability.
+     */
+    std::tuple<UnpolarizedSpectrum, Float, Float>
+    eval_pdf_ms(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                const Vector3f &wo, const MicrofacetDistribution &distr,
+                const UnpolarizedSpectrum &spec_r,
+                const UnpolarizedSpectrum &spec_t, Mask active) const {
+        auto [prob, frac_r, prob_r] = ms_terms(ctx, si, distr, active);
+
+        Float cos_theta_i = Frame3f::cos_theta(si.wi),
+              cos_theta_o = Frame3f::cos_theta(wo),
+              mu_o        = dr::abs(cos_theta_o),
+              alpha       = albedo_roughness(distr);
+
+        bool has_reflection   = ctx.is_enabled(BSDFFlags::GlossyReflection, 0),
+             has_transmission = ctx.is_enabled(BSDFFlags::GlossyTransmission, 1);
+
+        Mask reflect = cos_theta_i * cos_theta_o > 0.f;
+        active &= cos_theta_o != 0.f &&
+                  ((Mask(has_reflection)   &&  reflect) ||
+                   (Mask(has_transmission) && !reflect));
+
+        // Reflected light stays on the side of 'wi', transmitted light doesn't
+        UInt32 side_i = dr::select(cos_theta_i > 0.f, UInt32(0), UInt32(1)),
+               side_o = dr::select(reflect, side_i, 1u - side_i);
+
+        Float e_o   = lerp_albedo(mu_o, alpha, side_o, 0, false, active) +
+                      lerp_albedo(mu_o, alpha, side_o, 1, false, active),
+              e_avg = lerp_albedo(0.f, alpha, side_o, 0, true, active) +
+                      lerp_albedo(0.f, alpha, side_o, 1, true, active);
+
+        // Normalized such that the lobes scatter all of the lost energy
+        Float lobe = prob * dr::maximum(1.f - e_o, 0.f) * mu_o /
+                     (dr::Pi<Float> * dr::maximum(1.f - e_avg, 1e-4f));
+
+        /* Account for the solid angle compression when tracing radiance, like
+           the single scattering transmission */
+        Float inv_eta = dr::select(cos_theta_i > 0.f, m_inv_eta, m_eta),
+              scale   = (ctx.mode == TransportMode::Radiance) ? dr::square(inv_eta)
+                                                              : Float(1.f);
+
+        UnpolarizedSpectrum value =
+            dr::select(reflect, frac_r * lobe * spec_r,
+                       (1.f - frac_r) * scale * lobe * spec_t);
+        Float pdf = prob * dr::select(reflect, prob_r, 1.f - prob_r) * mu_o *
+                    dr::InvPi<Float>;
+
+        return { dr::select(active, value, 0.f), dr::select(active, pdf, 0.f),
+                 prob };
+    }
+
+    /// Sample the single scattering model or the multiple scattering lobes
+    std::pair<BSDFSample3f, Spectrum>
+    sample_compensated(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                       const MicrofacetDistribution &distr,
+                       const MicrofacetDistribution &sample_distr,
+                       const UnpolarizedSpectrum &spec_r,
+                       const UnpolarizedSpectrum &spec_t, Float sample1,
+                       const Point2f &sample2, Mask active) const {
+        auto [prob, frac_r, prob_r] = ms_terms(ctx, si, distr, active);
+        DRJIT_MARK_USED(frac_r);
+
+        // Reuse the 1D sample to choose the lobe of the selected model
+        Mask sample_ms = active && sample1 < prob;
+        sample1 = dr::minimum(
+            dr::select(sample_ms, sample1 / prob, (sample1 - prob) / (1.f - prob)),
+            dr::OneMinusEpsilon<Float>);
+
+        auto [bs, weight] = sample_shared(ctx, si, distr, sample_distr, spec_r,
+                                          spec_t, sample1, sample2,
+                                          active && !sample_ms);
+        DRJIT_MARK_USED(weight);
+
+        // Cosine-weighted direction on the side of the chosen lobe
+        Float cos_theta_i = Frame3f::cos_theta(si.wi);
+        Mask ms_r = sample1 < prob_r;
+        Vector3f wo = warp::square_to_cosine_hemisphere(sample2);
+        wo.z() = dr::mulsign(wo.z(), dr::select(ms_r, cos_theta_i, -cos_theta_i));
+
+        dr::masked(bs.wo, sample_ms)  = wo;
+        dr::masked(bs.eta, sample_ms) = dr::select(
+            ms_r, Float(1.f), dr::select(cos_theta_i > 0.f, m_eta, m_inv_eta));
+        dr::masked(bs.sampled_component, sample_ms) =
+            dr::select(ms_r, UInt32(0), UInt32(1));
+        dr::masked(bs.sampled_type, sample_ms) =
+            dr::select(ms_r, UInt32(+BSDFFlags::GlossyReflection),
+                       UInt32(+BSDFFlags::GlossyTransmission));
+        active &= sample_ms || bs.pdf > 0.f;
+
+        // The weight accounts for all the lobes that could have sampled 'wo'
+        auto [value, pdf] = eval_pdf_shared(ctx, si, bs.wo, distr, sample_distr,
+                                            spec_r, spec_t, active);
+        bs.pdf = pdf;
+        active &= pdf > 0.f;
+
+        return { bs, (value / pdf) & active };
     }
 
-    MI_DECLARE_CLASS()
-private:
     ref<Texture> m_specular_reflectance;
     ref<Texture> m_specular_transmittance;
     MicrofacetType m_type;
     ref<Texture> m_alpha_u, m_alpha_v;
     Float m_eta, m_inv_eta;
     bool m_sample_visible;
+    /// Add the multiple scattering lobes?
+    bool m_energy_compensation;
+    /// Albedo tables for the index of refraction (see \ref albedo_table())
+    DynamicBuffer<Float> m_albedo;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(RoughDielectric, BSDF)
@@ -200,7 +200,7 @@ public:
 
         m_components.push_back(BSDFFlags::GlossyReflection | BSDFFlags::FrontSide);
         m_components.push_back(BSDFFlags::DiffuseReflection | BSDFFlags::FrontSide);
-        m_flags =  m_components[0] | m_components[1];
+        m_flags = m_components[0] | m_components[1] | BSDFFlags::Depolarizing;
 
         parameters_changed();
     }
@@ -441,7 +441,108 @@ public:
         Float t_i = lerp_gather(m_external_transmittance, cos_theta_i,
                                 MI_ROUGH_TRANSMITTANCE_RES, active);
 
-        // Determine which component should be sampled
+        auto [prob_specular, prob_diffuse] =
+            lobe_probabilities(t_i, has_specular, has_diffuse);
+
+        MicrofacetDistribution distr(m_type, m_alpha, m_sample_visible);
+        auto [spec, diff] = shading_terms(si, t_i, has_specular, has_diffuse, active);
+
+        return eval_pdf_shared(si, wo, distr, prob_specular, prob_diffuse,
+                               spec, diff, has_specular, has_diffuse, active);
+    }
+
+    std::tuple<Spectrum, Float, BSDFSample3f, Spectrum>
+    eval_pdf_sample(const BSDFContext &ctx,
+                    const SurfaceInteraction3f &si,
+                    const Vector3f &wo,
+                    Float sample1,
+                    const Point2f &sample2,
+                    Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::BSDFSample, active);
+
+        bool has_specular = ctx.is_enabled(BSDFFlags::GlossyReflection, 0),
+             has_diffuse  = ctx.is_enabled(BSDFFlags::DiffuseReflection, 1);
+
+        Float cos_theta_i = Frame3f::cos_theta(si.wi);
+        active &= cos_theta_i > 0.f;
+
+        BSDFSample3f bs = dr::zeros<BSDFSample3f>();
+        if (unlikely((!has_specular && !has_diffuse) || dr::none_or<false>(active)))
+            return { 0.f, 0.f, bs, 0.f };
+
+        /* The transmittance, the lobe probabilities, the microfacet
+           distribution and the texture lookups only depend on 'si' and are
+           shared by the evaluation of 'wo' and of the sampled direction */
+        Float t_i = lerp_gather(m_external_transmittance, cos_theta_i,
+                                MI_ROUGH_TRANSMITTANCE_RES, active);
+
+        auto [prob_specular, prob_diffuse] =
+            lobe_probabilities(t_i, has_specular, has_diffuse);
+
+        MicrofacetDistribution distr(m_type, m_alpha, m_sample_visible);
+        auto [spec, diff] = shading_terms(si, t_i, has_specular, has_diffuse, active);
+
+        auto [value, pdf] =
+            eval_pdf_shared(si, wo, distr, prob_specular, prob_diffuse, spec,
+                            diff, has_specular, has_diffuse, active);
+
+        Mask sample_specular = active && (sample1 < prob_specular),
+             sample_diffuse = active && !sample_specular;
+
+        bs.eta = 1.f;
+
+        if (dr::any_or<true>(sample_specular)) {
+            Normal3f m = std::get<0>(distr.sample(si.wi, sample2));
+
+            dr::masked(bs.wo, sample_specular) = reflect(si.wi, m);
+            dr::masked(bs.sampled_component, sample_specular) = 0;
+            dr::masked(bs.sampled_type, sample_specular) = +BSDFFlags::GlossyReflection;
+        }
+
+        if (dr::any_or<true>(sample_diffuse)) {
+            dr::masked(bs.wo, sample_diffuse) = warp::square_to_cosine_hemisphere(sample2);
+            dr::masked(bs.sampled_component, sample_diffuse) = 1;
+            dr::masked(bs.sampled_type, sample_diffuse) = +BSDFFlags::DiffuseReflection;
+        }
+
+        auto [bs_value, bs_pdf] =
+            eval_pdf_shared(si, bs.wo, distr, prob_specular, prob_diffuse,
+                            spec, diff, has_specular, has_diffuse, active);
+        bs.pdf = bs_pdf;
+        Mask active_s = active && bs.pdf > 0.f;
+
+        return { value, pdf, bs, (bs_value / bs.pdf) & active_s };
+    }
+
+    Spectrum eval_diffuse_reflectance(const SurfaceInteraction3f &si,
+                                      Mask active) const override {
+        return m_diffuse_reflectance->eval(si, active);
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "RoughPlastic[" << std::endl
+            << "  distribution = " << m_type << "," << std::endl
+            << "  sample_visible = "           << m_sample_visible                    << "," << std::endl
+            << "  alpha = "                    << m_alpha                             << "," << std::endl
+            << "  diffuse_reflectance = "      << m_diffuse_reflectance               << "," << std::endl;
+
+        if (m_specular_reflectance)
+            oss << "  specular_reflectance = "     << m_specular_reflectance              << "," << std::endl;
+
+        oss << "  specular_sampling_weight = " << m_specular_sampling_weight          << "," << std::endl
+            << "  eta = "                      << m_eta                               << "," << std::endl
+            << "  nonlinear = "                << m_nonlinear                         << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+private:
+    /// Probabilities of sampling the specular and diffuse lobes
+    std::pair<Float, Float> lobe_probabilities(const Float &t_i,
+                                               bool has_specular,
+                                               bool has_diffuse) const {
         Float prob_specular = (1.f - t_i) * m_specular_sampling_weight,
               prob_diffuse  = t_i * (1.f - m_specular_sampling_weight);
 
@@ -449,13 +550,51 @@ public:
             prob_specular = has_specular ? 1.f : 0.f;
         else
             prob_specular = prob_specular / (prob_specular + prob_diffuse);
-        prob_diffuse = 1.f - prob_specular;
+
+        return { prob_specular, 1.f - prob_specular };
+    }
+
+    /**
+     * \brief Look up the textures of the specular and diffuse lobes
+     *
+     * The diffuse term already accounts for the internal scattering, the
+     * relative index of refraction and the transmittance \c t_i along
+     * <tt>si.wi</tt>.
+     */
+    std::pair<UnpolarizedSpectrum, UnpolarizedSpectrum>
+    shading_terms(const SurfaceInteraction3f &si, const Float &t_i,
+                  bool has_specular, bool has_diffuse, Mask active) const {
+        UnpolarizedSpectrum spec(1.f), diff(0.f);
+
+        if (has_specular && m_specular_reflectance)
+            spec = m_specular_reflectance->eval(si, active);
+
+        if (has_diffuse) {
+            diff = m_diffuse_reflectance->eval(si, active);
+            diff /= 1.f - (m_nonlinear ? (diff * m_internal_reflectance)
+                                       : UnpolarizedSpectrum(m_internal_reflectance));
+            diff *= m_inv_eta_2 * t_i;
+        }
+
+        return { spec, diff };
+    }
+
+    /// Evaluate the BSDF and its density for \c wo given the shading terms
+    std::pair<Spectrum, Float>
+    eval_pdf_shared(const SurfaceInteraction3f &si, const Vector3f &wo,
+                    const MicrofacetDistribution &distr,
+                    const Float &prob_specular, const Float &prob_diffuse,
+                    const UnpolarizedSpectrum &spec,
+                    const UnpolarizedSpectrum &diff, bool has_specular,
+                    bool has_diffuse, Mask active) const {
+        Float cos_theta_i = Frame3f::cos_theta(si.wi),
+              cos_theta_o = Frame3f::cos_theta(wo);
+
+        active &= cos_theta_o > 0.f;
 
         // Calculate the reflection half-vector
         Vector3f H = dr::normalize(wo + si.wi);
 
-        MicrofacetDistribution distr(m_type, m_alpha, m_sample_visible);
-
         // Evaluate the microfacet normal distribution
         Float D = distr.eval(H);
 
@@ -480,51 +619,19 @@ public:
             Float G = distr.smith_g1(wo, H) * smith_g1_wi;
 
             // Calculate the specular reflection component
-            value = F * D * G / (4.f * cos_theta_i);
-
-            if (m_specular_reflectance)
-                value *= m_specular_reflectance->eval(si, active);
+            value = spec * (F * D * G / (4.f * cos_theta_i));
         }
 
         if (has_diffuse) {
             Float t_o = lerp_gather(m_external_transmittance, cos_theta_o,
                                     MI_ROUGH_TRANSMITTANCE_RES, active);
 
-            UnpolarizedSpectrum diff = m_diffuse_reflectance->eval(si, active);
-            diff /= 1.f - (m_nonlinear ? (diff * m_internal_reflectance)
-                                       : UnpolarizedSpectrum(m_internal_reflectance));
-
-            value += diff * (dr::InvPi<Float> * m_inv_eta_2 * cos_theta_o * t_i * t_o);
+            value += diff * (dr::InvPi<Float> * cos_theta_o * t_o);
         }
 
         return { depolarizer<Spectrum>(value) & active, pdf };
     }
 
-    Spectrum eval_diffuse_reflectance(const SurfaceInteraction3f &si,
-                                      Mask active) const override {
-        return m_diffuse_reflectance->eval(si, active);
-    }
-
-    std::string to_string() const override {
-        std::ostringstream oss;
-        oss << "RoughPlastic[" << std::endl
-            << "  distribution = " << m_type << "," << std::endl
-            << "  sample_visible = "           << m_sample_visible                    << "," << std::endl
-            << "  alpha = "                    << m_alpha                             << "," << std::endl
-            << "  diffuse_reflectance = "      << m_diffuse_reflectance               << "," << std::endl;
-
-        if (m_specular_reflectance)
-            oss << "  specular_reflectance = "     << m_specular_reflectance              << "," << std::endl;
-
-        oss << "  specular_sampling_weight = " << m_specular_sampling_weight          << "," << std::endl
-            << "  eta = "                      << m_eta                               << "," << std::endl
-            << "  nonlinear = "                << m_nonlinear                         << std::endl
-            << "]";
-        return oss.str();
-    }
-
-    MI_DECLARE_CLASS()
-private:
     ref<Texture> m_diffuse_reflectance;
     ref<Texture> m_specular_reflectance;
     MicrofacetType m_type;
@@ -14,7 +14,7 @@ def test01_create(variant_scalar_rgb):
     assert bsdf.component_count() == 2
     assert bsdf.flags(0) == mi.BSDFFlags.DiffuseReflection | mi.BSDFFlags.FrontSide
     assert bsdf.flags(1) == mi.BSDFFlags.DiffuseReflection | mi.BSDFFlags.FrontSide
-    assert bsdf.flags() == bsdf.flags(0) | bsdf.flags(1)
+    assert bsdf.flags() == bsdf.flags(0) | bsdf.flags(1) | mi.BSDFFlags.Depolarizing
 
     bsdf = mi.load_dict({
         'type': 'blendbsdf',
@@ -184,3 +184,44 @@ def test05_sample_components(variant_scalar_rgb):
     expected_b = weight*1.0    # InvPi will cancel out with sampling pdf, but still need to apply weight
     bs_b, weight_b = bsdf.sample(ctx, si, 0.3, [0.5, 0.5])
     assert dr.allclose(weight_b, expected_b)
+
+
+def test06_stochastic(variants_vec_backends_once_rgb):
+    def blend(stochastic):
+        return mi.load_dict({
+            'type': 'blendbsdf',
+            'weight': 0.3,
+            'stochastic': stochastic,
+            'nested1': {
+                'type': 'blendbsdf',
+                'weight': 0.6,
+                'stochastic': stochastic,
+                'nested1': {'type': 'diffuse', 'reflectance': 0.2},
+                'nested2': {'type': 'roughconductor', 'alpha': 0.3}
+            },
+            'nested2': {'type': 'diffuse', 'reflectance': 0.9}
+        })
+
+    bsdf, bsdf_ref = blend(True), blend(False)
+
+    n = 100000
+    rng = mi.PCG32(size=n)
+    si = dr.zeros(mi.SurfaceInteraction3f, n)
+    si.p = mi.Point3f(rng.next_float32(), rng.next_float32(), 0)
+    si.n = mi.Normal3f(0, 0, 1)
+    si.sh_frame = mi.Frame3f(si.n)
+    si.wi = mi.warp.square_to_cosine_hemisphere(
+        mi.Point2f(rng.next_float32(), rng.next_float32()))
+    wo = mi.warp.square_to_cosine_hemisphere(
+        mi.Point2f(rng.next_float32(), rng.next_float32()))
+    ctx = mi.BSDFContext()
+
+    # The value and density of a direction refer to the same nested BSDF
+    value, pdf = bsdf.eval_pdf(ctx, si, wo)
+    assert dr.allclose(value, bsdf.eval(ctx, si, wo))
+    assert dr.allclose(pdf, bsdf.pdf(ctx, si, wo))
+
+    # ... and are unbiased estimates of the blend
+    value_ref, pdf_ref = bsdf_ref.eval_pdf(ctx, si, wo)
+    assert dr.allclose(dr.mean(value), dr.mean(value_ref), rtol=2e-2)
+    assert dr.allclose(dr.mean(pdf), dr.mean(pdf_ref), rtol=2e-2)
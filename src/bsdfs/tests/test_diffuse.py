@@ -7,7 +7,7 @@ def test01_create(variant_scalar_rgb):
     assert b is not None
     assert b.component_count() == 1
     assert b.flags(0) == mi.BSDFFlags.DiffuseReflection | mi.BSDFFlags.FrontSide
-    assert b.flags() == b.flags(0)
+    assert b.flags() == b.flags(0) | mi.BSDFFlags.Depolarizing
 
 
 def test02_eval_pdf(variant_scalar_rgb):
@@ -11,7 +11,7 @@ def test01_create(variants_all):
             mi.BSDFFlags.Anisotropic | mi.BSDFFlags.NonSymmetric
     )
     assert b.flags(1) == (mi.BSDFFlags.Null | mi.BSDFFlags.BackSide)
-    assert b.flags() == (b.flags(0) | b.flags(1))
+    assert b.flags() == (b.flags(0) | b.flags(1) | mi.BSDFFlags.Depolarizing)
 
 
 def test02_white_furnace(variants_vec_backends_once_rgb):
@@ -189,3 +189,60 @@ def test06_chi2(variants_vec_backends_once_rgb):
                         )
 
                         assert chi2.run()
+
+
+def test07_tabulated_eval(variants_vec_backends_once_rgb):
+    total = int(1e5)
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(seed=0, wavefront_size=total)
+
+    si    = mi.SurfaceInteraction3f()
+    si.p  = [0, 0, 0]
+    si.n  = [0, 0, 1]
+    si.wi = mi.warp.square_to_uniform_sphere(sampler.next_2d())
+    si.sh_frame = mi.Frame3f(si.n)
+    wo = mi.warp.square_to_uniform_sphere(sampler.next_2d())
+
+    ctx = mi.BSDFContext()
+
+    desc = {
+        'type': 'hair',
+        'longitudinal_roughness': 0.5,
+        'azimuthal_roughness': 0.5,
+    }
+    analytic = mi.load_dict(desc)
+    tabulated = mi.load_dict(dict(desc, tabulated=True))
+
+    # The tables only approximate the analytic model
+    value_ref, pdf_ref = analytic.eval_pdf(ctx, si, wo)
+    value, pdf = tabulated.eval_pdf(ctx, si, wo)
+    assert dr.allclose(dr.mean(value, axis=None), dr.mean(value_ref, axis=None), rtol=1e-2)
+    assert dr.allclose(dr.mean(pdf), dr.mean(pdf_ref), rtol=1e-2)
+
+    assert dr.allclose(value, tabulated.eval(ctx, si, wo))
+    assert dr.allclose(pdf, tabulated.pdf(ctx, si, wo))
+
+
+def test08_tabulated_chi2(variants_vec_backends_once_rgb):
+    from mitsuba.chi2 import BSDFAdapter, ChiSquareTest, SphericalDomain
+    for long_roughness in [0.3, 0.8]:
+        for theta in list(dr.linspace(mi.Float, 0, 0.99 * (dr.pi / 2), 3)):
+            xml = f"""
+                <rgb name="sigma_a" value="0.8, 0.8, 0.8" />
+                <float name="longitudinal_roughness" value="{long_roughness}" />
+                <float name="azimuthal_roughness" value="0.9" />
+                <boolean name="tabulated" value="true" />
+            """
+
+            wi = dr.normalize(mi.ScalarVector3f(dr.sin(theta), 0, dr.cos(theta)))
+            sample_func, pdf_func = BSDFAdapter("hair", xml, wi=wi)
+
+            chi2 = ChiSquareTest(
+                domain=SphericalDomain(),
+                sample_func=sample_func,
+                pdf_func=pdf_func,
+                sample_dim=3,
+                res=301,
+            )
+
+            assert chi2.run()
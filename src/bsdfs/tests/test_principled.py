@@ -194,3 +194,43 @@ def test05_eval_pdf(variant_scalar_rgb):
         wo = [dr.sin(theta), 0, dr.cos(theta)]
         assert dr.allclose(bsdf.pdf(ctx, si, wo=wo), pdf_true[i])
         assert dr.allclose(bsdf.eval(ctx, si, wo=wo)[0], evaluate_true[i])
+
+
+def test06_specialized_lobes(variant_scalar_rgb):
+    # Pure metals don't have a diffuse lobe
+    desc = {
+        'type': 'principled',
+        'metallic': 1.0,
+        'sheen': 0.5,
+        'clearcoat': 0.5,
+        'anisotropic': 0.3
+    }
+    b = mi.load_dict(desc)
+    assert b.component_count() == 2
+    assert not mi.has_flag(b.flags(), mi.BSDFFlags.DiffuseReflection)
+    assert mi.has_flag(b.flags(), mi.BSDFFlags.GlossyReflection)
+
+    # ... which evaluate like the general implementation
+    desc['metallic'] = {'type': 'uniform', 'value': 1.0}
+    b_ref = mi.load_dict(desc)
+    assert b_ref.component_count() == 3
+
+    si = mi.SurfaceInteraction3f()
+    si.p = [0, 0, 0]
+    si.n = [0, 0, 1]
+    si.wi = dr.normalize(mi.ScalarVector3f(1, 0, 1))
+    si.sh_frame = mi.Frame3f(si.n)
+
+    ctx = mi.BSDFContext()
+    for i in range(10):
+        theta = i / 9.0 * (dr.pi / 2)
+        wo = [dr.sin(theta), 0, dr.cos(theta)]
+        assert dr.allclose(b.pdf(ctx, si, wo=wo), b_ref.pdf(ctx, si, wo=wo))
+        assert dr.allclose(b.eval(ctx, si, wo=wo), b_ref.eval(ctx, si, wo=wo))
+
+    # Updating the metallic parameter restores the lobe
+    p = mi.traverse(b)
+    p['metallic.value'] = 0.5
+    p.update()
+    assert b.component_count() == 3
+    assert mi.has_flag(b.flags(), mi.BSDFFlags.DiffuseReflection)
@@ -115,3 +115,46 @@ def test06_eval_pdf(variant_scalar_rgb):
         v_eval_pdf = bsdf.eval_pdf(ctx, si, wo=wo)
         assert dr.allclose(v_eval, v_eval_pdf[0])
         assert dr.allclose(v_pdf, v_eval_pdf[1])
+
+
+def test07_chi2_energy_compensation(variants_vec_backends_once_rgb):
+    xml = """<float name="alpha" value="0.6"/>
+             <boolean name="energy_compensation" value="true"/>"""
+    wi = dr.normalize(mi.ScalarVector3f(1.0, 1.0, 1.0))
+    sample_func, pdf_func = mi.chi2.BSDFAdapter("roughconductor", xml, wi=wi)
+
+    chi2 = mi.chi2.ChiSquareTest(
+        domain=mi.chi2.SphericalDomain(),
+        sample_func=sample_func,
+        pdf_func=pdf_func,
+        sample_dim=3,
+        ires=16
+    )
+
+    assert chi2.run()
+
+
+def test08_energy_compensation_furnace(variants_vec_backends_once_rgb):
+    # A perfectly reflecting rough conductor should not lose any energy
+    def albedo(compensation):
+        bsdf = mi.load_dict({
+            'type': 'roughconductor',
+            'alpha': 0.8,
+            'material': 'none',
+            'energy_compensation': compensation
+        })
+
+        n = 100000
+        sampler = mi.load_dict({'type': 'independent'})
+        sampler.seed(0, n)
+
+        si = dr.zeros(mi.SurfaceInteraction3f, n)
+        si.wi = dr.normalize(mi.Vector3f(1, 0, 1))
+        si.sh_frame = mi.Frame3f(mi.Normal3f(0, 0, 1))
+
+        _, weight = bsdf.sample(mi.BSDFContext(), si, sampler.next_1d(),
+                                sampler.next_2d())
+        return dr.mean(weight.x)[0]
+
+    assert albedo(False) < 0.9
+    assert dr.allclose(albedo(True), 1, rtol=2e-2)
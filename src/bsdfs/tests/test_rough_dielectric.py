@@ -245,4 +245,70 @@ def test13_attached_sampling(variants_all_ad_rgb):
 
     dr.forward(angle)
     assert dr.allclose(dr.grad(weight), 0.02079637348651886)
-    
\ No newline at end of file
+    
+
+@pytest.mark.parametrize('wi', [[0.4, 0.2, 0.6], [0.2, -0.6, -0.5], [0.8, 0.3, -0.05]])
+def test14_chi2_energy_compensation(variants_vec_backends_once_rgb, wi):
+    xml = """<float name="alpha" value="0.7"/>
+             <boolean name="energy_compensation" value="true"/>"""
+    wi = dr.normalize(mi.ScalarVector3f(wi))
+    sample_func, pdf_func = mi.chi2.BSDFAdapter("roughdielectric", xml, wi=wi)
+
+    chi2 = mi.chi2.ChiSquareTest(
+        domain=mi.chi2.SphericalDomain(),
+        sample_func=sample_func,
+        pdf_func=pdf_func,
+        sample_dim=3,
+        res=201
+    )
+
+    assert chi2.run()
+
+
+@pytest.mark.parametrize('cos_theta', [0.8, -0.8, -0.3])
+def test15_energy_compensation_furnace(variants_vec_backends_once_rgb, cos_theta):
+    # A dielectric interface reflects or transmits all of the incident energy
+    def albedo(compensation):
+        bsdf = mi.load_dict({
+            'type': 'roughdielectric',
+            'distribution': 'ggx',
+            'alpha': 0.8,
+            'energy_compensation': compensation
+        })
+
+        n = 100000
+        sampler = mi.load_dict({'type': 'independent'})
+        sampler.seed(0, n)
+
+        si = dr.zeros(mi.SurfaceInteraction3f, n)
+        si.wi = mi.Vector3f(dr.sqrt(1 - cos_theta**2), 0, cos_theta)
+        si.sh_frame = mi.Frame3f(mi.Normal3f(0, 0, 1))
+
+        # Importance transport avoids the radiance scaling of the transmission
+        ctx = mi.BSDFContext(mi.TransportMode.Importance)
+        _, weight = bsdf.sample(ctx, si, sampler.next_1d(), sampler.next_2d())
+        return dr.mean(weight.x)[0]
+
+    assert albedo(False) < 0.98
+    assert dr.allclose(albedo(True), 1, rtol=2e-2)
+
+
+def test16_energy_compensation_eval_pdf(variants_vec_backends_once_rgb):
+    bsdf = mi.load_dict({
+        'type': 'roughdielectric',
+        'alpha': 0.6,
+        'energy_compensation': True
+    })
+
+    si = dr.zeros(mi.SurfaceInteraction3f)
+    si.wi = dr.normalize(mi.Vector3f(0.3, 0.1, 0.7))
+    si.sh_frame = mi.Frame3f(mi.Normal3f(0, 0, 1))
+
+    theta = dr.linspace(mi.Float, 0.01, dr.pi - 0.01, 40)
+    wo = mi.Vector3f(dr.sin(theta), 0, dr.cos(theta))
+
+    ctx = mi.BSDFContext()
+    value, pdf = bsdf.eval_pdf(ctx, si, wo)
+    assert dr.allclose(value, bsdf.eval(ctx, si, wo))
+    assert dr.allclose(pdf, bsdf.pdf(ctx, si, wo))
+    assert dr.all(pdf > 0)
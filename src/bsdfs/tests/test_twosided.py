@@ -13,7 +13,7 @@ def test01_create(variant_scalar_rgb):
     assert bsdf.component_count() == 2
     assert bsdf.flags(0) == mi.BSDFFlags.DiffuseReflection | mi.BSDFFlags.FrontSide
     assert bsdf.flags(1) == mi.BSDFFlags.DiffuseReflection | mi.BSDFFlags.BackSide
-    assert bsdf.flags() == bsdf.flags(0) | bsdf.flags(1)
+    assert bsdf.flags() == bsdf.flags(0) | bsdf.flags(1) | mi.BSDFFlags.Depolarizing
 
     bsdf = mi.load_string("""<bsdf version="3.0.0" type="twosided">
         <bsdf type="roughconductor"/>
@@ -121,7 +121,7 @@ public:
         m_components.push_back(BSDFFlags::DeltaReflection | BSDFFlags::FrontSide |
                                BSDFFlags::BackSide);
         m_components.push_back(BSDFFlags::Null | BSDFFlags::FrontSide | BSDFFlags::BackSide);
-        m_flags = m_components[0] | m_components[1];
+        m_flags = m_components[0] | m_components[1] | BSDFFlags::Depolarizing;
     }
 
     void traverse(TraversalCallback *callback) override {
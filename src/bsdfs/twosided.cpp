@@ -100,6 +100,10 @@ public:
 
         if (has_flag(m_flags, BSDFFlags::Transmission))
             Throw("Only materials without a transmission component can be nested!");
+
+        if (has_flag(m_brdf[0]->flags(), BSDFFlags::Depolarizing) &&
+            has_flag(m_brdf[1]->flags(), BSDFFlags::Depolarizing))
+            m_flags = m_flags | BSDFFlags::Depolarizing;
     }
 
     void traverse(TraversalCallback *callback) override {
@@ -9,9 +9,14 @@
 #include <mitsuba/core/profiler.h>
 #include <unordered_map>
 #include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 #include <nanothread/nanothread.h>
 #include <drjit-core/half.h>
+#include <drjit/packet.h>
+#include <drjit/color.h>
 
 /* libpng */
 #include <png.h>
@@ -37,9 +42,15 @@ extern "C" {
 #endif
 
 #include <ImfInputFile.h>
+#include <ImfTiledInputFile.h>
 #include <ImfStandardAttributes.h>
 #include <ImfRgbaYca.h>
 #include <ImfOutputFile.h>
+#include <ImfTiledOutputFile.h>
+#include <ImfMultiPartOutputFile.h>
+#include <ImfOutputPart.h>
+#include <ImfTiledOutputPart.h>
+#include <ImfPartType.h>
 #include <ImfChannelList.h>
 #include <ImfStringAttribute.h>
 #include <ImfIntAttribute.h>
@@ -81,6 +92,7 @@ Bitmap::Bitmap(PixelFormat pixel_format, Struct::Type component_format,
         m_data = std::unique_ptr<uint8_t[]>(new uint8_t[buffer_size()]);
 
         m_owns_data = true;
+        m_memory.set(buffer_size());
     }
 }
 
@@ -95,6 +107,7 @@ Bitmap::Bitmap(const Bitmap &bitmap)
     size_t size = buffer_size();
     m_data = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
     memcpy(m_data.get(), bitmap.m_data.get(), size);
+    m_memory.set(size);
 }
 
 
@@ -106,7 +119,8 @@ Bitmap::Bitmap(Bitmap &&bitmap)
       m_struct(std::move(bitmap.m_struct)),
       m_srgb_gamma(bitmap.m_srgb_gamma),
       m_premultiplied_alpha(bitmap.m_premultiplied_alpha),
-      m_owns_data(bitmap.m_owns_data) {
+      m_owns_data(bitmap.m_owns_data), m_memory(bitmap.m_memory) {
+    bitmap.m_memory.set(0);
 }
 
 Bitmap::Bitmap(Stream *stream, FileFormat format) {
@@ -253,6 +267,40 @@ void Bitmap::vflip() {
     }
 }
 
+/**
+ * Return a resampler with the given configuration. Precomputing the filter
+ * weights is a significant part of resampling small images, hence resamplers
+ * are shared between calls (e.g. for the rows and columns of square images,
+ * or for repeated thumbnail generation).
+ */
+template <typename Scalar, typename ReconstructionFilter>
+static std::shared_ptr<const Resampler<Scalar>>
+cached_resampler(const ReconstructionFilter *rfilter, uint32_t source_res,
+                 uint32_t target_res, FilterBoundaryCondition bc,
+                 const std::pair<Scalar, Scalar> &clamp) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const Resampler<Scalar>>> cache;
+
+    std::string key = tfm::format("%s|%u|%u|%i|%s|%s", rfilter->to_string(),
+                                  source_res, target_res, (int) bc,
+                                  (double) clamp.first, (double) clamp.second);
+
+    std::lock_guard<std::mutex> guard(mutex);
+    auto it = cache.find(key);
+    if (it != cache.end())
+        return it->second;
+
+    auto r = std::make_shared<Resampler<Scalar>>(rfilter, source_res, target_res);
+    r->set_boundary_condition(bc);
+    r->set_clamp(clamp);
+
+    // Keep the cache small, the weight tables scale with the resolution
+    if (cache.size() >= 32)
+        cache.clear();
+    cache[key] = r;
+    return r;
+}
+
 template <typename Scalar, bool Filter,
           typename ReconstructionFilter = typename Bitmap::ReconstructionFilter>
 static void
@@ -281,9 +329,8 @@ resample(Bitmap *target, const Bitmap *source,
 
     if (source->width() != target->width() || Filter) {
         // Re-sample horizontally
-        Resampler<Scalar> r(rfilter, source->width(), target->width());
-        r.set_boundary_condition(bc.first);
-        r.set_clamp(clamp);
+        auto r = cached_resampler<Scalar>(rfilter.get(), source->width(),
+                                          target->width(), bc.first, clamp);
 
         // Create a bitmap for intermediate storage
         if (!temp) {
@@ -306,7 +353,7 @@ resample(Bitmap *target, const Bitmap *source,
                                       y * (size_t) source->width() * channels;
                     Scalar *t       = (Scalar *) temp->uint8_data() +
                                       y * (size_t) target->width() * channels;
-                    r.resample(s, 1, t, 1, (uint32_t) channels);
+                    r->resample(s, 1, t, 1, (uint32_t) channels);
                 }
             }
         );
@@ -317,20 +364,21 @@ resample(Bitmap *target, const Bitmap *source,
 
     if (source->height() != target->height() || Filter) {
         // Re-sample vertically
-        Resampler<Scalar> r(rfilter, source->height(), target->height());
-        r.set_boundary_condition(bc.second);
-        r.set_clamp(clamp);
+        auto r = cached_resampler<Scalar>(rfilter.get(), source->height(),
+                                          target->height(), bc.second, clamp);
 
+        /* Process tiles of adjacent columns row by row, which accesses
+           memory contiguously instead of with a stride of a full row */
         dr::parallel_for(
-            dr::blocked_range<size_t>(0, source->width(), 100),
+            dr::blocked_range<size_t>(0, source->width(), 64),
             [&](const dr::blocked_range<size_t> &range) {
-                for (auto x = range.begin(); x != range.end(); ++x) {
-                    const Scalar *s = (const Scalar *) source->uint8_data() +
-                                      x * channels;
-                    Scalar *t       = (Scalar *) target->uint8_data() +
-                                      x * channels;
-                    r.resample(s, source->width(), t, target->width(), (uint32_t) channels);
-                }
+                const Scalar *s = (const Scalar *) source->uint8_data() +
+                                  range.begin() * channels;
+                Scalar *t       = (Scalar *) target->uint8_data() +
+                                  range.begin() * channels;
+                r->resample_columns(s, source->width() * channels, t,
+                                    target->width() * channels,
+                                    (uint32_t) (range.size() * channels));
             }
         );
     }
@@ -386,6 +434,96 @@ ref<Bitmap> Bitmap::resample(
     return result;
 }
 
+// Defined in dither-matrix256.cpp
+extern const float dither_matrix256[65536];
+
+/// Conversions that \ref Bitmap::convert() handles without a \ref StructConverter
+enum class FastConversion { None, Float32ToUInt8, Float16ToFloat32, Float32ToFloat16 };
+
+/**
+ * Check if the conversion from \c source to \c target only changes the
+ * component format of otherwise identical channels, in which case it can be
+ * done using vectorized loops.
+ */
+static FastConversion fast_conversion(const Struct *source, const Struct *target) {
+    if (source->field_count() != target->field_count() ||
+        source->field_count() == 0 ||
+        source->byte_order() != Struct::host_byte_order() ||
+        target->byte_order() != Struct::host_byte_order())
+        return FastConversion::None;
+
+    Struct::Type source_type = (*source)[0].type,
+                 target_type = (*target)[0].type;
+
+    uint32_t value_flags = Struct::Flags::Normalized | Struct::Flags::Gamma;
+    for (size_t i = 0; i < source->field_count(); ++i) {
+        const Struct::Field &s = (*source)[i], &t = (*target)[i];
+        if (s.name != t.name || !t.blend.empty() || s.type != source_type ||
+            t.type != target_type || s.offset != i * s.size ||
+            t.offset != i * t.size ||
+            has_flag(s.flags, Struct::Flags::Assert) ||
+            ((s.flags ^ t.flags) & ~value_flags) != 0)
+            return FastConversion::None;
+
+        if (source_type == Struct::Type::Float32 &&
+            target_type == Struct::Type::UInt8) {
+            if (has_flag(s.flags, Struct::Flags::Gamma) ||
+                !has_flag(t.flags, Struct::Flags::Normalized))
+                return FastConversion::None;
+        } else if (has_flag(s.flags, Struct::Flags::Gamma) !=
+                   has_flag(t.flags, Struct::Flags::Gamma)) {
+            return FastConversion::None;
+        }
+    }
+
+    if (source_type == Struct::Type::Float32 && target_type == Struct::Type::UInt8)
+        return FastConversion::Float32ToUInt8;
+    else if (source_type == Struct::Type::Float16 && target_type == Struct::Type::Float32)
+        return FastConversion::Float16ToFloat32;
+    else if (source_type == Struct::Type::Float32 && target_type == Struct::Type::Float16)
+        return FastConversion::Float32ToFloat16;
+    else
+        return FastConversion::None;
+}
+
+/// Quantize a normalized value to 8 bits (same rounding as \ref StructConverter)
+template <typename Value>
+MI_INLINE Value quantize_uint8(Value value, bool gamma, const Value &dither) {
+    if (gamma)
+        value = dr::linear_to_srgb(value);
+    return dr::clip(dr::round(dr::fmadd(value, 255.f, dither)), 0.f, 255.f);
+}
+
+/// Convert a row of \c width pixels from float32 to dithered uint8 values
+static void convert_row_uint8(const float *src, uint8_t *dst, size_t width,
+                              size_t channels, const bool *gamma, size_t y) {
+    using FloatP  = dr::Packet<float>;
+    using UInt32P = dr::Packet<uint32_t>;
+    using UInt8P  = dr::Packet<uint8_t>;
+    constexpr size_t Size = FloatP::Size;
+    static_assert(256 % Size == 0, "Packets must not straddle dither rows");
+
+    const float *dither = dither_matrix256 + (y % 256) * 256;
+    size_t x = 0;
+
+    for (; x + Size <= width; x += Size) {
+        FloatP d = dr::load<FloatP>(dither + x % 256);
+        UInt32P index = (dr::arange<UInt32P>() + (uint32_t) x) * (uint32_t) channels;
+        for (size_t c = 0; c < channels; ++c) {
+            FloatP value = dr::gather<FloatP>(src, index + (uint32_t) c);
+            dr::scatter(dst, UInt8P(quantize_uint8(value, gamma[c], d)),
+                        index + (uint32_t) c);
+        }
+    }
+
+    for (; x < width; ++x) {
+        for (size_t c = 0; c < channels; ++c) {
+            size_t i = x * channels + c;
+            dst[i] = (uint8_t) quantize_uint8(src[i], gamma[c], dither[x % 256]);
+        }
+    }
+}
+
 ref<Bitmap> Bitmap::convert(PixelFormat pixel_format,
                             Struct::Type component_format,
                             bool srgb_gamma, Bitmap::AlphaTransform alpha_transform) const {
@@ -526,9 +664,78 @@ void Bitmap::convert(Bitmap *target) const {
               m_struct, target_struct, field.name);
     }
 
+    size_t width = m_size.x(), height = m_size.y(),
+           channels = target_struct->field_count(),
+           source_stride = width * m_struct->size(),
+           target_stride = width * target_struct->size();
+    const uint8_t *source_data = uint8_data();
+    uint8_t *target_data = target->uint8_data();
+
+    // Process blocks of roughly 64K pixels in parallel
+    size_t grain = std::max<size_t>(1, 65536 / std::max<size_t>(1, width));
+
+    switch (fast_conversion(m_struct, target_struct)) {
+        case FastConversion::Float32ToUInt8: {
+                std::unique_ptr<bool[]> gamma(new bool[channels]);
+                for (size_t c = 0; c < channels; ++c)
+                    gamma[c] = has_flag((*target_struct)[c].flags, Struct::Flags::Gamma);
+
+                dr::parallel_for(
+                    dr::blocked_range<size_t>(0, height, grain),
+                    [&](const dr::blocked_range<size_t> &range) {
+                        for (size_t y = range.begin(); y != range.end(); ++y)
+                            convert_row_uint8(
+                                (const float *) (source_data + y * source_stride),
+                                target_data + y * target_stride, width,
+                                channels, gamma.get(), y);
+                    }
+                );
+            }
+            return;
+
+        case FastConversion::Float16ToFloat32:
+            dr::parallel_for(
+                dr::blocked_range<size_t>(0, height, grain),
+                [&](const dr::blocked_range<size_t> &range) {
+                    const dr::half *src = (const dr::half *) (source_data + range.begin() * source_stride);
+                    float *dst = (float *) (target_data + range.begin() * target_stride);
+                    for (size_t i = 0, n = range.size() * width * channels; i < n; ++i)
+                        dst[i] = (float) src[i];
+                }
+            );
+            return;
+
+        case FastConversion::Float32ToFloat16:
+            dr::parallel_for(
+                dr::blocked_range<size_t>(0, height, grain),
+                [&](const dr::blocked_range<size_t> &range) {
+                    const float *src = (const float *) (source_data + range.begin() * source_stride);
+                    dr::half *dst = (dr::half *) (target_data + range.begin() * target_stride);
+                    for (size_t i = 0, n = range.size() * width * channels; i < n; ++i)
+                        dst[i] = dr::half(src[i]);
+                }
+            );
+            return;
+
+        default:
+            break;
+    }
+
+    /* The dither pattern repeats every 256 rows: blocks starting at multiples
+       of 256 rows produce exactly the same output as a single pass. */
     StructConverter conv(m_struct, target_struct, true);
-    bool rv = conv.convert_2d(m_size.x(), m_size.y(), uint8_data(), target->uint8_data());
-    if (!rv)
+    std::atomic<bool> failed(false);
+    dr::parallel_for(
+        dr::blocked_range<size_t>(0, height, 256),
+        [&](const dr::blocked_range<size_t> &range) {
+            if (!conv.convert_2d(width, range.size(),
+                                 source_data + range.begin() * source_stride,
+                                 target_data + range.begin() * target_stride))
+                failed = true;
+        }
+    );
+
+    if (failed)
         Throw("Bitmap::convert(): conversion kernel indicated a failure!");
 }
 
@@ -705,6 +912,8 @@ void Bitmap::read(Stream *stream, FileFormat format) {
         default:
             Throw("Bitmap: Unknown file format!");
     }
+
+    m_memory.set(m_owns_data ? buffer_size() : 0);
 }
 
 Bitmap::FileFormat Bitmap::detect_file_format(Stream *stream) {
@@ -811,16 +1020,74 @@ void Bitmap::write(Stream *stream, FileFormat format, int quality) const {
     }
 }
 
+/// Bounded queue of the writes issued by \ref Bitmap::write_async()
+static std::mutex async_write_mutex;
+static std::condition_variable async_write_cv;
+static uint32_t async_write_pending = 0;
+static uint32_t async_write_limit_value = 4;
+
 void Bitmap::write_async(const fs::path &path, FileFormat format, int quality) const {
+    /* Block while too many writes are pending (back-pressure). Pool workers
+       instead help with the pending tasks, which would otherwise deadlock. */
+    if (pool_thread_id()) {
+        while (true) {
+            pool_work_until(
+                nullptr,
+                [](void *) -> bool {
+                    std::lock_guard<std::mutex> guard(async_write_mutex);
+                    return async_write_pending < async_write_limit_value;
+                },
+                nullptr);
+            std::lock_guard<std::mutex> guard(async_write_mutex);
+            if (async_write_pending < async_write_limit_value) {
+                async_write_pending++;
+                break;
+            }
+        }
+    } else {
+        std::unique_lock<std::mutex> guard(async_write_mutex);
+        async_write_cv.wait(guard, [] {
+            return async_write_pending < async_write_limit_value;
+        });
+        async_write_pending++;
+    }
+
     this->inc_ref();
     Task *task = dr::do_async([path, format, quality, this]() {
-        write(path, format, quality);
-        if (this->dec_ref())
-            delete this;
+        auto finish = [this]() {
+            /* locked */ {
+                std::lock_guard<std::mutex> guard(async_write_mutex);
+                async_write_pending--;
+            }
+            async_write_cv.notify_all();
+            if (this->dec_ref())
+                delete this;
+        };
+
+        try {
+            write(path, format, quality);
+        } catch (...) {
+            finish();
+            throw;
+        }
+        finish();
     });
     Thread::register_task(task);
 }
 
+void Bitmap::set_async_write_limit(uint32_t limit) {
+    /* locked */ {
+        std::lock_guard<std::mutex> guard(async_write_mutex);
+        async_write_limit_value = std::max(limit, 1u);
+    }
+    async_write_cv.notify_all();
+}
+
+uint32_t Bitmap::async_write_limit() {
+    std::lock_guard<std::mutex> guard(async_write_mutex);
+    return async_write_limit_value;
+}
+
 bool Bitmap::operator==(const Bitmap &bitmap) const {
     if (dr::all(m_pixel_format != bitmap.m_pixel_format ||
         m_component_format != bitmap.m_component_format ||
@@ -936,11 +1203,49 @@ public:
     void finish() override { }
 };
 
+/// OpenEXR I/O settings, see \ref Bitmap::set_exr_tile_size() etc.
+static std::atomic<uint32_t> exr_tile_size_value { 0 };
+static std::atomic<int> exr_thread_count_value { -1 };
+
+/// Number of line buffers/tiles that OpenEXR processes concurrently
+static int exr_threads() {
+    int count = exr_thread_count_value.load(std::memory_order_relaxed);
+    return count < 0 ? (int) Thread::thread_count() : count;
+}
+
+/// Run an OpenEXR call that blocks until the pixels are read or written
+template <typename Func> static void exr_decode(Func func) {
+    if (pool_thread_id()) {
+        // We are being is called from a nanothread worker ,e.g., because of
+        // parallel scene loading or \ref Bitmap::write_async(). The OpenEXR
+        // functions (e.g. ``file.readPixels()``) sleep, which can cause a serious starvation issue where the entire
+        // worker pool waits for a large number of parallel reads to finish.
+        //
+        // The following works around the issue by performing the decoding call
+        // from a temporary thread. It then resumes working on nanothread tasks until
+        // the image is fully loaded.
+
+        std::atomic<bool> done(false);
+        std::thread t([&] { func(); done = true; });
+
+        pool_work_until(
+            nullptr,
+            [](void *p) -> bool {
+                return ((std::atomic<bool> *) p)->load(std::memory_order_relaxed);
+            },
+            &done);
+
+        t.join();
+    } else {
+        func();
+    }
+}
+
 void Bitmap::read_exr(Stream *stream) {
     ScopedPhase phase(ProfilerPhase::BitmapRead);
 
     EXRIStream istr(stream);
-    Imf::InputFile file(istr);
+    Imf::InputFile file(istr, exr_threads());
 
     const Imf::Header &header = file.header();
     const Imf::ChannelList &channels = header.channels();
@@ -1168,32 +1473,7 @@ void Bitmap::read_exr(Stream *stream) {
         m_pixel_format, m_component_format);
 
     file.setFrameBuffer(framebuffer);
-
-    if (pool_thread_id()) {
-        // We are being is called from a nanothread worker ,e.g., because of
-        // parallel scene loading. The function ``file.readPixels()`` below
-        // sleeps, which can cause a serious starvation issue where the entire
-        // worker pool waits for a large number of parallel reads to finish.
-        //
-        // The following works around the issue by performing the readPixels() call
-        // from a temporary thread. It then resumes working on nanothread tasks until
-        // the image is fully loaded.
-
-        std::atomic<bool> done(false);
-        std::thread t(
-            [&] { file.readPixels(data_window.min.y, data_window.max.y); done = true; });
-
-        pool_work_until(
-            nullptr,
-            [](void *p) -> bool {
-                return ((std::atomic<bool> *) p)->load(std::memory_order_relaxed);
-            },
-            &done);
-
-        t.join();
-    } else {
-        file.readPixels(data_window.min.y, data_window.max.y);
-    }
+    exr_decode([&] { file.readPixels(data_window.min.y, data_window.max.y); });
 
     for (auto &buf: resample_buffers) {
         Log(Debug, "Upsampling layer \"%s\" from %ix%i to %ix%i pixels",
@@ -1329,20 +1609,147 @@ void Bitmap::read_exr(Stream *stream) {
     }
 }
 
-void Bitmap::write_exr(Stream *stream, int quality) const {
-    ScopedPhase phase(ProfilerPhase::BitmapWrite);
+struct BitmapRegionReader::EXRFile {
+    ref<FileStream> stream;
+    std::unique_ptr<EXRIStream> istr;
+    std::unique_ptr<Imf::InputFile> scanline;
+    std::unique_ptr<Imf::TiledInputFile> tiled;
+    Imath::Box2i data_window;
+    std::vector<std::string> channels;
+};
 
-    PixelFormat pixel_format = m_pixel_format;
+BitmapRegionReader::BitmapRegionReader(const fs::path &path)
+    : m_file(new EXRFile()), m_path(path) {
+    m_file->stream = new FileStream(path);
+    if (Bitmap::detect_file_format(m_file->stream) != Bitmap::FileFormat::OpenEXR)
+        Throw("BitmapRegionReader: \"%s\" is not an OpenEXR file!",
+              path.filename().string());
 
-    Properties metadata(m_metadata);
+    m_file->istr = std::make_unique<EXRIStream>(m_file->stream.get());
+    m_file->scanline = std::make_unique<Imf::InputFile>(*m_file->istr);
+    const Imf::Header &header = m_file->scanline->header();
+
+    if (header.hasTileDescription()) {
+        m_file->scanline.reset();
+        m_file->istr->seekg(0);
+        m_file->tiled = std::make_unique<Imf::TiledInputFile>(*m_file->istr);
+    }
+
+    const Imf::ChannelList &channels = header.channels();
+    if (channels.begin() == channels.end())
+        Throw("BitmapRegionReader: image \"%s\" does not contain any channels!",
+              path.filename().string());
+
+    if (channels.findChannel("R") && channels.findChannel("G") &&
+        channels.findChannel("B"))
+        m_file->channels = { "R", "G", "B" };
+    else if (channels.findChannel("Y"))
+        m_file->channels = { "Y" };
+    else
+        m_file->channels = { channels.begin().name() };
+    m_channel_count = (uint32_t) m_file->channels.size();
+
+    m_file->data_window = header.dataWindow();
+    m_size = Vector2u(m_file->data_window.max.x - m_file->data_window.min.x + 1,
+                      m_file->data_window.max.y - m_file->data_window.min.y + 1);
+
+    Log(Debug, "Opened OpenEXR file \"%s\" for region reads (%ix%i, %s)",
+        path.filename().string(), m_size.x(), m_size.y(),
+        tiled() ? "tiled" : "scanlines");
+}
+
+BitmapRegionReader::~BitmapRegionReader() { }
+
+bool BitmapRegionReader::tiled() const { return (bool) m_file->tiled; }
+
+void BitmapRegionReader::read(const Vector2u &offset, const Vector2u &size,
+                              float *dest) const {
+    if (dr::any(offset + size > m_size) || dr::any(size == 0u))
+        Throw("BitmapRegionReader::read(): region is out of bounds!");
+
+    ScopedPhase phase(ProfilerPhase::BitmapRead);
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    const Imath::Box2i &dw = m_file->data_window;
+    size_t channels = m_channel_count;
+
+    /* The decoders write entire tiles or scanlines, so decode into a
+       temporary buffer covering them (relative to 'origin') */
+    Vector2u origin, extent;
+    uint32_t tx0 = 0, tx1 = 0, ty0 = 0, ty1 = 0;
+    if (m_file->tiled) {
+        const Imf::TileDescription &td = m_file->tiled->header().tileDescription();
+        tx0 = offset.x() / td.xSize; tx1 = (offset.x() + size.x() - 1) / td.xSize;
+        ty0 = offset.y() / td.ySize; ty1 = (offset.y() + size.y() - 1) / td.ySize;
+        origin = Vector2u(tx0 * td.xSize, ty0 * td.ySize);
+        extent = dr::minimum(Vector2u((tx1 + 1) * td.xSize, (ty1 + 1) * td.ySize),
+                             m_size) - origin;
+    } else {
+        origin = Vector2u(0, offset.y());
+        extent = Vector2u(m_size.x(), size.y());
+    }
+
+    std::unique_ptr<float[]> buffer(
+        new float[(size_t) extent.x() * extent.y() * channels]);
+
+    size_t pixel_stride = channels * sizeof(float),
+           row_stride   = pixel_stride * extent.x();
+    char *base = (char *) buffer.get() -
+                 (dw.min.x + origin.x()) * pixel_stride -
+                 (dw.min.y + origin.y()) * row_stride;
+
+    Imf::FrameBuffer framebuffer;
+    for (size_t c = 0; c < channels; ++c)
+        framebuffer.insert(m_file->channels[c],
+                           Imf::Slice(Imf::FLOAT, base + c * sizeof(float),
+                                      pixel_stride, row_stride));
+
+    if (m_file->tiled) {
+        m_file->tiled->setFrameBuffer(framebuffer);
+        exr_decode([&] { m_file->tiled->readTiles(tx0, tx1, ty0, ty1, 0); });
+    } else {
+        m_file->scanline->setFrameBuffer(framebuffer);
+        exr_decode([&] {
+            m_file->scanline->readPixels(dw.min.y + offset.y(),
+                                         dw.min.y + offset.y() + size.y() - 1);
+        });
+    }
+
+    for (uint32_t y = 0; y < size.y(); ++y) {
+        const float *src = buffer.get() +
+            ((size_t) (offset.y() - origin.y() + y) * extent.x() +
+             (offset.x() - origin.x())) * channels;
+        std::memcpy(dest + (size_t) y * size.x() * channels, src,
+                    size.x() * channels * sizeof(float));
+    }
+}
+
+std::string BitmapRegionReader::to_string() const {
+    std::ostringstream oss;
+    oss << "BitmapRegionReader[" << std::endl
+        << "  path = \"" << m_path.string() << "\"," << std::endl
+        << "  size = " << m_size << "," << std::endl
+        << "  channel_count = " << m_channel_count << "," << std::endl
+        << "  tiled = " << (tiled() ? "true" : "false") << std::endl
+        << "]";
+    return oss.str();
+}
+
+/// Describe the contents of a bitmap using an OpenEXR header and frame buffer
+static void exr_prepare(const Bitmap *bitmap, int quality, uint32_t tile_size,
+                        Imf::Header &header, Imf::FrameBuffer &framebuffer) {
+    Bitmap::PixelFormat pixel_format = bitmap->pixel_format();
+
+    Properties metadata(bitmap->metadata());
     if (!metadata.has_property("generatedBy"))
         metadata.set_string("generatedBy", "Mitsuba version " MI_VERSION);
 
     std::vector<std::string> keys = metadata.property_names();
 
-    Imf::Header header(
-        (int) m_size.x(),  // width
-        (int) m_size.y(),  // height,
+    Vector2u size = bitmap->size();
+    header = Imf::Header(
+        (int) size.x(),    // width
+        (int) size.y(),    // height,
         1.f,               // pixelAspectRatio
         Imath::V2f(0, 0),  // screenWindowCenter,
         1.f,               // screenWindowWidth
@@ -1403,7 +1810,8 @@ void Bitmap::write_exr(Stream *stream, int quality) const {
         }
     }
 
-    if (pixel_format == PixelFormat::XYZ || pixel_format == PixelFormat::XYZA) {
+    if (pixel_format == Bitmap::PixelFormat::XYZ ||
+        pixel_format == Bitmap::PixelFormat::XYZA) {
         Imf::addChromaticities(header, Imf::Chromaticities(
             Imath::V2f(1.f, 0.f),
             Imath::V2f(0.f, 1.f),
@@ -1411,13 +1819,16 @@ void Bitmap::write_exr(Stream *stream, int quality) const {
             Imath::V2f(1.f / 3.f, 1.f / 3.f)));
     }
 
-    size_t pixel_stride = m_struct->size(),
-           row_stride = pixel_stride * m_size.x();
+    if (tile_size > 0)
+        header.setTileDescription(
+            Imf::TileDescription(tile_size, tile_size, Imf::ONE_LEVEL));
+
+    size_t pixel_stride = bitmap->struct_()->size(),
+           row_stride = pixel_stride * size.x();
 
     Imf::ChannelList &channels = header.channels();
-    Imf::FrameBuffer framebuffer;
-    const uint8_t *ptr = uint8_data();
-    for (auto field : *m_struct) {
+    const uint8_t *ptr = bitmap->uint8_data();
+    for (auto field : *bitmap->struct_()) {
         Imf::PixelType comp_type;
         switch (field.type) {
             case Struct::Type::Float32: comp_type = Imf::FLOAT; break;
@@ -1431,10 +1842,174 @@ void Bitmap::write_exr(Stream *stream, int quality) const {
         framebuffer.insert(field.name, slice);
     }
 
+}
+
+/// Write the pixels of a (single part) OpenEXR file that may be tiled
+template <typename ScanlineFile, typename TiledFile>
+static void exr_write_pixels(ScanlineFile &scanline, TiledFile &tiled,
+                             const Imf::FrameBuffer &framebuffer,
+                             bool is_tiled, int height) {
+    exr_decode([&] {
+        if (is_tiled) {
+            tiled.setFrameBuffer(framebuffer);
+            tiled.writeTiles(0, tiled.numXTiles() - 1, 0, tiled.numYTiles() - 1);
+        } else {
+            scanline.setFrameBuffer(framebuffer);
+            scanline.writePixels(height);
+        }
+    });
+}
+
+void Bitmap::write_exr(Stream *stream, int quality) const {
+    ScopedPhase phase(ProfilerPhase::BitmapWrite);
+
+    uint32_t tile_size = exr_tile_size();
+    Imf::Header header;
+    Imf::FrameBuffer framebuffer;
+    exr_prepare(this, quality, tile_size, header, framebuffer);
+
+    /* Writing all scanlines (or tiles) at once lets OpenEXR compress
+       several line buffers in parallel while finished ones are written */
     EXROStream ostr(stream);
-    Imf::OutputFile file(ostr, header);
-    file.setFrameBuffer(framebuffer);
-    file.writePixels((int) m_size.y());
+    if (tile_size > 0) {
+        Imf::TiledOutputFile file(ostr, header, exr_threads());
+        exr_write_pixels(file, file, framebuffer, true, (int) m_size.y());
+    } else {
+        Imf::OutputFile file(ostr, header, exr_threads());
+        exr_write_pixels(file, file, framebuffer, false, (int) m_size.y());
+    }
+}
+
+void Bitmap::write_exr_multipart(
+    Stream *stream,
+    const std::vector<std::pair<std::string, ref<Bitmap>>> &parts,
+    int quality) {
+    ScopedPhase phase(ProfilerPhase::BitmapWrite);
+
+    if (parts.empty())
+        Throw("Bitmap::write_exr_multipart(): at least one part is required!");
+
+    uint32_t tile_size = exr_tile_size();
+    std::vector<Imf::Header> headers(parts.size());
+    std::vector<Imf::FrameBuffer> framebuffers(parts.size());
+    for (size_t i = 0; i < parts.size(); ++i) {
+        exr_prepare(parts[i].second.get(), quality, tile_size, headers[i],
+                    framebuffers[i]);
+        headers[i].setName(parts[i].first);
+        headers[i].setType(tile_size > 0 ? Imf::TILEDIMAGE : Imf::SCANLINEIMAGE);
+    }
+
+    Log(Debug, "Writing multi-part OpenEXR file with %zu parts ..", parts.size());
+
+    EXROStream ostr(stream);
+    Imf::MultiPartOutputFile file(ostr, headers.data(), (int) headers.size(),
+                                  false, exr_threads());
+
+    for (size_t i = 0; i < parts.size(); ++i) {
+        int height = (int) parts[i].second->size().y();
+        if (tile_size > 0) {
+            Imf::TiledOutputPart part(file, (int) i);
+            exr_write_pixels(part, part, framebuffers[i], true, height);
+        } else {
+            Imf::OutputPart part(file, (int) i);
+            exr_write_pixels(part, part, framebuffers[i], false, height);
+        }
+    }
+}
+
+void Bitmap::write_exr_multipart(
+    const fs::path &path,
+    const std::vector<std::pair<std::string, ref<Bitmap>>> &parts,
+    int quality) {
+    ref<FileStream> fs = new FileStream(path, FileStream::ETruncReadWrite);
+    write_exr_multipart(fs.get(), parts, quality);
+}
+
+void Bitmap::set_exr_tile_size(uint32_t size) {
+    exr_tile_size_value.store(size, std::memory_order_relaxed);
+}
+
+uint32_t Bitmap::exr_tile_size() {
+    return exr_tile_size_value.load(std::memory_order_relaxed);
+}
+
+void Bitmap::set_exr_thread_count(int count) {
+    exr_thread_count_value.store(count, std::memory_order_relaxed);
+}
+
+int Bitmap::exr_thread_count() { return exr_threads(); }
+
+struct BitmapTileWriter::EXRFile {
+    ref<FileStream> stream;
+    std::unique_ptr<EXROStream> ostr;
+    std::unique_ptr<Imf::TiledOutputFile> file;
+    ref<Struct> struct_;
+};
+
+BitmapTileWriter::BitmapTileWriter(const fs::path &path, const Vector2u &size,
+                                   uint32_t tile_size, int quality)
+    : m_file(new EXRFile()), m_path(path), m_size(size),
+      m_tile_size(tile_size), m_quality(quality) {
+    if (tile_size == 0 || dr::any(size == 0u))
+        Throw("BitmapTileWriter(): the image and tile sizes must be nonzero!");
+    m_file->stream = new FileStream(path, FileStream::ETruncReadWrite);
+    m_file->ostr = std::make_unique<EXROStream>(m_file->stream.get());
+}
+
+BitmapTileWriter::~BitmapTileWriter() {
+    if (m_file->file && m_rows_written != row_count())
+        Log(Warn, "BitmapTileWriter: \"%s\" is incomplete (%u/%u rows of "
+            "tiles were written)", m_path.string(), m_rows_written, row_count());
+}
+
+void BitmapTileWriter::write_row(uint32_t row, const Bitmap *bitmap) {
+    ScopedPhase phase(ProfilerPhase::BitmapWrite);
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    uint32_t y = row * m_tile_size;
+    if (row >= row_count() || bitmap->width() != m_size.x() ||
+        bitmap->height() != std::min(m_tile_size, m_size.y() - y))
+        Throw("BitmapTileWriter::write_row(): row %u has an invalid index or "
+              "size (%ix%i)!", row, bitmap->width(), bitmap->height());
+
+    Imf::Header header;
+    Imf::FrameBuffer framebuffer;
+    exr_prepare(bitmap, m_quality, m_tile_size, header, framebuffer);
+
+    if (!m_file->file) {
+        Imath::Box2i window(Imath::V2i(0, 0), Imath::V2i((int) m_size.x() - 1,
+                                                          (int) m_size.y() - 1));
+        header.dataWindow() = window;
+        header.displayWindow() = window;
+        m_file->file = std::make_unique<Imf::TiledOutputFile>(
+            *m_file->ostr, header, exr_threads());
+        m_file->struct_ = new Struct(*bitmap->struct_());
+    } else if (*m_file->struct_ != *bitmap->struct_()) {
+        Throw("BitmapTileWriter::write_row(): all rows must have the same "
+              "channel layout!");
+    }
+
+    // The frame buffer is addressed using absolute pixel coordinates
+    for (auto it = framebuffer.begin(); it != framebuffer.end(); ++it)
+        it.slice().base -= (ptrdiff_t) y * (ptrdiff_t) it.slice().yStride;
+
+    Imf::TiledOutputFile &file = *m_file->file;
+    exr_decode([&] {
+        file.setFrameBuffer(framebuffer);
+        file.writeTiles(0, file.numXTiles() - 1, (int) row, (int) row);
+    });
+    m_rows_written++;
+}
+
+std::string BitmapTileWriter::to_string() const {
+    std::ostringstream oss;
+    oss << "BitmapTileWriter[" << std::endl
+        << "  path = \"" << m_path.string() << "\"," << std::endl
+        << "  size = " << m_size << "," << std::endl
+        << "  tile_size = " << m_tile_size << "," << std::endl
+        << "  rows_written = " << m_rows_written << std::endl
+        << "]";
+    return oss.str();
 }
 
 // -----------------------------------------------------------------------------
@@ -2554,5 +3129,7 @@ void Bitmap::static_initialization() {
 void Bitmap::static_shutdown() { }
 
 MI_IMPLEMENT_CLASS(Bitmap, Object)
+MI_IMPLEMENT_CLASS(BitmapRegionReader, Object)
+MI_IMPLEMENT_CLASS(BitmapTileWriter, Object)
 
 NAMESPACE_END(mitsuba)
@@ -0,0 +1,156 @@
+#include <mitsuba/core/bstream.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/string.h>
+#include <algorithm>
+#include <sstream>
+
+NAMESPACE_BEGIN(mitsuba)
+
+BufferedStream::BufferedStream(Stream *child_stream, size_t buffer_size)
+    : m_child_stream(child_stream), m_buffer_size(buffer_size), m_pos(0),
+      m_end(0), m_did_write(false) {
+    if (buffer_size == 0)
+        Throw("BufferedStream(): the buffer size must be nonzero!");
+    m_buffer = std::unique_ptr<uint8_t[]>(new uint8_t[buffer_size]);
+    m_offset = m_child_stream->tell();
+}
+
+BufferedStream::~BufferedStream() { }
+
+void BufferedStream::close() {
+    m_child_stream->close();
+    m_pos = m_end = 0;
+}
+
+void BufferedStream::fill() {
+    discard();
+
+    if (m_did_write) {
+        m_child_stream->flush();
+        m_did_write = false;
+    }
+
+    size_t size = m_child_stream->size();
+    if (m_offset >= size)
+        return;
+
+    size_t amount = std::min(m_buffer_size, size - m_offset);
+    m_child_stream->seek(m_offset);
+    m_child_stream->read(m_buffer.get(), amount);
+    m_end = amount;
+}
+
+void BufferedStream::read(void *p, size_t size) {
+    uint8_t *ptr = (uint8_t *) p;
+    size_t requested = size;
+
+    while (size > 0) {
+        size_t amount = std::min(size, m_end - m_pos);
+        if (amount > 0) {
+            std::memcpy(ptr, m_buffer.get() + m_pos, amount);
+            m_pos += amount;
+            ptr += amount;
+            size -= amount;
+            continue;
+        }
+
+        if (size >= m_buffer_size) {
+            // Large reads bypass the buffer
+            discard();
+            if (m_did_write) {
+                m_child_stream->flush();
+                m_did_write = false;
+            }
+            m_child_stream->seek(m_offset);
+            m_child_stream->read(ptr, size);
+            m_offset += size;
+            return;
+        }
+
+        fill();
+        if (m_end == 0)
+            throw EOFException(
+                tfm::format("BufferedStream: read %zu out of %zu bytes",
+                            requested - size, requested),
+                requested - size);
+    }
+}
+
+std::string BufferedStream::read_line() {
+    std::string result;
+
+    while (true) {
+        if (m_pos == m_end) {
+            fill();
+            if (m_end == 0) {
+                if (result.empty())
+                    Throw("read_line(): attempted to read past the end of the stream!");
+                break;
+            }
+        }
+
+        const uint8_t *start = m_buffer.get() + m_pos,
+                      *newline = (const uint8_t *) std::memchr(start, '\n', m_end - m_pos);
+        size_t amount = newline ? (size_t) (newline - start) : m_end - m_pos;
+        result.append((const char *) start, amount);
+        m_pos += amount;
+
+        if (newline) {
+            m_pos++;
+            break;
+        }
+    }
+
+    result.erase(std::remove(result.begin(), result.end(), '\r'), result.end());
+    return result;
+}
+
+void BufferedStream::write(const void *p, size_t size) {
+    discard();
+    m_child_stream->seek(m_offset);
+    m_child_stream->write(p, size);
+    m_offset += size;
+    m_did_write = true;
+}
+
+void BufferedStream::seek(size_t pos) {
+    if (pos >= m_offset && pos <= m_offset + m_end) {
+        m_pos = pos - m_offset;
+    } else {
+        m_offset = pos;
+        m_pos = m_end = 0;
+    }
+}
+
+void BufferedStream::truncate(size_t size) {
+    discard();
+    m_child_stream->truncate(size);
+    m_offset = std::min(m_offset, size);
+    m_child_stream->seek(m_offset);
+}
+
+std::string BufferedStream::to_string() const {
+    std::ostringstream oss;
+
+    oss << class_()->name() << "[" << std::endl;
+    if (is_closed()) {
+        oss << "  closed" << std::endl;
+    } else {
+        oss << "  child_stream = " << string::indent(m_child_stream) << "," << std::endl
+            << "  buffer_size = " << m_buffer_size << "," << std::endl
+            << "  host_byte_order = " << host_byte_order() << "," << std::endl
+            << "  byte_order = " << byte_order() << "," << std::endl
+            << "  can_read = " << can_read() << "," << std::endl
+            << "  can_write = " << can_write() << "," << std::endl
+            << "  pos = " << tell() << "," << std::endl
+            << "  size = " << size() << std::endl;
+    }
+
+    oss << "]";
+
+    return oss.str();
+}
+
+MI_IMPLEMENT_CLASS(BufferedStream, Stream)
+
+NAMESPACE_END(mitsuba)
@@ -133,6 +133,19 @@ size_t file_size(const path& p) {
     return (size_t) sb.st_size;
 }
 
+int64_t last_write_time(const path& p) {
+#if defined(_WIN32)
+    struct _stati64 sb;
+    if (_wstati64(p.native().c_str(), &sb) != 0)
+        throw std::runtime_error("filesystem::last_write_time(): cannot stat file \"" + p.string() + "\"!");
+#else
+    struct stat sb;
+    if (stat(p.native().c_str(), &sb) != 0)
+        throw std::runtime_error("filesystem::last_write_time(): cannot stat file \"" + p.string() + "\"!");
+#endif
+    return (int64_t) sb.st_mtime;
+}
+
 bool equivalent(const path& p1, const path& p2) {
 #if defined(_WIN32)
     struct _stati64 sb1, sb2;
@@ -162,6 +175,21 @@ bool create_directory(const path& p) noexcept {
 #endif
 }
 
+bool create_directories(const path& p) noexcept {
+    if (p.empty())
+        return false;
+    if (exists(p))
+        return is_directory(p);
+
+    path parent = p.parent_path();
+    if (!parent.empty() && parent.native() != p.native() &&
+        !create_directories(parent))
+        return false;
+
+    // Another process may have created the directory in the meantime
+    return create_directory(p) || is_directory(p);
+}
+
 bool resize_file(const path& p, size_t target_length) noexcept {
 #if !defined(_WIN32)
     return ::truncate(p.native().c_str(), (off_t) target_length) == 0;
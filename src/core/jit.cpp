@@ -4,18 +4,25 @@
 NAMESPACE_BEGIN(mitsuba)
 
 static Jit *jit = nullptr;
+static std::mutex jit_mutex;
 
 Jit::Jit() { }
-Jit *Jit::get_instance() { return jit; }
 
-void Jit::static_initialization() {
+Jit *Jit::get_instance() {
 #if defined(DRJIT_X86_64)
-    jit = new Jit();
+    // The runtime is created on first use (i.e. by the first StructConverter)
+    std::lock_guard<std::mutex> guard(jit_mutex);
+    if (!jit)
+        jit = new Jit();
 #endif
+    return jit;
 }
 
+void Jit::static_initialization() { }
+
 void Jit::static_shutdown() {
 #if defined(DRJIT_X86_64)
+    std::lock_guard<std::mutex> guard(jit_mutex);
     delete jit;
     jit = nullptr;
 #endif
@@ -6,24 +6,72 @@
 #include <thread>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 
 NAMESPACE_BEGIN(mitsuba)
 
+/// Log message whose formatting was deferred by the asynchronous mode
+struct LogMessage {
+    LogLevel level;
+    const Class *class_;
+    ref<Thread> thread;
+    const char *file;
+    int line;
+    std::string text;
+    LogMessage *next;
+};
+
 struct Logger::LoggerPrivate {
-    std::mutex mutex;
+    /* Recursive, since appenders and formatters can themselves log (or
+       throw) while pending messages are being flushed */
+    std::recursive_mutex mutex;
     LogLevel error_level = Error;
     std::vector<ref<Appender>> appenders;
     ref<Formatter> formatter;
+
+    // Asynchronous mode: pending messages (most recent first) and worker
+    std::atomic<LogMessage *> pending { nullptr };
+    std::atomic<bool> asynchronous { false };
+    std::thread worker;
+    std::mutex worker_mutex;
+    std::condition_variable worker_cv;
+    bool worker_stop = false;
+
+    /// Format and append all pending messages (must hold \c mutex)
+    void drain() {
+        LogMessage *head = pending.exchange(nullptr, std::memory_order_acquire),
+                   *list = nullptr;
+
+        // Reverse the list to process messages in the order they were logged
+        while (head) {
+            LogMessage *next = head->next;
+            head->next = list;
+            list = head;
+            head = next;
+        }
+
+        while (list) {
+            std::unique_ptr<LogMessage> msg(list);
+            list = list->next;
+            std::string text = formatter->format(msg->level, msg->class_,
+                msg->thread, msg->file, msg->line, msg->text);
+            for (auto entry : appenders)
+                entry->append(msg->level, text);
+        }
+    }
 };
 
 Logger::Logger(LogLevel log_level)
     : m_log_level(log_level), d(new LoggerPrivate()) { }
 
-Logger::~Logger() { }
+Logger::~Logger() {
+    set_asynchronous(false);
+}
 
 void Logger::set_formatter(Formatter *formatter) {
-    std::lock_guard<std::mutex> guard(d->mutex);
+    std::lock_guard<std::recursive_mutex> guard(d->mutex);
     d->formatter = formatter;
 }
 
@@ -64,34 +112,98 @@ void Logger::log(LogLevel level, const Class *class_, const char *file,
         abort();
     }
 
+    if (d->asynchronous.load(std::memory_order_relaxed)) {
+        LogMessage *message = new LogMessage{ level, class_, Thread::thread(),
+                                              file, line, msg, nullptr };
+        LogMessage *head = d->pending.load(std::memory_order_relaxed);
+        do {
+            message->next = head;
+        } while (!d->pending.compare_exchange_weak(
+            head, message, std::memory_order_release, std::memory_order_relaxed));
+
+        // Wake up the worker when the list was empty
+        if (!head)
+            d->worker_cv.notify_one();
+        return;
+    }
+
     std::string text = d->formatter->format(level, class_,
         Thread::thread(), file, line, msg);
 
-    std::lock_guard<std::mutex> guard(d->mutex);
+    std::lock_guard<std::recursive_mutex> guard(d->mutex);
     for (auto entry : d->appenders)
         entry->append(level, text);
 }
 
+void Logger::set_asynchronous(bool value) {
+    std::lock_guard<std::mutex> guard(d->worker_mutex);
+    if (value == d->worker.joinable())
+        return;
+
+    if (value) {
+        d->worker_stop = false;
+        d->worker = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(d->worker_mutex);
+            while (!d->worker_stop) {
+                /* Messages are enqueued without holding 'worker_mutex', so
+                   wake up periodically in case a notification was missed */
+                d->worker_cv.wait_for(lock, std::chrono::milliseconds(50), [&] {
+                    return d->worker_stop ||
+                           d->pending.load(std::memory_order_relaxed) != nullptr;
+                });
+                lock.unlock();
+                flush();
+                lock.lock();
+            }
+        });
+        d->asynchronous = true;
+    } else {
+        d->asynchronous = false;
+        d->worker_stop = true;
+        d->worker_cv.notify_one();
+        {
+            // Release the lock while the worker finishes
+            d->worker_mutex.unlock();
+            d->worker.join();
+            d->worker_mutex.lock();
+        }
+        flush();
+    }
+}
+
+bool Logger::asynchronous() const {
+    return d->asynchronous;
+}
+
+void Logger::flush() {
+    if (!d->pending.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::recursive_mutex> guard(d->mutex);
+    d->drain();
+}
+
 void Logger::log_progress(float progress, const std::string &name,
     const std::string &formatted, const std::string &eta, const void *ptr) {
-    std::lock_guard<std::mutex> guard(d->mutex);
+    std::lock_guard<std::recursive_mutex> guard(d->mutex);
+    d->drain();
     for (auto entry : d->appenders)
         entry->log_progress(progress, name, formatted, eta, ptr);
 }
 
 void Logger::add_appender(Appender *appender) {
-    std::lock_guard<std::mutex> guard(d->mutex);
+    std::lock_guard<std::recursive_mutex> guard(d->mutex);
     d->appenders.push_back(appender);
 }
 
 void Logger::remove_appender(Appender *appender) {
-    std::lock_guard<std::mutex> guard(d->mutex);
+    std::lock_guard<std::recursive_mutex> guard(d->mutex);
     d->appenders.erase(std::remove(d->appenders.begin(),
         d->appenders.end(), ref<Appender>(appender)), d->appenders.end());
 }
 
 std::string Logger::read_log() {
-    std::lock_guard<std::mutex> guard(d->mutex);
+    std::lock_guard<std::recursive_mutex> guard(d->mutex);
     for (auto appender: d->appenders) {
         if (appender->class_()->derives_from(MI_CLASS(StreamAppender))) {
             auto sa = static_cast<StreamAppender *>(appender.get());
@@ -104,7 +216,7 @@ std::string Logger::read_log() {
 }
 
 void Logger::clear_appenders() {
-    std::lock_guard<std::mutex> guard(d->mutex);
+    std::lock_guard<std::recursive_mutex> guard(d->mutex);
     d->appenders.clear();
 }
 
@@ -146,6 +258,10 @@ void Throw(LogLevel level, const Class *class_, const char *file,
     util::trap_debugger();
     #endif
 
+    // Don't lose messages that are still pending in asynchronous mode
+    if (Thread *thread = Thread::thread(); thread && thread->logger())
+        thread->logger()->flush();
+
     DefaultFormatter formatter;
     formatter.set_has_date(false);
     formatter.set_has_log_level(false);
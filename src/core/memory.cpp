@@ -0,0 +1,132 @@
+#include <mitsuba/core/memory.h>
+#include <mitsuba/core/util.h>
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#  include <psapi.h>
+#else
+#  include <sys/resource.h>
+#endif
+
+NAMESPACE_BEGIN(mitsuba)
+
+static constexpr int memory_category_count = int(MemoryCategory::MemoryCategoryCount);
+
+struct MemoryCounter {
+    std::atomic<size_t> usage { 0 };
+    std::atomic<size_t> peak { 0 };
+
+    void add(size_t size) {
+        size_t value = usage.fetch_add(size, std::memory_order_relaxed) + size,
+               prev  = peak.load(std::memory_order_relaxed);
+        while (prev < value &&
+               !peak.compare_exchange_weak(prev, value, std::memory_order_relaxed))
+            ;
+    }
+
+    void sub(size_t size) {
+        usage.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    void reset_peak() {
+        peak.store(usage.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+};
+
+static MemoryCounter memory_categories[memory_category_count];
+/// Totals of all categories in host and GPU memory
+static MemoryCounter memory_totals[2];
+
+void MemoryTracker::allocate(MemoryCategory category, size_t size, bool device) {
+    memory_categories[(int) category].add(size);
+    memory_totals[device ? 1 : 0].add(size);
+}
+
+void MemoryTracker::release(MemoryCategory category, size_t size, bool device) {
+    memory_categories[(int) category].sub(size);
+    memory_totals[device ? 1 : 0].sub(size);
+}
+
+size_t MemoryTracker::usage(MemoryCategory category) {
+    return memory_categories[(int) category].usage.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::peak_usage(MemoryCategory category) {
+    return memory_categories[(int) category].peak.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::total_usage(bool device) {
+    return memory_totals[device ? 1 : 0].usage.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::peak_total_usage(bool device) {
+    return memory_totals[device ? 1 : 0].peak.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::peak_rss() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return (size_t) counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#  if defined(__APPLE__)
+    return (size_t) usage.ru_maxrss;
+#  else
+    return (size_t) usage.ru_maxrss * 1024;
+#  endif
+#endif
+}
+
+void MemoryTracker::reset_peak_usage() {
+    for (int i = 0; i < memory_category_count; ++i)
+        memory_categories[i].reset_peak();
+    for (int i = 0; i < 2; ++i)
+        memory_totals[i].reset_peak();
+}
+
+std::string MemoryTracker::report() {
+    std::ostringstream oss;
+    oss << "Memory usage:" << std::endl
+        << "  " << std::left << std::setw(40) << "Category" << std::setw(14)
+        << "Current" << "Peak" << std::endl;
+
+    for (int i = 0; i < memory_category_count; ++i)
+        oss << "  " << std::left << std::setw(40)
+            << (std::string(memory_category_id[i]) + ":") << std::setw(14)
+            << util::mem_string(usage((MemoryCategory) i))
+            << util::mem_string(peak_usage((MemoryCategory) i)) << std::endl;
+
+    oss << "  " << std::left << std::setw(40) << "Total (host):" << std::setw(14)
+        << util::mem_string(total_usage(false))
+        << util::mem_string(peak_total_usage(false)) << std::endl
+        << "  " << std::left << std::setw(40) << "Total (GPU):" << std::setw(14)
+        << util::mem_string(total_usage(true))
+        << util::mem_string(peak_total_usage(true)) << std::endl
+        << "  " << std::left << std::setw(40) << "Peak resident memory:"
+        << util::mem_string(peak_rss()) << std::endl;
+
+    return oss.str();
+}
+
+std::string MemoryTracker::summary() {
+    std::ostringstream oss;
+    oss << "Memory: ";
+    for (int i = 0; i < memory_category_count; ++i) {
+        size_t value = usage((MemoryCategory) i);
+        if (value > 0)
+            oss << memory_category_id[i] << " " << util::mem_string(value) << ", ";
+    }
+    oss << "tracked peak " << util::mem_string(peak_total_usage(false))
+        << " (host), " << util::mem_string(peak_total_usage(true))
+        << " (GPU), peak resident memory " << util::mem_string(peak_rss());
+    return oss.str();
+}
+
+NAMESPACE_END(mitsuba)
@@ -20,10 +20,12 @@ struct MemoryMappedFile::MemoryMappedFilePrivate {
     size_t size;
     void *data;
     bool can_write;
+    bool copy_on_write;
     bool temp;
 
     MemoryMappedFilePrivate(const fs::path &f = "", size_t s = 0)
-        : filename(f), size(s), data(nullptr), can_write(false), temp(false) { }
+        : filename(f), size(s), data(nullptr), can_write(false),
+          copy_on_write(false), temp(false) { }
 
     void create() {
         #if defined(__linux__) || defined(__APPLE__)
@@ -142,7 +144,8 @@ struct MemoryMappedFile::MemoryMappedFilePrivate {
             if (fd == -1)
                 Throw("Could not open \"%s\"!", filename.string());
 
-            data = mmap(nullptr, size, PROT_READ | (can_write ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+            data = mmap(nullptr, size, PROT_READ | (can_write || copy_on_write ? PROT_WRITE : 0),
+                        copy_on_write ? MAP_PRIVATE : MAP_SHARED, fd, 0);
             if (data == MAP_FAILED) {
                 data = nullptr;
                 Throw("Could not map \"%s\" to memory!", filename.string());
@@ -159,12 +162,16 @@ struct MemoryMappedFile::MemoryMappedFilePrivate {
                 Throw("Could not open \"%s\": %s", filename.string(),
                     util::last_error());
 
-            file_mapping = CreateFileMappingW(file, nullptr, can_write ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+            file_mapping = CreateFileMappingW(file, nullptr,
+                can_write ? PAGE_READWRITE : (copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY),
+                0, 0, nullptr);
             if (file_mapping == nullptr)
                 Throw("CreateFileMapping: Could not map \"%s\" to memory: %s",
                     filename.string(), util::last_error());
 
-            data = (void *) MapViewOfFile(file_mapping, can_write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+            data = (void *) MapViewOfFile(file_mapping,
+                can_write ? FILE_MAP_WRITE : (copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ),
+                0, 0, 0);
             if (data == nullptr)
                 Throw("MapViewOfFile: Could not map \"%s\" to memory: %s",
                     filename.string(), util::last_error());
@@ -240,6 +247,8 @@ MemoryMappedFile::~MemoryMappedFile() {
 void MemoryMappedFile::resize(size_t size) {
     if (!d->data)
         Throw("Internal error in MemoryMappedFile::resize()!");
+    if (d->copy_on_write)
+        Throw("MemoryMappedFile::resize(): copy-on-write mappings cannot be resized!");
     bool temp = d->temp;
     d->temp = false;
     d->unmap();
@@ -262,7 +271,11 @@ size_t MemoryMappedFile::size() const {
 }
 
 bool MemoryMappedFile::can_write() const {
-    return d->can_write;
+    return d->can_write || d->copy_on_write;
+}
+
+bool MemoryMappedFile::is_copy_on_write() const {
+    return d->copy_on_write;
 }
 
 const fs::path &MemoryMappedFile::filename() const {
@@ -276,6 +289,16 @@ ref<MemoryMappedFile> MemoryMappedFile::create_temporary(size_t size) {
     return result;
 }
 
+ref<MemoryMappedFile> MemoryMappedFile::map_copy_on_write(const fs::path &filename) {
+    MemoryMappedFile* result = new MemoryMappedFile();
+    result->d->filename = filename;
+    result->d->copy_on_write = true;
+    result->d->map();
+    Log(Trace, "Mapped \"%s\" into memory (%s, copy-on-write)..",
+        filename.filename().string(), util::mem_string(result->d->size));
+    return result;
+}
+
 std::string MemoryMappedFile::to_string() const {
     std::ostringstream oss;
     oss << "MemoryMappedFile[" << std::endl
@@ -12,6 +12,10 @@ void Object::traverse(TraversalCallback * /*callback*/) { }
 
 void Object::parameters_changed(const std::vector<std::string> &/*keys*/) { }
 
+bool Object::replace_object(Object * /*old_child*/, Object * /*new_child*/) {
+    return false;
+}
+
 std::string Object::id() const { return std::string(); }
 
 void Object::set_id(const std::string&/*id*/) { }
@@ -4,6 +4,7 @@
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/filesystem.h>
 #include <mitsuba/core/fresolver.h>
+#include <chrono>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
@@ -88,6 +89,8 @@ private:
 struct PluginManager::PluginManagerPrivate {
     std::unordered_map<std::string, Plugin *> m_plugins;
     std::unordered_set<std::string> m_python_plugins;
+    /// Total time spent loading plugin libraries
+    std::chrono::duration<float, std::milli> m_load_time { 0.f };
     std::mutex m_mutex;
 
     Plugin *plugin(const std::string &name) {
@@ -114,9 +117,11 @@ struct PluginManager::PluginManagerPrivate {
 
         if (fs::exists(resolved)) {
             Log(Debug, "Loading plugin \"%s\" ..", filename.string());
+            auto start = std::chrono::steady_clock::now();
             Plugin *plugin = new Plugin(resolved);
             // New classes must be registered within the class hierarchy
             Class::static_initialization();
+            m_load_time += std::chrono::steady_clock::now() - start;
             // Statistics::instance()->log_plugin(shortName, description()); XXX
             m_plugins[name] = plugin;
             return plugin;
@@ -165,6 +170,11 @@ std::vector<std::string> PluginManager::loaded_plugins() const {
     return list;
 }
 
+float PluginManager::load_time() const {
+    std::lock_guard<std::mutex> guard(d->m_mutex);
+    return d->m_load_time.count();
+}
+
 void PluginManager::register_python_plugin(const std::string &plugin_name,
                                            const std::string &variant) {
     d->m_python_plugins.insert(plugin_name + "@" + variant);
@@ -1,6 +1,21 @@
 #include <mitsuba/core/profiler.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/util.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/memory.h>
+#include <mitsuba/core/thread.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string_view>
+#include <vector>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -18,6 +33,828 @@ void Profiler::static_initialization() {
 #endif
 }
 
-void Profiler::static_shutdown() { }
+void Profiler::static_shutdown() {
+    if (phase_profiling())
+        Log(Info, "%s", phase_profile_report());
+
+    if (kernel_profiling())
+        Log(Info, "%s", kernel_statistics_report());
+
+    if (kernel_instrumentation())
+        Log(Info, "%s", kernel_phase_report());
+
+#if defined(MI_ENABLE_RAY_STATISTICS)
+    if (ray_statistic(RayStatistic::RayIntersect) > 0 ||
+        ray_statistic(RayStatistic::RayTest) > 0)
+        Log(Info, "%s", ray_statistics_report());
+#endif
+}
+
+#if defined(MI_ENABLE_RAY_STATISTICS)
+static constexpr int ray_statistic_count = int(RayStatistic::RayStatisticCount);
+
+/* Per-thread counters. Every counter is only ever modified by its owning
+   thread, hence relaxed loads and stores suffice (and compile to plain memory
+   accesses). Other threads merely read them to compute the totals. */
+struct ThreadRayStatistics;
+
+static std::mutex ray_statistics_mutex;
+static std::vector<ThreadRayStatistics *> ray_statistics_threads;
+static uint64_t ray_statistics_retired[ray_statistic_count] { };
+
+struct ThreadRayStatistics {
+    std::atomic<uint64_t> values[ray_statistic_count] { };
+
+    ThreadRayStatistics() {
+        std::lock_guard<std::mutex> guard(ray_statistics_mutex);
+        ray_statistics_threads.push_back(this);
+    }
+
+    ~ThreadRayStatistics() {
+        std::lock_guard<std::mutex> guard(ray_statistics_mutex);
+        for (int i = 0; i < ray_statistic_count; ++i)
+            ray_statistics_retired[i] += values[i].load(std::memory_order_relaxed);
+        ray_statistics_threads.erase(std::find(ray_statistics_threads.begin(),
+                                               ray_statistics_threads.end(), this));
+    }
+};
+
+static thread_local ThreadRayStatistics thread_ray_statistics;
+#endif
+
+void Profiler::add_ray_statistics(const uint64_t *values) {
+#if defined(MI_ENABLE_RAY_STATISTICS)
+    ThreadRayStatistics &ts = thread_ray_statistics;
+    for (int i = 0; i < ray_statistic_count; ++i) {
+        if (values[i] == 0)
+            continue;
+        std::atomic<uint64_t> &v = ts.values[i];
+        v.store(v.load(std::memory_order_relaxed) + values[i],
+                std::memory_order_relaxed);
+    }
+#else
+    (void) values;
+#endif
+}
+
+uint64_t Profiler::thread_ray_statistic(RayStatistic stat) {
+#if defined(MI_ENABLE_RAY_STATISTICS)
+    return thread_ray_statistics.values[(int) stat].load(std::memory_order_relaxed);
+#else
+    (void) stat;
+    return 0;
+#endif
+}
+
+uint64_t Profiler::ray_statistic(RayStatistic stat) {
+#if defined(MI_ENABLE_RAY_STATISTICS)
+    std::lock_guard<std::mutex> guard(ray_statistics_mutex);
+    uint64_t result = ray_statistics_retired[(int) stat];
+    for (ThreadRayStatistics *ts : ray_statistics_threads)
+        result += ts->values[(int) stat].load(std::memory_order_relaxed);
+    return result;
+#else
+    (void) stat;
+    return 0;
+#endif
+}
+
+void Profiler::reset_ray_statistics() {
+#if defined(MI_ENABLE_RAY_STATISTICS)
+    std::lock_guard<std::mutex> guard(ray_statistics_mutex);
+    for (int i = 0; i < ray_statistic_count; ++i) {
+        ray_statistics_retired[i] = 0;
+        for (ThreadRayStatistics *ts : ray_statistics_threads)
+            ts->values[i].store(0, std::memory_order_relaxed);
+    }
+#endif
+}
+
+std::string Profiler::ray_statistics_report() {
+    std::ostringstream oss;
+#if defined(MI_ENABLE_RAY_STATISTICS)
+    uint64_t values[ray_statistic_count];
+    for (int i = 0; i < ray_statistic_count; ++i)
+        values[i] = ray_statistic((RayStatistic) i);
+
+    uint64_t rays = values[(int) RayStatistic::RayIntersect] +
+                    values[(int) RayStatistic::RayTest];
+
+    oss << "Ray traversal statistics:" << std::endl;
+    for (int i = 0; i < ray_statistic_count; ++i) {
+        oss << "  " << std::left << std::setw(32)
+            << (std::string(ray_statistic_id[i]) + ":") << values[i];
+        if (i >= (int) RayStatistic::TraversedNodes && rays > 0)
+            oss << " (" << (double) values[i] / (double) rays << " per ray)";
+        oss << std::endl;
+    }
+#else
+    oss << "Ray traversal statistics are unavailable (compile Mitsuba with "
+           "-DMI_ENABLE_RAY_STATISTICS=ON)." << std::endl;
+#endif
+    return oss.str();
+}
+
+// =======================================================================
+//! @{ \name Built-in phase profiler
+// =======================================================================
+
+static constexpr int phase_count = int(ProfilerPhase::ProfilerPhaseCount);
+
+NAMESPACE_BEGIN(detail)
+std::atomic<uint32_t> profiler_flags { 0 };
+NAMESPACE_END(detail)
+
+/// Time stamp in nanoseconds
+static uint64_t profiler_time() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Accumulated time and counts of the nested phases, merged from all threads
+struct PhaseTree {
+    struct Node {
+        int phase = -1;
+        uint64_t time = 0, count = 0;
+        // Index of the node of every nested phase (0: none)
+        uint32_t children[phase_count] { };
+    };
+
+    std::vector<Node> nodes { Node() };
+
+    uint32_t child(uint32_t index, int phase) {
+        uint32_t result = nodes[index].children[phase];
+        if (result == 0) {
+            result = (uint32_t) nodes.size();
+            nodes[index].children[phase] = result;
+            nodes.emplace_back().phase = phase;
+        }
+        return result;
+    }
+};
+
+/// Event of a timeline trace
+struct TraceEvent {
+    const char *category;
+    std::string name, info;
+    uint64_t begin, end;
+};
+
+/// Timeline of a thread that has already exited
+struct TraceTimeline {
+    uint32_t id;
+    std::string name;
+    std::vector<TraceEvent> events;
+};
+
+struct ThreadProfile;
+
+static std::mutex profile_mutex;
+static std::vector<ThreadProfile *> profile_threads;
+/// Phase profile and timelines of threads that have already exited
+static PhaseTree phase_profile_retired;
+static std::vector<TraceTimeline> trace_retired;
+static uint32_t profile_thread_counter = 0;
+/// Incremented whenever a trace is started, which discards the old events
+static std::atomic<uint32_t> trace_generation { 0 };
+static uint64_t trace_start_time = 0;
+
+/* Per-thread tree of nested phases with a stack of the currently active ones,
+   and the events of the trace timeline. Times and counts are only modified by
+   the owning thread (relaxed atomics, see the ray statistics above). New
+   nodes and events are created while holding 'mutex', which reports acquire
+   before reading them. */
+struct ThreadProfile {
+    struct Node {
+        Node(int phase) : phase(phase) { }
+        int phase;
+        std::atomic<uint64_t> time { 0 }, count { 0 };
+        uint32_t children[phase_count] { };
+    };
+
+    struct Frame {
+        ProfilerPhase phase;
+        // Node of the phase profile ((uint32_t) -1: not profiled)
+        uint32_t node;
+        // Event of the trace timeline ((size_t) -1: not traced)
+        size_t event;
+        uint32_t generation;
+        uint64_t start;
+        // JIT backends whose label prefix stack contains the phase (bit mask)
+        uint32_t labels;
+    };
+
+    std::mutex mutex;
+    // A deque doesn't move existing nodes when growing
+    std::deque<Node> nodes;
+    std::vector<Frame> stack;
+    std::vector<TraceEvent> events;
+    uint32_t generation = 0;
+    uint32_t id;
+    std::string name;
+
+    ThreadProfile() {
+        nodes.emplace_back(-1);
+        Thread *thread = Thread::thread();
+        std::lock_guard<std::mutex> guard(profile_mutex);
+        id = profile_thread_counter++;
+        name = thread ? thread->name() : tfm::format("thread %u", id);
+        generation = trace_generation;
+        profile_threads.push_back(this);
+    }
+
+    ~ThreadProfile() {
+        std::lock_guard<std::mutex> guard(profile_mutex);
+        merge_into(phase_profile_retired);
+        {
+            std::lock_guard<std::mutex> guard2(mutex);
+            if (!events.empty() && generation == trace_generation)
+                trace_retired.push_back({ id, name, std::move(events) });
+        }
+        profile_threads.erase(std::find(profile_threads.begin(),
+                                        profile_threads.end(), this));
+    }
+
+    /// Add the phase profile of this thread to 'tree' (holds 'profile_mutex')
+    void merge_into(PhaseTree &tree) {
+        std::lock_guard<std::mutex> guard(mutex);
+        merge_into(tree, 0, 0);
+    }
+
+    void merge_into(PhaseTree &tree, uint32_t src, uint32_t dst) {
+        for (int i = 0; i < phase_count; ++i) {
+            uint32_t src_child = nodes[src].children[i];
+            if (src_child == 0)
+                continue;
+            uint32_t dst_child = tree.child(dst, i);
+            const Node &node = nodes[src_child];
+            tree.nodes[dst_child].time  += node.time.load(std::memory_order_relaxed);
+            tree.nodes[dst_child].count += node.count.load(std::memory_order_relaxed);
+            merge_into(tree, src_child, dst_child);
+        }
+    }
+
+    /// Start a trace event, returns its index
+    size_t begin_event(const char *category, const std::string &name,
+                       const std::string &info, uint64_t time) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (generation != trace_generation) {
+            // The trace was restarted
+            events.clear();
+            generation = trace_generation;
+        }
+        events.push_back({ category, name, info, time, 0 });
+        return events.size() - 1;
+    }
+
+    /// End a trace event, unless the trace was restarted in the meantime
+    void end_event(size_t index, uint32_t gen, uint64_t time) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (gen == generation && index < events.size())
+            events[index].end = time;
+    }
+
+    static void add(std::atomic<uint64_t> &value, uint64_t amount) {
+        value.store(value.load(std::memory_order_relaxed) + amount,
+                    std::memory_order_relaxed);
+    }
+};
+
+static thread_local ThreadProfile thread_profile;
+
+/// Push the name of a phase onto the label prefix stack of the JIT backends
+static uint32_t kernel_label_push(ProfilerPhase phase) {
+    uint32_t backends = 0;
+#if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
+    for (JitBackend backend : { JitBackend::CUDA, JitBackend::LLVM }) {
+        if (jit_has_backend(backend)) {
+            jit_prefix_push(backend, profiler_phase_id[(int) phase]);
+            backends |= 1u << (uint32_t) backend;
+        }
+    }
+#else
+    (void) phase;
+#endif
+    return backends;
+}
+
+static void kernel_label_pop(uint32_t backends) {
+#if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
+    for (JitBackend backend : { JitBackend::CUDA, JitBackend::LLVM }) {
+        if (backends & (1u << (uint32_t) backend))
+            jit_prefix_pop(backend);
+    }
+#else
+    (void) backends;
+#endif
+}
+
+NAMESPACE_BEGIN(detail)
+void profiler_enter_phase(ProfilerPhase phase) {
+    ThreadProfile &tp = thread_profile;
+    uint32_t flags = profiler_flags.load(std::memory_order_relaxed);
+    uint64_t time = profiler_time();
+    ThreadProfile::Frame frame { phase, (uint32_t) -1, (size_t) -1, 0, time, 0 };
+
+    if (flags & ProfilerPhases) {
+        uint32_t parent = 0;
+        for (auto it = tp.stack.rbegin(); it != tp.stack.rend(); ++it) {
+            if (it->node != (uint32_t) -1) {
+                parent = it->node;
+                break;
+            }
+        }
+
+        uint32_t node = tp.nodes[parent].children[(int) phase];
+        if (unlikely(node == 0)) {
+            std::lock_guard<std::mutex> guard(tp.mutex);
+            node = (uint32_t) tp.nodes.size();
+            tp.nodes.emplace_back((int) phase);
+            tp.nodes[parent].children[(int) phase] = node;
+        }
+        frame.node = node;
+    }
+
+    if (flags & ProfilerTrace) {
+        frame.event = tp.begin_event("phase", profiler_phase_id[(int) phase], "", time);
+        frame.generation = tp.generation;
+    }
+
+    if (flags & ProfilerKernelLabels)
+        frame.labels = kernel_label_push(phase);
+
+    tp.stack.push_back(frame);
+}
+
+void profiler_leave_phase() {
+    ThreadProfile &tp = thread_profile;
+    ThreadProfile::Frame frame = tp.stack.back();
+    tp.stack.pop_back();
+    uint64_t time = profiler_time();
+
+    if (frame.node != (uint32_t) -1) {
+        ThreadProfile::Node &node = tp.nodes[frame.node];
+        ThreadProfile::add(node.time, time - frame.start);
+        ThreadProfile::add(node.count, 1);
+    }
+
+    if (frame.event != (size_t) -1)
+        tp.end_event(frame.event, frame.generation, time);
+
+    if (frame.labels)
+        kernel_label_pop(frame.labels);
+}
+NAMESPACE_END(detail)
+
+void Profiler::set_phase_profiling(bool enabled) {
+    if (enabled)
+        detail::profiler_flags.fetch_or(detail::ProfilerPhases);
+    else
+        detail::profiler_flags.fetch_and(~(uint32_t) detail::ProfilerPhases);
+}
+
+bool Profiler::phase_profiling() {
+    return detail::profiler_flags.load(std::memory_order_relaxed) &
+           detail::ProfilerPhases;
+}
+
+void Profiler::reset_phase_profile() {
+    std::lock_guard<std::mutex> guard(profile_mutex);
+    phase_profile_retired = PhaseTree();
+    for (ThreadProfile *tp : profile_threads) {
+        std::lock_guard<std::mutex> guard2(tp->mutex);
+        for (ThreadProfile::Node &node : tp->nodes) {
+            node.time.store(0, std::memory_order_relaxed);
+            node.count.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::string Profiler::phase_profile_report() {
+    PhaseTree tree;
+    {
+        std::lock_guard<std::mutex> guard(profile_mutex);
+        tree = phase_profile_retired;
+        for (ThreadProfile *tp : profile_threads)
+            tp->merge_into(tree);
+    }
+
+    uint64_t total = 0;
+    for (uint32_t child : tree.nodes[0].children)
+        if (child)
+            total += tree.nodes[child].time;
+
+    std::ostringstream oss;
+    oss << "Phase profile (" << util::time_string((float) (total / 1e6), true)
+        << " accumulated over all threads):" << std::endl;
+    if (total == 0)
+        return oss.str();
+
+    oss << "  " << std::left << std::setw(52) << "Phase" << std::right
+        << std::setw(9) << "Total" << std::setw(9) << "Self"
+        << std::setw(14) << "Count" << std::endl;
+
+    auto percent = [total](uint64_t time) {
+        std::ostringstream oss2;
+        oss2 << std::fixed << std::setprecision(1)
+             << (100.0 * (double) time / (double) total) << "%";
+        return oss2.str();
+    };
+
+    auto print = [&](auto &print_ref, uint32_t index, int depth) -> void {
+        const PhaseTree::Node &node = tree.nodes[index];
+
+        std::vector<uint32_t> children;
+        uint64_t children_time = 0;
+        for (uint32_t child : node.children) {
+            if (child && tree.nodes[child].count > 0) {
+                children.push_back(child);
+                children_time += tree.nodes[child].time;
+            }
+        }
+        std::sort(children.begin(), children.end(), [&](uint32_t a, uint32_t b) {
+            return tree.nodes[a].time > tree.nodes[b].time;
+        });
+
+        if (depth >= 0) {
+            std::string name = std::string(2 * depth, ' ') + profiler_phase_id[node.phase];
+            oss << "  " << std::left << std::setw(52) << name << std::right
+                << std::setw(9) << percent(node.time)
+                << std::setw(9) << percent(node.time - std::min(node.time, children_time))
+                << std::setw(14) << node.count << std::endl;
+        }
+
+        for (uint32_t child : children)
+            print_ref(print_ref, child, depth + 1);
+    };
+
+    print(print, 0, -1);
+    return oss.str();
+}
+
+void ScopedTraceEvent::begin(const char *category, const std::string &name,
+                             const std::string &info) {
+    ThreadProfile &tp = thread_profile;
+    m_index = tp.begin_event(category, name, info, profiler_time());
+    m_generation = tp.generation;
+}
+
+void ScopedTraceEvent::end() {
+    thread_profile.end_event(m_index, m_generation, profiler_time());
+}
+
+void ScopedTraceEvent::set_info(const std::string &info) {
+    if (!active())
+        return;
+    ThreadProfile &tp = thread_profile;
+    std::lock_guard<std::mutex> guard(tp.mutex);
+    if (m_generation == tp.generation && m_index < tp.events.size())
+        tp.events[m_index].info = info;
+}
+
+void Profiler::start_trace() {
+    {
+        std::lock_guard<std::mutex> guard(profile_mutex);
+        trace_retired.clear();
+        trace_generation++;
+        trace_start_time = profiler_time();
+    }
+    detail::profiler_flags.fetch_or(detail::ProfilerTrace);
+}
+
+void Profiler::stop_trace() {
+    detail::profiler_flags.fetch_and(~(uint32_t) detail::ProfilerTrace);
+}
+
+bool Profiler::tracing() {
+    return detail::profiler_flags.load(std::memory_order_relaxed) &
+           detail::ProfilerTrace;
+}
+
+/// Append a string to a JSON document
+static void json_string(std::ostringstream &oss, const std::string &str) {
+    oss << '"';
+    for (char c : str) {
+        switch (c) {
+            case '"':  oss << "\\\""; break;
+            case '\\': oss << "\\\\"; break;
+            case '\n': oss << "\\n"; break;
+            case '\t': oss << "\\t"; break;
+            default:
+                if ((unsigned char) c < 0x20)
+                    oss << tfm::format("\\u%04x", (int) c);
+                else
+                    oss << c;
+        }
+    }
+    oss << '"';
+}
+
+void Profiler::write_trace(const fs::path &path) {
+    std::vector<TraceTimeline> timelines;
+    uint64_t start, now = profiler_time();
+    {
+        std::lock_guard<std::mutex> guard(profile_mutex);
+        timelines = trace_retired;
+        for (ThreadProfile *tp : profile_threads) {
+            std::lock_guard<std::mutex> guard2(tp->mutex);
+            if (tp->generation == trace_generation && !tp->events.empty())
+                timelines.push_back({ tp->id, tp->name, tp->events });
+        }
+        start = trace_start_time;
+    }
+
+    std::ostringstream oss;
+    oss << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    auto separator = [&]() {
+        oss << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    // Time stamps and durations are specified in microseconds
+    auto micros = [](uint64_t ns) { return tfm::format("%.3f", ns / 1000.0); };
+
+    for (const TraceTimeline &timeline : timelines) {
+        separator();
+        oss << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": "
+            << timeline.id << ", \"args\": {\"name\": ";
+        json_string(oss, timeline.name);
+        oss << "}}";
+
+        for (const TraceEvent &event : timeline.events) {
+            uint64_t begin = std::max(event.begin, start),
+                     end   = std::max(event.end ? event.end : now, begin);
+            separator();
+            oss << "{\"name\": ";
+            json_string(oss, event.name);
+            oss << ", \"cat\": \"" << event.category << "\", \"ph\": \"X\", "
+                << "\"ts\": " << micros(begin - start) << ", "
+                << "\"dur\": " << micros(end - begin) << ", "
+                << "\"pid\": 0, \"tid\": " << timeline.id;
+            if (!event.info.empty()) {
+                oss << ", \"args\": {\"info\": ";
+                json_string(oss, event.info);
+                oss << "}";
+            }
+            oss << "}";
+        }
+    }
+    oss << "\n]}\n";
+
+    std::string str = oss.str();
+    ref<FileStream> fs = new FileStream(path, FileStream::ETruncReadWrite);
+    fs->write(str.data(), str.size());
+    fs->close();
+
+    Log(Info, "Wrote a trace with the timelines of %zu threads to \"%s\"",
+        timelines.size(), path.string());
+}
+
+//! @}
+// =======================================================================
+
+// =======================================================================
+//! @{ \name JIT kernel statistics
+// =======================================================================
+
+static std::atomic<bool> kernel_profiling_enabled { false };
+/// Is a ScopedKernelStatistics currently collecting the kernel history?
+static std::atomic<bool> kernel_statistics_active { false };
+static std::mutex kernel_statistics_mutex;
+static KernelStatistics kernel_statistics_phase[phase_count];
+/// Kernel execution time attributed to every phase (last entry: unattributed)
+static double kernel_phase_times[phase_count + 1] { };
+
+KernelStatistics &KernelStatistics::operator+=(const KernelStatistics &other) {
+    kernel_count += other.kernel_count;
+    cache_hits += other.cache_hits;
+    disk_cache_hits += other.disk_cache_hits;
+    codegen_time += other.codegen_time;
+    backend_time += other.backend_time;
+    execution_time += other.execution_time;
+    peak_memory = std::max(peak_memory, other.peak_memory);
+    return *this;
+}
+
+std::string KernelStatistics::to_string() const {
+    std::ostringstream oss;
+    oss << "Kernels: " << kernel_count << " launch"
+        << (kernel_count == 1 ? "" : "es") << " (" << std::fixed
+        << std::setprecision(1) << 100.0 * cache_hit_rate()
+        << "% cache hits, " << disk_cache_hits << " from disk), compilation "
+        << util::time_string((float) (codegen_time + backend_time), true)
+        << " (codegen " << util::time_string((float) codegen_time, true)
+        << ", backend " << util::time_string((float) backend_time, true)
+        << "), execution " << util::time_string((float) execution_time, true)
+        << ", tracked peak memory " << util::mem_string(peak_memory);
+    return oss.str();
+}
+
+void Profiler::set_kernel_profiling(bool enabled) {
+    kernel_profiling_enabled = enabled;
+}
+
+bool Profiler::kernel_profiling() {
+    return kernel_profiling_enabled;
+}
+
+KernelStatistics Profiler::kernel_statistics(ProfilerPhase phase) {
+    std::lock_guard<std::mutex> guard(kernel_statistics_mutex);
+    return kernel_statistics_phase[(int) phase];
+}
+
+void Profiler::reset_kernel_statistics() {
+    std::lock_guard<std::mutex> guard(kernel_statistics_mutex);
+    for (int i = 0; i < phase_count; ++i)
+        kernel_statistics_phase[i] = KernelStatistics();
+    for (int i = 0; i <= phase_count; ++i)
+        kernel_phase_times[i] = 0.0;
+}
+
+std::string Profiler::kernel_statistics_report() {
+    std::ostringstream oss;
+    oss << "Kernel statistics:";
+    std::lock_guard<std::mutex> guard(kernel_statistics_mutex);
+    for (int i = 0; i < phase_count; ++i) {
+        const KernelStatistics &ks = kernel_statistics_phase[i];
+        if (ks.kernel_count == 0)
+            continue;
+        oss << std::endl << "  " << profiler_phase_id[i] << ": "
+            << ks.to_string();
+    }
+    return oss.str();
+}
+
+void Profiler::set_kernel_instrumentation(bool enabled) {
+    if (enabled)
+        detail::profiler_flags.fetch_or(detail::ProfilerKernelLabels);
+    else
+        detail::profiler_flags.fetch_and(~(uint32_t) detail::ProfilerKernelLabels);
+}
+
+bool Profiler::kernel_instrumentation() {
+    return detail::profiler_flags.load(std::memory_order_relaxed) &
+           detail::ProfilerKernelLabels;
+}
+
+double Profiler::kernel_phase_time(ProfilerPhase phase) {
+    std::lock_guard<std::mutex> guard(kernel_statistics_mutex);
+    return kernel_phase_times[(int) phase];
+}
+
+std::string Profiler::kernel_phase_report() {
+    double times[phase_count + 1];
+    {
+        std::lock_guard<std::mutex> guard(kernel_statistics_mutex);
+        std::copy(kernel_phase_times, kernel_phase_times + phase_count + 1, times);
+    }
+
+    double total = 0.0;
+    std::vector<int> phases;
+    for (int i = 0; i <= phase_count; ++i) {
+        total += times[i];
+        if (times[i] > 0.0)
+            phases.push_back(i);
+    }
+    std::sort(phases.begin(), phases.end(),
+              [&](int a, int b) { return times[a] > times[b]; });
+
+    std::ostringstream oss;
+    oss << "Kernel execution time per phase ("
+        << util::time_string((float) total, true) << " in total):";
+    for (int i : phases)
+        oss << std::endl << "  " << std::left << std::setw(52)
+            << (i < phase_count ? profiler_phase_id[i] : "(unattributed)")
+            << std::right << std::setw(12)
+            << util::time_string((float) times[i], true) << std::setw(9)
+            << std::fixed << std::setprecision(1)
+            << 100.0 * times[i] / total << "%";
+    return oss.str();
+}
+
+#if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
+/**
+ * Split the execution time of a kernel among the phases whose labels occur in
+ * comments of its IR ('ir'), in proportion to the number of instructions
+ * following each label. Holds 'kernel_statistics_mutex'.
+ */
+static void kernel_attribute(const char *ir, double time) {
+    uint64_t counts[phase_count + 1] { }, total = 0;
+    int current = phase_count;
+
+    for (const char *line = ir; *line; ) {
+        const char *end = std::strchr(line, '\n');
+        if (!end)
+            end = line + std::strlen(line);
+        while (line < end && std::isspace((unsigned char) *line))
+            ++line;
+
+        std::string_view str(line, end - line);
+        if (str.substr(0, 1) == ";" || str.substr(0, 2) == "//") {
+            // The innermost phase is the last one of the label
+            size_t best = std::string_view::npos;
+            current = phase_count;
+            for (int i = 0; i < phase_count; ++i) {
+                size_t pos = str.rfind(profiler_phase_id[i]);
+                if (pos != std::string_view::npos &&
+                    (best == std::string_view::npos || pos > best)) {
+                    best = pos;
+                    current = i;
+                }
+            }
+        } else if (!str.empty() && str.back() != ':' && str != "}" &&
+                   str != "{") {
+            counts[current]++;
+            total++;
+        }
+
+        line = *end ? end + 1 : end;
+    }
+
+    if (total == 0) {
+        kernel_phase_times[phase_count] += time;
+        return;
+    }
+    for (int i = 0; i <= phase_count; ++i)
+        kernel_phase_times[i] += time * (double) counts[i] / (double) total;
+}
+
+/// Fetch and clear the kernel history of Dr.Jit
+static void kernel_history(KernelStatistics *stats) {
+    KernelHistoryEntry *data = jit_kernel_history();
+    bool instrumented = stats && Profiler::kernel_instrumentation();
+    std::unique_lock<std::mutex> guard(kernel_statistics_mutex, std::defer_lock);
+    if (instrumented)
+        guard.lock();
+
+    for (KernelHistoryEntry *e = data; e && (uint32_t) e->backend; ++e) {
+        if (instrumented) {
+            if (e->type == KernelType::JIT && e->ir)
+                kernel_attribute(e->ir, e->execution_time);
+            else
+                kernel_phase_times[phase_count] += e->execution_time;
+        }
+        if (stats) {
+            stats->kernel_count++;
+            if (e->type == KernelType::JIT && e->cache_hit) {
+                stats->cache_hits++;
+                if (e->cache_disk)
+                    stats->disk_cache_hits++;
+            }
+            stats->codegen_time += e->codegen_time;
+            stats->backend_time += e->backend_time;
+            stats->execution_time += e->execution_time;
+        }
+        free(e->ir);
+    }
+    free(data);
+}
+#endif
+
+ScopedKernelStatistics::ScopedKernelStatistics(ProfilerPhase phase,
+                                               uint32_t backend)
+    : m_phase(phase), m_backend(backend) {
+#if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
+    bool expected = false;
+    if (!backend ||
+        !(Profiler::kernel_profiling() || Profiler::kernel_instrumentation()) ||
+        !kernel_statistics_active.compare_exchange_strong(expected, true))
+        return;
+
+    m_active = true;
+    m_history_flag = jit_flag(JitFlag::KernelHistory);
+
+    // Discard the kernels launched so far, and start recording new ones
+    kernel_history(nullptr);
+    jit_set_flag(JitFlag::KernelHistory, true);
+    MemoryTracker::reset_peak_usage();
+#endif
+}
+
+const KernelStatistics &ScopedKernelStatistics::finish() {
+#if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
+    if (!m_active)
+        return m_stats;
+
+    jit_sync_thread();
+    kernel_history(&m_stats);
+    m_stats.peak_memory = MemoryTracker::peak_total_usage(
+        m_backend == (uint32_t) JitBackend::CUDA);
+    jit_set_flag(JitFlag::KernelHistory, m_history_flag);
+
+    {
+        std::lock_guard<std::mutex> guard(kernel_statistics_mutex);
+        kernel_statistics_phase[(int) m_phase] += m_stats;
+    }
+
+    m_active = false;
+    kernel_statistics_active = false;
+#endif
+    return m_stats;
+}
+
+//! @}
+// =======================================================================
 
 NAMESPACE_END(mitsuba)
@@ -1,11 +1,11 @@
 #if defined(_MSC_VER)
-#  pragma warning (disable: 4324) // warning C4324: 'std::pair<const std::string,mitsuba::Entry>': structure was padded due to alignment specifier
+#  pragma warning (disable: 4324) // warning C4324: 'mitsuba::NamedEntry': structure was padded due to alignment specifier
 #  define _ENABLE_EXTENDED_ALIGNED_STORAGE
 #endif
 
 #include <cstdlib>
 #include <iostream>
-#include <map>
+#include <algorithm>
 #include <sstream>
 #include <cstring>
 #include <climits>
@@ -73,22 +73,120 @@ struct SortKey {
     }
 };
 
+/**
+ * Entries are stored in a flat array in the order of their insertion, which
+ * makes copying cheap. Small property sets are searched linearly. Larger ones
+ * (e.g. the children of a scene) additionally maintain an open-addressing
+ * hash table that maps keys to positions in the array. Functions that iterate
+ * over the entries visit them in the order given by \ref SortKey.
+ */
+struct NamedEntry {
+    std::string name;
+    uint64_t hash;
+    Entry entry;
+};
+
+/// Property sets up to this size are searched without a hash table
+static constexpr size_t PropertiesLinearSearch = 8;
+
+/// 64 bit FNV-1a hash of a property name
+static uint64_t property_hash(const std::string &name) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : name)
+        hash = (hash ^ (uint8_t) c) * 0x100000001b3ull;
+    return hash;
+}
+
 struct Properties::PropertiesPrivate {
-    std::map<std::string, Entry, SortKey> entries;
+    std::vector<NamedEntry> entries;
+    /// Hash table storing entry indices + 1 (0 denotes an empty slot)
+    std::vector<uint32_t> table;
     std::string id, plugin_name;
+
+    NamedEntry *find(const std::string &name) {
+        if (table.empty()) {
+            for (NamedEntry &item : entries) {
+                if (item.name == name)
+                    return &item;
+            }
+            return nullptr;
+        }
+
+        uint64_t hash = property_hash(name);
+        size_t mask = table.size() - 1;
+        for (size_t i = (size_t) hash & mask; table[i] != 0; i = (i + 1) & mask) {
+            NamedEntry &item = entries[table[i] - 1];
+            if (item.hash == hash && item.name == name)
+                return &item;
+        }
+        return nullptr;
+    }
+
+    /// Return the entry with the given name, creating it if necessary
+    Entry &insert(const std::string &name) {
+        NamedEntry *item = find(name);
+        if (item)
+            return item->entry;
+
+        entries.push_back(NamedEntry{ name, property_hash(name), Entry() });
+        if (entries.size() > PropertiesLinearSearch) {
+            if (entries.size() * 2 > table.size())
+                rebuild_table();
+            else
+                insert_table(entries.size() - 1);
+        }
+        return entries.back().entry;
+    }
+
+    void erase(NamedEntry *item) {
+        entries.erase(entries.begin() + (item - entries.data()));
+        rebuild_table();
+    }
+
+    void insert_table(size_t index) {
+        size_t mask = table.size() - 1;
+        size_t i = (size_t) entries[index].hash & mask;
+        while (table[i] != 0)
+            i = (i + 1) & mask;
+        table[i] = (uint32_t) index + 1;
+    }
+
+    void rebuild_table() {
+        table.clear();
+        if (entries.size() <= PropertiesLinearSearch)
+            return;
+        size_t size = 16;
+        while (size < entries.size() * 4)
+            size *= 2;
+        table.resize(size, 0);
+        for (size_t i = 0; i < entries.size(); ++i)
+            insert_table(i);
+    }
+
+    /// Return pointers to all entries in the order given by SortKey
+    std::vector<NamedEntry *> sorted() {
+        std::vector<NamedEntry *> result;
+        result.reserve(entries.size());
+        for (NamedEntry &item : entries)
+            result.push_back(&item);
+        std::sort(result.begin(), result.end(), [](const NamedEntry *a, const NamedEntry *b) {
+            return SortKey()(a->name, b->name);
+        });
+        return result;
+    }
 };
 
-using Iterator = typename std::map<std::string, Entry, SortKey>::iterator;
+using Iterator = NamedEntry *;
 
 template <typename T, typename T2 = T>
 T get_impl(const Iterator &it) {
-    if (!it->second.data.template is<T>() && !it->second.data.template is<T2>())
+    if (!it->entry.data.template is<T>() && !it->entry.data.template is<T2>())
         Throw("The property \"%s\" has the wrong type (expected <%s> or <%s>, is <%s>)",
-              it->first, typeid(T).name(), typeid(T2).name(), it->second.data.type().name());
-    it->second.queried = true;
-    if (it->second.data.template is<T2>())
-        return (T const &) (T2 const &) it->second.data;
-    return (T const &) it->second.data;
+              it->name, typeid(T).name(), typeid(T2).name(), it->entry.data.type().name());
+    it->entry.queried = true;
+    if (it->entry.data.template is<T2>())
+        return (T const &) (T2 const &) it->entry.data;
+    return (T const &) it->entry.data;
 }
 
 
@@ -99,13 +197,13 @@ T get_impl(const Iterator &it) {
  */
 template<>
 Transform3f get_impl<Transform3f, Transform4f>(const Iterator &it) {
-    if (!it->second.data.template is<Transform3f>() && !it->second.data.template is<Transform4f>())
+    if (!it->entry.data.template is<Transform3f>() && !it->entry.data.template is<Transform4f>())
         Throw("The property \"%s\" has the wrong type (expected <%s> or <%s>, is <%s>)",
-              it->first, typeid(Transform3f).name(), typeid(Transform4f).name(), it->second.data.type().name());
-    it->second.queried = true;
-    if (it->second.data.template is<Transform4f>())
-        return ((Transform4f const &)it->second.data).extract();
-    return (Transform3f const &) it->second.data;
+              it->name, typeid(Transform3f).name(), typeid(Transform4f).name(), it->entry.data.type().name());
+    it->entry.queried = true;
+    if (it->entry.data.template is<Transform4f>())
+        return ((Transform4f const &)it->entry.data).extract();
+    return (Transform3f const &) it->entry.data;
 }
 
 template <typename T>
@@ -144,7 +242,7 @@ T get_routing(const Iterator &it) {
         if constexpr (std::is_unsigned_v<T>) {
             if (v < 0) {
                 Throw("Property \"%s\" has negative value %i, but was queried as a"
-                    " size_t (unsigned).", it->first, v);
+                    " size_t (unsigned).", it->name, v);
             }
         }
         return (T) v;
@@ -158,16 +256,16 @@ T get_routing(const Iterator &it) {
 
 template <typename T>
 T Properties::get(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Iterator it = d->find(name);
+    if (!it)
         Throw("Property \"%s\" has not been specified!", name);
     return get_routing<T>(it);
 }
 
 template <typename T>
 T Properties::get(const std::string &name, const T &def_val) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Iterator it = d->find(name);
+    if (!it)
         return def_val;
     return get_routing<T>(it);
 }
@@ -175,31 +273,32 @@ T Properties::get(const std::string &name, const T &def_val) const {
     void Properties::SetterName(const std::string &name, Type const &value, bool error_duplicates) { \
         if (has_property(name) && error_duplicates) \
             Log(Error, "Property \"%s\" was specified multiple times!", name); \
-        d->entries[name].data = (Type) value; \
-        d->entries[name].queried = false; \
+        Entry &entry = d->insert(name); \
+        entry.data = (Type) value; \
+        entry.queried = false; \
     }
 
 #define DEFINE_PROPERTY_ACCESSOR(Type, TagName, SetterName, GetterName) \
     DEFINE_PROPERTY_SETTER(Type, SetterName) \
     \
     Type const & Properties::GetterName(const std::string &name) const { \
-        const auto it = d->entries.find(name); \
-        if (it == d->entries.end()) \
+        Iterator it = d->find(name); \
+        if (!it) \
             Throw("Property \"%s\" has not been specified!", name); \
-        if (!it->second.data.is<Type>()) \
+        if (!it->entry.data.is<Type>()) \
             Throw("The property \"%s\" has the wrong type (expected <" #TagName ">).", name); \
-        it->second.queried = true; \
-        return (Type const &) it->second.data; \
+        it->entry.queried = true; \
+        return (Type const &) it->entry.data; \
     } \
     \
     Type const & Properties::GetterName(const std::string &name, Type const &def_val) const { \
-        const auto it = d->entries.find(name); \
-        if (it == d->entries.end()) \
+        Iterator it = d->find(name); \
+        if (!it) \
             return def_val; \
-        if (!it->second.data.is<Type>()) \
+        if (!it->entry.data.is<Type>()) \
             Throw("The property \"%s\" has the wrong type (expected <" #TagName ">).", name); \
-        it->second.queried = true; \
-        return (Type const &) it->second.data; \
+        it->entry.queried = true; \
+        return (Type const &) it->entry.data; \
     }
 
 DEFINE_PROPERTY_SETTER(bool,         set_bool)
@@ -216,15 +315,15 @@ DEFINE_PROPERTY_ACCESSOR(const void *,   pointer, set_pointer,         pointer)
 // See at the end of the file for custom-defined accessors.
 
 Properties::Properties()
-    : d(new PropertiesPrivate()) { }
+    : d(std::make_shared<PropertiesPrivate>()) { }
 
 Properties::Properties(const std::string &plugin_name)
-    : d(new PropertiesPrivate()) {
+    : d(std::make_shared<PropertiesPrivate>()) {
     d->plugin_name = plugin_name;
 }
 
 Properties::Properties(const Properties &props)
-    : d(new PropertiesPrivate(*props.d)) { }
+    : d(std::make_shared<PropertiesPrivate>(*props.d)) { }
 
 Properties::~Properties() { }
 
@@ -237,7 +336,7 @@ void Properties::operator=(const Properties &props) {
 }
 
 bool Properties::has_property(const std::string &name) const {
-    return d->entries.find(name) != d->entries.end();
+    return d->find(name) != nullptr;
 }
 
 namespace {
@@ -278,33 +377,33 @@ namespace {
 }
 
 Properties::Type Properties::type(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Iterator it = d->find(name);
+    if (!it)
         Throw("type(): Could not find property named \"%s\"!", name);
 
-    return it->second.data.visit(PropertyTypeVisitor());
+    return it->entry.data.visit(PropertyTypeVisitor());
 }
 
 bool Properties::mark_queried(const std::string &name) const {
-    auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Iterator it = d->find(name);
+    if (!it)
         return false;
-    it->second.queried = true;
+    it->entry.queried = true;
     return true;
 }
 
 bool Properties::was_queried(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Iterator it = d->find(name);
+    if (!it)
         Throw("Could not find property named \"%s\"!", name);
-    return it->second.queried;
+    return it->entry.queried;
 }
 
 bool Properties::remove_property(const std::string &name) {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Iterator it = d->find(name);
+    if (!it)
         return false;
-    d->entries.erase(it);
+    d->erase(it);
     return true;
 }
 
@@ -327,29 +426,31 @@ void Properties::set_id(const std::string &id) {
 void Properties::copy_attribute(const Properties &properties,
                                 const std::string &source_name,
                                 const std::string &target_name) {
-    const auto it = properties.d->entries.find(source_name);
-    if (it == properties.d->entries.end())
+    Iterator it = properties.d->find(source_name);
+    if (!it)
         Throw("copy_attribute(): Could not find parameter \"%s\"!", source_name);
-    d->entries[target_name] = it->second;
+    Entry entry = it->entry;
+    d->insert(target_name) = std::move(entry);
 }
 
 std::vector<std::string> Properties::property_names() const {
     std::vector<std::string> result;
-    for (const auto &e : d->entries)
-        result.push_back(e.first);
+    result.reserve(d->entries.size());
+    for (const NamedEntry *item : d->sorted())
+        result.push_back(item->name);
     return result;
 }
 
 std::vector<std::pair<std::string, NamedReference>> Properties::named_references() const {
     std::vector<std::pair<std::string, NamedReference>> result;
     result.reserve(d->entries.size());
-    for (auto &e : d->entries) {
-        auto type = e.second.data.visit(PropertyTypeVisitor());
+    for (NamedEntry *item : d->sorted()) {
+        auto type = item->entry.data.visit(PropertyTypeVisitor());
         if (type != Type::NamedReference)
             continue;
-        auto const &value = (const NamedReference &) e.second.data;
-        result.push_back(std::make_pair(e.first, value));
-        e.second.queried = true;
+        auto const &value = (const NamedReference &) item->entry.data;
+        result.push_back(std::make_pair(item->name, value));
+        item->entry.queried = true;
     }
     return result;
 }
@@ -357,29 +458,31 @@ std::vector<std::pair<std::string, NamedReference>> Properties::named_references
 std::vector<std::pair<std::string, ref<Object>>> Properties::objects(bool mark_queried) const {
     std::vector<std::pair<std::string, ref<Object>>> result;
     result.reserve(d->entries.size());
-    for (auto &e : d->entries) {
-        auto type = e.second.data.visit(PropertyTypeVisitor());
+    for (NamedEntry *item : d->sorted()) {
+        auto type = item->entry.data.visit(PropertyTypeVisitor());
         if (type != Type::Object)
             continue;
-        result.push_back(std::make_pair(e.first, (const ref<Object> &) e.second));
+        result.push_back(std::make_pair(item->name, (const ref<Object> &) item->entry.data));
         if (mark_queried)
-            e.second.queried = true;
+            item->entry.queried = true;
     }
     return result;
 }
 
 std::vector<std::string> Properties::unqueried() const {
     std::vector<std::string> result;
-    for (const auto &e : d->entries) {
-        if (!e.second.queried)
-            result.push_back(e.first);
+    for (const NamedEntry *item : d->sorted()) {
+        if (!item->entry.queried)
+            result.push_back(item->name);
     }
     return result;
 }
 
 void Properties::merge(const Properties &p) {
-    for (const auto &e : p.d->entries)
-        d->entries[e.first] = e.second;
+    if (d == p.d)
+        return;
+    for (const NamedEntry &item : p.d->entries)
+        d->insert(item.name) = item.entry;
 }
 
 bool Properties::operator==(const Properties &p) const {
@@ -388,11 +491,11 @@ bool Properties::operator==(const Properties &p) const {
         d->entries.size() != p.d->entries.size())
         return false;
 
-    for (const auto &e : d->entries) {
-        auto it = p.d->entries.find(e.first);
-        if (it == p.d->entries.end())
+    for (const NamedEntry &item : d->entries) {
+        Iterator it = p.d->find(item.name);
+        if (!it)
             return false;
-        if (e.second.data != it->second.data)
+        if (item.entry.data != it->entry.data)
             return false;
     }
 
@@ -400,46 +503,34 @@ bool Properties::operator==(const Properties &p) const {
 }
 
 std::string Properties::as_string(const std::string &name) const {
+    Iterator it = d->find(name);
+    if (!it)
+        Throw("Property \"%s\" has not been specified!", name);
     std::ostringstream oss;
-    bool found = false;
-    for (auto &e : d->entries) {
-        if (e.first != name)
-            continue;
-        e.second.data.visit(StreamVisitor(oss));
-        found = true;
-        break;
-    }
-    if (!found)
-        Throw("Property \"%s\" has not been specified!", name); \
+    it->entry.data.visit(StreamVisitor(oss));
     return oss.str();
 }
 
 std::string Properties::as_string(const std::string &name, const std::string &def_val) const {
-    std::ostringstream oss;
-    bool found = false;
-    for (auto &e : d->entries) {
-        if (e.first != name)
-            continue;
-        e.second.data.visit(StreamVisitor(oss));
-        found = true;
-        break;
-    }
-    if (!found)
+    Iterator it = d->find(name);
+    if (!it)
         return def_val;
+    std::ostringstream oss;
+    it->entry.data.visit(StreamVisitor(oss));
     return oss.str();
 }
 
 std::ostream &operator<<(std::ostream &os, const Properties &p) {
-    auto it = p.d->entries.begin();
+    std::vector<NamedEntry *> items = p.d->sorted();
 
     os << "Properties[" << std::endl
        << "  plugin_name = \"" << (p.d->plugin_name) << "\"," << std::endl
        << "  id = \"" << p.d->id << "\"," << std::endl
        << "  elements = {" << std::endl;
-    while (it != p.d->entries.end()) {
-        os << "    \"" << it->first << "\" -> ";
-        it->second.data.visit(StreamVisitor(os));
-        if (++it != p.d->entries.end()) os << ",";
+    for (size_t i = 0; i < items.size(); ++i) {
+        os << "    \"" << items[i]->name << "\" -> ";
+        items[i]->entry.data.visit(StreamVisitor(os));
+        if (i + 1 < items.size()) os << ",";
         os << std::endl;
     }
     os << "  }" << std::endl
@@ -456,16 +547,18 @@ std::ostream &operator<<(std::ostream &os, const Properties &p) {
 void Properties::set_float(const std::string &name, const Float &value, bool error_duplicates) {
     if (has_property(name) && error_duplicates)
         Log(Error, "Property \"%s\" was specified multiple times!", name);
-    d->entries[name].data = (Float) value;
-    d->entries[name].queried = false;
+    Entry &entry = d->insert(name);
+    entry.data = (Float) value;
+    entry.queried = false;
 }
 
 /// Array3f setter
 void Properties::set_array3f(const std::string &name, const Array3f &value, bool error_duplicates) {
     if (has_property(name) && error_duplicates)
         Log(Error, "Property \"%s\" was specified multiple times!", name);
-    d->entries[name].data = (Array3f) value;
-    d->entries[name].queried = false;
+    Entry &entry = d->insert(name);
+    entry.data = (Array3f) value;
+    entry.queried = false;
 }
 
 #if 0
@@ -489,50 +582,50 @@ void Properties::set_animated_transform(const std::string &name,
 
 /// AnimatedTransform getter (without default value).
 ref<AnimatedTransform> Properties::animated_transform(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Iterator it = d->find(name);
+    if (!it)
         Throw("Property \"%s\" has not been specified!", name);
-    if (it->second.data.is<Transform4f>()) {
+    if (it->entry.data.is<Transform4f>()) {
         // Also accept simple transforms, from which we can build
         // an AnimatedTransform.
-        it->second.queried = true;
+        it->entry.queried = true;
         return new AnimatedTransform(
-            static_cast<const Transform4f &>(it->second.data));
+            static_cast<const Transform4f &>(it->entry.data));
     }
-    if (!it->second.data.is<ref<Object>>()) {
+    if (!it->entry.data.is<ref<Object>>()) {
         Throw("The property \"%s\" has the wrong type (expected "
               " <animated_transform> or <transform>).", name);
     }
-    ref<Object> o = it->second.data;
+    ref<Object> o = it->entry.data;
     if (!o->class_()->derives_from(MI_CLASS(AnimatedTransform)))
         Throw("The property \"%s\" has the wrong type (expected "
               " <animated_transform> or <transform>).", name);
-    it->second.queried = true;
+    it->entry.queried = true;
     return (AnimatedTransform *) o.get();
 }
 
 /// AnimatedTransform getter (with default value).
 ref<AnimatedTransform> Properties::animated_transform(
         const std::string &name, ref<AnimatedTransform> def_val) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Iterator it = d->find(name);
+    if (!it)
         return def_val;
-    if (it->second.data.is<Transform4f>()) {
+    if (it->entry.data.is<Transform4f>()) {
         // Also accept simple transforms, from which we can build
         // an AnimatedTransform.
-        it->second.queried = true;
+        it->entry.queried = true;
         return new AnimatedTransform(
-            static_cast<const Transform4f &>(it->second.data));
+            static_cast<const Transform4f &>(it->entry.data));
     }
-    if (!it->second.data.is<ref<Object>>()) {
+    if (!it->entry.data.is<ref<Object>>()) {
         Throw("The property \"%s\" has the wrong type (expected "
               " <animated_transform> or <transform>).", name);
     }
-    ref<Object> o = it->second.data;
+    ref<Object> o = it->entry.data;
     if (!o->class_()->derives_from(MI_CLASS(AnimatedTransform)))
         Throw("The property \"%s\" has the wrong type (expected "
               " <animated_transform> or <transform>).", name);
-    it->second.queried = true;
+    it->entry.queried = true;
     return (AnimatedTransform *) o.get();
 }
 
@@ -544,14 +637,14 @@ ref<AnimatedTransform> Properties::animated_transform(
 #endif
 
 ref<Object> Properties::find_object(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Iterator it = d->find(name);
+    if (!it)
         return ref<Object>();
 
-    if (!it->second.data.is<ref<Object>>())
+    if (!it->entry.data.is<ref<Object>>())
         Throw("The property \"%s\" has the wrong type.", name);
 
-    return it->second.data;
+    return it->entry.data;
 }
 
 #define EXPORT_PROPERTY_ACCESSOR(T) \
@@ -5,6 +5,7 @@
 #include <mitsuba/core/mstream.h>
 #include <mitsuba/python/python.h>
 #include <string>
+#include <tuple>
 #include <drjit/python.h>
 #include <nanobind/ndarray.h>
 #include <nanobind/stl/string.h>
@@ -28,9 +29,9 @@ namespace nanobind {
 
 using ContigCpuNdArray = nb::ndarray<nb::device::cpu, nb::c_contig>;
 
-void from_cpu_dlpack(Bitmap *b, ContigCpuNdArray data,
-                     nb::object pixel_format_,
-                     const std::vector<std::string> &channel_names) {
+/// Pixel format, component format, size and channel count of a Bitmap holding an array
+std::tuple<Bitmap::PixelFormat, Struct::Type, Bitmap::Vector2u, size_t>
+array_format(const ContigCpuNdArray &data, nb::object pixel_format_) {
         using Float = typename Bitmap::Float;
         MI_IMPORT_CORE_TYPES()
 
@@ -93,7 +94,15 @@ void from_cpu_dlpack(Bitmap *b, ContigCpuNdArray data,
         if (!pixel_format_.is_none())
             pixel_format = nb::cast<Bitmap::PixelFormat>(pixel_format_);
 
-        ScalarVector2u size(shape[1], shape[0]);
+        return { pixel_format, component_format,
+                 ScalarVector2u(shape[1], shape[0]), channel_count };
+}
+
+void from_cpu_dlpack(Bitmap *b, ContigCpuNdArray data,
+                     nb::object pixel_format_,
+                     const std::vector<std::string> &channel_names) {
+        auto [pixel_format, component_format, size, channel_count] =
+            array_format(data, pixel_format_);
         new (b) Bitmap(pixel_format, component_format, size, channel_count,
                        channel_names);
 
@@ -262,6 +271,24 @@ MI_PY_EXPORT(Bitmap) {
                  &Bitmap::write_async, nb::const_),
              "path"_a, "format"_a = Bitmap::FileFormat::Auto, "quality"_a = -1,
              D(Bitmap, write_async))
+        .def_static("write_exr_multipart",
+             nb::overload_cast<const fs::path &,
+                               const std::vector<std::pair<std::string, ref<Bitmap>>> &,
+                               int>(&Bitmap::write_exr_multipart),
+             "path"_a, "parts"_a, "quality"_a = -1,
+             D(Bitmap, write_exr_multipart, 2),
+             nb::call_guard<nb::gil_scoped_release>())
+        .def_static("set_exr_tile_size", &Bitmap::set_exr_tile_size, "size"_a,
+                    D(Bitmap, set_exr_tile_size))
+        .def_static("exr_tile_size", &Bitmap::exr_tile_size, D(Bitmap, exr_tile_size))
+        .def_static("set_exr_thread_count", &Bitmap::set_exr_thread_count,
+                    "count"_a, D(Bitmap, set_exr_thread_count))
+        .def_static("exr_thread_count", &Bitmap::exr_thread_count,
+                    D(Bitmap, exr_thread_count))
+        .def_static("set_async_write_limit", &Bitmap::set_async_write_limit,
+                    "limit"_a, D(Bitmap, set_async_write_limit))
+        .def_static("async_write_limit", &Bitmap::async_write_limit,
+                    D(Bitmap, async_write_limit))
         .def("split", &Bitmap::split, D(Bitmap, split))
         .def_static("detect_file_format", &Bitmap::detect_file_format,
                     D(Bitmap, detect_file_format))
@@ -380,6 +407,27 @@ MI_PY_EXPORT(Bitmap) {
         "Initialize a Bitmap from any array that implements the buffer or "
         "DLPack protocol.");
 
+    /**
+     * Python only zero-copy constructor for CPU arrays
+     */
+    bitmap.def_static(
+        "from_dlpack",
+        [](ContigCpuNdArray data, nb::object pixel_format_,
+           const std::vector<std::string> &channel_names) {
+            auto [pixel_format, component_format, size, channel_count] =
+                array_format(data, pixel_format_);
+            return ref<Bitmap>(new Bitmap(pixel_format, component_format, size,
+                                          channel_count, channel_names,
+                                          (uint8_t *) data.data()));
+        },
+        "array"_a, "pixel_format"_a = nb::none(),
+        "channel_names"_a = std::vector<std::string>(),
+        nb::keep_alive<0, 1>(),
+        "Create a Bitmap that shares the memory of a C-contiguous CPU array "
+        "implementing the buffer or DLPack protocol, without copying it. The "
+        "array is kept alive as long as the bitmap, and writes through "
+        "either of them are visible in the other one.");
+
     /**
      * Python only constructor for Dr.Jit tensor types
      */
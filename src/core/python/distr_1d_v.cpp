@@ -17,7 +17,8 @@ MI_PY_EXPORT(DiscreteDistribution) {
         MI_PY_STRUCT(DiscreteDistribution)
             .def(nb::init<>(), D(DiscreteDistribution))
             .def(nb::init<const DiscreteDistribution &>(), "Copy constructor")
-            .def(nb::init<const FloatStorage &>(), "pmf"_a,
+            .def(nb::init<const FloatStorage &, bool>(), "pmf"_a,
+                 "alias_table"_a = false,
                  D(DiscreteDistribution, DiscreteDistribution, 2))
             .def("__len__", &DiscreteDistribution::size)
             .def("size", &DiscreteDistribution::size, D(DiscreteDistribution, size))
@@ -39,6 +40,8 @@ MI_PY_EXPORT(DiscreteDistribution) {
             .def("eval_cdf_normalized", &DiscreteDistribution::eval_cdf_normalized,
                  "index"_a, "active"_a = true, D(DiscreteDistribution, eval_cdf_normalized))
             .def_method(DiscreteDistribution, update)
+            .def_method(DiscreteDistribution, has_alias_table)
+            .def_method(DiscreteDistribution, set_alias_table, "value"_a)
             .def_method(DiscreteDistribution, normalization)
             .def_method(DiscreteDistribution, sum)
             .def("sample",
@@ -57,6 +60,48 @@ MI_PY_EXPORT(DiscreteDistribution) {
     }
 }
 
+MI_PY_EXPORT(FenwickDistribution) {
+    MI_PY_IMPORT_TYPES()
+
+    using FenwickDistribution = mitsuba::FenwickDistribution<Float>;
+    using FloatStorage = DynamicBuffer<Float>;
+
+    MI_PY_CHECK_ALIAS(FenwickDistribution, "FenwickDistribution") {
+        MI_PY_STRUCT(FenwickDistribution)
+            .def(nb::init<>(), D(FenwickDistribution))
+            .def(nb::init<const FenwickDistribution &>(), "Copy constructor")
+            .def(nb::init<const FloatStorage &>(), "pmf"_a,
+                 D(FenwickDistribution, FenwickDistribution, 2))
+            .def("__len__", &FenwickDistribution::size)
+            .def("size", &FenwickDistribution::size, D(FenwickDistribution, size))
+            .def("empty", &FenwickDistribution::empty, D(FenwickDistribution, empty))
+            .def_prop_ro("pmf",
+              [](FenwickDistribution &t) { return t.pmf(); },
+              D(FenwickDistribution, pmf))
+            .def_prop_ro("tree",
+              [](FenwickDistribution &t) { return t.tree(); },
+              D(FenwickDistribution, tree))
+            .def("eval_pmf", &FenwickDistribution::eval_pmf,
+                 "index"_a, "active"_a = true, D(FenwickDistribution, eval_pmf))
+            .def("eval_pmf_normalized", &FenwickDistribution::eval_pmf_normalized,
+                 "index"_a, "active"_a = true, D(FenwickDistribution, eval_pmf_normalized))
+            .def_method(FenwickDistribution, set, "index"_a, "value"_a)
+            .def_method(FenwickDistribution, update)
+            .def_method(FenwickDistribution, normalization)
+            .def_method(FenwickDistribution, sum)
+            .def("sample",
+                &FenwickDistribution::sample,
+                "value"_a, "active"_a = true, D(FenwickDistribution, sample))
+            .def("sample_reuse",
+                &FenwickDistribution::sample_reuse,
+                "value"_a, "active"_a = true, D(FenwickDistribution, sample_reuse))
+            .def("sample_reuse_pmf",
+                &FenwickDistribution::sample_reuse_pmf,
+                "value"_a, "active"_a = true, D(FenwickDistribution, sample_reuse_pmf))
+            .def_repr(FenwickDistribution);
+    }
+}
+
 MI_PY_EXPORT(ContinuousDistribution) {
     MI_PY_IMPORT_TYPES()
 
@@ -57,6 +57,10 @@ MI_PY_EXPORT(Logger) {
         .def("appender", (Appender * (Logger::*)(size_t)) &Logger::appender, D(Logger, appender))
         .def("formatter", (Formatter * (Logger::*)()) &Logger::formatter, D(Logger, formatter))
         .def_method(Logger, set_formatter)
+        .def_method(Logger, set_asynchronous, "value"_a,
+                    nb::call_guard<nb::gil_scoped_release>())
+        .def_method(Logger, asynchronous)
+        .def_method(Logger, flush, nb::call_guard<nb::gil_scoped_release>())
         .def_method(Logger, read_log);
 
     m.def("Log", &PyLog, "level"_a, "msg"_a);
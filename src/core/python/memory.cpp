@@ -0,0 +1,24 @@
+#include <mitsuba/core/memory.h>
+#include <mitsuba/python/python.h>
+#include <nanobind/stl/string.h>
+
+MI_PY_EXPORT(MemoryTracker) {
+    nb::enum_<MemoryCategory>(m, "MemoryCategory", D(MemoryCategory))
+        .value("Mesh", MemoryCategory::Mesh, D(MemoryCategory, Mesh))
+        .value("Bitmap", MemoryCategory::Bitmap, D(MemoryCategory, Bitmap))
+        .value("VolumeGrid", MemoryCategory::VolumeGrid, D(MemoryCategory, VolumeGrid))
+        .value("KDTree", MemoryCategory::KDTree, D(MemoryCategory, KDTree))
+        .value("Embree", MemoryCategory::Embree, D(MemoryCategory, Embree))
+        .value("OptiX", MemoryCategory::OptiX, D(MemoryCategory, OptiX))
+        .value("ImageBlock", MemoryCategory::ImageBlock, D(MemoryCategory, ImageBlock));
+
+    nb::class_<MemoryTracker>(m, "MemoryTracker", D(MemoryTracker))
+        .def_static_method(MemoryTracker, usage, "category"_a)
+        .def_static_method(MemoryTracker, peak_usage, "category"_a)
+        .def_static_method(MemoryTracker, total_usage, "device"_a = false)
+        .def_static_method(MemoryTracker, peak_total_usage, "device"_a = false)
+        .def_static_method(MemoryTracker, peak_rss)
+        .def_static_method(MemoryTracker, reset_peak_usage)
+        .def_static_method(MemoryTracker, report)
+        .def_static_method(MemoryTracker, summary);
+}
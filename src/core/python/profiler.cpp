@@ -0,0 +1,76 @@
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/filesystem.h>
+#include <mitsuba/python/python.h>
+#include <nanobind/stl/string.h>
+
+MI_PY_EXPORT(Profiler) {
+    nb::enum_<ProfilerPhase>(m, "ProfilerPhase", D(ProfilerPhase))
+        .value("InitScene", ProfilerPhase::InitScene, D(ProfilerPhase, InitScene))
+        .value("LoadGeometry", ProfilerPhase::LoadGeometry, D(ProfilerPhase, LoadGeometry))
+        .value("BitmapRead", ProfilerPhase::BitmapRead, D(ProfilerPhase, BitmapRead))
+        .value("BitmapWrite", ProfilerPhase::BitmapWrite, D(ProfilerPhase, BitmapWrite))
+        .value("InitAccel", ProfilerPhase::InitAccel, D(ProfilerPhase, InitAccel))
+        .value("Render", ProfilerPhase::Render, D(ProfilerPhase, Render))
+        .value("SamplingIntegratorSample", ProfilerPhase::SamplingIntegratorSample, D(ProfilerPhase, SamplingIntegratorSample))
+        .value("SampleEmitter", ProfilerPhase::SampleEmitter, D(ProfilerPhase, SampleEmitter))
+        .value("SampleEmitterRay", ProfilerPhase::SampleEmitterRay, D(ProfilerPhase, SampleEmitterRay))
+        .value("SampleEmitterDirection", ProfilerPhase::SampleEmitterDirection, D(ProfilerPhase, SampleEmitterDirection))
+        .value("RayTest", ProfilerPhase::RayTest, D(ProfilerPhase, RayTest))
+        .value("RayIntersect", ProfilerPhase::RayIntersect, D(ProfilerPhase, RayIntersect))
+        .value("CreateSurfaceInteraction", ProfilerPhase::CreateSurfaceInteraction, D(ProfilerPhase, CreateSurfaceInteraction))
+        .value("ImageBlockPut", ProfilerPhase::ImageBlockPut, D(ProfilerPhase, ImageBlockPut))
+        .value("BSDFEvaluate", ProfilerPhase::BSDFEvaluate, D(ProfilerPhase, BSDFEvaluate))
+        .value("BSDFSample", ProfilerPhase::BSDFSample, D(ProfilerPhase, BSDFSample))
+        .value("PhaseFunctionEvaluate", ProfilerPhase::PhaseFunctionEvaluate, D(ProfilerPhase, PhaseFunctionEvaluate))
+        .value("PhaseFunctionSample", ProfilerPhase::PhaseFunctionSample, D(ProfilerPhase, PhaseFunctionSample))
+        .value("MediumEvaluate", ProfilerPhase::MediumEvaluate, D(ProfilerPhase, MediumEvaluate))
+        .value("MediumSample", ProfilerPhase::MediumSample, D(ProfilerPhase, MediumSample))
+        .value("EndpointEvaluate", ProfilerPhase::EndpointEvaluate, D(ProfilerPhase, EndpointEvaluate))
+        .value("EndpointSampleRay", ProfilerPhase::EndpointSampleRay, D(ProfilerPhase, EndpointSampleRay))
+        .value("EndpointSampleDirection", ProfilerPhase::EndpointSampleDirection, D(ProfilerPhase, EndpointSampleDirection))
+        .value("EndpointSamplePosition", ProfilerPhase::EndpointSamplePosition, D(ProfilerPhase, EndpointSamplePosition))
+        .value("TextureSample", ProfilerPhase::TextureSample, D(ProfilerPhase, TextureSample))
+        .value("TextureEvaluate", ProfilerPhase::TextureEvaluate, D(ProfilerPhase, TextureEvaluate));
+
+    nb::enum_<RayStatistic>(m, "RayStatistic", D(RayStatistic))
+        .value("RayIntersect", RayStatistic::RayIntersect, D(RayStatistic, RayIntersect))
+        .value("RayTest", RayStatistic::RayTest, D(RayStatistic, RayTest))
+        .value("TraversedNodes", RayStatistic::TraversedNodes, D(RayStatistic, TraversedNodes))
+        .value("PrimitiveTests", RayStatistic::PrimitiveTests, D(RayStatistic, PrimitiveTests));
+
+    nb::class_<KernelStatistics>(m, "KernelStatistics", D(KernelStatistics))
+        .def(nb::init<>())
+        .def_rw("kernel_count", &KernelStatistics::kernel_count, D(KernelStatistics, kernel_count))
+        .def_rw("cache_hits", &KernelStatistics::cache_hits, D(KernelStatistics, cache_hits))
+        .def_rw("disk_cache_hits", &KernelStatistics::disk_cache_hits, D(KernelStatistics, disk_cache_hits))
+        .def_rw("codegen_time", &KernelStatistics::codegen_time, D(KernelStatistics, codegen_time))
+        .def_rw("backend_time", &KernelStatistics::backend_time, D(KernelStatistics, backend_time))
+        .def_rw("execution_time", &KernelStatistics::execution_time, D(KernelStatistics, execution_time))
+        .def_rw("peak_memory", &KernelStatistics::peak_memory, D(KernelStatistics, peak_memory))
+        .def_method(KernelStatistics, cache_hit_rate)
+        .def("__repr__", &KernelStatistics::to_string);
+
+    nb::class_<Profiler>(m, "Profiler", D(Profiler))
+        .def_static_method(Profiler, has_ray_statistics)
+        .def_static_method(Profiler, thread_ray_statistic, "stat"_a)
+        .def_static_method(Profiler, ray_statistic, "stat"_a)
+        .def_static_method(Profiler, reset_ray_statistics)
+        .def_static_method(Profiler, ray_statistics_report)
+        .def_static_method(Profiler, set_phase_profiling, "enabled"_a)
+        .def_static_method(Profiler, phase_profiling)
+        .def_static_method(Profiler, reset_phase_profile)
+        .def_static_method(Profiler, phase_profile_report)
+        .def_static_method(Profiler, start_trace)
+        .def_static_method(Profiler, stop_trace)
+        .def_static_method(Profiler, tracing)
+        .def_static_method(Profiler, write_trace, "path"_a)
+        .def_static_method(Profiler, set_kernel_profiling, "enabled"_a)
+        .def_static_method(Profiler, kernel_profiling)
+        .def_static_method(Profiler, kernel_statistics, "phase"_a)
+        .def_static_method(Profiler, reset_kernel_statistics)
+        .def_static_method(Profiler, kernel_statistics_report)
+        .def_static_method(Profiler, set_kernel_instrumentation, "enabled"_a)
+        .def_static_method(Profiler, kernel_instrumentation)
+        .def_static_method(Profiler, kernel_phase_time, "phase"_a)
+        .def_static_method(Profiler, kernel_phase_report);
+}
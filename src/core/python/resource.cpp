@@ -0,0 +1,10 @@
+#include <mitsuba/core/resource.h>
+#include <mitsuba/python/python.h>
+
+MI_PY_EXPORT(ResourceCache) {
+    nb::class_<ResourceCache>(m, "ResourceCache", D(ResourceCache))
+        .def_static_method(ResourceCache, size)
+        .def_static("clear", &ResourceCache::clear,
+                    nb::call_guard<nb::gil_scoped_release>(),
+                    D(ResourceCache, clear));
+}
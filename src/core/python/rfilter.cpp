@@ -44,6 +44,20 @@ MI_PY_EXPORT(rfilter) {
             },
             D(Resampler, resample), "source"_a, "source_stride"_a, "target"_a,
             "target_stride"_a, "channels"_a);
+        .def("resample_columns",
+            [](Resampler &resampler, const ArrayType &source,
+                ArrayType &target, uint32_t count) {
+                if (resampler.source_resolution() * (size_t) count != (size_t) source.size())
+                    throw std::runtime_error(
+                        "'source' has an incompatible size!");
+                if (resampler.target_resolution() * (size_t) count != (size_t) target.size())
+                    throw std::runtime_error(
+                        "'target' has an incompatible size!");
+
+                resampler.resample_columns((const float *) source.data(), count,
+                                           (float *) target.data(), count, count);
+            },
+            D(Resampler, resample_columns), "source"_a, "target"_a, "count"_a);
 
     m.attr("MI_FILTER_RESOLUTION") = MI_FILTER_RESOLUTION;
 }
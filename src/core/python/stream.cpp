@@ -1,4 +1,5 @@
 #include <mitsuba/core/stream.h>
+#include <mitsuba/core/bstream.h>
 #include <mitsuba/core/dstream.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/mstream.h>
@@ -101,20 +102,33 @@ MI_PY_EXPORT(MemoryStream) {
         });
 }
 
+MI_PY_EXPORT(BufferedStream) {
+    MI_PY_CLASS(BufferedStream, Stream)
+        .def(nb::init<Stream*, size_t>(), D(BufferedStream, BufferedStream),
+             "child_stream"_a, "buffer_size"_a = detail::kBufferedStreamSize)
+        .def("child_stream", [](BufferedStream &stream) {
+            return nb::cast(stream.child_stream());
+        }, D(BufferedStream, child_stream))
+        .def_method(BufferedStream, buffer_size);
+}
+
 MI_PY_EXPORT(ZStream) {
     auto c = MI_PY_CLASS(ZStream, Stream);
 
     nb::enum_<ZStream::EStreamType>(c, "EStreamType", D(ZStream, EStreamType))
         .value("EDeflateStream", ZStream::EDeflateStream, D(ZStream, EStreamType, EDeflateStream))
         .value("EGZipStream", ZStream::EGZipStream, D(ZStream, EStreamType, EGZipStream))
+        .value("EBlockStream", ZStream::EBlockStream, D(ZStream, EStreamType, EBlockStream))
         .export_values();
 
 
-    c.def(nb::init<Stream*, ZStream::EStreamType, int>(), D(ZStream, ZStream),
+    c.def(nb::init<Stream*, ZStream::EStreamType, int, size_t>(), D(ZStream, ZStream),
         "child_stream"_a,
         "stream_type"_a = ZStream::EDeflateStream,
-        "level"_a = -1)
+        "level"_a = -1,
+        "block_size"_a = detail::kZStreamBlockSize)
         .def("child_stream", [](ZStream &stream) {
             return nb::cast(stream.child_stream());
-        }, D(ZStream, child_stream));
+        }, D(ZStream, child_stream))
+        .def_method(ZStream, stream_type);
 }
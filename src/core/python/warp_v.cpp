@@ -69,6 +69,14 @@ MI_PY_EXPORT(warp) {
           warp::square_to_uniform_triangle_pdf<false, Float>,
           "p"_a, D(warp, square_to_uniform_triangle_pdf));
 
+    m.def("square_to_spherical_triangle",
+          warp::square_to_spherical_triangle<Float>,
+          "sample"_a, "a"_a, "b"_a, "c"_a, D(warp, square_to_spherical_triangle));
+
+    m.def("square_to_spherical_triangle_pdf",
+          warp::square_to_spherical_triangle_pdf<Float>,
+          "a"_a, "b"_a, "c"_a, D(warp, square_to_spherical_triangle_pdf));
+
     m.def("square_to_uniform_sphere",
           warp::square_to_uniform_sphere<Float>,
           "sample"_a, D(warp, square_to_uniform_sphere));
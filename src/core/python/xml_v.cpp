@@ -3,11 +3,14 @@
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/xml.h>
 #include <mitsuba/core/plugin.h>
+#include <mitsuba/core/profiler.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/resource.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/transform.h>
 #include <mitsuba/python/python.h>
 #include <nanothread/nanothread.h>
+#include <atomic>
 #include <map>
 #include <unordered_map>
 
@@ -30,6 +33,8 @@ struct DictParseContext {
     std::map<std::string, DictInstance> instances;
     std::map<std::string, std::string> aliases;
     bool parallel = false;
+    /// Set when an object failed to load, which cancels pending instantiations
+    std::atomic<bool> failed { false };
 };
 
 // Forward declaration
@@ -67,7 +72,8 @@ MI_PY_EXPORT(xml) {
 
     m.def(
         "load_file",
-        [](const std::string &name, bool update_scene, bool parallel, nb::kwargs kwargs) {
+        [](const std::string &name, bool update_scene, bool parallel,
+           const std::string &cache_dir, bool reload, nb::kwargs kwargs) {
             xml::ParameterList param;
             if (kwargs) {
                 for (auto [k, v] : kwargs)
@@ -81,12 +87,14 @@ MI_PY_EXPORT(xml) {
             std::vector<ref<Object>> objects;
             {
                 nb::gil_scoped_release release;
-                objects = xml::load_file(name, GET_VARIANT(), param, update_scene, parallel);
+                objects = xml::load_file(name, GET_VARIANT(), param, update_scene,
+                                         parallel, cache_dir, reload);
             }
 
             return single_object_or_list(objects);
         },
-        "path"_a, "update_scene"_a = false, "parallel"_a = true, "kwargs"_a,
+        "path"_a, "update_scene"_a = false, "parallel"_a = true,
+        "cache_dir"_a = "", "reload"_a = false, "kwargs"_a,
         D(xml, load_file));
 
     m.def(
@@ -113,6 +121,15 @@ MI_PY_EXPORT(xml) {
         "string"_a, "parallel"_a = true, "kwargs"_a,
         D(xml, load_string));
 
+    m.def("set_instantiation_report", &xml::set_instantiation_report,
+          "path"_a, D(xml, set_instantiation_report));
+
+    m.def("set_streaming_threshold", &xml::set_streaming_threshold,
+          "size"_a, D(xml, set_streaming_threshold));
+
+    m.def("invalidate_reload", &xml::invalidate_reload,
+          "object"_a, D(xml, invalidate_reload));
+
     m.def(
         "load_dict",
         [](const nb::dict dict, bool parallel) {
@@ -127,8 +144,23 @@ MI_PY_EXPORT(xml) {
             try {
                 parse_dictionary<Float, Spectrum>(ctx, "__root__", dict);
                 std::unordered_map<std::string, Task*> task_map;
-                instantiate_node<Float, Spectrum>(ctx, "__root__", task_map);
-                auto objects = mitsuba::xml::detail::expand_node(ctx.instances["__root__"].object);
+                std::vector<ref<Object>> objects;
+                {
+                    /* The instantiation doesn't access Python objects (plugins
+                       implemented in Python re-acquire the GIL), hence other
+                       Python threads can run in the meantime */
+                    nb::gil_scoped_release release;
+                    // Files that are referenced several times are only loaded once
+                    ResourceCache::Scope resource_scope;
+                    if (parallel) {
+                        std::vector<const Properties *> props;
+                        for (const auto &[name, inst] : ctx.instances)
+                            props.push_back(&inst.props);
+                        mitsuba::xml::detail::prefetch_resources(props);
+                    }
+                    instantiate_node<Float, Spectrum>(ctx, "__root__", task_map);
+                    objects = mitsuba::xml::detail::expand_node(ctx.instances["__root__"].object);
+                }
                 Thread::thread()->set_file_resolver(fs_backup.get());
                 return single_object_or_list(objects);
             } catch(...) {
@@ -465,13 +497,14 @@ Task *instantiate_node(DictParseContext &ctx,
         deps.push_back(task_map.find(path2)->second);
     }
 
-    auto instantiate = [&ctx, path, scope, backend]() {
+    auto instantiate_impl = [&ctx, path, scope, backend]() {
         ScopedSetThreadEnvironment set_env(ctx.env);
         mitsuba::xml::ScopedSetJITScope set_scope(ctx.parallel ? backend : 0u, scope);
 
         auto &inst = ctx.instances[path];
         Properties props = inst.props;
         std::string type = props.plugin_name();
+        ScopedTraceEvent trace("xml", type, path);
 
         const Class *class_;
         if (type == "scene")
@@ -498,12 +531,23 @@ Task *instantiate_node(DictParseContext &ctx,
             Throw("Unreferenced property \"%s\" in plugin of type \"%s\"!", props.unqueried()[0], type);
     };
 
+    // Skip the remaining objects once one of them failed to load
+    auto instantiate = [&ctx, instantiate_impl]() {
+        if (ctx.failed)
+            return;
+        try {
+            instantiate_impl();
+        } catch (...) {
+            ctx.failed = true;
+            throw;
+        }
+    };
+
     // Top node always instantiated on the main thread
     if (is_root) {
         std::exception_ptr eptr;
         for (auto& task : deps) {
             try {
-                nb::gil_scoped_release gil_release{};
                 task_wait(task);
             } catch (...) {
                 if (!eptr)
@@ -0,0 +1,145 @@
+#include <mitsuba/core/resource.h>
+#include <mitsuba/core/logger.h>
+#include <mitsuba/core/thread.h>
+#include <nanothread/nanothread.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/// Identifies a resource: absolute path, file size, modification time, parameters
+using ResourceKey = std::tuple<std::string, size_t, int64_t, std::string>;
+
+struct ResourceEntry {
+    /// Held while the resource is being loaded
+    std::mutex mutex;
+    ref<Object> object;
+};
+
+static std::mutex resource_mutex;
+static std::map<ResourceKey, std::shared_ptr<ResourceEntry>> *resources = nullptr;
+/// Number of active ResourceCache::Scope instances
+static size_t resource_scopes = 0;
+/// Pending loads started by ResourceCache::prefetch()
+static std::vector<Task *> resource_tasks;
+
+/// Release all entries that are not referenced outside of the cache
+static void resource_purge() {
+    if (!resources || resource_scopes > 0)
+        return;
+    for (auto it = resources->begin(); it != resources->end(); ) {
+        const ref<Object> &object = it->second->object;
+        if (object && object->ref_count() == 1)
+            it = resources->erase(it);
+        else
+            ++it;
+    }
+}
+
+ResourceCache::Scope::Scope() {
+    std::lock_guard<std::mutex> guard(resource_mutex);
+    resource_scopes++;
+}
+
+ResourceCache::Scope::~Scope() {
+    // Prefetched entries must be complete before they can be purged
+    ResourceCache::wait();
+    std::lock_guard<std::mutex> guard(resource_mutex);
+    resource_scopes--;
+    resource_purge();
+}
+
+ref<Object> ResourceCache::get(const fs::path &path, const std::string &params,
+                               const LoadFunction &load) {
+    fs::path abs_path = fs::absolute(path);
+    ResourceKey key(abs_path.string(), fs::file_size(abs_path),
+                    fs::last_write_time(abs_path), params);
+
+    std::shared_ptr<ResourceEntry> entry;
+    {
+        std::lock_guard<std::mutex> guard(resource_mutex);
+        if (!resources)
+            resources = new std::map<ResourceKey, std::shared_ptr<ResourceEntry>>();
+        resource_purge();
+
+        std::shared_ptr<ResourceEntry> &value = (*resources)[key];
+        if (!value)
+            value = std::make_shared<ResourceEntry>();
+        entry = value;
+    }
+
+    std::lock_guard<std::mutex> guard(entry->mutex);
+    if (entry->object) {
+        Log(Debug, "Reusing cached resource \"%s\"", abs_path);
+        return entry->object;
+    }
+
+    try {
+        entry->object = load(abs_path);
+    } catch (...) {
+        // Remove the entry, other waiting requests will try loading it again
+        std::lock_guard<std::mutex> guard2(resource_mutex);
+        if (resources) {
+            auto it = resources->find(key);
+            if (it != resources->end() && it->second == entry)
+                resources->erase(it);
+        }
+        throw;
+    }
+
+    if (!entry->object)
+        Throw("ResourceCache::get(): could not load \"%s\"!", abs_path);
+
+    return entry->object;
+}
+
+void ResourceCache::prefetch(const fs::path &path, const std::string &params,
+                             const LoadFunction &load) {
+    ThreadEnvironment env;
+    Task *task = dr::do_async([env, path, params, load]() mutable {
+        ScopedSetThreadEnvironment set_env(env);
+        try {
+            get(path, params, load);
+        } catch (const std::exception &e) {
+            Log(Debug, "ResourceCache::prefetch(): could not load \"%s\": %s",
+                path, e.what());
+        }
+    });
+
+    std::lock_guard<std::mutex> guard(resource_mutex);
+    resource_tasks.push_back(task);
+}
+
+void ResourceCache::wait() {
+    std::vector<Task *> tasks;
+    {
+        std::lock_guard<std::mutex> guard(resource_mutex);
+        tasks.swap(resource_tasks);
+    }
+    for (Task *task : tasks)
+        task_wait_and_release(task);
+}
+
+size_t ResourceCache::size() {
+    std::lock_guard<std::mutex> guard(resource_mutex);
+    resource_purge();
+    return resources ? resources->size() : 0;
+}
+
+void ResourceCache::clear() {
+    std::lock_guard<std::mutex> guard(resource_mutex);
+    if (resources)
+        resources->clear();
+}
+
+void ResourceCache::static_shutdown() {
+    wait();
+    std::lock_guard<std::mutex> guard(resource_mutex);
+    delete resources;
+    resources = nullptr;
+}
+
+NAMESPACE_END(mitsuba)
@@ -20,6 +20,40 @@ MI_VARIANT void ReconstructionFilter<Float, Spectrum>::init_discretization() {
     }
 
     m_scale_factor = MI_FILTER_RESOLUTION / m_radius;
+
+    /* The discretized weight of a pixel changes whenever the sub-pixel offset
+       of the sample crosses a multiple of radius / MI_FILTER_RESOLUTION. When
+       'q * radius' is an integer, these all fall onto a regular grid with
+       MI_FILTER_RESOLUTION * q cells, within which all weights are constant */
+    m_offset_weights.clear();
+    m_offset_resolution = m_offset_taps = 0;
+    m_offset_first_tap = 0;
+
+    if constexpr (!dr::is_jit_v<Float>) {
+        for (uint32_t q = 1; q <= 4; ++q) {
+            ScalarFloat p = m_radius * q;
+            if (p == dr::round(p)) {
+                m_offset_resolution = MI_FILTER_RESOLUTION * q;
+                break;
+            }
+        }
+
+        if (m_offset_resolution > 0) {
+            m_offset_first_tap = dr::ceil2int<int32_t>(-m_radius);
+            m_offset_taps = (uint32_t) (dr::floor2int<int32_t>(m_radius) + 1 -
+                                        m_offset_first_tap + 1);
+            m_offset_weights.resize(m_offset_resolution * m_offset_taps);
+
+            // Evaluate the weights at the center of every cell
+            for (uint32_t i = 0; i < m_offset_resolution; ++i) {
+                ScalarFloat u = (i + .5f) / m_offset_resolution;
+                for (uint32_t j = 0; j < m_offset_taps; ++j)
+                    m_offset_weights[i * m_offset_taps + j] = eval_discretized(
+                        ScalarFloat(m_offset_first_tap + (int32_t) j) - u);
+            }
+        }
+    }
+
     m_border_size = (int) dr::ceil(m_radius - .5f - 2.f * math::RayEpsilon<ScalarFloat>);
 }
 
@@ -3,6 +3,7 @@
 #include <mitsuba/core/mmap.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/spectrum.h>
+#include <mutex>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -242,20 +243,25 @@ CIE1932Tables<dr::CUDAArray<float>> color_space_tables_cuda;
 #endif
 NAMESPACE_END(detail)
 
+/// Serializes the (possibly concurrent) on-demand initialization
+static std::mutex color_management_mutex;
+
 void color_management_static_initialization(bool cuda, bool llvm) {
+    std::lock_guard<std::mutex> guard(color_management_mutex);
     detail::color_space_tables_scalar.initialize(cie1931_tbl);
 #if defined(MI_ENABLE_LLVM)
     if (llvm)
-        detail::color_space_tables_llvm.initialize(cie1931_tbl);
+        detail::color_space_tables_llvm.initialize(detail::color_space_tables_scalar);
 #endif
 #if defined(MI_ENABLE_CUDA)
     if (cuda)
-        detail::color_space_tables_cuda.initialize(cie1931_tbl);
+        detail::color_space_tables_cuda.initialize(detail::color_space_tables_scalar);
 #endif
     (void) cuda; (void) llvm;
 }
 
 void color_management_static_shutdown() {
+    std::lock_guard<std::mutex> guard(color_management_mutex);
     detail::color_space_tables_scalar.release();
 #if defined(MI_ENABLE_LLVM)
     detail::color_space_tables_llvm.release();
@@ -1499,13 +1499,46 @@ StructConverter::StructConverter(const Struct *source, const Struct *target, boo
     __cache[key] = (void *) m_func;
 #else
     m_dither = dither;
+    m_source_swap = source->byte_order() != Struct::host_byte_order();
+    m_target_swap = target->byte_order() != Struct::host_byte_order();
+
+    // Resolve all fields once instead of looking them up for every record
+    for (const Struct::Field &f : *source) {
+        if (has_flag(f.flags, Struct::Flags::Assert) && !target->has_field(f.name))
+            m_assert_fields.push_back(f);
+        if (has_flag(f.flags, Struct::Flags::Weight)) {
+            m_weight_field = f;
+            m_has_weight = true;
+        }
+        if (has_flag(f.flags, Struct::Flags::Alpha)) {
+            m_has_multiple_alpha_channels |= m_has_alpha;
+            m_alpha_field = f;
+            m_has_alpha = true;
+        }
+    }
+    for (const Struct::Field &f : *target) {
+        if (has_flag(f.flags, Struct::Flags::Weight) && m_has_weight)
+            m_has_weight = false;
+
+        FieldPlan plan;
+        if (f.blend.empty()) {
+            if (!source->has_field(f.name) && has_flag(f.flags, Struct::Flags::Default))
+                plan.use_default = true;
+            else
+                plan.source = source->field(f.name);
+        } else {
+            for (const auto &kv : f.blend)
+                plan.blend.emplace_back((Float) kv.first, source->field(kv.second));
+        }
+        m_plan.push_back(std::move(plan));
+    }
 #endif
 }
 
 #if MI_STRUCTCONVERTER_USE_JIT == 0
 
 bool StructConverter::load(const uint8_t *src, const Struct::Field &f, Value &value) const {
-    bool source_swap = m_source->byte_order() != Struct::host_byte_order();
+    bool source_swap = m_source_swap;
 
     src += f.offset;
     value.type = f.type;
@@ -1638,7 +1671,7 @@ void StructConverter::linearize(Value &value) const {
 void StructConverter::save(uint8_t *dst, const Struct::Field &f, Value value, size_t x, size_t y) const {
 
     /* Is swapping needed */
-    bool target_swap = m_target->byte_order() != Struct::host_byte_order();
+    bool target_swap = m_target_swap;
 
     dst += f.offset;
 
@@ -1761,27 +1794,8 @@ bool StructConverter::convert_2d(size_t width, size_t height, const void *src_,
 
     size_t source_size = m_source->size();
     size_t target_size = m_target->size();
-    Struct::Field weight_field, alpha_field;
-
-    bool has_weight = false, has_alpha = false, has_multiple_alpha_channels = false;
-    std::vector<Struct::Field> assert_fields;
-    for (Struct::Field f : *m_source) {
-        if (has_flag(f.flags, Struct::Flags::Assert) && !m_target->has_field(f.name))
-            assert_fields.push_back(f);
-        if (has_flag(f.flags, Struct::Flags::Weight)) {
-            weight_field = f;
-            has_weight = true;
-        }
-        if (has_flag(f.flags, Struct::Flags::Alpha)) {
-            has_multiple_alpha_channels |= has_alpha;
-            alpha_field = f;
-            has_alpha = true;
-        }
-    }
-    for (const Struct::Field &f : *m_target) {
-        if (has_flag(f.flags, Struct::Flags::Weight) && has_weight)
-            has_weight = false;
-    }
+    size_t field_count = m_target->field_count();
+    bool has_weight = m_has_weight, has_alpha = m_has_alpha;
 
     uint8_t *src  = (uint8_t *) src_;
     uint8_t *dest = (uint8_t *) dest_;
@@ -1789,7 +1803,7 @@ bool StructConverter::convert_2d(size_t width, size_t height, const void *src_,
     for (size_t y = 0; y<height; ++y) {
         for (size_t x = 0; x<width; ++x) {
             Float inv_weight = 1.f;
-            for (const Struct::Field &f : assert_fields) {
+            for (const Struct::Field &f : m_assert_fields) {
                 Value value;
                 if (!load(src, f, value))
                     return false;
@@ -1797,7 +1811,7 @@ bool StructConverter::convert_2d(size_t width, size_t height, const void *src_,
 
             if (has_weight) {
                 Value value;
-                if (!load(src, weight_field, value))
+                if (!load(src, m_weight_field, value))
                     return false;
                 linearize(value);
                 inv_weight = value.f != 0.f ? (1.f / value.f) : 1.f;
@@ -1806,35 +1820,37 @@ bool StructConverter::convert_2d(size_t width, size_t height, const void *src_,
             Float alpha = 1.f, inv_alpha = 1.f;
             if (has_alpha) {
                 Value value;
-                if (!load(src, alpha_field, value))
+                if (!load(src, m_alpha_field, value))
                     return false;
                 linearize(value);
                 alpha = value.f;
                 inv_alpha = alpha > 0 ? 1.f / alpha : 0.f;
             }
 
-            for (const Struct::Field &f : *m_target) {
+            for (size_t i = 0; i < field_count; ++i) {
+                const Struct::Field &f = (*m_target)[i];
+                const FieldPlan &plan = m_plan[i];
                 Value value;
 
-                if (f.blend.empty()) {
-                    if (!m_source->has_field(f.name) && has_flag(f.flags, Struct::Flags::Default)) {
+                if (plan.blend.empty()) {
+                    if (plan.use_default) {
                         value.d = f.default_;
                         value.type = Struct::Type::Float64;
                         value.flags = +Struct::Flags::Empty;
                     } else {
-                        if (!load(src, m_source->field(f.name), value))
+                        if (!load(src, plan.source, value))
                             return false;
                     }
                 } else {
                     value.type = struct_type_v<Float>;
                     value.f = 0;
                     value.flags = +Struct::Flags::Empty;
-                    for (auto kv : f.blend) {
+                    for (const auto &kv : plan.blend) {
                         Value value2;
-                        if (!load(src, m_source->field(kv.second), value2))
+                        if (!load(src, kv.second, value2))
                             return false;
                         linearize(value2);
-                        value.f += (Float) kv.first * value2.f;
+                        value.f += kv.first * value2.f;
                     }
                 }
 
@@ -1854,7 +1870,7 @@ bool StructConverter::convert_2d(size_t width, size_t height, const void *src_,
                 if (has_alpha && ((f.flags & special_channels_mask) == 0) &&
                     source_premult != target_premult && f.blend.empty()) {
                     linearize(value);
-                    if (has_multiple_alpha_channels)
+                    if (m_has_multiple_alpha_channels)
                         Throw("Found multiple alpha channels: Alpha (un)premultiplication expects a single alpha channel");
 
                     if (target_premult && !source_premult) {
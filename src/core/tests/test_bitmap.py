@@ -379,6 +379,23 @@ def test_construct_from_int8_array(variants_all_rgb):
     assert dr.allclose(b_np, np.array(b2))
 
 
+def test_from_dlpack_zero_copy(variant_scalar_rgb):
+    data = np.reshape(np.arange(24, dtype=np.float32), (2, 4, 3))
+    b = mi.Bitmap.from_dlpack(data)
+    assert b.pixel_format() == mi.Bitmap.PixelFormat.RGB
+    assert b.size() == [4, 2]
+
+    # Both views share the same memory
+    data[1, 2, 0] = -1
+    assert np.array(b, copy=False)[1, 2, 0] == -1
+    np.array(b, copy=False)[0, 0, 2] = 42
+    assert data[0, 0, 2] == 42
+
+    # The array is kept alive by the bitmap
+    del data
+    assert np.array(b)[0, 0, 2] == 42
+
+
 def test_resample(variants_all):
     """
     Resampling a mi.Bitmap should work even in non-scalar and non-RGB variants.
@@ -428,3 +445,57 @@ def test_check_weight_division(variant_scalar_rgb):
     assert np.all(x[0, 0, :] == (2, 0, 0, 0))
     assert np.all(x[1, 0, :] == (1, 0, 0, 0))
     assert np.all(x[2, 0, :] == (2, 0, 0, 0))
+
+
+def test_write_exr_tiled_multipart(variant_scalar_rgb, tmpdir):
+    b0 = mi.Bitmap(find_resource('resources/data/tests/bitmap/spot_0.exr'))
+    b1 = mi.Bitmap(find_resource('resources/data/tests/bitmap/spot_1.exr'))
+
+    assert mi.Bitmap.exr_tile_size() == 0
+    mi.Bitmap.set_exr_tile_size(32)
+    try:
+        tmp_file = os.path.join(str(tmpdir), "tiled.exr")
+        b0.write(tmp_file)
+        assert mi.Bitmap(tmp_file) == b0
+
+        tmp_file = os.path.join(str(tmpdir), "parts.exr")
+        mi.Bitmap.write_exr_multipart(tmp_file, [("spot_0", b0), ("spot_1", b1)])
+        # Single-part readers see the first part
+        b = mi.Bitmap(tmp_file)
+        assert np.allclose(np.array(b), np.array(b0))
+    finally:
+        mi.Bitmap.set_exr_tile_size(0)
+
+    mi.Bitmap.set_exr_thread_count(0)
+    try:
+        assert mi.Bitmap.exr_thread_count() == 0
+        tmp_file = os.path.join(str(tmpdir), "serial.exr")
+        b1.write(tmp_file)
+        assert mi.Bitmap(tmp_file) == b1
+    finally:
+        mi.Bitmap.set_exr_thread_count(-1)
+
+
+def test_convert_fast_paths(variant_scalar_rgb):
+    rng = np.random.default_rng(0)
+    data = rng.random((700, 333, 3), dtype=np.float32)
+    b = mi.Bitmap(data)
+
+    # float32 -> dithered 8 bit sRGB
+    b8 = np.array(b.convert(mi.Bitmap.PixelFormat.RGB, mi.Struct.Type.UInt8, True))
+    ref = np.where(data <= 0.0031308, data * 12.92,
+                   1.055 * np.power(data, 1.0 / 2.4) - 0.055) * 255
+    assert b8.dtype == np.uint8
+    assert np.max(np.abs(b8 - ref)) <= 1.0
+    assert np.abs(np.mean(b8 - ref)) < 0.01
+
+    # float32 <-> float16
+    b16 = b.convert(mi.Bitmap.PixelFormat.RGB, mi.Struct.Type.Float16, False)
+    assert np.all(np.array(b16) == data.astype(np.float16))
+    b32 = b16.convert(mi.Bitmap.PixelFormat.RGB, mi.Struct.Type.Float32, False)
+    assert np.all(np.array(b32) == data.astype(np.float16).astype(np.float32))
+
+    # General conversions are processed in parallel blocks of rows
+    by = np.array(b.convert(mi.Bitmap.PixelFormat.Y, mi.Struct.Type.Float32, False))
+    lum = data @ np.array([0.212671, 0.715160, 0.072169], dtype=np.float32)
+    assert np.allclose(by[..., 0], lum, atol=1e-5)
@@ -270,3 +270,114 @@ def test18_irrcont_simple_function(variants_vec_backends_once):
                 0.48734, 0.654313, 0.786607, 0.899653, 1.])
          * d.normalization())
     )
+
+
+def test19_discr_alias_table(variants_vec_backends_once):
+    # The alias table must reproduce the PMF exactly, including zero entries
+    import numpy as np
+
+    rng = np.random.default_rng(0)
+    values = rng.random(1000) * (rng.random(1000) > 0.2)
+    values[:10] = 0
+    ddistr = mi.DiscreteDistribution(values, alias_table=True)
+    assert ddistr.has_alias_table()
+
+    n = 1 << 18
+    x = (dr.arange(mi.Float, n) + 0.5) / n
+    index, reused, pmf = ddistr.sample_reuse_pmf(x)
+    assert dr.allclose(pmf, ddistr.eval_pmf_normalized(index))
+    assert dr.all((reused >= 0) & (reused <= 1))
+
+    counts = np.bincount(np.array(index), minlength=len(values)) / n
+    assert np.allclose(counts, values / values.sum(), atol=1e-4)
+    assert np.all(counts[values == 0] == 0)
+
+    # The reused sample is uniformly distributed within every entry
+    hist = np.histogram(np.array(reused), bins=8, range=(0, 1))[0] / n
+    assert np.allclose(hist, 1 / 8, atol=1e-3)
+
+    # Switching back to the inverse CDF method
+    ddistr.set_alias_table(False)
+    assert not ddistr.has_alias_table()
+    y = ddistr.sample(x)
+    z = dr.gather(mi.Float, ddistr.cdf, y - 1, y > 0)
+    assert dr.all(x * ddistr.sum() >= z)
+
+
+@pytest.mark.parametrize("clustered", [False, True])
+def test20_irrcont_lookup(variants_vec_backends_once, clustered):
+    # The interval lookup must match a linear interpolation at all positions,
+    # including the nodes themselves
+    import numpy as np
+
+    rng = np.random.default_rng(0)
+    if clustered:
+        # Dense cluster of nodes, which falls back to the bisection
+        nodes = np.concatenate([np.linspace(0, 1e-3, 200), [1, 10]])
+    else:
+        nodes = np.cumsum(rng.random(100) + 0.1)
+    nodes = nodes.astype(np.float32)
+    values = rng.random(len(nodes)).astype(np.float32)
+    d = mi.IrregularContinuousDistribution(nodes, values)
+
+    x = np.concatenate([nodes, rng.uniform(nodes[0], nodes[-1], 10000)])
+    x = x.astype(np.float32)
+    ref = np.interp(x.astype(np.float64), nodes.astype(np.float64), values)
+    assert np.allclose(np.array(d.eval_pdf(mi.Float(x))), ref, atol=1e-4)
+
+
+def test21_fenwick_sample(variants_vec_backends_once):
+    # The Fenwick tree must sample the same indices as the inverse CDF method
+    eps = 1e-6
+
+    x = mi.FenwickDistribution([1, 3, 2])
+    assert len(x) == 3
+    assert x.sum() == 6
+    assert dr.allclose(x.normalization(), 1.0 / 6.0)
+    assert dr.all(x.tree == [1, 4, 2])
+    assert dr.all(x.sample([-1, 0, 1, 2]) == [0, 0, 2, 2])
+    assert dr.all(x.sample([1 / 6.0 - eps, 1 / 6.0 + eps]) == [0, 1])
+    assert dr.all(x.sample([4 / 6.0 - eps, 4 / 6.0 + eps]) == [1, 2])
+
+    assert dr.allclose(
+        x.sample_reuse_pmf([0, 1 / 12.0, 1 / 6.0 + eps, 5 / 6.0]),
+        ([0, 0, 1, 2], mi.Float([0, .5, 0, .5]), mi.Float([1, 1, 3, 2]) / 6),
+        atol=1e-5
+    )
+
+    # Zero-valued buckets are never sampled
+    x = mi.FenwickDistribution([0, 0, 1, 0, 1, 0, 0, 0])
+    index, _, pmf = x.sample_reuse_pmf([-100, 0, 0.5, 0.5 + 1e-6, 1, 100])
+    assert dr.all(index == [2, 2, 2, 4, 4, 4])
+    assert dr.all(pmf == [.5] * 6)
+
+
+def test22_fenwick_update(variants_vec_backends_once):
+    import numpy as np
+
+    rng = np.random.default_rng(0)
+    values = rng.random(100).astype(np.float32)
+    x = mi.FenwickDistribution(values)
+    sample = dr.linspace(mi.Float, 0, 1, 1000, endpoint=False)
+
+    for it in range(10):
+        # Change a few entries (including setting some of them to zero)
+        for i in rng.integers(0, 100, it + 1):
+            values[i] = rng.random() if it % 3 else 0
+            x.set(int(i), float(values[i]))
+        x.update()
+
+        ref = mi.DiscreteDistribution(values)
+        assert dr.allclose(x.sum(), ref.sum())
+        assert dr.allclose(x.eval_pmf_normalized(dr.arange(mi.UInt32, 100)),
+                           ref.eval_pmf_normalized(dr.arange(mi.UInt32, 100)))
+
+        # Rounding may differ right at the boundaries of the entries
+        index, reused, pmf = x.sample_reuse_pmf(sample)
+        ref_index, ref_reused, ref_pmf = ref.sample_reuse_pmf(sample)
+        same = index == ref_index
+        assert dr.count(~same) <= 2
+        assert dr.allclose(dr.select(same, reused - ref_reused, 0), 0, atol=1e-3)
+
+    with pytest.raises(RuntimeError, match='non-negative'):
+        x.set(0, -1)
@@ -179,3 +179,37 @@ def test05_discrete_distribution_2d(variants_all_backends_once):
     assert allclose(d.sample([1, 0]), ([2, 0], .3, [1, 0]))
     assert allclose(d.sample([0, 6 / 10 - 1e-7]), ([0, 0], .1, [0, 1]))
     assert allclose(d.sample([0, 6 / 10 + 1e-7]), ([1, 1], .1, [0, 0]))
+
+
+@pytest.mark.parametrize("warp", ['Hierarchical2D1', 'MarginalDiscrete2D1',
+                                  'MarginalContinuous2D1'])
+def test06_large_nd(variant_scalar_rgb, warp):
+    # Distributions that are large enough to be constructed in parallel must
+    # match the normalized linear interpolant of the input data
+    rng = np.random.default_rng(seed=6)
+    values = rng.random((3, 130, 257)) * 10
+    param_res = [[0, 0.5, 1]]
+    instance = getattr(mi, warp)(values, param_res)
+
+    for slice in range(3):
+        if 'Continuous' in warp:
+            # Trapezoidal rule, see the conditional CDF construction
+            w = np.array([.5] + [1] * 255 + [.5]) / 256
+            h = np.array([.5] + [1] * 128 + [.5]) / 129
+            norm = 1 / np.sum(values[slice] * h[:, None] * w[None, :])
+        else:
+            patches = .25 * (values[slice, :-1, :-1] + values[slice, 1:, :-1] +
+                             values[slice, :-1, 1:] + values[slice, 1:, 1:])
+            norm = 1 / np.mean(patches)
+
+        for j in range(10):
+            x, y = rng.integers(0, 257), rng.integers(0, 130)
+            p = mi.Vector2f(x / 256, y / 129)
+            assert dr.allclose(instance.eval(p, param=[slice * .5]),
+                               values[slice, y, x] * norm, rtol=1e-4)
+
+            p_i = mi.Vector2f(rng.random(2))
+            p_o, pdf = instance.sample(p_i, param=[slice * .5])
+            p_i_2, pdf2 = instance.invert(p_o, param=[slice * .5])
+            assert dr.allclose(pdf, pdf2, rtol=1e-4)
+            assert dr.allclose(p_i_2, p_i, atol=1e-4)
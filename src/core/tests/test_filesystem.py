@@ -155,3 +155,19 @@ def test12_truncate_and_file_size(variant_scalar_rgb, tmp_path):
     assert fs.file_size(p) == 42
     assert fs.remove(p)
     assert not fs.exists(p)
+
+
+def test13_create_directories(variant_scalar_rgb, tmp_path):
+    base_dir = fs.path(str(tmp_path)) / 'nested'
+    new_dir = base_dir / 'dir 1' / 'dir 2'
+    assert fs.create_directories(new_dir)
+    assert fs.is_directory(new_dir)
+
+    # Existing directories are not treated as an error
+    assert fs.create_directories(new_dir)
+
+    # .. but existing files are
+    p = base_dir / 'file.txt'
+    open(str(p), 'a').close()
+    assert not fs.create_directories(p)
+    assert not fs.create_directories(p / 'dir 3')
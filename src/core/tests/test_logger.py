@@ -39,3 +39,42 @@ def test01_custom(variant_scalar_rgb):
         for app in appenders:
             logger.add_appender(app)
         logger.set_formatter(formatter)
+
+
+def test02_asynchronous(variant_scalar_rgb):
+    # Messages are deferred in asynchronous mode and flushed in order
+    messages = []
+
+    logger = mi.Thread.thread().logger()
+    appenders = []
+    while logger.appender_count() > 0:
+        app = logger.appender(0)
+        appenders.append(app)
+        logger.remove_appender(app)
+
+    class MyAppender(mi.Appender):
+        def append(self, level, text):
+            messages.append(text)
+
+    try:
+        logger.add_appender(MyAppender())
+        logger.set_asynchronous(True)
+        assert logger.asynchronous()
+
+        for i in range(100):
+            mi.Log(mi.LogLevel.Warn, "Message %i" % i)
+        logger.flush()
+
+        assert len(messages) == 100
+        for i, text in enumerate(messages):
+            assert text.endswith("Message %i" % i)
+
+        mi.Log(mi.LogLevel.Warn, "Last message")
+        logger.set_asynchronous(False)
+        assert not logger.asynchronous()
+        assert len(messages) == 101
+    finally:
+        logger.set_asynchronous(False)
+        logger.clear_appenders()
+        for app in appenders:
+            logger.add_appender(app)
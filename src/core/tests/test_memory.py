@@ -0,0 +1,44 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def test01_bitmap(variant_scalar_rgb):
+    import gc
+    category = mi.MemoryCategory.Bitmap
+    before = mi.MemoryTracker.usage(category)
+
+    b = mi.Bitmap(mi.Bitmap.PixelFormat.RGB, mi.Struct.Type.Float32, [64, 32])
+    assert mi.MemoryTracker.usage(category) == before + 64 * 32 * 3 * 4
+    assert mi.MemoryTracker.peak_usage(category) >= before + 64 * 32 * 3 * 4
+
+    # Copies own their storage
+    b2 = mi.Bitmap(b)
+    assert mi.MemoryTracker.usage(category) == before + 2 * 64 * 32 * 3 * 4
+
+    del b, b2
+    gc.collect()
+    assert mi.MemoryTracker.usage(category) == before
+
+
+def test02_scene(variants_all_rgb):
+    mesh_before = mi.MemoryTracker.usage(mi.MemoryCategory.Mesh)
+    mesh = mi.load_dict({'type': 'cube'})
+    assert mi.MemoryTracker.usage(mi.MemoryCategory.Mesh) > mesh_before
+
+    scene = mi.load_dict(mi.cornell_box())
+    mi.render(scene, spp=1)
+    assert mi.MemoryTracker.usage(mi.MemoryCategory.ImageBlock) > 0
+
+    device = dr.is_cuda_v(mi.Float)
+    assert mi.MemoryTracker.total_usage(device) > 0
+    assert mi.MemoryTracker.peak_total_usage(device) >= mi.MemoryTracker.total_usage(device)
+    assert mi.MemoryTracker.peak_rss() > 0
+
+    report = mi.MemoryTracker.report()
+    assert 'Meshes:' in report and 'Image blocks:' in report
+    assert 'peak resident memory' in mi.MemoryTracker.summary()
+
+    mi.MemoryTracker.reset_peak_usage()
+    assert mi.MemoryTracker.peak_usage(mi.MemoryCategory.Mesh) == \
+           mi.MemoryTracker.usage(mi.MemoryCategory.Mesh)
@@ -0,0 +1,139 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def test01_phase_profiling_disabled(variant_scalar_rgb):
+    assert not mi.Profiler.phase_profiling()
+    mi.Profiler.reset_phase_profile()
+
+    scene = mi.load_dict(mi.cornell_box())
+    mi.render(scene, spp=1)
+
+    assert 'Integrator::render()' not in mi.Profiler.phase_profile_report()
+
+
+def test02_phase_profiling_report(variant_scalar_rgb):
+    scene = mi.load_dict(mi.cornell_box())
+
+    mi.Profiler.reset_phase_profile()
+    mi.Profiler.set_phase_profiling(True)
+    try:
+        mi.render(scene, spp=1)
+    finally:
+        mi.Profiler.set_phase_profiling(False)
+
+    report = mi.Profiler.phase_profile_report()
+    lines = report.splitlines()
+
+    def indent(line):
+        return len(line) - len(line.lstrip())
+
+    # The blocks rendered by other threads start a tree of their own
+    render = [l for l in lines if l.strip().startswith('Integrator::render()')]
+    assert len(render) == 1 and '%' in render[0]
+
+    # Nested phases are indented below the phase they were entered from
+    sample = [i for i, l in enumerate(lines)
+              if l.strip().startswith('SamplingIntegrator::sample()')]
+    assert len(sample) >= 1
+    nested = lines[sample[0] + 1]
+    assert indent(nested) > indent(lines[sample[0]])
+
+    mi.Profiler.reset_phase_profile()
+    assert 'Integrator::render()' not in mi.Profiler.phase_profile_report()
+
+
+def test03_trace(variant_scalar_rgb, tmp_path):
+    import json
+
+    assert not mi.Profiler.tracing()
+    mi.Profiler.start_trace()
+    try:
+        scene = mi.load_dict(mi.cornell_box())
+        mi.render(scene, spp=1)
+    finally:
+        mi.Profiler.stop_trace()
+
+    path = str(tmp_path / 'trace.json')
+    mi.Profiler.write_trace(path)
+
+    with open(path) as f:
+        events = json.load(f)['traceEvents']
+
+    threads = [e for e in events if e['ph'] == 'M']
+    spans = [e for e in events if e['ph'] == 'X']
+    assert len(threads) >= 1
+    assert all(e['dur'] >= 0 and e['ts'] >= 0 for e in spans)
+
+    names = set(e['name'] for e in spans)
+    assert 'Render block' in names
+    assert 'Integrator::render()' in names
+
+    # Every plugin instantiation is recorded with the ID of the object
+    assert any(e['cat'] == 'xml' and e['name'] == 'diffuse' for e in spans)
+
+    # Events are only recorded while tracing
+    mi.Profiler.start_trace()
+    mi.Profiler.stop_trace()
+    mi.render(scene, spp=1)
+    mi.Profiler.write_trace(path)
+    with open(path) as f:
+        events = json.load(f)['traceEvents']
+    assert not any(e['ph'] == 'X' for e in events)
+
+
+def test04_kernel_statistics(variants_vec_backends_once_rgb):
+    scene = mi.load_dict(mi.cornell_box())
+
+    mi.Profiler.reset_kernel_statistics()
+    assert not mi.Profiler.kernel_profiling()
+    mi.Profiler.set_kernel_profiling(True)
+    try:
+        mi.render(scene, spp=4)
+    finally:
+        mi.Profiler.set_kernel_profiling(False)
+
+    stats = mi.Profiler.kernel_statistics(mi.ProfilerPhase.Render)
+    assert stats.kernel_count > 0
+    assert stats.cache_hits <= stats.kernel_count
+    assert 0 <= stats.cache_hit_rate() <= 1
+    assert stats.execution_time >= 0
+    assert 'Integrator::render()' in mi.Profiler.kernel_statistics_report()
+
+    # A second render reuses the compiled kernels
+    mi.Profiler.reset_kernel_statistics()
+    mi.Profiler.set_kernel_profiling(True)
+    try:
+        mi.render(scene, spp=4)
+    finally:
+        mi.Profiler.set_kernel_profiling(False)
+    stats = mi.Profiler.kernel_statistics(mi.ProfilerPhase.Render)
+    assert stats.cache_hits > 0
+
+    mi.Profiler.reset_kernel_statistics()
+    assert mi.Profiler.kernel_statistics(mi.ProfilerPhase.Render).kernel_count == 0
+
+
+def test05_kernel_instrumentation(variants_vec_backends_once_rgb):
+    scene = mi.load_dict(mi.cornell_box())
+
+    mi.Profiler.reset_kernel_statistics()
+    mi.Profiler.set_kernel_instrumentation(True)
+    try:
+        mi.render(scene, spp=4)
+    finally:
+        mi.Profiler.set_kernel_instrumentation(False)
+
+    # The execution time of the kernels is split among the phases
+    total = mi.Profiler.kernel_statistics(mi.ProfilerPhase.Render).execution_time
+    phases = [getattr(mi.ProfilerPhase, name) for name in dir(mi.ProfilerPhase)
+              if not name.startswith('_') and
+              isinstance(getattr(mi.ProfilerPhase, name), mi.ProfilerPhase)]
+    times = [mi.Profiler.kernel_phase_time(phase) for phase in phases]
+    assert all(t >= 0 for t in times)
+    assert sum(times) <= total * 1.001 + 1e-3
+
+    assert 'Kernel execution time per phase' in mi.Profiler.kernel_phase_report()
+    mi.Profiler.reset_kernel_statistics()
+    assert mi.Profiler.kernel_phase_time(mi.ProfilerPhase.BSDFSample) == 0
@@ -253,3 +253,23 @@ def test13_trailing_zeros_keys(variant_scalar_rgb):
     assert len(props.property_names()) == 2
     assert props[key1] == 4.0
     assert props[key2] == 8.0
+
+def test14_many_entries(variant_scalar_rgb):
+    # Larger property sets are indexed by a hash table
+    props = mi.Properties()
+    names = ['shape_%i' % i for i in range(100)]
+    for i in reversed(range(100)):
+        props[names[i]] = float(i)
+
+    assert props.property_names() == names
+    for i in range(0, 100, 2):
+        del props[names[i]]
+
+    assert props.property_names() == names[1::2]
+    for i in range(100):
+        assert props.has_property(names[i]) == (i % 2 == 1)
+        if i % 2 == 1:
+            assert props[names[i]] == float(i)
+
+    props['shape_0'] = 0.0
+    assert props.property_names() == ['shape_0'] + names[1::2]
@@ -2,7 +2,7 @@ import os
 import pytest
 import drjit as dr
 
-from mitsuba import Stream, DummyStream, FileStream, MemoryStream, ZStream
+from mitsuba import Stream, DummyStream, FileStream, MemoryStream, ZStream, BufferedStream
 from mitsuba.test.util import tmpfile, make_tmpfile
 
 parameters = [
@@ -11,7 +11,10 @@ parameters = [
         (DummyStream, ()),
         (MemoryStream, (64,)),
         (FileStream, (make_tmpfile, FileStream.ERead)),
-        (FileStream, (make_tmpfile, FileStream.ETruncReadWrite))
+        (FileStream, (make_tmpfile, FileStream.ETruncReadWrite)),
+        # Use a tiny buffer to exercise refills
+        (lambda *args: BufferedStream(FileStream(*args), 16),
+         (make_tmpfile, FileStream.ETruncReadWrite))
     ]
 ]
 
@@ -292,3 +295,46 @@ def test08_fstream(rw, tmpfile):
     else:
         with pytest.raises(RuntimeError):
             FileStream(new_name)
+
+
+def test09_buffered_stream(tmpfile):
+    s = FileStream(tmpfile, FileStream.ETruncReadWrite)
+    s.write(b'first line\r\nsecond line\n')
+    payload = bytes(range(256)) * 4
+    s.write(payload)
+    s.close()
+
+    s = BufferedStream(FileStream(tmpfile), 64)
+    assert s.buffer_size() == 64
+    assert s.read_line() == 'first line'
+    assert s.read_line() == 'second line'
+
+    # Reads larger than the buffer bypass it
+    pos = s.tell()
+    assert s.read(len(payload)) == payload
+    assert s.tell() == s.size()
+    with pytest.raises(RuntimeError):
+        s.read(1)
+
+    # Seeking backwards and reading across several refills
+    s.seek(pos + 10)
+    assert b''.join(s.read(50) for i in range(4)) == payload[10:210]
+    s.close()
+
+
+@pytest.mark.parametrize('block_size', [7, 1024 * 1024])
+def test10_block_zstream(block_size):
+    stream = MemoryStream(64)
+    zstream = ZStream(stream, ZStream.EBlockStream, block_size=block_size)
+    assert zstream.stream_type() == ZStream.EBlockStream
+    write_contents(zstream)
+    payload = bytes(range(256)) * 1000
+    zstream.write(payload)
+    zstream.close()
+
+    stream.seek(0)
+    zstream = ZStream(stream, ZStream.EBlockStream)
+    check_contents(zstream)
+    assert zstream.read(len(payload)) == payload
+    with pytest.raises(RuntimeError):
+        zstream.read(1)
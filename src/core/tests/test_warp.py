@@ -213,3 +213,57 @@ def test_square_to_uniform_lune(variants_vec_rgb):
     inv = lambda v: mi.warp.uniform_spherical_lune_to_square(v, n1, n2)
 
     check_inverse(fwd, inv, atol=1e-4)
+
+
+def test_square_to_spherical_triangle(variants_vec_rgb):
+    a = dr.normalize(mi.Vector3f(0.1, 0.2, 1.0))
+    b = dr.normalize(mi.Vector3f(1.0, -0.3, 0.8))
+    c = dr.normalize(mi.Vector3f(-0.4, 1.0, 0.5))
+
+    n = 100000
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(0, n)
+    d = mi.warp.square_to_spherical_triangle(sampler.next_2d(), a, b, c)
+    assert dr.allclose(dr.norm(d), 1.0)
+
+    # All directions lie within the spherical triangle
+    for u, v, w in [(a, b, c), (b, c, a), (c, a, b)]:
+        e = dr.cross(u, v)
+        assert dr.all(dr.dot(d, e) * dr.dot(w, e) >= -1e-6)
+
+    # .. and are uniformly distributed: compare against a sub-triangle
+    m = dr.normalize(a + b)
+    e = dr.cross(m, c)
+    fraction = dr.count(dr.dot(d, e) * dr.dot(a, e) > 0) / n
+    ratio = (mi.warp.square_to_spherical_triangle_pdf(a, b, c) /
+             mi.warp.square_to_spherical_triangle_pdf(a, m, c))
+    assert dr.allclose(fraction, ratio, atol=1e-2)
+
+    # The density is the inverse of the solid angle (here: an octant)
+    pdf = mi.warp.square_to_spherical_triangle_pdf(mi.Vector3f(1, 0, 0),
+                                                   mi.Vector3f(0, 1, 0),
+                                                   mi.Vector3f(0, 0, 1))
+    assert dr.allclose(pdf, 2 / dr.pi)
+
+
+def test_square_to_spherical_triangle_inside(variant_scalar_rgb):
+    # Every sample of a regular grid lies within the spherical triangle,
+    # including the corners of the sample domain and large triangles
+    triangles = [
+        ([0.1, 0.2, 1.0], [1.0, -0.3, 0.8], [-0.4, 1.0, 0.5]),
+        ([1, 0, 0], [0, 1, 0], [0, 0, 1]),
+        ([1, 0, 0.05], [-0.5, 0.86, 0.05], [-0.5, -0.86, 0.05]),
+        ([0.01, 0, 1], [0, 0.01, 1], [-0.01, -0.01, 1]),
+    ]
+
+    n = 17
+    for a, b, c in triangles:
+        a, b, c = (dr.normalize(mi.Vector3f(v)) for v in (a, b, c))
+        for i in range(n):
+            for j in range(n):
+                s = mi.Point2f(i / (n - 1), j / (n - 1))
+                d = mi.warp.square_to_spherical_triangle(s, a, b, c)
+                assert dr.allclose(dr.norm(d), 1.0)
+                for u, v, w in [(a, b, c), (b, c, a), (c, a, b)]:
+                    e = dr.cross(u, v)
+                    assert dr.dot(d, e) * dr.dot(w, e) >= -1e-5
@@ -425,3 +425,228 @@ def test31_python_plugins_parallel(variants_vec_backends_once_rgb):
         <bsdf type='dummy'/>
     </scene>
     """, parallel=True)
+
+
+def test32_xml_cache(variant_scalar_rgb, tmp_path):
+    scene_file = tmp_path / 'scene.xml'
+    include_file = tmp_path / 'include.xml'
+    cache_dir = tmp_path / 'cache'
+
+    def write(radius, color):
+        include_file.write_text(f"""<scene version="3.0.0">
+            <shape type="sphere">
+                <float name="radius" value="{radius}"/>
+                <transform name="to_world">
+                    <translate x="1" y="2" z="3"/>
+                </transform>
+                <bsdf type="diffuse">
+                    <rgb name="reflectance" value="{color}"/>
+                </bsdf>
+            </shape>
+        </scene>""")
+        scene_file.write_text("""<scene version="3.0.0">
+            <include filename="include.xml"/>
+            <emitter type="point" id="light">
+                <spectrum name="intensity" value="$power"/>
+            </emitter>
+        </scene>""")
+
+    def load(**kwargs):
+        return mi.load_file(str(scene_file), cache_dir=str(cache_dir), **kwargs)
+
+    write(2.0, "0.25 0.5 0.75")
+    scene = load(power=3)
+    files = list(cache_dir.glob('xml_*.bin'))
+    assert len(files) == 1
+
+    # Loading the same scene again uses the cache entry
+    scene_cached = load(power=3)
+    assert list(cache_dir.glob('xml_*.bin')) == files
+    assert dr.allclose(scene_cached.bbox().min, scene.bbox().min)
+    assert dr.allclose(scene_cached.bbox().max, scene.bbox().max)
+
+    params, params_cached = mi.traverse(scene), mi.traverse(scene_cached)
+    assert len(params.keys()) == len(params_cached.keys())
+    for key in params.keys():
+        if 'reflectance' in key or 'intensity' in key:
+            assert dr.allclose(params_cached[key], params[key])
+
+    # Other parameters use a separate entry
+    load(power=4)
+    assert len(list(cache_dir.glob('xml_*.bin'))) == 2
+
+    # Changing an included file invalidates the entry
+    write(4.0, "0.25 0.5 0.75")
+    scene_changed = load(power=3)
+    assert dr.allclose(scene_changed.bbox().max, [5, 6, 7])
+
+
+def test33_xml_reload(variant_scalar_rgb, tmp_path):
+    scene_file = tmp_path / 'scene.xml'
+
+    def write(color_b):
+        scene_file.write_text(f"""<scene version="3.0.0">
+            <bsdf type="diffuse" id="bsdf_a">
+                <rgb name="reflectance" value="0.5"/>
+            </bsdf>
+            <bsdf type="diffuse" id="bsdf_b">
+                <rgb name="reflectance" value="{color_b}"/>
+            </bsdf>
+            <shape type="sphere" id="sphere_a">
+                <ref id="bsdf_a"/>
+            </shape>
+            <shape type="sphere" id="sphere_b">
+                <point name="center" x="3" y="0" z="0"/>
+                <ref id="bsdf_b"/>
+            </shape>
+        </scene>""")
+
+    def shapes(scene):
+        return { s.id(): s for s in scene.shapes() }
+
+    write("0.25")
+    scene = mi.load_file(str(scene_file), reload=True)
+
+    # Without changes, all objects except for the scene are reused
+    scene_same = mi.load_file(str(scene_file), reload=True)
+    assert scene_same != scene
+    assert shapes(scene_same) == shapes(scene)
+
+    # Parameter changes made by the application are not carried over
+    params = mi.traverse(scene)
+    params['bsdf_a.reflectance.value'] = 0.75
+    params.update()
+
+    write("0.125")
+    scene_reloaded = mi.load_file(str(scene_file), reload=True)
+    assert len(scene_reloaded.shapes()) == 2
+
+    params = mi.traverse(scene_reloaded)
+    assert dr.allclose(params['bsdf_a.reflectance.value'], 0.5)
+    assert dr.allclose(params['bsdf_b.reflectance.value'], 0.125)
+
+    # The shape referencing the edited BSDF is reused with the new BSDF
+    old, new = shapes(scene), shapes(scene_reloaded)
+    assert new['sphere_a'] != old['sphere_a']
+    assert new['sphere_b'] == old['sphere_b']
+    assert dr.allclose(
+        mi.traverse(new['sphere_b'])['bsdf.reflectance.value'], 0.125)
+
+
+def test34_xml_reload_files(variant_scalar_rgb, tmp_path):
+    mesh_file = tmp_path / 'mesh.ply'
+    scene_file = tmp_path / 'scene.xml'
+    scene_file.write_text("""<scene version="3.0.0">
+        <shape type="ply" id="mesh">
+            <string name="filename" value="mesh.ply"/>
+        </shape>
+    </scene>""")
+
+    def write_mesh(face_count):
+        faces = [[0, 1, 2], [0, 2, 3]][:face_count]
+        mesh_file.write_text("\n".join([
+            "ply", "format ascii 1.0",
+            "element vertex 4",
+            "property float x", "property float y", "property float z",
+            f"element face {face_count}",
+            "property list uchar int vertex_indices",
+            "end_header",
+            "0 0 0", "1 0 0", "1 1 0", "0 1 0",
+            *[f"3 {f[0]} {f[1]} {f[2]}" for f in faces]]) + "\n")
+
+    write_mesh(1)
+    scene = mi.load_file(str(scene_file), reload=True)
+    assert mi.load_file(str(scene_file), reload=True).shapes()[0] == scene.shapes()[0]
+
+    # Files referenced by the objects are compared by their contents
+    write_mesh(2)
+    scene_reloaded = mi.load_file(str(scene_file), reload=True)
+    assert scene_reloaded.shapes()[0] != scene.shapes()[0]
+    assert scene_reloaded.shapes()[0].face_count() == 2
+
+
+def test35_xml_instantiation_report(variant_scalar_rgb, tmp_path):
+    import csv
+    report_file = tmp_path / "report.csv"
+    mi.set_instantiation_report(str(report_file))
+    try:
+        mi.load_string("""<scene version="3.0.0">
+            <bsdf type="diffuse" id="my_bsdf"/>
+            <shape type="sphere" id="my_sphere">
+                <ref id="my_bsdf"/>
+            </shape>
+        </scene>""")
+    finally:
+        mi.set_instantiation_report("")
+
+    with open(report_file) as f:
+        rows = list(csv.DictReader(f))
+
+    objects = {row['id']: row for row in rows}
+    assert 'my_bsdf' in objects and 'my_sphere' in objects
+    assert objects['my_sphere']['class'] == 'shape'
+    assert objects['my_sphere']['plugin'] == 'sphere'
+
+    # Sorted by decreasing instantiation time
+    durations = [float(row['duration']) for row in rows]
+    assert durations == sorted(durations, reverse=True)
+
+    # The sphere can't be instantiated before its BSDF
+    assert float(objects['my_sphere']['start']) >= float(objects['my_bsdf']['end'])
+    assert all(float(row[k]) >= 0 for row in rows
+               for k in ['duration', 'dependency_wait', 'queue_wait'])
+
+
+def test36_xml_streaming(variant_scalar_rgb, tmp_path):
+    scene_file = tmp_path / "scene.xml"
+    scene_file.write_text("""<?xml version="1.0"?>
+<!-- Comment before the root element -->
+<scene version="3.0.0">
+    <default name="radius" value="2"/>
+    <default name="label" value="a > b"/>
+    <bsdf type="diffuse" id="my_bsdf">
+        <rgb name="reflectance" value="0.1, 0.2, 0.3"/>
+    </bsdf>
+    <!-- <shape type="sphere"/> -->
+    <shape type="sphere" id="sphere_1">
+        <float name="radius" value="$radius"/>
+        <ref id="my_bsdf"/>
+    </shape>
+    <shape type="sphere" id="sphere_2">
+        <transform name="to_world">
+            <translate x="4"/>
+        </transform>
+    </shape>
+</scene>""")
+
+    def load(**kwargs):
+        scene = mi.load_file(str(scene_file), **kwargs)
+        return { s.id(): s for s in scene.shapes() }
+
+    shapes_ref = load()
+    mi.set_streaming_threshold(0)
+    try:
+        shapes = load()
+        assert shapes.keys() == shapes_ref.keys()
+        for k in shapes:
+            assert dr.allclose(shapes[k].bbox().min, shapes_ref[k].bbox().min)
+            assert dr.allclose(shapes[k].bbox().max, shapes_ref[k].bbox().max)
+        assert dr.allclose(shapes['sphere_1'].bbox().max, [2, 2, 2])
+        assert shapes['sphere_1'].bsdf().id() == 'my_bsdf'
+
+        # Parameters are substituted and checked
+        shapes = load(radius=3)
+        assert dr.allclose(shapes['sphere_1'].bbox().max, [3, 3, 3])
+        with pytest.raises(Exception, match='Unused parameter'):
+            load(foo=1)
+
+        # Errors are reported at their location in the file
+        text = scene_file.read_text()
+        scene_file.write_text(text.replace('<translate x="4"/>', '<translate y="a"/>'))
+        with pytest.raises(Exception, match='line 16'):
+            load()
+        scene_file.write_text(text.replace('</scene>', ''))
+        with pytest.raises(Exception, match='unexpected end of file'):
+            load()
+    finally:
+        mi.set_streaming_threshold(64 * 1024 * 1024)
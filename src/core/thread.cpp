@@ -493,9 +493,12 @@ bool Thread::register_external_thread(const std::string &prefix) {
     self->d->external_thread = true;
 
     // An external thread will re-use the main thread's Logger (thread safe)
-    // and create a new FileResolver (since the FileResolver is not thread safe).
+    // and create a copy of its FileResolver (since the FileResolver is not
+    // thread safe), so that e.g. Python threads resolve the same search paths.
     self->d->logger = main_thread->d->logger;
-    self->d->fresolver = new FileResolver();
+    self->d->fresolver = main_thread->d->fresolver
+                             ? new FileResolver(*main_thread->d->fresolver)
+                             : new FileResolver();
 
     const std::string &thread_name = self->name();
     #if defined(__linux__)
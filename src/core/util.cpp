@@ -5,6 +5,8 @@
 #include <mitsuba/core/string.h>
 #include <mitsuba/core/filesystem.h>
 #include <mitsuba/core/vector.h>
+#include <atomic>
+#include <random>
 
 #if defined(__linux__)
 #  if !defined(_GNU_SOURCE)
@@ -14,6 +16,8 @@
 #  include <unistd.h>
 #  include <limits.h>
 #  include <sys/ioctl.h>
+#  include <sched.h>
+#  include <fstream>
 #elif defined(__APPLE__)
 #  include <sys/sysctl.h>
 #  include <mach-o/dyld.h>
@@ -120,6 +124,55 @@ done:
 #endif
 }
 
+std::vector<uint32_t> core_numa_nodes() {
+    static std::vector<uint32_t> nodes = []() {
+        std::vector<uint32_t> result;
+
+#if defined(__linux__)
+        // Map operating system CPU indices to NUMA nodes
+        std::vector<uint32_t> cpu_node;
+        for (uint32_t node = 0; ; ++node) {
+            std::ifstream is(tfm::format(
+                "/sys/devices/system/node/node%u/cpulist", node));
+            if (!is.good())
+                break;
+
+            std::string line;
+            std::getline(is, line);
+            for (const std::string &range : string::tokenize(line, ",")) {
+                std::vector<std::string> bounds = string::tokenize(range, "-");
+                if (bounds.empty())
+                    continue;
+                int first = std::stoi(bounds[0]),
+                    last  = bounds.size() > 1 ? std::stoi(bounds[1]) : first;
+                if (cpu_node.size() <= (size_t) last)
+                    cpu_node.resize(last + 1, 0);
+                for (int cpu = first; cpu <= last; ++cpu)
+                    cpu_node[cpu] = node;
+            }
+        }
+
+        /* Enumerate the available cores in the same order as
+           Thread::set_core_affinity() */
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &cpuset))
+                    result.push_back((size_t) cpu < cpu_node.size() ? cpu_node[cpu] : 0);
+            }
+        }
+#endif
+
+        if (result.size() != (size_t) core_count())
+            result = std::vector<uint32_t>(core_count(), 0);
+
+        return result;
+    }();
+
+    return nodes;
+}
+
 bool detect_debugger() {
 #if defined(__linux__)
     char exePath[PATH_MAX];
@@ -248,6 +301,43 @@ fs::path library_path() {
     return fs::absolute(result);
 }
 
+void write_file_atomic(const fs::path &filename,
+                       const std::function<void(const fs::path &)> &write) {
+    static std::atomic<uint32_t> counter { 0 };
+#if defined(_WIN32)
+    unsigned long pid = (unsigned long) GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long) getpid();
+#endif
+    uint32_t salt = std::random_device()() ^ counter++;
+
+    fs::path parent = filename.parent_path();
+    if (!parent.empty() && !fs::create_directories(parent))
+        Throw("write_file_atomic(): could not create directory \"%s\"",
+              parent.string());
+
+    fs::path tmp_file =
+        filename.string() + tfm::format(".%lu.%08x.tmp", pid, salt);
+
+    try {
+        write(tmp_file);
+#if defined(_WIN32)
+        // fs::rename() does not replace existing files on Windows
+        bool success = MoveFileExW(tmp_file.native().c_str(),
+                                   filename.native().c_str(),
+                                   MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        bool success = fs::rename(tmp_file, filename);
+#endif
+        if (!success)
+            Throw("write_file_atomic(): could not rename \"%s\" to \"%s\"",
+                  tmp_file.string(), filename.string());
+    } catch (...) {
+        fs::remove(tmp_file);
+        throw;
+    }
+}
+
 int terminal_width() {
     static int cached_width = -1;
 
@@ -1,22 +1,32 @@
+#include <atomic>
+#include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <set>
+#include <sstream>
+#include <string_view>
 #include <unordered_map>
 #include <mutex>
 #include <map>
 
+#include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/class.h>
 #include <mitsuba/core/config.h>
 #include <mitsuba/core/filesystem.h>
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/math.h>
+#include <mitsuba/core/mmap.h>
 #include <mitsuba/core/object.h>
 #include <mitsuba/core/plugin.h>
 #include <mitsuba/core/profiler.h>
+#include <mitsuba/core/resource.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/string.h>
 #include <mitsuba/core/transform.h>
+#include <mitsuba/core/util.h>
 #include <mitsuba/core/vector.h>
 #include <mitsuba/core/xml.h>
 #include <mitsuba/core/timer.h>
@@ -72,6 +82,31 @@ static std::unordered_map<std::string, Tag> *tags = nullptr;
 static std::unordered_map<std::string, // e.g. bsdf.scalar_rgb
                           const Class *> *tag_class = nullptr;
 
+/// Serialized description and object of a scene object loaded in reload mode
+struct XMLReloadObject {
+    std::string description;
+    ref<Object> object;
+};
+
+/// Objects of a scene file loaded in reload mode (except for the scene itself)
+struct XMLReloadState {
+    std::unordered_map<std::string, XMLReloadObject> objects;
+};
+
+static std::mutex reload_mutex;
+static std::unordered_map<std::string, // e.g. /path/scene.xml.scalar_rgb
+                          XMLReloadState> *reload_states = nullptr;
+/* Objects of all reload states, mapped to whether the application changed
+   their parameters since they were loaded (see invalidate_reload()) */
+static std::unordered_map<const Object *, bool> *reload_modified = nullptr;
+
+/// CSV file receiving the instantiation times (see set_instantiation_report())
+static std::mutex instantiation_report_mutex;
+static fs::path instantiation_report_path;
+
+/// Files above this size are parsed in streaming mode (see set_streaming_threshold())
+static std::atomic<size_t> streaming_threshold { 64ull * 1024 * 1024 };
+
 inline std::string class_key(const std::string &name, const std::string &variant) {
     return name + "." + variant;
 }
@@ -121,8 +156,12 @@ void register_class(const Class *class_) {
 void cleanup() {
     delete tags;
     delete tag_class;
+    delete reload_states;
+    delete reload_modified;
     tags = nullptr;
     tag_class = nullptr;
+    reload_states = nullptr;
+    reload_modified = nullptr;
 }
 
 /// Helper function: map a position offset in bytes to a more readable line/column value
@@ -171,12 +210,19 @@ struct XMLSource {
     std::function<std::string(ptrdiff_t)> offset;
     size_t depth = 0;
     bool modified = false;
+    /// Position of the document in the file (when parsed in streaming mode)
+    ptrdiff_t base = 0;
+
+    /// Position of a node in the file
+    ptrdiff_t location(const pugi::xml_node &n) const {
+        return base + n.offset_debug();
+    }
 
     template <typename... Args>
     [[noreturn]]
     void throw_error(const pugi::xml_node &n, const std::string &msg_, Args&&... args) {
         std::string msg = "Error while loading \"%s\" (at %s): " + msg_ + ".";
-        Throw(msg.c_str(), id, offset(n.offset_debug()), args...);
+        Throw(msg.c_str(), id, offset(location(n)), args...);
     }
 };
 
@@ -190,6 +236,29 @@ struct XMLObject {
     ref<Object> object;
     std::mutex mutex;
     uint32_t scope = 0;
+    /// Position of the object in parsing order
+    size_t index = 0;
+    /// Was the object taken over from a previous load in reload mode?
+    bool reused = false;
+    /// Changed children (and their previous objects) to swap on a reused object
+    std::vector<std::pair<std::string, ref<Object>>> replaced;
+
+    /* Instantiation timing in milliseconds since the start of the
+       instantiation: task creation, the time when all dependencies were
+       available, and the start and end of the plugin construction */
+    bool timed = false;
+    double submit_time = 0, ready_time = 0, start_time = 0, end_time = 0;
+    std::string thread;
+};
+
+/// Texture created while parsing an <rgb> or <spectrum> tag
+struct XMLInlineTexture {
+    std::string name;
+    bool within_emitter;
+    bool rgb;
+    Color3f color;
+    Float const_value;
+    std::vector<Float> wavelengths, values;
 };
 
 enum class ColorMode {
@@ -220,6 +289,25 @@ struct XMLParseContext {
     uint32_t id_counter = 0;
     uint32_t backend = 0;
 
+    /// Set when an object failed to load, which cancels pending instantiations
+    std::atomic<bool> failed { false };
+
+    /* Information needed to store the parsed scene description in a cache:
+       files that were read, <path> directories, and inline textures */
+    bool record = false;
+    std::vector<fs::path> dependencies;
+    std::vector<fs::path> resource_paths;
+    std::unordered_map<const Object *, XMLInlineTexture> inline_textures;
+
+    /// Reference point of the instantiation timing of the objects
+    std::chrono::steady_clock::time_point start_time;
+
+    /// Milliseconds elapsed since \c start_time
+    double elapsed() const {
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start_time).count();
+    }
+
     XMLParseContext(const std::string &variant, bool parallel)
         : variant(variant), parallel(parallel) {
         color_mode = MI_INVOKE_VARIANT(variant, variant_to_color_mode);
@@ -543,6 +631,7 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                     inst.class_ = it2->second;
                     inst.offset = src.offset;
                     inst.src_id = src.id;
+                    inst.index = ctx.instances.size();
 #if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
                     // Deterministically assign a scope to each scene object
                     if (ctx.backend && ctx.parallel) {
@@ -550,7 +639,7 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                         inst.scope = jit_scope((JitBackend) ctx.backend);
                     }
 #endif
-                    inst.location = node.offset_debug();
+                    inst.location = src.location(node);
                     return std::make_pair(name, id);
                 }
                 break;
@@ -579,7 +668,8 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                     inst.alias = alias_src;
                     inst.offset = src.offset;
                     inst.src_id = src.id;
-                    inst.location = node.offset_debug();
+                    inst.index = ctx.instances.size();
+                    inst.location = src.location(node);
 
                     return std::make_pair("", "");
                 }
@@ -622,6 +712,8 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                     if (!fs::exists(resource_path))
                         src.throw_error(node, "<path>: folder \"%s\" not found", resource_path);
                     fs->prepend(resource_path);
+                    if (ctx.record)
+                        ctx.resource_paths.push_back(resource_path);
                     return std::make_pair("", "");
                 }
                 break;
@@ -634,6 +726,8 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                         src.throw_error(node, "included file \"%s\" not found", filename);
 
                     Log(Info, "Loading included XML file \"%s\" ..", filename);
+                    if (ctx.record)
+                        ctx.dependencies.push_back(filename);
 
                     pugi::xml_document doc;
                     pugi::xml_parse_result result = doc.load_file(filename.native().c_str());
@@ -773,6 +867,9 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                         ref<Object> obj = detail::create_texture_from_rgb(
                             name, color, ctx.variant, within_emitter);
                         props.set_object(name, obj);
+                        if (ctx.record)
+                            ctx.inline_textures[obj.get()] = { name, within_emitter,
+                                                               true, color, 0.0, {}, {} };
                     } else {
                         props.set_color("color", color);
                     }
@@ -824,9 +921,19 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                             }
                         } else if (has_filename) {
                             spectrum_from_file(node.attribute("filename").value(), wavelengths, values);
+                            if (ctx.record)
+                                ctx.dependencies.push_back(
+                                    Thread::thread()->file_resolver()->resolve(
+                                        node.attribute("filename").value()));
                         }
                     }
 
+                    // Copy the values, which are scaled by the texture creation
+                    XMLInlineTexture texture;
+                    if (ctx.record)
+                        texture = { name, within_emitter, false, Color3f(0.0),
+                                    const_value, wavelengths, values };
+
                     ref<Object> obj = detail::create_texture_from_spectrum(
                         name, const_value, wavelengths, values, ctx.variant,
                         within_emitter,
@@ -834,6 +941,8 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                         ctx.color_mode == ColorMode::Monochromatic);
 
                     props.set_object(name, obj);
+                    if (ctx.record)
+                        ctx.inline_textures[obj.get()] = std::move(texture);
                 }
                 break;
 
@@ -949,11 +1058,205 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
     return std::make_pair("", "");
 }
 
+/// Kinds of markup found by \ref xml_skip_markup()
+enum class XMLMarkup { Other, Open, Close, Empty };
+
+/**
+ * Skip the markup (tag, comment, processing instruction, ...) starting at the
+ * '<' character at \c p. Returns the position past its end (or \c nullptr
+ * when it is not terminated) and its kind in \c kind.
+ */
+static const char *xml_skip_markup(const char *p, const char *end, XMLMarkup &kind) {
+    std::string_view s(p, end - p);
+    auto skip_to = [&](const char *delim) -> const char * {
+        size_t pos = s.find(delim);
+        return pos == std::string_view::npos ? nullptr : p + pos + strlen(delim);
+    };
+
+    kind = XMLMarkup::Other;
+    if (s.substr(0, 4) == "<!--")
+        return skip_to("-->");
+    if (s.substr(0, 9) == "<![CDATA[")
+        return skip_to("]]>");
+    if (s.substr(0, 2) == "<?")
+        return skip_to("?>");
+
+    // Tags and declarations end with the first '>' outside of quotes
+    char quote = 0;
+    for (const char *it = p + 1; it < end; ++it) {
+        char c = *it;
+        if (quote) {
+            if (c == quote)
+                quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            if (p[1] == '/')
+                kind = XMLMarkup::Close;
+            else if (p[1] != '!')
+                kind = it[-1] == '/' ? XMLMarkup::Empty : XMLMarkup::Open;
+            return it + 1;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Parse a file one element at a time: the start tag of the root element is
+ * parsed first, followed by each of the elements nested in it, whose DOM is
+ * released before the next one is parsed. Returns an empty string (without
+ * modifying the context) when the file can't be streamed, e.g. because it
+ * requires a version upgrade.
+ */
+static std::string init_xml_parse_context_streaming(XMLParseContext &ctx,
+                                                    const fs::path &filename,
+                                                    ParameterList &param) {
+    ref<MemoryMappedFile> mmap = new MemoryMappedFile(filename);
+    const char *start = (const char *) mmap->data(),
+               *end   = start + mmap->size(), *p = start;
+    auto offset = [=](ptrdiff_t pos) { return detail::file_offset(filename, pos); };
+    XMLMarkup kind;
+
+    // Skip the prolog (XML declaration, comments, ..) until the root element
+    const char *root_begin = nullptr, *root_end = nullptr;
+    while (!root_begin) {
+        p = std::find(p, end, '<');
+        const char *next = p == end ? nullptr : xml_skip_markup(p, end, kind);
+        if (!next || kind == XMLMarkup::Close || kind == XMLMarkup::Empty)
+            return ""; // The regular parser reports the error
+        if (kind == XMLMarkup::Open) {
+            root_begin = p;
+            root_end = next;
+        }
+        p = next;
+    }
+
+    // Parse the start tag of the root element, closed right away
+    std::string root_name(root_begin + 1,
+                          std::find_if(root_begin + 1, root_end, [](char c) {
+                              return std::isspace((unsigned char) c) || c == '>';
+                          }));
+    std::string root_text = std::string(root_begin, root_end) + "</" + root_name + ">";
+
+    pugi::xml_document root_doc;
+    if (!root_doc.load_buffer(root_text.data(), root_text.size(),
+                              pugi::parse_default | pugi::parse_comments))
+        return "";
+    pugi::xml_node root = root_doc.document_element();
+
+    auto version_attr = root.attribute("version");
+    try {
+        if (!version_attr || Version(version_attr.value()) < Version(2, 0, 0))
+            return "";
+    } catch (const std::exception &) {
+        return "";
+    }
+
+    Log(Info, "Parsing \"%s\" in streaming mode (%s) ..", filename,
+        util::mem_string(mmap->size()));
+
+    XMLSource root_src { filename.string(), root_doc, offset };
+    root_src.base = root_begin - start;
+    Properties props;
+    size_t arg_counter = 0; // Unused
+    std::string scene_id = parse_xml(root_src, ctx, root, Tag::Invalid, props,
+                                     param, arg_counter, 0).second;
+    XMLObject &scene = ctx.instances.find(scene_id)->second;
+
+    auto fail = [&](const char *pos, const char *msg) {
+        Throw("Error while loading \"%s\" (at %s): %s.", filename,
+              offset(pos - start), msg);
+    };
+
+    // Parse the nested elements one at a time
+    arg_counter = 0;
+    while (true) {
+        const char *text = p;
+        p = std::find(p, end, '<');
+        if (p == end)
+            fail(p, "unexpected end of file");
+        if (std::any_of(text, p, [](char c) { return !std::isspace((unsigned char) c); }))
+            fail(text, "unexpected content");
+
+        const char *element_begin = p,
+                   *next = xml_skip_markup(p, end, kind);
+        if (!next)
+            fail(p, "unterminated markup");
+        if (kind == XMLMarkup::Close)
+            break; // End of the root element
+        p = next;
+
+        // Find the end of the element at the same nesting level
+        size_t depth = kind == XMLMarkup::Open ? 1 : 0;
+        while (depth > 0) {
+            p = std::find(p, end, '<');
+            if (p == end)
+                fail(p, "unexpected end of file");
+            next = xml_skip_markup(p, end, kind);
+            if (!next)
+                fail(p, "unterminated markup");
+            if (kind == XMLMarkup::Open)
+                depth++;
+            else if (kind == XMLMarkup::Close)
+                depth--;
+            p = next;
+        }
+        const char *element_end = p;
+
+        pugi::xml_document doc;
+        pugi::xml_parse_result result =
+            doc.load_buffer(element_begin, element_end - element_begin,
+                            pugi::parse_default | pugi::parse_comments);
+
+        XMLSource src { filename.string(), doc, offset };
+        src.base = element_begin - start;
+        if (!result)
+            Throw("Error while loading \"%s\" (at %s): %s", src.id,
+                  src.offset(src.base + result.offset), result.description());
+
+        for (pugi::xml_node &ch : doc.children()) {
+            auto [arg_name, nested_id] = parse_xml(src, ctx, ch, Tag::Object,
+                                                   scene.props, param,
+                                                   arg_counter, 1);
+            if (nested_id == scene_id)
+                root_src.throw_error(root, "cannot reference parent id \"%s\" "
+                                     "in nested object", nested_id);
+            if (!nested_id.empty())
+                scene.props.set_named_reference(arg_name, nested_id);
+        }
+    }
+
+    // Like in the regular parser, the root element comes after its children
+    scene.index = ctx.instances.size() + 1;
+#if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
+    if (ctx.backend && ctx.parallel) {
+        jit_new_scope((JitBackend) ctx.backend);
+        scene.scope = jit_scope((JitBackend) ctx.backend);
+    }
+#endif
+
+    return scene_id;
+}
+
 static std::string init_xml_parse_context_from_file(XMLParseContext &ctx,
                                                     const fs::path &filename_,
                                                     ParameterList param,
                                                     bool write_update) {
     fs::path filename = filename_;
+    ScopedTraceEvent trace("xml", "Parse XML", filename.string());
+
+    // Large files are parsed one element at a time (unless they are rewritten)
+    if (!write_update && fs::file_size(filename) > streaming_threshold) {
+        std::string scene_id =
+            init_xml_parse_context_streaming(ctx, filename, param);
+        if (!scene_id.empty()) {
+            for (const auto &p : param) {
+                if (!std::get<2>(p))
+                    Throw("Unused parameter \"%s\"!", std::get<0>(p));
+            }
+            return scene_id;
+        }
+    }
 
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_file(filename.native().c_str(),
@@ -1024,9 +1327,13 @@ static Task *instantiate_node(XMLParseContext &ctx,
     if (!inst.alias.empty())
         return instantiate_node(ctx, inst.alias, env, task_map, top_node);
 
+    if (inst.reused && inst.replaced.empty())
+        return nullptr;
+
     Properties &props = inst.props;
     const auto &named_references = props.named_references();
     uint32_t scope = inst.scope;
+    inst.submit_time = ctx.elapsed();
 
     // Recursive graph traversal to gather dependency tasks
     std::vector<Task *> deps;
@@ -1036,10 +1343,12 @@ static Task *instantiate_node(XMLParseContext &ctx,
             Task *task = instantiate_node(ctx, child_id, env, task_map, false);
             task_map.insert({child_id, task});
         }
-        deps.push_back(task_map.find(child_id)->second);
+        // Reused objects (reload mode) don't have a task
+        if (Task *task = task_map.find(child_id)->second)
+            deps.push_back(task);
     }
 
-    auto instantiate = [&ctx, &env, id, scope]() {
+    auto instantiate_impl = [&ctx, &env, id, scope]() {
         ScopedSetThreadEnvironment set_env(env);
         ScopedSetJITScope set_scope(ctx.parallel ? ctx.backend : 0u, scope);
 
@@ -1050,8 +1359,28 @@ static Task *instantiate_node(XMLParseContext &ctx,
         auto &inst = it->second;
         Properties &props = inst.props;
         const auto &named_references = props.named_references();
+        ScopedTraceEvent trace("xml", props.plugin_name(), id);
+        inst.start_time = ctx.elapsed();
+        inst.thread = Thread::thread()->name();
+
+        // Swap the changed children of an otherwise reused object
+        if (inst.reused) {
+            for (auto &[child_id, old_child] : inst.replaced) {
+                auto it2 = ctx.instances.find(child_id);
+                if (it2 == ctx.instances.end() || !it2->second.object ||
+                    !inst.object->replace_object(old_child.get(),
+                                                 it2->second.object.get()))
+                    Throw("Error while loading \"%s\" (near %s): could not "
+                          "replace the object \"%s\" of %s plugin of type \"%s\"",
+                          inst.src_id, inst.offset(inst.location), child_id,
+                          string::to_lower(inst.class_->name()),
+                          props.plugin_name());
+            }
+            return;
+        }
 
         // Populate props with the already instantiated child objects
+        double ready_time = inst.submit_time;
         for (auto &kv : named_references) {
             const std::string& child_id = kv.second;
             auto it2 = ctx.instances.find(child_id);
@@ -1060,6 +1389,15 @@ static Task *instantiate_node(XMLParseContext &ctx,
             ref<Object> obj = it2->second.object;
             Assert(obj);
 
+            const XMLObject *child = &it2->second;
+            if (!child->alias.empty()) {
+                auto it3 = ctx.instances.find(child->alias);
+                if (it3 != ctx.instances.end())
+                    child = &it3->second;
+            }
+            if (child->timed)
+                ready_time = std::max(ready_time, child->end_time);
+
             // Give the object a chance to recursively expand into sub-objects
             std::vector<ref<Object>> children = obj->expand();
             if (children.empty()) {
@@ -1073,6 +1411,8 @@ static Task *instantiate_node(XMLParseContext &ctx,
             }
         }
 
+        inst.ready_time = std::min(ready_time, inst.start_time);
+
         try {
             inst.object = PluginManager::instance()->create_object(props, inst.class_);
         } catch (const std::exception &e) {
@@ -1082,6 +1422,8 @@ static Task *instantiate_node(XMLParseContext &ctx,
                   string::to_lower(inst.class_->name()), props.plugin_name(),
                   e.what());
         }
+        inst.end_time = ctx.elapsed();
+        inst.timed = true;
 
         auto unqueried = props.unqueried();
         if (!unqueried.empty()) {
@@ -1105,6 +1447,20 @@ static Task *instantiate_node(XMLParseContext &ctx,
         }
     };
 
+    /* Once an object failed to load, the scene can't be created anymore.
+       Skip the instantiation of the remaining objects instead of waiting for
+       them (e.g. large meshes and textures) before reporting the error. */
+    auto instantiate = [&ctx, instantiate_impl]() {
+        if (ctx.failed)
+            return;
+        try {
+            instantiate_impl();
+        } catch (...) {
+            ctx.failed = true;
+            throw;
+        }
+    };
+
     if (top_node) {
         // Top node always instantiated on the main thread
         std::exception_ptr eptr;
@@ -1133,14 +1489,750 @@ static Task *instantiate_node(XMLParseContext &ctx,
     }
 }
 
+/// Header of a parsed scene description cache file
+struct XMLCacheHeader {
+    char id[4];
+    uint32_t version;
+    uint64_t key;
+};
+
+static constexpr char XMLCacheId[4] = { 'M', 'I', 'X', 'C' };
+static constexpr uint32_t XMLCacheVersion = 1;
+
+/// 64-bit FNV-1a hash used to identify cached scene descriptions
+static void xml_hash(uint64_t &hash, const void *ptr, size_t size) {
+    const uint8_t *data = (const uint8_t *) ptr;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+}
+
+static void xml_hash(uint64_t &hash, const std::string &value) {
+    uint64_t size = value.size();
+    xml_hash(hash, &size, sizeof(uint64_t));
+    xml_hash(hash, value.data(), value.size());
+}
+
+/// Hash the contents of a file
+static uint64_t xml_file_hash(const fs::path &filename) {
+    std::ifstream is(filename.native(), std::ios::binary);
+    if (!is.good())
+        Throw("could not open \"%s\"", filename);
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    char buffer[4096];
+    while (is.good()) {
+        is.read(buffer, sizeof(buffer));
+        xml_hash(hash, buffer, (size_t) is.gcount());
+    }
+    return hash;
+}
+
+/// Helper to serialize a parsed scene description
+struct XMLCacheWriter {
+    std::string buffer;
+
+    template <typename T> void write(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        buffer.append((const char *) &value, sizeof(T));
+    }
+
+    void write_string(const std::string &value) {
+        write((uint64_t) value.size());
+        buffer.append(value);
+    }
+
+    template <typename Matrix> void write_matrix(const Matrix &m) {
+        for (size_t i = 0; i < Matrix::Size; ++i)
+            for (size_t j = 0; j < Matrix::Size; ++j)
+                write((double) m(i, j));
+    }
+};
+
+/// Helper to deserialize a parsed scene description
+struct XMLCacheReader {
+    const uint8_t *ptr, *end;
+
+    template <typename T> T read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if ((size_t) (end - ptr) < sizeof(T))
+            Throw("file is truncated");
+        T value;
+        std::memcpy(&value, ptr, sizeof(T));
+        ptr += sizeof(T);
+        return value;
+    }
+
+    std::string read_string() {
+        uint64_t size = read<uint64_t>();
+        if ((uint64_t) (end - ptr) < size)
+            Throw("file is truncated");
+        std::string value((const char *) ptr, (size_t) size);
+        ptr += size;
+        return value;
+    }
+
+    /// Read the size of an array whose elements have at least 'size' bytes
+    uint32_t read_count(size_t size) {
+        uint32_t count = read<uint32_t>();
+        if ((size_t) (end - ptr) < count * size)
+            Throw("file is truncated");
+        return count;
+    }
+
+    template <typename Matrix> Matrix read_matrix() {
+        Matrix m;
+        for (size_t i = 0; i < Matrix::Size; ++i)
+            for (size_t j = 0; j < Matrix::Size; ++j)
+                m(i, j) = read<double>();
+        return m;
+    }
+};
+
+/**
+ * \brief Compute the key of a cached scene description
+ *
+ * The key identifies the inputs of the parser other than the contents of the
+ * files, which are verified separately: the file name, the variant, the
+ * parameters and the search path of the file resolver.
+ */
+static uint64_t xml_cache_key(const fs::path &filename, const std::string &variant,
+                              const ParameterList &param) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    xml_hash(hash, &XMLCacheVersion, sizeof(uint32_t));
+    xml_hash(hash, MI_VERSION);
+    xml_hash(hash, fs::absolute(filename).string());
+    xml_hash(hash, variant);
+
+    std::vector<std::pair<std::string, std::string>> sorted;
+    for (const auto &p : param)
+        sorted.emplace_back(std::get<0>(p), std::get<1>(p));
+    std::sort(sorted.begin(), sorted.end());
+    for (const auto &[name, value] : sorted) {
+        xml_hash(hash, name);
+        xml_hash(hash, value);
+    }
+
+    for (const fs::path &path : *Thread::thread()->file_resolver())
+        xml_hash(hash, path.string());
+
+    return hash;
+}
+
+/**
+ * \brief Serialize the parts of a parsed object that determine the result
+ * of its instantiation: its class, alias and properties
+ */
+static void xml_write_object(XMLCacheWriter &w, const XMLParseContext &ctx,
+                             const std::string &id, const XMLObject &inst) {
+    w.write_string(inst.class_ ? inst.class_->name() : "");
+    w.write_string(inst.alias);
+
+    // Copy the properties, since the getters mark them as queried
+    Properties props(inst.props);
+    std::vector<std::string> names = props.property_names();
+    w.write_string(props.plugin_name());
+    w.write_string(props.id());
+    w.write((uint32_t) names.size());
+
+    for (const std::string &name : names) {
+        Properties::Type type = props.type(name);
+        w.write_string(name);
+        w.write((uint32_t) type);
+
+        switch (type) {
+            case Properties::Type::Bool:
+                w.write((uint8_t) props.get<bool>(name));
+                break;
+
+            case Properties::Type::Long:
+                w.write(props.get<int64_t>(name));
+                break;
+
+            case Properties::Type::Float:
+                w.write(props.get<double>(name));
+                break;
+
+            case Properties::Type::Array3f: {
+                    Array3f value = props.get<Array3f>(name);
+                    for (size_t i = 0; i < 3; ++i)
+                        w.write((double) value[i]);
+                }
+                break;
+
+            case Properties::Type::Color: {
+                    Color3f value = props.get<Color3f>(name);
+                    for (size_t i = 0; i < 3; ++i)
+                        w.write((double) value[i]);
+                }
+                break;
+
+            case Properties::Type::Transform3f: {
+                    Transform3f value = props.get<Transform3f>(name);
+                    w.write_matrix(value.matrix);
+                    w.write_matrix(value.inverse_transpose);
+                }
+                break;
+
+            case Properties::Type::Transform4f: {
+                    Transform4f value = props.get<Transform4f>(name);
+                    w.write_matrix(value.matrix);
+                    w.write_matrix(value.inverse_transpose);
+                }
+                break;
+
+            case Properties::Type::String:
+                w.write_string(props.string(name));
+                break;
+
+            case Properties::Type::NamedReference:
+                w.write_string(props.named_reference(name));
+                break;
+
+            case Properties::Type::Object: {
+                    auto it = ctx.inline_textures.find(props.object(name).get());
+                    if (it == ctx.inline_textures.end())
+                        Throw("property \"%s\" of \"%s\" can't be serialized",
+                              name, id);
+                    const XMLInlineTexture &t = it->second;
+                    w.write_string(t.name);
+                    w.write((uint8_t) t.within_emitter);
+                    w.write((uint8_t) t.rgb);
+                    for (size_t i = 0; i < 3; ++i)
+                        w.write((double) t.color[i]);
+                    w.write((double) t.const_value);
+                    w.write((uint32_t) t.wavelengths.size());
+                    for (size_t i = 0; i < t.wavelengths.size(); ++i) {
+                        w.write((double) t.wavelengths[i]);
+                        w.write((double) t.values[i]);
+                    }
+                }
+                break;
+
+            default:
+                Throw("property \"%s\" of \"%s\" can't be serialized",
+                      name, id);
+        }
+    }
+}
+
+/**
+ * \brief Store the parsed scene description of \c ctx in a cache file
+ *
+ * Scene descriptions that contain properties which can't be serialized (e.g.
+ * objects created by other means than inline <rgb> and <spectrum> tags) are
+ * not stored.
+ */
+static void xml_cache_store(const XMLParseContext &ctx, const std::string &scene_id,
+                            const fs::path &filename, uint64_t key) {
+    XMLCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.id, XMLCacheId, 4);
+    header.version = XMLCacheVersion;
+    header.key     = key;
+
+    try {
+        XMLCacheWriter w;
+        w.write(header);
+
+        w.write((uint32_t) ctx.dependencies.size());
+        for (const fs::path &path : ctx.dependencies) {
+            w.write_string(path.string());
+            w.write(xml_file_hash(path));
+        }
+
+        w.write((uint32_t) ctx.resource_paths.size());
+        for (const fs::path &path : ctx.resource_paths)
+            w.write_string(path.string());
+
+        w.write_string(scene_id);
+
+        // Objects in parsing order, which determines their JIT scopes
+        std::vector<std::pair<const std::string *, const XMLObject *>> instances;
+        for (const auto &[id, inst] : ctx.instances)
+            instances.emplace_back(&id, &inst);
+        std::sort(instances.begin(), instances.end(),
+                  [](const auto &a, const auto &b) { return a.second->index < b.second->index; });
+
+        w.write((uint32_t) instances.size());
+        for (const auto &[id, inst] : instances) {
+            w.write_string(*id);
+            w.write_string(inst->src_id);
+            w.write((uint64_t) inst->location);
+            xml_write_object(w, ctx, *id, *inst);
+        }
+
+        /* Write to a temporary file first, so that concurrent processes never
+           observe a partially written cache entry */
+        util::write_file_atomic(filename, [&](const fs::path &tmp_file) {
+            ref<MemoryMappedFile> mmap = new MemoryMappedFile(tmp_file, w.buffer.size());
+            std::memcpy(mmap->data(), w.buffer.data(), w.buffer.size());
+        });
+
+        Log(Info, "Stored the parsed scene description in \"%s\"", filename);
+    } catch (const std::exception &e) {
+        Log(Warn, "Could not store the scene description cache file \"%s\": %s",
+            filename, e.what());
+    }
+}
+
+/**
+ * \brief Restore a parsed scene description from a cache file
+ *
+ * Returns the id of the scene object, or an empty string when the file
+ * doesn't exist, is invalid, or when one of the files that were read by the
+ * parser changed since it was written.
+ */
+static std::string xml_cache_load(XMLParseContext &ctx, const fs::path &filename,
+                                  uint64_t key) {
+    if (!fs::exists(filename))
+        return "";
+
+    try {
+        ref<MemoryMappedFile> mmap = new MemoryMappedFile(filename);
+        const uint8_t *data = (const uint8_t *) mmap->data();
+        XMLCacheReader r { data, data + mmap->size() };
+
+        XMLCacheHeader header = r.read<XMLCacheHeader>();
+        if (std::memcmp(header.id, XMLCacheId, 4) != 0 ||
+            header.version != XMLCacheVersion)
+            Throw("unsupported file format");
+        if (header.key != key)
+            Throw("file does not match the scene parameters");
+
+        uint32_t dependency_count = r.read_count(16);
+        for (uint32_t i = 0; i < dependency_count; ++i) {
+            fs::path path = r.read_string();
+            uint64_t hash = r.read<uint64_t>();
+            if (!fs::exists(path) || xml_file_hash(path) != hash) {
+                Log(Info, "Ignoring the scene description cache file \"%s\" "
+                    "(\"%s\" changed)", filename, path);
+                return "";
+            }
+        }
+
+        std::vector<fs::path> resource_paths(r.read_count(8));
+        for (fs::path &path : resource_paths)
+            path = r.read_string();
+
+        std::string scene_id = r.read_string();
+
+        uint32_t instance_count = r.read_count(8);
+        for (uint32_t i = 0; i < instance_count; ++i) {
+            std::string id = r.read_string();
+
+            auto &inst = ctx.instances[id];
+            inst.src_id = r.read_string();
+            inst.location = (size_t) r.read<uint64_t>();
+            inst.index = i;
+
+            std::string class_name = r.read_string();
+            if (!class_name.empty()) {
+                inst.class_ = Class::for_name(class_name, ctx.variant);
+                if (!inst.class_)
+                    Throw("unknown class \"%s\"", class_name);
+            }
+            inst.alias = r.read_string();
+            fs::path src_file = inst.src_id;
+            inst.offset = [src_file](ptrdiff_t pos) { return file_offset(src_file, pos); };
+
+#if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
+            // Assign scopes in the same order as the parser
+            if (ctx.backend && ctx.parallel && inst.alias.empty()) {
+                jit_new_scope((JitBackend) ctx.backend);
+                inst.scope = jit_scope((JitBackend) ctx.backend);
+            }
+#endif
+
+            Properties &props = inst.props;
+            props.set_plugin_name(r.read_string());
+            props.set_id(r.read_string());
+
+            uint32_t property_count = r.read_count(8);
+            for (uint32_t j = 0; j < property_count; ++j) {
+                std::string name = r.read_string();
+                Properties::Type type = (Properties::Type) r.read<uint32_t>();
+
+                switch (type) {
+                    case Properties::Type::Bool:
+                        props.set_bool(name, r.read<uint8_t>() != 0);
+                        break;
+
+                    case Properties::Type::Long:
+                        props.set_long(name, r.read<int64_t>());
+                        break;
+
+                    case Properties::Type::Float:
+                        props.set_float(name, r.read<double>());
+                        break;
+
+                    case Properties::Type::Array3f: {
+                            Array3f value;
+                            for (size_t k = 0; k < 3; ++k)
+                                value[k] = r.read<double>();
+                            props.set_array3f(name, value);
+                        }
+                        break;
+
+                    case Properties::Type::Color: {
+                            Color3f value;
+                            for (size_t k = 0; k < 3; ++k)
+                                value[k] = r.read<double>();
+                            props.set_color(name, value);
+                        }
+                        break;
+
+                    case Properties::Type::Transform3f: {
+                            auto m = r.read_matrix<Matrix3f>();
+                            auto inv = r.read_matrix<Matrix3f>();
+                            props.set_transform3f(name, Transform3f(m, inv));
+                        }
+                        break;
+
+                    case Properties::Type::Transform4f: {
+                            auto m = r.read_matrix<Matrix4f>();
+                            auto inv = r.read_matrix<Matrix4f>();
+                            props.set_transform(name, Transform4f(m, inv));
+                        }
+                        break;
+
+                    case Properties::Type::String:
+                        props.set_string(name, r.read_string());
+                        break;
+
+                    case Properties::Type::NamedReference:
+                        props.set_named_reference(name, r.read_string());
+                        break;
+
+                    case Properties::Type::Object: {
+                            XMLInlineTexture t;
+                            t.name = r.read_string();
+                            t.within_emitter = r.read<uint8_t>() != 0;
+                            t.rgb = r.read<uint8_t>() != 0;
+                            for (size_t k = 0; k < 3; ++k)
+                                t.color[k] = r.read<double>();
+                            t.const_value = r.read<double>();
+                            uint32_t size = r.read_count(16);
+                            t.wavelengths.resize(size);
+                            t.values.resize(size);
+                            for (uint32_t k = 0; k < size; ++k) {
+                                t.wavelengths[k] = r.read<double>();
+                                t.values[k] = r.read<double>();
+                            }
+
+                            ref<Object> obj;
+                            if (t.rgb) {
+                                obj = create_texture_from_rgb(t.name, t.color, ctx.variant,
+                                                              t.within_emitter);
+                            } else {
+                                // Pass copies, since the values are scaled in place
+                                std::vector<Float> wavelengths = t.wavelengths,
+                                                   values = t.values;
+                                obj = create_texture_from_spectrum(
+                                    t.name, t.const_value, wavelengths, values,
+                                    ctx.variant, t.within_emitter,
+                                    ctx.color_mode == ColorMode::Spectral,
+                                    ctx.color_mode == ColorMode::Monochromatic);
+                            }
+                            props.set_object(name, obj);
+                            ctx.inline_textures[obj.get()] = std::move(t);
+                        }
+                        break;
+
+                    default:
+                        Throw("unsupported property type");
+                }
+            }
+        }
+
+        if (r.ptr != r.end)
+            Throw("unexpected data at the end of the file");
+        if (ctx.instances.find(scene_id) == ctx.instances.end())
+            Throw("the scene object is missing");
+
+        // Extend the search path like the <path> tags of the scene
+        ref<FileResolver> resolver = Thread::thread()->file_resolver();
+        for (const fs::path &path : resource_paths)
+            resolver->prepend(path);
+
+        return scene_id;
+    } catch (const std::exception &e) {
+        Log(Warn, "Ignoring the scene description cache file \"%s\": %s",
+            filename, e.what());
+        ctx.instances.clear();
+        return "";
+    }
+}
+
+/**
+ * \brief Describe the objects of a scene file loaded in reload mode
+ *
+ * The descriptions identify the objects when the file is reloaded the next
+ * time. Besides the class, properties and named references of an object,
+ * they contain the hashes of the files referenced by its string properties
+ * (e.g. meshes and textures), so that objects are loaded again when one of
+ * these files changes on disk. Objects that can't be described, and the
+ * scene itself, are always instantiated again.
+ */
+static std::unordered_map<std::string, std::string>
+xml_reload_describe(const XMLParseContext &ctx) {
+    ref<FileResolver> resolver = Thread::thread()->file_resolver();
+    std::unordered_map<std::string, std::string> descriptions;
+    for (const auto &[id, inst] : ctx.instances) {
+        if (!inst.alias.empty() || (inst.class_ && inst.class_->name() == "Scene"))
+            continue;
+        XMLCacheWriter w;
+        try {
+            xml_write_object(w, ctx, id, inst);
+
+            // Copy the properties, since the getters mark them as queried
+            Properties props(inst.props);
+            for (const std::string &name : props.property_names()) {
+                if (props.type(name) != Properties::Type::String)
+                    continue;
+                fs::path path = resolver->resolve(props.string(name));
+                if (fs::is_regular_file(path)) {
+                    w.write_string(name);
+                    w.write(xml_file_hash(path));
+                }
+            }
+        } catch (const std::exception &) {
+            continue;
+        }
+        descriptions[id] = std::move(w.buffer);
+    }
+    return descriptions;
+}
+
+/**
+ * \brief Take over the objects of the previous load of a scene file
+ *
+ * An object is reused when its description (see xml_reload_describe()) is
+ * unchanged, when the application didn't change its parameters since (see
+ * invalidate_reload()), and when this also holds for all objects that it
+ * references. The BSDF of a shape is the exception: a changed BSDF is
+ * instantiated again and swapped on the reused shape. Must be called with
+ * \c reload_mutex held.
+ */
+static void
+xml_reload_reuse(XMLParseContext &ctx, const XMLReloadState &state,
+                 const std::unordered_map<std::string, std::string> &descriptions) {
+    auto resolve_alias = [&](const std::string &id) -> const std::string & {
+        auto it = ctx.instances.find(id);
+        if (it != ctx.instances.end() && !it->second.alias.empty())
+            return it->second.alias;
+        return id;
+    };
+
+    /* Can a changed child be swapped on the previous object of 'inst'? This
+       requires the previous object of the child to identify it. */
+    auto swappable = [&](const XMLObject &inst, const std::string &child_id) {
+        auto it = ctx.instances.find(child_id);
+        return inst.class_ && inst.class_->name() == "Shape" &&
+               it != ctx.instances.end() && it->second.class_ &&
+               it->second.class_->name() == "BSDF" &&
+               state.objects.find(child_id) != state.objects.end();
+    };
+
+    /* 'reusable' records whether the previous object can be taken over, and
+       'changed' whether the object differs for the objects referencing it */
+    std::unordered_map<std::string, bool> changed, reusable;
+    std::unordered_map<std::string, std::vector<std::string>> swaps;
+    std::function<bool(const std::string &)> is_changed = [&](const std::string &id) {
+        auto it = changed.find(id);
+        if (it != changed.end())
+            return it->second;
+        changed[id] = true;
+
+        bool result = true;
+        auto it_inst = ctx.instances.find(id);
+        if (it_inst != ctx.instances.end()) {
+            const XMLObject &inst = it_inst->second;
+            if (!inst.alias.empty()) {
+                result = is_changed(inst.alias);
+            } else {
+                auto it_desc = descriptions.find(id);
+                auto it_old = state.objects.find(id);
+                bool reuse = it_desc != descriptions.end() &&
+                             it_old != state.objects.end() &&
+                             it_desc->second == it_old->second.description;
+                if (reuse && reload_modified) {
+                    auto it_mod = reload_modified->find(it_old->second.object.get());
+                    reuse = it_mod != reload_modified->end() && !it_mod->second;
+                }
+
+                std::vector<std::string> inst_swaps;
+                for (auto &kv : inst.props.named_references()) {
+                    if (!reuse)
+                        break;
+                    if (!is_changed(kv.second))
+                        continue;
+                    const std::string &child_id = resolve_alias(kv.second);
+                    if (swappable(inst, child_id))
+                        inst_swaps.push_back(child_id);
+                    else
+                        reuse = false;
+                }
+
+                reusable[id] = reuse;
+                if (reuse && !inst_swaps.empty())
+                    swaps[id] = std::move(inst_swaps);
+                result = !reuse || swaps.find(id) != swaps.end();
+            }
+        }
+
+        changed[id] = result;
+        return result;
+    };
+
+    size_t reused = 0, replaced = 0;
+    for (auto &[id, inst] : ctx.instances) {
+        if (!inst.alias.empty())
+            continue;
+        is_changed(id);
+        if (!reusable[id])
+            continue;
+        inst.object = state.objects.find(id)->second.object;
+        inst.reused = true;
+        reused++;
+
+        auto it = swaps.find(id);
+        if (it != swaps.end()) {
+            for (const std::string &child_id : it->second)
+                inst.replaced.emplace_back(
+                    child_id, state.objects.find(child_id)->second.object);
+            replaced++;
+        }
+    }
+
+    Log(Info, "Reusing %i of %i objects of the previous load (%i with "
+        "replaced BSDFs).", reused, descriptions.size(), replaced);
+}
+
+/// Log the slowest instantiated objects and write the CSV report if requested
+static void report_instantiation_times(const XMLParseContext &ctx) {
+    std::vector<std::pair<const std::string *, const XMLObject *>> objects;
+    for (auto &[id, inst] : ctx.instances) {
+        if (inst.timed)
+            objects.emplace_back(&id, &inst);
+    }
+    if (objects.empty())
+        return;
+
+    std::sort(objects.begin(), objects.end(), [](const auto &a, const auto &b) {
+        return a.second->end_time - a.second->start_time >
+               b.second->end_time - b.second->start_time;
+    });
+
+    auto ms = [](double value) {
+        return util::time_string((float) value, true);
+    };
+
+    size_t count = std::min(objects.size(), (size_t) 20);
+    std::ostringstream oss;
+    oss << "Slowest " << count << " of " << objects.size()
+        << " instantiated objects:";
+    for (size_t i = 0; i < count; ++i) {
+        const auto &[id, inst] = objects[i];
+        oss << std::endl << "  " << ms(inst->end_time - inst->start_time)
+            << ": " << string::to_lower(inst->class_->name()) << " \""
+            << *id << "\" (type \"" << inst->props.plugin_name()
+            << "\", thread \"" << inst->thread << "\", waited "
+            << ms(inst->ready_time - inst->submit_time)
+            << " for its dependencies)";
+    }
+    Log(Info, "%s", oss.str());
+
+    fs::path path;
+    {
+        std::lock_guard<std::mutex> guard(instantiation_report_mutex);
+        path = instantiation_report_path;
+    }
+    if (path.empty())
+        return;
+
+    std::ofstream os(path.native());
+    if (!os.good()) {
+        Log(Warn, "Could not write the instantiation report \"%s\"!", path);
+        return;
+    }
+
+    /* All times are in milliseconds. The dependency wait extends from the
+       creation of the task to the completion of the last dependency, and the
+       queue wait from then until a thread started the instantiation. */
+    os << "id,class,plugin,file,thread,duration,dependency_wait,queue_wait,"
+          "start,end" << std::endl;
+    auto quote = [](const std::string &value) {
+        std::string result = "\"";
+        for (char c : value) {
+            if (c == '"')
+                result += '"';
+            result += c;
+        }
+        return result + "\"";
+    };
+    for (const auto &[id, inst] : objects)
+        os << quote(*id) << "," << string::to_lower(inst->class_->name())
+           << "," << quote(inst->props.plugin_name()) << ","
+           << quote(inst->src_id) << "," << quote(inst->thread) << ","
+           << inst->end_time - inst->start_time << ","
+           << inst->ready_time - inst->submit_time << ","
+           << inst->start_time - inst->ready_time << "," << inst->start_time
+           << "," << inst->end_time << std::endl;
+
+    Log(Info, "Wrote the instantiation report \"%s\".", path);
+}
+
+void prefetch_resources(const std::vector<const Properties *> &props) {
+    FileResolver *resolver = Thread::thread()->file_resolver();
+    std::vector<std::pair<size_t, fs::path>> files;
+    for (const Properties *p : props) {
+        if (p->plugin_name() != "bitmap" || p->has_property("bitmap") ||
+            !p->has_property("filename") ||
+            p->type("filename") != Properties::Type::String)
+            continue;
+        fs::path path = resolver->resolve(p->string("filename"));
+        if (!fs::exists(path))
+            continue; // Reported by the plugin
+        files.emplace_back(fs::file_size(path), path);
+    }
+
+    // Start with the largest files, which take the longest to decode
+    std::sort(files.begin(), files.end(), [](const auto &a, const auto &b) {
+        if (a.first != b.first)
+            return a.first > b.first;
+        return a.second.string() < b.second.string();
+    });
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+
+    for (const auto &[size, path] : files)
+        ResourceCache::prefetch<Bitmap>(path);
+}
+
 static ref<Object> instantiate_top_node(XMLParseContext &ctx, const std::string &id) {
     ThreadEnvironment env;
+    // Files that are referenced several times are only loaded once
+    ResourceCache::Scope resource_scope;
     std::unordered_map<std::string, Task*> task_map;
+    ScopedKernelStatistics kernel_stats(ProfilerPhase::InitScene, ctx.backend);
+    ctx.start_time = std::chrono::steady_clock::now();
+    if (ctx.parallel) {
+        std::vector<const Properties *> props;
+        for (const auto &[name, inst] : ctx.instances) {
+            if (!inst.reused)
+                props.push_back(&inst.props);
+        }
+        prefetch_resources(props);
+    }
     instantiate_node(ctx, id, env, task_map, true);
 #if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
     if (ctx.backend && ctx.parallel)
         jit_new_scope((JitBackend) ctx.backend);
 #endif
+    report_instantiation_times(ctx);
+    if (kernel_stats.active())
+        Log(Info, "%s", kernel_stats.finish().to_string());
     return ctx.instances.find(id)->second.object;
 }
 
@@ -1320,6 +2412,24 @@ std::vector<std::pair<std::string, Properties>> xml_to_properties(const fs::path
 
 NAMESPACE_END(detail)
 
+void set_instantiation_report(const fs::path &path) {
+    std::lock_guard<std::mutex> guard(detail::instantiation_report_mutex);
+    detail::instantiation_report_path = path;
+}
+
+void set_streaming_threshold(size_t size) {
+    detail::streaming_threshold = size;
+}
+
+void invalidate_reload(const Object *object) {
+    std::lock_guard<std::mutex> guard(detail::reload_mutex);
+    if (!detail::reload_modified)
+        return;
+    auto it = detail::reload_modified->find(object);
+    if (it != detail::reload_modified->end())
+        it->second = true;
+}
+
 std::vector<ref<Object>> load_string(const std::string &string,
                                      const std::string &variant,
                                      ParameterList param,
@@ -1370,7 +2480,9 @@ std::vector<ref<Object>> load_file(const fs::path &filename,
                                    const std::string &variant,
                                    ParameterList param,
                                    bool write_update,
-                                   bool parallel) {
+                                   bool parallel,
+                                   const fs::path &cache_dir,
+                                   bool reload) {
     ScopedPhase sp(ProfilerPhase::InitScene);
 
     if (!fs::exists(filename))
@@ -1387,11 +2499,73 @@ std::vector<ref<Object>> load_file(const fs::path &filename,
 
     try {
         detail::XMLParseContext ctx(variant, parallel);
-        auto scene_id = detail::init_xml_parse_context_from_file(ctx, filename, param, write_update);
+        std::string scene_id;
+
+        /* Look up the parsed scene description in the cache. Scenes that are
+           upgraded and written back to disk are always parsed. */
+        fs::path cache_file;
+        uint64_t cache_key = 0;
+        if (!cache_dir.empty() && !write_update) {
+            cache_key = detail::xml_cache_key(filename, variant, param);
+            cache_file = cache_dir / fs::path(tfm::format(
+                "xml_%016llx.bin", (unsigned long long) cache_key));
+            scene_id = detail::xml_cache_load(ctx, cache_file, cache_key);
+            if (!scene_id.empty())
+                Log(Info, "Loaded the parsed scene description from \"%s\"", cache_file);
+        }
+
+        if (scene_id.empty()) {
+            // Inline textures must be recorded to describe the objects
+            ctx.record = !cache_file.empty() || reload;
+            if (ctx.record)
+                ctx.dependencies.push_back(filename);
+
+            scene_id = detail::init_xml_parse_context_from_file(ctx, filename, param, write_update);
+
+            if (!cache_file.empty())
+                detail::xml_cache_store(ctx, scene_id, cache_file, cache_key);
+        }
+
+        // Reuse the unchanged objects of the previous load in reload mode
+        std::string reload_key;
+        std::unordered_map<std::string, std::string> descriptions;
+        if (reload) {
+            reload_key = fs::absolute(filename).string() + "." + variant;
+            descriptions = detail::xml_reload_describe(ctx);
+            std::lock_guard<std::mutex> guard(detail::reload_mutex);
+            if (detail::reload_states) {
+                auto it = detail::reload_states->find(reload_key);
+                if (it != detail::reload_states->end())
+                    detail::xml_reload_reuse(ctx, it->second, descriptions);
+            }
+        }
 
         ref<Object> top_node = detail::instantiate_top_node(ctx, scene_id);
         std::vector<ref<Object>> objects = detail::expand_node(top_node);
 
+        if (reload) {
+            detail::XMLReloadState state;
+            for (auto &[id, desc] : descriptions) {
+                const ref<Object> &obj = ctx.instances.find(id)->second.object;
+                if (obj)
+                    state.objects[id] = { std::move(desc), obj };
+            }
+
+            std::lock_guard<std::mutex> guard(detail::reload_mutex);
+            if (!detail::reload_states) {
+                detail::reload_states =
+                    new std::unordered_map<std::string, detail::XMLReloadState>();
+                detail::reload_modified =
+                    new std::unordered_map<const Object *, bool>();
+            }
+            detail::XMLReloadState &previous = (*detail::reload_states)[reload_key];
+            for (auto &[id, entry] : previous.objects)
+                detail::reload_modified->erase(entry.object.get());
+            for (auto &[id, entry] : state.objects)
+                (*detail::reload_modified)[entry.object.get()] = false;
+            previous = std::move(state);
+        }
+
         Thread::thread()->set_file_resolver(fs_backup.get());
 
         Log(Info, "Done loading XML file \"%s\" (took %s).",
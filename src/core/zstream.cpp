@@ -1,13 +1,54 @@
 #include <mitsuba/core/zstream.h>
+#include <nanothread/nanothread.h>
 #include <zlib.h>
+#include <algorithm>
 
 NAMESPACE_BEGIN(mitsuba)
 
-ZStream::ZStream(Stream *child_stream, EStreamType stream_type, int level)
+/// Block of an EBlockStream that is being compressed or decompressed
+struct ZStream::Block {
+    std::vector<uint8_t> raw, stored;
+    Task *task = nullptr;
+    std::string error;
+
+    /// Wait for the compression or decompression to finish
+    void wait() {
+        if (task) {
+            task_wait_and_release(task);
+            task = nullptr;
+        }
+    }
+};
+
+/// Maximum number of blocks that are compressed or decompressed concurrently
+static size_t zstream_blocks_in_flight() {
+    return std::max((size_t) 2, (size_t) pool_size() * 2);
+}
+
+static void zstream_write_u32(Stream *stream, uint32_t value) {
+    uint8_t data[4] = { (uint8_t) value, (uint8_t) (value >> 8),
+                        (uint8_t) (value >> 16), (uint8_t) (value >> 24) };
+    stream->write(data, sizeof(data));
+}
+
+static uint32_t zstream_read_u32(Stream *stream) {
+    uint8_t data[4];
+    stream->read(data, sizeof(data));
+    return (uint32_t) data[0] | ((uint32_t) data[1] << 8) |
+           ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+ZStream::ZStream(Stream *child_stream, EStreamType stream_type, int level,
+                 size_t block_size)
     : m_child_stream(child_stream),
       m_deflate_stream(new z_stream()),
       m_inflate_stream(new z_stream()),
-      m_did_write(false) {
+      m_did_write(false), m_stream_type(stream_type), m_level(level),
+      m_block_size(block_size), m_read_pos(0), m_read_done(false) {
+    if (stream_type == EBlockStream &&
+        (block_size == 0 || block_size > 0xFFFFFFFFull))
+        Throw("ZStream(): the block size must be between 1 byte and 4 GiB!");
+
     m_deflate_stream->zalloc = Z_NULL;
     m_deflate_stream->zfree = Z_NULL;
     m_deflate_stream->opaque = Z_NULL;
@@ -31,9 +72,99 @@ ZStream::ZStream(Stream *child_stream, EStreamType stream_type, int level)
         Throw("Could not initialize ZLIB: error code %i", retval);
 }
 
+void ZStream::submit_block() {
+    std::unique_ptr<Block> block(new Block());
+    block->raw.swap(m_pending);
+    m_pending.reserve(m_block_size);
+
+    Block *b = block.get();
+    int level = m_level;
+    b->task = dr::do_async([b, level]() {
+        uLongf stored_size = compressBound((uLong) b->raw.size());
+        b->stored.resize(stored_size);
+        int retval = compress2(b->stored.data(), &stored_size, b->raw.data(),
+                               (uLong) b->raw.size(), level);
+        if (retval != Z_OK)
+            b->error = tfm::format("compress2(): error code %i", retval);
+        b->stored.resize(stored_size);
+    });
+    m_write_blocks.push_back(std::move(block));
+
+    while (m_write_blocks.size() > zstream_blocks_in_flight())
+        write_block();
+}
+
+void ZStream::write_block() {
+    std::unique_ptr<Block> block = std::move(m_write_blocks.front());
+    m_write_blocks.pop_front();
+    block->wait();
+    if (!block->error.empty())
+        Throw("ZStream: %s", block->error);
+    zstream_write_u32(m_child_stream, (uint32_t) block->raw.size());
+    zstream_write_u32(m_child_stream, (uint32_t) block->stored.size());
+    m_child_stream->write(block->stored.data(), block->stored.size());
+}
+
+void ZStream::fetch_blocks() {
+    size_t max_blocks = zstream_blocks_in_flight();
+    while (!m_read_done && m_read_blocks.size() < max_blocks) {
+        // The stream also ends when the child stream does (e.g. when not closed)
+        if (m_child_stream->tell() == m_child_stream->size()) {
+            m_read_done = true;
+            break;
+        }
+
+        uint32_t raw_size = zstream_read_u32(m_child_stream),
+                 stored_size = zstream_read_u32(m_child_stream);
+        if (raw_size == 0) {
+            m_read_done = true;
+            break;
+        }
+
+        std::unique_ptr<Block> block(new Block());
+        block->raw.resize(raw_size);
+        block->stored.resize(stored_size);
+        m_child_stream->read(block->stored.data(), stored_size);
+
+        Block *b = block.get();
+        b->task = dr::do_async([b]() {
+            uLongf raw_size = (uLongf) b->raw.size();
+            int retval = uncompress(b->raw.data(), &raw_size, b->stored.data(),
+                                    (uLong) b->stored.size());
+            if (retval != Z_OK || raw_size != b->raw.size())
+                b->error = tfm::format("uncompress(): error code %i", retval);
+            b->stored = std::vector<uint8_t>();
+        });
+        m_read_blocks.push_back(std::move(block));
+    }
+}
+
+void ZStream::release_blocks() {
+    for (auto &block : m_write_blocks)
+        block->wait();
+    for (auto &block : m_read_blocks)
+        block->wait();
+    m_write_blocks.clear();
+    m_read_blocks.clear();
+}
+
 void ZStream::write(const void *ptr, size_t size) {
     Assert(m_child_stream != nullptr);
 
+    if (m_stream_type == EBlockStream) {
+        const uint8_t *data = (const uint8_t *) ptr;
+        while (size > 0) {
+            size_t amount = std::min(size, m_block_size - m_pending.size());
+            m_pending.insert(m_pending.end(), data, data + amount);
+            data += amount;
+            size -= amount;
+            if (m_pending.size() == m_block_size)
+                submit_block();
+        }
+        m_did_write = true;
+        return;
+    }
+
     m_deflate_stream->avail_in = (uInt) size;
     m_deflate_stream->next_in = (uint8_t *) ptr;
 
@@ -59,6 +190,32 @@ void ZStream::write(const void *ptr, size_t size) {
 void ZStream::read(void *ptr, size_t size) {
     Assert(m_child_stream != nullptr);
 
+    if (m_stream_type == EBlockStream) {
+        uint8_t *target = (uint8_t *) ptr;
+        while (size > 0) {
+            fetch_blocks();
+            if (m_read_blocks.empty())
+                Throw("Read less data than expected (%i more bytes required)", size);
+
+            Block *block = m_read_blocks.front().get();
+            block->wait();
+            if (!block->error.empty())
+                Throw("ZStream: %s", block->error);
+
+            size_t amount = std::min(size, block->raw.size() - m_read_pos);
+            memcpy(target, block->raw.data() + m_read_pos, amount);
+            target += amount;
+            size -= amount;
+            m_read_pos += amount;
+
+            if (m_read_pos == block->raw.size()) {
+                m_read_blocks.pop_front();
+                m_read_pos = 0;
+            }
+        }
+        return;
+    }
+
     uint8_t *targetPtr = (uint8_t *) ptr;
     while (size > 0) {
         if (m_inflate_stream->avail_in == 0) {
@@ -101,6 +258,15 @@ void ZStream::read(void *ptr, size_t size) {
 void ZStream::flush() {
     Assert(m_child_stream != nullptr);
 
+    if (m_stream_type == EBlockStream) {
+        if (!m_pending.empty())
+            submit_block();
+        while (!m_write_blocks.empty())
+            write_block();
+        m_child_stream->flush();
+        return;
+    }
+
     if (m_did_write) {
         m_deflate_stream->avail_in = 0;
         m_deflate_stream->next_in = NULL;
@@ -127,7 +293,23 @@ void ZStream::close() {
     if (!m_child_stream)
         return;
 
-    if (m_did_write) {
+    if (m_stream_type == EBlockStream) {
+        try {
+            if (m_did_write) {
+                flush();
+                // An empty block marks the end of the stream
+                zstream_write_u32(m_child_stream, 0);
+                zstream_write_u32(m_child_stream, 0);
+            }
+        } catch (...) {
+            release_blocks();
+            deflateEnd(m_deflate_stream.get());
+            inflateEnd(m_inflate_stream.get());
+            m_child_stream = nullptr;
+            throw;
+        }
+        release_blocks();
+    } else if (m_did_write) {
         m_deflate_stream->avail_in = 0;
         m_deflate_stream->next_in = NULL;
         int output_size = 0;
@@ -243,6 +243,35 @@ public:
         return { ps, weight };
     }
 
+    Float pdf_position(const PositionSample3f &ps, Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::EndpointEvaluate, active);
+
+        if constexpr (drjit::is_jit_v<Float>) {
+            if (!m_shape)
+                return 0.f;
+        } else {
+            Assert(m_shape, "The area emitter has no associated Shape!");
+        }
+
+        if (!m_radiance->is_spatially_varying())
+            return m_shape->pdf_position(ps, active);
+
+        SurfaceInteraction3f si =
+            m_shape->eval_parameterization(ps.uv, +RayFlags::dPdUV, active);
+        active &= si.is_valid();
+
+        return dr::select(active,
+                          m_radiance->pdf_position(ps.uv, active) /
+                              dr::norm(dr::cross(si.dp_du, si.dp_dv)),
+                          0.f);
+    }
+
+    Float pdf_ray_direction(const PositionSample3f &ps, const Vector3f &d,
+                            Mask /*active*/) const override {
+        // Cosine-weighted hemisphere around the normal, see \ref sample_ray()
+        return dr::maximum(dr::dot(ps.n, d), 0.f) * dr::InvPi<Float>;
+    }
+
     std::pair<Wavelength, Spectrum>
     sample_wavelengths(const SurfaceInteraction3f &si, Float sample,
                        Mask active) const override {
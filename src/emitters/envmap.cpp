@@ -1,3 +1,4 @@
+#include <mitsuba/core/atomic.h>
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/bsphere.h>
 #include <mitsuba/core/distr_2d.h>
@@ -21,7 +22,7 @@ Environment emitter (:monosp:`envmap`)
 --------------------------------------
 
 .. pluginparameters::
- :extra-rows: 4
+ :extra-rows: 6
 
  * - filename
    - |string|
@@ -49,6 +50,23 @@ Environment emitter (:monosp:`envmap`)
      will be combined using multiple importance sampling (MIS)? This is
      extremely cheap to do and can slightly reduce variance. (Default: false)
 
+ * - product_bins
+   - |int|
+   - Resolution of the grid of surface normals for which cosine-weighted
+     sampling tables are precomputed (see below). Disabled when set to zero.
+     (Default: 0)
+
+ * - visibility_grid
+   - |int|
+   - Resolution along each axis of a grid over the scene bounding box whose
+     cells learn the unoccluded parts of the environment (see below).
+     Disabled when set to zero. (Default: 0)
+
+ * - visibility_training_spp
+   - |int|
+   - Number of samples per pixel of the training pass of the visibility
+     cache. (Default: 4)
+
  * - data
    - |tensor|
    - Tensor array containing the radiance-valued data.
@@ -75,6 +93,37 @@ The plugin can work with all types of images that are natively supported by Mits
 (i.e. JPEG, PNG, OpenEXR, RGBE, TGA, and BMP). In practice, a good environment
 map will contain high-dynamic range data that can only be represented using the
 OpenEXR or RGBE file formats.
+
+When :paramtype:`product_bins` is set, directions towards the environment
+are sampled proportionally to the product of its luminance and the cosine
+of the angle to the normal of the shading point. The map is divided into at
+most 64 cells along each axis, and a cosine-weighted distribution over these
+cells is precomputed for the center of every bin of an octahedral grid of
+normals with :paramtype:`product_bins` :math:`\times`
+:paramtype:`product_bins` bins; a direction is then sampled within the
+chosen cell according to the luminance of its pixels. Since the emitter
+doesn't know the side from which a surface is lit, the tables are symmetric
+with respect to the normal and include a small constant term, which keeps
+every direction sampleable, e.g. for transmissive materials. Points without
+a normal (e.g. in participating media) fall back to sampling the luminance.
+This reduces the noise of surfaces lit by high dynamic range environment
+maps whose bright regions are grazing or hidden for many of the normals, at
+the cost of memory proportional to the number of pixels and of bins.
+
+When :paramtype:`visibility_grid` is set, the emitter additionally learns
+which parts of the environment are visible from each cell of a grid over
+the bounding box of the scene. This helps e.g. interiors lit through
+windows, where most directions sampled proportionally to the luminance are
+occluded. Before the first rendering of a scene, sampling-based integrators
+then perform a training pass with :paramtype:`visibility_training_spp`
+samples per pixel, during which the unoccluded contributions of the
+emitter samples that were tested for visibility by the scene are
+accumulated per spatial cell and per cell of the map. Afterwards, reference
+points in cells that observed unoccluded samples choose directions from the
+learned distribution with probability 75%, and otherwise use the regular
+technique, which keeps every direction sampleable. The cache is trained
+again when the scene or the map change.
+
 High quality free light probes are available on
 `Bernhard Vogl's <http://dativ.at/lightprobes/>`_ website or
 `Polyhaven <https://polyhaven.com/hdris>`_.
@@ -97,10 +146,12 @@ High quality free light probes are available on
 template <typename Float, typename Spectrum>
 class EnvironmentMapEmitter final : public Emitter<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(Emitter, m_flags, m_to_world)
+    MI_IMPORT_BASE(Emitter, m_flags, m_to_world, m_training)
     MI_IMPORT_TYPES(Scene, Shape, Texture)
 
     using Warp = Hierarchical2D<Float, 0>;
+    using FloatStorage = DynamicBuffer<Float>;
+    using UInt32Storage = DynamicBuffer<UInt32>;
 
     /* In RGB variants: 3-channel array for R, G, and B components
        In spectral variants: 4-channel array for polynomial coefficients & scale */
@@ -231,6 +282,22 @@ public:
 
         m_scale = props.get<ScalarFloat>("scale", 1.f);
         m_warp = Warp(luminance.get(), res);
+
+        int product_bins = props.get<int>("product_bins", 0);
+        if (product_bins < 0)
+            Throw("\"product_bins\" must be a non-negative number!");
+        m_product_bins = (uint32_t) product_bins;
+
+        int visibility_grid = props.get<int>("visibility_grid", 0),
+            visibility_training_spp = props.get<int>("visibility_training_spp", 4);
+        if (visibility_grid < 0)
+            Throw("\"visibility_grid\" must be a non-negative number!");
+        if (visibility_training_spp <= 0)
+            Throw("\"visibility_training_spp\" must be positive!");
+        m_visibility_grid = (uint32_t) visibility_grid;
+        m_visibility_training_spp = (uint32_t) visibility_training_spp;
+
+        build_sampling_tables(luminance.get(), res);
         m_d65 = Texture::D65(1.f);
         m_flags = EmitterFlags::Infinite | EmitterFlags::SpatiallyVarying;
     }
@@ -320,6 +387,7 @@ public:
             }
 
             m_warp = Warp(luminance.get(), res);
+            build_sampling_tables(luminance.get(), res);
         }
         Base::parameters_changed(keys);
     }
@@ -338,6 +406,62 @@ public:
         }
 
         dr::make_opaque(m_bsphere.center, m_bsphere.radius);
+
+        // The visibility cache must be trained again for the new scene
+        m_visibility_bbox = scene->bbox();
+        ScalarVector3f extents = m_visibility_bbox.extents();
+        m_visibility_scale = dr::select(
+            extents > 0.f, ScalarFloat(m_visibility_grid) / extents, 0.f);
+        m_visibility_ready = false;
+    }
+
+    uint32_t training_spp() const override {
+        if (m_visibility_grid == 0 || m_visibility_ready || m_training ||
+            !m_visibility_bbox.valid())
+            return 0;
+        return m_visibility_training_spp;
+    }
+
+    void set_training(bool training) override {
+        if (training == m_training)
+            return;
+        Base::set_training(training);
+
+        size_t size = visibility_cell_count() * dr::prod(m_product_cells);
+        if (training) {
+            if constexpr (dr::is_jit_v<Float>)
+                m_visibility_train = dr::zeros<FloatStorage>(size);
+            else
+                m_visibility_train_host.reset(new AtomicFloat<ScalarFloat>[size]);
+        } else {
+            visibility_update();
+            m_visibility_train = FloatStorage();
+            m_visibility_train_host.reset();
+        }
+    }
+
+    void record_visibility(const Interaction3f &it,
+                           const DirectionSample3f &ds,
+                           const Spectrum &weight, const Mask &visible,
+                           Mask active) const override {
+        if (m_visibility_grid == 0 || !m_training)
+            return;
+
+        Float value = dr::mean(unpolarized_spectrum(weight));
+        active &= visible && dr::isfinite(value) && value > 0.f;
+
+        Vector3f d = m_to_world.value().inverse().transform_affine(ds.d);
+        Point2f uv = direction_to_uv(d);
+        UInt32 index = visibility_cell(it.p, active).first +
+                       texel_cell(uv);
+
+        if constexpr (dr::is_jit_v<Float>) {
+            dr::scatter_reduce(ReduceOp::Add, m_visibility_train, value, index,
+                               active);
+        } else {
+            if (active)
+                m_visibility_train_host[index] += value;
+        }
     }
 
     Spectrum eval(const SurfaceInteraction3f &si, Mask active) const override {
@@ -406,7 +530,7 @@ public:
                      Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::EndpointSampleDirection, active);
 
-        auto [uv, pdf] = m_warp.sample(sample, nullptr, active);
+        auto [uv, pdf] = sample_uv(it, sample, active);
         uv.x() += .5f / (m_data.shape(1) - 1);
         active &= pdf > 0.f;
 
@@ -447,22 +571,18 @@ public:
         return { ds, weight & active };
     }
 
-    Float pdf_direction(const Interaction3f & /*it*/, const DirectionSample3f &ds,
+    Float pdf_direction(const Interaction3f &it, const DirectionSample3f &ds,
                         Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::EndpointEvaluate, active);
 
         Vector3f d = m_to_world.value().inverse().transform_affine(ds.d);
-
-        // Convert to latitude-longitude texture coordinates
-        Point2f uv = Point2f(dr::atan2(d.x(), -d.z()) * dr::InvTwoPi<Float>,
-                             dr::safe_acos(d.y()) * dr::InvPi<Float>);
-        uv.x() -= .5f / (m_data.shape(1) - 1u);
-        uv -= dr::floor(uv);
+        Point2f uv = direction_to_uv(d);
 
         Float inv_sin_theta = dr::safe_rsqrt(dr::maximum(
             dr::square(d.x()) + dr::square(d.z()), dr::square(dr::Epsilon<Float>)));
 
-        return m_warp.eval(uv) * inv_sin_theta * (1.f / (2.f * dr::square(dr::Pi<Float>)));
+        return pdf_uv(it, uv, active) * inv_sin_theta *
+               (1.f / (2.f * dr::square(dr::Pi<Float>)));
     }
 
     Spectrum eval_direction(const Interaction3f &it,
@@ -509,12 +629,414 @@ public:
         if (!m_filename.empty())
             oss << "  filename = \"" << m_filename << "\"," << std::endl;
         oss << "  res = \"" << res << "\"," << std::endl
-            << "  bsphere = " << string::indent(m_bsphere) << std::endl
+            << "  bsphere = " << string::indent(m_bsphere) << "," << std::endl
+            << "  product_bins = " << m_product_bins << "," << std::endl
+            << "  visibility_grid = " << m_visibility_grid << std::endl
             << "]";
         return oss.str();
     }
 
 protected:
+    /**
+     * \brief Precompute the tables of the product sampling technique and of
+     * the visibility cache from the luminance of the vertices of \c m_warp
+     *
+     * The texels between the vertices are grouped into coarse cells of
+     * <tt>m_product_block^2</tt> texels, whose texels are stored contiguously
+     * in \c m_texel_index along with their CDF within the cell. For every bin
+     * of normals, \c m_product_pmf and \c m_product_cdf hold the distribution
+     * over the cells weighted by the cosine to the center of the bin.
+     */
+    void build_sampling_tables(const ScalarFloat *luminance,
+                               const ScalarVector2u &res) {
+        // The visibility cache refers to the cells of the previous map
+        m_visibility_ready = false;
+
+        if (m_product_bins == 0 && m_visibility_grid == 0)
+            return;
+
+        uint32_t width = res.x() - 1, height = res.y() - 1,
+                 block = (width + product_max_cells - 1) / product_max_cells;
+        ScalarVector2u cells((width + block - 1) / block,
+                             (height + block - 1) / block);
+        uint32_t cell_count = dr::prod(cells), texel_count = width * height;
+
+        std::vector<double> texel_lum(texel_count), cell_lum(cell_count, 0.0);
+        std::vector<uint32_t> cell_offset(cell_count + 1, 0);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const ScalarFloat *v = luminance + y * res.x() + x;
+                double lum = .25 * ((double) v[0] + (double) v[1] +
+                                    (double) v[res.x()] + (double) v[res.x() + 1]);
+                uint32_t cell = (y / block) * cells.x() + x / block;
+                texel_lum[y * width + x] = lum;
+                cell_lum[cell] += lum;
+                cell_offset[cell + 1]++;
+            }
+        }
+
+        for (uint32_t i = 0; i < cell_count; ++i)
+            cell_offset[i + 1] += cell_offset[i];
+
+        // Group the texels by cell and compute their CDF within the cell
+        std::vector<uint32_t> texel_index(texel_count),
+                              next(cell_offset.begin(), cell_offset.end() - 1);
+        for (uint32_t y = 0; y < height; ++y)
+            for (uint32_t x = 0; x < width; ++x)
+                texel_index[next[(y / block) * cells.x() + x / block]++] =
+                    y * width + x;
+
+        std::vector<ScalarFloat> texel_cdf(texel_count), texel_prob(texel_count);
+        for (uint32_t i = 0; i < cell_count; ++i) {
+            uint32_t start = cell_offset[i], end = cell_offset[i + 1];
+            double sum = 0.0;
+            for (uint32_t j = start; j < end; ++j) {
+                uint32_t texel = texel_index[j];
+                double prob = cell_lum[i] > 0.0 ? texel_lum[texel] / cell_lum[i]
+                                                : 1.0 / (end - start);
+                sum += prob;
+                texel_cdf[j] = (ScalarFloat) sum;
+                texel_prob[texel] = (ScalarFloat) prob;
+            }
+            texel_cdf[end - 1] = 1.f;
+        }
+
+        // Directions of the cell centers in the local frame of the emitter
+        std::vector<ScalarVector3f> cell_dir(cell_count);
+        for (uint32_t i = 0; i < cell_count; ++i) {
+            uint32_t cx = i % cells.x(), cy = i / cells.x();
+            ScalarFloat u = (.5f * (cx * block + std::min((cx + 1) * block, width)) + .5f) / width,
+                        v = (.5f * (cy * block + std::min((cy + 1) * block, height))) / height;
+            ScalarVector3f d = dr::sphdir(v * dr::Pi<ScalarFloat>,
+                                          u * dr::TwoPi<ScalarFloat>);
+            cell_dir[i] = ScalarVector3f(d.y(), d.z(), -d.x());
+        }
+
+        uint32_t bins = m_product_bins * m_product_bins;
+        std::vector<ScalarFloat> pmf((size_t) bins * cell_count),
+                                 cdf((size_t) bins * cell_count);
+        for (uint32_t b = 0; b < bins; ++b) {
+            // Center of the bin in the hemispherical octahedral parameterization
+            ScalarFloat u = ((b % m_product_bins) + .5f) / m_product_bins,
+                        v = ((b / m_product_bins) + .5f) / m_product_bins,
+                        px = u + v - 1.f, py = u - v;
+            ScalarVector3f n = dr::normalize(ScalarVector3f(
+                px, py, 1.f - dr::abs(px) - dr::abs(py)));
+
+            double total = 0.0;
+            for (uint32_t i = 0; i < cell_count; ++i)
+                total += cell_lum[i] * (dr::abs(dr::dot(n, cell_dir[i])) +
+                                        product_cosine_offset);
+
+            double sum = 0.0;
+            ScalarFloat *pmf_b = pmf.data() + (size_t) b * cell_count,
+                        *cdf_b = cdf.data() + (size_t) b * cell_count;
+            for (uint32_t i = 0; i < cell_count; ++i) {
+                double value =
+                    total > 0.0 ? cell_lum[i] * (dr::abs(dr::dot(n, cell_dir[i])) +
+                                                 product_cosine_offset) / total
+                                : 1.0 / cell_count;
+                sum += value;
+                pmf_b[i] = (ScalarFloat) value;
+                cdf_b[i] = (ScalarFloat) sum;
+            }
+            cdf_b[cell_count - 1] = 1.f;
+        }
+
+        m_product_block = block;
+        m_product_cells = cells;
+        if (bins > 0) {
+            m_product_pmf = dr::load<FloatStorage>(pmf.data(), pmf.size());
+            m_product_cdf = dr::load<FloatStorage>(cdf.data(), cdf.size());
+        }
+        m_texel_cdf     = dr::load<FloatStorage>(texel_cdf.data(), texel_count);
+        m_texel_prob    = dr::load<FloatStorage>(texel_prob.data(), texel_count);
+        m_texel_index   = dr::load<UInt32Storage>(texel_index.data(), texel_count);
+        m_cell_offset   = dr::load<UInt32Storage>(cell_offset.data(), cell_count + 1);
+    }
+
+    /**
+     * \brief Return the bin of the product tables for a world-space normal,
+     * and whether the normal is valid
+     */
+    std::pair<UInt32, Mask> product_bin(const Normal3f &n_world) const {
+        Normal3f n = m_to_world.value().inverse().transform_affine(n_world);
+
+        // The tables are symmetric, map the normal to the upper hemisphere
+        n = dr::select(n.z() < 0.f, -n, n);
+        Float norm = dr::abs(n.x()) + dr::abs(n.y()) + n.z();
+        Mask valid = norm > 0.f;
+
+        Float px = n.x() / norm, py = n.y() / norm;
+        Point2f uv = Point2f(px + py + 1.f, px - py + 1.f) * (.5f * m_product_bins);
+        Point2u pos = dr::minimum(Point2u(dr::maximum(uv, 0.f)),
+                                  m_product_bins - 1u);
+
+        return { dr::fmadd(pos.y(), m_product_bins, pos.x()), valid };
+    }
+
+    /**
+     * \brief Sample a position of \c m_warp by selecting a cell from the
+     * distribution over the cells stored at \c offset in \c pmf and \c cdf,
+     * and then one of its texels according to their luminance
+     */
+    std::pair<Point2f, Float> sample_cells(const FloatStorage &pmf,
+                                           const FloatStorage &cdf,
+                                           const UInt32 &offset, Point2f sample,
+                                           Mask active) const {
+        ScalarVector2u res = { (uint32_t) m_data.shape(1) - 1,
+                               (uint32_t) m_data.shape(0) - 1 };
+        uint32_t cell_count  = dr::prod(m_product_cells),
+                 texel_count = dr::prod(res);
+
+        // 1. Select a cell
+        UInt32 cell = dr::binary_search<UInt32>(
+            0, cell_count - 1, [&](UInt32 i) DRJIT_INLINE_LAMBDA {
+                return dr::gather<Float>(cdf, offset + i, active) < sample.x();
+            });
+
+        Float cell_pmf = dr::gather<Float>(pmf, offset + cell, active),
+              cell_cdf = dr::gather<Float>(cdf, offset + cell, active);
+        sample.x() = dr::select(
+            cell_pmf > 0.f, (sample.x() - (cell_cdf - cell_pmf)) / cell_pmf, 0.f);
+        sample.x() = dr::clip(sample.x(), 0.f, dr::OneMinusEpsilon<Float>);
+
+        // 2. Select one of its texels according to their luminance
+        UInt32 start = dr::gather<UInt32>(m_cell_offset, cell, active),
+               end   = dr::gather<UInt32>(m_cell_offset, cell + 1, active);
+        UInt32 index = dr::binary_search<UInt32>(
+            0, texel_count - 1, [&](UInt32 i) DRJIT_INLINE_LAMBDA {
+                return i < start ||
+                       (i + 1 < end &&
+                        dr::gather<Float>(m_texel_cdf, i, active) < sample.x());
+            });
+
+        UInt32 texel = dr::gather<UInt32>(m_texel_index, index, active);
+        Float texel_prob = dr::gather<Float>(m_texel_prob, texel, active),
+              texel_cdf  = dr::gather<Float>(m_texel_cdf, index, active);
+        sample.x() = dr::select(
+            texel_prob > 0.f, (sample.x() - (texel_cdf - texel_prob)) / texel_prob, 0.f);
+        sample.x() = dr::clip(sample.x(), 0.f, dr::OneMinusEpsilon<Float>);
+
+        // 3. Sample a position uniformly within the texel
+        UInt32 y = texel / res.x(), x = texel - y * res.x();
+        Point2f uv = (Point2f(Float(x), Float(y)) + sample) / ScalarVector2f(res);
+
+        return { uv, cell_pmf * texel_prob * (ScalarFloat) texel_count };
+    }
+
+    /// Return the cell of the sampling tables containing a position of \c m_warp
+    UInt32 texel_cell(const Point2f &uv) const {
+        ScalarVector2u res = { (uint32_t) m_data.shape(1) - 1,
+                               (uint32_t) m_data.shape(0) - 1 };
+        Point2u pos = dr::minimum(Point2u(uv * ScalarVector2f(res)), res - 1u);
+        return dr::fmadd(pos.y() / m_product_block, m_product_cells.x(),
+                         pos.x() / m_product_block);
+    }
+
+    /// Evaluate the density of \ref sample_cells()
+    Float pdf_cells(const FloatStorage &pmf, const UInt32 &offset,
+                    const Point2f &uv, Mask active) const {
+        ScalarVector2u res = { (uint32_t) m_data.shape(1) - 1,
+                               (uint32_t) m_data.shape(0) - 1 };
+
+        Point2u pos = dr::minimum(Point2u(uv * ScalarVector2f(res)), res - 1u);
+
+        return dr::gather<Float>(pmf, offset + texel_cell(uv), active) *
+               dr::gather<Float>(m_texel_prob, dr::fmadd(pos.y(), res.x(), pos.x()),
+                                 active) *
+               (ScalarFloat) dr::prod(res);
+    }
+
+    /**
+     * \brief Sample a position of \c m_warp for directions leaving \c it,
+     * using the product tables when enabled and \c it has a normal
+     */
+    std::pair<Point2f, Float> sample_base(const Interaction3f &it,
+                                          const Point2f &sample,
+                                          Mask active) const {
+        if (m_product_bins == 0)
+            return m_warp.sample(sample, nullptr, active);
+
+        auto [bin, product] = product_bin(it.n);
+        Point2f uv = dr::zeros<Point2f>();
+        Float pdf = 0.f;
+
+        Mask active_p = active && product;
+        if (dr::any_or<true>(active_p)) {
+            auto [uv_p, pdf_p] =
+                sample_cells(m_product_pmf, m_product_cdf,
+                             bin * dr::prod(m_product_cells), sample, active_p);
+            dr::masked(uv, active_p) = uv_p;
+            dr::masked(pdf, active_p) = pdf_p;
+        }
+
+        Mask active_w = active && !product;
+        if (dr::any_or<true>(active_w)) {
+            auto [uv_w, pdf_w] = m_warp.sample(sample, nullptr, active_w);
+            dr::masked(uv, active_w) = uv_w;
+            dr::masked(pdf, active_w) = pdf_w;
+        }
+
+        return { uv, pdf };
+    }
+
+    /// Evaluate the density of \ref sample_base()
+    Float pdf_base(const Interaction3f &it, const Point2f &uv, Mask active) const {
+        if (m_product_bins == 0)
+            return m_warp.eval(uv, nullptr, active);
+
+        auto [bin, product] = product_bin(it.n);
+        Float pdf = 0.f;
+
+        Mask active_p = active && product;
+        if (dr::any_or<true>(active_p))
+            dr::masked(pdf, active_p) = pdf_cells(
+                m_product_pmf, bin * dr::prod(m_product_cells), uv, active_p);
+
+        Mask active_w = active && !product;
+        if (dr::any_or<true>(active_w))
+            dr::masked(pdf, active_w) = m_warp.eval(uv, nullptr, active_w);
+
+        return pdf;
+    }
+
+    /**
+     * \brief Convert a direction in the local frame of the emitter into a
+     * position of \c m_warp
+     */
+    Point2f direction_to_uv(const Vector3f &d) const {
+        // Convert to latitude-longitude texture coordinates
+        Point2f uv = Point2f(dr::atan2(d.x(), -d.z()) * dr::InvTwoPi<Float>,
+                             dr::safe_acos(d.y()) * dr::InvPi<Float>);
+        uv.x() -= .5f / (m_data.shape(1) - 1u);
+        uv -= dr::floor(uv);
+        return uv;
+    }
+
+    /// Return the number of cells of the visibility grid
+    size_t visibility_cell_count() const {
+        return (size_t) m_visibility_grid * m_visibility_grid * m_visibility_grid;
+    }
+
+    /// Turn the contributions recorded during training into the visibility cache
+    void visibility_update() {
+        size_t cells = visibility_cell_count(),
+               env_cells = dr::prod(m_product_cells),
+               size = cells * env_cells;
+        std::vector<ScalarFloat> train(size), pmf(size), cdf(size), valid(cells);
+
+        if constexpr (dr::is_jit_v<Float>) {
+            auto &&host = dr::migrate(m_visibility_train, AllocType::Host);
+            dr::sync_thread();
+            std::copy(host.data(), host.data() + size, train.data());
+        } else {
+            for (size_t i = 0; i < size; ++i)
+                train[i] = m_visibility_train_host[i];
+        }
+
+        size_t valid_count = 0;
+        for (size_t i = 0; i < cells; ++i) {
+            const ScalarFloat *train_i = train.data() + i * env_cells;
+            double total = 0.0;
+            for (size_t j = 0; j < env_cells; ++j)
+                total += train_i[j];
+            if (!(total > 0.0))
+                continue;
+
+            double sum = 0.0;
+            for (size_t j = 0; j < env_cells; ++j) {
+                sum += train_i[j] / total;
+                pmf[i * env_cells + j] = (ScalarFloat) (train_i[j] / total);
+                cdf[i * env_cells + j] = (ScalarFloat) sum;
+            }
+            cdf[(i + 1) * env_cells - 1] = 1.f;
+            valid[i] = 1.f;
+            valid_count++;
+        }
+
+        m_visibility_pmf   = dr::load<FloatStorage>(pmf.data(), size);
+        m_visibility_cdf   = dr::load<FloatStorage>(cdf.data(), size);
+        m_visibility_valid = dr::load<FloatStorage>(valid.data(), cells);
+        m_visibility_ready = true;
+
+        Log(Debug, "Visibility cache: %zu/%zu cells observed unoccluded samples.",
+            valid_count, cells);
+    }
+
+    /**
+     * \brief Return the offset of the learned distribution of the cell of the
+     * visibility grid containing \c p, and whether it is available
+     */
+    std::pair<UInt32, Mask> visibility_cell(const Point3f &p, Mask active) const {
+        int32_t res = (int32_t) m_visibility_grid;
+        Vector3i cell = dr::clip(
+            dr::floor2int<Vector3i>((p - m_visibility_bbox.min) * m_visibility_scale),
+            0, res - 1);
+        UInt32 index = UInt32((cell.z() * res + cell.y()) * res + cell.x());
+
+        Mask valid = dr::gather<Float>(m_visibility_valid, index, active) > 0.f;
+        return { index * dr::prod(m_product_cells), valid };
+    }
+
+    /**
+     * \brief Sample a position of \c m_warp for directions leaving \c it
+     *
+     * Once the visibility cache is trained, reference points in cells that
+     * observed unoccluded samples choose between its distribution and the
+     * base technique (see \ref sample_base()), which keeps all directions
+     * sampleable.
+     */
+    std::pair<Point2f, Float> sample_uv(const Interaction3f &it,
+                                        Point2f sample, Mask active) const {
+        if (!m_visibility_ready)
+            return sample_base(it, sample, active);
+
+        auto [offset, cached] = visibility_cell(it.p, active);
+        cached &= active;
+
+        ScalarFloat frac = 1.f - visibility_base_fraction;
+        Mask use_cache = cached && sample.x() < frac;
+        sample.x() = dr::select(
+            use_cache, sample.x() / frac,
+            dr::select(cached, (sample.x() - frac) / (1.f - frac), sample.x()));
+        sample.x() = dr::minimum(sample.x(), dr::OneMinusEpsilon<Float>);
+
+        Point2f uv = dr::zeros<Point2f>();
+
+        Mask active_c = active && use_cache;
+        if (dr::any_or<true>(active_c))
+            dr::masked(uv, active_c) =
+                sample_cells(m_visibility_pmf, m_visibility_cdf, offset,
+                             sample, active_c).first;
+
+        Mask active_b = active && !use_cache;
+        auto [uv_b, pdf_b] = sample_base(it, sample, active_b);
+        dr::masked(uv, active_b) = uv_b;
+
+        Float pdf = pdf_b;
+        if (dr::any_or<true>(cached))
+            dr::masked(pdf, cached) = pdf_uv(it, uv, cached);
+
+        return { uv, pdf };
+    }
+
+    /// Evaluate the density of \ref sample_uv()
+    Float pdf_uv(const Interaction3f &it, const Point2f &uv, Mask active) const {
+        Float pdf = pdf_base(it, uv, active);
+        if (!m_visibility_ready)
+            return pdf;
+
+        auto [offset, cached] = visibility_cell(it.p, active);
+        cached &= active;
+        if (dr::any_or<true>(cached))
+            dr::masked(pdf, cached) =
+                dr::lerp(pdf_cells(m_visibility_pmf, offset, uv, cached), pdf,
+                         visibility_base_fraction);
+
+        return pdf;
+    }
+
     UnpolarizedSpectrum eval_spectrum(Point2f uv, const Wavelength &wavelengths,
                                       Mask active, bool include_whitepoint = true) const {
         ScalarVector2u res = { m_data.shape(1), m_data.shape(0) };
@@ -583,6 +1105,35 @@ protected:
     Warp m_warp;
     ref<Texture> m_d65;
     Float m_scale;
+
+    /// Maximum number of cells of the product tables along each axis
+    static constexpr uint32_t product_max_cells = 64;
+    /// Constant added to the cosine of the product tables
+    static constexpr double product_cosine_offset = 0.1;
+
+    uint32_t m_product_bins = 0;
+    uint32_t m_product_block = 1;
+    ScalarVector2u m_product_cells = 0;
+    FloatStorage m_product_pmf;
+    FloatStorage m_product_cdf;
+    FloatStorage m_texel_cdf;
+    FloatStorage m_texel_prob;
+    UInt32Storage m_texel_index;
+    UInt32Storage m_cell_offset;
+
+    /// Probability of using the regular technique where the visibility cache is valid
+    static constexpr float visibility_base_fraction = .25f;
+
+    uint32_t m_visibility_grid = 0;
+    uint32_t m_visibility_training_spp = 0;
+    ScalarBoundingBox3f m_visibility_bbox;
+    ScalarVector3f m_visibility_scale = 0.f;
+    FloatStorage m_visibility_pmf;
+    FloatStorage m_visibility_cdf;
+    FloatStorage m_visibility_valid;
+    bool m_visibility_ready = false;
+    mutable FloatStorage m_visibility_train;
+    std::unique_ptr<AtomicFloat<ScalarFloat>[]> m_visibility_train_host;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(EnvironmentMapEmitter, Emitter)
@@ -152,6 +152,11 @@ public:
         return 0.f;
     }
 
+    Float pdf_ray_direction(const PositionSample3f &, const Vector3f &,
+                            Mask) const override {
+        return dr::InvFourPi<Float>;
+    }
+
     Spectrum eval_direction(const Interaction3f &it,
                             const DirectionSample3f &ds,
                             Mask active) const override {
@@ -270,6 +270,23 @@ public:
         return 0.f;
     }
 
+    Float pdf_ray_direction(const PositionSample3f &, const Vector3f &d,
+                            Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::EndpointEvaluate, active);
+
+        Vector3f local_d = dr::normalize(m_to_world.value().inverse() * d);
+        Point2f uv = dr::head<2>(m_camera_to_sample * Point3f(local_d));
+        active &= dr::all(uv >= 0 && uv <= 1) && local_d.z() > 0;
+
+        /* \ref sample_ray() picks the film position proportionally to the
+           irradiance texture. The film plane at z=1 has area 'm_sensor_area',
+           and its area element projects to the solid angle 1/cos^3(theta). */
+        Float pdf = m_irradiance->pdf_position(uv, active) /
+                    (m_sensor_area * dr::square(local_d.z()) * local_d.z());
+
+        return dr::select(active, pdf, 0.f);
+    }
+
     Spectrum eval_direction(const Interaction3f &it,
                             const DirectionSample3f &ds,
                             Mask active) const override {
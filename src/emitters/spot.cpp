@@ -215,6 +215,13 @@ public:
         return 0.f;
     }
 
+    Float pdf_ray_direction(const PositionSample3f &, const Vector3f &d,
+                            Mask) const override {
+        Vector3f local_dir = dr::normalize(m_to_world.value().inverse() * d);
+        return warp::square_to_uniform_cone_pdf<true>(
+            local_dir, (Float) m_cos_cutoff_angle);
+    }
+
     std::pair<PositionSample3f, Float>
     sample_position(Float time, const Point2f & /*sample*/,
                     Mask active) const override {
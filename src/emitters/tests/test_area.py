@@ -138,3 +138,37 @@ def test05_shape_accessors(variants_vec_rgb):
 
     assert type(emitter.get_shape()) == mi.Mesh
     assert type(emitter_ptr.get_shape()) == mi.ShapePtr
+
+
+@fresolver_append_path
+def test06_solid_angle_sampling(variants_vec_rgb):
+    # Spherical triangle sampling must be consistent with pdf_direction()
+    # and yield the same expected solid angle as area sampling
+    def load(solid_angle):
+        return mi.load_dict({
+            "type": "ply",
+            "filename": "resources/data/tests/ply/triangle.ply",
+            "solid_angle_sampling": solid_angle,
+            "emitter" : { "type": "area" },
+            "to_world" : mi.ScalarTransform4f().translate([0, 0, 1])
+        })
+
+    shape_sa, shape_area = load(True), load(False)
+
+    n = 10000
+    it = dr.zeros(mi.SurfaceInteraction3f, n)
+    it.p = [0.1, 0.2, -0.5]
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(0, n)
+
+    for shape in [shape_sa, shape_area]:
+        ds = shape.sample_direction(it, sampler.next_2d())
+        assert dr.all(ds.pdf > 0)
+        assert dr.allclose(ds.pdf, shape.pdf_direction(it, ds), rtol=1e-3)
+
+    ds_sa = shape_sa.sample_direction(it, sampler.next_2d())
+    ds_area = shape_area.sample_direction(it, sampler.next_2d())
+    assert dr.allclose(dr.mean(1 / ds_sa.pdf), dr.mean(1 / ds_area.pdf), rtol=5e-2)
+
+    # Uniform solid angle density: the pdf is (nearly) constant
+    assert dr.allclose(dr.max(ds_sa.pdf), dr.min(ds_sa.pdf), rtol=1e-3)
@@ -135,3 +135,136 @@ def test04_parameters_changed(variants_all):
 
     params = mi.traverse(emitter)
     assert dr.allclose(params['data'], 1)
+
+
+def test05_product_sampling(variants_vec_backends_once_rgb):
+    import numpy as np
+
+    # Dim random environment with a bright region (divided into partial cells)
+    data = np.random.default_rng(seed=0).random((100, 200, 3)).astype(np.float32)
+    data[20:30, 150:160] *= 100
+    desc = {
+        'type': 'envmap',
+        'bitmap': mi.Bitmap(data),
+        'to_world': mi.ScalarTransform4f.rotate([1, 2, 3], 40),
+        'product_bins': 8
+    }
+    emitter = mi.load_dict(desc)
+
+    it = dr.zeros(mi.Interaction3f)
+    it.n = dr.normalize(mi.Normal3f(0.3, -0.8, 0.5))
+
+    def sample_func(sample):
+        ds, _ = emitter.sample_direction(it, sample)
+        return ds.d
+
+    def pdf_func(wo):
+        ds = dr.zeros(mi.DirectionSample3f)
+        ds.d = wo
+        return emitter.pdf_direction(it, ds)
+
+    chi2 = mi.chi2.ChiSquareTest(
+        domain=mi.chi2.SphericalDomain(),
+        sample_func=sample_func,
+        pdf_func=pdf_func,
+        sample_dim=2,
+        ires=32
+    )
+    assert chi2.run()
+
+    # The sampling weights match the density
+    rng = mi.PCG32(size=100000)
+    sample = mi.Point2f(rng.next_float32(), rng.next_float32())
+    ds, w = emitter.sample_direction(it, sample)
+    si = dr.zeros(mi.SurfaceInteraction3f)
+    si.wi = -ds.d
+    assert dr.allclose(w, emitter.eval(si) / emitter.pdf_direction(it, ds), rtol=1e-3)
+
+    # Cosine-weighted irradiance estimates are less noisy than without the product
+    def variance(emitter):
+        ds, w = emitter.sample_direction(it, sample)
+        value = w[0] * dr.abs(dr.dot(ds.d, it.n))
+        return dr.mean(dr.square(value)) - dr.square(dr.mean(value))
+
+    desc['product_bins'] = 0
+    assert variance(emitter)[0] < variance(mi.load_dict(desc))[0]
+
+    # Interactions without a normal sample the luminance
+    it_medium = dr.zeros(mi.Interaction3f)
+    ds_1, w_1 = emitter.sample_direction(it_medium, sample)
+    ds_2, w_2 = mi.load_dict(desc).sample_direction(it_medium, sample)
+    assert dr.allclose(ds_1.d, ds_2.d) and dr.allclose(w_1, w_2)
+
+
+def test06_visibility_cache(variants_vec_backends_once_rgb):
+    import numpy as np
+
+    # Points inside of a closed box, lit through a window in its top face
+    T = mi.ScalarTransform4f
+    walls = {
+        'bottom': T.translate([0, 0, -1]),
+        'left':   T.translate([-1, 0, 0]) @ T.rotate([0, 1, 0], 90),
+        'right':  T.translate([1, 0, 0]) @ T.rotate([0, 1, 0], 90),
+        'back':   T.translate([0, -1, 0]) @ T.rotate([1, 0, 0], 90),
+        'front':  T.translate([0, 1, 0]) @ T.rotate([1, 0, 0], 90),
+        'top_0':  T.translate([-0.65, 0, 1]) @ T.scale([0.35, 1, 1]),
+        'top_1':  T.translate([0.65, 0, 1]) @ T.scale([0.35, 1, 1]),
+        'top_2':  T.translate([0, -0.65, 1]) @ T.scale([0.3, 0.35, 1]),
+        'top_3':  T.translate([0, 0.65, 1]) @ T.scale([0.3, 0.35, 1])
+    }
+
+    data = np.random.default_rng(seed=0).random((50, 100, 3)).astype(np.float32)
+    desc = {
+        'type': 'scene',
+        'emitter': {
+            'type': 'envmap',
+            'bitmap': mi.Bitmap(data),
+            'visibility_grid': 2,
+            'visibility_training_spp': 1
+        }
+    }
+    for name, to_world in walls.items():
+        desc[name] = {'type': 'rectangle', 'to_world': to_world}
+    scene = mi.load_dict(desc)
+    emitter = scene.environment()
+    assert emitter.training_spp() == 1
+
+    it = dr.zeros(mi.Interaction3f, 100000)
+    rng = mi.PCG32(size=100000)
+    it.p = mi.Point3f(rng.next_float32(), rng.next_float32(), 0.5) * 0.2 - 0.1
+    sample = mi.Point2f(rng.next_float32(), rng.next_float32())
+
+    def visible_fraction():
+        ds, w = scene.sample_emitter_direction(it, sample, True)
+        return dr.mean(mi.Float(dr.max(w) > 0))[0]
+
+    before = visible_fraction()
+    scene.set_emitter_training(True)
+    assert emitter.training()
+    visible_fraction()
+    scene.set_emitter_training(False)
+    assert emitter.training_spp() == 0
+
+    # Most samples now pass through the window
+    assert visible_fraction() > 4 * before
+
+    it_1 = dr.zeros(mi.Interaction3f)
+    it_1.p = mi.Point3f(0.05, -0.05, 0.1)
+
+    def sample_func(sample):
+        ds, _ = emitter.sample_direction(it_1, sample)
+        return ds.d
+
+    def pdf_func(wo):
+        ds = dr.zeros(mi.DirectionSample3f)
+        ds.d = wo
+        return emitter.pdf_direction(it_1, ds)
+
+    chi2 = mi.chi2.ChiSquareTest(
+        domain=mi.chi2.SphericalDomain(),
+        sample_func=sample_func,
+        pdf_func=pdf_func,
+        sample_dim=2,
+        ires=32
+    )
+    assert chi2.run()
@@ -1,5 +1,6 @@
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/filesystem.h>
+#include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/string.h>
@@ -7,6 +8,7 @@
 #include <mitsuba/render/fwd.h>
 #include <mitsuba/render/imageblock.h>
 
+#include <atomic>
 #include <mutex>
 
 NAMESPACE_BEGIN(mitsuba)
@@ -64,6 +66,46 @@ High dynamic range film (:monosp:`hdrfilm`)
      in JIT variants and can make sample accumulation quite a bit more expensive.
      (Default: |false|, i.e. disabled)
 
+ * - partial_images
+   - |int|
+   - Number of partial images that LLVM variants of particle tracing
+     integrators (e.g. :ref:`ptracer <integrator-ptracer>`) accumulate their
+     splats into. Worker threads then mostly write to separate copies of the
+     image instead of contending on atomic additions to the same pixels, and
+     the copies are summed up after rendering. A value of 0 selects one copy
+     per CPU core. Other variants ignore this parameter. (Default: 1, i.e.
+     disabled)
+
+ * - partial_images_limit
+   - |int|
+   - Upper bound on the memory (in MiB) occupied by the partial images. Fewer
+     copies are used when the requested number would exceed it. (Default: 256)
+
+ * - aov_format
+   - |string|
+   - Storage precision of the AOV channels (e.g. produced by the
+     :ref:`aov <integrator-aov>` integrator) during rendering:
+     :monosp:`float32` or :monosp:`float16`. In the latter case, the film
+     stores the per-pixel average of every AOV in half precision, next to the
+     radiance and the weight of the pixel in single precision. This halves the
+     memory occupied by AOVs, at the cost of about three significant digits of
+     accuracy. Not supported in streaming mode. (Default: :monosp:`float32`)
+
+ * - stream_filename
+   - |string|
+   - When specified, the film operates in streaming mode: the image is
+     rendered from top to bottom, and finished rows of tiles are developed
+     and written to this tiled OpenEXR file during rendering. Only a sliding
+     window of unfinished rows stays in memory, which enables renders that
+     are too large to be stored as a whole. The developed image is not
+     available through :code:`develop()` or :code:`bitmap()` in this mode.
+     Only CPU (scalar) variants support streaming. (Default: unused)
+
+ * - stream_tile_size
+   - |int|
+   - Width and height of the tiles of the streamed OpenEXR file.
+     (Default: 64)
+
  * - (Nested plugin)
    - :paramtype:`rfilter`
    - Reconstruction filter that should be used by the film. (Default: :monosp:`gaussian`, a windowed
@@ -138,6 +180,9 @@ public:
                    m_filter, m_flags)
     MI_IMPORT_TYPES(ImageBlock)
 
+    using Float16 = dr::float16_array_t<Float>;
+    using Float16Storage = DynamicBuffer<Float16>;
+
     HDRFilm(const Properties &props) : Base(props) {
         std::string file_format = string::to_lower(
             props.string("file_format", "openexr"));
@@ -226,6 +271,41 @@ public:
 
         m_compensate = props.get<bool>("compensate", false);
 
+        int partial_images = props.get<int>("partial_images", 1);
+        if (partial_images < 0)
+            Throw("The \"partial_images\" parameter must be non-negative!");
+        m_partial_images = (uint32_t) partial_images;
+        int partial_limit = props.get<int>("partial_images_limit", 256);
+        if (partial_limit <= 0)
+            Throw("The \"partial_images_limit\" parameter must be positive!");
+        m_partial_images_limit = (size_t) partial_limit * 1024 * 1024;
+
+        std::string aov_format = string::to_lower(
+            props.string("aov_format", "float32"));
+        if (aov_format == "float16")
+            m_aov_format = Struct::Type::Float16;
+        else if (aov_format == "float32")
+            m_aov_format = Struct::Type::Float32;
+        else
+            Throw("The \"aov_format\" parameter must either be equal to "
+                  "\"float16\" or \"float32\". Found %s instead.", aov_format);
+
+        if (props.has_property("stream_filename")) {
+            if constexpr (dr::is_jit_v<Float>)
+                Throw("Streaming film output (\"stream_filename\") is only "
+                      "supported by CPU (scalar) variants!");
+            if (m_file_format != Bitmap::FileFormat::OpenEXR)
+                Throw("Streaming film output requires the OpenEXR file format!");
+
+            FileResolver *fs = Thread::thread()->file_resolver();
+            m_stream_path = fs->resolve(props.string("stream_filename"));
+            if (string::to_lower(m_stream_path.extension().string()) != ".exr")
+                m_stream_path.replace_extension(".exr");
+            m_stream_tile_size = props.get<uint32_t>("stream_tile_size", 64);
+            if (m_stream_tile_size == 0)
+                Throw("The \"stream_tile_size\" parameter must be positive!");
+        }
+
         props.mark_queried("banner"); // no banner in Mitsuba 3
     }
 
@@ -257,10 +337,44 @@ public:
         for (size_t i = 0; i < aovs.size(); ++i)
             channels[base_channels + i] = aovs[i];
 
+        bool half_aovs = m_aov_format == Struct::Type::Float16 && !aovs.empty();
+        if (half_aovs && streaming())
+            Throw("Film::prepare(): half precision AOVs (\"aov_format\") are "
+                  "not supported in streaming mode!");
+
         /* locked */ {
             std::lock_guard<std::mutex> lock(m_mutex);
-            m_storage = new ImageBlock(m_crop_size, m_crop_offset,
-                                       (uint32_t) channels.size());
+            m_aov_count = half_aovs ? (uint32_t) aovs.size() : 0;
+            m_aov_storage = Float16Storage();
+            m_aov_memory.set(0);
+            if (streaming()) {
+                // Start with a window spanning the first row of tiles
+                m_window_y = 0;
+                m_storage = new ImageBlock(
+                    ScalarVector2u(m_crop_size.x(),
+                                   std::min(m_stream_tile_size, m_crop_size.y())),
+                    m_crop_offset, (uint32_t) channels.size());
+                m_writer = new BitmapTileWriter(m_stream_path, m_crop_size,
+                                                 m_stream_tile_size);
+            } else {
+                // Half precision AOVs are stored separately from the RGBAW channels
+                m_storage = new ImageBlock(
+                    m_crop_size, m_crop_offset,
+                    (uint32_t) (channels.size() - m_aov_count));
+                if (m_aov_count > 0) {
+                    size_t count = dr::prod(m_crop_size) * m_aov_count;
+                    m_aov_storage = dr::zeros<Float16Storage>(count);
+                    m_aov_memory.set(count * sizeof(dr::half),
+                                     dr::is_cuda_v<Float>);
+                }
+                if constexpr (!dr::is_jit_v<Float>)
+                    m_row_locks.reset(new std::mutex[m_crop_size.y()]);
+
+                m_dirty_tiles = (m_crop_size + m_dirty_tile_size - 1u) /
+                                m_dirty_tile_size;
+                m_dirty.reset(new std::atomic<bool>[dr::prod(m_dirty_tiles)]);
+                mark_dirty();
+            }
             m_channels = channels;
         }
 
@@ -279,50 +393,316 @@ public:
 
         bool default_config = dr::all(size == ScalarVector2u(0));
 
-        return new ImageBlock(default_config ? m_crop_size : size,
-                              default_config ? m_crop_offset : ScalarPoint2u(0),
-                              (uint32_t) m_channels.size(), m_filter.get(),
-                              border /* border */,
-                              normalize /* normalize */,
-                              dr::is_jit_v<Float> /* coalesce */,
-                              m_compensate /* compensate */,
-                              warn /* warn_negative */,
-                              warn /* warn_invalid */);
+        ref<ImageBlock> block =
+            new ImageBlock(default_config ? m_crop_size : size,
+                           default_config ? m_crop_offset : ScalarPoint2u(0),
+                           (uint32_t) m_channels.size(), m_filter.get(),
+                           border /* border */,
+                           normalize /* normalize */,
+                           dr::is_jit_v<Float> /* coalesce */,
+                           m_compensate /* compensate */,
+                           warn /* warn_negative */,
+                           warn /* warn_invalid */);
+
+        // Normalized blocks receive the splats of particle tracers
+        if (normalize && m_partial_images != 1)
+            block->set_partial_images(m_partial_images, m_partial_images_limit);
+
+        return block;
     }
 
     void put_block(const ImageBlock *block) override {
         Assert(m_storage != nullptr);
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_storage->put_block(block);
+
+        if (streaming()) {
+            // Extend the window to the last row touched by the block
+            int32_t end = block->offset().y() + (int32_t) block->size().y() +
+                          (int32_t) block->border_size() - (int32_t) m_crop_offset.y();
+            uint32_t window_end =
+                std::min((uint32_t) std::max(end, 0), m_crop_size.y());
+            if (window_end > m_window_y + m_storage->size().y())
+                move_window(m_window_y, window_end - m_window_y);
+        }
+
+        if (m_aov_count > 0)
+            put_half(block);
+        else
+            m_storage->put_block(block);
+
+        /* Mark the tiles after merging the block, so that a concurrent
+           develop_dirty() can't miss its contents */
+        if (!streaming())
+            mark_dirty(block);
+    }
+
+    void put_tile(const ImageBlock *block) override {
+        Assert(m_storage != nullptr);
+
+        /* The window of a streaming film moves as blocks arrive, and JIT
+           variants accumulate on the device: use the regular code path */
+        if (dr::is_jit_v<Float> || streaming() || m_aov_count > 0) {
+            put_block(block);
+            return;
+        }
+
+        m_storage->put_tile(block, m_row_locks.get());
+        mark_dirty(block);
+    }
+
+    bool streaming() const override { return !m_stream_path.empty(); }
+
+    void flush_rows(uint32_t y) override {
+        if (!streaming())
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_writer)
+            return;
+
+        // Rows that can still receive splats from samples below 'y'
+        uint32_t border = m_filter ? m_filter->border_size() : 0,
+                 final_end = y >= m_crop_size.y()
+                                 ? m_crop_size.y()
+                                 : (uint32_t) std::max((int32_t) y - (int32_t) border, 0);
+
+        uint32_t tile = m_stream_tile_size;
+        while (m_window_y < m_crop_size.y() &&
+               (m_window_y + tile <= final_end || final_end == m_crop_size.y())) {
+            uint32_t rows = std::min(tile, m_crop_size.y() - m_window_y);
+
+            // Develop the finished rows of tiles
+            ref<ImageBlock> finished = new ImageBlock(
+                ScalarVector2u(m_crop_size.x(), rows),
+                m_crop_offset + ScalarPoint2u(0, m_window_y),
+                (uint32_t) m_channels.size());
+            finished->put_block(m_storage.get());
+            ref<Bitmap> tiles = develop_bitmap(finished.get(), false, m_component_format);
+            m_writer->write_row(m_window_y / tile, tiles.get());
+
+            m_window_y += rows;
+            if (m_window_y < m_crop_size.y()) {
+                uint32_t height = m_storage->size().y() > rows
+                                      ? m_storage->size().y() - rows
+                                      : std::min(tile, m_crop_size.y() - m_window_y);
+                move_window(m_window_y, height);
+            }
+        }
+
+        if (m_window_y >= m_crop_size.y()) {
+            Log(Info, "Streamed the film to \"%s\".", m_stream_path.string());
+            m_writer = nullptr; // Closes the file
+        }
     }
 
     void clear() override {
-        if (m_storage)
+        if (m_storage) {
             m_storage->clear();
+            if (m_aov_count > 0)
+                m_aov_storage = dr::zeros<Float16Storage>(
+                    dr::width(m_aov_storage));
+            mark_dirty();
+        }
+    }
+
+    void write_storage(Stream *stream) const override {
+        if (!m_storage)
+            Throw("No storage allocated, was prepare() called first?");
+        if (streaming())
+            Throw("write_storage(): not supported by streaming films!");
+        std::lock_guard<std::mutex> lock(m_mutex);
+        storage_region(ScalarPoint2u(0), m_crop_size)->write(stream);
+    }
+
+    void read_storage(Stream *stream, bool accumulate = false) override {
+        if (!m_storage)
+            Throw("No storage allocated, was prepare() called first?");
+        if (streaming())
+            Throw("read_storage(): not supported by streaming films!");
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_aov_count > 0) {
+            ref<ImageBlock> block = new ImageBlock(
+                m_crop_size, m_crop_offset, (uint32_t) m_channels.size());
+            block->read(stream, false);
+            if (!accumulate) {
+                m_storage->clear();
+                m_aov_storage = dr::zeros<Float16Storage>(
+                    dr::width(m_aov_storage));
+            }
+            put_half(block.get());
+        } else {
+            m_storage->read(stream, accumulate);
+        }
+        mark_dirty();
     }
 
     TensorXf develop(bool raw = false) const override {
+        if (!m_storage)
+            Throw("No storage allocated, was prepare() called first?");
+        if (streaming())
+            Throw("develop(): the contents of a streaming film were written "
+                  "to \"%s\" and cannot be developed!", m_stream_path.string());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return develop_block(
+            storage_region(ScalarPoint2u(0), m_crop_size).get(), raw);
+    }
+
+    TensorXf develop_region(const ScalarPoint2u &offset,
+                            const ScalarVector2u &size,
+                            bool raw = false) const override {
+        if (!m_storage)
+            Throw("No storage allocated, was prepare() called first?");
+        if (streaming())
+            Throw("develop_region(): the contents of a streaming film were "
+                  "written to \"%s\" and cannot be developed!",
+                  m_stream_path.string());
+        if (dr::any(offset + size > m_crop_size) || dr::any(size == 0u))
+            Throw("develop_region(): invalid region: offset(%u, %u) + "
+                  "size(%u, %u) must lie within the crop window (%u, %u)!",
+                  offset.x(), offset.y(), size.x(), size.y(),
+                  m_crop_size.x(), m_crop_size.y());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return develop_block(storage_region(offset, size).get(), raw);
+    }
+
+    std::vector<std::pair<ScalarPoint2u, TensorXf>> develop_dirty() override {
+        if (!m_storage)
+            Throw("No storage allocated, was prepare() called first?");
+        if (streaming())
+            Throw("develop_dirty(): the contents of a streaming film were "
+                  "written to \"%s\" and cannot be developed!",
+                  m_stream_path.string());
+
+        /* Collect runs of dirty tiles in every row of tiles, and reset their
+           state. Blocks that are merged concurrently mark their tiles again */
+        std::vector<std::pair<ScalarPoint2u, ScalarVector2u>> regions;
+        uint32_t tile = m_dirty_tile_size;
+        for (uint32_t ty = 0; ty < m_dirty_tiles.y(); ++ty) {
+            for (uint32_t tx = 0; tx < m_dirty_tiles.x(); ++tx) {
+                if (!m_dirty[ty * m_dirty_tiles.x() + tx].exchange(false))
+                    continue;
+
+                ScalarPoint2u offset(tx * tile, ty * tile);
+                ScalarVector2u size(
+                    std::min(tile, m_crop_size.x() - offset.x()),
+                    std::min(tile, m_crop_size.y() - offset.y()));
+
+                if (!regions.empty() && regions.back().first.y() == offset.y() &&
+                    regions.back().first.x() + regions.back().second.x() == offset.x())
+                    regions.back().second.x() += size.x();
+                else
+                    regions.emplace_back(offset, size);
+            }
+        }
+
+        std::vector<std::pair<ScalarPoint2u, TensorXf>> result;
+        for (auto [offset, size] : regions)
+            result.emplace_back(offset, develop_region(offset, size));
+        return result;
+    }
+
+    ref<Bitmap> bitmap(bool raw = false) const override {
+        if (!m_storage)
+            Throw("No storage allocated, was prepare() called first?");
+        if (streaming())
+            Throw("bitmap(): the contents of a streaming film were written "
+                  "to \"%s\" and cannot be developed!", m_stream_path.string());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return develop_bitmap(
+            storage_region(ScalarPoint2u(0), m_crop_size).get(), raw);
+    }
+
+    void write(const fs::path &path) const override { write_impl(path, false); }
+
+    void write_async(const fs::path &path) const override {
+        write_impl(path, true);
+    }
+
+    void write_impl(const fs::path &path, bool async) const {
+        if (streaming()) {
+            Log(Info, "The film was streamed to \"%s\" during rendering, "
+                "skipping \"%s\".", m_stream_path.string(), path.string());
+            return;
+        }
+
+        fs::path filename = path;
+        std::string proper_extension;
+        if (m_file_format == Bitmap::FileFormat::OpenEXR)
+            proper_extension = ".exr";
+        else if (m_file_format == Bitmap::FileFormat::RGBE)
+            proper_extension = ".rgbe";
+        else
+            proper_extension = ".pfm";
+
+        std::string extension = string::to_lower(filename.extension().string());
+        if (extension != proper_extension)
+            filename.replace_extension(proper_extension);
+
+        #if !defined(_WIN32)
+            Log(Info, "\U00002714  Developing \"%s\" ..", filename.string());
+        #else
+            Log(Info, "Developing \"%s\" ..", filename.string());
+        #endif
+
         if (!m_storage)
             Throw("No storage allocated, was prepare() called first?");
 
-        if (raw) {
+        // Develop and convert to the component format of the file in one pass
+        ref<Bitmap> bitmap;
+        /* locked */ {
             std::lock_guard<std::mutex> lock(m_mutex);
-            return m_storage->tensor();
+            bitmap = develop_bitmap(
+                storage_region(ScalarPoint2u(0), m_crop_size).get(), false,
+                m_component_format);
         }
+        if (async)
+            bitmap->write_async(filename, m_file_format);
+        else
+            bitmap->write(filename, m_file_format);
+    }
+
+    void schedule_storage() override {
+        dr::schedule(m_storage->tensor());
+        if (m_aov_count > 0)
+            dr::schedule(m_aov_storage);
+    };
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "HDRFilm[" << std::endl
+            << "  size = " << m_size << "," << std::endl
+            << "  crop_size = " << m_crop_size << "," << std::endl
+            << "  crop_offset = " << m_crop_offset << "," << std::endl
+            << "  sample_border = " << m_sample_border << "," << std::endl
+            << "  compensate = " << m_compensate << "," << std::endl
+            << "  partial_images = " << m_partial_images << "," << std::endl
+            << "  aov_format = " << m_aov_format << "," << std::endl
+            << "  filter = " << m_filter << "," << std::endl
+            << "  file_format = " << m_file_format << "," << std::endl
+            << "  pixel_format = " << m_pixel_format << "," << std::endl
+            << "  component_format = " << m_component_format << "," << std::endl;
+        if (streaming())
+            oss << "  stream_filename = \"" << m_stream_path.string() << "\"," << std::endl
+                << "  stream_tile_size = " << m_stream_tile_size << "," << std::endl;
+        oss << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+protected:
+    /// Develop the contents of an image block (the caller must hold \c m_mutex)
+    TensorXf develop_block(const ImageBlock *block, bool raw) const {
+        if (raw)
+            return block->tensor();
 
         if constexpr (dr::is_jit_v<Float>) {
-            Float data;
-            uint32_t source_ch;
-            uint32_t pixel_count;
-            ScalarVector2i size;
-
-            /* locked */ {
-                std::lock_guard<std::mutex> lock(m_mutex);
-                data        = m_storage->tensor().array();
-                size        = m_storage->size();
-                source_ch   = (uint32_t) m_storage->channel_count();
-                pixel_count = dr::prod(m_storage->size());
-            }
+            const Float &data    = block->tensor().array();
+            ScalarVector2i size  = block->size();
+            uint32_t source_ch   = (uint32_t) block->channel_count(),
+                     pixel_count = dr::prod(block->size());
 
             /* The following code develops weighted image block data into
                an output image of the desired configuration, while using
@@ -404,25 +784,71 @@ public:
 
             return TensorXf(values, 3, shape);
         } else {
-            ref<Bitmap> source = bitmap();
-            ScalarVector2i size = source->size();
-            size_t width = source->channel_count() * dr::prod(size);
-            auto data = dr::load<DynamicBuffer<ScalarFloat>>(source->data(), width);
+            ScalarVector2u size = block->size();
+            size_t target_ch = developed_channel_count(block);
 
-            size_t shape[3] = { (size_t) source->height(),
-                                (size_t) source->width(),
-                                source->channel_count() };
+            // Develop directly into the memory of the output tensor
+            auto data = dr::empty<DynamicBuffer<ScalarFloat>>(
+                target_ch * dr::prod(size));
+            develop_bitmap(block, false, struct_type_v<ScalarFloat>,
+                           (uint8_t *) data.data());
+
+            size_t shape[3] = { (size_t) size.y(), (size_t) size.x(),
+                                target_ch };
 
             return TensorXf(data, 3, shape);
         }
     }
 
-    ref<Bitmap> bitmap(bool raw = false) const override {
-        if (!m_storage)
-            Throw("No storage allocated, was prepare() called first?");
+    /// Mark all tiles as changed
+    void mark_dirty() {
+        for (size_t i = 0, n = dr::prod(m_dirty_tiles); i < n; ++i)
+            m_dirty[i].store(true, std::memory_order_relaxed);
+    }
 
-        std::lock_guard<std::mutex> lock(m_mutex);
-        auto &&storage = dr::migrate(m_storage->tensor().array(), AllocType::Host);
+    /// Mark the tiles covered by an image block (including its border) as changed
+    void mark_dirty(const ImageBlock *block) {
+        ScalarPoint2i start = ScalarPoint2i(block->offset()) -
+                              (int32_t) block->border_size() -
+                              ScalarPoint2i(m_crop_offset),
+                      end   = start + ScalarPoint2i(block->size()) +
+                              2 * (int32_t) block->border_size();
+
+        start = dr::clip(start, ScalarPoint2i(0), ScalarPoint2i(m_crop_size));
+        end   = dr::clip(end,   ScalarPoint2i(0), ScalarPoint2i(m_crop_size));
+        if (dr::any(end <= start))
+            return;
+
+        ScalarPoint2u t0 = ScalarPoint2u(start) / m_dirty_tile_size,
+                      t1 = (ScalarPoint2u(end) - 1u) / m_dirty_tile_size;
+        for (uint32_t ty = t0.y(); ty <= t1.y(); ++ty)
+            for (uint32_t tx = t0.x(); tx <= t1.x(); ++tx)
+                m_dirty[ty * m_dirty_tiles.x() + tx].store(true, std::memory_order_relaxed);
+    }
+
+    /// Number of channels of the developed contents of an image block
+    size_t developed_channel_count(const ImageBlock *storage_block) const {
+        bool alpha = has_flag(m_flags, FilmFlags::Alpha),
+             to_y  = m_pixel_format == Bitmap::PixelFormat::Y ||
+                     m_pixel_format == Bitmap::PixelFormat::YA;
+        uint32_t base_ch = alpha ? 5 : 4;
+        return storage_block->channel_count() - base_ch + (to_y ? 1 : 3) +
+               (alpha ? 1 : 0);
+    }
+
+    /**
+     * \brief Develop the contents of an image block with the film's channels
+     *
+     * The weight division, color space transformation and conversion to the
+     * requested component format happen in a single (parallel) pass. When
+     * \c target_data is specified, the developed image is written to this
+     * memory region, which must hold \ref developed_channel_count() values
+     * of the component format per pixel.
+     */
+    ref<Bitmap> develop_bitmap(const ImageBlock *storage_block, bool raw,
+                               Struct::Type component_format = struct_type_v<ScalarFloat>,
+                               uint8_t *target_data = nullptr) const {
+        auto &&storage = dr::migrate(storage_block->tensor().array(), AllocType::Host);
 
         if constexpr (dr::is_jit_v<Float>)
             dr::sync_thread();
@@ -437,8 +863,8 @@ public:
                                      : Bitmap::PixelFormat::MultiChannel;
 
         ref<Bitmap> source = new Bitmap(
-            source_fmt, struct_type_v<ScalarFloat>, m_storage->size(),
-            m_storage->channel_count(), m_channels, (uint8_t *) storage.data());
+            source_fmt, struct_type_v<ScalarFloat>, storage_block->size(),
+            storage_block->channel_count(), m_channels, (uint8_t *) storage.data());
 
         if (raw)
             return source;
@@ -453,12 +879,12 @@ public:
         uint32_t img_ch = to_y ? 1 : 3;
         uint32_t aovs_channel = has_aovs ? (img_ch + (uint32_t) alpha) : 0;
         uint32_t target_ch =
-            (uint32_t) m_storage->channel_count() - base_ch + aovs_channel;
+            (uint32_t) storage_block->channel_count() - base_ch + aovs_channel;
 
         ref<Bitmap> target = new Bitmap(
             has_aovs ? Bitmap::PixelFormat::MultiChannel : m_pixel_format,
-            struct_type_v<ScalarFloat>, m_storage->size(),
-            has_aovs ? target_ch : 0);
+            component_format, storage_block->size(),
+            has_aovs ? target_ch : 0, {}, target_data);
 
         if (has_aovs) {
             source->struct_()->operator[](base_ch - 1).flags |=
@@ -543,76 +969,207 @@ public:
         return target;
     }
 
-    void write(const fs::path &path) const override {
-        fs::path filename = path;
-        std::string proper_extension;
-        if (m_file_format == Bitmap::FileFormat::OpenEXR)
-            proper_extension = ".exr";
-        else if (m_file_format == Bitmap::FileFormat::RGBE)
-            proper_extension = ".rgbe";
-        else
-            proper_extension = ".pfm";
-
-        std::string extension = string::to_lower(filename.extension().string());
-        if (extension != proper_extension)
-            filename.replace_extension(proper_extension);
+    /**
+     * \brief Return the contents of a region (relative to the crop window) of
+     * the storage with all channels in full precision
+     *
+     * Returns the storage itself when the region spans the crop window and
+     * the AOVs are stored in full precision. Otherwise, the half precision
+     * AOV averages are scaled by the weight of their pixel. The caller must
+     * hold \c m_mutex.
+     */
+    ref<ImageBlock> storage_region(const ScalarPoint2u &offset,
+                                   const ScalarVector2u &size) const {
+        uint32_t channels = (uint32_t) m_channels.size();
+        ref<ImageBlock> region = new ImageBlock(size, m_crop_offset + offset,
+                                                channels);
+        if (m_aov_count == 0) {
+            if (dr::all(offset == 0u && size == m_crop_size))
+                return m_storage;
+            region->put_block(m_storage.get());
+            return region;
+        }
 
-        #if !defined(_WIN32)
-            Log(Info, "\U00002714  Developing \"%s\" ..", filename.string());
-        #else
-            Log(Info, "Developing \"%s\" ..", filename.string());
-        #endif
+        uint32_t base = m_storage->channel_count(), aovs = m_aov_count,
+                 width = m_crop_size.x(), weight = base - 1;
 
-        ref<Bitmap> source = bitmap();
-        if (m_component_format != struct_type_v<ScalarFloat>) {
-            // Mismatch between the current format and the one expected by the film
-            // Conversion is necessary before saving to disk
-            std::vector<std::string> channel_names;
-            for (size_t i = 0; i < source->channel_count(); i++)
-                channel_names.push_back(source->struct_()->operator[](i).name);
-            ref<Bitmap> target = new Bitmap(
-                source->pixel_format(),
-                m_component_format,
-                source->size(),
-                source->channel_count(),
-                channel_names);
-            source->convert(target);
-
-            target->write(filename, m_file_format);
+        if constexpr (dr::is_jit_v<Float>) {
+            UInt32 index = dr::arange<UInt32>(dr::prod(size)),
+                   y = index / size.x(),
+                   source = (y + offset.y()) * width +
+                            (index - y * size.x()) + offset.x(),
+                   target = index * channels;
+
+            const Float &base_h = m_storage->tensor().array();
+            Float &region_h = region->tensor().array();
+            Float w = dr::gather<Float>(base_h, source * base + weight);
+
+            for (uint32_t c = 0; c < base; ++c)
+                dr::scatter(region_h,
+                            dr::gather<Float>(base_h, source * base + c),
+                            target + c);
+            for (uint32_t c = 0; c < aovs; ++c)
+                dr::scatter(region_h,
+                            Float(dr::gather<Float16>(m_aov_storage,
+                                                      source * aovs + c)) * w,
+                            target + base + c);
         } else {
-            source->write(filename, m_file_format);
+            const ScalarFloat *base_h = m_storage->tensor().data();
+            const dr::half *aov_h = m_aov_storage.data();
+            ScalarFloat *region_h = region->tensor().data();
+
+            for (uint32_t y = 0; y < size.y(); ++y) {
+                for (uint32_t x = 0; x < size.x(); ++x) {
+                    size_t source = (size_t) (y + offset.y()) * width + x + offset.x();
+                    const ScalarFloat *src = base_h + source * base;
+                    const dr::half *src_aov = aov_h + source * aovs;
+                    ScalarFloat *dst = region_h + ((size_t) y * size.x() + x) * channels;
+
+                    for (uint32_t c = 0; c < base; ++c)
+                        dst[c] = src[c];
+                    for (uint32_t c = 0; c < aovs; ++c)
+                        dst[base + c] = (ScalarFloat) (float) src_aov[c] * src[weight];
+                }
+            }
         }
+
+        return region;
     }
 
-    void schedule_storage() override {
-        dr::schedule(m_storage->tensor());
-    };
+    /**
+     * \brief Merge a block with all channels in full precision into a storage
+     * with half precision AOVs (the caller must hold \c m_mutex)
+     *
+     * The AOVs are stored as averages over the samples of their pixel, which
+     * share its weight channel. This keeps them within the range of half
+     * precision values irrespective of the number of accumulated samples.
+     */
+    void put_half(const ImageBlock *block) {
+        if (unlikely(block->channel_count() != m_channels.size()))
+            Throw("HDRFilm::put_block(): mismatched channel counts! (%u, "
+                  "expected %u)", block->channel_count(), (uint32_t) m_channels.size());
+
+        ScalarVector2i source_size(block->size() + 2 * block->border_size()),
+                       target_size(m_crop_size);
+
+        // Position of the source block within the storage
+        ScalarPoint2i shift = ScalarPoint2i(block->offset()) -
+                              (int32_t) block->border_size() -
+                              ScalarPoint2i(m_crop_offset);
+
+        ScalarPoint2i t0 = dr::maximum(shift, 0),
+                      t1 = dr::minimum(shift + source_size, target_size);
+        if (dr::any(t1 <= t0))
+            return;
+        ScalarVector2i extent = t1 - t0;
+        ScalarPoint2i s0 = t0 - shift;
+
+        uint32_t channels = block->channel_count(),
+                 base = m_storage->channel_count(), aovs = m_aov_count,
+                 weight = base - 1;
 
-    std::string to_string() const override {
-        std::ostringstream oss;
-        oss << "HDRFilm[" << std::endl
-            << "  size = " << m_size << "," << std::endl
-            << "  crop_size = " << m_crop_size << "," << std::endl
-            << "  crop_offset = " << m_crop_offset << "," << std::endl
-            << "  sample_border = " << m_sample_border << "," << std::endl
-            << "  compensate = " << m_compensate << "," << std::endl
-            << "  filter = " << m_filter << "," << std::endl
-            << "  file_format = " << m_file_format << "," << std::endl
-            << "  pixel_format = " << m_pixel_format << "," << std::endl
-            << "  component_format = " << m_component_format << "," << std::endl
-            << "]";
-        return oss.str();
+        if constexpr (dr::is_jit_v<Float>) {
+            UInt32 index = dr::arange<UInt32>(dr::prod(extent)),
+                   y = index / extent.x(),
+                   x = index - y * extent.x(),
+                   source = ((y + s0.y()) * source_size.x() + x + s0.x()) * channels,
+                   target = (y + t0.y()) * target_size.x() + x + t0.x();
+
+            const Float &block_h = block->tensor().array();
+            Float &base_h = m_storage->tensor().array();
+
+            Float w_old = dr::gather<Float>(base_h, target * base + weight),
+                  w_new = w_old + dr::gather<Float>(block_h, source + weight),
+                  inv_w = dr::select(w_new != 0.f, dr::rcp(w_new), 0.f);
+
+            for (uint32_t c = 0; c < aovs; ++c) {
+                UInt32 index_aov = target * aovs + c;
+                Float value = Float(dr::gather<Float16>(m_aov_storage, index_aov)) * w_old +
+                              dr::gather<Float>(block_h, source + base + c);
+                dr::scatter(m_aov_storage, Float16(value * inv_w), index_aov);
+            }
+
+            for (uint32_t c = 0; c < base; ++c) {
+                UInt32 index_base = target * base + c;
+                dr::scatter(base_h,
+                            dr::gather<Float>(base_h, index_base) +
+                                dr::gather<Float>(block_h, source + c),
+                            index_base);
+            }
+        } else {
+            const ScalarFloat *block_h = block->tensor().data();
+            ScalarFloat *base_h = m_storage->tensor().data();
+            dr::half *aov_h = m_aov_storage.data();
+
+            for (int32_t y = 0; y < extent.y(); ++y) {
+                for (int32_t x = 0; x < extent.x(); ++x) {
+                    size_t target = (size_t) (y + t0.y()) * target_size.x() + x + t0.x();
+                    const ScalarFloat *src = block_h +
+                        ((size_t) (y + s0.y()) * source_size.x() + x + s0.x()) * channels;
+                    ScalarFloat *dst = base_h + target * base;
+                    dr::half *dst_aov = aov_h + target * aovs;
+
+                    ScalarFloat w_old = dst[weight],
+                                w_new = w_old + src[weight],
+                                inv_w = w_new != 0.f ? 1.f / w_new : 0.f;
+
+                    for (uint32_t c = 0; c < aovs; ++c)
+                        dst_aov[c] = dr::half(
+                            (float) (((ScalarFloat) (float) dst_aov[c] * w_old +
+                                      src[base + c]) * inv_w));
+                    for (uint32_t c = 0; c < base; ++c)
+                        dst[c] += src[c];
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Move the window of resident rows of a streaming film to start at
+     * row \c y (relative to the crop window) and span \c height rows
+     *
+     * The contents of rows covered by both windows are preserved.
+     */
+    void move_window(uint32_t y, uint32_t height) {
+        ref<ImageBlock> window = new ImageBlock(
+            ScalarVector2u(m_crop_size.x(), height),
+            m_crop_offset + ScalarPoint2u(0, y),
+            (uint32_t) m_channels.size());
+        window->put_block(m_storage.get());
+        m_storage = window;
+        m_window_y = y;
     }
 
-    MI_DECLARE_CLASS()
-protected:
     Bitmap::FileFormat m_file_format;
     Bitmap::PixelFormat m_pixel_format;
     Struct::Type m_component_format;
     bool m_compensate;
+    uint32_t m_partial_images;
+    size_t m_partial_images_limit;
     ref<ImageBlock> m_storage;
+
+    /// Storage precision of the AOV channels
+    Struct::Type m_aov_format;
+    /// Number of AOV channels stored in half precision (zero if disabled)
+    uint32_t m_aov_count = 0;
+    /// Per-pixel averages of the AOVs, interleaved like the channels of \c m_storage
+    Float16Storage m_aov_storage;
+    MemoryAllocation m_aov_memory { MemoryCategory::ImageBlock };
     mutable std::mutex m_mutex;
+    /// Per-row locks of the storage used by \ref put_tile()
+    std::unique_ptr<std::mutex[]> m_row_locks;
     std::vector<std::string> m_channels;
+
+    /// Tiles (relative to the crop window) changed since \ref develop_dirty()
+    std::unique_ptr<std::atomic<bool>[]> m_dirty;
+    ScalarVector2u m_dirty_tiles { 0, 0 };
+    uint32_t m_dirty_tile_size = 64;
+
+    // Streaming mode: output file and first row of the resident window
+    fs::path m_stream_path;
+    uint32_t m_stream_tile_size = 0;
+    uint32_t m_window_y = 0;
+    ref<BitmapTileWriter> m_writer;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(HDRFilm, Film)
@@ -323,6 +323,20 @@ public:
             m_storage->clear();
     }
 
+    void write_storage(Stream *stream) const override {
+        if (!m_storage)
+            Throw("No storage allocated, was prepare() called first?");
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_storage->write(stream);
+    }
+
+    void read_storage(Stream *stream, bool accumulate = false) override {
+        if (!m_storage)
+            Throw("No storage allocated, was prepare() called first?");
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_storage->read(stream, accumulate);
+    }
+
     TensorXf develop(bool raw = false) const override {
         if (!m_storage)
             Throw("No storage allocated, was prepare() called first?");
@@ -372,14 +386,17 @@ public:
 
             return TensorXf(values, 3, shape);
         } else {
-            ref<Bitmap> source = bitmap();
-            ScalarVector2i size = source->size();
-            size_t width = source->channel_count() * dr::prod(size);
-            auto data = dr::load<DynamicBuffer<Float>>(source->data(), width);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ScalarVector2u size = m_storage->size();
+            size_t target_ch = m_storage->channel_count() - 1;
 
-            size_t shape[3] = { (size_t) source->height(),
-                                (size_t) source->width(),
-                                source->channel_count() };
+            // Develop directly into the memory of the output tensor
+            auto data = dr::empty<DynamicBuffer<Float>>(target_ch * dr::prod(size));
+            develop_bitmap(false, struct_type_v<ScalarFloat>,
+                           (uint8_t *) data.data());
+
+            size_t shape[3] = { (size_t) size.y(), (size_t) size.x(),
+                                target_ch };
 
             return TensorXf(data, 3, shape);
         }
@@ -391,36 +408,16 @@ public:
             Throw("No storage allocated, was prepare() called first?");
 
         std::lock_guard<std::mutex> lock(m_mutex);
-        auto &&storage = dr::migrate(m_storage->tensor().array(), AllocType::Host);
-
-        if constexpr (dr::is_jit_v<Float>)
-            dr::sync_thread();
-
-        ref<Bitmap> source = new Bitmap(
-            Bitmap::PixelFormat::MultiChannel,
-            struct_type_v<ScalarFloat>, m_storage->size(),
-            m_storage->channel_count(), m_channels, (uint8_t *) storage.data());
-
-        if (raw)
-            return source;
-
-        ref<Bitmap> target = new Bitmap(
-            Bitmap::PixelFormat::MultiChannel,
-            struct_type_v<ScalarFloat>, m_storage->size(),
-            m_storage->channel_count() - 1);
+        return develop_bitmap(raw);
+    }
 
-        source->struct_()->operator[](m_channels.size() - 1).flags |= +Struct::Flags::Weight;
-        for (size_t i = 0; i < m_storage->channel_count() - 1; ++i) {
-            Struct::Field &dest_field = target->struct_()->operator[](i);
-            dest_field.name = m_channels[i];
-        }
+    void write(const fs::path &path) const override { write_impl(path, false); }
 
-        source->convert(target);
-
-        return target;
+    void write_async(const fs::path &path) const override {
+        write_impl(path, true);
     }
 
-    void write(const fs::path &path) const override {
+    void write_impl(const fs::path &path, bool async) const {
         fs::path filename = path;
         std::string proper_extension = ".exr";
 
@@ -434,25 +431,19 @@ public:
             Log(Info, "Developing \"%s\" ..", filename.string());
         #endif
 
-        ref<Bitmap> source = bitmap();
-        if (m_component_format != struct_type_v<ScalarFloat>) {
-            // Mismatch between the current format and the one expected by the film
-            // Conversion is necessary before saving to disk
-            std::vector<std::string> channel_names;
-            for (size_t i = 0; i < source->channel_count(); i++)
-                channel_names.push_back(source->struct_()->operator[](i).name);
-            ref<Bitmap> target = new Bitmap(
-                source->pixel_format(),
-                m_component_format,
-                source->size(),
-                source->channel_count(),
-                channel_names);
-            source->convert(target);
-
-            target->write(filename, m_file_format);
-        } else {
-            source->write(filename, m_file_format);
+        if (!m_storage)
+            Throw("No storage allocated, was prepare() called first?");
+
+        // Develop and convert to the component format of the file in one pass
+        ref<Bitmap> bitmap;
+        /* locked */ {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            bitmap = develop_bitmap(false, m_component_format);
         }
+        if (async)
+            bitmap->write_async(filename, m_file_format);
+        else
+            bitmap->write(filename, m_file_format);
     }
 
     void schedule_storage() override {
@@ -481,6 +472,45 @@ public:
 
     MI_DECLARE_CLASS()
 protected:
+    /**
+     * \brief Develop the film storage (the caller must hold \c m_mutex)
+     *
+     * The weight division and conversion to the requested component format
+     * happen in a single (parallel) pass. When \c target_data is specified,
+     * the developed image is written to this memory region.
+     */
+    ref<Bitmap> develop_bitmap(bool raw,
+                               Struct::Type component_format = struct_type_v<ScalarFloat>,
+                               uint8_t *target_data = nullptr) const {
+        auto &&storage = dr::migrate(m_storage->tensor().array(), AllocType::Host);
+
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+
+        ref<Bitmap> source = new Bitmap(
+            Bitmap::PixelFormat::MultiChannel,
+            struct_type_v<ScalarFloat>, m_storage->size(),
+            m_storage->channel_count(), m_channels, (uint8_t *) storage.data());
+
+        if (raw)
+            return source;
+
+        ref<Bitmap> target = new Bitmap(
+            Bitmap::PixelFormat::MultiChannel,
+            component_format, m_storage->size(),
+            m_storage->channel_count() - 1, {}, target_data);
+
+        source->struct_()->operator[](m_channels.size() - 1).flags |= +Struct::Flags::Weight;
+        for (size_t i = 0; i < m_storage->channel_count() - 1; ++i) {
+            Struct::Field &dest_field = target->struct_()->operator[](i);
+            dest_field.name = m_channels[i];
+        }
+
+        source->convert(target);
+
+        return target;
+    }
+
     Bitmap::FileFormat m_file_format;
     Bitmap::PixelFormat m_pixel_format;
     Struct::Type m_component_format;
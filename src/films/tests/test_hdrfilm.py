@@ -236,3 +236,201 @@ def test07_luminance_alpha_mono(variants_all):
     image = mi.TensorXf(film.bitmap())
 
     assert image.shape[2] == 2
+
+
+@pytest.mark.parametrize('sample_border', [False, True])
+def test08_streaming(variant_scalar_rgb, tmpdir, sample_border):
+    import numpy as np
+    filename = str(tmpdir.join('streamed.exr'))
+
+    def load_scene(**film_args):
+        return mi.load_dict({
+            'type': 'scene',
+            'integrator': { 'type': 'path' },
+            'sensor': {
+                'type': 'perspective',
+                'to_world': mi.ScalarTransform4f().look_at(
+                    origin=[0, 0, 4], target=[0, 0, 0], up=[0, 1, 0]),
+                'sampler': { 'type': 'independent', 'sample_count': 4 },
+                'film': {
+                    'type': 'hdrfilm',
+                    'width': 70,
+                    'height': 45,
+                    'component_format': 'float32',
+                    'sample_border': sample_border,
+                    'rfilter': { 'type': 'gaussian' },
+                    **film_args
+                }
+            },
+            'sphere': { 'type': 'sphere' },
+            'emitter': { 'type': 'constant' }
+        })
+
+    scene = load_scene()
+    ref = mi.render(scene, spp=4)
+
+    scene = load_scene(stream_filename=filename, stream_tile_size=16)
+    film = scene.sensors()[0].film()
+    assert film.streaming()
+    scene.integrator().render(scene, scene.sensors()[0], spp=4, develop=False)
+
+    with pytest.raises(RuntimeError, match='cannot be developed'):
+        film.develop()
+
+    image = np.array(mi.Bitmap(filename))
+    assert image.shape == (45, 70, 3)
+    assert np.allclose(image, np.array(ref), atol=1e-4)
+
+
+def test09_put_tile(variant_scalar_rgb):
+    # Merging tiles without the film's lock must match the regular code path
+    import numpy as np
+
+    films = [mi.load_dict({
+        'type': 'hdrfilm',
+        'width': 37,
+        'height': 29,
+        'rfilter': { 'type': 'gaussian' }
+    }) for _ in range(2)]
+
+    for film in films:
+        film.prepare([])
+
+    rng = np.random.default_rng(seed=0)
+    tile = 16
+    for y in range(0, 29, tile):
+        for x in range(0, 37, tile):
+            size = [min(tile, 37 - x), min(tile, 29 - y)]
+            block = films[0].create_block(size, False, True)
+            block.set_offset([x, y])
+            block.clear()
+
+            for _ in range(64):
+                pos = [x + rng.random() * size[0], y + rng.random() * size[1]]
+                block.put(pos, list(rng.random(5)))
+
+            films[0].put_tile(block)
+            films[1].put_block(block)
+
+    assert np.allclose(np.array(films[0].develop(raw=True)),
+                       np.array(films[1].develop(raw=True)))
+
+
+def test10_develop_dirty(variants_all_rgb):
+    # Only the tiles touched by blocks since the last call are developed
+    import numpy as np
+
+    film = mi.load_dict({
+        'type': 'hdrfilm',
+        'width': 150,
+        'height': 100,
+        'rfilter': { 'type': 'box' }
+    })
+    film.prepare([])
+
+    # Initially, the entire film is reported as changed
+    regions = film.develop_dirty()
+    assert [list(offset) for offset, _ in regions] == [[0, 0], [0, 64]]
+    assert regions[0][1].shape == (64, 150, 3)
+    assert regions[1][1].shape == (36, 150, 3)
+    assert film.develop_dirty() == []
+
+    block = film.create_block([8, 8], False, True)
+    block.set_offset([70, 10])
+    block.clear()
+    block.put([74.5, 14.5], [1, 2, 3, 1, 1])
+    film.put_block(block)
+
+    regions = film.develop_dirty()
+    assert len(regions) == 1
+    offset, image = regions[0]
+    assert list(offset) == [64, 0]
+    assert image.shape == (64, 64, 3)
+
+    image_full = np.array(film.develop())
+    assert np.allclose(np.array(image), image_full[0:64, 64:128])
+    assert np.allclose(np.array(film.develop_region([70, 10], [8, 8])),
+                       image_full[10:18, 70:78])
+    assert film.develop_dirty() == []
+
+
+def test11_write_async(variant_scalar_rgb, tmpdir):
+    import numpy as np
+
+    film = mi.load_dict({
+        'type': 'hdrfilm',
+        'width': 16,
+        'height': 8,
+        'pixel_format': 'rgb',
+        'rfilter': { 'type': 'box' }
+    })
+    film.prepare([])
+
+    limit = mi.Bitmap.async_write_limit()
+    mi.Bitmap.set_async_write_limit(2)
+    try:
+        # The film can be cleared while the previous frames are being written
+        filenames = []
+        for i in range(5):
+            block = film.create_block()
+            block.clear()
+            block.put([4.5, 2.5], [i + 1, 0, 0, 1, 1])
+            film.clear()
+            film.put_block(block)
+            filenames.append(str(tmpdir.join('frame_%i.exr' % i)))
+            film.write_async(filenames[-1])
+        mi.Thread.wait_for_tasks()
+    finally:
+        mi.Bitmap.set_async_write_limit(limit)
+
+    for i, filename in enumerate(filenames):
+        image = np.array(mi.Bitmap(filename))
+        assert np.allclose(image[2, 4], [i + 1, 0, 0])
+
+
+def test12_half_precision_aovs(variants_all_rgb):
+    # AOVs stored in half precision must closely match the regular storage
+    import numpy as np
+
+    aovs = ['depth.T', 'nn.X', 'nn.Y', 'nn.Z']
+    films = [mi.load_dict({
+        'type': 'hdrfilm',
+        'width': 13,
+        'height': 9,
+        'aov_format': fmt,
+        'rfilter': { 'type': 'gaussian' }
+    }) for fmt in ['float32', 'float16']]
+
+    for film in films:
+        film.prepare(aovs)
+
+    rng = np.random.default_rng(seed=0)
+    for i in range(4):
+        block = films[0].create_block([8, 6], False, True)
+        block.set_offset([(i % 2) * 6, (i // 2) * 4])
+        block.clear()
+        for _ in range(32):
+            pos = [block.offset()[0] + rng.random() * 8,
+                   block.offset()[1] + rng.random() * 6]
+            value = [rng.random(), rng.random(), rng.random(), 1,
+                     1000 * rng.random(), *(rng.random(3) * 2 - 1)]
+            block.put(pos, value)
+        for film in films:
+            film.put_block(block)
+
+    image_ref = np.array(films[0].develop())
+    image = np.array(films[1].develop())
+    assert image.shape == image_ref.shape == (9, 13, 7)
+    assert np.allclose(image[..., :3], image_ref[..., :3], rtol=1e-5)
+    assert np.allclose(image[..., 3:], image_ref[..., 3:], rtol=2e-3, atol=2e-3)
+
+    # The raw storage exposes the weighted sums of the AOVs, like before
+    raw_ref, raw = np.array(films[0].develop(raw=True)), np.array(films[1].develop(raw=True))
+    assert np.allclose(raw[..., :4], raw_ref[..., :4], rtol=1e-5)
+    assert np.allclose(raw[..., 4:], raw_ref[..., 4:], rtol=2e-3, atol=2e-2)
+
+    films[1].clear()
+    assert np.all(np.array(films[1].develop(raw=True)) == 0)
+
+    with pytest.raises(RuntimeError, match='aov_format'):
+        mi.load_dict({'type': 'hdrfilm', 'aov_format': 'float64'})
@@ -74,11 +74,39 @@ Currently, the following AOVs types are available:
     - :monosp:`duv_dx`, :monosp:`duv_dy`: UV partials wrt. changes in screen-space.
     - :monosp:`prim_index`: Primitive index (e.g. triangle index in the mesh).
     - :monosp:`shape_index`: Shape index.
+    - :monosp:`ray_count`, :monosp:`shadow_ray_count`: Number of rays traced
+      via :code:`Scene::ray_intersect()` and :code:`Scene::ray_test()`.
+    - :monosp:`traversed_nodes`: Number of visited acceleration data structure nodes.
+    - :monosp:`primitive_tests`: Number of ray-primitive intersection tests.
+    - :monosp:`motion`: Screen-space motion vectors, i.e. the offset in pixels
+      from the position of the visible surface point in the previous frame to
+      its position in the current one.
 
 Note that integer-valued AOVs (e.g. :monosp:`prim_index`, :monosp:`shape_index`)
 are meaningless whenever there is only partial pixel coverage or when using a
 wide pixel reconstruction filter as it will result in fractional values.
 
+The last four AOVs visualize the cost of ray tracing as heatmaps. They count
+the work performed per pixel sample by the AOV integrator and all nested
+integrators (including shadow rays), and they require a scalar variant of
+Mitsuba compiled with the :monosp:`MI_ENABLE_RAY_STATISTICS` CMake option.
+Node visits are only reported by the built-in acceleration data structures,
+and primitive tests only involve Embree's user geometry when Embree is used.
+
+When the AOV integrator wraps a single integrator which supports it (currently
+:ref:`path <integrator-path>` and :ref:`volpath <integrator-volpath>`), the
+AOVs of the first surface intersection are recorded while that integrator
+traces its camera rays, so that the scene is rendered in a single pass. The
+ray statistics AOVs disable this optimization, and derivatives are always
+computed with separate passes.
+
+Motion vectors account for the motion of the sensor and of
+:ref:`instances <shape-instance>` (including keyframed ones, whose
+transformation is evaluated at the center of the shutter interval) between
+consecutive calls to ``render()``, e.g. when rendering an animated sequence
+with ``mi.render_sequence()``. They are zero in the first frame and require a
+``perspective`` or ``thinlens`` sensor.
+
 The :monosp:`albedo` AOV will evaluate the diffuse reflectance
 (\ref BSDF::eval_diffuse_reflectance) of the material. Note that depending on
 the material, this value might only be an approximation.
@@ -87,8 +115,9 @@ the material, this value might only be an approximation.
 template <typename Float, typename Spectrum>
 class AOVIntegrator final : public SamplingIntegrator<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(SamplingIntegrator)
-    MI_IMPORT_TYPES(Scene, Shape, Sensor, Sampler, Medium, BSDFPtr, ShapePtr)
+    MI_IMPORT_BASE(SamplingIntegrator, write_primary_aovs)
+    MI_IMPORT_TYPES(Scene, Shape, ShapePtr, Sensor, Sampler, Medium,
+                    MonteCarloIntegrator)
 
     enum class Type {
         Albedo,
@@ -103,6 +132,11 @@ public:
         dUVdy,
         PrimIndex,
         ShapeIndex,
+        RayCount,
+        ShadowRayCount,
+        TraversedNodes,
+        PrimitiveTests,
+        Motion,
         IntegratorRGBA
     };
 
@@ -188,13 +222,57 @@ public:
             } else if (item[1] == "shape_index") {
                 m_aov_types.push_back(Type::ShapeIndex);
                 m_aov_names.push_back(item[0] + ".I");
+            } else if (item[1] == "ray_count") {
+                m_aov_types.push_back(Type::RayCount);
+                m_aov_names.push_back(item[0] + ".I");
+            } else if (item[1] == "shadow_ray_count") {
+                m_aov_types.push_back(Type::ShadowRayCount);
+                m_aov_names.push_back(item[0] + ".I");
+            } else if (item[1] == "traversed_nodes") {
+                m_aov_types.push_back(Type::TraversedNodes);
+                m_aov_names.push_back(item[0] + ".I");
+            } else if (item[1] == "primitive_tests") {
+                m_aov_types.push_back(Type::PrimitiveTests);
+                m_aov_names.push_back(item[0] + ".I");
+            } else if (item[1] == "motion") {
+                m_aov_types.push_back(Type::Motion);
+                m_aov_names.push_back(item[0] + ".X");
+                m_aov_names.push_back(item[0] + ".Y");
+                m_motion = true;
             } else {
                 Throw("Invalid AOV type \"%s\"!", item[1]);
             }
+
+            if (m_aov_types.back() >= Type::RayCount &&
+                m_aov_types.back() <= Type::PrimitiveTests) {
+                if constexpr (dr::is_jit_v<Float>)
+                    Throw("The \"%s\" AOV is only supported in scalar variants!", item[1]);
+                if (!Profiler::has_ray_statistics())
+                    Throw("The \"%s\" AOV requires Mitsuba to be compiled "
+                          "with -DMI_ENABLE_RAY_STATISTICS=ON!", item[1]);
+                m_ray_statistics = true;
+            }
         }
 
         if (m_aov_names.empty())
             Log(Warn, "No AOVs were specified!");
+
+        // The first 12 AOV types coincide with the 'PrimaryAOV' enumeration
+        for (Type type : m_aov_types) {
+            if (type < Type::RayCount)
+                m_primary_types.push_back((PrimaryAOV) type);
+        }
+
+        /* A single Monte Carlo integrator can produce the primary AOVs
+           in the same pass as the radiance image. Ray statistics must count
+           the work of the AOV integrator itself, and motion vectors are
+           computed by it, which rules this out. */
+        if (m_integrators.size() == 1 && !m_ray_statistics && !m_motion) {
+            MonteCarloIntegrator *integrator =
+                dynamic_cast<MonteCarloIntegrator *>(m_integrators[0].get());
+            if (integrator && integrator->supports_primary_aovs())
+                m_primary_integrator = integrator;
+        }
     }
 
     std::pair<Spectrum, Mask> sample(const Scene *scene,
@@ -205,12 +283,6 @@ public:
                                      Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
 
-        std::pair<Spectrum, Mask> result { 0.f, false };
-
-        SurfaceInteraction3f si =
-            scene->ray_intersect(ray, (uint32_t) RayFlags::All, true, active);
-        dr::masked(si, !si.is_valid()) = dr::zeros<SurfaceInteraction3f>();
-
         auto spectrum_to_color3f = [](const Spectrum& spec, const Ray3f& ray, Mask active) {
             DRJIT_MARK_USED(active);
             UnpolarizedSpectrum spec_u = unpolarized_spectrum(spec);
@@ -227,12 +299,38 @@ public:
             }
         };
 
-        // Shape indexing data structure for scalar variants
-        std::unordered_map<const Shape*, uint32_t> shape_to_idx{};
-        std::vector<ref<Shape>> shapes = scene->shapes();
-        size_t counter = 1; // 0 reserved for background
-        for (const ref<Shape>& shape: shapes)
-            shape_to_idx[shape.get()] = (uint32_t) counter++;
+        /* Single-pass mode (see render()): the inner integrator writes the
+           primary AOVs after its own ones, which directly follow its RGBA
+           channels */
+        if (m_primary_integrator && !m_primary_integrator->primary_aovs().empty()) {
+            auto [inner_spec, inner_mask] = m_primary_integrator->sample(
+                scene, sampler, ray, medium, _aovs + 4, active);
+
+            Color3f rgb = spectrum_to_color3f(inner_spec, ray, active);
+            _aovs[0] = rgb.r();
+            _aovs[1] = rgb.g();
+            _aovs[2] = rgb.b();
+            _aovs[3] = dr::select(inner_mask, Float(1.f), Float(0.f));
+
+            return { inner_spec, inner_mask };
+        }
+
+        std::pair<Spectrum, Mask> result { 0.f, false };
+
+        // Counters of the calling thread before tracing any rays of this sample
+        uint64_t stats_start[int(RayStatistic::RayStatisticCount)] { };
+        if (m_ray_statistics) {
+            for (int i = 0; i < int(RayStatistic::RayStatisticCount); ++i)
+                stats_start[i] = Profiler::thread_ray_statistic((RayStatistic) i);
+        }
+
+        auto ray_statistic = [&](RayStatistic stat) {
+            return Float(ScalarFloat(Profiler::thread_ray_statistic(stat) -
+                                     stats_start[int(stat)]));
+        };
+
+        SurfaceInteraction3f si =
+            scene->ray_intersect(ray, (uint32_t) RayFlags::All, true, active);
 
         // We want to pack the channels such that base_channels and inner-integrator
         // RGBA channels are contiguous
@@ -242,91 +340,44 @@ public:
         size_t inner_idx = 0;
         for (size_t i = 0; i < m_aov_types.size(); ++i) {
             switch (m_aov_types[i]) {
-                case Type::Albedo: {
-                        Color3f rgb(0.f);
-                        if (dr::any_or<true>(si.is_valid()))
-                        {
-                            Mask valid = active && si.is_valid();
-                            BSDFPtr m_bsdf = si.bsdf(ray);
-
-                            Spectrum spec =
-                                m_bsdf->eval_diffuse_reflectance(si, valid);
-                            dr::masked(rgb, valid) =
-                                spectrum_to_color3f(spec, ray, valid);
-                        }
-
-                        *aovs++ = rgb.r();
-                        *aovs++ = rgb.g();
-                        *aovs++ = rgb.b();
-                    }
-                    break;
+                case Type::Albedo:
                 case Type::Depth:
-                    *aovs++ = dr::select(si.is_valid(), si.t, 0.f);
-                    break;
-
                 case Type::Position:
-                    *aovs++ = si.p.x();
-                    *aovs++ = si.p.y();
-                    *aovs++ = si.p.z();
-                    break;
-
                 case Type::UV:
-                    *aovs++ = si.uv.x();
-                    *aovs++ = si.uv.y();
-                    break;
-
                 case Type::GeometricNormal:
-                    *aovs++ = si.n.x();
-                    *aovs++ = si.n.y();
-                    *aovs++ = si.n.z();
-                    break;
-
                 case Type::ShadingNormal:
-                    *aovs++ = si.sh_frame.n.x();
-                    *aovs++ = si.sh_frame.n.y();
-                    *aovs++ = si.sh_frame.n.z();
-                    break;
-
                 case Type::dPdU:
-                    *aovs++ = si.dp_du.x();
-                    *aovs++ = si.dp_du.y();
-                    *aovs++ = si.dp_du.z();
+                case Type::dPdV:
+                case Type::dUVdx:
+                case Type::dUVdy:
+                case Type::PrimIndex:
+                case Type::ShapeIndex: {
+                        PrimaryAOV type = (PrimaryAOV) m_aov_types[i];
+                        write_primary_aovs({ type }, scene, ray, si, aovs, active);
+                        aovs += primary_aov_channels(type);
+                    }
                     break;
 
-                case Type::dPdV:
-                    *aovs++ = si.dp_dv.x();
-                    *aovs++ = si.dp_dv.y();
-                    *aovs++ = si.dp_dv.z();
+                case Type::RayCount:
+                    *aovs++ = ray_statistic(RayStatistic::RayIntersect);
                     break;
 
-                case Type::dUVdx:
-                    si.compute_uv_partials(ray);
-                    *aovs++ = si.duv_dx.x();
-                    *aovs++ = si.duv_dx.y();
+                case Type::ShadowRayCount:
+                    *aovs++ = ray_statistic(RayStatistic::RayTest);
                     break;
 
-                case Type::dUVdy:
-                    *aovs++ = si.duv_dy.x();
-                    *aovs++ = si.duv_dy.y();
+                case Type::TraversedNodes:
+                    *aovs++ = ray_statistic(RayStatistic::TraversedNodes);
                     break;
 
-                case Type::PrimIndex:
-                    *aovs++ = Float(si.prim_index);
+                case Type::PrimitiveTests:
+                    *aovs++ = ray_statistic(RayStatistic::PrimitiveTests);
                     break;
 
-                case Type::ShapeIndex:
-                    if constexpr (!dr::is_jit_v<Float>) {
-                        ShapePtr target = si.instance;
-                        if (!target)
-                            target = si.shape;
-
-                        auto it = shape_to_idx.find(target);
-                        if (it == shape_to_idx.end())
-                            *aovs++ = 0;
-                        else
-                            *aovs++ = Float(it->second);
-                    } else {
-                        *aovs++ = Float(dr::reinterpret_array<UInt32>(si.shape));
+                case Type::Motion: {
+                        Vector2f motion = motion_vector(si, ray, active);
+                        *aovs++ = motion.x();
+                        *aovs++ = motion.y();
                     }
                     break;
 
@@ -360,6 +411,45 @@ public:
                     bool develop,
                     bool evaluate) override {
 
+        /* Every primal rendering advances the frame of the motion vectors,
+           which are zero when differentiating */
+        if (m_motion)
+            prepare_motion(scene, sensor);
+
+        struct MotionScope {
+            ~MotionScope() { integrator->m_motion_sensor = nullptr; }
+            AOVIntegrator *integrator;
+        } motion_scope { this };
+
+        if (m_primary_integrator) {
+            TensorXf image;
+            {
+                // Request the primary AOVs for the duration of this pass
+                PrimaryAOVScope scope(m_primary_integrator, m_primary_types);
+                image = Base::render(scene, sensor, seed, spp, develop, evaluate);
+            }
+
+            if (!develop)
+                return {};
+
+            /* Rearrange the channels into the layout produced by separate
+               passes, which excludes the copy of the inner RGBA channels */
+            size_t base_ch_count = sensor->film()->base_channels_count(),
+                   inner_aovs = m_integrators[0]->aov_names().size(),
+                   num_aovs = m_aov_names.size() - m_integrator_aovs_count;
+
+            std::vector<TensorXf> inner_images = {
+                get_channels_slice(image, 0, base_ch_count)
+            };
+            if (inner_aovs > 0)
+                inner_images.push_back(
+                    get_channels_slice(image, base_ch_count + 4, inner_aovs));
+
+            return merge_channels(
+                inner_images,
+                get_channels_slice(image, base_ch_count + 4, num_aovs));
+        }
+
         std::vector<TensorXf> inner_images;
         for (auto& integrator : m_integrators) {
             auto image = integrator->render(scene, sensor, seed, spp, develop, evaluate);
@@ -469,6 +559,91 @@ public:
 
     MI_DECLARE_CLASS()
 protected:
+    /**
+     * \brief Screen-space motion of the surface point \c si since the
+     * previous frame, in pixels
+     *
+     * Projecting the position in the previous frame with the previous sensor
+     * transform is equivalent to projecting it with the current sensor after
+     * applying the relative transform \c m_motion_sensor_delta.
+     */
+    Vector2f motion_vector(const SurfaceInteraction3f &si,
+                           const RayDifferential3f &ray, Mask active) const {
+        if (!m_motion_sensor)
+            return 0.f;
+
+        active &= si.is_valid();
+
+        Point3f p_prev = si.p;
+        for (const auto &[shape, delta] : m_motion_instances)
+            dr::masked(p_prev, active && si.instance == ShapePtr(shape)) =
+                Transform4f(delta).transform_affine(si.p);
+
+        Interaction3f it = dr::zeros<Interaction3f>();
+        it.time = ray.time;
+        it.wavelengths = ray.wavelengths;
+
+        // Sample the center of the aperture, which projects the point
+        it.p = si.p;
+        auto [ds, weight] = m_motion_sensor->sample_direction(it, Point2f(.5f), active);
+        active &= ds.pdf > 0.f;
+        Point2f uv = ds.uv;
+
+        it.p = Transform4f(m_motion_sensor_delta).transform_affine(p_prev);
+        std::tie(ds, weight) = m_motion_sensor->sample_direction(it, Point2f(.5f), active);
+        active &= ds.pdf > 0.f;
+
+        return dr::select(active, uv - ds.uv, 0.f);
+    }
+
+    /// Compute the transforms between the previous frame and the current one
+    void prepare_motion(const Scene *scene, const Sensor *sensor) {
+        ScalarFloat time =
+            sensor->shutter_open() + .5f * sensor->shutter_open_time();
+
+        Transform4f trafo = sensor->world_transform();
+        ScalarTransform4f to_world;
+        if constexpr (dr::is_jit_v<Float>)
+            to_world = ScalarTransform4f(ScalarMatrix4f(dr::slice(trafo.matrix)));
+        else
+            to_world = trafo;
+
+        bool has_prev = m_prev_sensor == sensor;
+        m_motion_sensor_delta = has_prev ? to_world * m_prev_sensor_to_world.inverse()
+                                         : ScalarTransform4f();
+        m_prev_sensor = sensor;
+        m_prev_sensor_to_world = to_world;
+
+        m_motion_instances.clear();
+        std::unordered_map<const Shape *, ScalarTransform4f> instances;
+        for (const ref<Shape> &shape : scene->shapes()) {
+            if (!shape->is_instance())
+                continue;
+            ScalarTransform4f shape_to_world = shape->instance_transform(time);
+            instances[shape.get()] = shape_to_world;
+
+            auto it = m_prev_instances.find(shape.get());
+            if (has_prev && it != m_prev_instances.end() &&
+                !(it->second == shape_to_world))
+                m_motion_instances.emplace_back(
+                    shape.get(), it->second * shape_to_world.inverse());
+        }
+        m_prev_instances = std::move(instances);
+        m_motion_sensor = sensor;
+    }
+
+    /// Sets the primary AOVs of an inner integrator until the end of a scope
+    struct PrimaryAOVScope {
+        PrimaryAOVScope(MonteCarloIntegrator *integrator,
+                        const std::vector<PrimaryAOV> &types)
+            : integrator(integrator) {
+            integrator->set_primary_aovs(types);
+        }
+
+        ~PrimaryAOVScope() { integrator->set_primary_aovs({}); }
+
+        MonteCarloIntegrator *integrator;
+    };
 
     TensorXf get_channels_slice(const TensorXf& src, size_t channel_offset, size_t num_channels) const {
         using Array = typename TensorXf::Array;
@@ -556,9 +731,23 @@ protected:
 
 private:
     size_t m_integrator_aovs_count;
+    bool m_ray_statistics = false;
     std::vector<Type> m_aov_types;
     std::vector<std::string> m_aov_names;
     std::vector<ref<Base>> m_integrators;
+
+    /// Inner integrator that can write the primary AOVs (single-pass mode)
+    MonteCarloIntegrator *m_primary_integrator = nullptr;
+    std::vector<PrimaryAOV> m_primary_types;
+
+    /// Motion vectors: state of the current and of the previous frame
+    bool m_motion = false;
+    const Sensor *m_motion_sensor = nullptr;
+    ScalarTransform4f m_motion_sensor_delta;
+    std::vector<std::pair<const Shape *, ScalarTransform4f>> m_motion_instances;
+    const Sensor *m_prev_sensor = nullptr;
+    ScalarTransform4f m_prev_sensor_to_world;
+    std::unordered_map<const Shape *, ScalarTransform4f> m_prev_instances;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(AOVIntegrator, SamplingIntegrator)
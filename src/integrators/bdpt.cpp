@@ -0,0 +1,718 @@
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/render/integrator.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/records.h>
+#include <mitsuba/render/sampler.h>
+#include <mitsuba/render/sensor.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _integrator-bdpt:
+
+Bidirectional path tracer (:monosp:`bdpt`)
+------------------------------------------
+
+.. pluginparameters::
+
+ * - max_depth
+   - |int|
+   - Specifies the longest path depth in the generated output image. A value of 1 will only
+     render directly visible light sources. 2 will lead to single-bounce (direct-only)
+     illumination, and so on. Unlike the other integrators, infinite depth (-1) is not
+     supported. (Default: 6)
+
+ * - rr_depth
+   - |int|
+   - Specifies the minimum path depth, after which the implementation will start to use the
+     *russian roulette* path termination criterion. (Default: 5)
+
+ * - hide_emitters
+   - |bool|
+   - Hide directly visible emitters. (Default: no, i.e. |false|)
+
+ * - samples_per_pass
+   - |bool|
+   - If specified, divides the workload in successive passes with :paramtype:`samples_per_pass`
+     samples per pixel.
+
+This integrator traces one subpath from the sensor and one from a light source (using the
+same emitter ray sampling as the :ref:`particle tracer <integrator-ptracer>`), and connects
+every pair of their vertices. Paths with :math:`s` light vertices and :math:`t` sensor vertices
+are combined with multiple importance sampling (power heuristic) over all connection
+strategies that could have produced them. This makes the technique considerably more robust
+than :ref:`path <integrator-path>` in scenes where light reaches the visible surfaces
+through small openings, or after bouncing off surfaces that are easy to reach from the
+light sources.
+
+Connections of light vertices to the sensor are splatted to arbitrary image positions,
+which is why this integrator, like the particle tracer, cannot divide the workload into
+image-space tiles.
+
+The subpaths are stored in fixed-size vertex arrays (one entry per depth), and every
+connection strategy is evaluated for all samples of a wavefront at once. In JIT variants,
+this produces one kernel per subpath and one per row of connections.
+
+The current implementation has the following limitations:
+
+- Only perspective (pinhole) sensors are supported, and the sensor cannot be hit by light
+  subpaths.
+- Light subpaths are only traced from area and point-like emitters. Environment and
+  directional emitters are handled with the emitter and BSDF sampling strategies of the
+  path tracer.
+- Spectral and polarized variants, as well as participating media, are not supported.
+
+.. tabs::
+    .. code-tab::  xml
+
+        <integrator type="bdpt">
+            <integer name="max_depth" value="8"/>
+        </integrator>
+
+    .. code-tab:: python
+
+        'type': 'bdpt',
+        'max_depth': 8
+
+ */
+
+template <typename Float, typename Spectrum>
+class BidirectionalPathIntegrator final : public AdjointIntegrator<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(AdjointIntegrator, connect_sensor, m_hide_emitters,
+                    m_rr_depth, m_max_depth)
+    MI_IMPORT_TYPES(Scene, Sensor, Sampler, ImageBlock, Emitter, EmitterPtr,
+                     BSDF, BSDFPtr)
+
+    /// Vertex of a light or sensor subpath
+    struct Vertex {
+        /// Surface interaction (only the position is set for sensor vertices)
+        SurfaceInteraction3f si;
+        /// Throughput of the subpath up to (and excluding) this vertex
+        Spectrum beta;
+        /// Area density of this vertex when sampled from its own subpath
+        Float pdf_fwd;
+        /// Area density of this vertex when sampled from the other subpath
+        Float pdf_rev;
+        /// Was the outgoing direction sampled from a delta lobe?
+        Mask delta;
+        /// Does this vertex exist?
+        Mask valid;
+
+        DRJIT_STRUCT(Vertex, si, beta, pdf_fwd, pdf_rev, delta, valid)
+    };
+
+    BidirectionalPathIntegrator(const Properties &props) : Base(props) {
+        if constexpr (is_spectral_v<Spectrum> || is_polarized_v<Spectrum>)
+            Throw("The bidirectional path tracer only supports RGB and "
+                  "monochromatic variants!");
+
+        m_max_depth = props.get<int>("max_depth", 6);
+        if (m_max_depth < 1)
+            Throw("\"max_depth\" must be set to a finite value >= 1!");
+    }
+
+    void sample(const Scene *scene, const Sensor *sensor, Sampler *sampler,
+                ImageBlock *block, ScalarFloat sample_scale) const override {
+        if (sensor->needs_aperture_sample())
+            Throw("The bidirectional path tracer only supports pinhole sensors!");
+
+        size_t max_depth    = (size_t) m_max_depth,
+               sensor_count = max_depth + 1,
+               light_count  = max_depth;
+
+        Float time = sensor->shutter_open();
+        if (sensor->shutter_open_time() > 0)
+            time += sampler->next_1d() * sensor->shutter_open_time();
+
+        // Pick a uniformly distributed position on the sensor's crop window
+        Point2f position_sample = sampler->next_2d();
+        Vector2f position = position_sample * ScalarVector2f(block->size()) +
+                            ScalarVector2f(block->offset());
+
+        // ------------------------- Subpath generation -------------------------
+
+        std::vector<Vertex> cam(sensor_count, dr::zeros<Vertex>()),
+                            light(light_count, dr::zeros<Vertex>());
+
+        Spectrum result = trace_sensor_subpath(scene, sensor, sampler, time,
+                                               position_sample, cam);
+
+        auto [light_delta, light_on_surface] =
+            trace_light_subpath(scene, sampler, time, light);
+
+        schedule(sampler, cam, light, result);
+
+        // -------------------- Connections (t >= 2, s >= 0) --------------------
+
+        BSDFContext ctx;
+        for (size_t t = 2; t <= sensor_count; ++t) {
+            const Vertex &z = cam[t - 1];
+            Mask active = z.valid;
+            if (dr::none_or<false>(active))
+                break;
+
+            // s = 0: the sensor subpath directly hits an area emitter
+            if (t > 2 || !m_hide_emitters) {
+                EmitterPtr emitter = z.si.emitter(scene);
+                Mask active_e = active && (emitter != nullptr);
+                if (dr::any_or<true>(active_e)) {
+                    Float z_rev = pdf_light_origin(scene, emitter, z.si, active_e),
+                          z_prev_rev = 0.f;
+                    if (t > 2)
+                        z_prev_rev = pdf_light_direction(emitter, z.si,
+                                                         cam[t - 2].si, active_e);
+
+                    Float mis = mis_weight(cam, t, nullptr, 0, false, z_rev,
+                                           z_prev_rev, 0.f, 0.f);
+                    result[active_e] +=
+                        z.beta * emitter->eval(z.si, active_e) * mis;
+                }
+            }
+
+            if (t == sensor_count)
+                break;
+
+            BSDFPtr bsdf = z.si.bsdf();
+            Vector3f z_wi = z.si.to_world(z.si.wi);
+
+            // s = 1: emitter sampling
+            Mask active_e = active && has_flag(bsdf->flags(), BSDFFlags::Smooth);
+            if (dr::any_or<true>(active_e)) {
+                auto [ds, em_weight] = scene->sample_emitter_direction(
+                    z.si, sampler->next_2d(active_e), true, active_e);
+                active_e &= (ds.pdf != 0.f);
+
+                Vector3f wo = z.si.to_local(ds.d);
+                Spectrum bsdf_val = bsdf->eval(ctx, z.si, wo, active_e);
+                Float bsdf_pdf = bsdf->pdf(ctx, z.si, wo, active_e);
+
+                /* Environment and directional emitters don't start light
+                   subpaths: only use the strategies of the path tracer */
+                Mask env = active_e &&
+                    (has_flag(ds.emitter->flags(), EmitterFlags::Infinite) ||
+                     has_flag(ds.emitter->flags(), EmitterFlags::DeltaDirection));
+                Float mis_env =
+                    dr::select(ds.delta, 1.f, power_heuristic(ds.pdf, bsdf_pdf));
+
+                // Temporary light vertex for the remaining emitters
+                Vertex y0 = dr::zeros<Vertex>();
+                y0.si.p  = ds.p;
+                y0.si.n  = ds.n;
+                y0.si.uv = ds.uv;
+                Mask y_on_surface = !ds.delta,
+                     active_y = active_e && !env;
+                y0.pdf_fwd = pdf_light_origin(scene, ds.emitter, y0.si,
+                                              active_y && y_on_surface);
+
+                Float y_rev  = to_area(bsdf_pdf, z.si.p, y0.si, y_on_surface),
+                      z_rev  = pdf_light_direction(ds.emitter, y0.si, z.si, active_y),
+                      z_prev_rev = 0.f;
+                if (t > 2)
+                    z_prev_rev = to_area(pdf_bsdf(bsdf, z.si, ds.d, z_wi, active_e),
+                                         z.si.p, cam[t - 2].si, true);
+
+                Float mis = dr::select(
+                    env, mis_env,
+                    mis_weight(cam, t, &y0, 1, ds.delta, z_rev, z_prev_rev,
+                               y_rev, 0.f));
+
+                result[active_e] += z.beta * bsdf_val * em_weight * mis;
+            }
+
+            // s >= 2: connect to a vertex of the light subpath
+            for (size_t s = 2; s <= std::min(light_count, max_depth + 1 - t); ++s) {
+                const Vertex &y = light[s - 1];
+                Mask active_c = active && y.valid;
+                if (dr::none_or<false>(active_c))
+                    break;
+
+                Vector3f d = y.si.p - z.si.p;
+                Float dist2 = dr::squared_norm(d);
+                d *= dr::rsqrt(dist2);
+
+                BSDFPtr bsdf_y = y.si.bsdf();
+                Vector3f y_wi = y.si.to_world(y.si.wi);
+
+                Spectrum contrib =
+                    z.beta * bsdf->eval(ctx, z.si, z.si.to_local(d), active_c) *
+                    eval_adjoint(bsdf_y, y.si, -d, active_c) * y.beta / dist2;
+
+                active_c &= dr::any(unpolarized_spectrum(contrib) != 0.f);
+                if (dr::none_or<false>(active_c))
+                    continue;
+
+                active_c &= !scene->ray_test(z.si.spawn_ray_to(y.si.p), active_c);
+
+                Float z_rev = to_area(pdf_bsdf(bsdf_y, y.si, y_wi, -d, active_c),
+                                      y.si.p, z.si, true),
+                      y_rev = to_area(pdf_bsdf(bsdf, z.si, z_wi, d, active_c),
+                                      z.si.p, y.si, true),
+                      y_prev_rev = to_area(pdf_bsdf(bsdf_y, y.si, -d, y_wi, active_c),
+                                           y.si.p, light[s - 2].si,
+                                           s > 2 ? Mask(true) : light_on_surface),
+                      z_prev_rev = 0.f;
+                if (t > 2)
+                    z_prev_rev = to_area(pdf_bsdf(bsdf, z.si, d, z_wi, active_c),
+                                         z.si.p, cam[t - 2].si, true);
+
+                Float mis = mis_weight(cam, t, light.data(), s, light_delta,
+                                       z_rev, z_prev_rev, y_rev, y_prev_rev);
+                result[active_c] += contrib * mis;
+            }
+
+            schedule(sampler, result);
+        }
+
+        block->put(position, cam[0].si.wavelengths, result * sample_scale,
+                   dr::select(cam[1].valid, 1.f, 0.f), /* weight = */ 0.f);
+
+        // ----------------------- Connections (t = 1) --------------------------
+
+        for (size_t s = 2; s <= light_count; ++s) {
+            const Vertex &y = light[s - 1];
+            Mask active = y.valid;
+            if (dr::none_or<false>(active))
+                break;
+
+            auto [sensor_ds, sensor_weight] =
+                sensor->sample_direction(y.si, sampler->next_2d(active), active);
+            active &= (sensor_ds.pdf > 0.f);
+
+            BSDFPtr bsdf = y.si.bsdf();
+            Float y_rev = pdf_sensor(sensor_ds, sensor_weight, y.si),
+                  y_prev_rev = to_area(
+                      pdf_bsdf(bsdf, y.si, sensor_ds.d, y.si.to_world(y.si.wi), active),
+                      y.si.p, light[s - 2].si, s > 2 ? Mask(true) : light_on_surface);
+
+            Float mis = mis_weight(cam, 1, light.data(), s, light_delta, 0.f,
+                                   0.f, y_rev, y_prev_rev);
+            connect_sensor(scene, y.si, sensor_ds, bsdf,
+                           y.beta * sensor_weight * mis, block, sample_scale,
+                           active);
+        }
+    }
+
+    /**
+     * \brief Trace a subpath starting at the sensor
+     *
+     * Radiance of environment emitters reached by this subpath is combined
+     * with emitter sampling as in the path tracer and directly returned,
+     * since no other connection strategy can produce these paths.
+     */
+    Spectrum trace_sensor_subpath(const Scene *scene, const Sensor *sensor,
+                                  Sampler *sampler, const Float &time,
+                                  const Point2f &position_sample,
+                                  std::vector<Vertex> &cam) const {
+        auto [ray, ray_weight] = sensor->sample_ray(
+            time, sampler->next_1d(), position_sample, dr::zeros<Point2f>());
+
+        Vertex &z0 = cam[0];
+        z0.si.p           = ray.o;
+        z0.si.time        = ray.time;
+        z0.si.wavelengths = ray.wavelengths;
+        z0.beta           = ray_weight;
+        z0.valid          = true;
+
+        BSDFContext ctx;
+        Spectrum beta = ray_weight, result = 0.f;
+        Float eta = 1.f, pdf_dir = 0.f;
+        Mask active = true;
+
+        for (size_t i = 1; i < cam.size(); ++i) {
+            Vertex &v = cam[i];
+            const Vertex &prev = cam[i - 1];
+            SurfaceInteraction3f si = scene->ray_intersect(
+                ray, +RayFlags::All, /* coherent = */ i == 1, active);
+
+            // Emission of environment emitters (area emitters are handled later)
+            Mask escaped = active && !si.is_valid();
+            if ((i > 1 || !m_hide_emitters) && dr::any_or<true>(escaped)) {
+                DirectionSample3f ds(scene, si, prev.si);
+                escaped &= ds.emitter != nullptr;
+                if (dr::any_or<true>(escaped)) {
+                    Float mis = 1.f;
+                    if (i > 1) {
+                        Float em_pdf = scene->pdf_emitter_direction(
+                            prev.si, ds, escaped && !prev.delta);
+                        mis = dr::select(prev.delta, 1.f,
+                                         power_heuristic(pdf_dir, em_pdf));
+                    }
+                    result[escaped] += beta * ds.emitter->eval(si, escaped) * mis;
+                }
+            }
+
+            active &= si.is_valid();
+            v.si    = si;
+            v.beta  = beta;
+            v.valid = active;
+            if (i == 1)
+                v.pdf_fwd = pdf_sensor(sensor, si, active);
+            else
+                v.pdf_fwd = to_area(dr::select(prev.delta, 0.f, pdf_dir),
+                                    prev.si.p, si, true);
+
+            if (i + 1 == cam.size() || dr::none_or<false>(active))
+                break;
+
+            BSDFPtr bsdf = si.bsdf(ray);
+            auto [bs, bsdf_weight] =
+                bsdf->sample(ctx, si, sampler->next_1d(active),
+                             sampler->next_2d(active), active);
+            Vector3f wo = si.to_world(bs.wo);
+
+            v.delta = has_flag(bs.sampled_type, BSDFFlags::Delta);
+            if (i > 1)
+                cam[i - 1].pdf_rev = dr::select(
+                    v.delta, 0.f,
+                    to_area(pdf_bsdf(bsdf, si, wo, si.to_world(si.wi), active),
+                            si.p, prev.si, true));
+
+            beta *= bsdf_weight;
+            eta *= bs.eta;
+            pdf_dir = bs.pdf;
+            active &= dr::any(unpolarized_spectrum(beta) != 0.f);
+
+            // Russian Roulette
+            if ((int) i >= m_rr_depth) {
+                Float q = dr::minimum(
+                    dr::max(unpolarized_spectrum(beta)) * dr::square(eta), .95f);
+                active &= sampler->next_1d(active) < q;
+                beta *= dr::rcp(q);
+            }
+
+            ray = si.spawn_ray(wo);
+        }
+
+        return result;
+    }
+
+    /**
+     * \brief Trace a subpath starting at an emitter
+     *
+     * \return Whether the emitter has a delta position, and whether the
+     * first vertex lies on a surface
+     */
+    std::pair<Mask, Mask> trace_light_subpath(const Scene *scene,
+                                              Sampler *sampler,
+                                              const Float &time,
+                                              std::vector<Vertex> &light) const {
+        if (scene->emitters().empty())
+            return { false, false };
+
+        Float wavelength_sample = sampler->next_1d();
+        Point2f position_sample  = sampler->next_2d(),
+                direction_sample = sampler->next_2d();
+
+        auto [ray, ray_weight, emitter] = scene->sample_emitter_ray(
+            time, wavelength_sample, position_sample, direction_sample);
+
+        // Environment and directional emitters don't start light subpaths
+        Mask active = !has_flag(emitter->flags(), EmitterFlags::Infinite) &&
+                      !has_flag(emitter->flags(), EmitterFlags::DeltaDirection) &&
+                      dr::any(unpolarized_spectrum(ray_weight) != 0.f);
+
+        Mask delta      = has_flag(emitter->flags(), EmitterFlags::DeltaPosition),
+             on_surface = active && !delta;
+
+        Vertex &y0 = light[0];
+        y0.si             = dr::zeros<SurfaceInteraction3f>();
+        y0.si.p           = ray.o;
+        y0.si.time        = time;
+        y0.si.wavelengths = ray.wavelengths;
+        y0.si.shape       = emitter->shape();
+        y0.valid          = active;
+
+        /* Recover the surface point of area emitters, which was sampled with
+           the same 2D sample (position sampling is deterministic) */
+        if (dr::any_or<true>(on_surface)) {
+            auto [ps, pos_weight] =
+                emitter->sample_position(time, position_sample, on_surface);
+            DRJIT_MARK_USED(pos_weight);
+            SurfaceInteraction3f si(ps, ray.wavelengths);
+            si.shape = y0.si.shape;
+            y0.si[on_surface] = si;
+        }
+
+        // Densities of the emitted ray, as used by the emitter's ray sampling
+        y0.pdf_fwd = pdf_light_origin(scene, emitter, y0.si, on_surface);
+        Float pdf_dir = pdf_emitted_direction(emitter, y0.si, ray.d, active);
+
+        BSDFContext ctx(TransportMode::Importance);
+        Spectrum beta = ray_weight;
+        Float eta = 1.f;
+
+        for (size_t i = 1; i < light.size(); ++i) {
+            Vertex &v = light[i];
+            const Vertex &prev = light[i - 1];
+            SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+
+            active &= si.is_valid();
+            v.si    = si;
+            v.beta  = beta;
+            v.valid = active;
+            v.pdf_fwd = to_area(dr::select(prev.delta, 0.f, pdf_dir), prev.si.p,
+                                si, true);
+
+            if (i + 1 == light.size() || dr::none_or<false>(active))
+                break;
+
+            BSDFPtr bsdf = si.bsdf();
+            auto [bs, bsdf_weight] =
+                bsdf->sample(ctx, si, sampler->next_1d(active),
+                             sampler->next_2d(active), active);
+            Vector3f wo = si.to_world(bs.wo);
+
+            // Using geometric normals (wo points to the camera)
+            Float wi_dot_geo_n = dr::dot(si.n, -ray.d),
+                  wo_dot_geo_n = dr::dot(si.n, wo);
+
+            // Prevent light leaks due to shading normals
+            active &= (wi_dot_geo_n * Frame3f::cos_theta(si.wi) > 0.f) &&
+                      (wo_dot_geo_n * Frame3f::cos_theta(bs.wo) > 0.f);
+
+            // Adjoint BSDF for shading normals -- [Veach, p. 155]
+            Float correction = dr::abs((Frame3f::cos_theta(si.wi) * wo_dot_geo_n) /
+                                       (Frame3f::cos_theta(bs.wo) * wi_dot_geo_n));
+
+            v.delta = has_flag(bs.sampled_type, BSDFFlags::Delta);
+            light[i - 1].pdf_rev = dr::select(
+                v.delta, 0.f,
+                to_area(pdf_bsdf(bsdf, si, wo, -ray.d, active), si.p, prev.si,
+                        i > 1 ? Mask(true) : on_surface));
+
+            beta *= bsdf_weight * correction;
+            eta *= bs.eta;
+            pdf_dir = bs.pdf;
+            active &= dr::any(unpolarized_spectrum(beta) != 0.f);
+
+            // Russian Roulette
+            if ((int) i >= m_rr_depth) {
+                Float q = dr::minimum(
+                    dr::max(unpolarized_spectrum(beta)) * dr::square(eta), .95f);
+                active &= sampler->next_1d(active) < q;
+                beta *= dr::rcp(q);
+            }
+
+            ray = si.spawn_ray(wo);
+        }
+
+        return { delta, on_surface };
+    }
+
+    /**
+     * \brief Compute the MIS weight (power heuristic) of the strategy that
+     * connects \c s light and \c t sensor vertices
+     *
+     * The four \c *_rev arguments replace the reverse densities of the two
+     * vertices on each side of the connection, which depend on the strategy.
+     * Following Veach's thesis, the densities of all other strategies are
+     * obtained incrementally from the ratios of reverse and forward
+     * densities of the vertices that move from one subpath to the other.
+     */
+    Float mis_weight(const std::vector<Vertex> &cam, size_t t,
+                     const Vertex *light, size_t s, const Mask &light_delta,
+                     const Float &z_rev, const Float &z_prev_rev,
+                     const Float &y_rev, const Float &y_prev_rev) const {
+        if (s + t == 2)
+            return 1.f;
+
+        // Delta densities are represented by zeros, which cancel out
+        auto remap = [](const Float &pdf) {
+            return dr::select(pdf != 0.f, pdf, 1.f);
+        };
+
+        Float sum = 0.f, ri = 1.f;
+
+        // Strategies with fewer sensor vertices
+        for (size_t i = t - 1; i > 0; --i) {
+            const Float &rev = (i == t - 1) ? z_rev
+                               : (i == t - 2) ? z_prev_rev : cam[i].pdf_rev;
+            ri *= dr::square(remap(rev) / remap(cam[i].pdf_fwd));
+
+            Mask delta = cam[i - 1].delta;
+            if (i != t - 1)
+                delta |= cam[i].delta;
+            dr::masked(sum, !delta) += ri;
+        }
+
+        // Strategies with fewer light vertices
+        ri = 1.f;
+        for (size_t i = s; i-- > 0; ) {
+            const Float &rev = (i == s - 1) ? y_rev
+                               : (i == s - 2) ? y_prev_rev : light[i].pdf_rev;
+            ri *= dr::square(remap(rev) / remap(light[i].pdf_fwd));
+
+            Mask delta = i > 0 ? light[i - 1].delta : light_delta;
+            if (i != s - 1)
+                delta |= light[i].delta;
+            dr::masked(sum, !delta) += ri;
+        }
+
+        return dr::rcp(1.f + sum);
+    }
+
+    /// Compute a multiple importance sampling weight using the power heuristic
+    Float power_heuristic(Float pdf_a, Float pdf_b) const {
+        pdf_a *= pdf_a;
+        pdf_b *= pdf_b;
+        Float w = pdf_a / (pdf_a + pdf_b);
+        return dr::select(dr::isfinite(w), w, 0.f);
+    }
+
+    /**
+     * \brief Convert a solid angle density of sampling \c si from \c p to
+     * the area measure (\c on_surface is \c false for point-like vertices)
+     */
+    Float to_area(const Float &pdf, const Point3f &p,
+                  const SurfaceInteraction3f &si, const Mask &on_surface) const {
+        Vector3f d = si.p - p;
+        Float inv_dist2 = dr::rcp(dr::squared_norm(d));
+        Float cos_theta = dr::select(
+            on_surface, dr::abs(dr::dot(si.n, d)) * dr::sqrt(inv_dist2), 1.f);
+        return pdf * cos_theta * inv_dist2;
+    }
+
+    /// Solid angle density of sampling \c wo at \c si given \c wi (world space)
+    Float pdf_bsdf(const BSDFPtr &bsdf, const SurfaceInteraction3f &si,
+                   const Vector3f &wi, const Vector3f &wo, Mask active) const {
+        SurfaceInteraction3f si_(si);
+        si_.wi = si.to_local(wi);
+        BSDFContext ctx;
+        return bsdf->pdf(ctx, si_, si.to_local(wo), active);
+    }
+
+    /// Evaluate the adjoint BSDF (including the shading normal correction)
+    Spectrum eval_adjoint(const BSDFPtr &bsdf, const SurfaceInteraction3f &si,
+                          const Vector3f &wo, Mask active) const {
+        BSDFContext ctx(TransportMode::Importance);
+        Vector3f wo_local = si.to_local(wo);
+
+        // Using geometric normals
+        Float wi_dot_geo_n = dr::dot(si.n, si.to_world(si.wi)),
+              wo_dot_geo_n = dr::dot(si.n, wo);
+
+        // Prevent light leaks due to shading normals
+        Mask valid = (wi_dot_geo_n * Frame3f::cos_theta(si.wi) > 0.f) &&
+                     (wo_dot_geo_n * Frame3f::cos_theta(wo_local) > 0.f);
+
+        // Adjoint BSDF for shading normals -- [Veach, p. 155]
+        Float correction = dr::select(valid,
+            dr::abs((Frame3f::cos_theta(si.wi) * wo_dot_geo_n) /
+                    (Frame3f::cos_theta(wo_local) * wi_dot_geo_n)), 0.f);
+
+        return bsdf->eval(ctx, si, wo_local, active) * correction;
+    }
+
+    /**
+     * \brief Area density of sampling \c si from the sensor, given the
+     * result of \ref Sensor::sample_direction() at \c si
+     *
+     * For pinhole sensors, the directional density equals the importance,
+     * which is the returned weight times the squared distance.
+     */
+    Float pdf_sensor(const DirectionSample3f &ds, const Spectrum &weight,
+                     const SurfaceInteraction3f &si) const {
+        return dr::select(ds.pdf > 0.f,
+                          weight[0] * dr::abs(dr::dot(si.n, ds.d)), 0.f);
+    }
+
+    /// Area density of sampling \c si from the sensor
+    Float pdf_sensor(const Sensor *sensor, const SurfaceInteraction3f &si,
+                     Mask active) const {
+        auto [ds, weight] =
+            sensor->sample_direction(si, dr::zeros<Point2f>(), active);
+        return pdf_sensor(ds, weight, si);
+    }
+
+    /// Position sample of the light vertex \c y (using its geometric normal)
+    PositionSample3f light_position(const SurfaceInteraction3f &y) const {
+        PositionSample3f ps(y);
+        ps.n = y.n;
+        return ps;
+    }
+
+    /**
+     * \brief Solid angle density of emitting a ray along \c d from the light
+     * vertex \c y, as sampled by \ref Emitter::sample_ray()
+     */
+    Float pdf_emitted_direction(const EmitterPtr &emitter,
+                                const SurfaceInteraction3f &y,
+                                const Vector3f &d, Mask active) const {
+        if (dr::none_or<false>(active))
+            return 0.f;
+
+        Float pdf = emitter->pdf_ray_direction(light_position(y), d, active);
+        return dr::select(active, pdf, 0.f);
+    }
+
+    /// Area density of emitting toward \c si from the light vertex \c y
+    Float pdf_light_direction(const EmitterPtr &emitter,
+                              const SurfaceInteraction3f &y,
+                              const SurfaceInteraction3f &si,
+                              const Mask &active) const {
+        Vector3f d = dr::normalize(si.p - y.p);
+        return to_area(pdf_emitted_direction(emitter, y, d, active), y.p, si,
+                       true);
+    }
+
+    /**
+     * \brief Area density of choosing the point \c si on an area emitter as
+     * the origin of a light subpath
+     *
+     * This is the density of \ref Scene::sample_emitter_ray(), i.e. the
+     * probability of selecting the emitter times its position density.
+     */
+    Float pdf_light_origin(const Scene *scene, const EmitterPtr &emitter,
+                           const SurfaceInteraction3f &si, Mask active) const {
+        if (dr::none_or<false>(active))
+            return 0.f;
+
+        Float pdf = scene->pdf_emitter(emitter->scene_index(), active) *
+                    emitter->pdf_position(light_position(si), active);
+        return dr::select(active, pdf, 0.f);
+    }
+
+    /**
+     * \brief Evaluate the current wavefront in JIT variants, so that each
+     * subpath and row of connections is rendered by a separate kernel
+     */
+    template <typename... Ts>
+    void schedule(Sampler *sampler, const Ts &...values) const {
+        if constexpr (dr::is_jit_v<Float>) {
+            (schedule_value(values), ...);
+            sampler->schedule_state();
+            dr::eval();
+        } else {
+            ((void) values, ...);
+            (void) sampler;
+        }
+    }
+
+    void schedule_value(const std::vector<Vertex> &vertices) const {
+        for (const Vertex &v : vertices)
+            dr::schedule(v);
+    }
+
+    void schedule_value(const Spectrum &value) const { dr::schedule(value); }
+
+    //! @}
+    // =============================================================
+
+    std::string to_string() const override {
+        return tfm::format("BidirectionalPathIntegrator[\n"
+                           "  max_depth = %i,\n"
+                           "  rr_depth = %i\n"
+                           "]",
+                           m_max_depth, m_rr_depth);
+    }
+
+    MI_DECLARE_CLASS()
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(BidirectionalPathIntegrator, AdjointIntegrator);
+MI_EXPORT_PLUGIN(BidirectionalPathIntegrator, "Bidirectional path tracer");
+NAMESPACE_END(mitsuba)
@@ -144,14 +144,27 @@ public:
         auto flags = bsdf->flags();
         Mask sample_emitter = active && has_flag(flags, BSDFFlags::Smooth);
 
+        // No change of Stokes basis is needed for depolarizing BSDFs
+        Mask rotate_mueller = true;
+        if constexpr (is_polarized_v<Spectrum>)
+            rotate_mueller = !has_flag(flags, BSDFFlags::Depolarizing);
+
         if (dr::any_or<true>(sample_emitter)) {
+            // Take all samples first, so that their shadow rays are traced together
+            std::vector<Point2f> samples(m_emitter_samples);
+            for (size_t i = 0; i < m_emitter_samples; ++i)
+                samples[i] = sampler->next_2d(sample_emitter);
+
+            std::vector<DirectionSample3f> emitter_ds(m_emitter_samples);
+            std::vector<Spectrum> emitter_vals(m_emitter_samples);
+            scene->sample_emitter_directions(si, samples.data(), m_emitter_samples,
+                                             emitter_ds.data(), emitter_vals.data(),
+                                             true, sample_emitter);
+
             for (size_t i = 0; i < m_emitter_samples; ++i) {
-                Mask active_e = sample_emitter;
-                DirectionSample3f ds;
-                Spectrum emitter_val;
-                std::tie(ds, emitter_val) = scene->sample_emitter_direction(
-                    si, sampler->next_2d(active_e), true, active_e);
-                active_e &= ds.pdf != 0.f;
+                const DirectionSample3f &ds = emitter_ds[i];
+                const Spectrum &emitter_val = emitter_vals[i];
+                Mask active_e = sample_emitter && ds.pdf != 0.f;
                 if (dr::none_or<false>(active_e))
                     continue;
 
@@ -161,7 +174,9 @@ public:
                 /* Determine BSDF value and probability of having sampled
                    that same direction using BSDF sampling. */
                 auto [bsdf_val, bsdf_pdf] = bsdf->eval_pdf(ctx, si, wo, active_e);
-                bsdf_val = si.to_world_mueller(bsdf_val, -wo, si.wi);
+                if (dr::any_or<true>(rotate_mueller))
+                    dr::masked(bsdf_val, rotate_mueller) =
+                        si.to_world_mueller(bsdf_val, -wo, si.wi);
 
                 Float mis = dr::select(ds.delta, Float(1.f), mis_weight(
                     ds.pdf * m_frac_lum, bsdf_pdf * m_frac_bsdf) * m_weight_lum);
@@ -174,7 +189,9 @@ public:
         for (size_t i = 0; i < m_bsdf_samples; ++i) {
             auto [bs, bsdf_val] = bsdf->sample(ctx, si, sampler->next_1d(active),
                                                sampler->next_2d(active), active);
-            bsdf_val = si.to_world_mueller(bsdf_val, -bs.wo, si.wi);
+            if (dr::any_or<true>(rotate_mueller))
+                dr::masked(bsdf_val, rotate_mueller) =
+                    si.to_world_mueller(bsdf_val, -bs.wo, si.wi);
 
             Mask active_b = active && dr::any(unpolarized_spectrum(bsdf_val) != 0.f);
 
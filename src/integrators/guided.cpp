@@ -0,0 +1,642 @@
+#include <mitsuba/core/atomic.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/integrator.h>
+#include <mitsuba/render/records.h>
+#include <mitsuba/render/sampler.h>
+#include <mitsuba/render/sensor.h>
+#include <drjit/dynamic.h>
+#include <nanothread/nanothread.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _integrator-guided:
+
+Guided path tracer (:monosp:`guided`)
+-------------------------------------
+
+.. pluginparameters::
+
+ * - max_depth
+   - |int|
+   - Specifies the longest path depth in the generated output image (where -1
+     corresponds to :math:`\infty`). A value of 1 will only render directly
+     visible light sources. 2 will lead to single-bounce (direct-only)
+     illumination, and so on. (Default: -1)
+
+ * - rr_depth
+   - |int|
+   - Specifies the path depth, at which the implementation will begin to use
+     the *russian roulette* path termination criterion. (Default: 5)
+
+ * - hide_emitters
+   - |bool|
+   - Hide directly visible emitters. (Default: no, i.e. |false|)
+
+ * - training_passes
+   - |int|
+   - Number of training passes rendered before the final image. (Default: 5)
+
+ * - training_spp
+   - |int|
+   - Number of samples per pixel of the first training pass. Every subsequent
+     pass doubles this number. (Default: 4)
+
+ * - spatial_resolution
+   - |int|
+   - Resolution of the grid over the scene bounds that stores the directional
+     distributions. (Default: 16)
+
+ * - bsdf_sampling_fraction
+   - |float|
+   - Probability of sampling the BSDF instead of the learned distribution at
+     guided vertices. (Default: 0.5)
+
+This integrator extends the :ref:`path tracer <integrator-path>` with *path
+guiding*: it learns an approximation of the incident radiance in the scene
+while rendering, and uses it to sample directions at the vertices of the
+paths. This significantly reduces the noise in scenes where most of the light
+arrives indirectly, e.g. interiors lit through small windows or doors, where
+BSDF sampling and emitter sampling both fail to find the important paths.
+
+The learned distributions are piecewise constant over 512 equal-area bins of
+the sphere of directions, and stored per cell of a regular grid over the
+scene bounds, in the spirit of "Practical Path Guiding" by Müller et al.
+Before the final image, the integrator renders :paramtype:`training_passes`
+passes with a doubling sample count. During these passes, every path records
+the radiance that reaches each of its first vertices, and the distributions
+are rebuilt from these estimates after every pass. The training images are
+discarded, and the final image is rendered with the requested sample count.
+
+At vertices with a smooth BSDF, directions are sampled from a mixture of the
+BSDF and the learned distribution, whose density is used for multiple
+importance sampling with emitter sampling. The estimate therefore remains
+unbiased, regardless of the quality of the learned distributions.
+
+.. note:: This integrator does not handle participating media, and is not
+   available in polarized variants.
+
+.. tabs::
+    .. code-tab::  xml
+        :name: guided-integrator
+
+        <integrator type="guided">
+            <integer name="max_depth" value="8"/>
+            <integer name="training_passes" value="6"/>
+        </integrator>
+
+    .. code-tab:: python
+
+        'type': 'guided',
+        'max_depth': 8,
+        'training_passes': 6
+
+ */
+
+template <typename Float, typename Spectrum>
+class GuidedPathIntegrator : public MonteCarloIntegrator<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters,
+                   should_stop, m_progressive, m_checkpoint_path)
+    MI_IMPORT_TYPES(Scene, Sensor, Sampler, Medium, Emitter, EmitterPtr, BSDF, BSDFPtr)
+
+    using FloatStorage = DynamicBuffer<Float>;
+
+    /// Directional bins along cos(theta) and phi (equal-area mapping)
+    static constexpr uint32_t BinsTheta = 16, BinsPhi = 32,
+                              Bins = BinsTheta * BinsPhi;
+
+    /// Number of vertices per path whose incident radiance is recorded
+    static constexpr size_t RecordDepth = 6;
+
+    GuidedPathIntegrator(const Properties &props) : Base(props) {
+        if constexpr (is_polarized_v<Spectrum>)
+            Throw("The guided path tracer is not available in polarized variants!");
+
+        int training_passes = props.get<int>("training_passes", 5),
+            training_spp = props.get<int>("training_spp", 4),
+            spatial_resolution = props.get<int>("spatial_resolution", 16);
+        if (training_passes < 0)
+            Throw("\"training_passes\" must be non-negative!");
+        if (training_spp <= 0)
+            Throw("\"training_spp\" must be positive!");
+        if (spatial_resolution <= 0)
+            Throw("\"spatial_resolution\" must be positive!");
+        m_training_passes = (uint32_t) training_passes;
+        m_training_spp = (uint32_t) training_spp;
+        m_spatial_resolution = (uint32_t) spatial_resolution;
+
+        m_bsdf_fraction = props.get<ScalarFloat>("bsdf_sampling_fraction", .5f);
+        if (m_bsdf_fraction <= 0.f || m_bsdf_fraction > 1.f)
+            Throw("\"bsdf_sampling_fraction\" must be in the interval (0, 1]!");
+    }
+
+    using Base::render;
+
+    TensorXf render(Scene *scene, Sensor *sensor, uint32_t seed, uint32_t spp,
+                    bool develop, bool evaluate) override {
+        Sampler *sampler = sensor->sampler();
+        uint32_t final_spp = spp ? spp : sampler->sample_count();
+
+        reset_guide(scene);
+
+        // The training passes are regular, non-progressive renderings
+        bool progressive = m_progressive;
+        fs::path checkpoint_path = m_checkpoint_path;
+        m_progressive = false;
+        m_checkpoint_path.clear();
+
+        uint32_t training_spp = m_training_spp;
+        for (uint32_t i = 0; i < m_training_passes; ++i) {
+            reset_training();
+            m_recording = true;
+            Base::render(scene, sensor, sample_tea_32(seed, i + 1).first,
+                         training_spp, false, true);
+            m_recording = false;
+            if (should_stop())
+                break;
+
+            update_guide();
+            Log(Info, "Path guiding: training pass %u/%u completed (%u sample%s "
+                "per pixel).", i + 1, m_training_passes, training_spp,
+                training_spp == 1 ? "" : "s");
+            training_spp *= 2;
+        }
+
+        m_progressive = progressive;
+        m_checkpoint_path = checkpoint_path;
+        m_train = FloatStorage();
+        m_train_host.reset();
+
+        return Base::render(scene, sensor, seed, final_spp, develop, evaluate);
+    }
+
+    std::pair<Spectrum, Bool> sample(const Scene *scene,
+                                     Sampler *sampler,
+                                     const RayDifferential3f &ray_,
+                                     const Medium * /* medium */,
+                                     Float * /* aovs */,
+                                     Bool active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
+
+        if (unlikely(m_max_depth == 0))
+            return { 0.f, false };
+
+        using RecordIndex    = dr::Array<UInt32, RecordDepth>;
+        using RecordFloat    = dr::Array<Float, RecordDepth>;
+        using RecordMask     = dr::Array<Mask, RecordDepth>;
+        using RecordSpectrum = dr::Array<UnpolarizedSpectrum, RecordDepth>;
+
+        // If m_hide_emitters == false, the environment emitter will be visible
+        Mask valid_ray = !m_hide_emitters && (scene->environment() != nullptr);
+        BSDFContext bsdf_ctx;
+        bool guide = m_guide_ready, recording = m_recording;
+
+        struct LoopState {
+            Ray3f ray;
+            Spectrum throughput;
+            Spectrum result;
+            Float eta;
+            UInt32 depth;
+            Mask valid_ray;
+            Interaction3f prev_si;
+            Float prev_bsdf_pdf;
+            Bool prev_bsdf_delta;
+            Bool active;
+            Sampler* sampler;
+
+            /* Vertices of the path whose incident radiance is recorded: bin of
+               the sampled direction, its density, the throughput after the
+               vertex, and the accumulated radiance */
+            UInt32 rec_count;
+            RecordIndex rec_index;
+            RecordFloat rec_pdf, rec_radiance;
+            RecordSpectrum rec_beta;
+            RecordMask rec_valid;
+
+            DRJIT_STRUCT(LoopState, ray, throughput, result, eta, depth,
+                valid_ray, prev_si, prev_bsdf_pdf, prev_bsdf_delta,
+                active, sampler, rec_count, rec_index, rec_pdf, rec_radiance,
+                rec_beta, rec_valid)
+        } ls = {
+            Ray3f(ray_),
+            Spectrum(1.f),
+            Spectrum(0.f),
+            Float(1.f),
+            UInt32(0),
+            valid_ray,
+            dr::zeros<Interaction3f>(),
+            Float(1.f),
+            Bool(true),
+            active,
+            sampler,
+            UInt32(0),
+            dr::zeros<RecordIndex>(),
+            dr::zeros<RecordFloat>(),
+            dr::zeros<RecordFloat>(),
+            dr::zeros<RecordSpectrum>(),
+            dr::zeros<RecordMask>()
+        };
+
+        /* Add a contribution to the radiance incident at the recorded vertices.
+           The vertex whose sampled direction led to the contribution receives
+           'value_last' instead of 'value' (see the emitter hits below) */
+        auto record = [](LoopState &ls, const Spectrum &value,
+                         const Spectrum &value_last) {
+            for (size_t j = 0; j < RecordDepth; ++j) {
+                Mask used = (uint32_t) j < ls.rec_count,
+                     last = (uint32_t) j + 1 == ls.rec_count;
+                UnpolarizedSpectrum v = unpolarized_spectrum(
+                    dr::select(last, value_last, value));
+                UnpolarizedSpectrum ratio = dr::select(
+                    ls.rec_beta[j] > 0.f, v / ls.rec_beta[j], 0.f);
+                dr::masked(ls.rec_radiance[j], used) += dr::mean(ratio);
+            }
+        };
+
+        auto body = [this, scene, bsdf_ctx, guide, recording, &record,
+                     &ray_](LoopState& ls) {
+            SurfaceInteraction3f si =
+                scene->ray_intersect(ls.ray,
+                                     /* ray_flags = */ +RayFlags::All,
+                                     /* coherent = */ ls.depth == 0u);
+
+            // Texture footprint of camera rays
+            if (ray_.has_differentials) {
+                Mask primary = ls.depth == 0u;
+                if (dr::any_or<true>(primary)) {
+                    si.compute_uv_partials(ray_);
+                    dr::masked(si.duv_dx, !primary) = 0.f;
+                    dr::masked(si.duv_dy, !primary) = 0.f;
+                }
+            }
+
+            // ---------------------- Direct emission ----------------------
+
+            if (dr::any_or<true>(si.emitter(scene) != nullptr)) {
+                DirectionSample3f ds(scene, si, ls.prev_si);
+                Float em_pdf = 0.f;
+
+                if (dr::any_or<true>(!ls.prev_bsdf_delta))
+                    em_pdf = scene->pdf_emitter_direction(ls.prev_si, ds,
+                                                          !ls.prev_bsdf_delta);
+
+                // Compute MIS weight for emitter sample from previous bounce
+                Float mis_bsdf = mis_weight(ls.prev_bsdf_pdf, em_pdf);
+
+                Spectrum emitted = ls.throughput *
+                    ds.emitter->eval(si, ls.prev_bsdf_pdf > 0.f);
+                ls.result += emitted * mis_bsdf;
+
+                /* The emitter sampling strategy of the previous vertex only
+                   covers directions other than its sampled one, which thus
+                   records the emitted radiance without MIS weight */
+                if (recording)
+                    record(ls, emitted * mis_bsdf, emitted);
+            }
+
+            // Continue tracing the path at this point?
+            Bool active_next = (ls.depth + 1 < m_max_depth) && si.is_valid();
+
+            if (dr::none_or<false>(active_next)) {
+                ls.active = active_next;
+                return; // early exit for scalar mode
+            }
+
+            BSDFPtr bsdf = si.bsdf(ls.ray);
+            Mask smooth = has_flag(bsdf->flags(), BSDFFlags::Smooth);
+
+            // Sample from the learned distribution at this vertex?
+            Mask guided = guide && active_next && smooth;
+            UInt32 cell = cell_index(si.p);
+
+            // ---------------------- Emitter sampling ----------------------
+
+            Mask active_em = active_next && smooth;
+
+            DirectionSample3f ds = dr::zeros<DirectionSample3f>();
+            Spectrum em_weight = dr::zeros<Spectrum>();
+            Vector3f wo = dr::zeros<Vector3f>();
+
+            if (dr::any_or<true>(active_em)) {
+                std::tie(ds, em_weight) = scene->sample_emitter_direction(
+                    si, ls.sampler->next_2d(), true, active_em);
+                active_em &= (ds.pdf != 0.f);
+                wo = si.to_local(ds.d);
+            }
+
+            // ------ Evaluate BSDF * cos(theta) and sample direction -------
+
+            Float sample_1 = ls.sampler->next_1d();
+            Point2f sample_2 = ls.sampler->next_2d();
+
+            auto [bsdf_val, bsdf_pdf, bsdf_sample, bsdf_weight]
+                = bsdf->eval_pdf_sample(bsdf_ctx, si, wo, sample_1, sample_2);
+
+            // --------------- Emitter sampling contribution ----------------
+
+            if (dr::any_or<true>(active_em)) {
+                // The BSDF direction was drawn from the mixture at guided vertices
+                Float mix_pdf = bsdf_pdf;
+                if (dr::any_or<true>(guided && active_em))
+                    mix_pdf = dr::select(
+                        guided,
+                        mixture_pdf(bsdf_pdf, guide_pdf(cell, ds.d, guided && active_em)),
+                        bsdf_pdf);
+
+                Float mis_em =
+                    dr::select(ds.delta, 1.f, mis_weight(ds.pdf, mix_pdf));
+
+                Spectrum contrib = ls.throughput * bsdf_val * em_weight * mis_em;
+                dr::masked(ls.result, active_em) += contrib;
+                if (recording)
+                    record(ls, dr::select(active_em, contrib, 0.f),
+                           dr::select(active_em, contrib, 0.f));
+            }
+
+            // ---------------------- Direction sampling ----------------------
+
+            Vector3f wo_world = si.to_world(bsdf_sample.wo);
+            Float wo_pdf = bsdf_sample.pdf;
+            Mask wo_delta = has_flag(bsdf_sample.sampled_type, BSDFFlags::Delta);
+
+            if (dr::any_or<true>(guided)) {
+                Float sample_mix = ls.sampler->next_1d(guided),
+                      sample_bin = ls.sampler->next_1d(guided);
+                Point2f sample_dir = ls.sampler->next_2d(guided);
+
+                Mask use_guide = guided && sample_mix >= m_bsdf_fraction;
+                Vector3f wo_guide = sample_guide(cell, sample_bin, sample_dir, use_guide);
+                auto [guide_val, guide_bsdf_pdf] =
+                    bsdf->eval_pdf(bsdf_ctx, si, si.to_local(wo_guide), use_guide);
+
+                wo_world = dr::select(use_guide, wo_guide, wo_world);
+                Float f_pdf = dr::select(use_guide, guide_bsdf_pdf, bsdf_sample.pdf);
+                Spectrum f = dr::select(use_guide, guide_val,
+                                        bsdf_weight * bsdf_sample.pdf);
+
+                // Density of the direction under the mixture
+                Mask mixed = guided && (use_guide || !wo_delta);
+                Float mix_pdf = mixture_pdf(f_pdf, guide_pdf(cell, wo_world, mixed));
+
+                dr::masked(bsdf_weight, mixed) =
+                    dr::select(mix_pdf > 0.f, f / mix_pdf, 0.f);
+                dr::masked(wo_pdf, mixed) = mix_pdf;
+
+                // Delta lobes are only reachable through BSDF sampling
+                Mask delta = guided && !use_guide && wo_delta;
+                dr::masked(bsdf_weight, delta) = bsdf_weight / m_bsdf_fraction;
+                dr::masked(wo_pdf, delta) = bsdf_sample.pdf * m_bsdf_fraction;
+
+                dr::masked(bsdf_sample.sampled_type, use_guide) =
+                    +BSDFFlags::Smooth;
+                wo_delta &= !use_guide;
+            }
+
+            ls.ray = si.spawn_ray(wo_world);
+
+            // ------ Update loop variables based on current interaction ------
+
+            ls.throughput *= bsdf_weight;
+            ls.eta *= dr::select(wo_delta, bsdf_sample.eta, 1.f);
+            ls.valid_ray |= ls.active && si.is_valid() &&
+                         !has_flag(bsdf_sample.sampled_type, BSDFFlags::Null);
+
+            if (recording) {
+                for (size_t j = 0; j < RecordDepth; ++j) {
+                    Mask slot = active_next && ls.rec_count == (uint32_t) j;
+                    dr::masked(ls.rec_index[j], slot) =
+                        cell * Bins + direction_bin(wo_world);
+                    dr::masked(ls.rec_pdf[j], slot) = wo_pdf;
+                    dr::masked(ls.rec_beta[j], slot) =
+                        unpolarized_spectrum(ls.throughput);
+                    dr::masked(ls.rec_radiance[j], slot) = 0.f;
+                    dr::masked(ls.rec_valid[j], slot) = smooth && !wo_delta;
+                }
+                dr::masked(ls.rec_count, active_next) += 1;
+            }
+
+            // Information about the current vertex needed by the next iteration
+            ls.prev_si = si;
+            ls.prev_bsdf_pdf = wo_pdf;
+            ls.prev_bsdf_delta = wo_delta;
+
+            // -------------------- Stopping criterion ---------------------
+
+            dr::masked(ls.depth, si.is_valid()) += 1;
+
+            Float throughput_max = dr::max(unpolarized_spectrum(ls.throughput));
+
+            Float rr_prob = dr::minimum(throughput_max * dr::square(ls.eta), .95f);
+            Mask rr_active = ls.depth >= m_rr_depth,
+                 rr_continue = ls.sampler->next_1d() < rr_prob;
+
+            ls.throughput[rr_active] *= dr::rcp(rr_prob);
+
+            ls.active = active_next && (!rr_active || rr_continue) &&
+                     (throughput_max != 0.f);
+        };
+
+        dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
+            [](const LoopState& ls) { return ls.active; }, body);
+
+        // Splat the radiance estimates of the recorded vertices
+        if (recording) {
+            for (size_t j = 0; j < RecordDepth; ++j) {
+                Mask valid = active && ls.rec_valid[j] &&
+                             (uint32_t) j < ls.rec_count &&
+                             ls.rec_pdf[j] > 0.f && ls.rec_radiance[j] > 0.f;
+                Float value = ls.rec_radiance[j] / ls.rec_pdf[j];
+
+                if constexpr (dr::is_jit_v<Float>) {
+                    dr::scatter_reduce(ReduceOp::Add, m_train, value,
+                                       ls.rec_index[j], valid);
+                } else {
+                    if (valid && dr::isfinite(value))
+                        m_train_host[ls.rec_index[j]] += value;
+                }
+            }
+        }
+
+        return {
+            /* spec  = */ dr::select(ls.valid_ray, ls.result, 0.f),
+            /* valid = */ ls.valid_ray
+        };
+    }
+
+    //! @}
+    // =============================================================
+
+    std::string to_string() const override {
+        return tfm::format("GuidedPathIntegrator[\n"
+            "  max_depth = %u,\n"
+            "  rr_depth = %u,\n"
+            "  training_passes = %u,\n"
+            "  training_spp = %u,\n"
+            "  spatial_resolution = %u,\n"
+            "  bsdf_sampling_fraction = %f\n"
+            "]", m_max_depth, m_rr_depth, m_training_passes, m_training_spp,
+            m_spatial_resolution, m_bsdf_fraction);
+    }
+
+    MI_DECLARE_CLASS()
+
+protected:
+    /// Compute a multiple importance sampling weight using the power heuristic
+    Float mis_weight(Float pdf_a, Float pdf_b) const {
+        pdf_a *= pdf_a;
+        pdf_b *= pdf_b;
+        Float w = pdf_a / (pdf_a + pdf_b);
+        return dr::detach<true>(dr::select(dr::isfinite(w), w, 0.f));
+    }
+
+    /// Density of the mixture of BSDF and guided sampling
+    MI_INLINE Float mixture_pdf(const Float &bsdf_pdf, const Float &guide_pdf) const {
+        return dr::lerp(guide_pdf, bsdf_pdf, m_bsdf_fraction);
+    }
+
+    /// Index of the grid cell containing \c p
+    MI_INLINE UInt32 cell_index(const Point3f &p) const {
+        Vector3i cell = dr::clip(
+            dr::floor2int<Vector3i>((p - m_bbox.min) * m_cell_scale), 0,
+            (int32_t) m_spatial_resolution - 1);
+        return UInt32((cell.z() * (int32_t) m_spatial_resolution + cell.y()) *
+                      (int32_t) m_spatial_resolution + cell.x());
+    }
+
+    /// Directional bin of the (world space) direction \c d
+    MI_INLINE UInt32 direction_bin(const Vector3f &d) const {
+        Float u = dr::fmadd(d.z(), .5f, .5f),
+              v = dr::atan2(d.y(), d.x()) * dr::InvTwoPi<Float>;
+        v = dr::select(v < 0.f, v + 1.f, v);
+
+        UInt32 iu = dr::minimum(UInt32(dr::maximum(u, 0.f) * BinsTheta), BinsTheta - 1),
+               iv = dr::minimum(UInt32(dr::maximum(v, 0.f) * BinsPhi), BinsPhi - 1);
+        return iu * BinsPhi + iv;
+    }
+
+    /// Density of the learned distribution of the cell \c cell
+    MI_INLINE Float guide_pdf(const UInt32 &cell, const Vector3f &d, Mask active) const {
+        return dr::gather<Float>(m_pdf, cell * Bins + direction_bin(d), active);
+    }
+
+    /// Sample a direction from the learned distribution of the cell \c cell
+    Vector3f sample_guide(const UInt32 &cell, const Float &sample_bin,
+                          const Point2f &sample_dir, Mask active) const {
+        // Binary search over the cumulative distribution of the cell
+        UInt32 base = cell * Bins, bin = 0;
+        for (uint32_t step = Bins / 2; step > 0; step /= 2) {
+            Float cdf = dr::gather<Float>(m_cdf, base + bin + (step - 1), active);
+            dr::masked(bin, cdf <= sample_bin) += step;
+        }
+
+        UInt32 iu = bin / BinsPhi, iv = bin % BinsPhi;
+        Float cos_theta = dr::fmadd(Float(iu) + sample_dir.x(), 2.f / BinsTheta, -1.f),
+              sin_theta = dr::safe_sqrt(dr::fnmadd(cos_theta, cos_theta, 1.f)),
+              phi = (Float(iv) + sample_dir.y()) * (dr::TwoPi<Float> / BinsPhi);
+
+        auto [sin_phi, cos_phi] = dr::sincos(phi);
+        return { cos_phi * sin_theta, sin_phi * sin_theta, cos_theta };
+    }
+
+    size_t cell_count() const {
+        return (size_t) m_spatial_resolution * m_spatial_resolution *
+               m_spatial_resolution;
+    }
+
+    /// Set up the grid over the scene with uniform distributions
+    void reset_guide(const Scene *scene) {
+        m_bbox = scene->bbox();
+        ScalarVector3f extents = m_bbox.extents();
+        m_cell_scale = dr::select(extents > 0.f,
+                                  ScalarFloat(m_spatial_resolution) / extents, 0.f);
+
+        size_t size = cell_count() * Bins;
+        m_pdf = dr::full<FloatStorage>(dr::InvFourPi<ScalarFloat>, size);
+        m_cdf = dr::zeros<FloatStorage>(size);
+        m_guide_ready = false;
+    }
+
+    /// Clear the statistics recorded during a training pass
+    void reset_training() {
+        size_t size = cell_count() * Bins;
+        if constexpr (dr::is_jit_v<Float>)
+            m_train = dr::zeros<FloatStorage>(size);
+        else
+            m_train_host.reset(new AtomicFloat<ScalarFloat>[size]);
+    }
+
+    /// Rebuild the learned distributions from the recorded statistics
+    void update_guide() {
+        size_t cells = cell_count(), size = cells * Bins;
+        std::vector<ScalarFloat> train(size), pdf(size), cdf(size);
+
+        if constexpr (dr::is_jit_v<Float>) {
+            auto &&host = dr::migrate(m_train, AllocType::Host);
+            dr::sync_thread();
+            std::copy(host.data(), host.data() + size, train.data());
+        } else {
+            for (size_t i = 0; i < size; ++i)
+                train[i] = m_train_host[i];
+        }
+
+        /* Blend the normalized histograms with a small uniform component to
+           limit the effect of noisy estimates in cells with little data */
+        const ScalarFloat uniform_fraction = .1f;
+
+        dr::parallel_for(
+            dr::blocked_range<size_t>(0, cells, 64),
+            [&](const dr::blocked_range<size_t> &range) {
+                for (size_t c = range.begin(); c != range.end(); ++c) {
+                    const ScalarFloat *t = train.data() + c * Bins;
+                    double sum = 0.0;
+                    for (uint32_t b = 0; b < Bins; ++b)
+                        sum += t[b];
+
+                    double accum = 0.0;
+                    for (uint32_t b = 0; b < Bins; ++b) {
+                        double p = 1.0 / Bins;
+                        if (sum > 0.0)
+                            p = (1.0 - uniform_fraction) * t[b] / sum +
+                                uniform_fraction / Bins;
+                        accum += p;
+                        pdf[c * Bins + b] = (ScalarFloat) (p * Bins * dr::InvFourPi<double>);
+                        cdf[c * Bins + b] = (ScalarFloat) accum;
+                    }
+                    cdf[c * Bins + Bins - 1] = 1.f;
+                }
+            }
+        );
+
+        m_pdf = dr::load<FloatStorage>(pdf.data(), size);
+        m_cdf = dr::load<FloatStorage>(cdf.data(), size);
+        m_guide_ready = true;
+    }
+
+private:
+    uint32_t m_training_passes;
+    uint32_t m_training_spp;
+    uint32_t m_spatial_resolution;
+    ScalarFloat m_bsdf_fraction;
+
+    /// Grid over the scene bounds
+    ScalarBoundingBox3f m_bbox;
+    ScalarVector3f m_cell_scale;
+
+    /// Per-bin density and cumulative distribution of every cell
+    FloatStorage m_pdf, m_cdf;
+    bool m_guide_ready = false;
+
+    /// Statistics recorded during the current training pass
+    bool m_recording = false;
+    mutable FloatStorage m_train;
+    std::unique_ptr<AtomicFloat<ScalarFloat>[]> m_train_host;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(GuidedPathIntegrator, MonteCarloIntegrator)
+MI_EXPORT_PLUGIN(GuidedPathIntegrator, "Guided path tracer integrator");
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,949 @@
+#include <mitsuba/core/math.h>
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/random.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/core/warp.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/film.h>
+#include <mitsuba/render/integrator.h>
+#include <mitsuba/render/records.h>
+#include <mitsuba/render/sampler.h>
+#include <mitsuba/render/sensor.h>
+#include <nanothread/nanothread.h>
+#include <unordered_map>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _integrator-irrcache:
+
+Irradiance cache (:monosp:`irrcache`)
+-------------------------------------
+
+.. pluginparameters::
+
+ * - max_depth
+   - |int|
+   - Specifies the longest path depth in the generated output image (where -1
+     corresponds to :math:`\infty`). A value of 1 will only render directly
+     visible light sources. 2 will lead to single-bounce (direct-only)
+     illumination, and so on. (Default: -1)
+
+ * - rr_depth
+   - |int|
+   - Specifies the path depth, at which the implementation will begin to use
+     the *russian roulette* path termination criterion. (Default: 5)
+
+ * - hide_emitters
+   - |bool|
+   - Hide directly visible emitters. (Default: no, i.e. |false|)
+
+ * - record_spacing
+   - |float|
+   - Edge length of the cells of the coarsest level of the cache. If not
+     specified, 2% of the scene's bounding box diagonal are used.
+
+ * - max_levels
+   - |int|
+   - Number of levels of the cache. Every level halves the size of the cells
+     of the previous one. (Default: 4, at most 8)
+
+ * - error_threshold
+   - |float|
+   - Relative difference between the irradiance of neighboring records above
+     which a cell is split into the cells of the next level. (Default: 0.1)
+
+ * - record_samples
+   - |int|
+   - Number of hemispherical samples used to compute the irradiance of every
+     record. (Default: 256)
+
+This integrator accelerates the rendering of scenes in which the indirect
+illumination mostly arrives through diffuse interreflection, such as
+architectural interiors. It computes the irradiance at a set of *records*
+before rendering, and uses them instead of tracing the remainder of the paths
+once these reach a diffuse surface after the first bounce.
+
+The records are placed where they are needed: a camera ray is traced through
+every pixel, and the diffuse surfaces that are found after sampling the BSDF
+of the first intersection are candidate positions. The candidates are sorted
+into the cells of a hash grid over the scene, which are further separated by
+the dominant axis of their normal, and the first candidate of every cell
+becomes a record. The irradiance of each record is estimated from
+:paramtype:`record_samples` paths, combining emitter sampling and
+cosine-weighted hemisphere sampling. When the irradiance of a record differs
+from that of a neighboring cell by more than :paramtype:`error_threshold`,
+the cell is split into cells of half the size, which receive new records from
+the candidates they contain. This places many records where the illumination
+varies quickly (e.g. near shadow boundaries and corners), and few of them on
+smoothly lit walls.
+
+While rendering, the first intersection is shaded exactly like in the
+:ref:`path tracer <integrator-path>`. At the following diffuse intersections,
+the irradiance is interpolated between the records of the eight nearest cells
+of the finest level that covers the intersection, and multiplied by the
+diffuse reflectance of the surface. The remaining intersections (e.g. glossy
+surfaces, or regions without records) continue the path as usual.
+
+The interpolated irradiance is biased, which manifests as blurred indirect
+illumination. Decreasing :paramtype:`record_spacing` or
+:paramtype:`error_threshold`, or increasing :paramtype:`max_levels`, reduces
+this bias. The records are computed in parallel using the thread pool in
+scalar variants, and as a single wavefront in JIT variants. The cache is
+rebuilt at the beginning of every render job.
+
+.. note:: This integrator does not handle participating media, and is only
+   available in RGB and monochromatic variants.
+
+.. tabs::
+    .. code-tab::  xml
+        :name: irrcache-integrator
+
+        <integrator type="irrcache">
+            <integer name="max_depth" value="8"/>
+            <float name="error_threshold" value="0.05"/>
+        </integrator>
+
+    .. code-tab:: python
+
+        'type': 'irrcache',
+        'max_depth': 8,
+        'error_threshold': 0.05
+
+ */
+
+template <typename Float, typename Spectrum>
+class IrradianceCacheIntegrator final : public MonteCarloIntegrator<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters)
+    MI_IMPORT_TYPES(Scene, Sensor, Film, Sampler, Medium, Emitter, EmitterPtr,
+                    BSDF, BSDFPtr)
+
+    using FloatStorage  = DynamicBuffer<Float>;
+    using UInt32Storage = DynamicBuffer<UInt32>;
+    using UInt64Storage = DynamicBuffer<UInt64>;
+
+    /// Number of color channels of the cached irradiance
+    static constexpr size_t Channels = dr::size_v<UnpolarizedSpectrum>;
+
+    /// Bits per cell coordinate in the keys of the hash table
+    static constexpr uint32_t CoordBits = 19;
+    static constexpr uint32_t MaxLevels = 8;
+
+    /// Maximum number of slots that are probed per lookup
+    static constexpr uint32_t MaxProbes = 8;
+
+    /// Marks cells that were split into the cells of the next level
+    static constexpr uint32_t RefinedBit = 0x80000000u;
+    static constexpr uint64_t EmptyKey = (uint64_t) -1;
+
+    IrradianceCacheIntegrator(const Properties &props) : Base(props) {
+        if constexpr (is_spectral_v<Spectrum> || is_polarized_v<Spectrum>)
+            Throw("The irradiance cache is only supported in RGB and "
+                  "monochromatic variants!");
+
+        m_record_spacing  = props.get<ScalarFloat>("record_spacing", 0.f);
+        m_error_threshold = props.get<ScalarFloat>("error_threshold", .1f);
+        int max_levels = props.get<int>("max_levels", 4),
+            record_samples = props.get<int>("record_samples", 256);
+
+        if (m_record_spacing < 0.f)
+            Throw("\"record_spacing\" must be positive!");
+        if (m_error_threshold <= 0.f)
+            Throw("\"error_threshold\" must be positive!");
+        if (max_levels <= 0 || max_levels > (int) MaxLevels)
+            Throw("\"max_levels\" must be in the range [1, %u]!", MaxLevels);
+        if (record_samples <= 0)
+            Throw("\"record_samples\" must be positive!");
+        m_max_levels = (uint32_t) max_levels;
+        m_record_samples = (uint32_t) record_samples;
+
+        Properties props_sampler("independent");
+        props_sampler.set_int("sample_count", 1);
+        m_sampler = PluginManager::instance()->create_object<Sampler>(props_sampler);
+    }
+
+    using Base::render;
+
+    TensorXf render(Scene *scene, Sensor *sensor, uint32_t seed, uint32_t spp,
+                    bool develop, bool evaluate) override {
+        build_cache(scene, sensor, seed);
+        return Base::render(scene, sensor, seed, spp, develop, evaluate);
+    }
+
+    std::pair<Spectrum, Bool> sample(const Scene *scene,
+                                     Sampler *sampler,
+                                     const RayDifferential3f &ray,
+                                     const Medium * /* medium */,
+                                     Float * /* aovs */,
+                                     Bool active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
+
+        if (unlikely(m_max_depth == 0))
+            return { 0.f, false };
+
+        // If m_hide_emitters == false, the environment emitter will be visible
+        Mask valid_ray = !m_hide_emitters && (scene->environment() != nullptr);
+
+        LoopState ls = {
+            Ray3f(ray),
+            Spectrum(1.f),
+            Spectrum(0.f),
+            Float(1.f),
+            UInt32(0),
+            valid_ray,
+            dr::zeros<Interaction3f>(),
+            Float(1.f),
+            Bool(true),
+            active,
+            sampler
+        };
+
+        ls = trace(scene, ls, m_record_count > 0, &ray);
+
+        return {
+            /* spec  = */ dr::select(ls.valid_ray, ls.result, 0.f),
+            /* valid = */ ls.valid_ray
+        };
+    }
+
+    std::string to_string() const override {
+        return tfm::format("IrradianceCacheIntegrator[\n"
+            "  max_depth = %u,\n"
+            "  rr_depth = %u,\n"
+            "  record_spacing = %f,\n"
+            "  max_levels = %u,\n"
+            "  error_threshold = %f,\n"
+            "  record_samples = %u,\n"
+            "  records = %zu\n"
+            "]", m_max_depth, m_rr_depth, m_record_spacing, m_max_levels,
+            m_error_threshold, m_record_samples, m_record_count);
+    }
+
+    MI_DECLARE_CLASS()
+
+protected:
+    /// State of the path tracing loop
+    struct LoopState {
+        Ray3f ray;
+        Spectrum throughput;
+        Spectrum result;
+        Float eta;
+        UInt32 depth;
+        Mask valid_ray;
+        Interaction3f prev_si;
+        Float prev_bsdf_pdf;
+        Bool prev_bsdf_delta;
+        Bool active;
+        Sampler* sampler;
+
+        DRJIT_STRUCT(LoopState, ray, throughput, result, eta, depth,
+            valid_ray, prev_si, prev_bsdf_pdf, prev_bsdf_delta, active,
+            sampler)
+    };
+
+    /**
+     * \brief Continue the paths of \c ls using emitter and BSDF sampling
+     *
+     * When \c use_cache is set, the paths end at the first diffuse
+     * intersection after the first bounce that is covered by the cache.
+     */
+    LoopState trace(const Scene *scene, LoopState ls, bool use_cache,
+                    const RayDifferential3f *ray_ = nullptr) const {
+        BSDFContext bsdf_ctx;
+
+        auto body = [this, scene, bsdf_ctx, use_cache, ray_](LoopState &ls) {
+            SurfaceInteraction3f si =
+                scene->ray_intersect(ls.ray,
+                                     /* ray_flags = */ +RayFlags::All,
+                                     /* coherent = */ ls.depth == 0u);
+
+            // Texture footprint of camera rays
+            if (ray_ && ray_->has_differentials) {
+                Mask primary = ls.depth == 0u;
+                if (dr::any_or<true>(primary)) {
+                    si.compute_uv_partials(*ray_);
+                    dr::masked(si.duv_dx, !primary) = 0.f;
+                    dr::masked(si.duv_dy, !primary) = 0.f;
+                }
+            }
+
+            // ---------------------- Direct emission ----------------------
+
+            if (dr::any_or<true>(si.emitter(scene) != nullptr)) {
+                DirectionSample3f ds(scene, si, ls.prev_si);
+                Float em_pdf = 0.f;
+
+                if (dr::any_or<true>(!ls.prev_bsdf_delta))
+                    em_pdf = scene->pdf_emitter_direction(ls.prev_si, ds,
+                                                          !ls.prev_bsdf_delta);
+
+                // Compute MIS weight for emitter sample from previous bounce
+                Float mis_bsdf = mis_weight(ls.prev_bsdf_pdf, em_pdf);
+
+                ls.result += ls.throughput *
+                    ds.emitter->eval(si, ls.prev_bsdf_pdf > 0.f) * mis_bsdf;
+            }
+
+            // Continue tracing the path at this point?
+            Bool active_next = (ls.depth + 1 < m_max_depth) && si.is_valid();
+
+            if (dr::none_or<false>(active_next)) {
+                ls.active = active_next;
+                return; // early exit for scalar mode
+            }
+
+            BSDFPtr bsdf = si.bsdf(ls.ray);
+
+            // ------------------ Irradiance cache lookup -------------------
+
+            if (use_cache) {
+                Mask query = active_next && ls.depth > 0u &&
+                             is_diffuse(bsdf->flags());
+
+                if (dr::any_or<true>(query)) {
+                    Normal3f n = dr::mulsign(si.n, -dr::dot(si.n, ls.ray.d));
+                    auto [irradiance, cached] = lookup(si.p, n, query);
+
+                    Spectrum albedo = bsdf->eval_diffuse_reflectance(si, cached);
+                    dr::masked(ls.result, cached) +=
+                        ls.throughput * albedo * irradiance * dr::InvPi<Float>;
+                    active_next &= !cached;
+                }
+
+                if (dr::none_or<false>(active_next)) {
+                    ls.active = active_next;
+                    return; // early exit for scalar mode
+                }
+            }
+
+            // ---------------------- Emitter sampling ----------------------
+
+            // Perform emitter sampling?
+            Mask active_em = active_next && has_flag(bsdf->flags(), BSDFFlags::Smooth);
+
+            DirectionSample3f ds = dr::zeros<DirectionSample3f>();
+            Spectrum em_weight = dr::zeros<Spectrum>();
+            Vector3f wo = dr::zeros<Vector3f>();
+
+            if (dr::any_or<true>(active_em)) {
+                // Sample the emitter
+                std::tie(ds, em_weight) = scene->sample_emitter_direction(
+                    si, ls.sampler->next_2d(), true, active_em);
+                active_em &= (ds.pdf != 0.f);
+
+                // Given the detached emitter sample, recompute its contribution
+                wo = si.to_local(ds.d);
+            }
+
+            // ------ Evaluate BSDF * cos(theta) and sample direction -------
+
+            Float sample_1 = ls.sampler->next_1d();
+            Point2f sample_2 = ls.sampler->next_2d();
+
+            auto [bsdf_val, bsdf_pdf, bsdf_sample, bsdf_weight]
+                = bsdf->eval_pdf_sample(bsdf_ctx, si, wo, sample_1, sample_2);
+
+            // --------------- Emitter sampling contribution ----------------
+
+            if (dr::any_or<true>(active_em)) {
+                // Compute the MIS weight
+                Float mis_em =
+                    dr::select(ds.delta, 1.f, mis_weight(ds.pdf, bsdf_pdf));
+
+                // Accumulate, being careful with polarization (see spec_fma)
+                dr::masked(ls.result, active_em) +=
+                    ls.throughput * bsdf_val * em_weight * mis_em;
+            }
+
+            // ---------------------- BSDF sampling ----------------------
+
+            ls.ray = si.spawn_ray(si.to_world(bsdf_sample.wo));
+
+            // ------ Update loop variables based on current interaction ------
+
+            ls.throughput *= bsdf_weight;
+            ls.eta *= bsdf_sample.eta;
+            ls.valid_ray |= ls.active && si.is_valid() &&
+                            !has_flag(bsdf_sample.sampled_type, BSDFFlags::Null);
+
+            // Information about the current vertex needed by the next iteration
+            ls.prev_si = si;
+            ls.prev_bsdf_pdf = bsdf_sample.pdf;
+            ls.prev_bsdf_delta = has_flag(bsdf_sample.sampled_type, BSDFFlags::Delta);
+
+            // -------------------- Stopping criterion ---------------------
+
+            dr::masked(ls.depth, si.is_valid()) += 1;
+
+            Float throughput_max = dr::max(unpolarized_spectrum(ls.throughput));
+
+            Float rr_prob = dr::minimum(throughput_max * dr::square(ls.eta), .95f);
+            Mask rr_active = ls.depth >= m_rr_depth,
+                 rr_continue = ls.sampler->next_1d() < rr_prob;
+
+            ls.throughput[rr_active] *= dr::rcp(rr_prob);
+
+            ls.active = active_next && (!rr_active || rr_continue) &&
+                        (throughput_max != 0.f);
+        };
+
+        dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
+            [](const LoopState &ls) { return ls.active; }, body,
+            "Irradiance cache");
+
+        return ls;
+    }
+
+    /**
+     * \brief Estimate the irradiance at the position \c p with normal \c n
+     * using a single sample
+     *
+     * This is the radiance reflected by a white diffuse surface scaled by
+     * pi. Emitter sampling is combined with cosine-weighted hemisphere
+     * sampling, that starts a path whose first intersection counts as the
+     * third vertex of the camera paths.
+     */
+    UnpolarizedSpectrum sample_irradiance(const Scene *scene, Sampler *sampler,
+                                          const Point3f &p, const Normal3f &n,
+                                          const Float &time, Mask active) const {
+        if (m_max_depth <= 2)
+            return 0.f;
+
+        Interaction3f it(Float(0.f), time, dr::zeros<Wavelength>(dr::width(p)),
+                         p, n);
+
+        // ---------------------- Emitter sampling ----------------------
+
+        auto [ds, em_weight] = scene->sample_emitter_direction(
+            it, sampler->next_2d(active), true, active);
+        Float cos_em = dr::dot(n, ds.d);
+        Mask active_em = active && (ds.pdf != 0.f) && (cos_em > 0.f);
+        Float mis_em = dr::select(
+            ds.delta, 1.f, mis_weight(ds.pdf, cos_em * dr::InvPi<Float>));
+        Spectrum result = dr::select(active_em, em_weight * cos_em * mis_em, 0.f);
+
+        // ----------------- Cosine-weighted sampling ------------------
+
+        Vector3f wo = warp::square_to_cosine_hemisphere(sampler->next_2d(active));
+        LoopState ls = {
+            it.spawn_ray(Frame3f(n).to_world(wo)),
+            Spectrum(dr::Pi<ScalarFloat>),
+            result,
+            Float(1.f),
+            UInt32(2),
+            Mask(true),
+            it,
+            warp::square_to_cosine_hemisphere_pdf(wo),
+            Bool(false),
+            active,
+            sampler
+        };
+
+        ls = trace(scene, ls, false);
+        return unpolarized_spectrum(ls.result);
+    }
+
+    /// Compute a multiple importance sampling weight using the power heuristic
+    Float mis_weight(Float pdf_a, Float pdf_b) const {
+        pdf_a *= pdf_a;
+        pdf_b *= pdf_b;
+        Float w = pdf_a / (pdf_a + pdf_b);
+        return dr::detach<true>(dr::select(dr::isfinite(w), w, 0.f));
+    }
+
+    /// Is \c flags the set of flags of a purely diffuse reflector?
+    template <typename UInt32_>
+    static auto is_diffuse(const UInt32_ &flags) {
+        return has_flag(flags, BSDFFlags::DiffuseReflection) &&
+               !has_flag(flags, BSDFFlags::Glossy) &&
+               !has_flag(flags, BSDFFlags::Delta) &&
+               !has_flag(flags, BSDFFlags::Transmission) &&
+               !has_flag(flags, BSDFFlags::Null);
+    }
+
+    // =============================================================
+    //! @{ \name Hash grid
+    // =============================================================
+
+    /// Index of the dominant axis of \c n and its sign (0..5)
+    template <typename Normal>
+    static auto normal_bin(const Normal &n) {
+        using Value = dr::value_t<Normal>;
+        using UInt  = dr::uint32_array_t<Value>;
+        using Mask_ = dr::mask_t<Value>;
+
+        Normal a = dr::abs(n);
+        Mask_ x_max = a.x() >= a.y() && a.x() >= a.z(),
+              y_max = !x_max && a.y() >= a.z();
+        Value c = dr::select(x_max, n.x(), dr::select(y_max, n.y(), n.z()));
+        UInt axis = dr::select(x_max, UInt(0), dr::select(y_max, UInt(1), UInt(2)));
+        return axis * 2u + dr::select(c < 0.f, UInt(1), UInt(0));
+    }
+
+    /// Integer coordinates of the cell containing \c p (cell size: 1 / \c scale)
+    template <typename Point, typename Value>
+    auto cell_coords(const Point &p, const Value &scale) const {
+        using Int3 = Vector<dr::int32_array_t<dr::value_t<Point>>, 3>;
+        return dr::floor2int<Int3>((p - m_origin) * scale);
+    }
+
+    /// Can the cell coordinates \c c be stored in a key?
+    template <typename Int3>
+    static auto in_range(const Int3 &c) {
+        return dr::all(c >= 0 && c < (int32_t) (1u << CoordBits));
+    }
+
+    /// Key of a cell in the hash table
+    template <typename Int3, typename UInt>
+    static auto cell_key(const Int3 &c, const UInt &bin, const UInt &level) {
+        using UInt64_ = dr::uint64_array_t<UInt>;
+        return (UInt64_(level) << 60) | (UInt64_(bin) << 57) |
+               (UInt64_(UInt(c.x())) << (2 * CoordBits)) |
+               (UInt64_(UInt(c.y())) << CoordBits) | UInt64_(UInt(c.z()));
+    }
+
+    /// Initial slot of \c key in the hash table (Fibonacci hashing)
+    template <typename UInt64_>
+    auto key_slot(const UInt64_ &key) const {
+        return dr::uint32_array_t<UInt64_>(
+            (key * 0x9E3779B97F4A7C15ull) >> (64 - m_table_bits));
+    }
+
+    /// Look up the value associated with \c key in the hash table
+    std::pair<Mask, UInt32> find(const UInt64 &key, Mask active) const {
+        UInt32 slot = key_slot(key), value = 0;
+        Mask found = false;
+
+        // All keys are within 'MaxProbes' slots of their initial one
+        for (uint32_t i = 0; i < MaxProbes; ++i) {
+            Mask query = active && !found;
+            UInt32 s = (slot + i) & m_table_mask;
+            Mask hit = query && (dr::gather<UInt64>(m_keys, s, query) == key);
+            dr::masked(value, hit) = dr::gather<UInt32>(m_values, s, hit);
+            found |= hit;
+        }
+
+        return { found, value };
+    }
+
+    /**
+     * \brief Interpolate the cached irradiance at the point \c p with normal
+     * \c n (facing the incident direction)
+     *
+     * Returns the irradiance and a mask of lanes covered by the cache.
+     */
+    std::pair<UnpolarizedSpectrum, Mask> lookup(const Point3f &p,
+                                                const Normal3f &n,
+                                                Mask active) const {
+        UInt32 bin = normal_bin(n), level = 0;
+        Float scale = m_inv_cell_size;
+        Mask found = false, descend = active;
+
+        // Find the finest level whose cell containing 'p' holds a record
+        for (uint32_t l = 0; l < m_max_levels; ++l) {
+            ScalarFloat scale_l = m_inv_cell_size * (ScalarFloat) (1u << l);
+            Vector3i c = cell_coords(p, Float(scale_l));
+            auto [hit, value] = find(cell_key(c, bin, UInt32(l)),
+                                     descend && in_range(c));
+            dr::masked(level, hit) = l;
+            dr::masked(scale, hit) = scale_l;
+            found |= hit;
+            descend = hit && (value & RefinedBit) != 0u;
+        }
+
+        // Trilinear interpolation between the records of the 8 nearest cells
+        Vector3f pos = dr::fmadd(p - m_origin, scale, -.5f);
+        Vector3i base = dr::floor2int<Vector3i>(pos);
+        Vector3f frac = pos - Vector3f(base);
+
+        UnpolarizedSpectrum irradiance = 0.f;
+        Float weight = 0.f;
+
+        for (uint32_t i = 0; i < 8; ++i) {
+            Vector3i c = base + Vector3i((int32_t) (i & 1), (int32_t) ((i >> 1) & 1),
+                                       (int32_t) ((i >> 2) & 1));
+            auto [hit, value] = find(cell_key(c, bin, level), found && in_range(c));
+            UInt32 record = value & ~RefinedBit;
+
+            Float w = ((i & 1) ? frac.x() : 1.f - frac.x()) *
+                      ((i & 2) ? frac.y() : 1.f - frac.y()) *
+                      ((i & 4) ? frac.z() : 1.f - frac.z());
+
+            // Discard records away from the tangent plane (e.g. behind walls)
+            Point3f record_p = dr::gather<Point3f>(m_positions, record, hit);
+            w *= dr::maximum(1.f - dr::abs(dr::dot(n, record_p - p)) * scale, 0.f);
+
+            dr::masked(irradiance, hit) +=
+                w * dr::gather<UnpolarizedSpectrum>(m_irradiance, record, hit);
+            dr::masked(weight, hit) += w;
+        }
+
+        found &= weight > 0.f;
+        return { dr::select(found, irradiance / weight, 0.f), found };
+    }
+
+    //! @}
+    // =============================================================
+
+    // =============================================================
+    //! @{ \name Cache construction
+    // =============================================================
+
+    /**
+     * \brief Follow one camera ray through the pixel \c idx of the film and
+     * sample the BSDF of its first intersection
+     *
+     * Returns the position and normal (facing the ray) of the intersection
+     * found after the bounce, and a mask of lanes where it is diffuse.
+     */
+    std::tuple<Point3f, Normal3f, Mask>
+    sample_candidate(const Scene *scene, const Sensor *sensor, Sampler *sampler,
+                     const UInt32 &idx) const {
+        const Film *film = sensor->film();
+        ScalarVector2u crop_size = film->crop_size();
+        Vector2f pos(Float(idx % crop_size.x()), Float(idx / crop_size.x()));
+        pos = (pos + sampler->next_2d()) / ScalarVector2f(crop_size);
+
+        Point2f aperture_sample(.5f);
+        if (sensor->needs_aperture_sample())
+            aperture_sample = sampler->next_2d();
+
+        Float time = sensor->shutter_open();
+        if (sensor->shutter_open_time() > 0.f)
+            time += sampler->next_1d() * sensor->shutter_open_time();
+
+        auto [ray, ray_weight] =
+            sensor->sample_ray(time, 0.f, pos, aperture_sample);
+        DRJIT_MARK_USED(ray_weight);
+
+        SurfaceInteraction3f si = scene->ray_intersect(ray);
+        Mask valid = si.is_valid();
+
+        BSDFContext ctx;
+        BSDFPtr bsdf = si.bsdf(ray);
+        auto [bs, bsdf_weight] = bsdf->sample(ctx, si, sampler->next_1d(valid),
+                                              sampler->next_2d(valid), valid);
+        valid &= dr::any(unpolarized_spectrum(bsdf_weight) != 0.f);
+
+        Ray3f ray2 = si.spawn_ray(si.to_world(bs.wo));
+        SurfaceInteraction3f si2 = scene->ray_intersect(ray2, valid);
+        valid &= si2.is_valid();
+        valid &= is_diffuse(si2.bsdf(ray2)->flags(valid));
+
+        return { si2.p, dr::mulsign(si2.n, -dr::dot(si2.n, ray2.d)), valid };
+    }
+
+    /// Trace one candidate per pixel, and return those on diffuse surfaces
+    void trace_candidates(const Scene *scene, const Sensor *sensor,
+                          uint32_t seed, std::vector<ScalarFloat> &positions,
+                          std::vector<ScalarFloat> &normals) const {
+        uint32_t pixel_count = dr::prod(sensor->film()->crop_size());
+        std::vector<ScalarFloat> p(pixel_count * 3), n(pixel_count * 3);
+        std::vector<uint8_t> valid(pixel_count);
+
+        if constexpr (dr::is_jit_v<Float>) {
+            ref<Sampler> sampler = m_sampler->clone();
+            sampler->seed(seed, pixel_count);
+            auto [p_j, n_j, valid_j] = sample_candidate(
+                scene, sensor, sampler, dr::arange<UInt32>(pixel_count));
+
+            FloatStorage buf = dr::empty<FloatStorage>(pixel_count * 7);
+            UInt32 idx = dr::arange<UInt32>(pixel_count) * 7;
+            for (size_t k = 0; k < 3; ++k) {
+                dr::scatter(buf, p_j[k], idx + (uint32_t) k);
+                dr::scatter(buf, n_j[k], idx + (uint32_t) (k + 3));
+            }
+            dr::scatter(buf, dr::select(valid_j, 1.f, 0.f), idx + 6);
+
+            auto &&host = dr::migrate(buf, AllocType::Host);
+            dr::sync_thread();
+            const ScalarFloat *data = host.data();
+            for (uint32_t i = 0; i < pixel_count; ++i) {
+                for (size_t k = 0; k < 3; ++k) {
+                    p[i * 3 + k] = data[i * 7 + k];
+                    n[i * 3 + k] = data[i * 7 + k + 3];
+                }
+                valid[i] = data[i * 7 + 6] > 0.f;
+            }
+        } else {
+            ThreadEnvironment env;
+            dr::parallel_for(
+                dr::blocked_range<uint32_t>(0, pixel_count, 1024),
+                [&](const dr::blocked_range<uint32_t> &range) {
+                    ScopedSetThreadEnvironment set_env(env);
+                    ref<Sampler> sampler = m_sampler->clone();
+
+                    for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                        sampler->seed(sample_tea_32(seed, i).first);
+                        auto [p_i, n_i, valid_i] =
+                            sample_candidate(scene, sensor, sampler, i);
+                        for (size_t k = 0; k < 3; ++k) {
+                            p[i * 3 + k] = p_i[k];
+                            n[i * 3 + k] = n_i[k];
+                        }
+                        valid[i] = valid_i;
+                    }
+                }
+            );
+        }
+
+        for (uint32_t i = 0; i < pixel_count; ++i) {
+            if (!valid[i])
+                continue;
+            positions.insert(positions.end(), p.begin() + i * 3, p.begin() + i * 3 + 3);
+            normals.insert(normals.end(), n.begin() + i * 3, n.begin() + i * 3 + 3);
+        }
+    }
+
+    /// Compute the irradiance of the records [first, end)
+    void compute_records(const Scene *scene, const Sensor *sensor,
+                         uint32_t seed, size_t first, size_t end,
+                         const std::vector<ScalarFloat> &positions,
+                         const std::vector<ScalarFloat> &normals,
+                         std::vector<ScalarFloat> &irradiance) const {
+        irradiance.resize(end * Channels);
+        ScalarFloat time = sensor->shutter_open(),
+                    inv_samples = 1.f / m_record_samples;
+
+        if constexpr (dr::is_jit_v<Float>) {
+            // Wavefronts of up to 2^22 samples
+            ref<Sampler> sampler = m_sampler->clone();
+            uint32_t batch = std::max(1u, (1u << 22) / m_record_samples);
+
+            for (size_t start = first; start < end; start += batch) {
+                uint32_t count = (uint32_t) std::min((size_t) batch, end - start),
+                         lanes = count * m_record_samples;
+
+                UInt32 record = dr::arange<UInt32>(lanes) / m_record_samples;
+                FloatStorage p_buf = dr::load<FloatStorage>(
+                                 positions.data() + start * 3, count * 3),
+                             n_buf = dr::load<FloatStorage>(
+                                 normals.data() + start * 3, count * 3);
+
+                sampler->seed(sample_tea_32(seed, (uint32_t) start).first, lanes);
+                UnpolarizedSpectrum value = sample_irradiance(
+                    scene, sampler, dr::gather<Point3f>(p_buf, record),
+                    dr::gather<Normal3f>(n_buf, record), Float(time), true);
+
+                FloatStorage sum = dr::zeros<FloatStorage>(count * Channels);
+                for (size_t k = 0; k < Channels; ++k)
+                    dr::scatter_reduce(ReduceOp::Add, sum, value[k] * inv_samples,
+                                       record * (uint32_t) Channels + (uint32_t) k);
+
+                auto &&host = dr::migrate(sum, AllocType::Host);
+                dr::sync_thread();
+                std::copy(host.data(), host.data() + count * Channels,
+                          irradiance.data() + start * Channels);
+            }
+        } else {
+            ThreadEnvironment env;
+            dr::parallel_for(
+                dr::blocked_range<size_t>(first, end, 4),
+                [&](const dr::blocked_range<size_t> &range) {
+                    ScopedSetThreadEnvironment set_env(env);
+                    ref<Sampler> sampler = m_sampler->clone();
+
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        sampler->seed(sample_tea_32(seed, (uint32_t) i).first);
+                        Point3f p(positions[i * 3], positions[i * 3 + 1],
+                                  positions[i * 3 + 2]);
+                        Normal3f n(normals[i * 3], normals[i * 3 + 1],
+                                   normals[i * 3 + 2]);
+
+                        UnpolarizedSpectrum value = 0.f;
+                        for (uint32_t j = 0; j < m_record_samples; ++j) {
+                            value += sample_irradiance(scene, sampler, p, n,
+                                                       time, true);
+                            sampler->advance();
+                        }
+
+                        for (size_t k = 0; k < Channels; ++k) {
+                            ScalarFloat v = value[k] * inv_samples;
+                            irradiance[i * Channels + k] = dr::isfinite(v) ? v : 0.f;
+                        }
+                    }
+                }
+            );
+        }
+    }
+
+    /// Place the records, compute their irradiance and build the hash table
+    void build_cache(const Scene *scene, const Sensor *sensor, uint32_t seed) {
+        Timer timer;
+        m_record_count = 0;
+
+        ScalarBoundingBox3f bbox = scene->bbox();
+        ScalarFloat spacing = m_record_spacing;
+        if (spacing == 0.f)
+            spacing = .02f * dr::norm(bbox.extents());
+
+        // The cell coordinates of the finest level must fit into the keys
+        ScalarFloat max_extent = dr::max(bbox.extents()),
+                    min_spacing = max_extent * (ScalarFloat) (1u << (m_max_levels - 1)) /
+                                  (ScalarFloat) ((1u << CoordBits) - 1);
+        spacing = dr::maximum(spacing, min_spacing);
+        if (!(spacing > 0.f))
+            spacing = 1.f;
+        m_origin = bbox.min;
+        m_inv_cell_size = 1.f / spacing;
+
+        // 1. Diffuse surfaces seen after the first bounce of camera rays
+        std::vector<ScalarFloat> cand_p, cand_n;
+        trace_candidates(scene, sensor, seed, cand_p, cand_n);
+        size_t cand_count = cand_p.size() / 3;
+
+        auto cand_key = [&](size_t i, uint32_t level, const ScalarVector3i &shift) {
+            ScalarPoint3f p(cand_p[i * 3], cand_p[i * 3 + 1], cand_p[i * 3 + 2]);
+            ScalarNormal3f n(cand_n[i * 3], cand_n[i * 3 + 1], cand_n[i * 3 + 2]);
+            ScalarVector3i c =
+                cell_coords(p, m_inv_cell_size * (ScalarFloat) (1u << level)) + shift;
+            return std::make_pair(
+                cell_key(c, normal_bin(n), level), (bool) in_range(c));
+        };
+
+        /* 2. Place the records level by level. The first candidate of every
+              cell becomes its record, and the candidates in cells whose
+              irradiance differs from that of a neighbor move to the next level */
+        std::unordered_map<uint64_t, uint32_t> cells;
+        std::vector<ScalarFloat> rec_p, rec_n, rec_e;
+        std::vector<size_t> rec_cand;
+        std::vector<uint32_t> candidates(cand_count);
+        for (size_t i = 0; i < cand_count; ++i)
+            candidates[i] = (uint32_t) i;
+
+        for (uint32_t level = 0; level < m_max_levels && !candidates.empty(); ++level) {
+            size_t first = rec_cand.size();
+            for (uint32_t i : candidates) {
+                auto [key, valid] = cand_key(i, level, ScalarVector3i(0));
+                if (!valid)
+                    continue;
+                if (cells.emplace(key, (uint32_t) rec_cand.size()).second) {
+                    rec_cand.push_back(i);
+                    rec_p.insert(rec_p.end(), cand_p.begin() + i * 3, cand_p.begin() + i * 3 + 3);
+                    rec_n.insert(rec_n.end(), cand_n.begin() + i * 3, cand_n.begin() + i * 3 + 3);
+                }
+            }
+
+            compute_records(scene, sensor, sample_tea_32(seed, level + 1).first,
+                            first, rec_cand.size(), rec_p, rec_n, rec_e);
+
+            if (level + 1 == m_max_levels)
+                break;
+
+            auto mean_irradiance = [&](uint32_t r) {
+                ScalarFloat sum = 0.f;
+                for (size_t k = 0; k < Channels; ++k)
+                    sum += rec_e[r * Channels + k];
+                return sum / Channels;
+            };
+
+            // Split the cells whose irradiance differs from that of a neighbor
+            std::vector<uint64_t> refined;
+            for (size_t r = first; r < rec_cand.size(); ++r) {
+                ScalarFloat e = mean_irradiance((uint32_t) r);
+                for (uint32_t j = 0; j < 6; ++j) {
+                    ScalarVector3i shift(0);
+                    shift[j / 2] = (j & 1) ? 1 : -1;
+                    auto [key, valid] = cand_key(rec_cand[r], level, shift);
+                    auto it = cells.find(key);
+                    if (!valid || it == cells.end())
+                        continue;
+                    ScalarFloat e2 = mean_irradiance(it->second & ~RefinedBit);
+                    if (dr::abs(e - e2) > m_error_threshold * dr::maximum(e, e2)) {
+                        refined.push_back(cand_key(rec_cand[r], level, ScalarVector3i(0)).first);
+                        break;
+                    }
+                }
+            }
+
+            for (uint64_t key : refined)
+                cells[key] |= RefinedBit;
+
+            std::vector<uint32_t> next;
+            for (uint32_t i : candidates) {
+                auto it = cells.find(cand_key(i, level, ScalarVector3i(0)).first);
+                if (it != cells.end() && (it->second & RefinedBit))
+                    next.push_back(i);
+            }
+            candidates = std::move(next);
+        }
+
+        m_record_count = rec_cand.size();
+
+        // 3. Build the hash table using linear probing
+        std::vector<uint64_t> keys;
+        std::vector<uint32_t> values;
+        m_table_bits = 1;
+        while ((1u << m_table_bits) < 2 * std::max(cells.size(), (size_t) 1))
+            ++m_table_bits;
+
+        while (true) {
+            uint32_t size = 1u << m_table_bits;
+            m_table_mask = size - 1;
+            keys.assign(size, EmptyKey);
+            values.assign(size, 0u);
+
+            bool success = true;
+            for (auto [key, value] : cells) {
+                uint32_t slot = key_slot(key), i = 0;
+                while (i < MaxProbes && keys[(slot + i) & m_table_mask] != EmptyKey)
+                    ++i;
+                if (i == MaxProbes) {
+                    success = false;
+                    break;
+                }
+                keys[(slot + i) & m_table_mask] = key;
+                values[(slot + i) & m_table_mask] = value;
+            }
+
+            if (success)
+                break;
+            ++m_table_bits;
+        }
+
+        m_keys       = dr::load<UInt64Storage>(keys.data(), keys.size());
+        m_values     = dr::load<UInt32Storage>(values.data(), values.size());
+        m_positions  = dr::load<FloatStorage>(rec_p.data(), rec_p.size());
+        m_irradiance = dr::load<FloatStorage>(rec_e.data(), rec_e.size());
+
+        Log(Info, "Built an irradiance cache with %zu records from %zu "
+            "candidates (%s, took %s)", m_record_count, cand_count,
+            util::mem_string(keys.size() * (sizeof(uint64_t) + sizeof(uint32_t)) +
+                             (rec_p.size() + rec_e.size()) * sizeof(ScalarFloat)),
+            util::time_string((float) timer.value()));
+    }
+
+    //! @}
+    // =============================================================
+
+private:
+    ScalarFloat m_record_spacing;
+    ScalarFloat m_error_threshold;
+    uint32_t m_max_levels;
+    uint32_t m_record_samples;
+    ref<Sampler> m_sampler;
+
+    /// Origin and inverse cell size of the coarsest level
+    ScalarPoint3f m_origin;
+    ScalarFloat m_inv_cell_size = 1.f;
+
+    /// Hash table that maps cell keys to record indices
+    UInt64Storage m_keys;
+    UInt32Storage m_values;
+    uint32_t m_table_bits = 1;
+    uint32_t m_table_mask = 1;
+
+    /// Position and irradiance of every record
+    FloatStorage m_positions, m_irradiance;
+    size_t m_record_count = 0;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(IrradianceCacheIntegrator, MonteCarloIntegrator)
+MI_EXPORT_PLUGIN(IrradianceCacheIntegrator, "Irradiance cache integrator");
+NAMESPACE_END(mitsuba)
@@ -1,3 +1,5 @@
+#include <mitsuba/core/atomic.h>
+#include <mitsuba/core/math.h>
 #include <mitsuba/core/ray.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/render/bsdf.h>
@@ -34,6 +36,99 @@ Path tracer (:monosp:`path`)
    - |bool|
    - Hide directly visible emitters. (Default: no, i.e. |false|)
 
+ * - emitter_samples
+   - |int|
+   - Number of emitter samples taken at every path vertex. Their shadow rays
+     are tested together (see :py:meth:`mitsuba.Scene.ray_test_multi`), which
+     shares the upper levels of the traversal in scalar variants. Values
+     larger than 1 reduce the variance of the direct illumination in scenes
+     with many emitters. (Default: 1)
+
+ * - sort_rays
+   - |bool|
+   - Reorder the rays of every bounce after the first one by origin cell and
+     direction octant before tracing them, which improves the coherence of
+     the traversal for incoherent secondary rays. This only has an effect in
+     wavefront mode (i.e. when rendering JIT variants with the '-W' flag or
+     with the JitFlag.LoopRecord bit disabled) and is otherwise ignored.
+     (Default: no, i.e. |false|)
+
+ * - sort_materials
+   - |bool|
+   - Sort the active lanes of every bounce by BSDF instance before evaluating
+     and sampling the materials, so that the lanes calling the same material
+     are contiguous. This reduces the divergence of the virtual function calls
+     in scenes with many materials. Like :paramtype:`sort_rays`, this only has
+     an effect in wavefront mode. (Default: no, i.e. |false|)
+
+ * - compaction_threshold
+   - |float|
+   - Compact the state of the paths into a dense wavefront whenever the
+     fraction of active paths drops below this threshold, so that later
+     bounces only process (and load and store the state of) the paths that
+     are still alive. The results are scattered back to their original lanes
+     once all paths have terminated, and the image is identical to the one
+     rendered without compaction. Like :paramtype:`sort_rays`, this only has
+     an effect in wavefront mode. (Default: 0, i.e. disabled)
+
+ * - rr_mode
+   - |string|
+   - Russian roulette criterion. :monosp:`throughput` terminates paths based
+     on their throughput after :paramtype:`rr_depth` bounces. :monosp:`adjoint`
+     learns a coarse estimate of the scattered radiance on a grid over the
+     scene during a few training passes, and terminates paths based on their
+     expected contribution to the pixel from the first bounce on (see below).
+     (Default: :monosp:`throughput`)
+
+ * - rr_training_passes, rr_training_spp
+   - |int|
+   - Number of training passes of the :monosp:`adjoint` mode, and number of
+     samples per pixel of the first training pass. Every subsequent pass
+     doubles the sample count. The training passes are not part of the
+     final image. (Default: 3 and 4)
+
+ * - rr_grid_resolution
+   - |int|
+   - Resolution of the grid of radiance estimates along each axis of the
+     scene bounding box. (Default: 32)
+
+ * - rr_window
+   - |float|
+   - Size of the weight window of the :monosp:`adjoint` mode, i.e. the ratio
+     between the largest and smallest expected contribution of a path
+     relative to the pixel value that is left untouched. (Default: 5)
+
+ * - radiance_cache
+   - |bool|
+   - Terminate paths early using a world-space hash grid of radiance estimates
+     that is updated by every render job (see below). The estimate is biased
+     while this is enabled. (Default: no, i.e. |false|)
+
+ * - cache_depth
+   - |int|
+   - Number of bounces that are traced before paths query the radiance cache,
+     i.e. 1 queries it at the intersection after the first bounce. (Default: 1)
+
+ * - cache_update_fraction
+   - |float|
+   - Fraction of the paths that ignore the cache and update it instead.
+     Paths reaching cells without estimates update it as well. (Default: 0.1)
+
+ * - cache_cell_size
+   - |float|
+   - Edge length of the cells of the hash grid. If not specified, 1% of the
+     bounding box diagonal of the scene of the first render job are used.
+
+ * - cache_size
+   - |int|
+   - Number of slots of the hash table (rounded up to a power of two).
+     (Default: 1048576)
+
+ * - cache_decay
+   - |float|
+   - Weight of the estimates of previous render jobs relative to those of
+     the current one, in the interval [0, 1). (Default: 0.9)
+
 This integrator implements a basic path tracer and is a **good default choice**
 when there is no strong reason to prefer another method.
 
@@ -68,6 +163,35 @@ paths of arbitrary length to compute both direct and indirect illumination.
 
 .. note:: This integrator does not handle participating media
 
+The :monosp:`adjoint` Russian roulette mode is inspired by *adjoint-driven
+Russian roulette and splitting* (Vorba and Křivánek, 2016). Paths whose
+expected contribution (their throughput times the learned radiance estimate
+at the current vertex) falls below the lower end of the weight window centered
+around the pixel estimate survive with a probability that brings their weight
+back to its center, which quickly terminates paths in dark regions. Paths
+above the lower end are never terminated, so that rare paths towards bright
+regions (e.g. caustics) are not prematurely discarded. Cells without estimates
+fall back to the standard criterion. Path splitting is not performed, since
+every sample is traced by a single lane of a vectorized loop.
+
+The radiance cache targets interactive use in JIT variants, where every
+additional bounce costs an iteration over the whole wavefront. Paths that
+reach a non-specular intersection after :paramtype:`cache_depth` bounces look
+up the radiance scattered there in a hash grid over world space (whose cells
+are also separated by the dominant axis of the surface normal), and end with
+this estimate. A random subset of the paths, whose size is given by
+:paramtype:`cache_update_fraction`, continues instead, and records the
+radiance that it gathers at this intersection using atomic operations. At the
+end of every render job, the recorded values are added to the estimates of the
+previous jobs after scaling those by :paramtype:`cache_decay`, so that the
+cache persists across calls to ``render()`` and adapts to changes of the
+scene. Each slot of the hash table stores a checksum of its cell, and slots
+that receive the values of multiple cells during a render job keep their
+previous estimate. The cached radiance does not depend on the viewing
+direction, which is accurate for diffuse surfaces and an approximation
+otherwise. The cache is only available in RGB and monochromatic variants;
+when it is disabled, the path tracer remains unbiased and is unaffected.
+
 .. tabs::
     .. code-tab::  xml
         :name: path-integrator
@@ -86,21 +210,81 @@ paths of arbitrary length to compute both direct and indirect illumination.
 template <typename Float, typename Spectrum>
 class PathIntegrator : public MonteCarloIntegrator<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters)
+    MI_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters,
+                   m_primary_aovs, write_primary_aovs, m_adjoint_rr,
+                   adjoint_rr, rr_recording, rr_estimate, rr_survival, rr_record,
+                   record_event, record_path, record_ray, m_capture_rays)
     MI_IMPORT_TYPES(Scene, Sampler, Medium, Emitter, EmitterPtr, BSDF, BSDFPtr)
 
-    PathIntegrator(const Properties &props) : Base(props) { }
+    PathIntegrator(const Properties &props) : Base(props) {
+        m_sort_rays = props.get<bool>("sort_rays", false);
+        m_sort_materials = props.get<bool>("sort_materials", false);
+        m_compaction_threshold = props.get<ScalarFloat>("compaction_threshold", 0.f);
+        if (m_compaction_threshold < 0.f || m_compaction_threshold > 1.f)
+            Throw("\"compaction_threshold\" must be in the range [0, 1]!");
+        int emitter_samples = props.get<int>("emitter_samples", 1);
+        if (emitter_samples <= 0)
+            Throw("\"emitter_samples\" must be positive!");
+        m_emitter_samples = (uint32_t) emitter_samples;
+        parse_adjoint_rr(props);
+
+        m_cache = props.get<bool>("radiance_cache", false);
+        int cache_depth = props.get<int>("cache_depth", 1),
+            cache_size = props.get<int>("cache_size", 1 << 20);
+        m_cache_update_fraction = props.get<ScalarFloat>("cache_update_fraction", .1f);
+        m_cache_cell_size = props.get<ScalarFloat>("cache_cell_size", 0.f);
+        m_cache_decay = props.get<ScalarFloat>("cache_decay", .9f);
+        if (cache_depth <= 0)
+            Throw("\"cache_depth\" must be positive!");
+        if (cache_size <= 0)
+            Throw("\"cache_size\" must be positive!");
+        if (m_cache_update_fraction < 0.f || m_cache_update_fraction > 1.f)
+            Throw("\"cache_update_fraction\" must be in the range [0, 1]!");
+        if (m_cache_cell_size < 0.f)
+            Throw("\"cache_cell_size\" must be positive!");
+        if (m_cache_decay < 0.f || m_cache_decay >= 1.f)
+            Throw("\"cache_decay\" must be in the range [0, 1)!");
+        if constexpr (is_spectral_v<Spectrum> || is_polarized_v<Spectrum>) {
+            if (m_cache)
+                Throw("The radiance cache is only supported in RGB and "
+                      "monochromatic variants!");
+        }
+        m_cache_depth = (uint32_t) cache_depth;
+        m_cache_size = math::round_to_power_of_two((uint32_t) cache_size);
+    }
+
+    using Base::render;
+
+    TensorXf render(Scene *scene, Sensor *sensor, uint32_t seed, uint32_t spp,
+                    bool develop, bool evaluate) override {
+        if (!m_cache)
+            return Base::render(scene, sensor, seed, spp, develop, evaluate);
+
+        cache_begin(scene);
+        TensorXf result = Base::render(scene, sensor, seed, spp, develop, evaluate);
+        cache_update();
+        return result;
+    }
 
     std::pair<Spectrum, Bool> sample(const Scene *scene,
                                      Sampler *sampler,
                                      const RayDifferential3f &ray_,
                                      const Medium * /* medium */,
-                                     Float * /* aovs */,
+                                     Float *aovs,
                                      Bool active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
 
-        if (unlikely(m_max_depth == 0))
+        // Attributes of the first intersection requested by the 'aov' plugin
+        bool record_aovs = aovs && !m_primary_aovs.empty();
+
+        if (unlikely(m_max_depth == 0)) {
+            if (record_aovs) {
+                SurfaceInteraction3f si = scene->ray_intersect(
+                    ray_, +RayFlags::All, true, active);
+                write_primary_aovs(m_primary_aovs, scene, ray_, si, aovs, active);
+            }
             return { 0.f, false };
+        }
 
         // --------------------- Configure loop state ----------------------
 
@@ -119,6 +303,28 @@ public:
         Bool          prev_bsdf_delta = true;
         BSDFContext   bsdf_ctx;
 
+        SurfaceInteraction3f primary_si = dr::zeros<SurfaceInteraction3f>();
+
+        /* Adjoint-driven Russian roulette: expected contribution to the pixel
+           after the first vertex, and the vertex whose scattered radiance is
+           recorded during training passes (chosen by reservoir sampling) */
+        bool use_estimates = adjoint_rr(), recording = rr_recording();
+        Float    rr_pixel      = -1.f;
+        Point3f  rr_p          = dr::zeros<Point3f>();
+        Spectrum rr_result     = 0.f,
+                 rr_throughput = 0.f;
+        UInt32   rr_count      = 0;
+
+        /* Radiance cache: the vertex at which paths that don't end there
+           record the scattered radiance, along with the path state upon
+           reaching it */
+        bool use_cache = m_cache_recording;
+        Point3f  rc_p          = dr::zeros<Point3f>();
+        Normal3f rc_n          = dr::zeros<Normal3f>();
+        Spectrum rc_result     = 0.f,
+                 rc_throughput = 0.f;
+        Bool     rc_valid      = false;
+
         /* Set up a Dr.Jit loop. This optimizes away to a normal loop in scalar
            mode, and it generates either a a megakernel (default) or
            wavefront-style renderer in JIT variants. This can be controlled by
@@ -135,11 +341,24 @@ public:
             Interaction3f prev_si;
             Float prev_bsdf_pdf;
             Bool prev_bsdf_delta;
+            SurfaceInteraction3f primary_si;
+            Float rr_pixel;
+            Point3f rr_p;
+            Spectrum rr_result;
+            Spectrum rr_throughput;
+            UInt32 rr_count;
+            Point3f rc_p;
+            Normal3f rc_n;
+            Spectrum rc_result;
+            Spectrum rc_throughput;
+            Bool rc_valid;
             Bool active;
             Sampler* sampler;
 
             DRJIT_STRUCT(LoopState, ray, throughput, result, eta, depth, \
                 valid_ray, prev_si, prev_bsdf_pdf, prev_bsdf_delta,
+                primary_si, rr_pixel, rr_p, rr_result, rr_throughput,
+                rr_count, rc_p, rc_n, rc_result, rc_throughput, rc_valid,
                 active, sampler)
         } ls = {
             ray,
@@ -151,21 +370,70 @@ public:
             prev_si,
             prev_bsdf_pdf,
             prev_bsdf_delta,
+            primary_si,
+            rr_pixel,
+            rr_p,
+            rr_result,
+            rr_throughput,
+            rr_count,
+            rc_p,
+            rc_n,
+            rc_result,
+            rc_throughput,
+            rc_valid,
             active,
             sampler
         };
 
-        dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
-            [](const LoopState& ls) { return ls.active; },
-            [this, scene, bsdf_ctx](LoopState& ls) {
+        /* Ray and material reordering and the compaction of the path state
+           require an explicit wavefront loop, since the sorted or compacted
+           lanes don't line up with the implicit mask */
+        bool sort_rays = false, sort_materials = false, compact = false,
+             reorder = false;
+        if constexpr (dr::is_jit_v<Float>) {
+            bool wavefront = !jit_flag(JitFlag::LoopRecord);
+            sort_rays = m_sort_rays && wavefront;
+            sort_materials = m_sort_materials && wavefront;
+            compact = m_compaction_threshold > 0.f && wavefront;
+        }
+
+        // Camera ray of every lane (compacted along with the loop state)
+        RayDifferential3f primary_ray = ray_;
+
+        /* Only compute the surface interaction fields read by the scene's
+           materials, unless AOVs inspect the first intersection */
+        uint32_t ray_flags = record_aovs ? +RayFlags::All : scene->ray_flags();
+
+        auto body = [this, scene, bsdf_ctx, &primary_ray, &reorder,
+                     sort_materials, record_aovs, use_estimates,
+                     recording, use_cache, ray_flags](LoopState& ls) {
 
             /* dr::while_loop implicitly masks all code in the loop using the
                'active' flag, so there is no need to pass it to every function */
 
-            SurfaceInteraction3f si =
-                scene->ray_intersect(ls.ray,
-                                     /* ray_flags = */ +RayFlags::All,
-                                     /* coherent = */ ls.depth == 0u);
+            SurfaceInteraction3f si;
+            if (reorder)
+                si = ray_intersect_sorted(scene, ls.ray, ray_flags, ls.active);
+            else
+                si = scene->ray_intersect(ls.ray, ray_flags,
+                                          /* coherent = */ ls.depth == 0u);
+            record_event(RenderCounter::ExtensionRays, ls.active);
+            record_ray(ls.ray, ls.depth, Mask(reorder) || ls.depth == 0u,
+                       /* shadow = */ false, ls.active);
+
+            /* Texture footprint of camera rays, which selects the level of
+               MIP mapped textures. Secondary rays carry no differentials. */
+            if (primary_ray.has_differentials) {
+                Mask primary = ls.depth == 0u;
+                if (dr::any_or<true>(primary)) {
+                    si.compute_uv_partials(primary_ray);
+                    dr::masked(si.duv_dx, !primary) = 0.f;
+                    dr::masked(si.duv_dy, !primary) = 0.f;
+                }
+            }
+
+            if (record_aovs)
+                dr::masked(ls.primary_si, ls.depth == 0u) = si;
 
             // ---------------------- Direct emission ----------------------
 
@@ -183,7 +451,8 @@ public:
                                                           !ls.prev_bsdf_delta);
 
                 // Compute MIS weight for emitter sample from previous bounce
-                Float mis_bsdf = mis_weight(ls.prev_bsdf_pdf, em_pdf);
+                Float mis_bsdf = mis_weight(ls.prev_bsdf_pdf,
+                                            em_pdf * (ScalarFloat) m_emitter_samples);
 
                 // Accumulate, being careful with polarization (see spec_fma)
                 ls.result = spec_fma(
@@ -194,6 +463,10 @@ public:
 
             // Continue tracing the path at this point?
             Bool active_next = (ls.depth + 1 < m_max_depth) && si.is_valid();
+            record_path(ls.depth, PathTermination::Escaped,
+                        ls.active && !si.is_valid());
+            record_path(ls.depth + 1, PathTermination::MaxDepth,
+                        ls.active && si.is_valid() && !active_next);
 
             if (dr::none_or<false>(active_next)) {
                 ls.active = active_next;
@@ -202,27 +475,84 @@ public:
 
             BSDFPtr bsdf = si.bsdf(ls.ray);
 
+            // ----------------------- Radiance cache -----------------------
+
+            if (use_cache) {
+                Mask vertex = active_next && ls.depth == m_cache_depth &&
+                              !has_flag(bsdf->flags(), BSDFFlags::Delta);
+
+                if (dr::any_or<true>(vertex)) {
+                    Normal3f n = dr::mulsign(si.n, -dr::dot(si.n, ls.ray.d));
+                    auto [cached, hit] = cache_lookup(si.p, n, vertex);
+
+                    // End the path with the cached estimate, or update it
+                    Mask update = ls.sampler->next_1d() < m_cache_update_fraction,
+                         terminate = hit && !update,
+                         record = vertex && !terminate;
+
+                    ls.result[terminate] = spec_fma(
+                        ls.throughput, depolarizer<Spectrum>(cached), ls.result);
+                    dr::masked(ls.rc_p, record) = si.p;
+                    dr::masked(ls.rc_n, record) = n;
+                    dr::masked(ls.rc_result, record) = ls.result;
+                    dr::masked(ls.rc_throughput, record) = ls.throughput;
+                    ls.rc_valid |= record;
+                    active_next &= !terminate;
+                }
+
+                if (dr::none_or<false>(active_next)) {
+                    ls.active = active_next;
+                    return; // early exit for scalar mode
+                }
+            }
+
             // ---------------------- Emitter sampling ----------------------
 
             // Perform emitter sampling?
             Mask active_em = active_next && has_flag(bsdf->flags(), BSDFFlags::Smooth);
 
-            DirectionSample3f ds = dr::zeros<DirectionSample3f>();
-            Spectrum em_weight = dr::zeros<Spectrum>();
+            /* All samples (see the 'emitter_samples' parameter). The first
+               one is evaluated together with BSDF sampling below. */
+            std::vector<DirectionSample3f> em_ds(m_emitter_samples,
+                                                 dr::zeros<DirectionSample3f>());
+            std::vector<Spectrum> em_weights(m_emitter_samples, dr::zeros<Spectrum>());
+            DirectionSample3f &ds = em_ds[0];
+            Spectrum &em_weight = em_weights[0];
             Vector3f wo = dr::zeros<Vector3f>();
+            Mask em_sampled = active_em;
 
             if (dr::any_or<true>(active_em)) {
                 // Sample the emitter
-                std::tie(ds, em_weight) = scene->sample_emitter_direction(
-                    si, ls.sampler->next_2d(), true, active_em);
+                if (m_emitter_samples == 1) {
+                    std::tie(ds, em_weight) = scene->sample_emitter_direction(
+                        si, ls.sampler->next_2d(), true, active_em);
+                } else {
+                    // Trace the shadow rays of all samples together
+                    std::vector<Point2f> samples(m_emitter_samples);
+                    for (Point2f &sample : samples)
+                        sample = ls.sampler->next_2d();
+                    scene->sample_emitter_directions(si, samples.data(),
+                                                     m_emitter_samples, em_ds.data(),
+                                                     em_weights.data(), true, active_em);
+                }
+                for (uint32_t i = 0; i < m_emitter_samples; ++i) {
+                    record_event(RenderCounter::ShadowRays, active_em);
+                    if (unlikely(m_capture_rays))
+                        record_ray(si.spawn_ray_to(em_ds[i].p), ls.depth,
+                                   false, /* shadow = */ true, active_em);
+                }
                 active_em &= (ds.pdf != 0.f);
 
-                /* Given the detached emitter sample, recompute its contribution
+                /* Given the detached emitter samples, recompute their contribution
                    with AD to enable light source optimization. */
                 if (dr::grad_enabled(si.p)) {
-                    ds.d = dr::normalize(ds.p - si.p);
-                    Spectrum em_val = scene->eval_emitter_direction(si, ds, active_em);
-                    em_weight = dr::select(ds.pdf != 0, em_val / ds.pdf, 0);
+                    for (uint32_t i = 0; i < m_emitter_samples; ++i) {
+                        DirectionSample3f &ds_i = em_ds[i];
+                        Mask active_i = em_sampled && ds_i.pdf != 0.f;
+                        ds_i.d = dr::normalize(ds_i.p - si.p);
+                        Spectrum em_val = scene->eval_emitter_direction(si, ds_i, active_i);
+                        em_weights[i] = dr::select(ds_i.pdf != 0, em_val / ds_i.pdf, 0);
+                    }
                 }
 
                 wo = si.to_local(ds.d);
@@ -233,26 +563,61 @@ public:
             Float sample_1 = ls.sampler->next_1d();
             Point2f sample_2 = ls.sampler->next_2d();
 
-            auto [bsdf_val, bsdf_pdf, bsdf_sample, bsdf_weight]
-                = bsdf->eval_pdf_sample(bsdf_ctx, si, wo, sample_1, sample_2);
+            auto [bsdf_val, bsdf_pdf, bsdf_sample, bsdf_weight] =
+                sort_materials
+                    ? eval_pdf_sample_sorted(bsdf, bsdf_ctx, si, wo, sample_1,
+                                             sample_2, ls.active)
+                    : bsdf->eval_pdf_sample(bsdf_ctx, si, wo, sample_1, sample_2);
 
             // --------------- Emitter sampling contribution ----------------
 
+            ScalarFloat em_count = (ScalarFloat) m_emitter_samples;
+
+            /* Depolarizing BSDFs return Mueller matrices that are invariant to
+               rotations of the Stokes basis, hence the conversion can be skipped */
+            Mask rotate_mueller = true;
+            if constexpr (is_polarized_v<Spectrum>)
+                rotate_mueller = !has_flag(bsdf->flags(), BSDFFlags::Depolarizing);
+
             if (dr::any_or<true>(active_em)) {
-                bsdf_val = si.to_world_mueller(bsdf_val, -wo, si.wi);
+                if (dr::any_or<true>(rotate_mueller))
+                    dr::masked(bsdf_val, rotate_mueller) =
+                        si.to_world_mueller(bsdf_val, -wo, si.wi);
 
                 // Compute the MIS weight
-                Float mis_em =
-                    dr::select(ds.delta, 1.f, mis_weight(ds.pdf, bsdf_pdf));
+                Float mis_em = dr::select(
+                    ds.delta, 1.f, mis_weight(ds.pdf * em_count, bsdf_pdf)) / em_count;
 
                 // Accumulate, being careful with polarization (see spec_fma)
                 ls.result[active_em] = spec_fma(
                     ls.throughput, bsdf_val * em_weight * mis_em, ls.result);
             }
 
+            // The other emitter samples only require evaluating the BSDF
+            for (uint32_t i = 1; i < m_emitter_samples; ++i) {
+                const DirectionSample3f &ds_i = em_ds[i];
+                Mask active_i = em_sampled && ds_i.pdf != 0.f;
+                if (dr::none_or<false>(active_i))
+                    continue;
+
+                Vector3f wo_i = si.to_local(ds_i.d);
+                auto [bsdf_val_i, bsdf_pdf_i] =
+                    bsdf->eval_pdf(bsdf_ctx, si, wo_i, active_i);
+                if (dr::any_or<true>(rotate_mueller))
+                    dr::masked(bsdf_val_i, rotate_mueller) =
+                        si.to_world_mueller(bsdf_val_i, -wo_i, si.wi);
+
+                Float mis_i = dr::select(
+                    ds_i.delta, 1.f, mis_weight(ds_i.pdf * em_count, bsdf_pdf_i)) / em_count;
+                ls.result[active_i] = spec_fma(
+                    ls.throughput, bsdf_val_i * em_weights[i] * mis_i, ls.result);
+            }
+
             // ---------------------- BSDF sampling ----------------------
 
-            bsdf_weight = si.to_world_mueller(bsdf_weight, -bsdf_sample.wo, si.wi);
+            if (dr::any_or<true>(rotate_mueller))
+                dr::masked(bsdf_weight, rotate_mueller) =
+                    si.to_world_mueller(bsdf_weight, -bsdf_sample.wo, si.wi);
 
             ls.ray = si.spawn_ray(si.to_world(bsdf_sample.wo));
 
@@ -284,13 +649,37 @@ public:
 
             // -------------------- Stopping criterion ---------------------
 
+            if (use_estimates) {
+                Mask first = ls.depth == 0u;
+                dr::masked(ls.rr_pixel, first) =
+                    dr::mean(unpolarized_spectrum(ls.throughput)) *
+                    rr_estimate(si.p, first);
+            }
+
+            if (recording) {
+                dr::masked(ls.rr_count, active_next) += 1;
+                Mask replace = active_next &&
+                    ls.sampler->next_1d() * Float(ls.rr_count) < 1.f;
+                dr::masked(ls.rr_p, replace) = si.p;
+                dr::masked(ls.rr_result, replace) = ls.result;
+                dr::masked(ls.rr_throughput, replace) = ls.throughput;
+            }
+
             dr::masked(ls.depth, si.is_valid()) += 1;
 
             Float throughput_max = dr::max(unpolarized_spectrum(ls.throughput));
 
             Float rr_prob = dr::minimum(throughput_max * dr::square(ls.eta), .95f);
-            Mask rr_active = ls.depth >= m_rr_depth,
-                 rr_continue = ls.sampler->next_1d() < rr_prob;
+            Mask rr_active = ls.depth >= m_rr_depth;
+
+            if (use_estimates) {
+                auto [rr_prob_adj, rr_valid] =
+                    rr_survival(si.p, ls.throughput, ls.rr_pixel, active_next);
+                dr::masked(rr_prob, rr_valid) = rr_prob_adj;
+                rr_active |= rr_valid;
+            }
+
+            Mask rr_continue = ls.sampler->next_1d() < rr_prob;
 
             /* Differentiable variants of the renderer require the the russian
                roulette sampling weight to be detached to avoid bias. This is a
@@ -299,7 +688,129 @@ public:
 
             ls.active = active_next && (!rr_active || rr_continue) &&
                      (throughput_max != 0.f);
-        });
+            record_path(ls.depth, PathTermination::RussianRoulette,
+                        active_next && rr_active && !rr_continue);
+            record_path(ls.depth, PathTermination::Absorbed,
+                        active_next && (!rr_active || rr_continue) &&
+                            throughput_max == 0.f);
+        };
+
+        // Apply 'fn' to the matching JIT-compiled fields of two loop states
+        auto for_each_field = [](LoopState &a, const LoopState &b, auto &&fn) {
+            fn(a.ray, b.ray);
+            fn(a.throughput, b.throughput);
+            fn(a.result, b.result);
+            fn(a.eta, b.eta);
+            fn(a.depth, b.depth);
+            fn(a.valid_ray, b.valid_ray);
+            fn(a.prev_si, b.prev_si);
+            fn(a.prev_bsdf_pdf, b.prev_bsdf_pdf);
+            fn(a.prev_bsdf_delta, b.prev_bsdf_delta);
+            fn(a.primary_si, b.primary_si);
+            fn(a.rr_pixel, b.rr_pixel);
+            fn(a.rr_p, b.rr_p);
+            fn(a.rr_result, b.rr_result);
+            fn(a.rr_throughput, b.rr_throughput);
+            fn(a.rr_count, b.rr_count);
+            fn(a.rc_p, b.rc_p);
+            fn(a.rc_n, b.rc_n);
+            fn(a.rc_result, b.rc_result);
+            fn(a.rc_throughput, b.rc_throughput);
+            fn(a.rc_valid, b.rc_valid);
+        };
+
+        if (!sort_rays && !sort_materials && !compact) {
+            dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
+                [](const LoopState& ls) { return ls.active; }, body);
+        } else if constexpr (dr::is_jit_v<Float>) {
+            /* State of all lanes of the wavefront, and original lane of every
+               entry of the compacted state 'ls' (when 'compacted' is set) */
+            LoopState full = ls;
+            UInt32 lanes;
+            ref<Sampler> compact_sampler;
+            bool compacted = false;
+
+            // Write the compacted state back to the original lanes
+            auto expand = [&]() {
+                for_each_field(full, ls, [&](auto &dst, const auto &src) {
+                    dr::scatter(dst, src, lanes);
+                });
+                full.sampler->expand(ls.sampler, lanes);
+            };
+
+            while (dr::any(ls.active)) {
+                size_t width = dr::width(ls.active), count = dr::count(ls.active);
+                if (compact && (double) count < m_compaction_threshold * width) {
+                    UInt32 index = dr::compress(ls.active);
+                    if (compacted) {
+                        expand();
+                        lanes = dr::gather<UInt32>(lanes, index);
+                    } else {
+                        lanes = index;
+                    }
+
+                    LoopState dense = ls;
+                    for_each_field(dense, ls, [&](auto &dst, const auto &src) {
+                        using T = std::decay_t<decltype(src)>;
+                        dst = dr::gather<T>(src, index);
+                    });
+                    dense.active = dr::full<Mask>(true, count);
+                    primary_ray = dr::gather<RayDifferential3f>(primary_ray, index);
+
+                    compact_sampler = ls.sampler->compact(index);
+                    dense.sampler = compact_sampler.get();
+                    ls = dense;
+                    compacted = true;
+                }
+
+                LoopState prev = ls;
+                body(ls);
+
+                // Masking that dr::while_loop would otherwise perform
+                Mask done = !prev.active;
+                for_each_field(ls, prev, [&](auto &dst, const auto &src) {
+                    dr::masked(dst, done) = src;
+                });
+                dr::masked(ls.active, done) = false;
+
+                ls.sampler->schedule_state();
+                dr::eval(ls.ray, ls.throughput, ls.result, ls.eta, ls.depth,
+                         ls.valid_ray, ls.prev_si, ls.prev_bsdf_pdf,
+                         ls.prev_bsdf_delta, ls.primary_si, ls.rr_pixel,
+                         ls.rr_p, ls.rr_result, ls.rr_throughput, ls.rr_count,
+                         ls.rc_p, ls.rc_n, ls.rc_result, ls.rc_throughput,
+                         ls.rc_valid, ls.active);
+                reorder = sort_rays;
+            }
+
+            if (compacted) {
+                expand();
+                full.active = false;
+                ls = full;
+            }
+        }
+
+        if (record_aovs)
+            write_primary_aovs(m_primary_aovs, scene, ray_, ls.primary_si,
+                               aovs, active);
+
+        // Radiance scattered at the selected vertex, weighted by the vertex count
+        if (recording) {
+            Float throughput = dr::mean(unpolarized_spectrum(ls.rr_throughput));
+            rr_record(ls.rr_p,
+                      dr::mean(unpolarized_spectrum(ls.result - ls.rr_result)) /
+                          throughput,
+                      Float(ls.rr_count), active && throughput > 0.f);
+        }
+
+        // Radiance scattered at the cache vertex by the paths that continued
+        if (use_cache) {
+            UnpolarizedSpectrum throughput = unpolarized_spectrum(ls.rc_throughput),
+                                value = unpolarized_spectrum(ls.result - ls.rc_result);
+            cache_record(ls.rc_p, ls.rc_n,
+                         dr::select(throughput > 0.f, value / throughput, 0.f),
+                         active && ls.rc_valid);
+        }
 
         return {
             /* spec  = */ dr::select(ls.valid_ray, ls.result, 0.f),
@@ -310,11 +821,129 @@ public:
     //! @}
     // =============================================================
 
+    bool supports_primary_aovs() const override { return true; }
+
     std::string to_string() const override {
         return tfm::format("PathIntegrator[\n"
             "  max_depth = %u,\n"
-            "  rr_depth = %u\n"
-            "]", m_max_depth, m_rr_depth);
+            "  rr_depth = %u,\n"
+            "  emitter_samples = %u,\n"
+            "  sort_rays = %s,\n"
+            "  sort_materials = %s,\n"
+            "  compaction_threshold = %f,\n"
+            "  rr_mode = %s,\n"
+            "  radiance_cache = %s\n"
+            "]", m_max_depth, m_rr_depth, m_emitter_samples,
+            m_sort_rays ? "true" : "false",
+            m_sort_materials ? "true" : "false", m_compaction_threshold,
+            m_adjoint_rr ? "adjoint" : "throughput", m_cache ? "true" : "false");
+    }
+
+    /**
+     * \brief Sort the lanes of a wavefront by key with a parallel counting sort
+     *
+     * Returns the permutation from sorted positions to the original lanes,
+     * and the sorted position of every lane. The sort is stable.
+     */
+    std::pair<UInt32, UInt32> sort_permutation(const UInt32 &key,
+                                               uint32_t bucket_count) const {
+        UInt32 counts = dr::zeros<UInt32>(bucket_count);
+        dr::scatter_reduce(ReduceOp::Add, counts, UInt32(1), key);
+        UInt32 offsets = dr::prefix_sum(counts, true /* exclusive */);
+
+        UInt32 cursor = dr::zeros<UInt32>(bucket_count);
+        UInt32 slot = dr::gather<UInt32>(offsets, key) +
+                      dr::scatter_inc(cursor, key);
+
+        uint32_t size = (uint32_t) dr::width(key);
+        UInt32 perm = dr::zeros<UInt32>(size);
+        dr::scatter(perm, dr::arange<UInt32>(size), slot);
+        return { perm, slot };
+    }
+
+    /**
+     * \brief Evaluate and sample the BSDFs of a wavefront after sorting its
+     * lanes by BSDF instance
+     *
+     * The active lanes are grouped by the registry ID of their BSDF, with
+     * inactive lanes moved to the end, so that every virtual function call
+     * target processes a contiguous range of lanes. The results are returned
+     * in the original lane order.
+     */
+    std::tuple<Spectrum, Float, BSDFSample3f, Spectrum>
+    eval_pdf_sample_sorted(const BSDFPtr &bsdf, const BSDFContext &ctx,
+                           const SurfaceInteraction3f &si, const Vector3f &wo,
+                           const Float &sample_1, const Point2f &sample_2,
+                           const Mask &active) const {
+        if constexpr (dr::is_jit_v<Float>) {
+            uint32_t bound =
+                jit_registry_id_bound(dr::backend_v<Float>, "mitsuba::BSDF") + 1;
+            UInt32 key = dr::select(active, dr::reinterpret_array<UInt32>(bsdf),
+                                    bound);
+            auto [perm, slot] = sort_permutation(key, bound + 1);
+
+            BSDFPtr bsdf_sorted = dr::gather<BSDFPtr>(bsdf, perm);
+            SurfaceInteraction3f si_sorted = dr::gather<SurfaceInteraction3f>(si, perm);
+            Vector3f wo_sorted = dr::gather<Vector3f>(wo, perm);
+            Float sample_1_sorted = dr::gather<Float>(sample_1, perm);
+            Point2f sample_2_sorted = dr::gather<Point2f>(sample_2, perm);
+            Mask active_sorted = dr::gather<Mask>(active, perm);
+            dr::eval(bsdf_sorted, si_sorted, wo_sorted, sample_1_sorted,
+                     sample_2_sorted, active_sorted, slot);
+
+            auto [val, pdf, bs, weight] = bsdf_sorted->eval_pdf_sample(
+                ctx, si_sorted, wo_sorted, sample_1_sorted, sample_2_sorted,
+                active_sorted);
+
+            return { dr::gather<Spectrum>(val, slot),
+                     dr::gather<Float>(pdf, slot),
+                     dr::gather<BSDFSample3f>(bs, slot),
+                     dr::gather<Spectrum>(weight, slot) };
+        } else {
+            return bsdf->eval_pdf_sample(ctx, si, wo, sample_1, sample_2, active);
+        }
+    }
+
+    /**
+     * \brief Intersect a wavefront of incoherent rays after sorting them by
+     * origin and direction
+     *
+     * The rays are grouped by the cell of a 16x16x16 grid over the scene
+     * bounds containing their origin and by the octant of their direction
+     * using a parallel counting sort, with inactive rays moved to the end.
+     * The sorted rays are traced as a coherent batch, and the resulting
+     * surface interactions are returned in the original lane order.
+     */
+    SurfaceInteraction3f ray_intersect_sorted(const Scene *scene,
+                                              const Ray3f &ray,
+                                              uint32_t ray_flags,
+                                              const Mask &active) const {
+        constexpr uint32_t res = 16, bucket_count = res * res * res * 8 + 1;
+
+        ScalarBoundingBox3f bbox = scene->bbox();
+        ScalarVector3f extents = bbox.extents();
+        ScalarVector3f scale = dr::select(extents > 0.f, res / extents, 0.f);
+
+        Vector3u cell = Vector3u(dr::clip(
+            dr::floor2int<Vector3i>((ray.o - bbox.min) * scale), 0, (int) res - 1));
+
+        UInt32 key = (((cell.z() * res + cell.y()) * res + cell.x()) << 3) |
+                     dr::select(ray.d.x() < 0.f, 1u, 0u) |
+                     dr::select(ray.d.y() < 0.f, 2u, 0u) |
+                     dr::select(ray.d.z() < 0.f, 4u, 0u);
+        key = dr::select(active, key, bucket_count - 1);
+
+        auto [perm, slot] = sort_permutation(key, bucket_count);
+
+        Ray3f ray_sorted = dr::gather<Ray3f>(ray, perm);
+        Mask active_sorted = dr::gather<Mask>(active, perm);
+        dr::eval(ray_sorted, active_sorted, slot);
+
+        SurfaceInteraction3f si =
+            scene->ray_intersect(ray_sorted, ray_flags,
+                                 /* coherent = */ true, active_sorted);
+
+        return dr::gather<SurfaceInteraction3f>(si, slot);
     }
 
     /// Compute a multiple importance sampling weight using the power heuristic
@@ -337,7 +966,202 @@ public:
             return dr::fmadd(a, b, c);
     }
 
+    // =============================================================
+    //! @{ \name Radiance cache
+    // =============================================================
+
+    /// Hash table slot of the cell containing \c p, and checksum of the cell
+    std::pair<UInt32, UInt32> cache_slot(const Point3f &p, const Normal3f &n) const {
+        Vector3u cell = Vector3u(dr::floor2int<Vector3i>(p * m_cache_inv_cell_size));
+
+        // Dominant axis of the normal and its sign
+        Vector3f a = dr::abs(n);
+        UInt32 bin = dr::select(a.x() >= a.y() && a.x() >= a.z(), 0u,
+                                dr::select(a.y() >= a.z(), 2u, 4u));
+        bin += dr::select(dr::select(bin == 0u, n.x(),
+                                     dr::select(bin == 2u, n.y(), n.z())) < 0.f,
+                          1u, 0u);
+
+        // Two independent hash functions (Teschner et al. 2003)
+        UInt32 hash = (cell.x() * 73856093u) ^ (cell.y() * 19349663u) ^
+                      (cell.z() * 83492791u) ^ (bin * 2654435761u),
+               check = (cell.x() * 2246822519u) ^ (cell.y() * 3266489917u) ^
+                       (cell.z() * 668265263u) ^ (bin * 374761393u);
+
+        return { hash & (m_cache_size - 1), check | 1u };
+    }
+
+    /// Look up the radiance scattered at \c p with normal \c n (facing the ray)
+    std::pair<UnpolarizedSpectrum, Mask>
+    cache_lookup(const Point3f &p, const Normal3f &n, Mask active) const {
+        auto [slot, check] = cache_slot(p, n);
+        active &= dr::gather<UInt32>(m_cache_check, slot, active) == check;
+        Float weight = dr::gather<Float>(m_cache_weight, slot, active);
+        active &= weight > 0.f;
+        UnpolarizedSpectrum sum =
+            dr::gather<UnpolarizedSpectrum>(m_cache_sum, slot, active);
+        return { dr::select(active, sum / weight, 0.f), active };
+    }
+
+    /// Record the radiance scattered at \c p with normal \c n (atomically)
+    void cache_record(const Point3f &p, const Normal3f &n,
+                      const UnpolarizedSpectrum &value, Mask active) const {
+        active &= dr::all(dr::isfinite(value) && value >= 0.f);
+        auto [slot, check] = cache_slot(p, n);
+
+        if constexpr (dr::is_jit_v<Float>) {
+            UInt32 index = slot * (uint32_t) Channels;
+            for (size_t i = 0; i < Channels; ++i)
+                dr::scatter_reduce(ReduceOp::Add, m_cache_train, value[i],
+                                   index + (uint32_t) i, active);
+            dr::scatter_reduce(ReduceOp::Add, m_cache_train_weight, 1.f, slot, active);
+            dr::scatter_reduce(ReduceOp::Min, m_cache_train_min, check, slot, active);
+            dr::scatter_reduce(ReduceOp::Max, m_cache_train_max, check, slot, active);
+        } else {
+            if (active) {
+                for (size_t i = 0; i < Channels; ++i)
+                    m_cache_train_host[slot * Channels + i] += value[i];
+                m_cache_train_host_weight[slot] += 1.f;
+
+                std::atomic<uint32_t> &min = m_cache_train_host_check[2 * slot],
+                                      &max = m_cache_train_host_check[2 * slot + 1];
+                uint32_t prev = min.load(std::memory_order_relaxed);
+                while (check < prev && !min.compare_exchange_weak(prev, check))
+                    ;
+                prev = max.load(std::memory_order_relaxed);
+                while (check > prev && !max.compare_exchange_weak(prev, check))
+                    ;
+            }
+        }
+    }
+
+    /// Set up the cache (if needed) and clear the values of the current job
+    void cache_begin(const Scene *scene) {
+        m_cache_recording = true;
+
+        if (m_cache_inv_cell_size == 0.f) {
+            ScalarFloat cell_size = m_cache_cell_size;
+            if (cell_size == 0.f)
+                cell_size = .01f * dr::norm(scene->bbox().extents());
+            m_cache_inv_cell_size = cell_size > 0.f ? 1.f / cell_size : 1.f;
+
+            m_cache_sum = dr::zeros<FloatStorage>(m_cache_size * Channels);
+            m_cache_weight = dr::zeros<FloatStorage>(m_cache_size);
+            m_cache_check = dr::zeros<UInt32Storage>(m_cache_size);
+        }
+
+        if constexpr (dr::is_jit_v<Float>) {
+            m_cache_train = dr::zeros<FloatStorage>(m_cache_size * Channels);
+            m_cache_train_weight = dr::zeros<FloatStorage>(m_cache_size);
+            m_cache_train_min = dr::full<UInt32Storage>(0xFFFFFFFFu, m_cache_size);
+            m_cache_train_max = dr::zeros<UInt32Storage>(m_cache_size);
+        } else {
+            m_cache_train_host.reset(
+                new AtomicFloat<ScalarFloat>[m_cache_size * Channels]);
+            m_cache_train_host_weight.reset(
+                new AtomicFloat<ScalarFloat>[m_cache_size]);
+            m_cache_train_host_check.reset(
+                new std::atomic<uint32_t>[2 * m_cache_size]);
+            for (uint32_t i = 0; i < m_cache_size; ++i) {
+                m_cache_train_host_check[2 * i] = 0xFFFFFFFFu;
+                m_cache_train_host_check[2 * i + 1] = 0u;
+            }
+        }
+    }
+
+    /**
+     * \brief Add the values recorded during the current job to the decayed
+     * estimates of the previous ones
+     *
+     * Slots that were updated by a single cell take over its checksum (and
+     * drop the estimates of the cell that previously owned them), while
+     * contested slots keep their previous estimates.
+     */
+    void cache_update() {
+        if constexpr (dr::is_jit_v<Float>) {
+            Mask updated = m_cache_train_weight > 0.f &&
+                           m_cache_train_min == m_cache_train_max,
+                 replaced = updated && m_cache_train_min != m_cache_check;
+
+            UInt32 index = dr::arange<UInt32>(m_cache_size * Channels),
+                   slot = index / (uint32_t) Channels;
+            Mask updated_c = dr::gather<Mask>(updated, slot),
+                 replaced_c = dr::gather<Mask>(replaced, slot);
+
+            m_cache_sum = dr::select(replaced_c, 0.f, m_cache_sum * m_cache_decay) +
+                          dr::select(updated_c, m_cache_train, 0.f);
+            m_cache_weight = dr::select(replaced, 0.f, m_cache_weight * m_cache_decay) +
+                             dr::select(updated, m_cache_train_weight, 0.f);
+            m_cache_check = dr::select(replaced, m_cache_train_min, m_cache_check);
+            dr::eval(m_cache_sum, m_cache_weight, m_cache_check);
+
+            m_cache_train = FloatStorage();
+            m_cache_train_weight = FloatStorage();
+            m_cache_train_min = m_cache_train_max = UInt32Storage();
+        } else {
+            ScalarFloat *sum = m_cache_sum.data(), *weight = m_cache_weight.data();
+            uint32_t *check = m_cache_check.data();
+
+            for (uint32_t i = 0; i < m_cache_size; ++i) {
+                uint32_t min = m_cache_train_host_check[2 * i],
+                         max = m_cache_train_host_check[2 * i + 1];
+                ScalarFloat w = m_cache_train_host_weight[i];
+                bool updated = w > 0.f && min == max,
+                     replaced = updated && min != check[i];
+
+                ScalarFloat scale = replaced ? 0.f : m_cache_decay;
+                for (size_t j = 0; j < Channels; ++j)
+                    sum[i * Channels + j] = sum[i * Channels + j] * scale +
+                        (updated ? (ScalarFloat) m_cache_train_host[i * Channels + j] : 0.f);
+                weight[i] = weight[i] * scale + (updated ? w : 0.f);
+                if (replaced)
+                    check[i] = min;
+            }
+
+            m_cache_train_host.reset();
+            m_cache_train_host_weight.reset();
+            m_cache_train_host_check.reset();
+        }
+
+        m_cache_recording = false;
+    }
+
+    //! @}
+    // =============================================================
+
     MI_DECLARE_CLASS()
+private:
+    using FloatStorage  = DynamicBuffer<Float>;
+    using UInt32Storage = DynamicBuffer<UInt32>;
+
+    /// Number of color channels of the radiance cache
+    static constexpr size_t Channels = dr::size_v<UnpolarizedSpectrum>;
+
+    bool m_sort_rays;
+    bool m_sort_materials;
+    ScalarFloat m_compaction_threshold;
+    uint32_t m_emitter_samples;
+
+    /// Radiance cache (see the \c radiance_cache parameter)
+    bool m_cache;
+    uint32_t m_cache_depth;
+    uint32_t m_cache_size;
+    ScalarFloat m_cache_update_fraction;
+    ScalarFloat m_cache_cell_size;
+    ScalarFloat m_cache_decay;
+    ScalarFloat m_cache_inv_cell_size = 0.f;
+    bool m_cache_recording = false;
+
+    /// Decayed sums of the radiance and sample counts, and cell checksums
+    FloatStorage m_cache_sum, m_cache_weight;
+    UInt32Storage m_cache_check;
+
+    /// Values recorded during the current render job
+    mutable FloatStorage m_cache_train, m_cache_train_weight;
+    mutable UInt32Storage m_cache_train_min, m_cache_train_max;
+    std::unique_ptr<AtomicFloat<ScalarFloat>[]> m_cache_train_host,
+                                                m_cache_train_host_weight;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_cache_train_host_check;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(PathIntegrator, MonteCarloIntegrator)
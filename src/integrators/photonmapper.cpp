@@ -1,8 +1,13 @@
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/pointkdtree.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/random.h>
 #include <mitsuba/core/ray.h>
-#include <mitsuba/render/integrator.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/emitter.h>
+#include <mitsuba/render/integrator.h>
 #include <mitsuba/render/records.h>
 #include <mitsuba/render/sampler.h>
 
@@ -10,404 +15,411 @@ NAMESPACE_BEGIN(mitsuba)
 
 /**!
 
-.. _integrator-ptracer:
+.. _integrator-photon:
 
-Particle tracer (:monosp:`ptracer`)
------------------------------------
+Photon mapper (:monosp:`photon`)
+--------------------------------
 
 .. pluginparameters::
 
+ * - photon_count
+   - |int|
+   - Number of photon paths that are traced from the emitters before
+     rendering. (Default: 250000)
+
+ * - lookup_size
+   - |int|
+   - Number of photons used in each density estimate. (Default: 120)
+
+ * - lookup_radius
+   - |float|
+   - Maximum radius of the density estimates. If not specified, 5% of the
+     scene's bounding box diagonal are used.
+
  * - max_depth
    - |int|
-   - Specifies the longest path depth in the generated output image (where -1 corresponds to
-     :math:`\infty`). A value of 1 will only render directly visible light sources. 2 will lead
-     to single-bounce (direct-only) illumination, and so on. (Default: -1)
+   - Specifies the longest path depth in the generated output image (where -1
+     corresponds to :math:`\infty`). This limits both the photon paths and
+     the sensor paths. (Default: -1)
 
  * - rr_depth
    - |int|
-   - Specifies the minimum path depth, after which the implementation will start to use the
-     *russian roulette* path termination criterion. (Default: 5)
+   - Specifies the path depth, at which the implementation will begin to use
+     the *russian roulette* path termination criterion. (Default: 5)
 
  * - hide_emitters
    - |bool|
    - Hide directly visible emitters. (Default: no, i.e. |false|)
 
- * - samples_per_pass
-   - |bool|
-   - If specified, divides the workload in successive passes with :paramtype:`samples_per_pass`
-     samples per pixel.
-
-This integrator traces rays starting from light sources and attempts to connect them
-to the sensor at each bounce.
-It does not support media (volumes).
-
-Usually, this is a relatively useless rendering technique due to its high variance, but there
-are some cases where it excels. In particular, it does a good job on scenes where most scattering
-events are directly visible to the camera.
-
-Note that unlike sensor-based integrators such as :ref:`path <integrator-path>`, it is not
-possible to divide the workload in image-space tiles. The :paramtype:`samples_per_pass` parameter
-allows splitting work in successive passes of the given sample count per pixel. It is particularly
-useful in wavefront mode.
+This integrator implements the two-pass photon mapping technique by Jensen.
+Before rendering, photons are emitted from the light sources in parallel and
+traced through the scene. Each interaction with a non-specular surface
+(except for the first one, which is handled by emitter sampling) stores a
+photon in a balanced kd-tree.
+
+Sensor rays are then traced through specular surfaces until they reach a
+non-specular surface, where direct illumination is computed using emitter
+sampling, and indirect illumination is estimated from the density of the
+nearest photons. Since caustic paths (light that is focused by specular
+surfaces) are captured by the photon map, this converges considerably faster
+than a path tracer in scenes dominated by caustics, such as objects made of
+glass. The density estimates are biased however, which manifests as blurred
+illumination. Increasing :paramtype:`photon_count` along with
+:paramtype:`lookup_size` reduces this bias.
+
+The photon map is rebuilt at the beginning of every render job. This
+integrator is only available in scalar RGB and monochromatic variants, and it
+does not support participating media.
 
 .. tabs::
     .. code-tab::  xml
 
-        <integrator type="ptracer">
-            <integer name="max_depth" value="8"/>
+        <integrator type="photon">
+            <integer name="photon_count" value="1000000"/>
         </integrator>
 
     .. code-tab:: python
 
-        'type': 'ptracer',
-        'max_depth': 8
+        'type': 'photon',
+        'photon_count': 1000000
 
  */
 
 template <typename Float, typename Spectrum>
-class PhotonMapperIntegrator final : public AdjointIntegrator<Float, Spectrum> {
+class PhotonMapperIntegrator final : public MonteCarloIntegrator<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(AdjointIntegrator, m_samples_per_pass, m_hide_emitters,
-                    m_rr_depth, m_max_depth)
-    MI_IMPORT_TYPES(Scene, Sensor, Film, Sampler, ImageBlock, Emitter,
-                     EmitterPtr, BSDF, BSDFPtr)
-
-    PhotonMapperIntegrator(const Properties &props) : Base(props) { }
-
-    void sample(const Scene *scene, const Sensor *sensor, Sampler *sampler,
-                ImageBlock *block, ScalarFloat sample_scale) const override {
-        // Account for emitters directly visible from the sensor
-        if (m_max_depth != 0 && !m_hide_emitters)
-            sample_visible_emitters(scene, sensor, sampler, block, sample_scale);
-
-        // Primary & further bounces illumination
-        auto [ray, throughput] = prepare_ray(scene, sensor, sampler);
-
-        Float throughput_max = dr::max(unpolarized_spectrum(throughput));
-        Mask active = (throughput_max != 0.f);
-
-        trace_light_ray(ray, scene, sensor, sampler, throughput, block,
-                        sample_scale, active);
+    MI_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters)
+    MI_IMPORT_TYPES(Scene, Sensor, Sampler, Medium, Emitter, EmitterPtr, BSDF,
+                    BSDFPtr)
+
+    using PhotonTree   = PointKDTree<ScalarPoint3f>;
+    using SearchResult = typename PhotonTree::SearchResult;
+
+    /// Photon record (the position is stored in the kd-tree)
+    struct Photon {
+        /// Direction towards the previous vertex of the photon path
+        ScalarVector3f wi;
+        /// Geometric normal of the surface on which the photon was stored
+        ScalarNormal3f n;
+        /// Power of the photon
+        Spectrum power;
+    };
+
+    PhotonMapperIntegrator(const Properties &props) : Base(props) {
+        if constexpr (dr::is_jit_v<Float> || is_spectral_v<Spectrum> ||
+                      is_polarized_v<Spectrum>)
+            Throw("The photon mapper is only supported in scalar RGB and "
+                  "monochromatic variants!");
+
+        m_photon_count  = props.get<int>("photon_count", 250000);
+        m_lookup_size   = props.get<int>("lookup_size", 120);
+        m_lookup_radius = props.get<ScalarFloat>("lookup_radius", 0.f);
+
+        if (m_photon_count <= 0 || m_lookup_size <= 0)
+            Throw("\"photon_count\" and \"lookup_size\" must be positive!");
+        if (m_lookup_radius < 0.f)
+            Throw("\"lookup_radius\" must be positive!");
+
+        Properties props_sampler("independent");
+        props_sampler.set_int("sample_count", 1);
+        m_sampler = PluginManager::instance()->create_object<Sampler>(props_sampler);
     }
 
-    /**
-     * Samples an emitter in the scene and connects it directly to the sensor,
-     * splatting the emitted radiance to the given image block.
-     */
-    void sample_visible_emitters(const Scene *scene, const Sensor *sensor,
-                                 Sampler *sampler, ImageBlock *block,
-                                 ScalarFloat sample_scale) const {
-        // 1. Time sampling
-        Float time = sensor->shutter_open();
-        if (sensor->shutter_open_time() > 0)
-            time += sampler->next_1d() * sensor->shutter_open_time();
-
-        // 2. Emitter sampling (select one emitter)
-        auto [emitter_idx, emitter_idx_weight, _] =
-            scene->sample_emitter(sampler->next_1d());
-
-        EmitterPtr emitter =
-            dr::gather<EmitterPtr>(scene->emitters_dr(), emitter_idx);
-
-        // Don't connect delta emitters with sensor (both position and direction)
-        Mask active = !has_flag(emitter->flags(), EmitterFlags::Delta);
-
-        // 3. Emitter position sampling
-        Spectrum emitter_weight = dr::zeros<Spectrum>();
-        SurfaceInteraction3f si = dr::zeros<SurfaceInteraction3f>();
-
-        // 3.a. Infinite emitters
-        Mask is_infinite = has_flag(emitter->flags(), EmitterFlags::Infinite),
-             active_e = active && is_infinite;
-        if (dr::any_or<true>(active_e)) {
-            /* Sample a direction toward an envmap emitter starting
-               from the center of the scene (the sensor is not part of the
-               scene's bounding box, which could otherwise cause issues.) */
-            Interaction3f ref_it(0.f, time, dr::zeros<Wavelength>(),
-                                 sensor->world_transform().translation());
-
-            auto [ds, dir_weight] = emitter->sample_direction(
-                ref_it, sampler->next_2d(active), active_e);
-
-            /* Note: `dir_weight` already includes the emitter radiance, but
-               that will be accounted for again when sampling the wavelength
-               below. Instead, we recompute just the factor due to the PDF.
-               Also, convert to area measure. */
-            emitter_weight[active_e] =
-                dr::select(ds.pdf > 0.f, dr::rcp(ds.pdf), 0.f) *
-                dr::square(ds.dist);
-
-            si[active_e] = SurfaceInteraction3f(ds, ref_it.wavelengths);
-        }
-
-        // 3.b. Finite emitters
-        active_e = active && !is_infinite;
-        if (dr::any_or<true>(active_e)) {
-            auto [ps, pos_weight] =
-                emitter->sample_position(time, sampler->next_2d(active), active_e);
+    TensorXf render(Scene *scene, Sensor *sensor, uint32_t seed, uint32_t spp,
+                    bool develop, bool evaluate) override {
+        if constexpr (!dr::is_jit_v<Float>)
+            build_photon_map(scene, sensor, seed);
+        return Base::render(scene, sensor, seed, spp, develop, evaluate);
+    }
 
-            emitter_weight[active_e] = pos_weight;
-            si[active_e] = SurfaceInteraction3f(ps, dr::zeros<Wavelength>());
+    /// Trace photons from the emitters and store them in the photon map
+    void build_photon_map(const Scene *scene, const Sensor *sensor,
+                          uint32_t seed) {
+        Timer timer;
+        Log(Info, "Tracing %i photon paths ..", m_photon_count);
+
+        ScalarFloat radius = m_lookup_radius;
+        if (radius == 0.f)
+            radius = 0.05f * dr::norm(scene->bbox().extents());
+        m_radius2 = dr::square(radius);
+
+        // Photons of every work unit are stored separately (deterministic order)
+        const uint32_t grain_size = 4096;
+        uint32_t unit_count = (m_photon_count + grain_size - 1) / grain_size;
+        std::vector<std::vector<ScalarPoint3f>> positions(unit_count);
+        std::vector<std::vector<Photon>> photons(unit_count);
+        ScalarFloat scale = 1.f / m_photon_count;
+
+        ThreadEnvironment env;
+        dr::parallel_for(
+            dr::blocked_range<uint32_t>(0, unit_count, 1),
+            [&](const dr::blocked_range<uint32_t> &range) {
+                ScopedSetThreadEnvironment set_env(env);
+                ref<Sampler> sampler = m_sampler->clone();
+
+                for (uint32_t unit = range.begin(); unit != range.end(); ++unit) {
+                    sampler->seed(sample_tea_32(seed, unit).first);
+                    uint32_t end = std::min((uint32_t) m_photon_count,
+                                            (unit + 1) * grain_size);
+                    for (uint32_t i = unit * grain_size; i < end; ++i) {
+                        trace_photon(scene, sensor, sampler, scale,
+                                     positions[unit], photons[unit]);
+                        sampler->advance();
+                    }
+                }
+            }
+        );
+
+        size_t size = 0;
+        for (auto &p : positions)
+            size += p.size();
+
+        std::vector<ScalarPoint3f> all_positions;
+        std::vector<Photon> all_photons;
+        all_positions.reserve(size);
+        all_photons.reserve(size);
+        for (uint32_t i = 0; i < unit_count; ++i) {
+            all_positions.insert(all_positions.end(), positions[i].begin(),
+                                 positions[i].end());
+            all_photons.insert(all_photons.end(), photons[i].begin(),
+                               photons[i].end());
         }
 
-        /* 4. Connect to the sensor.
-           Query sensor for a direction connecting to `si.p`, which also
-           produces UVs on the sensor (for splatting). The resulting direction
-           points from si.p (on the emitter) toward the sensor. */
-        auto [sensor_ds, sensor_weight] = sensor->sample_direction(si, sampler->next_2d(), active);
-        si.wi = sensor_ds.d;
-
-        // 5. Sample spectrum of the emitter (accounts for its radiance)
-        auto [wavelengths, wav_weight] =
-            emitter->sample_wavelengths(si, sampler->next_1d(active), active);
-        si.wavelengths = wavelengths;
-        si.shape       = emitter->shape();
+        // Build the kd-tree and store the photons in the same order
+        m_tree.build(std::move(all_positions));
+        const std::vector<uint32_t> &perm = m_tree.permutation();
+        m_photons.resize(size);
+        for (size_t i = 0; i < size; ++i)
+            m_photons[i] = all_photons[perm[i]];
 
-        Spectrum weight = emitter_idx_weight * emitter_weight * wav_weight * sensor_weight;
-
-        // No BSDF passed (should not evaluate it since there's no scattering)
-        connect_sensor(scene, si, sensor_ds, nullptr, weight, block, sample_scale, active);
+        Log(Info, "Built a photon map with %zu photons (%s, took %s)", size,
+            util::mem_string(size * (sizeof(Photon) + sizeof(ScalarPoint3f))),
+            util::time_string((float) timer.value()));
     }
 
-    /// Samples a ray from a random emitter in the scene.
-    std::pair<Ray3f, Spectrum> prepare_ray(const Scene *scene,
-                                           const Sensor *sensor,
-                                           Sampler *sampler) const {
-        Float time = sensor->shutter_open();
-        if (sensor->shutter_open_time() > 0)
-            time += sampler->next_1d() * sensor->shutter_open_time();
-
-        // Prepare random samples.
-        Float wavelength_sample  = sampler->next_1d();
-        Point2f direction_sample = sampler->next_2d(),
-                position_sample  = sampler->next_2d();
-
-        // Sample one ray from an emitter in the scene.
-        auto [ray, ray_weight, emitter] = scene->sample_emitter_ray(
-            time, wavelength_sample, direction_sample, position_sample);
-
-        return { ray, ray_weight };
-    }
+    /// Trace a single photon path and record its non-specular interactions
+    void trace_photon(const Scene *scene, const Sensor *sensor,
+                      Sampler *sampler, ScalarFloat scale,
+                      std::vector<ScalarPoint3f> &positions,
+                      std::vector<Photon> &photons) const {
+        if constexpr (!dr::is_jit_v<Float>) {
+            Float time = sensor->shutter_open();
+            if (sensor->shutter_open_time() > 0.f)
+                time += sampler->next_1d() * sensor->shutter_open_time();
+
+            auto [ray, weight, emitter] = scene->sample_emitter_ray(
+                time, sampler->next_1d(), sampler->next_2d(), sampler->next_2d());
+            DRJIT_MARK_USED(emitter);
+
+            Spectrum throughput = weight * scale;
+            Float weight_max = dr::max(weight), eta = 1.f;
+            if (!(weight_max > 0.f))
+                return;
 
-    /**
-     * Intersects the given ray with the scene and recursively trace using
-     * BSDF sampling. The given `throughput` should account for emitted
-     * radiance from the sampled light source, wavelengths sampling weights,
-     * etc. At each interaction, we attempt to connect to the sensor and add
-     * the current radiance to the given `block`.
-     *
-     * Note: this will *not* account for directly visible emitters, since
-     * they require a direct connection from the emitter to the sensor. See
-     * \ref sample_visible_emitters.
-     *
-     * \return The radiance along the ray and an alpha value.
-     */
-    std::pair<Spectrum, Float>
-    trace_light_ray(Ray3f ray, const Scene *scene, const Sensor *sensor,
-                    Sampler *sampler, Spectrum throughput, ImageBlock *block,
-                    ScalarFloat sample_scale, Mask active = true) const {
-        // Tracks radiance scaling due to index of refraction changes
-        Float eta(1.f);
-
-        Int32 depth = 1;
-
-        /* ---------------------- Path construction ------------------------- */
-        // First intersection from the emitter to the scene
-        SurfaceInteraction3f si = scene->ray_intersect(ray, active);
-
-        active &= si.is_valid();
-        if (m_max_depth >= 0)
-            active &= depth < m_max_depth;
-
-        /* Set up a Dr.Jit loop (optimizes away to a normal loop in scalar mode,
-           generates wavefront or megakernel renderer based on configuration).
-           Register everything that changes as part of the loop here */
-        struct LoopState {
-            Bool active;
-            Int32 depth;
-            Ray3f ray;
-            Spectrum throughput;
-            SurfaceInteraction3f si;
-            Float eta;
-            Sampler* sampler;
-
-            DRJIT_STRUCT(LoopState, active, depth, ray, throughput, si, eta,
-                         sampler)
-        } ls = {
-            active,
-            depth,
-            ray,
-            throughput,
-            si,
-            eta,
-            sampler
-        };
-
-        // Incrementally build light path using BSDF sampling.
-        dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
-            [](const LoopState& ls) { return ls.active; },
-            [this, scene, sensor, block, sample_scale](LoopState& ls) {
-
-            BSDFPtr bsdf = ls.si.bsdf(ls.ray);
-
-            /* Connect to sensor and splat if successful. Sample a direction
-               from the sensor to the current surface point. */
-            auto [sensor_ds, sensor_weight] =
-                sensor->sample_direction(ls.si, ls.sampler->next_2d(), ls.active);
-            connect_sensor(scene, ls.si, sensor_ds, bsdf,
-                           ls.throughput * sensor_weight, block, sample_scale,
-                           ls.active);
-
-            /* ----------------------- BSDF sampling ------------------------ */
-            // Sample BSDF * cos(theta).
             BSDFContext ctx(TransportMode::Importance);
-            auto [bs, bsdf_val] =
-                bsdf->sample(ctx, ls.si, ls.sampler->next_1d(ls.active),
-                             ls.sampler->next_2d(ls.active), ls.active);
-
-            // Using geometric normals (wo points to the camera)
-            Float wi_dot_geo_n = dr::dot(ls.si.n, -ls.ray.d),
-                  wo_dot_geo_n = dr::dot(ls.si.n, ls.si.to_world(bs.wo));
-
-            // Prevent light leaks due to shading normals
-            ls.active &= (wi_dot_geo_n * Frame3f::cos_theta(ls.si.wi) > 0.f) &&
-                         (wo_dot_geo_n * Frame3f::cos_theta(bs.wo) > 0.f);
-
-            // Adjoint BSDF for shading normals -- [Veach, p. 155]
-            Float correction = dr::abs((Frame3f::cos_theta(ls.si.wi) * wo_dot_geo_n) /
-                                       (Frame3f::cos_theta(bs.wo) * wi_dot_geo_n));
-            ls.throughput *= bsdf_val * correction;
-            ls.eta *= bs.eta;
-
-            ls.active &= dr::any(unpolarized_spectrum(ls.throughput) != 0.f);
-            if (dr::none_or<false>(ls.active))
-                return;
+            for (uint32_t depth = 1; depth < m_max_depth; ++depth) {
+                SurfaceInteraction3f si = scene->ray_intersect(ray);
+                if (!si.is_valid())
+                    break;
 
-            // Intersect the BSDF ray against scene geometry (next vertex).
-            ls.ray = ls.si.spawn_ray(ls.si.to_world(bs.wo));
-            ls.si = scene->ray_intersect(ls.ray, ls.active);
-
-            ls.depth++;
-            if (m_max_depth >= 0)
-                ls.active &= ls.depth < m_max_depth;
-            ls.active &= ls.si.is_valid();
-
-            // Russian Roulette
-            Mask use_rr = ls.depth > m_rr_depth;
-            if (dr::any_or<true>(use_rr)) {
-                Float q = dr::minimum(
-                    dr::max(unpolarized_spectrum(ls.throughput)) * dr::square(ls.eta),
-                    0.95f
-                );
-                dr::masked(ls.active, use_rr) &= ls.sampler->next_1d(ls.active) < q;
-                dr::masked(ls.throughput, use_rr) *= dr::rcp(q);
-            }
-        },
-        "Particle Tracer Integrator");
+                BSDFPtr bsdf = si.bsdf(ray);
 
-        return { ls.throughput, 1.f };
-    }
+                /* Store the photon on non-specular surfaces. The first hit
+                   is skipped since direct illumination is computed using
+                   emitter sampling. */
+                if (depth > 1 && has_flag(bsdf->flags(), BSDFFlags::Smooth)) {
+                    positions.push_back(si.p);
+                    photons.push_back({ -ray.d, si.n, throughput });
+                }
 
-    /**
-     * Attempt connecting the given point to the sensor.
-     *
-     * If the point to connect is on the surface (non-null `bsdf` values),
-     * evaluate the BSDF in the direction of the sensor.
-     *
-     * Finally, splat `weight` (with all appropriate factors) to the
-     * given image block.
-     *
-     * \return The quantity that was accumulated to the block.
-     */
-    Spectrum connect_sensor(const Scene *scene, const SurfaceInteraction3f &si,
-                            const DirectionSample3f &sensor_ds,
-                            const BSDFPtr &bsdf, const Spectrum &weight,
-                            ImageBlock *block, ScalarFloat sample_scale,
-                            Mask active) const {
-        active &= (sensor_ds.pdf > 0.f) &&
-                  dr::any(unpolarized_spectrum(weight) != 0.f);
-        if (dr::none_or<false>(active))
-            return 0.f;
+                if (depth + 1 >= m_max_depth)
+                    break;
 
-        // Check that sensor is visible from current position (shadow ray).
-        Ray3f sensor_ray = si.spawn_ray_to(sensor_ds.p);
-        active &= !scene->ray_test(sensor_ray, active);
-        if (dr::none_or<false>(active))
-            return 0.f;
+                auto [bs, bsdf_weight] =
+                    bsdf->sample(ctx, si, sampler->next_1d(), sampler->next_2d());
 
-        // Foreshortening term and BSDF value for that direction (for surface interactions).
-        Spectrum result = 0.f;
-        Spectrum surface_weight = 1.f;
-        Vector3f local_d        = si.to_local(sensor_ray.d);
-        Mask on_surface         = active && (si.shape != nullptr);
-        if (dr::any_or<true>(on_surface)) {
-            /* Note that foreshortening is only missing for directly visible
-               emitters associated with a shape. Otherwise it's included in the
-               BSDF. Clamp negative cosines (zero value if behind the surface). */
-
-            surface_weight[on_surface && (bsdf == nullptr)] *=
-                dr::maximum(0.f, Frame3f::cos_theta(local_d));
-
-            on_surface &= bsdf != nullptr;
-            if (dr::any_or<true>(on_surface)) {
-                BSDFContext ctx(TransportMode::Importance);
                 // Using geometric normals
-                Float wi_dot_geo_n = dr::dot(si.n, si.to_world(si.wi)),
-                      wo_dot_geo_n = dr::dot(si.n, sensor_ray.d);
+                Float wi_dot_geo_n = dr::dot(si.n, -ray.d),
+                      wo_dot_geo_n = dr::dot(si.n, si.to_world(bs.wo));
 
                 // Prevent light leaks due to shading normals
-                Mask valid = (wi_dot_geo_n * Frame3f::cos_theta(si.wi) > 0.f) &&
-                             (wo_dot_geo_n * Frame3f::cos_theta(local_d) > 0.f);
+                if (wi_dot_geo_n * Frame3f::cos_theta(si.wi) <= 0.f ||
+                    wo_dot_geo_n * Frame3f::cos_theta(bs.wo) <= 0.f)
+                    break;
 
                 // Adjoint BSDF for shading normals -- [Veach, p. 155]
-                Float correction = dr::select(valid,
-                    dr::abs((Frame3f::cos_theta(si.wi) * wo_dot_geo_n) /
-                            (Frame3f::cos_theta(local_d) * wi_dot_geo_n)), 0.f);
-
-                surface_weight[on_surface] *=
-                    correction * bsdf->eval(ctx, si, local_d, on_surface);
+                Float correction = dr::abs((Frame3f::cos_theta(si.wi) * wo_dot_geo_n) /
+                                           (Frame3f::cos_theta(bs.wo) * wi_dot_geo_n));
+                throughput *= bsdf_weight * correction;
+                eta *= bs.eta;
+
+                Float throughput_max = dr::max(throughput) / (weight_max * scale);
+                if (!(throughput_max > 0.f))
+                    break;
+
+                // Russian roulette (relative to the initial photon power)
+                if (depth >= m_rr_depth) {
+                    Float q = dr::minimum(throughput_max * dr::square(eta), .95f);
+                    if (sampler->next_1d() >= q)
+                        break;
+                    throughput *= dr::rcp(q);
+                }
+
+                ray = si.spawn_ray(si.to_world(bs.wo));
             }
+        } else {
+            DRJIT_MARK_USED(scene); DRJIT_MARK_USED(sensor);
+            DRJIT_MARK_USED(sampler); DRJIT_MARK_USED(scale);
+            DRJIT_MARK_USED(positions); DRJIT_MARK_USED(photons);
         }
+    }
 
-        /* Even if the ray is not coming from a surface (no foreshortening),
-           we still don't want light coming from behind the emitter. */
-        Mask not_on_surface = active && (si.shape == nullptr) && (bsdf == nullptr);
-        if (dr::any_or<true>(not_on_surface)) {
-            Mask invalid_side = Frame3f::cos_theta(local_d) <= 0.f;
-            surface_weight[not_on_surface && invalid_side] = 0.f;
-        }
-
-        result = weight * surface_weight * sample_scale;
+    std::pair<Spectrum, Bool> sample(const Scene *scene,
+                                     Sampler *sampler,
+                                     const RayDifferential3f &ray_,
+                                     const Medium * /* medium */,
+                                     Float * /* aovs */,
+                                     Bool active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
+
+        if constexpr (!dr::is_jit_v<Float>) {
+            if (unlikely(m_max_depth == 0 || !active))
+                return { 0.f, false };
+
+            Ray3f ray = Ray3f(ray_);
+            Spectrum throughput = 1.f, result = 0.f;
+            Float eta = 1.f;
+            bool valid_ray = !m_hide_emitters && scene->environment() != nullptr;
+
+            for (uint32_t depth = 0;; ++depth) {
+                SurfaceInteraction3f si =
+                    scene->ray_intersect(ray, +RayFlags::All, depth == 0);
+
+                /* Emitters that are hit directly or after specular scattering
+                   (all other emission is accounted for by emitter sampling) */
+                const Emitter *emitter = si.emitter(scene);
+                if (emitter && (depth > 0 || !m_hide_emitters))
+                    result += throughput * emitter->eval(si);
+
+                if (!si.is_valid() || depth + 1 >= m_max_depth)
+                    break;
+
+                BSDFPtr bsdf = si.bsdf(ray);
+                uint32_t flags = bsdf->flags();
+                valid_ray |= !has_flag(flags, BSDFFlags::Null);
+
+                if (has_flag(flags, BSDFFlags::Smooth)) {
+                    // Direct illumination using emitter sampling
+                    BSDFContext ctx;
+                    auto [ds, em_weight] =
+                        scene->sample_emitter_direction(si, sampler->next_2d(), true);
+                    if (ds.pdf != 0.f) {
+                        Vector3f wo = si.to_local(ds.d);
+                        result += throughput * bsdf->eval(ctx, si, wo) * em_weight;
+                    }
+
+                    // Indirect illumination using the photon map
+                    if (depth + 2 < m_max_depth)
+                        result += throughput * photon_estimate(si, bsdf);
+                }
+
+                // Continue along the specular components of the BSDF
+                if (!has_flag(flags, BSDFFlags::Delta))
+                    break;
+
+                BSDFContext ctx_delta(TransportMode::Radiance,
+                                      (uint32_t) BSDFFlags::Delta);
+                auto [bs, bsdf_weight] = bsdf->sample(
+                    ctx_delta, si, sampler->next_1d(), sampler->next_2d());
+
+                throughput *= bsdf_weight;
+                eta *= bs.eta;
+
+                Float throughput_max = dr::max(throughput);
+                if (!(throughput_max > 0.f))
+                    break;
+
+                if (depth + 1 >= m_rr_depth) {
+                    Float q = dr::minimum(throughput_max * dr::square(eta), .95f);
+                    if (sampler->next_1d() >= q)
+                        break;
+                    throughput *= dr::rcp(q);
+                }
+
+                ray = si.spawn_ray(si.to_world(bs.wo));
+            }
 
-        /* Splatting, adjusting UVs for sensor's crop window if needed.
-           The crop window is already accounted for in the UV positions
-           returned by the sensor, here we just need to compensate for
-           the block's offset that will be applied in `put`. */
-        Float alpha = dr::select(bsdf != nullptr, 1.f, 0.f);
-        Vector2f adjusted_position = sensor_ds.uv + block->offset();
+            return { valid_ray ? result : Spectrum(0.f), valid_ray };
+        } else {
+            DRJIT_MARK_USED(scene); DRJIT_MARK_USED(sampler);
+            DRJIT_MARK_USED(ray_);
+            Throw("The photon mapper is only supported in scalar variants!");
+        }
+    }
 
-        /* Splat RGB value onto the image buffer. The particle tracer
-           does not use the weight channel at all */
-        block->put(adjusted_position, si.wavelengths, result, alpha,
-                   /* weight = */ 0.f, active);
+    /**
+     * \brief Estimate the radiance reflected towards \c si.wi from the
+     * density of the nearest photons
+     */
+    Spectrum photon_estimate(const SurfaceInteraction3f &si,
+                             const BSDF *bsdf) const {
+        if constexpr (!dr::is_jit_v<Float>) {
+            thread_local std::vector<SearchResult> results;
+            results.resize(m_lookup_size);
+
+            ScalarFloat radius2 = m_radius2;
+            size_t count = m_tree.nn_search(si.p, (size_t) m_lookup_size,
+                                            radius2, results.data());
+            if (count == 0)
+                return 0.f;
+
+            BSDFContext ctx;
+            Spectrum result = 0.f;
+            for (size_t i = 0; i < count; ++i) {
+                const Photon &photon = m_photons[results[i].index];
+
+                // Discard photons on surfaces with a different orientation
+                if (dr::dot(photon.n, si.n) < .1f)
+                    continue;
+
+                Vector3f wo = si.to_local(photon.wi);
+                Float cos_theta = dr::abs(Frame3f::cos_theta(wo));
+                if (cos_theta > 0.f)
+                    result += bsdf->eval(ctx, si, wo) * photon.power / cos_theta;
+            }
 
-        return result;
+            return result * (dr::InvPi<Float> / radius2);
+        } else {
+            DRJIT_MARK_USED(si); DRJIT_MARK_USED(bsdf);
+            return 0.f;
+        }
     }
 
-    //! @}
-    // =============================================================
-
     std::string to_string() const override {
         return tfm::format("PhotonMapperIntegrator[\n"
-                           "  max_depth = %i,\n"
-                           "  rr_depth = %i\n"
+                           "  photon_count = %i,\n"
+                           "  lookup_size = %i,\n"
+                           "  lookup_radius = %f,\n"
+                           "  photons = %zu,\n"
+                           "  max_depth = %u,\n"
+                           "  rr_depth = %u\n"
                            "]",
-                           m_max_depth, m_rr_depth);
+                           m_photon_count, m_lookup_size, m_lookup_radius,
+                           m_photons.size(), m_max_depth, m_rr_depth);
     }
 
     MI_DECLARE_CLASS()
+private:
+    int32_t m_photon_count;
+    int32_t m_lookup_size;
+    ScalarFloat m_lookup_radius;
+    ScalarFloat m_radius2 = 0.f;
+    ref<Sampler> m_sampler;
+
+    PhotonTree m_tree;
+    std::vector<Photon> m_photons;
 };
 
-MI_IMPLEMENT_CLASS_VARIANT(PhotonMapperIntegrator, AdjointIntegrator);
+MI_IMPLEMENT_CLASS_VARIANT(PhotonMapperIntegrator, MonteCarloIntegrator);
 MI_EXPORT_PLUGIN(PhotonMapperIntegrator, "Photon Mapper integrator");
 NAMESPACE_END(mitsuba)
@@ -1,3 +1,5 @@
+#include <mitsuba/core/atomic.h>
+#include <mitsuba/core/distr_1d.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/ray.h>
 #include <mitsuba/render/integrator.h>
@@ -37,6 +39,25 @@ Particle tracer (:monosp:`ptracer`)
    - If specified, divides the workload in successive passes with :paramtype:`samples_per_pass`
      samples per pixel.
 
+ * - emission_training_passes
+   - |int|
+   - Number of training passes that learn where to emit particles before the
+     final image is rendered (see below). (Default: 0, i.e. disabled)
+
+ * - emission_training_spp
+   - |int|
+   - Number of samples per pixel of every training pass. (Default: 1)
+
+ * - emission_resolution
+   - |int|
+   - Resolution of the learned emission distribution along each of the two
+     spatial and two directional dimensions of every emitter. (Default: 8)
+
+ * - emission_uniform_fraction
+   - |float|
+   - Probability of emitting particles with the default strategy of the scene
+     instead of the learned distribution. (Default: 0.2)
+
 This integrator traces rays starting from light sources and attempts to connect them
 to the sensor at each bounce.
 It does not support media (volumes).
@@ -50,6 +71,20 @@ possible to divide the workload in image-space tiles. The :paramtype:`samples_pe
 allows splitting work in successive passes of the given sample count per pixel. It is particularly
 useful in wavefront mode.
 
+By default, particles are emitted without any knowledge of which parts of the
+scene are visible to the sensor, which wastes most of them in large scenes
+with many emitters. When :paramtype:`emission_training_passes` is positive,
+the integrator instead learns an emission distribution before rendering the
+final image. Every training pass records the sensor contributions of its
+particles on a grid over the random numbers that each emitter turns into the
+position and the direction of a particle, and the following passes emit
+particles proportionally to these contributions. The training images are
+discarded. Particles are emitted from a mixture of the learned distribution
+and the default strategy (selected with probability
+:paramtype:`emission_uniform_fraction`), whose density is used to weight
+every particle. The image therefore remains unbiased, even where the
+training passes found no contributions.
+
 .. tabs::
     .. code-tab::  xml
 
@@ -67,27 +102,113 @@ useful in wavefront mode.
 template <typename Float, typename Spectrum>
 class ParticleTracerIntegrator final : public AdjointIntegrator<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(AdjointIntegrator, m_samples_per_pass, m_hide_emitters,
-                    m_rr_depth, m_max_depth)
+    MI_IMPORT_BASE(AdjointIntegrator, connect_sensor, m_samples_per_pass,
+                    m_hide_emitters, m_rr_depth, m_max_depth, record_event,
+                    record_path, should_stop, m_progressive,
+                    m_checkpoint_path)
     MI_IMPORT_TYPES(Scene, Sensor, Film, Sampler, ImageBlock, Emitter,
                      EmitterPtr, BSDF, BSDFPtr)
 
-    ParticleTracerIntegrator(const Properties &props) : Base(props) { }
+    using FloatStorage = DynamicBuffer<Float>;
+
+    ParticleTracerIntegrator(const Properties &props) : Base(props) {
+        int training_passes = props.get<int>("emission_training_passes", 0),
+            training_spp = props.get<int>("emission_training_spp", 1),
+            resolution = props.get<int>("emission_resolution", 8);
+        if (training_passes < 0)
+            Throw("\"emission_training_passes\" must be non-negative!");
+        if (training_spp <= 0)
+            Throw("\"emission_training_spp\" must be positive!");
+        if (resolution <= 0)
+            Throw("\"emission_resolution\" must be positive!");
+        m_training_passes = (uint32_t) training_passes;
+        m_training_spp = (uint32_t) training_spp;
+        m_resolution = (uint32_t) resolution;
+
+        m_uniform_fraction =
+            props.get<ScalarFloat>("emission_uniform_fraction", .2f);
+        if (m_uniform_fraction <= 0.f || m_uniform_fraction > 1.f)
+            Throw("\"emission_uniform_fraction\" must be in the interval (0, 1]!");
+    }
+
+    using Base::render;
+
+    TensorXf render(Scene *scene, Sensor *sensor, uint32_t seed, uint32_t spp,
+                    bool develop, bool evaluate) override {
+        m_emission.reset();
+        if (m_training_passes == 0 || scene->emitters().empty())
+            return Base::render(scene, sensor, seed, spp, develop, evaluate);
+
+        Sampler *sampler = sensor->sampler();
+        uint32_t final_spp = spp ? spp : sampler->sample_count();
+
+        // The training passes are regular, single-pass renderings
+        bool progressive = m_progressive;
+        fs::path checkpoint_path = m_checkpoint_path;
+        uint32_t samples_per_pass = m_samples_per_pass;
+        m_progressive = false;
+        m_checkpoint_path.clear();
+        m_samples_per_pass = (uint32_t) -1;
+
+        for (uint32_t i = 0; i < m_training_passes; ++i) {
+            reset_training(scene);
+            m_recording = true;
+            Base::render(scene, sensor, sample_tea_32(seed, i + 1).first,
+                         m_training_spp, false, true);
+            m_recording = false;
+            if (should_stop())
+                break;
+
+            update_emission();
+            Log(Info, "Particle tracer: emission training pass %u/%u completed.",
+                i + 1, m_training_passes);
+        }
+
+        m_progressive = progressive;
+        m_checkpoint_path = checkpoint_path;
+        m_samples_per_pass = samples_per_pass;
+        m_train = FloatStorage();
+        m_train_host.reset();
+
+        return Base::render(scene, sensor, seed, final_spp, develop, evaluate);
+    }
 
     void sample(const Scene *scene, const Sensor *sensor, Sampler *sampler,
                 ImageBlock *block, ScalarFloat sample_scale) const override {
+        bool recording = m_recording;
+
         // Account for emitters directly visible from the sensor
         if (m_max_depth != 0 && !m_hide_emitters)
             sample_visible_emitters(scene, sensor, sampler, block, sample_scale);
 
         // Primary & further bounces illumination
-        auto [ray, throughput] = prepare_ray(scene, sensor, sampler);
+        UInt32 cell;
+        auto [ray, throughput] =
+            prepare_ray(scene, sensor, sampler,
+                        m_training_passes > 0 ? &cell : nullptr);
 
         Float throughput_max = dr::max(unpolarized_spectrum(throughput));
         Mask active = (throughput_max != 0.f);
+        record_event(RenderCounter::Samples,
+                     dr::full<Mask>(true, dr::width(throughput_max)));
 
+        Float contribution = 0.f;
         trace_light_ray(ray, scene, sensor, sampler, throughput, block,
-                        sample_scale, active);
+                        sample_scale, active,
+                        recording ? &contribution : nullptr);
+
+        // Record the sensor contributions on the grid of the emitter
+        if (recording) {
+            Mask valid = active && contribution > 0.f &&
+                         dr::isfinite(contribution);
+            if constexpr (dr::is_jit_v<Float>) {
+                dr::scatter_reduce(ReduceOp::Add, m_train, contribution, cell,
+                                   valid);
+            } else {
+                if (valid)
+                    m_train_host[cell] += contribution;
+            }
+        }
     }
 
     /**
@@ -169,10 +290,18 @@ public:
         connect_sensor(scene, si, sensor_ds, nullptr, weight, block, sample_scale, active);
     }
 
-    /// Samples a ray from a random emitter in the scene.
+    /**
+     * Samples a ray from a random emitter in the scene.
+     *
+     * When \c cell is specified, the ray is sampled from the mixture of the
+     * default emitter sampling strategy and the learned emission distribution
+     * (if available), and \c cell receives the index of the grid cell of the
+     * sample in the learned distribution.
+     */
     std::pair<Ray3f, Spectrum> prepare_ray(const Scene *scene,
                                            const Sensor *sensor,
-                                           Sampler *sampler) const {
+                                           Sampler *sampler,
+                                           UInt32 *cell = nullptr) const {
         Float time = sensor->shutter_open();
         if (sensor->shutter_open_time() > 0)
             time += sampler->next_1d() * sensor->shutter_open_time();
@@ -182,11 +311,54 @@ public:
         Point2f direction_sample = sampler->next_2d(),
                 position_sample  = sampler->next_2d();
 
-        // Sample one ray from an emitter in the scene.
-        auto [ray, ray_weight, emitter] = scene->sample_emitter_ray(
+        if (!cell) {
+            // Sample one ray from an emitter in the scene.
+            auto [ray, ray_weight, emitter] = scene->sample_emitter_ray(
+                time, wavelength_sample, direction_sample, position_sample);
+
+            return { ray, ray_weight };
+        }
+
+        Float sample_mix = sampler->next_1d(),
+              sample_cell = sampler->next_1d();
+
+        // Select an emitter following the default strategy of the scene
+        UInt32 emitter_idx = std::get<0>(scene->sample_emitter(sample_cell));
+
+        // .. or a grid cell following the learned distribution
+        uint32_t res = m_resolution, cells = cell_count();
+        if (m_emission) {
+            Mask use_guide = sample_mix >= m_uniform_fraction;
+            if (dr::any_or<true>(use_guide)) {
+                UInt32 index = m_emission->sample(sample_cell, use_guide),
+                       local = index % cells;
+                dr::masked(emitter_idx, use_guide) = index / cells;
+
+                Point2f cell_dir(Float((local / (res * res * res)) % res),
+                                 Float((local / (res * res)) % res)),
+                        cell_pos(Float((local / res) % res),
+                                 Float(local % res));
+                dr::masked(direction_sample, use_guide) =
+                    (cell_dir + direction_sample) / (ScalarFloat) res;
+                dr::masked(position_sample, use_guide) =
+                    (cell_pos + position_sample) / (ScalarFloat) res;
+            }
+        }
+
+        *cell = emitter_idx * cells + cell_index(direction_sample, position_sample);
+
+        // Density of the sample w.r.t. the random numbers of the emitters
+        Float pdf = scene->pdf_emitter(emitter_idx);
+        if (m_emission)
+            pdf = dr::lerp(m_emission->eval_pmf_normalized(*cell) * (ScalarFloat) cells,
+                           pdf, m_uniform_fraction);
+
+        EmitterPtr emitter =
+            dr::gather<EmitterPtr>(scene->emitters_dr(), emitter_idx);
+        auto [ray, ray_weight] = emitter->sample_ray(
             time, wavelength_sample, direction_sample, position_sample);
 
-        return { ray, ray_weight };
+        return { ray, ray_weight * dr::select(pdf > 0.f, dr::rcp(pdf), 0.f) };
     }
 
     /**
@@ -200,12 +372,16 @@ public:
      * they require a direct connection from the emitter to the sensor. See
      * \ref sample_visible_emitters.
      *
+     * When \c contribution is specified, it accumulates the maximum
+     * component of every value splatted along the path.
+     *
      * \return The radiance along the ray and an alpha value.
      */
     std::pair<Spectrum, Float>
     trace_light_ray(Ray3f ray, const Scene *scene, const Sensor *sensor,
                     Sampler *sampler, Spectrum throughput, ImageBlock *block,
-                    ScalarFloat sample_scale, Mask active = true) const {
+                    ScalarFloat sample_scale, Mask active = true,
+                    Float *contribution = nullptr) const {
         // Tracks radiance scaling due to index of refraction changes
         Float eta(1.f);
 
@@ -214,10 +390,16 @@ public:
         /* ---------------------- Path construction ------------------------- */
         // First intersection from the emitter to the scene
         SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+        record_event(RenderCounter::ExtensionRays, active);
+        record_path(UInt32(depth - 1), PathTermination::Escaped,
+                    active && !si.is_valid());
 
         active &= si.is_valid();
-        if (m_max_depth >= 0)
+        if (m_max_depth >= 0) {
+            record_path(UInt32(depth), PathTermination::MaxDepth,
+                        active && depth >= m_max_depth);
             active &= depth < m_max_depth;
+        }
 
         /* Set up a Dr.Jit loop (optimizes away to a normal loop in scalar mode,
            generates wavefront or megakernel renderer based on configuration).
@@ -229,10 +411,11 @@ public:
             Spectrum throughput;
             SurfaceInteraction3f si;
             Float eta;
+            Float contribution;
             Sampler* sampler;
 
             DRJIT_STRUCT(LoopState, active, depth, ray, throughput, si, eta,
-                         sampler)
+                         contribution, sampler)
         } ls = {
             active,
             depth,
@@ -240,13 +423,16 @@ public:
             throughput,
             si,
             eta,
+            contribution ? *contribution : Float(0.f),
             sampler
         };
 
+        bool record = contribution != nullptr;
+
         // Incrementally build light path using BSDF sampling.
         dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
             [](const LoopState& ls) { return ls.active; },
-            [this, scene, sensor, block, sample_scale](LoopState& ls) {
+            [this, scene, sensor, block, sample_scale, record](LoopState& ls) {
 
             BSDFPtr bsdf = ls.si.bsdf(ls.ray);
 
@@ -254,9 +440,13 @@ public:
                from the sensor to the current surface point. */
             auto [sensor_ds, sensor_weight] =
                 sensor->sample_direction(ls.si, ls.sampler->next_2d(), ls.active);
-            connect_sensor(scene, ls.si, sensor_ds, bsdf,
-                           ls.throughput * sensor_weight, block, sample_scale,
-                           ls.active);
+            Spectrum splat =
+                connect_sensor(scene, ls.si, sensor_ds, bsdf,
+                               ls.throughput * sensor_weight, block,
+                               sample_scale, ls.active);
+            if (record)
+                dr::masked(ls.contribution, ls.active) +=
+                    dr::max(unpolarized_spectrum(splat));
 
             /* ----------------------- BSDF sampling ------------------------ */
             // Sample BSDF * cos(theta).
@@ -270,6 +460,7 @@ public:
                   wo_dot_geo_n = dr::dot(ls.si.n, ls.si.to_world(bs.wo));
 
             // Prevent light leaks due to shading normals
+            Mask scattered = ls.active;
             ls.active &= (wi_dot_geo_n * Frame3f::cos_theta(ls.si.wi) > 0.f) &&
                          (wo_dot_geo_n * Frame3f::cos_theta(bs.wo) > 0.f);
 
@@ -280,17 +471,25 @@ public:
             ls.eta *= bs.eta;
 
             ls.active &= dr::any(unpolarized_spectrum(ls.throughput) != 0.f);
+            record_path(UInt32(ls.depth), PathTermination::Absorbed,
+                        scattered && !ls.active);
             if (dr::none_or<false>(ls.active))
                 return;
 
             // Intersect the BSDF ray against scene geometry (next vertex).
             ls.ray = ls.si.spawn_ray(ls.si.to_world(bs.wo));
             ls.si = scene->ray_intersect(ls.ray, ls.active);
+            record_event(RenderCounter::ExtensionRays, ls.active);
 
             ls.depth++;
-            if (m_max_depth >= 0)
-                ls.active &= ls.depth < m_max_depth;
+            record_path(UInt32(ls.depth - 1), PathTermination::Escaped,
+                        ls.active && !ls.si.is_valid());
             ls.active &= ls.si.is_valid();
+            if (m_max_depth >= 0) {
+                record_path(UInt32(ls.depth), PathTermination::MaxDepth,
+                            ls.active && ls.depth >= m_max_depth);
+                ls.active &= ls.depth < m_max_depth;
+            }
 
             // Russian Roulette
             Mask use_rr = ls.depth > m_rr_depth;
@@ -299,99 +498,19 @@ public:
                     dr::max(unpolarized_spectrum(ls.throughput)) * dr::square(ls.eta),
                     0.95f
                 );
-                dr::masked(ls.active, use_rr) &= ls.sampler->next_1d(ls.active) < q;
+                Mask rr_continue = ls.sampler->next_1d(ls.active) < q;
+                record_path(UInt32(ls.depth), PathTermination::RussianRoulette,
+                            ls.active && use_rr && !rr_continue);
+                dr::masked(ls.active, use_rr) &= rr_continue;
                 dr::masked(ls.throughput, use_rr) *= dr::rcp(q);
             }
         },
         "Particle Tracer Integrator");
 
-        return { ls.throughput, 1.f };
-    }
+        if (contribution)
+            *contribution = ls.contribution;
 
-    /**
-     * Attempt connecting the given point to the sensor.
-     *
-     * If the point to connect is on the surface (non-null `bsdf` values),
-     * evaluate the BSDF in the direction of the sensor.
-     *
-     * Finally, splat `weight` (with all appropriate factors) to the
-     * given image block.
-     *
-     * \return The quantity that was accumulated to the block.
-     */
-    Spectrum connect_sensor(const Scene *scene, const SurfaceInteraction3f &si,
-                            const DirectionSample3f &sensor_ds,
-                            const BSDFPtr &bsdf, const Spectrum &weight,
-                            ImageBlock *block, ScalarFloat sample_scale,
-                            Mask active) const {
-        active &= (sensor_ds.pdf > 0.f) &&
-                  dr::any(unpolarized_spectrum(weight) != 0.f);
-        if (dr::none_or<false>(active))
-            return 0.f;
-
-        // Check that sensor is visible from current position (shadow ray).
-        Ray3f sensor_ray = si.spawn_ray_to(sensor_ds.p);
-        active &= !scene->ray_test(sensor_ray, active);
-        if (dr::none_or<false>(active))
-            return 0.f;
-
-        // Foreshortening term and BSDF value for that direction (for surface interactions).
-        Spectrum result = 0.f;
-        Spectrum surface_weight = 1.f;
-        Vector3f local_d        = si.to_local(sensor_ray.d);
-        Mask on_surface         = active && (si.shape != nullptr);
-        if (dr::any_or<true>(on_surface)) {
-            /* Note that foreshortening is only missing for directly visible
-               emitters associated with a shape. Otherwise it's included in the
-               BSDF. Clamp negative cosines (zero value if behind the surface). */
-
-            surface_weight[on_surface && (bsdf == nullptr)] *=
-                dr::maximum(0.f, Frame3f::cos_theta(local_d));
-
-            on_surface &= bsdf != nullptr;
-            if (dr::any_or<true>(on_surface)) {
-                BSDFContext ctx(TransportMode::Importance);
-                // Using geometric normals
-                Float wi_dot_geo_n = dr::dot(si.n, si.to_world(si.wi)),
-                      wo_dot_geo_n = dr::dot(si.n, sensor_ray.d);
-
-                // Prevent light leaks due to shading normals
-                Mask valid = (wi_dot_geo_n * Frame3f::cos_theta(si.wi) > 0.f) &&
-                             (wo_dot_geo_n * Frame3f::cos_theta(local_d) > 0.f);
-
-                // Adjoint BSDF for shading normals -- [Veach, p. 155]
-                Float correction = dr::select(valid,
-                    dr::abs((Frame3f::cos_theta(si.wi) * wo_dot_geo_n) /
-                            (Frame3f::cos_theta(local_d) * wi_dot_geo_n)), 0.f);
-
-                surface_weight[on_surface] *=
-                    correction * bsdf->eval(ctx, si, local_d, on_surface);
-            }
-        }
-
-        /* Even if the ray is not coming from a surface (no foreshortening),
-           we still don't want light coming from behind the emitter. */
-        Mask not_on_surface = active && (si.shape == nullptr) && (bsdf == nullptr);
-        if (dr::any_or<true>(not_on_surface)) {
-            Mask invalid_side = Frame3f::cos_theta(local_d) <= 0.f;
-            surface_weight[not_on_surface && invalid_side] = 0.f;
-        }
-
-        result = weight * surface_weight * sample_scale;
-
-        /* Splatting, adjusting UVs for sensor's crop window if needed.
-           The crop window is already accounted for in the UV positions
-           returned by the sensor, here we just need to compensate for
-           the block's offset that will be applied in `put`. */
-        Float alpha = dr::select(bsdf != nullptr, 1.f, 0.f);
-        Vector2f adjusted_position = sensor_ds.uv + block->offset();
-
-        /* Splat RGB value onto the image buffer. The particle tracer
-           does not use the weight channel at all */
-        block->put(adjusted_position, si.wavelengths, result, alpha,
-                   /* weight = */ 0.f, active);
-
-        return result;
+        return { ls.throughput, 1.f };
     }
 
     //! @}
@@ -400,12 +519,89 @@ public:
     std::string to_string() const override {
         return tfm::format("ParticleTracerIntegrator[\n"
                            "  max_depth = %i,\n"
-                           "  rr_depth = %i\n"
+                           "  rr_depth = %i,\n"
+                           "  emission_training_passes = %u,\n"
+                           "  emission_training_spp = %u,\n"
+                           "  emission_resolution = %u,\n"
+                           "  emission_uniform_fraction = %f\n"
                            "]",
-                           m_max_depth, m_rr_depth);
+                           m_max_depth, m_rr_depth, m_training_passes,
+                           m_training_spp, m_resolution, m_uniform_fraction);
     }
 
     MI_DECLARE_CLASS()
+
+protected:
+    /// Number of grid cells of the learned distribution of every emitter
+    uint32_t cell_count() const {
+        return m_resolution * m_resolution * m_resolution * m_resolution;
+    }
+
+    /// Index of the grid cell containing the given sample of an emitter
+    MI_INLINE UInt32 cell_index(const Point2f &direction_sample,
+                                const Point2f &position_sample) const {
+        auto bin = [res = m_resolution](const Float &value) {
+            return dr::minimum(UInt32(dr::maximum(value, 0.f) * (ScalarFloat) res),
+                               res - 1);
+        };
+        return ((bin(direction_sample.x()) * m_resolution +
+                 bin(direction_sample.y())) * m_resolution +
+                bin(position_sample.x())) * m_resolution +
+               bin(position_sample.y());
+    }
+
+    /// Clear the statistics recorded during a training pass
+    void reset_training(const Scene *scene) {
+        size_t size = scene->emitters().size() * cell_count();
+        if constexpr (dr::is_jit_v<Float>)
+            m_train = dr::zeros<FloatStorage>(size);
+        else
+            m_train_host.reset(new AtomicFloat<ScalarFloat>[size]);
+        m_train_size = size;
+    }
+
+    /// Rebuild the learned emission distribution from the recorded statistics
+    void update_emission() {
+        std::vector<ScalarFloat> train(m_train_size);
+
+        if constexpr (dr::is_jit_v<Float>) {
+            auto &&host = dr::migrate(m_train, AllocType::Host);
+            dr::sync_thread();
+            std::copy(host.data(), host.data() + m_train_size, train.data());
+        } else {
+            for (size_t i = 0; i < m_train_size; ++i)
+                train[i] = m_train_host[i];
+        }
+
+        double sum = 0.0;
+        for (ScalarFloat value : train)
+            sum += value;
+
+        if (sum == 0.0) {
+            Log(Warn, "Particle tracer: no particle reached the sensor during "
+                      "the training pass, keeping the previous emission "
+                      "distribution.");
+            return;
+        }
+
+        m_emission = std::make_unique<DiscreteDistribution<Float>>(
+            train.data(), train.size());
+    }
+
+private:
+    uint32_t m_training_passes;
+    uint32_t m_training_spp;
+    uint32_t m_resolution;
+    ScalarFloat m_uniform_fraction;
+
+    /// Learned distribution over the grid cells of all emitters
+    std::unique_ptr<DiscreteDistribution<Float>> m_emission;
+
+    /// Statistics recorded during the current training pass
+    bool m_recording = false;
+    size_t m_train_size = 0;
+    mutable FloatStorage m_train;
+    std::unique_ptr<AtomicFloat<ScalarFloat>[]> m_train_host;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(ParticleTracerIntegrator, AdjointIntegrator);
@@ -0,0 +1,559 @@
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/film.h>
+#include <mitsuba/render/imageblock.h>
+#include <mitsuba/render/integrator.h>
+#include <mitsuba/render/records.h>
+#include <mitsuba/render/sampler.h>
+#include <mitsuba/render/sensor.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _integrator-restir:
+
+Reservoir-based direct illumination (:monosp:`restir`)
+------------------------------------------------------
+
+.. pluginparameters::
+
+ * - candidates
+   - |int|
+   - Number of emitter samples drawn per pixel and frame, among which one
+     is selected by resampled importance sampling. (Default: 32)
+
+ * - temporal_reuse
+   - |bool|
+   - Combine the reservoir of every pixel with the one of the previous frame.
+     (Default: |true|)
+
+ * - max_history
+   - |int|
+   - Limit on the number of candidates represented by the reservoir of the
+     previous frame, relative to :paramtype:`candidates`. Lower values adapt
+     faster to changes of the scene. (Default: 20)
+
+ * - spatial_samples
+   - |int|
+   - Number of neighboring reservoirs combined with the reservoir of every
+     pixel. (Default: 5)
+
+ * - spatial_radius
+   - |float|
+   - Radius (in pixels) of the neighborhood from which the reservoirs are
+     chosen. (Default: 30)
+
+ * - hide_emitters
+   - |bool|
+   - Hide directly visible emitters. (Default: no, i.e. |false|)
+
+ * - reservoir_*
+   - |tensor|
+   - The per-pixel reservoirs of the last rendered frame, which persist across
+     calls to ``render()`` (see below).
+   - |exposed|
+
+This integrator renders direct illumination at the surfaces that are visible
+from the sensor using *spatiotemporal reservoir resampling* (ReSTIR DI) by
+Bitterli et al. ("Spatiotemporal reservoir resampling for real-time ray tracing
+with dynamic direct lighting", SIGGRAPH 2020). It is targeted at interactive
+previews of scenes with many emitters, which only afford a few samples per
+pixel.
+
+Every pixel keeps a *reservoir* storing a single emitter sample and the
+weight that turns it into an estimate of the direct illumination. Every frame,
+the integrator draws :paramtype:`candidates` samples via
+``Scene::sample_emitter_direction()`` and selects one according to the
+unshadowed contribution, which only requires a single shadow ray. The result
+is then merged with the reservoir of the pixel in the previous frame and with
+those of a few random neighbors, if their surfaces are similar. Every sample
+per pixel renders one frame, and their average is developed by the film.
+
+The reservoirs and the normals and depths of the visible surfaces persist
+across calls to ``render()``, so that the frames of an interactive viewer
+loop benefit from the history of the previous ones. They are exposed via
+:monosp:`mi.traverse()` under the names ``reservoir_position``,
+``reservoir_normal``, ``reservoir_radiance``, ``reservoir_flags``,
+``reservoir_weight`` and ``reservoir_count``. Setting ``reservoir_count`` to
+zero discards the history, e.g. after a cut of the animation.
+
+.. note:: The reuse of the reservoirs relies on the position of the pixels and
+   ignores the motion of the camera and of the objects: the history is only
+   discarded when the surface seen through a pixel changes. The combination
+   of the reservoirs uses the biased weights of the original method, which
+   slightly darken the image at geometric discontinuities. This integrator is
+   only available in JIT RGB and monochromatic variants.
+
+.. tabs::
+    .. code-tab::  xml
+        :name: restir-integrator
+
+        <integrator type="restir">
+            <integer name="candidates" value="16"/>
+        </integrator>
+
+    .. code-tab:: python
+
+        'type': 'restir',
+        'candidates': 16
+
+ */
+
+template <typename Float, typename Spectrum>
+class ReSTIRIntegrator final : public Integrator<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Integrator, should_stop, m_stop, m_render_timer,
+                   m_hide_emitters, m_passes_completed)
+    MI_IMPORT_TYPES(Scene, Sensor, Film, Sampler, ImageBlock, Emitter,
+                    EmitterPtr, BSDF, BSDFPtr)
+
+    /// Flags of the emitter sample stored in a reservoir
+    enum SampleFlags : uint32_t {
+        /// The sample is a direction towards an infinitely distant emitter
+        SampleInfinite = 1,
+        /// The sample lies on an emitter with a delta position
+        SampleDeltaPosition = 2
+    };
+
+    /// Emitter sample and weight of the reservoir of every pixel
+    struct Reservoir {
+        /// Position on the emitter (or direction, if infinite)
+        Point3f y;
+        /// Normal of the emitter surface (zero for points and directions)
+        Normal3f n;
+        /// Emitted radiance (or intensity, for delta positions)
+        Spectrum radiance;
+        UInt32 flags;
+        /// Unbiased contribution weight and number of represented candidates
+        Float W, M;
+
+        DRJIT_STRUCT(Reservoir, y, n, radiance, flags, W, M)
+    };
+
+    /// Reservoir during the resampling, with the sum of the weights
+    struct Stream {
+        Reservoir r;
+        Float w_sum, p_hat;
+
+        DRJIT_STRUCT(Stream, r, w_sum, p_hat)
+    };
+
+    ReSTIRIntegrator(const Properties &props) : Base(props) {
+        if constexpr (!dr::is_jit_v<Float> || is_spectral_v<Spectrum> ||
+                      is_polarized_v<Spectrum>)
+            Throw("The ReSTIR integrator is only supported in JIT RGB and "
+                  "monochromatic variants!");
+
+        int candidates      = props.get<int>("candidates", 32),
+            max_history     = props.get<int>("max_history", 20),
+            spatial_samples = props.get<int>("spatial_samples", 5);
+        if (candidates <= 0)
+            Throw("\"candidates\" must be positive!");
+        if (max_history <= 0)
+            Throw("\"max_history\" must be positive!");
+        if (spatial_samples < 0)
+            Throw("\"spatial_samples\" must be non-negative!");
+        m_candidates      = (uint32_t) candidates;
+        m_max_history     = (uint32_t) max_history;
+        m_spatial_samples = (uint32_t) spatial_samples;
+
+        m_temporal_reuse = props.get<bool>("temporal_reuse", true);
+        m_spatial_radius = props.get<ScalarFloat>("spatial_radius", 30.f);
+        if (m_spatial_radius < 0.f)
+            Throw("\"spatial_radius\" must be non-negative!");
+
+        Properties props_sampler("independent");
+        props_sampler.set_int("sample_count", 1);
+        m_sampler = PluginManager::instance()->create_object<Sampler>(props_sampler);
+    }
+
+    TensorXf render(Scene *scene, Sensor *sensor, uint32_t seed, uint32_t spp,
+                    bool develop, bool evaluate) override {
+        ScopedPhase sp(ProfilerPhase::Render);
+        m_stop = false;
+        m_passes_completed = 0;
+        m_render_timer.reset();
+
+        TensorXf result;
+        if constexpr (dr::is_jit_v<Float>) {
+            Film *film = sensor->film();
+            ScalarVector2u crop_size = film->crop_size();
+            ScalarPoint2i crop_offset(film->crop_offset());
+            uint32_t pixel_count = dr::prod(crop_size);
+
+            // One frame per sample
+            Sampler *sensor_sampler = sensor->sampler();
+            if (spp)
+                sensor_sampler->set_sample_count(spp);
+            uint32_t frames = sensor_sampler->sample_count();
+
+            Log(Info, "Starting render job (%ux%u, %u frame%s, %u candidate%s)",
+                crop_size.x(), crop_size.y(), frames, frames == 1 ? "" : "s",
+                m_candidates, m_candidates == 1 ? "" : "s");
+
+            // Discard the history if the film was resized
+            if (dr::width(m_reservoirs.M) != pixel_count ||
+                dr::width(m_depth) != pixel_count) {
+                m_reservoirs = dr::zeros<Reservoir>(pixel_count);
+                m_normal = dr::zeros<Normal3f>(pixel_count);
+                m_depth = dr::zeros<Float>(pixel_count);
+            }
+
+            ref<Sampler> sampler = m_sampler->clone();
+            Spectrum sum = dr::zeros<Spectrum>(pixel_count);
+            Float alpha = dr::zeros<Float>(pixel_count);
+
+            uint32_t it = 0;
+            for (; it < frames && !should_stop(); ++it) {
+                sampler->seed(sample_tea_32(seed, m_frame++).first, pixel_count);
+                auto [value, valid] = render_frame(scene, sensor, sampler);
+                sum += value;
+                alpha += dr::select(valid, 1.f, 0.f);
+                dr::eval(sum, alpha, m_reservoirs, m_normal, m_depth);
+                m_passes_completed = it + 1;
+            }
+
+            if (it > 0) {
+                Float scale = dr::rcp((ScalarFloat) it);
+
+                UInt32 idx = dr::arange<UInt32>(pixel_count);
+                Point2f pos(Float(idx % crop_size.x()) + .5f + crop_offset.x(),
+                            Float(idx / crop_size.x()) + .5f + crop_offset.y());
+
+                uint32_t channels = (uint32_t) film->prepare({});
+                ref<ImageBlock> block = new ImageBlock(
+                    crop_size, crop_offset, channels, nullptr /* box filter */,
+                    false /* border */);
+                block->put(pos, dr::zeros<Wavelength>(pixel_count), sum * scale,
+                           alpha * scale);
+                film->put_block(block);
+            }
+
+            if (develop) {
+                result = film->develop();
+                dr::schedule(result);
+            } else {
+                film->schedule_storage();
+            }
+
+            if (evaluate) {
+                dr::eval();
+                dr::sync_thread();
+            }
+
+            if (!m_stop && evaluate)
+                Log(Info, "Rendering finished. (took %s)",
+                    util::time_string((float) m_render_timer.value(), true));
+        } else {
+            DRJIT_MARK_USED(scene); DRJIT_MARK_USED(sensor);
+            DRJIT_MARK_USED(seed); DRJIT_MARK_USED(spp);
+            DRJIT_MARK_USED(develop); DRJIT_MARK_USED(evaluate);
+            Throw("The ReSTIR integrator is only supported in JIT variants!");
+        }
+
+        return result;
+    }
+
+    /**
+     * \brief Render one frame with a sample per pixel and update the
+     * persistent reservoirs
+     *
+     * Returns the radiance of every pixel and a mask denoting the pixels
+     * whose ray hit the scene.
+     */
+    std::pair<Spectrum, Mask> render_frame(const Scene *scene,
+                                           const Sensor *sensor,
+                                           Sampler *sampler) {
+        const Film *film = sensor->film();
+        ScalarVector2u crop_size = film->crop_size();
+        uint32_t pixel_count = dr::prod(crop_size);
+
+        ScalarVector2f scale  = 1.f / ScalarVector2f(crop_size),
+                       offset = -ScalarVector2f(film->crop_offset()) * scale;
+
+        UInt32 idx = dr::arange<UInt32>(pixel_count);
+        Vector2i pixel(Int32(idx % crop_size.x()), Int32(idx / crop_size.x()));
+        Vector2f pos = Vector2f(pixel) + ScalarVector2f(film->crop_offset());
+
+        Vector2f adjusted_pos = dr::fmadd(pos + sampler->next_2d(), scale, offset);
+
+        Point2f aperture_sample(.5f);
+        if (sensor->needs_aperture_sample())
+            aperture_sample = sampler->next_2d();
+
+        Float time = sensor->shutter_open();
+        if (sensor->shutter_open_time() > 0.f)
+            time += sampler->next_1d() * sensor->shutter_open_time();
+
+        auto [ray, ray_weight] = sensor->sample_ray(time, 0.f, adjusted_pos,
+                                                    aperture_sample);
+
+        SurfaceInteraction3f si = scene->ray_intersect(
+            ray, +RayFlags::All, /* coherent = */ true);
+
+        Spectrum result = 0.f;
+        if (!m_hide_emitters) {
+            EmitterPtr emitter = si.emitter(scene);
+            if (dr::any_or<true>(emitter != nullptr))
+                result = emitter->eval(si);
+        }
+
+        BSDFPtr bsdf = si.bsdf(ray);
+        Mask active = si.is_valid() &&
+                      has_flag(bsdf->flags(), BSDFFlags::Smooth);
+        Normal3f normal = si.sh_frame.n;
+        Float depth = dr::select(active, si.t, 0.f);
+
+        // 1. Resampled importance sampling of the emitter samples
+        Stream s = initial_candidates(scene, sampler, si, bsdf, active);
+
+        // Visibility reuse: occluded samples do not propagate
+        Mask visible = test_visibility(scene, si, s.r, active);
+        dr::masked(s.w_sum, !visible) = 0.f;
+        finalize(s);
+
+        // 2. Temporal reuse of the reservoir of the previous frame
+        if (m_temporal_reuse) {
+            Mask similar = active && similar_surface(normal, depth, m_normal, m_depth);
+            Reservoir prev = m_reservoirs;
+            prev.M = dr::minimum(prev.M, (ScalarFloat) (m_max_history * m_candidates));
+            merge(s, prev, si, bsdf, sampler->next_1d(), similar);
+            finalize(s);
+        }
+
+        Reservoir temporal = s.r;
+        dr::eval(temporal, normal, depth);
+
+        // 3. Spatial reuse of the reservoirs of random neighbors
+        for (uint32_t i = 0; i < m_spatial_samples; ++i) {
+            Point2f sample = sampler->next_2d();
+            auto [sin_phi, cos_phi] = dr::sincos(dr::TwoPi<Float> * sample.y());
+            Vector2f offset = Vector2f(cos_phi, sin_phi) *
+                              (m_spatial_radius * dr::sqrt(sample.x()));
+
+            Vector2i neighbor = dr::clip(pixel + dr::round2int<Vector2i>(offset),
+                                         0, ScalarVector2i(crop_size) - 1);
+            UInt32 n_idx = UInt32(neighbor.y()) * crop_size.x() + UInt32(neighbor.x());
+
+            Mask valid = active && n_idx != idx;
+            Normal3f n_normal = dr::gather<Normal3f>(normal, n_idx, valid);
+            Float n_depth = dr::gather<Float>(depth, n_idx, valid);
+            valid &= similar_surface(normal, depth, n_normal, n_depth);
+
+            Reservoir r = dr::gather<Reservoir>(temporal, n_idx, valid);
+            merge(s, r, si, bsdf, sampler->next_1d(), valid);
+        }
+
+        if (m_spatial_samples > 0)
+            finalize(s);
+
+        // 4. Shade using the selected sample
+        Vector3f d;
+        Float dist;
+        Spectrum contrib = integrand(si, bsdf, s.r, d, dist, active);
+        visible = test_visibility(scene, si, s.r, active && s.r.W > 0.f);
+        result[visible] += contrib * s.r.W;
+
+        // Store the reservoirs for the next frame
+        m_reservoirs = s.r;
+        m_normal = normal;
+        m_depth = depth;
+
+        return { ray_weight * result, si.is_valid() };
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_parameter("reservoir_position", m_reservoirs.y,        +ParamFlags::NonDifferentiable);
+        callback->put_parameter("reservoir_normal",   m_reservoirs.n,        +ParamFlags::NonDifferentiable);
+        callback->put_parameter("reservoir_radiance", m_reservoirs.radiance, +ParamFlags::NonDifferentiable);
+        callback->put_parameter("reservoir_flags",    m_reservoirs.flags,    +ParamFlags::NonDifferentiable);
+        callback->put_parameter("reservoir_weight",   m_reservoirs.W,        +ParamFlags::NonDifferentiable);
+        callback->put_parameter("reservoir_count",    m_reservoirs.M,        +ParamFlags::NonDifferentiable);
+    }
+
+    std::string to_string() const override {
+        return tfm::format("ReSTIRIntegrator[\n"
+                           "  candidates = %u,\n"
+                           "  temporal_reuse = %s,\n"
+                           "  max_history = %u,\n"
+                           "  spatial_samples = %u,\n"
+                           "  spatial_radius = %f\n"
+                           "]",
+                           m_candidates, m_temporal_reuse ? "true" : "false",
+                           m_max_history, m_spatial_samples, m_spatial_radius);
+    }
+
+    MI_DECLARE_CLASS()
+
+protected:
+    /**
+     * \brief Evaluate the unshadowed contribution of the emitter sample of
+     * \c r at \c si
+     *
+     * The contribution is expressed with respect to the area measure on the
+     * emitters (or the solid angle measure, for infinite emitters), in which
+     * the weights of all reservoirs are defined irrespective of the shading
+     * point. Returns the direction and distance to the sample via \c d and
+     * \c dist.
+     */
+    Spectrum integrand(const SurfaceInteraction3f &si, const BSDFPtr &bsdf,
+                       const Reservoir &r, Vector3f &d, Float &dist,
+                       Mask active) const {
+        Mask infinite = (r.flags & (uint32_t) SampleInfinite) != 0u;
+
+        d = r.y - si.p;
+        Float dist2 = dr::squared_norm(d);
+        dist = dr::sqrt(dist2);
+        d /= dist;
+
+        // Geometry term for emitter surfaces and for points
+        Float cos_theta = -dr::dot(r.n, d),
+              g = dr::select(dr::squared_norm(r.n) > 0.f,
+                             dr::maximum(cos_theta, 0.f), 1.f) / dist2;
+
+        d[infinite] = r.y;
+        dist[infinite] = dr::Infinity<Float>;
+        g[infinite] = 1.f;
+
+        active &= r.M > 0.f && dr::isfinite(g);
+        Spectrum f = bsdf->eval(BSDFContext(), si, si.to_local(d), active);
+        return dr::select(active, f * r.radiance * g, 0.f);
+    }
+
+    /// Target function of the resampling
+    MI_INLINE Float target(const SurfaceInteraction3f &si,
+                           const Spectrum &value) const {
+        return dr::maximum(luminance(value, si.wavelengths), 0.f);
+    }
+
+    /// Trace a shadow ray to the emitter sample of \c r
+    Mask test_visibility(const Scene *scene, const SurfaceInteraction3f &si,
+                         const Reservoir &r, Mask active) const {
+        Mask infinite = (r.flags & (uint32_t) SampleInfinite) != 0u;
+        Ray3f ray = si.spawn_ray_to(r.y);
+        Ray3f ray_inf = si.spawn_ray(r.y);
+        dr::masked(ray, infinite) = ray_inf;
+        return active && !scene->ray_test(ray, active);
+    }
+
+    /// Stream \c m_candidates emitter samples through a new reservoir
+    Stream initial_candidates(const Scene *scene, Sampler *sampler,
+                              const SurfaceInteraction3f &si,
+                              const BSDFPtr &bsdf, Mask active) const {
+        struct LoopState {
+            Stream s;
+            UInt32 i;
+            Sampler *sampler;
+
+            DRJIT_STRUCT(LoopState, s, i, sampler)
+        } ls = {
+            dr::zeros<Stream>(dr::width(active)),
+            dr::zeros<UInt32>(dr::width(active)),
+            sampler
+        };
+
+        dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
+            [this, &active](const LoopState &ls) {
+                return active && ls.i < m_candidates;
+            },
+            [this, scene, &si, &bsdf](LoopState &ls) {
+            auto [ds, em_weight] = scene->sample_emitter_direction(
+                si, ls.sampler->next_2d(), false);
+            Float u = ls.sampler->next_1d();
+
+            Mask infinite = has_flag(ds.emitter->flags(), EmitterFlags::Infinite),
+                 delta_position = ds.delta && !infinite;
+
+            Reservoir c = dr::zeros<Reservoir>();
+            c.y = dr::select(infinite, ds.d, ds.p);
+            c.n = dr::select(infinite, 0.f, ds.n);
+            c.flags = dr::select(infinite, (uint32_t) SampleInfinite, 0u) |
+                      dr::select(delta_position, (uint32_t) SampleDeltaPosition, 0u);
+            c.M = 1.f;
+
+            /* Convert the sample to the area measure: the radiance of emitters
+               with a delta position includes the inverse squared distance */
+            Spectrum value = em_weight * ds.pdf;
+            Float dist2 = dr::square(ds.dist),
+                  cos_theta = dr::abs(dr::dot(ds.n, ds.d)),
+                  pdf = ds.pdf;
+            c.radiance = dr::select(delta_position, value * dist2, value);
+            dr::masked(pdf, !infinite && !ds.delta) = ds.pdf * cos_theta / dist2;
+
+            Vector3f d;
+            Float dist;
+            Float p_hat = target(si, integrand(si, bsdf, c, d, dist, ds.pdf > 0.f));
+            Float w = dr::select(pdf > 0.f, p_hat / pdf, 0.f);
+            update(ls.s, c, p_hat, w, u);
+            ls.i += 1;
+        },
+        "ReSTIR candidates");
+
+        // Each candidate counts once, irrespective of its weight
+        ls.s.r.M = dr::select(active, (ScalarFloat) m_candidates, 0.f);
+        finalize(ls.s);
+        return ls.s;
+    }
+
+    /// Stream a candidate with target value \c p_hat and weight \c w
+    void update(Stream &s, const Reservoir &c, const Float &p_hat,
+                const Float &w, const Float &u, Mask active = true) const {
+        active &= w > 0.f && dr::isfinite(w);
+        dr::masked(s.w_sum, active) += w;
+        Mask take = active && u * s.w_sum < w;
+        Float M = s.r.M;
+        dr::masked(s.r, take) = c;
+        dr::masked(s.p_hat, take) = p_hat;
+        s.r.M = M;
+    }
+
+    /// Merge the reservoir \c r (of another pixel or frame) into \c s
+    void merge(Stream &s, const Reservoir &r, const SurfaceInteraction3f &si,
+               const BSDFPtr &bsdf, const Float &u, Mask active) const {
+        Vector3f d;
+        Float dist;
+        Float p_hat = target(si, integrand(si, bsdf, r, d, dist, active));
+        update(s, r, p_hat, p_hat * r.W * r.M, u, active);
+        dr::masked(s.r.M, active) += r.M;
+    }
+
+    /// Compute the contribution weight of the sample selected by \c s
+    void finalize(Stream &s) const {
+        Mask valid = s.p_hat > 0.f && s.r.M > 0.f;
+        s.r.W = dr::select(valid, s.w_sum / (s.r.M * s.p_hat), 0.f);
+
+        // Continue streaming from the combined reservoir
+        s.w_sum = s.r.W * s.r.M * s.p_hat;
+    }
+
+    /// Check whether two pixels see similar surfaces
+    Mask similar_surface(const Normal3f &n1, const Float &depth1,
+                         const Normal3f &n2, const Float &depth2) const {
+        return depth1 > 0.f && depth2 > 0.f && dr::dot(n1, n2) > .9f &&
+               dr::abs(depth1 - depth2) < .1f * depth1;
+    }
+
+private:
+    uint32_t m_candidates;
+    uint32_t m_max_history;
+    uint32_t m_spatial_samples;
+    ScalarFloat m_spatial_radius;
+    bool m_temporal_reuse;
+    ref<Sampler> m_sampler;
+
+    /// Reservoirs and visible surfaces of the last frame
+    Reservoir m_reservoirs;
+    Normal3f m_normal;
+    Float m_depth;
+
+    /// Number of rendered frames, which decorrelates consecutive renders
+    uint32_t m_frame = 0;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(ReSTIRIntegrator, Integrator)
+MI_EXPORT_PLUGIN(ReSTIRIntegrator, "ReSTIR direct illumination integrator");
+NAMESPACE_END(mitsuba)
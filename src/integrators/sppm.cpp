@@ -0,0 +1,612 @@
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/random.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/film.h>
+#include <mitsuba/render/imageblock.h>
+#include <mitsuba/render/integrator.h>
+#include <mitsuba/render/records.h>
+#include <mitsuba/render/sampler.h>
+#include <mitsuba/render/sensor.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _integrator-sppm:
+
+Stochastic progressive photon mapping (:monosp:`sppm`)
+------------------------------------------------------
+
+.. pluginparameters::
+
+ * - photon_count
+   - |int|
+   - Number of photon paths that are traced in each iteration. If not
+     specified, this is set to the number of pixels of the film.
+
+ * - initial_radius
+   - |float|
+   - Initial radius of the density estimates. If not specified, 1% of the
+     scene's bounding box diagonal are used.
+
+ * - alpha
+   - |float|
+   - Radius reduction parameter, which controls the trade-off between bias
+     and variance. (Default: 0.7)
+
+ * - max_depth
+   - |int|
+   - Specifies the longest path depth in the generated output image (where -1
+     corresponds to :math:`\infty`). This limits both the photon paths and
+     the sensor paths. (Default: -1)
+
+ * - rr_depth
+   - |int|
+   - Specifies the path depth, at which the implementation will begin to use
+     the *russian roulette* path termination criterion. (Default: 5)
+
+ * - hide_emitters
+   - |bool|
+   - Hide directly visible emitters. (Default: no, i.e. |false|)
+
+This integrator implements stochastic progressive photon mapping (SPPM) by
+Hachisuka and Jensen for the JIT (LLVM and CUDA) variants. The number of
+samples per pixel specifies the number of iterations, each of which
+
+1. traces one sensor ray per pixel through specular surfaces until it reaches a
+   non-specular surface, where direct illumination is computed using emitter
+   sampling, and a *visible point* is recorded,
+
+2. builds a spatial hash grid over the visible points (using a parallel
+   counting sort),
+
+3. traces :paramtype:`photon_count` photon paths from the emitters, whose
+   interactions with non-specular surfaces are accumulated into all visible
+   points within their radius using atomic operations, and
+
+4. shrinks the radius of each pixel depending on the number of photons it
+   received.
+
+In contrast to the :ref:`photon mapper <integrator-photon>`, photons are not
+stored. The memory usage of every iteration is therefore bounded, while the
+total number of photons can become arbitrarily large, and the estimate is
+consistent: the bias vanishes as the number of iterations increases. This
+makes it a good choice for scenes dominated by caustics.
+
+Only a single visible point is recorded per pixel and iteration. At surfaces
+that are both specular and non-specular (e.g. :ref:`plastic <bsdf-plastic>`),
+the sensor path continues along the specular component after recording the
+visible point, but it only accounts for emission and direct illumination. The
+pixel reconstruction filter of the film is ignored (a box filter is used).
+
+This integrator is only available in JIT RGB and monochromatic variants, and
+it does not support participating media.
+
+.. tabs::
+    .. code-tab::  xml
+
+        <integrator type="sppm">
+            <integer name="photon_count" value="1000000"/>
+        </integrator>
+
+    .. code-tab:: python
+
+        'type': 'sppm',
+        'photon_count': 1000000
+
+ */
+
+template <typename Float, typename Spectrum>
+class SPPMIntegrator final : public Integrator<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Integrator, should_stop, m_stop, m_render_timer,
+                   m_hide_emitters, m_passes_completed)
+    MI_IMPORT_TYPES(Scene, Sensor, Film, Sampler, ImageBlock, Emitter,
+                    EmitterPtr, BSDF, BSDFPtr)
+
+    /// Visible points of the current iteration and hash grid over them
+    struct VisiblePoints {
+        /// Surface interaction and path throughput of every visible point
+        SurfaceInteraction3f si;
+        Spectrum beta;
+        /// Squared radius of every pixel
+        Float radius2;
+        /// Visible point indices sorted by hash grid cell
+        UInt32 indices;
+        /// Offset and number of visible points of every hash grid cell
+        UInt32 offsets, counts;
+        /// Photon count and flux accumulated during the current iteration
+        Float m;
+        Spectrum phi;
+
+        ScalarPoint3f origin;
+        ScalarFloat inv_cell_size;
+        uint32_t table_mask;
+    };
+
+    SPPMIntegrator(const Properties &props) : Base(props) {
+        if constexpr (!dr::is_jit_v<Float> || is_spectral_v<Spectrum> ||
+                      is_polarized_v<Spectrum>)
+            Throw("The SPPM integrator is only supported in JIT RGB and "
+                  "monochromatic variants (use the \"photon\" integrator in "
+                  "scalar variants)!");
+
+        m_photon_count   = props.get<int>("photon_count", 0);
+        m_initial_radius = props.get<ScalarFloat>("initial_radius", 0.f);
+        m_alpha          = props.get<ScalarFloat>("alpha", 0.7f);
+
+        if (m_photon_count < 0)
+            Throw("\"photon_count\" must be positive!");
+        if (m_initial_radius < 0.f)
+            Throw("\"initial_radius\" must be positive!");
+        if (m_alpha <= 0.f || m_alpha >= 1.f)
+            Throw("\"alpha\" must be in the interval (0, 1)!");
+
+        int rr_depth = props.get<int>("rr_depth", 5);
+        if (rr_depth <= 0)
+            Throw("\"rr_depth\" must be set to a value greater than zero!");
+        m_rr_depth = (uint32_t) rr_depth;
+
+        int max_depth = props.get<int>("max_depth", -1);
+        if (max_depth < 0 && max_depth != -1)
+            Throw("\"max_depth\" must be set to -1 (infinite) or a value >= 0");
+        m_max_depth = (uint32_t) max_depth;
+
+        Properties props_sampler("independent");
+        props_sampler.set_int("sample_count", 1);
+        m_sampler = PluginManager::instance()->create_object<Sampler>(props_sampler);
+    }
+
+    TensorXf render(Scene *scene, Sensor *sensor, uint32_t seed, uint32_t spp,
+                    bool develop, bool evaluate) override {
+        ScopedPhase sp(ProfilerPhase::Render);
+        m_stop = false;
+        m_passes_completed = 0;
+        m_render_timer.reset();
+
+        TensorXf result;
+        if constexpr (dr::is_jit_v<Float>) {
+            Film *film = sensor->film();
+            ScalarVector2u crop_size = film->crop_size();
+            ScalarPoint2i crop_offset(film->crop_offset());
+            uint32_t pixel_count = dr::prod(crop_size),
+                     photon_count = m_photon_count > 0 ? (uint32_t) m_photon_count
+                                                       : pixel_count;
+
+            // One iteration per sample
+            Sampler *sensor_sampler = sensor->sampler();
+            if (spp)
+                sensor_sampler->set_sample_count(spp);
+            uint32_t iterations = sensor_sampler->sample_count();
+
+            Log(Info, "Starting render job (%ux%u, %u iteration%s, %u photon%s "
+                "per iteration)", crop_size.x(), crop_size.y(), iterations,
+                iterations == 1 ? "" : "s", photon_count,
+                photon_count == 1 ? "" : "s");
+
+            ScalarFloat radius = m_initial_radius;
+            if (radius == 0.f)
+                radius = 0.01f * dr::norm(scene->bbox().extents());
+
+            // Per-pixel state that persists across iterations
+            VisiblePoints vp;
+            vp.radius2 = dr::full<Float>(dr::square(radius), pixel_count);
+            Float n = dr::zeros<Float>(pixel_count);
+            Spectrum tau = dr::zeros<Spectrum>(pixel_count),
+                     ld  = dr::zeros<Spectrum>(pixel_count);
+
+            uint32_t table_size = math::round_to_power_of_two(2 * pixel_count);
+            vp.table_mask = table_size - 1;
+            vp.origin = scene->bbox().min;
+
+            ref<Sampler> sampler = m_sampler->clone();
+
+            uint32_t it = 0;
+            for (; it < iterations && !should_stop(); ++it) {
+                // 1. Trace sensor paths and record the visible points
+                sampler->seed(sample_tea_32(seed, 2 * it).first, pixel_count);
+                Mask found = trace_visible_points(scene, sensor, sampler, vp, ld);
+
+                // 2. Build the hash grid over the visible points
+                ScalarFloat max_radius = dr::sqrt(dr::max_nested(
+                    dr::select(found, vp.radius2, 0.f)));
+
+                if (max_radius > 0.f) {
+                    build_grid(vp, found, max_radius, table_size);
+
+                    // 3. Trace photons and accumulate them at the visible points
+                    sampler->seed(sample_tea_32(seed, 2 * it + 1).first,
+                                  photon_count);
+                    trace_photons(scene, sensor, sampler, vp, photon_count);
+
+                    // 4. Progressive radius reduction
+                    Mask has_photons = vp.m > 0.f;
+                    Float n_new = n + m_alpha * vp.m,
+                          ratio = dr::select(has_photons, n_new / (n + vp.m), 1.f);
+                    vp.radius2 *= ratio;
+                    tau = (tau + vp.phi) * ratio;
+                    n = n_new;
+                }
+
+                dr::eval(n, tau, ld, vp.radius2);
+                m_passes_completed = it + 1;
+            }
+
+            if (it > 0) {
+                // Combine direct illumination and the photon flux estimate
+                Float scale = dr::rcp((ScalarFloat) it),
+                      flux_scale = dr::InvPi<Float> /
+                                   ((ScalarFloat) it * photon_count * vp.radius2);
+                Spectrum value = ld * scale + tau * flux_scale;
+
+                UInt32 idx = dr::arange<UInt32>(pixel_count);
+                Point2f pos(Float(idx % crop_size.x()) + .5f + crop_offset.x(),
+                            Float(idx / crop_size.x()) + .5f + crop_offset.y());
+
+                uint32_t channels = (uint32_t) film->prepare({});
+                ref<ImageBlock> block = new ImageBlock(
+                    crop_size, crop_offset, channels, nullptr /* box filter */,
+                    false /* border */);
+                block->put(pos, dr::zeros<Wavelength>(pixel_count), value);
+                film->put_block(block);
+            }
+
+            if (develop) {
+                result = film->develop();
+                dr::schedule(result);
+            } else {
+                film->schedule_storage();
+            }
+
+            if (evaluate) {
+                dr::eval();
+                dr::sync_thread();
+            }
+
+            if (!m_stop && evaluate)
+                Log(Info, "Rendering finished. (took %s)",
+                    util::time_string((float) m_render_timer.value(), true));
+        } else {
+            DRJIT_MARK_USED(scene); DRJIT_MARK_USED(sensor);
+            DRJIT_MARK_USED(seed); DRJIT_MARK_USED(spp);
+            DRJIT_MARK_USED(develop); DRJIT_MARK_USED(evaluate);
+            Throw("The SPPM integrator is only supported in JIT variants!");
+        }
+
+        return result;
+    }
+
+    /**
+     * \brief Trace one sensor path per pixel until it reaches a non-specular
+     * surface, where a visible point is recorded
+     *
+     * Emission and direct illumination are added to \c ld. Returns a mask
+     * denoting the pixels for which a visible point was found.
+     */
+    Mask trace_visible_points(const Scene *scene, const Sensor *sensor,
+                              Sampler *sampler, VisiblePoints &vp,
+                              Spectrum &ld) const {
+        const Film *film = sensor->film();
+        ScalarVector2u crop_size = film->crop_size();
+        uint32_t pixel_count = dr::prod(crop_size);
+
+        ScalarVector2f scale  = 1.f / ScalarVector2f(crop_size),
+                       offset = -ScalarVector2f(film->crop_offset()) * scale;
+
+        UInt32 idx = dr::arange<UInt32>(pixel_count);
+        Vector2f pos(Float(idx % crop_size.x()), Float(idx / crop_size.x()));
+        pos += ScalarVector2f(film->crop_offset());
+
+        Vector2f adjusted_pos = dr::fmadd(pos + sampler->next_2d(), scale, offset);
+
+        Point2f aperture_sample(.5f);
+        if (sensor->needs_aperture_sample())
+            aperture_sample = sampler->next_2d();
+
+        Float time = sensor->shutter_open();
+        if (sensor->shutter_open_time() > 0.f)
+            time += sampler->next_1d() * sensor->shutter_open_time();
+
+        auto [ray, ray_weight] = sensor->sample_ray_differential(
+            time, 0.f, adjusted_pos, aperture_sample);
+
+        struct LoopState {
+            Ray3f ray;
+            Spectrum beta;
+            Spectrum ld;
+            UInt32 depth;
+            Bool found;
+            SurfaceInteraction3f vp_si;
+            Spectrum vp_beta;
+            Bool active;
+            Sampler *sampler;
+
+            DRJIT_STRUCT(LoopState, ray, beta, ld, depth, found, vp_si,
+                         vp_beta, active, sampler)
+        } ls = {
+            Ray3f(ray),
+            ray_weight,
+            dr::zeros<Spectrum>(pixel_count),
+            dr::zeros<UInt32>(pixel_count),
+            dr::full<Bool>(false, pixel_count),
+            dr::zeros<SurfaceInteraction3f>(pixel_count),
+            dr::zeros<Spectrum>(pixel_count),
+            dr::full<Bool>(m_max_depth != 0, pixel_count),
+            sampler
+        };
+
+        dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
+            [](const LoopState &ls) { return ls.active; },
+            [this, scene](LoopState &ls) {
+            SurfaceInteraction3f si =
+                scene->ray_intersect(ls.ray,
+                                     /* ray_flags = */ +RayFlags::All,
+                                     /* coherent = */ ls.depth == 0u);
+
+            /* Emitters that are hit directly or after specular scattering
+               (all other emission is accounted for by emitter sampling) */
+            EmitterPtr emitter = si.emitter(scene);
+            Mask show = (ls.depth > 0u) || !m_hide_emitters;
+            if (dr::any_or<true>(show && emitter != nullptr))
+                ls.ld[show] = ls.ld + ls.beta * emitter->eval(si, show);
+
+            Bool active_next = si.is_valid() && (ls.depth + 1u < m_max_depth);
+            if (dr::none_or<false>(active_next)) {
+                ls.active = active_next;
+                return; // early exit for scalar mode
+            }
+
+            BSDFPtr bsdf = si.bsdf(ls.ray);
+            UInt32 flags = bsdf->flags();
+
+            // Direct illumination at non-specular surfaces
+            Mask smooth = active_next && has_flag(flags, BSDFFlags::Smooth);
+            if (dr::any_or<true>(smooth)) {
+                auto [ds, em_weight] = scene->sample_emitter_direction(
+                    si, ls.sampler->next_2d(), true, smooth);
+                Mask active_em = smooth && (ds.pdf != 0.f);
+                Spectrum bsdf_val = bsdf->eval(BSDFContext(), si,
+                                               si.to_local(ds.d), active_em);
+                ls.ld[active_em] = ls.ld + ls.beta * bsdf_val * em_weight;
+            }
+
+            // Record the first non-specular vertex as the visible point
+            Mask record = smooth && !ls.found;
+            dr::masked(ls.vp_si, record) = si;
+            ls.vp_beta[record] = ls.beta;
+            ls.found |= record;
+
+            // Continue along the specular components of the BSDF
+            Mask delta = active_next && has_flag(flags, BSDFFlags::Delta);
+            BSDFContext ctx_delta(TransportMode::Radiance,
+                                  (uint32_t) BSDFFlags::Delta);
+            auto [bs, bsdf_weight] =
+                bsdf->sample(ctx_delta, si, ls.sampler->next_1d(),
+                             ls.sampler->next_2d(), delta);
+
+            ls.beta *= bsdf_weight;
+            ls.ray = si.spawn_ray(si.to_world(bs.wo));
+            ls.depth += 1;
+
+            Float beta_max = dr::max(unpolarized_spectrum(ls.beta));
+            Float rr_prob = dr::minimum(beta_max, .95f);
+            Mask rr_active = ls.depth >= m_rr_depth,
+                 rr_continue = ls.sampler->next_1d() < rr_prob;
+            ls.beta[rr_active] *= dr::rcp(rr_prob);
+
+            ls.active = delta && (beta_max != 0.f) && (!rr_active || rr_continue);
+        },
+        "SPPM visible points");
+
+        ld += ls.ld;
+        vp.si = ls.vp_si;
+        vp.beta = ls.vp_beta;
+        dr::eval(ld, vp.si, vp.beta, ls.found);
+
+        return ls.found;
+    }
+
+    /// Hash grid cell containing \c p
+    Vector3i grid_cell(const VisiblePoints &vp, const Point3f &p) const {
+        return dr::floor2int<Vector3i>((p - vp.origin) * vp.inv_cell_size);
+    }
+
+    /// Hash function of a grid cell (Teschner et al. 2003)
+    UInt32 grid_hash(const VisiblePoints &vp, const Vector3i &cell) const {
+        return ((UInt32(cell.x()) * 73856093u) ^
+                (UInt32(cell.y()) * 19349663u) ^
+                (UInt32(cell.z()) * 83492791u)) & vp.table_mask;
+    }
+
+    /**
+     * \brief Sort the visible points by hash grid cell using a parallel
+     * counting sort
+     *
+     * The cells have twice the size of the largest radius, so that the
+     * neighborhood of every photon overlaps at most 2x2x2 cells.
+     */
+    void build_grid(VisiblePoints &vp, const Mask &found,
+                    ScalarFloat max_radius, uint32_t table_size) const {
+        uint32_t pixel_count = (uint32_t) dr::width(found);
+        vp.inv_cell_size = 1.f / (2.f * max_radius);
+
+        UInt32 hash = grid_hash(vp, grid_cell(vp, vp.si.p));
+
+        vp.counts = dr::zeros<UInt32>(table_size);
+        dr::scatter_reduce(ReduceOp::Add, vp.counts, UInt32(1), hash, found);
+        vp.offsets = dr::prefix_sum(vp.counts, true /* exclusive */);
+
+        UInt32 cursor = dr::zeros<UInt32>(table_size);
+        UInt32 slot = dr::scatter_inc(cursor, hash, found);
+
+        vp.indices = dr::zeros<UInt32>(pixel_count);
+        dr::scatter(vp.indices, dr::arange<UInt32>(pixel_count),
+                    dr::gather<UInt32>(vp.offsets, hash, found) + slot, found);
+
+        vp.m = dr::zeros<Float>(pixel_count);
+        vp.phi = dr::zeros<Spectrum>(pixel_count);
+        dr::eval(vp.counts, vp.offsets, vp.indices, vp.m, vp.phi);
+    }
+
+    /**
+     * \brief Trace photon paths and accumulate their interactions with
+     * non-specular surfaces into the visible points (wavefront-style, one
+     * kernel per bounce)
+     */
+    void trace_photons(const Scene *scene, const Sensor *sensor,
+                       Sampler *sampler, VisiblePoints &vp,
+                       uint32_t photon_count) const {
+        Float time = dr::full<Float>(sensor->shutter_open(), photon_count);
+        if (sensor->shutter_open_time() > 0.f)
+            time += sampler->next_1d() * sensor->shutter_open_time();
+
+        auto [ray, weight, emitter] = scene->sample_emitter_ray(
+            time, sampler->next_1d(), sampler->next_2d(), sampler->next_2d());
+        DRJIT_MARK_USED(emitter);
+
+        Spectrum throughput = weight;
+        Float weight_max = dr::max(unpolarized_spectrum(weight)),
+              eta = 1.f;
+        Mask active = weight_max > 0.f;
+
+        BSDFContext ctx(TransportMode::Importance);
+        for (uint32_t depth = 1; depth < m_max_depth; ++depth) {
+            SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+            active &= si.is_valid();
+
+            BSDFPtr bsdf = si.bsdf(ray);
+
+            /* The first hit is skipped since direct illumination is
+               computed using emitter sampling */
+            if (depth > 1)
+                splat_photon(vp, si, -ray.d, throughput,
+                             active && has_flag(bsdf->flags(), BSDFFlags::Smooth));
+
+            if (depth + 1 >= m_max_depth)
+                break;
+
+            auto [bs, bsdf_weight] =
+                bsdf->sample(ctx, si, sampler->next_1d(active),
+                             sampler->next_2d(active), active);
+
+            // Using geometric normals
+            Float wi_dot_geo_n = dr::dot(si.n, -ray.d),
+                  wo_dot_geo_n = dr::dot(si.n, si.to_world(bs.wo));
+
+            // Prevent light leaks due to shading normals
+            active &= (wi_dot_geo_n * Frame3f::cos_theta(si.wi) > 0.f) &&
+                      (wo_dot_geo_n * Frame3f::cos_theta(bs.wo) > 0.f);
+
+            // Adjoint BSDF for shading normals -- [Veach, p. 155]
+            Float correction = dr::abs((Frame3f::cos_theta(si.wi) * wo_dot_geo_n) /
+                                       (Frame3f::cos_theta(bs.wo) * wi_dot_geo_n));
+            throughput *= bsdf_weight * correction;
+            eta *= bs.eta;
+
+            // Russian roulette (relative to the initial photon power)
+            Float throughput_max = dr::max(unpolarized_spectrum(throughput)) / weight_max;
+            active &= throughput_max > 0.f;
+            if (depth >= m_rr_depth) {
+                Float q = dr::minimum(throughput_max * dr::square(eta), .95f);
+                active &= sampler->next_1d(active) < q;
+                throughput *= dr::rcp(q);
+            }
+
+            ray = si.spawn_ray(si.to_world(bs.wo));
+
+            sampler->schedule_state();
+            dr::eval(ray, throughput, eta, active, vp.m, vp.phi);
+            if (!dr::any(active))
+                break;
+        }
+
+        dr::eval(vp.m, vp.phi);
+    }
+
+    /// Accumulate a photon into all visible points within their radius
+    void splat_photon(VisiblePoints &vp, const SurfaceInteraction3f &si,
+                      const Vector3f &wi, const Spectrum &power,
+                      Mask active) const {
+        Vector3i base = dr::floor2int<Vector3i>(
+            (si.p - vp.origin) * vp.inv_cell_size - .5f);
+
+        for (int32_t i = 0; i < 8; ++i) {
+            Vector3i cell = base + Vector3i(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+            UInt32 hash  = grid_hash(vp, cell),
+                   begin = dr::gather<UInt32>(vp.offsets, hash, active),
+                   count = dr::gather<UInt32>(vp.counts, hash, active);
+
+            struct LoopState {
+                UInt32 j;
+                Bool active;
+                DRJIT_STRUCT(LoopState, j, active)
+            } ls = { dr::zeros<UInt32>(dr::width(hash)), active && (count > 0u) };
+
+            dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
+                [](const LoopState &ls) { return ls.active; },
+                [&](LoopState &ls) {
+                UInt32 index = dr::gather<UInt32>(vp.indices, begin + ls.j);
+                SurfaceInteraction3f vp_si =
+                    dr::gather<SurfaceInteraction3f>(vp.si, index);
+                Float radius2 = dr::gather<Float>(vp.radius2, index);
+
+                /* Skip visible points of other cells that share the same hash
+                   (they would otherwise be visited more than once), those
+                   outside of the radius, and those on surfaces with a
+                   different orientation */
+                Mask accept = dr::all(grid_cell(vp, vp_si.p) == cell) &&
+                              dr::squared_norm(vp_si.p - si.p) < radius2 &&
+                              dr::dot(vp_si.n, si.n) > .1f;
+
+                Vector3f wo = vp_si.to_local(wi);
+                Float cos_theta = dr::abs(Frame3f::cos_theta(wo));
+                accept &= cos_theta > 0.f;
+
+                BSDFPtr bsdf = vp_si.bsdf();
+                Spectrum value = bsdf->eval(BSDFContext(), vp_si, wo, accept) *
+                                 dr::gather<Spectrum>(vp.beta, index, accept) *
+                                 power / cos_theta;
+
+                dr::scatter_reduce(ReduceOp::Add, vp.m, Float(1.f), index, accept);
+                for (size_t k = 0; k < dr::size_v<Spectrum>; ++k)
+                    dr::scatter_reduce(ReduceOp::Add, vp.phi[k], value[k],
+                                       index, accept);
+
+                ls.j += 1;
+                ls.active = ls.j < count;
+            },
+            "SPPM photon splatting");
+        }
+    }
+
+    std::string to_string() const override {
+        return tfm::format("SPPMIntegrator[\n"
+                           "  photon_count = %i,\n"
+                           "  initial_radius = %f,\n"
+                           "  alpha = %f,\n"
+                           "  max_depth = %u,\n"
+                           "  rr_depth = %u\n"
+                           "]",
+                           m_photon_count, m_initial_radius, m_alpha,
+                           m_max_depth, m_rr_depth);
+    }
+
+    MI_DECLARE_CLASS()
+private:
+    int32_t m_photon_count;
+    ScalarFloat m_initial_radius;
+    ScalarFloat m_alpha;
+    uint32_t m_max_depth;
+    uint32_t m_rr_depth;
+    ref<Sampler> m_sampler;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(SPPMIntegrator, Integrator);
+MI_EXPORT_PLUGIN(SPPMIntegrator, "Stochastic progressive photon mapping integrator");
+NAMESPACE_END(mitsuba)
@@ -942,6 +942,150 @@ def test04_render_custom_op(variants_all_ad_rgb):
         mi.util.write_bitmap(filename, error)
         pytest.fail("Gradient values exceeded configuration's tolerances!")
 
+@pytest.mark.skipif(not hasattr(dr, 'freeze'), reason='Requires frozen functions')
+@pytest.mark.parametrize('integrator_name', ['prb', 'prbvolpath'])
+def test05_frozen_rendering(variants_all_ad_rgb, integrator_name):
+    config = DiffuseAlbedoConfig()
+    config.initialize()
+
+    def run(freeze):
+        integrator = mi.load_dict({
+            'type': integrator_name,
+            'max_depth': config.integrator_dict['max_depth'],
+            'freeze': freeze
+        })
+
+        images, grads = [], []
+        for it in range(3):
+            theta = mi.Float(0.1 * it)
+            dr.enable_grad(theta)
+            config.update(theta)
+            image = mi.render(config.scene, config.params, integrator=integrator,
+                              seed=it, spp=4)
+            dr.backward(dr.mean(image, axis=None))
+            images.append(dr.detach(image))
+            grads.append(dr.grad(theta))
+        return images, grads
+
+    # Replaying the recorded kernels with new seeds and parameter values
+    # matches tracing the rendering steps again
+    images_ref, grads_ref = run(False)
+    images, grads = run(True)
+    for image, image_ref in zip(images, images_ref):
+        assert dr.allclose(image, image_ref)
+    for grad, grad_ref in zip(grads, grads_ref):
+        assert dr.allclose(grad, grad_ref)
+
+
+@pytest.mark.parametrize('integrator_name', ['prb', 'prbvolpath'])
+def test06_chunked_differential_rendering(variants_all_ad_rgb, integrator_name):
+    config = DiffuseAlbedoConfig()
+    config.initialize()
+
+    def run(budget):
+        integrator = mi.load_dict({
+            'type': integrator_name,
+            'max_depth': config.integrator_dict['max_depth'],
+            'max_wavefront_memory': budget
+        })
+
+        theta = mi.Float(0.0)
+        dr.enable_grad(theta)
+        config.update(theta)
+        image = mi.render(config.scene, config.params, integrator=integrator,
+                          seed=0, spp=16)
+        dr.backward(dr.mean(image, axis=None))
+        grad_backward = dr.grad(theta)
+
+        theta = mi.Float(0.0)
+        dr.enable_grad(theta)
+        config.update(theta)
+        dr.set_grad(theta, 1.0)
+        grad_forward = integrator.render_forward(config.scene, config.params,
+                                                 seed=0, spp=16)
+        return grad_forward, grad_backward
+
+    grad_forward_ref, grad_backward_ref = run(0.0)
+
+    # A budget that fits all samples renders a single pass with the same seed
+    grad_forward, grad_backward = run(1024.0)
+    assert dr.all(grad_forward == grad_forward_ref, axis=None)
+    assert dr.all(grad_backward == grad_backward_ref)
+
+    # Budgets that force several passes converge to the same gradients
+    for budget in [40.0, 10.0]:
+        grad_forward, grad_backward = run(budget)
+        assert dr.allclose(dr.mean(grad_forward, axis=None),
+                           dr.mean(grad_forward_ref, axis=None), rtol=5e-2)
+        assert dr.allclose(grad_backward, grad_backward_ref, rtol=5e-2)
+
+        # The passes do not depend on anything but the parameters
+        assert dr.all(run(budget)[1] == grad_backward)
+
+
+@pytest.mark.slow
+@pytest.mark.skipif(os.name == 'nt', reason='Skip those memory heavy tests on Windows')
+@pytest.mark.parametrize('integrator_name', ['prb', 'prb_projective', 'direct_projective'])
+def test07_batch_sensor(variants_all_ad_rgb, integrator_name):
+    config = TranslateDiffuseSphereConstantConfig()
+    config.res = 64
+    views = [
+        {
+            'type': 'perspective',
+            'to_world': T().look_at(origin=origin, target=[0, 0, 0], up=[0, 1, 0])
+        } for origin in [[0, 0, 4], [3, 0, 3]]
+    ]
+
+    @fresolver_append_path
+    def load(sensor_dict, width):
+        sensor_dict['film'] = dict(config.sensor_dict['film'], width=width,
+                                   height=config.res)
+        config.scene_dict['sensor'] = sensor_dict
+        config.scene = mi.load_dict(config.scene_dict)
+        config.params = mi.traverse(config.scene)
+        config.params.keep([config.key])
+        config.initial_state = mi.Vector3f(
+            dr.unravel(mi.Vector3f, config.params[config.key]))
+
+    integrator = mi.load_dict({
+        'type': integrator_name,
+        'max_depth': config.integrator_dict['max_depth']
+    })
+
+    def grad(loss):
+        theta = mi.Float(0.0)
+        dr.enable_grad(theta)
+        config.update(theta)
+        image = mi.render(config.scene, config.params, integrator=integrator,
+                          seed=0, spp=256)
+        dr.backward(loss(image))
+        return dr.grad(theta)
+
+    # Separate rendering of each view
+    grads_ref = []
+    for view in views:
+        load(dict(view), config.res)
+        grads_ref.append(grad(lambda image: dr.mean(image, axis=None)))
+
+    # All views in a single rendering step, with a loss per view
+    batch = { 'type': 'batch' }
+    for i, view in enumerate(views):
+        batch[f'view_{i}'] = view
+    load(batch, config.res * len(views))
+    sensor = config.scene.sensors()[0]
+    assert len(sensor.sub_sensors()) == len(views)
+
+    for i in range(len(views)):
+        grad_i = grad(lambda image: dr.mean(
+            mi.util.split_batch(image, sensor)[i], axis=None))
+        assert dr.allclose(grad_i, grads_ref[i], rtol=0.1, atol=1e-3)
+
+    # The views are slices of the batched image
+    image = mi.render(config.scene, spp=4)
+    for i, image_i in enumerate(mi.util.split_batch(image, sensor)):
+        assert dr.all(image_i == image[:, i * config.res:(i + 1) * config.res], axis=None)
+
+
 # -------------------------------------------------------------------
 #                      Generate reference images
 # -------------------------------------------------------------------
@@ -180,3 +180,121 @@ def test05_check_aov_film(variants_all_rgb):
 
     # Make sure radiance is consistent
     assert(np.allclose(bitmap_aov.split()[0][1],bitmap_path.split()[0][1]))
+
+
+def test06_ray_statistics(variant_scalar_rgb):
+    aov_dict = {
+        'type': 'aov',
+        'aovs': 'rc:ray_count,sr:shadow_ray_count',
+    }
+
+    if not mi.Profiler.has_ray_statistics():
+        with pytest.raises(RuntimeError, match='MI_ENABLE_RAY_STATISTICS'):
+            mi.load_dict(aov_dict)
+        assert mi.Profiler.ray_statistic(mi.RayStatistic.RayIntersect) == 0
+        return
+
+    scene = mi.load_dict({
+        'type': 'scene',
+        'sensor': {
+            'type': 'orthographic',
+            'to_world': mi.ScalarTransform4f().look_at(
+                origin=(0, 0, 1), target=(0, 0, -1), up=(0, 1, 0)),
+            'film': {
+                'type': 'hdrfilm',
+                'width': 16, 'height': 16,
+                'rfilter': {'type': 'box'}
+            },
+        },
+        'plane' : {
+            'type' : 'rectangle',
+            'to_world' : mi.ScalarTransform4f().scale([10.0, 10.0, 1.0])
+        }
+    })
+
+    mi.Profiler.reset_ray_statistics()
+    image = mi.load_dict(aov_dict).render(scene, seed=0, spp=4)
+
+    # The AOV integrator traces exactly one camera ray per sample
+    assert dr.allclose(image[:, :, 0].array, 1)
+    assert dr.allclose(image[:, :, 1].array, 0)
+
+    assert mi.Profiler.ray_statistic(mi.RayStatistic.RayIntersect) == 16 * 16 * 4
+    assert mi.Profiler.ray_statistic(mi.RayStatistic.RayTest) == 0
+    assert 'Traversed nodes' in mi.Profiler.ray_statistics_report()
+
+
+@pytest.mark.parametrize('integrator', ['path', 'volpath'])
+def test07_single_pass_matches_separate_passes(variants_all_rgb, integrator):
+    scene = mi.load_file(find_resource('resources/data/scenes/cbox/cbox.xml'), res=32)
+    aovs = 'dd.y:depth,nn:sh_normal,uv:uv,si:shape_index'
+
+    # The 'direct' integrator doesn't record primary AOVs, which requires a
+    # separate pass to compute them
+    reference = mi.load_dict({
+        'type': 'aov',
+        'aovs': aovs,
+        'my_image': { 'type': 'direct' }
+    }).render(scene, seed=0, spp=4)
+
+    inner = mi.load_dict({ 'type': integrator, 'max_depth': 4 })
+    image = mi.load_dict({
+        'type': 'aov',
+        'aovs': aovs,
+        'my_image': inner
+    }).render(scene, seed=0, spp=4)
+
+    # Channel layout is unchanged by the single-pass mode
+    assert image.shape == reference.shape
+    assert dr.allclose(image[:, :, -7:], reference[:, :, -7:])
+
+    # The radiance matches a render of the inner integrator alone, which
+    # no longer records the primary AOVs
+    assert dr.allclose(image[:, :, :3], inner.render(scene, seed=0, spp=4))
+
+
+def test08_motion_vectors(variants_all_rgb):
+    T = mi.ScalarTransform4f
+
+    def sensor_to_world(x):
+        return T().look_at(origin=[x, 0, 4], target=[x, 0, 0], up=[0, 1, 0])
+
+    scene = mi.load_dict({
+        'type': 'scene',
+        'sensor': {
+            'type': 'perspective',
+            'to_world': sensor_to_world(0),
+            'film': {
+                'type': 'hdrfilm',
+                'width': 16, 'height': 16,
+                'rfilter': { 'type': 'box' }
+            }
+        },
+        'wall': { 'type': 'rectangle', 'to_world': T().scale(10) },
+        'light': { 'type': 'constant' }
+    })
+
+    integrator = mi.load_dict({
+        'type': 'aov',
+        'aovs': 'flow:motion',
+        'my_image': { 'type': 'path' }
+    })
+
+    # There is no previous frame: the motion vectors are zero
+    image = integrator.render(scene, seed=0, spp=4)
+    assert dr.allclose(image[:, :, -2:].array, 0)
+
+    # A sideways motion of the sensor makes the wall move horizontally
+    params = mi.traverse(scene)
+    params['sensor.to_world'] = sensor_to_world(0.5)
+    params.update()
+
+    image = integrator.render(scene, seed=1, spp=4)
+    flow_x, flow_y = image[:, :, -2].array, image[:, :, -1].array
+    assert dr.all(dr.abs(flow_x) > 0.5)
+    assert dr.allclose(flow_x, flow_x[0], atol=1e-3)
+    assert dr.allclose(flow_y, 0, atol=1e-3)
+
+    # The sensor didn't move since the last frame
+    image = integrator.render(scene, seed=2, spp=4)
+    assert dr.allclose(image[:, :, -2:].array, 0, atol=1e-3)
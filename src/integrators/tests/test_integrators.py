@@ -23,3 +23,677 @@ def test01_trampoline_id(variants_vec_backends_once_rgb):
 
     params = mi.traverse(scene)
     assert 'my_integrator.depth' in params
+
+
+def test02_adaptive_sampling(variant_scalar_rgb):
+    # A constant environment converges immediately: all blocks are retired
+    scene = mi.load_dict({
+        'type': 'scene',
+        'sensor': {
+            'type': 'perspective',
+            'film': {
+                'type': 'hdrfilm',
+                'width': 64, 'height': 64,
+                'rfilter': {'type': 'box'}
+            },
+        },
+        'emitter': {'type': 'constant'},
+    })
+
+    integrator = mi.load_dict({
+        'type': 'path',
+        'adaptive_threshold': 0.01
+    })
+
+    image = integrator.render(scene, spp=64)
+    assert dr.allclose(image.array, 1.0)
+
+    # Noisy scenes must remain consistent with non-adaptive rendering
+    scene = mi.load_dict(mi.cornell_box())
+    ref = mi.load_dict({'type': 'path'}).render(scene, spp=64)
+    image = mi.load_dict({
+        'type': 'path',
+        'adaptive_threshold': 0.05
+    }).render(scene, spp=64)
+
+    assert dr.allclose(dr.mean(image.array), dr.mean(ref.array), rtol=5e-2)
+
+
+def test02_adaptive_sampling_special_film(variant_scalar_spectral):
+    # The channels of special films aren't RGB values, which the per-pixel
+    # error estimate relies on: adaptive sampling is disabled
+    scene = mi.load_dict({
+        'type': 'scene',
+        'sensor': {
+            'type': 'perspective',
+            'film': {
+                'type': 'specfilm',
+                'width': 16, 'height': 16,
+                'srf_test': {
+                    'type': 'spectrum',
+                    'value': [(500, 1.0), (700, 2.0), (750, 3.0)]
+                },
+            },
+        },
+        'emitter': {'type': 'constant'},
+    })
+
+    image = mi.load_dict({
+        'type': 'path',
+        'adaptive_threshold': 0.01
+    }).render(scene, seed=0, spp=16)
+    ref = mi.load_dict({'type': 'path'}).render(scene, seed=0, spp=16)
+
+    assert dr.all(dr.isfinite(image.array))
+    assert dr.allclose(image, ref)
+
+
+def test03_progressive_timeout(variants_all_rgb):
+    scene = mi.load_dict(mi.cornell_box())
+    integrator = mi.load_dict({
+        'type': 'path',
+        'progressive': True,
+        'timeout': 0.5,
+    })
+
+    image = integrator.render(scene, spp=4)
+    assert integrator.passes_completed() >= 1
+
+    # Every completed pass leaves a normalized image behind
+    ref = mi.load_dict({'type': 'path'}).render(scene, spp=64)
+    assert dr.allclose(dr.mean(image.array), dr.mean(ref.array), rtol=0.1)
+
+
+def test04_progressive_target_error(variant_scalar_rgb):
+    scene = mi.load_dict({
+        'type': 'scene',
+        'sensor': {
+            'type': 'perspective',
+            'film': { 'type': 'hdrfilm', 'width': 16, 'height': 16 },
+        },
+        'emitter': {'type': 'constant'},
+    })
+
+    integrator = mi.load_dict({
+        'type': 'path',
+        'progressive': True,
+        'target_error': 0.01,
+    })
+
+    # The constant environment converges after the minimum of two passes
+    image = integrator.render(scene, spp=4)
+    assert integrator.passes_completed() == 2
+    assert dr.allclose(image.array, 1.0)
+
+
+def test05_checkpoint_cleanup(variant_scalar_rgb, tmp_path):
+    scene = mi.load_dict(mi.cornell_box())
+    ckpt = tmp_path / 'render.ckpt'
+
+    integrator = scene.integrator()
+    integrator.set_checkpoint(str(ckpt), interval=0.01, resume=True)
+    image = integrator.render(scene, seed=0, spp=4)
+    assert not ckpt.exists()
+
+    integrator.set_checkpoint('')
+    ref = integrator.render(scene, seed=0, spp=4)
+    assert dr.allclose(image, ref)
+
+
+def test05_checkpoint_resume(variants_all_rgb, tmp_path):
+    class InterruptingSensor(mi.Sensor):
+        """Forwards to a nested sensor and cancels the render job of
+        ``integrator`` once ``sample_ray_differential()`` was called ``limit``
+        times (once per pass in JIT variants, once per sample otherwise)"""
+        def __init__(self, props):
+            mi.Sensor.__init__(self, props)
+            self.sensor = None
+            self.integrator = None
+            self.limit = 0
+            self.calls = 0
+
+        def sample_ray_differential(self, time, sample1, sample2, sample3,
+                                    active=True):
+            self.calls += 1
+            if self.integrator is not None and self.calls == self.limit:
+                self.integrator.cancel()
+            return self.sensor.sample_ray_differential(time, sample1, sample2,
+                                                       sample3, active)
+
+    mi.register_sensor('interrupting_sensor', InterruptingSensor)
+
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 32
+    scene_dict['sensor']['film']['height'] = 32
+    scene_dict['integrator'].update({ 'samples_per_pass': 1 })
+    scene = mi.load_dict(scene_dict)
+    integrator = scene.integrator()
+
+    sensor = mi.load_dict({
+        'type': 'interrupting_sensor',
+        'film': scene_dict['sensor']['film'],
+        'sampler': scene_dict['sensor']['sampler']
+    })
+    sensor.sensor = mi.load_dict(scene_dict['sensor'])
+
+    spp = 8
+    ckpt = tmp_path / 'render.ckpt'
+    integrator.set_checkpoint(str(ckpt))
+    ref = integrator.render(scene, sensor, seed=0, spp=spp)
+
+    # Interrupt the render job after 3 of the 8 passes (JIT variants), or
+    # halfway through the samples (scalar variants)
+    jit = dr.is_jit_v(mi.Float)
+    sensor.integrator = integrator
+    sensor.limit = 3 if jit else 32 * 32 * spp // 2
+    sensor.calls = 0
+    integrator.render(scene, sensor, seed=0, spp=spp)
+    assert ckpt.exists()
+    if jit:
+        assert sensor.calls == 3
+
+    # Resume from the checkpoint without interruption
+    sensor.integrator = None
+    sensor.calls = 0
+    integrator.set_checkpoint(str(ckpt), resume=True)
+    image = integrator.render(scene, sensor, seed=0, spp=spp)
+    assert not ckpt.exists()
+    if jit:
+        assert sensor.calls == spp - 3
+
+    assert dr.allclose(image, ref)
+
+
+def test06_partitioned_render(variant_scalar_rgb):
+    scene = mi.load_dict(mi.cornell_box())
+    integrator = scene.integrator()
+    film = scene.sensors()[0].film()
+
+    ref = integrator.render(scene, seed=0, spp=4)
+
+    # Render each partition separately and store the raw film contents
+    parts = []
+    for i in range(3):
+        integrator.set_partition(i, 3)
+        integrator.render(scene, seed=0, spp=4)
+        stream = mi.MemoryStream()
+        film.write_storage(stream)
+        stream.seek(0)
+        parts.append(stream)
+    integrator.set_partition(0, 1)
+
+    film.clear()
+    for stream in parts:
+        film.read_storage(stream, accumulate=True)
+
+    assert dr.allclose(film.develop(), ref)
+
+
+def test07_max_wavefront_memory(variants_vec_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 64
+    scene_dict['sensor']['film']['height'] = 64
+    ref = mi.render(mi.load_dict(scene_dict), spp=16)
+
+    # Budgets that force fewer samples per pass, and additionally image bands
+    for budget in [10.0, 1.0]:
+        scene_dict['integrator']['max_wavefront_memory'] = budget
+        scene = mi.load_dict(scene_dict)
+        image = mi.render(scene, spp=16)
+        assert dr.all(dr.isfinite(image), axis=None)
+        assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                           rtol=5e-2)
+
+        # The chunking does not depend on anything but the parameters
+        assert dr.all(mi.render(scene, spp=16) == image, axis=None)
+
+
+def test08_numa_mode(variant_scalar_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 64
+    scene_dict['sensor']['film']['height'] = 64
+    ref = mi.render(mi.load_dict(scene_dict), spp=4)
+
+    # Blocks are seeded by their identifier, so the image does not change
+    scene_dict['integrator']['numa'] = True
+    image = mi.render(mi.load_dict(scene_dict), spp=4)
+    assert dr.allclose(image, ref)
+
+    nodes = mi.misc.core_numa_nodes()
+    assert len(nodes) == mi.misc.core_count()
+
+
+def test09_photon_mapper(variant_scalar_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 64
+    scene_dict['sensor']['film']['height'] = 64
+    ref = mi.render(mi.load_dict(scene_dict), spp=64)
+
+    # Density estimation is biased, but must agree with a path tracer on average
+    scene_dict['integrator'] = {
+        'type': 'photon',
+        'photon_count': 200000,
+        'lookup_size': 64
+    }
+    scene = mi.load_dict(scene_dict)
+    image = mi.render(scene, spp=16)
+    assert dr.all(dr.isfinite(image), axis=None)
+    assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.1)
+
+    # The photon map only depends on the seed
+    assert dr.all(mi.render(scene, spp=16) == image, axis=None)
+
+
+def test10_sppm(variants_vec_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 64
+    scene_dict['sensor']['film']['height'] = 64
+    ref = mi.render(mi.load_dict(scene_dict), spp=64)
+
+    # The radius reduction makes the estimate converge to the path tracer
+    scene_dict['integrator'] = {
+        'type': 'sppm',
+        'photon_count': 100000
+    }
+    image = mi.render(mi.load_dict(scene_dict), spp=16)
+    assert dr.all(dr.isfinite(image), axis=None)
+    assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.1)
+
+
+def test11_bdpt(variant_scalar_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 32
+    scene_dict['sensor']['film']['height'] = 32
+    scene_dict['integrator'] = { 'type': 'path', 'max_depth': 4 }
+    ref = mi.render(mi.load_dict(scene_dict), spp=128)
+
+    # All connection strategies are unbiased, and so is their combination
+    scene_dict['integrator'] = { 'type': 'bdpt', 'max_depth': 4 }
+    image = mi.render(mi.load_dict(scene_dict), spp=64)
+    assert dr.all(dr.isfinite(image), axis=None)
+    assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.05)
+
+
+@pytest.mark.parametrize('emitter', ['spot', 'envmap'])
+def test11_bdpt_emitters(variant_scalar_rgb, emitter):
+    import numpy as np
+
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 32
+    scene_dict['sensor']['film']['height'] = 32
+    if emitter == 'spot':
+        # Non-uniform emission profile that starts light subpaths
+        del scene_dict['light']
+        scene_dict['emitter'] = {
+            'type': 'spot',
+            'cutoff_angle': 40,
+            'intensity': { 'type': 'rgb', 'value': [10, 10, 10] },
+            'to_world': mi.ScalarTransform4f().look_at(
+                origin=[0, 0.9, 0], target=[0, -1, 0], up=[0, 0, 1])
+        }
+    else:
+        # Handled by the path tracer strategies, next to the area emitter
+        data = np.random.default_rng(seed=0).random((16, 32, 3)).astype(np.float32)
+        scene_dict['emitter'] = { 'type': 'envmap', 'bitmap': mi.Bitmap(data) }
+
+    scene_dict['integrator'] = { 'type': 'path', 'max_depth': 4 }
+    ref = mi.render(mi.load_dict(scene_dict), spp=128)
+
+    scene_dict['integrator'] = { 'type': 'bdpt', 'max_depth': 4 }
+    image = mi.render(mi.load_dict(scene_dict), spp=64)
+    assert dr.all(dr.isfinite(image), axis=None)
+    assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.05)
+
+
+def test12_path_sort_rays(variants_vec_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 64
+    scene_dict['sensor']['film']['height'] = 64
+
+    with dr.scoped_set_flag(dr.JitFlag.SymbolicLoops, False):
+        ref = mi.render(mi.load_dict(scene_dict), spp=4)
+
+        # Sorting does not change the paths, only the order of the traced rays
+        scene_dict['integrator']['sort_rays'] = True
+        image = mi.render(mi.load_dict(scene_dict), spp=4)
+        assert dr.allclose(image, ref)
+
+    # The option is ignored by megakernels
+    image = mi.render(mi.load_dict(scene_dict), spp=4)
+    assert dr.allclose(image, ref)
+
+
+def test13_guided(variants_all_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 32
+    scene_dict['sensor']['film']['height'] = 32
+    scene_dict['integrator'] = { 'type': 'path', 'max_depth': 4 }
+    ref = mi.render(mi.load_dict(scene_dict), spp=128)
+
+    # Sampling from the learned distributions does not bias the estimate
+    scene_dict['integrator'] = {
+        'type': 'guided',
+        'max_depth': 4,
+        'training_passes': 3,
+        'spatial_resolution': 4
+    }
+    image = mi.render(mi.load_dict(scene_dict), spp=64)
+    assert dr.all(dr.isfinite(image), axis=None)
+    assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.05)
+
+
+def test14_restir(variants_vec_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 32
+    scene_dict['sensor']['film']['height'] = 32
+    scene_dict['integrator'] = { 'type': 'direct', 'bsdf_samples': 0 }
+    ref = mi.render(mi.load_dict(scene_dict), spp=256)
+
+    scene_dict['integrator'] = { 'type': 'restir', 'candidates': 8 }
+    scene = mi.load_dict(scene_dict)
+    integrator = scene.integrator()
+    image = mi.render(scene, spp=16)
+    assert dr.all(dr.isfinite(image), axis=None)
+
+    # The reuse of the reservoirs is only slightly biased
+    assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.1)
+
+    # The reservoirs persist across calls to render()
+    params = mi.traverse(integrator)
+    assert dr.width(params['reservoir_count']) == 32 * 32
+    assert dr.max(params['reservoir_count']) > 8
+    image = mi.render(scene, spp=1)
+    assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.1)
+
+
+@pytest.mark.parametrize('integrator', ['path', 'volpath'])
+def test15_adjoint_rr(variants_all_rgb, integrator):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 32
+    scene_dict['sensor']['film']['height'] = 32
+    scene_dict['integrator'] = { 'type': integrator, 'max_depth': 8 }
+    ref = mi.render(mi.load_dict(scene_dict), spp=128)
+
+    # Terminating paths based on the learned estimates does not bias the image
+    scene_dict['integrator'] = {
+        'type': integrator,
+        'max_depth': 8,
+        'rr_mode': 'adjoint',
+        'rr_training_passes': 2,
+        'rr_grid_resolution': 8
+    }
+    image = mi.render(mi.load_dict(scene_dict), spp=64)
+    assert dr.all(dr.isfinite(image), axis=None)
+    assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.05)
+
+    scene_dict['integrator']['rr_mode'] = 'splitting'
+    with pytest.raises(RuntimeError, match='rr_mode'):
+        mi.load_dict(scene_dict)
+
+
+@pytest.mark.parametrize('medium', ['homogeneous', 'heterogeneous'])
+def test16_volpath_tracking(variants_vec_rgb, medium):
+    T = mi.ScalarTransform4f
+    medium_dict = {
+        'type': medium,
+        'albedo': { 'type': 'rgb', 'value': [0.9, 0.7, 0.5] },
+        'sigma_t': { 'type': 'rgb', 'value': [0.5, 2.0, 4.0] },
+    }
+    if medium == 'heterogeneous':
+        medium_dict['control_sigma_t'] = { 'type': 'rgb', 'value': [0.4, 1.5, 3.0] }
+
+    scene_dict = {
+        'type': 'scene',
+        'sensor': {
+            'type': 'perspective',
+            'to_world': T().look_at(origin=[0, 0, 4], target=[0, 0, 0], up=[0, 1, 0]),
+            'film': { 'type': 'hdrfilm', 'width': 16, 'height': 16 }
+        },
+        'cube': {
+            'type': 'cube',
+            'bsdf': { 'type': 'null' },
+            'interior': medium_dict
+        },
+        'light': { 'type': 'constant' }
+    }
+
+    means = []
+    for tracking in ['delta', 'spectral', 'decomposition']:
+        scene_dict['integrator'] = { 'type': 'volpath', 'tracking': tracking }
+        image = mi.render(mi.load_dict(scene_dict), spp=256)
+        assert dr.all(dr.isfinite(image), axis=None)
+        means.append(dr.mean(dr.mean(image, axis=0), axis=0))
+
+    # All techniques estimate the same image
+    assert dr.allclose(means[1], means[0], rtol=0.03)
+    assert dr.allclose(means[2], means[0], rtol=0.03)
+
+    scene_dict['integrator']['tracking'] = 'ratio'
+    with pytest.raises(RuntimeError, match='tracking'):
+        mi.load_dict(scene_dict)
+
+
+@pytest.mark.parametrize('integrator', ['path', 'prb'])
+def test17_sort_materials(variants_vec_rgb, integrator):
+    if integrator == 'prb' and not dr.is_diff_v(mi.Float):
+        pytest.skip('Only relevant in AD-enabled variants!')
+
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 64
+    scene_dict['sensor']['film']['height'] = 64
+    scene_dict['integrator'] = { 'type': integrator, 'max_depth': 6 }
+
+    with dr.scoped_set_flag(dr.JitFlag.SymbolicLoops, False):
+        ref = mi.render(mi.load_dict(scene_dict), spp=4)
+
+        # Sorting does not change the paths, only the order of the BSDF calls
+        scene_dict['integrator']['sort_materials'] = True
+        image = mi.render(mi.load_dict(scene_dict), spp=4)
+        assert dr.allclose(image, ref)
+
+    # The option is ignored by megakernels
+    image = mi.render(mi.load_dict(scene_dict), spp=4)
+    assert dr.allclose(image, ref)
+
+
+def test18_path_compaction(variants_vec_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 64
+    scene_dict['sensor']['film']['height'] = 64
+    scene_dict['integrator'] = { 'type': 'path', 'max_depth': 12 }
+
+    with dr.scoped_set_flag(dr.JitFlag.SymbolicLoops, False):
+        ref = mi.render(mi.load_dict(scene_dict), spp=4)
+
+        # Compacting the wavefront does not change the paths
+        scene_dict['integrator']['compaction_threshold'] = 0.9
+        image = mi.render(mi.load_dict(scene_dict), spp=4)
+        assert dr.allclose(image, ref)
+
+    with pytest.raises(RuntimeError, match='compaction_threshold'):
+        scene_dict['integrator']['compaction_threshold'] = 2.0
+        mi.load_dict(scene_dict)
+
+
+@pytest.mark.parametrize('integrator', ['path', 'ptracer'])
+def test19_render_statistics(variants_all_rgb, integrator):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 16
+    scene_dict['sensor']['film']['height'] = 16
+    scene = mi.load_dict(scene_dict)
+    integrator = mi.load_dict({ 'type': integrator, 'max_depth': 6 })
+
+    mi.RenderStatistics.set_enabled(True)
+    try:
+        integrator.render(scene, spp=4)
+    finally:
+        mi.RenderStatistics.set_enabled(False)
+
+    stats = integrator.render_statistics()
+    assert stats.counter(mi.RenderCounter.Samples) == 16 * 16 * 4
+    assert stats.samples_per_second() > 0
+
+    # Every path is terminated exactly once and for exactly one reason
+    paths = stats.counter(mi.RenderCounter.Paths)
+    assert paths > 0
+    assert paths == sum(stats.counter(c) for c in [
+        mi.RenderCounter.Escaped, mi.RenderCounter.RussianRoulette,
+        mi.RenderCounter.MaxDepth, mi.RenderCounter.Absorbed])
+    assert 0 < stats.average_path_length() <= stats.max_path_length <= 6
+    assert stats.counter(mi.RenderCounter.ShadowRays) > 0
+    assert stats.counter(mi.RenderCounter.ExtensionRays) >= paths
+
+
+def test20_irrcache(variants_all_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 32
+    scene_dict['sensor']['film']['height'] = 32
+    scene_dict['integrator'] = { 'type': 'path', 'max_depth': 5 }
+    ref = mi.render(mi.load_dict(scene_dict), spp=128)
+
+    # Interpolation is biased, but must agree with a path tracer on average
+    def render(error_threshold):
+        scene_dict['integrator'] = {
+            'type': 'irrcache',
+            'max_depth': 5,
+            'record_samples': 64,
+            'error_threshold': error_threshold
+        }
+        scene = mi.load_dict(scene_dict)
+        image = mi.render(scene, spp=16)
+        records = int(str(scene.integrator()).split('records = ')[1].split('\n')[0])
+        return image, records
+
+    image, records = render(0.1)
+    assert records > 0
+    assert dr.all(dr.isfinite(image), axis=None)
+    assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.1)
+
+    # A higher threshold splits fewer cells
+    image_coarse, records_coarse = render(10.0)
+    assert 0 < records_coarse < records
+    assert dr.allclose(dr.mean(image_coarse, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.15)
+
+
+def test21_path_radiance_cache(variants_all_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 32
+    scene_dict['sensor']['film']['height'] = 32
+    scene_dict['integrator'] = { 'type': 'path', 'max_depth': 6 }
+    ref = mi.render(mi.load_dict(scene_dict), spp=128)
+
+    scene_dict['integrator']['radiance_cache'] = True
+    scene_dict['integrator']['cache_update_fraction'] = 0.25
+    scene = mi.load_dict(scene_dict)
+
+    def extension_rays(seed):
+        mi.RenderStatistics.set_enabled(True)
+        try:
+            image = mi.render(scene, spp=16, seed=seed)
+        finally:
+            mi.RenderStatistics.set_enabled(False)
+        stats = scene.integrator().render_statistics()
+        return image, stats.counter(mi.RenderCounter.ExtensionRays)
+
+    # The cache is empty at first, and persists across render jobs
+    image_0, rays_0 = extension_rays(0)
+    for seed in range(1, 3):
+        image, rays = extension_rays(seed)
+    assert rays < 0.75 * rays_0
+
+    # Cached estimates are biased, but must agree with a path tracer on average
+    assert dr.all(dr.isfinite(image), axis=None)
+    assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.1)
+
+
+@pytest.mark.parametrize('integrator', ['volpath', 'volpathmis'])
+def test22_homogeneous_fast_path(variants_vec_rgb, integrator):
+    T = mi.ScalarTransform4f
+    scene_dict = {
+        'type': 'scene',
+        'integrator': { 'type': integrator, 'max_depth': 8 },
+        'sensor': {
+            'type': 'perspective',
+            'to_world': T().look_at(origin=[0, 0, 4], target=[0, 0, 0], up=[0, 1, 0]),
+            'film': { 'type': 'hdrfilm', 'width': 16, 'height': 16 }
+        },
+        'cube': {
+            'type': 'cube',
+            'bsdf': { 'type': 'null' }
+        },
+        'light': {
+            'type': 'point',
+            'position': [0, 3, 0],
+            'intensity': { 'type': 'rgb', 'value': 10.0 }
+        }
+    }
+
+    def render(medium):
+        scene_dict['cube']['interior'] = {
+            'type': medium,
+            'albedo': { 'type': 'rgb', 'value': [0.9, 0.7, 0.5] },
+            'sigma_t': { 'type': 'rgb', 'value': [0.5, 1.0, 2.0] },
+        }
+        image = mi.render(mi.load_dict(scene_dict), spp=256)
+        assert dr.all(dr.isfinite(image), axis=None)
+        return dr.mean(dr.mean(image, axis=0), axis=0)
+
+    # Analytic free flights and transmittance in the homogeneous medium match
+    # the null-collision estimators of an equivalent heterogeneous one
+    assert dr.allclose(render('homogeneous'), render('heterogeneous'), rtol=0.05)
+
+
+def test23_path_emitter_samples(variants_all_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 32
+    scene_dict['sensor']['film']['height'] = 32
+    scene_dict['integrator'] = { 'type': 'path', 'max_depth': 4 }
+    ref = mi.render(mi.load_dict(scene_dict), spp=128)
+
+    # Several emitter samples per vertex are combined without bias
+    scene_dict['integrator']['emitter_samples'] = 4
+    image = mi.render(mi.load_dict(scene_dict), spp=32)
+    assert dr.all(dr.isfinite(image), axis=None)
+    assert dr.allclose(dr.mean(image, axis=None), dr.mean(ref, axis=None),
+                       rtol=0.05)
+
+    with pytest.raises(RuntimeError, match='emitter_samples'):
+        scene_dict['integrator']['emitter_samples'] = 0
+        mi.load_dict(scene_dict)
+
+
+def test24_cost_aware_scheduling(variant_scalar_rgb):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 48
+    scene_dict['sensor']['film']['height'] = 40
+    scene_dict['integrator'].update({ 'block_size': 16, 'samples_per_pass': 2 })
+    ref = mi.render(mi.load_dict(scene_dict), spp=8)
+
+    # Quadrants of split blocks are seeded like the full blocks, hence the
+    # schedule does not change the image
+    scene_dict['integrator']['cost_aware'] = True
+    image = mi.render(mi.load_dict(scene_dict), spp=8)
+    assert dr.allclose(image, ref)
+
+    scene_dict['integrator']['adaptive_threshold'] = 0.05
+    image = mi.render(mi.load_dict(scene_dict), spp=8)
+    assert dr.all(dr.isfinite(image), axis=None)
+
+    # The render cost channel holds the time per sample of every pixel
+    del scene_dict['integrator']['adaptive_threshold']
+    scene_dict['integrator']['render_cost'] = True
+    image = mi.render(mi.load_dict(scene_dict), spp=8)
+    assert image.shape[2] == ref.shape[2] + 1
+    assert dr.allclose(image[:, :, :ref.shape[2]], ref)
+    assert dr.all(image[:, :, ref.shape[2]] > 0, axis=None)
@@ -6,13 +6,15 @@ from mitsuba.scalar_rgb.test.util import fresolver_append_path
 
 @fresolver_append_path
 def create_test_scene(max_depth=4, emitter='area',
-                      shape=None, hide_emitters=False, crop_window=None):
+                      shape=None, hide_emitters=False, crop_window=None,
+                      **kwargs):
 
     integrator = {
         'type': 'ptracer',
         'rr_depth': 9,
         'max_depth': max_depth,
         'hide_emitters': hide_emitters,
+        **kwargs
     }
     scene = {
         'type': 'scene',
@@ -236,3 +238,27 @@ def test07_adjoint_integrator_trampoline(variants_all_ad_rgb):
     mi.load_dict({
         'type': 'myptracer'
     })
+
+
+@pytest.mark.parametrize('emitter', ['directionalarea', 'constant'])
+def test08_learned_emission(variants_vec_backends_once_rgb, emitter):
+    # The learned emission distribution must not bias the image
+    scene, integrator = create_test_scene(emitter=emitter, shape='receiver',
+                                          hide_emitters=True)
+    ref = integrator.render(scene, seed=0, spp=256)
+
+    scene, integrator = create_test_scene(emitter=emitter, shape='receiver',
+                                          hide_emitters=True,
+                                          emission_training_passes=2,
+                                          emission_training_spp=16,
+                                          emission_resolution=4)
+    assert 'emission_training_passes = 2' in str(integrator)
+    image = integrator.render(scene, seed=1, spp=256)
+
+    mean_ref = dr.mean(ref, axis=None)
+    assert mean_ref > 0
+    assert dr.allclose(dr.mean(image, axis=None), mean_ref, rtol=5e-2)
+
+    with pytest.raises(RuntimeError, match='emission_uniform_fraction'):
+        create_test_scene(emission_training_passes=1,
+                          emission_uniform_fraction=0.0)
@@ -35,6 +35,19 @@ Volumetric path tracer (:monosp:`volpath`)
    - |bool|
    - Hide directly visible emitters. (Default: no, i.e. |false|)
 
+ * - rr_mode, rr_training_passes, rr_training_spp, rr_grid_resolution, rr_window
+   - |string|, |int|, |float|
+   - Russian roulette criterion and parameters of its adjoint-driven mode,
+     which learns a coarse estimate of the radiance scattered in surfaces and
+     media. See the :ref:`path tracer <integrator-path>` for details.
+     (Default: :monosp:`throughput`, 3, 4, 32 and 5)
+
+ * - tracking
+   - |string|
+   - Technique used to sample collisions in participating media, one of
+     :monosp:`delta`, :monosp:`spectral` or :monosp:`decomposition`, see below.
+     (Default: :monosp:`delta`)
+
 This plugin provides a volumetric path tracer that can be used to compute approximate solutions
 of the radiative transfer equation. Its implementation makes use of multiple importance sampling
 to combine BSDF and phase function sampling with direct illumination sampling strategies. On
@@ -47,11 +60,34 @@ has a :ref:`null <bsdf-null>` or :ref:`thin dielectric <bsdf-thindielectric>` BS
 to it (as compared to, say, a :ref:`dielectric <bsdf-dielectric>` or
 :ref:`roughdielectric <bsdf-roughdielectric>` BSDF).
 
-.. note:: This integrator does not implement good sampling strategies to render
-    participating media with a spectrally varying extinction coefficient. For these cases,
-    it is better to use the more advanced :ref:`volumetric path tracer with
-    spectral MIS <integrator-volpathmis>`, which will produce in a significantly less noisy
-    rendered image.
+By default, collisions in media are sampled with delta tracking, using the
+extinction of a single (randomly chosen) color channel. This produces noisy
+images for media with a spectrally varying extinction coefficient. Two
+alternatives are available for such media:
+
+- :monosp:`spectral`: *spectral tracking* :cite:`Kutz17spectral` still samples tentative
+  collisions with the majorant of one channel, but decides whether a
+  collision is real or null based on the maximum over all channels of the
+  path throughput times the respective coefficients. The paths of all
+  channels are then weighted accordingly, which keeps the weights bounded
+  for strongly chromatic media such as skin, milk or colored smoke.
+- :monosp:`decomposition`: *decomposition tracking* :cite:`Kutz17spectral` splits the
+  extinction into a control component provided by the medium (the entire
+  extinction of a :ref:`homogeneous <medium-homogeneous>` medium, or the
+  ``control_sigma_t`` of a :ref:`heterogeneous <medium-heterogeneous>` one)
+  and a residual. Free flights in the former are sampled analytically, using
+  the mixture of the exponential distributions of all channels, and the
+  latter is handled with spectral tracking. When the control component
+  captures most of the extinction, far fewer null collisions occur.
+
+Free flights in :ref:`homogeneous <medium-homogeneous>` media are always
+sampled analytically in this way, regardless of the tracking technique, and
+their transmittance along shadow rays is evaluated in closed form. Neither
+requires any tentative collisions.
+
+.. note:: The :ref:`volumetric path tracer with spectral MIS
+    <integrator-volpathmis>` is an alternative for media with a spectrally
+    varying extinction coefficient.
 
 .. warning:: This integrator does not support forward-mode differentiation.
 
@@ -72,11 +108,28 @@ template <typename Float, typename Spectrum>
 class VolumetricPathIntegrator : public MonteCarloIntegrator<Float, Spectrum> {
 
 public:
-    MI_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters)
+    MI_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters,
+                   m_primary_aovs, write_primary_aovs, m_adjoint_rr,
+                   adjoint_rr, rr_recording, rr_estimate, rr_survival, rr_record)
     MI_IMPORT_TYPES(Scene, Sampler, Emitter, EmitterPtr, BSDF, BSDFPtr,
                      Medium, MediumPtr, PhaseFunctionContext)
 
+    /// Technique used to sample collisions in media
+    enum class Tracking { Delta, Spectral, Decomposition };
+
     VolumetricPathIntegrator(const Properties &props) : Base(props) {
+        parse_adjoint_rr(props);
+
+        std::string tracking = props.string("tracking", "delta");
+        if (tracking == "delta")
+            m_tracking = Tracking::Delta;
+        else if (tracking == "spectral")
+            m_tracking = Tracking::Spectral;
+        else if (tracking == "decomposition")
+            m_tracking = Tracking::Decomposition;
+        else
+            Throw("Invalid tracking technique \"%s\", must be one of: "
+                  "\"delta\", \"spectral\" or \"decomposition\"!", tracking);
     }
 
     MI_INLINE
@@ -95,10 +148,29 @@ public:
                                      Sampler *sampler,
                                      const RayDifferential3f &ray_,
                                      const Medium *initial_medium,
-                                     Float * /* aovs */,
+                                     Float *aovs,
                                      Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
 
+        /* Attributes of the first intersection requested by the 'aov' plugin.
+           The camera ray is only intersected with the full extent of the
+           scene when it doesn't start inside a medium. */
+        bool record_aovs = aovs && !m_primary_aovs.empty(),
+             record_in_loop = record_aovs && !initial_medium;
+        SurfaceInteraction3f primary_si = dr::zeros<SurfaceInteraction3f>();
+        Mask primary_pending = record_aovs;
+
+        /* Adjoint-driven Russian roulette: expected contribution to the pixel
+           after the first vertex, and the vertex whose scattered radiance is
+           recorded during training passes (chosen by reservoir sampling) */
+        bool use_estimates = adjoint_rr(), recording = rr_recording();
+        Float    rr_pixel      = -1.f;
+        Mask     rr_first      = true;
+        Point3f  rr_p          = dr::zeros<Point3f>();
+        Spectrum rr_result     = 0.f,
+                 rr_throughput = 0.f;
+        UInt32   rr_count      = 0;
+
         // If there is an environment emitter and emitters are visible: all rays will be valid
         // Otherwise, it will depend on whether a valid interaction is sampled
         Mask valid_ray = !m_hide_emitters && (scene->environment() != nullptr);
@@ -144,12 +216,22 @@ public:
             Mask needs_intersection;
             Mask specular_chain;
             Mask valid_ray;
+            SurfaceInteraction3f primary_si;
+            Mask primary_pending;
+            Float rr_pixel;
+            Mask rr_first;
+            Point3f rr_p;
+            Spectrum rr_result;
+            Spectrum rr_throughput;
+            UInt32 rr_count;
             Sampler* sampler;
 
             DRJIT_STRUCT(LoopState, active, depth, ray, throughput, result, \
                 si, mei, medium, eta, last_scatter_event, \
                 last_scatter_direction_pdf, needs_intersection, \
-                specular_chain, valid_ray, sampler)
+                specular_chain, valid_ray, primary_si, primary_pending, \
+                rr_pixel, rr_first, rr_p, rr_result, rr_throughput, \
+                rr_count, sampler)
         } ls = {
             active,
             depth,
@@ -165,12 +247,21 @@ public:
             needs_intersection,
             specular_chain,
             valid_ray,
+            primary_si,
+            primary_pending,
+            rr_pixel,
+            rr_first,
+            rr_p,
+            rr_result,
+            rr_throughput,
+            rr_count,
             sampler
         };
 
         dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
             [](const LoopState& ls) { return ls.active; },
-            [this, scene, channel](LoopState& ls) {
+            [this, scene, channel, record_in_loop, use_estimates,
+             recording](LoopState& ls) {
 
             Mask& active = ls.active;
             UInt32& depth = ls.depth;
@@ -195,6 +286,31 @@ public:
             active &= dr::any(unpolarized_spectrum(throughput) != 0.f);
             Float q = dr::minimum(dr::max(unpolarized_spectrum(throughput)) * dr::square(eta), .95f);
             Mask perform_rr = (depth > (uint32_t) m_rr_depth);
+
+            // The ray starts at a scattering vertex after the first bounce
+            Mask scattered = active && depth > 0u;
+            if (use_estimates) {
+                Mask first = scattered && ls.rr_first;
+                dr::masked(ls.rr_pixel, first) =
+                    dr::mean(unpolarized_spectrum(throughput)) *
+                    rr_estimate(ray.o, first);
+                ls.rr_first &= !first;
+
+                auto [q_adj, rr_valid] =
+                    rr_survival(ray.o, throughput, ls.rr_pixel, scattered);
+                dr::masked(q, rr_valid) = q_adj;
+                perform_rr |= rr_valid;
+            }
+
+            if (recording) {
+                dr::masked(ls.rr_count, scattered) += 1;
+                Mask replace = scattered &&
+                    sampler->next_1d(scattered) * Float(ls.rr_count) < 1.f;
+                dr::masked(ls.rr_p, replace) = ray.o;
+                dr::masked(ls.rr_result, replace) = result;
+                dr::masked(ls.rr_throughput, replace) = throughput;
+            }
+
             active &= sampler->next_1d(active) < q || !perform_rr;
             dr::masked(throughput, perform_rr) *= dr::rcp(dr::detach(q));
 
@@ -208,18 +324,58 @@ public:
             Mask act_null_scatter = false, act_medium_scatter = false,
                  escaped_medium = false;
 
-            // If the medium does not have a spectrally varying extinction,
-            // we can perform a few optimizations to speed up rendering
-            Mask is_spectral = active_medium;
+            /* Spectral and decomposition tracking weight the collisions of
+               all channels themselves, and so do the analytic free flights in
+               homogeneous media. Otherwise, if the medium does not have a
+               spectrally varying extinction, we can perform a few
+               optimizations to speed up rendering */
+            Mask homogeneous = false;
+            if (dr::any_or<true>(active_medium))
+                homogeneous = active_medium && medium->is_homogeneous();
+            Mask tracked = (m_tracking != Tracking::Delta ? active_medium : Mask(false)) || homogeneous;
+            Mask is_spectral = active_medium && !tracked;
             Mask not_spectral = false;
             if (dr::any_or<true>(active_medium)) {
                 is_spectral &= medium->has_spectral_extinction();
-                not_spectral = !is_spectral && active_medium;
+                not_spectral = !is_spectral && active_medium && !tracked;
             }
 
             if (dr::any_or<true>(active_medium)) {
-                mei = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
-                dr::masked(ray.maxt, active_medium && medium->is_homogeneous() && mei.is_valid()) = mei.t;
+                /* Decomposition tracking: the free flight in the control
+                   component is sampled analytically, and competes with the
+                   collisions of the residual, whose majorant is reduced by
+                   the smallest control extinction. Homogeneous media consist
+                   of their control component only, which is why they take
+                   this path with all tracking techniques and never sample
+                   tentative collisions. */
+                UnpolarizedSpectrum sigma_c = 0.f;
+                Mask control = false;
+                Float majorant_offset = 0.f;
+                Mask controlled = m_tracking == Tracking::Decomposition ? tracked : homogeneous;
+                if (dr::any_or<true>(controlled)) {
+                    MediumInteraction3f mei_c = dr::zeros<MediumInteraction3f>();
+                    mei_c.p           = ray.o;
+                    mei_c.time        = ray.time;
+                    mei_c.wavelengths = ray.wavelengths;
+                    sigma_c = medium->get_control_extinction(mei_c, controlled);
+                    control = controlled && dr::any(sigma_c > 0.f);
+                    dr::masked(majorant_offset, control && !homogeneous) = dr::min(sigma_c);
+                }
+
+                Mask sampled = active_medium && !homogeneous;
+                if (dr::any_or<true>(sampled))
+                    mei = medium->sample_interaction(ray, sampler->next_1d(sampled), channel,
+                                                     sampled, majorant_offset, depth);
+                if (dr::any_or<true>(homogeneous)) {
+                    MediumInteraction3f mei_h = dr::zeros<MediumInteraction3f>();
+                    mei_h.t           = dr::Infinity<Float>;
+                    mei_h.wi          = -ray.d;
+                    mei_h.sh_frame    = Frame3f(mei_h.wi);
+                    mei_h.time        = ray.time;
+                    mei_h.wavelengths = ray.wavelengths;
+                    mei_h.medium      = medium;
+                    dr::masked(mei, homogeneous) = mei_h;
+                }
                 Mask intersect = needs_intersection && active_medium;
                 if (dr::any_or<true>(intersect))
                     dr::masked(si, intersect) = scene->ray_intersect(ray, intersect);
@@ -232,13 +388,74 @@ public:
                     dr::masked(throughput, is_spectral) *= dr::select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
                 }
 
+                Mask control_hit = false;
+                if (dr::any_or<true>(control)) {
+                    // Sample the distance with the extinction of a random channel
+                    uint32_t n_channels = (uint32_t) dr::size_v<UnpolarizedSpectrum>;
+                    UInt32 control_channel = (UInt32) dr::minimum(
+                        sampler->next_1d(control) * n_channels, n_channels - 1);
+                    Float sigma_hero = sigma_c[0];
+                    for (uint32_t i = 1; i < n_channels; ++i)
+                        dr::masked(sigma_hero, control_channel == i) = sigma_c[i];
+                    Float t_c = dr::select(
+                        control && sigma_hero > 0.f,
+                        -dr::log(1.f - sampler->next_1d(control)) / sigma_hero,
+                        dr::Infinity<Float>);
+
+                    Float t_end = dr::minimum(mei.t, si.t);
+                    control_hit = control && t_c < t_end;
+                    dr::masked(t_end, control_hit) = t_c;
+
+                    // Weight all channels by the mixture of their free-flight densities
+                    UnpolarizedSpectrum tr_c = dr::select(sigma_c > 0.f, dr::exp(-sigma_c * t_end), 1.f),
+                                        f_c  = dr::select(control_hit, sigma_c * tr_c, tr_c);
+                    Float pdf_c = dr::mean(f_c);
+                    dr::masked(throughput, control) *= dr::select(pdf_c > 0.f, f_c / pdf_c, 0.f);
+
+                    // A collision with the control component is a real one
+                    if (dr::any_or<true>(control_hit)) {
+                        MediumInteraction3f mei_c = mei;
+                        mei_c.t = t_c;
+                        mei_c.p = ray(t_c);
+                        std::tie(mei_c.sigma_s, mei_c.sigma_n, mei_c.sigma_t) =
+                            medium->get_scattering_coefficients(mei_c, control_hit);
+                        dr::masked(mei, control_hit) = mei_c;
+                        dr::masked(throughput, control_hit) *= dr::select(
+                            mei.sigma_t > 0.f, mei.sigma_s / mei.sigma_t, 0.f);
+                    }
+                }
+
                 escaped_medium = active_medium && !mei.is_valid();
                 active_medium &= mei.is_valid();
 
                 // Handle null and real scatter events
-                Mask null_scatter = sampler->next_1d(active_medium) >= index_spectrum(mei.sigma_t, channel) / index_spectrum(mei.combined_extinction, channel);
+                Mask null_scatter = sampler->next_1d(active_medium && !tracked) >= index_spectrum(mei.sigma_t, channel) / index_spectrum(mei.combined_extinction, channel);
+                act_null_scatter |= null_scatter && active_medium && !tracked;
+
+                /* Spectral tracking: choose between real and null collisions
+                   of the (residual) medium based on the maximum over the
+                   channels of the path throughput times their coefficients */
+                Mask residual = tracked && active_medium && !control_hit;
+                if (dr::any_or<true>(residual)) {
+                    Float majorant = index_spectrum(mei.combined_extinction, channel);
+                    UnpolarizedSpectrum sigma_r  = mei.sigma_t - sigma_c,
+                                        sigma_rn = majorant - sigma_r,
+                                        weight   = unpolarized_spectrum(throughput);
+                    Float p_real = dr::max(dr::abs(sigma_r * weight)),
+                          p_sum  = p_real + dr::max(dr::abs(sigma_rn * weight));
+                    p_real = dr::select(p_sum > 0.f, p_real / p_sum, 0.f);
+
+                    Mask tracked_null = residual && sampler->next_1d(residual) >= p_real,
+                         tracked_real = residual && !tracked_null;
+                    UnpolarizedSpectrum albedo = dr::select(
+                        mei.sigma_t > 0.f, mei.sigma_s / mei.sigma_t, 0.f);
+                    dr::masked(throughput, tracked_real) *=
+                        sigma_r * albedo / (majorant * p_real);
+                    dr::masked(throughput, tracked_null) *=
+                        sigma_rn / (majorant * (1.f - p_real));
+                    act_null_scatter |= tracked_null;
+                }
 
-                act_null_scatter |= null_scatter && active_medium;
                 act_medium_scatter |= !act_null_scatter && active_medium;
 
                 if (dr::any_or<true>(is_spectral && act_null_scatter))
@@ -277,7 +494,7 @@ public:
 
                 Mask active_e = act_medium_scatter && sample_emitters;
                 if (dr::any_or<true>(active_e)) {
-                    auto [emitted, ds] = sample_emitter(mei, scene, sampler, medium, channel, active_e);
+                    auto [emitted, ds] = sample_emitter(mei, scene, sampler, medium, channel, depth, active_e);
                     auto [phase_val, phase_pdf] = phase->eval_pdf(phase_ctx, mei, ds.d, active_e);
                     dr::masked(result, active_e) += throughput * phase_val * emitted *
                                                     mis_weight(ds.pdf, dr::select(ds.delta, 0.f, phase_pdf));
@@ -303,6 +520,11 @@ public:
             if (dr::any_or<true>(intersect))
                 dr::masked(si, intersect) = scene->ray_intersect(ray, intersect);
 
+            if (record_in_loop) {
+                dr::masked(ls.primary_si, ls.primary_pending) = si;
+                ls.primary_pending = false;
+            }
+
             if (dr::any_or<true>(active_surface)) {
                 // ---------------- Intersection with emitters ----------------
                 Mask ray_from_camera = active_surface && (depth == 0u);
@@ -330,26 +552,42 @@ public:
                 BSDFPtr bsdf  = si.bsdf(ray);
                 Mask active_e = active_surface && has_flag(bsdf->flags(), BSDFFlags::Smooth) && (depth + 1 < (uint32_t) m_max_depth);
 
+                Spectrum emitted(0.f);
+                DirectionSample3f ds = dr::zeros<DirectionSample3f>();
+                Vector3f wo = dr::zeros<Vector3f>();
                 if (likely(dr::any_or<true>(active_e))) {
-                    auto [emitted, ds] = sample_emitter(si, scene, sampler, medium, channel, active_e);
+                    std::tie(emitted, ds) = sample_emitter(si, scene, sampler, medium, channel, depth, active_e);
+                    wo = si.to_local(ds.d);
+                }
+
+                /* Query the BSDF for the emitter-sampled direction and sample
+                   the next direction using a single (fused) BSDF call */
+                Float sample_1   = sampler->next_1d(active_surface);
+                Point2f sample_2 = sampler->next_2d(active_surface);
+                auto [bsdf_val, bsdf_pdf, bs, bsdf_weight] = bsdf->eval_pdf_sample(
+                    ctx, si, wo, sample_1, sample_2, active_surface);
+
+                // Depolarizing BSDFs do not require a change of Stokes basis
+                Mask rotate_mueller = true;
+                if constexpr (is_polarized_v<Spectrum>)
+                    rotate_mueller = !has_flag(bsdf->flags(), BSDFFlags::Depolarizing);
 
-                    // Query the BSDF for that emitter-sampled direction
-                    Vector3f wo       = si.to_local(ds.d);
-                    Spectrum bsdf_val = bsdf->eval(ctx, si, wo, active_e);
-                    bsdf_val = si.to_world_mueller(bsdf_val, -wo, si.wi);
+                if (likely(dr::any_or<true>(active_e))) {
+                    if (dr::any_or<true>(rotate_mueller))
+                        dr::masked(bsdf_val, rotate_mueller) =
+                            si.to_world_mueller(bsdf_val, -wo, si.wi);
 
-                    // Determine probability of having sampled that same
-                    // direction using BSDF sampling.
-                    Float bsdf_pdf = bsdf->pdf(ctx, si, wo, active_e);
+                    // 'bsdf_pdf' is the probability of having sampled that
+                    // same direction using BSDF sampling.
                     result[active_e] += throughput * bsdf_val * mis_weight(ds.pdf, dr::select(ds.delta, 0.f, bsdf_pdf)) * emitted;
                 }
 
                 // ----------------------- BSDF sampling ----------------------
-                auto [bs, bsdf_val] = bsdf->sample(ctx, si, sampler->next_1d(active_surface),
-                                                   sampler->next_2d(active_surface), active_surface);
-                bsdf_val = si.to_world_mueller(bsdf_val, -bs.wo, si.wi);
+                if (dr::any_or<true>(rotate_mueller))
+                    dr::masked(bsdf_weight, rotate_mueller) =
+                        si.to_world_mueller(bsdf_weight, -bs.wo, si.wi);
 
-                dr::masked(throughput, active_surface) *= bsdf_val;
+                dr::masked(throughput, active_surface) *= bsdf_weight;
                 dr::masked(eta, active_surface) *= bs.eta;
 
                 Ray3f bsdf_ray                  = si.spawn_ray(si.to_world(bs.wo));
@@ -374,6 +612,25 @@ public:
         },
         "Volpath integrator");
 
+        if (record_aovs) {
+            // Paths that terminated early or started inside a medium
+            Mask retrace = active && ls.primary_pending;
+            if (dr::any_or<true>(retrace))
+                dr::masked(ls.primary_si, retrace) =
+                    scene->ray_intersect(ray_, +RayFlags::All, true, retrace);
+            write_primary_aovs(m_primary_aovs, scene, ray_, ls.primary_si,
+                               aovs, active);
+        }
+
+        // Radiance scattered at the selected vertex, weighted by the vertex count
+        if (recording) {
+            Float throughput = dr::mean(unpolarized_spectrum(ls.rr_throughput));
+            rr_record(ls.rr_p,
+                      dr::mean(unpolarized_spectrum(ls.result - ls.rr_result)) /
+                          throughput,
+                      Float(ls.rr_count), active && throughput > 0.f);
+        }
+
         return { ls.result, ls.valid_ray };
     }
 
@@ -383,7 +640,7 @@ public:
     std::tuple<Spectrum, DirectionSample3f>
     sample_emitter(const Interaction &ref_interaction, const Scene *scene,
                    Sampler *sampler, MediumPtr medium,
-                   UInt32 channel, Mask active) const {
+                   UInt32 channel, UInt32 depth, Mask active) const {
         Spectrum transmittance(1.0f);
 
         auto [ds, emitter_val] = scene->sample_emitter_direction(ref_interaction, sampler->next_2d(active), false, active);
@@ -435,7 +692,7 @@ public:
 
         dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
             [](const LoopState& ls) { return dr::detach(ls.active); },
-            [this, scene, channel, max_dist](LoopState& ls) {
+            [this, scene, channel, depth, max_dist](LoopState& ls) {
 
             Mask& active = ls.active;
             Ray3f& ray = ls.ray;
@@ -458,8 +715,29 @@ public:
             Mask active_surface = active && !active_medium;
 
             if (dr::any_or<true>(active_medium)) {
-                auto mei = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
-                dr::masked(ray.maxt, active_medium && medium->is_homogeneous() && mei.is_valid()) = dr::minimum(mei.t, remaining_dist);
+                Mask homogeneous = active_medium && medium->is_homogeneous();
+                if (dr::any_or<true>(homogeneous)) {
+                    // Homogeneous media: analytic transmittance up to the next surface
+                    Mask intersect = needs_intersection && homogeneous;
+                    if (dr::any_or<true>(intersect))
+                        dr::masked(si, intersect) = scene->ray_intersect(ray, intersect);
+                    needs_intersection &= !homogeneous;
+
+                    MediumInteraction3f mei = dr::zeros<MediumInteraction3f>();
+                    mei.p           = ray.o;
+                    mei.time        = ray.time;
+                    mei.wavelengths = ray.wavelengths;
+                    UnpolarizedSpectrum sigma_t = medium->get_majorant(mei, homogeneous);
+                    Float t = dr::minimum(remaining_dist, si.t);
+                    dr::masked(transmittance, homogeneous) *= dr::exp(-sigma_t * t);
+
+                    escaped_medium = homogeneous;
+                    active_medium &= !homogeneous;
+                }
+            }
+
+            if (dr::any_or<true>(active_medium)) {
+                auto mei = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium, 0.f, depth);
                 Mask intersect = needs_intersection && active_medium;
                 if (dr::any_or<true>(intersect))
                     dr::masked(si, intersect) = scene->ray_intersect(ray, intersect);
@@ -481,7 +759,7 @@ public:
                 dr::masked(total_dist, active_medium && (mei.t > remaining_dist) && mei.is_valid()) = dir_sample.dist;
                 dr::masked(mei.t, active_medium && (mei.t > remaining_dist)) = dr::Infinity<Float>;
 
-                escaped_medium = active_medium && !mei.is_valid();
+                escaped_medium |= active_medium && !mei.is_valid();
                 active_medium &= mei.is_valid();
                 is_spectral &= active_medium;
                 not_spectral &= active_medium;
@@ -538,12 +816,20 @@ public:
     //! @}
     // =============================================================
 
+    bool supports_primary_aovs() const override { return true; }
+
     std::string to_string() const override {
         return tfm::format("VolumetricSimplePathIntegrator[\n"
                            "  max_depth = %i,\n"
-                           "  rr_depth = %i\n"
+                           "  rr_depth = %i,\n"
+                           "  rr_mode = %s,\n"
+                           "  tracking = %s\n"
                            "]",
-                           m_max_depth, m_rr_depth);
+                           m_max_depth, m_rr_depth,
+                           m_adjoint_rr ? "adjoint" : "throughput",
+                           m_tracking == Tracking::Delta    ? "delta" :
+                           m_tracking == Tracking::Spectral ? "spectral"
+                                                            : "decomposition");
     }
 
     Float mis_weight(Float pdf_a, Float pdf_b) const {
@@ -554,6 +840,8 @@ public:
     };
 
     MI_DECLARE_CLASS()
+private:
+    Tracking m_tracking;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(VolumetricPathIntegrator, MonteCarloIntegrator);
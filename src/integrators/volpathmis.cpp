@@ -47,7 +47,9 @@ The implementation is based on the method proposed by Miller et al. :cite:`Mille
 and is only marginally slower than the :ref:`simple volumetric path tracer <integrator-volpath>`.
 
 Similar to the simple volumetric path tracer, this integrator has special
-support for index-matched transmission events.
+support for index-matched transmission events. Collisions in
+:ref:`homogeneous <medium-homogeneous>` media are never null collisions, and
+the transmittance of shadow rays through them is evaluated in closed form.
 
 .. warning:: This integrator does not support forward-mode differentiation.
 
@@ -255,14 +257,15 @@ public:
             // If the medium does not have a spectrally varying extinction,
             // we can perform a few optimizations to speed up rendering
             Mask is_spectral = active_medium;
-            Mask not_spectral = false;
+            Mask not_spectral = false, homogeneous = false;
             if (dr::any_or<true>(active_medium)) {
                 is_spectral &= medium->has_spectral_extinction();
                 not_spectral = !is_spectral && active_medium;
+                homogeneous = active_medium && medium->is_homogeneous();
             }
 
             if (dr::any_or<true>(active_medium)) {
-                mei = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
+                mei = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium, 0.f, depth);
                 dr::masked(ray.maxt, active_medium && medium->is_homogeneous() && mei.is_valid()) = mei.t;
                 Mask intersect = needs_intersection && active_medium;
                 if (dr::any_or<true>(intersect))
@@ -279,11 +282,14 @@ public:
                 active_medium &= mei.is_valid();
                 is_spectral &= active_medium;
                 not_spectral &= active_medium;
+                homogeneous &= active_medium;
             }
 
             if (dr::any_or<true>(active_medium)) {
-                Mask null_scatter = sampler->next_1d(active_medium) >= index_spectrum(mei.sigma_t, channel) / index_spectrum(mei.combined_extinction, channel);
-                act_null_scatter |= null_scatter && active_medium;
+                // Collisions in homogeneous media are always real ones
+                Mask tentative = active_medium && !homogeneous;
+                Mask null_scatter = sampler->next_1d(tentative) >= index_spectrum(mei.sigma_t, channel) / index_spectrum(mei.combined_extinction, channel);
+                act_null_scatter |= null_scatter && tentative;
                 act_medium_scatter |= !act_null_scatter && active_medium;
                 last_event_was_null = act_null_scatter;
 
@@ -326,7 +332,7 @@ public:
                     if (dr::any_or<true>(active_e)) {
                         auto [p_over_f_nee_end, p_over_f_end, emitted, ds] =
                             sample_emitter(mei, scene, sampler, medium, p_over_f,
-                                           channel, active_e);
+                                           channel, depth, active_e);
                         auto [phase_val, phase_pdf] = phase->eval_pdf(phase_ctx, mei, ds.d, active_e);
 
                         update_weights(p_over_f_nee_end, 1.0f, unpolarized_spectrum(phase_val), channel, active_e);
@@ -387,18 +393,29 @@ public:
                 BSDFContext ctx;
                 BSDFPtr bsdf  = si.bsdf(ray);
                 Mask active_e = active_surface && has_flag(bsdf->flags(), BSDFFlags::Smooth) && (depth + 1 < (uint32_t) m_max_depth);
+                WeightMatrix p_over_f_nee_end = p_over_f, p_over_f_end = p_over_f;
+                Spectrum emitted(0.f);
+                DirectionSample3f ds = dr::zeros<DirectionSample3f>();
+                Vector3f wo_local = dr::zeros<Vector3f>();
+                if (likely(dr::any_or<true>(active_e))) {
+                    std::tie(p_over_f_nee_end, p_over_f_end, emitted, ds) = sample_emitter(si, scene, sampler, medium, p_over_f, channel, depth, active_e);
+                    wo_local = si.to_local(ds.d);
+                }
+
+                /* Query the BSDF for the emitter-sampled direction and sample
+                   the next direction using a single (fused) BSDF call */
+                Float sample_1   = sampler->next_1d(active_surface);
+                Point2f sample_2 = sampler->next_2d(active_surface);
+                auto [bsdf_val, bsdf_pdf, bs, bsdf_weight] = bsdf->eval_pdf_sample(
+                    ctx, si, wo_local, sample_1, sample_2, active_surface);
+
                 if (likely(dr::any_or<true>(active_e))) {
-                    auto [p_over_f_nee_end, p_over_f_end, emitted, ds] = sample_emitter(si, scene, sampler, medium, p_over_f, channel, active_e);
-                    Vector3f wo_local       = si.to_local(ds.d);
-                    auto [bsdf_val, bsdf_pdf] = bsdf->eval_pdf(ctx, si, wo_local, active_e);
                     update_weights(p_over_f_nee_end, 1.0f, unpolarized_spectrum(bsdf_val), channel, active_e);
                     update_weights(p_over_f_end, dr::select(ds.delta, 0.f, bsdf_pdf), unpolarized_spectrum(bsdf_val), channel, active_e);
                     dr::masked(result, active_e) += mis_weight(p_over_f_nee_end, p_over_f_end) * emitted;
                 }
 
                 // ----------------------- BSDF sampling ----------------------
-                auto [bs, bsdf_weight] = bsdf->sample(ctx, si, sampler->next_1d(active_surface),
-                                                   sampler->next_2d(active_surface), active_surface);
                 Mask invalid_bsdf_sample = active_surface && (bs.pdf == 0.f);
                 active_surface &= bs.pdf > 0.f;
                 dr::masked(eta, active_surface) *= bs.eta;
@@ -434,7 +451,7 @@ public:
     sample_emitter(const Interaction &ref_interaction, const Scene *scene,
                    Sampler *sampler, MediumPtr medium,
                    const WeightMatrix &p_over_f, UInt32 channel,
-                   Mask active) const {
+                   UInt32 depth, Mask active) const {
         WeightMatrix p_over_f_nee = p_over_f, p_over_f_uni = p_over_f;
 
         auto [ds, emitter_sample_weight] = scene->sample_emitter_direction(ref_interaction, sampler->next_2d(active), false, active);
@@ -491,7 +508,7 @@ public:
 
         dr::tie(ls) = dr::while_loop(dr::make_tuple(ls),
             [](const LoopState& ls) { return dr::detach(ls.active); },
-            [this, scene, channel, max_dist](LoopState& ls) {
+            [this, scene, channel, depth, max_dist](LoopState& ls) {
 
             Mask& active = ls.active;
             Ray3f& ray = ls.ray;
@@ -515,8 +532,32 @@ public:
             Mask active_surface = active && !active_medium;
 
             if (dr::any_or<true>(active_medium)) {
-                auto mei = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
-                dr::masked(ray.maxt, active_medium && medium->is_homogeneous() && mei.is_valid()) = dr::minimum(mei.t, remaining_dist);
+                Mask homogeneous = active_medium && medium->is_homogeneous();
+                if (dr::any_or<true>(homogeneous)) {
+                    /* Homogeneous media: analytic transmittance up to the next
+                       surface. Unidirectional sampling passes through the
+                       segment with the same probability. */
+                    Mask intersect = needs_intersection && homogeneous;
+                    if (dr::any_or<true>(intersect))
+                        dr::masked(si, intersect) = scene->ray_intersect(ray, intersect);
+                    needs_intersection &= !homogeneous;
+
+                    MediumInteraction3f mei = dr::zeros<MediumInteraction3f>();
+                    mei.p           = ray.o;
+                    mei.time        = ray.time;
+                    mei.wavelengths = ray.wavelengths;
+                    UnpolarizedSpectrum sigma_t = medium->get_majorant(mei, homogeneous);
+                    UnpolarizedSpectrum tr = dr::exp(-sigma_t * dr::minimum(remaining_dist, si.t));
+                    update_weights(p_over_f_nee, 1.f, tr, channel, homogeneous);
+                    update_weights(p_over_f_uni, tr, tr, channel, homogeneous);
+
+                    escaped_medium = homogeneous;
+                    active_medium &= !homogeneous;
+                }
+            }
+
+            if (dr::any_or<true>(active_medium)) {
+                auto mei = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium, 0.f, depth);
                 Mask intersect = needs_intersection && active_medium;
                 if (dr::any_or<true>(intersect))
                     dr::masked(si, intersect) = scene->ray_intersect(ray, intersect);
@@ -536,7 +577,7 @@ public:
                 dr::masked(total_dist, active_medium && (mei.t > remaining_dist) && mei.is_valid()) = dir_sample.dist;
                 dr::masked(mei.t, active_medium && (mei.t > remaining_dist)) = dr::Infinity<Float>;
 
-                escaped_medium = active_medium && !mei.is_valid();
+                escaped_medium |= active_medium && !mei.is_valid();
                 active_medium &= mei.is_valid();
                 is_spectral &= active_medium;
                 not_spectral &= active_medium;
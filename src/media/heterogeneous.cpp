@@ -38,6 +38,24 @@ Heterogeneous medium (:monosp:`heterogeneous`)
      units, or to simply tweak the density of the medium. (Default: 1)
    - |exposed|
 
+ * - majorant_cell_size
+   - |int|
+   - Size (in voxels of the extinction volume) of the cells of the majorant
+     grid, see below. A value of 0 uses a single majorant for the entire
+     medium. (Default: 16)
+
+ * - control_sigma_t
+   - |float| or |spectrum|
+   - Extinction coefficient of the control component used by decomposition
+     tracking, see below. It is scaled by ``scale`` and should not exceed the
+     extinction anywhere in the medium. (Default: 0)
+
+ * - lod_step
+   - |float|
+   - Number of MIP levels of the extinction and albedo volumes by which the
+     lookups become coarser with each scattering event on the path, see below.
+     (Default: 0, i.e. always use the full resolution)
+
  * - sample_emitters
    - |bool|
    - Flag to specify whether shadow rays should be cast from inside the volume (Default: |true|)
@@ -68,6 +86,34 @@ meters and the coefficients are in inverse millimeters, set scale to 1000.
 Both the albedo and the extinction coefficient can either be constant or textured,
 and both parameters are allowed to be spectrally varying.
 
+Free-flight distances are sampled using delta tracking, which requires an
+upper bound (the *majorant*) of the extinction coefficient. When the
+extinction is given by a grid, the medium subdivides it into cells of
+``majorant_cell_size`` voxels along each axis and stores the maximum
+extinction over each cell. Rays then traverse this coarse grid using a 3D
+digital differential analyzer and sample distances with the local majorant of
+each cell, which avoids most null collisions in the thin regions of sparse
+volumes. The majorant grid is rebuilt when the parameters of the medium
+change.
+
+The ``volpath`` integrator can alternatively render the medium with
+decomposition tracking (``tracking="decomposition"``). The extinction is then
+split into the constant (but possibly chromatic) ``control_sigma_t``, whose
+free-flight distances are sampled analytically, and a residual that is tracked
+with null collisions. This is most effective for dense media with a roughly
+constant chromatic extinction, such as skin or milk.
+
+When the volumes provide a MIP pyramid (e.g. a :ref:`grid volume
+<volume-gridvolume>` with ``mip_levels`` larger than 1), the medium can look up
+coarser levels on secondary paths, whose details are blurred by the preceding
+scattering events anyway. With ``lod_step`` set to 1, for instance, camera rays
+use the full resolution, and the paths after the first scattering event use
+the first coarser level, and so on. The level is chosen by
+:ref:`volpath <integrator-volpath>` and :ref:`volpathmis
+<integrator-volpathmis>` from the number of scattering events on the path,
+other integrators always use the full resolution. This trades a slight blur of
+the indirect illumination for less memory traffic per lookup.
+
 .. tabs::
     .. code-tab:: xml
         :name: lst-heterogeneous
@@ -156,29 +202,53 @@ public:
         m_is_homogeneous = false;
         m_albedo = props.volume<Volume>("albedo", 0.75f);
         m_sigmat = props.volume<Volume>("sigma_t", 1.f);
+        m_control_sigmat = props.volume<Volume>("control_sigma_t", 0.f);
 
         m_scale = props.get<ScalarFloat>("scale", 1.0f);
         m_has_spectral_extinction = props.get<bool>("has_spectral_extinction", true);
 
-        m_max_density = dr::opaque<Float>(m_scale * m_sigmat->max());
+        int cell_size = props.get<int>("majorant_cell_size", 16);
+        if (cell_size < 0)
+            Throw("The majorant cell size must be non-negative!");
+        m_majorant_cell_size = (uint32_t) cell_size;
+
+        m_lod_step = props.get<ScalarFloat>("lod_step", 0.f);
+        if (m_lod_step < 0.f)
+            Throw("The LOD step must be non-negative!");
+
+        update_majorants();
     }
 
     void traverse(TraversalCallback *callback) override {
         callback->put_parameter("scale", m_scale,        +ParamFlags::NonDifferentiable);
         callback->put_object("albedo",   m_albedo.get(), +ParamFlags::Differentiable);
         callback->put_object("sigma_t",  m_sigmat.get(), +ParamFlags::Differentiable);
+        callback->put_object("control_sigma_t", m_control_sigmat.get(), +ParamFlags::NonDifferentiable);
         Base::traverse(callback);
     }
 
     void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
-        m_max_density = dr::opaque<Float>(m_scale * m_sigmat->max());
+        update_majorants();
     }
 
     UnpolarizedSpectrum
-    get_majorant(const MediumInteraction3f & /* mi */,
+    get_majorant(const MediumInteraction3f &mi,
                  Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
-        return m_max_density;
+        if (!m_majorant_grid)
+            return m_max_density;
+
+        Point3f p = m_to_local * mi.p;
+        Vector3i cell = dr::clip(dr::floor2int<Vector3i>(p * m_majorant_res_f),
+                                 0, m_majorant_res - 1);
+        return dr::gather<Float>(m_majorants, cell_index(cell), active);
+    }
+
+    UnpolarizedSpectrum
+    get_control_extinction(const MediumInteraction3f &mi,
+                           Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+        return (m_scale * m_control_sigmat->eval(mi, active)) & active;
     }
 
     std::tuple<UnpolarizedSpectrum, UnpolarizedSpectrum, UnpolarizedSpectrum>
@@ -186,12 +256,12 @@ public:
                                 Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
 
-        auto sigmat = m_scale * m_sigmat->eval(mi, active);
+        auto sigmat = m_scale * eval_lod(m_sigmat.get(), mi, active);
         if (has_flag(m_phase_function->flags(), PhaseFunctionFlags::Microflake))
             sigmat *= m_phase_function->projected_area(mi, active);
 
-        auto sigmas = sigmat * m_albedo->eval(mi, active);
-        auto sigman = m_max_density - sigmat;
+        auto sigmas = sigmat * eval_lod(m_albedo.get(), mi, active);
+        auto sigman = get_majorant(mi, active) - sigmat;
         return { sigmas, sigman, sigmat };
     }
 
@@ -205,17 +275,150 @@ public:
         oss << "HeterogeneousMedium[" << std::endl
             << "  albedo  = " << string::indent(m_albedo) << std::endl
             << "  sigma_t = " << string::indent(m_sigmat) << std::endl
-            << "  scale   = " << string::indent(m_scale) << std::endl
-            << "]";
+            << "  scale   = " << string::indent(m_scale) << std::endl;
+        if (m_lod_step > 0.f)
+            oss << "  lod_step = " << m_lod_step << std::endl;
+        if (m_majorant_grid)
+            oss << "  majorant_grid = " << m_majorant_res << std::endl;
+        oss << "]";
         return oss.str();
     }
 
     MI_DECLARE_CLASS()
+
+protected:
+    /**
+     * Sample a free-flight distance by traversing the cells of the majorant
+     * grid with a 3D DDA. The exponential distribution is memoryless, hence
+     * the remaining optical depth of the sample carries over from one cell
+     * to the next.
+     */
+    std::pair<Float, UnpolarizedSpectrum>
+    sample_distance(const MediumInteraction3f &mei, const Ray3f &ray,
+                    Float mint, Float maxt, Float sample, UInt32 channel,
+                    Float majorant_offset, Mask active) const override {
+        if (!m_majorant_grid)
+            return Base::sample_distance(mei, ray, mint, maxt, sample, channel,
+                                         majorant_offset, active);
+
+        // Ray in grid coordinates, parameterized by the world-space distance along it
+        Point3f o = m_to_local * ray(mint);
+        Vector3f d = m_to_local * ray.d;
+        Point3f q = o * m_majorant_res_f;
+        Vector3f dq = d * m_majorant_res_f;
+
+        Vector3i cell = dr::clip(dr::floor2int<Vector3i>(q), 0, m_majorant_res - 1);
+        Vector3f inv_dq = dr::rcp(dq);
+        Vector3i step = dr::select(dq >= 0.f, Vector3i(1), Vector3i(-1));
+        Vector3f t_delta = dr::select(dq != 0.f, dr::abs(inv_dq), dr::Infinity<Float>),
+                 t_next  = dr::select(
+                     dq != 0.f,
+                     mint + (Vector3f(cell + dr::select(dq >= 0.f, Vector3i(1), Vector3i(0))) - q) * inv_dq,
+                     dr::Infinity<Float>);
+
+        Float t = mint,
+              tau = -dr::log(1.f - sample),
+              sampled_t = dr::Infinity<Float>,
+              majorant = 0.f;
+        Mask active_loop = active && mint < maxt;
+
+        std::tie(t, tau, cell, t_next, sampled_t, majorant, active_loop) = dr::while_loop(
+            std::make_tuple(t, tau, cell, t_next, sampled_t, majorant, active_loop),
+            [](const Float &, const Float &, const Vector3i &, const Vector3f &,
+               const Float &, const Float &, const Mask &active_loop) {
+                return active_loop;
+            },
+            [this, maxt, step, t_delta, majorant_offset](
+                Float &t, Float &tau, Vector3i &cell, Vector3f &t_next,
+                Float &sampled_t, Float &majorant, Mask &active_loop) {
+                Float mu = dr::maximum(
+                    dr::gather<Float>(m_majorants, cell_index(cell), active_loop) -
+                        majorant_offset, 0.f);
+                Float t_exit = dr::minimum(dr::min(t_next), maxt),
+                      segment_tau = mu * (t_exit - t);
+
+                // An interaction occurs within this cell
+                Mask hit = active_loop && segment_tau >= tau && mu > 0.f;
+                dr::masked(sampled_t, hit) = t + tau / mu;
+                dr::masked(majorant, active_loop) = mu;
+
+                // Otherwise, advance to the next cell along the axis exited first
+                Mask advance = active_loop && !hit;
+                dr::masked(tau, advance) = tau - segment_tau;
+                dr::masked(t, advance) = t_exit;
+
+                Mask exit_x = t_next.x() <= dr::minimum(t_next.y(), t_next.z()),
+                     exit_y = !exit_x && t_next.y() <= t_next.z(),
+                     exit_z = !exit_x && !exit_y;
+                dr::Array<Mask, 3> axis(exit_x, exit_y, exit_z);
+                dr::masked(cell, advance & axis) = cell + step;
+                dr::masked(t_next, advance & axis) = t_next + t_delta;
+
+                active_loop = advance && t_exit < maxt &&
+                              dr::all(cell >= 0 && cell < m_majorant_res);
+            },
+            "HeterogeneousMedium::sample_distance()");
+
+        return { sampled_t, majorant };
+    }
+
+private:
+    /// Evaluate a volume at the MIP level selected by the depth of the interaction
+    MI_INLINE UnpolarizedSpectrum eval_lod(const Volume *volume,
+                                           const MediumInteraction3f &mi,
+                                           Mask active) const {
+        if (m_lod_step == 0.f || volume->mip_levels() == 1)
+            return volume->eval(mi, active);
+        UInt32 level = dr::floor2int<UInt32>(Float(mi.depth) * m_lod_step);
+        return volume->eval_mip(mi, level, active);
+    }
+
+    /// Linear index of a cell of the majorant grid
+    MI_INLINE UInt32 cell_index(const Vector3i &cell) const {
+        return UInt32((cell.z() * m_majorant_res.y() + cell.y()) *
+                      m_majorant_res.x() + cell.x());
+    }
+
+    /// (Re)build the global majorant and the majorant grid
+    void update_majorants() {
+        m_max_density = dr::opaque<Float>(m_scale * m_sigmat->max());
+
+        ScalarVector3i res = m_sigmat->resolution(), cells(1);
+        if (m_majorant_cell_size > 0)
+            cells = (res + (int32_t) m_majorant_cell_size - 1) /
+                    (int32_t) m_majorant_cell_size;
+
+        m_majorant_grid = dr::any(cells > 1);
+        if (!m_majorant_grid)
+            return;
+
+        std::vector<ScalarFloat> majorants((size_t) dr::prod(cells));
+        m_sigmat->max_per_cell(ScalarVector3u(cells), majorants.data());
+        for (ScalarFloat &value : majorants)
+            value *= m_scale;
+
+        m_majorants = dr::load<FloatStorage>(majorants.data(), majorants.size());
+        m_majorant_res = cells;
+        m_majorant_res_f = ScalarVector3f(cells);
+        m_to_local = m_sigmat->world_to_local();
+    }
+
 private:
-    ref<Volume> m_sigmat, m_albedo;
+    using FloatStorage = DynamicBuffer<Float>;
+
+    ref<Volume> m_sigmat, m_albedo, m_control_sigmat;
     ScalarFloat m_scale;
+    ScalarFloat m_lod_step;
 
     Float m_max_density;
+
+    /// Majorant grid (maximum scaled extinction per cell)
+    uint32_t m_majorant_cell_size;
+    bool m_majorant_grid = false;
+    FloatStorage m_majorants;
+    ScalarVector3i m_majorant_res;
+    ScalarVector3f m_majorant_res_f;
+    ScalarTransform4f m_to_local;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(HeterogeneousMedium, Medium)
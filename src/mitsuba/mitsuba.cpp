@@ -1,3 +1,4 @@
+#include <mitsuba/core/appender.h>
 #include <mitsuba/core/argparser.h>
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/filesystem.h>
@@ -5,14 +6,27 @@
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/jit.h>
 #include <mitsuba/core/logger.h>
+#include <mitsuba/core/mstream.h>
+#include <mitsuba/core/plugin.h>
 #include <mitsuba/core/profiler.h>
+#include <mitsuba/core/resource.h>
 #include <mitsuba/core/thread.h>
+#include <mitsuba/core/timer.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/vector.h>
 #include <mitsuba/core/xml.h>
 #include <mitsuba/render/integrator.h>
 #include <mitsuba/render/records.h>
 #include <mitsuba/render/scene.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
 
 #if !defined(_WIN32)
 #  include <signal.h>
@@ -65,6 +79,118 @@ Options:
     -o <filename>, --output <filename>
         Write the output image to the file "filename".
 
+    -c <seconds>, --checkpoint <seconds>
+        Periodically save the state of the render job to a checkpoint file
+        next to the output image (with the extension ".ckpt"). A checkpoint
+        is also written when the render job is interrupted.
+
+    -r, --resume
+        Continue an interrupted render job from its checkpoint file (if it
+        exists). The scene and rendering parameters must not have changed.
+
+    -p <index>/<count>, --partition <index>/<count>
+        Only render a part of the image (or of the samples in JIT modes),
+        so that a render job can be distributed over several machines.
+        Partition "index" (0-based) out of "count" is rendered and its
+        raw film contents are written to the output filename with the
+        extension ".part<index>".
+
+    -M <path1>;<path2>;.., --merge <path1>;<path2>
+        Merge the partial results created with --partition instead of
+        rendering the scene, and write the final output image.
+
+    -F <count>, --frames <count>
+        Render an animated sequence of "count" frames, whose shutter
+        opening times are evenly distributed over the time interval
+        [0, 1] of the keyframed instances. Frame "i" is written to the
+        output filename with the suffix "_<i>" (e.g. "scene_0003.exr").
+        When the integrator is an "aov" integrator with a "motion" AOV,
+        the motion vectors of every frame are relative to the previous one.
+
+    --tracks <filename>
+        Animate scene parameters over the frames of a sequence (see -F,
+        which defaults to the number of frames spanned by the tracks).
+        Every line of the file holds a frame index followed by
+        "key=value" pairs, e.g. "10 sensor.x_fov=30 bsdf.alpha=0.1".
+        Keys are named as by mitsuba.traverse(), vectors and colors are
+        comma-separated, and values are linearly interpolated between
+        keyframes. The scene is loaded once and updated in place, which
+        reuses the acceleration data structure (refitted when vertices
+        move) and the compiled kernels across frames.
+
+    -P, --profile
+        Measure the time spent in the phases of scene loading and
+        rendering (e.g. BSDF evaluation, ray intersection), and print a
+        hierarchical report at the end. In JIT modes, this covers the
+        tracing rather than the execution of the kernels, hence the
+        number of kernel launches, the kernel cache hit rate, and the
+        compilation and execution times are additionally reported after
+        loading the scene and after rendering.
+
+    --instrument-kernels
+        Label the JIT code traced within each phase (e.g. BSDF::eval(),
+        Texture::eval()) in the generated kernels, and estimate the share
+        of the kernel execution time spent in every phase from the number
+        of instructions it generated. The kernels are compiled separately
+        from uninstrumented ones.
+
+    --stats
+        Print a summary of every render job: the number of samples per
+        second, the average and maximum path length, how the paths were
+        terminated (escaping, Russian roulette, maximum depth, absorption),
+        and the number of shadow rays per extension ray. Path and ray
+        counts are only recorded by the "path" and "ptracer" integrators.
+
+    --trace <filename>
+        Record a timeline of the run (XML parsing, instantiation of every
+        plugin, profiler phases, rendered blocks, and JIT kernel launches)
+        on every thread, and write it to "filename" in the Chrome trace
+        event format (e.g. for https://ui.perfetto.dev).
+
+    --load-report <filename>
+        Write the instantiation time of every object of the loaded scenes,
+        the thread that instantiated it, and the time it waited for its
+        dependencies to "filename" in CSV format. The slowest 20 objects
+        are always logged at the Info level.
+
+    --server
+        Keep scenes resident and render them on request, which avoids
+        paying for plugin loading, scene parsing, acceleration data
+        structure builds and (in JIT modes) kernel compilation for every
+        render job. Commands are read line by line from standard input,
+        and each one is answered by a line starting with "ok" or "error"
+        on standard output ("ok ready" is printed once at startup). Log
+        messages and progress bars are written to standard error:
+
+          load <id> <scene file> [name=value ..]
+              Load a scene file under the identifier "id". The values
+              are passed like -D definitions (in addition to those of
+              the command line).
+          update <id> <key>=<value> ..
+              Set scene parameters named as by mitsuba.traverse() (e.g.
+              "bsdf.reflectance.value=0.2,0.5,0.8") and notify the
+              modified objects, without reloading the scene.
+          render <id> [sensor=<index>] [spp=<count>] [seed=<value>]
+                 [output=<filename>] [<key>=<value> ..]
+              Apply parameter updates (as in "update") and render the
+              scene. "spp=0" (default) uses the sample count of the
+              sensor and the output defaults to the scene filename.
+              The image is encoded and written in the background.
+          wait
+              Wait until all images have been written.
+          unload <id>
+              Release a scene.
+          quit
+              Wait for pending images and stop the server (as does the
+              end of the input).
+
+    --startup-profile
+        Print the time taken by every phase of the startup (static
+        initialization, argument parsing, JIT backend initialization,
+        scene loading including plugin libraries) and by rendering.
+        The JIT backends are initialized in the background, hence the
+        phases that first wait for them include part of their cost.
+
  === The following options are only relevant for JIT (CUDA/LLVM) modes ===
 
     -O [0-5]
@@ -81,6 +207,25 @@ Options:
         series of wavefronts. Specify twice to unroll both loops *and*
         virtual function calls.
 
+    -T, --tune
+        Time short calibration renders in megakernel and wavefront mode
+        (see -W) and with a few values of "samples_per_pass", and render
+        with the fastest configuration. The decision is stored in a cache
+        file next to the scene file (extension ".tuning") and reused by
+        later runs with the same variant, scene, and parameters.
+
+    -G <index1>,<index2>,.., --devices <index1>,<index2>,..
+        Render on several CUDA devices (or "all" of them) at once. The
+        scene is loaded on every device, the samples per pixel are split
+        between them, and their results are merged into a single image.
+
+    -H <variant>, --hybrid <variant>
+        Render the image using a second variant at the same time, e.g. an
+        LLVM variant on the host CPU next to a CUDA variant. Both variants
+        pull chunks of samples per pixel from a shared queue sized by their
+        measured throughput, and their results are merged into one image.
+        The two variants must use the same color representation.
+
     -V <width>
         Override the vector width of the LLVM backend ('width' must be
         a power of two). Values of 4/8/16 cause SSE/NEON, AVX, or AVX512
@@ -105,7 +250,9 @@ void scene_static_accel_shutdown() {
 }
 
 template <typename Float, typename Spectrum>
-void render(Object *scene_, size_t sensor_i, fs::path filename) {
+void render(Object *scene_, size_t sensor_i, fs::path filename,
+            float checkpoint_interval, bool resume, uint32_t partition_index,
+            uint32_t partition_count, const std::vector<std::string> &merge) {
     auto *scene = dynamic_cast<Scene<Float, Spectrum> *>(scene_);
     if (!scene)
         Throw("Root element of the input file must be a <scene> tag!");
@@ -119,11 +266,35 @@ void render(Object *scene_, size_t sensor_i, fs::path filename) {
     if (!integrator)
         Throw("No integrator specified for scene: %s", scene);
 
+    // Accumulate the partial results of a distributed render job
+    if (!merge.empty()) {
+        film->prepare(integrator->aov_names());
+        for (const std::string &part : merge) {
+            Log(Info, "Merging partial result \"%s\" ..", part);
+            ref<FileStream> fs = new FileStream(part);
+            film->read_storage(fs, true /* accumulate */);
+        }
+        film->write(filename);
+        return;
+    }
+
     /* critical section */ {
         std::lock_guard<std::mutex> guard(develop_callback_mutex);
         develop_callback = [&]() { film->write(filename); };
     }
 
+    std::string part_ext;
+    if (partition_count > 1) {
+        part_ext = tfm::format(".part%u", partition_index);
+        integrator->set_partition(partition_index, partition_count);
+    }
+
+    if (checkpoint_interval > 0.f || resume) {
+        fs::path checkpoint_path = filename;
+        checkpoint_path.replace_extension(part_ext + ".ckpt");
+        integrator->set_checkpoint(checkpoint_path, checkpoint_interval, resume);
+    }
+
     integrator->render(scene, (uint32_t) sensor_i,
                        0 /* seed */,
                        0 /* spp */,
@@ -135,9 +306,892 @@ void render(Object *scene_, size_t sensor_i, fs::path filename) {
         develop_callback = nullptr;
     }
 
+    if (partition_count > 1) {
+        // Store the raw film contents, which are merged later using --merge
+        fs::path part_path = filename;
+        part_path.replace_extension(part_ext);
+        ref<FileStream> fs = new FileStream(part_path, FileStream::ETruncReadWrite);
+        film->write_storage(fs);
+        Log(Info, "Wrote partial result to \"%s\".", part_path);
+    } else {
+        film->write(filename);
+    }
+}
+
+/**
+ * Applies parameter overrides of the --server mode and of parameter tracks
+ * (--tracks) without reloading the scene. This is the C++
+ * counterpart of <tt>mitsuba.traverse()</tt>: parameters are named in the same
+ * way (e.g. <tt>"bsdf.reflectance.value"</tt>) and, once all values have been
+ * written, the modified objects and their parents are notified via \ref
+ * Object::parameters_changed() from bottom to top.
+ */
+template <typename Float, typename Spectrum>
+class ParameterUpdate : public TraversalCallback {
+public:
+    MI_IMPORT_CORE_TYPES()
+
+    /// Parameters to be written, and whether a matching parameter was found
+    using Values = std::map<std::string, std::pair<std::string, bool>>;
+
+    struct State {
+        Values values;
+        std::set<std::string> prefixes;
+        std::set<Object *> visited;
+        /// Modified objects, keyed by their depth, and the names of their changed keys
+        std::map<std::pair<uint32_t, Object *>, std::vector<std::string>> dirty;
+    };
+
+    ParameterUpdate(State &state, Object *node, ParameterUpdate *parent = nullptr,
+                    const std::string &name = "")
+        : m_state(state), m_node(node), m_parent(parent),
+          m_depth(parent ? parent->m_depth + 1 : 0) {
+        if (!name.empty()) {
+            m_name = name;
+            for (int ctr = 1; m_state.prefixes.count(m_name) > 0; ++ctr)
+                m_name = tfm::format("%s_%i", name, ctr);
+            m_state.prefixes.insert(m_name);
+        }
+        m_state.visited.insert(node);
+    }
+
+    /// Write \c values into the parameters of \c node and notify the modified objects
+    static void apply(Object *node, Values &values) {
+        State state;
+        state.values = std::move(values);
+        ParameterUpdate root(state, node);
+        node->traverse(&root);
+
+        for (auto &[key, value] : state.values)
+            if (!value.second)
+                Throw("Unknown scene parameter \"%s\"!", key);
+
+        for (auto it = state.dirty.rbegin(); it != state.dirty.rend(); ++it)
+            it->first.second->parameters_changed(it->second);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::eval();
+    }
+
+    void put_object(const std::string &name, Object *obj, uint32_t) override {
+        if (!obj || m_state.visited.count(obj) > 0)
+            return;
+        ParameterUpdate child(m_state, obj, this,
+                              m_name.empty() ? name : m_name + "." + name);
+        obj->traverse(&child);
+    }
+
+protected:
+    void put_parameter_impl(const std::string &name, void *ptr, uint32_t,
+                            const std::type_info &type) override {
+        std::string key = m_name.empty() ? name : m_name + "." + name;
+        auto it = m_state.values.find(key);
+        if (it == m_state.values.end())
+            return;
+
+        std::vector<double> v;
+        for (const std::string &token : string::tokenize(it->second.first, ","))
+            v.push_back(std::stod(token));
+        if (!assign(ptr, type, v))
+            Throw("Cannot set scene parameter \"%s\" to \"%s\" (unsupported "
+                  "type or wrong number of components)!", key, it->second.first);
+        it->second.second = true;
+
+        // Mark this object and all its parents as dirty
+        for (ParameterUpdate *cb = this; cb; cb = cb->m_parent) {
+            std::string local = key;
+            if (cb->m_parent) {
+                size_t sep = key.rfind('.');
+                local = key.substr(sep + 1);
+                key = key.substr(0, sep);
+            }
+            auto &keys = m_state.dirty[{ cb->m_depth, cb->m_node }];
+            if (std::find(keys.begin(), keys.end(), local) == keys.end())
+                keys.push_back(local);
+        }
+    }
+
+    /// Assign the components \c v to a parameter of type \c T
+    template <typename T>
+    static bool assign_as(void *ptr, const std::type_info &type,
+                          const std::vector<double> &v) {
+        if (type != typeid(T))
+            return false;
+        T &value = *(T *) ptr;
+        if constexpr (std::is_same_v<T, bool>) {
+            if (v.size() != 1)
+                return false;
+            value = v[0] != 0.0;
+        } else if constexpr (std::is_arithmetic_v<T> || dr::is_jit_v<T>) {
+            if (v.size() != 1)
+                return false;
+            value = T((dr::scalar_t<T>) v[0]);
+        } else {
+            if (v.size() != dr::size_v<T>)
+                return false;
+            for (size_t i = 0; i < dr::size_v<T>; ++i)
+                value[i] = (dr::scalar_t<T>) v[i];
+        }
+        return true;
+    }
+
+    /// Assign the components \c v to a parameter of a supported type
+    static bool assign(void *ptr, const std::type_info &type,
+                       const std::vector<double> &v) {
+        return assign_as<bool>(ptr, type, v) ||
+               assign_as<int>(ptr, type, v) ||
+               assign_as<uint32_t>(ptr, type, v) ||
+               assign_as<ScalarFloat>(ptr, type, v) ||
+               assign_as<Float>(ptr, type, v) ||
+               assign_as<ScalarColor3f>(ptr, type, v) ||
+               assign_as<Color3f>(ptr, type, v) ||
+               assign_as<ScalarPoint3f>(ptr, type, v) ||
+               assign_as<Point3f>(ptr, type, v) ||
+               assign_as<ScalarVector3f>(ptr, type, v) ||
+               assign_as<Vector3f>(ptr, type, v) ||
+               assign_as<ScalarPoint2f>(ptr, type, v) ||
+               assign_as<Point2f>(ptr, type, v);
+    }
+
+private:
+    State &m_state;
+    Object *m_node;
+    ParameterUpdate *m_parent;
+    uint32_t m_depth;
+    std::string m_name;
+};
+
+/**
+ * Keyframed scene parameters of an animated sequence (--tracks). Every line
+ * of the file starts with a frame index followed by <tt>key=value</tt> pairs,
+ * where keys are named as by <tt>mitsuba.traverse()</tt> and values are
+ * comma-separated lists of numbers. The values of each parameter are linearly
+ * interpolated between its keyframes and held constant outside of them.
+ */
+struct ParameterTracks {
+    using Keyframe = std::pair<uint32_t, std::vector<double>>;
+
+    ParameterTracks(const fs::path &path) {
+        std::ifstream is(path.string());
+        if (!is.good())
+            Throw("--tracks: could not open \"%s\"!", path);
+
+        std::string line;
+        for (size_t line_i = 1; std::getline(is, line); ++line_i) {
+            auto tokens = string::tokenize(line, " \t\r");
+            if (tokens.empty() || tokens[0][0] == '#')
+                continue;
+            try {
+                uint32_t frame = (uint32_t) std::stoul(tokens[0]);
+                for (size_t i = 1; i < tokens.size(); ++i) {
+                    auto sep = tokens[i].find('=');
+                    if (sep == std::string::npos || sep == 0)
+                        Throw("expected a key=value pair, got \"%s\"", tokens[i]);
+                    std::vector<double> value;
+                    for (const std::string &v : string::tokenize(tokens[i].substr(sep + 1), ","))
+                        value.push_back(std::stod(v));
+                    auto &track = tracks[tokens[i].substr(0, sep)];
+                    if (!track.empty() && (track.back().first >= frame ||
+                                           track.back().second.size() != value.size()))
+                        Throw("the keyframes of \"%s\" must have increasing frame "
+                              "indices and the same number of components",
+                              tokens[i].substr(0, sep));
+                    track.emplace_back(frame, std::move(value));
+                }
+                frame_count = std::max(frame_count, frame + 1);
+            } catch (const std::exception &e) {
+                Throw("--tracks: error in line %zu of \"%s\": %s", line_i, path,
+                      e.what());
+            }
+        }
+    }
+
+    /// Return the interpolated value of every parameter at a given frame
+    std::map<std::string, std::string> values(uint32_t frame) const {
+        std::map<std::string, std::string> result;
+        for (auto &[key, track] : tracks) {
+            auto it = std::upper_bound(
+                track.begin(), track.end(), frame,
+                [](uint32_t f, const Keyframe &k) { return f < k.first; });
+
+            std::vector<double> value;
+            if (it == track.begin()) {
+                value = track.front().second;
+            } else if (it == track.end()) {
+                value = track.back().second;
+            } else {
+                const Keyframe &k0 = *(it - 1), &k1 = *it;
+                double t = double(frame - k0.first) / double(k1.first - k0.first);
+                for (size_t i = 0; i < k0.second.size(); ++i)
+                    value.push_back((1.0 - t) * k0.second[i] + t * k1.second[i]);
+            }
+
+            std::string str;
+            for (size_t i = 0; i < value.size(); ++i)
+                str += (i > 0 ? "," : "") + tfm::format("%.9g", value[i]);
+            result[key] = str;
+        }
+        return result;
+    }
+
+    std::map<std::string, std::vector<Keyframe>> tracks;
+    /// Number of frames spanned by the keyframes
+    uint32_t frame_count = 0;
+};
+
+/**
+ * Render an animated sequence. Frame \c i opens the shutter of the sensor at
+ * the time <tt>i / frames</tt> and uses \c i as seed, so that the noise of
+ * consecutive frames is decorrelated. Parameter \c tracks (if any) are
+ * applied to the loaded scene before every frame, hence the scene is never
+ * reloaded and the compiled kernels are reused across frames.
+ */
+template <typename Float, typename Spectrum>
+void render_sequence(Object *scene_, size_t sensor_i, fs::path filename,
+                     uint32_t frames, const ParameterTracks *tracks) {
+    using ScalarFloat = dr::scalar_t<Float>;
+
+    auto *scene = dynamic_cast<Scene<Float, Spectrum> *>(scene_);
+    if (!scene)
+        Throw("Root element of the input file must be a <scene> tag!");
+    if (scene->sensors().empty())
+        Throw("No sensor specified for scene: %s", scene);
+    if (sensor_i >= scene->sensors().size())
+        Throw("Specified sensor index is out of bounds!");
+    auto sensor = scene->sensors()[sensor_i];
+    auto film = sensor->film();
+
+    auto integrator = scene->integrator();
+    if (!integrator)
+        Throw("No integrator specified for scene: %s", scene);
+
+    std::string name = filename.filename().string(),
+                ext  = filename.extension().string();
+    name = name.substr(0, name.size() - ext.size());
+
+    // Values of the parameter tracks in the previous frame
+    std::map<std::string, std::string> current;
+
+    for (uint32_t i = 0; i < frames; ++i) {
+        fs::path frame_path =
+            filename.parent_path() / tfm::format("%s_%04u%s", name, i, ext);
+
+        /* critical section */ {
+            std::lock_guard<std::mutex> guard(develop_callback_mutex);
+            develop_callback = [&]() { film->write(frame_path); };
+        }
+
+        // Only update the parameters whose value changed since the last frame
+        if (tracks) {
+            typename ParameterUpdate<Float, Spectrum>::Values values;
+            for (auto &[key, value] : tracks->values(i)) {
+                auto it = current.find(key);
+                if (it == current.end() || it->second != value) {
+                    values[key] = { value, false };
+                    current[key] = value;
+                }
+            }
+            if (!values.empty())
+                ParameterUpdate<Float, Spectrum>::apply(scene, values);
+        }
+
+        Log(Info, "Rendering frame %u/%u ..", i + 1, frames);
+        sensor->set_shutter_open((ScalarFloat) i / (ScalarFloat) frames);
+        integrator->render(scene, (uint32_t) sensor_i,
+                           i /* seed */,
+                           0 /* spp */,
+                           false /* develop */,
+                           true /* evaluate */);
+
+        // Encode the frame in the background while the next one is rendered
+        film->write_async(frame_path);
+    }
+
+    /* critical section */ {
+        std::lock_guard<std::mutex> guard(develop_callback_mutex);
+        develop_callback = nullptr;
+    }
+}
+
+/// JIT compilation mode and integrator settings chosen by --tune
+struct TuningConfig {
+    /// 0: megakernel, 1: wavefront loops, 2: wavefront loops and virtual calls
+    uint32_t mode = 0;
+    /// Samples per pass of a sampling integrator ((uint32_t) -1: single pass)
+    uint32_t samples_per_pass = (uint32_t) -1;
+
+    std::string to_string() const {
+        const char *modes[] = { "megakernel", "wavefront",
+                                "wavefront (loops and virtual calls)" };
+        std::string spp = samples_per_pass == (uint32_t) -1
+                              ? std::string("all")
+                              : std::to_string(samples_per_pass);
+        return tfm::format("%s, samples_per_pass=%s", modes[mode], spp);
+    }
+};
+
+/**
+ * Per-scene cache of the --tune decisions. Every line of the file contains
+ * the variant, a hash of the scene description and parameters, the chosen
+ * mode and samples per pass, and the measured calibration time (in ms).
+ */
+struct TuningCache {
+    TuningCache(const fs::path &path) : path(path) {
+        std::ifstream is(path.string());
+        std::string line;
+        while (std::getline(is, line))
+            if (!line.empty())
+                lines.push_back(line);
+    }
+
+    bool lookup(const std::string &variant, const std::string &key,
+                TuningConfig &config) const {
+        for (const std::string &line : lines) {
+            auto tokens = string::tokenize(line, " ");
+            if (tokens.size() < 4 || tokens[0] != variant || tokens[1] != key)
+                continue;
+            config.mode = (uint32_t) std::stoul(tokens[2]);
+            config.samples_per_pass = (uint32_t) std::stoul(tokens[3]);
+            return config.mode < 3;
+        }
+        return false;
+    }
+
+    void store(const std::string &variant, const std::string &key,
+               const TuningConfig &config, double ms) {
+        std::string prefix = variant + " " + key + " ";
+        lines.erase(std::remove_if(lines.begin(), lines.end(),
+                                   [&](const std::string &line) {
+                                       return string::starts_with(line, prefix);
+                                   }),
+                    lines.end());
+        lines.push_back(tfm::format("%s%u %u %.3f", prefix, config.mode,
+                                    config.samples_per_pass, ms));
+
+        std::ofstream os(path.string(), std::ios::trunc);
+        for (const std::string &line : lines)
+            os << line << std::endl;
+        if (!os.good())
+            Log(Warn, "--tune: could not write the tuning cache \"%s\"!", path);
+    }
+
+    fs::path path;
+    std::vector<std::string> lines;
+};
+
+/// Hash of a scene file and of the parameters that affect its rendering (FNV-1a)
+static std::string tuning_key(const fs::path &scene_file,
+                              const xml::ParameterList &params,
+                              size_t sensor_i) {
+    std::ifstream is(scene_file.string(), std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(is)),
+                     std::istreambuf_iterator<char>());
+    for (const auto &param : params)
+        data += "\n" + std::get<0>(param) + "=" + std::get<1>(param);
+    data += "\n" + std::to_string(sensor_i);
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : data)
+        hash = (hash ^ (uint8_t) c) * 0x100000001b3ull;
+    return tfm::format("%016llx", (unsigned long long) hash);
+}
+
+/**
+ * Choose the fastest JIT compilation mode (megakernel or wavefront) and number
+ * of samples per pass for a scene, and apply it. The configurations are timed
+ * with short calibration renders: each mode is first warmed up (so that kernel
+ * compilation is not measured), and then rendered once per candidate value of
+ * \c samples_per_pass. The decision is stored in \c cache.
+ */
+template <typename Float, typename Spectrum>
+void tune(Object *scene_, size_t sensor_i, TuningCache &cache,
+          const std::string &key) {
+    auto *scene = dynamic_cast<Scene<Float, Spectrum> *>(scene_);
+    if (!scene)
+        Throw("Root element of the input file must be a <scene> tag!");
+    if (sensor_i >= scene->sensors().size())
+        Throw("Specified sensor index is out of bounds!");
+    auto integrator = scene->integrator();
+    if (!integrator)
+        Throw("No integrator specified for scene: %s", scene);
+
+    if constexpr (!dr::is_jit_v<Float>) {
+        DRJIT_MARK_USED(cache); DRJIT_MARK_USED(key);
+        Throw("-T/--tune: tuning requires a JIT (LLVM/CUDA) variant!");
+    } else {
+#if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
+        using SamplingIntegrator = SamplingIntegrator<Float, Spectrum>;
+        std::string variant = detail::get_variant<Float, Spectrum>();
+        auto *sampling = dynamic_cast<SamplingIntegrator *>(integrator.get());
+
+        auto apply = [&](const TuningConfig &config) {
+            jit_set_flag(JitFlag::LoopRecord, config.mode == 0);
+            jit_set_flag(JitFlag::VCallRecord, config.mode < 2);
+            if (sampling)
+                sampling->set_samples_per_pass(config.samples_per_pass);
+        };
+
+        TuningConfig best;
+        if (cache.lookup(variant, key, best)) {
+            Log(Info, "Using the cached tuning decision: %s.", best.to_string());
+            apply(best);
+            return;
+        }
+
+        auto sampler = scene->sensors()[sensor_i]->sampler();
+        uint32_t spp = sampler->sample_count(),
+                 spp_per_pass = sampling ? sampling->samples_per_pass()
+                                         : (uint32_t) -1;
+
+        /* Calibrate with the largest divisor of 'spp' up to 8 samples, and
+           compare rendering them at once to smaller passes */
+        uint32_t calib_spp = std::min(spp, 8u);
+        while (spp % calib_spp != 0)
+            calib_spp--;
+        std::vector<uint32_t> candidates = { (uint32_t) -1 };
+        if (sampling)
+            for (uint32_t value : { 1u, 2u, 4u })
+                if (value < calib_spp && calib_spp % value == 0)
+                    candidates.push_back(value);
+
+        Log(Info, "Tuning the rendering configuration with %u sample%s per "
+                  "pixel ..", calib_spp, calib_spp == 1 ? "" : "s");
+
+        double best_ms = std::numeric_limits<double>::infinity();
+        std::ostringstream report;
+        for (uint32_t mode = 0; mode < 3; ++mode) {
+            for (size_t i = 0; i <= candidates.size(); ++i) {
+                // The first render of every mode only compiles the kernels
+                TuningConfig config { mode, candidates[i == 0 ? 0 : i - 1] };
+                apply(config);
+
+                Timer timer;
+                integrator->render(scene, (uint32_t) sensor_i, 0 /* seed */,
+                                   calib_spp, false /* develop */,
+                                   true /* evaluate */);
+                dr::sync_thread();
+                double ms = (double) timer.value();
+                if (i == 0)
+                    continue;
+
+                report << "  - " << config.to_string() << ": "
+                       << util::time_string((float) ms, true) << std::endl;
+                if (ms < best_ms) {
+                    best_ms = ms;
+                    best = config;
+                }
+            }
+        }
+
+        Log(Info, "Tuning report:\n%s  => %s", report.str(), best.to_string());
+
+        // Undo the changes to the sampler made by the calibration renders
+        sampler->set_sample_count(spp);
+        if (sampling)
+            sampling->set_samples_per_pass(spp_per_pass);
+
+        if (best.samples_per_pass != (uint32_t) -1 && spp % best.samples_per_pass != 0)
+            best.samples_per_pass = (uint32_t) -1;
+        apply(best);
+        cache.store(variant, key, best, best_ms);
+#endif
+    }
+}
+
+/// Load a scene file for a given variant and check that it can be rendered
+template <typename Float, typename Spectrum>
+ref<Scene<Float, Spectrum>> load_scene(const fs::path &scene_file,
+                                       const std::string &mode,
+                                       const xml::ParameterList &params,
+                                       size_t sensor_i) {
+    std::vector<ref<Object>> parsed =
+        xml::load_file(scene_file, mode, params, false, false);
+    if (parsed.size() != 1)
+        Throw("Root element of the input file is expanded into "
+              "multiple objects, only a single object is expected!");
+    ref<Scene<Float, Spectrum>> scene =
+        dynamic_cast<Scene<Float, Spectrum> *>(parsed[0].get());
+    if (!scene)
+        Throw("Root element of the input file must be a <scene> tag!");
+    if (sensor_i >= scene->sensors().size())
+        Throw("Specified sensor index is out of bounds!");
+    if (!scene->integrator())
+        Throw("No integrator specified for scene: %s", scene);
+    return scene;
+}
+
+/**
+ * Render a scene file on several CUDA devices at once. Every device loads its
+ * own copy of the scene and renders a share of the samples per pixel with a
+ * different seed. The film contents are then merged on the first device.
+ */
+template <typename Float, typename Spectrum>
+void render_devices(const fs::path &scene_file, const std::string &mode,
+                    const xml::ParameterList &params,
+                    const std::vector<int> &devices, size_t sensor_i,
+                    fs::path filename) {
+    if constexpr (!dr::is_cuda_v<Float>) {
+        DRJIT_MARK_USED(scene_file); DRJIT_MARK_USED(mode);
+        DRJIT_MARK_USED(params); DRJIT_MARK_USED(devices);
+        DRJIT_MARK_USED(sensor_i); DRJIT_MARK_USED(filename);
+        Throw("-G/--devices: multi-device rendering requires a CUDA variant!");
+    } else {
+        using Scene = Scene<Float, Spectrum>;
+        uint32_t device_count = (uint32_t) devices.size();
+
+        /* Render a share of the samples on each device, the first one being
+           handled by the calling thread */
+        std::vector<ref<Scene>> scenes(device_count);
+        std::vector<ref<MemoryStream>> parts(device_count);
+        std::vector<std::exception_ptr> errors(device_count);
+        uint32_t spp = 0;
+
+        auto render_device = [&](uint32_t i) {
+            try {
+                jit_cuda_set_device(devices[i]);
+                scenes[i] = load_scene<Float, Spectrum>(scene_file, mode,
+                                                        params, sensor_i);
+                auto sensor = scenes[i]->sensors()[sensor_i];
+                uint32_t total = sensor->sampler()->sample_count(),
+                         share = total / device_count +
+                                 (i < total % device_count ? 1 : 0);
+                if (i == 0)
+                    spp = total;
+                if (share == 0)
+                    return;
+
+                Log(Info, "Rendering %u sample%s per pixel on CUDA device %i ..",
+                    share, share == 1 ? "" : "s", devices[i]);
+                scenes[i]->integrator()->render(scenes[i], (uint32_t) sensor_i,
+                                                i /* seed */, share,
+                                                false /* develop */,
+                                                true /* evaluate */);
+                if (i > 0) {
+                    parts[i] = new MemoryStream();
+                    sensor->film()->write_storage(parts[i]);
+                    parts[i]->seek(0);
+                }
+                dr::sync_thread();
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        };
+
+        ThreadEnvironment env;
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < device_count; ++i)
+            threads.emplace_back([&, i]() {
+                ScopedSetThreadEnvironment set_env(env);
+                render_device(i);
+            });
+        render_device(0);
+        for (std::thread &t : threads)
+            t.join();
+        for (std::exception_ptr &e : errors)
+            if (e)
+                std::rethrow_exception(e);
+
+        // Merge the results of the other devices into the film of the first one
+        jit_cuda_set_device(devices[0]);
+        auto film = scenes[0]->sensors()[sensor_i]->film();
+        if (spp == 0)
+            film->prepare(scenes[0]->integrator()->aov_names());
+        for (uint32_t i = 1; i < device_count; ++i)
+            if (parts[i])
+                film->read_storage(parts[i], true /* accumulate */);
+        film->write(filename);
+    }
+}
+
+/**
+ * Shared work queue of a hybrid render job, which hands out chunks of samples
+ * per pixel to the participating variants.
+ *
+ * A worker that has not reported its throughput yet receives a single sample
+ * per pixel. Afterwards, every request is granted half of the worker's share
+ * of the remaining samples, where the share is proportional to its measured
+ * throughput. The chunks thus shrink towards the end of the render job, so
+ * that all workers finish at roughly the same time.
+ */
+struct HybridQueue {
+    HybridQueue(uint32_t spp, size_t workers)
+        : remaining(spp), throughput(workers, 0.0) { }
+
+    /// Fetch the next chunk for a worker. Returns (seed, spp), spp = 0 when done
+    std::pair<uint32_t, uint32_t> next(size_t worker) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (remaining == 0)
+            return { 0, 0 };
+
+        uint32_t chunk = 1;
+        if (throughput[worker] > 0.0) {
+            double total = 0.0;
+            for (double t : throughput)
+                total += t;
+            chunk = (uint32_t) std::ceil(0.5 * remaining * throughput[worker] / total);
+        }
+
+        chunk = std::min(std::max(chunk, 1u), remaining);
+        remaining -= chunk;
+        return { chunk_index++, chunk };
+    }
+
+    /// Report the time (in seconds) taken to render a chunk
+    void report(size_t worker, uint32_t spp, double seconds) {
+        std::lock_guard<std::mutex> guard(mutex);
+        throughput[worker] = spp / std::max(seconds, 1e-6);
+    }
+
+    std::mutex mutex;
+    uint32_t remaining, chunk_index = 0;
+    std::vector<double> throughput;
+};
+
+/**
+ * Render chunks of samples fetched from a hybrid work queue, until all samples
+ * have been handed out. The accumulated (undeveloped) film contents of this
+ * worker are returned in \c result.
+ */
+template <typename Float, typename Spectrum>
+void render_chunks(Scene<Float, Spectrum> *scene, size_t sensor_i,
+                   HybridQueue &queue, size_t worker,
+                   ref<MemoryStream> &result) {
+    auto film = scene->sensors()[sensor_i]->film();
+    uint32_t spp_total = 0;
+
+    while (true) {
+        auto [seed, spp] = queue.next(worker);
+        if (spp == 0)
+            break;
+
+        Timer timer;
+        scene->integrator()->render(scene, (uint32_t) sensor_i, seed, spp,
+                                    false /* develop */, true /* evaluate */);
+
+        // Add the chunks previously rendered by this worker
+        if (result) {
+            result->seek(0);
+            film->read_storage(result, true /* accumulate */);
+        }
+
+        ref<MemoryStream> stream = new MemoryStream();
+        film->write_storage(stream);
+        stream->seek(0);
+        result = stream;
+
+        queue.report(worker, spp, timer.value() / 1000.0);
+        spp_total += spp;
+    }
+
+    Log(Info, "%s variant rendered %u sample%s per pixel.",
+        detail::get_variant<Float, Spectrum>(), spp_total,
+        spp_total == 1 ? "" : "s");
+}
+
+/// Entry point of the secondary variant of a hybrid render job
+template <typename Float, typename Spectrum>
+void render_hybrid_secondary(const fs::path &scene_file,
+                             const std::string &mode,
+                             const xml::ParameterList &params,
+                             size_t sensor_i, HybridQueue &queue,
+                             ref<MemoryStream> &result) {
+    ref<Scene<Float, Spectrum>> scene =
+        load_scene<Float, Spectrum>(scene_file, mode, params, sensor_i);
+    render_chunks<Float, Spectrum>(scene, sensor_i, queue, 1, result);
+    dr::sync_thread();
+}
+
+/**
+ * Render a scene file using two variants at the same time (e.g. a CUDA variant
+ * and an LLVM variant running on the host CPU). Both variants load their own
+ * copy of the scene and fetch chunks of samples from a shared work queue sized
+ * according to their measured throughput. The film contents of the secondary
+ * variant are then merged into the film of the primary variant.
+ */
+template <typename Float, typename Spectrum>
+void render_hybrid(const fs::path &scene_file, const std::string &mode,
+                   const std::string &secondary_mode,
+                   const xml::ParameterList &params, size_t sensor_i,
+                   fs::path filename) {
+    ref<Scene<Float, Spectrum>> scene =
+        load_scene<Float, Spectrum>(scene_file, mode, params, sensor_i);
+    auto film = scene->sensors()[sensor_i]->film();
+    uint32_t spp = scene->sensors()[sensor_i]->sampler()->sample_count();
+    HybridQueue queue(spp, 2);
+
+    ref<MemoryStream> primary, secondary;
+    std::exception_ptr error;
+    ThreadEnvironment env;
+    std::thread thread([&]() {
+        ScopedSetThreadEnvironment set_env(env);
+        try {
+            MI_INVOKE_VARIANT(secondary_mode, render_hybrid_secondary,
+                              scene_file, secondary_mode, params, sensor_i,
+                              queue, secondary);
+        } catch (...) {
+            error = std::current_exception();
+        }
+    });
+
+    try {
+        render_chunks<Float, Spectrum>(scene, sensor_i, queue, 0, primary);
+    } catch (...) {
+        // Drain the queue so that the secondary variant stops early
+        /* locked */ {
+            std::lock_guard<std::mutex> guard(queue.mutex);
+            queue.remaining = 0;
+        }
+        thread.join();
+        throw;
+    }
+    thread.join();
+    if (error)
+        std::rethrow_exception(error);
+
+    if (!primary)
+        film->prepare(scene->integrator()->aov_names());
+    if (secondary)
+        film->read_storage(secondary, true /* accumulate */);
     film->write(filename);
 }
 
+/**
+ * Keep scenes resident and render them on request (--server). Commands are
+ * read line by line from standard input, and every command is answered by a
+ * line on standard output that starts with "ok" or "error". Log messages are
+ * written to standard error (see main()). See \ref help() for the list of
+ * commands.
+ */
+template <typename Float, typename Spectrum>
+void serve(const std::string &mode, const xml::ParameterList &params) {
+    using Scene = Scene<Float, Spectrum>;
+    using Update = ParameterUpdate<Float, Spectrum>;
+
+    ref<Thread> thread = Thread::thread();
+    ref<FileResolver> fr = thread->file_resolver();
+    std::map<std::string, std::pair<ref<Scene>, fs::path>> scenes;
+
+    auto find = [&](const std::vector<std::string> &tokens) -> auto & {
+        if (tokens.size() < 2)
+            Throw("Expected a scene identifier!");
+        auto it = scenes.find(tokens[1]);
+        if (it == scenes.end())
+            Throw("Unknown scene \"%s\"!", tokens[1]);
+        return it->second;
+    };
+
+    auto split = [](const std::string &token) {
+        auto sep = token.find('=');
+        if (sep == std::string::npos || sep == 0)
+            Throw("Expected a key=value pair, got \"%s\"!", token);
+        return std::make_pair(token.substr(0, sep), token.substr(sep + 1));
+    };
+
+    std::cout << "ok ready" << std::endl;
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::vector<std::string> tokens = string::tokenize(line, " \t\r");
+        if (tokens.empty() || tokens[0][0] == '#')
+            continue;
+        const std::string &command = tokens[0];
+
+        try {
+            Timer timer;
+            if (command == "quit") {
+                Thread::wait_for_tasks();
+                std::cout << "ok" << std::endl;
+                break;
+            } else if (command == "load") {
+                if (tokens.size() < 3)
+                    Throw("Usage: load <id> <scene file> [name=value ..]");
+                xml::ParameterList scene_params = params;
+                for (size_t i = 3; i < tokens.size(); ++i) {
+                    auto [key, value] = split(tokens[i]);
+                    scene_params.emplace_back(key, value, false);
+                }
+
+                fs::path scene_file(tokens[2]);
+                ref<FileResolver> fr2 = new FileResolver(*fr);
+                fs::path scene_dir = scene_file.parent_path();
+                if (!fr2->contains(scene_dir))
+                    fr2->append(scene_dir);
+                thread->set_file_resolver(fr2);
+
+                ref<Scene> scene =
+                    load_scene<Float, Spectrum>(scene_file, mode, scene_params, 0);
+                scenes[tokens[1]] = { scene, scene_file };
+                std::cout << "ok " << util::time_string((float) timer.value(), true)
+                          << std::endl;
+            } else if (command == "unload") {
+                find(tokens);
+                scenes.erase(tokens[1]);
+                std::cout << "ok" << std::endl;
+            } else if (command == "update" || command == "render") {
+                auto &[scene, scene_file] = find(tokens);
+                size_t sensor_i = 0;
+                uint32_t spp = 0, seed = 0;
+                fs::path filename = scene_file;
+                typename Update::Values values;
+
+                for (size_t i = 2; i < tokens.size(); ++i) {
+                    auto [key, value] = split(tokens[i]);
+                    if (command == "render" && key == "sensor")
+                        sensor_i = (size_t) std::stoul(value);
+                    else if (command == "render" && key == "spp")
+                        spp = (uint32_t) std::stoul(value);
+                    else if (command == "render" && key == "seed")
+                        seed = (uint32_t) std::stoul(value);
+                    else if (command == "render" && key == "output")
+                        filename = value;
+                    else
+                        values[key] = { value, false };
+                }
+
+                if (!values.empty())
+                    Update::apply(scene, values);
+
+                if (command == "update") {
+                    std::cout << "ok " << util::time_string((float) timer.value(), true)
+                              << std::endl;
+                    continue;
+                }
+
+                if (sensor_i >= scene->sensors().size())
+                    Throw("Specified sensor index is out of bounds!");
+                auto film = scene->sensors()[sensor_i]->film();
+
+                /* critical section */ {
+                    std::lock_guard<std::mutex> guard(develop_callback_mutex);
+                    develop_callback = [&]() { film->write(filename); };
+                }
+
+                scene->integrator()->render(scene, (uint32_t) sensor_i, seed,
+                                            spp, false /* develop */,
+                                            true /* evaluate */);
+
+                /* critical section */ {
+                    std::lock_guard<std::mutex> guard(develop_callback_mutex);
+                    develop_callback = nullptr;
+                }
+
+                film->write_async(filename);
+                std::cout << "ok " << util::time_string((float) timer.value(), true)
+                          << std::endl;
+            } else if (command == "wait") {
+                Thread::wait_for_tasks();
+                std::cout << "ok " << util::time_string((float) timer.value(), true)
+                          << std::endl;
+            } else {
+                Throw("Unknown command \"%s\"!", command);
+            }
+        } catch (const std::exception &e) {
+            std::string msg = e.what();
+            std::replace(msg.begin(), msg.end(), '\n', ' ');
+            std::cout << "error " << msg << std::endl;
+        }
+    }
+}
+
 #if !defined(_WIN32)
 // Handle the hang-up signal and write a partially rendered image to disk
 void hup_signal_handler(int signal) {
@@ -149,7 +1203,44 @@ void hup_signal_handler(int signal) {
 }
 #endif
 
+/// Durations of the phases of a run, which are printed with --startup-profile
+struct StartupProfile {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point start = Clock::now(), last = start;
+    std::vector<std::pair<std::string, float>> phases;
+
+    /// Record the time (in milliseconds) since the end of the previous phase
+    void phase(const std::string &name) {
+        Clock::time_point now = Clock::now();
+        phases.emplace_back(name, elapsed(last, now));
+        last = now;
+    }
+
+    void print(std::ostream &os) const {
+        float plugins = PluginManager::instance()->load_time();
+        size_t width = 0;
+        for (auto &[name, time] : phases)
+            width = std::max(width, name.length());
+
+        os << "Startup profile:" << std::endl;
+        for (auto &[name, time] : phases) {
+            os << "  " << name << std::string(width - name.length() + 2, ' ')
+               << util::time_string(time, true) << std::endl;
+        }
+        os << "  (" << util::time_string(plugins, true)
+           << " of this were spent loading plugin libraries, "
+           << util::time_string(elapsed(start, last), true)
+           << " in total)" << std::endl;
+    }
+
+    static float elapsed(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<float, std::milli>(to - from).count();
+    }
+};
+
 int main(int argc, char *argv[]) {
+    StartupProfile profile;
     Jit::static_initialization();
     Class::static_initialization();
     Thread::static_initialization();
@@ -158,6 +1249,7 @@ int main(int argc, char *argv[]) {
 
     // Ensure that the mitsuba-render shared library is loaded
     librender_nop();
+    profile.phase("static initialization");
 
     ArgParser parser;
     using StringVec    = std::vector<std::string>;
@@ -166,6 +1258,12 @@ int main(int argc, char *argv[]) {
     auto arg_define    = parser.add(StringVec{ "-D", "--define" }, true);
     auto arg_sensor_i  = parser.add(StringVec{ "-s", "--sensor" }, true);
     auto arg_output    = parser.add(StringVec{ "-o", "--output" }, true);
+    auto arg_ckpt      = parser.add(StringVec{ "-c", "--checkpoint" }, true);
+    auto arg_resume    = parser.add(StringVec{ "-r", "--resume" }, false);
+    auto arg_partition = parser.add(StringVec{ "-p", "--partition" }, true);
+    auto arg_merge     = parser.add(StringVec{ "-M", "--merge" }, true);
+    auto arg_frames    = parser.add(StringVec{ "-F", "--frames" }, true);
+    auto arg_tracks    = parser.add(StringVec{ "--tracks" }, true);
     auto arg_update    = parser.add(StringVec{ "-u", "--update" }, false);
     auto arg_help      = parser.add(StringVec{ "-h", "--help" });
     auto arg_mode      = parser.add(StringVec{ "-m", "--mode" }, true);
@@ -177,9 +1275,19 @@ int main(int argc, char *argv[]) {
     auto arg_wavefront = parser.add(StringVec{ "-W" });
     auto arg_source    = parser.add(StringVec{ "-S" });
     auto arg_vec_width = parser.add(StringVec{ "-V" }, true);
+    auto arg_devices   = parser.add(StringVec{ "-G", "--devices" }, true);
+    auto arg_hybrid    = parser.add(StringVec{ "-H", "--hybrid" }, true);
+    auto arg_tune      = parser.add(StringVec{ "-T", "--tune" });
+    auto arg_phases    = parser.add(StringVec{ "-P", "--profile" });
+    auto arg_trace     = parser.add(StringVec{ "--trace" }, true);
+    auto arg_load_rep  = parser.add(StringVec{ "--load-report" }, true);
+    auto arg_instrument = parser.add(StringVec{ "--instrument-kernels" });
+    auto arg_stats     = parser.add(StringVec{ "--stats" });
+    auto arg_profile   = parser.add(StringVec{ "--startup-profile" });
+    auto arg_server    = parser.add(StringVec{ "--server" });
 
     xml::ParameterList params;
-    std::string error_msg, mode;
+    std::string error_msg, mode, hybrid_mode;
 
 #if !defined(_WIN32)
     /* Initialize signal handlers */
@@ -216,6 +1324,13 @@ int main(int argc, char *argv[]) {
 
         logger->set_log_level(log_level_mitsuba[std::min(log_level, 2)]);
 
+        /* In server mode, standard output carries the replies to commands.
+           Log messages and progress bars are written to standard error. */
+        if (*arg_server) {
+            logger->clear_appenders();
+            logger->add_appender(new StreamAppender(&std::cerr));
+        }
+
 #if defined(MI_ENABLE_CUDA) || defined(MI_ENABLE_LLVM)
         ::LogLevel log_level_drjit[] = {
             ::LogLevel::Error,
@@ -252,18 +1367,48 @@ int main(int argc, char *argv[]) {
         bool cuda = string::starts_with(mode, "cuda_");
         bool llvm = string::starts_with(mode, "llvm_");
 
-#if defined(MI_ENABLE_CUDA)
-        if (cuda)
-            jit_init((uint32_t) JitBackend::CUDA);
-#endif
+        if (*arg_hybrid) {
+            hybrid_mode = arg_hybrid->as_string();
+
+            // Strip the backend and AD flag, e.g. "cuda_ad_rgb" -> "rgb"
+            auto color_mode = [](const std::string &variant) {
+                std::string result = variant.substr(variant.find('_') + 1);
+                if (string::starts_with(result, "ad_"))
+                    result = result.substr(3);
+                return result;
+            };
+
+            if (hybrid_mode == mode)
+                Throw("-H/--hybrid: the secondary variant must differ from "
+                      "the primary variant!");
+            if (color_mode(hybrid_mode) != color_mode(mode))
+                Throw("-H/--hybrid: variants \"%s\" and \"%s\" use different "
+                      "color representations!", mode, hybrid_mode);
+        }
+        bool hybrid_cuda = string::starts_with(hybrid_mode, "cuda_"),
+             hybrid_llvm = string::starts_with(hybrid_mode, "llvm_");
 
-#if defined(MI_ENABLE_LLVM)
-        if (llvm)
-            jit_init((uint32_t) JitBackend::LLVM);
+        profile.phase("argument parsing");
+
+#if defined(MI_ENABLE_CUDA) || defined(MI_ENABLE_LLVM)
+        /* Initialize the JIT backends in a background thread (mainly the
+           creation of a CUDA context). Any further call into the JIT waits
+           for it to finish, which overlaps it with the work in between. */
+        uint32_t backends = 0;
+#  if defined(MI_ENABLE_CUDA)
+        if (cuda || hybrid_cuda)
+            backends |= (uint32_t) JitBackend::CUDA;
+#  endif
+#  if defined(MI_ENABLE_LLVM)
+        if (llvm || hybrid_llvm)
+            backends |= (uint32_t) JitBackend::LLVM;
+#  endif
+        if (backends)
+            jit_init_async(backends);
 #endif
 
 #if defined(MI_ENABLE_LLVM) || defined(MI_ENABLE_CUDA)
-        if (cuda || llvm) {
+        if (cuda || llvm || hybrid_cuda || hybrid_llvm) {
             if (*arg_optim_lev) {
                 int lev = arg_optim_lev->as_int();
                 jit_set_flag(JitFlag::VCallDeduplicate, lev > 0);
@@ -282,7 +1427,7 @@ int main(int argc, char *argv[]) {
             if (*arg_source)
                 jit_set_flag(JitFlag::PrintIR, true);
 
-            if (*arg_vec_width && llvm) {
+            if (*arg_vec_width && (llvm || hybrid_llvm)) {
                 uint32_t width = arg_vec_width->as_int();
                 if (!math::is_power_of_two(width))
                     Throw("Value specified to the -V argument must be a power of two!");
@@ -301,16 +1446,110 @@ int main(int argc, char *argv[]) {
         DRJIT_MARK_USED(arg_source);
 #endif
 
-        if (!cuda && !llvm &&
-            (*arg_optim_lev || *arg_wavefront || *arg_source || *arg_vec_width))
+        if (!cuda && !llvm && !hybrid_cuda && !hybrid_llvm &&
+            (*arg_optim_lev || *arg_wavefront || *arg_source || *arg_vec_width ||
+             *arg_tune))
             Throw("Specified an argument that only makes sense in a JIT (LLVM/CUDA) mode!");
 
-        Profiler::static_initialization();
-        color_management_static_initialization(cuda, llvm);
+        if (*arg_tune && *arg_wavefront)
+            Throw("-T/--tune: cannot be combined with -W, since tuning chooses "
+                  "between megakernel and wavefront mode!");
 
+        /* The color space tables are initialized on demand, and the Embree
+           device and OptiX pipelines are created with the first scene */
+        Profiler::static_initialization();
+        if (*arg_phases) {
+            Profiler::set_phase_profiling(true);
+            Profiler::set_kernel_profiling(true);
+        }
+        if (*arg_trace)
+            Profiler::start_trace();
+        if (*arg_instrument)
+            Profiler::set_kernel_instrumentation(true);
+        if (*arg_load_rep)
+            xml::set_instantiation_report(arg_load_rep->as_string());
+        if (*arg_stats)
+            RenderStatistics::set_enabled(true);
         MI_INVOKE_VARIANT(mode, scene_static_accel_initialization);
+        if (!hybrid_mode.empty())
+            MI_INVOKE_VARIANT(hybrid_mode, scene_static_accel_initialization);
+        profile.phase("JIT backend initialization");
 
         size_t sensor_i  = (*arg_sensor_i ? arg_sensor_i->as_int() : 0);
+        float checkpoint_interval = (*arg_ckpt ? (float) arg_ckpt->as_float() : -1.f);
+        bool resume = (bool) *arg_resume;
+
+        uint32_t partition_index = 0, partition_count = 1;
+        if (*arg_partition) {
+            auto tokens = string::tokenize(arg_partition->as_string(), "/");
+            if (tokens.size() != 2)
+                Throw("-p/--partition: expect index/count pair!");
+            partition_index = (uint32_t) std::stoul(tokens[0]);
+            partition_count = (uint32_t) std::stoul(tokens[1]);
+            if (partition_count == 0 || partition_index >= partition_count)
+                Throw("-p/--partition: invalid partition %u/%u!",
+                      partition_index, partition_count);
+        }
+
+        std::vector<std::string> merge;
+        if (*arg_merge)
+            merge = string::tokenize(arg_merge->as_string(), ";");
+
+        std::vector<int> devices;
+        if (*arg_devices) {
+            if (!cuda)
+                Throw("-G/--devices: multi-device rendering requires a CUDA variant!");
+#if defined(MI_ENABLE_CUDA)
+            std::string value = arg_devices->as_string();
+            int available = jit_cuda_device_count();
+            if (value == "all") {
+                for (int i = 0; i < available; ++i)
+                    devices.push_back(i);
+            } else {
+                for (const std::string &token : string::tokenize(value, ","))
+                    devices.push_back(std::stoi(token));
+            }
+            for (int device : devices)
+                if (device < 0 || device >= available)
+                    Throw("-G/--devices: invalid CUDA device %i (%i available)!",
+                          device, available);
+            if (devices.size() > 1 &&
+                (partition_count > 1 || !merge.empty() || checkpoint_interval > 0.f || resume))
+                Throw("-G/--devices: cannot be combined with partitioned or "
+                      "checkpointed rendering!");
+            if (devices.size() == 1)
+                jit_cuda_set_device(devices[0]);
+#endif
+        }
+
+        if (!hybrid_mode.empty() &&
+            (devices.size() > 1 || partition_count > 1 || !merge.empty() ||
+             checkpoint_interval > 0.f || resume))
+            Throw("-H/--hybrid: cannot be combined with multi-device, "
+                  "partitioned or checkpointed rendering!");
+
+        if (*arg_tune && (devices.size() > 1 || !hybrid_mode.empty() || !merge.empty()))
+            Throw("-T/--tune: cannot be combined with multi-device or hybrid "
+                  "rendering, or with --merge!");
+
+        std::unique_ptr<ParameterTracks> tracks;
+        if (*arg_tracks)
+            tracks = std::make_unique<ParameterTracks>(arg_tracks->as_string());
+
+        uint32_t frames = tracks ? tracks->frame_count : 0;
+        if (*arg_frames || tracks) {
+            if (*arg_frames) {
+                int value = arg_frames->as_int();
+                if (value <= 0)
+                    Throw("-F/--frames: the number of frames must be positive!");
+                frames = (uint32_t) value;
+            }
+            if (devices.size() > 1 || !hybrid_mode.empty() ||
+                partition_count > 1 || !merge.empty() ||
+                checkpoint_interval > 0.f || resume)
+                Throw("-F/--frames: cannot be combined with multi-device, "
+                      "hybrid, partitioned or checkpointed rendering!");
+        }
 
         // Append the mitsuba directory to the FileResolver search path list
         ref<Thread> thread = Thread::thread();
@@ -328,7 +1567,7 @@ int main(int argc, char *argv[]) {
             }
         }
 
-        if (!*arg_extra || *arg_help) {
+        if ((!*arg_extra && !*arg_server) || *arg_help) {
             help((int) Thread::thread_count());
         } else {
             Log(Info, "%s", util::info_build((int) Thread::thread_count()));
@@ -340,6 +1579,18 @@ int main(int argc, char *argv[]) {
 #endif
         }
 
+        if (*arg_server && !*arg_help) {
+            if (*arg_extra)
+                Throw("--server: scene files are loaded with the \"load\" command!");
+            if (devices.size() > 1 || !hybrid_mode.empty() || partition_count > 1 ||
+                !merge.empty() || checkpoint_interval > 0.f || resume ||
+                frames > 0 || *arg_tune)
+                Throw("--server: cannot be combined with multi-device, hybrid, "
+                      "partitioned, checkpointed, animated or tuned rendering!");
+            MI_INVOKE_VARIANT(mode, serve, mode, params);
+            profile.phase("serving render jobs");
+        }
+
         while (arg_extra && *arg_extra) {
             fs::path filename(arg_extra->as_string());
             ref<FileResolver> fr2 = new FileResolver(*fr);
@@ -353,18 +1604,66 @@ int main(int argc, char *argv[]) {
             if (*arg_output)
                 filename = arg_output->as_string();
 
+            std::string scene_name = fs::path(arg_extra->as_string()).filename().string();
+
+            if (devices.size() > 1) {
+                MI_INVOKE_VARIANT(mode, render_devices, arg_extra->as_string(),
+                                  mode, params, devices, sensor_i, filename);
+                profile.phase("loading and rendering \"" + scene_name + "\"");
+                arg_extra = arg_extra->next();
+                continue;
+            }
+
+            if (!hybrid_mode.empty()) {
+                MI_INVOKE_VARIANT(mode, render_hybrid, arg_extra->as_string(),
+                                  mode, hybrid_mode, params, sensor_i, filename);
+                profile.phase("loading and rendering \"" + scene_name + "\"");
+                arg_extra = arg_extra->next();
+                continue;
+            }
+
             // Try and parse a scene from the passed file.
             std::vector<ref<Object>> parsed =
                 xml::load_file(arg_extra->as_string(), mode, params,
                                *arg_update, false);
+            profile.phase("loading \"" + scene_name + "\"");
 
             if (parsed.size() != 1)
                 Throw("Root element of the input file is expanded into "
                       "multiple objects, only a single object is expected!");
 
-            MI_INVOKE_VARIANT(mode, render, parsed[0].get(), sensor_i, filename);
+            if (*arg_tune) {
+                fs::path scene_file(arg_extra->as_string());
+                fs::path cache_path = scene_file;
+                cache_path.replace_extension(".tuning");
+                TuningCache cache(cache_path);
+                MI_INVOKE_VARIANT(mode, tune, parsed[0].get(), sensor_i, cache,
+                                  tuning_key(scene_file, params, sensor_i));
+                profile.phase("tuning \"" + scene_name + "\"");
+            }
+
+            if (frames > 0)
+                MI_INVOKE_VARIANT(mode, render_sequence, parsed[0].get(),
+                                  sensor_i, filename, frames, tracks.get());
+            else
+                MI_INVOKE_VARIANT(mode, render, parsed[0].get(), sensor_i, filename,
+                                  checkpoint_interval, resume, partition_index,
+                                  partition_count, merge);
+            profile.phase("rendering \"" + scene_name + "\"");
             arg_extra = arg_extra->next();
         }
+
+        // Wait for the images that are still written in the background
+        Thread::wait_for_tasks();
+        profile.phase("writing pending images");
+
+        if (*arg_trace) {
+            Profiler::stop_trace();
+            Profiler::write_trace(arg_trace->as_string());
+        }
+
+        if (*arg_profile)
+            profile.print(*arg_server ? std::cerr : std::cout);
     } catch (const std::exception &e) {
         error_msg = std::string("Caught a critical exception: ") + e.what();
     } catch (...) {
@@ -399,7 +1698,10 @@ int main(int argc, char *argv[]) {
     }
 
     MI_INVOKE_VARIANT(mode, scene_static_accel_shutdown);
+    if (!hybrid_mode.empty())
+        MI_INVOKE_VARIANT(hybrid_mode, scene_static_accel_shutdown);
     color_management_static_shutdown();
+    ResourceCache::static_shutdown();
     Profiler::static_shutdown();
     Bitmap::static_shutdown();
     StructConverter::static_shutdown();
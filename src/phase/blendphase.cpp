@@ -1,6 +1,8 @@
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/random.h>
 #include <mitsuba/render/phase.h>
 #include <mitsuba/render/volume.h>
+#include <atomic>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -21,6 +23,12 @@ Blended phase function (:monosp:`blendphase`)
      (Default: 0.5)
    - |exposed|, |differentiable|
 
+ * - stochastic
+   - |bool|
+   - Evaluate only one of the nested phase functions, chosen randomly according
+     to the blending weight, instead of both of them (see below).
+     (Default: false)
+
  * - (Nested plugin)
    - |phase|
    - Two nested phase function instances that should be mixed according to the
@@ -36,6 +44,15 @@ atmosphere).
 The association of nested Phase plugins with the two positions in the
 interpolation is based on the alphanumeric order of their identifiers.
 
+When :paramtype:`stochastic` is set, :monosp:`eval_pdf()` returns the value and
+the density of a single nested phase function, which is chosen with a
+probability equal to its blending weight (like :monosp:`sample()` does). This
+yields an unbiased estimate of the blend at the cost of one nested evaluation,
+as in the stochastic mode of the :ref:`blendbsdf <bsdf-blendbsdf>` plugin. The
+choice is a deterministic function of the position and of both directions, so
+that the value and the density of a direction always refer to the same nested
+phase function.
+
 .. tabs::
     .. code-tab:: xml
 
@@ -82,6 +99,8 @@ public:
         }
 
         m_weight = props.volume<Volume>("weight");
+        m_stochastic = props.get<bool>("stochastic", false);
+        m_seed = seed_counter++;
         if (phase_index != 2)
             Throw("BlendPhase: Two child phase functions must be specified!");
 
@@ -172,6 +191,26 @@ public:
              auto [val, pdf] = m_nested_phase[sample_first ? 0 : 1]->eval_pdf(ctx2, mi, wo, active);
 
              return { weight * val, weight * pdf };
+        } else if (m_stochastic) {
+            Mask m1 = active && select_second(mi, wo, weight),
+                 m0 = active && !m1;
+            Float weight_1 = dr::select(m1, weight, 1 - weight);
+
+            Spectrum val = dr::zeros<Spectrum>();
+            Float pdf = dr::zeros<Float>();
+            if (dr::any_or<true>(m0)) {
+                auto [val_0, pdf_0] = m_nested_phase[0]->eval_pdf(ctx, mi, wo, m0);
+                dr::masked(val, m0) = val_0;
+                dr::masked(pdf, m0) = pdf_0;
+            }
+            if (dr::any_or<true>(m1)) {
+                auto [val_1, pdf_1] = m_nested_phase[1]->eval_pdf(ctx, mi, wo, m1);
+                dr::masked(val, m1) = val_1;
+                dr::masked(pdf, m1) = pdf_1;
+            }
+
+            // Keep the derivative with respect to the blending weight
+            return { val * (weight_1 / dr::detach(weight_1)), pdf };
         } else {
             auto [val_0, pdf_0] = m_nested_phase[0]->eval_pdf(ctx, mi, wo, active);
             auto [val_1, pdf_1] = m_nested_phase[1]->eval_pdf(ctx, mi, wo, active);
@@ -183,10 +222,35 @@ public:
         }
     }
 
+    /**
+     * \brief Randomly choose the nested phase function that is evaluated in
+     * stochastic mode, returning \c true for the second one
+     *
+     * The random number is a hash of the position and of both directions,
+     * decorrelated from the choices of other blends by a per-instance seed.
+     */
+    Mask select_second(const MediumInteraction3f &mi, const Vector3f &wo,
+                       const Float &weight) const {
+        using Float32 = dr::float32_array_t<Float>;
+        auto bits = [](const Float &value) {
+            return dr::reinterpret_array<UInt32>(Float32(dr::detach(value)));
+        };
+
+        UInt32 hash = sample_tea_32(bits(mi.p.x()) ^ bits(wo.x()),
+                                    bits(mi.p.y()) ^ bits(wo.y())).first;
+        hash = sample_tea_32(hash ^ bits(mi.p.z()) ^ bits(wo.z()),
+                             bits(mi.wi.x()) ^ bits(mi.wi.y())).first;
+        Float sample = Float(
+            sample_tea_float32(hash ^ bits(mi.wi.z()), UInt32(m_seed)));
+
+        return sample < dr::detach(weight);
+    }
+
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "BlendPhase[" << std::endl
             << "  weight = " << string::indent(m_weight) << "," << std::endl
+            << "  stochastic = " << m_stochastic << "," << std::endl
             << "  nested_phase[0] = " << string::indent(m_nested_phase[0])
             << "," << std::endl
             << "  nested_phase[1] = " << string::indent(m_nested_phase[1])
@@ -199,6 +263,11 @@ public:
 protected:
     ref<Volume> m_weight;
     ref<Base> m_nested_phase[2];
+    bool m_stochastic;
+    uint32_t m_seed;
+
+    /// Seeds of the random choices of the instances in stochastic mode
+    static inline std::atomic<uint32_t> seed_counter { 0 };
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(BlendPhaseFunction, PhaseFunction)
@@ -33,6 +33,9 @@ function of the cosine of the scattering angle.
      scattering.
    * Lookup table points are regularly spaced between -1 and 1.
    * Phase function values are automatically normalized.
+   * Sampling looks up the interval of the inverse cumulative distribution in
+     a guide table over :math:`[0, 1]`, which reduces the search to the few
+     intervals of one guide cell, independently of the table size.
 */
 
 template <typename Float, typename Spectrum>
@@ -58,6 +61,7 @@ public:
 
             m_distr = ContinuousDistribution<Float>(ScalarVector2f(-1.f, 1.f),
                                                     data.data(), data.size());
+            build_guide();
         } else {
             Throw("'values' must be a string");
         }
@@ -72,6 +76,7 @@ public:
 
     void parameters_changed(const std::vector<std::string> & /*keys*/) override {
         m_distr.update();
+        build_guide();
     }
 
     std::tuple<Vector3f, Spectrum, Float> sample(const PhaseFunctionContext & /* ctx */,
@@ -83,7 +88,7 @@ public:
 
         // Sample a direction in physics convention.
         // We sample cos θ' = cos(π - θ) = -cos θ.
-        Float cos_theta_prime = m_distr.sample(sample2.x());
+        Float cos_theta_prime = sample_cos_theta(sample2.x(), active);
         Float sin_theta_prime =
             dr::safe_sqrt(1.f - cos_theta_prime * cos_theta_prime);
         auto [sin_phi, cos_phi] =
@@ -117,6 +122,69 @@ public:
         return { pdf, pdf };
     }
 
+    /**
+     * \brief Build the guide table of the inverse cumulative distribution
+     *
+     * Entry \c j of the table is the first interval whose cumulative
+     * distribution reaches <tt>j / n</tt>, where \c n is the number of
+     * intervals. A sample in <tt>[j / n, (j + 1) / n)</tt> therefore falls
+     * into one of the intervals between the entries \c j and <tt>j + 1</tt>.
+     */
+    void build_guide() {
+        using UInt32X = DynamicBuffer<UInt32>;
+        using FloatX  = DynamicBuffer<Float>;
+
+        uint32_t size = (uint32_t) m_distr.cdf().size();
+        UInt32X j = dr::arange<UInt32X>(size + 1);
+        FloatX target = FloatX(j) * (m_distr.integral() / (ScalarFloat) size);
+
+        m_guide = dr::binary_search<UInt32X>(
+            0, size - 1, [&](UInt32X index) DRJIT_INLINE_LAMBDA {
+                return dr::gather<FloatX>(m_distr.cdf(), index) < target;
+            });
+
+        // Number of bisection steps needed to search the widest guide cell
+        UInt32X span = dr::gather<UInt32X>(m_guide, dr::arange<UInt32X>(1, size + 1)) -
+                       dr::gather<UInt32X>(m_guide, dr::arange<UInt32X>(size));
+        uint32_t max_span = (uint32_t) dr::slice(dr::max(span));
+        m_guide_steps = 0;
+        while ((1u << m_guide_steps) <= max_span)
+            m_guide_steps++;
+    }
+
+    /// Sample the cosine of the scattering angle using the guide table
+    Float sample_cos_theta(Float sample, Mask active) const {
+        uint32_t size = (uint32_t) m_distr.cdf().size();
+
+        UInt32 j = dr::minimum(UInt32(sample * (ScalarFloat) size), size - 1);
+        UInt32 lo = dr::gather<UInt32>(m_guide, j, active),
+               hi = dr::gather<UInt32>(m_guide, j + 1u, active);
+
+        sample *= m_distr.integral();
+
+        // Find the first interval whose cumulative distribution reaches the sample
+        for (uint32_t i = 0; i < m_guide_steps; ++i) {
+            UInt32 mid = (lo + hi) >> 1;
+            Mask right = dr::gather<Float>(m_distr.cdf(), mid, active) < sample;
+            lo = dr::select(right, mid + 1u, lo);
+            hi = dr::select(right, hi, mid);
+        }
+
+        ScalarFloat w = 2.f / size;
+        Float x0 = dr::fmadd(Float(lo), w, -1.f),
+              y0 = dr::gather<Float>(m_distr.pdf(), lo, active),
+              y1 = dr::gather<Float>(m_distr.pdf(), lo + 1u, active),
+              c0 = dr::gather<Float>(m_distr.cdf(), lo - 1u, active && lo > 0);
+
+        sample = (sample - c0) / w;
+
+        Float t_linear = (y0 - dr::safe_sqrt(dr::square(y0) + 2.f * sample * (y1 - y0))) / (y0 - y1),
+              t_const  = sample / y0,
+              t        = dr::select(y0 == y1, t_const, t_linear);
+
+        return dr::clip(dr::fmadd(t, w, x0), -1.f, 1.f);
+    }
+
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "TabulatedPhaseFunction[" << std::endl
@@ -128,6 +196,9 @@ public:
     MI_DECLARE_CLASS()
 private:
     ContinuousDistribution<Float> m_distr;
+    /// Guide table of the inverse cumulative distribution (see \ref build_guide())
+    DynamicBuffer<UInt32> m_guide;
+    uint32_t m_guide_steps;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(TabulatedPhaseFunction, PhaseFunction)
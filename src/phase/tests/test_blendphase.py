@@ -178,3 +178,38 @@ def test05_sample_components(variant_scalar_rgb):
     expected_b = weight * dr.inv_four_pi * (1 - g) / (1 + g) ** 2
     wo_b, w_b, pdf_b = phase.sample(ctx, mei, 0.1, [0.0, 0.0])
     assert dr.allclose(pdf_b, expected_b)
+
+
+def test06_eval_stochastic(variants_vec_backends_once_rgb):
+    weight = 0.3
+    g = 0.6
+    desc = {
+        "type": "blendphase",
+        "phase1": {"type": "isotropic"},
+        "phase2": {"type": "hg", "g": g},
+        "weight": weight,
+    }
+    phase = mi.load_dict(desc)
+    stochastic = mi.load_dict(dict(desc, stochastic=True))
+
+    n = 100000
+    sampler = mi.load_dict({"type": "independent"})
+    sampler.seed(0, n)
+
+    mei = dr.zeros(mi.MediumInteraction3f, n)
+    mei.p = mi.warp.square_to_uniform_sphere(sampler.next_2d())
+    mei.wi = mi.warp.square_to_uniform_sphere(sampler.next_2d())
+    mei.sh_frame = mi.Frame3f(mei.wi)
+    wo = mi.warp.square_to_uniform_sphere(sampler.next_2d())
+    ctx = mi.PhaseFunctionContext()
+
+    value_0, pdf_0 = phase.eval_pdf(ctx, mei, wo)
+    value_1, pdf_1 = stochastic.eval_pdf(ctx, mei, wo)
+
+    # Each direction evaluates one of the nested phase functions ...
+    assert dr.allclose(value_1[0], pdf_1)
+    assert dr.any(dr.abs(value_1[0] - value_0[0]) > 1e-3)
+
+    # ... and the estimate matches the blend on average
+    assert dr.allclose(dr.mean(value_1[0]), dr.mean(value_0[0]), rtol=2e-2)
+    assert dr.allclose(dr.mean(pdf_1), dr.mean(pdf_0), rtol=2e-2)
@@ -109,6 +109,30 @@ def test_chi2(variants_vec_backends_once_rgb):
     assert result
 
 
+def test_chi2_peaked(variants_vec_backends_once_rgb):
+    # Large and strongly forward-scattering table: the guide cells of the
+    # sampling routine then cover very different numbers of intervals
+    import numpy as np
+
+    g = 0.8
+    cos_theta = np.linspace(-1, 1, 513)
+    values = (1 - g**2) / (1 + g**2 - 2 * g * cos_theta) ** 1.5
+    values_str = ", ".join([str(x) for x in values])
+
+    sample_func, pdf_func = mi.chi2.PhaseFunctionAdapter(
+        "tabphase", f"<string name='values' value='{values_str}'/>"
+    )
+
+    chi2 = mi.chi2.ChiSquareTest(
+        domain=mi.chi2.SphericalDomain(),
+        sample_func=sample_func,
+        pdf_func=pdf_func,
+        sample_dim=3,
+    )
+
+    assert chi2.run()
+
+
 def test_traverse(variant_scalar_rgb):
     # Phase function table definition
     import numpy as np
@@ -6,6 +6,7 @@
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/profiler.h>
+#include <mitsuba/core/resource.h>
 #include <mitsuba/python/python.h>
 
 
@@ -31,10 +32,14 @@ MI_PY_DECLARE(DummyStream);
 MI_PY_DECLARE(FileStream);
 MI_PY_DECLARE(MemoryStream);
 MI_PY_DECLARE(ZStream);
+MI_PY_DECLARE(BufferedStream);
 MI_PY_DECLARE(ProgressReporter);
+MI_PY_DECLARE(Profiler);
+MI_PY_DECLARE(MemoryTracker);
 MI_PY_DECLARE(rfilter);
 MI_PY_DECLARE(Thread);
 MI_PY_DECLARE(Timer);
+MI_PY_DECLARE(ResourceCache);
 MI_PY_DECLARE(misc);
 
 // render
@@ -48,6 +53,7 @@ MI_PY_DECLARE(Sensor);
 MI_PY_DECLARE(VolumeGrid);
 MI_PY_DECLARE(FilmFlags);
 MI_PY_DECLARE(DiscontinuityFlags);
+MI_PY_DECLARE(RenderStatistics);
 
 NB_MODULE(mitsuba_ext, m) {
     // Temporarily change the module name (for pydoc)
@@ -156,9 +162,13 @@ NB_MODULE(mitsuba_ext, m) {
     MI_PY_IMPORT(FileStream);
     MI_PY_IMPORT(MemoryStream);
     MI_PY_IMPORT(ZStream);
+    MI_PY_IMPORT(BufferedStream);
     MI_PY_IMPORT(ProgressReporter);
+    MI_PY_IMPORT(Profiler);
+    MI_PY_IMPORT(MemoryTracker);
     MI_PY_IMPORT(Thread);
     MI_PY_IMPORT(Timer);
+    MI_PY_IMPORT(ResourceCache);
     MI_PY_IMPORT(misc);
 
     MI_PY_IMPORT(BSDFContext);
@@ -170,6 +180,7 @@ NB_MODULE(mitsuba_ext, m) {
     MI_PY_IMPORT(Sensor);
     MI_PY_IMPORT(FilmFlags);
     MI_PY_IMPORT(DiscontinuityFlags);
+    MI_PY_IMPORT(RenderStatistics);
 
     /* Register a cleanup callback function to wait for pending tasks (this is
      * called before all Python variables are cleaned up */
@@ -204,6 +215,7 @@ NB_MODULE(mitsuba_ext, m) {
     /* Callback function cleanup static data structures, this should be called
      * when the module is being deallocated */
     nanobind_module_def_mitsuba_ext.m_free = [](void *) {
+        ResourceCache::static_shutdown();
         Profiler::static_shutdown();
         Bitmap::static_shutdown();
         Logger::static_shutdown();
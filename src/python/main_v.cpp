@@ -64,6 +64,7 @@ MI_PY_DECLARE(Frame);
 MI_PY_DECLARE(Ray);
 MI_PY_DECLARE(DiscreteDistribution);
 MI_PY_DECLARE(DiscreteDistribution2D);
+MI_PY_DECLARE(FenwickDistribution);
 MI_PY_DECLARE(ContinuousDistribution);
 MI_PY_DECLARE(IrregularContinuousDistribution);
 MI_PY_DECLARE(Hierarchical2D);
@@ -102,6 +103,9 @@ MI_PY_DECLARE(MicroflakeDistribution);
 #if defined(MI_ENABLE_CUDA)
 MI_PY_DECLARE(OptixDenoiser);
 #endif // defined(MI_ENABLE_CUDA)
+#if defined(MI_ENABLE_OIDN)
+MI_PY_DECLARE(OIDNDenoiser);
+#endif // defined(MI_ENABLE_OIDN)
 MI_PY_DECLARE(PositionSample);
 MI_PY_DECLARE(PhaseFunction);
 MI_PY_DECLARE(DirectionSample);
@@ -157,8 +161,8 @@ NB_MODULE(MI_VARIANT_NAME, m) {
     m.attr("is_spectral") = is_spectral_v<Spectrum>;
     m.attr("is_polarized") = is_polarized_v<Spectrum>;
 
-    color_management_static_initialization(dr::is_cuda_v<Float>,
-                                           dr::is_llvm_v<Float>);
+    /* The color space tables are initialized on demand, and the Embree
+       device and OptiX pipelines are created with the first scene */
     Scene::static_accel_initialization();
 
     MI_PY_IMPORT(Object);
@@ -168,6 +172,7 @@ NB_MODULE(MI_VARIANT_NAME, m) {
     MI_PY_IMPORT(Frame);
     MI_PY_IMPORT(DiscreteDistribution);
     MI_PY_IMPORT(DiscreteDistribution2D);
+    MI_PY_IMPORT(FenwickDistribution);
     MI_PY_IMPORT(ContinuousDistribution);
     MI_PY_IMPORT(IrregularContinuousDistribution);
     MI_PY_IMPORT_SUBMODULE(math);
@@ -210,6 +215,9 @@ NB_MODULE(MI_VARIANT_NAME, m) {
 #if defined(MI_ENABLE_CUDA)
     MI_PY_IMPORT(OptixDenoiser);
 #endif // defined(MI_ENABLE_CUDA)
+#if defined(MI_ENABLE_OIDN)
+    MI_PY_IMPORT(OIDNDenoiser);
+#endif // defined(MI_ENABLE_OIDN)
     MI_PY_IMPORT(PhaseFunction);
     MI_PY_IMPORT(Sampler);
     MI_PY_IMPORT(Sensor);
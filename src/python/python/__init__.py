@@ -1,5 +1,6 @@
-from .util import traverse, SceneParameters, render, cornell_box, variant_context
+from .util import traverse, SceneParameters, render, render_sequence, split_batch, warmup, prefetch_kernels, KernelWarmup, cornell_box, variant_context
 from . import chi2
 from . import xml
 from . import ad
 from . import math_py
+from . import benchmark
@@ -365,6 +365,8 @@ class ADIntegrator(mi.CppADIntegrator):
                 "fewer samples per pixel or render using multiple passes."
                 % wavefront_size)
 
+        # The sequences of the wavefront cover the film in scanline order
+        sampler.set_film_width(film_size[0])
         sampler.seed(seed, wavefront_size)
         film.prepare(aovs)
 
@@ -493,8 +495,179 @@ class RBIntegrator(ADIntegrator):
     """
     Abstract base class of radiative-backpropagation style differentiable
     integrators.
+
+    .. pluginparameters::
+
+     * - freeze
+       - |bool|
+       - Record the kernels of the primal, forward and backward rendering
+         steps once and replay them in subsequent calls, which only change the
+         parameter values and the seed (e.g. in an optimization loop). This
+         skips the tracing of the Python code and the assembly of the kernels.
+         It requires a version of Dr.Jit with support for frozen functions
+         (``dr.freeze()``). (Default: |false|)
+
+     * - max_wavefront_memory
+       - |float|
+       - Memory budget (in MiB) for the wavefront of the forward and backward
+         rendering steps. When the estimated state of a wavefront tracing all
+         samples at once exceeds it, the samples are split into several passes
+         with the largest divisor of the sample count that fits, and the
+         gradients of the passes are accumulated. A value of zero disables the
+         limit. (Default: 0)
+
+     * - wavefront_lane_words
+       - |int|
+       - Estimated number of 32-bit words of state per lane of the wavefront,
+         excluding the channels of the film, which converts the
+         ``max_wavefront_memory`` budget into a number of lanes. The default
+         corresponds to the state of a path tracer in an RGB variant,
+         integrators with more state (e.g. volumetric ones) should use a
+         larger value. (Default: 128)
+
+    The recordings are specific to a scene, a sensor and a sample count. They
+    are discarded when ``Scene.parameters_changed()`` rebuilds the scene's
+    acceleration data structure or emitter sampling distributions (see
+    ``Scene.structure_version()``), and Dr.Jit records them again whenever the
+    layout of the inputs (e.g. the size of a parameter) changes.
     """
 
+    def __init__(self, props):
+        super().__init__(props)
+
+        self.freeze = props.get('freeze', False)
+        if self.freeze and not hasattr(dr, 'freeze'):
+            raise Exception("\"freeze\" requires a version of Dr.Jit with "
+                            "support for frozen functions (dr.freeze)!")
+
+        # Frozen functions, indexed by rendering step, scene and sensor
+        self._frozen = {}
+
+        self.max_wavefront_memory = props.get('max_wavefront_memory', 0.0)
+        if self.max_wavefront_memory < 0:
+            raise Exception("\"max_wavefront_memory\" must be non-negative!")
+
+        self.wavefront_lane_words = props.get('wavefront_lane_words', 128)
+        if self.wavefront_lane_words <= 0:
+            raise Exception("\"wavefront_lane_words\" must be positive!")
+
+    def _wavefront_passes(self, sensor: mi.Sensor, spp: int) -> Tuple[int, int]:
+        """
+        Split the samples of a differential rendering step into passes that
+        fit the ``max_wavefront_memory`` budget.
+
+        Returns the total number of samples per pixel and the number of samples
+        per pass. The latter is the largest divisor of the former such that a
+        pass over the whole image fits the budget (at least one sample per
+        pixel), using the same estimate as ``SamplingIntegrator.render()``. The
+        passes therefore only depend on the budget, film, and sample count.
+        """
+        sampler = sensor.sampler().clone()
+        if spp != 0:
+            sampler.set_sample_count(spp)
+        spp = sampler.sample_count()
+
+        if self.max_wavefront_memory <= 0:
+            return spp, spp
+
+        film = sensor.film()
+        film_size = film.crop_size()
+        if film.sample_border():
+            film_size += 2 * film.rfilter().border_size()
+
+        # Estimated state per lane, plus the channels of the film
+        n_channels = film.base_channels_count() + len(self.aov_names())
+        lane_size = (self.wavefront_lane_words + n_channels) * 4
+        max_lanes = max(int(self.max_wavefront_memory * 1024 * 1024) // lane_size, 1)
+        pixel_count = int(dr.prod(film_size))
+
+        spp_per_pass = spp
+        while spp_per_pass > 1 and pixel_count * spp_per_pass > max_lanes:
+            spp_per_pass -= 1
+            while spp % spp_per_pass != 0:
+                spp_per_pass -= 1
+
+        if pixel_count * spp_per_pass > max_lanes:
+            mi.Log(mi.LogLevel.Warn,
+                   "A single sample per pixel exceeds the wavefront memory "
+                   "budget of the differential rendering step.")
+
+        return spp, spp_per_pass
+
+    def _prepare_passes(self, sensor: mi.Sensor, seed: mi.UInt32, spp: int):
+        """
+        Prepare the film and sampler of a differential rendering step that is
+        split into passes (see ``_wavefront_passes()``).
+
+        Returns the sampler, the total number of samples per pixel, and the
+        number of samples per pass. Use ``_reseed_pass()`` before rendering
+        each pass after the first one.
+        """
+        spp, spp_per_pass = self._wavefront_passes(sensor, spp)
+
+        sampler, spp_2 = self.prepare(sensor, seed, spp_per_pass, self.aov_names())
+
+        # Samplers that round the sample count (e.g. 'stratified') may not
+        # support the pass size, render all samples at once in that case
+        if spp_2 != spp_per_pass:
+            sampler, spp = self.prepare(sensor, seed, spp, self.aov_names())
+            spp_per_pass = spp
+
+        return sampler, spp, spp_per_pass
+
+    def _reseed_pass(self, sampler: mi.Sampler, seed: mi.UInt32, index: int):
+        """
+        Reseed the sampler for pass ``index > 0`` of a differential rendering
+        step, in the same way as the passes of ``SamplingIntegrator.render()``.
+        """
+        sampler.seed(mi.sample_tea_32(mi.UInt32(seed), mi.UInt32(index))[0],
+                     sampler.wavefront_size())
+
+    def _frozen_call(self, name: str, func: Callable, scene: mi.Scene,
+                     sensor: mi.Sensor, seed: mi.UInt32, spp: int, *args):
+        """
+        Invoke ``func(scene, sensor, seed, spp, *args)``, through a frozen
+        function if the ``freeze`` parameter is set.
+
+        The frozen function is created the first time a rendering step
+        (``name``) is invoked for a given scene and sensor, and again when the
+        structure of the scene changed since then.
+        """
+        if not self.freeze:
+            return func(scene, sensor, seed, spp, *args)
+
+        key = (name, id(scene), id(sensor))
+        version = scene.structure_version()
+        entry = self._frozen.get(key)
+        if entry is None or entry[0] != version:
+            entry = (version, dr.freeze(func))
+            self._frozen[key] = entry
+
+        # The seed must be an input of the recording rather than a constant
+        seed = mi.UInt32(seed)
+        dr.make_opaque(seed)
+        return entry[1](scene, sensor, seed, spp, *args)
+
+    def render(self: mi.SamplingIntegrator,
+               scene: mi.Scene,
+               sensor: Union[int, mi.Sensor] = 0,
+               seed: mi.UInt32 = 0,
+               spp: int = 0,
+               develop: bool = True,
+               evaluate: bool = True) -> mi.TensorXf:
+        if not develop:
+            raise Exception("develop=True must be specified when "
+                            "invoking AD integrators")
+
+        if isinstance(sensor, int):
+            sensor = scene.sensors()[sensor]
+
+        return self._frozen_call('primal', self._render_primal, scene, sensor,
+                                 seed, spp)
+
+    def _render_primal(self, scene, sensor, seed, spp):
+        return ADIntegrator.render(self, scene, sensor, seed, spp)
+
     def render_forward(self: mi.SamplingIntegrator,
                        scene: mi.Scene,
                        params: Any,
@@ -560,70 +733,87 @@ class RBIntegrator(ADIntegrator):
         if isinstance(sensor, int):
             sensor = scene.sensors()[sensor]
 
+        return self._frozen_call('forward', self._render_forward, scene,
+                                 sensor, seed, spp, params)
+
+    def _render_forward(self, scene, sensor, seed, spp, params):
         film = sensor.film()
 
         # Disable derivatives in all of the following
         with dr.suspend_grad():
             # Prepare the film and sample generator for rendering
-            sampler, spp = self.prepare(sensor, seed, spp, self.aov_names())
+            sampler, spp, spp_per_pass = self._prepare_passes(sensor, seed, spp)
+            n_passes = spp // spp_per_pass
 
-            # Generate a set of rays starting at the sensor, keep track of
-            # derivatives wrt. sample positions ('pos') if there are any
-            ray, weight, pos = self.sample_rays(scene, sensor, sampler)
+            for i in range(n_passes):
+                if i > 0:
+                    self._reseed_pass(sampler, seed, i)
 
-            # Launch the Monte Carlo sampling process in primal mode (1)
-            L, valid, aovs, state_out = self.sample(
-                mode=dr.ADMode.Primal,
-                scene=scene,
-                sampler=sampler.clone(),
-                ray=ray,
-                depth=mi.UInt32(0),
-                δL=None,
-                state_in=None,
-                active=mi.Bool(True)
-            )
+                # Generate a set of rays starting at the sensor, keep track of
+                # derivatives wrt. sample positions ('pos') if there are any
+                ray, weight, pos = self.sample_rays(scene, sensor, sampler)
 
-            # Launch the Monte Carlo sampling process in forward mode (2)
-            δL, valid_2, δaovs, state_out_2 = self.sample(
-                mode=dr.ADMode.Forward,
-                scene=scene,
-                sampler=sampler,
-                ray=ray,
-                depth=mi.UInt32(0),
-                δL=None,
-                δaovs=None,
-                state_in=state_out,
-                active=mi.Bool(True)
-            )
+                # Launch the Monte Carlo sampling process in primal mode (1)
+                L, valid, aovs, state_out = self.sample(
+                    mode=dr.ADMode.Primal,
+                    scene=scene,
+                    sampler=sampler.clone(),
+                    ray=ray,
+                    depth=mi.UInt32(0),
+                    δL=None,
+                    state_in=None,
+                    active=mi.Bool(True)
+                )
 
-            # Prepare an ImageBlock as specified by the film
-            block = film.create_block()
+                # Launch the Monte Carlo sampling process in forward mode (2)
+                δL, valid_2, δaovs, state_out_2 = self.sample(
+                    mode=dr.ADMode.Forward,
+                    scene=scene,
+                    sampler=sampler,
+                    ray=ray,
+                    depth=mi.UInt32(0),
+                    δL=None,
+                    δaovs=None,
+                    state_in=state_out,
+                    active=mi.Bool(True)
+                )
 
-            # Only use the coalescing feature when rendering enough samples
-            block.set_coalesce(block.coalesce() and spp >= 4)
+                # Prepare an ImageBlock as specified by the film
+                block = film.create_block()
 
-            # Accumulate into the image block
-            ADIntegrator._splat_to_block(
-                block, film, pos,
-                value=δL * weight,
-                weight=1.0,
-                alpha=dr.select(valid_2, mi.Float(1), mi.Float(0)),
-                aovs=[δaov * weight for δaov in δaovs],
-                wavelengths=ray.wavelengths
-            )
+                # Only use the coalescing feature when rendering enough samples
+                block.set_coalesce(block.coalesce() and spp_per_pass >= 4)
 
-            # Perform the weight division and return an image tensor
-            film.put_block(block)
+                # Accumulate into the image block
+                ADIntegrator._splat_to_block(
+                    block, film, pos,
+                    value=δL * weight,
+                    weight=1.0,
+                    alpha=dr.select(valid_2, mi.Float(1), mi.Float(0)),
+                    aovs=[δaov * weight for δaov in δaovs],
+                    wavelengths=ray.wavelengths
+                )
 
-            # Explicitly delete any remaining unused variables
-            del sampler, ray, weight, pos, L, valid, aovs, δL, δaovs, \
-                valid_2, params, state_out, state_out_2, block
+                # The film accumulates the samples of all passes
+                film.put_block(block)
+
+                # Explicitly delete any remaining unused variables
+                del ray, weight, pos, L, valid, aovs, δL, δaovs, \
+                    valid_2, state_out, state_out_2, block
+
+                # Evaluate each pass separately to bound the wavefront size
+                if n_passes > 1:
+                    gc.collect()
+                    dr.eval()
+
+            del sampler, params
 
             # Probably a little overkill, but why not.. If there are any
             # DrJit arrays to be collected by Python's cyclic GC, then
             # freeing them may enable loop simplifications in dr.eval().
             gc.collect()
 
+            # Perform the weight division and return an image tensor
             result_grad = film.develop()
 
         return result_grad
@@ -688,112 +878,130 @@ class RBIntegrator(ADIntegrator):
         if isinstance(sensor, int):
             sensor = scene.sensors()[sensor]
 
+        self._frozen_call('backward', self._render_backward, scene, sensor,
+                          seed, spp, params, grad_in)
+
+    def _render_backward(self, scene, sensor, seed, spp, params, grad_in):
         film = sensor.film()
 
         # Disable derivatives in all of the following
         with dr.suspend_grad():
             # Prepare the film and sample generator for rendering
-            sampler, spp = self.prepare(sensor, seed, spp, self.aov_names())
-
-            # Generate a set of rays starting at the sensor, keep track of
-            # derivatives wrt. sample positions ('pos') if there are any
-            ray, weight, pos = self.sample_rays(scene, sensor, sampler)
-
-            def splatting_and_backward_gradient_image(value: mi.Spectrum,
-                                                      weight: mi.Float,
-                                                      alpha: mi.Float,
-                                                      aovs: Sequence[mi.Float]):
-                '''
-                Backward propagation of the gradient image through the sample
-                splatting and weight division steps.
-                '''
+            sampler, spp, spp_per_pass = self._prepare_passes(sensor, seed, spp)
+            n_passes = spp // spp_per_pass
 
-                # Prepare an ImageBlock as specified by the film
-                block = film.create_block()
-
-                # Only use the coalescing feature when rendering enough samples
-                block.set_coalesce(block.coalesce() and spp >= 4)
-
-                ADIntegrator._splat_to_block(
-                    block, film, pos,
-                    value=value,
-                    weight=weight,
-                    alpha=alpha,
-                    aovs=aovs,
-                    wavelengths=ray.wavelengths
-                )
+            for i in range(n_passes):
+                if i > 0:
+                    self._reseed_pass(sampler, seed, i)
 
-                film.put_block(block)
+                # Generate a set of rays starting at the sensor, keep track of
+                # derivatives wrt. sample positions ('pos') if there are any
+                ray, weight, pos = self.sample_rays(scene, sensor, sampler)
 
-                # Probably a little overkill, but why not.. If there are any
-                # DrJit arrays to be collected by Python's cyclic GC, then
-                # freeing them may enable loop simplifications in dr.eval().
-                gc.collect()
+                def splatting_and_backward_gradient_image(value: mi.Spectrum,
+                                                          weight: mi.Float,
+                                                          alpha: mi.Float,
+                                                          aovs: Sequence[mi.Float]):
+                    '''
+                    Backward propagation of the gradient image through the sample
+                    splatting and weight division steps.
+                    '''
+
+                    # Prepare an ImageBlock as specified by the film
+                    block = film.create_block()
+
+                    # Only use the coalescing feature when rendering enough samples
+                    block.set_coalesce(block.coalesce() and spp_per_pass >= 4)
+
+                    ADIntegrator._splat_to_block(
+                        block, film, pos,
+                        value=value,
+                        weight=weight,
+                        alpha=alpha,
+                        aovs=aovs,
+                        wavelengths=ray.wavelengths
+                    )
 
-                image = film.develop()
+                    film.put_block(block)
 
-                dr.set_grad(image, grad_in)
-                dr.enqueue(dr.ADMode.Backward, image)
-                dr.traverse(dr.ADMode.Backward)
+                    # Probably a little overkill, but why not.. If there are any
+                    # DrJit arrays to be collected by Python's cyclic GC, then
+                    # freeing them may enable loop simplifications in dr.eval().
+                    gc.collect()
 
-            # Differentiate sample splatting and weight division steps to
-            # retrieve the adjoint radiance (e.g. 'δL')
-            with dr.resume_grad():
-                with dr.suspend_grad(pos, ray, weight):
-                    L = dr.full(mi.Spectrum, 1.0, dr.width(ray))
-                    dr.enable_grad(L)
-                    aovs = []
-                    for _ in self.aov_names():
-                        aov = dr.ones(mi.Float, dr.width(ray))
-                        dr.enable_grad(aov)
-                        aovs.append(aov)
-                    splatting_and_backward_gradient_image(
-                        value=L * weight,
-                        weight=1.0,
-                        alpha=1.0,
-                        aovs=[aov * weight for aov in aovs]
-                    )
+                    image = film.develop()
 
-                    δL = dr.grad(L)
-                    δaovs = dr.grad(aovs)
+                    dr.set_grad(image, grad_in)
+                    dr.enqueue(dr.ADMode.Backward, image)
+                    dr.traverse(dr.ADMode.Backward)
 
-            # Clear the dummy data splatted on the film above
-            film.clear()
+                # Differentiate sample splatting and weight division steps to
+                # retrieve the adjoint radiance (e.g. 'δL')
+                with dr.resume_grad():
+                    with dr.suspend_grad(pos, ray, weight):
+                        L = dr.full(mi.Spectrum, 1.0, dr.width(ray))
+                        dr.enable_grad(L)
+                        aovs = []
+                        for _ in self.aov_names():
+                            aov = dr.ones(mi.Float, dr.width(ray))
+                            dr.enable_grad(aov)
+                            aovs.append(aov)
+                        splatting_and_backward_gradient_image(
+                            value=L * weight,
+                            weight=1.0,
+                            alpha=1.0,
+                            aovs=[aov * weight for aov in aovs]
+                        )
+
+                        δL = dr.grad(L)
+                        δaovs = dr.grad(aovs)
+
+                # Clear the dummy data splatted on the film above
+                film.clear()
+
+                # The weight division above only accounted for the samples of
+                # this pass, each of which holds a fraction of the total weight
+                if n_passes > 1:
+                    δL *= spp_per_pass / spp
+                    δaovs = [δaov * (spp_per_pass / spp) for δaov in δaovs]
+
+                # Launch the Monte Carlo sampling process in primal mode (1)
+                L, valid, aovs, state_out = self.sample(
+                    mode=dr.ADMode.Primal,
+                    scene=scene,
+                    sampler=sampler.clone(),
+                    ray=ray,
+                    depth=mi.UInt32(0),
+                    δL=None,
+                    δaovs=None,
+                    state_in=None,
+                    active=mi.Bool(True)
+                )
 
-            # Launch the Monte Carlo sampling process in primal mode (1)
-            L, valid, aovs, state_out = self.sample(
-                mode=dr.ADMode.Primal,
-                scene=scene,
-                sampler=sampler.clone(),
-                ray=ray,
-                depth=mi.UInt32(0),
-                δL=None,
-                δaovs=None,
-                state_in=None,
-                active=mi.Bool(True)
-            )
+                # Launch Monte Carlo sampling in backward AD mode (2)
+                L_2, valid_2, aovs_2, state_out_2 = self.sample(
+                    mode=dr.ADMode.Backward,
+                    scene=scene,
+                    sampler=sampler,
+                    ray=ray,
+                    depth=mi.UInt32(0),
+                    δL=δL,
+                    δaovs=δaovs,
+                    state_in=state_out,
+                    active=mi.Bool(True)
+                )
 
-            # Launch Monte Carlo sampling in backward AD mode (2)
-            L_2, valid_2, aovs_2, state_out_2 = self.sample(
-                mode=dr.ADMode.Backward,
-                scene=scene,
-                sampler=sampler,
-                ray=ray,
-                depth=mi.UInt32(0),
-                δL=δL,
-                δaovs=δaovs,
-                state_in=state_out,
-                active=mi.Bool(True)
-            )
+                # We don't need any of the outputs here
+                del L_2, valid_2, aovs_2, state_out, state_out_2, \
+                    δL, δaovs, ray, weight, pos
 
-            # We don't need any of the outputs here
-            del L_2, valid_2, aovs_2, state_out, state_out_2, \
-                δL, δaovs, ray, weight, pos, sampler
+                gc.collect()
 
-            gc.collect()
+                # Run kernel representing side effects of the above. The
+                # parameter gradients accumulate over the passes.
+                dr.eval()
 
-            # Run kernel representing side effects of the above
-            dr.eval()
+            del sampler
 
 
 class PSIntegrator(ADIntegrator):
@@ -960,11 +1168,30 @@ class PSIntegrator(ADIntegrator):
 
         # Primarily visible discontinuous derivative
         if sppp > 0 and has_silhouettes:
-            with dr.suspend_grad():
-                self.proj_detail.init_primarily_visible_silhouette(scene, sensor)
-
             sampler, spp = self.prepare(sensor, 0xffffffff ^ seed, sppp, aovs)
-            result_img += self.render_primarily_visible_silhouette(scene, sensor, sampler, spp)
+            views = sensor.sub_sensors()
+
+            if len(views) == 0:
+                with dr.suspend_grad():
+                    self.proj_detail.init_primarily_visible_silhouette(scene, sensor)
+
+                result_img += self.render_primarily_visible_silhouette(scene, sensor, sampler, spp)
+            else:
+                # Batch sensor: the silhouettes depend on the viewpoint, hence
+                # sample them separately for each view (with as many samples
+                # as its pixels) and splat them into its part of the film
+                wavefront_size = sampler.wavefront_size() // len(views)
+                for i, view in enumerate(views):
+                    with dr.suspend_grad():
+                        self.proj_detail.init_primarily_visible_silhouette(scene, view)
+
+                    sampler_view = sampler.clone()
+                    sampler_view.seed(
+                        mi.sample_tea_32(mi.UInt32(0xffffffff ^ seed), mi.UInt32(i))[0],
+                        wavefront_size)
+                    result_img += self.render_primarily_visible_silhouette(
+                        scene, sensor, sampler_view, spp, view=view,
+                        offset=i * view.film().size().x)
 
         # Indirect discontinuous derivative
         if sppi > 0 and has_silhouettes:
@@ -1093,20 +1320,33 @@ class PSIntegrator(ADIntegrator):
                                             scene: mi.Scene,
                                             sensor: mi.Sensor,
                                             sampler: mi.Sampler,
-                                            spp: int) -> mi.TensorXf:
+                                            spp: int,
+                                            view: Optional[mi.Sensor] = None,
+                                            offset: int = 0) -> mi.TensorXf:
         """
         Renders the primarily visible discontinuities.
 
         This method returns the AD-attached image. The result must still be
         traversed using one of the Dr.Jit functions to propagate gradients.
+
+        Parameter ``view`` (``mi.Sensor``):
+            Child sensor of a ``batch`` sensor (see ``Sensor.sub_sensors()``)
+            whose discontinuities should be rendered. By default, ``sensor``
+            itself is used.
+
+        Parameter ``offset`` (``int``):
+            Horizontal offset (in pixels) of the view in the film of ``sensor``.
         """
         film = sensor.film()
         aovs = self.aov_names()
 
+        if view is None:
+            view = sensor
+
         # Explicit sampling to handle the primarily visible discontinuous derivative
         with dr.suspend_grad():
             # Get the viewpoint
-            sensor_center = sensor.world_transform() @ mi.Point3f(0)
+            sensor_center = view.world_transform() @ mi.Point3f(0)
 
             # Sample silhouette point
             ss = self.proj_detail.sample_primarily_visible_silhouette(
@@ -1114,10 +1354,10 @@ class PSIntegrator(ADIntegrator):
             active = ss.is_valid() & (ss.pdf > 0)
 
             # Jacobian (motion correction included)
-            J = self.proj_detail.perspective_sensor_jacobian(sensor, ss)
+            J = self.proj_detail.perspective_sensor_jacobian(view, ss)
 
             ΔL = self.proj_detail.eval_primary_silhouette_radiance_difference(
-                scene, sampler, ss, sensor, active=active)
+                scene, sampler, ss, view, active=active)
             active &= dr.any(ΔL != 0)
 
         # ∂z/∂ⲡ * normal
@@ -1136,7 +1376,8 @@ class PSIntegrator(ADIntegrator):
         with dr.suspend_grad():
             it = dr.zeros(mi.Interaction3f)
             it.p = ss.p
-            sensor_ds, _ = sensor.sample_direction(it, mi.Point2f(0))
+            sensor_ds, _ = view.sample_direction(it, mi.Point2f(0))
+            sensor_ds.uv.x += offset
 
         # Particle tracer style imageblock to accumulate primarily visible derivatives
         block = film.create_block(normalize=True)
@@ -1324,3 +1565,53 @@ def mis_weight(pdf_a, pdf_b):
     b2 = dr.square(pdf_b)
     w = a2 / (a2 + b2)
     return dr.detach(dr.select(dr.isfinite(w), w, 0))
+
+
+def sort_by_bsdf(bsdf: mi.BSDFPtr,
+                 active: mi.Bool) -> Tuple[mi.UInt32, mi.UInt32]:
+    """
+    Sort the lanes of a wavefront by BSDF instance with a counting sort, with
+    the inactive lanes moved to the end. This requires evaluated loops (i.e.
+    wavefront mode).
+
+    Returns the permutation from sorted positions to the original lanes, and
+    the sorted position of every lane (see ``call_sorted()``).
+    """
+    ids = dr.reinterpret_array(mi.UInt32, bsdf)
+    bound = int(dr.max(ids)[0]) + 1 if dr.width(ids) > 0 else 1
+    key = dr.select(active, ids, bound)
+
+    counts = dr.zeros(mi.UInt32, bound + 1)
+    dr.scatter_reduce(dr.ReduceOp.Add, counts, 1, key)
+    offsets = dr.prefix_sum(counts, exclusive=True)
+
+    cursor = dr.zeros(mi.UInt32, bound + 1)
+    slot = dr.gather(mi.UInt32, offsets, key) + dr.scatter_inc(cursor, key)
+
+    size = dr.width(key)
+    perm = dr.zeros(mi.UInt32, size)
+    dr.scatter(perm, dr.arange(mi.UInt32, size), slot)
+    dr.eval(perm, slot)
+    return perm, slot
+
+
+def call_sorted(order: Optional[Tuple[mi.UInt32, mi.UInt32]],
+                func: Callable, *args):
+    """
+    Call ``func(*args)`` on the lanes reordered by ``order`` (as returned by
+    ``sort_by_bsdf()``), and return the result in the original lane order. The
+    arguments that are not Dr.Jit arrays or structures are passed as is. When
+    ``order`` is ``None``, this simply calls ``func(*args)``.
+    """
+    if order is None:
+        return func(*args)
+
+    def permute(value, index):
+        if isinstance(value, tuple):
+            return tuple(permute(v, index) for v in value)
+        if dr.is_array_v(value) or dr.is_struct_v(value):
+            return dr.gather(type(value), value, index)
+        return value
+
+    perm, slot = order
+    return permute(func(*[permute(arg, perm) for arg in args]), slot)
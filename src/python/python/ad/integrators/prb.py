@@ -3,7 +3,7 @@ from __future__ import annotations # Delayed parsing of type annotations
 import drjit as dr
 import mitsuba as mi
 
-from .common import RBIntegrator, mis_weight
+from .common import RBIntegrator, mis_weight, sort_by_bsdf, call_sorted
 
 class PRBIntegrator(RBIntegrator):
     r"""
@@ -28,6 +28,32 @@ class PRBIntegrator(RBIntegrator):
          1, then path generation many randomly cease after encountering directly
          visible surfaces. (Default: 5)
 
+     * - freeze
+       - |bool|
+       - Record the kernels of the rendering steps once and replay them in
+         subsequent calls with new parameter values and seeds, see
+         ``RBIntegrator``. (Default: |false|)
+
+     * - max_wavefront_memory
+       - |float|
+       - Memory budget (in MiB) for the wavefront of the differential rendering
+         steps, which are split into several passes if needed, see
+         ``RBIntegrator``. (Default: 0, i.e. unlimited)
+
+     * - wavefront_lane_words
+       - |int|
+       - Estimated number of 32-bit words of state per lane of the wavefront,
+         which converts the ``max_wavefront_memory`` budget into a number of
+         lanes, see ``RBIntegrator``. (Default: 128)
+
+     * - sort_materials
+       - |bool|
+       - Sort the active lanes of every bounce by BSDF instance before
+         evaluating and sampling the materials, which reduces the divergence
+         of the virtual function calls in scenes with many materials. This
+         only has an effect in wavefront mode (i.e. with the
+         ``JitFlag.SymbolicLoops`` flag disabled). (Default: |false|)
+
     This plugin implements a basic Path Replay Backpropagation (PRB) integrator
     with the following properties:
 
@@ -60,6 +86,10 @@ class PRBIntegrator(RBIntegrator):
             'max_depth': 8
     """
 
+    def __init__(self, props):
+        super().__init__(props)
+        self.sort_materials = props.get('sort_materials', False)
+
     @dr.syntax
     def sample(self,
                mode: dr.ADMode,
@@ -82,6 +112,10 @@ class PRBIntegrator(RBIntegrator):
         # Standard BSDF evaluation context for path tracing
         bsdf_ctx = mi.BSDFContext()
 
+        # Sort the lanes by material before calling BSDFs? (wavefront mode only)
+        sort_materials = self.sort_materials and \
+            not dr.flag(dr.JitFlag.SymbolicLoops)
+
         # --------------------- Configure loop state ----------------------
 
         # Copy input arguments to avoid mutating the caller's state
@@ -139,6 +173,10 @@ class PRBIntegrator(RBIntegrator):
             # Is emitter sampling even possible on the current vertex?
             active_em = active_next & mi.has_flag(bsdf.flags(), mi.BSDFFlags.Smooth)
 
+            order = None
+            if dr.hint(sort_materials, mode='scalar'):
+                order = sort_by_bsdf(bsdf, active_next)
+
             # If so, randomly sample an emitter without derivative tracking.
             ds, em_weight = scene.sample_emitter_direction(
                 si, sampler.next_2d(), True, active_em)
@@ -153,18 +191,19 @@ class PRBIntegrator(RBIntegrator):
                     em_weight = dr.replace_grad(em_weight, dr.select((ds.pdf != 0), em_val / ds.pdf, 0))
                     dr.disable_grad(ds.d)
 
-                # Evaluate BSDF * cos(theta) differentiably
+                # Evaluate BSDF * cos(theta) differentiably and sample the next
+                # direction using a single (fused) BSDF call
                 wo = si.to_local(ds.d)
-                bsdf_value_em, bsdf_pdf_em = bsdf.eval_pdf(bsdf_ctx, si, wo, active_em)
+                sample1, sample2 = sampler.next_1d(), sampler.next_2d()
+                bsdf_value_em, bsdf_pdf_em, bsdf_sample, bsdf_weight = call_sorted(
+                    order, lambda b, *args: b.eval_pdf_sample(*args),
+                    bsdf, bsdf_ctx, si, wo, sample1, sample2, active_next)
                 mis_em = dr.select(ds.delta, 1, mis_weight(ds.pdf, bsdf_pdf_em))
-                Lr_dir = β * mis_em * bsdf_value_em * em_weight
+                Lr_dir = dr.select(active_em, β * mis_em * bsdf_value_em * em_weight, 0)
 
             # ------------------ Detached BSDF sampling -------------------
 
-            bsdf_sample, bsdf_weight = bsdf.sample(bsdf_ctx, si,
-                                                   sampler.next_1d(),
-                                                   sampler.next_2d(),
-                                                   active_next)
+            bsdf_sample, bsdf_weight = dr.detach(bsdf_sample), dr.detach(bsdf_weight)
 
             # ---- Update loop variables based on current interaction -----
 
@@ -212,7 +251,9 @@ class PRBIntegrator(RBIntegrator):
                     wo = si.to_local(ray.d)
 
                     # Re-evaluate BSDF * cos(theta) differentiably
-                    bsdf_val = bsdf.eval(bsdf_ctx, si, wo, active_next)
+                    bsdf_val = call_sorted(
+                        order, lambda b, *args: b.eval(*args),
+                        bsdf, bsdf_ctx, si, wo, active_next)
 
                     # Detached version of the above term and inverse
                     bsdf_val_det = bsdf_weight * bsdf_sample.pdf
@@ -475,6 +475,7 @@ class PathProjectiveIntegrator(PSIntegrator):
         cnt_valid = mi.UInt32(0)                    # Number of valid connections
         first_its = mi.Bool(active)                 # First iteration?
         first_wo = dr.zeros(mi.Vector3f)            # First BSDF sampled direction, or the direction to the sensor
+        sample_cam = dr.zeros(mi.Point2f)           # Sample of the selected sensor connection
         active_loop = mi.Mask(active)               # Active SIMD lanes
 
         bsdf_ctx = mi.BSDFContext(mi.TransportMode.Importance)
@@ -486,8 +487,9 @@ class PathProjectiveIntegrator(PSIntegrator):
             active_connect = active_loop & mi.has_flag(bsdf.flags(), mi.BSDFFlags.Smooth)
 
             # Sample a direction from the current vertex towards the sensor
+            sample_connect = sampler.next_2d(active_connect)
             sensor_ds, sensor_weight = sensor.sample_direction(
-                si_loop, sampler.next_2d(active_connect), active_connect)
+                si_loop, sample_connect, active_connect)
             active_connect &= (sensor_ds.pdf > 0) & dr.any(sensor_weight > 0)
 
             # Check that the sensor is visible from the current vertex (shadow test)
@@ -501,6 +503,7 @@ class PathProjectiveIntegrator(PSIntegrator):
             si_cam[replace]    = si_loop
             depth_cam[replace] = depth
             W[replace]         = β
+            sample_cam[replace] = sample_connect
 
             # Should we continue tracing to reach one more vertex? We need to
             # continue tracing even when we have found a valid connection.
@@ -531,9 +534,11 @@ class PathProjectiveIntegrator(PSIntegrator):
         # Which lanes have a valid connection?
         active_found = active & (cnt_valid > 0)
 
-        # Re-compute the importance weight
+        # Re-compute the importance weight. Reuse the sample of the selected
+        # connection, so that sensors which sample a random view or aperture
+        # position (e.g. 'batch') reproduce the connection that was tested
         sensor_ds, sensor_weight = sensor.sample_direction(
-            si_cam, sampler.next_2d(active_found), active_found)
+            si_cam, sample_cam, active_found)
         W *= sensor_weight / sensor_ds.pdf
 
         # Include the camera ray intersection BSDF
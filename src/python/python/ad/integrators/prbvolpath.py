@@ -35,6 +35,24 @@ class PRBVolpathIntegrator(RBIntegrator):
          1, then path generation many randomly cease after encountering directly
          visible surfaces. (Default: 5)
 
+     * - freeze
+       - |bool|
+       - Record the kernels of the rendering steps once and replay them in
+         subsequent calls with new parameter values and seeds, see
+         ``RBIntegrator``. (Default: |false|)
+
+     * - max_wavefront_memory
+       - |float|
+       - Memory budget (in MiB) for the wavefront of the differential rendering
+         steps, which are split into several passes if needed, see
+         ``RBIntegrator``. (Default: 0, i.e. unlimited)
+
+     * - wavefront_lane_words
+       - |int|
+       - Estimated number of 32-bit words of state per lane of the wavefront,
+         which converts the ``max_wavefront_memory`` budget into a number of
+         lanes, see ``RBIntegrator``. (Default: 128)
+
      * - hide_emitters
        - |bool|
        - Hide directly visible emitters. (Default: no, i.e. |false|)
@@ -253,8 +271,13 @@ class PRBVolpathIntegrator(RBIntegrator):
                     emitted, ds = self.sample_emitter(mei, si, active_e_medium, active_e_surface,
                         scene, sampler, medium, channel, active_e, mode=dr.ADMode.Primal)
 
-                    # Query the BSDF for that emitter-sampled direction
-                    bsdf_val, bsdf_pdf = bsdf.eval_pdf(ctx, si, si.to_local(ds.d), active_e_surface)
+                    # Query the BSDF for that emitter-sampled direction, and
+                    # sample the next direction in the same (fused) BSDF call.
+                    # Only the BSDF value tracks derivatives.
+                    bsdf_val, bsdf_pdf, bs, bsdf_weight = bsdf.eval_pdf_sample(
+                        ctx, si, si.to_local(ds.d), sampler.next_1d(active_surface),
+                        sampler.next_2d(active_surface), active_surface)
+                    bs, bsdf_weight = dr.detach(bs), dr.detach(bsdf_weight)
                     phase_val, phase_pdf = phase.eval_pdf(phase_ctx, mei, ds.d, active_e_medium)
                     nee_weight = dr.select(active_e_surface, bsdf_val, phase_val)
                     nee_directional_pdf = dr.select(ds.delta, 0.0, dr.select(active_e_surface, bsdf_pdf, phase_pdf))
@@ -297,10 +320,11 @@ class PRBVolpathIntegrator(RBIntegrator):
                 # ------------------------ BSDF sampling -----------------------
 
                 with dr.suspend_grad():
-                    bs, bsdf_weight = bsdf.sample(ctx, si,
-                                                  sampler.next_1d(active_surface),
-                                                  sampler.next_2d(active_surface),
-                                                  active_surface)
+                    if dr.hint(not self.use_nee, mode='scalar'):
+                        bs, bsdf_weight = bsdf.sample(ctx, si,
+                                                      sampler.next_1d(active_surface),
+                                                      sampler.next_2d(active_surface),
+                                                      active_surface)
                     active_surface &= bs.pdf > 0
 
                 bsdf_eval = bsdf.eval(ctx, si, bs.wo, active_surface)
@@ -108,6 +108,42 @@ class Optimizer:
         """
         pass
 
+    def _tile_indices(self, g_p):
+        """
+        Return the indices of the entries of the tiles of the gradient ``g_p``
+        which received nonzero values, or ``None`` if it should be processed
+        densely.
+
+        Tiles consist of ``tile_size`` consecutive entries of the flattened
+        tensor (e.g. a part of a row of texels of a ``BitmapTexture``, or of
+        a row of voxels of a ``gridvolume``). Only tensor-valued parameters
+        are tiled.
+        """
+        tile_size = getattr(self, 'tile_size', 0)
+        if tile_size == 0 or not dr.is_tensor_v(g_p):
+            return None
+
+        g = g_p.array
+        n = dr.width(g)
+        UInt32 = dr.uint32_array_t(type(g))
+
+        touched = dr.zeros(dr.mask_t(type(g)), (n + tile_size - 1) // tile_size)
+        dr.scatter(touched, True, dr.arange(UInt32, n) // tile_size, g != 0)
+        tiles = dr.compress(touched)
+
+        # Expand the touched tiles into entry indices. The last tile may be
+        # incomplete, its indices past the end are clamped (and thus update
+        # the last entry several times with the same value)
+        idx = dr.arange(UInt32, dr.width(tiles) * tile_size)
+        idx = dr.fma(dr.gather(UInt32, tiles, idx // tile_size), tile_size,
+                     idx % tile_size)
+        return dr.minimum(idx, n - 1)
+
+    @staticmethod
+    def _gather_tiles(value, idx):
+        """Gather the entries ``idx`` of a (detached) tensor"""
+        return dr.gather(type(value.array), value.array, idx)
+
 
 class SGD(Optimizer):
     """
@@ -128,7 +164,8 @@ class SGD(Optimizer):
     :math:`\\varepsilon` is the learning rate, and :math:`\\mu` is
     the momentum parameter.
     """
-    def __init__(self, lr, momentum=0, mask_updates=False, params:dict=None):
+    def __init__(self, lr, momentum=0, mask_updates=False, tile_size=0,
+                 params:dict=None):
         """
         Parameter ``lr``:
             learning rate
@@ -142,13 +179,20 @@ class SGD(Optimizer):
             This only has an effect if momentum is enabled.
             See :py:class:`mitsuba.optimizers.Adam`'s documentation for more details.
 
+        Parameter ``tile_size``:
+            if nonzero, the gradients of tensor-valued parameters are processed
+            in tiles of this many consecutive entries, and only the tiles which
+            received nonzero gradients are updated.
+            See :py:class:`mitsuba.optimizers.Adam`'s documentation for more details.
+
         Parameter ``params`` (:py:class:`dict`):
             Optional dictionary-like object containing parameters to optimize.
         """
         assert momentum >= 0 and momentum < 1
-        assert lr > 0
+        assert lr > 0 and tile_size >= 0
         self.momentum = momentum
         self.mask_updates = mask_updates
+        self.tile_size = tile_size
         super().__init__(lr, params)
 
     def step(self):
@@ -159,25 +203,45 @@ class SGD(Optimizer):
             if shape == 0:
                 continue
 
-            if self.momentum != 0:
-                if shape != dr.shape(self.state[k]):
-                    # Reset state if data size has changed
-                    self.reset(k)
+            if self.momentum != 0 and shape != dr.shape(self.state[k]):
+                # Reset state if data size has changed
+                self.reset(k)
 
-                next_state = self.momentum * self.state[k] + g_p
-                step = self.lr_v[k] * self.state[k]
+            idx = self._tile_indices(g_p)
+            if idx is not None:
+                # Only process the tiles which received nonzero gradients
+                g_p = self._gather_tiles(g_p, idx)
+
+            if self.momentum != 0:
+                state = self.state[k]
+                if idx is not None:
+                    # Evaluate the gathered entries first, so that the state
+                    # can subsequently be updated in place
+                    state = self._gather_tiles(state, idx)
+                    dr.eval(g_p, state)
+
+                next_state = self.momentum * state + g_p
+                step = self.lr_v[k] * state
                 if self.mask_updates:
                     nonzero = g_p != 0.
-                    next_state = dr.select(nonzero, next_state, self.state[k])
+                    next_state = dr.select(nonzero, next_state, state)
                     step = dr.select(nonzero, step, 0)
-                self.state[k] = next_state
-                value = dr.detach(p) - step
+
+                if idx is None:
+                    self.state[k] = next_state
+                else:
+                    dr.scatter(self.state[k].array, next_state, idx)
                 dr.schedule(self.state[k])
             else:
-                value = dr.detach(p) - self.lr_v[k] * g_p
+                step = self.lr_v[k] * g_p
 
+            if idx is None:
+                value = type(p)(dr.detach(p) - step)
+            else:
+                value = type(p)(dr.detach(p))
+                dr.scatter(value.array,
+                           self._gather_tiles(value, idx) - step, idx)
 
-            value = type(p)(value)
             dr.enable_grad(value)
             self.variables[k] = value
             dr.schedule(self.variables[k])
@@ -223,9 +287,19 @@ class Adam(Optimizer):
 
     Enabling ``mask_updates`` avoids these two issues. This is similar to
     `PyTorch's SparseAdam optimizer <https://pytorch.org/docs/1.9.0/generated/torch.optim.SparseAdam.html>`_.
+
+    When only a small fraction of a large tensor-valued parameter (e.g. the
+    ``data`` of a 4K ``BitmapTexture`` or of a large ``gridvolume``) receives
+    gradients in each iteration, the optimizer can furthermore process the
+    gradient in tiles of ``tile_size`` consecutive entries (``tile_size > 0``).
+    A first pass over the gradient finds the tiles with nonzero entries, and
+    only these tiles of the state variables and of the parameter are then
+    read and updated. The state of the other tiles is left untouched, which
+    is equivalent to ``mask_updates`` at the granularity of tiles.
     """
     def __init__(self, lr, beta_1=0.9, beta_2=0.999, epsilon=1e-8,
-                 mask_updates=False, uniform=False, params: dict=None):
+                 mask_updates=False, uniform=False, tile_size=0,
+                 params: dict=None):
         """
         Parameter ``lr``:
             learning rate
@@ -246,17 +320,23 @@ class Adam(Optimizer):
             the second moment estimates at the current step instead of the
             per-element second moments.
 
+        Parameter ``tile_size``:
+            if nonzero, the gradients of tensor-valued parameters are processed
+            in tiles of this many consecutive entries, and only the tiles which
+            received nonzero gradients are updated (see above).
+
         Parameter ``params`` (:py:class:`dict`):
             Optional dictionary-like object containing parameters to optimize.
         """
         assert 0 <= beta_1 < 1 and 0 <= beta_2 < 1 \
-            and lr > 0 and epsilon > 0
+            and lr > 0 and epsilon > 0 and tile_size >= 0
 
         self.beta_1 = beta_1
         self.beta_2 = beta_2
         self.epsilon = epsilon
         self.mask_updates = mask_updates
         self.uniform = uniform
+        self.tile_size = tile_size
         self.t = defaultdict(lambda: 0)
         super().__init__(lr, params)
 
@@ -278,23 +358,44 @@ class Adam(Optimizer):
                 self.reset(k)
 
             m_tp, v_tp = self.state[k]
+            idx = self._tile_indices(g_p)
+            if idx is not None:
+                # Only process the tiles which received nonzero gradients
+                g_p = self._gather_tiles(g_p, idx)
+                m_tp = self._gather_tiles(m_tp, idx)
+                v_tp = self._gather_tiles(v_tp, idx)
+                # Evaluate the gathered entries first, so that the state
+                # can subsequently be updated in place
+                dr.eval(g_p, m_tp, v_tp)
+
             m_t = self.beta_1 * m_tp + (1 - self.beta_1) * g_p
             v_t = self.beta_2 * v_tp + (1 - self.beta_2) * dr.square(g_p)
             if self.mask_updates:
                 nonzero = g_p != 0.
                 m_t = dr.select(nonzero, m_t, m_tp)
                 v_t = dr.select(nonzero, v_t, v_tp)
-            self.state[k] = (m_t, v_t)
+
+            if idx is None:
+                self.state[k] = (m_t, v_t)
+                v_max = v_t
+            else:
+                dr.scatter(self.state[k][0].array, m_t, idx)
+                dr.scatter(self.state[k][1].array, v_t, idx)
+                v_max = self.state[k][1].array
             dr.schedule(self.state[k])
 
             if self.uniform:
-                step = lr_t * m_t / (dr.sqrt(dr.max(v_t)) + self.epsilon)
+                step = lr_t * m_t / (dr.sqrt(dr.max(v_max)) + self.epsilon)
             else:
                 step = lr_t * m_t / (dr.sqrt(v_t) + self.epsilon)
             if self.mask_updates:
                 step = dr.select(nonzero, step, 0.)
-            u = dr.detach(p) - step
-            u = type(p)(u)
+
+            if idx is None:
+                u = type(p)(dr.detach(p) - step)
+            else:
+                u = type(p)(dr.detach(p))
+                dr.scatter(u.array, self._gather_tiles(u, idx) - step, idx)
             dr.enable_grad(u)
             self.variables[k] = u
             dr.schedule(self.variables[k])
@@ -0,0 +1,5 @@
+from .common import BenchmarkResult, measure, environment, write_json
+from . import micro
+from . import scene
+from . import rays
+from . import replay
@@ -0,0 +1,123 @@
+from __future__ import annotations # Delayed parsing of type annotations
+
+import json
+import platform
+import statistics
+import time
+from typing import Callable, List, Optional
+
+import drjit as dr
+import mitsuba as mi
+
+
+class BenchmarkResult:
+    """
+    Timings of a single benchmark in a specific variant.
+
+    The throughput is reported in items (e.g. evaluated samples, traced rays)
+    per second, based on the median of the repeated measurements.
+    """
+
+    def __init__(self, name: str, variant: str, items: int,
+                 times: List[float], **extra):
+        self.name = name
+        self.variant = variant
+        self.items = items
+        self.times = times
+        self.extra = extra
+
+    @property
+    def median(self) -> float:
+        return statistics.median(self.times)
+
+    @property
+    def throughput(self) -> float:
+        return self.items / max(self.median, 1e-12)
+
+    def to_dict(self) -> dict:
+        return {
+            'name': self.name,
+            'variant': self.variant,
+            'items': self.items,
+            'median': self.median,
+            'min': min(self.times),
+            'max': max(self.times),
+            'throughput': self.throughput,
+            **self.extra
+        }
+
+    def __repr__(self) -> str:
+        return '%-50s %-20s %12.3f ms %14.4g items/s' % (
+            self.name, self.variant, self.median * 1000, self.throughput)
+
+
+def is_jit() -> bool:
+    '''Does the current variant use a JIT (LLVM/CUDA) backend?'''
+    return dr.is_jit_v(mi.Float)
+
+
+def measure(func: Callable, repeat: int = 10, warmup: int = 2) -> List[float]:
+    """
+    Measure the wall-clock time of ``func()`` in seconds.
+
+    In JIT variants, the outputs returned by ``func()`` are evaluated and the
+    device is synchronized before the time is taken, so the measurements
+    include tracing, kernel launches and their execution. The warmup calls
+    populate the kernel cache, so the measurements don't include kernel
+    compilation.
+
+    Parameter ``func`` (``Callable``):
+        Function to benchmark.
+
+    Parameter ``repeat`` (``int``):
+        Number of measurements.
+
+    Parameter ``warmup`` (``int``):
+        Number of calls before the measurements start.
+    """
+    jit = is_jit()
+
+    def run():
+        result = func()
+        if jit:
+            dr.eval(result)
+            dr.sync_thread()
+
+    for _ in range(warmup):
+        run()
+
+    times = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        run()
+        times.append(time.perf_counter() - start)
+    return times
+
+
+def environment() -> dict:
+    '''Describe the machine and the versions of Mitsuba and Dr.Jit'''
+    return {
+        'mitsuba': mi.MI_VERSION,
+        'drjit': dr.__version__,
+        'python': platform.python_version(),
+        'platform': platform.platform(),
+        'processor': platform.processor(),
+        'threads': mi.Thread.thread_count(),
+    }
+
+
+def write_json(path: str, results: List[BenchmarkResult],
+               **metadata) -> None:
+    """
+    Write benchmark results to a JSON file.
+
+    The file contains a description of the environment, the ``metadata``
+    passed to this function, and the list of results (see
+    :py:meth:`BenchmarkResult.to_dict()`).
+    """
+    with open(path, 'w') as f:
+        json.dump({
+            'environment': environment(),
+            **metadata,
+            'results': [r.to_dict() for r in results]
+        }, f, indent=2)
@@ -0,0 +1,358 @@
+"""
+Micro-benchmarks of individual kernels (warps, distributions, BSDFs,
+textures, image blocks and ray intersections).
+
+Each benchmark is registered with :py:func:`micro_benchmark` and consists of
+a *setup* function that receives the number of work items ``n`` and returns a
+closure performing the actual work. In JIT variants, this closure processes
+all ``n`` items at once, and its outputs are evaluated by
+:py:func:`mitsuba.benchmark.measure`. In scalar variants, the closure is
+called ``n`` times in a Python loop, hence the measurements then include the
+overhead of the Python bindings (those results are flagged with
+``python_loop``).
+
+The suite can be run from the command line, e.g.
+
+.. code-block:: bash
+
+    python -m mitsuba.python.benchmark.micro -m llvm_ad_rgb -f warp -o out.json
+"""
+
+from __future__ import annotations # Delayed parsing of type annotations
+
+import fnmatch
+from typing import Callable, List, Optional
+
+import drjit as dr
+import mitsuba as mi
+
+from .common import BenchmarkResult, is_jit, measure, write_json
+
+_registry = {}
+
+
+def micro_benchmark(name: str, variants: Optional[str] = None):
+    """
+    Decorator that registers a micro-benchmark.
+
+    Parameter ``name`` (``str``):
+        Hierarchical name of the benchmark (e.g. ``warp.square_to_uniform_disk``)
+
+    Parameter ``variants`` (``str``):
+        Optional ``fnmatch`` pattern of the variants supported by the benchmark.
+    """
+    def decorator(setup):
+        _registry[name] = (setup, variants)
+        return setup
+    return decorator
+
+
+def benchmarks() -> List[str]:
+    '''Return the names of all registered micro-benchmarks'''
+    return sorted(_registry.keys())
+
+
+def _samples(n: int, dim: int = 2, seed: int = 0):
+    '''Uniformly distributed sample(s) of the given dimension'''
+    rng = mi.PCG32(size=n if is_jit() else 1, initstate=seed)
+    values = [rng.next_float32() for _ in range(dim)]
+    if not is_jit():
+        values = [v[0] if dr.is_array_v(v) else v for v in values]
+    if dim == 1:
+        return values[0]
+    return (mi.Point2f if dim == 2 else mi.Point3f)(*values)
+
+
+def _kernel(n: int, func: Callable, *args) -> Callable:
+    '''Process ``n`` work items, looping in Python for scalar variants'''
+    if is_jit():
+        return lambda: func(*args)
+
+    def loop():
+        for _ in range(n):
+            result = func(*args)
+        return result
+    return loop
+
+
+# --------------------------------------------------------------------------
+#  Warps
+# --------------------------------------------------------------------------
+
+def _register_warp(name, *extra):
+    def setup(n):
+        return _kernel(n, getattr(mi.warp, name), _samples(n), *extra)
+    micro_benchmark('warp.' + name)(setup)
+    def setup_pdf(n):
+        return _kernel(n, getattr(mi.warp, name + '_pdf'),
+                       getattr(mi.warp, name)(_samples(n), *extra), *extra)
+    micro_benchmark('warp.%s_pdf' % name)(setup_pdf)
+
+
+for _name in ['square_to_uniform_disk', 'square_to_uniform_disk_concentric',
+              'square_to_uniform_sphere', 'square_to_uniform_hemisphere',
+              'square_to_cosine_hemisphere', 'square_to_uniform_triangle',
+              'square_to_std_normal']:
+    _register_warp(_name)
+
+_register_warp('square_to_uniform_cone', 0.5)
+_register_warp('square_to_beckmann', 0.3)
+_register_warp('square_to_von_mises_fisher', 10.0)
+
+
+# --------------------------------------------------------------------------
+#  Distributions
+# --------------------------------------------------------------------------
+
+def _pdf_1d(size=1024):
+    import numpy as np
+    x = np.linspace(0, 1, size)
+    return np.exp(-((x - 0.5) / 0.1) ** 2) + 0.1
+
+
+def _pdf_2d(size=256):
+    import numpy as np
+    x, y = np.meshgrid(np.linspace(0, 1, size), np.linspace(0, 1, size))
+    return (np.exp(-((x - 0.5) ** 2 + (y - 0.3) ** 2) / 0.02) + 0.1).astype(np.float32)
+
+
+@micro_benchmark('distr.DiscreteDistribution.sample')
+def _(n):
+    distr = mi.DiscreteDistribution(_pdf_1d())
+    return _kernel(n, distr.sample, _samples(n, 1))
+
+
+@micro_benchmark('distr.ContinuousDistribution.sample')
+def _(n):
+    distr = mi.ContinuousDistribution([0, 1], _pdf_1d())
+    return _kernel(n, distr.sample, _samples(n, 1))
+
+
+@micro_benchmark('distr.Hierarchical2D0.sample')
+def _(n):
+    distr = mi.Hierarchical2D0(_pdf_2d())
+    return _kernel(n, distr.sample, _samples(n))
+
+
+@micro_benchmark('distr.MarginalDiscrete2D0.sample')
+def _(n):
+    distr = mi.MarginalDiscrete2D0(_pdf_2d())
+    return _kernel(n, distr.sample, _samples(n))
+
+
+@micro_benchmark('distr.MarginalContinuous2D0.sample')
+def _(n):
+    distr = mi.MarginalContinuous2D0(_pdf_2d())
+    return _kernel(n, distr.sample, _samples(n))
+
+
+# --------------------------------------------------------------------------
+#  BSDFs
+# --------------------------------------------------------------------------
+
+_bsdfs = {
+    'diffuse':        {'type': 'diffuse'},
+    'dielectric':     {'type': 'dielectric'},
+    'conductor':      {'type': 'conductor'},
+    'roughconductor': {'type': 'roughconductor', 'alpha': 0.2},
+    'plastic':        {'type': 'plastic'},
+    'roughplastic':   {'type': 'roughplastic', 'alpha': 0.2},
+    'principled':     {'type': 'principled', 'roughness': 0.3, 'metallic': 0.5},
+}
+
+
+def _surface_interaction(n):
+    si = dr.zeros(mi.SurfaceInteraction3f, n if is_jit() else 1)
+    si.wi = mi.warp.square_to_cosine_hemisphere(_samples(n, seed=1))
+    si.n = mi.Normal3f(0, 0, 1)
+    si.sh_frame = mi.Frame3f(si.n)
+    si.uv = _samples(n, seed=2)
+    if mi.is_spectral:
+        si.wavelengths = mi.sample_rgb_spectrum(
+            mi.sample_shifted(_samples(n, 1, seed=3)))[0]
+    return si
+
+
+def _register_bsdf(name, desc):
+    def setup_sample(n):
+        bsdf = mi.load_dict(desc)
+        ctx, si = mi.BSDFContext(), _surface_interaction(n)
+        return _kernel(n, bsdf.sample, ctx, si, _samples(n, 1, seed=4),
+                       _samples(n, seed=5))
+    micro_benchmark('bsdf.%s.sample' % name)(setup_sample)
+
+    def setup_eval(n):
+        bsdf = mi.load_dict(desc)
+        ctx, si = mi.BSDFContext(), _surface_interaction(n)
+        wo = mi.warp.square_to_cosine_hemisphere(_samples(n, seed=6))
+        return _kernel(n, bsdf.eval, ctx, si, wo)
+    micro_benchmark('bsdf.%s.eval' % name)(setup_eval)
+
+
+for _name, _desc in _bsdfs.items():
+    _register_bsdf(_name, _desc)
+
+
+# --------------------------------------------------------------------------
+#  Textures and image blocks
+# --------------------------------------------------------------------------
+
+@micro_benchmark('texture.bitmap.eval')
+def _(n):
+    import numpy as np
+    data = np.random.default_rng(0).random((512, 512, 3), dtype=np.float32)
+    texture = mi.load_dict({'type': 'bitmap', 'data': mi.TensorXf(data),
+                            'raw': True})
+    si = _surface_interaction(n)
+    return _kernel(n, texture.eval, si)
+
+
+@micro_benchmark('imageblock.put')
+def _(n):
+    size = mi.ScalarVector2u(256, 256)
+    rfilter = mi.load_dict({'type': 'gaussian'})
+    block = mi.ImageBlock(size, [0, 0], 4, rfilter=rfilter)
+    pos = _samples(n) * mi.ScalarVector2f(size)
+    values = [mi.Float(1), mi.Float(0.5), mi.Float(0.25), mi.Float(1)]
+
+    if is_jit():
+        def kernel():
+            block.put(pos=pos, values=values)
+            return block.tensor()
+        return kernel
+    return _kernel(n, lambda: block.put(pos=pos, values=values))
+
+
+# --------------------------------------------------------------------------
+#  Ray intersection
+# --------------------------------------------------------------------------
+
+_shapes = ['sphere', 'rectangle', 'cube', 'disk', 'cylinder']
+
+
+def _rays(n):
+    '''Rays starting on a sphere of radius 3, aimed near the origin'''
+    o = mi.warp.square_to_uniform_sphere(_samples(n, seed=7)) * 3
+    target = (_samples(n, 3, seed=8) - 0.5) * 0.5
+    return mi.Ray3f(o, dr.normalize(target - o))
+
+
+def _register_shape(shape):
+    def make_setup(method):
+        def setup(n):
+            scene = mi.load_dict({'type': 'scene', 'shape': {'type': shape}})
+            return _kernel(n, getattr(scene, method), _rays(n))
+        return setup
+
+    for method in ['ray_intersect', 'ray_intersect_preliminary', 'ray_test']:
+        micro_benchmark('shape.%s.%s' % (shape, method))(make_setup(method))
+
+
+for _name in _shapes:
+    _register_shape(_name)
+
+
+# --------------------------------------------------------------------------
+#  Driver
+# --------------------------------------------------------------------------
+
+def run(variants: Optional[List[str]] = None, filter: str = '*',
+        size: int = 2**20, scalar_size: int = 1024, repeat: int = 10,
+        warmup: int = 2, output: Optional[str] = None,
+        verbose: bool = True) -> List[BenchmarkResult]:
+    """
+    Run the micro-benchmarks.
+
+    Parameter ``variants`` (``List[str]``):
+        Variants to benchmark. Defaults to the current variant.
+
+    Parameter ``filter`` (``str``):
+        ``fnmatch`` pattern that selects the benchmarks by name. A pattern
+        without wildcards matches all benchmarks that contain it.
+
+    Parameter ``size`` (``int``):
+        Number of work items processed by the JIT variants.
+
+    Parameter ``scalar_size`` (``int``):
+        Number of work items processed by the scalar variants.
+
+    Parameter ``repeat`` (``int``):
+        Number of measurements per benchmark.
+
+    Parameter ``warmup`` (``int``):
+        Number of untimed runs preceding the measurements.
+
+    Parameter ``output`` (``str``):
+        Optional path of a JSON file where the results are written.
+
+    Parameter ``verbose`` (``bool``):
+        Print each result once it is available.
+    """
+    if variants is None:
+        variants = [mi.variant()]
+    if not any(c in filter for c in '*?['):
+        filter = '*%s*' % filter
+
+    results = []
+    for variant in variants:
+        with mi.variant_context(variant):
+            n = size if is_jit() else scalar_size
+            for name in benchmarks():
+                setup, supported = _registry[name]
+                if not fnmatch.fnmatch(name, filter):
+                    continue
+                if supported is not None and not fnmatch.fnmatch(variant, supported):
+                    continue
+
+                kernel = setup(n)
+                times = measure(kernel, repeat=repeat, warmup=warmup)
+                result = BenchmarkResult(name, variant, n, times,
+                                         python_loop=not is_jit())
+                if verbose:
+                    print(result)
+                results.append(result)
+
+    if output is not None:
+        write_json(output, results, suite='micro')
+
+    return results
+
+
+def main(args=None):
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        prog='python -m mitsuba.python.benchmark.micro',
+        description='Run the Mitsuba micro-benchmark suite.')
+    parser.add_argument('-m', '--variant', action='append', dest='variants',
+                        help='variant to benchmark (can be repeated)')
+    parser.add_argument('-f', '--filter', default='*',
+                        help='only run benchmarks matching this pattern')
+    parser.add_argument('-n', '--size', type=int, default=2**20,
+                        help='work items per JIT kernel (default: 2^20)')
+    parser.add_argument('-s', '--scalar-size', type=int, default=1024,
+                        help='work items per scalar benchmark (default: 1024)')
+    parser.add_argument('-r', '--repeat', type=int, default=10,
+                        help='number of measurements (default: 10)')
+    parser.add_argument('-o', '--output', help='write the results to a JSON file')
+    parser.add_argument('-l', '--list', action='store_true',
+                        help='list the benchmarks and exit')
+    args = parser.parse_args(args)
+
+    if args.list:
+        print('\n'.join(benchmarks()))
+        return
+
+    variants = args.variants
+    if variants is None:
+        variants = [v for v in mi.variants()
+                    if v in ('scalar_rgb', 'llvm_ad_rgb', 'cuda_ad_rgb')]
+        if not variants:
+            variants = [mi.variants()[0]]
+
+    run(variants, filter=args.filter, size=args.size,
+        scalar_size=args.scalar_size, repeat=args.repeat, output=args.output)
+
+
+if __name__ == '__main__':
+    main()
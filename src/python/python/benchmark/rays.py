@@ -0,0 +1,261 @@
+"""
+Ray throughput of the acceleration data structures.
+
+This module times :py:meth:`mitsuba.Scene.ray_intersect_preliminary` and
+:py:meth:`mitsuba.Scene.ray_test` on three kinds of ray batches generated for
+a loaded scene:
+
+- ``primary``: coherent camera rays through every pixel of the film,
+- ``diffuse``: incoherent rays leaving the primary hits in cosine-weighted
+  random directions,
+- ``shadow``: finite rays connecting the primary hits to sampled points on
+  the emitters.
+
+The acceleration data structure is selected by the variant and the build:
+CUDA variants use OptiX, while CPU variants use Embree when Mitsuba was
+compiled with ``MI_ENABLE_EMBREE``, and otherwise the native kd-tree or one
+of the BVHs (see the ``accel`` parameter of the scene). The ``kdtree_compact``
+backend is the kd-tree with the compact node layout (see the ``kd_compact``
+parameter of the scene). The backends of the current variant are returned by
+:py:func:`backends`. Every result also reports the memory used by the
+acceleration data structure. Comparing e.g. the
+kd-tree against Embree therefore requires running this benchmark with two
+builds of Mitsuba and comparing their JSON output.
+
+The suite can be run from the command line, e.g.
+
+.. code-block:: bash
+
+    python -m mitsuba.python.benchmark.rays -m llvm_ad_rgb -m cuda_ad_rgb scene.xml
+"""
+
+from __future__ import annotations # Delayed parsing of type annotations
+
+import time
+from typing import List, Optional
+
+import drjit as dr
+import mitsuba as mi
+
+from .common import BenchmarkResult, is_jit, measure, write_json
+from . import scene as scene_benchmark
+
+
+def backends() -> List[str]:
+    '''Return the acceleration data structures available in the current variant'''
+    if dr.is_cuda_v(mi.Float):
+        return ['optix']
+    if mi.MI_ENABLE_EMBREE:
+        return ['embree']
+    return ['kdtree', 'kdtree_compact', 'bvh4', 'bvh8']
+
+
+def build(scene: mi.Scene, backend: str):
+    """
+    Rebuild the top-level acceleration data structure of a scene using the
+    given backend (see :py:func:`backends`).
+
+    Returns the new scene and the build time in seconds.
+    """
+    desc = {'type': 'scene'}
+    if backend == 'kdtree_compact':
+        desc['accel'] = 'kdtree'
+        desc['kd_compact'] = True
+    elif backend in ('kdtree', 'bvh4', 'bvh8'):
+        desc['accel'] = backend
+    for i, sensor in enumerate(scene.sensors()):
+        desc['sensor_%i' % i] = sensor
+    for i, shape in enumerate(scene.shapes()):
+        desc['shape_%i' % i] = shape
+
+    start = time.perf_counter()
+    result = mi.load_dict(desc)
+    dr.sync_thread()
+    return result, time.perf_counter() - start
+
+
+def _generate(scene: mi.Scene, pos, sample1, sample2):
+    '''Generate the rays of all batches for the given film positions'''
+    sensor = scene.sensors()[0]
+    primary, _ = sensor.sample_ray(0, sample1, pos, mi.Point2f(0.5))
+    si = scene.ray_intersect(primary)
+    valid = si.is_valid()
+
+    wo = mi.warp.square_to_cosine_hemisphere(sample2)
+    diffuse = si.spawn_ray(si.to_world(wo))
+
+    ds, _ = scene.sample_emitter_direction(si, sample2, False, valid)
+    shadow = si.spawn_ray_to(ds.p)
+
+    return {
+        'primary': (primary, True),
+        'diffuse': (diffuse, valid),
+        'shadow': (shadow, valid & (ds.pdf > 0))
+    }
+
+
+def ray_batches(scene: mi.Scene, scalar_rays: int = 4096, seed: int = 0):
+    """
+    Generate the primary, diffuse and shadow ray batches of a scene.
+
+    In JIT variants, every batch is a single ``Ray3f`` wavefront containing
+    the rays of all pixels of the film (discarding the diffuse and shadow
+    rays of primary rays that missed). In scalar variants, every batch is a
+    list of at most ``scalar_rays`` individual rays.
+    """
+    film_size = scene.sensors()[0].film().crop_size()
+
+    if is_jit():
+        count = int(dr.prod(film_size))
+        idx = dr.arange(mi.UInt32, count)
+        pos = mi.Point2f(mi.Float(idx % film_size[0]) + 0.5,
+                         mi.Float(idx // film_size[0]) + 0.5)
+        pos /= mi.ScalarVector2f(film_size)
+        rng = mi.PCG32(size=count, initstate=seed)
+        sample1 = rng.next_float32()
+        sample2 = mi.Point2f(rng.next_float32(), rng.next_float32())
+
+        batches = {}
+        for kind, (ray, valid) in _generate(scene, pos, sample1, sample2).items():
+            if valid is not True:
+                ray = dr.gather(mi.Ray3f, ray, dr.compress(valid))
+            dr.eval(ray)
+            batches[kind] = ray
+        return batches
+
+    rng = mi.PCG32(initstate=seed)
+    batches = {'primary': [], 'diffuse': [], 'shadow': []}
+    for i in range(scalar_rays):
+        pos = mi.Point2f(rng.next_float32(), rng.next_float32())
+        sample2 = mi.Point2f(rng.next_float32(), rng.next_float32())
+        for kind, (ray, valid) in _generate(scene, pos, rng.next_float32(),
+                                            sample2).items():
+            if valid:
+                batches[kind].append(ray)
+    return batches
+
+
+def _accel_memory() -> int:
+    '''Memory used by all acceleration data structures (in bytes)'''
+    return sum(mi.MemoryTracker.usage(category) for category in [
+        mi.MemoryCategory.KDTree, mi.MemoryCategory.Embree,
+        mi.MemoryCategory.OptiX])
+
+
+def _count(rays) -> int:
+    return len(rays) if isinstance(rays, list) else dr.width(rays)
+
+
+def run_scene(name: str, resolution: int = 512, scalar_rays: int = 4096,
+              repeat: int = 5, verbose: bool = True) -> List[BenchmarkResult]:
+    """
+    Benchmark the ray throughput of all backends of the current variant.
+
+    Parameter ``name`` (``str``):
+        Name of a reference scene (see :py:func:`mitsuba.benchmark.scene.scenes`)
+        or path of a scene file.
+
+    Parameter ``resolution`` (``int``):
+        Film resolution of the reference scenes, which determines the number
+        of rays in JIT variants.
+
+    Parameter ``scalar_rays`` (``int``):
+        Number of rays per batch in scalar variants.
+
+    Parameter ``repeat`` (``int``):
+        Number of measurements per query.
+    """
+    loaded = scene_benchmark.load(name, resolution)
+
+    results = []
+    for backend in backends():
+        memory = _accel_memory()
+        scene, build_time = build(loaded, backend)
+        memory = _accel_memory() - memory
+        for kind, rays in ray_batches(scene, scalar_rays).items():
+            count = _count(rays)
+            if count == 0:
+                continue
+            coherent = kind == 'primary'
+
+            for query in ['ray_intersect_preliminary', 'ray_test']:
+                func = getattr(scene, query)
+                if is_jit():
+                    kernel = lambda: func(rays, coherent)
+                else:
+                    def kernel():
+                        for ray in rays:
+                            func(ray, coherent)
+                times = measure(kernel, repeat=repeat, warmup=1)
+
+                result = BenchmarkResult(
+                    'rays.%s.%s.%s' % (name, kind, query), mi.variant(),
+                    count, times, backend=backend, kind=kind, query=query,
+                    build_time=build_time, accel_memory=memory,
+                    python_loop=not is_jit())
+                result.extra['mrays_per_second'] = result.throughput * 1e-6
+                if verbose:
+                    print('%s [%s]' % (result, backend))
+                results.append(result)
+
+    return results
+
+
+def run(variants: Optional[List[str]] = None,
+        scenes: Optional[List[str]] = None, resolution: int = 512,
+        repeat: int = 5, output: Optional[str] = None,
+        verbose: bool = True) -> List[BenchmarkResult]:
+    """
+    Benchmark the ray throughput of a list of scenes in a list of variants.
+
+    Parameter ``variants`` (``List[str]``):
+        Variants to benchmark. Defaults to the current variant.
+
+    Parameter ``scenes`` (``List[str]``):
+        Reference scenes or scene files. Defaults to all reference scenes.
+
+    Parameter ``output`` (``str``):
+        Optional path of a JSON file where the results are written.
+    """
+    if variants is None:
+        variants = [mi.variant()]
+    if scenes is None:
+        scenes = scene_benchmark.scenes()
+
+    results = []
+    for variant in variants:
+        with mi.variant_context(variant):
+            for name in scenes:
+                results += run_scene(name, resolution=resolution,
+                                     repeat=repeat, verbose=verbose)
+
+    if output is not None:
+        write_json(output, results, suite='rays')
+
+    return results
+
+
+def main(args=None):
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        prog='python -m mitsuba.python.benchmark.rays',
+        description='Measure the ray throughput of the acceleration data structures.')
+    parser.add_argument('scenes', nargs='*',
+                        help='reference scenes or scene files (default: all '
+                             'reference scenes)')
+    parser.add_argument('-m', '--variant', action='append', dest='variants',
+                        help='variant to benchmark (can be repeated)')
+    parser.add_argument('-r', '--resolution', type=int, default=512,
+                        help='film resolution of the reference scenes (default: 512)')
+    parser.add_argument('-n', '--repeat', type=int, default=5,
+                        help='number of measurements (default: 5)')
+    parser.add_argument('-o', '--output', help='write the results to a JSON file')
+    args = parser.parse_args(args)
+
+    run(args.variants or [mi.variants()[0]], scenes=args.scenes or None,
+        resolution=args.resolution, repeat=args.repeat, output=args.output)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,340 @@
+"""
+Replay of captured rays against the acceleration data structures.
+
+Full renderings are noisy and slow to compare when tuning the acceleration
+data structures. Instead, :py:class:`mitsuba.RayCapture` can record the rays
+traced by the render jobs of a scene into a compact binary file, e.g.
+
+.. code-block:: python
+
+    mi.RayCapture.start('rays.mrc', interval=4)
+    for i in range(16):
+        mi.render(scene, seed=i)
+    mi.RayCapture.stop()
+
+This module loads such a file along with the scene, and times only the
+traversal of the acceleration data structures on this fixed set of rays:
+:py:meth:`mitsuba.Scene.ray_intersect_preliminary` for the extension rays,
+which are split into a coherent and an incoherent batch according to how
+they were originally traced, and :py:meth:`mitsuba.Scene.ray_test` for the
+shadow rays. The backends are those of :py:func:`mitsuba.benchmark.rays.backends`.
+
+As a correctness check, the hits of every backend are compared against a
+reference: the results of the first backend that was replayed, or those
+written to a ``.npz`` file by a previous run (e.g. of another build of
+Mitsuba). Rays whose hit status differs, or whose hit distances differ by
+more than a relative tolerance, are reported as mismatches.
+
+The replay can also be run from the command line, e.g.
+
+.. code-block:: bash
+
+    python -m mitsuba.python.benchmark.replay -m llvm_ad_rgb -m cuda_ad_rgb \\
+        scene.xml rays.mrc --save hits.npz
+"""
+
+from __future__ import annotations # Delayed parsing of type annotations
+
+import struct
+from typing import Dict, List, Optional, Tuple
+
+import drjit as dr
+import mitsuba as mi
+
+from .common import BenchmarkResult, is_jit, measure, write_json
+from . import rays as rays_benchmark
+from . import scene as scene_benchmark
+
+#: Flags of the ``info`` field of captured rays (see :py:class:`mitsuba.RayCapture`)
+DEPTH_MASK = 0xFFFF
+SHADOW_RAY = 1 << 30
+COHERENT_RAY = 1 << 31
+
+
+def _record_dtype():
+    import numpy as np
+    return np.dtype([('o', '<f4', 3), ('d', '<f4', 3), ('maxt', '<f4'),
+                     ('info', '<u4')])
+
+
+def load(filename: str) -> List[Tuple[int, 'numpy.ndarray']]:
+    """
+    Load a file written by :py:class:`mitsuba.RayCapture`.
+
+    Returns the list of recorded render jobs as pairs of the index of the job
+    and a structured NumPy array of its rays, whose fields are ``o``, ``d``,
+    ``maxt`` and ``info``.
+    """
+    import numpy as np
+
+    with open(filename, 'rb') as f:
+        data = f.read()
+    if data[:3] != b'MRC' or len(data) < 4 or data[3] != 1:
+        raise ValueError('load(): "%s" is not a valid ray capture file!' % filename)
+
+    dtype = _record_dtype()
+    jobs, pos = [], 4
+    while pos < len(data):
+        if pos + 12 > len(data):
+            raise ValueError('load(): "%s" is truncated!' % filename)
+        job, count = struct.unpack_from('<IQ', data, pos)
+        pos += 12
+        if pos + count * dtype.itemsize > len(data):
+            raise ValueError('load(): "%s" is truncated!' % filename)
+        jobs.append((job, np.frombuffer(data, dtype=dtype, count=count,
+                                        offset=pos)))
+        pos += count * dtype.itemsize
+    return jobs
+
+
+def split(records: 'numpy.ndarray') -> Dict[str, 'numpy.ndarray']:
+    """
+    Split captured rays into the ``coherent`` and ``incoherent`` extension
+    rays and the ``shadow`` rays.
+    """
+    shadow = (records['info'] & SHADOW_RAY) != 0
+    coherent = (records['info'] & COHERENT_RAY) != 0
+    return {
+        'coherent': records[~shadow & coherent],
+        'incoherent': records[~shadow & ~coherent],
+        'shadow': records[shadow]
+    }
+
+
+def depth(records: 'numpy.ndarray') -> 'numpy.ndarray':
+    '''Return the path depth of captured rays'''
+    return records['info'] & DEPTH_MASK
+
+
+def to_rays(records: 'numpy.ndarray'):
+    """
+    Convert captured rays to a ``Ray3f`` wavefront in JIT variants, and to a
+    list of individual rays in scalar variants.
+    """
+    o, d, maxt = records['o'], records['d'], records['maxt']
+
+    if is_jit():
+        ray = mi.Ray3f(mi.Point3f(*[mi.Float(o[:, i].copy()) for i in range(3)]),
+                       mi.Vector3f(*[mi.Float(d[:, i].copy()) for i in range(3)]))
+        ray.maxt = mi.Float(maxt.copy())
+        dr.eval(ray)
+        return ray
+
+    result = []
+    for i in range(len(records)):
+        ray = mi.Ray3f(mi.Point3f(*[float(v) for v in o[i]]),
+                       mi.Vector3f(*[float(v) for v in d[i]]))
+        ray.maxt = float(maxt[i])
+        result.append(ray)
+    return result
+
+
+def _query(kind: str) -> Tuple[str, bool]:
+    '''Return the traversal query of a batch and whether it is coherent'''
+    if kind == 'shadow':
+        return 'ray_test', False
+    return 'ray_intersect_preliminary', kind == 'coherent'
+
+
+def hits(scene: mi.Scene, kind: str, rays) -> 'numpy.ndarray':
+    """
+    Trace a batch of rays (see :py:func:`to_rays`) and return the hit
+    distances of extension rays (``inf`` when they escape) or whether the
+    shadow rays are occluded.
+    """
+    import numpy as np
+
+    query, coherent = _query(kind)
+    func = getattr(scene, query)
+
+    def result(value):
+        if kind == 'shadow':
+            return value
+        return dr.select(value.is_valid(), value.t, dr.inf)
+
+    if is_jit():
+        value = result(func(rays, coherent))
+        dr.eval(value)
+        return np.array(value.numpy(), copy=True)
+
+    return np.array([result(func(ray, coherent)) for ray in rays],
+                    dtype=bool if kind == 'shadow' else np.float32)
+
+
+def mismatches(kind: str, values: 'numpy.ndarray', reference: 'numpy.ndarray',
+               rtol: float = 1e-3) -> int:
+    """
+    Count the rays whose results differ from a reference: shadow rays whose
+    occlusion differs, and extension rays whose hit status differs or whose
+    hit distances differ by more than ``rtol`` (relative to the distance).
+    """
+    import numpy as np
+
+    if values.shape != reference.shape:
+        raise ValueError('mismatches(): expected %i results, got %i!'
+                         % (len(reference), len(values)))
+    if kind == 'shadow':
+        return int(np.count_nonzero(values != reference))
+
+    hit, hit_ref = np.isfinite(values), np.isfinite(reference)
+    both = hit & hit_ref
+    far = np.abs(values[both] - reference[both]) > \
+        rtol * np.maximum(np.abs(reference[both]), 1)
+    return int(np.count_nonzero(hit != hit_ref) + np.count_nonzero(far))
+
+
+def _count(rays) -> int:
+    return len(rays) if isinstance(rays, list) else dr.width(rays)
+
+
+def run_scene(name: str, filename: str, job: Optional[int] = None,
+              repeat: int = 5, reference: Optional[dict] = None,
+              rtol: float = 1e-3, verbose: bool = True
+              ) -> Tuple[List[BenchmarkResult], dict]:
+    """
+    Replay the captured rays of a scene on all backends of the current variant.
+
+    Parameter ``name`` (``str``):
+        Name of a reference scene (see :py:func:`mitsuba.benchmark.scene.scenes`)
+        or path of a scene file.
+
+    Parameter ``filename`` (``str``):
+        Capture file written by :py:class:`mitsuba.RayCapture`.
+
+    Parameter ``job`` (``int``):
+        Index of the recorded render job to replay. Defaults to all of them.
+
+    Parameter ``reference`` (``dict``):
+        Reference results of every batch (see :py:func:`hits`). Defaults to
+        the results of the first backend.
+
+    Parameter ``rtol`` (``float``):
+        Relative tolerance of the hit distances.
+
+    Returns the results and the reference, which every result reports the
+    number of mismatches against (in ``extra['mismatches']``).
+    """
+    import numpy as np
+
+    jobs = load(filename)
+    if job is not None:
+        jobs = [(i, r) for i, r in jobs if i == job]
+        if not jobs:
+            raise ValueError('run_scene(): "%s" does not contain render job %i!'
+                             % (filename, job))
+    records = np.concatenate([r for _, r in jobs]) if jobs else \
+        np.zeros(0, dtype=_record_dtype())
+
+    loaded = scene_benchmark.load(name)
+    batches = {kind: to_rays(r) for kind, r in split(records).items() if len(r) > 0}
+    reference = dict(reference) if reference is not None else {}
+
+    results = []
+    for backend in rays_benchmark.backends():
+        scene, build_time = rays_benchmark.build(loaded, backend)
+        for kind, rays in batches.items():
+            query, coherent = _query(kind)
+            func = getattr(scene, query)
+            if is_jit():
+                kernel = lambda: func(rays, coherent)
+            else:
+                def kernel():
+                    for ray in rays:
+                        func(ray, coherent)
+            times = measure(kernel, repeat=repeat, warmup=1)
+
+            values = hits(scene, kind, rays)
+            if kind not in reference:
+                reference[kind] = values
+            count = mismatches(kind, values, reference[kind], rtol)
+
+            result = BenchmarkResult(
+                'replay.%s.%s' % (name, kind), mi.variant(), _count(rays),
+                times, backend=backend, kind=kind, query=query,
+                build_time=build_time, mismatches=count,
+                python_loop=not is_jit())
+            result.extra['mrays_per_second'] = result.throughput * 1e-6
+            if verbose:
+                print('%s [%s]' % (result, backend))
+                if count > 0:
+                    print('  warning: %i of %i rays differ from the reference!'
+                          % (count, _count(rays)))
+            results.append(result)
+
+    return results, reference
+
+
+def run(scene: str, filename: str, variants: Optional[List[str]] = None,
+        job: Optional[int] = None, repeat: int = 5,
+        reference: Optional[str] = None, save: Optional[str] = None,
+        output: Optional[str] = None, rtol: float = 1e-3,
+        verbose: bool = True) -> List[BenchmarkResult]:
+    """
+    Replay the captured rays of a scene in a list of variants.
+
+    The results of every backend of every variant are checked against those
+    of the first one, or against the ``.npz`` file ``reference`` when given.
+
+    Parameter ``save`` (``str``):
+        Optional path of a ``.npz`` file where the reference results are
+        written, e.g. to check another build of Mitsuba against them.
+
+    Parameter ``output`` (``str``):
+        Optional path of a JSON file where the results are written.
+    """
+    import numpy as np
+
+    if variants is None:
+        variants = [mi.variant()]
+
+    ref = None
+    if reference is not None:
+        with np.load(reference) as f:
+            ref = {k: f[k] for k in f.files}
+
+    results = []
+    for variant in variants:
+        with mi.variant_context(variant):
+            r, ref = run_scene(scene, filename, job=job, repeat=repeat,
+                               reference=ref, rtol=rtol, verbose=verbose)
+            results += r
+
+    if save is not None and ref is not None:
+        np.savez(save, **ref)
+    if output is not None:
+        write_json(output, results, suite='replay')
+
+    return results
+
+
+def main(args=None):
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        prog='python -m mitsuba.python.benchmark.replay',
+        description='Time the traversal of captured rays.')
+    parser.add_argument('scene', help='reference scene or scene file')
+    parser.add_argument('capture', help='file written by mitsuba.RayCapture')
+    parser.add_argument('-m', '--variant', action='append', dest='variants',
+                        help='variant to benchmark (can be repeated)')
+    parser.add_argument('-j', '--job', type=int,
+                        help='recorded render job to replay (default: all)')
+    parser.add_argument('-n', '--repeat', type=int, default=5,
+                        help='number of measurements (default: 5)')
+    parser.add_argument('--reference',
+                        help='compare the hits against a .npz file written by --save')
+    parser.add_argument('--save', help='write the reference hits to a .npz file')
+    parser.add_argument('--rtol', type=float, default=1e-3,
+                        help='relative tolerance of the hit distances (default: 1e-3)')
+    parser.add_argument('-o', '--output', help='write the results to a JSON file')
+    args = parser.parse_args(args)
+
+    results = run(args.scene, args.capture, args.variants or [mi.variants()[0]],
+                  job=args.job, repeat=args.repeat, reference=args.reference,
+                  save=args.save, output=args.output, rtol=args.rtol)
+    if any(r.extra['mismatches'] > 0 for r in results):
+        raise SystemExit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,458 @@
+"""
+End-to-end rendering benchmarks with regression tracking.
+
+This module renders a set of reference scenes, which are generated
+procedurally so that they don't depend on external assets:
+
+- ``cornell``: the Cornell box (see :py:func:`mitsuba.cornell_box`)
+- ``textures``: the Cornell box with large bitmap textures on every wall
+- ``volume``: the Cornell box containing a heterogeneous participating medium
+- ``instances``: a grid of instanced shape groups
+
+Scene files can be benchmarked as well by passing their path instead of the
+name of a reference scene.
+
+For every scene and variant, the benchmark reports
+
+- the time to the first pixel, i.e. the time needed to load the scene and to
+  render one sample per pixel (including kernel compilation in JIT variants),
+- the number of camera samples rendered per second,
+- the number of primary rays intersected per second,
+- the peak resident memory of the process.
+
+These numbers can be compared against a baseline that was previously written
+by this module using :py:func:`compare`. The suite can also be run from the
+command line, e.g.
+
+.. code-block:: bash
+
+    python -m mitsuba.python.benchmark.scene -m llvm_ad_rgb -o out.json
+    python -m mitsuba.python.benchmark.scene -m llvm_ad_rgb -b out.json -t 0.1
+
+In scalar variants, the order in which the image blocks are rendered (see
+the ``block_order`` parameter of sampling integrators) can be compared by
+passing ``--block-order`` several times. The effect of the order on the
+last-level cache is best observed on scenes with large textures or many
+shapes, e.g. by looking at the miss rates reported by ``perf`` on Linux:
+
+.. code-block:: bash
+
+    for order in spiral hilbert morton; do
+        perf stat -e LLC-loads,LLC-load-misses \\
+            python -m mitsuba.python.benchmark.scene -m scalar_rgb \\
+                -r 1024 --block-order $order textures instances
+    done
+"""
+
+from __future__ import annotations # Delayed parsing of type annotations
+
+import json
+import time
+from typing import List, Optional, Union
+
+import drjit as dr
+import mitsuba as mi
+
+from .common import BenchmarkResult, is_jit, measure, write_json
+
+_registry = {}
+
+#: Direction of each tracked metric: +1 when larger values are better
+metrics = {
+    'samples_per_second': +1,
+    'primary_rays_per_second': +1,
+    'time_to_first_pixel': -1,
+    'peak_memory_mib': -1,
+}
+
+
+def scene_benchmark(name: str):
+    """
+    Decorator that registers a reference scene. The decorated function
+    receives the film resolution and returns a scene dictionary.
+    """
+    def decorator(func):
+        _registry[name] = func
+        return func
+    return decorator
+
+
+def scenes() -> List[str]:
+    '''Return the names of all reference scenes'''
+    return sorted(_registry.keys())
+
+
+def _with_film(scene: dict, resolution: int) -> dict:
+    scene['sensor']['film']['width'] = resolution
+    scene['sensor']['film']['height'] = resolution
+    return scene
+
+
+def _random_texture(size: int, seed: int) -> dict:
+    import numpy as np
+    data = np.random.default_rng(seed).random((size, size, 3), dtype=np.float32)
+    return {'type': 'bitmap', 'data': mi.TensorXf(data * 0.8)}
+
+
+@scene_benchmark('cornell')
+def _(resolution):
+    return _with_film(mi.cornell_box(), resolution)
+
+
+@scene_benchmark('textures')
+def _(resolution):
+    scene = _with_film(mi.cornell_box(), resolution)
+    for i, key in enumerate(['white', 'green', 'red']):
+        scene[key]['reflectance'] = _random_texture(2048, seed=i)
+    return scene
+
+
+@scene_benchmark('volume')
+def _(resolution):
+    import numpy as np
+    T = mi.ScalarTransform4f
+
+    x, y, z = np.meshgrid(*[np.linspace(-1, 1, 64)] * 3, indexing='ij')
+    density = np.maximum(1 - (x**2 + y**2 + z**2), 0)
+    density *= 0.5 + 0.5 * np.sin(8 * x) * np.cos(8 * y) * np.sin(8 * z)
+
+    scene = _with_film(mi.cornell_box(), resolution)
+    scene['integrator'] = {'type': 'volpath', 'max_depth': 8}
+    scene['medium'] = {
+        'type': 'cube',
+        'to_world': T().translate([0, -0.2, 0]).scale(0.6),
+        'bsdf': {'type': 'null'},
+        'interior': {
+            'type': 'heterogeneous',
+            'albedo': 0.8,
+            'scale': 4.0,
+            'sigma_t': {
+                'type': 'gridvolume',
+                'data': mi.TensorXf(density[..., None].astype(np.float32)),
+                'to_world': T().translate([0, -0.2, 0]).scale(0.6) @
+                            T().translate([-1, -1, -1]).scale(2)
+            }
+        }
+    }
+    return scene
+
+
+@scene_benchmark('instances')
+def _(resolution):
+    T = mi.ScalarTransform4f
+
+    scene = _with_film(mi.cornell_box(), resolution)
+    for key in ['small-box', 'large-box']:
+        del scene[key]
+
+    scene['group'] = {
+        'type': 'shapegroup',
+        'sphere': {
+            'type': 'sphere',
+            'to_world': T().scale(0.5),
+            'bsdf': {'type': 'ref', 'id': 'white'}
+        },
+        'cube': {
+            'type': 'cube',
+            'to_world': T().translate([0, -0.5, 0]).scale([0.4, 0.1, 0.4]),
+            'bsdf': {'type': 'ref', 'id': 'red'}
+        }
+    }
+
+    n = 16
+    for i in range(n):
+        for j in range(n):
+            scene['instance_%i_%i' % (i, j)] = {
+                'type': 'instance',
+                'group': {'type': 'ref', 'id': 'group'},
+                'to_world': T().translate([-0.9 + 1.8 * i / (n - 1), -0.85,
+                                           -0.9 + 1.8 * j / (n - 1)]) @
+                            T().rotate([0, 1, 0], 17 * (i + j)).scale(0.12)
+            }
+    return scene
+
+
+def _peak_memory_mib() -> Optional[float]:
+    '''Peak resident memory of the process (not available on Windows)'''
+    try:
+        import resource, sys
+    except ImportError:
+        return None
+    peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    # Bytes on macOS, kilobytes on Linux
+    return peak / (2**20 if sys.platform == 'darwin' else 2**10)
+
+
+def _primary_rays(scene: mi.Scene, scalar_size: int):
+    sensor = scene.sensors()[0]
+    film_size = sensor.film().crop_size()
+
+    if is_jit():
+        idx = dr.arange(mi.UInt32, dr.prod(film_size))
+        pos = mi.Point2f(mi.Float(idx % film_size[0]) + 0.5,
+                         mi.Float(idx // film_size[0]) + 0.5)
+        ray, _ = sensor.sample_ray(0, 0, pos / mi.ScalarVector2f(film_size),
+                                   mi.Point2f(0.5))
+        return ray, dr.prod(film_size)
+
+    ray, _ = sensor.sample_ray(0, 0, mi.Point2f(0.5), mi.Point2f(0.5))
+    return ray, scalar_size
+
+
+def load(name: str, resolution: int = 256,
+         block_order: Optional[str] = None) -> mi.Scene:
+    '''
+    Load a reference scene (see :py:func:`scenes`) or a scene file. The
+    ``block_order`` of the integrator can only be set for reference scenes.
+    '''
+    if name in _registry:
+        scene = _registry[name](resolution)
+        if block_order is not None:
+            scene['integrator']['block_order'] = block_order
+        return mi.load_dict(scene)
+    if block_order is not None:
+        raise ValueError('load(): the block order can only be specified for '
+                         'reference scenes!')
+    return mi.load_file(name)
+
+
+def run_scene(name: str, spp: int = 16, budget: Optional[float] = None,
+              resolution: int = 256, scalar_rays: int = 4096,
+              repeat: int = 3,
+              block_order: Optional[str] = None) -> BenchmarkResult:
+    """
+    Benchmark a single scene in the current variant.
+
+    Parameter ``name`` (``str``):
+        Name of a reference scene (see :py:func:`scenes`) or path of a
+        scene file.
+
+    Parameter ``spp`` (``int``):
+        Samples per pixel of each timed rendering.
+
+    Parameter ``budget`` (``float``):
+        When specified, renderings of ``spp`` samples per pixel are repeated
+        until this time budget (in seconds) is exhausted. Otherwise, the
+        scene is rendered ``repeat`` times.
+
+    Parameter ``resolution`` (``int``):
+        Film resolution of the reference scenes.
+
+    Parameter ``scalar_rays`` (``int``):
+        Number of primary rays traced by scalar variants.
+
+    Parameter ``repeat`` (``int``):
+        Number of timed renderings when no time budget is given.
+
+    Parameter ``block_order`` (``str``):
+        Optional order of the image blocks (``spiral``, ``hilbert`` or
+        ``morton``). It is appended to the name of the result.
+    """
+    start = time.perf_counter()
+    scene = load(name, resolution, block_order)
+    load_time = time.perf_counter() - start
+
+    image = mi.render(scene, spp=1, seed=0)
+    dr.eval(image)
+    dr.sync_thread()
+    first_pixel = time.perf_counter() - start
+
+    film_size = scene.sensors()[0].film().crop_size()
+    samples = int(film_size[0]) * int(film_size[1]) * spp
+
+    times, seed = [], 1
+    while True:
+        pass_start = time.perf_counter()
+        image = mi.render(scene, spp=spp, seed=seed)
+        dr.eval(image)
+        dr.sync_thread()
+        times.append(time.perf_counter() - pass_start)
+        seed += 1
+        if budget is None:
+            if len(times) >= repeat:
+                break
+        elif sum(times) >= budget:
+            break
+
+    ray, ray_count = _primary_rays(scene, scalar_rays)
+    if is_jit():
+        ray_times = measure(lambda: scene.ray_intersect_preliminary(ray),
+                            repeat=repeat, warmup=1)
+    else:
+        def trace():
+            for _ in range(ray_count):
+                scene.ray_intersect_preliminary(ray)
+        ray_times = measure(trace, repeat=repeat, warmup=1)
+
+    if block_order is not None:
+        name += '.' + block_order
+
+    result = BenchmarkResult(
+        'scene.' + name, mi.variant(), samples, times, spp=spp,
+        resolution=[int(film_size[0]), int(film_size[1])],
+        load_time=load_time, time_to_first_pixel=first_pixel,
+        primary_rays_per_second=ray_count / max(min(ray_times), 1e-12),
+        peak_memory_mib=_peak_memory_mib(), python_loop=not is_jit())
+    result.extra['samples_per_second'] = result.throughput
+    return result
+
+
+def run(variants: Optional[List[str]] = None,
+        scenes: Optional[List[str]] = None, spp: int = 16,
+        budget: Optional[float] = None, resolution: int = 256,
+        repeat: int = 3, output: Optional[str] = None,
+        verbose: bool = True,
+        block_orders: Optional[List[str]] = None) -> List[BenchmarkResult]:
+    """
+    Benchmark a list of scenes in a list of variants.
+
+    The parameters ``spp``, ``budget``, ``resolution`` and ``repeat`` are
+    forwarded to :py:func:`run_scene`.
+
+    Parameter ``variants`` (``List[str]``):
+        Variants to benchmark. Defaults to the current variant.
+
+    Parameter ``scenes`` (``List[str]``):
+        Reference scenes or scene files. Defaults to all reference scenes.
+
+    Parameter ``output`` (``str``):
+        Optional path of a JSON file where the results are written. This
+        file can later serve as a baseline of :py:func:`compare`.
+
+    Parameter ``block_orders`` (``List[str]``):
+        Optional list of block orders, each of which is benchmarked
+        separately (see :py:func:`run_scene`).
+    """
+    if variants is None:
+        variants = [mi.variant()]
+    if scenes is None:
+        scenes = sorted(_registry.keys())
+    if block_orders is None:
+        block_orders = [None]
+
+    results = []
+    for variant in variants:
+        with mi.variant_context(variant):
+            for name in scenes:
+                for block_order in block_orders:
+                    result = run_scene(name, spp=spp, budget=budget,
+                                       resolution=resolution, repeat=repeat,
+                                       block_order=block_order)
+                    if verbose:
+                        print(result)
+                    results.append(result)
+
+    if output is not None:
+        write_json(output, results, suite='scene', spp=spp, budget=budget)
+
+    return results
+
+
+def compare(results: List[BenchmarkResult], baseline: Union[str, dict],
+            tolerance: float = 0.1,
+            tolerances: Optional[dict] = None) -> List[dict]:
+    """
+    Compare benchmark results against a baseline.
+
+    A metric has regressed when it is worse than its baseline value by more
+    than the relative tolerance, e.g. when the number of samples per second
+    dropped by more than 10 % with the default ``tolerance``. Results that
+    aren't part of the baseline are ignored.
+
+    Parameter ``results`` (``List[BenchmarkResult]``):
+        Results of :py:func:`run`.
+
+    Parameter ``baseline`` (``str | dict``):
+        Path of a JSON file written by :py:func:`run`, or its parsed contents.
+
+    Parameter ``tolerance`` (``float``):
+        Default relative tolerance.
+
+    Parameter ``tolerances`` (``dict``):
+        Optional relative tolerances of specific metrics (see
+        :py:data:`metrics`), which override ``tolerance``.
+
+    Returns a list of regressions, each of which is a dictionary with the
+    keys ``name``, ``variant``, ``metric``, ``baseline``, ``value`` and
+    ``change`` (the relative change of the metric).
+    """
+    if isinstance(baseline, str):
+        with open(baseline) as f:
+            baseline = json.load(f)
+
+    reference = {(r['name'], r['variant']): r for r in baseline['results']}
+    tolerances = tolerances or {}
+
+    regressions = []
+    for result in results:
+        ref_entry = reference.get((result.name, result.variant))
+        if ref_entry is None:
+            continue
+        current = result.to_dict()
+
+        for metric, sign in metrics.items():
+            old, new = ref_entry.get(metric), current.get(metric)
+            if not old or new is None:
+                continue
+            change = (new - old) / old
+            if sign * change < -tolerances.get(metric, tolerance):
+                regressions.append({
+                    'name': result.name,
+                    'variant': result.variant,
+                    'metric': metric,
+                    'baseline': old,
+                    'value': new,
+                    'change': change
+                })
+
+    return regressions
+
+
+def main(args=None) -> int:
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        prog='python -m mitsuba.python.benchmark.scene',
+        description='Render reference scenes and track performance regressions.')
+    parser.add_argument('scenes', nargs='*',
+                        help='reference scenes or scene files (default: all '
+                             'reference scenes: %s)' % ', '.join(scenes()))
+    parser.add_argument('-m', '--variant', action='append', dest='variants',
+                        help='variant to benchmark (can be repeated)')
+    parser.add_argument('-s', '--spp', type=int, default=16,
+                        help='samples per pixel of each rendering (default: 16)')
+    parser.add_argument('-T', '--time', type=float, dest='budget',
+                        help='render each scene repeatedly for this many seconds')
+    parser.add_argument('-r', '--resolution', type=int, default=256,
+                        help='film resolution of the reference scenes (default: 256)')
+    parser.add_argument('--block-order', action='append', dest='block_orders',
+                        choices=['spiral', 'hilbert', 'morton'],
+                        help='order of the image blocks (can be repeated)')
+    parser.add_argument('-o', '--output', help='write the results to a JSON file')
+    parser.add_argument('-b', '--baseline',
+                        help='JSON file of a previous run to compare against')
+    parser.add_argument('-t', '--tolerance', type=float, default=0.1,
+                        help='relative tolerance of the comparison (default: 0.1)')
+    args = parser.parse_args(args)
+
+    variants = args.variants or [mi.variants()[0]]
+    results = run(variants, scenes=args.scenes or None, spp=args.spp,
+                  budget=args.budget, resolution=args.resolution,
+                  output=args.output, block_orders=args.block_orders)
+
+    if args.baseline is None:
+        return 0
+
+    regressions = compare(results, args.baseline, tolerance=args.tolerance)
+    for r in regressions:
+        print('Regression: %s (%s): %s changed by %+.1f %% (%.4g -> %.4g)' % (
+            r['name'], r['variant'], r['metric'], r['change'] * 100,
+            r['baseline'], r['value']))
+    if not regressions:
+        print('No regressions.')
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    import sys
+    sys.exit(main())
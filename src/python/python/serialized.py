@@ -0,0 +1,222 @@
+'''
+Reading, writing, and conversion of Mitsuba's ``.serialized`` mesh format.
+
+Files of versions 3 and 4 store every shape as a single DEFLATE stream. Version
+5 splits the shape data into blocks that are either stored uncompressed (at
+64-byte aligned offsets, so that the loader can memory-map them) or compressed
+independently (so that they can be decompressed in parallel). This module only
+depends on the Python standard library.
+'''
+
+import struct
+import zlib
+from concurrent.futures import ThreadPoolExecutor
+
+FORMAT_HEADER = 0x041C
+
+FLAG_HAS_NORMALS       = 0x0001
+FLAG_HAS_TEXCOORDS     = 0x0002
+FLAG_HAS_COLORS        = 0x0008
+FLAG_DOUBLE_PRECISION  = 0x2000
+
+COMPRESSION_NONE    = 0
+COMPRESSION_DEFLATE = 1
+
+# Arrays in file order: name, per-vertex dimension and presence flag
+_ARRAYS = [
+    ('vertex_positions', 3, None),
+    ('vertex_normals', 3, FLAG_HAS_NORMALS),
+    ('vertex_texcoords', 2, FLAG_HAS_TEXCOORDS),
+    ('vertex_colors', 3, FLAG_HAS_COLORS)
+]
+
+
+def _array_sizes(flags, vertex_count, face_count):
+    value_size = 8 if flags & FLAG_DOUBLE_PRECISION else 4
+    index_size = 8 if vertex_count > 0xFFFFFFFF else 4
+    sizes = []
+    for _, dim, flag in _ARRAYS:
+        present = flag is None or (flags & flag) != 0
+        sizes.append(vertex_count * dim * value_size if present else 0)
+    sizes.append(face_count * 3 * index_size)
+    return sizes
+
+
+def _read_string(data, offset):
+    end = data.index(b'\0', offset)
+    return data[offset:end].decode('utf-8'), end + 1
+
+
+def _shape_offsets(data, version):
+    count = struct.unpack_from('<I', data, len(data) - 4)[0]
+    if version == 3:
+        fmt, size = '<%iI' % count, 4
+    else:
+        fmt, size = '<%iQ' % count, 8
+    return list(struct.unpack_from(fmt, data, len(data) - 4 - size * count))
+
+
+def read(filename):
+    '''
+    Read all shapes of a ``.serialized`` file (version 3, 4, or 5).
+
+    Returns a list of dictionaries with the entries ``name``, ``flags``,
+    ``vertex_count``, ``face_count``, and ``arrays``. The latter holds the raw
+    little endian contents of the vertex positions, normals, texture
+    coordinates, colors, and faces as ``bytes`` (empty when not present).
+    '''
+    with open(filename, 'rb') as f:
+        data = f.read()
+
+    fmt, version = struct.unpack_from('<HH', data, 0)
+    if fmt != FORMAT_HEADER:
+        raise RuntimeError('"%s": invalid file format' % filename)
+    if version not in (3, 4, 5):
+        raise RuntimeError('"%s": unsupported version %i' % (filename, version))
+
+    shapes = []
+    for offset in _shape_offsets(data, version):
+        fmt, version = struct.unpack_from('<HH', data, offset)
+        offset += 4
+
+        if version == 5:
+            flags, compression = struct.unpack_from('<II', data, offset)
+            name, offset = _read_string(data, offset + 8)
+            vertex_count, face_count = struct.unpack_from('<QQ', data, offset)
+            offset += 16
+
+            arrays = []
+            for _ in range(5):
+                block_count = struct.unpack_from('<I', data, offset)[0]
+                offset += 4
+                chunks = []
+                for _ in range(block_count):
+                    b_offset, b_size, _ = struct.unpack_from('<QQQ', data, offset)
+                    offset += 24
+                    chunk = data[b_offset:b_offset + b_size]
+                    if compression == COMPRESSION_DEFLATE:
+                        chunk = zlib.decompress(chunk)
+                    chunks.append(chunk)
+                arrays.append(b''.join(chunks))
+        else:
+            payload = zlib.decompressobj().decompress(data[offset:])
+            flags = struct.unpack_from('<I', payload, 0)[0]
+            pos = 4
+            name = ''
+            if version == 4:
+                name, pos = _read_string(payload, pos)
+            vertex_count, face_count = struct.unpack_from('<QQ', payload, pos)
+            pos += 16
+
+            arrays = []
+            for size in _array_sizes(flags, vertex_count, face_count):
+                arrays.append(payload[pos:pos + size])
+                pos += size
+
+        shapes.append({
+            'name': name,
+            'flags': flags,
+            'vertex_count': vertex_count,
+            'face_count': face_count,
+            'arrays': arrays
+        })
+
+    return shapes
+
+
+def write(filename, shapes, version=5, compression=COMPRESSION_DEFLATE,
+          block_size=1 << 22, level=6):
+    '''
+    Write a list of shapes (in the representation returned by :py:func:`read`)
+    to a ``.serialized`` file of version 4 or 5.
+
+    In version 5 files, compressed arrays are split into blocks of
+    ``block_size`` bytes, which are compressed in parallel.
+    '''
+    if version not in (4, 5):
+        raise RuntimeError('write(): unsupported version %i' % version)
+
+    def align(value):
+        return (value + 63) & ~63
+
+    offsets = []
+    with open(filename, 'wb') as f, ThreadPoolExecutor() as pool:
+        for shape in shapes:
+            offsets.append(f.tell())
+            name = shape['name'].encode('utf-8') + b'\0'
+            counts = struct.pack('<QQ', shape['vertex_count'], shape['face_count'])
+            arrays = shape['arrays']
+
+            if version == 4:
+                f.write(struct.pack('<HH', FORMAT_HEADER, 4))
+                f.write(zlib.compress(struct.pack('<I', shape['flags']) + name +
+                                      counts + b''.join(arrays), level))
+                continue
+
+            if shape['vertex_count'] > 0xFFFFFFFF:
+                raise RuntimeError('write(): version 5 requires 32 bit indices')
+
+            # Split the arrays into blocks and compress them
+            blocks = []
+            for array in arrays:
+                if len(array) == 0:
+                    chunks = []
+                elif compression == COMPRESSION_DEFLATE:
+                    chunks = [array[i:i + block_size]
+                              for i in range(0, len(array), block_size)]
+                else:
+                    chunks = [array]
+                raw_sizes = [len(c) for c in chunks]
+                if compression == COMPRESSION_DEFLATE:
+                    chunks = list(pool.map(lambda c: zlib.compress(c, level), chunks))
+                blocks.append(list(zip(chunks, raw_sizes)))
+
+            header_size = 4 + 8 + len(name) + 16 + \
+                sum(4 + 24 * len(b) for b in blocks)
+
+            # Assign 64-byte aligned file offsets to the blocks
+            table, pos = b'', align(offsets[-1] + header_size)
+            for array_blocks in blocks:
+                table += struct.pack('<I', len(array_blocks))
+                for chunk, raw_size in array_blocks:
+                    table += struct.pack('<QQQ', pos, len(chunk), raw_size)
+                    pos = align(pos + len(chunk))
+
+            f.write(struct.pack('<HHII', FORMAT_HEADER, 5, shape['flags'],
+                                compression))
+            f.write(name + counts + table)
+
+            for array_blocks in blocks:
+                for chunk, _ in array_blocks:
+                    f.write(b'\0' * (align(f.tell()) - f.tell()))
+                    f.write(chunk)
+
+        f.write(struct.pack('<%iQ' % len(offsets), *offsets))
+        f.write(struct.pack('<I', len(offsets)))
+
+
+def convert(source, target, compression=COMPRESSION_DEFLATE, **kwargs):
+    '''
+    Convert a ``.serialized`` file of version 3, 4, or 5 to version 5.
+    '''
+    write(target, read(source), version=5, compression=compression, **kwargs)
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(description=
+        'This program converts .serialized mesh files to version 5 of the '
+        'format, which supports memory-mapped and parallel loading.')
+    parser.add_argument('--compression', choices=['none', 'deflate'],
+                        default='deflate', help='Block compression method')
+    parser.add_argument('--block-size', type=int, default=1 << 22,
+                        help='Size of compressed blocks in bytes')
+    parser.add_argument('source', type=str, help='Input file')
+    parser.add_argument('target', type=str, help='Output file')
+    args = parser.parse_args()
+
+    convert(args.source, args.target,
+            compression=COMPRESSION_NONE if args.compression == 'none'
+                        else COMPRESSION_DEFLATE,
+            block_size=args.block_size)
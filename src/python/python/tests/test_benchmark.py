@@ -0,0 +1,141 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def test01_micro_benchmarks(variants_all_backends_once, tmp_path):
+    import json
+
+    names = mi.benchmark.micro.benchmarks()
+    assert 'warp.square_to_uniform_disk' in names
+    assert 'bsdf.diffuse.sample' in names
+    assert 'shape.sphere.ray_intersect' in names
+
+    path = str(tmp_path / 'micro.json')
+    results = mi.benchmark.micro.run(
+        filter='*', size=16, scalar_size=2, repeat=1, warmup=1,
+        output=path, verbose=False)
+    assert len(results) == len(names)
+    assert all(r.median >= 0 and r.throughput > 0 for r in results)
+
+    with open(path) as f:
+        data = json.load(f)
+    assert data['suite'] == 'micro'
+    assert 'mitsuba' in data['environment']
+    assert len(data['results']) == len(names)
+    assert all(r['variant'] == mi.variant() for r in data['results'])
+    assert all(r['python_loop'] == (not dr.is_jit_v(mi.Float))
+               for r in data['results'])
+
+
+def test02_micro_benchmark_filter(variant_scalar_rgb):
+    results = mi.benchmark.micro.run(
+        filter='warp.square_to_uniform_disk_pdf', scalar_size=1, repeat=1,
+        warmup=0, verbose=False)
+    assert [r.name for r in results] == ['warp.square_to_uniform_disk_pdf']
+
+
+def test03_scene_benchmarks(variants_all_backends_once, tmp_path):
+    import json
+
+    assert mi.benchmark.scene.scenes() == ['cornell', 'instances', 'textures', 'volume']
+
+    path = str(tmp_path / 'scene.json')
+    results = mi.benchmark.scene.run(scenes=['cornell'], spp=1,
+                                     resolution=8, repeat=1, output=path,
+                                     verbose=False)
+    assert len(results) == 1
+    r = results[0].to_dict()
+    assert r['name'] == 'scene.cornell' and r['resolution'] == [8, 8]
+    assert r['samples_per_second'] > 0 and r['primary_rays_per_second'] > 0
+    assert r['time_to_first_pixel'] >= r['load_time']
+
+    # A run compared against itself does not regress
+    assert mi.benchmark.scene.compare(results, path) == []
+
+    # Inflate the baseline throughput to trigger a regression
+    with open(path) as f:
+        baseline = json.load(f)
+    baseline['results'][0]['samples_per_second'] *= 2
+    regressions = mi.benchmark.scene.compare(results, baseline, tolerance=0.1)
+    assert [r['metric'] for r in regressions] == ['samples_per_second']
+    assert abs(regressions[0]['change'] + 0.5) < 1e-6
+
+    # Per-metric tolerances override the default
+    assert mi.benchmark.scene.compare(
+        results, baseline, tolerances={'samples_per_second': 0.6}) == []
+
+
+def test04_ray_benchmarks(variants_all_backends_once, tmp_path):
+    import json
+
+    backends = mi.benchmark.rays.backends()
+    assert len(backends) >= 1
+
+    scene = mi.benchmark.scene.load('cornell', resolution=8)
+    batches = mi.benchmark.rays.ray_batches(scene, scalar_rays=16)
+    assert set(batches.keys()) == {'primary', 'diffuse', 'shadow'}
+
+    path = str(tmp_path / 'rays.json')
+    results = mi.benchmark.rays.run(scenes=['cornell'], resolution=8,
+                                    repeat=1, output=path, verbose=False)
+
+    # Two queries on three batches per backend, the Cornell box covers the film
+    assert len(results) == 6 * len(backends)
+    assert all(r.extra['mrays_per_second'] > 0 for r in results)
+    assert all(r.extra['build_time'] >= 0 for r in results)
+    assert all(r.extra['accel_memory'] >= 0 for r in results)
+
+    with open(path) as f:
+        data = json.load(f)
+    assert set(r['backend'] for r in data['results']) == set(backends)
+
+
+def test05_scene_benchmark_block_orders(variant_scalar_rgb):
+    results = mi.benchmark.scene.run(
+        scenes=['cornell'], spp=1, resolution=16, repeat=1, verbose=False,
+        block_orders=['spiral', 'hilbert', 'morton'])
+    assert [r.name for r in results] == [
+        'scene.cornell.spiral', 'scene.cornell.hilbert', 'scene.cornell.morton']
+    assert all(r.extra['samples_per_second'] > 0 for r in results)
+
+    with pytest.raises(ValueError, match='reference scenes'):
+        mi.benchmark.scene.load('scene.xml', block_order='hilbert')
+
+
+def test06_ray_capture_replay(variants_all_backends_once, tmp_path):
+    path = str(tmp_path / 'rays.mrc')
+    scene = mi.benchmark.scene.load('cornell', resolution=8)
+
+    # Only the first and third render jobs are recorded
+    mi.RayCapture.start(path, interval=2)
+    assert mi.RayCapture.enabled()
+    try:
+        for i in range(3):
+            mi.render(scene, spp=1, seed=i)
+    finally:
+        mi.RayCapture.stop()
+    assert not mi.RayCapture.enabled()
+
+    jobs = mi.benchmark.replay.load(path)
+    assert [job for job, _ in jobs] == [0, 2]
+    batches = mi.benchmark.replay.split(jobs[0][1])
+
+    # Every pixel traces a coherent camera ray, which hits the Cornell box
+    assert len(batches['coherent']) == 64
+    assert all(mi.benchmark.replay.depth(batches['coherent']) == 0)
+    assert len(batches['incoherent']) > 0 and len(batches['shadow']) > 0
+
+    # All backends find the same hits as the first one
+    results = mi.benchmark.replay.run('cornell', path, job=0, repeat=1,
+                                      save=str(tmp_path / 'hits.npz'),
+                                      verbose=False)
+    backends = mi.benchmark.rays.backends()
+    assert len(results) == 3 * len(backends)
+    assert all(r.extra['mismatches'] == 0 for r in results)
+
+    # ... and the same hits as the saved reference
+    results = mi.benchmark.replay.run('cornell', path, job=0, repeat=1,
+                                      reference=str(tmp_path / 'hits.npz'),
+                                      verbose=False)
+    assert all(r.extra['mismatches'] == 0 for r in results)
@@ -325,3 +325,32 @@ def test06_variant_context():
     except RuntimeError:
         pass
     assert mi.variant() == "scalar_rgb"
+
+
+def test07_kernel_warmup(variants_vec_backends_once_rgb, tmp_path):
+    scene_dict = mi.cornell_box()
+    scene_dict['sensor']['film']['width'] = 32
+    scene_dict['sensor']['film']['height'] = 32
+    scene = mi.load_dict(scene_dict)
+
+    handle = mi.warmup(scene, spp=4, cache_dir=str(tmp_path), key='cbox')
+    kernels = handle.wait()
+    assert handle.done()
+
+    # The kernels are published to the shared directory with a manifest
+    import json, os
+    with open(os.path.join(tmp_path, 'manifest.json')) as f:
+        manifest = json.load(f)
+    assert manifest['cbox']['variant'] == mi.variant()
+    assert manifest['cbox']['kernels'] == sorted(kernels)
+    for name in kernels:
+        assert os.path.exists(os.path.join(tmp_path, name))
+
+    # Kernels already in the local cache are not copied again
+    assert mi.prefetch_kernels(str(tmp_path), 'cbox') == 0
+    assert mi.prefetch_kernels(str(tmp_path), 'unknown') == 0
+
+    # Rendering after the warmup gives the same image as without it
+    image = mi.render(scene, spp=4)
+    ref = mi.render(mi.load_dict(scene_dict), spp=4)
+    assert dr.allclose(image, ref)
@@ -8,7 +8,7 @@ import mitsuba as mi
 
 import typing
 if typing.TYPE_CHECKING:
-    from typing import Any, Optional, Union
+    from typing import Any, Callable, Iterator, Optional, Union
 
 class SceneParameters(Mapping):
     """
@@ -224,6 +224,8 @@ class SceneParameters(Mapping):
         out = []
         for _, node, keys in work_list:
             node.parameters_changed(list(keys))
+            # Don't reuse the modified objects in the reload mode of load_file()
+            mi.invalidate_reload(node)
             out.append((node, keys))
 
         self.nodes_to_update.clear()
@@ -508,6 +510,412 @@ def render(scene: mi.Scene,
     return dr.custom(_RenderOp, scene, sensor, dict_params, params, integrator,
                      (seed, seed_grad), (spp, spp_grad))
 
+def render_sequence(scene: mi.Scene,
+                    frames: int,
+                    update: Callable[[int], None] = None,
+                    sensor: Union[int, mi.Sensor] = 0,
+                    integrator: mi.Integrator = None,
+                    seed: int = 0,
+                    spp: int = 0,
+                    frame_duration: float = 0.0,
+                    denoise: bool = False) -> Iterator[mi.TensorXf]:
+    """
+    Render an animated sequence, optionally with temporal denoising.
+
+    This generator renders the frames ``0, ..., frames - 1`` in order and
+    yields each image as soon as it is complete. Before rendering the frame
+    ``i``, the function calls ``update(i)``, which should animate the scene
+    (e.g. by modifying the parameters returned by ``mi.traverse()`` and calling
+    their ``update()`` method). Every frame uses the seed ``seed + i``.
+
+    When ``denoise=True``, the integrator is wrapped in an ``aov`` integrator
+    that additionally records the albedo, the shading normals and the
+    screen-space motion vectors of the first intersection. The motion vectors
+    account for the movement of the sensor and of the scene's instances
+    between consecutive frames. In CUDA variants, these guides are given to a
+    temporal ``mi.OptixDenoiser`` together with the previous denoised frame,
+    which avoids flickering in the denoised sequence. In other variants, the
+    ``mi.OIDNDenoiser`` is used instead, which denoises every frame
+    independently. The yielded images then only contain the denoised base
+    channels of the film (e.g. RGBA).
+
+    Parameter ``scene`` (``mi.Scene``):
+        Reference to the scene being rendered.
+
+    Parameter ``frames`` (``int``):
+        Number of frames of the sequence.
+
+    Parameter ``update`` (``Callable[[int], None]``):
+        Optional function which is called with the frame index before every
+        frame is rendered.
+
+    Parameter ``sensor`` (``int``, ``mi.Sensor``):
+        Specify a sensor or a (sensor index) to render the scene from a
+        different viewpoint. By default, the first sensor within the scene
+        description (index 0) will take precedence.
+
+    Parameter ``integrator`` (``mi.Integrator``):
+        Optional parameter to override the rendering technique to be used. By
+        default, the integrator specified in the original scene description will
+        be used.
+
+    Parameter ``seed`` (``int``)
+        Seed of the first frame.
+
+    Parameter ``spp`` (``int``):
+        Optional parameter to override the number of samples per pixel. The
+        value provided within the original scene specification takes precedence
+        if ``spp=0``.
+
+    Parameter ``frame_duration`` (``float``):
+        When nonzero, the shutter of the sensor opens at the time
+        ``i * frame_duration`` when rendering the frame ``i``. This animates
+        the keyframed instances of the scene without an ``update`` function.
+
+    Parameter ``denoise`` (``bool``):
+        Whether the frames should be denoised.
+    """
+
+    assert isinstance(scene, mi.Scene)
+
+    if integrator is None:
+        integrator = scene.integrator()
+
+    if integrator is None:
+        raise Exception('No integrator specified! Add an integrator in the scene '
+                        'description or provide an integrator directly as argument.')
+
+    if isinstance(sensor, int):
+        if len(scene.sensors()) == 0:
+            raise Exception('No sensor specified! Add a sensor in the scene '
+                            'description or provide a sensor directly as argument.')
+        sensor = scene.sensors()[sensor]
+
+    denoiser = None
+    temporal = False
+    if denoise:
+        film = sensor.film()
+        # The same `aov` integrator is used for all frames, as it keeps track
+        # of the sensor and instance transforms of the previous frame
+        integrator = mi.load_dict({
+            'type': 'aov',
+            'aovs': 'albedo:albedo,normals:sh_normal,flow:motion',
+            'integrator': integrator
+        })
+        base_channels = film.base_channels_count()
+        if hasattr(mi, 'OptixDenoiser') and mi.variant().startswith('cuda'):
+            denoiser = mi.OptixDenoiser(film.crop_size(), albedo=True,
+                                        normals=True, temporal=True)
+            temporal = True
+        elif hasattr(mi, 'OIDNDenoiser'):
+            denoiser = mi.OIDNDenoiser(film.crop_size(), albedo=True,
+                                       normals=True, prefilter=False)
+        else:
+            raise Exception('Denoising requires Mitsuba to be compiled with '
+                            'OptiX or Open Image Denoise support!')
+
+    previous = None
+    for i in range(frames):
+        if update is not None:
+            update(i)
+
+        if frame_duration != 0.0:
+            sensor.set_shutter_open(i * frame_duration)
+
+        image = integrator.render(scene, sensor, seed=seed + i, spp=spp)
+
+        if denoiser is None:
+            yield image
+            continue
+
+        channels = image.shape[2]
+        noisy = image[:, :, :base_channels]
+        albedo = image[:, :, channels - 8:channels - 5]
+        normals = image[:, :, channels - 5:channels - 2]
+        to_sensor = sensor.world_transform().inverse()
+
+        if temporal:
+            flow = image[:, :, channels - 2:]
+            # The first frame has no history: use the noisy frame instead
+            if previous is None:
+                previous = noisy
+            previous = denoiser(noisy, albedo=albedo, normals=normals,
+                                to_sensor=to_sensor, flow=flow,
+                                previous_denoised=previous)
+        else:
+            previous = denoiser(noisy, albedo=albedo, normals=normals,
+                                to_sensor=to_sensor)
+
+        yield previous
+
+def split_batch(image: mi.TensorXf, sensor: mi.Sensor) -> list[mi.TensorXf]:
+    """
+    Split an image rendered with a ``batch`` sensor into the images of its
+    views.
+
+    The views are tiled horizontally in the film of the ``batch`` sensor, in
+    the order of ``Sensor.sub_sensors()``. This function reinterprets the
+    storage of the image with the shape ``(height, views, width, channels)``
+    (which does not copy it) and returns lazy slices of the views. The slices
+    are only gathered by the kernels that consume them, e.g. when evaluating a
+    loss per view, and they propagate gradients to the batched image. This
+    makes it possible to differentiate all views in a single rendering step.
+
+    Parameter ``image`` (``mi.TensorXf``):
+        Image rendered with the ``batch`` sensor, of shape
+        ``(height, views * width, channels)``.
+
+    Parameter ``sensor`` (``mi.Sensor``):
+        The ``batch`` sensor that rendered the image.
+
+    Returns → list[mi.TensorXf]:
+        The images of the views, of shape ``(height, width, channels)``.
+    """
+    count = len(sensor.sub_sensors())
+    if count == 0:
+        raise Exception('split_batch(): the sensor must be a batch sensor!')
+
+    height, width, channels = image.shape
+    if width % count != 0:
+        raise Exception('split_batch(): the width of the image (%i) must be '
+                        'divisible by the number of views (%i)!'
+                        % (width, count))
+
+    views = mi.TensorXf(image.array, (height, count, width // count, channels))
+    return [views[:, i] for i in range(count)]
+
+# ------------------------------------------------------------------------------
+#                            Kernel warmup
+# ------------------------------------------------------------------------------
+
+def _kernel_cache_path() -> str:
+    """Return the directory in which Dr.Jit caches compiled kernels"""
+    import os, sys, tempfile
+    if sys.platform == 'win32':
+        return os.path.join(tempfile.gettempdir(), 'drjit')
+    return os.path.join(os.path.expanduser('~'), '.drjit')
+
+def _manifest_path(cache_dir: str) -> str:
+    import os
+    return os.path.join(cache_dir, 'manifest.json')
+
+def _read_manifest(cache_dir: str) -> dict:
+    import json, os
+    path = _manifest_path(cache_dir)
+    if not os.path.exists(path):
+        return {}
+    with open(path, 'r') as f:
+        return json.load(f)
+
+def _warmup_key(scene: mi.Scene, sensor: mi.Sensor, integrator: mi.Integrator,
+                spp: int) -> str:
+    size = sensor.film().size()
+    if spp == 0:
+        spp = sensor.sampler().sample_count()
+    return '%s/%s/%ix%i/%ispp' % (mi.variant(), integrator.class_().name(),
+                                  size[0], size[1], spp)
+
+def prefetch_kernels(cache_dir: str, key: str) -> int:
+    """
+    Copy the compiled kernels that a manifest in a shared cache directory lists
+    for ``key`` into the local kernel cache of Dr.Jit.
+
+    The kernels then do not need to be compiled again by the first
+    ``render()`` of this process, as long as its traced IR matches that of the
+    process which created the manifest (see :py:func:`mitsuba.warmup()`).
+    Kernels that are already present in the local cache are not copied.
+
+    Parameter ``cache_dir`` (``str``):
+        Shared cache directory, which holds the kernels and the manifest
+        ``manifest.json``.
+
+    Parameter ``key`` (``str``):
+        Key of the configuration in the manifest.
+
+    Returns → int:
+        The number of copied kernels.
+    """
+    import os, shutil
+    entry = _read_manifest(cache_dir).get(key)
+    if entry is None:
+        return 0
+
+    local = _kernel_cache_path()
+    os.makedirs(local, exist_ok=True)
+    count = 0
+    for name in entry['kernels']:
+        source, target = os.path.join(cache_dir, name), os.path.join(local, name)
+        if os.path.exists(source) and not os.path.exists(target):
+            shutil.copyfile(source, target)
+            count += 1
+    return count
+
+class KernelWarmup:
+    """
+    Handle of a kernel warmup started by :py:func:`mitsuba.warmup()`.
+    """
+
+    def __init__(self):
+        self.thread = None
+        self.kernels = []
+        self.error = None
+
+    def done(self) -> bool:
+        """Return whether the warmup has finished"""
+        return self.thread is None or not self.thread.is_alive()
+
+    def wait(self) -> list[str]:
+        """
+        Wait for the warmup to finish and return the file names of the kernels
+        (in the cache directory of Dr.Jit) that it used. Any exception raised
+        by the warmup is propagated.
+        """
+        if self.thread is not None:
+            self.thread.join()
+            self.thread = None
+        if self.error is not None:
+            error, self.error = self.error, None
+            raise error
+        return self.kernels
+
+def warmup(scene: mi.Scene,
+           sensor: Union[int, mi.Sensor] = 0,
+           integrator: mi.Integrator = None,
+           spp: int = 0,
+           cache_dir: Optional[str] = None,
+           key: Optional[str] = None,
+           background: bool = True) -> KernelWarmup:
+    """
+    Trace and compile the kernels of the integrator for a scene ahead of time.
+
+    The first ``render()`` of a JIT variant spends most of its time compiling
+    kernels. This function performs a throwaway rendering with the same film
+    size and sample count (by default on a background thread), so that this can
+    overlap with other work done after loading the scene, such as the upload of
+    textures or the setup of an optimization. Since Dr.Jit caches kernels by
+    the hash of their IR, and the seed of the sampler is an opaque variable,
+    the subsequent renderings of the same configuration directly reuse these
+    kernels. The rendering must not start before the warmup has finished,
+    which :py:meth:`KernelWarmup.wait()` guarantees.
+
+    When ``cache_dir`` is specified, the kernels listed for ``key`` in the
+    manifest of this shared directory are first prefetched into the local cache
+    (see :py:func:`mitsuba.prefetch_kernels()`). After the warmup, the kernels
+    it used are copied to the shared directory and the manifest is updated, so
+    that other processes (e.g. on a render farm) can skip their compilation.
+
+    This function has no effect in non-JIT variants.
+
+    Parameter ``scene`` (``mi.Scene``):
+        Reference to the scene being rendered.
+
+    Parameter ``sensor`` (``int``, ``mi.Sensor``):
+        The sensor (or sensor index) that will be used for rendering.
+
+    Parameter ``integrator`` (``mi.Integrator``):
+        Optional parameter to override the integrator of the scene.
+
+    Parameter ``spp`` (``int``):
+        Number of samples per pixel of the subsequent renderings (the value of
+        the scene description if ``spp=0``).
+
+    Parameter ``cache_dir`` (``str``):
+        Optional shared directory holding kernels and a manifest.
+
+    Parameter ``key`` (``str``):
+        Key of the configuration in the manifest. By default, it is made of
+        the variant, the integrator type, the film size and the sample count.
+        Several scenes sharing a directory should use distinct keys.
+
+    Parameter ``background`` (``bool``):
+        Whether the warmup runs on a background thread.
+
+    Returns → :py:class:`mitsuba.KernelWarmup`:
+        A handle to wait for the completion of the warmup.
+    """
+    import os, shutil, threading
+
+    assert isinstance(scene, mi.Scene)
+    handle = KernelWarmup()
+    if not dr.is_jit_v(mi.Float):
+        return handle
+
+    if integrator is None:
+        integrator = scene.integrator()
+    if integrator is None:
+        raise Exception('No integrator specified! Add an integrator in the scene '
+                        'description or provide an integrator directly as argument.')
+
+    if isinstance(sensor, int):
+        if len(scene.sensors()) == 0:
+            raise Exception('No sensor specified! Add a sensor in the scene '
+                            'description or provide a sensor directly as argument.')
+        sensor = scene.sensors()[sensor]
+
+    if key is None:
+        key = _warmup_key(scene, sensor, integrator, spp)
+
+    if cache_dir is not None:
+        prefetch_kernels(cache_dir, key)
+
+    def run():
+        local = _kernel_cache_path()
+        before = set(os.listdir(local)) if os.path.isdir(local) else set()
+
+        try:
+            with dr.scoped_set_flag(dr.JitFlag.KernelHistory, True):
+                dr.kernel_history()  # Clear the history
+                integrator.render(scene, sensor, seed=0, spp=spp)
+                dr.sync_thread()
+                history = dr.kernel_history()
+        except Exception as e:
+            handle.error = e
+            return
+
+        # Kernels compiled by the warmup, or loaded from the local cache
+        hashes = []
+        for entry in history:
+            h = entry.get('hash', None)
+            if isinstance(h, int):
+                hashes.append('%032x' % h)
+            elif isinstance(h, str):
+                hashes.append(h.lower().replace('0x', ''))
+
+        files = os.listdir(local) if os.path.isdir(local) else []
+        handle.kernels = sorted(f for f in files if f not in before or
+                                any(f.startswith(h) for h in hashes if h))
+
+        if cache_dir is None:
+            return
+
+        try:
+            os.makedirs(cache_dir, exist_ok=True)
+            for name in handle.kernels:
+                target = os.path.join(cache_dir, name)
+                if not os.path.exists(target):
+                    shutil.copyfile(os.path.join(local, name), target)
+
+            # Update the manifest atomically, since other processes may read it
+            import json
+            manifest = _read_manifest(cache_dir)
+            kernels = set(manifest.get(key, {}).get('kernels', [])) | set(handle.kernels)
+            manifest[key] = { 'variant': mi.variant(), 'kernels': sorted(kernels) }
+            path = _manifest_path(cache_dir)
+            tmp = '%s.%i.tmp' % (path, os.getpid())
+            with open(tmp, 'w') as f:
+                json.dump(manifest, f, indent=2)
+            os.replace(tmp, path)
+        except OSError as e:
+            handle.error = e
+
+    if background:
+        handle.thread = threading.Thread(target=run, daemon=True)
+        handle.thread.start()
+    else:
+        run()
+
+    return handle
+
 # ------------------------------------------------------------------------------
 
 def convert_to_bitmap(data, uint8_srgb=True):
@@ -272,6 +272,11 @@ std::string type_mask_to_string(Index type_mask) {
         oss << "needs_differentials ";
         type_mask = type_mask & ~BSDFFlags::NeedsDifferentials;
     }
+    if (has_flag(type_mask, BSDFFlags::Depolarizing)) {
+        add_separator();
+        oss << "depolarizing ";
+        type_mask = type_mask & ~BSDFFlags::Depolarizing;
+    }
 
     Assert(type_mask == 0);
     oss << "}";
@@ -0,0 +1,335 @@
+#include <mitsuba/render/bvh.h>
+#include <mitsuba/render/mesh.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
+#include <nanothread/nanothread.h>
+#include <algorithm>
+#include <numeric>
+
+NAMESPACE_BEGIN(mitsuba)
+
+NAMESPACE_BEGIN(detail)
+
+/// Node of the intermediate binary hierarchy created during BVH construction
+template <typename BoundingBox> struct BinaryBVHNode {
+    BoundingBox bbox;
+    /// Children of an inner node
+    uint32_t left = 0, right = 0;
+    /// Primitive range of a leaf node (count is zero for inner nodes)
+    uint32_t prim_offset = 0, prim_count = 0;
+
+    bool leaf() const { return prim_count > 0; }
+};
+
+/**
+ * \brief Convert a binary hierarchy into a wide one
+ *
+ * The children of a wide node are gathered by repeatedly replacing the inner
+ * child with the largest surface area by its two children, until \c Width
+ * children are found or only leaves remain.
+ */
+template <size_t Width, typename Node, typename BinaryNode>
+uint32_t collapse_bvh(const std::vector<BinaryNode> &binary, uint32_t index,
+                      std::vector<Node> &nodes) {
+    using ScalarFloat = dr::value_t<typename Node::FloatP>;
+
+    uint32_t node_index = (uint32_t) nodes.size();
+    nodes.emplace_back();
+
+    uint32_t children[Width], n = 0;
+    if (binary[index].leaf()) {
+        // Only happens for the root node
+        children[n++] = index;
+    } else {
+        children[n++] = binary[index].left;
+        children[n++] = binary[index].right;
+    }
+
+    while (n < Width) {
+        int32_t best = -1;
+        ScalarFloat best_area = -1.f;
+        for (uint32_t i = 0; i < n; ++i) {
+            const BinaryNode &c = binary[children[i]];
+            if (c.leaf())
+                continue;
+            ScalarFloat area = c.bbox.surface_area();
+            if (area > best_area) {
+                best_area = area;
+                best = (int32_t) i;
+            }
+        }
+        if (best < 0)
+            break;
+        const BinaryNode &c = binary[children[best]];
+        children[best] = c.left;
+        children[n++] = c.right;
+    }
+
+    Node node;
+    node.min_x = node.min_y = node.min_z = dr::Infinity<ScalarFloat>;
+    node.max_x = node.max_y = node.max_z = -dr::Infinity<ScalarFloat>;
+    for (size_t i = 0; i < Width; ++i) {
+        node.child[i] = 0;
+        node.count[i] = 0;
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+        const BinaryNode &c = binary[children[i]];
+        node.min_x.entry(i) = c.bbox.min.x();
+        node.min_y.entry(i) = c.bbox.min.y();
+        node.min_z.entry(i) = c.bbox.min.z();
+        node.max_x.entry(i) = c.bbox.max.x();
+        node.max_y.entry(i) = c.bbox.max.y();
+        node.max_z.entry(i) = c.bbox.max.z();
+
+        if (c.leaf()) {
+            node.child[i] = c.prim_offset;
+            node.count[i] = c.prim_count;
+        } else {
+            node.child[i] = collapse_bvh<Width>(binary, children[i], nodes);
+        }
+    }
+
+    nodes[node_index] = node;
+    return node_index;
+}
+
+NAMESPACE_END(detail)
+
+MI_VARIANT ShapeBVH<Float, Spectrum>::ShapeBVH(const Properties &props,
+                                               uint32_t width)
+    : m_width(width) {
+    if (width != 4 && width != 8)
+        Throw("ShapeBVH: unsupported node width %u (must be 4 or 8)!", width);
+
+    /* BVH construction: Maximum number of primitives per leaf node */
+    m_max_leaf_size = props.get<uint32_t>("bvh_max_leaf_size", 8);
+    if (m_max_leaf_size == 0)
+        Throw("ShapeBVH: \"bvh_max_leaf_size\" must be positive!");
+
+    /* BVH construction: Relative cost of a traversal step in the surface
+       area heuristic */
+    m_traversal_cost = props.get<ScalarFloat>("bvh_traversal_cost", 1.f);
+
+    /* BVH construction: Relative cost of a shape intersection operation in
+       the surface area heuristic */
+    m_intersection_cost = props.get<ScalarFloat>("bvh_intersection_cost", 1.f);
+
+    clear();
+}
+
+MI_VARIANT void ShapeBVH<Float, Spectrum>::clear() {
+    m_shapes.clear();
+    m_primitive_map = { 0 };
+    m_bbox.reset();
+    m_prim_shape.clear();
+    m_prim_index.clear();
+    m_nodes_4.clear();
+    m_nodes_8.clear();
+    m_memory.set(0);
+}
+
+MI_VARIANT void ShapeBVH<Float, Spectrum>::add_shape(Shape *shape) {
+    m_primitive_map.push_back(m_primitive_map.back() +
+                              shape->primitive_count());
+    m_shapes.push_back(shape);
+    m_bbox.expand(shape->bbox());
+}
+
+MI_VARIANT void ShapeBVH<Float, Spectrum>::build() {
+    using BinaryNode = detail::BinaryBVHNode<ScalarBoundingBox3f>;
+    constexpr uint32_t BinCount = 16;
+
+    Timer timer;
+    Index prim_count = primitive_count();
+
+    m_nodes_4.clear();
+    m_nodes_8.clear();
+    m_prim_shape.clear();
+    m_prim_index.clear();
+
+    Log(Info, "Building a SAH BVH%u (%u primitives) ..", m_width, prim_count);
+
+    if (prim_count == 0)
+        return;
+
+    // Compute primitive bounding boxes and centroids in parallel
+    std::vector<ScalarBoundingBox3f> bboxes(prim_count);
+    std::vector<ScalarPoint3f> centers(prim_count);
+
+    dr::parallel_for(
+        dr::blocked_range<Index>(0, prim_count, 4096),
+        [&](const dr::blocked_range<Index> &range) {
+            Index shape_index = Index(
+                std::upper_bound(m_primitive_map.begin(), m_primitive_map.end(),
+                                 range.begin()) - m_primitive_map.begin() - 1);
+
+            for (Index i = range.begin(); i != range.end(); ++i) {
+                while (i >= m_primitive_map[shape_index + 1])
+                    ++shape_index;
+                ScalarBoundingBox3f bbox =
+                    m_shapes[shape_index]->bbox(i - m_primitive_map[shape_index]);
+                bboxes[i] = bbox;
+                centers[i] = bbox.valid() ? bbox.center() : ScalarPoint3f(0.f);
+            }
+        }
+    );
+
+    std::vector<Index> indices(prim_count);
+    std::iota(indices.begin(), indices.end(), 0);
+
+    std::vector<BinaryNode> binary;
+    binary.reserve(2 * prim_count / m_max_leaf_size + 1);
+
+    auto area = [](const ScalarBoundingBox3f &b) -> ScalarFloat {
+        return b.valid() ? b.surface_area() : 0.f;
+    };
+
+    // Recursive binned SAH construction of the binary hierarchy
+    auto build_rec = [&](auto &self, Index begin, Index end,
+                         uint32_t depth) -> Index {
+        Index node_index = (Index) binary.size();
+        binary.emplace_back();
+
+        ScalarBoundingBox3f bbox, cbox;
+        for (Index i = begin; i < end; ++i) {
+            bbox.expand(bboxes[indices[i]]);
+            cbox.expand(centers[indices[i]]);
+        }
+        binary[node_index].bbox = bbox;
+
+        Index count = end - begin;
+        auto make_leaf = [&]() {
+            binary[node_index].prim_offset = begin;
+            binary[node_index].prim_count  = count;
+            return node_index;
+        };
+
+        if (count == 1 || depth + 1 >= MI_BVH_MAXDEPTH)
+            return make_leaf();
+
+        uint32_t axis = cbox.major_axis();
+        ScalarFloat extent = cbox.max[axis] - cbox.min[axis];
+        Index mid = begin + count / 2;
+
+        if (extent > 0.f) {
+            struct Bin {
+                ScalarBoundingBox3f bbox;
+                Index count = 0;
+            } bins[BinCount];
+
+            ScalarFloat scale = BinCount / extent * (1.f - dr::Epsilon<ScalarFloat>),
+                        offset = cbox.min[axis];
+            auto bin_index = [&](Index prim) {
+                return std::min(
+                    (uint32_t) ((centers[prim][axis] - offset) * scale),
+                    BinCount - 1);
+            };
+
+            for (Index i = begin; i < end; ++i) {
+                Bin &bin = bins[bin_index(indices[i])];
+                bin.bbox.expand(bboxes[indices[i]]);
+                bin.count++;
+            }
+
+            // Sweep from the right to accumulate the cost of the right side
+            ScalarFloat right_cost[BinCount];
+            ScalarBoundingBox3f acc;
+            Index acc_count = 0;
+            for (uint32_t i = BinCount - 1; i > 0; --i) {
+                acc.expand(bins[i].bbox);
+                acc_count += bins[i].count;
+                right_cost[i] = area(acc) * acc_count;
+            }
+
+            // Sweep from the left and find the best split position
+            acc.reset();
+            acc_count = 0;
+            uint32_t best_split = 0;
+            ScalarFloat best_cost = dr::Infinity<ScalarFloat>;
+            for (uint32_t i = 1; i < BinCount; ++i) {
+                acc.expand(bins[i - 1].bbox);
+                acc_count += bins[i - 1].count;
+                ScalarFloat cost = area(acc) * acc_count + right_cost[i];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_split = i;
+                }
+            }
+
+            best_cost = m_traversal_cost +
+                        m_intersection_cost * best_cost / area(bbox);
+            ScalarFloat leaf_cost = m_intersection_cost * count;
+
+            if (count <= m_max_leaf_size && best_cost >= leaf_cost)
+                return make_leaf();
+
+            mid = Index(std::partition(indices.begin() + begin,
+                                       indices.begin() + end,
+                                       [&](Index prim) {
+                                           return bin_index(prim) < best_split;
+                                       }) - indices.begin());
+
+            // Fall back to a median split in case of numerical issues
+            if (mid == begin || mid == end)
+                mid = begin + count / 2;
+        } else if (count <= m_max_leaf_size) {
+            // All centroids coincide, the primitives cannot be separated
+            return make_leaf();
+        }
+
+        Index left  = self(self, begin, mid, depth + 1),
+              right = self(self, mid, end, depth + 1);
+        binary[node_index].left  = left;
+        binary[node_index].right = right;
+        return node_index;
+    };
+
+    build_rec(build_rec, 0, prim_count, 0);
+
+    // Store the shape and primitive index of the reordered primitive list
+    m_prim_shape.resize(prim_count);
+    m_prim_index.resize(prim_count);
+    for (Index i = 0; i < prim_count; ++i) {
+        Index prim = indices[i],
+              shape_index = Index(
+                  std::upper_bound(m_primitive_map.begin(), m_primitive_map.end(),
+                                   prim) - m_primitive_map.begin() - 1);
+        m_prim_shape[i] = shape_index;
+        m_prim_index[i] = prim - m_primitive_map[shape_index];
+    }
+
+    size_t storage = m_prim_shape.size() * 2 * sizeof(Index), node_count;
+    if (m_width == 8) {
+        detail::collapse_bvh<8>(binary, 0, m_nodes_8);
+        node_count = m_nodes_8.size();
+        storage += node_count * sizeof(Node<8>);
+    } else {
+        detail::collapse_bvh<4>(binary, 0, m_nodes_4);
+        node_count = m_nodes_4.size();
+        storage += node_count * sizeof(Node<4>);
+    }
+    m_memory.set(storage);
+
+    Log(Info, "Finished BVH construction (%zu nodes, took %s, storage: %s).",
+        node_count, util::time_string((float) timer.value()),
+        util::mem_string(storage));
+}
+
+MI_VARIANT std::string ShapeBVH<Float, Spectrum>::to_string() const {
+    std::ostringstream oss;
+    oss << "ShapeBVH[" << std::endl
+        << "  width = " << m_width << "," << std::endl
+        << "  shapes = [" << std::endl;
+    for (auto shape : m_shapes)
+        oss << "    " << string::indent(shape, 4)
+            << "," << std::endl;
+    oss << "  ]" << std::endl << "]";
+    return oss.str();
+}
+
+MI_IMPLEMENT_CLASS_VARIANT(ShapeBVH, Object)
+MI_INSTANTIATE_CLASS(ShapeBVH)
+NAMESPACE_END(mitsuba)
@@ -25,7 +25,17 @@ void Emitter<Float, Spectrum>::traverse(TraversalCallback *callback) {
 
 MI_VARIANT
 void Emitter<Float, Spectrum>::parameters_changed(const std::vector<std::string> &keys) {
-    set_dirty(true);
+    /* The scene's emitter sampling distributions only depend on the sampling
+       weights and the placement of the emitters. Updates of the emitted
+       radiance alone don't require rebuilding them. */
+    bool appearance_only = !keys.empty();
+    for (const std::string &key : keys)
+        appearance_only &= key == "radiance" || key == "intensity" ||
+                           key == "irradiance" || key == "data" ||
+                           key == "scale";
+    if (!appearance_only)
+        set_dirty(true);
+
     Base::parameters_changed(keys);
 }
 
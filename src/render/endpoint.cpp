@@ -94,6 +94,12 @@ MI_VARIANT Float Endpoint<Float, Spectrum>::pdf_position(
     NotImplementedError("pdf_position");
 }
 
+MI_VARIANT Float Endpoint<Float, Spectrum>::pdf_ray_direction(
+    const PositionSample3f & /*ps*/, const Vector3f & /*d*/,
+    Mask /*active*/) const {
+    NotImplementedError("pdf_ray_direction");
+}
+
 MI_VARIANT Spectrum Endpoint<Float, Spectrum>::pdf_wavelengths(
     const Spectrum & /*wavelengths*/, Mask /*active*/) const {
     NotImplementedError("pdf_wavelengths");
@@ -83,6 +83,40 @@ Film<Float, Spectrum>::prepare_sample(const UnpolarizedSpectrum & /* spec */,
     NotImplementedError("prepare_sample");
 }
 
+MI_VARIANT void Film<Float, Spectrum>::write_async(const fs::path &path) const {
+    write(path);
+}
+
+MI_VARIANT void Film<Float, Spectrum>::write_storage(Stream * /* stream */) const {
+    NotImplementedError("write_storage");
+}
+
+MI_VARIANT void Film<Float, Spectrum>::read_storage(Stream * /* stream */,
+                                                  bool /* accumulate */) {
+    NotImplementedError("read_storage");
+}
+
+MI_VARIANT bool Film<Float, Spectrum>::streaming() const { return false; }
+
+MI_VARIANT void Film<Float, Spectrum>::flush_rows(uint32_t /* y */) { }
+
+MI_VARIANT void Film<Float, Spectrum>::put_tile(const ImageBlock *block) {
+    put_block(block);
+}
+
+MI_VARIANT typename Film<Float, Spectrum>::TensorXf
+Film<Float, Spectrum>::develop_region(const ScalarPoint2u & /* offset */,
+                                      const ScalarVector2u & /* size */,
+                                      bool /* raw */) const {
+    NotImplementedError("develop_region");
+}
+
+MI_VARIANT std::vector<std::pair<typename Film<Float, Spectrum>::ScalarPoint2u,
+                                 typename Film<Float, Spectrum>::TensorXf>>
+Film<Float, Spectrum>::develop_dirty() {
+    return { { ScalarPoint2u(0), develop() } };
+}
+
 MI_VARIANT const typename Film<Float, Spectrum>::Texture *
 Film<Float, Spectrum>::sensor_response_function() {
     return m_srf.get();
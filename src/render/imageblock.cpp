@@ -1,10 +1,37 @@
 #include <mitsuba/render/imageblock.h>
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/profiler.h>
+#include <mitsuba/core/stream.h>
+#include <mitsuba/core/util.h>
 #include <drjit/while_loop.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
+/**
+ * Splat a sample covering a footprint of (Taps x Taps) pixels in scalar
+ * variants. The fixed number of taps allows the compiler to unroll and
+ * vectorize the loops over the footprint.
+ */
+template <uint32_t Taps, typename Float>
+static void put_taps(Float *ptr, const Float *weights_x, const Float *weights_y,
+                     const Float *values, uint32_t channel_count,
+                     uint32_t row_stride) {
+    Float weights[Taps][Taps];
+    for (uint32_t y = 0; y < Taps; ++y)
+        for (uint32_t x = 0; x < Taps; ++x)
+            weights[y][x] = weights_x[x] * weights_y[y];
+
+    for (uint32_t y = 0; y < Taps; ++y) {
+        Float *row = ptr;
+        for (uint32_t x = 0; x < Taps; ++x) {
+            for (uint32_t k = 0; k < channel_count; ++k)
+                row[k] = dr::fmadd(values[k], weights[y][x], row[k]);
+            row += channel_count;
+        }
+        ptr += row_stride;
+    }
+}
+
 MI_VARIANT
 ImageBlock<Float, Spectrum>::ImageBlock(const ScalarVector2u &size,
                                         const ScalarPoint2i &offset,
@@ -63,6 +90,8 @@ ImageBlock<Float, Spectrum>::ImageBlock(const TensorXf &tensor,
         m_tensor = TensorXf(tensor.array().copy(), 3, tensor.shape().data());
     else
         m_tensor = TensorXf(tensor.array(), 3, tensor.shape().data());
+
+    update_memory_usage();
 }
 
 MI_VARIANT ImageBlock<Float, Spectrum>::~ImageBlock() { }
@@ -79,6 +108,104 @@ MI_VARIANT void ImageBlock<Float, Spectrum>::clear() {
 
     if (m_compensate)
         m_tensor_compensation = TensorXf(dr::zeros<Array>(size_flat), 3, shape);
+
+    allocate_partial_images();
+    update_memory_usage();
+}
+
+MI_VARIANT void ImageBlock<Float, Spectrum>::write(Stream *stream) const {
+    using Array = typename TensorXf::Array;
+
+    stream->write("IMB", 3);
+    stream->write(uint8_t(1)); // file format version
+    stream->write(m_size.x());
+    stream->write(m_size.y());
+    stream->write(m_border_size);
+    stream->write(m_channel_count);
+    stream->write(uint8_t(m_compensate));
+
+    flush_partial_images();
+
+    auto write_array = [&](const Array &value) {
+        if constexpr (dr::is_jit_v<Float>) {
+            auto &&host = dr::migrate(value, AllocType::Host);
+            dr::sync_thread();
+            stream->write_array(host.data(), host.size());
+        } else {
+            stream->write_array(value.data(), value.size());
+        }
+    };
+
+    write_array(m_tensor.array());
+    if (m_compensate)
+        write_array(m_tensor_compensation.array());
+}
+
+MI_VARIANT void ImageBlock<Float, Spectrum>::read(Stream *stream, bool accumulate) {
+    using Array = typename TensorXf::Array;
+    using ScalarArray = dr::DynamicArray<ScalarFloat>;
+
+    char header[3];
+    stream->read(header, 3);
+    if (header[0] != 'I' || header[1] != 'M' || header[2] != 'B')
+        Throw("ImageBlock::read(): invalid file format!");
+
+    uint8_t version;
+    stream->read(version);
+    if (version != 1)
+        Throw("ImageBlock::read(): unsupported version %i!", (int) version);
+
+    uint32_t width, height, border_size, channel_count;
+    uint8_t compensate;
+    stream->read(width);
+    stream->read(height);
+    stream->read(border_size);
+    stream->read(channel_count);
+    stream->read(compensate);
+
+    if (width != m_size.x() || height != m_size.y() ||
+        border_size != m_border_size || channel_count != m_channel_count)
+        Throw("ImageBlock::read(): incompatible image block (%ux%u, border "
+              "%u, %u channels), expected %ux%u, border %u, %u channels!",
+              width, height, border_size, channel_count, m_size.x(),
+              m_size.y(), m_border_size, m_channel_count);
+
+    ScalarVector2u size_ext = m_size + 2 * m_border_size;
+    size_t size_flat = m_channel_count * dr::prod(size_ext),
+           shape[3]  = { size_ext.y(), size_ext.x(), m_channel_count };
+
+    auto read_array = [&]() -> Array {
+        ScalarArray host = dr::empty<ScalarArray>(size_flat);
+        stream->read_array(host.data(), size_flat);
+        if constexpr (dr::is_jit_v<Float>)
+            return dr::load<Array>(host.data(), size_flat);
+        else
+            return host;
+    };
+
+    Array value = read_array();
+
+    flush_partial_images();
+
+    if (compensate) {
+        Array comp = read_array();
+        if (m_compensate && !accumulate) {
+            m_tensor = TensorXf(value, 3, shape);
+            m_tensor_compensation = TensorXf(comp, 3, shape);
+            update_memory_usage();
+            return;
+        }
+        value += comp;
+    }
+
+    if (accumulate) {
+        m_tensor.array() += value;
+    } else {
+        m_tensor = TensorXf(value, 3, shape);
+        if (m_compensate)
+            m_tensor_compensation = TensorXf(dr::zeros<Array>(size_flat), 3, shape);
+        update_memory_usage();
+    }
 }
 
 MI_VARIANT void
@@ -99,9 +226,75 @@ ImageBlock<Float, Spectrum>::set_size(const ScalarVector2u &size) {
         m_tensor_compensation = TensorXf(dr::zeros<Array>(size_flat), 3, shape);
 
     m_size = size;
+    allocate_partial_images();
+    update_memory_usage();
+}
+
+MI_VARIANT void ImageBlock<Float, Spectrum>::update_memory_usage() {
+    size_t count = m_tensor.array().size() +
+                   m_tensor_compensation.array().size() +
+                   m_tensor_partial.size();
+    m_memory.set(count * sizeof(dr::scalar_t<Float>), dr::is_cuda_v<Float>);
+}
+
+MI_VARIANT void ImageBlock<Float, Spectrum>::set_partial_images(uint32_t count,
+                                                                size_t memory_limit) {
+    m_partial_request = count == 0 ? (uint32_t) util::core_count() : count;
+    m_partial_limit = memory_limit;
+    flush_partial_images();
+    allocate_partial_images();
+    update_memory_usage();
+}
+
+MI_VARIANT void ImageBlock<Float, Spectrum>::allocate_partial_images() {
+    uint32_t count = 1;
+
+    if constexpr (dr::is_llvm_v<Float>) {
+        size_t size_flat = m_tensor.array().size(),
+               bytes     = size_flat * sizeof(ScalarFloat);
+
+        if (!m_compensate && m_partial_request > 1 && size_flat > 0) {
+            // Bound the memory usage and the extent of the partial indices
+            size_t limit = std::min(m_partial_limit / bytes,
+                                    (size_t) 0xFFFFFFFFu / size_flat);
+            count = (uint32_t) std::min((size_t) m_partial_request, limit);
+            if (count < m_partial_request)
+                Log(Debug, "ImageBlock: using %u instead of %u partial images "
+                    "to respect the memory limit.", std::max(count, 1u),
+                    m_partial_request);
+            count = std::max(count, 1u);
+        }
+
+        m_tensor_partial = count > 1 ? dr::zeros<Float>(count * size_flat)
+                                     : Float();
+        m_partial_dirty = false;
+    }
+
+    m_partial_count = count;
+}
+
+MI_VARIANT void ImageBlock<Float, Spectrum>::flush_partial_images() const {
+    if constexpr (dr::is_llvm_v<Float>) {
+        if (!m_partial_dirty)
+            return;
+
+        Float &target = const_cast<ImageBlock &>(*this).m_tensor.array();
+        uint32_t size_flat = (uint32_t) target.size();
+        UInt32 index = dr::arange<UInt32>(size_flat);
+
+        Float sum = target;
+        for (uint32_t i = 0; i < m_partial_count; ++i)
+            sum += dr::gather<Float>(m_tensor_partial, index + i * size_flat);
+        target = sum;
+
+        m_tensor_partial = dr::zeros<Float>(m_tensor_partial.size());
+        m_partial_dirty = false;
+    }
 }
 
 MI_VARIANT typename ImageBlock<Float, Spectrum>::TensorXf &ImageBlock<Float, Spectrum>::tensor() {
+    flush_partial_images();
+
     if constexpr (dr::is_jit_v<Float>) {
         if (m_compensate) {
             Float &comp = m_tensor_compensation.array();
@@ -118,11 +311,22 @@ MI_VARIANT const typename ImageBlock<Float, Spectrum>::TensorXf &ImageBlock<Floa
 
 MI_VARIANT void ImageBlock<Float, Spectrum>::accum(Float value, UInt32 index, Bool active) {
     if constexpr (dr::is_jit_v<Float>) {
-        if (m_compensate)
+        if (m_compensate) {
             dr::scatter_add_kahan(m_tensor.array(),
                                   m_tensor_compensation.array(),
                                   value, index, active);
-        else
+        } else if (m_partial_count > 1) {
+            /* Map contiguous ranges of the wavefront to separate partial
+               images. The LLVM backend assigns such ranges to its worker
+               threads, which therefore rarely write to the same memory. */
+            uint32_t width = (uint32_t) dr::width(value, index, active),
+                     block = (width + m_partial_count - 1) / m_partial_count;
+            UInt32 slot = dr::arange<UInt32>(width) / std::max(block, 1u);
+            dr::scatter_reduce(ReduceOp::Add, m_tensor_partial, value,
+                               dr::fmadd(slot, (uint32_t) m_tensor.array().size(), index),
+                               active);
+            m_partial_dirty = true;
+        } else
             dr::scatter_reduce(ReduceOp::Add, m_tensor.array(),
                                value, index, active);
     } else {
@@ -171,6 +375,73 @@ MI_VARIANT void ImageBlock<Float, Spectrum>::put_block(const ImageBlock *block)
     }
 }
 
+MI_VARIANT void ImageBlock<Float, Spectrum>::put_tile(const ImageBlock *block,
+                                                      std::mutex *row_locks) {
+    ScopedPhase sp(ProfilerPhase::ImageBlockPut);
+
+    if (unlikely(block->channel_count() != channel_count()))
+        Throw("ImageBlock::put_tile(): mismatched channel counts! (%u, "
+              "expected %u)", block->channel_count(), channel_count());
+
+    if constexpr (dr::is_jit_v<Float>) {
+        DRJIT_MARK_USED(row_locks);
+        Throw("ImageBlock::put_tile(): not supported in JIT variants, use "
+              "put_block() instead!");
+    } else {
+        ScalarVector2i source_size(block->size() + 2 * block->border_size()),
+                       target_size(       size() + 2 *        border_size());
+
+        // Position of the source block within this one
+        ScalarVector2i shift = (block->offset() - block->border_size()) -
+                               (offset() - border_size());
+
+        /* Pixels of the interior that are further than the border size away
+           from its edges can't be reached by any other concurrent block */
+        int32_t border = (int32_t) block->border_size();
+        ScalarPoint2i core_0 = shift + 2 * border,
+                      core_1 = shift + source_size - 2 * border;
+
+        int32_t x_0 = std::max(shift.x(), 0),
+                x_1 = std::min(shift.x() + source_size.x(), target_size.x()),
+                y_0 = std::max(shift.y(), 0),
+                y_1 = std::min(shift.y() + source_size.y(), target_size.y());
+
+        if (x_0 >= x_1)
+            return;
+
+        uint32_t channels = channel_count();
+        const ScalarFloat *source = block->tensor().data();
+        ScalarFloat *target = m_tensor.data();
+
+        // Accumulate the pixels [x0, x1) of row 'y' (in target coordinates)
+        auto add = [&](int32_t y, int32_t x0, int32_t x1) {
+            if (x0 >= x1)
+                return;
+            const ScalarFloat *src = source +
+                ((size_t) (y - shift.y()) * source_size.x() + (x0 - shift.x())) * channels;
+            ScalarFloat *dst = target + ((size_t) y * target_size.x() + x0) * channels;
+            for (size_t i = 0, n = (size_t) (x1 - x0) * channels; i < n; ++i)
+                dst[i] += src[i];
+        };
+
+        for (int32_t y = y_0; y < y_1; ++y) {
+            if (y >= core_0.y() && y < core_1.y() && core_0.x() < core_1.x()) {
+                int32_t c0 = dr::clip(core_0.x(), x_0, x_1),
+                        c1 = dr::clip(core_1.x(), c0, x_1);
+
+                add(y, c0, c1);
+
+                std::lock_guard<std::mutex> guard(row_locks[y]);
+                add(y, x_0, c0);
+                add(y, c1, x_1);
+            } else {
+                std::lock_guard<std::mutex> guard(row_locks[y]);
+                add(y, x_0, x_1);
+            }
+        }
+    }
+}
+
 MI_VARIANT void ImageBlock<Float, Spectrum>::put(const Point2f &pos,
                                                  const Float *values,
                                                  Mask active) {
@@ -291,6 +562,75 @@ MI_VARIANT void ImageBlock<Float, Spectrum>::put(const Point2f &pos,
 
         Point2f rel_f = Point2f(pos_0_u) - pos_f;
 
+        if constexpr (!JIT) {
+            // ===========================================================
+            // 1.0. Scalar mode / look up tabulated filter weights
+            // ===========================================================
+
+            Point2f base = dr::floor(pos_f);
+            Vector2f u = pos_f - base;
+
+            const ScalarFloat *table_x = m_rfilter->offset_weights(u.x()),
+                              *table_y = m_rfilter->offset_weights(u.y());
+
+            if (table_x && table_y) {
+                // Skip the table entries preceding the first covered pixel
+                Vector2i skip = Point2i(pos_0_u) - Point2i(base) -
+                                m_rfilter->offset_first_tap();
+                table_x += skip.x();
+                table_y += skip.y();
+
+                ScalarFloat *weights_x =
+                    (ScalarFloat *) alloca(sizeof(ScalarFloat) * count.x());
+                for (uint32_t x = 0; x < count.x(); ++x)
+                    weights_x[x] = table_x[x];
+
+                // Normalize sample contribution if desired
+                if (unlikely(m_normalize)) {
+                    const ScalarFloat *row_x = table_x - skip.x(),
+                                      *row_y = table_y - skip.y();
+                    ScalarFloat wx = 0.f, wy = 0.f;
+                    for (uint32_t i = 0; i < m_rfilter->offset_taps(); ++i) {
+                        wx += row_x[i];
+                        wy += row_y[i];
+                    }
+
+                    ScalarFloat factor = wx * wy;
+                    if (unlikely(factor == 0))
+                        return;
+                    factor = dr::rcp(factor);
+
+                    for (uint32_t x = 0; x < count.x(); ++x)
+                        weights_x[x] *= factor;
+                }
+
+                ScalarFloat *ptr = m_tensor.array().data() + index;
+                uint32_t row_stride = size.x() * m_channel_count;
+
+                // Specialized versions for the footprints of common filters
+                switch (count.x() == count.y() ? count.x() : 0) {
+                    case 2: put_taps<2>(ptr, weights_x, table_y, values, m_channel_count, row_stride); break;
+                    case 3: put_taps<3>(ptr, weights_x, table_y, values, m_channel_count, row_stride); break;
+                    case 4: put_taps<4>(ptr, weights_x, table_y, values, m_channel_count, row_stride); break;
+                    case 6: put_taps<6>(ptr, weights_x, table_y, values, m_channel_count, row_stride); break;
+
+                    default:
+                        for (uint32_t y = 0; y < count.y(); ++y) {
+                            ScalarFloat *row = ptr + y * row_stride;
+                            for (uint32_t x = 0; x < count.x(); ++x) {
+                                ScalarFloat weight = weights_x[x] * table_y[y];
+                                for (uint32_t k = 0; k < m_channel_count; ++k)
+                                    row[k] = dr::fmadd(values[k], weight, row[k]);
+                                row += m_channel_count;
+                            }
+                        }
+                        break;
+                }
+
+                return;
+            }
+        }
+
         if (!record_loop) {
             // ===========================================================
             // 1.1. Scalar mode / unroll the complete loop
@@ -566,6 +906,8 @@ MI_VARIANT void ImageBlock<Float, Spectrum>::read(const Point2f &pos_,
     // Account for image block offset
     Point2f pos = pos_ - ScalarVector2f(m_offset);
 
+    flush_partial_images();
+
     // ===================================================================
     //  Fast special case for the box filter
     // ===================================================================
@@ -804,6 +1146,7 @@ MI_VARIANT std::string ImageBlock<Float, Spectrum>::to_string() const {
         << "  normalize = " << m_normalize << "," << std::endl
         << "  coalesce = " << m_coalesce << "," << std::endl
         << "  compensate = " << m_compensate << "," << std::endl
+        << "  partial_images = " << m_partial_count << "," << std::endl
         << "  warn_negative = " << m_warn_negative << "," << std::endl
         << "  warn_invalid = " << m_warn_invalid << "," << std::endl
         << "  rfilter = " << (m_rfilter ? string::indent(m_rfilter) : "BoxFilter[]")
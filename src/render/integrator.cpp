@@ -1,13 +1,21 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
 #include <mutex>
+#include <sstream>
+#include <unordered_map>
 
 #include <drjit/morton.h>
 #include <mitsuba/core/fwd.h>
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/profiler.h>
 #include <mitsuba/core/progress.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/fstream.h>
+#include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/film.h>
 #include <mitsuba/render/integrator.h>
 #include <mitsuba/render/sampler.h>
@@ -19,14 +27,515 @@ NAMESPACE_BEGIN(mitsuba)
 
 // -----------------------------------------------------------------------------
 
+static constexpr uint32_t render_counter_count =
+    (uint32_t) RenderCounter::RenderCounterCount;
+
+static std::atomic<bool> render_statistics_enabled { false };
+
+/* Per-thread counters of the render statistics in scalar variants. Every
+   counter is only ever modified by its owning thread, hence relaxed loads and
+   stores suffice (and compile to plain memory accesses). The render job merges
+   them once all of its blocks are done. */
+struct ThreadRenderCounters;
+
+static std::mutex render_counters_mutex;
+static std::vector<ThreadRenderCounters *> render_counters_threads;
+static RenderStatistics render_counters_retired;
+
+struct ThreadRenderCounters {
+    std::atomic<uint64_t> values[render_counter_count] { };
+    std::atomic<uint32_t> max_path_length { 0 };
+
+    ThreadRenderCounters() {
+        std::lock_guard<std::mutex> guard(render_counters_mutex);
+        render_counters_threads.push_back(this);
+    }
+
+    ~ThreadRenderCounters() {
+        std::lock_guard<std::mutex> guard(render_counters_mutex);
+        merge_into(render_counters_retired);
+        render_counters_threads.erase(std::find(render_counters_threads.begin(),
+                                                render_counters_threads.end(), this));
+    }
+
+    void add(RenderCounter counter, uint64_t value) {
+        std::atomic<uint64_t> &v = values[(uint32_t) counter];
+        v.store(v.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void merge_into(RenderStatistics &stats) const {
+        for (uint32_t i = 0; i < render_counter_count; ++i)
+            stats.counters[i] += values[i].load(std::memory_order_relaxed);
+        stats.max_path_length = std::max(
+            stats.max_path_length, max_path_length.load(std::memory_order_relaxed));
+    }
+};
+
+static thread_local ThreadRenderCounters thread_render_counters;
+
+/// Reset the counters of all threads (called while no render job is running)
+static void render_counters_reset() {
+    std::lock_guard<std::mutex> guard(render_counters_mutex);
+    render_counters_retired = RenderStatistics();
+    for (ThreadRenderCounters *tc : render_counters_threads) {
+        for (uint32_t i = 0; i < render_counter_count; ++i)
+            tc->values[i].store(0, std::memory_order_relaxed);
+        tc->max_path_length.store(0, std::memory_order_relaxed);
+    }
+}
+
+/// Merge the counters of all threads
+static RenderStatistics render_counters_merge() {
+    std::lock_guard<std::mutex> guard(render_counters_mutex);
+    RenderStatistics stats = render_counters_retired;
+    for (ThreadRenderCounters *tc : render_counters_threads)
+        tc->merge_into(stats);
+    return stats;
+}
+
+void RenderStatistics::set_enabled(bool enabled) {
+    render_statistics_enabled = enabled;
+}
+
+bool RenderStatistics::enabled() {
+    return render_statistics_enabled;
+}
+
+// -----------------------------------------------------------------------------
+
+static std::atomic<bool> ray_capture_enabled { false };
+
+/* State of the ray capture. The per-thread buffers of scalar variants are only
+   appended to by their owning thread while a render job is running, and
+   gathered once it completes. */
+struct ThreadRayCapture;
+
+static std::mutex ray_capture_mutex;
+static fs::path ray_capture_path;
+static uint32_t ray_capture_interval = 1;
+static uint32_t ray_capture_jobs = 0;
+static size_t ray_capture_max_rays = 0;
+static std::atomic<size_t> ray_capture_count { 0 };
+static std::vector<ThreadRayCapture *> ray_capture_threads;
+static std::vector<RayCapture::Record> ray_capture_retired;
+
+struct ThreadRayCapture {
+    std::vector<RayCapture::Record> records;
+
+    ThreadRayCapture() {
+        std::lock_guard<std::mutex> guard(ray_capture_mutex);
+        ray_capture_threads.push_back(this);
+    }
+
+    ~ThreadRayCapture() {
+        std::lock_guard<std::mutex> guard(ray_capture_mutex);
+        ray_capture_retired.insert(ray_capture_retired.end(), records.begin(),
+                                   records.end());
+        ray_capture_threads.erase(std::find(ray_capture_threads.begin(),
+                                            ray_capture_threads.end(), this));
+    }
+};
+
+static thread_local ThreadRayCapture thread_ray_capture;
+
+/// Append the rays of a render job to the capture file
+static void ray_capture_write(uint32_t job, const RayCapture::Record *records,
+                              size_t count) {
+    std::lock_guard<std::mutex> guard(ray_capture_mutex);
+    ref<FileStream> fs = new FileStream(ray_capture_path, FileStream::EReadWrite);
+    fs->seek(fs->size());
+    fs->write(job);
+    fs->write((uint64_t) count);
+    fs->write(records, count * sizeof(RayCapture::Record));
+
+    Log(Info, "Captured %zu rays of render job %u into \"%s\".", count, job,
+        ray_capture_path);
+}
+
+void RayCapture::start(const fs::path &filename, uint32_t interval,
+                       size_t max_rays) {
+    if (interval == 0)
+        Throw("RayCapture::start(): the interval must be positive!");
+
+    std::lock_guard<std::mutex> guard(ray_capture_mutex);
+    /* scope */ {
+        ref<FileStream> fs = new FileStream(filename, FileStream::ETruncReadWrite);
+        fs->write("MRC", 3);
+        fs->write(uint8_t(1)); // file format version
+    }
+    ray_capture_path = filename;
+    ray_capture_interval = interval;
+    ray_capture_max_rays = max_rays;
+    ray_capture_jobs = 0;
+    ray_capture_enabled = true;
+}
+
+void RayCapture::stop() {
+    ray_capture_enabled = false;
+}
+
+bool RayCapture::enabled() {
+    return ray_capture_enabled;
+}
+
+std::string RenderStatistics::to_string() const {
+    std::ostringstream oss;
+    oss << "Render statistics: " << counter(RenderCounter::Samples)
+        << " samples (" << std::fixed << std::setprecision(3)
+        << samples_per_second() * 1e-6 << " M/s)";
+
+    uint64_t paths = counter(RenderCounter::Paths);
+    if (paths > 0) {
+        auto percent = [paths](uint64_t value) {
+            return 100.0 * (double) value / (double) paths;
+        };
+        oss << ", path length " << std::setprecision(2)
+            << average_path_length() << " on average and " << max_path_length
+            << " at most, terminated by escaping "
+            << std::setprecision(1) << percent(counter(RenderCounter::Escaped))
+            << "%, Russian roulette "
+            << percent(counter(RenderCounter::RussianRoulette))
+            << "%, maximum depth " << percent(counter(RenderCounter::MaxDepth))
+            << "%, absorption " << percent(counter(RenderCounter::Absorbed))
+            << "%";
+    }
+
+    if (counter(RenderCounter::ExtensionRays) > 0)
+        oss << ", " << counter(RenderCounter::ExtensionRays)
+            << " extension and " << counter(RenderCounter::ShadowRays)
+            << " shadow rays (ratio " << std::setprecision(3)
+            << shadow_ray_ratio() << ")";
+
+    return oss.str();
+}
+
+// -----------------------------------------------------------------------------
+
+/// Configuration of a render job, used to validate checkpoints upon resuming
+struct CheckpointHeader {
+    uint32_t seed, spp, spp_per_pass, block_size, width, height, units,
+             partition_index, partition_count, block_order;
+
+    bool operator==(const CheckpointHeader &h) const {
+        return seed == h.seed && spp == h.spp &&
+               spp_per_pass == h.spp_per_pass && block_size == h.block_size &&
+               width == h.width && height == h.height && units == h.units &&
+               partition_index == h.partition_index &&
+               partition_count == h.partition_count &&
+               block_order == h.block_order;
+    }
+
+    void write(Stream *stream) const {
+        for (uint32_t value : { seed, spp, spp_per_pass, block_size, width,
+                                height, units, partition_index,
+                                partition_count, block_order })
+            stream->write(value);
+    }
+
+    void read(Stream *stream) {
+        for (uint32_t *value : { &seed, &spp, &spp_per_pass, &block_size,
+                                 &width, &height, &units, &partition_index,
+                                 &partition_count, &block_order })
+            stream->read(*value);
+    }
+};
+
+/**
+ * Write a checkpoint containing the job configuration, the list of completed
+ * work units (blocks or passes), and the film storage. The file is first
+ * written to a temporary location and then renamed, so that an interruption
+ * during this step never leaves behind a corrupted checkpoint.
+ */
+template <typename Film>
+void write_checkpoint(const fs::path &path, const CheckpointHeader &header,
+                      const std::vector<uint8_t> &done, const Film *film) {
+    fs::path tmp_path = path.string() + ".tmp";
+
+    /* scope */ {
+        ref<FileStream> fs = new FileStream(tmp_path, FileStream::ETruncReadWrite);
+        fs->write("MCK", 3);
+        fs->write(uint8_t(2)); // file format version
+        header.write(fs);
+        fs->write_array(done.data(), done.size());
+        film->write_storage(fs);
+    }
+
+    if (!fs::rename(tmp_path, path))
+        Throw("Could not write checkpoint \"%s\"!", path);
+
+    Log(Debug, "Wrote checkpoint \"%s\".", path);
+}
+
+/**
+ * Load a checkpoint created by \ref write_checkpoint(). Returns \c false if
+ * the file does not exist, and throws if it was produced by an incompatible
+ * render job.
+ */
+template <typename Film>
+bool read_checkpoint(const fs::path &path, const CheckpointHeader &header,
+                     std::vector<uint8_t> &done, Film *film) {
+    if (!fs::exists(path))
+        return false;
+
+    ref<FileStream> fs = new FileStream(path);
+    char magic[3];
+    uint8_t version;
+    fs->read(magic, 3);
+    fs->read(version);
+    if (magic[0] != 'M' || magic[1] != 'C' || magic[2] != 'K' || version != 2)
+        Throw("\"%s\": not a valid checkpoint file!", path);
+
+    CheckpointHeader header_file { };
+    header_file.read(fs);
+    if (!(header_file == header))
+        Throw("\"%s\": checkpoint was created by a render job with a different "
+              "configuration (seed, sample count, block size, block order, "
+              "resolution, or partition)!", path);
+
+    done.resize(header.units);
+    fs->read_array(done.data(), done.size());
+    film->read_storage(fs);
+    return true;
+}
+
+/**
+ * NUMA mode: pin the calling thread pool worker to a core and return the
+ * NUMA node it was assigned to. Workers are distributed round-robin over the
+ * nodes, and the pinning persists for the lifetime of the worker. Threads
+ * that are not part of the pool (e.g. the main thread) are never pinned.
+ */
+static uint32_t numa_pin_worker(const std::vector<std::vector<uint32_t>> &node_cores) {
+    uint32_t worker = pool_thread_id();
+    if (worker == 0)
+        return 0;
+
+    uint32_t node_count = (uint32_t) node_cores.size(),
+             node       = (worker - 1) % node_count;
+    const std::vector<uint32_t> &cores = node_cores[node];
+
+    Thread *thread = Thread::thread();
+    if (thread->core_affinity() == -1)
+        thread->set_core_affinity(
+            (int) cores[((worker - 1) / node_count) % cores.size()]);
+
+    return node;
+}
+
+// -----------------------------------------------------------------------------
+
 MI_VARIANT Integrator<Float, Spectrum>::Integrator(const Properties & props)
-    : m_stop(false), m_id(props.id()) {
+    : m_stop(false), m_passes_completed(0), m_id(props.id()) {
     m_timeout = props.get<ScalarFloat>("timeout", -1.f);
 
+    // Open-ended progressive rendering (until timeout or target error)
+    m_progressive = props.get<bool>("progressive", false);
+    m_target_error = props.get<ScalarFloat>("target_error", 0.f);
+    if (m_target_error < 0.f)
+        Throw("\"target_error\" must be non-negative!");
+
+    // Interval between checkpoints (in seconds, see set_checkpoint())
+    m_checkpoint_interval = props.get<ScalarFloat>("checkpoint_interval", -1.f);
+    m_resume = false;
+
+    m_partition_index = 0;
+    m_partition_count = 1;
+
     // Disable direct visibility of emitters if needed
     m_hide_emitters = props.get<bool>("hide_emitters", false);
 }
 
+MI_VARIANT void Integrator<Float, Spectrum>::statistics_begin(bool evaluate) {
+    /* The counters of JIT variants can only be read once the rendering
+       kernels have run */
+    m_collect_stats = RenderStatistics::enabled() &&
+                      (evaluate || !dr::is_jit_v<Float>);
+    if (!m_collect_stats)
+        return;
+
+    m_render_stats = RenderStatistics();
+    if constexpr (dr::is_jit_v<Float>) {
+        m_stats_counters = dr::zeros<DynamicBuffer<UInt64>>(render_counter_count);
+        m_stats_max_length = dr::zeros<DynamicBuffer<UInt32>>(1);
+    } else {
+        render_counters_reset();
+    }
+}
+
+MI_VARIANT void Integrator<Float, Spectrum>::statistics_end(bool log) {
+    if (!m_collect_stats)
+        return;
+    m_collect_stats = false;
+
+    RenderStatistics stats;
+    if constexpr (dr::is_jit_v<Float>) {
+        dr::eval(m_stats_counters, m_stats_max_length);
+        for (uint32_t i = 0; i < render_counter_count; ++i)
+            stats.counters[i] = (uint64_t) dr::slice(m_stats_counters, i);
+        stats.max_path_length = (uint32_t) dr::slice(m_stats_max_length, 0);
+        m_stats_counters = DynamicBuffer<UInt64>();
+        m_stats_max_length = DynamicBuffer<UInt32>();
+    } else {
+        stats = render_counters_merge();
+    }
+    stats.time = m_render_timer.value() / 1000.0;
+    m_render_stats = stats;
+
+    if (log)
+        Log(Info, "%s", stats.to_string());
+}
+
+MI_VARIANT void Integrator<Float, Spectrum>::capture_begin(bool evaluate) {
+    // Like the render statistics, captured rays are only known once evaluated
+    m_capture_rays = false;
+    if (!ray_capture_enabled || (dr::is_jit_v<Float> && !evaluate))
+        return;
+
+    /* scope */ {
+        std::lock_guard<std::mutex> guard(ray_capture_mutex);
+        m_capture_job = ray_capture_jobs++;
+        if (m_capture_job % ray_capture_interval != 0)
+            return;
+        m_capture_capacity = ray_capture_max_rays;
+
+        if constexpr (!dr::is_jit_v<Float>) {
+            ray_capture_retired.clear();
+            for (ThreadRayCapture *tc : ray_capture_threads)
+                tc->records.clear();
+            ray_capture_count = 0;
+        }
+    }
+
+    if constexpr (dr::is_jit_v<Float>) {
+        constexpr size_t words = sizeof(RayCapture::Record) / sizeof(uint32_t);
+        m_capture_data = dr::empty<DynamicBuffer<UInt32>>(m_capture_capacity * words);
+        m_capture_count = dr::zeros<DynamicBuffer<UInt32>>(1);
+    }
+
+    m_capture_rays = true;
+}
+
+MI_VARIANT void Integrator<Float, Spectrum>::capture_end() {
+    if (!m_capture_rays)
+        return;
+    m_capture_rays = false;
+
+    size_t count;
+    if constexpr (dr::is_jit_v<Float>) {
+        dr::eval(m_capture_data, m_capture_count);
+        count = (size_t) (uint32_t) dr::slice(m_capture_count, 0);
+        size_t stored = std::min(count, m_capture_capacity);
+
+        DynamicBuffer<UInt32> data = dr::migrate(m_capture_data, AllocType::Host);
+        dr::sync_thread();
+        ray_capture_write(m_capture_job,
+                          (const RayCapture::Record *) data.data(), stored);
+
+        m_capture_data = DynamicBuffer<UInt32>();
+        m_capture_count = DynamicBuffer<UInt32>();
+    } else {
+        std::vector<RayCapture::Record> records;
+        /* scope */ {
+            std::lock_guard<std::mutex> guard(ray_capture_mutex);
+            records = std::move(ray_capture_retired);
+            ray_capture_retired.clear();
+            for (ThreadRayCapture *tc : ray_capture_threads) {
+                records.insert(records.end(), tc->records.begin(),
+                               tc->records.end());
+                tc->records.clear();
+            }
+        }
+        count = ray_capture_count;
+        ray_capture_write(m_capture_job, records.data(), records.size());
+    }
+
+    if (count > m_capture_capacity)
+        Log(Warn, "Ray capture: render job %u traced %zu rays, only the first "
+                  "%zu were recorded (see the 'max_rays' parameter).",
+            m_capture_job, count, m_capture_capacity);
+}
+
+MI_VARIANT void
+Integrator<Float, Spectrum>::record_ray_impl(const Ray3f &ray,
+                                             const UInt32 &depth,
+                                             const Mask &coherent, bool shadow,
+                                             const Mask &active) const {
+    UInt32 info = dr::minimum(depth, (uint32_t) RayCapture::DepthMask) |
+                  dr::select(coherent, (uint32_t) RayCapture::CoherentRay, 0u);
+    if (shadow)
+        info |= (uint32_t) RayCapture::ShadowRay;
+
+    if constexpr (dr::is_jit_v<Float>) {
+        constexpr uint32_t words = sizeof(RayCapture::Record) / sizeof(uint32_t);
+        UInt32 slot = dr::scatter_inc(m_capture_count, UInt32(0), active);
+        Mask valid = active && slot < (uint32_t) m_capture_capacity;
+        UInt32 offset = slot * words;
+
+        auto put = [&](uint32_t i, const Float &value) {
+            dr::scatter(m_capture_data,
+                        dr::reinterpret_array<UInt32>(
+                            dr::float32_array_t<Float>(dr::detach(value))),
+                        offset + i, valid);
+        };
+        for (uint32_t i = 0; i < 3; ++i) {
+            put(i, ray.o[i]);
+            put(i + 3, ray.d[i]);
+        }
+        put(6, ray.maxt);
+        dr::scatter(m_capture_data, info, offset + 7, valid);
+    } else {
+        if (!active || ray_capture_count.fetch_add(1, std::memory_order_relaxed) >=
+                           m_capture_capacity)
+            return;
+        RayCapture::Record r;
+        for (uint32_t i = 0; i < 3; ++i) {
+            r.o[i] = (float) ray.o[i];
+            r.d[i] = (float) ray.d[i];
+        }
+        r.maxt = (float) ray.maxt;
+        r.info = info;
+        thread_ray_capture.records.push_back(r);
+    }
+}
+
+MI_VARIANT void
+Integrator<Float, Spectrum>::record_event_impl(RenderCounter counter,
+                                               const Mask &active) const {
+    if constexpr (dr::is_jit_v<Float>) {
+        dr::scatter_reduce(ReduceOp::Add, m_stats_counters, UInt64(1),
+                           UInt32((uint32_t) counter), active);
+    } else {
+        if (active)
+            thread_render_counters.add(counter, 1);
+    }
+}
+
+MI_VARIANT void
+Integrator<Float, Spectrum>::record_path_impl(const UInt32 &length,
+                                              PathTermination cause,
+                                              const Mask &active) const {
+    RenderCounter counter =
+        RenderCounter((uint32_t) RenderCounter::Escaped + (uint32_t) cause);
+
+    if constexpr (dr::is_jit_v<Float>) {
+        for (RenderCounter c : { RenderCounter::Paths, counter })
+            dr::scatter_reduce(ReduceOp::Add, m_stats_counters, UInt64(1),
+                               UInt32((uint32_t) c), active);
+        dr::scatter_reduce(ReduceOp::Add, m_stats_counters, UInt64(length),
+                           UInt32((uint32_t) RenderCounter::PathVertices), active);
+        dr::scatter_reduce(ReduceOp::Max, m_stats_max_length, length,
+                           UInt32(0), active);
+    } else {
+        if (!active)
+            return;
+        ThreadRenderCounters &tc = thread_render_counters;
+        tc.add(RenderCounter::Paths, 1);
+        tc.add(counter, 1);
+        tc.add(RenderCounter::PathVertices, length);
+        if (length > tc.max_path_length.load(std::memory_order_relaxed))
+            tc.max_path_length.store(length, std::memory_order_relaxed);
+    }
+}
+
 MI_VARIANT typename Integrator<Float, Spectrum>::TensorXf
 Integrator<Float, Spectrum>::render(Scene *scene,
                                     uint32_t sensor_index,
@@ -91,6 +600,22 @@ MI_VARIANT void Integrator<Float, Spectrum>::cancel() {
     m_stop = true;
 }
 
+MI_VARIANT void Integrator<Float, Spectrum>::set_checkpoint(const fs::path &path,
+                                                            float interval,
+                                                            bool resume) {
+    m_checkpoint_path = path;
+    m_checkpoint_interval = interval;
+    m_resume = resume;
+}
+
+MI_VARIANT void Integrator<Float, Spectrum>::set_partition(uint32_t index,
+                                                           uint32_t count) {
+    if (count == 0 || index >= count)
+        Throw("set_partition(): invalid partition %u/%u!", index, count);
+    m_partition_index = index;
+    m_partition_count = count;
+}
+
 // -----------------------------------------------------------------------------
 
 MI_VARIANT SamplingIntegrator<Float, Spectrum>::SamplingIntegrator(const Properties &props)
@@ -106,6 +631,9 @@ MI_VARIANT SamplingIntegrator<Float, Spectrum>::SamplingIntegrator(const Propert
         m_block_size = block_size;
     }
 
+    m_block_order = block_order_from_string(
+        props.get<std::string>("block_order", "spiral"));
+
     m_samples_per_pass = props.get<uint32_t>("samples_per_pass", (uint32_t) -1);
     if (m_samples_per_pass != (uint32_t) -1) {
         Log(Warn, "The 'samples_per_pass' is deprecated, as a poor choice of "
@@ -113,6 +641,33 @@ MI_VARIANT SamplingIntegrator<Float, Spectrum>::SamplingIntegrator(const Propert
                   "Please leave it undefined; Mitsuba will then automatically "
                   "choose the necessary number of passes.");
     }
+
+    m_adaptive_threshold = props.get<ScalarFloat>("adaptive_threshold", 0.f);
+    if (m_adaptive_threshold < 0.f)
+        Throw("\"adaptive_threshold\" must be non-negative!");
+
+    m_adaptive_min_passes = props.get<uint32_t>("adaptive_min_passes", 2);
+
+    // Pin workers and partition the image blocks by NUMA node (scalar variants)
+    m_numa = props.get<bool>("numa", false);
+
+    // Time the blocks and schedule later passes accordingly (scalar variants)
+    m_cost_aware = props.get<bool>("cost_aware", false);
+    m_render_cost = props.get<bool>("render_cost", false);
+
+    // Memory budget for the wavefront state in JIT variants (specified in MiB)
+    ScalarFloat max_memory = props.get<ScalarFloat>("max_wavefront_memory", 0.f);
+    if (max_memory < 0.f)
+        Throw("\"max_wavefront_memory\" must be non-negative!");
+    m_max_wavefront_memory = (size_t) ((double) max_memory * 1024.0 * 1024.0);
+
+    // Estimated number of 32-bit words of wavefront state per lane
+    m_wavefront_lane_words = props.get<uint32_t>("wavefront_lane_words", 128);
+    if (m_wavefront_lane_words == 0)
+        Throw("\"wavefront_lane_words\" must be positive!");
+
+    if (m_adaptive_threshold > 0.f && m_progressive)
+        Throw("Adaptive sampling is not supported in progressive mode!");
 }
 
 MI_VARIANT SamplingIntegrator<Float, Spectrum>::~SamplingIntegrator() { }
@@ -124,8 +679,32 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
                                             uint32_t spp,
                                             bool develop,
                                             bool evaluate) {
+    /* Render the training pass requested by an environment emitter that
+       learns its sampling distribution (regular and non-progressive) */
+    if (uint32_t training_spp = scene->emitter_training_spp(); training_spp > 0) {
+        bool progressive = m_progressive;
+        fs::path checkpoint_path = m_checkpoint_path;
+        m_progressive = false;
+        m_checkpoint_path.clear();
+
+        scene->set_emitter_training(true);
+        SamplingIntegrator::render(scene, sensor, sample_tea_32(seed, 0u).first,
+                                   training_spp, false, true);
+        scene->set_emitter_training(false);
+
+        m_progressive = progressive;
+        m_checkpoint_path = checkpoint_path;
+        Log(Info, "Environment emitter: training pass completed (%u sample%s "
+            "per pixel).", training_spp, training_spp == 1 ? "" : "s");
+    }
+
     ScopedPhase sp(ProfilerPhase::Render);
+    ScopedKernelStatistics kernel_stats(ProfilerPhase::Render,
+                                        (uint32_t) dr::backend_v<Float>);
     m_stop = false;
+    m_passes_completed = 0;
+    statistics_begin(evaluate);
+    capture_begin(evaluate);
 
     // Render on a larger film if the 'high quality edges' feature is enabled
     Film *film = sensor->film();
@@ -133,6 +712,18 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
     if (film->sample_border())
         film_size += 2 * film->rfilter()->border_size();
 
+    /* Adaptive sampling and the target error estimate the per-pixel error
+       from the luminance of the first three channels, which are only RGB
+       values for regular films */
+    ScalarFloat adaptive_threshold = m_adaptive_threshold,
+                target_error       = m_target_error;
+    if ((adaptive_threshold > 0.f || target_error > 0.f) &&
+        has_flag(film->flags(), FilmFlags::Special)) {
+        Log(Warn, "render(): 'adaptive_threshold' and 'target_error' are only "
+                  "supported with regular films, disabling them.");
+        adaptive_threshold = target_error = 0.f;
+    }
+
     // Potentially adjust the number of samples per pixel if spp != 0
     Sampler *sampler = sensor->sampler();
     if (spp)
@@ -143,6 +734,17 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
                                     ? spp
                                     : std::min(m_samples_per_pass, spp);
 
+    /* Adaptive sampling needs several passes to estimate the per-pixel error.
+       Unless specified, choose the largest divisor of 'spp' that leads to at
+       least 8 passes. */
+    if constexpr (!dr::is_jit_v<Float>) {
+        if (adaptive_threshold > 0.f && m_samples_per_pass == (uint32_t) -1) {
+            spp_per_pass = std::max(spp / 8, 1u);
+            while (spp % spp_per_pass != 0)
+                spp_per_pass--;
+        }
+    }
+
     if ((spp % spp_per_pass) != 0)
         Throw("sample_count (%d) must be a multiple of spp_per_pass (%d).",
               spp, spp_per_pass);
@@ -150,7 +752,26 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
     uint32_t n_passes = spp / spp_per_pass;
 
     // Determine output channels and prepare the film with this information
-    size_t n_channels = film->prepare(aov_names());
+    std::vector<std::string> channels = aov_names();
+    bool render_cost = m_render_cost;
+    if (render_cost && (dr::is_jit_v<Float> ||
+                        has_flag(film->flags(), FilmFlags::Special))) {
+        Log(Warn, "render(): the 'render_cost' channel is only supported in "
+                  "scalar variants with regular films, disabling it.");
+        render_cost = false;
+    }
+    if (render_cost)
+        channels.push_back("render_cost");
+    size_t n_channels = film->prepare(channels);
+    m_render_cost_channel = render_cost ? n_channels - 1 : 0;
+
+    if (m_partition_count > 1) {
+        if (m_progressive)
+            Throw("render(): partitioned rendering is not supported in "
+                  "progressive mode!");
+        Log(Info, "Rendering partition %u of %u.", m_partition_index + 1,
+            m_partition_count);
+    }
 
     // Start the render timer (used for timeouts & log messages)
     m_render_timer.reset();
@@ -168,6 +789,10 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
         if (m_timeout > 0.f)
             Log(Info, "Timeout specified: %.2f seconds.", m_timeout);
 
+        if (m_progressive && m_timeout <= 0.f && target_error <= 0.f)
+            Log(Warn, "Progressive rendering without a timeout or target "
+                      "error, rendering until cancelled..");
+
         // If no block size was specified, find size that is good for parallelization
         uint32_t block_size = m_block_size;
         if (block_size == 0) {
@@ -181,7 +806,8 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
             }
         }
 
-        Spiral spiral(film_size, film->crop_offset(), block_size, n_passes);
+        Spiral spiral(film_size, film->crop_offset(), block_size, n_passes,
+                      m_block_order);
 
         std::mutex mutex;
         ref<ProgressReporter> progress;
@@ -190,58 +816,564 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
             progress = new ProgressReporter("Rendering");
 
         // Total number of blocks to be handled, including multiple passes.
-        uint32_t total_blocks = spiral.block_count() * n_passes,
-                 blocks_done = 0;
-
-        // Grain size for parallelization
-        uint32_t grain_size = std::max(total_blocks / (4 * n_threads), 1u);
+        uint32_t block_count = spiral.block_count(),
+                 total_blocks = block_count * n_passes,
+                 blocks_done = 0,
+                 quadrants_done = 0; // Split blocks (see 'cost_aware' below)
 
         // Avoid overlaps in RNG seeding RNG when a seed is manually specified
         seed *= dr::prod(film_size);
 
-        ThreadEnvironment env;
-        dr::parallel_for(
-            dr::blocked_range<uint32_t>(0, total_blocks, grain_size),
-            [&](const dr::blocked_range<uint32_t> &range) {
-                ScopedSetThreadEnvironment set_env(env);
-                // Fork a non-overlapping sampler for the current worker
-                ref<Sampler> sampler = sensor->sampler()->fork();
+        /* Checkpointing: track which blocks have been accumulated into the
+           film. Since every block is seeded deterministically, this is all
+           that is needed to continue an interrupted render job. */
+        bool checkpoint = !m_checkpoint_path.empty();
+        if (checkpoint && (m_progressive || (adaptive_threshold > 0.f && n_passes > 1))) {
+            Log(Warn, "render(): checkpointing is not supported in progressive "
+                      "or adaptive mode, disabling it.");
+            checkpoint = false;
+        }
+
+        /* Streaming films write finished rows during rendering, hence the
+           image must be rendered from top to bottom in a single sweep */
+        bool streaming = film->streaming();
+        if (streaming) {
+            if (m_progressive || (adaptive_threshold > 0.f && n_passes > 1) ||
+                m_partition_count > 1)
+                Throw("render(): streaming films are not supported in "
+                      "progressive, adaptive, or partitioned mode!");
+            if (checkpoint) {
+                Log(Warn, "render(): checkpointing is not supported with "
+                          "streaming films, disabling it.");
+                checkpoint = false;
+            }
+        }
+
+        /* Distributed rendering: only handle the blocks whose index maps to
+           the current partition. The other partitions are rendered by
+           separate processes, whose film contents are merged afterwards. */
+        bool partitioned = m_partition_count > 1;
+        if (partitioned) {
+            if (adaptive_threshold > 0.f && n_passes > 1)
+                Throw("render(): partitioned rendering is not supported in "
+                      "adaptive mode!");
+
+            // Account for the blocks of other partitions in the progress bar
+            blocks_done = total_blocks - (total_blocks - m_partition_index +
+                                          m_partition_count - 1) / m_partition_count;
+        }
+
+        CheckpointHeader ckpt_header { seed, spp, spp_per_pass, block_size,
+                                       film_size.x(), film_size.y(), total_blocks,
+                                       m_partition_index, m_partition_count,
+                                       (uint32_t) m_block_order };
+        std::vector<uint8_t> blocks_completed;
+        Timer checkpoint_timer;
+
+        if (checkpoint) {
+            blocks_completed.resize(total_blocks, 0);
+            if (m_resume && read_checkpoint(m_checkpoint_path, ckpt_header,
+                                            blocks_completed, film)) {
+                for (uint8_t b : blocks_completed)
+                    blocks_done += b;
+                Log(Info, "Resuming from checkpoint \"%s\" (%u/%u blocks done).",
+                    m_checkpoint_path, blocks_done, total_blocks);
+            }
+        }
 
-                ref<ImageBlock> block = film->create_block(
-                    ScalarVector2u(block_size) /* size */,
-                    false /* normalize */,
-                    true /* border */);
+        /* In adaptive mode, track the first two moments of the luminance of
+           every pixel (stored per block in Morton order, see render_block()) */
+        bool adaptive = adaptive_threshold > 0.f && n_passes > 1 && !m_progressive;
+        uint32_t pixel_count = block_size * block_size;
+        std::unique_ptr<ScalarFloat[]> moments;
+        if (adaptive || (m_progressive && target_error > 0.f))
+            moments = std::unique_ptr<ScalarFloat[]>(
+                new ScalarFloat[(size_t) block_count * pixel_count * 2]());
+
+        /* Sum of the relative standard errors of the pixels in a block given
+           'n' samples per pixel. Also returns the number of valid pixels. */
+        auto block_error = [&](uint32_t index, ScalarFloat n) {
+            ScalarVector2u size = std::get<1>(spiral.block(index));
+            const ScalarFloat *m = moments.get() + (size_t) index * pixel_count * 2;
+            double error = 0.0;
+            uint32_t valid = 0;
+
+            for (uint32_t j = 0; j < pixel_count; ++j) {
+                ScalarPoint2u p = dr::morton_decode<ScalarPoint2u>(j);
+                if (dr::any(p >= size))
+                    continue;
+                ScalarFloat mean = m[2 * j] / n,
+                            var  = dr::maximum(m[2 * j + 1] / n - dr::square(mean), 0.f) *
+                                   n / (n - 1.f);
+                error += dr::sqrt(var / n) / dr::maximum(mean, 1e-3f);
+                valid++;
+            }
 
-                std::unique_ptr<Float[]> aovs(new Float[n_channels]);
+            return std::make_pair(error, valid);
+        };
+
+        auto update_progress = [&]() {
+            if (!progress)
+                return;
+            if (!m_progressive)
+                progress->update((blocks_done + quadrants_done / 4.f) /
+                                 (float) total_blocks);
+            else if (m_timeout > 0.f)
+                progress->update(std::min(m_render_timer.value() /
+                                          (1000.f * m_timeout), 1.f));
+        };
+
+        /* NUMA mode: group the available cores by node. If there are several
+           nodes, the worker threads are pinned, and each of them preferably
+           renders blocks from the stripe of the image assigned to its node. */
+        std::vector<std::vector<uint32_t>> node_cores;
+        if (m_numa) {
+            std::vector<uint32_t> core_nodes = util::core_numa_nodes();
+            for (uint32_t core = 0; core < (uint32_t) core_nodes.size(); ++core) {
+                if (node_cores.size() <= core_nodes[core])
+                    node_cores.resize(core_nodes[core] + 1);
+                node_cores[core_nodes[core]].push_back(core);
+            }
 
-                // Render up to 'grain_size' image blocks
-                for (uint32_t i = range.begin();
-                     i != range.end() && !should_stop(); ++i) {
-                    auto [offset, size, block_id] = spiral.next_block();
-                    Assert(dr::prod(size) != 0);
+            // Skip nodes without available cores
+            node_cores.erase(std::remove_if(node_cores.begin(), node_cores.end(),
+                                            [](const auto &c) { return c.empty(); }),
+                             node_cores.end());
 
-                    if (film->sample_border())
-                        offset -= film->rfilter()->border_size();
+            if (node_cores.size() > 1)
+                Log(Info, "NUMA mode: distributing the work over %zu nodes.",
+                    node_cores.size());
+            else
+                node_cores.clear();
+        }
+        bool numa = !node_cores.empty();
+
+        /* Per-worker state: a forked sampler, an image block, and the AOV
+           buffer. The sampler is reseeded for every pixel, so none of them
+           depend on the blocks rendered before */
+        struct WorkerState {
+            ref<Sampler> sampler;
+            ref<ImageBlock> block;
+            std::unique_ptr<Float[]> aovs;
+        };
+
+        /* Worker states are recycled across the chunks of work and passes of
+           the workers instead of being allocated for every chunk. There is
+           one pool per NUMA node, so that blocks stay on the node that first
+           touched their memory. */
+        std::vector<std::vector<WorkerState>> worker_pools(
+            std::max(node_cores.size(), (size_t) 1));
+        std::mutex worker_pool_mutex;
+
+        auto acquire_worker = [&](uint32_t node) -> WorkerState {
+            {
+                std::lock_guard<std::mutex> lock(worker_pool_mutex);
+                std::vector<WorkerState> &pool = worker_pools[node];
+                if (!pool.empty()) {
+                    WorkerState state = std::move(pool.back());
+                    pool.pop_back();
+                    return state;
+                }
+            }
 
-                    block->set_size(size);
-                    block->set_offset(offset);
+            WorkerState state;
+            // Fork a non-overlapping sampler for the current worker
+            state.sampler = sensor->sampler()->fork();
+            state.block = film->create_block(ScalarVector2u(block_size) /* size */,
+                                             false /* normalize */,
+                                             true /* border */);
+            state.aovs = std::unique_ptr<Float[]>(new Float[n_channels]);
+            return state;
+        };
+
+        auto release_worker = [&](uint32_t node, WorkerState &&state) {
+            std::lock_guard<std::mutex> lock(worker_pool_mutex);
+            worker_pools[node].push_back(std::move(state));
+        };
+
+        /* When every call to 'render_blocks' visits each tile at most once,
+           the interiors of concurrently merged blocks never overlap, and the
+           film can accumulate them without holding its lock */
+        bool disjoint_tiles = n_passes == 1 || m_progressive || adaptive;
+
+        /* Cost-aware scheduling: every block is timed, and the blocks of the
+           subsequent passes are rendered by decreasing cost of the previous
+           pass (longest processing time first). The most expensive ones are
+           split into their quadrants, otherwise the last few of them keep a
+           handful of workers busy while the others idle at the end of a pass.
+           Blocks are accumulated individually, hence this is incompatible
+           with checkpoints, streaming films, and the NUMA mode. */
+        bool cost_aware = m_cost_aware && (m_progressive || n_passes > 1) &&
+                          !checkpoint && !streaming && !numa;
+
+        // Render time of every tile of the image in the current pass (in ns)
+        std::unique_ptr<std::atomic<uint64_t>[]> tile_cost;
+        std::vector<uint32_t> all_tiles;
+        if (cost_aware) {
+            tile_cost = std::unique_ptr<std::atomic<uint64_t>[]>(
+                new std::atomic<uint64_t>[block_count]());
+            all_tiles.resize(block_count);
+            for (uint32_t i = 0; i < block_count; ++i)
+                all_tiles[i] = i;
+        }
 
-                    render_block(scene, sensor, sampler, block, aovs.get(),
-                                 spp_per_pass, seed, block_id, block_size);
+        /// A block of the spiral, or one of its quadrants
+        struct Work {
+            uint32_t index;
+            uint32_t quadrant; // (uint32_t) -1 for the whole block
+            double cost;
+        };
+
+        /* Sort the given blocks (indices into the first pass of the spiral)
+           by decreasing cost and split the ones taking longer than a fraction
+           of the time of a worker. Resets the measured costs. */
+        auto schedule = [&](const std::vector<uint32_t> &tiles) {
+            std::vector<Work> work;
+            work.reserve(tiles.size());
+
+            double total = 0.0, longest = 0.0;
+            for (uint32_t tile : tiles) {
+                double cost = (double) tile_cost[tile].exchange(0);
+                work.push_back({ tile, (uint32_t) -1, cost });
+                total += cost;
+                longest = std::max(longest, cost);
+            }
 
-                    film->put_block(block);
+            double threshold = total / (4.0 * n_threads);
+            size_t n_split = 0, n_work = work.size();
+            for (size_t i = 0; i < n_work && block_size > 1; ++i) {
+                if (!(work[i].cost > threshold))
+                    continue;
+                work[i].cost /= 4.0;
+                work[i].quadrant = 0;
+                for (uint32_t q = 1; q < 4; ++q)
+                    work.push_back({ work[i].index, q, work[i].cost });
+                n_split++;
+            }
 
-                    /* Critical section: update progress bar */
-                    if (progress) {
-                        std::lock_guard<std::mutex> lock(mutex);
-                        blocks_done++;
-                        progress->update(blocks_done / (float) total_blocks);
+            std::stable_sort(work.begin(), work.end(),
+                             [](const Work &a, const Work &b) { return a.cost > b.cost; });
+
+            Log(Debug, "Cost-aware scheduling: %zu blocks, longest %.2f ms, "
+                "average %.2f ms, %zu split into quadrants.", tiles.size(),
+                longest * 1e-6, total * 1e-6 / std::max(tiles.size(), (size_t) 1),
+                n_split);
+            return work;
+        };
+
+        /* Render 'n_blocks' blocks in parallel. The function 'next' maps an
+           index in [0, n_blocks) and the NUMA node of the calling worker to
+           the block that should be rendered, optionally followed by the
+           quadrant of the block (see 'cost_aware' above). Unless specified,
+           the workers are handed chunks of several consecutive indices. */
+        auto render_blocks = [&](uint32_t n_blocks, auto next,
+                                 uint32_t grain_size = 0) {
+            // Grain size for parallelization
+            if (grain_size == 0)
+                grain_size = std::max(n_blocks / (4 * n_threads), 1u);
+
+            ThreadEnvironment env;
+            dr::parallel_for(
+                dr::blocked_range<uint32_t>(0, n_blocks, grain_size),
+                [&](const dr::blocked_range<uint32_t> &range) {
+                    ScopedSetThreadEnvironment set_env(env);
+
+                    // Pin the worker before allocating memory (first touch)
+                    uint32_t node = numa ? numa_pin_worker(node_cores) : 0;
+
+                    WorkerState state = acquire_worker(node);
+                    Sampler *sampler = state.sampler.get();
+                    ImageBlock *block = state.block.get();
+                    Float *aovs = state.aovs.get();
+
+                    // Render up to 'grain_size' image blocks
+                    for (uint32_t i = range.begin();
+                         i != range.end() && !should_stop() &&
+                         !(m_progressive && budget_exhausted()); ++i) {
+                        auto item = next(i, node);
+                        auto offset = std::get<0>(item);
+                        auto size = std::get<1>(item);
+                        uint32_t block_id = std::get<2>(item),
+                                 quadrant = (uint32_t) -1;
+                        if constexpr (std::tuple_size_v<decltype(item)> == 4)
+                            quadrant = std::get<3>(item);
+                        Assert(dr::prod(size) != 0);
+
+                        // Skip blocks of other partitions or restored from a checkpoint
+                        if ((partitioned && block_id % m_partition_count != m_partition_index) ||
+                            (checkpoint && blocks_completed[block_id]))
+                            continue;
+
+                        // Restrict split blocks to the pixels of the quadrant
+                        uint32_t pixel_begin = 0, pixel_end = pixel_count;
+                        if (quadrant != (uint32_t) -1) {
+                            pixel_begin = quadrant * (pixel_count / 4);
+                            pixel_end = pixel_begin + pixel_count / 4;
+
+                            ScalarVector2u corner(
+                                dr::morton_decode<ScalarPoint2u>(pixel_begin));
+                            if (dr::any(corner >= size)) {
+                                // Quadrant outside of the image (border blocks)
+                                if (progress) {
+                                    std::lock_guard<std::mutex> lock(mutex);
+                                    quadrants_done++;
+                                    update_progress();
+                                }
+                                continue;
+                            }
+
+                            offset += ScalarVector2i(corner);
+                            size = dr::minimum(size - corner, block_size / 2);
+                        }
+
+                        if (film->sample_border())
+                            offset -= film->rfilter()->border_size();
+
+                        // Timeline event of the block, including its merge into the film
+                        ScopedTraceEvent trace("render", "Render block");
+                        if (trace.active())
+                            trace.set_info(tfm::format("block %u at [%i, %i]", block_id,
+                                                       offset.x(), offset.y()));
+
+                        block->set_size(size);
+                        block->set_offset(offset);
+
+                        ScalarFloat *block_moments = nullptr;
+                        if (moments)
+                            block_moments = moments.get() +
+                                (size_t) (block_id % block_count) * pixel_count * 2;
+
+                        auto start = std::chrono::steady_clock::now();
+
+                        render_block(scene, sensor, sampler, block, aovs,
+                                     spp_per_pass, seed, block_id, block_size,
+                                     block_moments, pixel_begin, pixel_end);
+
+                        if (tile_cost)
+                            tile_cost[block_id % block_count] += (uint64_t)
+                                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now() - start).count();
+
+                        if (checkpoint) {
+                            /* Commit the block and record its completion
+                               atomically with respect to checkpoints */
+                            std::lock_guard<std::mutex> lock(mutex);
+                            if (should_stop())
+                                continue; // The block might be incomplete
+
+                            if (disjoint_tiles)
+                                film->put_tile(block);
+                            else
+                                film->put_block(block);
+                            blocks_completed[block_id] = 1;
+                            blocks_done++;
+                            update_progress();
+
+                            if (m_checkpoint_interval > 0.f &&
+                                checkpoint_timer.value() > 1000.f * m_checkpoint_interval) {
+                                write_checkpoint(m_checkpoint_path, ckpt_header,
+                                                 blocks_completed, film);
+                                checkpoint_timer.reset();
+                            }
+                            continue;
+                        }
+
+                        if (disjoint_tiles)
+                            film->put_tile(block);
+                        else
+                            film->put_block(block);
+
+                        /* Critical section: update progress bar */
+                        if (progress) {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            if (quadrant == (uint32_t) -1)
+                                blocks_done++;
+                            else
+                                quadrants_done++;
+                            update_progress();
+                        }
                     }
+
+                    release_worker(node, std::move(state));
+                }
+            );
+        };
+
+        /* Render a schedule of blocks in its order. The function 'block' maps
+           the index of a work item to the block of the spiral */
+        auto render_work = [&](const std::vector<Work> &work, auto block) {
+            render_blocks((uint32_t) work.size(), [&](uint32_t i, uint32_t /* node */) {
+                return std::tuple_cat(block(work[i].index),
+                                      std::make_tuple(work[i].quadrant));
+            }, 1u);
+        };
+
+        if (m_progressive) {
+            /* Open-ended progressive rendering: each pass covers all blocks
+               with 'spp_per_pass' samples. Workers stop picking up new blocks
+               once the time budget is exhausted, but always finish the block
+               they are working on, so that every pixel stays normalized. */
+            uint32_t pass = 0;
+            while (!should_stop() && !budget_exhausted()) {
+                auto block = [&](uint32_t index) {
+                    auto [offset, size, block_id] = spiral.block(index);
+                    return std::make_tuple(offset, size, block_id + pass * block_count);
+                };
+
+                if (cost_aware && pass > 0)
+                    render_work(schedule(all_tiles), block);
+                else
+                    render_blocks(block_count, [&](uint32_t i, uint32_t /* node */) {
+                        return block(i);
+                    });
+
+                if (should_stop() || budget_exhausted())
+                    break;
+
+                m_passes_completed = ++pass;
+
+                if (target_error > 0.f && pass > 1) {
+                    double error = 0.0;
+                    uint32_t valid = 0;
+                    for (uint32_t i = 0; i < block_count; ++i) {
+                        auto [e, v] = block_error(i, ScalarFloat(pass * spp_per_pass));
+                        error += e;
+                        valid += v;
+                    }
+                    error /= std::max(valid, 1u);
+
+                    Log(Debug, "Progressive rendering: pass %u, relative error %.4f",
+                        pass, error);
+
+                    if (error < target_error)
+                        break;
                 }
             }
-        );
 
-        if (develop)
+            Log(Info, "Progressive rendering completed %u pass%s (%u sample%s per pixel).",
+                pass, pass == 1 ? "" : "es", pass * spp_per_pass,
+                pass * spp_per_pass == 1 ? "" : "s");
+        } else if (streaming) {
+            // Group the blocks (of all passes) by their row
+            uint32_t row_count = (film_size.y() + block_size - 1) / block_size;
+            std::vector<std::vector<uint32_t>> rows(row_count);
+            for (uint32_t i = 0; i < total_blocks; ++i) {
+                uint32_t y = std::get<0>(spiral.block(i)).y() - film->crop_offset().y();
+                rows[y / block_size].push_back(i);
+            }
+
+            int32_t border = film->sample_border() ? (int32_t) film->rfilter()->border_size() : 0;
+            for (uint32_t row = 0; row < row_count && !should_stop(); ++row) {
+                render_blocks((uint32_t) rows[row].size(), [&](uint32_t i, uint32_t /* node */) {
+                    return spiral.block(rows[row][i]);
+                });
+
+                if (should_stop())
+                    break;
+
+                // Samples of the remaining rows are placed below this row
+                uint32_t next = row + 1 == row_count
+                    ? film_size.y()
+                    : (uint32_t) std::max((int32_t) ((row + 1) * block_size) - border, 0);
+                film->flush_rows(next);
+            }
+            m_passes_completed = should_stop() ? 0 : n_passes;
+        } else if (!adaptive) {
+            if (numa) {
+                spiral.set_partitions((uint32_t) node_cores.size());
+                render_blocks(total_blocks, [&](uint32_t, uint32_t node) {
+                    return spiral.next_block(node);
+                });
+            } else if (cost_aware) {
+                /* Measure the cost of the blocks in the first pass, then
+                   render each of the remaining passes longest-first */
+                render_blocks(block_count, [&](uint32_t i, uint32_t) {
+                    return spiral.block(i);
+                });
+
+                if (!should_stop()) {
+                    std::vector<Work> pass_work = schedule(all_tiles), work;
+                    work.reserve(pass_work.size() * (n_passes - 1));
+                    for (uint32_t pass = 1; pass < n_passes; ++pass) {
+                        for (Work w : pass_work) {
+                            w.index += pass * block_count;
+                            work.push_back(w);
+                        }
+                    }
+                    render_work(work, [&](uint32_t index) { return spiral.block(index); });
+                }
+            } else {
+                render_blocks(total_blocks, [&](uint32_t, uint32_t) {
+                    return spiral.next_block();
+                });
+            }
+            m_passes_completed = should_stop() ? 0 : n_passes;
+
+            if (checkpoint) {
+                if (should_stop()) {
+                    write_checkpoint(m_checkpoint_path, ckpt_header,
+                                     blocks_completed, film);
+                    Log(Info, "Render job interrupted, wrote checkpoint \"%s\".",
+                        m_checkpoint_path);
+                } else if (fs::exists(m_checkpoint_path)) {
+                    fs::remove(m_checkpoint_path);
+                }
+            }
+        } else {
+            Log(Info, "Adaptive sampling enabled (target relative error: %.4f).",
+                adaptive_threshold);
+
+            // Blocks that have not converged yet (indices into the spiral)
+            std::vector<uint32_t> active(block_count);
+            for (uint32_t i = 0; i < block_count; ++i)
+                active[i] = i;
+
+            uint32_t min_passes = std::max(std::min(m_adaptive_min_passes, n_passes), 2u);
+            size_t blocks_rendered = 0;
+
+            for (uint32_t pass = 0; pass < n_passes && !active.empty() &&
+                                    !should_stop(); ++pass) {
+                auto block = [&](uint32_t index) {
+                    return spiral.block(pass * block_count + index);
+                };
+
+                if (cost_aware && pass > 0)
+                    render_work(schedule(active), block);
+                else
+                    render_blocks((uint32_t) active.size(), [&](uint32_t i, uint32_t /* node */) {
+                        return block(active[i]);
+                    });
+                blocks_rendered += active.size();
+                m_passes_completed = pass + 1;
+
+                if (pass + 1 < min_passes || pass + 1 == n_passes)
+                    continue;
+
+                // Retire blocks whose error estimate dropped below the target
+                ScalarFloat n = ScalarFloat((pass + 1) * spp_per_pass);
+                std::vector<uint32_t> still_active;
+                for (uint32_t index : active) {
+                    auto [error, valid] = block_error(index, n);
+                    if (valid == 0 || error / valid > adaptive_threshold)
+                        still_active.push_back(index);
+                }
+
+                // Account for skipped blocks in the progress bar
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    blocks_done += (uint32_t) (active.size() - still_active.size()) *
+                                   (n_passes - pass - 1);
+                    update_progress();
+                }
+
+                active = std::move(still_active);
+            }
+
+            Log(Info, "Adaptive sampling used %.1f%% of the sample budget.",
+                100.0 * blocks_rendered / (double) total_blocks);
+        }
+
+        if (develop && !streaming)
             result = film->develop();
     } else {
         size_t wavefront_size = (size_t) film_size.x() *
@@ -264,13 +1396,60 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
                 wavefront_size, n_passes);
         }
 
+        /* Memory-bounded rendering: if the estimated state of the wavefront
+           exceeds the budget, first reduce the number of samples per pass. If
+           that is not enough, split the image into horizontal bands that are
+           rendered one after the other. The resulting chunks only depend on
+           the budget, film size, and sample count (not on the device). */
+        uint32_t band_height = film_size.y();
+        if (m_max_wavefront_memory > 0) {
+            // Estimated state per lane, plus the channels of the image block
+            size_t lane_size   = (m_wavefront_lane_words + n_channels) * sizeof(ScalarFloat),
+                   max_lanes   = std::max(m_max_wavefront_memory / lane_size, (size_t) 1),
+                   pixel_count = (size_t) film_size.x() * (size_t) film_size.y();
+
+            // Largest divisor of 'spp' such that a pass over the image fits
+            while (spp_per_pass > 1 && pixel_count * spp_per_pass > max_lanes) {
+                do {
+                    spp_per_pass--;
+                } while (spp % spp_per_pass != 0);
+            }
+            n_passes = spp / spp_per_pass;
+
+            if (pixel_count * spp_per_pass > max_lanes)
+                band_height = (uint32_t) dr::clip(max_lanes / film_size.x(),
+                                                  (size_t) 1, (size_t) film_size.y());
+
+            wavefront_size = (size_t) film_size.x() * (size_t) band_height *
+                             (size_t) spp_per_pass;
+        }
+        uint32_t n_bands = (film_size.y() + band_height - 1) / band_height;
+
+        if (n_bands > 1 && (m_progressive || !m_checkpoint_path.empty() ||
+                            m_partition_count > 1)) {
+            Log(Warn, "render(): image bands are not supported in progressive, "
+                      "checkpointed, or partitioned mode, exceeding the "
+                      "wavefront memory budget.");
+            band_height = film_size.y();
+            n_bands = 1;
+            wavefront_size = (size_t) film_size.x() * (size_t) film_size.y() *
+                             (size_t) spp_per_pass;
+        }
+
+        if (m_max_wavefront_memory > 0)
+            Log(Info, "Wavefront memory budget of %s: rendering %u pass%s "
+                      "(%u sample%s each) over %u image band%s.",
+                util::mem_string(m_max_wavefront_memory), n_passes,
+                n_passes == 1 ? "" : "es", spp_per_pass,
+                spp_per_pass == 1 ? "" : "s", n_bands, n_bands == 1 ? "" : "s");
+
         dr::sync_thread(); // Separate from scene initialization (for timings)
 
         Log(Info, "Starting render job (%ux%u, %u sample%s%s)",
             film_size.x(), film_size.y(), spp, spp == 1 ? "" : "s",
             n_passes > 1 ? tfm::format(", %u passes", n_passes) : "");
 
-        if (n_passes > 1 && !evaluate) {
+        if ((n_passes > 1 || n_bands > 1 || m_progressive) && !evaluate) {
             Log(Warn, "render(): forcing 'evaluate=true' since multi-pass "
                       "rendering was requested.");
             evaluate = true;
@@ -279,6 +1458,9 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
         // Inform the sampler about the passes (needed in vectorized modes)
         sampler->set_samples_per_wavefront(spp_per_pass);
 
+        // The sequences of the wavefront cover the film in scanline order
+        sampler->set_film_width(film_size.x());
+
         // Seed the underlying random number generators, if applicable
         sampler->seed(seed, (uint32_t) wavefront_size);
 
@@ -289,25 +1471,10 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
         // Only use the ImageBlock coalescing feature when rendering enough samples
         block->set_coalesce(block->coalesce() && spp_per_pass >= 4);
 
-        // Compute discrete sample position
-        UInt32 idx = dr::arange<UInt32>((uint32_t) wavefront_size);
-
-        // Try to avoid a division by an unknown constant if we can help it
-        uint32_t log_spp_per_pass = dr::log2i(spp_per_pass);
-        if ((1u << log_spp_per_pass) == spp_per_pass)
-            idx >>= dr::opaque<UInt32>(log_spp_per_pass);
-        else
-            idx /= dr::opaque<UInt32>(spp_per_pass);
-
-        // Compute the position on the image plane
+        // Sample positions of the whole image (bands compute their own ones)
         Vector2i pos;
-        pos.y() = idx / film_size[0];
-        pos.x() = dr::fnmadd(film_size[0], pos.y(), idx);
-
-        if (film->sample_border())
-            pos -= film->rfilter()->border_size();
-
-        pos += film->crop_offset();
+        if (n_bands == 1)
+            pos = sample_positions(film, spp_per_pass, 0, wavefront_size);
 
         // Scale factor that will be applied to ray differentials
         ScalarFloat diff_scale_factor = dr::rsqrt((ScalarFloat) spp);
@@ -315,19 +1482,123 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
         Timer timer;
         std::unique_ptr<Float[]> aovs(new Float[n_channels]);
 
-        // Potentially render multiple passes
-        for (size_t i = 0; i < n_passes; i++) {
-            render_sample(scene, sensor, sampler, block, aovs.get(), pos,
-                          diff_scale_factor);
+        if (m_progressive) {
+            if (target_error > 0.f)
+                Log(Warn, "render(): 'target_error' is only supported in "
+                          "scalar variants, ignoring it.");
+
+            /* Open-ended progressive rendering: every pass is accumulated into
+               the film and evaluated, which keeps it developable throughout */
+            uint32_t pass = 0;
+            while (!should_stop() && !budget_exhausted()) {
+                if (pass > 0) {
+                    // Decorrelate passes by deriving a new seed for each one
+                    sampler->seed(sample_tea_32(seed, pass).first,
+                                  (uint32_t) wavefront_size);
+                    block->clear();
+                }
 
-            if (n_passes > 1) {
-                sampler->advance(); // Will trigger a kernel launch of size 1
-                sampler->schedule_state();
-                dr::eval(block->tensor());
+                render_sample(scene, sensor, sampler, block, aovs.get(), pos,
+                              diff_scale_factor);
+                film->put_block(block);
+                film->schedule_storage();
+                dr::eval();
+                dr::sync_thread();
+
+                m_passes_completed = ++pass;
+            }
+
+            Log(Info, "Progressive rendering completed %u pass%s (%u sample%s per pixel).",
+                pass, pass == 1 ? "" : "es", pass * spp_per_pass,
+                pass * spp_per_pass == 1 ? "" : "s");
+        } else if (!m_checkpoint_path.empty() || m_partition_count > 1) {
+            /* Checkpointing and partitioned rendering: accumulate and evaluate
+               every pass separately, and use a separate seed for each of them.
+               This way, passes can be skipped when resuming a render job from a
+               checkpoint, or distributed between several processes. */
+            bool checkpoint = !m_checkpoint_path.empty();
+            CheckpointHeader ckpt_header { seed, spp, spp_per_pass, 0,
+                                           film_size.x(), film_size.y(), n_passes,
+                                           m_partition_index, m_partition_count };
+            std::vector<uint8_t> passes_done(n_passes, 0);
+
+            // Passes of other partitions are handled by separate processes
+            for (uint32_t i = 0; i < n_passes; i++)
+                passes_done[i] = i % m_partition_count != m_partition_index;
+
+            if (n_passes < m_partition_count)
+                Log(Warn, "render(): the render job only has %u pass%s, some of "
+                          "the %u partitions will be empty. Consider lowering "
+                          "'samples_per_pass'.", n_passes,
+                          n_passes == 1 ? "" : "es", m_partition_count);
+
+            if (checkpoint && m_resume &&
+                read_checkpoint(m_checkpoint_path, ckpt_header, passes_done, film))
+                Log(Info, "Resuming from checkpoint \"%s\".", m_checkpoint_path);
+
+            Timer checkpoint_timer;
+            bool first = true;
+            for (uint32_t i = 0; i < n_passes && !should_stop(); i++) {
+                if (passes_done[i])
+                    continue;
+
+                if (!first)
+                    block->clear();
+                if (i > 0)
+                    sampler->seed(sample_tea_32(seed, i).first,
+                                  (uint32_t) wavefront_size);
+                first = false;
+
+                render_sample(scene, sensor, sampler, block, aovs.get(), pos,
+                              diff_scale_factor);
+                film->put_block(block);
+                film->schedule_storage();
+                dr::eval();
+                dr::sync_thread();
+                passes_done[i] = 1;
+
+                if (checkpoint && m_checkpoint_interval > 0.f &&
+                    checkpoint_timer.value() > 1000.f * m_checkpoint_interval) {
+                    write_checkpoint(m_checkpoint_path, ckpt_header,
+                                     passes_done, film);
+                    checkpoint_timer.reset();
+                }
             }
-        }
 
-        film->put_block(block);
+            if (!should_stop())
+                m_passes_completed = n_passes;
+
+            if (checkpoint) {
+                if (should_stop()) {
+                    write_checkpoint(m_checkpoint_path, ckpt_header, passes_done, film);
+                    Log(Info, "Render job interrupted, wrote checkpoint \"%s\".",
+                        m_checkpoint_path);
+                } else if (fs::exists(m_checkpoint_path)) {
+                    fs::remove(m_checkpoint_path);
+                }
+            }
+        } else if (n_bands > 1) {
+            render_bands(scene, sensor, sampler, block, aovs.get(), seed,
+                         spp_per_pass, n_passes, band_height, diff_scale_factor);
+
+            film->put_block(block);
+            m_passes_completed = should_stop() ? 0 : n_passes;
+        } else {
+            // Potentially render multiple passes
+            for (size_t i = 0; i < n_passes; i++) {
+                render_sample(scene, sensor, sampler, block, aovs.get(), pos,
+                              diff_scale_factor);
+
+                if (n_passes > 1) {
+                    sampler->advance(); // Will trigger a kernel launch of size 1
+                    sampler->schedule_state();
+                    dr::eval(block->tensor());
+                }
+            }
+
+            film->put_block(block);
+            m_passes_completed = n_passes;
+        }
 
         if (n_passes == 1 && jit_flag(JitFlag::VCallRecord) &&
             jit_flag(JitFlag::LoopRecord)) {
@@ -343,7 +1614,10 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
         }
 
         if (evaluate) {
-            dr::eval();
+            {
+                ScopedTraceEvent trace("jit", "Kernel compilation and launch");
+                dr::eval();
+            }
 
             if (n_passes == 1 && jit_flag(JitFlag::VCallRecord) &&
                 jit_flag(JitFlag::LoopRecord)) {
@@ -355,17 +1629,93 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
                 m_render_timer.reset();
             }
 
+            ScopedTraceEvent trace("jit", "Kernel execution");
             dr::sync_thread();
         }
     }
 
-    if (!m_stop && (evaluate || !dr::is_jit_v<Float>))
+    if (!m_stop && (evaluate || !dr::is_jit_v<Float>)) {
         Log(Info, "Rendering finished. (took %s)",
             util::time_string((float) m_render_timer.value(), true));
+        Log(Info, "%s", MemoryTracker::summary());
+        if (kernel_stats.active())
+            Log(Info, "%s", kernel_stats.finish().to_string());
+    }
+    statistics_end(!m_stop && (evaluate || !dr::is_jit_v<Float>));
+    capture_end();
+
+    // Emit the messages of the render job before returning
+    if (Logger *logger = Thread::thread()->logger())
+        logger->flush();
 
     return result;
 }
 
+MI_VARIANT typename SamplingIntegrator<Float, Spectrum>::Vector2i
+SamplingIntegrator<Float, Spectrum>::sample_positions(const Film *film,
+                                                      uint32_t spp_per_pass,
+                                                      uint32_t row_offset,
+                                                      size_t size) const {
+    ScalarVector2u film_size = film->crop_size();
+    if (film->sample_border())
+        film_size += 2 * film->rfilter()->border_size();
+
+    UInt32 idx = dr::arange<UInt32>((uint32_t) size);
+
+    // Try to avoid a division by an unknown constant if we can help it
+    uint32_t log_spp_per_pass = dr::log2i(spp_per_pass);
+    if ((1u << log_spp_per_pass) == spp_per_pass)
+        idx >>= dr::opaque<UInt32>(log_spp_per_pass);
+    else
+        idx /= dr::opaque<UInt32>(spp_per_pass);
+
+    // Compute the position on the image plane
+    Vector2i pos;
+    pos.y() = idx / film_size[0];
+    pos.x() = dr::fnmadd(film_size[0], pos.y(), idx);
+    pos.y() += (int32_t) row_offset;
+
+    if (film->sample_border())
+        pos -= film->rfilter()->border_size();
+
+    return pos + film->crop_offset();
+}
+
+MI_VARIANT void SamplingIntegrator<Float, Spectrum>::render_bands(
+    const Scene *scene, const Sensor *sensor, Sampler *sampler,
+    ImageBlock *block, Float *aovs, uint32_t seed, uint32_t spp_per_pass,
+    uint32_t n_passes, uint32_t band_height,
+    ScalarFloat diff_scale_factor) const {
+    const Film *film = sensor->film();
+    ScalarVector2u film_size = film->crop_size();
+    if (film->sample_border())
+        film_size += 2 * film->rfilter()->border_size();
+
+    uint32_t n_bands = (film_size.y() + band_height - 1) / band_height;
+
+    // Render the image bands one after the other, each with its own seed
+    for (uint32_t band = 0; band < n_bands && !should_stop(); band++) {
+        uint32_t row_offset = band * band_height,
+                 rows = std::min(band_height, film_size.y() - row_offset);
+        size_t band_size = (size_t) film_size.x() * (size_t) rows *
+                           (size_t) spp_per_pass;
+
+        sampler->seed(band == 0 ? seed : sample_tea_32(seed, band).first,
+                      (uint32_t) band_size);
+        Vector2i pos = sample_positions(film, spp_per_pass, row_offset, band_size);
+
+        for (size_t i = 0; i < n_passes; i++) {
+            render_sample(scene, sensor, sampler, block, aovs, pos,
+                          diff_scale_factor);
+            if (n_passes > 1) {
+                sampler->advance(); // Will trigger a kernel launch of size 1
+                sampler->schedule_state();
+            }
+            dr::eval(block->tensor());
+        }
+    }
+}
+
 MI_VARIANT void SamplingIntegrator<Float, Spectrum>::render_block(const Scene *scene,
                                                                    const Sensor *sensor,
                                                                    Sampler *sampler,
@@ -374,7 +1724,10 @@ MI_VARIANT void SamplingIntegrator<Float, Spectrum>::render_block(const Scene *s
                                                                    uint32_t sample_count,
                                                                    uint32_t seed,
                                                                    uint32_t block_id,
-                                                                   uint32_t block_size) const {
+                                                                   uint32_t block_size,
+                                                                   ScalarFloat *moments,
+                                                                   uint32_t pixel_begin,
+                                                                   uint32_t pixel_end) const {
 
     if constexpr (!dr::is_array_v<Float>) {
         uint32_t pixel_count = block_size * block_size;
@@ -388,10 +1741,16 @@ MI_VARIANT void SamplingIntegrator<Float, Spectrum>::render_block(const Scene *s
         // Clear block (it's being reused)
         block->clear();
 
-        for (uint32_t i = 0; i < pixel_count && !should_stop(); ++i) {
+        /* Only render the pixels [pixel_begin, pixel_end) of the block (in
+           Morton order), which start at the offset of 'block'. Aligned
+           ranges, e.g. quadrants, cover a square part of the block. */
+        pixel_end = std::min(pixel_end, pixel_count);
+        Point2u origin = dr::morton_decode<Point2u>(pixel_begin);
+
+        for (uint32_t i = pixel_begin; i < pixel_end && !should_stop(); ++i) {
             sampler->seed(seed + i);
 
-            Point2u pos = dr::morton_decode<Point2u>(i);
+            Point2u pos = dr::morton_decode<Point2u>(i) - origin;
             if (dr::any(pos >= block->size()))
                 continue;
 
@@ -400,6 +1759,13 @@ MI_VARIANT void SamplingIntegrator<Float, Spectrum>::render_block(const Scene *s
                 render_sample(scene, sensor, sampler, block, aovs, pos_f,
                               diff_scale_factor);
                 sampler->advance();
+
+                // Accumulate luminance moments (adaptive sampling)
+                if (moments) {
+                    Float lum = luminance(Color3f(aovs[0], aovs[1], aovs[2]));
+                    moments[2 * i]     += lum;
+                    moments[2 * i + 1] += dr::square(lum);
+                }
             }
         }
     } else {
@@ -412,6 +1778,9 @@ MI_VARIANT void SamplingIntegrator<Float, Spectrum>::render_block(const Scene *s
         DRJIT_MARK_USED(seed);
         DRJIT_MARK_USED(block_id);
         DRJIT_MARK_USED(block_size);
+        DRJIT_MARK_USED(moments);
+        DRJIT_MARK_USED(pixel_begin);
+        DRJIT_MARK_USED(pixel_end);
         Throw("Not implemented for JIT arrays.");
     }
 }
@@ -432,6 +1801,11 @@ SamplingIntegrator<Float, Spectrum>::render_sample(const Scene *scene,
     ScalarVector2f scale = 1.f / ScalarVector2f(film->crop_size()),
                    offset = -ScalarVector2f(film->crop_offset()) * scale;
 
+    // Time the sample for the 'render_cost' channel (scalar variants)
+    std::chrono::steady_clock::time_point start;
+    if (!dr::is_jit_v<Float> && m_render_cost_channel)
+        start = std::chrono::steady_clock::now();
+
     Vector2f sample_pos   = pos + sampler->next_2d(active),
              adjusted_pos = dr::fmadd(sample_pos, scale, offset);
 
@@ -455,6 +1829,8 @@ SamplingIntegrator<Float, Spectrum>::render_sample(const Scene *scene,
 
     const Medium *medium = sensor->medium();
 
+    record_event(RenderCounter::Samples, active);
+
     auto [spec, valid] = sample(scene, sampler, ray, medium,
                aovs + (has_alpha ? 5 : 4) /* skip R,G,B,[A],W */, active);
 
@@ -486,6 +1862,12 @@ SamplingIntegrator<Float, Spectrum>::render_sample(const Scene *scene,
         }
     }
 
+    if constexpr (!dr::is_jit_v<Float>) {
+        if (m_render_cost_channel)
+            aovs[m_render_cost_channel] = (Float) std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count();
+    }
+
     // With box filter, ignore random offset to prevent numerical instabilities
     block->put(box_filter ? pos : sample_pos, aovs, active);
 }
@@ -500,6 +1882,129 @@ SamplingIntegrator<Float, Spectrum>::sample(const Scene * /* scene */,
     NotImplementedError("sample");
 }
 
+MI_VARIANT void SamplingIntegrator<Float, Spectrum>::write_primary_aovs(
+    const std::vector<PrimaryAOV> &types, const Scene *scene,
+    const RayDifferential3f &ray, SurfaceInteraction3f si, Float *aovs,
+    Mask active) const {
+    dr::masked(si, !si.is_valid()) = dr::zeros<SurfaceInteraction3f>();
+
+    // Shape indexing data structure for scalar variants
+    std::unordered_map<const Shape *, uint32_t> shape_to_idx;
+    if constexpr (!dr::is_jit_v<Float>) {
+        if (std::find(types.begin(), types.end(), PrimaryAOV::ShapeIndex) !=
+            types.end()) {
+            uint32_t counter = 1; // 0 reserved for background
+            for (const ref<Shape> &shape : scene->shapes())
+                shape_to_idx[shape.get()] = counter++;
+        }
+    } else {
+        DRJIT_MARK_USED(scene);
+    }
+
+    for (PrimaryAOV type : types) {
+        switch (type) {
+            case PrimaryAOV::Albedo: {
+                    Color3f rgb(0.f);
+                    if (dr::any_or<true>(si.is_valid())) {
+                        Mask valid = active && si.is_valid();
+                        BSDFPtr bsdf = si.bsdf(ray);
+                        UnpolarizedSpectrum spec = unpolarized_spectrum(
+                            bsdf->eval_diffuse_reflectance(si, valid));
+
+                        if constexpr (is_monochromatic_v<Spectrum>) {
+                            dr::masked(rgb, valid) = Color3f(spec.x());
+                        } else if constexpr (is_rgb_v<Spectrum>) {
+                            dr::masked(rgb, valid) = spec;
+                        } else {
+                            /* Note: this assumes that sensor used
+                               sample_rgb_spectrum() to generate 'ray.wavelengths' */
+                            auto pdf = pdf_rgb_spectrum(ray.wavelengths);
+                            spec *= dr::select(pdf != 0.f, dr::rcp(pdf), 0.f);
+                            dr::masked(rgb, valid) =
+                                spectrum_to_srgb(spec, ray.wavelengths, valid);
+                        }
+                    }
+
+                    *aovs++ = rgb.r();
+                    *aovs++ = rgb.g();
+                    *aovs++ = rgb.b();
+                }
+                break;
+
+            case PrimaryAOV::Depth:
+                *aovs++ = dr::select(si.is_valid(), si.t, 0.f);
+                break;
+
+            case PrimaryAOV::Position:
+                *aovs++ = si.p.x();
+                *aovs++ = si.p.y();
+                *aovs++ = si.p.z();
+                break;
+
+            case PrimaryAOV::UV:
+                *aovs++ = si.uv.x();
+                *aovs++ = si.uv.y();
+                break;
+
+            case PrimaryAOV::GeometricNormal:
+                *aovs++ = si.n.x();
+                *aovs++ = si.n.y();
+                *aovs++ = si.n.z();
+                break;
+
+            case PrimaryAOV::ShadingNormal:
+                *aovs++ = si.sh_frame.n.x();
+                *aovs++ = si.sh_frame.n.y();
+                *aovs++ = si.sh_frame.n.z();
+                break;
+
+            case PrimaryAOV::dPdU:
+                *aovs++ = si.dp_du.x();
+                *aovs++ = si.dp_du.y();
+                *aovs++ = si.dp_du.z();
+                break;
+
+            case PrimaryAOV::dPdV:
+                *aovs++ = si.dp_dv.x();
+                *aovs++ = si.dp_dv.y();
+                *aovs++ = si.dp_dv.z();
+                break;
+
+            case PrimaryAOV::dUVdx:
+                si.compute_uv_partials(ray);
+                *aovs++ = si.duv_dx.x();
+                *aovs++ = si.duv_dx.y();
+                break;
+
+            case PrimaryAOV::dUVdy:
+                si.compute_uv_partials(ray);
+                *aovs++ = si.duv_dy.x();
+                *aovs++ = si.duv_dy.y();
+                break;
+
+            case PrimaryAOV::PrimIndex:
+                *aovs++ = Float(si.prim_index);
+                break;
+
+            case PrimaryAOV::ShapeIndex:
+                if constexpr (!dr::is_jit_v<Float>) {
+                    ShapePtr target = si.instance;
+                    if (!target)
+                        target = si.shape;
+
+                    auto it = shape_to_idx.find(target);
+                    if (it == shape_to_idx.end())
+                        *aovs++ = 0;
+                    else
+                        *aovs++ = Float(it->second);
+                } else {
+                    *aovs++ = Float(dr::reinterpret_array<UInt32>(si.shape));
+                }
+                break;
+        }
+    }
+}
+
 // -----------------------------------------------------------------------------
 
 MI_VARIANT MonteCarloIntegrator<Float, Spectrum>::MonteCarloIntegrator(const Properties &props)
@@ -523,6 +2028,161 @@ MI_VARIANT MonteCarloIntegrator<Float, Spectrum>::MonteCarloIntegrator(const Pro
 
 MI_VARIANT MonteCarloIntegrator<Float, Spectrum>::~MonteCarloIntegrator() { }
 
+MI_VARIANT void
+MonteCarloIntegrator<Float, Spectrum>::parse_adjoint_rr(const Properties &props) {
+    std::string rr_mode = props.string("rr_mode", "throughput");
+    if (rr_mode == "adjoint")
+        m_adjoint_rr = true;
+    else if (rr_mode != "throughput")
+        Throw("Invalid \"rr_mode\" value \"%s\", must be \"throughput\" or "
+              "\"adjoint\"!", rr_mode);
+
+    int training_passes = props.get<int>("rr_training_passes", 3),
+        training_spp = props.get<int>("rr_training_spp", 4),
+        resolution = props.get<int>("rr_grid_resolution", 32);
+    if (training_passes <= 0)
+        Throw("\"rr_training_passes\" must be positive!");
+    if (training_spp <= 0)
+        Throw("\"rr_training_spp\" must be positive!");
+    if (resolution <= 0)
+        Throw("\"rr_grid_resolution\" must be positive!");
+    m_rr_training_passes = (uint32_t) training_passes;
+    m_rr_training_spp = (uint32_t) training_spp;
+    m_rr_resolution = (uint32_t) resolution;
+
+    m_rr_window = props.get<ScalarFloat>("rr_window", 5.f);
+    if (m_rr_window < 1.f)
+        Throw("\"rr_window\" must be greater than or equal to 1!");
+}
+
+MI_VARIANT typename MonteCarloIntegrator<Float, Spectrum>::TensorXf
+MonteCarloIntegrator<Float, Spectrum>::render(Scene *scene, Sensor *sensor,
+                                              uint32_t seed, uint32_t spp,
+                                              bool develop, bool evaluate) {
+    if (!m_adjoint_rr)
+        return Base::render(scene, sensor, seed, spp, develop, evaluate);
+
+    m_rr_bbox = scene->bbox();
+    ScalarVector3f extents = m_rr_bbox.extents();
+    m_rr_scale = dr::select(extents > 0.f,
+                            ScalarFloat(m_rr_resolution) / extents, 0.f);
+    m_rr_estimates = DynamicBuffer<Float>();
+    m_rr_estimate_ready = false;
+
+    // The training passes are regular, non-progressive renderings
+    bool progressive = m_progressive;
+    fs::path checkpoint_path = m_checkpoint_path;
+    m_progressive = false;
+    m_checkpoint_path.clear();
+
+    size_t size = 2 * (size_t) m_rr_resolution * m_rr_resolution * m_rr_resolution;
+    uint32_t training_spp = m_rr_training_spp;
+    for (uint32_t i = 0; i < m_rr_training_passes; ++i) {
+        if constexpr (dr::is_jit_v<Float>)
+            m_rr_train = dr::zeros<DynamicBuffer<Float>>(size);
+        else
+            m_rr_train_host.reset(new AtomicFloat<ScalarFloat>[size]);
+
+        m_rr_recording = true;
+        Base::render(scene, sensor, sample_tea_32(seed, i + 1).first,
+                     training_spp, false, true);
+        m_rr_recording = false;
+        if (should_stop())
+            break;
+
+        rr_update();
+        Log(Info, "Adjoint-driven Russian roulette: training pass %u/%u "
+            "completed (%u sample%s per pixel).", i + 1, m_rr_training_passes,
+            training_spp, training_spp == 1 ? "" : "s");
+        training_spp *= 2;
+    }
+
+    m_progressive = progressive;
+    m_checkpoint_path = checkpoint_path;
+    m_rr_train = DynamicBuffer<Float>();
+    m_rr_train_host.reset();
+
+    return Base::render(scene, sensor, seed, spp, develop, evaluate);
+}
+
+MI_VARIANT typename MonteCarloIntegrator<Float, Spectrum>::UInt32
+MonteCarloIntegrator<Float, Spectrum>::rr_cell(const Point3f &p) const {
+    int32_t res = (int32_t) m_rr_resolution;
+    Vector3i cell = dr::clip(
+        dr::floor2int<Vector3i>((p - m_rr_bbox.min) * m_rr_scale), 0, res - 1);
+    return UInt32((cell.z() * res + cell.y()) * res + cell.x());
+}
+
+MI_VARIANT Float
+MonteCarloIntegrator<Float, Spectrum>::rr_estimate(const Point3f &p,
+                                                   Mask active) const {
+    if (!m_rr_estimate_ready)
+        return -1.f;
+    return dr::gather<Float>(m_rr_estimates, rr_cell(p), active);
+}
+
+MI_VARIANT std::pair<Float, typename MonteCarloIntegrator<Float, Spectrum>::Mask>
+MonteCarloIntegrator<Float, Spectrum>::rr_survival(const Point3f &p,
+                                                   const Spectrum &throughput,
+                                                   const Float &pixel_estimate,
+                                                   Mask active) const {
+    Float estimate = rr_estimate(p, active);
+    active &= estimate >= 0.f && pixel_estimate > 0.f;
+
+    // Expected contribution of the path relative to the pixel estimate
+    Float ratio = dr::mean(unpolarized_spectrum(throughput)) * estimate /
+                  pixel_estimate;
+
+    /* Paths below the lower end of the weight window survive with a
+       probability that brings their weight back to the center of the window.
+       The lower bound on the probability limits the variance caused by
+       inaccurate estimates. */
+    ScalarFloat lower = 2.f / (1.f + m_rr_window);
+    Float prob = dr::select(ratio < lower, dr::maximum(ratio, .05f), 1.f);
+
+    return { dr::detach(prob), active };
+}
+
+MI_VARIANT void
+MonteCarloIntegrator<Float, Spectrum>::rr_record(const Point3f &p,
+                                                 const Float &value,
+                                                 const Float &weight,
+                                                 Mask active) const {
+    active &= dr::isfinite(value) && value >= 0.f && weight > 0.f;
+    UInt32 index = rr_cell(p) * 2u;
+
+    if constexpr (dr::is_jit_v<Float>) {
+        dr::scatter_reduce(ReduceOp::Add, m_rr_train, value * weight, index, active);
+        dr::scatter_reduce(ReduceOp::Add, m_rr_train, weight, index + 1u, active);
+    } else {
+        if (active) {
+            m_rr_train_host[index] += value * weight;
+            m_rr_train_host[index + 1] += weight;
+        }
+    }
+}
+
+MI_VARIANT void MonteCarloIntegrator<Float, Spectrum>::rr_update() {
+    size_t cells = (size_t) m_rr_resolution * m_rr_resolution * m_rr_resolution;
+    std::vector<ScalarFloat> train(2 * cells), estimates(cells);
+
+    if constexpr (dr::is_jit_v<Float>) {
+        auto &&host = dr::migrate(m_rr_train, AllocType::Host);
+        dr::sync_thread();
+        std::copy(host.data(), host.data() + 2 * cells, train.data());
+    } else {
+        for (size_t i = 0; i < 2 * cells; ++i)
+            train[i] = m_rr_train_host[i];
+    }
+
+    for (size_t i = 0; i < cells; ++i)
+        estimates[i] = train[2 * i + 1] > 0.f ? train[2 * i] / train[2 * i + 1]
+                                              : -1.f;
+
+    m_rr_estimates = dr::load<DynamicBuffer<Float>>(estimates.data(), cells);
+    m_rr_estimate_ready = true;
+}
+
 // -----------------------------------------------------------------------------
 
 MI_VARIANT AdjointIntegrator<Float, Spectrum>::AdjointIntegrator(const Properties &props)
@@ -549,7 +2209,20 @@ AdjointIntegrator<Float, Spectrum>::render(Scene *scene,
                                            bool develop,
                                            bool evaluate) {
     ScopedPhase sp(ProfilerPhase::Render);
+    ScopedKernelStatistics kernel_stats(ProfilerPhase::Render,
+                                        (uint32_t) dr::backend_v<Float>);
     m_stop = false;
+    m_passes_completed = 0;
+    statistics_begin(evaluate);
+    capture_begin(evaluate);
+
+    if (!m_checkpoint_path.empty())
+        Log(Warn, "render(): checkpointing is not supported by adjoint "
+                  "integrators, ignoring it.");
+
+    if (m_partition_count > 1)
+        Throw("render(): partitioned rendering is not supported by adjoint "
+              "integrators!");
 
     Film *film = sensor->film();
     ScalarVector2u film_size = film->size(),
@@ -596,6 +2269,31 @@ AdjointIntegrator<Float, Spectrum>::render(Scene *scene,
     ScalarFloat sample_scale =
         dr::prod(crop_size) / ScalarFloat(spp * dr::prod(film_size));
 
+    /* In progressive mode, every pass is a complete estimate on its own. The
+       passes are averaged into 'average', and the film receives the change
+       of this average after each completed pass (which keeps it normalized) */
+    ref<ImageBlock> average;
+    if (m_progressive) {
+        sample_scale = dr::prod(crop_size) /
+                       ScalarFloat(spp_per_pass * dr::prod(film_size));
+        average = film->create_block(ScalarVector2u(0) /* use crop size */,
+                                     true /* normalize */, false /* border */);
+        average->set_offset(film->crop_offset());
+        average->clear();
+    }
+
+    auto accumulate_pass = [&](ImageBlock *pass_block, ScalarFloat weight) {
+        ref<ImageBlock> delta = film->create_block(
+            ScalarVector2u(0) /* use crop size */, true /* normalize */,
+            false /* border */);
+        delta->set_offset(film->crop_offset());
+        delta->tensor() = TensorXf(
+            (pass_block->tensor().array() - average->tensor().array()) * weight,
+            3, pass_block->tensor().shape().data());
+        average->put_block(delta);
+        film->put_block(delta);
+    };
+
     TensorXf result;
     if constexpr (!dr::is_jit_v<Float>) {
         size_t n_threads = Thread::thread_count();
@@ -623,56 +2321,135 @@ AdjointIntegrator<Float, Spectrum>::render(Scene *scene,
         // Start the render timer (used for timeouts & log messages)
         m_render_timer.reset();
 
-        ThreadEnvironment env;
-        dr::parallel_for(
-            dr::blocked_range<size_t>(0, total_samples, grain_size),
-            [&](const dr::blocked_range<size_t> &range) {
-                ScopedSetThreadEnvironment set_env(env);
-
-                // Fork a non-overlapping sampler for the current worker
-                ref<Sampler> sampler = sensor->sampler()->clone();
-
-                ref<ImageBlock> block = film->create_block(
-                    ScalarVector2u(0) /* use crop size */,
-                    true /* normalize */,
-                    false /* border */);
-
-                block->set_offset(film->crop_offset());
-
-                // Clear block (it's being reused)
-                block->clear();
-
-                sampler->seed(seed +
-                              (uint32_t) range.begin() / (uint32_t) grain_size);
+        /* Long-lived splat buffers, one per thread pool worker (and one for
+           the calling thread). They are created on demand, and reused across
+           chunks and passes. */
+        std::vector<ref<ImageBlock>> blocks(pool_size() + 1);
+
+        /* Render 'n_samples' samples in parallel and accumulate them into
+           'target' (either the film or an image block) */
+        auto render_samples = [&](size_t n_samples, uint32_t pass_seed, auto *target) {
+            ThreadEnvironment env;
+            dr::parallel_for(
+                dr::blocked_range<size_t>(0, n_samples, grain_size),
+                [&](const dr::blocked_range<size_t> &range) {
+                    ScopedSetThreadEnvironment set_env(env);
+
+                    // Fork a non-overlapping sampler for the current worker
+                    ref<Sampler> sampler = sensor->sampler()->clone();
+
+                    uint32_t worker = pool_thread_id();
+                    Assert(worker < blocks.size());
+                    ref<ImageBlock> &block = blocks[worker];
+                    if (!block) {
+                        block = film->create_block(
+                            ScalarVector2u(0) /* use crop size */,
+                            true /* normalize */,
+                            false /* border */);
+                        block->set_offset(film->crop_offset());
+                        block->clear();
+                    }
 
-                size_t ctr = 0;
-                for (auto i = range.begin(); i != range.end() && !should_stop(); ++i) {
-                    sample(scene, sensor, sampler, block, sample_scale);
-                    sampler->advance();
+                    sampler->seed(pass_seed +
+                                  (uint32_t) range.begin() / (uint32_t) grain_size);
+
+                    size_t ctr = 0;
+                    for (auto i = range.begin(); i != range.end() && !should_stop() &&
+                         !(m_progressive && budget_exhausted()); ++i) {
+                        sample(scene, sensor, sampler, block, sample_scale);
+                        sampler->advance();
+
+                        ctr++;
+                        if (ctr > 10000) {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            samples_done += ctr;
+                            ctr = 0;
+                            if (!m_progressive)
+                                progress->update(samples_done / (ScalarFloat) total_samples);
+                            else if (m_timeout > 0.f)
+                                progress->update(std::min(m_render_timer.value() /
+                                                          (1000.f * m_timeout), 1.f));
+                        }
+                    }
+                    samples_done += ctr;
 
-                    ctr++;
-                    if (ctr > 10000) {
+                    if (!m_progressive) {
                         std::lock_guard<std::mutex> lock(mutex);
-                        samples_done += ctr;
-                        ctr = 0;
                         progress->update(samples_done / (ScalarFloat) total_samples);
                     }
                 }
-                total_samples += ctr;
+            );
+
+            /* Tree reduction of the splat buffers: merge pairs of buffers in
+               parallel, clearing the merged ones so that they can be reused */
+            std::vector<ImageBlock *> used;
+            for (ref<ImageBlock> &block : blocks)
+                if (block)
+                    used.push_back(block.get());
+
+            for (size_t stride = 1; stride < used.size(); stride *= 2) {
+                size_t n_pairs = (used.size() + stride - 1) / (2 * stride);
+                dr::parallel_for(
+                    dr::blocked_range<size_t>(0, n_pairs, 1),
+                    [&](const dr::blocked_range<size_t> &range) {
+                        for (size_t i = range.begin(); i != range.end(); ++i) {
+                            ImageBlock *dst = used[2 * stride * i],
+                                       *src = used[2 * stride * i + stride];
+                            dst->put_block(src);
+                            src->clear();
+                        }
+                    }
+                );
+            }
 
-                // When all samples are done for this range, commit to the film
-                /* locked */ {
-                    std::lock_guard<std::mutex> lock(mutex);
-                    progress->update(samples_done / (ScalarFloat) total_samples);
-                    film->put_block(block);
+            // Commit the reduced result to the target
+            if (!used.empty()) {
+                target->put_block(used[0]);
+                used[0]->clear();
+            }
+        };
+
+        if (!m_progressive) {
+            render_samples(total_samples, seed, film);
+            m_passes_completed = should_stop() ? 0 : n_passes;
+        } else {
+            ref<ImageBlock> pass_block = film->create_block(
+                ScalarVector2u(0) /* use crop size */, true /* normalize */,
+                false /* border */);
+            pass_block->set_offset(film->crop_offset());
+
+            uint32_t pass = 0;
+            while (!should_stop() && !budget_exhausted()) {
+                pass_block->clear();
+                samples_done = 0;
+
+                // Decorrelate passes by deriving a new seed for each one
+                render_samples(samples_per_pass,
+                               pass == 0 ? seed : sample_tea_32(seed, pass).first,
+                               pass_block.get());
+
+                if (samples_done < samples_per_pass) {
+                    /* Interrupted pass: discard it, unless nothing else is
+                       available. In that case, rescale the partial result. */
+                    if (pass == 0 && samples_done > 0)
+                        accumulate_pass(pass_block, samples_per_pass /
+                                                    (ScalarFloat) samples_done);
+                    break;
                 }
+
+                accumulate_pass(pass_block, 1.f / (pass + 1));
+                m_passes_completed = ++pass;
             }
-        );
+
+            Log(Info, "Progressive rendering completed %u pass%s (%u sample%s per pixel).",
+                pass, pass == 1 ? "" : "es", pass * spp_per_pass,
+                pass * spp_per_pass == 1 ? "" : "s");
+        }
 
         if (develop)
             result = film->develop();
     } else {
-        if (n_passes > 1 && !evaluate) {
+        if ((n_passes > 1 || m_progressive) && !evaluate) {
             Log(Warn, "render(): forcing 'evaluate=true' since multi-pass "
                       "rendering was requested.");
             evaluate = true;
@@ -717,17 +2494,45 @@ AdjointIntegrator<Float, Spectrum>::render(Scene *scene,
         block->set_coalesce(false);
 
         Timer timer;
-        for (size_t i = 0; i < n_passes; i++) {
-            sample(scene, sensor, sampler, block, sample_scale);
+        if (m_progressive) {
+            m_render_timer.reset();
+
+            uint32_t pass = 0;
+            while (!should_stop() && !budget_exhausted()) {
+                if (pass > 0) {
+                    // Decorrelate passes by deriving a new seed for each one
+                    sampler->seed(sample_tea_32(seed, pass).first,
+                                  (uint32_t) samples_per_pass);
+                    block->clear();
+                }
 
-            if (n_passes > 1) {
-                sampler->advance(); // Will trigger a kernel launch of size 1
-                sampler->schedule_state();
-                dr::eval(block->tensor());
+                sample(scene, sensor, sampler, block, sample_scale);
+                accumulate_pass(block, 1.f / (pass + 1));
+                dr::eval(average->tensor());
+                film->schedule_storage();
+                dr::eval();
+                dr::sync_thread();
+
+                m_passes_completed = ++pass;
+            }
+
+            Log(Info, "Progressive rendering completed %u pass%s (%u sample%s per pixel).",
+                pass, pass == 1 ? "" : "es", pass * spp_per_pass,
+                pass * spp_per_pass == 1 ? "" : "s");
+        } else {
+            for (size_t i = 0; i < n_passes; i++) {
+                sample(scene, sensor, sampler, block, sample_scale);
+
+                if (n_passes > 1) {
+                    sampler->advance(); // Will trigger a kernel launch of size 1
+                    sampler->schedule_state();
+                    dr::eval(block->tensor());
+                }
             }
-        }
 
-        film->put_block(block);
+            film->put_block(block);
+            m_passes_completed = n_passes;
+        }
 
         if (develop) {
             result = film->develop();
@@ -737,7 +2542,10 @@ AdjointIntegrator<Float, Spectrum>::render(Scene *scene,
         }
 
         if (evaluate) {
-            dr::eval();
+            {
+                ScopedTraceEvent trace("jit", "Kernel compilation and launch");
+                dr::eval();
+            }
 
             if (n_passes == 1 && jit_flag(JitFlag::VCallRecord) &&
                 jit_flag(JitFlag::LoopRecord)) {
@@ -749,13 +2557,100 @@ AdjointIntegrator<Float, Spectrum>::render(Scene *scene,
                 m_render_timer.reset();
             }
 
+            ScopedTraceEvent trace("jit", "Kernel execution");
             dr::sync_thread();
         }
     }
 
-    if (!m_stop && (evaluate || !dr::is_jit_v<Float>))
+    if (!m_stop && (evaluate || !dr::is_jit_v<Float>)) {
         Log(Info, "Rendering finished. (took %s)",
             util::time_string((float) m_render_timer.value(), true));
+        Log(Info, "%s", MemoryTracker::summary());
+        if (kernel_stats.active())
+            Log(Info, "%s", kernel_stats.finish().to_string());
+    }
+    statistics_end(!m_stop && (evaluate || !dr::is_jit_v<Float>));
+    capture_end();
+
+    // Emit the messages of the render job before returning
+    if (Logger *logger = Thread::thread()->logger())
+        logger->flush();
+
+    return result;
+}
+
+MI_VARIANT Spectrum AdjointIntegrator<Float, Spectrum>::connect_sensor(
+    const Scene *scene, const SurfaceInteraction3f &si,
+    const DirectionSample3f &sensor_ds, const BSDFPtr &bsdf,
+    const Spectrum &weight, ImageBlock *block, ScalarFloat sample_scale,
+    Mask active) const {
+    active &= (sensor_ds.pdf > 0.f) &&
+              dr::any(unpolarized_spectrum(weight) != 0.f);
+    if (dr::none_or<false>(active))
+        return 0.f;
+
+    // Check that sensor is visible from current position (shadow ray).
+    Ray3f sensor_ray = si.spawn_ray_to(sensor_ds.p);
+    record_event(RenderCounter::ShadowRays, active);
+    active &= !scene->ray_test(sensor_ray, active);
+    if (dr::none_or<false>(active))
+        return 0.f;
+
+    // Foreshortening term and BSDF value for that direction (for surface interactions).
+    Spectrum result = 0.f;
+    Spectrum surface_weight = 1.f;
+    Vector3f local_d        = si.to_local(sensor_ray.d);
+    Mask on_surface         = active && (si.shape != nullptr);
+    if (dr::any_or<true>(on_surface)) {
+        /* Note that foreshortening is only missing for directly visible
+           emitters associated with a shape. Otherwise it's included in the
+           BSDF. Clamp negative cosines (zero value if behind the surface). */
+
+        surface_weight[on_surface && (bsdf == nullptr)] *=
+            dr::maximum(0.f, Frame3f::cos_theta(local_d));
+
+        on_surface &= bsdf != nullptr;
+        if (dr::any_or<true>(on_surface)) {
+            BSDFContext ctx(TransportMode::Importance);
+            // Using geometric normals
+            Float wi_dot_geo_n = dr::dot(si.n, si.to_world(si.wi)),
+                  wo_dot_geo_n = dr::dot(si.n, sensor_ray.d);
+
+            // Prevent light leaks due to shading normals
+            Mask valid = (wi_dot_geo_n * Frame3f::cos_theta(si.wi) > 0.f) &&
+                         (wo_dot_geo_n * Frame3f::cos_theta(local_d) > 0.f);
+
+            // Adjoint BSDF for shading normals -- [Veach, p. 155]
+            Float correction = dr::select(valid,
+                dr::abs((Frame3f::cos_theta(si.wi) * wo_dot_geo_n) /
+                        (Frame3f::cos_theta(local_d) * wi_dot_geo_n)), 0.f);
+
+            surface_weight[on_surface] *=
+                correction * bsdf->eval(ctx, si, local_d, on_surface);
+        }
+    }
+
+    /* Even if the ray is not coming from a surface (no foreshortening),
+       we still don't want light coming from behind the emitter. */
+    Mask not_on_surface = active && (si.shape == nullptr) && (bsdf == nullptr);
+    if (dr::any_or<true>(not_on_surface)) {
+        Mask invalid_side = Frame3f::cos_theta(local_d) <= 0.f;
+        surface_weight[not_on_surface && invalid_side] = 0.f;
+    }
+
+    result = weight * surface_weight * sample_scale;
+
+    /* Splatting, adjusting UVs for sensor's crop window if needed.
+       The crop window is already accounted for in the UV positions
+       returned by the sensor, here we just need to compensate for
+       the block's offset that will be applied in `put`. */
+    Float alpha = dr::select(bsdf != nullptr, 1.f, 0.f);
+    Vector2f adjusted_position = sensor_ds.uv + block->offset();
+
+    /* Splat RGB value onto the image buffer. The adjoint integrators
+       do not use the weight channel at all */
+    block->put(adjusted_position, si.wavelengths, result, alpha,
+               /* weight = */ 0.f, active);
 
     return result;
 }
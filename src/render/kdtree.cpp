@@ -1,6 +1,10 @@
 #include <mitsuba/render/kdtree.h>
 #include <mitsuba/render/mesh.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/mmap.h>
+#include <mitsuba/core/util.h>
+#include <algorithm>
+#include <cstring>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -48,6 +52,50 @@ MI_VARIANT ShapeKDTree<Float, Spectrum>::ShapeKDTree(const Properties &props)
     if (props.has_property("kd_exact_primitive_threshold"))
         set_exact_primitive_threshold(props.get<int>("kd_exact_primitive_threshold"));
 
+    /* kd-tree construction: Directory of an on-disk cache of built kd-trees.
+       A tree is looked up by a hash of the scene geometry and of the above
+       parameters, and only built (and stored) when it is not found. */
+    if (props.has_property("kd_cache"))
+        m_cache_dir = props.get<std::string>("kd_cache");
+
+    /* kd-tree construction: Map trees found in the cache directly from their
+       file (copy-on-write) instead of copying them into memory. Processes
+       that render the same scene on one machine then share a single copy
+       of the tree through the page cache of the OS, and loading it is
+       nearly instant. */
+    m_cache_map = props.get<bool>("kd_cache_map", false);
+    /* kd-tree construction: Store leaves with a single primitive without an
+       index list entry, and reorder the nodes into cache-line-sized treelets
+       (see TShapeKDTree::set_compact()) */
+    if (props.has_property("kd_compact"))
+        set_compact(props.get<bool>("kd_compact"));
+
+    /* kd-tree traversal: In LLVM variants, traverse the rays of a SIMD
+       packet jointly when they are flagged as coherent (e.g. camera rays) */
+    m_coherent_traversal = props.get<bool>("kd_coherent_traversal", true);
+
+    /* kd-tree traversal: Fraction of idle SIMD lanes per visited node, above
+       which a packet is split into independently traversed rays */
+    m_divergence_threshold = props.get<ScalarFloat>("kd_divergence_threshold", .5f);
+    if (!(m_divergence_threshold >= 0.f && m_divergence_threshold <= 1.f))
+        Throw("kd_divergence_threshold: the threshold must be in [0, 1] "
+              "(got %f)!", m_divergence_threshold);
+
+    /* kd-tree traversal: Precompute the triangles of every leaf and pack them
+       into groups of 4 or 8 for a vectorized intersection test (0: disabled).
+       This avoids fetching the face indices and vertex positions from the
+       mesh buffers during traversal at the cost of extra memory. The spheres
+       of 'spheres' shapes are packed in the same way. */
+    m_packet_width = (uint32_t) props.get<int>("kd_triangle_packets", 0);
+    if (m_packet_width != 0 && m_packet_width != 4 && m_packet_width != 8)
+        Throw("kd_triangle_packets: the packet width must be 0, 4 or 8 (got %i)!",
+              m_packet_width);
+    if (m_packet_width != 0 && dr::is_jit_v<Float>) {
+        Log(Warn, "kd_triangle_packets: precomputed triangles are only "
+                  "supported in scalar variants, ignoring.");
+        m_packet_width = 0;
+    }
+
     m_primitive_map.push_back(0);
 }
 
@@ -56,14 +104,42 @@ MI_VARIANT void ShapeKDTree<Float, Spectrum>::clear() {
     m_primitive_map.clear();
     m_primitive_map.push_back(0);
     m_bbox.reset();
-    m_nodes.release();
-    m_indices.release();
+    Base::set_nodes(nullptr);
+    Base::set_indices(nullptr);
+    m_cache_file = nullptr;
     m_node_count = 0;
     m_index_count = 0;
+    m_memory.set(0);
+    m_leaf_packets.clear();
+    m_packets_4.clear();
+    m_packets_8.clear();
+    m_sphere_packets_4.clear();
+    m_sphere_packets_8.clear();
 }
 
 MI_VARIANT void ShapeKDTree<Float, Spectrum>::build() {
     Timer timer;
+
+    /* The key must be computed before the build, which may adjust some of
+       the build-related parameters (e.g. the maximum depth) */
+    fs::path cache_file;
+    uint64_t key = 0;
+    if (!m_cache_dir.empty()) {
+        key = cache_key();
+        cache_file = fs::path(m_cache_dir) /
+                     fs::path(tfm::format("kdtree_%016llx.bin",
+                                          (unsigned long long) key));
+        if (cache_load(cache_file, key)) {
+            Log(Info, "Loaded the kd-tree (%i primitives) from \"%s\" (%s of "
+                "storage, took %s)", primitive_count(), cache_file,
+                util::mem_string(m_index_count * sizeof(Index) +
+                                 m_node_count * sizeof(KDNode)),
+                util::time_string((float) timer.value()));
+            build_triangle_packets();
+            return;
+        }
+    }
+
     Log(Info, "Building a SAH kd-tree (%i primitives) ..",
         primitive_count());
 
@@ -74,6 +150,329 @@ MI_VARIANT void ShapeKDTree<Float, Spectrum>::build() {
                         m_node_count * sizeof(KDNode)),
         util::time_string((float) timer.value())
     );
+
+    if (!cache_file.empty())
+        cache_store(cache_file, key);
+
+    build_triangle_packets();
+}
+
+MI_VARIANT void ShapeKDTree<Float, Spectrum>::build_triangle_packets() {
+    m_leaf_packets.clear();
+    m_packets_4.clear();
+    m_packets_8.clear();
+    m_sphere_packets_4.clear();
+    m_sphere_packets_8.clear();
+
+    if (m_packet_width == 0 || m_node_count == 0)
+        return;
+
+    Timer timer;
+    size_t size;
+    if (m_packet_width == 8) {
+        build_triangle_packets(m_packets_8, m_sphere_packets_8);
+        size = m_packets_8.size() * sizeof(TrianglePacket<8>) +
+               m_sphere_packets_8.size() * sizeof(SpherePacket<8>);
+    } else {
+        build_triangle_packets(m_packets_4, m_sphere_packets_4);
+        size = m_packets_4.size() * sizeof(TrianglePacket<4>) +
+               m_sphere_packets_4.size() * sizeof(SpherePacket<4>);
+    }
+
+    Log(Info, "Precomputed the triangles and spheres of the kd-tree leaves (%s "
+        "of storage, took %s)", util::mem_string(size + m_node_count * sizeof(LeafPackets)),
+        util::time_string((float) timer.value()));
+}
+
+MI_VARIANT template <size_t Width>
+void ShapeKDTree<Float, Spectrum>::build_triangle_packets(
+    std::vector<TrianglePacket<Width>> &packets,
+    std::vector<SpherePacket<Width>> &sphere_packets) {
+    if constexpr (!dr::is_jit_v<Float>) {
+        m_leaf_packets.resize(m_node_count);
+
+        auto is_triangle = [&](Index prim_index) {
+            return m_shapes[find_shape(prim_index)]->is_mesh();
+        };
+
+        auto is_sphere = [&](Index prim_index) {
+            return m_shapes[find_shape(prim_index)]->shape_type() ==
+                   +ShapeType::Spheres;
+        };
+
+        for (Size i = 0; i < m_node_count; ++i) {
+            const KDNode &node = m_nodes[i];
+            LeafPackets &lp = m_leaf_packets[i];
+            lp.offset = (Index) packets.size();
+            lp.triangle_count = 0;
+            lp.sphere_offset = (Index) sphere_packets.size();
+            lp.sphere_count = 0;
+
+            if (!node.leaf() || node.primitive_count() == 0)
+                continue;
+
+            // Single-primitive leaves of the compact layout need no reordering
+            Index inline_index = node.primitive_offset();
+            Index *start = this->compact() && node.primitive_count() == 1
+                               ? &inline_index
+                               : m_indices.get() + node.primitive_offset(),
+                  *end   = start + node.primitive_count();
+
+            // Move the triangles to the front of the leaf
+            Index *mid = std::stable_partition(start, end, is_triangle);
+            lp.triangle_count = (Index) (mid - start);
+
+            for (Index *it = start; it < mid; it += Width) {
+                TrianglePacket<Width> tp;
+                std::memset(&tp, 0, sizeof(TrianglePacket<Width>));
+
+                for (size_t k = 0; k < Width && it + k < mid; ++k) {
+                    Index prim_index  = it[k],
+                          shape_index = find_shape(prim_index);
+                    const Mesh *mesh = (const Mesh *) m_shapes[shape_index].get();
+
+                    ScalarVector3u fi = mesh->face_indices(prim_index);
+                    ScalarPoint3f p0 = mesh->vertex_position(fi[0]),
+                                  p1 = mesh->vertex_position(fi[1]),
+                                  p2 = mesh->vertex_position(fi[2]);
+                    ScalarVector3f e1 = p1 - p0, e2 = p2 - p0;
+
+                    for (size_t j = 0; j < 3; ++j) {
+                        tp.p0[j][k] = p0[j];
+                        tp.e1[j][k] = e1[j];
+                        tp.e2[j][k] = e2[j];
+                    }
+                    tp.shape_index[k] = shape_index;
+                    tp.prim_index[k]  = prim_index;
+                }
+
+                packets.push_back(tp);
+            }
+
+            // Followed by the spheres
+            Index *sphere_end = std::stable_partition(mid, end, is_sphere);
+            lp.sphere_count = (Index) (sphere_end - mid);
+
+            for (Index *it = mid; it < sphere_end; it += Width) {
+                SpherePacket<Width> sp;
+                std::memset(&sp, 0, sizeof(SpherePacket<Width>));
+
+                for (size_t k = 0; k < Width && it + k < sphere_end; ++k) {
+                    Index prim_index  = it[k],
+                          shape_index = find_shape(prim_index);
+
+                    auto [center, radius] =
+                        m_shapes[shape_index]->sphere_primitive(prim_index);
+
+                    for (size_t j = 0; j < 3; ++j)
+                        sp.center[j][k] = center[j];
+                    sp.radius[k]      = radius;
+                    sp.shape_index[k] = shape_index;
+                    sp.prim_index[k]  = prim_index;
+                }
+
+                sphere_packets.push_back(sp);
+            }
+        }
+    } else {
+        DRJIT_MARK_USED(packets);
+        DRJIT_MARK_USED(sphere_packets);
+        Throw("build_triangle_packets(): only supported in scalar variants!");
+    }
+}
+
+NAMESPACE_BEGIN(detail)
+
+/// Header of a kd-tree cache file
+struct KDTreeCacheHeader {
+    char id[4];
+    uint32_t version;
+    uint64_t key;
+    double bbox_min[3], bbox_max[3];
+    uint32_t node_size, index_size;
+    uint32_t node_count, index_count;
+};
+
+static constexpr char KDTreeCacheId[4] = { 'M', 'I', 'K', 'D' };
+static constexpr uint32_t KDTreeCacheVersion = 2;
+
+/// Offset of the nodes in a cache file, which keeps them aligned when mapped
+static constexpr size_t KDTreeCacheDataOffset = 128;
+static_assert(sizeof(KDTreeCacheHeader) <= KDTreeCacheDataOffset &&
+              KDTreeCacheDataOffset % MI_KD_NODE_ALIGNMENT == 0);
+
+/// 64-bit FNV-1a hash used to identify cached kd-trees
+inline void kdtree_hash(uint64_t &hash, const void *ptr, size_t size) {
+    const uint8_t *data = (const uint8_t *) ptr;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+}
+
+template <typename T> void kdtree_hash(uint64_t &hash, const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    kdtree_hash(hash, &value, sizeof(T));
+}
+
+NAMESPACE_END(detail)
+
+MI_VARIANT uint64_t ShapeKDTree<Float, Spectrum>::cache_key() const {
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    // Build-related parameters
+    SurfaceAreaHeuristic3f model = this->cost_model();
+    detail::kdtree_hash(hash, (uint32_t) sizeof(ScalarFloat));
+    detail::kdtree_hash(hash, model.query_cost());
+    detail::kdtree_hash(hash, model.traversal_cost());
+    detail::kdtree_hash(hash, model.empty_space_bonus());
+    detail::kdtree_hash(hash, this->max_depth());
+    detail::kdtree_hash(hash, this->min_max_bins());
+    detail::kdtree_hash(hash, this->clip_primitives());
+    detail::kdtree_hash(hash, this->retract_bad_splits());
+    detail::kdtree_hash(hash, this->max_bad_refines());
+    detail::kdtree_hash(hash, this->stop_primitives());
+    detail::kdtree_hash(hash, this->exact_primitive_threshold());
+    detail::kdtree_hash(hash, this->compact());
+
+    // Geometry of all shapes, in registration order
+    for (const Shape *shape : m_shapes) {
+        detail::kdtree_hash(hash, shape->primitive_count());
+        if (shape->is_mesh()) {
+            const Mesh *mesh = (const Mesh *) shape;
+            for (uint32_t i = 0; i < mesh->vertex_count(); ++i) {
+                ScalarPoint3f p = mesh->vertex_position(i);
+                for (size_t k = 0; k < 3; ++k)
+                    detail::kdtree_hash(hash, p[k]);
+            }
+            for (uint32_t i = 0; i < mesh->face_count(); ++i) {
+                ScalarVector3u fi = mesh->face_indices(i);
+                for (size_t k = 0; k < 3; ++k)
+                    detail::kdtree_hash(hash, fi[k]);
+            }
+        } else {
+            /* Other shapes are identified by their type and parameters. The
+               construction only depends on their geometry through the
+               bounds of the individual primitives (e.g. curve segments,
+               SDF grid voxels or the spheres of a sphere mesh), which are
+               hashed one at a time. */
+            std::string desc = std::string(shape->class_()->name()) +
+                               shape->to_string();
+            detail::kdtree_hash(hash, desc.data(), desc.size());
+            uint32_t count = shape->primitive_count();
+            for (uint32_t i = 0; i < count; ++i) {
+                ScalarBoundingBox3f bbox =
+                    count == 1 ? shape->bbox() : shape->bbox(i);
+                for (size_t k = 0; k < 3; ++k) {
+                    detail::kdtree_hash(hash, bbox.min[k]);
+                    detail::kdtree_hash(hash, bbox.max[k]);
+                }
+            }
+        }
+    }
+
+    return hash;
+}
+
+MI_VARIANT bool ShapeKDTree<Float, Spectrum>::cache_load(const fs::path &filename,
+                                                        uint64_t key) {
+    if (!fs::exists(filename))
+        return false;
+
+    try {
+        /* Copy-on-write, since leaves are reordered by the construction of
+           triangle packets. Untouched pages remain shared with the file. */
+        ref<MemoryMappedFile> mmap =
+            m_cache_map ? MemoryMappedFile::map_copy_on_write(filename)
+                        : ref<MemoryMappedFile>(new MemoryMappedFile(filename));
+        uint8_t *data = (uint8_t *) mmap->data();
+
+        detail::KDTreeCacheHeader header;
+        if (mmap->size() < sizeof(header))
+            Throw("file is truncated");
+        std::memcpy(&header, data, sizeof(header));
+
+        if (std::memcmp(header.id, detail::KDTreeCacheId, 4) != 0 ||
+            header.version != detail::KDTreeCacheVersion)
+            Throw("unsupported file format");
+        if (header.key != key ||
+            header.node_size != sizeof(KDNode) ||
+            header.index_size != sizeof(Index))
+            Throw("file does not match the scene geometry");
+
+        size_t node_bytes  = (size_t) header.node_count * sizeof(KDNode),
+               index_bytes = (size_t) header.index_count * sizeof(Index);
+        if (header.node_count == 0 ||
+            mmap->size() != detail::KDTreeCacheDataOffset + node_bytes + index_bytes)
+            Throw("file is truncated");
+
+        m_node_count  = header.node_count;
+        m_index_count = header.index_count;
+        uint8_t *nodes   = data + detail::KDTreeCacheDataOffset,
+                *indices = nodes + node_bytes;
+        if (m_cache_map) {
+            // The file-backed pages are not accounted as kd-tree memory
+            Base::set_nodes((KDNode *) nodes, false);
+            Base::set_indices((Index *) indices, false);
+            m_cache_file = mmap;
+            m_memory.set(0);
+        } else {
+            Base::set_nodes(Base::allocate_nodes(m_node_count));
+            Base::set_indices(new Index[m_index_count]);
+            std::memcpy((void *) m_nodes.get(), nodes, node_bytes);
+            std::memcpy(m_indices.get(), indices, index_bytes);
+            m_memory.set(node_bytes + index_bytes);
+        }
+
+        for (size_t i = 0; i < 3; ++i) {
+            m_bbox.min[i] = (ScalarFloat) header.bbox_min[i];
+            m_bbox.max[i] = (ScalarFloat) header.bbox_max[i];
+        }
+    } catch (const std::exception &e) {
+        Log(Warn, "Ignoring the kd-tree cache file \"%s\": %s", filename, e.what());
+        return false;
+    }
+
+    return true;
+}
+
+MI_VARIANT void ShapeKDTree<Float, Spectrum>::cache_store(const fs::path &filename,
+                                                         uint64_t key) const {
+    detail::KDTreeCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.id, detail::KDTreeCacheId, 4);
+    header.version     = detail::KDTreeCacheVersion;
+    header.key         = key;
+    header.node_size   = (uint32_t) sizeof(KDNode);
+    header.index_size  = (uint32_t) sizeof(Index);
+    header.node_count  = m_node_count;
+    header.index_count = m_index_count;
+    for (size_t i = 0; i < 3; ++i) {
+        header.bbox_min[i] = (double) m_bbox.min[i];
+        header.bbox_max[i] = (double) m_bbox.max[i];
+    }
+
+    size_t node_bytes  = (size_t) m_node_count * sizeof(KDNode),
+           index_bytes = (size_t) m_index_count * sizeof(Index);
+
+    try {
+        util::write_file_atomic(filename, [&](const fs::path &tmp_file) {
+            ref<MemoryMappedFile> mmap = new MemoryMappedFile(
+                tmp_file, detail::KDTreeCacheDataOffset + node_bytes + index_bytes);
+            uint8_t *data = (uint8_t *) mmap->data();
+            std::memset(data, 0, detail::KDTreeCacheDataOffset);
+            std::memcpy(data, &header, sizeof(header));
+            std::memcpy(data + detail::KDTreeCacheDataOffset,
+                        (const void *) m_nodes.get(), node_bytes);
+            std::memcpy(data + detail::KDTreeCacheDataOffset + node_bytes,
+                        m_indices.get(), index_bytes);
+        });
+
+        Log(Info, "Stored the kd-tree in \"%s\"", filename);
+    } catch (const std::exception &e) {
+        Log(Warn, "Could not store the kd-tree cache file \"%s\": %s",
+            filename, e.what());
+    }
 }
 
 MI_VARIANT void ShapeKDTree<Float, Spectrum>::add_shape(Shape *shape) {
@@ -0,0 +1,744 @@
+#include <mitsuba/render/lightbvh.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/mesh.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/core/warp.h>
+#include <algorithm>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/// Marks the entries of the child array that refer to emitters (or triangles)
+static constexpr uint32_t LightBVHLeafFlag = 0x80000000u;
+
+/// Number of buckets per axis considered by the split heuristic
+static constexpr uint32_t LightBVHBucketCount = 12;
+
+/* Beyond this depth, the hierarchy is split at the median so that the bit
+   trails (64 bits) of all emitters are guaranteed to be long enough */
+static constexpr uint32_t LightBVHMedianDepth = 32;
+
+MI_VARIANT LightBVH<Float, Spectrum>::LightBVH(const std::vector<ref<Emitter>> &emitters) {
+    Timer timer;
+    m_emitter_count = (uint32_t) emitters.size();
+    if (emitters.size() >= LightBVHLeafFlag)
+        Throw("LightBVH: too many emitters (%zu)!", emitters.size());
+
+    std::vector<std::pair<uint32_t, LightBounds>> items;
+    std::vector<uint32_t> state(emitters.size(), 0), infinite,
+                          offset(emitters.size(), 0);
+    // Triangles of the emissive meshes with per-triangle leaves
+    std::vector<std::pair<uint32_t, std::vector<std::pair<uint32_t, LightBounds>>>> meshes;
+    std::vector<ScalarFloat> triangle_area;
+
+    for (size_t i = 0; i < emitters.size(); ++i) {
+        const Emitter *emitter = emitters[i].get();
+        if (emitter->sampling_weight() <= 0.f)
+            continue;
+
+        uint32_t flags = emitter->flags();
+        if (has_flag(flags, EmitterFlags::Infinite) ||
+            has_flag(flags, EmitterFlags::DeltaDirection)) {
+            infinite.push_back((uint32_t) i);
+            state[i] = 2;
+            continue;
+        }
+
+        LightBounds bounds;
+        offset[i] = (uint32_t) triangle_area.size();
+        auto triangles = triangle_bounds(emitter, triangle_area);
+        if (!triangles.empty()) {
+            // The upper level bounds the mesh by the union of its triangles
+            for (const auto &item : triangles)
+                bounds = merge(bounds, item.second);
+            meshes.emplace_back((uint32_t) i, std::move(triangles));
+        } else {
+            bounds = emitter_bounds(emitter);
+        }
+
+        if (!bounds.valid) {
+            infinite.push_back((uint32_t) i);
+            state[i] = 2;
+            continue;
+        }
+
+        items.emplace_back((uint32_t) i, bounds);
+        state[i] = 1;
+    }
+
+    std::vector<uint64_t> trail(emitters.size(), 0),
+                          triangle_trail(triangle_area.size(), 0);
+    if (!items.empty())
+        build_recursive(items, 0, items.size(), 0, 0, trail.data());
+
+    // Subtrees over the triangles of emissive meshes (after the upper level)
+    std::vector<uint32_t> root(emitters.size(), 0);
+    for (auto &[index, triangles] : meshes)
+        root[index] = build_recursive(triangles, 0, triangles.size(), 0, 0,
+                                      triangle_trail.data() + offset[index]);
+
+    m_node_count     = (uint32_t) m_tmp_child.size();
+    m_infinite_count = (uint32_t) infinite.size();
+    m_triangle_count = (uint32_t) triangle_area.size();
+
+    if (m_node_count > 0) {
+        m_node_bbox_min = dr::load<FloatStorage>(m_tmp_bbox_min.data(), m_tmp_bbox_min.size());
+        m_node_bbox_max = dr::load<FloatStorage>(m_tmp_bbox_max.data(), m_tmp_bbox_max.size());
+        m_node_axis     = dr::load<FloatStorage>(m_tmp_axis.data(), m_tmp_axis.size());
+        m_node_cone     = dr::load<FloatStorage>(m_tmp_cone.data(), m_tmp_cone.size());
+        m_node_child    = dr::load<UInt32Storage>(m_tmp_child.data(), m_tmp_child.size());
+    }
+    if (!infinite.empty())
+        m_infinite = dr::load<UInt32Storage>(infinite.data(), infinite.size());
+    if (!emitters.empty()) {
+        m_emitter_trail = dr::load<UInt64Storage>(trail.data(), trail.size());
+        m_emitter_state = dr::load<UInt32Storage>(state.data(), state.size());
+    }
+    if (m_triangle_count > 0) {
+        m_emitter_root    = dr::load<UInt32Storage>(root.data(), root.size());
+        m_emitter_offset  = dr::load<UInt32Storage>(offset.data(), offset.size());
+        m_triangle_trail  = dr::load<UInt64Storage>(triangle_trail.data(), triangle_trail.size());
+        m_triangle_area   = dr::load<FloatStorage>(triangle_area.data(), triangle_area.size());
+    }
+
+    m_tmp_bbox_min.clear(); m_tmp_bbox_max.clear(); m_tmp_axis.clear();
+    m_tmp_cone.clear(); m_tmp_child.clear();
+
+    Log(Debug, "Finished light BVH construction (%u nodes, %u infinite "
+               "emitters, %zu emissive meshes with %u triangles, took %s).",
+        m_node_count, m_infinite_count, meshes.size(), m_triangle_count,
+        util::time_string((float) timer.value()));
+}
+
+MI_VARIANT typename LightBVH<Float, Spectrum>::LightBounds
+LightBVH<Float, Spectrum>::emitter_bounds(const Emitter *emitter) const {
+    LightBounds result;
+    result.bbox = emitter->bbox();
+    if (!result.bbox.valid())
+        return result;
+
+    result.valid       = true;
+    result.power       = emitter->sampling_weight();
+    result.axis        = ScalarVector3f(0.f, 0.f, 1.f);
+    result.cos_theta_o = -1.f;
+    result.cos_theta_e = 0.f;
+
+    const Shape *shape = emitter->shape();
+    if (!has_flag(emitter->flags(), EmitterFlags::Surface) || !shape)
+        return result;
+
+    if (shape->is_mesh()) {
+        const Mesh *mesh = static_cast<const Mesh *>(shape);
+
+        auto &&positions = dr::migrate(mesh->vertex_positions_buffer(), AllocType::Host);
+        auto &&normals   = dr::migrate(mesh->vertex_normals_data(), AllocType::Host);
+        auto &&faces     = dr::migrate(mesh->faces_buffer(), AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+
+        const ScalarFloat *p = positions.data();
+        const ScalarFloat *n = normals.data();
+        const uint32_t *f    = faces.data();
+        size_t face_count    = mesh->face_count(),
+               vertex_count  = mesh->has_vertex_normals() ? mesh->vertex_count() : 0;
+
+        auto position = [p](uint32_t i) {
+            return ScalarPoint3f(p[3 * i + 0], p[3 * i + 1], p[3 * i + 2]);
+        };
+
+        // The cone axis is the average of the face normals ..
+        std::vector<ScalarVector3f> face_normals;
+        face_normals.reserve(face_count);
+        ScalarVector3f axis = 0.f;
+        for (size_t i = 0; i < face_count; ++i) {
+            ScalarPoint3f p0 = position(f[3 * i + 0]),
+                          p1 = position(f[3 * i + 1]),
+                          p2 = position(f[3 * i + 2]);
+            ScalarVector3f fn = dr::cross(p1 - p0, p2 - p0);
+            ScalarFloat length = dr::norm(fn);
+            if (!(length > 0.f))
+                continue;
+            fn /= length;
+            face_normals.push_back(fn);
+            axis += fn;
+        }
+
+        ScalarFloat axis_length = dr::norm(axis);
+        if (!(axis_length > 1e-3f * (ScalarFloat) face_normals.size()))
+            return result;
+        axis /= axis_length;
+
+        // .. and its aperture covers both face and shading normals
+        ScalarFloat cos_theta_o = 1.f;
+        for (const ScalarVector3f &fn : face_normals)
+            cos_theta_o = dr::minimum(cos_theta_o, dr::dot(axis, fn));
+        for (size_t i = 0; i < vertex_count; ++i) {
+            ScalarVector3f vn(n[3 * i + 0], n[3 * i + 1], n[3 * i + 2]);
+            cos_theta_o = dr::minimum(cos_theta_o, dr::dot(axis, dr::normalize(vn)));
+        }
+
+        result.axis        = mesh->flip_normals() ? -axis : axis;
+        result.cos_theta_o = dr::clip(cos_theta_o, -1.f, 1.f);
+    } else if (shape->shape_type() == +ShapeType::Rectangle ||
+               shape->shape_type() == +ShapeType::Disk) {
+        // Planar shapes have a constant normal
+        PositionSample3f ps = shape->sample_position(0.f, Point2f(0.5f));
+        result.axis        = dr::normalize(ScalarVector3f(dr::slice(ps.n)));
+        result.cos_theta_o = 1.f;
+    }
+
+    return result;
+}
+
+MI_VARIANT std::vector<std::pair<uint32_t, typename LightBVH<Float, Spectrum>::LightBounds>>
+LightBVH<Float, Spectrum>::triangle_bounds(const Emitter *emitter,
+                                           std::vector<ScalarFloat> &area) const {
+    std::vector<std::pair<uint32_t, LightBounds>> result;
+
+    /* Points are sampled uniformly on the chosen triangle, which requires a
+       uniform radiance (textured emitters importance sample their texture) */
+    const Shape *shape = emitter->shape();
+    uint32_t flags = emitter->flags();
+    if (!shape || !shape->is_mesh() || !has_flag(flags, EmitterFlags::Surface) ||
+        has_flag(flags, EmitterFlags::SpatiallyVarying))
+        return result;
+
+    const Mesh *mesh = static_cast<const Mesh *>(shape);
+    size_t face_count = mesh->face_count();
+    if (face_count < 2 || face_count >= LightBVHLeafFlag)
+        return result;
+
+    auto &&positions = dr::migrate(mesh->vertex_positions_buffer(), AllocType::Host);
+    auto &&normals   = dr::migrate(mesh->vertex_normals_data(), AllocType::Host);
+    auto &&faces     = dr::migrate(mesh->faces_buffer(), AllocType::Host);
+    if constexpr (dr::is_jit_v<Float>)
+        dr::sync_thread();
+
+    const ScalarFloat *p = positions.data();
+    const ScalarFloat *n = normals.data();
+    const uint32_t *f    = faces.data();
+    bool has_normals     = mesh->has_vertex_normals();
+
+    size_t first = area.size();
+    area.resize(first + face_count, 0.f);
+    ScalarFloat total_area = 0.f;
+    result.reserve(face_count);
+
+    for (size_t i = 0; i < face_count; ++i) {
+        ScalarPoint3f v[3];
+        for (size_t k = 0; k < 3; ++k) {
+            uint32_t idx = f[3 * i + k];
+            v[k] = ScalarPoint3f(p[3 * idx + 0], p[3 * idx + 1], p[3 * idx + 2]);
+        }
+
+        ScalarVector3f fn = dr::cross(v[1] - v[0], v[2] - v[0]);
+        ScalarFloat length = dr::norm(fn);
+        if (!(length > 0.f))
+            continue;
+        fn /= length;
+
+        LightBounds b;
+        b.valid = true;
+        for (size_t k = 0; k < 3; ++k)
+            b.bbox.expand(v[k]);
+
+        // The cone covers both the face and the shading normals
+        b.cos_theta_o = 1.f;
+        if (has_normals) {
+            for (size_t k = 0; k < 3; ++k) {
+                uint32_t idx = f[3 * i + k];
+                ScalarVector3f vn(n[3 * idx + 0], n[3 * idx + 1], n[3 * idx + 2]);
+                b.cos_theta_o = dr::minimum(b.cos_theta_o, dr::dot(fn, dr::normalize(vn)));
+            }
+        }
+        b.cos_theta_o = dr::clip(b.cos_theta_o, -1.f, 1.f);
+        b.cos_theta_e = 0.f;
+        b.axis  = mesh->flip_normals() ? -fn : fn;
+        b.power = .5f * length;
+
+        area[first + i] = b.power;
+        total_area += b.power;
+        result.emplace_back((uint32_t) i, b);
+    }
+
+    // The power of the emitter is distributed proportionally to the area
+    for (auto &item : result)
+        item.second.power *= emitter->sampling_weight() / total_area;
+
+    if (result.empty())
+        area.resize(first);
+
+    return result;
+}
+
+MI_VARIANT typename LightBVH<Float, Spectrum>::LightBounds
+LightBVH<Float, Spectrum>::merge(const LightBounds &a, const LightBounds &b) {
+    if (!a.valid)
+        return b;
+    if (!b.valid)
+        return a;
+
+    LightBounds result;
+    result.valid = true;
+    result.bbox  = ScalarBoundingBox3f::merge(a.bbox, b.bbox);
+    result.power = a.power + b.power;
+    result.cos_theta_e = dr::minimum(a.cos_theta_e, b.cos_theta_e);
+
+    // Union of the two normal cones
+    ScalarFloat theta_a = dr::safe_acos(a.cos_theta_o),
+                theta_b = dr::safe_acos(b.cos_theta_o),
+                theta_d = dr::safe_acos(dr::dot(a.axis, b.axis));
+
+    if (dr::minimum(theta_d + theta_b, dr::Pi<ScalarFloat>) <= theta_a) {
+        result.axis = a.axis;
+        result.cos_theta_o = a.cos_theta_o;
+        return result;
+    }
+
+    if (dr::minimum(theta_d + theta_a, dr::Pi<ScalarFloat>) <= theta_b) {
+        result.axis = b.axis;
+        result.cos_theta_o = b.cos_theta_o;
+        return result;
+    }
+
+    ScalarFloat theta_o = .5f * (theta_a + theta_d + theta_b);
+    ScalarVector3f wr = dr::cross(a.axis, b.axis);
+    if (theta_o >= dr::Pi<ScalarFloat> || dr::squared_norm(wr) == 0.f) {
+        result.axis = a.axis;
+        result.cos_theta_o = -1.f;
+        return result;
+    }
+
+    // Rotate the axis of 'a' towards 'b' (Rodrigues' formula)
+    ScalarFloat theta_r = theta_o - theta_a;
+    ScalarVector3f k = dr::normalize(wr);
+    auto [sin_r, cos_r] = dr::sincos(theta_r);
+    result.axis = dr::normalize(a.axis * cos_r + dr::cross(k, a.axis) * sin_r +
+                                k * (dr::dot(k, a.axis) * (1.f - cos_r)));
+    result.cos_theta_o = dr::cos(theta_o);
+    return result;
+}
+
+MI_VARIANT typename LightBVH<Float, Spectrum>::ScalarFloat
+LightBVH<Float, Spectrum>::cost(const LightBounds &b, const ScalarVector3f &extents,
+                                uint32_t axis) {
+    if (!b.valid)
+        return 0.f;
+
+    // Solid angle measure of the orientation bounds
+    ScalarFloat theta_o = dr::safe_acos(b.cos_theta_o),
+                theta_e = dr::safe_acos(b.cos_theta_e),
+                theta_w = dr::minimum(theta_o + theta_e, dr::Pi<ScalarFloat>),
+                sin_o   = dr::sin(theta_o);
+
+    ScalarFloat m_omega =
+        2.f * dr::Pi<ScalarFloat> * (1.f - b.cos_theta_o) +
+        .5f * dr::Pi<ScalarFloat> *
+            (2.f * theta_w * sin_o - dr::cos(theta_o - 2.f * theta_w) -
+             2.f * theta_o * sin_o + b.cos_theta_o);
+
+    // Penalize thin boxes along the split axis
+    ScalarFloat kr = dr::max(extents) / extents[axis];
+
+    return b.power * m_omega * kr * b.bbox.surface_area();
+}
+
+MI_VARIANT uint32_t LightBVH<Float, Spectrum>::build_recursive(
+    std::vector<std::pair<uint32_t, LightBounds>> &items, size_t begin,
+    size_t end, uint32_t depth, uint64_t trail, uint64_t *trails) {
+    uint32_t node = (uint32_t) m_tmp_child.size();
+
+    LightBounds bounds;
+    ScalarBoundingBox3f centroid_bbox;
+    for (size_t i = begin; i < end; ++i) {
+        bounds = merge(bounds, items[i].second);
+        centroid_bbox.expand(items[i].second.bbox.center());
+    }
+
+    for (uint32_t k = 0; k < 3; ++k) {
+        m_tmp_bbox_min.push_back(bounds.bbox.min[k]);
+        m_tmp_bbox_max.push_back(bounds.bbox.max[k]);
+        m_tmp_axis.push_back(bounds.axis[k]);
+    }
+    m_tmp_cone.push_back(bounds.cos_theta_o);
+    m_tmp_cone.push_back(bounds.cos_theta_e);
+    m_tmp_cone.push_back(bounds.power);
+    m_tmp_child.push_back(0);
+
+    if (end - begin == 1) {
+        m_tmp_child[node] = LightBVHLeafFlag | items[begin].first;
+        trails[items[begin].first] = trail;
+        return node;
+    }
+
+    ScalarVector3f extents = bounds.bbox.extents(),
+                   centroid_extents = centroid_bbox.extents();
+
+    // Find the split with the lowest cost using a bucketed heuristic
+    ScalarFloat best_cost = dr::Infinity<ScalarFloat>;
+    uint32_t best_axis = 0, best_bucket = 0;
+    auto bucket_index = [&](const LightBounds &b, uint32_t axis) {
+        ScalarFloat rel = (b.bbox.center()[axis] - centroid_bbox.min[axis]) /
+                          centroid_extents[axis];
+        return dr::minimum((uint32_t) (rel * LightBVHBucketCount),
+                           LightBVHBucketCount - 1);
+    };
+
+    if (depth < LightBVHMedianDepth) {
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            if (!(centroid_extents[axis] > 0.f))
+                continue;
+
+            LightBounds buckets[LightBVHBucketCount];
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t b = bucket_index(items[i].second, axis);
+                buckets[b] = merge(buckets[b], items[i].second);
+            }
+
+            for (uint32_t split = 0; split < LightBVHBucketCount - 1; ++split) {
+                LightBounds below, above;
+                for (uint32_t b = 0; b <= split; ++b)
+                    below = merge(below, buckets[b]);
+                for (uint32_t b = split + 1; b < LightBVHBucketCount; ++b)
+                    above = merge(above, buckets[b]);
+                if (!below.valid || !above.valid)
+                    continue;
+
+                ScalarFloat c = cost(below, extents, axis) + cost(above, extents, axis);
+                if (c < best_cost) {
+                    best_cost = c;
+                    best_axis = axis;
+                    best_bucket = split;
+                }
+            }
+        }
+    }
+
+    size_t mid = begin;
+    if (best_cost != dr::Infinity<ScalarFloat>) {
+        mid = std::partition(items.begin() + begin, items.begin() + end,
+                             [&](const auto &item) {
+                                 return bucket_index(item.second, best_axis) <= best_bucket;
+                             }) - items.begin();
+    }
+
+    if (mid == begin || mid == end) {
+        // Fall back to a median split along the axis of largest extent
+        uint32_t axis = 0;
+        for (uint32_t k = 1; k < 3; ++k)
+            if (centroid_extents[k] > centroid_extents[axis])
+                axis = k;
+        mid = (begin + end) / 2;
+        std::nth_element(items.begin() + begin, items.begin() + mid,
+                         items.begin() + end,
+                         [axis](const auto &a, const auto &b) {
+                             return a.second.bbox.center()[axis] <
+                                    b.second.bbox.center()[axis];
+                         });
+    }
+
+    build_recursive(items, begin, mid, depth + 1, trail, trails);
+    uint32_t right = build_recursive(items, mid, end, depth + 1,
+                                     trail | (uint64_t(1) << depth), trails);
+    m_tmp_child[node] = right;
+    return node;
+}
+
+MI_VARIANT Float LightBVH<Float, Spectrum>::importance(const Point3f &p,
+                                                       const Normal3f &n,
+                                                       UInt32 node,
+                                                       Mask active) const {
+    Point3f p_min = dr::gather<Point3f>(m_node_bbox_min, node, active),
+            p_max = dr::gather<Point3f>(m_node_bbox_max, node, active);
+    Vector3f axis = dr::gather<Vector3f>(m_node_axis, node, active),
+             cone = dr::gather<Vector3f>(m_node_cone, node, active);
+    Float cos_theta_o = cone.x(), cos_theta_e = cone.y(), power = cone.z();
+
+    // Clamp the distance to the center so that nearby nodes are not overestimated
+    Point3f center = .5f * (p_min + p_max);
+    Float dist2 = dr::squared_norm(p - center),
+          d2 = dr::maximum(dist2, .5f * dr::norm(p_max - p_min));
+
+    Vector3f wi = dr::select(dist2 > 0.f, (p - center) * dr::rsqrt(dist2), axis);
+
+    Float cos_theta_w = dr::dot(axis, wi),
+          sin_theta_w = dr::safe_sqrt(1.f - dr::square(cos_theta_w)),
+          sin_theta_o = dr::safe_sqrt(1.f - dr::square(cos_theta_o));
+
+    // Angle subtended by the bounding sphere of the node
+    Float radius2 = dr::squared_norm(p_max - center),
+          cos_theta_b = dr::select(dist2 < radius2, -1.f,
+                                   dr::safe_sqrt(1.f - radius2 / dist2)),
+          sin_theta_b = dr::safe_sqrt(1.f - dr::square(cos_theta_b));
+
+    // Minimum angle between 'wi' and the emission cone: cos(max(0, θw - θo - θb))
+    Mask inside_o = cos_theta_w > cos_theta_o;
+    Float cos_theta_x = dr::select(inside_o, 1.f, cos_theta_w * cos_theta_o +
+                                                  sin_theta_w * sin_theta_o),
+          sin_theta_x = dr::select(inside_o, 0.f, sin_theta_w * cos_theta_o -
+                                                  cos_theta_w * sin_theta_o),
+          cos_theta_p = dr::select(cos_theta_x > cos_theta_b, 1.f,
+                                   cos_theta_x * cos_theta_b +
+                                   sin_theta_x * sin_theta_b);
+
+    Float result = dr::select(cos_theta_p > cos_theta_e,
+                              power * cos_theta_p / d2, 0.f);
+
+    // Account for the foreshortening at the reference point (if on a surface)
+    Mask has_normal = dr::squared_norm(n) > 0.f;
+    Float cos_theta_i = dr::abs(dr::dot(wi, n)),
+          sin_theta_i = dr::safe_sqrt(1.f - dr::square(cos_theta_i)),
+          cos_theta_pi = dr::select(cos_theta_i > cos_theta_b, 1.f,
+                                    cos_theta_i * cos_theta_b +
+                                    sin_theta_i * sin_theta_b);
+    dr::masked(result, has_normal) *= cos_theta_pi;
+
+    return dr::select(active, dr::maximum(result, 0.f), 0.f);
+}
+
+MI_VARIANT std::tuple<typename LightBVH<Float, Spectrum>::UInt32, Float, Float>
+LightBVH<Float, Spectrum>::sample(const Interaction3f &ref, Float sample,
+                                  Mask active) const {
+    UInt32 index = UInt32(-1);
+    Float pmf = 0.f;
+
+    // Choose between the infinite emitters and the hierarchy
+    ScalarFloat choice_count = ScalarFloat(m_infinite_count + (m_node_count > 0 ? 1 : 0)),
+                p_inf;
+
+    if (choice_count == 0.f)
+        return { index, pmf, sample };
+    p_inf = m_infinite_count / choice_count;
+
+    if (m_infinite_count > 0) {
+        Mask is_inf = active && sample < p_inf;
+        Float sample_inf = sample * choice_count;
+        UInt32 i = dr::minimum(UInt32(sample_inf), m_infinite_count - 1);
+        dr::masked(index, is_inf) = dr::gather<UInt32>(m_infinite, i, is_inf);
+        dr::masked(pmf, is_inf) = dr::rcp(choice_count);
+        dr::masked(sample, is_inf) = sample_inf - Float(i);
+
+        active &= !is_inf;
+        dr::masked(sample, active) =
+            dr::minimum((sample - p_inf) / (1.f - p_inf),
+                        dr::OneMinusEpsilon<Float>);
+    }
+
+    if (m_node_count == 0 || dr::none_or<false>(active))
+        return { index, dr::select(pmf > 0.f, dr::rcp(pmf), 0.f), sample };
+
+    // A single emitter in the hierarchy must still contribute
+    if (m_node_count == 1)
+        active &= importance(ref.p, ref.n, 0u, active) > 0.f;
+
+    auto [leaf, pmf_tree, sample_re] = traverse(ref.p, ref.n, 0u, sample, active);
+    active &= pmf_tree > 0.f;
+
+    dr::masked(index, active) = leaf;
+    dr::masked(pmf, active) = pmf_tree * (1.f - p_inf);
+    dr::masked(sample, active) = sample_re;
+
+    return { index, dr::select(pmf > 0.f, dr::rcp(pmf), 0.f), sample };
+}
+
+MI_VARIANT Float LightBVH<Float, Spectrum>::pdf(const Interaction3f &ref,
+                                               UInt32 index,
+                                               Mask active) const {
+    if (m_emitter_count == 0)
+        return 0.f;
+
+    active &= index < m_emitter_count;
+    UInt32 state = dr::gather<UInt32>(m_emitter_state, index, active);
+
+    ScalarFloat choice_count = ScalarFloat(m_infinite_count + (m_node_count > 0 ? 1 : 0));
+    if (choice_count == 0.f)
+        return 0.f;
+
+    Float pmf = dr::select(active && state == 2u, dr::rcp(choice_count), 0.f);
+
+    active &= state == 1u;
+    if (m_node_count == 0 || dr::none_or<false>(active))
+        return pmf;
+
+    if (m_node_count == 1)
+        active &= importance(ref.p, ref.n, 0u, active) > 0.f;
+
+    UInt64 trail = dr::gather<UInt64>(m_emitter_trail, index, active);
+    dr::masked(pmf, active) =
+        traverse_pdf(ref.p, ref.n, 0u, trail, active) / choice_count;
+    return pmf;
+}
+
+MI_VARIANT std::tuple<typename LightBVH<Float, Spectrum>::UInt32, Float, Float>
+LightBVH<Float, Spectrum>::traverse(const Point3f &p, const Normal3f &n,
+                                    UInt32 node, Float sample,
+                                    Mask active) const {
+    Float pmf = 1.f;
+    UInt32 child = dr::gather<UInt32>(m_node_child, node, active);
+
+    std::tie(node, sample, pmf, active, child) = dr::while_loop(
+        std::make_tuple(node, sample, pmf, active, child),
+        [](const UInt32 &, const Float &, const Float &, const Mask &active,
+           const UInt32 &child) {
+            return active && (child & LightBVHLeafFlag) == 0u;
+        },
+        [this, p, n](UInt32 &node, Float &sample, Float &pmf,
+                     Mask &active, UInt32 &child) {
+            UInt32 left = node + 1, right = child;
+            Float imp_left  = importance(p, n, left, active),
+                  imp_right = importance(p, n, right, active),
+                  imp_total = imp_left + imp_right;
+
+            active &= imp_total > 0.f;
+
+            Float p_left = imp_left / imp_total;
+            Mask go_left = sample < p_left;
+
+            node = dr::select(go_left, left, right);
+            pmf *= dr::select(go_left, p_left, 1.f - p_left);
+            sample = dr::select(go_left, sample / p_left,
+                                (sample - p_left) / (1.f - p_left));
+            sample = dr::minimum(sample, dr::OneMinusEpsilon<Float>);
+
+            child = dr::gather<UInt32>(m_node_child, node, active);
+        },
+        "LightBVH::traverse");
+
+    return { child & ~LightBVHLeafFlag, dr::select(active, pmf, 0.f), sample };
+}
+
+MI_VARIANT Float LightBVH<Float, Spectrum>::traverse_pdf(const Point3f &p,
+                                                        const Normal3f &n,
+                                                        UInt32 node,
+                                                        UInt64 trail,
+                                                        Mask active) const {
+    Float pmf = 1.f;
+    UInt32 child = dr::gather<UInt32>(m_node_child, node, active);
+
+    std::tie(node, trail, pmf, active, child) = dr::while_loop(
+        std::make_tuple(node, trail, pmf, active, child),
+        [](const UInt32 &, const UInt64 &, const Float &, const Mask &active,
+           const UInt32 &child) {
+            return active && (child & LightBVHLeafFlag) == 0u;
+        },
+        [this, p, n](UInt32 &node, UInt64 &trail, Float &pmf,
+                     Mask &active, UInt32 &child) {
+            UInt32 left = node + 1, right = child;
+            Float imp_left  = importance(p, n, left, active),
+                  imp_right = importance(p, n, right, active),
+                  imp_total = imp_left + imp_right;
+
+            Mask go_right = (trail & 1u) != 0u;
+            Float imp = dr::select(go_right, imp_right, imp_left);
+            active &= imp > 0.f;
+
+            node = dr::select(go_right, right, left);
+            pmf *= imp / imp_total;
+            trail = trail >> 1;
+
+            child = dr::gather<UInt32>(m_node_child, node, active);
+        },
+        "LightBVH::traverse_pdf");
+
+    return dr::select(active, pmf, 0.f);
+}
+
+MI_VARIANT std::pair<typename LightBVH<Float, Spectrum>::DirectionSample3f, Spectrum>
+LightBVH<Float, Spectrum>::sample_direction(const Interaction3f &ref,
+                                            const EmitterPtr &emitter,
+                                            UInt32 index, const Point2f &sample,
+                                            Mask active) const {
+    UInt32 root = 0u;
+    if (m_triangle_count > 0)
+        root = dr::gather<UInt32>(m_emitter_root, index, active);
+    Mask is_mesh = active && root != 0u,
+         other   = active && !is_mesh;
+
+    DirectionSample3f ds = dr::zeros<DirectionSample3f>();
+    Spectrum spec = 0.f;
+    if (dr::any_or<true>(other))
+        std::tie(ds, spec) = emitter->sample_direction(ref, sample, other);
+
+    if (m_triangle_count == 0 || dr::none_or<false>(is_mesh))
+        return { ds, spec };
+
+    // Choose a triangle below the emitter, then a point on it
+    auto [prim, pmf, sample_x] = traverse(ref.p, ref.n, root, sample.x(), is_mesh);
+    is_mesh &= pmf > 0.f;
+
+    PreliminaryIntersection3f pi = dr::zeros<PreliminaryIntersection3f>();
+    pi.t          = 1.f;
+    pi.prim_uv    = warp::square_to_uniform_triangle(Point2f(sample_x, sample.y()));
+    pi.prim_index = prim;
+    pi.shape      = emitter->shape();
+
+    Ray3f ray(ref.p, Vector3f(0.f, 0.f, 1.f), ref.time, ref.wavelengths);
+    SurfaceInteraction3f si = pi.compute_surface_interaction(
+        ray, +RayFlags::Minimal | RayFlags::ShadingFrame | RayFlags::UV, is_mesh);
+
+    DirectionSample3f ds_mesh(PositionSample3f(si));
+    Vector3f rel = ds_mesh.p - ref.p;
+    Float dist2 = dr::squared_norm(rel);
+    ds_mesh.dist    = dr::sqrt(dist2);
+    ds_mesh.d       = rel / ds_mesh.dist;
+    ds_mesh.emitter = emitter;
+
+    UInt32 offset = dr::gather<UInt32>(m_emitter_offset, index, is_mesh);
+    Float area = dr::gather<Float>(m_triangle_area, offset + prim, is_mesh),
+          dp   = -dr::dot(ds_mesh.d, ds_mesh.n);
+    is_mesh &= dp > 0.f;
+
+    ds_mesh.pdf = dr::select(is_mesh, pmf * dist2 / (area * dp), 0.f);
+    Spectrum spec_mesh = emitter->eval_direction(ref, ds_mesh, is_mesh) / ds_mesh.pdf;
+
+    dr::masked(ds, active && root != 0u) = ds_mesh;
+    dr::masked(spec, active && root != 0u) = dr::select(is_mesh, spec_mesh, 0.f);
+    return { ds, spec };
+}
+
+MI_VARIANT Float LightBVH<Float, Spectrum>::pdf_direction(const Interaction3f &ref,
+                                                         const DirectionSample3f &ds,
+                                                         UInt32 index,
+                                                         Mask active) const {
+    UInt32 root = 0u;
+    if (m_triangle_count > 0)
+        root = dr::gather<UInt32>(m_emitter_root, index, active);
+    Mask is_mesh = active && root != 0u,
+         other   = active && !is_mesh;
+
+    Float pdf = 0.f;
+    if (dr::any_or<true>(other))
+        pdf = dr::select(other, ds.emitter->pdf_direction(ref, ds, other), 0.f);
+
+    if (m_triangle_count == 0 || dr::none_or<false>(is_mesh))
+        return pdf;
+
+    Float dp = -dr::dot(ds.d, ds.n);
+    is_mesh &= dp > 0.f;
+
+    UInt32 offset = dr::gather<UInt32>(m_emitter_offset, index, is_mesh),
+           prim   = offset + ds.prim_index;
+    UInt64 trail  = dr::gather<UInt64>(m_triangle_trail, prim, is_mesh);
+    Float area    = dr::gather<Float>(m_triangle_area, prim, is_mesh);
+    is_mesh &= area > 0.f;
+
+    Float pmf = traverse_pdf(ref.p, ref.n, root, trail, is_mesh);
+    dr::masked(pdf, is_mesh) = pmf * dr::square(ds.dist) / (area * dp);
+    return pdf;
+}
+
+MI_VARIANT std::string LightBVH<Float, Spectrum>::to_string() const {
+    std::ostringstream oss;
+    oss << "LightBVH[" << std::endl
+        << "  emitter_count = " << m_emitter_count << "," << std::endl
+        << "  infinite_count = " << m_infinite_count << "," << std::endl
+        << "  node_count = " << m_node_count << "," << std::endl
+        << "  triangle_count = " << m_triangle_count << std::endl
+        << "]";
+    return oss.str();
+}
+
+MI_IMPLEMENT_CLASS_VARIANT(LightBVH, Object)
+MI_INSTANTIATE_CLASS(LightBVH)
+NAMESPACE_END(mitsuba)
@@ -49,7 +49,9 @@ MI_VARIANT void Medium<Float, Spectrum>::traverse(TraversalCallback *callback) {
 MI_VARIANT
 typename Medium<Float, Spectrum>::MediumInteraction3f
 Medium<Float, Spectrum>::sample_interaction(const Ray3f &ray, Float sample,
-                                            UInt32 channel, Mask active) const {
+                                            UInt32 channel, Mask active,
+                                            Float majorant_offset,
+                                            UInt32 depth) const {
     MI_MASKED_FUNCTION(ProfilerPhase::MediumSample, active);
 
     // initialize basic medium interaction fields
@@ -58,6 +60,7 @@ Medium<Float, Spectrum>::sample_interaction(const Ray3f &ray, Float sample,
     mei.sh_frame    = Frame3f(mei.wi);
     mei.time        = ray.time;
     mei.wavelengths = ray.wavelengths;
+    mei.depth       = depth;
 
     auto [aabb_its, mint, maxt] = intersect_aabb(ray);
     aabb_its &= (dr::isfinite(mint) || dr::isfinite(maxt));
@@ -68,28 +71,50 @@ Medium<Float, Spectrum>::sample_interaction(const Ray3f &ray, Float sample,
     mint = dr::maximum(0.f, mint);
     maxt = dr::minimum(ray.maxt, maxt);
 
-    auto combined_extinction = get_majorant(mei, active);
-    Float m                  = combined_extinction[0];
-    if constexpr (is_rgb_v<Spectrum>) { // Handle RGB rendering
-        dr::masked(m, channel == 1u) = combined_extinction[1];
-        dr::masked(m, channel == 2u) = combined_extinction[2];
-    } else {
-        DRJIT_MARK_USED(channel);
-    }
+    auto [sampled_t, combined_extinction] =
+        sample_distance(mei, ray, mint, maxt, sample, channel,
+                        majorant_offset, active);
 
-    Float sampled_t = mint + (-dr::log(1 - sample) / m);
     Mask valid_mi   = active && (sampled_t <= maxt);
     mei.t           = dr::select(valid_mi, sampled_t, dr::Infinity<Float>);
     mei.p           = ray(sampled_t);
     mei.medium      = this;
     mei.mint        = mint;
+    mei.combined_extinction = combined_extinction;
 
     std::tie(mei.sigma_s, mei.sigma_n, mei.sigma_t) =
         get_scattering_coefficients(mei, valid_mi);
-    mei.combined_extinction = combined_extinction;
     return mei;
 }
 
+MI_VARIANT
+typename Medium<Float, Spectrum>::UnpolarizedSpectrum
+Medium<Float, Spectrum>::get_control_extinction(const MediumInteraction3f & /* mi */,
+                                                Mask /* active */) const {
+    return 0.f;
+}
+
+MI_VARIANT
+std::pair<Float, typename Medium<Float, Spectrum>::UnpolarizedSpectrum>
+Medium<Float, Spectrum>::sample_distance(const MediumInteraction3f &mei,
+                                         const Ray3f & /* ray */, Float mint,
+                                         Float /* maxt */, Float sample,
+                                         UInt32 channel, Float majorant_offset,
+                                         Mask active) const {
+    auto combined_extinction =
+        dr::maximum(get_majorant(mei, active) - majorant_offset, 0.f);
+    Float m                  = combined_extinction[0];
+    if constexpr (is_rgb_v<Spectrum>) { // Handle RGB rendering
+        dr::masked(m, channel == 1u) = combined_extinction[1];
+        dr::masked(m, channel == 2u) = combined_extinction[2];
+    } else {
+        DRJIT_MARK_USED(channel);
+    }
+
+    Float sampled_t = mint + (-dr::log(1 - sample) / m);
+    return { sampled_t, combined_extinction };
+}
+
 MI_VARIANT
 std::pair<typename Medium<Float, Spectrum>::UnpolarizedSpectrum,
           typename Medium<Float, Spectrum>::UnpolarizedSpectrum>
@@ -9,6 +9,9 @@
 #include <mitsuba/render/mesh.h>
 #include <mitsuba/render/records.h>
 #include <mitsuba/render/scene.h>
+#include <nanothread/nanothread.h>
+#include <algorithm>
+#include <atomic>
 
 #if defined(MI_ENABLE_EMBREE)
     #include <embree3/rtcore.h>
@@ -23,6 +26,77 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
+/// Number of faces processed by each work unit of the parallel mesh passes
+static constexpr uint32_t mesh_faces_per_block = 16384;
+
+/**
+ * \brief Group the corners of all faces by vertex
+ *
+ * The corner <tt>3 * f + i</tt> refers to the \c i-th vertex of face \c f,
+ * and it is also the index of the directed edge that starts there. Returns
+ * an offset table, which has an entry per vertex plus one, and the list of
+ * corners. The corners of each vertex are stored in increasing order, so
+ * that loops over them visit the faces in the same order as a sequential
+ * loop over all faces would.
+ *
+ * When \c skip_degenerate is set, corners whose edge ends at the vertex it
+ * starts from are left out.
+ */
+template <typename Index>
+static std::pair<std::vector<Index>, std::vector<Index>>
+vertex_corners(const Index *faces, Index face_count, Index vertex_count,
+               bool skip_degenerate) {
+    auto skip = [&](Index c) {
+        return skip_degenerate && faces[c] == faces[c - c % 3 + (c % 3 + 1) % 3];
+    };
+
+    auto for_each_corner = [&](auto &&func) {
+        dr::parallel_for(
+            dr::blocked_range<Index>(0, face_count, mesh_faces_per_block),
+            [&](const dr::blocked_range<Index> &range) {
+                for (Index c = 3 * range.begin(); c != 3 * range.end(); ++c) {
+                    if (!skip(c))
+                        func(c);
+                }
+            }
+        );
+    };
+
+    // 1. Count the corners of every vertex
+    std::vector<std::atomic<Index>> cursor(vertex_count);
+    for_each_corner([&](Index c) {
+        Assert(faces[c] < vertex_count);
+        cursor[faces[c]].fetch_add(1, std::memory_order_relaxed);
+    });
+
+    // 2. Offsets into the corner list
+    std::vector<Index> offsets(vertex_count + 1);
+    Index sum = 0;
+    for (Index v = 0; v < vertex_count; ++v) {
+        offsets[v] = sum;
+        sum += cursor[v].load(std::memory_order_relaxed);
+        cursor[v].store(offsets[v], std::memory_order_relaxed);
+    }
+    offsets[vertex_count] = sum;
+
+    // 3. Scatter the corners, then restore their order within each vertex
+    std::vector<Index> corners(sum);
+    for_each_corner([&](Index c) {
+        corners[cursor[faces[c]].fetch_add(1, std::memory_order_relaxed)] = c;
+    });
+
+    dr::parallel_for(
+        dr::blocked_range<Index>(0, vertex_count, mesh_faces_per_block),
+        [&](const dr::blocked_range<Index> &range) {
+            for (Index v = range.begin(); v != range.end(); ++v)
+                std::sort(corners.begin() + offsets[v],
+                          corners.begin() + offsets[v + 1]);
+        }
+    );
+
+    return { std::move(offsets), std::move(corners) };
+}
+
 MI_VARIANT Mesh<Float, Spectrum>::Mesh(const Properties &props) : Base(props) {
     /* When set to ``true``, Mitsuba will use per-face instead of per-vertex
        normals when rendering the object, which will give it a faceted
@@ -30,6 +104,24 @@ MI_VARIANT Mesh<Float, Spectrum>::Mesh(const Properties &props) : Base(props) {
     m_face_normals = props.get<bool>("face_normals", false);
     m_flip_normals = props.get<bool>("flip_normals", false);
 
+    /* When set to ``true``, directions towards the mesh are sampled by
+       solid angle instead of area (see \ref sample_direction()). Default:
+       ``false`` */
+    m_solid_angle_sampling = props.get<bool>("solid_angle_sampling", false);
+
+    /* When set to ``true``, vertex normals and texture coordinates are stored
+       in a compact quantized form (see \ref compact_vertex_data()). They can
+       then no longer be modified or differentiated. Default: ``false`` */
+    m_compact_vertices = props.get<bool>("compact_vertices", false);
+
+    /* When set to ``true``, scalar variants additionally store the vertex
+       positions, normals and texture coordinates interleaved (see \ref
+       interleave_vertex_data()). Default: ``false`` */
+    m_interleaved_vertices = props.get<bool>("interleaved_vertices", false);
+    if (m_interleaved_vertices && m_compact_vertices)
+        Throw("The \"compact_vertices\" and \"interleaved_vertices\" "
+              "parameters cannot be combined.");
+
     m_discontinuity_types = (uint32_t) DiscontinuityFlags::PerimeterType;
 
     m_shape_type = ShapeType::Mesh;
@@ -54,6 +146,11 @@ Mesh<Float, Spectrum>::Mesh(const std::string &name, ScalarSize vertex_count,
 
 MI_VARIANT
 void Mesh<Float, Spectrum>::initialize() {
+    if (m_compact_vertices)
+        compact_vertex_data();
+    if (m_interleaved_vertices)
+        interleave_vertex_data();
+
 #if defined(MI_ENABLE_LLVM) && !defined(MI_ENABLE_EMBREE)
     m_vertex_positions_ptr = m_vertex_positions.data();
     m_faces_ptr = m_faces.data();
@@ -69,18 +166,34 @@ void Mesh<Float, Spectrum>::initialize() {
         }
     }
 
+    update_memory_usage();
     Base::initialize();
 }
 
 MI_VARIANT Mesh<Float, Spectrum>::~Mesh() {}
 
+MI_VARIANT void Mesh<Float, Spectrum>::update_memory_usage() {
+    size_t size = (m_vertex_positions.size() + m_vertex_normals.size() +
+                   m_vertex_texcoords.size()) * sizeof(InputFloat) +
+                  (m_faces.size() + m_vertex_normals_compact.size() +
+                   m_vertex_texcoords_compact.size() + m_E2E.size()) * sizeof(uint32_t);
+    for (auto &[name, attribute]: m_mesh_attributes)
+        size += attribute.buf.size() * sizeof(InputFloat);
+    size += (m_vertex_attributes_interleaved.size() +
+             m_vertex_data_interleaved.size()) * sizeof(InputFloat);
+
+    m_memory.set(size, dr::is_cuda_v<Float>);
+}
+
 MI_VARIANT void Mesh<Float, Spectrum>::traverse(TraversalCallback *callback) {
     Base::traverse(callback);
 
     callback->put_parameter("faces",            m_faces,            +ParamFlags::NonDifferentiable);
     callback->put_parameter("vertex_positions", m_vertex_positions, ParamFlags::Differentiable | ParamFlags::Discontinuous);
-    callback->put_parameter("vertex_normals",   m_vertex_normals,   ParamFlags::Differentiable | ParamFlags::Discontinuous);
-    callback->put_parameter("vertex_texcoords", m_vertex_texcoords, +ParamFlags::Differentiable);
+    if (!m_compact_vertices) {
+        callback->put_parameter("vertex_normals",   m_vertex_normals,   ParamFlags::Differentiable | ParamFlags::Discontinuous);
+        callback->put_parameter("vertex_texcoords", m_vertex_texcoords, +ParamFlags::Differentiable);
+    }
 
     // We arbitrarily chose to show all attributes as being differentiable here.
     for (auto &[name, attribute]: m_mesh_attributes)
@@ -90,25 +203,39 @@ MI_VARIANT void Mesh<Float, Spectrum>::traverse(TraversalCallback *callback) {
 MI_VARIANT void Mesh<Float, Spectrum>::parameters_changed(const std::vector<std::string> &keys) {
     bool mesh_attributes_changed = false;
 
+    // Read the separate buffers until the interleaved layout is rebuilt below
+    m_vertex_stride = 0;
+
+    // Topology-preserving updates only move existing vertices
+    bool topology_changed = keys.empty() || string::contains(keys, "faces");
+
     if (m_vertex_positions.size() != m_vertex_count * 3) {
         Log(Debug, "parameters_changed(): Vertex count changed, updating it.");
-        mesh_attributes_changed = true;
+        mesh_attributes_changed = topology_changed = true;
         m_vertex_count = (uint32_t) m_vertex_positions.size() / 3;
     }
     if (m_faces.size() != m_face_count * 3) {
         Log(Debug, "parameters_changed(): Face count changed, updating it.");
-        mesh_attributes_changed = true;
+        mesh_attributes_changed = topology_changed = true;
         m_face_count = (uint32_t) m_faces.size() / 3;
     }
-    if (has_vertex_normals() && m_vertex_normals.size() != m_vertex_count * 3) {
+    size_t normal_count   = m_compact_vertices ? m_vertex_normals_compact.size() * 3
+                                               : m_vertex_normals.size(),
+           texcoord_count = m_compact_vertices ? m_vertex_texcoords_compact.size() * 2
+                                               : m_vertex_texcoords.size();
+    if (has_vertex_normals() && normal_count != m_vertex_count * 3) {
         Log(Debug, "parameters_changed(): Vertex normal count changed, updating it.");
         mesh_attributes_changed = true;
         m_vertex_normals = dr::zeros<FloatStorage>(m_vertex_count * 3);
+        m_vertex_normals_compact = DynamicBuffer<UInt32>();
     }
-    if (has_vertex_texcoords() && m_vertex_texcoords.size() != m_vertex_count * 2) {
+    if (has_vertex_texcoords() && texcoord_count != m_vertex_count * 2) {
         Log(Debug, "parameters_changed(): Vertex count has changed, but no UVs were specified, resetting them.");
         mesh_attributes_changed = true;
         m_vertex_texcoords = dr::zeros<FloatStorage>(m_vertex_count * 2);
+        m_vertex_texcoords_compact = DynamicBuffer<UInt32>();
+        if (m_compact_vertices)
+            compact_vertex_data();
     }
     for (auto &[name, attribute]: m_mesh_attributes) {
         size_t expected_size = attribute.size * (attribute.type == MeshAttributeType::Vertex ? m_vertex_count : m_face_count);
@@ -119,6 +246,7 @@ MI_VARIANT void Mesh<Float, Spectrum>::parameters_changed(const std::vector<std:
             attribute.buf = dr::zeros<FloatStorage>(expected_size);
         }
     }
+    build_interleaved_attributes();
 
     if (keys.empty() || string::contains(keys, "faces")) { // Topology changed
         m_E2E_outdated = true;
@@ -138,6 +266,8 @@ MI_VARIANT void Mesh<Float, Spectrum>::parameters_changed(const std::vector<std:
         if (m_parameterization)
             m_parameterization = nullptr;
 
+        m_sil_tree_refit = true;
+
         if (parameters_grad_enabled()) {
             // A topology change could have been made in a first update, and
             // then the vertex enabled gradient tracking in a second update
@@ -150,12 +280,19 @@ MI_VARIANT void Mesh<Float, Spectrum>::parameters_changed(const std::vector<std:
         m_vertex_positions_ptr = m_vertex_positions.data();
         m_faces_ptr = m_faces.data();
 #endif
-        mark_dirty();
+        if (topology_changed)
+            mark_dirty();
+        else
+            mark_vertices_dirty();
 
         if (!m_initialized)
             Base::initialize();
     }
 
+    if (m_interleaved_vertices)
+        interleave_vertex_data();
+
+    update_memory_usage();
     Base::parameters_changed();
 }
 
@@ -202,8 +339,8 @@ MI_VARIANT void Mesh<Float, Spectrum>::write_ply(const std::string &filename) co
 
 MI_VARIANT void Mesh<Float, Spectrum>::write_ply(Stream *stream) const {
     auto&& vertex_positions = dr::migrate(m_vertex_positions, AllocType::Host);
-    auto&& vertex_normals   = dr::migrate(m_vertex_normals, AllocType::Host);
-    auto&& vertex_texcoords = dr::migrate(m_vertex_texcoords, AllocType::Host);
+    auto&& vertex_normals   = dr::migrate(vertex_normals_data(), AllocType::Host);
+    auto&& vertex_texcoords = dr::migrate(vertex_texcoords_data(), AllocType::Host);
     auto&& faces = dr::migrate(m_faces, AllocType::Host);
 
     std::vector<std::pair<std::string, MeshAttribute>> vertex_attributes;
@@ -320,56 +457,78 @@ MI_VARIANT void Mesh<Float, Spectrum>::recompute_vertex_normals() {
         Throw("Storing new normals in a Mesh that didn't have normals at "
               "construction time is not implemented yet.");
 
+    // The interleaved layout (if any) may hold outdated positions
+    m_vertex_stride = 0;
+
+    if (dr::width(m_vertex_normals) != m_vertex_count * 3)
+        m_vertex_normals = dr::zeros<FloatStorage>(m_vertex_count * 3);
+
     /* Weighting scheme based on "Computing Vertex Normals from Polygonal Facets"
        by Grit Thuermer and Charles A. Wuethrich, JGT 1998, Vol 3 */
 
     if constexpr (!dr::is_dynamic_v<Float>) {
-        size_t invalid_counter = 0;
-        std::vector<InputNormal3f> normals(m_vertex_count, dr::zeros<InputNormal3f>());
-
-        for (ScalarSize i = 0; i < m_face_count; ++i) {
-            auto fi = face_indices(i);
-            Assert(fi[0] < m_vertex_count &&
-                   fi[1] < m_vertex_count &&
-                   fi[2] < m_vertex_count);
-
+        /* Every vertex accumulates the contributions of its faces in the
+           order of a sequential loop over the faces, so that the result
+           does not depend on the number of threads. */
+        std::vector<ScalarIndex> offsets, corners;
+        std::tie(offsets, corners) = vertex_corners<ScalarIndex>(
+            m_faces.data(), m_face_count, m_vertex_count, false);
+
+        // Area-normalized face normal and the angles at the three vertices
+        auto face_weights = [&](ScalarIndex f, InputNormal3f &n,
+                                InputVector3f &face_angles) {
+            auto fi = face_indices(f);
             InputPoint3f v[3] = { vertex_position(fi[0]),
                                   vertex_position(fi[1]),
                                   vertex_position(fi[2]) };
 
             InputVector3f side_0 = v[1] - v[0],
                           side_1 = v[2] - v[0];
-            InputNormal3f n = dr::cross(side_0, side_1);
+            n = dr::cross(side_0, side_1);
             InputFloat length_sqr = dr::squared_norm(n);
-            if (likely(length_sqr > 0)) {
-                n *= dr::rsqrt(length_sqr);
-
-                // Use DrJit to compute the face angles at the same time
-                auto side1 = transpose(dr::Array<dr::Packet<InputFloat, 3>, 3>{ side_0, v[2] - v[1], v[0] - v[2] });
-                auto side2 = transpose(dr::Array<dr::Packet<InputFloat, 3>, 3>{ side_1, v[0] - v[1], v[1] - v[2] });
-                InputVector3f face_angles = unit_angle(dr::normalize(side1), dr::normalize(side2));
+            if (unlikely(!(length_sqr > 0)))
+                return false;
+            n *= dr::rsqrt(length_sqr);
+
+            // Use DrJit to compute the face angles at the same time
+            auto side1 = transpose(dr::Array<dr::Packet<InputFloat, 3>, 3>{ side_0, v[2] - v[1], v[0] - v[2] });
+            auto side2 = transpose(dr::Array<dr::Packet<InputFloat, 3>, 3>{ side_1, v[0] - v[1], v[1] - v[2] });
+            face_angles = unit_angle(dr::normalize(side1), dr::normalize(side2));
+            return true;
+        };
+
+        std::atomic<size_t> invalid_counter { 0 };
+        dr::parallel_for(
+            dr::blocked_range<ScalarIndex>(0, m_vertex_count, mesh_faces_per_block),
+            [&](const dr::blocked_range<ScalarIndex> &range) {
+                size_t invalid = 0;
+                for (ScalarIndex i = range.begin(); i != range.end(); ++i) {
+                    InputNormal3f n = dr::zeros<InputNormal3f>();
+                    for (ScalarIndex k = offsets[i]; k < offsets[i + 1]; ++k) {
+                        ScalarIndex c = corners[k];
+                        InputNormal3f face_n;
+                        InputVector3f face_angles;
+                        if (likely(face_weights(c / 3, face_n, face_angles)))
+                            n += face_n * face_angles[c % 3];
+                    }
 
-                for (size_t j = 0; j < 3; ++j)
-                    normals[fi[j]] += n * face_angles[j];
-            }
-        }
+                    InputFloat length = dr::norm(n);
+                    if (likely(length != 0.f)) {
+                        n /= length;
+                    } else {
+                        n = InputNormal3f(1, 0, 0); // Choose some bogus value
+                        invalid++;
+                    }
 
-        for (ScalarSize i = 0; i < m_vertex_count; i++) {
-            InputNormal3f n = normals[i];
-            InputFloat length = dr::norm(n);
-            if (likely(length != 0.f)) {
-                n /= length;
-            } else {
-                n = InputNormal3f(1, 0, 0); // Choose some bogus value
-                invalid_counter++;
+                    dr::store(m_vertex_normals.data() + 3 * i, n);
+                }
+                invalid_counter += invalid;
             }
-
-            dr::store(m_vertex_normals.data() + 3 * i, n);
-        }
+        );
 
         if (invalid_counter > 0)
             Log(Warn, "\"%s\": computed vertex normals (%i invalid vertices!)",
-                m_name, invalid_counter);
+                m_name, invalid_counter.load());
     } else {
         // The following is JITed into two separate kernel launches
 
@@ -413,6 +572,143 @@ MI_VARIANT void Mesh<Float, Spectrum>::recompute_vertex_normals() {
 
         dr::eval(m_vertex_normals);
     }
+
+    if (m_compact_vertices && m_initialized)
+        compact_vertex_data();
+    if (m_interleaved_vertices && m_initialized)
+        interleave_vertex_data();
+}
+
+MI_VARIANT void Mesh<Float, Spectrum>::interleave_vertex_data() {
+    if constexpr (!dr::is_jit_v<Float>) {
+        // Invalidate the layout first, so that the accessors below read the
+        // separate buffers
+        m_vertex_data_interleaved = FloatStorage();
+        m_vertex_stride = 0;
+
+        bool has_normals   = has_vertex_normals(),
+             has_texcoords = has_vertex_texcoords();
+        uint32_t stride = 3 + (has_normals ? 3 : 0) + (has_texcoords ? 2 : 0),
+                 texcoord_offset = has_normals ? 6 : 3;
+        if (m_vertex_count == 0 ||
+            m_vertex_positions.size() != m_vertex_count * 3)
+            return;
+
+        std::unique_ptr<InputFloat[]> data(new InputFloat[m_vertex_count * stride]);
+        for (ScalarSize i = 0; i < m_vertex_count; ++i) {
+            InputFloat *ptr = data.get() + i * stride;
+            dr::store(ptr, vertex_position(i));
+            if (has_normals)
+                dr::store(ptr + 3, vertex_normal(i));
+            if (has_texcoords)
+                dr::store(ptr + texcoord_offset, vertex_texcoord(i));
+        }
+
+        m_vertex_data_interleaved =
+            dr::load<FloatStorage>(data.get(), m_vertex_count * stride);
+        m_vertex_texcoord_offset = texcoord_offset;
+        m_vertex_stride = stride;
+    }
+}
+
+MI_VARIANT void Mesh<Float, Spectrum>::compact_vertex_data() {
+    auto quantize = [](InputFloat value) {
+        return (uint32_t) dr::round(dr::clip(value, 0.f, 1.f) * 65535.f);
+    };
+
+    if (m_vertex_normals.size() == m_vertex_count * 3 && m_vertex_count > 0) {
+        auto&& normals = dr::migrate(m_vertex_normals, AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+
+        const InputFloat *ptr = normals.data();
+        std::unique_ptr<uint32_t[]> packed(new uint32_t[m_vertex_count]);
+
+        for (ScalarSize i = 0; i < m_vertex_count; ++i) {
+            // Project onto the octahedron and fold the lower hemisphere
+            InputNormal3f n(ptr[3 * i + 0], ptr[3 * i + 1], ptr[3 * i + 2]);
+            n /= dr::abs(n.x()) + dr::abs(n.y()) + dr::abs(n.z());
+            InputFloat x = n.x(), y = n.y();
+            if (n.z() < 0.f) {
+                x = (1.f - dr::abs(n.y())) * (n.x() >= 0.f ? 1.f : -1.f);
+                y = (1.f - dr::abs(n.x())) * (n.y() >= 0.f ? 1.f : -1.f);
+            }
+            packed[i] = quantize(x * .5f + .5f) | (quantize(y * .5f + .5f) << 16);
+        }
+
+        m_vertex_normals_compact =
+            dr::load<DynamicBuffer<UInt32>>(packed.get(), m_vertex_count);
+        m_vertex_normals = FloatStorage();
+    }
+
+    if (m_vertex_texcoords.size() == m_vertex_count * 2 && m_vertex_count > 0) {
+        auto&& texcoords = dr::migrate(m_vertex_texcoords, AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+
+        const InputFloat *ptr = texcoords.data();
+        dr::Array<InputFloat, 2> lo = dr::Infinity<InputFloat>,
+                                 hi = -dr::Infinity<InputFloat>;
+        for (ScalarSize i = 0; i < m_vertex_count; ++i) {
+            dr::Array<InputFloat, 2> uv(ptr[2 * i + 0], ptr[2 * i + 1]);
+            lo = dr::minimum(lo, uv);
+            hi = dr::maximum(hi, uv);
+        }
+
+        dr::Array<InputFloat, 2> extents = hi - lo,
+                                 inv_extents = dr::select(extents > 0.f, dr::rcp(extents), 0.f);
+
+        std::unique_ptr<uint32_t[]> packed(new uint32_t[m_vertex_count]);
+        for (ScalarSize i = 0; i < m_vertex_count; ++i) {
+            dr::Array<InputFloat, 2> uv(ptr[2 * i + 0], ptr[2 * i + 1]);
+            uv = (uv - lo) * inv_extents;
+            packed[i] = quantize(uv.x()) | (quantize(uv.y()) << 16);
+        }
+
+        m_texcoord_offset = lo;
+        m_texcoord_scale  = extents * (1.f / 65535.f);
+        m_vertex_texcoords_compact =
+            dr::load<DynamicBuffer<UInt32>>(packed.get(), m_vertex_count);
+        m_vertex_texcoords = FloatStorage();
+    }
+}
+
+MI_VARIANT typename Mesh<Float, Spectrum>::FloatStorage
+Mesh<Float, Spectrum>::vertex_normals_data() const {
+    if (dr::width(m_vertex_normals_compact) == 0)
+        return m_vertex_normals;
+
+    FloatStorage result = dr::zeros<FloatStorage>(m_vertex_count * 3);
+    if constexpr (!dr::is_dynamic_v<Float>) {
+        for (ScalarSize i = 0; i < m_vertex_count; ++i)
+            dr::store(result.data() + 3 * i, vertex_normal(i));
+    } else {
+        UInt32 index = dr::arange<UInt32>(m_vertex_count);
+        auto n = vertex_normal(index);
+        for (uint32_t i = 0; i < 3; ++i)
+            dr::scatter(result, n[i], index * 3 + i);
+        dr::eval(result);
+    }
+    return result;
+}
+
+MI_VARIANT typename Mesh<Float, Spectrum>::FloatStorage
+Mesh<Float, Spectrum>::vertex_texcoords_data() const {
+    if (dr::width(m_vertex_texcoords_compact) == 0)
+        return m_vertex_texcoords;
+
+    FloatStorage result = dr::zeros<FloatStorage>(m_vertex_count * 2);
+    if constexpr (!dr::is_dynamic_v<Float>) {
+        for (ScalarSize i = 0; i < m_vertex_count; ++i)
+            dr::store(result.data() + 2 * i, vertex_texcoord(i));
+    } else {
+        UInt32 index = dr::arange<UInt32>(m_vertex_count);
+        auto uv = vertex_texcoord(index);
+        for (uint32_t i = 0; i < 2; ++i)
+            dr::scatter(result, uv[i], index * 2 + i);
+        dr::eval(result);
+    }
+    return result;
 }
 
 MI_VARIANT void Mesh<Float, Spectrum>::recompute_bbox() {
@@ -449,15 +745,20 @@ MI_VARIANT void Mesh<Float, Spectrum>::build_pmf() {
         const ScalarIndex *idx_p = faces.data();
 
         std::vector<ScalarFloat> table(m_face_count);
-        for (ScalarIndex i = 0; i < m_face_count; i++) {
-            ScalarPoint3u idx = dr::load<ScalarPoint3u>(idx_p + 3 * i);
+        dr::parallel_for(
+            dr::blocked_range<ScalarIndex>(0, m_face_count, mesh_faces_per_block),
+            [&](const dr::blocked_range<ScalarIndex> &range) {
+                for (ScalarIndex i = range.begin(); i != range.end(); ++i) {
+                    ScalarPoint3u idx = dr::load<ScalarPoint3u>(idx_p + 3 * i);
 
-            ScalarPoint3f p0 = dr::load<InputPoint3f>(pos_p + 3 * idx.x()),
-                          p1 = dr::load<InputPoint3f>(pos_p + 3 * idx.y()),
-                          p2 = dr::load<InputPoint3f>(pos_p + 3 * idx.z());
+                    ScalarPoint3f p0 = dr::load<InputPoint3f>(pos_p + 3 * idx.x()),
+                                  p1 = dr::load<InputPoint3f>(pos_p + 3 * idx.y()),
+                                  p2 = dr::load<InputPoint3f>(pos_p + 3 * idx.z());
 
-            table[i] = .5f * dr::norm(dr::cross(p1 - p0, p2 - p0));
-        }
+                    table[i] = .5f * dr::norm(dr::cross(p1 - p0, p2 - p0));
+                }
+            }
+        );
 
         m_area_pmf = DiscreteDistribution<Float>(table.data(), m_face_count);
     } else {
@@ -481,84 +782,78 @@ MI_VARIANT void Mesh<Float, Spectrum>::build_directed_edges() {
     if constexpr (dr::is_array_v<Float>)
         dr::sync_thread();
 
-    std::vector<ScalarIndex> V2E(m_vertex_count, m_invalid_dedge);
-    std::vector<ScalarIndex> E2E(m_face_count * 3, m_invalid_dedge);
-
-    /* For an edge e1 = (v1, v2), tmp is defined as:
-    /     tmp[e1].first  = v2,
-    /     tmp[e1].second = (next edge e_k that also starts from v1) or (m_invalid_dedge)
-    */
-    std::vector<std::pair<ScalarIndex, ScalarIndex>> tmp(m_face_count * 3);
-
-    // 1. Fill `tmp` and `V2E`
     const ScalarIndex *face_data = faces.data();
-    for (ScalarIndex f = 0; f < m_face_count; f++) {
-        ScalarPoint3u triangle_indices =
-            dr::load<ScalarPoint3u>(face_data + 3 * f);
-        for (ScalarIndex i = 0; i < 3; i++) {
-            ScalarIndex idx_cur = triangle_indices[i],
-                        idx_nxt = triangle_indices[(i + 1) % 3],
-                        edge_id = 3 * f + i;
-            if (idx_cur == idx_nxt)
-                continue;
-
-            tmp[edge_id] = std::make_pair(idx_nxt, m_invalid_dedge);
-            if (V2E[idx_cur] != m_invalid_dedge) {
-                ScalarIndex last_edge_idx = V2E[idx_cur];
-
-                while (tmp[last_edge_idx].second != m_invalid_dedge)
-                    last_edge_idx = tmp[last_edge_idx].second;
-
-                if (tmp[last_edge_idx].second == m_invalid_dedge)
-                    tmp[last_edge_idx].second = edge_id;
-            } else {
-                V2E[idx_cur] = edge_id;
+    ScalarIndex edge_count = m_face_count * 3;
+
+    // Vertex at which the directed edge 'e' ends
+    auto edge_end = [face_data](ScalarIndex e) {
+        return face_data[e - e % 3 + (e % 3 + 1) % 3];
+    };
+
+    // 1. Group the (non-degenerate) directed edges by their start vertex
+    std::vector<ScalarIndex> offsets, edges;
+    std::tie(offsets, edges) = vertex_corners<ScalarIndex>(
+        face_data, m_face_count, m_vertex_count, true);
+
+    auto for_each_edge = [&](auto &&func) {
+        dr::parallel_for(
+            dr::blocked_range<ScalarIndex>(0, m_face_count, mesh_faces_per_block),
+            [&](const dr::blocked_range<ScalarIndex> &range) {
+                for (ScalarIndex e = 3 * range.begin(); e != 3 * range.end(); ++e) {
+                    ScalarIndex idx_cur = face_data[e], idx_nxt = edge_end(e);
+                    if (idx_cur != idx_nxt)
+                        func(e, idx_cur, idx_nxt);
+                }
             }
-        }
-    }
-
-    // 2. Manifold check & assign `E2E`
-    std::vector<bool> non_manifold(m_vertex_count, false);
-    for (ScalarIndex f = 0; f < m_face_count; f++) {
-        ScalarPoint3u tri = dr::load<ScalarPoint3u>(face_data + 3 * f);
-        for (ScalarIndex i = 0; i < 3; i++) {
-            ScalarIndex idx_cur = tri[i],
-                        idx_nxt = tri[(i + 1) % 3],
-                        edge_id_cur = 3 * f + i;
-            if (idx_cur == idx_nxt)
-                continue;
-
-            ScalarIndex it = V2E[idx_nxt], edge_id_opp = m_invalid_dedge;
-            while (it != m_invalid_dedge) {
-                if (tmp[it].first == idx_cur) {
-                    if (edge_id_opp == m_invalid_dedge) {
-                        edge_id_opp = it;
-                    } else {
-                        non_manifold[idx_cur] = true;
-                        non_manifold[idx_nxt] = true;
-                        edge_id_opp           = m_invalid_dedge;
-                        break;
-                    }
+        );
+    };
+
+    /* 2. Manifold check: find the opposite edge of every edge, which must be
+          the only edge going in the reverse direction */
+    std::vector<ScalarIndex> opposite(edge_count, m_invalid_dedge);
+    std::vector<std::atomic<bool>> non_manifold(m_vertex_count);
+    for_each_edge([&](ScalarIndex e, ScalarIndex idx_cur, ScalarIndex idx_nxt) {
+        ScalarIndex edge_id_opp = m_invalid_dedge;
+        for (ScalarIndex k = offsets[idx_nxt]; k < offsets[idx_nxt + 1]; ++k) {
+            ScalarIndex it = edges[k];
+            if (edge_end(it) == idx_cur) {
+                if (edge_id_opp == m_invalid_dedge) {
+                    edge_id_opp = it;
+                } else {
+                    non_manifold[idx_cur].store(true, std::memory_order_relaxed);
+                    non_manifold[idx_nxt].store(true, std::memory_order_relaxed);
+                    edge_id_opp = m_invalid_dedge;
+                    break;
                 }
-                it = tmp[it].second;
             }
+        }
+        opposite[e] = edge_id_opp;
+    });
+
+    /* 3. Assign `E2E`. Edges are paired up when the smaller of the two edge
+          indices has the other one as its opposite. When this is ambiguous
+          (around non-manifold vertices), the pairing made by the
+          largest such edge index takes precedence. */
+    std::vector<ScalarIndex> E2E(edge_count, m_invalid_dedge);
+    for_each_edge([&](ScalarIndex e, ScalarIndex idx_cur, ScalarIndex idx_nxt) {
+        if (opposite[e] != m_invalid_dedge && e < opposite[e]) {
+            E2E[e] = opposite[e];
+            return;
+        }
 
-            if (edge_id_opp != m_invalid_dedge && edge_id_cur < edge_id_opp) {
-                E2E[edge_id_cur] = edge_id_opp;
-                E2E[edge_id_opp] = edge_id_cur;
-            }
+        for (ScalarIndex k = offsets[idx_nxt]; k < offsets[idx_nxt + 1]; ++k) {
+            ScalarIndex it = edges[k];
+            if (it >= e)
+                break;
+            if (edge_end(it) == idx_cur && opposite[it] == e)
+                E2E[e] = it;
         }
-    }
+    });
 
-    // 3. Log
+    // 4. Log
     ScalarIndex non_manifold_count = 0;
-    std::vector<bool> boundary(m_vertex_count, false);
-    for (ScalarIndex i = 0; i < m_vertex_count; i++) {
-        if (non_manifold[i]) {
-            non_manifold_count++;
-            continue;
-        }
-    }
+    for (ScalarIndex i = 0; i < m_vertex_count; i++)
+        non_manifold_count += non_manifold[i].load(std::memory_order_relaxed);
 
     if (non_manifold_count > 0)
         Log(Warn,
@@ -568,6 +863,7 @@ MI_VARIANT void Mesh<Float, Spectrum>::build_directed_edges() {
 
     m_E2E = dr::load<DynamicBuffer<UInt32>>(E2E.data(), m_face_count * 3);
     m_E2E_outdated = false;
+    m_sil_tree_outdated = true;
 }
 
 /**
@@ -622,68 +918,179 @@ Mesh<Float, Spectrum>::build_indirect_silhouette_distribution() {
     m_sil_dedge_pmf = DiscreteDistribution<Float>(weight);
 }
 
-MI_VARIANT
-ref<Mesh<Float, Spectrum>>
+MI_VARIANT ref<Mesh<Float, Spectrum>>
 Mesh<Float, Spectrum>::merge(const Mesh *other) const {
-    if (other->emitter() != m_emitter || other->sensor() != m_sensor ||
-        other->bsdf() != m_bsdf ||
-        other->interior_medium() != m_interior_medium ||
-        other->exterior_medium() != m_exterior_medium ||
-        other->has_vertex_normals() != has_vertex_normals() ||
-        other->has_vertex_texcoords() != has_vertex_texcoords() ||
-        other->has_face_normals() != has_face_normals() ||
-        other->has_mesh_attributes() || has_mesh_attributes())
-        Throw("Mesh::merge(): the two meshes are incompatible (%s and %s)!",
-              to_string(), other->to_string());
+    return merge(std::vector<const Mesh *>{ this, other });
+}
+
+MI_VARIANT ref<Mesh<Float, Spectrum>>
+Mesh<Float, Spectrum>::merge(const std::vector<const Mesh *> &meshes) {
+    if (meshes.empty())
+        Throw("Mesh::merge(): the list of meshes is empty!");
+
+    const Mesh *first = meshes[0];
+    bool compact = true, interleaved = true;
+    for (const Mesh *other : meshes) {
+        if (other->emitter() != first->m_emitter || other->sensor() != first->m_sensor ||
+            other->bsdf() != first->m_bsdf ||
+            other->interior_medium() != first->m_interior_medium ||
+            other->exterior_medium() != first->m_exterior_medium ||
+            other->has_vertex_normals() != first->has_vertex_normals() ||
+            other->has_vertex_texcoords() != first->has_vertex_texcoords() ||
+            other->has_face_normals() != first->has_face_normals() ||
+            other->has_mesh_attributes())
+            Throw("Mesh::merge(): the two meshes are incompatible (%s and %s)!",
+                  first->to_string(), other->to_string());
+        compact &= other->m_compact_vertices;
+        interleaved &= other->m_interleaved_vertices;
+    }
 
     Properties props;
-    if (m_bsdf)
-        props.set_object("bsdf", (Object *) m_bsdf.get());
-    if (m_interior_medium)
-        props.set_object("interior", (Object *) m_interior_medium.get());
-    if (m_exterior_medium)
-        props.set_object("exterior", (Object *) m_exterior_medium.get());
-    if (m_sensor)
-        props.set_object("sensor", (Object *) m_sensor.get());
-    if (m_emitter)
-        props.set_object("emitter", (Object *) m_emitter.get());
-    props.set_bool("face_normals", m_face_normals);
-
-    ref<Mesh> result = new Mesh(
-        m_name + " + " + other->m_name, m_vertex_count + other->vertex_count(),
-        m_face_count + other->face_count(), props, has_vertex_normals(),
-        has_vertex_texcoords());
-
-    result->m_vertex_positions =
-        dr::concat(m_vertex_positions, other->m_vertex_positions);
+    if (first->m_bsdf)
+        props.set_object("bsdf", (Object *) first->m_bsdf.get());
+    if (first->m_interior_medium)
+        props.set_object("interior", (Object *) first->m_interior_medium.get());
+    if (first->m_exterior_medium)
+        props.set_object("exterior", (Object *) first->m_exterior_medium.get());
+    if (first->m_sensor)
+        props.set_object("sensor", (Object *) first->m_sensor.get());
+    if (first->m_emitter)
+        props.set_object("emitter", (Object *) first->m_emitter.get());
+    props.set_bool("face_normals", first->m_face_normals);
+    props.set_bool("compact_vertices", compact);
+    props.set_bool("interleaved_vertices", interleaved);
+
+    bool has_normals   = first->has_vertex_normals(),
+         has_texcoords = first->has_vertex_texcoords();
+
+    // Final buffer layout: offsets of every input mesh
+    size_t n = meshes.size();
+    std::vector<size_t> vertex_offset(n + 1, 0), face_offset(n + 1, 0);
+    std::string name = first->m_name;
+    ScalarBoundingBox3f bbox;
+    for (size_t i = 0; i < n; ++i) {
+        vertex_offset[i + 1] = vertex_offset[i] + meshes[i]->vertex_count();
+        face_offset[i + 1] = face_offset[i] + meshes[i]->face_count();
+        bbox.expand(meshes[i]->m_bbox);
+        if (i > 0)
+            name += " + " + meshes[i]->m_name;
+    }
 
-    if (has_vertex_normals())
-        result->m_vertex_normals =
-            dr::concat(m_vertex_normals, other->m_vertex_normals);
+    if (vertex_offset[n] > 0xFFFFFFFFull || face_offset[n] * 3 > 0xFFFFFFFFull)
+        Throw("Mesh::merge(): the merged mesh is too large!");
+
+    ref<Mesh> result = new Mesh(name, 0, 0, props, false, false);
+    result->m_vertex_count = (ScalarSize) vertex_offset[n];
+    result->m_face_count = (ScalarSize) face_offset[n];
+    result->m_bbox = bbox;
+
+    /* Pointers to the host data of the inputs. In the JIT variants, they
+       refer to host copies that are kept alive by 'storage'. */
+    std::vector<FloatStorage> storage;
+    std::vector<DynamicBuffer<UInt32>> storage_faces;
+    storage.reserve(5 * n);
+    storage_faces.reserve(n);
+
+    auto host = [&](const FloatStorage &buf) -> const InputFloat * {
+        if constexpr (dr::is_jit_v<Float>) {
+            storage.push_back(dr::migrate(buf, AllocType::Host));
+            return storage.back().data();
+        } else {
+            return buf.data();
+        }
+    };
+
+    std::vector<const InputFloat *> positions(n), normals(n), texcoords(n);
+    std::vector<const ScalarIndex *> faces(n);
+    for (size_t i = 0; i < n; ++i) {
+        const Mesh *mesh = meshes[i];
+        positions[i] = host(mesh->m_vertex_positions);
+        if constexpr (dr::is_jit_v<Float>) {
+            storage_faces.push_back(dr::migrate(mesh->m_faces, AllocType::Host));
+            faces[i] = storage_faces.back().data();
+        } else {
+            faces[i] = mesh->m_faces.data();
+        }
 
-    if (has_vertex_texcoords())
-        result->m_vertex_texcoords =
-            dr::concat(m_vertex_texcoords, other->m_vertex_texcoords);
+        // Decode compact normals and texture coordinates if necessary
+        if (has_normals) {
+            if (mesh->m_vertex_normals.size() == 0)
+                storage.push_back(mesh->vertex_normals_data());
+            normals[i] = host(mesh->m_vertex_normals.size() == 0
+                                  ? storage.back() : mesh->m_vertex_normals);
+        }
+        if (has_texcoords) {
+            if (mesh->m_vertex_texcoords.size() == 0)
+                storage.push_back(mesh->vertex_texcoords_data());
+            texcoords[i] = host(mesh->m_vertex_texcoords.size() == 0
+                                    ? storage.back() : mesh->m_vertex_texcoords);
+        }
+    }
+    if constexpr (dr::is_jit_v<Float>)
+        dr::sync_thread();
 
-    result->m_faces = dr::concat(m_faces, other->m_faces);
-    result->m_bbox = m_bbox;
-    result->m_bbox.expand(other->m_bbox);
+    /* Allocate every output once. The scalar variants write into the final
+       buffers, the JIT variants into host memory that is uploaded below. */
+    size_t vertex_total = vertex_offset[n], index_total = face_offset[n] * 3;
+    std::vector<InputFloat> host_buffer;
+    std::vector<ScalarIndex> host_faces;
+    InputFloat *out_positions, *out_normals = nullptr, *out_texcoords = nullptr;
+    ScalarIndex *out_faces;
 
+    size_t float_total = vertex_total * (3 + (has_normals ? 3 : 0) + (has_texcoords ? 2 : 0));
     if constexpr (dr::is_jit_v<Float>) {
-        UInt32 threshold = dr::opaque<UInt32>(face_count() * 3),
-               offset    = dr::opaque<UInt32>(vertex_count()),
-               index     = dr::arange<UInt32>(result->face_count() * 3);
+        host_buffer.resize(float_total);
+        host_faces.resize(index_total);
+        out_positions = host_buffer.data();
+        out_faces = host_faces.data();
+        if (has_normals)
+            out_normals = out_positions + vertex_total * 3;
+        if (has_texcoords)
+            out_texcoords = out_positions + vertex_total * (has_normals ? 6 : 3);
+    } else {
+        result->m_vertex_positions = dr::empty<FloatStorage>(vertex_total * 3);
+        result->m_faces = dr::empty<DynamicBuffer<UInt32>>(index_total);
+        out_positions = result->m_vertex_positions.data();
+        out_faces = result->m_faces.data();
+        if (has_normals) {
+            result->m_vertex_normals = dr::empty<FloatStorage>(vertex_total * 3);
+            out_normals = result->m_vertex_normals.data();
+        }
+        if (has_texcoords) {
+            result->m_vertex_texcoords = dr::empty<FloatStorage>(vertex_total * 2);
+            out_texcoords = result->m_vertex_texcoords.data();
+        }
+    }
 
-        result->m_faces = dr::select(index < threshold, result->m_faces,
-                                     result->m_faces + offset);
+    dr::parallel_for(
+        dr::blocked_range<size_t>(0, n, 1),
+        [&](const dr::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                size_t vo = vertex_offset[i],
+                       vc = vertex_offset[i + 1] - vo,
+                       fc = face_offset[i + 1] - face_offset[i];
+
+                memcpy(out_positions + vo * 3, positions[i], vc * 3 * sizeof(InputFloat));
+                if (has_normals)
+                    memcpy(out_normals + vo * 3, normals[i], vc * 3 * sizeof(InputFloat));
+                if (has_texcoords)
+                    memcpy(out_texcoords + vo * 2, texcoords[i], vc * 2 * sizeof(InputFloat));
+
+                const ScalarIndex *src = faces[i];
+                ScalarIndex *dst = out_faces + face_offset[i] * 3;
+                for (size_t j = 0; j < fc * 3; ++j)
+                    dst[j] = src[j] + (ScalarIndex) vo;
+            }
+        }
+    );
 
-        dr::eval(result->m_faces, result->m_vertex_positions,
-                 result->m_vertex_normals, result->m_vertex_texcoords);
-    } else {
-        uint32_t  offset = vertex_count(),
-                 *ptr    = result->m_faces.data() + face_count() * 3;
-        for (size_t i = 0; i < other->face_count() * 3; ++i)
-            *ptr++ += offset;
+    if constexpr (dr::is_jit_v<Float>) {
+        result->m_vertex_positions = dr::load<FloatStorage>(out_positions, vertex_total * 3);
+        result->m_faces = dr::load<DynamicBuffer<UInt32>>(out_faces, index_total);
+        if (has_normals)
+            result->m_vertex_normals = dr::load<FloatStorage>(out_normals, vertex_total * 3);
+        if (has_texcoords)
+            result->m_vertex_texcoords = dr::load<FloatStorage>(out_texcoords, vertex_total * 2);
     }
 
     result->initialize();
@@ -705,7 +1112,7 @@ MI_VARIANT void Mesh<Float, Spectrum>::build_parameterization() {
                  props, false, false);
     mesh->m_faces = m_faces;
 
-    auto&& vertex_texcoords = dr::migrate(m_vertex_texcoords, AllocType::Host);
+    auto&& vertex_texcoords = dr::migrate(vertex_texcoords_data(), AllocType::Host);
     if constexpr (dr::is_jit_v<Float>)
         dr::sync_thread();
 
@@ -760,13 +1167,21 @@ Mesh<Float, Spectrum>::sample_position(Float time, const Point2f &sample_, Mask
         m_area_pmf.sample_reuse(sample.y(), active);
 
     Vector3u fi = face_indices(face_idx, active);
+    Point2f b = warp::square_to_uniform_triangle(sample);
+
+    PositionSample3f ps = position_sample(fi, b, time, active);
+    ps.prim_index = face_idx;
+    return ps;
+}
 
+MI_VARIANT typename Mesh<Float, Spectrum>::PositionSample3f
+Mesh<Float, Spectrum>::position_sample(const Vector3u &fi, const Point2f &b,
+                                       Float time, Mask active) const {
     Point3f p0 = vertex_position(fi[0], active),
             p1 = vertex_position(fi[1], active),
             p2 = vertex_position(fi[2], active);
 
     Vector3f e0 = p1 - p0, e1 = p2 - p0;
-    Point2f b = warp::square_to_uniform_triangle(sample);
 
     PositionSample3f ps;
     ps.p     = dr::fmadd(e0, b.x(), dr::fmadd(e1, b.y(), p0));
@@ -804,6 +1219,103 @@ Mesh<Float, Spectrum>::sample_position(Float time, const Point2f &sample_, Mask
     return ps;
 }
 
+MI_VARIANT std::pair<typename Mesh<Float, Spectrum>::Mask, Float>
+Mesh<Float, Spectrum>::spherical_triangle_pdf(const Point3f &p,
+                                              const Point3f &p0,
+                                              const Point3f &p1,
+                                              const Point3f &p2) const {
+    /* Arvo's method becomes unstable for tiny triangles (where area sampling
+       works well), and for triangles covering almost a hemisphere */
+    const ScalarFloat min_solid_angle = 3e-4f, max_solid_angle = 6.22f;
+
+    Float pdf = warp::square_to_spherical_triangle_pdf(
+        dr::normalize(p0 - p), dr::normalize(p1 - p), dr::normalize(p2 - p));
+
+    Mask valid = pdf < (1.f / min_solid_angle) && pdf > (1.f / max_solid_angle);
+    return { valid, pdf };
+}
+
+MI_VARIANT typename Mesh<Float, Spectrum>::DirectionSample3f
+Mesh<Float, Spectrum>::sample_direction(const Interaction3f &it,
+                                        const Point2f &sample_,
+                                        Mask active) const {
+    if (!m_solid_angle_sampling)
+        return Base::sample_direction(it, sample_, active);
+
+    MI_MASK_ARGUMENT(active);
+    ensure_pmf_built();
+
+    using Index = dr::replace_scalar_t<Float, ScalarIndex>;
+    Index face_idx;
+    Point2f sample = sample_;
+
+    std::tie(face_idx, sample.y()) =
+        m_area_pmf.sample_reuse(sample.y(), active);
+    Float face_pmf = m_area_pmf.eval_pmf_normalized(face_idx, active);
+
+    Vector3u fi = face_indices(face_idx, active);
+    Point3f p0 = vertex_position(fi[0], active),
+            p1 = vertex_position(fi[1], active),
+            p2 = vertex_position(fi[2], active);
+    Vector3f e0 = p1 - p0, e1 = p2 - p0;
+
+    auto [spherical, sa_pdf] = spherical_triangle_pdf(it.p, p0, p1, p2);
+
+    // Intersect the sampled direction with the plane of the triangle
+    Vector3f d = warp::square_to_spherical_triangle(
+        sample, dr::normalize(p0 - it.p), dr::normalize(p1 - it.p),
+        dr::normalize(p2 - it.p));
+    Vector3f ng = dr::cross(e0, e1), rel = dr::fmadd(d, dr::dot(p0 - it.p, ng) /
+                                                     dr::dot(d, ng), it.p) - p0;
+
+    // .. and find its barycentric coordinates
+    Float d00 = dr::dot(e0, e0), d01 = dr::dot(e0, e1), d11 = dr::dot(e1, e1),
+          d20 = dr::dot(rel, e0), d21 = dr::dot(rel, e1),
+          inv_denom = dr::rcp(d00 * d11 - d01 * d01);
+    Point2f b_sa = dr::clip(Point2f((d11 * d20 - d01 * d21) * inv_denom,
+                                    (d00 * d21 - d01 * d20) * inv_denom), 0.f, 1.f);
+    b_sa /= dr::maximum(b_sa.x() + b_sa.y(), 1.f);
+
+    spherical &= dr::all(dr::isfinite(b_sa));
+    Point2f b = dr::select(spherical, b_sa,
+                           warp::square_to_uniform_triangle(sample));
+
+    DirectionSample3f ds(position_sample(fi, b, it.time, active));
+    ds.prim_index = face_idx;
+    ds.d = ds.p - it.p;
+
+    Float dist_squared = dr::squared_norm(ds.d);
+    ds.dist = dr::sqrt(dist_squared);
+    ds.d /= ds.dist;
+
+    Float x = dist_squared / dr::abs_dot(ds.d, ds.n);
+    ds.pdf = dr::select(spherical, face_pmf * sa_pdf,
+                        ds.pdf * dr::select(dr::isfinite(x), x, 0.f));
+
+    return ds;
+}
+
+MI_VARIANT Float Mesh<Float, Spectrum>::pdf_direction(const Interaction3f &it,
+                                                      const DirectionSample3f &ds,
+                                                      Mask active) const {
+    if (!m_solid_angle_sampling)
+        return Base::pdf_direction(it, ds, active);
+
+    MI_MASK_ARGUMENT(active);
+    ensure_pmf_built();
+
+    Vector3u fi = face_indices(ds.prim_index, active);
+    Point3f p0 = vertex_position(fi[0], active),
+            p1 = vertex_position(fi[1], active),
+            p2 = vertex_position(fi[2], active);
+
+    auto [spherical, sa_pdf] = spherical_triangle_pdf(it.p, p0, p1, p2);
+    Float face_pmf = m_area_pmf.eval_pmf_normalized(ds.prim_index, active);
+
+    return dr::select(spherical, face_pmf * sa_pdf,
+                      Base::pdf_direction(it, ds, active));
+}
+
 MI_VARIANT
 
 typename Mesh<Float, Spectrum>::SurfaceInteraction3f
@@ -1180,128 +1692,246 @@ Mesh<Float, Spectrum>::primitive_silhouette_projection(const Point3f &viewpoint,
     return ss;
 }
 
-MI_VARIANT
-std::tuple<DynamicBuffer<typename CoreAliases<Float>::UInt32>,
-           DynamicBuffer<Float>>
-Mesh<Float, Spectrum>::precompute_silhouette(
-    const ScalarPoint3f &viewpoint) const {
-    if constexpr (!dr::is_jit_v<Float>) {
-        using Vec3f = ScalarVector3f;
-        using Pt3f  = ScalarPoint3f;
+/// Maximum number of edges in a leaf of the silhouette hierarchy
+static constexpr uint32_t mesh_silhouette_leaf_size = 8;
 
-        auto &&vertex_positions =
-            dr::migrate(m_vertex_positions, AllocType::Host);
-        auto &&faces = dr::migrate(m_faces, AllocType::Host);
-        auto &&E2E   = dr::migrate(m_E2E, AllocType::Host);
+MI_VARIANT void Mesh<Float, Spectrum>::update_silhouette_tree() const {
+    if (!m_sil_tree_outdated && !m_sil_tree_refit)
+        return;
 
-        if constexpr (dr::is_array_v<Float>)
-            dr::sync_thread();
+    auto &&vertex_positions = dr::migrate(m_vertex_positions, AllocType::Host);
+    auto &&faces = dr::migrate(m_faces, AllocType::Host);
+    auto &&E2E   = dr::migrate(m_E2E, AllocType::Host);
 
-        const InputFloat *V          = vertex_positions.data();
-        const ScalarIndex *E2E_data  = E2E.data();
-        const ScalarIndex *face_data = faces.data();
-
-        ScalarIndex prim_count = 0u;
-        std::vector<ScalarIndex> indices(m_face_count * 3u);
-        std::vector<ScalarFloat> weight(m_face_count * 3u);
-        ScalarFloat weight_sum = 0.f;
-
-        for (ScalarIndex f = 0; f < m_face_count; f++) {
-            ScalarPoint3u idx = dr::load<ScalarPoint3u>(face_data + 3 * f);
-            Pt3f v0           = dr::load<Pt3f>(V + 3 * idx.x());
-            Pt3f v1           = dr::load<Pt3f>(V + 3 * idx.y());
-            Pt3f v2           = dr::load<Pt3f>(V + 3 * idx.z());
-            Vec3f n           = dr::normalize(dr::cross(v1 - v0, v2 - v0));
-
-            Vec3f to_v0 = dr::normalize(v0 - viewpoint);
-            Vec3f to_v1 = dr::normalize(v1 - viewpoint);
-            Vec3f to_v2 = dr::normalize(v2 - viewpoint);
-
-            auto check_edge = [&](const ScalarIndex dedge_curr,
-                                  const Vec3f &dir1,
-                                  const Vec3f &dir2) -> void {
-                ScalarIndex dedge_oppo =
-                    dr::load<ScalarIndex>(E2E_data + dedge_curr);
-                bool valid = false;
-
-                if (dedge_oppo == m_invalid_dedge) {
-                    valid = true;
-                } else if (dedge_oppo > dedge_curr) {
-                    ScalarIndex face_index_oppo = dr::idiv(dedge_oppo, 3u);
-                    ScalarPoint3u v_idx_oppo    = dr::load<ScalarPoint3u>(
-                        face_data + 3 * face_index_oppo);
-
-                    Pt3f v0_oppo = dr::load<Pt3f>(V + 3 * v_idx_oppo.x());
-                    Pt3f v1_oppo = dr::load<Pt3f>(V + 3 * v_idx_oppo.y());
-                    Pt3f v2_oppo = dr::load<Pt3f>(V + 3 * v_idx_oppo.z());
-                    Vec3f n_oppo = dr::normalize(
-                        dr::cross(v1_oppo - v0_oppo, v2_oppo - v0_oppo));
-
-                    if (dr::dot(dir1, n) * dr::dot(dir1, n_oppo) <= 0.f &&
-                        dr::abs(dr::dot(n, n_oppo)) < 1.f) {
-                        valid = true;
-                    }
-                }
+    if constexpr (dr::is_array_v<Float>)
+        dr::sync_thread();
 
-                if (valid) {
-                    indices[prim_count] = dedge_curr;
+    const InputFloat *V          = vertex_positions.data();
+    const ScalarIndex *E2E_data  = E2E.data();
+    const ScalarIndex *face_data = faces.data();
 
-                    // The arclength weight is not perfect for perspective
-                    // cameras. But it is a close approximation.
-                    weight[prim_count] = unit_angle(dir1, dir2);
-                    weight_sum += weight[prim_count];
-                    prim_count++;
-                }
-            };
+    auto vertex = [&](ScalarIndex dedge, ScalarIndex offset) {
+        ScalarIndex f = dedge / 3u, e = (dedge % 3u + offset) % 3u;
+        return ScalarPoint3f(
+            dr::load<InputPoint3f>(V + 3 * face_data[3 * f + e]));
+    };
+
+    auto normal = [&](ScalarIndex dedge) {
+        ScalarIndex e = dedge % 3u;
+        ScalarPoint3f v0 = vertex(dedge, 3u - e), v1 = vertex(dedge, 4u - e),
+                      v2 = vertex(dedge, 5u - e);
+        return ScalarVector3f(dr::normalize(dr::cross(v1 - v0, v2 - v0)));
+    };
+
+    // 1. Topology changed: collect the edges (once per pair of directed edges)
+    if (m_sil_tree_outdated) {
+        m_sil_tree_edges.clear();
+        m_sil_boundary_edges.clear();
+        for (ScalarIndex e = 0; e < m_face_count * 3u; ++e) {
+            ScalarIndex e_oppo = E2E_data[e];
+            if (e_oppo == m_invalid_dedge)
+                m_sil_boundary_edges.push_back({ e, {}, {}, {}, {} });
+            else if (e_oppo > e)
+                m_sil_tree_edges.push_back({ e, {}, {}, {}, {} });
+        }
+    }
 
-            check_edge(f * 3u, to_v0, to_v1);
-            check_edge(f * 3u + 1u, to_v1, to_v2);
-            check_edge(f * 3u + 2u, to_v2, to_v0);
+    // 2. Update the geometry of the edges
+    auto update_edge = [&](SilhouetteTreeEdge &edge, bool interior) {
+        edge.p0 = vertex(edge.dedge, 0u);
+        edge.p1 = vertex(edge.dedge, 1u);
+        edge.n0 = normal(edge.dedge);
+        if (interior)
+            edge.n1 = normal(E2E_data[edge.dedge]);
+    };
+
+    dr::parallel_for(
+        dr::blocked_range<size_t>(0, m_sil_tree_edges.size(), 1024),
+        [&](const dr::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i)
+                update_edge(m_sil_tree_edges[i], true);
         }
+    );
+    for (SilhouetteTreeEdge &edge : m_sil_boundary_edges)
+        update_edge(edge, false);
+
+    /* 3. Topology changed: build the hierarchy with median splits, storing the
+          nodes in depth-first order (i.e. children after their parent) */
+    if (m_sil_tree_outdated) {
+        m_sil_tree_nodes.clear();
+
+        auto build = [&](auto &&self, uint32_t begin, uint32_t end) -> void {
+            uint32_t node = (uint32_t) m_sil_tree_nodes.size();
+            m_sil_tree_nodes.push_back({ {}, {}, 0.f, begin, end - begin });
+            if (end - begin <= mesh_silhouette_leaf_size)
+                return;
+
+            ScalarBoundingBox3f centroids;
+            for (uint32_t i = begin; i < end; ++i)
+                centroids.expand(.5f * (m_sil_tree_edges[i].p0 + m_sil_tree_edges[i].p1));
+            uint32_t axis = centroids.major_axis(), mid = (begin + end) / 2;
+
+            std::nth_element(
+                m_sil_tree_edges.begin() + begin, m_sil_tree_edges.begin() + mid,
+                m_sil_tree_edges.begin() + end,
+                [axis](const SilhouetteTreeEdge &a, const SilhouetteTreeEdge &b) {
+                    return a.p0[axis] + a.p1[axis] < b.p0[axis] + b.p1[axis];
+                });
+
+            self(self, begin, mid);
+            m_sil_tree_nodes[node].offset = (uint32_t) m_sil_tree_nodes.size();
+            m_sil_tree_nodes[node].count = 0;
+            self(self, mid, end);
+        };
+
+        if (!m_sil_tree_edges.empty())
+            build(build, 0, (uint32_t) m_sil_tree_edges.size());
+    }
 
-        indices.resize(prim_count);
-        weight.resize(prim_count);
+    // 4. Refit the bounds of all nodes, children first
+    for (size_t i = m_sil_tree_nodes.size(); i-- > 0; ) {
+        SilhouetteTreeNode &node = m_sil_tree_nodes[i];
+
+        if (node.count > 0) {
+            node.bbox = ScalarBoundingBox3f();
+            ScalarVector3f sum = 0.f;
+            bool finite = true;
+            for (uint32_t j = node.offset; j < node.offset + node.count; ++j) {
+                const SilhouetteTreeEdge &edge = m_sil_tree_edges[j];
+                node.bbox.expand(edge.p0);
+                node.bbox.expand(edge.p1);
+                sum += edge.n0 + edge.n1;
+                finite &= dr::all(dr::isfinite(edge.n0) && dr::isfinite(edge.n1));
+            }
 
-        DynamicBuffer<UInt32> out_indices = dr::load<UInt32>(indices.data(), indices.size());
-        DynamicBuffer<Float> out_weights= dr::load<Float>(weight.data(), weight.size());
+            node.axis = dr::normalize(sum);
+            node.theta = 0.f;
+            if (!finite || !dr::all(dr::isfinite(node.axis))) {
+                // Degenerate faces: this node cannot be culled
+                node.theta = dr::Pi<ScalarFloat>;
+                continue;
+            }
 
-        return std::make_tuple(out_indices, out_weights);
-    } else {
-        UInt32 dedge_curr = dr::arange<UInt32>(m_face_count * 3);
-        auto [face_idx, e] = dr::idivmod(dedge_curr, 3u);
-        Vector3u fi = face_indices(face_idx);
-        Point3f p0 = vertex_position(pick_vertex(fi, e + 0u)),
-                p1 = vertex_position(pick_vertex(fi, e + 1u));
+            for (uint32_t j = node.offset; j < node.offset + node.count; ++j) {
+                const SilhouetteTreeEdge &edge = m_sil_tree_edges[j];
+                node.theta = dr::maximum(
+                    node.theta, dr::maximum(unit_angle(node.axis, edge.n0),
+                                            unit_angle(node.axis, edge.n1)));
+            }
+        } else {
+            const SilhouetteTreeNode &c0 = m_sil_tree_nodes[i + 1],
+                                     &c1 = m_sil_tree_nodes[node.offset];
+            node.bbox = ScalarBoundingBox3f::merge(c0.bbox, c1.bbox);
+
+            // Conservative union of the normal cones of the two children
+            node.axis = dr::normalize(c0.axis + c1.axis);
+            if (c0.theta >= dr::Pi<ScalarFloat> ||
+                c1.theta >= dr::Pi<ScalarFloat> ||
+                !dr::all(dr::isfinite(node.axis)))
+                node.theta = dr::Pi<ScalarFloat>;
+            else
+                node.theta = dr::minimum(
+                    dr::maximum(unit_angle(node.axis, c0.axis) + c0.theta,
+                                unit_angle(node.axis, c1.axis) + c1.theta),
+                    dr::Pi<ScalarFloat>);
+        }
+    }
 
-        Normal3f n = face_normal(face_idx);
-        Vector3f to_p0 = dr::normalize(p0 - viewpoint);
-        Vector3f to_p1 = dr::normalize(p1 - viewpoint);
+    m_sil_tree_outdated = false;
+    m_sil_tree_refit = false;
+}
 
+MI_VARIANT
+std::tuple<DynamicBuffer<typename CoreAliases<Float>::UInt32>,
+           DynamicBuffer<Float>>
+Mesh<Float, Spectrum>::precompute_silhouette(
+    const ScalarPoint3f &viewpoint) const {
+    // Directed edge data structure was not prepared,
+    // e.g. due to the shape not being differentiated.
+    if (m_E2E_outdated)
+        return { DynamicBuffer<UInt32>(), DynamicBuffer<Float>() };
+
+    update_silhouette_tree();
+
+    std::vector<std::pair<ScalarIndex, ScalarFloat>> silhouette;
+
+    auto add_edge = [&](const SilhouetteTreeEdge &edge) {
         // The arclength weight is not perfect for perspective
         // cameras. But it is a close approximation.
-        Float weight = unit_angle(to_p0, to_p1);
+        silhouette.emplace_back(
+            edge.dedge, unit_angle(dr::normalize(edge.p0 - viewpoint),
+                                   dr::normalize(edge.p1 - viewpoint)));
+    };
+
+    // Boundary edges always belong to the silhouette
+    for (const SilhouetteTreeEdge &edge : m_sil_boundary_edges)
+        add_edge(edge);
+
+    /* A node can only contain silhouette edges if the viewpoint may lie in
+       front of some of its faces and behind others. All directions from the
+       bounding sphere of the node towards the viewpoint lie in a cone of
+       half-angle 'phi', and the face normals in a cone of half-angle 'theta':
+       when the angle 'alpha' between both axes is further than 'phi + theta'
+       away from a right angle, all faces are either front- or back-facing. */
+    auto may_contain_silhouette = [&](const SilhouetteTreeNode &node) {
+        if (node.theta >= .5f * dr::Pi<ScalarFloat>)
+            return true;
+
+        ScalarVector3f d = viewpoint - node.bbox.center();
+        ScalarFloat radius = .5f * dr::norm(node.bbox.extents()),
+                    dist   = dr::norm(d);
+        if (dist <= radius)
+            return true;
+
+        ScalarFloat alpha = unit_angle(d / dist, node.axis),
+                    phi   = dr::asin(radius / dist);
+
+        // Safety margin for rounding errors in the bounds
+        return dr::abs(.5f * dr::Pi<ScalarFloat> - alpha) <=
+               phi + node.theta + 1e-3f;
+    };
+
+    if (!m_sil_tree_nodes.empty()) {
+        std::vector<uint32_t> stack = { 0u };
+        while (!stack.empty()) {
+            const SilhouetteTreeNode &node = m_sil_tree_nodes[stack.back()];
+            uint32_t index = stack.back();
+            stack.pop_back();
+
+            if (!may_contain_silhouette(node))
+                continue;
 
-        UInt32 dedge_oppo = opposite_dedge(dedge_curr);
-        Mask has_opposite = (dedge_oppo != m_invalid_dedge);
+            if (node.count == 0) {
+                stack.push_back(node.offset);
+                stack.push_back(index + 1);
+                continue;
+            }
 
-        auto face_idx_oppo = dr::idiv(dedge_oppo, 3u);
-        Normal3f n_oppo = face_normal(face_idx_oppo, has_opposite);
+            for (uint32_t j = node.offset; j < node.offset + node.count; ++j) {
+                const SilhouetteTreeEdge &edge = m_sil_tree_edges[j];
+                ScalarVector3f to_p0 = dr::normalize(edge.p0 - viewpoint);
+                if (dr::dot(to_p0, edge.n0) * dr::dot(to_p0, edge.n1) <= 0.f &&
+                    dr::abs(dr::dot(edge.n0, edge.n1)) < 1.f)
+                    add_edge(edge);
+            }
+        }
+    }
 
-        Mask greater_dedge_idx = dedge_oppo > dedge_curr;
-        Mask not_flat = dr::abs(dr::dot(n, n_oppo)) < 1.f;
-        Mask only_one_visible_face =
-            dr::dot(to_p0, n) * dr::dot(to_p0, n_oppo) <= 0.f;
+    // Return the edges in a deterministic order (by directed edge index)
+    std::sort(silhouette.begin(), silhouette.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
 
-        Mask valid = !has_opposite || (greater_dedge_idx &&
-                                       only_one_visible_face &&
-                                       not_flat);
+    std::vector<ScalarIndex> indices(silhouette.size());
+    std::vector<ScalarFloat> weights(silhouette.size());
+    for (size_t i = 0; i < silhouette.size(); ++i)
+        std::tie(indices[i], weights[i]) = silhouette[i];
 
-        UInt32 valid_indices = dr::compress(valid);
-        dr::masked(weight, !valid) = 0.f;
-        Float valid_weight = dr::gather<Float>(weight, valid_indices);
+    DynamicBuffer<UInt32> out_indices =
+        dr::load<DynamicBuffer<UInt32>>(indices.data(), indices.size());
+    DynamicBuffer<Float> out_weights =
+        dr::load<DynamicBuffer<Float>>(weights.data(), weights.size());
 
-        return std::make_tuple(valid_indices, valid_weight);
-    }
+    return std::make_tuple(out_indices, out_weights);
 }
 
 MI_VARIANT typename Mesh<Float, Spectrum>::SilhouetteSample3f
@@ -1585,7 +2215,51 @@ MI_VARIANT void Mesh<Float, Spectrum>::add_attribute(const std::string& name,
     }
 
     FloatStorage buffer = dr::load<FloatStorage>(data.data(), count * dim);
-    m_mesh_attributes.insert({ name, { dim, type, buffer } });
+    uint32_t handle = Base::attribute_handle(name);
+    auto it = m_mesh_attributes.insert({ name, { dim, type, buffer, handle } }).first;
+
+    // Pointers to the elements of an unordered map remain valid on insertion
+    if (handle >= m_attribute_slots.size())
+        m_attribute_slots.resize(handle + 1, nullptr);
+    m_attribute_slots[handle] = &it->second;
+
+    if (type == MeshAttributeType::Vertex)
+        build_interleaved_attributes();
+}
+
+MI_VARIANT void Mesh<Float, Spectrum>::build_interleaved_attributes() {
+    if constexpr (!dr::is_jit_v<Float>) {
+        uint32_t stride = 0, count = 0;
+        for (auto &[name, attribute]: m_mesh_attributes) {
+            if (attribute.type != MeshAttributeType::Vertex)
+                continue;
+            attribute.offset = stride;
+            stride += (uint32_t) attribute.size;
+            count++;
+        }
+
+        // A single attribute is already stored contiguously
+        if (count < 2) {
+            m_vertex_attributes_interleaved = FloatStorage();
+            m_vertex_attribute_stride = 0;
+            return;
+        }
+
+        std::unique_ptr<InputFloat[]> data(new InputFloat[m_vertex_count * stride]);
+        for (const auto &[name, attribute]: m_mesh_attributes) {
+            if (attribute.type != MeshAttributeType::Vertex)
+                continue;
+            const InputFloat *src = attribute.buf.data();
+            for (size_t i = 0; i < m_vertex_count; ++i)
+                for (size_t j = 0; j < attribute.size; ++j)
+                    data[i * stride + attribute.offset + j] =
+                        src[i * attribute.size + j];
+        }
+
+        m_vertex_attributes_interleaved =
+            dr::load<FloatStorage>(data.get(), m_vertex_count * stride);
+        m_vertex_attribute_stride = stride;
+    }
 }
 
 MI_VARIANT typename Mesh<Float, Spectrum>::Mask
@@ -1603,12 +2277,67 @@ Mesh<Float, Spectrum>::eval_attribute(const std::string& name,
     const auto& it = m_mesh_attributes.find(name);
     if (it == m_mesh_attributes.end())
         return Base::eval_attribute(name, si, active);
+    return eval_mesh_attribute(it->second, si, active);
+}
+
+MI_VARIANT Float
+Mesh<Float, Spectrum>::eval_attribute_1(const std::string& name,
+                                        const SurfaceInteraction3f &si,
+                                        Mask active) const {
+    const auto& it = m_mesh_attributes.find(name);
+    if (it == m_mesh_attributes.end())
+        return Base::eval_attribute_1(name, si, active);
+    return eval_mesh_attribute_1(it->second, si, active);
+}
+
+MI_VARIANT typename Mesh<Float, Spectrum>::Color3f
+Mesh<Float, Spectrum>::eval_attribute_3(const std::string& name,
+                                        const SurfaceInteraction3f &si,
+                                        Mask active) const {
+    const auto& it = m_mesh_attributes.find(name);
+    if (it == m_mesh_attributes.end())
+        return Base::eval_attribute_3(name, si, active);
+    return eval_mesh_attribute_3(it->second, si, active);
+}
+
+MI_VARIANT typename Mesh<Float, Spectrum>::UnpolarizedSpectrum
+Mesh<Float, Spectrum>::eval_attribute(uint32_t handle,
+                                      const SurfaceInteraction3f &si,
+                                      Mask active) const {
+    const MeshAttribute *attr = attribute_slot(handle);
+    if (!attr)
+        return Base::eval_attribute(Base::attribute_name(handle), si, active);
+    return eval_mesh_attribute(*attr, si, active);
+}
+
+MI_VARIANT Float
+Mesh<Float, Spectrum>::eval_attribute_1(uint32_t handle,
+                                        const SurfaceInteraction3f &si,
+                                        Mask active) const {
+    const MeshAttribute *attr = attribute_slot(handle);
+    if (!attr)
+        return Base::eval_attribute_1(Base::attribute_name(handle), si, active);
+    return eval_mesh_attribute_1(*attr, si, active);
+}
 
-    const auto& attr = it->second;
+MI_VARIANT typename Mesh<Float, Spectrum>::Color3f
+Mesh<Float, Spectrum>::eval_attribute_3(uint32_t handle,
+                                        const SurfaceInteraction3f &si,
+                                        Mask active) const {
+    const MeshAttribute *attr = attribute_slot(handle);
+    if (!attr)
+        return Base::eval_attribute_3(Base::attribute_name(handle), si, active);
+    return eval_mesh_attribute_3(*attr, si, active);
+}
+
+MI_VARIANT typename Mesh<Float, Spectrum>::UnpolarizedSpectrum
+Mesh<Float, Spectrum>::eval_mesh_attribute(const MeshAttribute &attr,
+                                           const SurfaceInteraction3f &si,
+                                           Mask active) const {
     if (attr.size == 1)
-        return interpolate_attribute<1, false>(attr.type, attr.buf, si, active);
+        return interpolate_attribute<1, false>(attr, si, active);
     else if (attr.size == 3) {
-        auto result = interpolate_attribute<3, false>(attr.type, attr.buf, si, active);
+        auto result = interpolate_attribute<3, false>(attr, si, active);
         if constexpr (is_monochromatic_v<Spectrum>)
             return luminance(result);
         else
@@ -1617,45 +2346,38 @@ Mesh<Float, Spectrum>::eval_attribute(const std::string& name,
         if constexpr (dr::is_jit_v<Float>)
             return 0.f;
         else
-            Throw("eval_attribute(): Attribute \"%s\" requested but had size %u.", name, attr.size);
+            Throw("eval_attribute(): Attribute \"%s\" requested but had size %u.",
+                  Base::attribute_name(attr.handle), attr.size);
     }
 }
 
 MI_VARIANT Float
-Mesh<Float, Spectrum>::eval_attribute_1(const std::string& name,
-                                        const SurfaceInteraction3f &si,
-                                        Mask active) const {
-    const auto& it = m_mesh_attributes.find(name);
-    if (it == m_mesh_attributes.end())
-        return Base::eval_attribute_1(name, si, active);
-
-    const auto& attr = it->second;
+Mesh<Float, Spectrum>::eval_mesh_attribute_1(const MeshAttribute &attr,
+                                             const SurfaceInteraction3f &si,
+                                             Mask active) const {
     if (attr.size == 1) {
-        return interpolate_attribute<1, true>(attr.type, attr.buf, si, active);
+        return interpolate_attribute<1, true>(attr, si, active);
     } else {
         if constexpr (dr::is_jit_v<Float>)
             return 0.f;
         else
-            Throw("eval_attribute_1(): Attribute \"%s\" requested but had size %u.", name, attr.size);
+            Throw("eval_attribute_1(): Attribute \"%s\" requested but had size %u.",
+                  Base::attribute_name(attr.handle), attr.size);
     }
 }
 
 MI_VARIANT typename Mesh<Float, Spectrum>::Color3f
-Mesh<Float, Spectrum>::eval_attribute_3(const std::string& name,
-                                        const SurfaceInteraction3f &si,
-                                        Mask active) const {
-    const auto& it = m_mesh_attributes.find(name);
-    if (it == m_mesh_attributes.end())
-        return Base::eval_attribute_3(name, si, active);
-
-    const auto& attr = it->second;
+Mesh<Float, Spectrum>::eval_mesh_attribute_3(const MeshAttribute &attr,
+                                             const SurfaceInteraction3f &si,
+                                             Mask active) const {
     if (attr.size == 3) {
-        return interpolate_attribute<3, true>(attr.type, attr.buf, si, active);
+        return interpolate_attribute<3, true>(attr, si, active);
     } else {
         if constexpr (dr::is_jit_v<Float>)
             return 0.f;
         else
-            Throw("eval_attribute_3(): Attribute \"%s\" requested but had size %u.", name, attr.size);
+            Throw("eval_attribute_3(): Attribute \"%s\" requested but had size %u.",
+                  Base::attribute_name(attr.handle), attr.size);
     }
 }
 
@@ -1797,10 +2519,13 @@ MI_VARIANT std::string Mesh<Float, Spectrum>::to_string() const {
 MI_VARIANT size_t Mesh<Float, Spectrum>::vertex_data_bytes() const {
     size_t vertex_data_bytes = 3 * sizeof(InputFloat);
 
+    size_t normal_size   = m_compact_vertices ? sizeof(uint32_t) : 3 * sizeof(InputFloat),
+           texcoord_size = m_compact_vertices ? sizeof(uint32_t) : 2 * sizeof(InputFloat);
+
     if (has_vertex_normals())
-        vertex_data_bytes += 3 * sizeof(InputFloat);
+        vertex_data_bytes += normal_size;
     if (has_vertex_texcoords())
-        vertex_data_bytes += 2 * sizeof(InputFloat);
+        vertex_data_bytes += texcoord_size;
 
     for (const auto&[name, attribute]: m_mesh_attributes)
         if (attribute.type == MeshAttributeType::Vertex)
@@ -1833,6 +2558,15 @@ MI_VARIANT RTCGeometry Mesh<Float, Spectrum>::embree_geometry(RTCDevice device)
     rtcCommitGeometry(geom);
     return geom;
 }
+
+MI_VARIANT void Mesh<Float, Spectrum>::embree_update_geometry(RTCGeometry geom) {
+    // The vertex buffer may have been reallocated by the update
+    rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3,
+                               m_vertex_positions.data(), 0, 3 * sizeof(InputFloat),
+                               m_vertex_count);
+    rtcUpdateGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0);
+    rtcCommitGeometry(geom);
+}
 #endif
 
 #if defined(MI_ENABLE_CUDA)
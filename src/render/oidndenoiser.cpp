@@ -0,0 +1,326 @@
+#include <mitsuba/render/oidndenoiser.h>
+#include <drjit/dynamic.h>
+#include <nanothread/nanothread.h>
+#include <OpenImageDenoise/oidn.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/// Copy the contents of a (possibly device-resident) array to host memory
+template <typename Array>
+static std::vector<float> host_copy(const Array &array) {
+    std::vector<float> result(dr::width(array));
+    if constexpr (dr::is_jit_v<Array>) {
+        auto &&host = dr::migrate(array, AllocType::Host);
+        dr::sync_thread();
+        std::copy(host.data(), host.data() + result.size(), result.data());
+    } else {
+        std::copy(array.data(), array.data() + result.size(), result.data());
+    }
+    return result;
+}
+
+/// Fetch a transformation that may reside on the device
+MI_VARIANT
+static typename OIDNDenoiser<Float, Spectrum>::ScalarTransform4f
+scalar_transform(const typename OIDNDenoiser<Float, Spectrum>::Transform4f &t) {
+    using ScalarTransform4f = typename OIDNDenoiser<Float, Spectrum>::ScalarTransform4f;
+    using ScalarMatrix4f = typename OIDNDenoiser<Float, Spectrum>::ScalarMatrix4f;
+    if constexpr (dr::is_jit_v<Float>)
+        return ScalarTransform4f(ScalarMatrix4f(dr::slice(t.matrix)),
+                                 ScalarMatrix4f(dr::slice(t.inverse_transpose)));
+    else
+        return t;
+}
+
+/// Share an interleaved host image with an OIDN filter
+static void set_image(OIDNFilter filter, const char *name, float *data,
+                      const ScalarVector2u &size, uint32_t channels) {
+    size_t pixel_stride = channels * sizeof(float);
+    oidnSetSharedFilterImage(filter, name, data, OIDN_FORMAT_FLOAT3,
+                             size.x(), size.y(), 0, pixel_stride,
+                             pixel_stride * size.x());
+}
+
+MI_VARIANT OIDNDenoiser<Float, Spectrum>::OIDNDenoiser(
+    const ScalarVector2u &input_size, bool albedo, bool normals, bool prefilter)
+    : m_input_size(input_size), m_albedo(albedo), m_normals(normals),
+      m_prefilter(prefilter), m_device(nullptr), m_filter(nullptr),
+      m_albedo_filter(nullptr), m_normals_filter(nullptr) {
+    if (normals && !albedo)
+        Throw("The denoiser cannot use normals to guide its process without "
+              "also providing albedo information!");
+
+    m_device = oidnNewDevice(OIDN_DEVICE_TYPE_CPU);
+    if (!m_device)
+        Throw("OIDNDenoiser: could not create a CPU device!");
+
+    // Share the worker threads with Mitsuba, which already pins them
+    oidnSetDeviceInt(m_device, "numThreads", (int) pool_size());
+    oidnSetDeviceBool(m_device, "setAffinity", false);
+    oidnCommitDevice(m_device);
+    check_error();
+
+    m_filter = oidnNewFilter(m_device, "RT");
+    if (prefilter) {
+        if (albedo)
+            m_albedo_filter = oidnNewFilter(m_device, "RT");
+        if (normals)
+            m_normals_filter = oidnNewFilter(m_device, "RT");
+    }
+    check_error();
+}
+
+MI_VARIANT OIDNDenoiser<Float, Spectrum>::~OIDNDenoiser() {
+    if (m_normals_filter)
+        oidnReleaseFilter(m_normals_filter);
+    if (m_albedo_filter)
+        oidnReleaseFilter(m_albedo_filter);
+    if (m_filter)
+        oidnReleaseFilter(m_filter);
+    if (m_device)
+        oidnReleaseDevice(m_device);
+}
+
+MI_VARIANT
+typename OIDNDenoiser<Float, Spectrum>::TensorXf
+OIDNDenoiser<Float, Spectrum>::operator()(const TensorXf &noisy,
+                                          bool denoise_alpha,
+                                          const TensorXf &albedo,
+                                          const TensorXf &normals,
+                                          const Transform4f &to_sensor) const {
+    using TensorArray = typename TensorXf::Array;
+
+    validate_input(noisy, albedo, normals);
+
+    // The output starts out as a copy of the noisy input
+    std::vector<float> output = host_copy(noisy.array()), albedo_host,
+                       normals_host;
+    if (m_albedo)
+        albedo_host = host_copy(albedo.array());
+    if (m_normals)
+        normals_host = host_copy(normals.array());
+
+    denoise(output.data(), (uint32_t) noisy.shape(2), denoise_alpha,
+            m_albedo ? albedo_host.data() : nullptr,
+            m_normals ? normals_host.data() : nullptr,
+            scalar_transform<Float, Spectrum>(to_sensor));
+
+    std::vector<ScalarFloat> values(output.begin(), output.end());
+    size_t shape[3] = { noisy.shape(0), noisy.shape(1), noisy.shape(2) };
+    return TensorXf(dr::load<TensorArray>(values.data(), values.size()), 3,
+                    shape);
+}
+
+MI_VARIANT
+ref<Bitmap> OIDNDenoiser<Float, Spectrum>::operator()(
+    const ref<Bitmap> &noisy, bool denoise_alpha, const std::string &albedo_ch,
+    const std::string &normals_ch, const Transform4f &to_sensor,
+    const std::string &noisy_ch) const {
+    ref<const Bitmap> noisy_bmp;
+    ref<const Bitmap> albedo_bmp;
+    ref<const Bitmap> normals_bmp;
+
+    if (noisy->pixel_format() != Bitmap::PixelFormat::MultiChannel) {
+        noisy_bmp = noisy.get();
+    } else {
+        bool found_albedo = albedo_ch == "";
+        bool found_normals = normals_ch == "";
+
+        // Search for each layer
+        std::vector<std::pair<std::string, ref<Bitmap>>> res = noisy->split();
+        for (auto &layer : res) {
+            if (noisy_bmp == nullptr && layer.first == noisy_ch)
+                noisy_bmp = layer.second.get();
+            if (!found_albedo && layer.first == albedo_ch) {
+                found_albedo = true;
+                albedo_bmp = layer.second.get();
+            }
+            if (!found_normals && layer.first == normals_ch) {
+                found_normals = true;
+                normals_bmp = layer.second.get();
+            }
+        }
+
+        // Check that no layer is missing
+        auto throw_missing_channel = [&](const std::string &channel) {
+            Throw("Could not find layer with channel name '%s' in Bitmap:\n%s",
+                  channel, noisy->to_string());
+        };
+        if (noisy_bmp == nullptr)
+            throw_missing_channel(noisy_ch);
+        if (!found_albedo)
+            throw_missing_channel(albedo_ch);
+        if (!found_normals)
+            throw_missing_channel(normals_ch);
+    }
+
+    if (m_albedo && !albedo_bmp)
+        Throw("The denoiser was created with albedo guiding enabled. An albedo "
+              "channel must be specified!");
+    if (m_normals && !normals_bmp)
+        Throw("The denoiser was created with normals guiding enabled. A normal "
+              "channel must be specified!");
+
+    // Convert every layer to linear single precision values
+    auto to_float = [&](const ref<const Bitmap> &bmp,
+                        size_t channel_count) -> ref<Bitmap> {
+        if (bmp->width() != m_input_size.x() || bmp->height() != m_input_size.y())
+            Throw("The denoiser was created for inputs of size %u x %u (width x "
+                  "height). You must create a new denoiser object for inputs "
+                  "of different sizes!", m_input_size.x(), m_input_size.y());
+        if (bmp->channel_count() != channel_count)
+            Throw("The layers of the bitmap have an unexpected number of "
+                  "channels (%u instead of %u)!", bmp->channel_count(),
+                  channel_count);
+        return bmp->convert(bmp->pixel_format(), Struct::Type::Float32, false);
+    };
+
+    size_t channels = noisy_bmp->channel_count();
+    if (channels != 3 && channels != 4)
+        Throw("The noisy input must have at least 3 channels and at most 4!");
+
+    ref<Bitmap> output = to_float(noisy_bmp, channels), albedo_f, normals_f;
+    if (m_albedo)
+        albedo_f = to_float(albedo_bmp, 3);
+    if (m_normals)
+        normals_f = to_float(normals_bmp, 3);
+
+    denoise((float *) output->data(), (uint32_t) channels, denoise_alpha,
+            m_albedo ? (float *) albedo_f->data() : nullptr,
+            m_normals ? (float *) normals_f->data() : nullptr,
+            scalar_transform<Float, Spectrum>(to_sensor));
+
+    return output;
+}
+
+MI_VARIANT
+void OIDNDenoiser<Float, Spectrum>::denoise(float *color, uint32_t channels,
+                                            bool denoise_alpha, float *albedo,
+                                            float *normals,
+                                            const ScalarTransform4f &to_sensor) const {
+    size_t pixel_count = (size_t) m_input_size.x() * m_input_size.y();
+
+    if (normals) {
+        dr::parallel_for(
+            dr::blocked_range<size_t>(0, pixel_count, 16384),
+            [&](const dr::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    float *n = normals + 3 * i;
+                    ScalarNormal3f value = to_sensor *
+                        ScalarNormal3f((ScalarFloat) n[0], (ScalarFloat) n[1],
+                                       (ScalarFloat) n[2]);
+                    for (size_t j = 0; j < 3; ++j)
+                        n[j] = (float) value[j];
+                }
+            }
+        );
+    }
+
+    // Denoise the guides first, in place
+    if (m_albedo_filter) {
+        set_image(m_albedo_filter, "albedo", albedo, m_input_size, 3);
+        set_image(m_albedo_filter, "output", albedo, m_input_size, 3);
+        oidnCommitFilter(m_albedo_filter);
+        oidnExecuteFilter(m_albedo_filter);
+        check_error();
+    }
+
+    if (m_normals_filter) {
+        set_image(m_normals_filter, "normal", normals, m_input_size, 3);
+        set_image(m_normals_filter, "output", normals, m_input_size, 3);
+        oidnCommitFilter(m_normals_filter);
+        oidnExecuteFilter(m_normals_filter);
+        check_error();
+    }
+
+    // Copy the alpha channel, which OIDN can only denoise as a color image
+    std::vector<float> alpha;
+    if (channels == 4 && denoise_alpha) {
+        alpha.resize(pixel_count * 3);
+        for (size_t i = 0; i < pixel_count; ++i)
+            alpha[3 * i] = alpha[3 * i + 1] = alpha[3 * i + 2] = color[4 * i + 3];
+    }
+
+    set_image(m_filter, "color", color, m_input_size, channels);
+    set_image(m_filter, "output", color, m_input_size, channels);
+    if (albedo)
+        set_image(m_filter, "albedo", albedo, m_input_size, 3);
+    if (normals)
+        set_image(m_filter, "normal", normals, m_input_size, 3);
+    oidnSetFilterBool(m_filter, "hdr", true);
+    oidnSetFilterBool(m_filter, "cleanAux", m_prefilter);
+    oidnCommitFilter(m_filter);
+    oidnExecuteFilter(m_filter);
+    check_error();
+
+    if (!alpha.empty()) {
+        OIDNFilter filter = oidnNewFilter(m_device, "RT");
+        set_image(filter, "color", alpha.data(), m_input_size, 3);
+        set_image(filter, "output", alpha.data(), m_input_size, 3);
+        oidnCommitFilter(filter);
+        oidnExecuteFilter(filter);
+        oidnReleaseFilter(filter);
+        check_error();
+
+        for (size_t i = 0; i < pixel_count; ++i)
+            color[4 * i + 3] = alpha[3 * i];
+    }
+}
+
+MI_VARIANT void OIDNDenoiser<Float, Spectrum>::check_error() const {
+    const char *message = nullptr;
+    if (oidnGetDeviceError(m_device, &message) != OIDN_ERROR_NONE)
+        Throw("OIDNDenoiser: %s", message ? message : "unknown error");
+}
+
+MI_VARIANT
+std::string OIDNDenoiser<Float, Spectrum>::to_string() const {
+    std::ostringstream oss;
+    oss << "OIDNDenoiser[" << std::endl
+        << "  input_size = " << m_input_size << "," << std::endl
+        << "  albedo = " << m_albedo << "," << std::endl
+        << "  normals = " << m_normals << "," << std::endl
+        << "  prefilter = " << m_prefilter << std::endl
+        << "]";
+    return oss.str();
+}
+
+MI_VARIANT
+void OIDNDenoiser<Float, Spectrum>::validate_input(
+    const TensorXf &noisy, const TensorXf &albedo,
+    const TensorXf &normals) const {
+    if ((albedo.ndim() == 0) && m_albedo)
+        Throw("The denoiser was created with albedo guiding enabled. An albedo "
+              "layer must be specified!");
+    if ((normals.ndim() == 0) && m_normals)
+        Throw("The denoiser was created with normals guiding enabled. A normal "
+              "layer must be specified!");
+
+    auto check_resolution = [](const TensorXf &tensor,
+                               const ScalarVector2u &expected_size) {
+        if (tensor.ndim() != 0 && (tensor.ndim() != 3 ||
+                                   expected_size.x() != tensor.shape(1) ||
+                                   expected_size.y() != tensor.shape(0)))
+            Throw(
+                "The denoiser was created for inputs of size %u x %u (width x "
+                "height). At least one of the input arguments does not have "
+                "this size. You must create a new denoiser object for inputs "
+                "of different sizes!",
+                expected_size.x(), expected_size.y());
+    };
+    check_resolution(noisy, m_input_size);
+    check_resolution(albedo, m_input_size);
+    check_resolution(normals, m_input_size);
+
+    if (noisy.ndim() != 3 || (noisy.shape(2) != 3 && noisy.shape(2) != 4))
+        Throw("The noisy input must have at least 3 channels and at most 4!");
+    if (m_albedo && (albedo.shape(2) != 3))
+        Throw("The albedo must have exactly 3 channels!");
+    if (m_normals && (normals.shape(2) != 3))
+        Throw("The normals must have exactly 3 channels!");
+}
+
+MI_IMPLEMENT_CLASS_VARIANT(OIDNDenoiser, Object, "denoiser")
+MI_INSTANTIATE_CLASS(OIDNDenoiser)
+
+NAMESPACE_END(mitsuba)
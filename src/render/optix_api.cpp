@@ -1,6 +1,11 @@
 #if defined(MI_ENABLE_CUDA)
 
 #include <mitsuba/core/logger.h>
+#include <mitsuba/core/memory.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include <drjit-core/optix.h>
 #define OPTIX_API_IMPL
@@ -21,6 +26,7 @@ void optix_initialize() {
     L(optixAccelBuild);
     L(optixAccelCompact);
     L(optixBuiltinISModuleGet);
+    L(optixConvertPointerToTraversableHandle);
     L(optixDenoiserCreate);
     L(optixDenoiserDestroy);
     L(optixDenoiserComputeMemoryResources);
@@ -32,6 +38,8 @@ void optix_initialize() {
     L(optixTaskExecute);
     L(optixProgramGroupCreate);
     L(optixSbtRecordPackHeader);
+    L(optixDeviceContextSetCacheEnabled);
+    L(optixDeviceContextSetCacheLocation);
 
     #undef L
 }
@@ -44,6 +52,152 @@ scoped_optix_context::~scoped_optix_context() {
     jit_cuda_pop_context();
 }
 
+static std::mutex builtin_spheres_mutex;
+static std::unordered_map<int, bool> builtin_spheres_support;
+
+bool optix_builtin_spheres() {
+    int device = jit_cuda_device();
+
+    std::lock_guard<std::mutex> guard(builtin_spheres_mutex);
+    auto it = builtin_spheres_support.find(device);
+    if (it != builtin_spheres_support.end())
+        return it->second;
+
+    optix_initialize();
+    scoped_optix_context context_guard;
+
+    /* The built-in intersection module for spheres only exists in OptiX 7.5
+       and later, hence failing to load it means that the driver (or the ABI
+       version requested by Dr.Jit) doesn't support built-in spheres */
+    OptixModuleCompileOptions module_compile_options { };
+    OptixPipelineCompileOptions pipeline_compile_options { };
+    pipeline_compile_options.numPayloadValues   = 6;
+    pipeline_compile_options.numAttributeValues = 2;
+    pipeline_compile_options.pipelineLaunchParamsVariableName = "params";
+    pipeline_compile_options.traversableGraphFlags =
+        OPTIX_TRAVERSABLE_GRAPH_FLAG_ALLOW_ANY;
+    pipeline_compile_options.usesPrimitiveTypeFlags =
+        OPTIX_PRIMITIVE_TYPE_FLAGS_SPHERE;
+
+    OptixBuiltinISOptions options = {};
+    options.builtinISModuleType = OPTIX_PRIMITIVE_TYPE_SPHERE;
+    options.buildFlags          = OPTIX_BUILD_FLAG_ALLOW_COMPACTION |
+                                  OPTIX_BUILD_FLAG_PREFER_FAST_TRACE;
+
+    OptixModule module = nullptr;
+    bool supported =
+        optixBuiltinISModuleGet(jit_optix_context(), &module_compile_options,
+                                &pipeline_compile_options, &options,
+                                &module) == 0;
+
+    Log(Debug, "OptiX: built-in spheres are %ssupported on CUDA device %i.",
+        supported ? "" : "not ", device);
+
+    builtin_spheres_support[device] = supported;
+    return supported;
+}
+
+static std::mutex disk_cache_mutex;
+static std::unordered_map<int, std::pair<bool, std::string>> disk_cache_settings;
+
+void optix_configure_disk_cache(bool enabled, const std::string &path) {
+    int device = jit_cuda_device();
+
+    std::lock_guard<std::mutex> guard(disk_cache_mutex);
+    auto it = disk_cache_settings.find(device);
+    if (it != disk_cache_settings.end() &&
+        it->second == std::make_pair(enabled, path))
+        return;
+
+    optix_initialize();
+    OptixDeviceContext context = jit_optix_context();
+
+    /* Failing to set up the cache (e.g. an unwritable directory) only slows
+       down the compilation, hence this isn't treated as an error */
+    if (enabled && !path.empty() &&
+        optixDeviceContextSetCacheLocation(context, path.c_str()) != 0)
+        Log(Warn, "OptiX: could not move the disk cache to \"%s\"!", path);
+    if (optixDeviceContextSetCacheEnabled(context, enabled ? 1 : 0) != 0)
+        Log(Warn, "OptiX: could not %s the disk cache!",
+            enabled ? "enable" : "disable");
+
+    Log(Debug, "OptiX: disk cache %s on CUDA device %i%s.",
+        enabled ? "enabled" : "disabled", device,
+        enabled && !path.empty() ? (" (\"" + path + "\")").c_str() : "");
+    disk_cache_settings[device] = { enabled, path };
+}
+
+struct GASCacheEntry {
+    uint64_t key;
+    OptixTraversableHandle handle;
+    size_t size;
+    uint32_t ref_count;
+};
+
+static std::mutex gas_cache_mutex;
+static std::unordered_map<uint64_t, void *> gas_cache_keys;
+static std::unordered_map<void *, GASCacheEntry> gas_cache;
+
+void *optix_gas_cache_acquire(uint64_t key, OptixTraversableHandle *handle) {
+    std::lock_guard<std::mutex> guard(gas_cache_mutex);
+    auto it = gas_cache_keys.find(key);
+    if (it == gas_cache_keys.end())
+        return nullptr;
+    GASCacheEntry &entry = gas_cache[it->second];
+    entry.ref_count++;
+    *handle = entry.handle;
+    return it->second;
+}
+
+void optix_gas_cache_insert(uint64_t key, void *buffer,
+                            OptixTraversableHandle handle, size_t size) {
+    std::lock_guard<std::mutex> guard(gas_cache_mutex);
+    if (gas_cache_keys.find(key) != gas_cache_keys.end())
+        Throw("optix_gas_cache_insert(): duplicate key %016llx!",
+              (unsigned long long) key);
+    gas_cache_keys[key] = buffer;
+    gas_cache[buffer] = GASCacheEntry{ key, handle, size, 1 };
+    MemoryTracker::allocate(MemoryCategory::OptiX, size, true);
+}
+
+void optix_gas_cache_release(void *buffer) {
+    std::lock_guard<std::mutex> guard(gas_cache_mutex);
+    auto it = gas_cache.find(buffer);
+    if (it == gas_cache.end())
+        Throw("optix_gas_cache_release(): unknown buffer!");
+    if (--it->second.ref_count == 0) {
+        MemoryTracker::release(MemoryCategory::OptiX, it->second.size, true);
+        gas_cache_keys.erase(it->second.key);
+        gas_cache.erase(it);
+        jit_free(buffer);
+    }
+}
+
+std::pair<size_t, size_t> optix_gas_cache_usage() {
+    std::lock_guard<std::mutex> guard(gas_cache_mutex);
+    size_t size = 0;
+    for (auto &[buffer, entry] : gas_cache)
+        size += entry.size;
+    return { gas_cache.size(), size };
+}
+
+uint64_t optix_hash_device_memory(uint64_t hash, const void *ptr, size_t size) {
+    const size_t chunk_size = 16 * 1024 * 1024;
+    std::unique_ptr<uint8_t[]> chunk(new uint8_t[std::min(size, chunk_size)]);
+
+    for (size_t offset = 0; offset < size; offset += chunk_size) {
+        size_t count = std::min(size - offset, chunk_size);
+        jit_memcpy(JitBackend::CUDA, chunk.get(),
+                   (const uint8_t *) ptr + offset, count);
+        for (size_t i = 0; i < count; ++i) {
+            hash ^= chunk[i];
+            hash *= 0x100000001b3ull;
+        }
+    }
+
+    return hash;
+}
+
 NAMESPACE_END(mitsuba)
 
 #endif // defined(MI_ENABLE_CUDA)
@@ -33,7 +33,7 @@ MI_PY_EXPORT(BSDFSample) {
 MI_VARIANT class PyBSDF : public BSDF<Float, Spectrum> {
 public:
     MI_IMPORT_TYPES(BSDF)
-    NB_TRAMPOLINE(BSDF, 12);
+    NB_TRAMPOLINE(BSDF, 13);
 
     PyBSDF(const Properties &props) : BSDF(props) { }
 
@@ -103,6 +103,17 @@ public:
         NB_OVERRIDE(parameters_changed, keys);
     }
 
+    /* The surface interaction fields read by BSDFs implemented in Python are
+       unknown, hence all of them are requested unless the method is overridden */
+    uint32_t ray_flags() const override {
+        nanobind::detail::ticket nb_ticket(nb_trampoline, "ray_flags", false);
+        if (nb_ticket.key.is_valid())
+            return nanobind::cast<uint32_t>(
+                nb_trampoline.base().attr(nb_ticket.key)());
+        else
+            return +RayFlags::All;
+    }
+
     using BSDF::m_flags;
     using BSDF::m_components;
 };
@@ -186,6 +197,7 @@ MI_PY_EXPORT(BSDF) {
             "index"_a, "active"_a = true, D(BSDF, flags, 2))
         .def_method(BSDF, component_count, "active"_a = true)
         .def_method(BSDF, id)
+        .def_method(BSDF, ray_flags)
         .def_field(PyBSDF, m_flags, D(BSDF, m_flags))
         .def_field(PyBSDF, m_components, D(BSDF, m_components))
         .def("__repr__", &BSDF::to_string, D(BSDF, to_string));
@@ -50,6 +50,11 @@ public:
         NB_OVERRIDE_PURE(pdf_position, ps, active);
     }
 
+    Float pdf_ray_direction(const PositionSample3f &ps, const Vector3f &d,
+                            Mask active) const override {
+        NB_OVERRIDE(pdf_ray_direction, ps, d, active);
+    }
+
     Spectrum eval(const SurfaceInteraction3f &si, Mask active) const override {
         NB_OVERRIDE_PURE(eval, si, active);
     }
@@ -129,6 +134,12 @@ template <typename Ptr, typename Cls> void bind_emitter_generic(Cls &cls) {
             },
             "ps"_a, "active"_a = true,
             D(Endpoint, pdf_position))
+    .def("pdf_ray_direction",
+            [](Ptr ptr, const PositionSample3f &ps, const Vector3f &d, Mask active) {
+                return ptr->pdf_ray_direction(ps, d, active);
+            },
+            "ps"_a, "d"_a, "active"_a = true,
+            D(Endpoint, pdf_ray_direction))
     .def("eval",
             [](Ptr ptr, const SurfaceInteraction3f &si, Mask active) {
                 return ptr->eval(si, active);
@@ -160,6 +171,9 @@ MI_PY_EXPORT(Emitter) {
         .def_method(Emitter, is_environment)
         .def_method(Emitter, sampling_weight)
         .def_method(Emitter, flags, "active"_a = true)
+        .def_method(Emitter, training_spp)
+        .def_method(Emitter, set_training, "training"_a)
+        .def_method(Emitter, training)
         .def_field(PyEmitter, m_needs_sample_2, D(Endpoint, m_needs_sample_2))
         .def_field(PyEmitter, m_needs_sample_3, D(Endpoint, m_needs_sample_3))
         .def_field(PyEmitter, m_flags, D(Emitter, m_flags));
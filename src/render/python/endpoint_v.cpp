@@ -18,9 +18,11 @@ MI_PY_EXPORT(Endpoint) {
         .def_method(Endpoint, eval_direction, "it"_a, "ds"_a, "active"_a = true)
         .def_method(Endpoint, sample_position, "ref"_a, "ds"_a, "active"_a = true)
         .def_method(Endpoint, pdf_position, "ps"_a, "active"_a = true)
+        .def_method(Endpoint, pdf_ray_direction, "ps"_a, "d"_a, "active"_a = true)
         .def_method(Endpoint, eval, "si"_a, "active"_a = true)
         .def_method(Endpoint, sample_wavelengths, "si"_a, "sample"_a, "active"_a = true)
         .def_method(Endpoint, world_transform)
+        .def_method(Endpoint, set_world_transform, "to_world"_a)
         .def_method(Endpoint, needs_sample_2)
         .def_method(Endpoint, needs_sample_3)
         .def("get_shape",  nb::overload_cast<>(&Endpoint::shape, nb::const_),  D(Endpoint, shape))
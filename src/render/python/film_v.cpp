@@ -1,6 +1,7 @@
 #include <nanobind/nanobind.h> // Needs to be first, to get `ref<T>` caster
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/filesystem.h>
+#include <mitsuba/core/stream.h>
 #include <mitsuba/render/film.h>
 #include <mitsuba/render/imageblock.h>
 #include <mitsuba/core/rfilter.h>
@@ -8,6 +9,7 @@
 #include <mitsuba/render/spiral.h>
 #include <mitsuba/python/python.h>
 #include <nanobind/trampoline.h>
+#include <nanobind/stl/pair.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 #include <drjit/python.h>
@@ -16,7 +18,7 @@
 MI_VARIANT class PyFilm : public Film<Float, Spectrum> {
 public:
     MI_IMPORT_TYPES(Film, ImageBlock)
-    NB_TRAMPOLINE(Film, 11);
+    NB_TRAMPOLINE(Film, 13);
 
     PyFilm(const Properties &props) : Film(props) { }
 
@@ -52,6 +54,22 @@ public:
         NB_OVERRIDE_PURE(schedule_storage);
     }
 
+    void write_storage(Stream *stream) const override {
+        NB_OVERRIDE(write_storage, stream);
+    }
+
+    void read_storage(Stream *stream, bool accumulate = false) override {
+        NB_OVERRIDE(read_storage, stream, accumulate);
+    }
+
+    bool streaming() const override {
+        NB_OVERRIDE(streaming);
+    }
+
+    void flush_rows(uint32_t y) override {
+        NB_OVERRIDE(flush_rows, y);
+    }
+
     void prepare_sample(const UnpolarizedSpectrum &spec,
                         const Wavelength &wavelengths,
                         Float* aovs, Float weight = 1.f,
@@ -90,10 +108,22 @@ MI_PY_EXPORT(Film) {
         .def(nb::init<const Properties &>(), "props"_a)
         .def_method(Film, prepare, "aovs"_a)
         .def_method(Film, put_block, "block"_a)
+        .def_method(Film, put_tile, "block"_a)
         .def_method(Film, clear)
-        .def_method(Film, develop, "raw"_a = false)
-        .def_method(Film, bitmap, "raw"_a = false)
-        .def_method(Film, write, "path"_a)
+        .def_method(Film, write_storage, "stream"_a)
+        .def_method(Film, read_storage, "stream"_a, "accumulate"_a = false)
+        .def_method(Film, streaming)
+        .def_method(Film, flush_rows, "y"_a)
+        .def_method(Film, develop, "raw"_a = false,
+                    nb::call_guard<nb::gil_scoped_release>())
+        .def_method(Film, develop_region, "offset"_a, "size"_a, "raw"_a = false)
+        .def_method(Film, develop_dirty)
+        .def_method(Film, bitmap, "raw"_a = false,
+                    nb::call_guard<nb::gil_scoped_release>())
+        .def_method(Film, write, "path"_a,
+                    nb::call_guard<nb::gil_scoped_release>())
+        .def_method(Film, write_async, "path"_a,
+                    nb::call_guard<nb::gil_scoped_release>())
         .def_method(Film, sample_border)
         .def_method(Film, base_channels_count)
         // Make sure to return a copy of those members as they might also be
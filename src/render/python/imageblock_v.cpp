@@ -52,6 +52,9 @@ MI_PY_EXPORT(ImageBlock) {
         .def_method(ImageBlock, set_coalesce)
         .def_method(ImageBlock, compensate)
         .def_method(ImageBlock, set_compensate)
+        .def_method(ImageBlock, partial_images)
+        .def_method(ImageBlock, set_partial_images, "count"_a,
+                    "memory_limit"_a = 256ull * 1024 * 1024)
         .def_method(ImageBlock, width)
         .def_method(ImageBlock, height)
         .def_method(ImageBlock, rfilter)
@@ -0,0 +1,40 @@
+#include <mitsuba/render/integrator.h>
+#include <mitsuba/python/python.h>
+#include <nanobind/stl/string.h>
+
+MI_PY_EXPORT(RenderStatistics) {
+    nb::enum_<RenderCounter>(m, "RenderCounter", D(RenderCounter))
+        .value("Samples", RenderCounter::Samples, D(RenderCounter, Samples))
+        .value("Paths", RenderCounter::Paths, D(RenderCounter, Paths))
+        .value("PathVertices", RenderCounter::PathVertices, D(RenderCounter, PathVertices))
+        .value("Escaped", RenderCounter::Escaped, D(RenderCounter, Escaped))
+        .value("RussianRoulette", RenderCounter::RussianRoulette, D(RenderCounter, RussianRoulette))
+        .value("MaxDepth", RenderCounter::MaxDepth, D(RenderCounter, MaxDepth))
+        .value("Absorbed", RenderCounter::Absorbed, D(RenderCounter, Absorbed))
+        .value("ExtensionRays", RenderCounter::ExtensionRays, D(RenderCounter, ExtensionRays))
+        .value("ShadowRays", RenderCounter::ShadowRays, D(RenderCounter, ShadowRays));
+
+    nb::enum_<PathTermination>(m, "PathTermination", D(PathTermination))
+        .value("Escaped", PathTermination::Escaped, D(PathTermination, Escaped))
+        .value("RussianRoulette", PathTermination::RussianRoulette, D(PathTermination, RussianRoulette))
+        .value("MaxDepth", PathTermination::MaxDepth, D(PathTermination, MaxDepth))
+        .value("Absorbed", PathTermination::Absorbed, D(PathTermination, Absorbed));
+
+    nb::class_<RenderStatistics>(m, "RenderStatistics", D(RenderStatistics))
+        .def(nb::init<>())
+        .def_rw("max_path_length", &RenderStatistics::max_path_length, D(RenderStatistics, max_path_length))
+        .def_rw("time", &RenderStatistics::time, D(RenderStatistics, time))
+        .def_method(RenderStatistics, counter, "counter"_a)
+        .def_method(RenderStatistics, samples_per_second)
+        .def_method(RenderStatistics, average_path_length)
+        .def_method(RenderStatistics, shadow_ray_ratio)
+        .def_static_method(RenderStatistics, set_enabled, "enabled"_a)
+        .def_static_method(RenderStatistics, enabled)
+        .def("__repr__", &RenderStatistics::to_string);
+
+    nb::class_<RayCapture>(m, "RayCapture", D(RayCapture))
+        .def_static_method(RayCapture, start, "filename"_a, "interval"_a = 1,
+                           "max_rays"_a = 1 << 22)
+        .def_static_method(RayCapture, stop)
+        .def_static_method(RayCapture, enabled);
+}
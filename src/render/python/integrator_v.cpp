@@ -303,6 +303,12 @@ MI_PY_EXPORT(Integrator) {
             "seed"_a = 0, "spp"_a = 0, "develop"_a = true, "evaluate"_a = true)
         .def_method(Integrator, cancel)
         .def_method(Integrator, should_stop)
+        .def_method(Integrator, budget_exhausted)
+        .def_method(Integrator, passes_completed)
+        .def_method(Integrator, render_statistics)
+        .def_method(Integrator, set_checkpoint, "path"_a,
+                    "interval"_a = -1.f, "resume"_a = false)
+        .def_method(Integrator, set_partition, "index"_a, "count"_a)
         .def_method(Integrator, aov_names);
 
     MI_PY_TRAMPOLINE_CLASS(PySamplingIntegrator, SamplingIntegrator, Integrator)
@@ -13,7 +13,7 @@
 MI_VARIANT class PyMedium : public Medium<Float, Spectrum> {
 public:
     MI_IMPORT_TYPES(Medium, Sampler, Scene)
-    NB_TRAMPOLINE(Medium, 6);
+    NB_TRAMPOLINE(Medium, 7);
 
     PyMedium(const Properties &props) : Medium(props) {}
 
@@ -25,6 +25,10 @@ public:
         NB_OVERRIDE_PURE(get_majorant, mi, active);
     }
 
+    UnpolarizedSpectrum get_control_extinction(const MediumInteraction3f &mi, Mask active = true) const override {
+        NB_OVERRIDE(get_control_extinction, mi, active);
+    }
+
     std::tuple<UnpolarizedSpectrum, UnpolarizedSpectrum, UnpolarizedSpectrum>
     get_scattering_coefficients(const MediumInteraction3f &mi, Mask active = true) const override {
         NB_OVERRIDE_PURE(get_scattering_coefficients, mi, active);
@@ -69,15 +73,23 @@ template <typename Ptr, typename Cls> void bind_medium_generic(Cls &cls) {
                 return ptr->get_majorant(mi, active); },
             "mi"_a, "active"_a=true,
             D(Medium, get_majorant))
+       .def("get_control_extinction",
+            [](Ptr ptr, const MediumInteraction3f &mi, Mask active) {
+                return ptr->get_control_extinction(mi, active); },
+            "mi"_a, "active"_a=true,
+            D(Medium, get_control_extinction))
        .def("intersect_aabb",
             [](Ptr ptr, const Ray3f &ray) {
                 return ptr->intersect_aabb(ray); },
             "ray"_a,
             D(Medium, intersect_aabb))
        .def("sample_interaction",
-            [](Ptr ptr, const Ray3f &ray, Float sample, UInt32 channel, Mask active) {
-                return ptr->sample_interaction(ray, sample, channel, active); },
-            "ray"_a, "sample"_a, "channel"_a, "active"_a,
+            [](Ptr ptr, const Ray3f &ray, Float sample, UInt32 channel, Mask active,
+               Float majorant_offset, UInt32 depth) {
+                return ptr->sample_interaction(ray, sample, channel, active,
+                                               majorant_offset, depth); },
+            "ray"_a, "sample"_a, "channel"_a, "active"_a, "majorant_offset"_a = 0.f,
+            "depth"_a = 0,
             D(Medium, sample_interaction))
        .def("transmittance_eval_pdf",
             [](Ptr ptr, const MediumInteraction3f &mi,
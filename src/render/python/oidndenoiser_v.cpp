@@ -0,0 +1,50 @@
+#if defined(MI_ENABLE_OIDN)
+
+#include <nanobind/nanobind.h>
+#include <mitsuba/render/oidndenoiser.h>
+#include <mitsuba/python/python.h>
+
+#include <nanobind/stl/string.h>
+
+MI_PY_EXPORT(OIDNDenoiser) {
+    MI_PY_IMPORT_TYPES(OIDNDenoiser)
+    MI_PY_CLASS(OIDNDenoiser, Object)
+        .def(nb::init<const ScalarVector2u &, bool, bool, bool>(),
+             "input_size"_a, "albedo"_a = false, "normals"_a = false,
+             "prefilter"_a = false, D(OIDNDenoiser, OIDNDenoiser))
+        .def(
+            "__call__",
+            [](const OIDNDenoiser &denoiser, const TensorXf &noisy,
+               bool denoise_alpha, const TensorXf &albedo,
+               const TensorXf &normals, const nb::object &transform) {
+                Transform4f to_sensor;
+                if (!transform.is(nb::none()))
+                    to_sensor = nb::cast<Transform4f>(transform);
+
+                nb::gil_scoped_release release;
+                return denoiser(noisy, denoise_alpha, albedo, normals,
+                                to_sensor);
+            },
+            "noisy"_a, "denoise_alpha"_a = true, "albedo"_a = TensorXf(),
+            "normals"_a = TensorXf(), "to_sensor"_a = nb::none(),
+            D(OIDNDenoiser, operator_call))
+        .def(
+            "__call__",
+            [](const OIDNDenoiser &denoiser, const ref<Bitmap> &noisy,
+               bool denoise_alpha, const std::string &albedo_ch,
+               const std::string &normals_ch, const nb::object &transform,
+               const std::string &noisy_ch) {
+                Transform4f to_sensor;
+                if (!transform.is(nb::none()))
+                    to_sensor = nb::cast<Transform4f>(transform);
+
+                nb::gil_scoped_release release;
+                return denoiser(noisy, denoise_alpha, albedo_ch, normals_ch,
+                                to_sensor, noisy_ch);
+            },
+            "noisy"_a, "denoise_alpha"_a = true, "albedo_ch"_a = "",
+            "normals_ch"_a = "", "to_sensor"_a = nb::none(),
+            "noisy_ch"_a = "<root>", D(OIDNDenoiser, operator_call, 2));
+}
+
+#endif // defined(MI_ENABLE_OIDN)
@@ -62,6 +62,10 @@ MI_PY_EXPORT(Sampler) {
         .def_method(Sampler, set_sample_count, "spp"_a)
         .def_method(Sampler, advance)
         .def_method(Sampler, schedule_state)
+        .def_method(Sampler, set_film_width, "width"_a)
+        .def_method(Sampler, film_width)
+        .def_method(Sampler, compact, "index"_a)
+        .def_method(Sampler, expand, "compacted"_a, "index"_a)
         .def_method(Sampler, seed, "seed"_a, "wavefront_size"_a = (uint32_t) -1)
         .def_method(Sampler, next_1d, "active"_a = true)
         .def_method(Sampler, next_2d, "active"_a = true);
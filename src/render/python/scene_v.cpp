@@ -64,15 +64,38 @@ MI_PY_EXPORT(Scene) {
         .def("ray_test",
              nb::overload_cast<const Ray3f &, Mask, Mask>(&Scene::ray_test, nb::const_),
              "ray"_a, "coherent"_a, "active"_a = true, D(Scene, ray_test, 2))
+        .def("ray_test_multi",
+             [](const Scene &scene, const std::vector<Ray3f> &rays, const Mask &active) {
+                 size_t count = rays.size();
+                 std::unique_ptr<Mask[]> active_v(new Mask[count]),
+                                         result(new Mask[count]);
+                 for (size_t i = 0; i < count; ++i)
+                     active_v[i] = active;
+                 scene.ray_test_multi(rays.data(), active_v.get(), result.get(), count);
+
+                 nb::list list;
+                 for (size_t i = 0; i < count; ++i)
+                     list.append(nb::cast(result[i]));
+                 return list;
+             },
+             "rays"_a, "active"_a = true, D(Scene, ray_test_multi))
 #if !defined(MI_ENABLE_EMBREE)
         .def("ray_intersect_naive",
             &Scene::ray_intersect_naive,
             "ray"_a, "active"_a = true)
 #endif
-        .def("sample_emitter", &Scene::sample_emitter,
+        .def("sample_emitter",
+             nb::overload_cast<Float, Mask>(&Scene::sample_emitter, nb::const_),
              "sample"_a, "active"_a = true, D(Scene, sample_emitter))
-        .def("pdf_emitter", &Scene::pdf_emitter,
+        .def("sample_emitter",
+             nb::overload_cast<const Interaction3f &, Float, Mask>(&Scene::sample_emitter, nb::const_),
+             "ref"_a, "sample"_a, "active"_a = true, D(Scene, sample_emitter, 2))
+        .def("pdf_emitter",
+             nb::overload_cast<UInt32, Mask>(&Scene::pdf_emitter, nb::const_),
              "index"_a, "active"_a = true, D(Scene, pdf_emitter))
+        .def("pdf_emitter",
+             nb::overload_cast<const Interaction3f &, UInt32, Mask>(&Scene::pdf_emitter, nb::const_),
+             "ref"_a, "index"_a, "active"_a = true, D(Scene, pdf_emitter, 2))
         .def("sample_emitter_direction", &Scene::sample_emitter_direction,
              "ref"_a, "sample"_a, "test_visibility"_a = true, "active"_a = true,
              D(Scene, sample_emitter_direction))
@@ -108,7 +131,10 @@ MI_PY_EXPORT(Scene) {
         .def("sensors_dr", &Scene::sensors_dr, D(Scene, sensors_dr))
         .def("emitters", nb::overload_cast<>(&Scene::emitters), D(Scene, emitters))
         .def("emitters_dr", &Scene::emitters_dr, D(Scene, emitters_dr))
+        .def_method(Scene, ray_flags)
         .def_method(Scene, environment)
+        .def_method(Scene, emitter_training_spp)
+        .def_method(Scene, set_emitter_training, "training"_a)
         .def("shapes",
              [](const Scene &scene) {
                  nb::list result;
@@ -151,5 +177,6 @@ MI_PY_EXPORT(Scene) {
              },
              D(Scene, integrator))
         .def_method(Scene, shapes_grad_enabled)
+        .def_method(Scene, structure_version)
         .def("__repr__", &Scene::to_string);
 }
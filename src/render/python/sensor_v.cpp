@@ -5,6 +5,7 @@
 #include <nanobind/trampoline.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/pair.h>
+#include <nanobind/stl/vector.h>
 #include <drjit/python.h>
 
 /// Trampoline for derived types implemented in Python
@@ -168,7 +169,9 @@ MI_PY_EXPORT(Sensor) {
         .def(nb::init<const Properties&>())
         .def_method(Sensor, shutter_open)
         .def_method(Sensor, shutter_open_time)
+        .def_method(Sensor, set_shutter_open, "time"_a)
         .def_method(Sensor, needs_aperture_sample)
+        .def_method(Sensor, sub_sensors)
         .def("film", nb::overload_cast<>(&Sensor::film, nb::const_), D(Sensor, film))
         .def("sampler", nb::overload_cast<>(&Sensor::sampler, nb::const_), D(Sensor, sampler))
         .def_field(PySensor, m_needs_sample_2, D(Endpoint, m_needs_sample_3))
@@ -1,5 +1,6 @@
 #include <mitsuba/core/stream.h>
 #include <mitsuba/core/struct.h>
+#include <mitsuba/core/plugin.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/emitter.h>
@@ -9,6 +10,7 @@
 #include <mitsuba/render/shape.h>
 #include <mitsuba/python/python.h>
 #include <nanobind/trampoline.h>
+#include <nanobind/stl/pair.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 #include <nanobind/stl/tuple.h>
@@ -125,6 +127,24 @@ template <typename Ptr, typename Cls> void bind_shape_generic(Cls &cls) {
                 return shape->eval_attribute_3(name, si, active);
             },
             "name"_a, "si"_a, "active"_a = true, D(Shape, eval_attribute_3))
+       .def("eval_attribute",
+            [](Ptr shape, uint32_t handle,
+               const SurfaceInteraction3f &si, const Mask &active) {
+                return shape->eval_attribute(handle, si, active);
+            },
+            "handle"_a, "si"_a, "active"_a = true, D(Shape, eval_attribute, 2))
+       .def("eval_attribute_1",
+            [](Ptr shape, uint32_t handle,
+               const SurfaceInteraction3f &si, const Mask &active) {
+                return shape->eval_attribute_1(handle, si, active);
+            },
+            "handle"_a, "si"_a, "active"_a = true, D(Shape, eval_attribute_1, 2))
+       .def("eval_attribute_3",
+            [](Ptr shape, uint32_t handle,
+               const SurfaceInteraction3f &si, const Mask &active) {
+                return shape->eval_attribute_3(handle, si, active);
+            },
+            "handle"_a, "si"_a, "active"_a = true, D(Shape, eval_attribute_3, 2))
        .def("ray_intersect_preliminary",
             [](Ptr shape, const Ray3f &ray, uint32_t prim_index, const Mask &active) {
                 return shape->ray_intersect_preliminary(ray, prim_index, active);
@@ -289,7 +309,7 @@ template <typename Ptr, typename Cls> void bind_mesh_generic(Cls &cls) {
 }
 
 MI_PY_EXPORT(Shape) {
-    MI_PY_IMPORT_TYPES(Shape, Mesh)
+    MI_PY_IMPORT_TYPES(Shape, Mesh, BSDF)
 
     auto shape = MI_PY_CLASS(Shape, Object)
         .def("bbox", nb::overload_cast<>(
@@ -300,10 +320,19 @@ MI_PY_EXPORT(Shape) {
             &Shape::bbox, nb::const_), D(Shape, bbox, 3), "index"_a, "clip"_a)
         .def_method(Shape, id)
         .def_method(Shape, is_mesh)
+        .def_method(Shape, has_motion)
+        .def_method(Shape, is_view_cullable)
+        .def_method(Shape, lod_levels)
+        .def_method(Shape, sphere_primitive, "index"_a)
+        .def_method(Shape, instance_transform, "time"_a)
         .def_method(Shape, parameters_grad_enabled)
         .def_method(Shape, primitive_count)
         .def_method(Shape, effective_primitive_count)
-        .def_method(Shape, precompute_silhouette, "viewpoint"_a);
+        .def_method(Shape, precompute_silhouette, "viewpoint"_a)
+        .def_static("attribute_handle", &Shape::attribute_handle, "name"_a,
+                    D(Shape, attribute_handle))
+        .def_static("attribute_name", &Shape::attribute_name, "handle"_a,
+                    D(Shape, attribute_name));
 
     bind_shape_generic<Shape *>(shape);
 
@@ -313,6 +342,82 @@ MI_PY_EXPORT(Shape) {
         bind_shape_generic<ShapePtr>(shape_ptr);
     }
 
+    m.def(
+        "load_instances",
+        [](Shape *group, const TensorXf &transforms,
+           const std::vector<ref<BSDF>> &bsdfs,
+           const std::vector<uint32_t> &bsdf_indices) {
+            if (!group || !group->is_shapegroup())
+                throw nb::type_error("load_instances(): expected a shape group!");
+            if (transforms.ndim() != 3 || transforms.shape(1) != 4 ||
+                transforms.shape(2) != 4)
+                throw nb::value_error(
+                    "load_instances(): expected a tensor of shape [N, 4, 4]!");
+            if (!bsdf_indices.empty()) {
+                if (bsdf_indices.size() != transforms.shape(0))
+                    throw nb::value_error(
+                        "load_instances(): expected one BSDF index per instance!");
+                for (uint32_t index : bsdf_indices)
+                    if (index >= bsdfs.size())
+                        throw nb::index_error(
+                            "load_instances(): BSDF index out of bounds!");
+            } else if (!bsdfs.empty() && bsdfs.size() != transforms.shape(0)) {
+                throw nb::value_error(
+                    "load_instances(): expected one BSDF per instance (or a "
+                    "table of BSDF indices)!");
+            }
+
+            auto &&data = dr::migrate(transforms.array(), AllocType::Host);
+            if constexpr (dr::is_jit_v<Float>)
+                dr::sync_thread();
+            const ScalarFloat *ptr = (const ScalarFloat *) data.data();
+            size_t count = transforms.shape(0);
+
+            std::vector<ref<Shape>> instances(count);
+            nb::gil_scoped_release release;
+            PluginManager *pmgr = PluginManager::instance();
+            for (size_t i = 0; i < count; ++i, ptr += 16) {
+                ScalarMatrix4f matrix;
+                for (size_t r = 0; r < 4; ++r)
+                    for (size_t c = 0; c < 4; ++c)
+                        matrix(r, c) = ptr[r * 4 + c];
+
+                Properties props("instance");
+                props.set_object("shapegroup", group);
+                props.set_transform("to_world", ScalarTransform4f(matrix));
+                if (!bsdfs.empty())
+                    props.set_object(
+                        "bsdf",
+                        bsdfs[bsdf_indices.empty() ? i : bsdf_indices[i]].get());
+                instances[i] = pmgr->create_object<Shape>(props);
+            }
+            return instances;
+        },
+        "group"_a, "transforms"_a, "bsdfs"_a = std::vector<ref<BSDF>>(),
+        "bsdf_indices"_a = std::vector<uint32_t>(),
+        R"doc(Create many instances of a shape group in a single call
+
+This is equivalent to loading one ``instance`` plugin per entry of
+``transforms`` with :py:func:`mitsuba.load_dict`, but skips the parsing of
+a dictionary per object, which dominates the loading time of scenes with
+many instances. The returned list of shapes can e.g. be added to a scene
+dictionary.
+
+Parameter ``group``:
+    Shape group (``shapegroup`` plugin) referenced by all instances
+
+Parameter ``transforms``:
+    Tensor of shape ``[N, 4, 4]`` holding the (row-major) ``to_world``
+    matrices of the instances
+
+Parameter ``bsdfs``:
+    Optional materials that override those of the shape group. Either one
+    per instance, or a table that is indexed by ``bsdf_indices``. The
+    instances share the BSDF objects, and the geometry of the group.
+
+Parameter ``bsdf_indices``:
+    Optional index into ``bsdfs`` per instance)doc");
+
     using PyMesh = PyMesh<Float, Spectrum>;
     using ScalarSize = typename Mesh::ScalarSize;
     using Properties = PropertiesV<Float>;
@@ -338,6 +443,10 @@ MI_PY_EXPORT(Shape) {
         .def("vertex_normals_buffer", nb::overload_cast<>(&Mesh::vertex_normals_buffer))
         .def("vertex_texcoords_buffer", nb::overload_cast<>(&Mesh::vertex_texcoords_buffer))
         .def("faces_buffer", nb::overload_cast<>(&Mesh::faces_buffer))
+        .def_method(Mesh, vertex_normals_data)
+        .def_method(Mesh, vertex_texcoords_data)
+        .def_method(Mesh, has_compact_vertices)
+        .def_method(Mesh, has_interleaved_vertices)
 
         .def("attribute_buffer", &Mesh::attribute_buffer, "name"_a,
              D(Mesh, attribute_buffer))
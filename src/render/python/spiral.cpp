@@ -5,12 +5,26 @@
 
 MI_PY_EXPORT(Spiral) {
     using Vector2u = typename Spiral::Vector2u;
+
+    nb::enum_<BlockOrder>(m, "BlockOrder", D(BlockOrder))
+        .value("Spiral",  BlockOrder::Spiral,  D(BlockOrder, Spiral))
+        .value("Hilbert", BlockOrder::Hilbert, D(BlockOrder, Hilbert))
+        .value("Morton",  BlockOrder::Morton,  D(BlockOrder, Morton));
+
     MI_PY_CLASS(Spiral, Object)
-        .def(nb::init<Vector2u, Vector2u, uint32_t, uint32_t>(),
+        .def(nb::init<Vector2u, Vector2u, uint32_t, uint32_t, BlockOrder>(),
             "size"_a, "offset"_a, "block_size"_a = MI_BLOCK_SIZE, "passes"_a = 1,
-            D(Spiral, Spiral))
+            "order"_a = BlockOrder::Spiral, D(Spiral, Spiral))
         .def_method(Spiral, max_block_size)
         .def_method(Spiral, block_count)
+        .def_method(Spiral, passes)
+        .def_method(Spiral, order)
         .def_method(Spiral, reset)
-        .def_method(Spiral, next_block);
+        .def("next_block", nb::overload_cast<>(&Spiral::next_block),
+             D(Spiral, next_block))
+        .def("next_block", nb::overload_cast<uint32_t>(&Spiral::next_block),
+             "partition"_a, D(Spiral, next_block, 2))
+        .def_method(Spiral, block, "index"_a)
+        .def_method(Spiral, set_partitions, "count"_a)
+        .def_method(Spiral, partitions);
 }
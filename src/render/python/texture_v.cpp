@@ -11,7 +11,7 @@
 MI_VARIANT class PyTexture : public Texture<Float, Spectrum> {
 public:
     MI_IMPORT_TYPES(Texture)
-    NB_TRAMPOLINE(Texture, 14);
+    NB_TRAMPOLINE(Texture, 15);
 
     PyTexture(const Properties &props) : Texture(props) {}
 
@@ -77,6 +77,17 @@ public:
         NB_OVERRIDE(is_spatially_varying);
     }
 
+    /* The surface interaction fields read by textures implemented in Python
+       are unknown, hence all of them are requested unless overridden */
+    uint32_t ray_flags() const override {
+        nanobind::detail::ticket nb_ticket(nb_trampoline, "ray_flags", false);
+        if (nb_ticket.key.is_valid())
+            return nanobind::cast<uint32_t>(
+                nb_trampoline.base().attr(nb_ticket.key)());
+        else
+            return +RayFlags::All;
+    }
+
     std::string to_string() const override {
         NB_OVERRIDE(to_string);
     }
@@ -93,6 +104,7 @@ MI_PY_EXPORT(Texture) {
         .def_method(Texture, mean, D(Texture, mean))
         .def_method(Texture, max, D(Texture, max))
         .def_method(Texture, is_spatially_varying)
+        .def_method(Texture, ray_flags)
         .def_method(Texture, eval, "si"_a, "active"_a = true)
         .def_method(Texture, eval_1, "si"_a, "active"_a = true)
         .def_method(Texture, eval_1_grad, "si"_a, "active"_a = true)
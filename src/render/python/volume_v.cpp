@@ -67,6 +67,7 @@ MI_PY_EXPORT(Volume) {
         .def_method(Volume, bbox)
         .def_method(Volume, channel_count)
         .def_method(Volume, max)
+        .def_method(Volume, mip_levels)
         .def("max_per_channel",
             [] (const Volume *volume) {
                 std::vector<ScalarFloat> max_values(volume->channel_count());
@@ -74,9 +75,18 @@ MI_PY_EXPORT(Volume) {
                 return max_values;
             },
             D(Volume, max_per_channel))
+        .def("max_per_cell",
+            [] (const Volume *volume, const ScalarVector3u &res) {
+                std::vector<ScalarFloat> max_values((size_t) dr::prod(res));
+                volume->max_per_cell(res, max_values.data());
+                return max_values;
+            },
+            "res"_a, D(Volume, max_per_cell))
+        .def_method(Volume, world_to_local)
         .def_method(Volume, eval, "it"_a, "active"_a = true)
         .def_method(Volume, eval_1, "it"_a, "active"_a = true)
         .def_method(Volume, eval_3, "it"_a, "active"_a = true)
+        .def_method(Volume, eval_mip, "it"_a, "level"_a, "active"_a = true)
         .def("eval_6",
                 [](const Volume &volume, const Interaction3f &it, const Mask active) {
                     dr::Array<Float, 6> result = volume.eval_6(it, active);
@@ -2,6 +2,7 @@
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/profiler.h>
 #include <drjit/array_traverse.h>
+#include <algorithm>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -18,6 +19,7 @@ MI_VARIANT Sampler<Float, Spectrum>::Sampler(const Properties &props)
     m_sample_index = dr::opaque<UInt32>(0);
     m_samples_per_wavefront = 1;
     m_wavefront_size = 0;
+    m_film_width = 0;
 }
 
 MI_VARIANT Sampler<Float, Spectrum>::Sampler(const Sampler &sampler)
@@ -26,6 +28,7 @@ MI_VARIANT Sampler<Float, Spectrum>::Sampler(const Sampler &sampler)
     m_base_seed             = sampler.m_base_seed;
     m_wavefront_size        = sampler.m_wavefront_size;
     m_samples_per_wavefront = sampler.m_samples_per_wavefront;
+    m_film_width            = sampler.m_film_width;
     m_dimension_index       = sampler.m_dimension_index;
     m_sample_index          = sampler.m_sample_index;
 }
@@ -68,6 +71,43 @@ MI_VARIANT void Sampler<Float, Spectrum>::schedule_state() {
     dr::schedule(m_sample_index, m_dimension_index);
 }
 
+MI_VARIANT ref<Sampler<Float, Spectrum>>
+Sampler<Float, Spectrum>::compact(const UInt32 &index) {
+    if constexpr (!dr::is_array_v<Float>)
+        Throw("Sampler::compact(): not supported in scalar variants!");
+    ref<Sampler> sampler = clone();
+    sampler->gather_state(index);
+    return sampler;
+}
+
+MI_VARIANT void Sampler<Float, Spectrum>::expand(const Sampler *compacted,
+                                                  const UInt32 &index) {
+    if constexpr (!dr::is_array_v<Float>)
+        Throw("Sampler::expand(): not supported in scalar variants!");
+    if (compacted->class_() != class_())
+        Throw("Sampler::expand(): the sampler was not created by compact()!");
+    scatter_state(compacted, index);
+}
+
+MI_VARIANT void Sampler<Float, Spectrum>::gather_state(const UInt32 &index) {
+    /* Fold the offsets of the lanes within their wavefront into the sample
+       index, since the compacted lanes no longer line up with them */
+    UInt32 sample_index = current_sample_index();
+    if (dr::width(sample_index) > 1)
+        sample_index = dr::gather<UInt32>(sample_index, index);
+
+    m_sample_index = sample_index;
+    m_samples_per_wavefront = 1;
+    m_wavefront_size = (uint32_t) dr::width(index);
+}
+
+MI_VARIANT void
+Sampler<Float, Spectrum>::scatter_state(const Sampler *compacted,
+                                        const UInt32 & /* index */) {
+    // All lanes consumed the same number of dimensions
+    m_dimension_index = compacted->m_dimension_index;
+}
+
 MI_VARIANT void
 Sampler<Float, Spectrum>::traverse_1_cb_ro(void * /*payload*/,
                                            void (* /*fn*/)(void *, uint64_t)) const {
@@ -140,6 +180,40 @@ MI_VARIANT void PCG32Sampler<Float, Spectrum>::seed(UInt32 seed,
         m_rng.seed(v0, v1);
     } else {
         m_rng.seed(seed_value, PCG32_DEFAULT_STREAM);
+        m_batch_index = BatchSize;
+    }
+}
+
+MI_VARIANT void PCG32Sampler<Float, Spectrum>::refill_batch() {
+    if constexpr (!dr::is_array_v<Float>) {
+        using UInt32P = dr::Array<uint32_t, BatchSize>;
+        using UInt64P = dr::Array<uint64_t, BatchSize>;
+
+        // Coefficients of the affine maps that advance the state by j steps
+        if (m_batch_inc != m_rng.inc) {
+            m_batch_inc = m_rng.inc;
+            m_batch_mult[0] = 1;
+            m_batch_add[0] = 0;
+            for (uint32_t j = 1; j <= BatchSize; ++j) {
+                m_batch_mult[j] = m_batch_mult[j - 1] * PCG32_MULT;
+                m_batch_add[j] = m_batch_add[j - 1] * PCG32_MULT + m_batch_inc;
+            }
+        }
+
+        UInt64P mult = dr::load<UInt64P>(m_batch_mult),
+                add  = dr::load<UInt64P>(m_batch_add);
+
+        // States from which the next 'BatchSize' outputs are computed
+        UInt64P state = mult * UInt64P(m_rng.state) + add;
+        m_rng.state = m_batch_mult[BatchSize] * m_rng.state + m_batch_add[BatchSize];
+
+        // PCG32 output function (XSH RR), as in PCG32::next_uint32()
+        UInt32P xorshifted = UInt32P(dr::sr<27>(dr::sr<18>(state) ^ state)),
+                rot        = UInt32P(dr::sr<59>(state)),
+                value      = (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31u));
+
+        dr::store(m_batch, value);
+        m_batch_index = 0;
     }
 }
 
@@ -148,6 +222,24 @@ MI_VARIANT void PCG32Sampler<Float, Spectrum>::schedule_state() {
     dr::schedule(m_rng.inc, m_rng.state);
 }
 
+MI_VARIANT void PCG32Sampler<Float, Spectrum>::gather_state(const UInt32 &index) {
+    Base::gather_state(index);
+    if (dr::width(m_rng.state) > 1) {
+        m_rng.state = dr::gather<UInt64>(m_rng.state, index);
+        m_rng.inc   = dr::gather<UInt64>(m_rng.inc, index);
+    }
+}
+
+MI_VARIANT void
+PCG32Sampler<Float, Spectrum>::scatter_state(const Base *compacted,
+                                             const UInt32 &index) {
+    Base::scatter_state(compacted, index);
+    if (dr::width(m_rng.state) > 1) {
+        const PCG32Sampler *sampler = static_cast<const PCG32Sampler *>(compacted);
+        dr::scatter(m_rng.state, sampler->m_rng.state, index);
+    }
+}
+
 MI_VARIANT void
 PCG32Sampler<Float, Spectrum>::traverse_1_cb_ro(void *payload,
                                                 void (*fn)(void *, uint64_t)) const {
@@ -164,6 +256,10 @@ MI_VARIANT
 PCG32Sampler<Float, Spectrum>::PCG32Sampler(const PCG32Sampler &sampler)
     : Base(sampler) {
     m_rng = sampler.m_rng;
+
+    // Continue with the same buffered outputs
+    std::copy(sampler.m_batch, sampler.m_batch + BatchSize, m_batch);
+    m_batch_index = sampler.m_batch_index;
 }
 
 //! @}
@@ -1,15 +1,23 @@
+#include <mitsuba/core/hash.h>
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/plugin.h>
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/timer.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/medium.h>
 #include <mitsuba/render/mesh.h>
 #include <mitsuba/render/scene.h>
 #include <mitsuba/render/integrator.h>
+#include <mitsuba/render/texture.h>
+#include <algorithm>
+#include <unordered_set>
 
 #if defined(MI_ENABLE_EMBREE)
 #  include "scene_embree.inl"
 #else
 #  include <mitsuba/render/kdtree.h>
+#  include <mitsuba/render/bvh.h>
 #  include "scene_native.inl"
 #endif
 
@@ -19,7 +27,38 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
+/// Combines the \ref RayFlags requested by the BSDFs and textures of a scene
+template <typename Float, typename Spectrum>
+struct RayFlagsCallback : public TraversalCallback {
+    MI_IMPORT_TYPES(BSDF, Shape, Texture)
+
+    void visit(Object *obj) {
+        if (!obj || !visited.insert(obj).second)
+            return;
+        if (BSDF *bsdf = dynamic_cast<BSDF *>(obj))
+            flags |= bsdf->ray_flags();
+        else if (Texture *texture = dynamic_cast<Texture *>(obj))
+            flags |= texture->ray_flags();
+        else if (Shape *shape = dynamic_cast<Shape *>(obj))
+            has_instances |= shape->is_instance();
+        obj->traverse(this);
+    }
+
+    void put_object(const std::string &, Object *obj, uint32_t) override {
+        visit(obj);
+    }
+
+    void put_parameter_impl(const std::string &, void *, uint32_t,
+                            const std::type_info &) override { }
+
+    uint32_t flags = RayFlags::Minimal | RayFlags::ShadingFrame;
+    bool has_instances = false;
+    std::unordered_set<Object *> visited;
+};
+
 MI_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
+    std::vector<ref<Shape>> lods;
+
     for (auto &[k, v] : props.objects()) {
         Scene *scene           = dynamic_cast<Scene *>(v.get());
         Shape *shape           = dynamic_cast<Shape *>(v.get());
@@ -28,6 +67,12 @@ MI_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
         Sensor *sensor         = dynamic_cast<Sensor *>(v.get());
         Integrator *integrator = dynamic_cast<Integrator *>(v.get());
 
+        if (shape && !shape->lod_levels().empty()) {
+            // Replaced by one of its levels once all sensors are known
+            lods.push_back(shape);
+            continue;
+        }
+
         if (!scene)
             m_children.push_back(v.get());
 
@@ -63,21 +108,53 @@ MI_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
         }
     }
 
+    bool view_culling = props.get<bool>("view_culling", false);
+    ScalarFloat view_culling_margin =
+        props.get<ScalarFloat>("view_culling_margin", 0.1f);
+    if (!lods.empty() || view_culling)
+        select_view_dependent_shapes(lods, view_culling, view_culling_margin);
+
     // Create sensors' shapes (environment sensors)
     for (Sensor *sensor: m_sensors)
         sensor->set_scene(this);
 
+    if (props.get<bool>("auto_instancing", false))
+        instance_duplicate_meshes();
+
     if constexpr (dr::is_cuda_v<Float>)
         accel_init_gpu(props);
     else
         accel_init_cpu(props);
 
+    /* Parameters of the acceleration data structures of other ray tracing
+       backends are ignored, so that scene descriptions remain portable */
+    for (const char *name : { "accel", "bvh_max_leaf_size", "bvh_traversal_cost",
+                              "bvh_intersection_cost", "kd_cache", "kd_compact",
+                              "kd_cache_map", "kd_triangle_packets",
+                              "kd_coherent_traversal",
+                              "kd_divergence_threshold", "embree_refit",
+                              "embree_use_robust_intersections",
+                              "embree_build_quality", "embree_compact",
+                              "embree_build_threads",
+                              "optix_ias_max_updates", "optix_gas_cache",
+                              "optix_disk_cache", "optix_cache_path",
+                              "optix_prune_pipeline" })
+        props.mark_queried(name);
+
+    m_use_light_bvh = props.get<bool>("light_bvh", false);
+
+    if (props.get<bool>("minimal_ray_flags", true))
+        update_ray_flags();
+
     if (!m_emitters.empty()) {
         // Inform environment emitters etc. about the scene bounds
         for (Emitter *emitter: m_emitters)
             emitter->set_scene(this);
     }
 
+    for (size_t i = 0; i < m_emitters.size(); ++i)
+        m_emitters[i]->set_scene_index((uint32_t) i);
+
     m_shapes_dr = dr::load<DynamicBuffer<ShapePtr>>(
         m_shapes.data(), m_shapes.size());
 
@@ -93,6 +170,338 @@ MI_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
     update_silhouette_sampling_distribution();
 
     m_shapes_grad_enabled = false;
+
+    Log(Info, "%s", MemoryTracker::summary());
+}
+
+MI_VARIANT void Scene<Float, Spectrum>::instance_duplicate_meshes() {
+    using UInt32Storage = DynamicBuffer<UInt32>;
+    using FloatStorage  = DynamicBuffer<Float>;
+
+    // Host copy of the data needed to compare two meshes
+    struct MeshData {
+        Mesh *mesh;
+        UInt32Storage faces;
+        FloatStorage positions, normals, texcoords;
+    };
+
+    auto fetch = [](Mesh *mesh, bool geometry) {
+        MeshData data { mesh, dr::migrate(mesh->faces_buffer(), AllocType::Host),
+                        FloatStorage(), FloatStorage(),
+                        dr::migrate(mesh->vertex_texcoords_data(), AllocType::Host) };
+        if (geometry) {
+            data.positions = dr::migrate(mesh->vertex_positions_buffer(), AllocType::Host);
+            data.normals   = dr::migrate(mesh->vertex_normals_data(), AllocType::Host);
+        }
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+        return data;
+    };
+
+    /* Bucket the meshes by a hash of the data that does not depend on their
+       transformation, i.e. the topology and the texture coordinates. The
+       buckets are stored in the order of their first mesh in the scene, so
+       that the shape groups are created in a deterministic order (the hash
+       includes the address of the BSDF and changes between runs). */
+    std::vector<std::vector<Mesh *>> buckets;
+    std::unordered_map<size_t, size_t> bucket_index;
+    for (Shape *shape : m_shapes) {
+        if (!shape->is_mesh() || shape->is_emitter() || shape->is_sensor() ||
+            shape->is_medium_transition() || !shape->m_texture_attributes.empty())
+            continue;
+        Mesh *mesh = (Mesh *) shape;
+        if (mesh->has_mesh_attributes() || mesh->face_count() == 0)
+            continue;
+
+        MeshData data = fetch(mesh, false);
+        size_t h = hash_combine(hash(mesh->vertex_count()), hash(mesh->face_count()));
+        h = hash_combine(h, hash((const void *) mesh->bsdf()));
+        h = hash_combine(h, hash(mesh->has_vertex_normals()));
+        h = hash_combine(h, std::hash<std::string_view>()(std::string_view(
+            (const char *) data.faces.data(), data.faces.size() * sizeof(uint32_t))));
+        h = hash_combine(h, std::hash<std::string_view>()(std::string_view(
+            (const char *) data.texcoords.data(), data.texcoords.size() * sizeof(ScalarFloat))));
+        auto [it, inserted] = bucket_index.try_emplace(h, buckets.size());
+        if (inserted)
+            buckets.emplace_back();
+        buckets[it->second].push_back(mesh);
+    }
+
+    /* Returns whether 'mesh' is a copy of 'proto' that was transformed by
+       'trafo', up to a small tolerance that accounts for the rounding errors
+       of the transformation that was applied when the meshes were loaded. */
+    auto matches = [](const MeshData &proto, const MeshData &mesh,
+                      const ScalarTransform4f &trafo) {
+        if (proto.mesh->bsdf() != mesh.mesh->bsdf() ||
+            proto.faces.size() != mesh.faces.size() ||
+            proto.texcoords.size() != mesh.texcoords.size() ||
+            proto.normals.size() != mesh.normals.size() ||
+            proto.positions.size() != mesh.positions.size())
+            return false;
+
+        if (memcmp(proto.faces.data(), mesh.faces.data(),
+                   proto.faces.size() * sizeof(uint32_t)) != 0 ||
+            memcmp(proto.texcoords.data(), mesh.texcoords.data(),
+                   proto.texcoords.size() * sizeof(ScalarFloat)) != 0)
+            return false;
+
+        ScalarFloat tolerance = 1e-4f * dr::max(mesh.mesh->bbox().extents()) + 1e-6f;
+        const ScalarFloat *p0 = proto.positions.data(), *p1 = mesh.positions.data();
+        for (size_t i = 0; i < proto.positions.size(); i += 3) {
+            ScalarPoint3f p = trafo.transform_affine(ScalarPoint3f(p0[i], p0[i + 1], p0[i + 2]));
+            if (dr::any(dr::abs(p - ScalarPoint3f(p1[i], p1[i + 1], p1[i + 2])) > tolerance))
+                return false;
+        }
+
+        const ScalarFloat *n0 = proto.normals.data(), *n1 = mesh.normals.data();
+        for (size_t i = 0; i < proto.normals.size(); i += 3) {
+            ScalarNormal3f n = dr::normalize(
+                trafo.transform_affine(ScalarNormal3f(n0[i], n0[i + 1], n0[i + 2])));
+            if (dr::any(dr::abs(n - ScalarNormal3f(n1[i], n1[i + 1], n1[i + 2])) > 1e-3f))
+                return false;
+        }
+
+        return true;
+    };
+
+    // Transformation that maps 'proto' onto 'mesh'
+    auto relative = [](const Shape *proto, const Shape *mesh) {
+        return mesh->m_to_world.scalar() * proto->m_to_object.scalar();
+    };
+
+    std::unordered_map<const Object *, ref<Shape>> replaced;
+    size_t group_count = 0, instance_count = 0;
+
+    for (auto &meshes : buckets) {
+        if (meshes.size() < 2)
+            continue;
+
+        // Prototypes found in this bucket, and the meshes that copy them
+        std::vector<std::pair<MeshData, std::vector<Mesh *>>> protos;
+        for (Mesh *mesh : meshes) {
+            MeshData data = fetch(mesh, true);
+            bool found = false;
+            for (auto &[proto, copies] : protos) {
+                ScalarTransform4f trafo = relative(proto.mesh, mesh);
+                if (matches(proto, data, trafo)) {
+                    copies.push_back(mesh);
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+                protos.emplace_back(std::move(data), std::vector<Mesh *>{ mesh });
+        }
+
+        for (auto &[proto, copies] : protos) {
+            if (copies.size() < 2)
+                continue;
+
+            /* The (world space) prototype becomes part of a shape group. All
+               copies, including the prototype, are replaced by instances that
+               map it onto their position. */
+            Properties group_props("shapegroup");
+            group_props.set_id(proto.mesh->id() + "_group");
+            group_props.set_object("shape", proto.mesh);
+            ref<Shape> group =
+                PluginManager::instance()->create_object<Shape>(group_props);
+            m_shapegroups.push_back((ShapeGroup *) group.get());
+            m_children.push_back(group.get());
+
+            for (Mesh *mesh : copies) {
+                Properties inst_props("instance");
+                inst_props.set_id(mesh->id());
+                inst_props.set_object("shapegroup", group.get());
+                inst_props.set_transform("to_world", relative(proto.mesh, mesh));
+                replaced[mesh] =
+                    PluginManager::instance()->create_object<Shape>(inst_props);
+            }
+
+            group_count++;
+            instance_count += copies.size();
+        }
+    }
+
+    if (replaced.empty())
+        return;
+
+    for (auto &shape : m_shapes) {
+        auto it = replaced.find(shape.get());
+        if (it != replaced.end())
+            shape = it->second;
+    }
+
+    for (auto &child : m_children) {
+        auto it = replaced.find(child.get());
+        if (it != replaced.end())
+            child = it->second.get();
+    }
+
+    Log(Info, "Replaced %zu duplicate meshes by instances of %zu shape groups.",
+        instance_count, group_count);
+}
+
+MI_VARIANT void Scene<Float, Spectrum>::select_view_dependent_shapes(
+        const std::vector<ref<Shape>> &lods, bool culling, ScalarFloat margin) {
+    const ProjectiveCamera *camera =
+        m_sensors.empty() ? nullptr
+                          : dynamic_cast<const ProjectiveCamera *>(m_sensors[0].get());
+
+    /* The view frustum is bounded by the planes through the rays of adjacent
+       (dilated) film corners, and by a plane through the sensor position. A
+       plane (n, d) contains the points p with dot(n, p) + d >= 0. */
+    std::vector<ScalarVector4f> planes;
+    ScalarPoint3f origin;
+    // Angle (perspective) or width (orthographic) covered by one pixel
+    ScalarFloat pixel_footprint = 0.f;
+    bool orthographic = false;
+
+    if (camera) {
+        auto ray = [camera](ScalarFloat x, ScalarFloat y) {
+            auto [r, unused] = camera->sample_ray(
+                Float(camera->shutter_open()), Float(0.5f), Point2f(x, y),
+                Point2f(0.5f));
+            return std::make_pair(ScalarPoint3f(dr::slice(r.o)),
+                                  ScalarVector3f(dr::slice(r.d)));
+        };
+
+        ScalarFloat lo = -margin, hi = 1.f + margin;
+        std::pair<ScalarPoint3f, ScalarVector3f> corners[4] = {
+            ray(lo, lo), ray(hi, lo), ray(hi, hi), ray(lo, hi)
+        };
+        auto [center_o, center_d] = ray(.5f, .5f);
+        ScalarPoint3f inside = center_o + center_d;
+
+        for (int i = 0; i < 4; ++i) {
+            auto [o0, d0] = corners[i];
+            auto [o1, d1] = corners[(i + 1) % 4];
+            ScalarVector3f n = dr::normalize(dr::cross(o1 + d1 - o0, d0));
+            ScalarFloat d = -dr::dot(n, o0);
+            if (dr::dot(n, inside) + d < 0.f) {
+                n = -n;
+                d = -d;
+            }
+            planes.emplace_back(n.x(), n.y(), n.z(), d);
+        }
+        planes.emplace_back(center_d.x(), center_d.y(), center_d.z(),
+                            -dr::dot(center_d, center_o));
+
+        auto left = ray(0.f, .5f), right = ray(1.f, .5f);
+        ScalarFloat width = (ScalarFloat) camera->film()->crop_size().x();
+        orthographic = dr::dot(left.second, right.second) > 1.f - 1e-6f;
+        pixel_footprint = (orthographic
+                               ? dr::norm(right.first - left.first)
+                               : dr::unit_angle(left.second, right.second)) / width;
+        origin = center_o;
+    }
+
+    // Size of the bounding sphere of a box on the film (in pixels)
+    auto projected_size = [&](const ScalarBoundingBox3f &bbox) -> ScalarFloat {
+        ScalarFloat radius = .5f * dr::norm(bbox.extents());
+        if (orthographic)
+            return 2.f * radius / pixel_footprint;
+        ScalarFloat dist = dr::norm(bbox.center() - origin);
+        if (dist <= radius)
+            return dr::Infinity<ScalarFloat>;
+        return 2.f * dr::asin(radius / dist) / pixel_footprint;
+    };
+
+    for (const ref<Shape> &lod : lods) {
+        std::vector<std::pair<ref<Shape>, ScalarFloat>> levels = lod->lod_levels();
+
+        size_t index = 0;
+        if (camera) {
+            ScalarFloat size = projected_size(levels[0].first->bbox());
+            while (index + 1 < levels.size() && size < levels[index].second)
+                index++;
+        }
+
+        Shape *shape = levels[index].first.get();
+        Log(Debug, "Shape \"%s\": using level %zu of %zu.", lod->id(), index,
+            levels.size());
+
+        m_children.push_back(shape);
+        if (shape->is_emitter())
+            m_emitters.push_back(shape->emitter());
+        if (shape->is_sensor())
+            m_sensors.push_back(shape->sensor());
+        m_bbox.expand(shape->bbox());
+        m_shapes.push_back(shape);
+        if (shape->is_mesh())
+            ((Mesh *) shape)->set_scene(this);
+    }
+
+    if (!culling || !camera)
+        return;
+
+    auto outside = [&](const ScalarBoundingBox3f &bbox) {
+        for (const ScalarVector4f &plane : planes) {
+            ScalarVector3f n(plane.x(), plane.y(), plane.z());
+            bool all_outside = true;
+            for (size_t i = 0; i < 8 && all_outside; ++i)
+                all_outside = dr::dot(n, bbox.corner(i)) + plane.w() < 0.f;
+            if (all_outside)
+                return true;
+        }
+        return false;
+    };
+
+    /* Emitters and sensors are never culled, since they contribute to the
+       image even when they are not directly visible */
+    std::unordered_set<const Object *> culled;
+    std::vector<ref<Shape>> shapes;
+    m_bbox.reset();
+    for (ref<Shape> &shape : m_shapes) {
+        ScalarBoundingBox3f bbox = shape->bbox();
+        if (shape->is_view_cullable() && !shape->is_emitter() &&
+            !shape->is_sensor() && bbox.valid() && outside(bbox)) {
+            culled.insert(shape.get());
+            continue;
+        }
+        m_bbox.expand(bbox);
+        shapes.push_back(shape);
+    }
+
+    if (culled.empty())
+        return;
+
+    m_shapes = std::move(shapes);
+    m_children.erase(std::remove_if(m_children.begin(), m_children.end(),
+                                    [&](const ref<Object> &child) {
+                                        return culled.count(child.get()) != 0;
+                                    }),
+                     m_children.end());
+
+    Log(Info, "View culling skipped %zu of %zu shapes.", culled.size(),
+        culled.size() + m_shapes.size());
+}
+
+MI_VARIANT void Scene<Float, Spectrum>::update_ray_flags() {
+    /* Polarized BSDFs express their Mueller matrices in the shading frame,
+       which must hence be consistently oriented along the UV parameterization */
+    if constexpr (is_polarized_v<Spectrum>) {
+        m_ray_flags = +RayFlags::All;
+        return;
+    }
+
+    RayFlagsCallback<Float, Spectrum> cb;
+    for (auto &child : m_children)
+        cb.visit(child.get());
+    for (auto &shape : m_shapes)
+        cb.visit(shape.get());
+    for (auto &group : m_shapegroups)
+        cb.visit(group.get());
+
+    /* Instances don't expose their shape group. Unless the scene references
+       shape groups directly, their materials are unknown. */
+    if (cb.has_instances && m_shapegroups.empty()) {
+        m_ray_flags = +RayFlags::All;
+        return;
+    }
+
+    m_ray_flags = cb.flags;
+    Log(Debug, "Surface interactions of the scene use the ray flags 0x%x.",
+        m_ray_flags);
 }
 
 MI_VARIANT
@@ -106,17 +515,30 @@ void Scene<Float, Spectrum>::update_emitter_sampling_distribution() {
         }
     }
     size_t n_emitters = m_emitters.size();
-    if (non_uniform_sampling) {
+    if (non_uniform_sampling && m_emitter_distr &&
+        m_emitter_distr->size() == n_emitters) {
+        /* Only the nodes of the emitters whose weight changed are updated,
+           e.g. when optimizing the weights of a few emitters at a time */
+        for (size_t i = 0; i < n_emitters; ++i)
+            m_emitter_distr->set((uint32_t) i, m_emitters[i]->sampling_weight());
+        m_emitter_distr->update();
+    } else if (non_uniform_sampling) {
         std::unique_ptr<ScalarFloat[]> sample_weights(new ScalarFloat[n_emitters]);
         for (size_t i = 0; i < n_emitters; ++i)
             sample_weights[i] = m_emitters[i]->sampling_weight();
-        m_emitter_distr = std::make_unique<DiscreteDistribution<Float>>(
+        m_emitter_distr = std::make_unique<FenwickDistribution<Float>>(
             sample_weights.get(), n_emitters);
     } else {
         // By default use uniform sampling with constant PMF
         m_emitter_pmf = m_emitters.empty() ? 0.f : (1.f / n_emitters);
         m_emitter_distr = nullptr;
     }
+
+    if (m_use_light_bvh && n_emitters > 1)
+        m_light_bvh = new LightBVH(m_emitters);
+    else
+        m_light_bvh = nullptr;
+
     // Clear emitter's dirty flag
     for (auto &e : m_emitters)
         e->set_dirty(false);
@@ -125,8 +547,8 @@ void Scene<Float, Spectrum>::update_emitter_sampling_distribution() {
 MI_VARIANT
 void Scene<Float, Spectrum>::update_silhouette_sampling_distribution() {
     size_t n_shapes = m_shapes.size();
-    std::vector<ScalarFloat> shape_weights{};
-    m_silhouette_shapes.clear();
+    std::vector<ref<Shape>> silhouette_shapes;
+    std::vector<ScalarFloat> shape_weights;
 
     for (size_t i = 0; i < n_shapes; ++i) {
         ScalarFloat weight = m_shapes[i]->silhouette_sampling_weight();
@@ -141,12 +563,20 @@ void Scene<Float, Spectrum>::update_silhouette_sampling_distribution() {
             bool has_discontinuity = has_interior || has_perimeter;
 
             if (has_discontinuity) {
-                m_silhouette_shapes.emplace_back(m_shapes[i]);
+                silhouette_shapes.emplace_back(m_shapes[i]);
                 shape_weights.emplace_back(weight);
             }
         }
     }
 
+    // Nothing to do if the differentiated shapes and their weights are the same
+    if (m_silhouette_distr && silhouette_shapes == m_silhouette_shapes &&
+        shape_weights == m_silhouette_weights)
+        return;
+
+    m_silhouette_shapes = std::move(silhouette_shapes);
+    m_silhouette_weights = shape_weights;
+
     size_t silhouette_shape_count = m_silhouette_shapes.size();
     m_silhouette_shapes_dr = dr::load<DynamicBuffer<ShapePtr>>(
         m_silhouette_shapes.data(), silhouette_shape_count);
@@ -155,6 +585,65 @@ void Scene<Float, Spectrum>::update_silhouette_sampling_distribution() {
             shape_weights.data(), silhouette_shape_count);
 }
 
+MI_VARIANT void Scene<Float, Spectrum>::build_shapegroups() {
+    if constexpr (!dr::is_cuda_v<Float>) {
+        std::vector<ShapeGroup *> groups;
+        for (auto &group : m_shapegroups) {
+#if defined(MI_ENABLE_EMBREE)
+            if (group->dirty())
+                groups.push_back(group.get());
+#else
+            if (!group->lazy_build() && !group->accel_ready())
+                groups.push_back(group.get());
+#endif
+        }
+
+#if !defined(MI_ENABLE_EMBREE) && defined(MI_ENABLE_LLVM)
+        /* Groups that are only referenced by instances (e.g. when nested in
+           their declaration) cannot be built within the ray tracing kernels
+           of the LLVM variants. Build all pending ones in this case. */
+        if constexpr (dr::is_llvm_v<Float>) {
+            const char *domain = "mitsuba::ShapeGroup";
+            uint32_t bound = jit_registry_id_bound(dr::backend_v<Float>, domain);
+            for (uint32_t id = 1; id <= bound; ++id) {
+                ShapeGroup *group = (ShapeGroup *) jit_registry_ptr(
+                    dr::backend_v<Float>, domain, id);
+                if (group && !group->accel_ready() &&
+                    std::find(groups.begin(), groups.end(), group) == groups.end())
+                    groups.push_back(group);
+            }
+        }
+#endif
+
+        if (groups.empty())
+            return;
+
+        ScopedPhase phase(ProfilerPhase::InitAccel);
+        Timer timer;
+
+        // Shape data may still be pending evaluation
+        if constexpr (dr::is_llvm_v<Float>)
+            dr::sync_thread();
+
+        dr::parallel_for(
+            dr::blocked_range<size_t>(0, groups.size(), 1),
+            [&](const dr::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+#if defined(MI_ENABLE_EMBREE)
+                    groups[i]->embree_build(global_embree_device);
+#else
+                    groups[i]->build_accel();
+#endif
+                }
+            }
+        );
+
+        Log(Debug, "Built the acceleration data structures of %zu shape "
+            "group%s (took %s).", groups.size(), groups.size() == 1 ? "" : "s",
+            util::time_string((float) timer.value()));
+    }
+}
+
 MI_VARIANT Scene<Float, Spectrum>::~Scene() {
     if constexpr (dr::is_cuda_v<Float>)
         accel_release_gpu();
@@ -173,10 +662,30 @@ MI_VARIANT Scene<Float, Spectrum>::~Scene() {
 
 // -----------------------------------------------------------------------
 
+/**
+ * Record a scene query in the ray traversal statistics of the calling thread.
+ * JIT variants count the lanes of the (possibly symbolic) query.
+ */
+template <typename Ray, typename Mask>
+MI_INLINE void record_ray_query(RayStatistic stat, const Ray &ray, const Mask &active) {
+#if defined(MI_ENABLE_RAY_STATISTICS)
+    ScopedRayStatistics stats;
+    if constexpr (dr::is_jit_v<Mask>)
+        stats.add(stat, dr::width(ray));
+    else if (active)
+        stats.add(stat);
+#else
+    DRJIT_MARK_USED(stat);
+    DRJIT_MARK_USED(ray);
+    DRJIT_MARK_USED(active);
+#endif
+}
+
 MI_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
 Scene<Float, Spectrum>::ray_intersect(const Ray3f &ray, uint32_t ray_flags, Mask coherent, Mask active) const {
     MI_MASKED_FUNCTION(ProfilerPhase::RayIntersect, active);
     DRJIT_MARK_USED(coherent);
+    record_ray_query(RayStatistic::RayIntersect, ray, active);
 
     if constexpr (dr::is_cuda_v<Float>)
         return ray_intersect_gpu(ray, ray_flags, active);
@@ -187,6 +696,7 @@ Scene<Float, Spectrum>::ray_intersect(const Ray3f &ray, uint32_t ray_flags, Mask
 MI_VARIANT typename Scene<Float, Spectrum>::PreliminaryIntersection3f
 Scene<Float, Spectrum>::ray_intersect_preliminary(const Ray3f &ray, Mask coherent, Mask active) const {
     DRJIT_MARK_USED(coherent);
+    record_ray_query(RayStatistic::RayIntersect, ray, active);
     if constexpr (dr::is_cuda_v<Float>)
         return ray_intersect_preliminary_gpu(ray, active);
     else
@@ -197,6 +707,7 @@ MI_VARIANT typename Scene<Float, Spectrum>::Mask
 Scene<Float, Spectrum>::ray_test(const Ray3f &ray, Mask coherent, Mask active) const {
     MI_MASKED_FUNCTION(ProfilerPhase::RayTest, active);
     DRJIT_MARK_USED(coherent);
+    record_ray_query(RayStatistic::RayTest, ray, active);
 
     if constexpr (dr::is_cuda_v<Float>)
         return ray_test_gpu(ray, active);
@@ -204,9 +715,25 @@ Scene<Float, Spectrum>::ray_test(const Ray3f &ray, Mask coherent, Mask active) c
         return ray_test_cpu(ray, coherent, active);
 }
 
+MI_VARIANT void
+Scene<Float, Spectrum>::ray_test_multi(const Ray3f *rays, const Mask *active,
+                                       Mask *result, size_t count) const {
+    ScopedPhase sp(ProfilerPhase::RayTest);
+    for (size_t i = 0; i < count; ++i)
+        record_ray_query(RayStatistic::RayTest, rays[i], active[i]);
+
+    if constexpr (dr::is_cuda_v<Float>) {
+        for (size_t i = 0; i < count; ++i)
+            result[i] = ray_test_gpu(rays[i], active[i]);
+    } else {
+        ray_test_multi_cpu(rays, active, result, count);
+    }
+}
+
 MI_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
 Scene<Float, Spectrum>::ray_intersect_naive(const Ray3f &ray, Mask active) const {
     MI_MASKED_FUNCTION(ProfilerPhase::RayIntersect, active);
+    record_ray_query(RayStatistic::RayIntersect, ray, active);
 
 #if !defined(MI_ENABLE_EMBREE)
     if constexpr (!dr::is_cuda_v<Float>)
@@ -252,6 +779,24 @@ MI_VARIANT Float Scene<Float, Spectrum>::pdf_emitter(UInt32 index,
         return m_emitter_distr->eval_pmf_normalized(index, active);
 }
 
+MI_VARIANT std::tuple<typename Scene<Float, Spectrum>::UInt32, Float, Float>
+Scene<Float, Spectrum>::sample_emitter(const Interaction3f &ref,
+                                       Float index_sample, Mask active) const {
+    if (!m_light_bvh)
+        return sample_emitter(index_sample, active);
+
+    MI_MASKED_FUNCTION(ProfilerPhase::SampleEmitter, active);
+    return m_light_bvh->sample(ref, index_sample, active);
+}
+
+MI_VARIANT Float Scene<Float, Spectrum>::pdf_emitter(const Interaction3f &ref,
+                                                      UInt32 index,
+                                                      Mask active) const {
+    if (!m_light_bvh)
+        return pdf_emitter(index, active);
+    return m_light_bvh->pdf(ref, index, active);
+}
+
 MI_VARIANT std::tuple<typename Scene<Float, Spectrum>::Ray3f, Spectrum,
                        const typename Scene<Float, Spectrum>::EmitterPtr>
 Scene<Float, Spectrum>::sample_emitter_ray(Float time, Float sample1,
@@ -282,6 +827,7 @@ Scene<Float, Spectrum>::sample_emitter_ray(Float time, Float sample1,
     } else if (emitter_count == 1) {
         std::tie(ray, weight) =
             m_emitters[0]->sample_ray(time, sample1, sample2, sample3, active);
+        emitter = EmitterPtr(m_emitters[0].get());
     } else {
         ray = dr::zeros<Ray3f>();
         weight = dr::zeros<Spectrum>();
@@ -308,15 +854,25 @@ Scene<Float, Spectrum>::sample_emitter_direction(const Interaction3f &ref, const
     size_t emitter_count = m_emitters.size();
     if (emitter_count > 1 || (emitter_count == 1 && !vcall_inline)) {
         // Randomly pick an emitter
-        auto [index, emitter_weight, sample_x_re] = sample_emitter(sample.x(), active);
+        auto [index, emitter_weight, sample_x_re] = sample_emitter(ref, sample.x(), active);
         sample.x() = sample_x_re;
+        active &= emitter_weight > 0.f;
+        if (unlikely(dr::none_or<false>(active)))
+            return { dr::zeros<DirectionSample3f>(), dr::zeros<Spectrum>() };
 
         // Sample a direction towards the emitter
         EmitterPtr emitter = dr::gather<EmitterPtr>(m_emitters_dr, index, active);
-        std::tie(ds, spec) = emitter->sample_direction(ref, sample, active);
+        if (m_light_bvh)
+            std::tie(ds, spec) =
+                m_light_bvh->sample_direction(ref, emitter, index, sample, active);
+        else
+            std::tie(ds, spec) = emitter->sample_direction(ref, sample, active);
 
         // Account for the discrete probability of sampling this emitter
-        ds.pdf *= pdf_emitter(index, active);
+        if (m_light_bvh)
+            ds.pdf *= dr::select(active, dr::rcp(emitter_weight), 0.f);
+        else
+            ds.pdf *= pdf_emitter(index, active);
         spec *= emitter_weight;
 
         active &= (ds.pdf != 0.f);
@@ -324,6 +880,7 @@ Scene<Float, Spectrum>::sample_emitter_direction(const Interaction3f &ref, const
         // Mark occluded samples as invalid if requested by the user
         if (test_visibility && dr::any_or<true>(active)) {
             Mask occluded = ray_test(ref.spawn_ray_to(ds.p), active);
+            record_emitter_visibility(ref, ds, spec, !occluded, active);
             dr::masked(spec, occluded) = 0.f;
             dr::masked(ds.pdf, occluded) = 0.f;
         }
@@ -336,6 +893,7 @@ Scene<Float, Spectrum>::sample_emitter_direction(const Interaction3f &ref, const
         // Mark occluded samples as invalid if requested by the user
         if (test_visibility && dr::any_or<true>(active)) {
             Mask occluded = ray_test(ref.spawn_ray_to(ds.p), active);
+            record_emitter_visibility(ref, ds, spec, !occluded, active);
             dr::masked(spec, occluded) = 0.f;
             dr::masked(ds.pdf, occluded) = 0.f;
         }
@@ -347,11 +905,62 @@ Scene<Float, Spectrum>::sample_emitter_direction(const Interaction3f &ref, const
     return { ds, spec };
 }
 
+MI_VARIANT void
+Scene<Float, Spectrum>::sample_emitter_directions(const Interaction3f &ref,
+                                                  const Point2f *samples,
+                                                  size_t count,
+                                                  DirectionSample3f *ds,
+                                                  Spectrum *spec,
+                                                  bool test_visibility,
+                                                  Mask active) const {
+    std::unique_ptr<Ray3f[]> rays(new Ray3f[count]);
+    std::unique_ptr<Mask[]> valid(new Mask[count]), occluded(new Mask[count]);
+
+    bool any_valid = false;
+    for (size_t i = 0; i < count; ++i) {
+        std::tie(ds[i], spec[i]) =
+            sample_emitter_direction(ref, samples[i], false, active);
+        valid[i] = active && ds[i].pdf != 0.f;
+        rays[i] = ref.spawn_ray_to(ds[i].p);
+        any_valid |= dr::any_or<true>(valid[i]);
+    }
+
+    // Mark occluded samples as invalid if requested by the user
+    if (!test_visibility || !any_valid)
+        return;
+
+    ray_test_multi(rays.get(), valid.get(), occluded.get(), count);
+    for (size_t i = 0; i < count; ++i) {
+        record_emitter_visibility(ref, ds[i], spec[i], !occluded[i], valid[i]);
+        dr::masked(spec[i], occluded[i]) = 0.f;
+        dr::masked(ds[i].pdf, occluded[i]) = 0.f;
+    }
+}
+
+MI_VARIANT void
+Scene<Float, Spectrum>::record_emitter_visibility(const Interaction3f &ref,
+                                                  const DirectionSample3f &ds,
+                                                  const Spectrum &weight,
+                                                  const Mask &visible,
+                                                  Mask active) const {
+    if (!m_environment || !m_environment->training())
+        return;
+
+    active &= ds.emitter == EmitterPtr(m_environment.get());
+    m_environment->record_visibility(ref, ds, weight, visible, active);
+}
+
 MI_VARIANT Float
 Scene<Float, Spectrum>::pdf_emitter_direction(const Interaction3f &ref,
                                               const DirectionSample3f &ds,
                                               Mask active) const {
     MI_MASK_ARGUMENT(active);
+    if (m_light_bvh) {
+        UInt32 index = ds.emitter->scene_index();
+        return m_light_bvh->pdf(ref, index, active) *
+               m_light_bvh->pdf_direction(ref, ds, index, active);
+    }
+
     Float emitter_pmf;
     if (m_emitter_distr == nullptr)
         emitter_pmf = m_emitter_pmf;
@@ -476,22 +1085,35 @@ MI_VARIANT void Scene<Float, Spectrum>::parameters_changed(const std::vector<std
     if (m_environment)
         m_environment->set_scene(this); // TODO use parameters_changed({"scene"})
 
-    bool accel_is_dirty = false;
+    /* Classify the update by the work that it requires. Appearance changes
+       alone (e.g. of a BSDF, texture, or emitted radiance) don't touch any of
+       the scene's data structures. Geometry changes update the acceleration
+       data structure, which is refit instead of rebuilt when no shape changed
+       its topology (see Shape::topology_dirty()). The emitter sampling
+       distribution only depends on the emitters' sampling weights and
+       placement (see Emitter::dirty()), and the silhouette sampling
+       distribution on the set of differentiated shapes. */
+    bool geometry_dirty = false, topology_dirty = false;
     for (auto &s : m_shapes) {
-        if (s->dirty()) {
-            accel_is_dirty = true;
-            break;
-        }
+        geometry_dirty |= s->dirty();
+        topology_dirty |= s->topology_dirty();
     }
 
     for (auto &s : m_shapegroups) {
-        if (s->dirty()) {
-            accel_is_dirty = true;
-            break;
-        }
+        geometry_dirty |= s->dirty();
+        topology_dirty |= s->dirty();
     }
 
-    if (accel_is_dirty) {
+    bool emitters_dirty = false;
+    for (auto &e : m_emitters)
+        emitters_dirty |= e->dirty();
+
+    Log(Debug, "parameters_changed(): %s%s.",
+        !geometry_dirty ? "no geometry update"
+                        : (topology_dirty ? "topology update" : "geometry refit"),
+        emitters_dirty ? ", emitter sampling update" : "");
+
+    if (geometry_dirty) {
         if constexpr (dr::is_cuda_v<Float>)
             accel_parameters_changed_gpu();
         else
@@ -500,6 +1122,8 @@ MI_VARIANT void Scene<Float, Spectrum>::parameters_changed(const std::vector<std
         m_bbox = {};
         for (auto &s : m_shapes)
             m_bbox.expand(s->bbox());
+
+        m_structure_version++;
     }
 
     // Check whether any shape parameters have gradient tracking enabled
@@ -512,13 +1136,11 @@ MI_VARIANT void Scene<Float, Spectrum>::parameters_changed(const std::vector<std
         }
     }
 
-    // Check if emitters were modified and we potentially need to update
-    // the emitter sampling distribution.
-    for (auto &e : m_emitters) {
-        if (e->dirty()) {
-            update_emitter_sampling_distribution();
-            break;
-        }
+    /* Emitters attached to modified shapes are marked as dirty as well, since
+       their bounds (e.g. in the light BVH) may have changed */
+    if (emitters_dirty) {
+        update_emitter_sampling_distribution();
+        m_structure_version++;
     }
 }
 
@@ -553,9 +1175,9 @@ MI_VARIANT void Scene<Float, Spectrum>::static_accel_shutdown() {
 
 MI_VARIANT void Scene<Float, Spectrum>::clear_shapes_dirty() {
     for (auto &s : m_shapes)
-        s->m_dirty = false;
+        s->m_dirty = s->m_topology_dirty = false;
     for (auto &s : m_shapegroups)
-        s->m_dirty = false;
+        s->m_dirty = s->m_topology_dirty = false;
 }
 
 MI_VARIANT void Scene<Float, Spectrum>::static_accel_initialization_cpu() { }
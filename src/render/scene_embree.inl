@@ -1,5 +1,6 @@
 #include <embree3/rtcore.h>
 #include <nanothread/nanothread.h>
+#include <mutex>
 #include <thread>
 
 NAMESPACE_BEGIN(mitsuba)
@@ -7,7 +8,9 @@ NAMESPACE_BEGIN(mitsuba)
 static_assert(sizeof(RTCIntersectContext) == 24 /* Dr.Jit assumes this */);
 
 static uint32_t embree_threads = 0;
-static RTCDevice embree_device = nullptr;
+static RTCDevice global_embree_device = nullptr;
+/// Protects the creation of the Embree device by concurrently loaded scenes
+static std::mutex embree_device_mutex;
 
 template <typename Float>
 struct EmbreeState {
@@ -16,12 +19,38 @@ struct EmbreeState {
     std::vector<int> geometries;
     DynamicBuffer<UInt32> shapes_registry_ids;
     bool is_nested_scene = false;
+    /// Refit the BVH after updates that only move the vertices of meshes
+    bool refit = false;
+    /// Number of Mitsuba thread pool workers that join BVH builds
+    uint32_t build_threads = 0;
 };
 
+/// Convert the value of an \c embree_build_quality parameter
+static RTCBuildQuality embree_build_quality(const std::string &value) {
+    if (value == "low")
+        return RTC_BUILD_QUALITY_LOW;
+    else if (value == "medium")
+        return RTC_BUILD_QUALITY_MEDIUM;
+    else if (value == "high")
+        return RTC_BUILD_QUALITY_HIGH;
+    else
+        Throw("embree_build_quality: invalid value \"%s\" (must be \"low\", "
+              "\"medium\" or \"high\")!", value);
+}
+
 static void embree_error_callback(void * /*user_ptr */, RTCError code, const char *str) {
     Log(Warn, "Embree device error %i: %s.", (int) code, str);
 }
 
+/// Accounts for the memory allocated by Embree (negative sizes are releases)
+static bool embree_memory_callback(void * /* user_ptr */, ssize_t bytes, bool /* post */) {
+    if (bytes > 0)
+        MemoryTracker::allocate(MemoryCategory::Embree, (size_t) bytes);
+    else if (bytes < 0)
+        MemoryTracker::release(MemoryCategory::Embree, (size_t) -bytes);
+    return true;
+}
+
 /// Wraps rtcOccluded16 when Dr.Jit operates on vectors of length 32
 void rtcOccluded32(const int *valid, RTCScene scene,
                    RTCIntersectContext *context, uint32_t *in) {
@@ -81,21 +110,31 @@ void rtcIntersect32(const int *valid, RTCScene scene,
     }
 }
 
-MI_VARIANT void
-Scene<Float, Spectrum>::accel_init_cpu(const Properties &props) {
-    if (!embree_device) {
+MI_VARIANT RTCDevice Scene<Float, Spectrum>::embree_device() {
+    std::lock_guard<std::mutex> device_guard(embree_device_mutex);
+    if (!global_embree_device) {
         // Tricky: Embree allows at most 2*hardware_concurrency() builder
         // threads due to allocation of a thread-local data structure in
         // taskschedulerinternal.h:233
+        // Since all of them are user threads, Embree does not start worker
+        // threads of its own: builds run on Mitsuba's thread pool, whose
+        // workers join them via rtcJoinCommitScene()
         uint32_t hw_concurrency = (uint32_t) std::thread::hardware_concurrency(),
                  pool_size = (uint32_t) ::pool_size();
         embree_threads = std::max((uint32_t) 1, std::min(pool_size, hw_concurrency*2));
 
         std::string config_str = tfm::format(
             "threads=%i,user_threads=%i", embree_threads, embree_threads);
-        embree_device = rtcNewDevice(config_str.c_str());
-        rtcSetDeviceErrorFunction(embree_device, embree_error_callback, nullptr);
+        global_embree_device = rtcNewDevice(config_str.c_str());
+        rtcSetDeviceErrorFunction(global_embree_device, embree_error_callback, nullptr);
+        rtcSetDeviceMemoryMonitorFunction(global_embree_device, embree_memory_callback, nullptr);
     }
+    return global_embree_device;
+}
+
+MI_VARIANT void
+Scene<Float, Spectrum>::accel_init_cpu(const Properties &props) {
+    RTCDevice device = embree_device();
 
     Timer timer;
 
@@ -110,10 +149,36 @@ Scene<Float, Spectrum>::accel_init_cpu(const Properties &props) {
         }
     }
 
-    s.accel = rtcNewScene(embree_device);
-    rtcSetSceneBuildQuality(s.accel, RTC_BUILD_QUALITY_HIGH);
+    /* Refitting requires a dynamic scene, whose two-level BVH is slightly
+       slower to traverse. It is therefore only enabled on request, e.g. for
+       animations or inverse rendering of deforming meshes. */
+    s.refit = props.get<bool>("embree_refit", false);
+
+    /* Quality of the BVH build ("low", "medium" or "high"). Lower qualities
+       build faster but trace slower, and "low" builds a two-level BVH that
+       respects the "embree_build_quality" parameter of individual shapes. */
+    RTCBuildQuality quality = embree_build_quality(
+        props.get<std::string>("embree_build_quality", "high"));
+
+    /* Reduce the memory footprint of the BVH at the cost of slightly slower
+       traversal */
+    bool compact = props.get<bool>("embree_compact", false);
+
+    /* Number of Mitsuba worker threads that join the BVH build (by default,
+       all of them). Leaving some threads free lets other tasks, such as
+       texture loading, continue while the BVH is built. */
+    s.build_threads = (uint32_t) props.get<int>("embree_build_threads", (int) embree_threads);
+    s.build_threads = std::max(1u, std::min(s.build_threads, embree_threads));
+
+    s.accel = rtcNewScene(device);
+    rtcSetSceneBuildQuality(s.accel, quality);
     bool use_robust = props.get<bool>("embree_use_robust_intersections", false);
-    rtcSetSceneFlags(s.accel, use_robust ? RTC_SCENE_FLAG_ROBUST : RTC_SCENE_FLAG_NONE);
+    int flags = use_robust ? RTC_SCENE_FLAG_ROBUST : RTC_SCENE_FLAG_NONE;
+    if (s.refit)
+        flags |= RTC_SCENE_FLAG_DYNAMIC;
+    if (compact)
+        flags |= RTC_SCENE_FLAG_COMPACT;
+    rtcSetSceneFlags(s.accel, (RTCSceneFlags) flags);
 
     ScopedPhase phase(ProfilerPhase::InitAccel);
     accel_parameters_changed_cpu();
@@ -141,14 +206,43 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_cpu() {
 
     EmbreeState<Float> &s = *(EmbreeState<Float> *) m_accel;
 
-    for (int geo : s.geometries)
-        rtcDetachGeometry(s.accel, geo);
-    s.geometries.clear();
-
-    for (Shape *shape : m_shapes) {
-        RTCGeometry geom = shape->embree_geometry(embree_device);
-        s.geometries.push_back(rtcAttachGeometry(s.accel, geom));
-        rtcReleaseGeometry(geom);
+    /* Only the vertex buffers need to be updated (followed by a refit of the
+       BVH) when no shape changed beyond the positions of its vertices */
+    bool refit = s.refit && s.geometries.size() == m_shapes.size();
+    for (Shape *shape : m_shapes)
+        refit &= !shape->topology_dirty();
+    for (ShapeGroup *shapegroup : m_shapegroups)
+        refit &= !shapegroup->dirty();
+
+    if (refit) {
+        for (size_t i = 0; i < m_shapes.size(); ++i) {
+            Shape *shape = m_shapes[i];
+            if (shape->dirty())
+                ((Mesh *) shape)->embree_update_geometry(
+                    rtcGetGeometry(s.accel, s.geometries[i]));
+        }
+    } else {
+        for (int geo : s.geometries)
+            rtcDetachGeometry(s.accel, geo);
+        s.geometries.clear();
+
+        /* Build the (changed) shape groups concurrently, so that their
+           instances below only reference the resulting Embree scenes */
+        build_shapegroups();
+
+        for (Shape *shape : m_shapes) {
+            RTCGeometry geom = shape->embree_geometry(global_embree_device);
+            if (s.refit && shape->is_mesh()) {
+                rtcSetGeometryBuildQuality(geom, RTC_BUILD_QUALITY_REFIT);
+                rtcCommitGeometry(geom);
+            } else if (!shape->embree_build_quality().empty()) {
+                rtcSetGeometryBuildQuality(
+                    geom, embree_build_quality(shape->embree_build_quality()));
+                rtcCommitGeometry(geom);
+            }
+            s.geometries.push_back(rtcAttachGeometry(s.accel, geom));
+            rtcReleaseGeometry(geom);
+        }
     }
 
     // Ensure shape data pointers are fully evaluated before building the BVH
@@ -160,7 +254,7 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_cpu() {
         rtcCommitScene(s.accel);
     } else {
         dr::parallel_for(
-            dr::blocked_range<size_t>(0, embree_threads, 1),
+            dr::blocked_range<size_t>(0, s.build_threads, 1),
             [&](const dr::blocked_range<size_t> &) {
                 rtcJoinCommitScene(s.accel);
             }
@@ -444,6 +538,13 @@ Scene<Float, Spectrum>::ray_test_cpu(const Ray3f &ray, Mask coherent, Mask activ
     }
 }
 
+MI_VARIANT void
+Scene<Float, Spectrum>::ray_test_multi_cpu(const Ray3f *rays, const Mask *active,
+                                           Mask *result, size_t count) const {
+    for (size_t i = 0; i < count; ++i)
+        result[i] = ray_test_cpu(rays[i], false, active[i]);
+}
+
 MI_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
 Scene<Float, Spectrum>::ray_intersect_naive_cpu(const Ray3f &ray,
                                                 Mask active) const {
@@ -3,19 +3,41 @@ NAMESPACE_BEGIN(mitsuba)
 template <typename Float, typename Spectrum>
 struct NativeState {
     MI_IMPORT_CORE_TYPES()
-    ShapeKDTree<Float, Spectrum> *accel;
+    /// Exactly one of the two acceleration data structures is used
+    ShapeKDTree<Float, Spectrum> *kdtree = nullptr;
+    ShapeBVH<Float, Spectrum> *bvh = nullptr;
     DynamicBuffer<UInt32> shapes_registry_ids;
+
+    /// Intersect a single ray against the acceleration data structure
+    template <bool ShadowRay, typename Ray>
+    MI_INLINE auto ray_intersect_scalar(const Ray &ray) const {
+        if (bvh)
+            return bvh->template ray_intersect_scalar<ShadowRay>(ray);
+        else
+            return kdtree->template ray_intersect_scalar<ShadowRay>(ray);
+    }
 };
 
 MI_VARIANT void Scene<Float, Spectrum>::accel_init_cpu(const Properties &props) {
-    ShapeKDTree *kdtree = new ShapeKDTree(props);
-    kdtree->inc_ref();
+    m_accel = new NativeState<Float, Spectrum>();
+    NativeState<Float, Spectrum> &s = *(NativeState<Float, Spectrum> *) m_accel;
+
+    /* Acceleration data structure used by the native CPU ray tracing backend:
+       "kdtree" (default), or a wide BVH with 4 ("bvh4") or 8 ("bvh8") children
+       per node */
+    std::string accel = props.get<std::string>("accel", "kdtree");
+    if (accel == "kdtree") {
+        s.kdtree = new ShapeKDTree(props);
+        s.kdtree->inc_ref();
+    } else if (accel == "bvh4" || accel == "bvh8") {
+        s.bvh = new ShapeBVH(props, accel == "bvh4" ? 4 : 8);
+        s.bvh->inc_ref();
+    } else {
+        Throw("Scene: unsupported acceleration data structure \"%s\" (must "
+              "be \"kdtree\", \"bvh4\" or \"bvh8\")!", accel);
+    }
 
     if constexpr (dr::is_llvm_v<Float>) {
-        m_accel = new NativeState<Float, Spectrum>();
-        NativeState<Float, Spectrum> &s = *(NativeState<Float, Spectrum> *) m_accel;
-        s.accel = kdtree;
-
         // Get shapes registry ids
         if (!m_shapes.empty()) {
             std::unique_ptr<uint32_t[]> data(new uint32_t[m_shapes.size()]);
@@ -26,10 +48,11 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_init_cpu(const Properties &props)
         } else {
             s.shapes_registry_ids = dr::zeros<DynamicBuffer<UInt32>>();
         }
-    } else {
-        m_accel = kdtree;
     }
 
+    // Build the shape groups concurrently before the top-level structure
+    build_shapegroups();
+
     accel_parameters_changed_cpu();
 }
 
@@ -38,17 +61,20 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_cpu() {
     if constexpr (dr::is_llvm_v<Float>)
         dr::sync_thread();
 
-    ShapeKDTree *kdtree;
-    if constexpr (dr::is_llvm_v<Float>)
-        kdtree = ((NativeState<Float, Spectrum> *) m_accel)->accel;
-    else
-        kdtree = (ShapeKDTree *) m_accel;
+    NativeState<Float, Spectrum> &s = *(NativeState<Float, Spectrum> *) m_accel;
 
-    kdtree->clear();
-    for (Shape *shape : m_shapes)
-        kdtree->add_shape(shape);
     ScopedPhase phase(ProfilerPhase::InitAccel);
-    kdtree->build();
+    if (s.bvh) {
+        s.bvh->clear();
+        for (Shape *shape : m_shapes)
+            s.bvh->add_shape(shape);
+        s.bvh->build();
+    } else {
+        s.kdtree->clear();
+        for (Shape *shape : m_shapes)
+            s.kdtree->add_shape(shape);
+        s.kdtree->build();
+    }
 
     /* Set up a callback on the handle variable to release the Embree
        acceleration data structure (IAS) when this variable is freed. This
@@ -59,18 +85,24 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_cpu() {
         // Prevents the IAS to be released when updating the scene parameters
         if (m_accel_handle.index())
             jit_var_set_callback(m_accel_handle.index(), nullptr, nullptr);
-        m_accel_handle = dr::opaque<UInt64>(kdtree);
+        m_accel_handle = dr::opaque<UInt64>(
+            s.bvh ? (Object *) s.bvh : (Object *) s.kdtree);
         jit_var_set_callback(
             m_accel_handle.index(),
             [](uint32_t /* index */, int free, void *payload) {
                 if (free) {
-                    // Free KDTree on another thread to avoid deadlock with Dr.Jit mutex
+                    // Free KDTree/BVH on another thread to avoid deadlock with Dr.Jit mutex
                     Task *task = dr::do_async([payload](){
-                        Log(Debug, "Free KDTree..");
+                        Log(Debug, "Free KDTree/BVH..");
                         NativeState<Float, Spectrum> *s =
                             (NativeState<Float, Spectrum> *) payload;
-                        s->accel->clear();
-                        s->accel->dec_ref();
+                        if (s->bvh) {
+                            s->bvh->clear();
+                            s->bvh->dec_ref();
+                        } else {
+                            s->kdtree->clear();
+                            s->kdtree->dec_ref();
+                        }
                         delete s;
                     });
                     Thread::register_task(task);
@@ -93,7 +125,12 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_release_cpu() {
            ray tracing calls are pending. */
         m_accel_handle = 0;
     } else {
-        ((ShapeKDTree *) m_accel)->dec_ref();
+        NativeState<Float, Spectrum> *s = (NativeState<Float, Spectrum> *) m_accel;
+        if (s->bvh)
+            s->bvh->dec_ref();
+        else
+            s->kdtree->dec_ref();
+        delete s;
     }
 
     m_accel = nullptr;
@@ -118,18 +155,24 @@ template <typename ScalarFloat> struct RayHitT {
 
 template <typename Float, typename Spectrum, bool ShadowRay, size_t Width>
 void kdtree_trace_func_wrapper(const int *valid, void *ptr,
-                               void* /* context */, uint8_t *args) {
+                               void *context, uint8_t *args) {
     MI_IMPORT_TYPES()
     using ScalarRay3f = Ray<ScalarPoint3f, Spectrum>;
-    using ShapeKDTree = ShapeKDTree<Float, Spectrum>;
+    using ScalarPreliminaryIntersection3f =
+        PreliminaryIntersection<ScalarFloat, Shape>;
 
-    NativeState<Float, Spectrum> *s = (NativeState<Float, Spectrum> *) ptr;
-    const ShapeKDTree *kdtree = s->accel;
+    const NativeState<Float, Spectrum> *s = (const NativeState<Float, Spectrum> *) ptr;
     using RayHit = RayHitT<ScalarFloat>;
 
+    ScalarRay3f rays[Width];
+    bool active[Width];
+    size_t active_count = 0;
+
     for (size_t i = 0; i < Width; i++) {
-        if (valid[i] == 0)
+        active[i] = valid[i] != 0;
+        if (!active[i])
             continue;
+        active_count++;
 
         ScalarPoint3f ray_o;
         ray_o[0] = ((ScalarFloat*) &args[offsetof(RayHit, o_x) * Width])[i];
@@ -141,34 +184,57 @@ void kdtree_trace_func_wrapper(const int *valid, void *ptr,
         ray_d[1] = ((ScalarFloat*) &args[offsetof(RayHit, d_y) * Width])[i];
         ray_d[2] = ((ScalarFloat*) &args[offsetof(RayHit, d_z) * Width])[i];
 
-        ScalarFloat& ray_maxt = ((ScalarFloat*) &args[offsetof(RayHit, tfar) * Width])[i];
-        ScalarFloat& ray_time = ((ScalarFloat*) &args[offsetof(RayHit, time) * Width])[i];
+        ScalarFloat ray_maxt = ((ScalarFloat*) &args[offsetof(RayHit, tfar) * Width])[i];
+        ScalarFloat ray_time = ((ScalarFloat*) &args[offsetof(RayHit, time) * Width])[i];
 
-        ScalarRay3f ray = ScalarRay3f(ray_o, ray_d, ray_maxt, ray_time, wavelength_t<Spectrum>());
+        rays[i] = ScalarRay3f(ray_o, ray_d, ray_maxt, ray_time, wavelength_t<Spectrum>());
+    }
 
-        if constexpr (ShadowRay) {
-            bool hit = kdtree->template ray_intersect_scalar<true>(ray).is_valid();
-            if (hit)
-                ray_maxt = 0.f;
+    /* Dr.Jit passes an Embree-style intersection context, whose first field
+       holds the flags (RTC_INTERSECT_CONTEXT_FLAG_COHERENT == 1) */
+    bool coherent = context && (*(const uint32_t *) context & 1u) != 0;
+
+    ScalarPreliminaryIntersection3f pi[Width];
+    if constexpr (Width > 1) {
+        if (coherent && active_count > 1 && s->kdtree &&
+            s->kdtree->coherent_traversal()) {
+            s->kdtree->template ray_intersect_packet<Width, ShadowRay>(rays, active, pi);
         } else {
-            auto pi = kdtree->template ray_intersect_scalar<false>(ray);
-            if (pi.is_valid()) {
-                ScalarFloat& prim_u = ((ScalarFloat*) &args[offsetof(RayHit, u) * Width])[i];
-                ScalarFloat& prim_v = ((ScalarFloat*) &args[offsetof(RayHit, v) * Width])[i];
-                uint32_t& prim_id = ((uint32_t*) &args[offsetof(RayHit, prim_id) * Width])[i];
-                uint32_t& geom_id = ((uint32_t*) &args[offsetof(RayHit, geom_id) * Width])[i];
-                uint32_t& inst_id = ((uint32_t*) &args[offsetof(RayHit, inst_id) * Width])[i];
-
-                // Write outputs
-                ray_maxt  = pi.t;
-                prim_u = pi.prim_uv[0];
-                prim_v = pi.prim_uv[1];
-                prim_id = pi.prim_index;
-                geom_id = pi.shape_index;
-                inst_id = pi.instance ? (uint32_t) (size_t) pi.shape // shape_index
-                                      : (uint32_t) -1;
+            for (size_t i = 0; i < Width; i++) {
+                if (active[i])
+                    pi[i] = s->template ray_intersect_scalar<ShadowRay>(rays[i]);
             }
         }
+    } else {
+        DRJIT_MARK_USED(coherent);
+        if (active[0])
+            pi[0] = s->template ray_intersect_scalar<ShadowRay>(rays[0]);
+    }
+
+    for (size_t i = 0; i < Width; i++) {
+        if (!active[i] || !pi[i].is_valid())
+            continue;
+
+        ScalarFloat& ray_maxt = ((ScalarFloat*) &args[offsetof(RayHit, tfar) * Width])[i];
+
+        if constexpr (ShadowRay) {
+            ray_maxt = 0.f;
+        } else {
+            ScalarFloat& prim_u = ((ScalarFloat*) &args[offsetof(RayHit, u) * Width])[i];
+            ScalarFloat& prim_v = ((ScalarFloat*) &args[offsetof(RayHit, v) * Width])[i];
+            uint32_t& prim_id = ((uint32_t*) &args[offsetof(RayHit, prim_id) * Width])[i];
+            uint32_t& geom_id = ((uint32_t*) &args[offsetof(RayHit, geom_id) * Width])[i];
+            uint32_t& inst_id = ((uint32_t*) &args[offsetof(RayHit, inst_id) * Width])[i];
+
+            // Write outputs
+            ray_maxt  = pi[i].t;
+            prim_u = pi[i].prim_uv[0];
+            prim_v = pi[i].prim_uv[1];
+            prim_id = pi[i].prim_index;
+            geom_id = pi[i].shape_index;
+            inst_id = pi[i].instance ? (uint32_t) (size_t) pi[i].shape // shape_index
+                                     : (uint32_t) -1;
+        }
     }
 }
 
@@ -178,8 +244,12 @@ Scene<Float, Spectrum>::ray_intersect_preliminary_cpu(const Ray3f &ray,
                                                       Mask active) const {
     if constexpr (!dr::is_array_v<Float>) {
         DRJIT_MARK_USED(coherent);
-        const ShapeKDTree *kdtree = (const ShapeKDTree *) m_accel;
-        return kdtree->template ray_intersect_preliminary<false>(ray, active);
+        const NativeState<Float, Spectrum> *s =
+            (const NativeState<Float, Spectrum> *) m_accel;
+        if (s->bvh)
+            return s->bvh->template ray_intersect_preliminary<false>(ray, active);
+        else
+            return s->kdtree->template ray_intersect_preliminary<false>(ray, active);
     } else {
         NativeState<Float, Spectrum> *s = (NativeState<Float, Spectrum> *) m_accel;
         void *func_ptr = nullptr,
@@ -266,8 +336,12 @@ Scene<Float, Spectrum>::ray_test_cpu(const Ray3f &ray,
                                      Mask coherent, Mask active) const {
     if constexpr (!dr::is_jit_v<Float>) {
         DRJIT_MARK_USED(coherent);
-        const ShapeKDTree *kdtree = (const ShapeKDTree *) m_accel;
-        return kdtree->template ray_intersect_preliminary<true>(ray, active).is_valid();
+        const NativeState<Float, Spectrum> *s =
+            (const NativeState<Float, Spectrum> *) m_accel;
+        if (s->bvh)
+            return s->bvh->template ray_intersect_preliminary<true>(ray, active).is_valid();
+        else
+            return s->kdtree->template ray_intersect_preliminary<true>(ray, active).is_valid();
     } else {
         void *func_ptr = nullptr, *scene_ptr = m_accel;
 
@@ -306,16 +380,58 @@ Scene<Float, Spectrum>::ray_test_cpu(const Ray3f &ray,
     }
 }
 
+MI_VARIANT void
+Scene<Float, Spectrum>::ray_test_multi_cpu(const Ray3f *rays, const Mask *active,
+                                           Mask *result, size_t count) const {
+    if constexpr (!dr::is_jit_v<Float>) {
+        const NativeState<Float, Spectrum> *s =
+            (const NativeState<Float, Spectrum> *) m_accel;
+
+        /* The rays usually share their origin, hence the packet traversal
+           does not diverge before the lower levels of the kd-tree (where it
+           falls back to tracing the remaining lanes independently) */
+        auto trace_packets = [&](auto width) {
+            constexpr size_t Width = decltype(width)::value;
+            for (size_t i = 0; i < count; i += Width) {
+                size_t n = std::min(Width, count - i);
+
+                // Pad the last packet with disabled copies of its last ray
+                Ray3f packet[Width];
+                bool valid[Width];
+                PreliminaryIntersection3f pi[Width];
+                for (size_t k = 0; k < Width; ++k) {
+                    packet[k] = rays[i + std::min(k, n - 1)];
+                    valid[k] = k < n && active[i + k];
+                }
+
+                s->kdtree->template ray_intersect_packet<Width, true>(packet, valid, pi);
+
+                for (size_t k = 0; k < n; ++k)
+                    result[i + k] = valid[k] && pi[k].is_valid();
+            }
+        };
+
+        if (s->kdtree && count > 1) {
+            if (count <= 4)
+                trace_packets(std::integral_constant<size_t, 4>());
+            else
+                trace_packets(std::integral_constant<size_t, 8>());
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+        result[i] = ray_test_cpu(rays[i], false, active[i]);
+}
+
 MI_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
 Scene<Float, Spectrum>::ray_intersect_naive_cpu(const Ray3f &ray, Mask active) const {
-    const ShapeKDTree *kdtree;
-    if constexpr (dr::is_llvm_v<Float>)
-        kdtree = ((NativeState<Float, Spectrum> *) m_accel)->accel;
-    else
-        kdtree = (const ShapeKDTree *) m_accel;
+    const NativeState<Float, Spectrum> *s =
+        (const NativeState<Float, Spectrum> *) m_accel;
 
     PreliminaryIntersection3f pi =
-        kdtree->template ray_intersect_naive<false>(ray, active);
+        s->bvh ? s->bvh->template ray_intersect_naive<false>(ray, active)
+               : s->kdtree->template ray_intersect_naive<false>(ray, active);
 
     return pi.compute_surface_interaction(ray, +RayFlags::All, active);
 }
@@ -1,6 +1,9 @@
 #include <iomanip>
 #include <cstring>
 #include <cstdio>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
 
 #include <drjit-core/optix.h>
 
@@ -32,7 +35,17 @@ struct OptixSceneState {
     struct InstanceData {
         void* buffer = nullptr;  // Device-visible storage for IAS
         void* inputs = nullptr;  // Device-visible storage for OptixInstance array
+        size_t buffer_size = 0;  // Size of the IAS
+        MemoryAllocation memory { MemoryCategory::OptiX };
     } ias_data;
+    /// Number of instances in the IAS
+    size_t ias_count = 0;
+    /// Number of consecutive IAS updates (refits) since the last full build
+    uint32_t ias_update_count = 0;
+    /// Maximum number of consecutive IAS updates before a full rebuild
+    uint32_t ias_max_updates = 0;
+    /// Share identical GASes with other scenes via the process-wide GAS cache
+    bool gas_cache = false;
     size_t config_index;
     uint32_t sbt_jit_index;
 };
@@ -45,6 +58,10 @@ struct OptixSceneState {
  * requirements. This data structure hold those OptiX pipeline components for a
  * specific configuration, which can be shared across multiple scenes.
  *
+ * Only the program groups of the shape types in \c shape_types are created
+ * and linked into the pipeline, the entries of \c program_groups for the
+ * other types are \c nullptr.
+ *
  * \ref Scene::static_accel_shutdown is responsible for freeing those programs.
  */
 struct OptixConfig {
@@ -53,30 +70,67 @@ struct OptixConfig {
     OptixModule main_module;
     OptixModule bspline_curve_module; /// Built-in module for B-spline curves
     OptixModule linear_curve_module; /// Built-in module for linear curves
+    OptixModule sphere_module; /// Built-in module for spheres
     OptixProgramGroup program_groups[PROGRAM_GROUP_COUNT];
+    /// Program groups linked into the pipeline (the non-null \c program_groups)
+    OptixProgramGroup pipeline_program_groups[PROGRAM_GROUP_COUNT];
+    uint32_t pipeline_program_group_count;
     char *custom_shapes_program_names[2 * OPTIX_SHAPE_TYPE_COUNT];
+    /// Bit mask of the OptiX shape types supported by the pipeline
+    uint32_t shape_types;
     uint32_t pipeline_jit_index;
 };
 
-// Array storing previously initialized optix configurations
-static constexpr int32_t OPTIX_CONFIG_COUNT = 32;
-static OptixConfig optix_configs[OPTIX_CONFIG_COUNT] = {};
+/* Previously initialized optix configurations, indexed by a key covering the
+   device and the required set of features (including the shape types).
+   OptiX modules and pipelines belong to the context of a specific device,
+   hence every device has its own set of configurations. A deque keeps the
+   references to configurations valid when new ones are added. */
+static std::mutex optix_configs_mutex;
+static std::deque<OptixConfig> optix_configs;
+static std::unordered_map<uint64_t, size_t> optix_config_indices;
+
+/// Return the configuration with the given index (see \ref init_optix_config())
+const OptixConfig &optix_config(size_t config_index) {
+    std::lock_guard<std::mutex> guard(optix_configs_mutex);
+    return optix_configs[config_index];
+}
 
 size_t init_optix_config(bool has_meshes, bool has_others, bool has_instances,
-                         bool has_bspline_curves, bool has_linear_curves) {
-    // Compute config index in optix_configs based on required set of features
-    size_t config_index =
-        (has_bspline_curves ? 16 : 0) +
-        (has_linear_curves ? 8 : 0) +
-        (has_instances ? 4 : 0) +
-        (has_meshes ? 2 : 0) +
-        (has_others ? 1 : 0);
-
-    OptixConfig &config = optix_configs[config_index];
-
-    // Initialize Optix config if necessary
-    if (!config.main_module) {
-        Log(Debug, "Initialize Optix configuration (index=%zu)..", config_index);
+                         bool has_bspline_curves, bool has_linear_curves,
+                         bool has_spheres, bool has_motion,
+                         uint32_t shape_types) {
+    static_assert(OPTIX_SHAPE_TYPE_COUNT <= 24);
+
+    int device = jit_cuda_device();
+    if (device < 0)
+        Throw("init_optix_config(): invalid CUDA device %i!", device);
+
+    // Compute the key of the configuration based on required set of features
+    uint64_t key =
+        ((uint64_t) shape_types << 8) |
+        (has_spheres ? 64 : 0) |
+        (has_motion ? 32 : 0) |
+        (has_bspline_curves ? 16 : 0) |
+        (has_linear_curves ? 8 : 0) |
+        (has_instances ? 4 : 0) |
+        (has_meshes ? 2 : 0) |
+        (has_others ? 1 : 0) |
+        ((uint64_t) device << 32);
+
+    std::lock_guard<std::mutex> guard(optix_configs_mutex);
+    auto it = optix_config_indices.find(key);
+    if (it != optix_config_indices.end())
+        return it->second;
+
+    size_t config_index = optix_configs.size();
+    OptixConfig &config = optix_configs.emplace_back();
+    config.shape_types = shape_types;
+
+    // Initialize Optix config
+    {
+        Log(Debug, "Initialize Optix configuration (index=%zu, shape "
+            "types=%#04x)..", config_index, shape_types);
 
         config.context = jit_optix_context();
 
@@ -94,7 +148,8 @@ size_t init_optix_config(bool has_meshes, bool has_others, bool has_instances,
         module_compile_options.debugLevel       = OPTIX_COMPILE_DEBUG_LEVEL_FULL;
     #endif
 
-        config.pipeline_compile_options.usesMotionBlur     = false;
+        // Motion transforms of instances must be enabled in the pipeline
+        config.pipeline_compile_options.usesMotionBlur     = has_motion;
         config.pipeline_compile_options.numPayloadValues   = 6;
         config.pipeline_compile_options.numAttributeValues = 2; // the minimum legal value
         config.pipeline_compile_options.pipelineLaunchParamsVariableName = "params";
@@ -102,7 +157,7 @@ size_t init_optix_config(bool has_meshes, bool has_others, bool has_instances,
         bool at_least_two_gas = [&]() {
             uint32_t counter = 0;
             for (bool has_gas : { has_meshes, has_bspline_curves,
-                                  has_linear_curves, has_others })
+                                  has_linear_curves, has_spheres, has_others })
                 if (has_gas)
                     if (++counter >= 2)
                         return true;
@@ -136,6 +191,8 @@ size_t init_optix_config(bool has_meshes, bool has_others, bool has_instances,
             prim_flags |= OPTIX_PRIMITIVE_TYPE_FLAGS_ROUND_CUBIC_BSPLINE;
         if (has_linear_curves)
             prim_flags |= OPTIX_PRIMITIVE_TYPE_FLAGS_ROUND_LINEAR;
+        if (has_spheres)
+            prim_flags |= OPTIX_PRIMITIVE_TYPE_FLAGS_SPHERE;
 
         config.pipeline_compile_options.usesPrimitiveTypeFlags = prim_flags;
 
@@ -200,7 +257,7 @@ size_t init_optix_config(bool has_meshes, bool has_others, bool has_instances,
                   "compilation state is: %#06x", compilation_state);
 
         // =====================================================
-        // Load built-in Optix modules for curves
+        // Load built-in Optix modules for curves and spheres
         // =====================================================
 
         if (has_bspline_curves) {
@@ -229,6 +286,18 @@ size_t init_optix_config(bool has_meshes, bool has_others, bool has_instances,
                                         &config.pipeline_compile_options,
                                         &options, &config.linear_curve_module));
         }
+        if (has_spheres) {
+            OptixBuiltinISOptions options = {};
+            options.builtinISModuleType = OPTIX_PRIMITIVE_TYPE_SPHERE;
+            options.usesMotionBlur      = false;
+            // buildFlags must match the flags used in OptixAccelBuildOptions (shapes.h)
+            options.buildFlags          = OPTIX_BUILD_FLAG_ALLOW_COMPACTION |
+                                          OPTIX_BUILD_FLAG_PREFER_FAST_TRACE;
+            jit_optix_check(
+                optixBuiltinISModuleGet(config.context, &module_compile_options,
+                                        &config.pipeline_compile_options,
+                                        &options, &config.sphere_module));
+        }
 
         // =====================================================
         // Create program groups (raygen provided by Dr.Jit..)
@@ -237,6 +306,14 @@ size_t init_optix_config(bool has_meshes, bool has_others, bool has_instances,
         OptixProgramGroupOptions program_group_options = {};
         OptixProgramGroupDesc pgd[PROGRAM_GROUP_COUNT] {};
 
+        /* Only describe the program groups of the shape types present in the
+           scene, the slot of each group in 'program_groups' is recorded in
+           'pgd_slot'. This avoids compiling and linking the intersection and
+           closest hit programs of all shape types for every configuration. */
+        size_t pgd_slot[PROGRAM_GROUP_COUNT], pgd_count = 2;
+        pgd_slot[0] = 0;
+        pgd_slot[1] = 1;
+
         pgd[0].kind                         = OPTIX_PROGRAM_GROUP_KIND_MISS;
         pgd[0].miss.module                  = config.main_module;
         pgd[0].miss.entryFunctionName       = "__miss__ms";
@@ -245,46 +322,63 @@ size_t init_optix_config(bool has_meshes, bool has_others, bool has_instances,
         pgd[1].hitgroup.entryFunctionNameCH = "__closesthit__mesh";
 
         for (size_t i = 0; i < OPTIX_SHAPE_TYPE_COUNT; i++) {
-            pgd[2+i].kind = OPTIX_PROGRAM_GROUP_KIND_HITGROUP;
+            config.custom_shapes_program_names[2*i]   = nullptr;
+            config.custom_shapes_program_names[2*i+1] = nullptr;
+            config.program_groups[2+i] = nullptr;
+            if ((shape_types & (1u << i)) == 0)
+                continue;
+
+            OptixProgramGroupDesc &desc = pgd[pgd_count];
+            pgd_slot[pgd_count++] = 2 + i;
+            desc.kind = OPTIX_PROGRAM_GROUP_KIND_HITGROUP;
 
             OptixShapeType optix_shape_type = OPTIX_SHAPE_ORDER[i];
             OptixShape& optix_shape = OPTIX_SHAPES.at(optix_shape_type);
 
-            config.custom_shapes_program_names[2*i]   = strdup(optix_shape.ch_name().c_str());
-            if (optix_shape.is_builtin)
-                config.custom_shapes_program_names[2*i+1] = nullptr;
-            else
+            /* Spheres use the built-in intersection program only when this
+               configuration has built-in spheres, and the custom one otherwise */
+            bool is_builtin = optix_shape.is_builtin ||
+                              (optix_shape_type == Sphere && has_spheres);
+
+            config.custom_shapes_program_names[2*i] = strdup(optix_shape.ch_name().c_str());
+            if (!is_builtin)
                 config.custom_shapes_program_names[2*i+1] = strdup(optix_shape.is_name().c_str());
 
-            pgd[2+i].hitgroup.moduleCH            = config.main_module;
-            pgd[2+i].hitgroup.entryFunctionNameCH = config.custom_shapes_program_names[2*i];
-            pgd[2+i].hitgroup.entryFunctionNameIS = config.custom_shapes_program_names[2*i+1];
-            if (optix_shape.is_builtin) {
+            desc.hitgroup.moduleCH            = config.main_module;
+            desc.hitgroup.entryFunctionNameCH = config.custom_shapes_program_names[2*i];
+            desc.hitgroup.entryFunctionNameIS = config.custom_shapes_program_names[2*i+1];
+            if (is_builtin) {
                 switch(optix_shape_type) {
                     case BSplineCurve:
-                        pgd[2 + i].hitgroup.moduleIS = config.bspline_curve_module; break;
+                        desc.hitgroup.moduleIS = config.bspline_curve_module; break;
                     case LinearCurve:
-                        pgd[2 + i].hitgroup.moduleIS = config.linear_curve_module; break;
+                        desc.hitgroup.moduleIS = config.linear_curve_module; break;
+                    case Sphere:
+                        desc.hitgroup.moduleIS = config.sphere_module; break;
                     default:
                         Throw("Unknown builtin OptiX shape type: \"%s\"!",
                               OPTIX_SHAPE_TYPE_NAMES[optix_shape_type]);
                 }
             }
             else
-                pgd[2+i].hitgroup.moduleIS = config.main_module;
+                desc.hitgroup.moduleIS = config.main_module;
         }
 
         optix_log_size = sizeof(optix_log);
         check_log(optixProgramGroupCreate(
             config.context,
             pgd,
-            PROGRAM_GROUP_COUNT,
+            (unsigned int) pgd_count,
             &program_group_options,
             optix_log,
             &optix_log_size,
-            config.program_groups
+            config.pipeline_program_groups
         ));
 
+        config.pipeline_program_group_count = (uint32_t) pgd_count;
+        for (size_t i = 0; i < pgd_count; i++)
+            config.program_groups[pgd_slot[i]] = config.pipeline_program_groups[i];
+
         // Create this variable in the JIT scope 0 to ensure a consistent
         // ordering in the generated PTX kernel (e.g. for other scenes).
         uint32_t scope = jit_scope(JitBackend::CUDA);
@@ -292,11 +386,12 @@ size_t init_optix_config(bool has_meshes, bool has_others, bool has_instances,
         config.pipeline_jit_index = jit_optix_configure_pipeline(
             &config.pipeline_compile_options,
             config.main_module,
-            config.program_groups, PROGRAM_GROUP_COUNT
+            config.pipeline_program_groups, config.pipeline_program_group_count
         );
         jit_set_scope(JitBackend::CUDA, scope);
     }
 
+    optix_config_indices[key] = config_index;
     return config_index;
 }
 
@@ -311,6 +406,28 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &props)
         m_accel = new OptixSceneState();
         OptixSceneState &s = *(OptixSceneState *) m_accel;
 
+        /* When only the transforms of instances change, the IAS is updated
+           (refitted) in place instead of being rebuilt. Since the quality of
+           the IAS degrades with every update, a full rebuild is performed
+           after this many consecutive updates (0 disables updates). */
+        s.ias_max_updates = props.get<uint32_t>("optix_ias_max_updates", 16);
+
+        /* Look up the geometry acceleration structures (GAS) of this scene in
+           a process-wide cache, so that scenes sharing the same geometry (e.g.
+           when a scene is loaded repeatedly) also share the GAS in device
+           memory. Computing the cache keys requires reading back the geometry
+           from the device, hence this is disabled by default. */
+        s.gas_cache = props.get<bool>("optix_gas_cache", false);
+
+        /* Compiled OptiX modules are stored in the OptiX disk cache, so that
+           other processes using the same configuration skip the compilation */
+        optix_configure_disk_cache(props.get<bool>("optix_disk_cache", true),
+                                   props.string("optix_cache_path", ""));
+
+        /* The pipeline only contains the programs of the shape types in the
+           scene, unless it must be shared with scenes that have other ones */
+        bool prune_pipeline = props.get<bool>("optix_prune_pipeline", true);
+
         // Check if another scene was passed to the constructor
         Scene *other_scene = nullptr;
         for (auto &[k, v] : props.objects()) {
@@ -327,7 +444,17 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &props)
             Log(Debug, "Re-use OptiX config, pipeline and update SBT ..");
             OptixSceneState &s2 = *(OptixSceneState *) other_scene->m_accel;
 
-            const OptixConfig &config = optix_configs[s2.config_index];
+            const OptixConfig &config = optix_config(s2.config_index);
+
+            // The pipeline of the other scene must cover the shapes of this one
+            uint32_t shape_types = optix_shape_types(m_shapes);
+            for (auto& shapegroup: m_shapegroups)
+                shape_types |= shapegroup->optix_shape_types();
+            if ((shape_types & ~config.shape_types) != 0)
+                Throw("Scene: cannot share the OptiX pipeline of another scene "
+                      "that doesn't contain all shape types of this scene! "
+                      "Set \"optix_prune_pipeline\" to false in the other "
+                      "scene to include the programs of all shape types.");
 
             HitGroupSbtRecord* prev_data
                 = (HitGroupSbtRecord*) jit_malloc_migrate(s2.sbt.hitgroupRecordBase, AllocType::Host, 1);
@@ -371,6 +498,8 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &props)
             bool has_instances = false;
             bool has_bspline_curves = false;
             bool has_linear_curves = false;
+            bool has_spheres = false;
+            bool has_motion = false;
 
             for (auto& shape : m_shapes) {
                 uint32_t type = shape->shape_type();
@@ -379,19 +508,30 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &props)
                 has_instances        |= (type == +ShapeType::Instance);
                 has_bspline_curves   |= (type == +ShapeType::BSplineCurve);
                 has_linear_curves    |= (type == +ShapeType::LinearCurve);
+                has_spheres          |= (type == +ShapeType::Sphere);
                 has_others           |= !shape->is_mesh() && !shape->is_instance();
+                has_motion           |= shape->has_motion();
             }
 
+            uint32_t shape_types = optix_shape_types(m_shapes);
             for (auto& shape : m_shapegroups) {
                 has_meshes |= shape->has_meshes();
                 has_bspline_curves |= shape->has_bspline_curves();
                 has_linear_curves |= shape->has_linear_curves();
+                has_spheres |= shape->has_spheres();
                 has_others |= shape->has_others();
+                shape_types |= shape->optix_shape_types();
             }
+            if (!prune_pipeline)
+                shape_types = (1u << OPTIX_SHAPE_TYPE_COUNT) - 1;
+
+            // Spheres are traced with a custom program on older OptiX versions
+            has_spheres &= optix_builtin_spheres();
 
             s.config_index = init_optix_config(has_meshes, has_others,
-                has_instances, has_bspline_curves, has_linear_curves);
-            const OptixConfig &config = optix_configs[s.config_index];
+                has_instances, has_bspline_curves, has_linear_curves,
+                has_spheres, has_motion, shape_types);
+            const OptixConfig &config = optix_config(s.config_index);
 
             // =====================================================
             //  Shader Binding Table generation
@@ -442,13 +582,40 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_gpu() {
     if constexpr (dr::is_cuda_v<Float>) {
         dr::sync_thread();
         OptixSceneState &s = *(OptixSceneState *) m_accel;
-        const OptixConfig &config = optix_configs[s.config_index];
+        const OptixConfig &config = optix_config(s.config_index);
 
         if (!m_shapes.empty()) {
-            // Build geometry acceleration structures for all the shapes
-            build_gas(config.context, m_shapes, s.accel);
-            for (auto& shapegroup: m_shapegroups)
-                shapegroup->optix_build_gas(config.context);
+            /* Check whether the update only concerns instance transforms, in
+               which case the GAS are kept and the IAS is refitted */
+            bool has_instances = false, update_ias = s.ias_data.buffer &&
+                s.ias_update_count < s.ias_max_updates;
+            for (Shape *shape : m_shapes) {
+                has_instances |= shape->is_instance();
+                update_ias &= !shape->dirty() || shape->is_instance();
+            }
+            for (ShapeGroup *shapegroup : m_shapegroups)
+                update_ias &= !shapegroup->dirty();
+            update_ias &= has_instances;
+
+            if (!update_ias) {
+                // Build geometry acceleration structures for all the shapes
+                OptixGASStatistics stats;
+                build_gas(config.context, m_shapes, s.accel, s.gas_cache, &stats);
+                for (auto& shapegroup: m_shapegroups)
+                    shapegroup->optix_build_gas(config.context, s.gas_cache, &stats);
+
+                if (stats.count > 0)
+                    Log(Info, "OptiX GAS memory: %s after compaction (%s "
+                        "before, %zu GAS, %zu reused from the GAS cache).",
+                        util::mem_string(stats.compacted_size),
+                        util::mem_string(stats.output_size), stats.count,
+                        stats.cache_hits);
+                if (s.gas_cache) {
+                    auto [cache_count, cache_size] = optix_gas_cache_usage();
+                    Log(Debug, "OptiX GAS cache: %zu GAS (%s).", cache_count,
+                        util::mem_string(cache_size));
+                }
+            }
 
             // Gather information about the instance acceleration structures to be built
             std::vector<OptixInstance> ias;
@@ -465,19 +632,27 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_gpu() {
 
                 // Build a "master" IAS that contains all the IAS of the scene (meshes,
                 // custom shapes, instances, ...)
+                update_ias &= ias.size() == s.ias_count;
+
                 OptixAccelBuildOptions accel_options = {};
                 accel_options.buildFlags = OPTIX_BUILD_FLAG_PREFER_FAST_TRACE;
-                accel_options.operation  = OPTIX_BUILD_OPERATION_BUILD;
+                if (has_instances && s.ias_max_updates > 0)
+                    accel_options.buildFlags |= OPTIX_BUILD_FLAG_ALLOW_UPDATE;
+                accel_options.operation  = update_ias ? OPTIX_BUILD_OPERATION_UPDATE
+                                                      : OPTIX_BUILD_OPERATION_BUILD;
                 accel_options.motionOptions.numKeys = 0;
 
                 size_t ias_data_size = ias.size() * sizeof(OptixInstance);
                 void* d_ias = jit_malloc(AllocType::HostPinned, ias_data_size);
                 jit_memcpy_async(JitBackend::CUDA, d_ias, ias.data(), ias_data_size);
 
-                jit_free(s.ias_data.buffer);
+                if (!update_ias) {
+                    jit_free(s.ias_data.buffer);
+                    s.ias_data.buffer = nullptr;
+                }
                 jit_free(s.ias_data.inputs);
-                s.ias_data = {};
                 s.ias_data.inputs = jit_malloc_migrate(d_ias, AllocType::Device, 1);
+                s.ias_count = ias.size();
 
                 OptixBuildInput build_input;
                 build_input.type = OPTIX_BUILD_INPUT_TYPE_INSTANCES;
@@ -493,10 +668,15 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_gpu() {
                     &buffer_sizes
                 ));
 
-                void* d_temp_buffer
-                    = jit_malloc(AllocType::Device, buffer_sizes.tempSizeInBytes);
-                s.ias_data.buffer
-                    = jit_malloc(AllocType::Device, buffer_sizes.outputSizeInBytes);
+                size_t temp_size = update_ias ? buffer_sizes.tempUpdateSizeInBytes
+                                              : buffer_sizes.tempSizeInBytes;
+                void* d_temp_buffer = jit_malloc(AllocType::Device, temp_size);
+                if (!update_ias) {
+                    s.ias_data.buffer
+                        = jit_malloc(AllocType::Device, buffer_sizes.outputSizeInBytes);
+                    s.ias_data.buffer_size = buffer_sizes.outputSizeInBytes;
+                }
+                s.ias_data.memory.set(s.ias_data.buffer_size + ias_data_size, true);
 
                 jit_optix_check(optixAccelBuild(
                     config.context,
@@ -505,7 +685,7 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_gpu() {
                     &build_input,
                     1, // num build inputs
                     (CUdeviceptr)d_temp_buffer,
-                    buffer_sizes.tempSizeInBytes,
+                    temp_size,
                     (CUdeviceptr)s.ias_data.buffer,
                     buffer_sizes.outputSizeInBytes,
                     &s.ias_handle,
@@ -514,6 +694,10 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_gpu() {
                 ));
 
                 jit_free(d_temp_buffer);
+
+                s.ias_update_count = update_ias ? s.ias_update_count + 1 : 0;
+                Log(Debug, "OptiX IAS %s (%zu instances).",
+                    update_ias ? "updated" : "built", ias.size());
             }
         }
 
@@ -574,8 +758,8 @@ MI_VARIANT void Scene<Float, Spectrum>::static_accel_initialization_gpu() { }
 MI_VARIANT void Scene<Float, Spectrum>::static_accel_shutdown_gpu() {
     if constexpr (dr::is_cuda_v<Float>) {
         Log(Debug, "Scene static GPU acceleration shutdown ..");
-        for (size_t j = 0; j < OPTIX_CONFIG_COUNT; j++) {
-            OptixConfig &config = optix_configs[j];
+        std::lock_guard<std::mutex> guard(optix_configs_mutex);
+        for (OptixConfig &config : optix_configs) {
             if (config.pipeline_jit_index) {
                 /* Decrease the reference count of the pipeline JIT variable.
                    This will trigger the release of the OptiX pipeline data
@@ -588,6 +772,8 @@ MI_VARIANT void Scene<Float, Spectrum>::static_accel_shutdown_gpu() {
                 config.pipeline_jit_index = 0;
             }
         }
+        optix_configs.clear();
+        optix_config_indices.clear();
     }
 }
 
@@ -596,7 +782,7 @@ Scene<Float, Spectrum>::ray_intersect_preliminary_gpu(const Ray3f &ray,
                                                       Mask active) const {
     if constexpr (dr::is_cuda_v<Float>) {
         OptixSceneState &s = *(OptixSceneState *) m_accel;
-        const OptixConfig &config = optix_configs[s.config_index];
+        const OptixConfig &config = optix_config(s.config_index);
 
         UInt32 ray_mask(255), ray_flags(OPTIX_RAY_FLAG_NONE),
                sbt_offset(0), sbt_stride(1), miss_sbt_index(0);
@@ -683,7 +869,7 @@ MI_VARIANT typename Scene<Float, Spectrum>::Mask
 Scene<Float, Spectrum>::ray_test_gpu(const Ray3f &ray, Mask active) const {
     if constexpr (dr::is_cuda_v<Float>) {
         OptixSceneState &s = *(OptixSceneState *) m_accel;
-        const OptixConfig &config = optix_configs[s.config_index];
+        const OptixConfig &config = optix_config(s.config_index);
 
         UInt32 ray_mask(255),
                ray_flags(OPTIX_RAY_FLAG_TERMINATE_ON_FIRST_HIT |
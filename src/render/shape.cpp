@@ -5,6 +5,8 @@
 #include <mitsuba/render/sensor.h>
 #include <mitsuba/render/medium.h>
 #include <mitsuba/core/plugin.h>
+#include <deque>
+#include <mutex>
 
 #if defined(MI_ENABLE_EMBREE)
 #  include <embree3/rtcore.h>
@@ -70,6 +72,19 @@ MI_VARIANT Shape<Float, Spectrum>::Shape(const Properties &props) : m_id(props.i
     }
 
     m_silhouette_sampling_weight = props.get<ScalarFloat>("silhouette_sampling_weight", 1.0f);
+    m_view_cullable = props.get<bool>("view_cullable", false);
+
+    /* Embree: quality of the BVH of this shape ("low", "medium" or "high"),
+       which only applies when the scene builds a two-level BVH */
+#if defined(MI_ENABLE_EMBREE)
+    m_embree_build_quality = props.get<std::string>("embree_build_quality", "");
+    if (!m_embree_build_quality.empty() && m_embree_build_quality != "low" &&
+        m_embree_build_quality != "medium" && m_embree_build_quality != "high")
+        Throw("embree_build_quality: invalid value \"%s\" (must be \"low\", "
+              "\"medium\" or \"high\")!", m_embree_build_quality);
+#else
+    props.mark_queried("embree_build_quality");
+#endif
 
     if constexpr (dr::is_jit_v<Float>)
         jit_registry_put(dr::backend_v<Float>, "mitsuba::Shape", this);
@@ -125,6 +140,9 @@ void embree_intersect_scalar(int* valid,
     if (!valid[0])
         return;
 
+    ScopedRayStatistics stats;
+    stats.add(RayStatistic::PrimitiveTests);
+
     // Create a Mitsuba ray
     Ray3f ray = dr::zeros<Ray3f>();
     ray.o.x() = rtc_ray->org_x;
@@ -183,6 +201,9 @@ static void embree_intersect_packet(int *valid, void *geometryUserPtr,
     if (dr::none(active))
         return;
 
+    ScopedRayStatistics stats;
+    stats.add(RayStatistic::PrimitiveTests, dr::count(active));
+
     // Create Mitsuba ray
     Ray3fP ray;
     ray.o.x() = dr::load_aligned<Float32P>(rtc_ray->org_x);
@@ -448,7 +469,8 @@ std::tuple<typename Shape<Float, Spectrum>::ScalarFloat,
            typename Shape<Float, Spectrum>::ScalarPoint2f,
            typename Shape<Float, Spectrum>::ScalarUInt32,
            typename Shape<Float, Spectrum>::ScalarUInt32>
-Shape<Float, Spectrum>::ray_intersect_preliminary_scalar(const ScalarRay3f & /*ray*/) const {
+Shape<Float, Spectrum>::ray_intersect_preliminary_scalar(const ScalarRay3f & /*ray*/,
+                                                         ScalarIndex /*prim_index*/) const {
     NotImplementedError("ray_intersect_preliminary_scalar");
 }
 
@@ -480,7 +502,8 @@ Shape<Float, Spectrum>::ray_test(const Ray3f &ray, uint32_t prim_index, Mask act
 }
 
 MI_VARIANT
-bool Shape<Float, Spectrum>::ray_test_scalar(const ScalarRay3f & /*ray*/) const {
+bool Shape<Float, Spectrum>::ray_test_scalar(const ScalarRay3f & /*ray*/,
+                                             ScalarIndex /*prim_index*/) const {
     NotImplementedError("ray_intersect_test_scalar");
 }
 
@@ -553,6 +576,62 @@ Shape<Float, Spectrum>::eval_attribute_3(const std::string& name,
     return texture->eval_3(si, active);
 }
 
+namespace {
+/// Names of the attributes that were assigned a handle (shared by all variants)
+struct AttributeRegistry {
+    std::mutex mutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string, uint32_t> handles;
+};
+
+AttributeRegistry &attribute_registry() {
+    static AttributeRegistry registry;
+    return registry;
+}
+} // namespace
+
+MI_VARIANT uint32_t
+Shape<Float, Spectrum>::attribute_handle(const std::string &name) {
+    AttributeRegistry &registry = attribute_registry();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    auto [it, inserted] =
+        registry.handles.try_emplace(name, (uint32_t) registry.names.size());
+    if (inserted)
+        registry.names.push_back(name);
+    return it->second;
+}
+
+MI_VARIANT const std::string &
+Shape<Float, Spectrum>::attribute_name(uint32_t handle) {
+    AttributeRegistry &registry = attribute_registry();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    if (handle >= registry.names.size())
+        Throw("attribute_name(): invalid attribute handle %u.", handle);
+    // Elements of a std::deque are never moved when appending to it
+    return registry.names[handle];
+}
+
+MI_VARIANT typename Shape<Float, Spectrum>::UnpolarizedSpectrum
+Shape<Float, Spectrum>::eval_attribute(uint32_t handle,
+                                       const SurfaceInteraction3f &si,
+                                       Mask active) const {
+    return eval_attribute(attribute_name(handle), si, active);
+}
+
+MI_VARIANT Float
+Shape<Float, Spectrum>::eval_attribute_1(uint32_t handle,
+                                         const SurfaceInteraction3f &si,
+                                         Mask active) const {
+    return eval_attribute_1(attribute_name(handle), si, active);
+}
+
+MI_VARIANT typename Shape<Float, Spectrum>::Color3f
+Shape<Float, Spectrum>::eval_attribute_3(uint32_t handle,
+                                         const SurfaceInteraction3f &si,
+                                         Mask active) const {
+    return eval_attribute_3(attribute_name(handle), si, active);
+}
+
 MI_VARIANT Float Shape<Float, Spectrum>::surface_area() const {
     NotImplementedError("surface_area");
 }
@@ -569,6 +648,12 @@ Shape<Float, Spectrum>::bbox(ScalarIndex index, const ScalarBoundingBox3f &clip)
     return result;
 }
 
+MI_VARIANT std::pair<typename Shape<Float, Spectrum>::ScalarPoint3f,
+                     typename Shape<Float, Spectrum>::ScalarFloat>
+Shape<Float, Spectrum>::sphere_primitive(ScalarIndex) const {
+    NotImplementedError("sphere_primitive");
+}
+
 MI_VARIANT typename Shape<Float, Spectrum>::ScalarSize
 Shape<Float, Spectrum>::primitive_count() const {
     return 1;
@@ -593,6 +678,15 @@ MI_VARIANT void Shape<Float, Spectrum>::traverse(TraversalCallback *callback) {
     callback->put_parameter("silhouette_sampling_weight", m_silhouette_sampling_weight, +ParamFlags::NonDifferentiable);
 }
 
+MI_VARIANT bool Shape<Float, Spectrum>::replace_object(Object *old_child,
+                                                      Object *new_child) {
+    BSDF *bsdf = dynamic_cast<BSDF *>(new_child);
+    if (!bsdf || !old_child || old_child != (Object *) m_bsdf.get())
+        return false;
+    m_bsdf = bsdf;
+    return true;
+}
+
 MI_VARIANT
 void Shape<Float, Spectrum>::parameters_changed(const std::vector<std::string> &/*keys*/) {
     if (dirty()) {
@@ -1,6 +1,11 @@
+#include <mitsuba/core/profiler.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/timer.h>
 #include <mitsuba/render/shapegroup.h>
+#include <mitsuba/render/mesh.h>
 #include <mitsuba/render/optix_api.h>
+#include <mitsuba/render/scene.h>
+#include <nanothread/nanothread.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -8,13 +13,44 @@ MI_VARIANT ShapeGroup<Float, Spectrum>::ShapeGroup(const Properties &props) {
     m_id = props.id();
 
 #if !defined(MI_ENABLE_EMBREE)
-    if constexpr (!dr::is_cuda_v<Float>)
-        m_kdtree = new ShapeKDTree(props);
+    if constexpr (!dr::is_cuda_v<Float>) {
+        /* Acceleration data structure of the shapes in this group: "kdtree"
+           (default), or a wide BVH with 4 ("bvh4") or 8 ("bvh8") children
+           per node */
+        std::string accel = props.get<std::string>("accel", "kdtree");
+        if (accel == "kdtree")
+            m_kdtree = new ShapeKDTree(props);
+        else if (accel == "bvh4" || accel == "bvh8")
+            m_bvh = new ShapeBVH(props, accel == "bvh4" ? 4 : 8);
+        else
+            Throw("ShapeGroup: unsupported acceleration data structure \"%s\" "
+                  "(must be \"kdtree\", \"bvh4\" or \"bvh8\")!", accel);
+
+        /* Defer the build of the acceleration data structure until the
+           group is intersected for the first time, instead of building it
+           along with the other groups of the scene. This is only supported
+           by the scalar variants, as the build cannot run within the ray
+           tracing kernels of the LLVM variants. */
+        m_lazy_build = props.get<bool>("lazy_build", false);
+        if (m_lazy_build && dr::is_jit_v<Float>) {
+            Log(Warn, "ShapeGroup: \"lazy_build\" is only supported in "
+                "scalar variants and will be ignored.");
+            m_lazy_build = false;
+        }
+    } else {
+        m_lazy_build = false;
+        props.mark_queried("accel");
+        props.mark_queried("lazy_build");
+    }
+#else
+    props.mark_queried("accel");
+    props.mark_queried("lazy_build");
 #endif
     m_has_meshes = false;
     m_has_others = false;
     m_has_bspline_curves = false;
     m_has_linear_curves = false;
+    m_has_spheres = false;
 
     // Add children to the underlying data structure
     for (auto &kv : props.objects()) {
@@ -34,13 +70,15 @@ MI_VARIANT ShapeGroup<Float, Spectrum>::ShapeGroup(const Properties &props) {
                 m_shapes.push_back(shape);
                 shape->mark_as_instance();
 
-#if defined(MI_ENABLE_EMBREE) || defined(MI_ENABLE_CUDA)
                 m_bbox.expand(shape->bbox());
-#endif
 
 #if !defined(MI_ENABLE_EMBREE)
-                if constexpr (!dr::is_cuda_v<Float>)
-                    m_kdtree->add_shape(shape);
+                if constexpr (!dr::is_cuda_v<Float>) {
+                    if (m_bvh)
+                        m_bvh->add_shape(shape);
+                    else
+                        m_kdtree->add_shape(shape);
+                }
 #endif
                 uint32_t type = shape->shape_type();
                 bool is_mesh = (type == +ShapeType::Mesh);
@@ -52,6 +90,8 @@ MI_VARIANT ShapeGroup<Float, Spectrum>::ShapeGroup(const Properties &props) {
                 bool is_linear = (type == +ShapeType::LinearCurve);
                 m_has_linear_curves |= is_linear;
 
+                m_has_spheres |= (type == +ShapeType::Sphere);
+
                 bool is_other = !is_mesh && !is_bspline && !is_linear;
                 m_has_others |= is_other;
             }
@@ -59,14 +99,7 @@ MI_VARIANT ShapeGroup<Float, Spectrum>::ShapeGroup(const Properties &props) {
             Throw("Tried to add an unsupported object of type \"%s\"", kv.second);
         }
     }
-#if !defined(MI_ENABLE_EMBREE)
-    if constexpr (!dr::is_cuda_v<Float>) {
-        if (!m_kdtree->ready())
-            m_kdtree->build();
-
-        m_bbox = m_kdtree->bbox();
-    }
-#endif
+    compute_bounds();
 
 #if defined(MI_ENABLE_LLVM)
     if constexpr (dr::is_llvm_v<Float>) {
@@ -81,8 +114,98 @@ MI_VARIANT ShapeGroup<Float, Spectrum>::ShapeGroup(const Properties &props) {
 
     if constexpr (dr::is_jit_v<Float>)
         jit_registry_put(dr::backend_v<Float>, "mitsuba::ShapeGroup", this);
+
+    /* When the group is loaded by a worker of the thread pool (i.e. by a
+       parallel scene load), build its acceleration data structure right away
+       so that it overlaps with the loading of the remaining objects (e.g.
+       textures). Otherwise, the scene builds the ones of all its groups
+       concurrently (see Scene::build_shapegroups()). With OptiX, the GAS is
+       built along with the scene, which provides the OptiX configuration. */
+    if constexpr (!dr::is_cuda_v<Float>) {
+        if (pool_thread_id() != 0) {
+#if defined(MI_ENABLE_EMBREE)
+            embree_build(Scene<Float, Spectrum>::embree_device());
+#else
+            if (!m_lazy_build)
+                build_accel();
+#endif
+        }
+    }
 }
 
+MI_VARIANT void ShapeGroup<Float, Spectrum>::compute_bounds() {
+    m_bounds.clear();
+
+    /* Meshes are bounded by the boxes of their vertices in the eight octants
+       of their bounding box, other shapes by their bounding box. The union of
+       the transformed boxes bounds the transformed geometry, and is often
+       much tighter than the transformed bounding box of the entire group. */
+    for (auto &shape : m_shapes) {
+        ScalarBoundingBox3f bbox = shape->bbox();
+        if (!bbox.valid())
+            continue;
+
+        const Mesh *mesh = dynamic_cast<const Mesh *>(shape.get());
+        if constexpr (!dr::is_cuda_v<Float>) {
+            if (mesh && mesh->vertex_count() > 8) {
+                auto &&positions =
+                    dr::migrate(mesh->vertex_positions_buffer(), AllocType::Host);
+                if constexpr (dr::is_jit_v<Float>)
+                    dr::sync_thread();
+                const auto *ptr = positions.data();
+
+                ScalarPoint3f center = bbox.center();
+                ScalarBoundingBox3f octants[8];
+                for (ScalarSize i = 0; i < mesh->vertex_count(); ++i) {
+                    ScalarPoint3f p(ptr[3 * i + 0], ptr[3 * i + 1], ptr[3 * i + 2]);
+                    int octant = (p.x() > center.x() ? 1 : 0) |
+                                 (p.y() > center.y() ? 2 : 0) |
+                                 (p.z() > center.z() ? 4 : 0);
+                    octants[octant].expand(p);
+                }
+
+                for (int i = 0; i < 8; ++i) {
+                    if (octants[i].valid())
+                        m_bounds.push_back(octants[i]);
+                }
+                continue;
+            }
+        }
+
+        m_bounds.push_back(bbox);
+    }
+
+    // Fall back to the bounding box of the group when there are many boxes
+    if (m_bounds.size() > 64)
+        m_bounds = { m_bbox };
+}
+
+#if !defined(MI_ENABLE_EMBREE)
+MI_VARIANT void ShapeGroup<Float, Spectrum>::build_accel() const {
+    if (m_accel_ready.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> guard(m_accel_mutex);
+    if (m_accel_ready.load(std::memory_order_relaxed))
+        return;
+
+    ScopedPhase phase(ProfilerPhase::InitAccel);
+    ScopedTraceEvent trace("accel", "Build shape group", m_id);
+    Timer timer;
+
+    if (m_bvh)
+        m_bvh->build();
+    else if (!m_kdtree->ready())
+        m_kdtree->build();
+
+    Log(Debug, "ShapeGroup \"%s\": built the acceleration data structure of "
+        "%u primitives (took %s).", m_id, primitive_count(),
+        util::time_string((float) timer.value()));
+
+    m_accel_ready.store(true, std::memory_order_release);
+}
+#endif
+
 MI_VARIANT ShapeGroup<Float, Spectrum>::~ShapeGroup() {
 #if defined(MI_ENABLE_EMBREE)
     if constexpr (!dr::is_cuda_v<Float>) {
@@ -147,7 +270,7 @@ MI_VARIANT typename ShapeGroup<Float, Spectrum>::ScalarSize
 ShapeGroup<Float, Spectrum>::primitive_count() const {
 #if !defined(MI_ENABLE_EMBREE)
     if constexpr (!dr::is_cuda_v<Float>)
-        return m_kdtree->primitive_count();
+        return m_bvh ? m_bvh->primitive_count() : m_kdtree->primitive_count();
 #endif
 
     ScalarSize count = 0;
@@ -172,20 +295,25 @@ MI_VARIANT void ShapeGroup<Float, Spectrum>::optix_fill_hitgroup_records(std::ve
 
 MI_VARIANT void ShapeGroup<Float, Spectrum>::optix_prepare_geometry() { }
 
-MI_VARIANT void ShapeGroup<Float, Spectrum>::optix_build_gas(const OptixDeviceContext& context) {
+MI_VARIANT void ShapeGroup<Float, Spectrum>::optix_build_gas(const OptixDeviceContext& context,
+                                                             bool use_cache,
+                                                             OptixGASStatistics *stats) {
     if (m_dirty) {
-        build_gas(context, m_shapes, m_accel);
+        build_gas(context, m_shapes, m_accel, use_cache, stats);
         for (auto &s : m_shapes)
-            s->m_dirty = false;
+            s->m_dirty = s->m_topology_dirty = false;
     }
 }
 #endif
 
 #if defined(MI_ENABLE_EMBREE)
-MI_VARIANT RTCGeometry ShapeGroup<Float, Spectrum>::embree_geometry(RTCDevice device) {
+MI_VARIANT void ShapeGroup<Float, Spectrum>::embree_build(RTCDevice device) {
     DRJIT_MARK_USED(device);
     if constexpr (!dr::is_cuda_v<Float>) {
         if (m_dirty) {
+            ScopedPhase phase(ProfilerPhase::InitAccel);
+            ScopedTraceEvent trace("accel", "Build shape group", m_id);
+
             if (m_embree_scene == nullptr)
                 m_embree_scene = rtcNewScene(device);
 
@@ -206,12 +334,21 @@ MI_VARIANT RTCGeometry ShapeGroup<Float, Spectrum>::embree_geometry(RTCDevice de
             rtcCommitScene(m_embree_scene);
 
             for (auto &s : m_shapes)
-                s->m_dirty = false;
+                s->m_dirty = s->m_topology_dirty = false;
 
             // This method is called once per instance, hence make sure we only
             // rebuild the BVH once per update.
-            m_dirty = false;
+            m_dirty = m_topology_dirty = false;
         }
+    } else {
+        Throw("embree_build() should only be called in CPU mode.");
+    }
+}
+
+MI_VARIANT RTCGeometry ShapeGroup<Float, Spectrum>::embree_geometry(RTCDevice device) {
+    DRJIT_MARK_USED(device);
+    if constexpr (!dr::is_cuda_v<Float>) {
+        embree_build(device);
 
         RTCGeometry instance = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_INSTANCE);
         rtcSetGeometryInstancedScene(instance, m_embree_scene);
@@ -228,14 +365,20 @@ std::tuple<typename ShapeGroup<Float, Spectrum>::ScalarFloat,
            typename ShapeGroup<Float, Spectrum>::ScalarPoint2f,
            typename ShapeGroup<Float, Spectrum>::ScalarUInt32,
            typename ShapeGroup<Float, Spectrum>::ScalarUInt32>
-ShapeGroup<Float, Spectrum>::ray_intersect_preliminary_scalar(const ScalarRay3f &ray) const {
-    auto pi = m_kdtree->template ray_intersect_scalar<false>(ray);
+ShapeGroup<Float, Spectrum>::ray_intersect_preliminary_scalar(const ScalarRay3f &ray,
+                                                              ScalarIndex /*prim_index*/) const {
+    build_accel();
+    auto pi = m_bvh ? m_bvh->template ray_intersect_scalar<false>(ray)
+                    : m_kdtree->template ray_intersect_scalar<false>(ray);
     return { pi.t, pi.prim_uv, pi.shape_index, pi.prim_index };
 }
 
 MI_VARIANT
-bool ShapeGroup<Float, Spectrum>::ray_test_scalar(const ScalarRay3f &ray) const {
-    return m_kdtree->template ray_intersect_scalar<true>(ray).is_valid();
+bool ShapeGroup<Float, Spectrum>::ray_test_scalar(const ScalarRay3f &ray,
+                                                  ScalarIndex /*prim_index*/) const {
+    build_accel();
+    return m_bvh ? m_bvh->template ray_intersect_scalar<true>(ray).is_valid()
+                 : m_kdtree->template ray_intersect_scalar<true>(ray).is_valid();
 }
 #endif
 
@@ -1,72 +1,176 @@
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/render/spiral.h>
 #include <mitsuba/mitsuba.h>
+#include <drjit/morton.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
+BlockOrder block_order_from_string(const std::string &name) {
+    if (name == "spiral")
+        return BlockOrder::Spiral;
+    else if (name == "hilbert")
+        return BlockOrder::Hilbert;
+    else if (name == "morton")
+        return BlockOrder::Morton;
+    else
+        Throw("Invalid block order \"%s\", must be one of: \"spiral\", "
+              "\"hilbert\", or \"morton\"!", name);
+}
+
+/// Map a distance along the Hilbert curve covering a 2^k x 2^k grid to a position
+static Spiral::Vector2u hilbert_position(uint32_t n, uint32_t d) {
+    uint32_t x = 0, y = 0;
+    for (uint32_t s = 1; s < n; s *= 2) {
+        uint32_t rx = 1 & (d / 2),
+                 ry = 1 & (d ^ rx);
+
+        // Rotate the quadrant
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+
+        x += s * rx;
+        y += s * ry;
+        d /= 4;
+    }
+    return { x, y };
+}
+
 Spiral::Spiral(const Vector2u &size, const Vector2u &offset,
-               uint32_t block_size, uint32_t passes)
-    : m_size(size), m_offset(offset), m_passes_left(passes),
-      m_block_size(block_size) {
+               uint32_t block_size, uint32_t passes, BlockOrder order)
+    : m_size(size), m_offset(offset), m_passes(passes),
+      m_block_size(block_size), m_block_order(order), m_block_counter(0) {
 
     m_blocks = (size + (block_size - 1)) / block_size;
     m_block_count = dr::prod(m_blocks);
 
-    reset();
-}
-
-void Spiral::reset() {
-    m_block_counter = 0;
-    direction = Direction::Right;
-    m_position = Vector2u(m_blocks / 2);
-    m_steps_left = 1;
-    m_spiral_size = 1;
-}
+    m_order.reserve(m_block_count);
 
-std::tuple<Spiral::Vector2i, Spiral::Vector2u, uint32_t> Spiral::next_block() {
-    // Reimplementation of the spiraling block generator by Adam Arbree.
-    std::lock_guard<std::mutex> lock(m_mutex);
-
-    if (m_block_counter == m_block_count) {
-        if (m_passes_left > 1) {
-            --m_passes_left;
-            reset();
-        } else {
-            return { 0, 0, (uint32_t) -1 };
+    if (order != BlockOrder::Spiral) {
+        /* Walk along the curve covering the smallest enclosing power-of-two
+           grid and skip the positions outside of the image. The visited
+           blocks then remain (mostly) adjacent. */
+        uint32_t n = math::round_to_power_of_two(dr::max(m_blocks));
+        for (uint64_t d = 0; d < (uint64_t) n * n; ++d) {
+            Vector2u p = order == BlockOrder::Hilbert
+                             ? hilbert_position(n, (uint32_t) d)
+                             : dr::morton_decode<Vector2u>((uint32_t) d);
+            if (dr::all(p < m_blocks))
+                m_order.push_back(p);
         }
+        Assert(m_order.size() == m_block_count);
+        return;
     }
 
-    // Calculate a unique identifier per block
-    uint32_t block_id =
-        m_block_counter + (m_passes_left - 1) * m_block_count;
-
-    Vector2u offset = m_position * m_block_size,
-             size   = dr::minimum(m_block_size, m_size - offset);
+    // Reimplementation of the spiraling block generator by Adam Arbree.
+    Point2i position = Point2i(m_blocks / 2);
+    Direction direction = Direction::Right;
+    uint32_t steps_left = 1,
+             spiral_size = 1;
 
-    Assert(dr::all(offset <= m_size));
+    for (uint32_t i = 0; i < m_block_count; ++i) {
+        m_order.push_back(Vector2u(position));
 
-    ++m_block_counter;
+        if (i + 1 == m_block_count)
+            break;
 
-    if (m_block_counter != m_block_count) {
         // Prepare the next block's position along the spiral.
         do {
             switch (direction) {
-                case Direction::Right: ++m_position.x(); break;
-                case Direction::Down:  ++m_position.y(); break;
-                case Direction::Left:  --m_position.x(); break;
-                case Direction::Up:    --m_position.y(); break;
+                case Direction::Right: ++position.x(); break;
+                case Direction::Down:  ++position.y(); break;
+                case Direction::Left:  --position.x(); break;
+                case Direction::Up:    --position.y(); break;
             }
 
-            if (--m_steps_left == 0) {
+            if (--steps_left == 0) {
                 direction = Direction(((int) direction + 1) % 4);
                 if (direction == Direction::Left ||
                     direction == Direction::Right)
-                    ++m_spiral_size;
-                m_steps_left = m_spiral_size;
+                    ++spiral_size;
+                steps_left = spiral_size;
             }
-        } while (dr::any(m_position < 0 || m_position >= m_blocks));
+        } while (dr::any(position < 0 || position >= Point2i(m_blocks)));
+    }
+}
+
+void Spiral::reset() {
+    uint32_t counter = m_block_counter.load(std::memory_order_relaxed),
+             total   = m_block_count * m_passes;
+
+    // Restart the pass that is currently in progress
+    counter = std::min(counter, total);
+    uint32_t pass = counter == 0 ? 0 : (counter - 1) / m_block_count;
+
+    m_block_counter.store(pass * m_block_count, std::memory_order_relaxed);
+
+    // Partitioned traversals restart from the beginning
+    for (uint32_t i = 0; i < partitions(); ++i)
+        m_partition_counter[i].store(0, std::memory_order_relaxed);
+}
+
+void Spiral::set_partitions(uint32_t count) {
+    m_partition_order.clear();
+    m_partition_counter.reset();
+    if (count == 0)
+        return;
+
+    m_partition_order.resize(count);
+    m_partition_counter = std::unique_ptr<std::atomic<uint32_t>[]>(
+        new std::atomic<uint32_t>[count]);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        m_partition_order[i].reserve(m_block_count * m_passes / count + 1);
+        m_partition_counter[i].store(0, std::memory_order_relaxed);
+    }
+
+    // Assign each block to a stripe of block rows, keeping the spiral order
+    for (uint32_t pass = 0; pass < m_passes; ++pass) {
+        for (uint32_t local = 0; local < m_block_count; ++local) {
+            uint32_t partition = m_order[local].y() * count / m_blocks.y();
+            m_partition_order[partition].push_back(pass * m_block_count + local);
+        }
+    }
+}
+
+std::tuple<Spiral::Vector2i, Spiral::Vector2u, uint32_t> Spiral::next_block() {
+    uint32_t index = m_block_counter.fetch_add(1, std::memory_order_relaxed);
+    return block(index);
+}
+
+std::tuple<Spiral::Vector2i, Spiral::Vector2u, uint32_t>
+Spiral::next_block(uint32_t partition) {
+    uint32_t count = partitions();
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t p = (partition + i) % count,
+                 index = m_partition_counter[p].fetch_add(1, std::memory_order_relaxed);
+        if (index < m_partition_order[p].size())
+            return block(m_partition_order[p][index]);
     }
 
+    return { 0, 0, (uint32_t) -1 };
+}
+
+std::tuple<Spiral::Vector2i, Spiral::Vector2u, uint32_t>
+Spiral::block(uint32_t index) const {
+    if (index >= m_block_count * m_passes)
+        return { 0, 0, (uint32_t) -1 };
+
+    uint32_t pass  = index / m_block_count,
+             local = index - pass * m_block_count;
+
+    // Calculate a unique identifier per block (the first pass is numbered last)
+    uint32_t block_id = local + (m_passes - 1 - pass) * m_block_count;
+
+    Vector2u offset = m_order[local] * m_block_size,
+             size   = dr::minimum(m_block_size, m_size - offset);
+
+    Assert(dr::all(offset <= m_size));
+
     return { offset + m_offset, size, block_id };
 }
 
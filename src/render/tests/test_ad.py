@@ -462,3 +462,42 @@ def test07_masked_updates(variants_all_ad_rgb, opt):
 
         prev_x = mi.Float(params['x'])
         prev_state = [mi.Float(vv) for vv in ensure_iterable(opt.state['x'])]
+
+
+@pytest.mark.parametrize('opt', ['SGD', 'Adam'])
+def test08_tiled_updates(variants_all_ad_rgb, opt):
+    def ensure_iterable(v):
+        if isinstance(v, (tuple, list)):
+            return v
+        else:
+            return [v]
+
+    def create(tile_size):
+        params = { 'x': dr.full(mi.TensorXf, 1.0, (8, 32, 3)) }
+        if opt == 'SGD':
+            return params, mi.ad.SGD(lr=0.1, momentum=0.8, params=params,
+                                     tile_size=tile_size)
+        else:
+            return params, mi.ad.Adam(lr=0.1, params=params,
+                                      tile_size=tile_size)
+
+    params_ref, opt_ref = create(0)
+    params, opt = create(96)
+
+    # Iteration i only touches the tiles 2 * i and 2 * i + 1
+    idx = dr.arange(mi.UInt32, 8 * 32 * 3)
+    for i in range(3):
+        touched = (idx // 192) == i
+        g = mi.TensorXf(dr.select(touched & (idx % 5 == 0), -1.0, 0.0), (8, 32, 3))
+        for p, o in [(params_ref, opt_ref), (params, opt)]:
+            dr.set_grad(p['x'], g)
+            o.step()
+            p.update(o)
+
+        # The touched tiles match dense updates, the others are unchanged
+        x, x_ref = params['x'].array, params_ref['x'].array
+        assert dr.allclose(dr.select(touched, x, x_ref), x_ref)
+        assert dr.all((idx < 192 * (i + 1)) | (x == 1.0))
+        for s, s_ref in zip(ensure_iterable(opt.state['x']),
+                            ensure_iterable(opt_ref.state['x'])):
+            assert dr.allclose(dr.select(touched, s.array, s_ref.array), s_ref.array)
@@ -63,4 +63,40 @@ def test03_bsdf_attributes(variants_vec_backends_once_rgb):
     assert dr.all(bsdf.has_attribute('tint'))
     assert not dr.all(bsdf.has_attribute('foo'))
     assert dr.allclose(color, bsdf.eval_attribute('tint', si))
-    assert dr.allclose(0.0, bsdf.eval_attribute('foo', si))
\ No newline at end of file
+    assert dr.allclose(0.0, bsdf.eval_attribute('foo', si))
+
+@pytest.mark.parametrize('bsdf_type', ['plastic', 'roughplastic', 'roughconductor',
+                                       'roughdielectric', 'principled', 'hair'])
+def test04_eval_pdf_sample(variants_vec_backends_once_rgb, bsdf_type):
+    # The fused query must match separate calls to eval_pdf() and sample()
+    desc = {'type': bsdf_type}
+    if bsdf_type == 'principled':
+        desc.update({'roughness': 0.4, 'metallic': 0.3, 'spec_trans': 0.5,
+                     'clearcoat': 0.5, 'sheen': 0.3})
+
+    bsdf = mi.load_dict(desc)
+
+    n = 64
+    rng = mi.PCG32(size=n)
+    si = dr.zeros(mi.SurfaceInteraction3f, n)
+    si.n = mi.Normal3f(0, 0, 1)
+    si.sh_frame = mi.Frame3f(si.n)
+    si.uv = mi.Point2f(rng.next_float32(), rng.next_float32())
+    si.wi = mi.warp.square_to_uniform_sphere(
+        mi.Point2f(rng.next_float32(), rng.next_float32()))
+    wo = mi.warp.square_to_uniform_sphere(
+        mi.Point2f(rng.next_float32(), rng.next_float32()))
+    sample1 = rng.next_float32()
+    sample2 = mi.Point2f(rng.next_float32(), rng.next_float32())
+
+    ctx = mi.BSDFContext()
+    value, pdf, bs, weight = bsdf.eval_pdf_sample(ctx, si, wo, sample1, sample2)
+    value_ref, pdf_ref = bsdf.eval_pdf(ctx, si, wo)
+    bs_ref, weight_ref = bsdf.sample(ctx, si, sample1, sample2)
+
+    assert dr.allclose(value, value_ref, rtol=1e-4, atol=1e-5)
+    assert dr.allclose(pdf, pdf_ref, rtol=1e-4, atol=1e-5)
+    assert dr.allclose(bs.wo, bs_ref.wo, rtol=1e-4, atol=1e-5)
+    assert dr.allclose(bs.pdf, bs_ref.pdf, rtol=1e-4, atol=1e-5)
+    assert dr.all(bs.sampled_type == bs_ref.sampled_type)
+    assert dr.allclose(weight, weight_ref, rtol=1e-4, atol=1e-5)
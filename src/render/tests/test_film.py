@@ -18,3 +18,32 @@ def test01_trampoline(variants_vec_backends_once_rgb):
     })
 
     assert str(film) == "DummyFilm (4)"
+
+
+def test02_storage_roundtrip(variants_vec_backends_once_rgb):
+    film = mi.load_dict({
+        'type': 'hdrfilm',
+        'width': 4,
+        'height': 3,
+        'rfilter': { 'type': 'box' }
+    })
+    film.prepare([])
+
+    block = film.create_block()
+    block.set_offset(film.crop_offset())
+    rng = mi.PCG32(size=4*3)
+    pos = mi.Point2f(dr.arange(mi.Float, 4*3) % 4,
+                     dr.floor(dr.arange(mi.Float, 4*3) / 4)) + 0.5
+    block.put(pos, [rng.next_float32(), rng.next_float32(),
+                    rng.next_float32(), mi.Float(1), mi.Float(1)])
+    film.put_block(block)
+    ref = film.develop()
+
+    stream = mi.MemoryStream()
+    film.write_storage(stream)
+    film.clear()
+    assert dr.all(film.develop() == 0, axis=None)
+
+    stream.seek(0)
+    film.read_storage(stream)
+    assert dr.allclose(film.develop(), ref)
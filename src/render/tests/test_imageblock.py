@@ -28,7 +28,7 @@ def test01_construct(variant_scalar_rgb):
     assert not im.warn_invalid()
 
 
-@pytest.mark.parametrize("filter_name", ['gaussian', 'tent', 'box'])
+@pytest.mark.parametrize("filter_name", ['gaussian', 'tent', 'lanczos', 'box'])
 @pytest.mark.parametrize("border", [ False, True ])
 @pytest.mark.parametrize("offset", [ [0, 0], [1, 2] ])
 @pytest.mark.parametrize("normalize", [ False, True ])
@@ -257,3 +257,33 @@ def test06_error_compensation(variants_any_cuda, compensate):
         print(2**24 + 1024)
         print(2**24)
         assert ib.tensor().array[0] ==  2**24 + (1024 if compensate else 0)
+
+
+@pytest.mark.parametrize("count", [ 2, 8 ])
+def test07_partial_images(variants_any_llvm, count):
+    def splat(ib):
+        rng = mi.PCG32(size=10000)
+        pos = mi.Point2f(rng.next_float32(), rng.next_float32()) * 16
+        ib.put(pos=pos, values=(dr.ones(mi.Float, 10000), pos.x))
+        return ib.tensor()
+
+    def block():
+        return mi.ImageBlock(size=(16, 16), offset=(0, 0), channel_count=2,
+                             rfilter=mi.load_dict({'type': 'gaussian'}),
+                             coalesce=False)
+
+    ref = splat(block())
+
+    ib = block()
+    ib.set_partial_images(count)
+    assert ib.partial_images() == count
+    assert dr.allclose(splat(ib), ref)
+
+    # The partial images are reset after their contents have been summed up
+    assert dr.allclose(ib.tensor(), ref)
+    ib.clear()
+    assert dr.allclose(ib.tensor(), 0)
+
+    # Too little memory for more than a single copy
+    ib.set_partial_images(count, memory_limit=16 * 16 * 2 * 4)
+    assert ib.partial_images() == 1
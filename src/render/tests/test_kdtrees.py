@@ -1,3 +1,4 @@
+import math
 import pytest
 import drjit as dr
 import mitsuba as mi
@@ -113,3 +114,393 @@ def test02_depth_scalar_bunny(variant_scalar_rgb):
             res_shadow = scene.ray_test(r)
             assert dr.all(res_shadow == res_naive.is_valid())
             compare_results(res_naive, res)
+
+
+@fresolver_append_path
+@pytest.mark.parametrize('accel', ['bvh4', 'bvh8'])
+def test03_bvh_scalar_bunny(variant_scalar_rgb, accel):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    shape = {
+        "type" : "ply",
+        "filename" : "resources/data/common/meshes/bunny_lowres.ply",
+    }
+    scene_kd  = mi.load_dict({ 'type': 'scene', 'shape': shape })
+    scene_bvh = mi.load_dict({ 'type': 'scene', 'shape': shape,
+                               'accel': accel, 'bvh_max_leaf_size': 2 })
+    b = scene_kd.bbox()
+
+    n = 50
+    inv_n = 1.0 / (n - 1)
+    wavelengths = []
+
+    for x in range(n):
+        for y in range(n):
+            o = [b.min[0] * (1 - x * inv_n) + b.max[0] * x * inv_n,
+                 b.min[1] * (1 - y * inv_n) + b.max[1] * y * inv_n,
+                 b.min[2] - 1]
+            d = dr.normalize(mi.Vector3f(0.1 * (x % 3 - 1), 0.1 * (y % 3 - 1), 1))
+            r = mi.Ray3f(o, d, 0.5, wavelengths)
+            r.maxt = 100
+
+            res_kd     = scene_kd.ray_intersect(r)
+            res        = scene_bvh.ray_intersect(r)
+            res_naive  = scene_bvh.ray_intersect_naive(r)
+            res_shadow = scene_bvh.ray_test(r)
+            assert dr.all(res_shadow == res_naive.is_valid())
+            compare_results(res_naive, res)
+            compare_results(res_kd, res, atol=1e-5)
+
+
+def test04_invalid_accel(variant_scalar_rgb):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    with pytest.raises(RuntimeError, match='unsupported acceleration data structure'):
+        mi.load_dict({ 'type': 'scene', 'accel': 'octree' })
+
+
+@fresolver_append_path
+def test05_kdtree_cache(variant_scalar_rgb, tmp_path):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    def load(**kwargs):
+        return mi.load_dict({
+            'type': 'scene',
+            'shape': {
+                "type" : "ply",
+                "filename" : "resources/data/common/meshes/bunny_lowres.ply",
+            },
+            **kwargs
+        })
+
+    scene_ref = load()
+    scene_store = load(kd_cache=str(tmp_path))
+    files = list(tmp_path.glob('kdtree_*.bin'))
+    assert len(files) == 1
+
+    # The cached tree is loaded and produces identical intersections
+    scene_load = load(kd_cache=str(tmp_path))
+    assert list(tmp_path.glob('kdtree_*.bin')) == files
+
+    # Different build parameters result in a separate cache entry
+    load(kd_cache=str(tmp_path), kd_stop_prims=5)
+    assert len(list(tmp_path.glob('kdtree_*.bin'))) == 2
+
+    # Corrupted cache entries are ignored and overwritten
+    with open(files[0], 'r+b') as f:
+        f.truncate(64)
+    scene_corrupt = load(kd_cache=str(tmp_path))
+    assert files[0].stat().st_size > 64
+
+    b = scene_ref.bbox()
+    n = 32
+    inv_n = 1.0 / (n - 1)
+    for x in range(n):
+        for y in range(n):
+            o = [b.min[0] * (1 - x * inv_n) + b.max[0] * x * inv_n,
+                 b.min[1] * (1 - y * inv_n) + b.max[1] * y * inv_n,
+                 b.min[2] - 1]
+            r = mi.Ray3f(o, [0, 0, 1])
+            res_ref = scene_ref.ray_intersect(r)
+            for scene in [scene_store, scene_load, scene_corrupt]:
+                compare_results(res_ref, scene.ray_intersect(r))
+
+
+@pytest.mark.parametrize('accel', ['bvh4', 'bvh8'])
+def test06_bvh_multi_primitive_shape(variant_scalar_rgb, accel):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+    pytest.importorskip("numpy")
+    import numpy as np
+
+    # Sphere of radius 0.3 in an SDF grid, whose primitives are its bricks
+    res = 21
+    x = np.linspace(0, 1, res)
+    z, y, x = np.meshgrid(x, x, x, indexing='ij')
+    sdf_grid = np.sqrt((x - 0.5)**2 + (y - 0.5)**2 + (z - 0.5)**2) - 0.3
+    shape = {
+        'type': 'sdfgrid',
+        'grid': sdf_grid.reshape((res, res, res, 1)).astype(np.float32),
+        'brick_size': 4
+    }
+    scene_kd  = mi.load_dict({ 'type': 'scene', 'shape': shape })
+    scene_bvh = mi.load_dict({ 'type': 'scene', 'shape': shape,
+                               'accel': accel, 'bvh_max_leaf_size': 1 })
+    assert scene_kd.shapes()[0].primitive_count() > 1
+
+    n = 9
+    for x in dr.linspace(mi.Float, 0.05, 0.95, n):
+        for y in dr.linspace(mi.Float, 0.05, 0.95, n):
+            r = mi.Ray3f([x, y, -1], [0.05, -0.1, 1])
+            res_kd = scene_kd.ray_intersect(r)
+            res    = scene_bvh.ray_intersect(r)
+            assert dr.all(scene_bvh.ray_test(r) == res_kd.is_valid())
+            compare_results(res_kd, res, atol=1e-5)
+            if dr.all(res_kd.is_valid()):
+                assert res.prim_index == res_kd.prim_index
+
+
+def test07_kdtree_cache_primitives(variant_scalar_rgb, tmp_path):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+    pytest.importorskip("numpy")
+    import numpy as np
+
+    def load(center):
+        res = 21
+        x = np.linspace(0, 1, res)
+        z, y, x = np.meshgrid(x, x, x, indexing='ij')
+        sdf_grid = np.sqrt((x - center[0])**2 + (y - center[1])**2 +
+                           (z - center[2])**2) - 0.2
+        return mi.load_dict({
+            'type': 'scene',
+            'shape': {
+                'type': 'sdfgrid',
+                'grid': sdf_grid.reshape((res, res, res, 1)).astype(np.float32),
+                'brick_size': 4
+            },
+            'kd_cache': str(tmp_path),
+        })
+
+    # Both grids have the same bounds, but their bricks have different
+    # positions and must therefore not share a cache entry
+    load([0.3, 0.3, 0.5])
+    scene = load([0.7, 0.7, 0.5])
+    assert len(list(tmp_path.glob('kdtree_*.bin'))) == 2
+
+    ray = mi.Ray3f([0.7, 0.7, -1], [0, 0, 1])
+    si = scene.ray_intersect(ray)
+    assert si.is_valid() and dr.allclose(si.t, 1.3, atol=1e-2)
+
+
+@fresolver_append_path
+def test06_kdtree_triangle_packets(variant_scalar_rgb):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    def load(**kwargs):
+        return mi.load_dict({
+            'type': 'scene',
+            'bunny': {
+                "type" : "ply",
+                "filename" : "resources/data/common/meshes/bunny_lowres.ply",
+            },
+            'sphere': {
+                'type': 'sphere',
+                'center': [0, 0.1, 0],
+                'radius': 0.05
+            },
+            **kwargs
+        })
+
+    scene_ref = load()
+    scenes = [load(kd_triangle_packets=4), load(kd_triangle_packets=8)]
+
+    b = scene_ref.bbox()
+    n = 32
+    inv_n = 1.0 / (n - 1)
+    for x in range(n):
+        for y in range(n):
+            o = [b.min[0] * (1 - x * inv_n) + b.max[0] * x * inv_n,
+                 b.min[1] * (1 - y * inv_n) + b.max[1] * y * inv_n,
+                 b.min[2] - 1]
+            r = mi.Ray3f(o, [0, 0, 1])
+            res_ref = scene_ref.ray_intersect(r)
+            for scene in scenes:
+                compare_results(res_ref, scene.ray_intersect(r))
+                assert scene.ray_test(r) == res_ref.is_valid()
+
+    with pytest.raises(RuntimeError, match='packet width must be 0, 4 or 8'):
+        load(kd_triangle_packets=3)
+
+
+@fresolver_append_path
+@pytest.mark.parametrize('threshold', [0.0, 0.5, 1.0])
+def test07_kdtree_coherent_traversal(variants_any_llvm, threshold):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    def load(**kwargs):
+        return mi.load_dict({
+            'type': 'scene',
+            'bunny': {
+                "type" : "ply",
+                "filename" : "resources/data/common/meshes/bunny_lowres.ply",
+            },
+            **kwargs
+        })
+
+    scene_ref = load(kd_coherent_traversal=False)
+    scene = load(kd_divergence_threshold=threshold)
+
+    # A grid of parallel rays, plus rays diverging from a point
+    b = scene_ref.bbox()
+    n = 64
+    t = dr.linspace(mi.Float, 0, 1, n * n)
+    x, y = dr.meshgrid(dr.linspace(mi.Float, 0, 1, n),
+                       dr.linspace(mi.Float, 0, 1, n))
+    o = mi.Point3f(b.min[0] * (1 - x) + b.max[0] * x,
+                   b.min[1] * (1 - y) + b.max[1] * y,
+                   b.min[2] - 1)
+    d = dr.normalize(mi.Vector3f(0.5 * dr.sin(37 * t), 0.5 * dr.cos(53 * t), 1))
+
+    for ray in [mi.Ray3f(o, mi.Vector3f(0, 0, 1)),
+                mi.Ray3f(mi.Point3f(b.center()) - mi.Vector3f(0, 0, 1), d)]:
+        si_ref = scene_ref.ray_intersect(ray, mi.RayFlags.All, coherent=True)
+        si = scene.ray_intersect(ray, mi.RayFlags.All, coherent=True)
+        assert dr.all(si.is_valid() == si_ref.is_valid())
+        assert dr.allclose(dr.select(si.is_valid(), si.t, 0),
+                           dr.select(si_ref.is_valid(), si_ref.t, 0))
+        assert dr.all(~si.is_valid() | (si.prim_index == si_ref.prim_index))
+
+        # Shadow rays
+        assert dr.all(scene.ray_test(ray, coherent=True) == si_ref.is_valid())
+
+
+def test08_kdtree_parallel_build(variant_scalar_rgb):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    # A bumpy height field with enough triangles to set up the edge events
+    # of the O(n log n) builder in parallel
+    n = 160
+    mesh = mi.Mesh('grid', (n + 1) * (n + 1), 2 * n * n)
+    positions, faces = [], []
+    for i in range(n + 1):
+        for j in range(n + 1):
+            x, y = i / n, j / n
+            positions += [x, y, 0.05 * math.sin(23 * x) * math.cos(17 * y)]
+    for i in range(n):
+        for j in range(n):
+            k = i * (n + 1) + j
+            faces += [k, k + n + 1, k + 1, k + 1, k + n + 1, k + n + 2]
+    params = mi.traverse(mesh)
+    params['vertex_positions'] = positions
+    params['faces'] = faces
+    params.update()
+    assert mesh.face_count() > 4 * 10240
+
+    def load(**kwargs):
+        props = mi.Properties('scene')
+        props['_unnamed_0'] = mesh
+        for key, value in kwargs.items():
+            props[key] = value
+        return mi.Scene(props)
+
+    # Exact build of the entire tree vs. min-max binning at the top levels
+    scene_exact = load(kd_exact_primitive_threshold=100000)
+    scene_binned = load(kd_exact_primitive_threshold=1024)
+
+    m = 48
+    inv_m = 1.0 / (m - 1)
+    for u in range(m):
+        for v in range(m):
+            r = mi.Ray3f([u * inv_m, v * inv_m, 1], [0, 0, -1])
+            res = scene_exact.ray_intersect(r)
+            assert res.is_valid()
+            compare_results(res, scene_binned.ray_intersect(r), atol=1e-5)
+
+
+
+@fresolver_append_path
+def test09_kdtree_compact(variant_scalar_rgb, tmp_path):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    def load(**kwargs):
+        scene = mi.load_dict({
+            'type': 'scene',
+            'bunny': {
+                "type" : "ply",
+                "filename" : "resources/data/common/meshes/bunny_lowres.ply",
+            },
+            'sphere': {
+                'type': 'sphere',
+                'center': [0, 0.1, 0],
+                'radius': 0.05
+            },
+            **kwargs
+        })
+        return scene, mi.MemoryTracker.usage(mi.MemoryCategory.KDTree)
+
+    memory_0 = mi.MemoryTracker.usage(mi.MemoryCategory.KDTree)
+    scene_ref, memory_1 = load()
+    scene_compact, memory_2 = load(kd_compact=True)
+
+    assert memory_1 > memory_0 and memory_2 > memory_1
+
+    scenes = [
+        scene_compact,
+        load(kd_compact=True, kd_triangle_packets=8)[0],
+        load(kd_compact=True, kd_cache=str(tmp_path))[0],
+        load(kd_compact=True, kd_cache=str(tmp_path))[0] # Loaded from the cache
+    ]
+
+    b = scene_ref.bbox()
+    n = 32
+    inv_n = 1.0 / (n - 1)
+    for x in range(n):
+        for y in range(n):
+            o = [b.min[0] * (1 - x * inv_n) + b.max[0] * x * inv_n,
+                 b.min[1] * (1 - y * inv_n) + b.max[1] * y * inv_n,
+                 b.min[2] - 1]
+            r = mi.Ray3f(o, [0.1, 0.2, 1])
+            res_ref = scene_ref.ray_intersect(r)
+            for scene in scenes:
+                res = scene.ray_intersect(r)
+                compare_results(res_ref, res)
+                assert res.prim_index == res_ref.prim_index
+                assert scene.ray_test(r) == res_ref.is_valid()
+
+
+@fresolver_append_path
+def test10_kdtree_cache_map(variant_scalar_rgb, tmp_path):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    def load(**kwargs):
+        scene = mi.load_dict({
+            'type': 'scene',
+            'shape': {
+                "type" : "ply",
+                "filename" : "resources/data/common/meshes/bunny_lowres.ply",
+            },
+            'kd_cache': str(tmp_path),
+            'kd_cache_map': True,
+            **kwargs
+        })
+        return scene, mi.MemoryTracker.usage(mi.MemoryCategory.KDTree)
+
+    memory_0 = mi.MemoryTracker.usage(mi.MemoryCategory.KDTree)
+    scene_ref, memory_1 = load()
+    assert memory_1 > memory_0
+
+    # Mapped trees don't allocate memory (instead, they share the file)
+    scene_map, memory_2 = load()
+    assert memory_2 == memory_1
+    files = list(tmp_path.glob('kdtree_*.bin'))
+    assert len(files) == 1
+
+    # Leaves of a mapped tree are reordered by the triangle packets, which
+    # must not modify the cache file
+    size, data = files[0].stat().st_size, files[0].read_bytes()
+    scene_packets = load(kd_triangle_packets=4)[0]
+    assert files[0].read_bytes() == data and len(data) == size
+
+    b = scene_ref.bbox()
+    n = 32
+    inv_n = 1.0 / (n - 1)
+    for x in range(n):
+        for y in range(n):
+            o = [b.min[0] * (1 - x * inv_n) + b.max[0] * x * inv_n,
+                 b.min[1] * (1 - y * inv_n) + b.max[1] * y * inv_n,
+                 b.min[2] - 1]
+            r = mi.Ray3f(o, [0.1, 0.2, 1])
+            res_ref = scene_ref.ray_intersect(r)
+            for scene in [scene_map, scene_packets]:
+                res = scene.ray_intersect(r)
+                compare_results(res_ref, res)
+                assert res.prim_index == res_ref.prim_index
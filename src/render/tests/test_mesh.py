@@ -1331,3 +1331,407 @@ def test35_mesh_vcalls(variants_vec_rgb):
                       == sh.face_normal(idx_i))
         assert dr.all(dr.gather(type(opposite), opposite, i)
                       == sh.opposite_dedge(idx_i))
+
+
+def test36_obj_parallel_parsing(variant_scalar_rgb, tmp_path):
+    # Files larger than a few MB are parsed in chunks by several threads. The
+    # result must match a sequential pass, including the vertex order.
+    import numpy as np
+
+    res = 300
+    lines, faces = [], []
+    for j in range(res):
+        for i in range(res):
+            lines.append(f'v {i / res} {j / res} {np.sin(i * j * 1e-3)}')
+    for i in range(res):
+        lines.append(f'vt {i / res} {(i * 7 % res) / res}')
+    for j in range(res - 1):
+        for i in range(res - 1):
+            a = j * res + i + 1
+            b, c, d = a + 1, a + res + 1, a + res
+            # Alternate between texture coordinate assignments to create
+            # several distinct vertices per position
+            t = (i + j) % res + 1
+            faces.append((a, b, c, d, t))
+            lines.append(f'f {a}/{t} {b}/{t} {c}/{t} {d}/{t}')
+
+    filepath = str(tmp_path / 'test_mesh-test36_obj_parallel_parsing.obj')
+    with open(filepath, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+    mesh = mi.load_dict({
+        'type': 'obj',
+        'filename': filepath,
+        'face_normals': True,
+        'flip_tex_coords': False
+    })
+
+    # Reference: sequential deduplication in the order of first reference
+    index, ref_faces = {}, []
+    for a, b, c, d, t in faces:
+        ids = [index.setdefault((k, t), len(index)) for k in (a, b, c, d)]
+        ref_faces.append([ids[0], ids[1], ids[2]])
+        ref_faces.append([ids[0], ids[2], ids[3]])
+
+    params = mi.traverse(mesh)
+    assert mesh.vertex_count() == len(index)
+    assert mesh.face_count() == len(ref_faces)
+    assert np.all(np.array(params['faces']).reshape(-1, 3) == np.array(ref_faces))
+
+    positions = np.array(params['vertex_positions']).reshape(-1, 3)
+    keys = list(index.keys())
+    ref_positions = np.array([[((k - 1) % res) / res, ((k - 1) // res) / res,
+                               np.sin(((k - 1) % res) * ((k - 1) // res) * 1e-3)]
+                              for k, _ in keys])
+    assert np.allclose(positions, ref_positions, atol=1e-5)
+
+
+@pytest.mark.parametrize('index_type', ['int', 'uint', 'ushort'])
+def test37_ply_binary_fast_path(variant_scalar_rgb, tmp_path, index_type):
+    # Binary PLY files whose layout matches the mesh format are read without
+    # conversion. The result must match the big-endian (converted) version.
+    import numpy as np
+
+    rng = np.random.default_rng(0)
+    n_vertices, n_faces = 5000, 20000
+    positions = rng.random((n_vertices, 3), dtype=np.float32)
+    uv = rng.random((n_vertices, 2), dtype=np.float32)
+    faces = rng.integers(0, n_vertices, (n_faces, 3))
+
+    index_dtype = { 'int': 'i4', 'uint': 'u4', 'ushort': 'u2' }[index_type]
+
+    meshes = []
+    for order in ['little', 'big']:
+        e = '<' if order == 'little' else '>'
+        vertex = np.zeros(n_vertices, dtype=[('p', e + 'f4', 3), ('uv', e + 'f4', 2)])
+        vertex['p'], vertex['uv'] = positions, uv
+        face = np.zeros(n_faces, dtype=[('n', 'u1'), ('i', e + index_dtype, 3)])
+        face['n'], face['i'] = 3, faces
+
+        filepath = str(tmp_path / f'test_mesh-test37_{order}.ply')
+        with open(filepath, 'wb') as f:
+            f.write((f'ply\nformat binary_{order}_endian 1.0\n'
+                     f'element vertex {n_vertices}\n'
+                     'property float x\nproperty float y\nproperty float z\n'
+                     'property float u\nproperty float v\n'
+                     f'element face {n_faces}\n'
+                     f'property list uchar {index_type} vertex_indices\n'
+                     'end_header\n').encode())
+            f.write(vertex.tobytes())
+            f.write(face.tobytes())
+
+        meshes.append(mi.traverse(mi.load_dict({
+            'type': 'ply',
+            'filename': filepath,
+            'face_normals': True
+        })))
+
+    for key in ['vertex_positions', 'vertex_texcoords', 'faces']:
+        assert np.all(np.array(meshes[0][key]) == np.array(meshes[1][key]))
+
+    assert np.all(np.array(meshes[0]['faces']) == faces.ravel())
+    assert np.allclose(np.array(meshes[0]['vertex_positions']), positions.ravel())
+
+
+@pytest.mark.parametrize('compression', [0, 1])
+def test38_serialized_v5(variant_scalar_rgb, tmp_path, compression):
+    # Version 5 files (converted from version 4) must load identically
+    import numpy as np
+    from mitsuba.serialized import write, convert
+
+    rng = np.random.default_rng(0)
+    n_vertices, n_faces = 1000, 3000
+    positions = rng.random((n_vertices, 3), dtype=np.float32)
+    normals = rng.random((n_vertices, 3), dtype=np.float32) + 0.1
+    texcoords = rng.random((n_vertices, 2), dtype=np.float32)
+    faces = rng.integers(0, n_vertices, (n_faces, 3)).astype(np.uint32)
+
+    shape = {
+        'name': 'mesh', 'flags': 0x1003,
+        'vertex_count': n_vertices, 'face_count': n_faces,
+        'arrays': [positions.tobytes(), normals.tobytes(), texcoords.tobytes(),
+                   b'', faces.tobytes()]
+    }
+
+    v4 = str(tmp_path / 'test_mesh-test38_v4.serialized')
+    v5 = str(tmp_path / 'test_mesh-test38_v5.serialized')
+    write(v4, [shape, shape], version=4)
+    convert(v4, v5, compression=compression, block_size=4096)
+
+    for shape_index in [0, 1]:
+        params = [mi.traverse(mi.load_dict({
+            'type': 'serialized',
+            'filename': f,
+            'shape_index': shape_index,
+            'to_world': mi.ScalarTransform4f().scale(2)
+        })) for f in [v4, v5]]
+
+        for key in ['vertex_positions', 'vertex_normals', 'vertex_texcoords', 'faces']:
+            assert np.all(np.array(params[0][key]) == np.array(params[1][key]))
+
+        assert np.all(np.array(params[1]['faces']) == faces.ravel())
+        assert np.allclose(np.array(params[1]['vertex_positions']), 2 * positions.ravel())
+
+
+def test39_compact_vertices(variants_all_rgb, tmp_path):
+    # The compact vertex layout approximates normals and UVs closely
+    import numpy as np
+
+    rng = np.random.default_rng(0)
+    n_vertices, n_faces = 1000, 2000
+    vertex = np.zeros(n_vertices, dtype=[('p', '<f4', 3), ('n', '<f4', 3), ('uv', '<f4', 2)])
+    vertex['p'] = rng.random((n_vertices, 3))
+    n = rng.normal(size=(n_vertices, 3))
+    vertex['n'] = n / np.linalg.norm(n, axis=1)[:, None]
+    vertex['uv'] = rng.random((n_vertices, 2)) * 4 - 1
+    face = np.zeros(n_faces, dtype=[('n', 'u1'), ('i', '<u4', 3)])
+    face['n'], face['i'] = 3, rng.integers(0, n_vertices, (n_faces, 3))
+
+    filepath = str(tmp_path / 'test_mesh-test39_compact_vertices.ply')
+    with open(filepath, 'wb') as f:
+        f.write((f'ply\nformat binary_little_endian 1.0\nelement vertex {n_vertices}\n'
+                 'property float x\nproperty float y\nproperty float z\n'
+                 'property float nx\nproperty float ny\nproperty float nz\n'
+                 'property float u\nproperty float v\n'
+                 f'element face {n_faces}\nproperty list uchar uint vertex_indices\n'
+                 'end_header\n').encode())
+        f.write(vertex.tobytes())
+        f.write(face.tobytes())
+
+    meshes = [mi.load_dict({
+        'type': 'ply',
+        'filename': filepath,
+        'compact_vertices': compact
+    }) for compact in [False, True]]
+
+    assert not meshes[0].has_compact_vertices()
+    assert meshes[1].has_compact_vertices()
+    assert meshes[1].has_vertex_normals() and meshes[1].has_vertex_texcoords()
+    assert 'vertex_normals' not in mi.traverse(meshes[1])
+
+    n_ref, n_compact = [np.array(m.vertex_normals_data()).reshape(-1, 3) for m in meshes]
+    uv_ref, uv_compact = [np.array(m.vertex_texcoords_data()).reshape(-1, 2) for m in meshes]
+    assert np.allclose(np.linalg.norm(n_compact, axis=1), 1, atol=1e-5)
+    assert np.max(np.abs(n_compact - n_ref)) < 1e-4
+    assert np.max(np.abs(uv_compact - uv_ref)) < 4.0 / 65535
+
+    idx = dr.arange(mi.UInt32, 10) * 7
+    assert dr.allclose(meshes[0].vertex_normal(idx), meshes[1].vertex_normal(idx), atol=1e-4)
+    assert dr.allclose(meshes[0].vertex_texcoord(idx), meshes[1].vertex_texcoord(idx), atol=1e-4)
+
+
+def test40_parallel_preprocessing(variant_scalar_rgb):
+    # Directed edges and vertex normals of a large mesh with random topology,
+    # including degenerate faces and non-manifold edges
+    import numpy as np
+
+    rng = np.random.default_rng(1)
+    n_vertices, n_faces = 2000, 50000
+    positions = rng.random((n_vertices, 3)).astype(np.float32)
+    faces = rng.integers(0, n_vertices, (n_faces, 3)).astype(np.uint32)
+    faces[::97, 1] = faces[::97, 0]
+
+    mesh = mi.Mesh('mesh', n_vertices, n_faces, has_vertex_normals=True)
+    params = mi.traverse(mesh)
+    params['vertex_positions'] = positions.ravel()
+    params['faces'] = faces.ravel()
+    params.update()
+
+    # Reference: the (sequential) definition of the opposite edge table
+    f = faces.ravel()
+    start = {}
+    for e in range(3 * n_faces):
+        a, b = f[e], f[e - e % 3 + (e % 3 + 1) % 3]
+        if a != b:
+            start.setdefault(a, []).append((e, b))
+    e2e = np.full(3 * n_faces, 0xFFFFFFFF, dtype=np.uint32)
+    for e in range(3 * n_faces):
+        a, b = f[e], f[e - e % 3 + (e % 3 + 1) % 3]
+        if a == b:
+            continue
+        opp = [o for o, end in start.get(b, []) if end == a]
+        if len(opp) == 1 and e < opp[0]:
+            e2e[e], e2e[opp[0]] = opp[0], e
+
+    mesh.build_directed_edges()
+    opposite = [mesh.opposite_dedge(e) for e in range(3 * n_faces)]
+    assert np.all(np.array(opposite, dtype=np.uint32) == e2e)
+
+    # Angle-weighted vertex normals
+    mesh.recompute_vertex_normals()
+    p = positions[faces]
+    n = np.cross(p[:, 1] - p[:, 0], p[:, 2] - p[:, 0])
+    length = np.linalg.norm(n, axis=1)
+    valid = length > 0
+    n[valid] /= length[valid, None]
+    normals = np.zeros((n_vertices, 3))
+    for i in range(3):
+        d0 = p[:, (i + 1) % 3] - p[:, i]
+        d1 = p[:, (i + 2) % 3] - p[:, i]
+        with np.errstate(invalid='ignore', divide='ignore'):
+            cos = np.sum(d0 * d1, axis=1) / (np.linalg.norm(d0, axis=1) * np.linalg.norm(d1, axis=1))
+        angle = np.arccos(np.clip(cos, -1, 1))
+        np.add.at(normals, faces[valid, i], n[valid] * angle[valid, None])
+    normals /= np.linalg.norm(normals, axis=1)[:, None]
+
+    result = np.array(mi.traverse(mesh)['vertex_normals']).reshape(-1, 3)
+    assert np.allclose(result, normals, atol=1e-4)
+
+
+def test41_precompute_silhouette_hierarchy(variants_vec_rgb):
+    # Compare the silhouette found with the edge hierarchy against a brute
+    # force search, before and after refitting it to new vertex positions
+    import numpy as np
+
+    rng = np.random.default_rng(2)
+    n_theta, n_phi = 40, 80
+    theta, phi = np.meshgrid(np.linspace(0.1, np.pi - 0.1, n_theta),
+                             np.linspace(0, 2 * np.pi, n_phi, endpoint=False),
+                             indexing='ij')
+    positions = np.stack([np.sin(theta) * np.cos(phi),
+                          np.sin(theta) * np.sin(phi),
+                          np.cos(theta)], axis=-1).reshape(-1, 3)
+
+    faces = []
+    for i in range(n_theta - 1):
+        for j in range(n_phi):
+            a, b = i * n_phi + j, i * n_phi + (j + 1) % n_phi
+            c, d = a + n_phi, b + n_phi
+            faces += [(a, b, d), (a, d, c)]
+    faces = np.array(faces, dtype=np.uint32)
+    n_vertices, n_faces = len(positions), len(faces)
+
+    mesh = mi.Mesh('mesh', n_vertices, n_faces)
+    params = mi.traverse(mesh)
+    params['faces'] = faces.ravel()
+
+    params['vertex_positions'] = positions.astype(np.float32).ravel()
+    params.update()
+    mesh.build_directed_edges()
+
+    def check(positions, viewpoint):
+        params['vertex_positions'] = positions.astype(np.float32).ravel()
+        params.update()
+
+        dedges = np.arange(3 * n_faces, dtype=np.uint32)
+        oppo = np.array(mesh.opposite_dedge(mi.UInt32(dedges)), dtype=np.uint32)
+        p = positions.astype(np.float32)[faces]
+        n = np.cross(p[:, 1] - p[:, 0], p[:, 2] - p[:, 0])
+        n /= np.linalg.norm(n, axis=1)[:, None]
+
+        p0 = p.reshape(-1, 3)
+        to_p0 = p0 - viewpoint
+        n_cur, n_oppo = n[dedges // 3], n[oppo % (3 * n_faces) // 3]
+        to_p0 /= np.linalg.norm(to_p0, axis=1)[:, None]
+        product = np.sum(to_p0 * n_cur, axis=1) * np.sum(to_p0 * n_oppo, axis=1)
+        boundary = oppo == 0xFFFFFFFF
+        ref = boundary | ((oppo > dedges) & (product <= 0))
+
+        indices, weights = mesh.precompute_silhouette(mi.ScalarPoint3f(viewpoint))
+        indices = np.array(indices, dtype=np.uint32)
+        assert np.all(np.diff(indices.astype(np.int64)) > 0)
+        assert dr.width(weights) == len(indices) and dr.all(weights > 0)
+
+        # Only edges at the rounding threshold may be classified differently
+        result = np.zeros(3 * n_faces, dtype=bool)
+        result[indices] = True
+        assert np.all((result == ref) | (np.abs(product) < 1e-5))
+
+    for viewpoint in [(0, 0, 3), (2.5, -1, 0.5), (0.2, 0.1, 0)]:
+        check(positions, np.array(viewpoint, dtype=np.float32))
+
+    # Refit: perturb the vertices without changing the topology
+    positions = positions * (1 + 0.1 * rng.random((n_vertices, 1)))
+    for viewpoint in [(0, 3, 1), (-1.5, 0.5, -2)]:
+        check(positions, np.array(viewpoint, dtype=np.float32))
+
+
+def test42_attribute_handles(variants_all_rgb):
+    m = mi.Mesh("MyMesh", 3, 1)
+    params = mi.traverse(m)
+    params['vertex_positions'] = [0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0]
+    params['faces'] = [0, 1, 2]
+    params.update()
+
+    # Several vertex attributes are interleaved in scalar variants
+    m.add_attribute("vertex_color", 3, [1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0])
+    m.add_attribute("vertex_weight", 1, [1.0, 2.0, 3.0])
+    m.add_attribute("face_id", 1, [4.0])
+
+    handle = mi.Shape.attribute_handle("vertex_color")
+    assert mi.Shape.attribute_handle("vertex_color") == handle
+    assert mi.Shape.attribute_name(handle) == "vertex_color"
+
+    scene = mi.load_dict({'type': 'scene', 'mesh': m})
+    si = scene.ray_intersect(mi.Ray3f([0.2, 0.3, -1], [0, 0, 1]))
+    shape = si.shape
+
+    for name in ["vertex_color", "vertex_weight", "face_id"]:
+        h = mi.Shape.attribute_handle(name)
+        assert dr.allclose(shape.eval_attribute(h, si), shape.eval_attribute(name, si))
+        if name == "vertex_color":
+            assert dr.allclose(shape.eval_attribute_3(h, si), [0.5, 0.2, 0.3])
+        else:
+            assert dr.allclose(shape.eval_attribute_1(h, si),
+                               shape.eval_attribute_1(name, si))
+    assert dr.allclose(shape.eval_attribute_1(mi.Shape.attribute_handle("vertex_weight"), si), 1.8)
+
+    # The texture resolves its handle when it is constructed
+    texture = mi.load_dict({'type': 'mesh_attribute', 'name': 'vertex_weight'})
+    assert dr.allclose(texture.eval_1(si), 1.8)
+
+    # Updated attributes are visible through the handles
+    params = mi.traverse(m)
+    params['vertex_weight'] = [2.0, 4.0, 6.0]
+    params.update()
+    assert dr.allclose(texture.eval_1(si), 3.6)
+
+
+def test43_interleaved_vertices(variants_all_rgb):
+    def load(interleaved):
+        return mi.load_dict({
+            'type': 'scene',
+            'cube': {
+                'type': 'cube',
+                'interleaved_vertices': interleaved
+            }
+        })
+
+    scenes = [load(False), load(True)]
+    meshes = [scene.shapes()[0] for scene in scenes]
+    assert not meshes[0].has_interleaved_vertices()
+    assert meshes[1].has_interleaved_vertices() == (not dr.is_jit_v(mi.Float))
+
+    def check():
+        n = 16
+        x, y = dr.meshgrid(dr.linspace(mi.Float, -1.5, 1.5, n),
+                           dr.linspace(mi.Float, -1.5, 1.5, n))
+        ray = mi.Ray3f(mi.Point3f(x, y, -3), dr.normalize(mi.Vector3f(0.1, 0.2, 1)))
+        si_ref, si = [scene.ray_intersect(ray) for scene in scenes]
+        assert dr.all(si.is_valid() == si_ref.is_valid())
+        assert dr.allclose(si.t, si_ref.t)
+        assert dr.allclose(si.uv, si_ref.uv)
+        assert dr.allclose(si.sh_frame.n, si_ref.sh_frame.n)
+
+        m_ref, m = meshes
+        for i in range(m.vertex_count()):
+            assert dr.allclose(m.vertex_position(i), m_ref.vertex_position(i))
+            assert dr.allclose(m.vertex_normal(i), m_ref.vertex_normal(i))
+            assert dr.allclose(m.vertex_texcoord(i), m_ref.vertex_texcoord(i))
+
+    check()
+
+    # The interleaved layout follows parameter updates
+    for scene in scenes:
+        params = mi.traverse(scene)
+        positions = dr.unravel(mi.Point3f, params['cube.vertex_positions'])
+        params['cube.vertex_positions'] = dr.ravel(positions * 0.5 + [0.1, 0, 0])
+        params.update()
+    check()
+
+    with pytest.raises(RuntimeError, match='cannot be combined'):
+        mi.load_dict({
+            'type': 'cube',
+            'compact_vertices': True,
+            'interleaved_vertices': True
+        })
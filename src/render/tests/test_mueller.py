@@ -193,3 +193,28 @@ def test09_circular(variant_scalar_rgb):
     # Light that is already circularly polarized is unchanged.
     dr.allclose(L @ Array4f([1, 0, 0, -1]), Array4f([0.5, 0, 0, -1]))
     dr.allclose(R @ Array4f([1, 0, 0, +1]), Array4f([0.5, 0, 0, +1]))
+
+
+def test10_rotate_mueller_basis_fused(variant_scalar_rgb):
+    # The fused basis change must match the explicit matrix products
+    rng = mi.PCG32(initstate=7)
+    for i in range(10):
+        M = mi.Matrix4f([[rng.next_float32() - 0.5 for j in range(4)] for k in range(4)])
+
+        w_in = dr.normalize(mi.Vector3f(rng.next_float32() - 0.5, rng.next_float32() - 0.5, 1))
+        w_out = dr.normalize(mi.Vector3f(rng.next_float32() - 0.5, 1, rng.next_float32() - 0.5))
+        v = mi.Vector3f(rng.next_float32(), rng.next_float32(), rng.next_float32())
+        bi_cur, bi_tgt = mi.mueller.stokes_basis(w_in), dr.normalize(dr.cross(w_in, v))
+        bo_cur, bo_tgt = mi.mueller.stokes_basis(w_out), dr.normalize(dr.cross(w_out, v))
+
+        ref = mi.mueller.rotate_stokes_basis(w_out, bo_cur, bo_tgt) @ M @ \
+              mi.mueller.rotate_stokes_basis(w_in, bi_tgt, bi_cur)
+        M_rot = mi.mueller.rotate_mueller_basis(M, w_in, bi_cur, bi_tgt,
+                                                w_out, bo_cur, bo_tgt)
+        assert dr.allclose(M_rot, ref, atol=1e-5)
+
+        # Depolarizers are invariant to changes of the Stokes basis
+        D = mi.mueller.depolarizer(0.5)
+        D_rot = mi.mueller.rotate_mueller_basis(D, w_in, bi_cur, bi_tgt,
+                                                w_out, bo_cur, bo_tgt)
+        assert dr.allclose(D_rot, D)
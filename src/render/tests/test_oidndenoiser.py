@@ -0,0 +1,78 @@
+import pytest
+import mitsuba as mi
+import drjit as dr
+
+from mitsuba.scalar_rgb.test.util import find_resource
+
+
+def skip_if_no_oidn(func):
+    from functools import wraps
+
+    @wraps(func)
+    def f(*args, **kwargs):
+        if not hasattr(mi, 'OIDNDenoiser'):
+            pytest.skip("Mitsuba was built without Open Image Denoise support.")
+        return func(*args, **kwargs)
+
+    return f
+
+
+@skip_if_no_oidn
+def test01_denoiser_construct(variants_all_rgb):
+    input_res = [33, 18]
+
+    assert (
+        "OIDNDenoiser[\n  input_size = [33, 18],\n  albedo = 0,\n  " +
+        "normals = 0,\n  prefilter = 0\n]" == str(mi.OIDNDenoiser(input_res))
+    )
+
+    with pytest.raises(Exception) as e:
+        mi.OIDNDenoiser(input_res, albedo=False, normals=True)
+    e.match("The denoiser cannot use normals to guide its process without " +
+            "also providing albedo information!")
+
+
+@skip_if_no_oidn
+def test02_denoiser_denoise(variants_all_rgb):
+    noisy = mi.TensorXf(mi.Bitmap(find_resource("resources/data/tests/denoiser/noisy.exr")))
+    ref = mi.TensorXf(mi.Bitmap(find_resource("resources/data/tests/denoiser/ref.exr")))[..., :3]
+
+    denoiser = mi.OIDNDenoiser(noisy.shape[:2])
+    denoised = denoiser(noisy)
+    assert denoised.shape == noisy.shape
+
+    # Different networks, but both get much closer to the reference
+    def error(image):
+        return dr.mean(dr.abs(image[..., :3] - ref), axis=None)
+    assert error(denoised) < 0.5 * error(noisy)
+
+    with pytest.raises(Exception) as e:
+        mi.OIDNDenoiser([4, 4])(noisy)
+    e.match("The denoiser was created for inputs of size 4 x 4")
+
+
+@skip_if_no_oidn
+def test03_denoiser_denoise_multichannel_bitmap(variants_all_rgb):
+    scene = mi.load_file(find_resource("resources/data/scenes/cbox/cbox-rgb.xml"), res=32)
+    sensor = scene.sensors()[0]
+
+    integrator = mi.load_dict({
+        'type': 'aov',
+        'aovs': 'albedo:albedo,normals:sh_normal',
+        'integrator': { 'type': 'path' }
+    })
+    mi.render(scene, spp=2, integrator=integrator, sensor=sensor)
+    multichannel = sensor.film().bitmap()
+
+    to_sensor = sensor.world_transform().inverse()
+    denoiser = mi.OIDNDenoiser(multichannel.size(), True, True, True)
+    denoised = denoiser(multichannel, albedo_ch='albedo', normals_ch='normals',
+                        to_sensor=to_sensor)
+
+    assert denoised.size() == multichannel.size()
+    assert denoised.channel_count() == 4
+    assert dr.all(dr.isfinite(mi.TensorXf(denoised)), axis=None)
+
+    with pytest.raises(Exception) as e:
+        denoiser(multichannel, albedo_ch='foo', normals_ch='normals')
+    e.match("Could not find layer with channel name 'foo'")
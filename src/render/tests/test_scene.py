@@ -317,6 +317,164 @@ def test11_sample_silhouette_bijective(variants_vec_rgb):
     assert dr.allclose(valid_samples, valid_out, atol=1e-6)
 
 
+def test12_light_bvh_emitter_sampling(variants_all_backends_once):
+    scene_dict = {
+        'type': 'scene',
+        'light_bvh': True,
+        'envmap': {'type': 'constant'},
+    }
+    for i in range(6):
+        scene_dict[f'point_{i}'] = {
+            'type': 'point',
+            'position': [i - 2.5, 0.5 * i, 2.0],
+            'sampling_weight': 1.0 + i,
+        }
+        scene_dict[f'rect_{i}'] = {
+            'type': 'rectangle',
+            'to_world': mi.ScalarTransform4f().translate([2.5 - i, 1.0, 3.0])
+                                              .rotate([1, 0, 0], 30.0 * i),
+            'emitter': {'type': 'area'},
+        }
+    scene = mi.load_dict(scene_dict)
+    emitter_count = len(scene.emitters())
+
+    ref = dr.zeros(mi.Interaction3f)
+    ref.p = [0.1, 0.2, -1.0]
+    ref.n = [0.0, 0.0, 1.0]
+
+    # The probabilities of all emitters sum up to one
+    pmf = [scene.pdf_emitter(ref, i) for i in range(emitter_count)]
+    assert dr.allclose(sum(pmf), 1.0)
+
+    # Sampling is consistent with the probabilities
+    sample = dr.linspace(mi.Float, 0.0, 1.0, 64, endpoint=False)
+    index, weight, reused_sample = scene.sample_emitter(ref, sample)
+    assert dr.all(index < emitter_count)
+    assert dr.allclose(weight, dr.rcp(scene.pdf_emitter(ref, index)))
+    assert dr.all((reused_sample >= 0.0) & (reused_sample < 1.0))
+
+    # Direct illumination sampling matches the evaluated density
+    rect_scene = mi.load_dict({k: v for k, v in scene_dict.items()
+                               if not k.startswith('point')})
+    ds, _ = rect_scene.sample_emitter_direction(
+        ref, mi.Point2f(sample, 0.5), False)
+    valid = ds.pdf > 0.0
+    assert dr.allclose(dr.select(valid, rect_scene.pdf_emitter_direction(ref, ds), 0.0),
+                       ds.pdf, rtol=1e-4)
+
+
+def test12_light_bvh_mesh_triangles(variants_vec_backends_once_rgb):
+    scene_dict = {
+        'type': 'scene',
+        'cube': {
+            'type': 'cube',
+            'to_world': mi.ScalarTransform4f().translate([0.0, 0.0, 3.0])
+                                              .rotate([1, 1, 0], 35.0)
+                                              .scale([2.0, 1.0, 0.5]),
+            'emitter': {'type': 'area'},
+        },
+    }
+    for i in range(4):
+        scene_dict[f'point_{i}'] = {
+            'type': 'point',
+            'position': [i - 1.5, -2.0, 1.0],
+        }
+
+    scene_bvh = mi.load_dict({**scene_dict, 'light_bvh': True})
+    scene_ref = mi.load_dict(scene_dict)
+    assert scene_bvh.light_bvh() is not None
+    assert 'triangle_count = 12' in str(scene_bvh.light_bvh())
+
+    ref = dr.zeros(mi.Interaction3f)
+    ref.p = [0.3, -0.2, 0.0]
+    ref.n = [0.0, 0.0, 1.0]
+
+    sampler = mi.load_dict({'type': 'independent'})
+    sample_count = 1 << 18
+    sampler.seed(0, sample_count)
+    sample = sampler.next_2d()
+
+    # Triangle sampling evaluates to the same density as the query
+    ds, weight = scene_bvh.sample_emitter_direction(ref, sample, False)
+    valid = ds.pdf > 0.0
+    assert dr.allclose(dr.select(valid, scene_bvh.pdf_emitter_direction(ref, ds), 0.0),
+                       ds.pdf, rtol=1e-3)
+
+    # .. and estimates the same unoccluded irradiance as uniform sampling
+    ds_ref, weight_ref = scene_ref.sample_emitter_direction(ref, sample, False)
+    cos_theta = dr.maximum(dr.dot(ds.d, ref.n), 0.0)
+    cos_theta_ref = dr.maximum(dr.dot(ds_ref.d, ref.n), 0.0)
+    estimate = dr.mean(weight[0] * cos_theta)
+    estimate_ref = dr.mean(weight_ref[0] * cos_theta_ref)
+    assert dr.allclose(estimate, estimate_ref, rtol=2e-2)
+
+
+@fresolver_append_path
+def test13_auto_instancing(variant_scalar_rgb):
+    T = mi.ScalarTransform4f
+    bsdf = mi.load_dict({'type': 'diffuse'})
+
+    def scene(auto_instancing):
+        scene_dict = {'type': 'scene', 'auto_instancing': auto_instancing}
+        for i in range(4):
+            scene_dict[f'rect_{i}'] = {
+                'type': 'ply',
+                'filename': 'resources/data/tests/ply/rectangle_normals_uv.ply',
+                'to_world': T().translate([3.0 * i, 0, 0]).rotate([0, 1, 0], 20 * i),
+                # The last copy uses a different material
+                'bsdf': bsdf if i < 3 else {'type': 'conductor'}
+            }
+        return mi.load_dict(scene_dict)
+
+    ref, scene = scene(False), scene(True)
+    assert len(scene.shapes()) == 4
+    assert sum(1 for s in scene.shapes() if s.is_mesh()) == 1
+    assert sum(1 for s in ref.shapes() if s.is_mesh()) == 4
+
+    for i in range(4):
+        for y in [-0.5, 0.1, 0.7]:
+            ray = mi.Ray3f([3.0 * i + 0.2, y, -4], [0, 0, 1])
+            si_ref, si = ref.ray_intersect(ray), scene.ray_intersect(ray)
+            assert si.is_valid() == si_ref.is_valid()
+            if si.is_valid():
+                assert dr.allclose(si.t, si_ref.t, atol=1e-5)
+                assert dr.allclose(si.p, si_ref.p, atol=1e-5)
+                assert dr.allclose(si.sh_frame.n, si_ref.sh_frame.n, atol=1e-4)
+                assert dr.allclose(si.uv, si_ref.uv, atol=1e-5)
+                assert si.bsdf() == si_ref.bsdf()
+
+
+def test14_view_culling(variants_all_rgb):
+    T = mi.ScalarTransform4f
+
+    def scene(view_culling):
+        scene_dict = {
+            'type': 'scene',
+            'view_culling': view_culling,
+            'sensor': {
+                'type': 'perspective',
+                'fov': 40,
+                'to_world': T().look_at(origin=[0, 0, -5], target=[0, 0, 0], up=[0, 1, 0]),
+                'film': {'type': 'hdrfilm', 'width': 32, 'height': 32}
+            },
+            'visible': {'type': 'sphere', 'view_cullable': True},
+            # Behind the sensor
+            'behind': {'type': 'sphere', 'center': [0, 0, -10], 'view_cullable': True},
+            # Not marked as cullable, e.g. since it casts shadows
+            'occluder': {'type': 'sphere', 'center': [0, 20, 0]},
+            'emitter': {'type': 'sphere', 'center': [20, 0, 0], 'emitter': {'type': 'area'}},
+            'aside': {'type': 'sphere', 'center': [-20, 0, 0], 'view_cullable': True}
+        }
+        return mi.load_dict(scene_dict)
+
+    assert len(scene(False).shapes()) == 5
+    culled = scene(True)
+    assert len(culled.shapes()) == 3
+    assert len(culled.emitters()) == 1
+    assert dr.allclose(culled.bbox().min, [-1, -1, -1])
+    assert dr.allclose(culled.bbox().max, [21, 21, 1])
+
+
 def test_enable_embree_robust_flag(variants_any_llvm):
 
     # We intersect rays against two adjacent triangles. The rays hit exactly
@@ -344,3 +502,314 @@ def test_enable_embree_robust_flag(variants_any_llvm):
     scene = mi.load_dict({'type': 'scene', 'mesh': mesh,
                           'embree_use_robust_intersections': True})
     assert dr.all(scene.ray_intersect(ray).is_valid())
+
+
+@fresolver_append_path
+def test_embree_refit(variants_any_llvm):
+    if not mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE disabled")
+
+    def load(**kwargs):
+        return mi.load_dict({
+            'type': 'scene',
+            'mesh': {
+                'type': 'ply',
+                'filename': 'resources/data/common/meshes/bunny_lowres.ply',
+            },
+            'sphere': { 'type': 'sphere', 'radius': 0.1 },
+            **kwargs
+        })
+
+    scene = load(embree_refit=True)
+    params = mi.traverse(scene)
+    key = 'mesh.vertex_positions'
+    positions = mi.Vector3f(dr.unravel(mi.Point3f, params[key]))
+
+    u, v = dr.meshgrid(dr.linspace(mi.Float, 0, 1, 64),
+                       dr.linspace(mi.Float, 0, 1, 64))
+    b = scene.bbox()
+    o = mi.Point3f(dr.lerp(b.min.x - 1, b.max.x + 1, u),
+                   dr.lerp(b.min.y - 1, b.max.y + 1, v), b.min.z - 1)
+    ray = mi.Ray3f(o, mi.Vector3f(0, 0, 1))
+
+    # Deform the mesh several times without changing its topology
+    for i in range(3):
+        offset = mi.Vector3f(0.1 * i, 0.05 * i, 0)
+        scale = 1 + 0.1 * i
+        params[key] = dr.ravel(positions * scale + offset)
+        params.update()
+
+        ref = load()
+        ref_params = mi.traverse(ref)
+        ref_params[key] = params[key]
+        ref_params.update()
+
+        si, si_ref = scene.ray_intersect(ray), ref.ray_intersect(ray)
+        assert dr.all(si.is_valid() == si_ref.is_valid())
+        assert dr.allclose(dr.select(si.is_valid(), si.t, 0),
+                           dr.select(si_ref.is_valid(), si_ref.t, 0))
+
+
+@fresolver_append_path
+def test_embree_build_quality(variants_any_llvm):
+    if not mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE disabled")
+
+    def load(mesh_quality=None, **kwargs):
+        mesh = {
+            'type': 'ply',
+            'filename': 'resources/data/common/meshes/bunny_lowres.ply',
+        }
+        if mesh_quality is not None:
+            mesh['embree_build_quality'] = mesh_quality
+        return mi.load_dict({
+            'type': 'scene',
+            'mesh': mesh,
+            'sphere': { 'type': 'sphere', 'radius': 0.1 },
+            **kwargs
+        })
+
+    ref = load()
+    u, v = dr.meshgrid(dr.linspace(mi.Float, 0, 1, 64),
+                       dr.linspace(mi.Float, 0, 1, 64))
+    b = ref.bbox()
+    o = mi.Point3f(dr.lerp(b.min.x - 1, b.max.x + 1, u),
+                   dr.lerp(b.min.y - 1, b.max.y + 1, v), b.min.z - 1)
+    ray = mi.Ray3f(o, mi.Vector3f(0, 0, 1))
+    si_ref = ref.ray_intersect(ray)
+
+    # The build settings must not affect the intersection results
+    for quality in ['low', 'medium', 'high']:
+        scene = load(mesh_quality='high', embree_build_quality=quality,
+                     embree_compact=True, embree_build_threads=1)
+        si = scene.ray_intersect(ray)
+        assert dr.all(si.is_valid() == si_ref.is_valid())
+        assert dr.allclose(dr.select(si.is_valid(), si.t, 0),
+                           dr.select(si_ref.is_valid(), si_ref.t, 0))
+
+    with pytest.raises(RuntimeError, match='embree_build_quality'):
+        load(embree_build_quality='best')
+    with pytest.raises(RuntimeError, match='embree_build_quality'):
+        load(mesh_quality='best')
+
+
+@fresolver_append_path
+def test_optix_gas_cache(variant_cuda_ad_rgb):
+    def load(**kwargs):
+        return mi.load_dict({
+            'type': 'scene',
+            'mesh': {
+                'type': 'ply',
+                'filename': 'resources/data/common/meshes/bunny_lowres.ply',
+            },
+            'sphere': { 'type': 'sphere', 'radius': 0.1 },
+            **kwargs
+        })
+
+    ref = load()
+    u, v = dr.meshgrid(dr.linspace(mi.Float, 0, 1, 64),
+                       dr.linspace(mi.Float, 0, 1, 64))
+    b = ref.bbox()
+    o = mi.Point3f(dr.lerp(b.min.x - 1, b.max.x + 1, u),
+                   dr.lerp(b.min.y - 1, b.max.y + 1, v), b.min.z - 1)
+    ray = mi.Ray3f(o, mi.Vector3f(0, 0, 1))
+    si_ref = ref.ray_intersect(ray)
+
+    # Scenes with identical geometry share their GAS via the cache, which
+    # must remain valid when one of the scenes is released
+    scenes = [load(optix_gas_cache=True) for i in range(3)]
+    del scenes[0]
+
+    for scene in scenes:
+        si = scene.ray_intersect(ray)
+        assert dr.all(si.is_valid() == si_ref.is_valid())
+        assert dr.allclose(dr.select(si.is_valid(), si.t, 0),
+                           dr.select(si_ref.is_valid(), si_ref.t, 0))
+
+    # Changing the geometry of one scene does not affect the other one
+    params = mi.traverse(scenes[0])
+    key = 'mesh.vertex_positions'
+    params[key] = dr.ravel(dr.unravel(mi.Point3f, params[key]) + mi.Vector3f(10, 0, 0))
+    params.update()
+    si = scenes[1].ray_intersect(ray)
+    assert dr.all(si.is_valid() == si_ref.is_valid())
+
+
+def test_optix_pruned_pipeline(variant_cuda_ad_rgb, tmpdir):
+    # Pipelines only contain the programs of the shape types in the scene
+    def load(shapes, **kwargs):
+        return mi.load_dict({
+            'type': 'scene',
+            'optix_cache_path': str(tmpdir),
+            **shapes,
+            **kwargs
+        })
+
+    disk = { 'disk': { 'type': 'disk', 'to_world': mi.ScalarTransform4f().translate([-2, 0, 0]) } }
+    rect = { 'rect': { 'type': 'rectangle', 'to_world': mi.ScalarTransform4f().translate([2, 0, 0]) } }
+
+    ray = mi.Ray3f(mi.Point3f([-2, 2, 0], 0, -1), mi.Vector3f(0, 0, 1))
+    for shapes in [disk, rect, { **disk, **rect }]:
+        scene = load(shapes)
+        si = scene.ray_intersect(ray)
+        assert dr.all(si.is_valid() == mi.Bool('disk' in shapes, 'rect' in shapes))
+
+    # Sharing the pipeline requires the other scene to cover all shape types
+    with pytest.raises(RuntimeError, match='optix_prune_pipeline'):
+        load(rect, other=load(disk))
+    scene = load(rect, other=load(disk, optix_prune_pipeline=False))
+    assert dr.all(scene.ray_intersect(ray).is_valid() == mi.Bool(False, True))
+
+
+def test_incremental_updates(variants_all_rgb):
+    scene = mi.load_dict({
+        'type': 'scene',
+        'rect': {
+            'type': 'rectangle',
+            'bsdf': { 'type': 'diffuse' },
+            'emitter': { 'type': 'area' }
+        },
+        'sphere': { 'type': 'sphere', 'radius': 0.1 },
+        'light': { 'type': 'point', 'position': [0, 0, 2] }
+    })
+    params = mi.traverse(scene)
+
+    # Appearance updates don't touch the scene's data structures
+    version = scene.structure_version()
+    params['rect.bsdf.reflectance.value'] = 0.2
+    params.update()
+    params['rect.emitter.radiance.value'] = 3.0
+    params.update()
+    params['light.intensity.value'] = 5.0
+    params.update()
+    assert scene.structure_version() == version
+
+    # Sampling weights and placement of emitters, and geometry do
+    params['light.sampling_weight'] = 2.0
+    params.update()
+    assert scene.structure_version() > version
+
+    version = scene.structure_version()
+    params['light.position'] = [0, 1, 2]
+    params.update()
+    assert scene.structure_version() > version
+
+    version = scene.structure_version()
+    params['sphere.to_world'] = mi.ScalarTransform4f().translate([1, 0, 0]).scale(0.1)
+    params.update()
+    assert scene.structure_version() > version
+
+
+def test_incremental_emitter_sampling_weights(variants_all_rgb):
+    scene = mi.load_dict({
+        'type': 'scene',
+        **{f'light_{i}': { 'type': 'point', 'position': [i, 0, 2],
+                           'sampling_weight': 1.0 + i } for i in range(20)}
+    })
+    params = mi.traverse(scene)
+
+    # Only a few weights change, the distribution is updated in place
+    for it in range(3):
+        params['light_3.sampling_weight'] = 0.5 * it
+        params['light_17.sampling_weight'] = 4.0 + it
+        params.update()
+
+        weights = [e.sampling_weight() for e in scene.emitters()]
+        distr = mi.DiscreteDistribution(weights)
+        for i in range(20):
+            assert dr.allclose(scene.pdf_emitter(i), distr.eval_pmf_normalized(i))
+
+        for sample in [0.05, 0.3, 0.71, 0.999]:
+            index, weight, reused = scene.sample_emitter(sample)
+            ref_index, ref_reused, ref_pmf = distr.sample_reuse_pmf(sample)
+            assert dr.allclose(index, ref_index)
+            assert dr.allclose(weight, 1.0 / ref_pmf)
+            assert dr.allclose(reused, ref_reused, atol=1e-5)
+
+
+def test_ray_test_multi(variants_all_rgb):
+    scene = mi.load_dict({
+        'type': 'scene',
+        'sphere_0': {'type': 'sphere', 'center': [0, 0, 3], 'radius': 1},
+        'sphere_1': {'type': 'sphere', 'center': [3, 0, 0], 'radius': 0.5},
+        'rectangle': {'type': 'rectangle',
+                      'to_world': mi.ScalarTransform4f().translate([0, -2, 0])
+                                                        .rotate([1, 0, 0], -90)}
+    })
+
+    # Shadow rays from a common origin, whose count is not a multiple of the
+    # packet width
+    directions = [[0, 0, 1], [1, 0, 0], [0, -1, 0], [0, 1, 0], [-1, 0, 0],
+                  [0, 0, -1], [0.3, 0, 1], [1, 0.05, 0], [0, -1, 0.1]]
+    for count in [1, 3, len(directions)]:
+        rays = [mi.Ray3f([0, 0, 0], dr.normalize(mi.Vector3f(d)))
+                for d in directions[:count]]
+        result = scene.ray_test_multi(rays)
+        assert len(result) == count
+        for ray, occluded in zip(rays, result):
+            assert dr.all(occluded == scene.ray_test(ray))
+
+    # Rays are limited to their extent
+    rays = [mi.Ray3f([0, 0, 0], [0, 0, 1], 1.5), mi.Ray3f([0, 0, 0], [0, 0, 1], 2.5)]
+    assert [bool(dr.all(v)) for v in scene.ray_test_multi(rays)] == [False, True]
+
+    # Disabled rays are never occluded
+    assert not any(dr.any(v) for v in scene.ray_test_multi(rays, active=False))
+
+
+def test_ray_flags(variants_all_rgb):
+    if mi.is_polarized:
+        pytest.skip('Polarized variants always compute all fields')
+
+    def flags(bsdf, **kwargs):
+        return mi.load_dict({
+            'type': 'scene',
+            'sphere': {'type': 'sphere', 'bsdf': bsdf},
+            **kwargs
+        }).ray_flags()
+
+    R = mi.RayFlags
+    basic = R.Minimal | R.ShadingFrame
+    uv = R.UV | R.dPdUV
+
+    assert flags({'type': 'diffuse'}) == basic
+    assert flags({'type': 'roughconductor', 'alpha': 0.2}) == basic
+    assert flags({'type': 'roughconductor', 'alpha_u': 0.1,
+                  'alpha_v': 0.3}) == basic | uv
+    assert flags({'type': 'diffuse', 'reflectance': {
+                  'type': 'checkerboard'}}) == basic | R.UV
+    assert flags({'type': 'bumpmap', 'arbitrary': {'type': 'checkerboard'},
+                  'bsdf': {'type': 'diffuse'}}) == basic | uv
+    assert flags({'type': 'diffuse'}, minimal_ray_flags=False) == R.All
+
+    # Textured emitters are taken into account as well
+    scene = mi.load_dict({
+        'type': 'scene',
+        'rectangle': {
+            'type': 'rectangle',
+            'emitter': {'type': 'area', 'radiance': {'type': 'checkerboard'}}
+        }
+    })
+    assert scene.ray_flags() == basic | R.UV
+
+    # Rendering with the reduced flags yields the same image
+    def render(**kwargs):
+        scene = mi.load_dict({
+            'type': 'scene',
+            'integrator': {'type': 'path', 'max_depth': 3},
+            'sensor': {
+                'type': 'perspective',
+                'to_world': mi.ScalarTransform4f().look_at(
+                    origin=[0, 0, 4], target=[0, 0, 0], up=[0, 1, 0]),
+                'film': {'type': 'hdrfilm', 'width': 16, 'height': 16},
+                'sampler': {'type': 'independent', 'sample_count': 4}
+            },
+            'sphere': {'type': 'sphere', 'bsdf': {
+                'type': 'diffuse',
+                'reflectance': {'type': 'checkerboard'}}},
+            'emitter': {'type': 'constant'},
+            **kwargs
+        })
+        return mi.render(scene, seed=0)
+
+    assert dr.allclose(render(), render(minimal_ray_flags=False))
@@ -77,3 +77,117 @@ def test03_normal_film(variant_scalar_rgb):
     # Resetting and re-querying the blocks should yield the exact same results.
     s.reset()
     check_first_blocks(extract_blocks(s), expected, n_total=110)
+
+
+def test04_multiple_passes(variant_scalar_rgb):
+    f = make_film(100, 70)
+    s = mi.Spiral(f.size(), f.crop_offset(), passes=3)
+    assert s.passes() == 3
+    n = s.block_count()
+
+    blocks = extract_blocks(s)
+    assert len(blocks) == 3 * n
+
+    # Every pass traverses the same spiral, and block IDs are unique
+    for i in range(n):
+        assert dr.all(blocks[i][0] == blocks[i + n][0])
+        assert dr.all(blocks[i][1] == blocks[i + 2 * n][1])
+    assert sorted([b[2] for b in blocks]) == list(range(3 * n))
+
+
+def test05_random_access(variant_scalar_rgb):
+    f = make_film(318, 322)
+    s = mi.Spiral(f.size(), f.crop_offset(), passes=2)
+    blocks = extract_blocks(s)
+
+    for i, b in enumerate(blocks):
+        o, sz, bi = s.block(i)
+        assert dr.all(o == b[0]) and dr.all(sz == b[1]) and bi == b[2]
+
+    assert dr.all(s.block(len(blocks))[1] == 0)
+
+
+def extract_blocks_partition(spiral, partition):
+    blocks = []
+    b = spiral.next_block(partition)
+
+    while np.prod(b[1]) > 0:
+        blocks.append(b)
+        b = spiral.next_block(partition)
+    return blocks
+
+
+def test06_partitions(variant_scalar_rgb):
+    f = make_film(318, 322)
+    s = mi.Spiral(f.size(), f.crop_offset(), block_size=32, passes=2)
+    s.set_partitions(3)
+    assert s.partitions() == 3
+    n = s.block_count()
+
+    # A single caller eventually receives every block exactly once
+    blocks = extract_blocks_partition(s, 1)
+    assert sorted([b[2] for b in blocks]) == list(range(2 * n))
+
+    # The blocks of the middle stripe (4 of 11 block rows) come first ..
+    own = 2 * 4 * 10
+    for o, sz, bi in blocks[:own]:
+        assert 128 <= o[1] < 256
+
+    # .. followed by the blocks stolen from the next partition
+    assert blocks[own][0][1] >= 256
+
+
+@pytest.mark.parametrize('order', ['Hilbert', 'Morton'])
+def test07_space_filling_curves(variant_scalar_rgb, order):
+    f = make_film(318, 166)
+    order = getattr(mi.BlockOrder, order)
+    s = mi.Spiral(f.size(), f.crop_offset(), block_size=32, passes=2,
+                  order=order)
+    assert s.order() == order
+    n = s.block_count()
+    assert n == 10 * 6
+
+    blocks = extract_blocks(s)
+    assert sorted([b[2] for b in blocks]) == list(range(2 * n))
+
+    # Every block is visited once per pass, and sizes are clipped to the film
+    offsets = [(int(b[0][0]), int(b[0][1])) for b in blocks[:n]]
+    assert len(set(offsets)) == n
+    assert sum(int(b[1][0]) * int(b[1][1]) for b in blocks[:n]) == 318 * 166
+
+    # Both passes use the same deterministic order
+    assert offsets == [(int(b[0][0]), int(b[0][1])) for b in blocks[n:]]
+    s2 = mi.Spiral(f.size(), f.crop_offset(), block_size=32, passes=2,
+                   order=order)
+    assert [s2.block(i)[2] for i in range(2 * n)] == [b[2] for b in blocks]
+
+    if order == mi.BlockOrder.Hilbert:
+        # Consecutive blocks within the power-of-two part of the grid are adjacent
+        for i in range(15):
+            d = np.abs(np.array(offsets[i + 1]) - np.array(offsets[i]))
+            assert d.sum() == 32
+    else:
+        assert offsets[:4] == [(0, 0), (32, 0), (0, 32), (32, 32)]
+
+
+def test08_block_order_integrator(variant_scalar_rgb):
+    def render(order):
+        scene = mi.load_dict({
+            'type': 'scene',
+            'integrator': {'type': 'path', 'block_order': order,
+                           'block_size': 8},
+            'sensor': {
+                'type': 'perspective',
+                'film': {'type': 'hdrfilm', 'width': 40, 'height': 24,
+                         'rfilter': {'type': 'box'}},
+            },
+            'emitter': {'type': 'constant'}
+        })
+        return mi.render(scene, spp=4)
+
+    # A constant environment renders identically, regardless of the seeding
+    assert dr.allclose(render('spiral'), render('hilbert'))
+    assert dr.allclose(render('spiral'), render('morton'))
+
+    with pytest.raises(RuntimeError, match='Invalid block order'):
+        render('diagonal')
@@ -1,8 +1,12 @@
 #include <mitsuba/render/volumegrid.h>
+#include <mitsuba/core/bstream.h>
 #include <mitsuba/core/stream.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/util.h>
+#include <drjit-core/half.h>
+#include <nanothread/nanothread.h>
+#include <mutex>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -11,8 +15,27 @@ VolumeGrid<Float, Spectrum>::VolumeGrid(Stream *stream) { read(stream); }
 
 MI_VARIANT
 VolumeGrid<Float, Spectrum>::VolumeGrid(const fs::path &filename) {
-    ref<FileStream> fs = new FileStream(filename);
-    read(fs);
+    ref<BufferedStream> fs = new BufferedStream(new FileStream(filename));
+    int32_t data_type = read_header(fs);
+
+    size_t count = dr::prod(m_size) * m_channel_count,
+           offset = fs->tell();
+
+    /* Map single precision payloads directly, since they are already laid
+       out in memory as expected */
+    if (data_type == 1 && std::is_same_v<ScalarFloat, float> &&
+        !fs->needs_endianness_swap() && offset % alignof(float) == 0 &&
+        fs->size() >= offset + count * sizeof(float)) {
+        fs->close();
+        m_mmap = MemoryMappedFile::map_copy_on_write(filename);
+        m_data_ptr = (ScalarFloat *) ((uint8_t *) m_mmap->data() + offset);
+        compute_max();
+        Log(Debug, "Mapped grid volume data from file: dimensions %s, max value %f",
+            m_size, m_max);
+    } else {
+        fs->seek(0);
+        read(fs);
+    }
 }
 
 MI_VARIANT
@@ -23,10 +46,12 @@ VolumeGrid<Float, Spectrum>::VolumeGrid(ScalarVector3u size,
       m_max_per_channel(channel_count, 0.f) {
     m_data = std::unique_ptr<ScalarFloat[]>(
         new ScalarFloat[dr::prod(m_size) * m_channel_count]);
+    m_data_ptr = m_data.get();
+    m_memory.set(dr::prod(m_size) * m_channel_count * sizeof(ScalarFloat));
 }
 
 MI_VARIANT
-void VolumeGrid<Float, Spectrum>::read(Stream *stream) {
+int32_t VolumeGrid<Float, Spectrum>::read_header(Stream *stream) {
     char header[3];
     stream->read(header, 3);
 
@@ -40,9 +65,9 @@ void VolumeGrid<Float, Spectrum>::read(Stream *stream) {
 
     int32_t data_type;
     stream->read(data_type);
-    if (data_type != 1)
-        Throw("Wrong type, currently only type == 1 (Float32) data is "
-              "supported (found type = %d)", data_type);
+    if (data_type != 1 && data_type != 2)
+        Throw("Wrong type, currently only type == 1 (Float32) and type == 2 "
+              "(Float16) data are supported (found type = %d)", data_type);
 
     int32_t size_x, size_y, size_z;
     stream->read(size_x);
@@ -52,7 +77,6 @@ void VolumeGrid<Float, Spectrum>::read(Stream *stream) {
     m_size.y() = uint32_t(size_y);
     m_size.z() = uint32_t(size_z);
 
-    size_t size = dr::prod(m_size);
     int32_t channel_count;
     stream->read(channel_count);
     m_channel_count = channel_count;
@@ -63,25 +87,77 @@ void VolumeGrid<Float, Spectrum>::read(Stream *stream) {
     m_bbox = ScalarBoundingBox3f(ScalarPoint3f(dims[0], dims[1], dims[2]),
                                  ScalarPoint3f(dims[3], dims[4], dims[5]));
 
-    m_max = -dr::Infinity<ScalarFloat>;
-    m_max_per_channel.resize(m_channel_count, -dr::Infinity<ScalarFloat>);
-
-    m_data = std::unique_ptr<ScalarFloat[]>(new ScalarFloat[size * m_channel_count]);
-    size_t k = 0;
-    for (size_t i = 0; i < size; ++i) {
-        for (size_t j = 0; j < m_channel_count; ++j) {
-            float val;
-            stream->read(val);
-            m_data[k] = val;
-            m_max     = dr::maximum(m_max, val);
-            m_max_per_channel[j] = dr::maximum(m_max_per_channel[j], val);
-            ++k;
+    return data_type;
+}
+
+MI_VARIANT
+void VolumeGrid<Float, Spectrum>::read(Stream *stream) {
+    int32_t data_type = read_header(stream);
+    size_t count = dr::prod(m_size) * m_channel_count;
+
+    m_data = std::unique_ptr<ScalarFloat[]>(new ScalarFloat[count]);
+    m_data_ptr = m_data.get();
+    m_memory.set(count * sizeof(ScalarFloat));
+
+    if (data_type == 1 && std::is_same_v<ScalarFloat, float>) {
+        stream->read_array((float *) m_data_ptr, count);
+    } else {
+        // Decode the payload in parallel after reading it in one go
+        std::unique_ptr<float[]> f32;
+        std::unique_ptr<uint16_t[]> f16;
+        if (data_type == 1) {
+            f32 = std::unique_ptr<float[]>(new float[count]);
+            stream->read_array(f32.get(), count);
+        } else {
+            f16 = std::unique_ptr<uint16_t[]>(new uint16_t[count]);
+            stream->read_array(f16.get(), count);
         }
+
+        dr::parallel_for(
+            dr::blocked_range<size_t>(0, count, 1 << 16),
+            [&](const dr::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    if (f32) {
+                        m_data_ptr[i] = (ScalarFloat) f32[i];
+                    } else {
+                        m_data_ptr[i] = (ScalarFloat) (float) dr::half::from_binary(f16[i]);
+                    }
+                }
+            }
+        );
     }
+
+    compute_max();
     Log(Debug, "Loaded grid volume data from file: dimensions %s, max value %f",
         m_size, m_max);
 }
 
+MI_VARIANT
+void VolumeGrid<Float, Spectrum>::compute_max() {
+    size_t voxels = dr::prod(m_size), channels = m_channel_count;
+
+    std::mutex mutex;
+    m_max = -dr::Infinity<ScalarFloat>;
+    m_max_per_channel.assign(channels, -dr::Infinity<ScalarFloat>);
+
+    dr::parallel_for(
+        dr::blocked_range<size_t>(0, voxels, 1 << 16),
+        [&](const dr::blocked_range<size_t> &range) {
+            std::vector<ScalarFloat> local(channels, -dr::Infinity<ScalarFloat>);
+            const ScalarFloat *ptr = m_data_ptr + range.begin() * channels;
+            for (size_t i = range.begin(); i != range.end(); ++i)
+                for (size_t j = 0; j < channels; ++j)
+                    local[j] = dr::maximum(local[j], *ptr++);
+
+            std::lock_guard<std::mutex> guard(mutex);
+            for (size_t j = 0; j < channels; ++j) {
+                m_max_per_channel[j] = dr::maximum(m_max_per_channel[j], local[j]);
+                m_max = dr::maximum(m_max, local[j]);
+            }
+        }
+    );
+}
+
 MI_VARIANT
 void VolumeGrid<Float, Spectrum>::max_per_channel(ScalarFloat *out) const {
     for (size_t i=0; i<m_channel_count; ++i)
@@ -89,16 +165,16 @@ void VolumeGrid<Float, Spectrum>::max_per_channel(ScalarFloat *out) const {
 }
 
 MI_VARIANT
-void VolumeGrid<Float, Spectrum>::write(const fs::path &path) const {
+void VolumeGrid<Float, Spectrum>::write(const fs::path &path, bool half) const {
     ref<FileStream> fs = new FileStream(path, FileStream::ETruncReadWrite);
-    write(fs);
+    write(fs, half);
 }
 
 MI_VARIANT
-void VolumeGrid<Float, Spectrum>::write(Stream *stream) const {
+void VolumeGrid<Float, Spectrum>::write(Stream *stream, bool half) const {
     stream->write("VOL", 3);
     stream->write(uint8_t(3)); // file format version
-    stream->write(int32_t(1)); // data_type
+    stream->write(int32_t(half ? 2 : 1)); // data_type
     stream->write(int32_t(m_size.x()));
     stream->write(int32_t(m_size.y()));
     stream->write(int32_t(m_size.z()));
@@ -111,14 +187,20 @@ void VolumeGrid<Float, Spectrum>::write(Stream *stream) const {
     stream->write(float(m_bbox.max.y()));
     stream->write(float(m_bbox.max.z()));
 
-    if constexpr (std::is_same<ScalarFloat, float>::value)
-        stream->write_array(m_data.get(), dr::prod(m_size) * m_channel_count);
-    else {
+    size_t count = dr::prod(m_size) * m_channel_count;
+    if (half) {
+        std::vector<uint16_t> output(count);
+        for (size_t i = 0; i < count; ++i)
+            output[i] = dr::half((float) m_data_ptr[i]).value;
+        stream->write_array(output.data(), count);
+    } else if constexpr (std::is_same<ScalarFloat, float>::value) {
+        stream->write_array(m_data_ptr, count);
+    } else {
         // Need to convert data to single precision before writing to disk
-        std::vector<float> output(dr::prod(m_size) * m_channel_count);
-        for (size_t i = 0; i < dr::prod(m_size) * m_channel_count; ++i)
-            output[i] = m_data[i];
-        stream->write_array(output.data(), dr::prod(m_size) * m_channel_count);
+        std::vector<float> output(count);
+        for (size_t i = 0; i < count; ++i)
+            output[i] = m_data_ptr[i];
+        stream->write_array(output.data(), count);
     }
 }
 
@@ -135,7 +217,7 @@ std::string VolumeGrid<Float, Spectrum>::to_string() const {
     oss << std::endl;
     oss << "  ],"  << std::endl
         << "  data = [ " << util::mem_string(buffer_size())
-        << " of volume data ]" << std::endl
+        << " of " << (m_mmap ? "memory-mapped " : "") << "volume data ]" << std::endl
         << "]";
     return oss.str();
 }
@@ -121,3 +121,23 @@ def test09_resampler_filter_only(variant_scalar_rgb):
     assert dr.allclose(b[0], (G(0) * a[0] + G(1) * (a[1] + a[2])) / (G(0) + 2*G(1)), atol=1e-4)
     assert dr.allclose(b[1], (G(0) * a[1] + G(1) * (a[0] + a[2])) / (G(0) + 2*G(1)), atol=1e-4)
     assert dr.allclose(b[2], (G(0) * a[2] + G(1) * (a[0] + a[1])) / (G(0) + 2*G(1)), atol=1e-4)
+
+
+@pytest.mark.parametrize('bc', ['Clamp', 'Zero', 'One', 'Repeat', 'Mirror'])
+@pytest.mark.parametrize('target_res', [3, 7, 11])
+def test10_resampler_columns(variant_scalar_rgb, bc, target_res):
+    f = mi.load_dict({'type': 'lanczos'})
+    resampler = mi.Resampler(f, 7, target_res)
+    resampler.set_boundary_condition(getattr(mi.FilterBoundaryCondition, bc))
+
+    # Resampling 4 interleaved columns at once matches resampling each one
+    count = 4
+    a = dr.sin(dr.linspace(Float, 0, 10, 7 * count))
+    b = dr.zeros(Float, target_res * count)
+    resampler.resample_columns(a, b, count)
+
+    for k in range(count):
+        col = Float([a[i * count + k] for i in range(7)])
+        ref = dr.zeros(Float, target_res)
+        resampler.resample(col, 1, ref, 1, 1)
+        assert dr.all(Float([b[i * count + k] for i in range(target_res)]) == ref)
@@ -25,7 +25,9 @@ Independent sampler (:monosp:`independent`)
 The independent sampler produces a stream of independent and uniformly
 distributed pseudorandom numbers. Internally, it relies on the
 `PCG32 random number generator <https://www.pcg-random.org/>`_
-by Melissa O’Neill.
+by Melissa O’Neill. In scalar variants, the outputs of the generator are
+computed eight at a time using SIMD instructions and buffered, which yields
+the same sequence at a lower cost per number.
 
 This is the most basic sample generator; because no precautions are taken to avoid
 sample clumping, images produced using this plugin will usually take longer to converge.
@@ -69,7 +71,7 @@ class IndependentSampler final : public PCG32Sampler<Float, Spectrum> {
 public:
     MI_IMPORT_BASE(PCG32Sampler, m_sample_count, m_base_seed, m_rng, seed,
                    seeded, m_samples_per_wavefront, m_wavefront_size,
-                   schedule_state)
+                   schedule_state, next_float_batched)
     MI_IMPORT_TYPES()
 
     IndependentSampler(const Properties &props) : Base(props) { }
@@ -87,7 +89,7 @@ public:
 
     Float next_1d(Mask active = true) override {
         Assert(seeded());
-        return m_rng.template next_float<Float>(active);
+        return next_float_batched(active);
     }
 
     Point2f next_2d(Mask active = true) override {
@@ -171,6 +171,13 @@ public:
 
     MI_DECLARE_CLASS()
 
+protected:
+    void gather_state(const UInt32 &index) override {
+        Base::gather_state(index);
+        if (dr::width(m_scramble_seed) > 1)
+            m_scramble_seed = dr::gather<UInt32>(m_scramble_seed, index);
+    }
+
 private:
     LowDiscrepancySampler(const LowDiscrepancySampler &sampler) : Base(sampler) {
         m_scramble_seed = sampler.m_scramble_seed;
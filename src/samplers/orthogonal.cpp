@@ -178,6 +178,13 @@ public:
 
     MI_DECLARE_CLASS()
 
+protected:
+    void gather_state(const UInt32 &index) override {
+        Base::gather_state(index);
+        if (dr::width(m_permutation_seed) > 1)
+            m_permutation_seed = dr::gather<UInt32>(m_permutation_seed, index);
+    }
+
 private:
     /// Compute the digits of decimal value \ref i expressed in base \ref m_strength
     std::vector<UInt32> to_base_s(UInt32 i) {
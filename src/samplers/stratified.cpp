@@ -178,6 +178,13 @@ public:
 
     MI_DECLARE_CLASS()
 
+protected:
+    void gather_state(const UInt32 &index) override {
+        Base::gather_state(index);
+        if (dr::width(m_permutation_seed) > 1)
+            m_permutation_seed = dr::gather<UInt32>(m_permutation_seed, index);
+    }
+
 private:
     StratifiedSampler(const StratifiedSampler &sampler) : Base(sampler) {
         m_jitter           = sampler.m_jitter;
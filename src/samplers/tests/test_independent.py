@@ -58,3 +58,30 @@ def test05_jit_seed(variants_vec_rgb):
     assert seed.state == state_before
 
     check_sampler_kernel_hash_wavefront(mi.UInt, sampler)
+
+def test06_batched_generation(variants_any_scalar):
+    # Scalar variants generate the numbers in batches, which must not change
+    # any of them (the batches are not aligned with the calls below)
+    sampler = mi.load_dict({
+        "type": "independent",
+        "sample_count": 4
+    })
+
+    double = 'double' in mi.variant()
+    def next_ref(rng):
+        return rng.next_float64() if double else rng.next_float32()
+
+    for seed in [0, 3]:
+        sampler.seed(seed)
+        rng = dr.scalar.PCG32(initstate=seed)
+        for i in range(100):
+            if i % 7 == 0:
+                # Masked calls don't advance the random number generator
+                sampler.next_1d(False)
+            assert sampler.next_1d() == next_ref(rng)
+            assert dr.all(sampler.next_2d() == [next_ref(rng), next_ref(rng)])
+
+    # Clones continue with the same numbers
+    clone = sampler.clone()
+    for i in range(20):
+        assert sampler.next_1d() == clone.next_1d()
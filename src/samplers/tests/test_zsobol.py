@@ -0,0 +1,93 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+from .utils import (
+    check_uniform_scalar_sampler,
+    check_uniform_wavefront_sampler,
+    check_deep_copy_sampler_scalar,
+    check_deep_copy_sampler_wavefront,
+    check_sampler_kernel_hash_wavefront,
+)
+
+
+def test01_zsobol_scalar(variant_scalar_rgb):
+    sampler = mi.load_dict({
+        "type" : "zsobol",
+        "sample_count" : 1024,
+    })
+    sampler.seed(0)
+
+    check_uniform_scalar_sampler(sampler)
+
+
+def test02_zsobol_wavefront(variants_vec_backends_once):
+    sampler = mi.load_dict({
+        "type" : "zsobol",
+        "sample_count" : 1024,
+    })
+    sampler.seed(0, 1024)
+
+    check_uniform_wavefront_sampler(sampler)
+
+
+def test03_copy_sampler_scalar(variants_any_scalar):
+    sampler = mi.load_dict({
+        "type" : "zsobol",
+        "sample_count" : 1024,
+    })
+    sampler.seed(0)
+
+    check_deep_copy_sampler_scalar(sampler)
+
+
+def test04_copy_sampler_wavefront(variants_vec_backends_once):
+    sampler = mi.load_dict({
+        "type" : "zsobol",
+        "sample_count" : 1024,
+    })
+    sampler.seed(0, 1024)
+
+    check_deep_copy_sampler_wavefront(sampler)
+
+
+def test05_jit_seed(variants_vec_rgb):
+    sampler = mi.load_dict({
+        "type": "zsobol",
+    })
+    seed = mi.UInt(0)
+    state_before = seed.state
+    sampler.seed(seed, 64)
+    assert seed.state == state_before
+
+    check_sampler_kernel_hash_wavefront(mi.UInt, sampler)
+
+
+@pytest.mark.parametrize("spp", [1, 2])
+def test06_pixel_quads(variants_vec_backends_once, spp):
+    # The samples of every 2x2 quad of pixels are jointly stratified
+    import numpy as np
+
+    sampler = mi.load_dict({
+        "type" : "zsobol",
+        "sample_count" : spp,
+    })
+    width = 8
+    sampler.set_samples_per_wavefront(spp)
+    sampler.set_film_width(width)
+    sampler.seed(0, width * width * spp)
+
+    for dim in range(3):
+        strata = np.array(dr.floor(sampler.next_1d() * 4 * spp), dtype=np.int32)
+        strata = strata.reshape(width // 2, 2, width // 2, 2, spp)
+        strata = strata.transpose(0, 2, 1, 3, 4).reshape(-1, 4 * spp)
+        for quad in strata:
+            assert len(np.unique(quad)) == 4 * spp
+
+
+def test07_sample_count(variant_scalar_rgb):
+    sampler = mi.load_dict({
+        "type" : "zsobol",
+        "sample_count" : 12,
+    })
+    assert sampler.sample_count() == 16
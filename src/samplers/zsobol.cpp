@@ -0,0 +1,287 @@
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/qmc.h>
+#include <mitsuba/render/sampler.h>
+#include <drjit/morton.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _sampler-zsobol:
+
+Z-ordered Sobol sampler (:monosp:`zsobol`)
+------------------------------------------
+
+.. pluginparameters::
+
+ * - sample_count
+   - |int|
+   - Number of samples per pixel. This value has to be a power of two. (Default: 4)
+
+ * - seed
+   - |int|
+   - Seed offset (Default: 0)
+
+This plugin implements the Z-ordered Sobol sampler of Ahmed and Wonka
+:cite:`Ahmed2020Screen`. It draws all samples of an image from a single
+Owen-scrambled Sobol sequence :cite:`Burley2020Practical`, and assigns
+consecutive blocks of this sequence to the pixels along a Morton (Z-order)
+curve. The base-4 digits of the resulting sample indices are furthermore
+shuffled by permutations that depend on the more significant digits, which
+preserves the stratification of the samples of every pixel while decorrelating
+neighboring pixels in a structured way.
+
+As a consequence, the error of the image is distributed as blue noise, which is
+mostly apparent at low sample counts. Such images are perceptually more
+pleasing, and denoisers can reconstruct them from fewer samples. The samples of
+every pixel are furthermore stratified like those of the :ref:`ldsampler
+<sampler-ldsampler>`, with all dimensions being scrambled independently.
+
+Every sample is computed from its index in closed form, which makes it
+possible to continue a sequence at any position. Rendering more samples than
+:paramtype:`sample_count` (e.g. in progressive or adaptive mode) continues
+with a new scrambling of the sequence for every further group of
+:paramtype:`sample_count` samples.
+
+In scalar variants, the rendering loop traverses the pixels of every block in
+Morton order, and this order is used directly. In vectorized variants, the
+sampler recovers the pixel coordinates from the scanline layout of the
+wavefront (see ``Sampler::set_film_width()``).
+
+.. tabs::
+    .. code-tab:: xml
+        :name: zsobol-sampler
+
+        <sampler type="zsobol">
+            <integer name="sample_count" value="16"/>
+        </sampler>
+
+    .. code-tab:: python
+
+        'type': 'zsobol',
+        'sample_count': '16'
+
+ */
+
+template <typename Float, typename Spectrum>
+class ZSobolSampler final : public Sampler<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Sampler, m_sample_count, m_base_seed, seeded,
+                   m_samples_per_wavefront, m_wavefront_size, m_film_width,
+                   m_dimension_index, current_sample_index)
+    MI_IMPORT_TYPES()
+
+    using UInt64 = dr::uint64_array_t<Float>;
+
+    ZSobolSampler(const Properties &props) : Base(props) {
+        set_sample_count(m_sample_count);
+    }
+
+    void set_sample_count(uint32_t spp) override {
+        // Make sure sample_count is a power of two
+        uint32_t res = math::round_to_power_of_two(std::max(spp, 1u));
+
+        if (spp != res)
+            Log(Warn, "Sample count should be a power of two, rounding to %i", res);
+
+        m_sample_count = res;
+        m_log2_spp = dr::log2i(res);
+    }
+
+    ref<Sampler<Float, Spectrum>> fork() override {
+        ZSobolSampler *sampler           = new ZSobolSampler(Properties());
+        sampler->m_sample_count          = m_sample_count;
+        sampler->m_log2_spp              = m_log2_spp;
+        sampler->m_samples_per_wavefront = m_samples_per_wavefront;
+        sampler->m_film_width            = m_film_width;
+        sampler->m_base_seed             = m_base_seed;
+        return sampler;
+    }
+
+    ref<Sampler<Float, Spectrum>> clone() override {
+        return new ZSobolSampler(*this);
+    }
+
+    void seed(UInt32 seed, uint32_t wavefront_size) override {
+        Base::seed(seed, wavefront_size);
+
+        if constexpr (dr::is_array_v<Float>) {
+            // Recover the pixel coordinates from the layout of the wavefront
+            UInt32 sequence = dr::arange<UInt32>(m_wavefront_size) /
+                              dr::opaque<UInt32>(m_samples_per_wavefront);
+            uint32_t pixels = m_wavefront_size / m_samples_per_wavefront,
+                     width  = m_film_width > 0 ? m_film_width : pixels,
+                     height = (pixels + width - 1) / width;
+
+            UInt32 y = sequence / dr::opaque<UInt32>(width),
+                   x = dr::fnmadd(y, width, sequence);
+            m_morton = dr::morton_encode(Point<UInt32, 2>(x, y));
+
+            m_digits = dr::log2i(math::round_to_power_of_two(
+                           std::max(std::max(width, height), 1u))) +
+                       (m_log2_spp + 1) / 2;
+            m_seed = sample_tea_32(dr::opaque<UInt32>(m_base_seed, 1),
+                                   dr::opaque<UInt32>(seed)).first;
+        } else {
+            /* The scalar rendering loop seeds every pixel of a block
+               separately, with consecutive seeds along a Morton curve */
+            m_morton = seed;
+            m_digits = 16 + (m_log2_spp & 1);
+            m_seed = sample_tea_32(UInt32(m_base_seed), UInt32(0)).first;
+        }
+
+        m_digits = std::min(m_digits, 16u + (m_log2_spp & 1));
+    }
+
+    Float next_1d(Mask /*active*/ = true) override {
+        Assert(seeded());
+
+        UInt32 index = current_sample_index(),
+               sobol_index = permuted_index(index, m_dimension_index);
+
+        UInt32 scramble = sample_tea_32(m_dimension_index, scramble_seed(index)).first;
+        m_dimension_index++;
+
+        return to_float(owen_scramble_2(reverse_bits_32(sobol_index), scramble));
+    }
+
+    Point2f next_2d(Mask /*active*/ = true) override {
+        Assert(seeded());
+
+        UInt32 index = current_sample_index(),
+               sobol_index = permuted_index(index, m_dimension_index);
+
+        auto [scramble_x, scramble_y] =
+            sample_tea_32(m_dimension_index, scramble_seed(index));
+        m_dimension_index++;
+
+        Float x = to_float(owen_scramble_2(reverse_bits_32(sobol_index), scramble_x)),
+              y = to_float(owen_scramble_2(sobol_2_bits(sobol_index), scramble_y));
+
+        return Point2f(x, y);
+    }
+
+    void schedule_state() override {
+        Base::schedule_state();
+        dr::schedule(m_morton, m_seed);
+    }
+
+    void traverse_1_cb_ro(void *payload, void (*fn)(void *, uint64_t)) const override {
+        auto fields = dr::make_tuple(m_morton, m_seed, m_dimension_index);
+        dr::traverse_1_fn_ro(fields, payload, fn);
+    }
+
+    void traverse_1_cb_rw(void *payload, uint64_t (*fn)(void *, uint64_t)) override {
+        auto fields = dr::tie(m_morton, m_seed, m_dimension_index);
+        dr::traverse_1_fn_rw(fields, payload, fn);
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "ZSobolSampler [" << std::endl
+            << "  sample_count = " << m_sample_count << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+
+protected:
+    void gather_state(const UInt32 &index) override {
+        Base::gather_state(index);
+        if (dr::width(m_morton) > 1)
+            m_morton = dr::gather<UInt32>(m_morton, index);
+    }
+
+private:
+    ZSobolSampler(const ZSobolSampler &sampler) : Base(sampler) {
+        m_morton   = sampler.m_morton;
+        m_seed     = sampler.m_seed;
+        m_log2_spp = sampler.m_log2_spp;
+        m_digits   = sampler.m_digits;
+    }
+
+    /// Seed of the Owen scrambling, which changes every 'sample_count' samples
+    UInt32 scramble_seed(const UInt32 &index) const {
+        return m_seed + (index >> m_log2_spp) * 0x9e3779b9u;
+    }
+
+    /**
+     * \brief Compute the index of a sample within the Sobol' sequence
+     *
+     * The index is the Morton code of the pixel followed by the index of the
+     * sample within the pixel. Its base-4 digits are permuted using one of 24
+     * permutations selected by a hash of the more significant digits and of
+     * the dimension. When the number of samples per pixel is an odd power of
+     * two, the least significant (base-2) digit is flipped instead.
+     */
+    UInt32 permuted_index(const UInt32 &index, const UInt32 &dimension) const {
+        UInt64 morton_index = (UInt64(m_morton) << m_log2_spp) |
+                              UInt64(index & (m_sample_count - 1u)),
+               dimension_hash = UInt64(dimension * 0x55555555u);
+
+        bool odd = m_log2_spp & 1;
+        UInt32 result = 0;
+
+        for (int32_t i = (int32_t) m_digits - 1; i >= (odd ? 1 : 0); --i) {
+            uint32_t shift = 2 * (uint32_t) i - (odd ? 1 : 0);
+
+            UInt32 digit = UInt32(morton_index >> shift) & 3u;
+            UInt64 higher_digits = morton_index >> (shift + 2);
+            UInt32 perm = UInt32(mix_bits(higher_digits ^ dimension_hash) >> 24) % 24u;
+
+            result |= permute_digit(perm, digit) << shift;
+        }
+
+        if (odd) {
+            UInt32 digit = UInt32(morton_index) & 1u;
+            result |= digit ^ (UInt32(mix_bits((morton_index >> 1) ^ dimension_hash)) & 1u);
+        }
+
+        return result;
+    }
+
+    /// Apply permutation 'perm' (in [0, 24)) of the digits {0, 1, 2, 3}
+    static UInt32 permute_digit(const UInt32 &perm, const UInt32 &digit) {
+        /* The 24 permutations in lexicographic order, encoded using two bits
+           per entry and eight bits per permutation */
+        UInt64 table = dr::select(perm < 8u, UInt64(0xb1e16c9c78d8b4e4ull),
+                       dr::select(perm < 16u, UInt64(0x36c672d22d8d39c9ull),
+                                              UInt64(0x1b4b278763931e4eull)));
+
+        UInt32 entry = UInt32(table >> UInt64((perm & 7u) * 8u));
+        return (entry >> (digit * 2u)) & 3u;
+    }
+
+    /// 64 bit finalizer of a hash function with good avalanche properties
+    static UInt64 mix_bits(UInt64 v) {
+        v ^= v >> 31;
+        v *= 0x7fb5d329728ea185ull;
+        v ^= v >> 27;
+        v *= 0x81dadef4bc2dd44dull;
+        v ^= v >> 33;
+        return v;
+    }
+
+    /// Map a 32 bit fixed-point value to the interval [0, 1)
+    static Float to_float(const UInt32 &value) {
+        return dr::minimum(Float(value) * Float(0x1p-32),
+                           dr::OneMinusEpsilon<Float>);
+    }
+
+private:
+    /// Morton code of the pixel of every sequence
+    UInt32 m_morton;
+    /// Seed of the scrambling
+    UInt32 m_seed;
+    /// Base-2 logarithm of the sample count
+    uint32_t m_log2_spp = 0;
+    /// Number of base-4 digits of the sample indices
+    uint32_t m_digits = 16;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(ZSobolSampler, Sampler)
+MI_EXPORT_PLUGIN(ZSobolSampler, "Z-ordered Sobol Sampler");
+NAMESPACE_END(mitsuba)
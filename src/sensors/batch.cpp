@@ -19,18 +19,46 @@ Batch sensor (:monosp:`batch`)
    - Sensor Response Function that defines the :ref:`spectral sensitivity <explanation_srf_sensor>`
      of the sensor (Default: :monosp:`none`)
 
+ * - rig
+   - |bool|
+   - If set to |true|, the transformations of the sub-sensors are specified
+     relative to the transformation of this sensor, which then positions all
+     views at once (Default: |false|)
+
+ * - to_world
+   - |transform|
+   - Specifies the pose of the camera rig. Only used when :monosp:`rig`
+     is set to |true|. (Default: none, i.e. sensor space = world space)
+   - |exposed|, |differentiable|, |discontinuous|
+
 This meta-sensor groups multiple sub-sensors so that they can be rendered
 simultaneously. This reduces tracing overheads in applications that need to
 render many viewpoints, particularly in the context of differentiable
 rendering.
 
 This plugin can currently only be used in path tracing-style integrators, and
-it is incompatible with the particle tracer. The horizontal resolution of the
+it is incompatible with the particle tracer. This includes the differentiable
+integrators (e.g. ``prb``, ``prb_projective``, ``direct_projective``), which
+differentiate all views in a single forward or backward pass. Use
+``mi.util.split_batch()`` to obtain the images of the views, e.g. to evaluate
+a loss per view. The horizontal resolution of the
 film associated with this sensor must be a multiple of the number of
 sub-sensors. In addition, all of the sub-sensors' films, samplers and shutter
 timings are typically ignored and superseded by the film, sampler and shutter
 timings specified for the `batch` sensor itself.
 
+All views are rendered by a single pass of the integrator. In vectorized
+variants, this means that they share one kernel, whose compilation and setup
+(e.g. of the emitter sampling structures) is amortized over all of them.
+
+Stereo and multi-camera rigs can be modeled by enabling the :monosp:`rig`
+parameter. The poses of the sub-sensors are then relative to the
+:monosp:`to_world` transformation of the `batch` sensor, and moving the rig
+requires updating only this transformation (e.g. once per frame of an
+animation). The relative poses are fixed when the sensor is created, and any
+direct change of the transformation of a sub-sensor is overwritten when the
+rig is moved.
+
 .. tabs::
     .. code-tab:: xml
         :name: batch-sensor
@@ -87,7 +115,8 @@ timings specified for the `batch` sensor itself.
 
 MI_VARIANT class BatchSensor final : public Sensor<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(Sensor, m_film, m_shape, m_needs_sample_3, sample_wavelengths)
+    MI_IMPORT_BASE(Sensor, m_film, m_shape, m_needs_sample_3, m_to_world,
+                   sample_wavelengths)
     MI_IMPORT_TYPES(Shape, SensorPtr)
 
     BatchSensor(const Properties &props) : Base(props) {
@@ -125,6 +154,20 @@ public:
 
         m_sensors_dr = dr::load<DynamicBuffer<SensorPtr>>(m_sensors.data(),
                                                           m_sensors.size());
+
+        m_rig = props.get<bool>("rig", false);
+        if (m_rig) {
+            for (size_t i = 0; i < m_sensors.size(); ++i)
+                m_rig_to_sensor.push_back(m_sensors[i]->world_transform());
+            update_rig();
+        }
+    }
+
+    /// Position the sub-sensors relative to the pose of the rig
+    void update_rig() {
+        for (size_t i = 0; i < m_sensors.size(); ++i)
+            m_sensors[i]->set_world_transform(m_to_world.value() *
+                                              m_rig_to_sensor[i]);
     }
 
     virtual std::pair<Ray3f, Spectrum>
@@ -261,6 +304,8 @@ public:
         return result;
     }
 
+    std::vector<ref<Base>> sub_sensors() const override { return m_sensors; }
+
     ScalarBoundingBox3f bbox() const override {
         ScalarBoundingBox3f result;
         for (size_t i = 0; i < m_sensors.size(); ++i)
@@ -270,6 +315,9 @@ public:
 
     void traverse(TraversalCallback *callback) override {
         Base::traverse(callback);
+        if (m_rig)
+            callback->put_parameter("to_world", *m_to_world.ptr(),
+                                    ParamFlags::Differentiable | ParamFlags::Discontinuous);
         std::string id;
         for(size_t i = 0; i < m_sensors.size(); i++) {
             id = m_sensors.at(i)->id();
@@ -279,9 +327,18 @@ public:
         }
     }
 
+    void parameters_changed(const std::vector<std::string> &keys) override {
+        Base::parameters_changed(keys);
+        if (m_rig && (keys.empty() || string::contains(keys, "to_world")))
+            update_rig();
+    }
+
     MI_DECLARE_CLASS()
 private:
     std::vector<ref<Base>> m_sensors;
+    /// Poses of the sub-sensors relative to the rig (if enabled)
+    std::vector<Transform4f> m_rig_to_sensor;
+    bool m_rig;
     DynamicBuffer<SensorPtr> m_sensors_dr;
     mutable UInt32 m_last_index;
 };
@@ -194,8 +194,41 @@ public:
         m_normalization = 1.f / m_image_rect.volume();
         m_needs_sample_3 = false;
 
+        /* Precompute data for sample_ray(). The position on the near plane is
+           an affine function of the sample position, which is evaluated in
+           world space (the camera-to-world transformation has no scale) */
+        Vector2f scaled_principal_point_offset =
+            m_film->size() * m_principal_point_offset / m_film->crop_size();
+
+        Point3f near_o = m_sample_to_camera *
+                         Point3f(scaled_principal_point_offset.x(),
+                                 scaled_principal_point_offset.y(), 0.f);
+        Transform4f to_world = m_to_world.value();
+        m_near_o = to_world * Vector3f(near_o);
+        m_near_x = to_world * Vector3f(m_sample_to_camera * Point3f(1.f, 0.f, 0.f) -
+                                       m_sample_to_camera * Point3f(0.f));
+        m_near_y = to_world * Vector3f(m_sample_to_camera * Point3f(0.f, 1.f, 0.f) -
+                                       m_sample_to_camera * Point3f(0.f));
+        m_world_dx = to_world * m_dx;
+        m_world_dy = to_world * m_dy;
+
         dr::make_opaque(m_camera_to_sample, m_sample_to_camera, m_dx, m_dy, m_x_fov,
-                        m_image_rect, m_normalization, m_principal_point_offset);
+                        m_image_rect, m_normalization, m_principal_point_offset,
+                        m_near_o, m_near_x, m_near_y, m_world_dx, m_world_dy);
+    }
+
+    /**
+     * \brief Compute the ray through a sample position
+     *
+     * Returns the unnormalized ray direction, which ends on the near plane,
+     * and its reciprocal length. Since the near plane is located at
+     * distance \c m_near_clip along the optical axis, the length of the
+     * direction is also the distance to the near plane along the ray.
+     */
+    std::pair<Vector3f, Float> near_plane_ray(const Point2f &position_sample) const {
+        Vector3f p = dr::fmadd(m_near_x, position_sample.x(),
+                     dr::fmadd(m_near_y, position_sample.y(), m_near_o));
+        return { p, dr::rsqrt(dr::squared_norm(p)) };
     }
 
     std::pair<Ray3f, Spectrum> sample_ray(Float time, Float wavelength_sample,
@@ -212,26 +245,13 @@ public:
         ray.time = time;
         ray.wavelengths = wavelengths;
 
-        Vector2f scaled_principal_point_offset =
-            m_film->size() * m_principal_point_offset / m_film->crop_size();
-
-        // Compute the sample position on the near plane (local camera space).
-        Point3f near_p = m_sample_to_camera *
-                         Point3f(position_sample.x() + scaled_principal_point_offset.x(),
-                                 position_sample.y() + scaled_principal_point_offset.y(),
-                                 0.f);
+        // Compute the sample position on the near plane (world space).
+        auto [near_p, inv_near_t] = near_plane_ray(position_sample);
 
         // Convert into a normalized ray direction; adjust the ray interval accordingly.
-        Vector3f d = dr::normalize(Vector3f(near_p));
-
-        ray.o = m_to_world.value().translation();
-        ray.d = m_to_world.value() * d;
-
-        Float inv_z = dr::rcp(d.z());
-        Float near_t = m_near_clip * inv_z,
-              far_t  = m_far_clip * inv_z;
-        ray.o += ray.d * near_t;
-        ray.maxt = far_t - near_t;
+        ray.d = near_p * inv_near_t;
+        ray.o = m_to_world.value().translation() + near_p;
+        ray.maxt = (m_far_clip / m_near_clip - 1.f) * dr::rcp(inv_near_t);
 
         return { ray, wav_weight };
     }
@@ -249,31 +269,18 @@ public:
         ray.time = time;
         ray.wavelengths = wavelengths;
 
-        Vector2f scaled_principal_point_offset =
-            m_film->size() * m_principal_point_offset / m_film->crop_size();
-
-        // Compute the sample position on the near plane (local camera space).
-        Point3f near_p = m_sample_to_camera *
-                         Point3f(position_sample.x() + scaled_principal_point_offset.x(),
-                                 position_sample.y() + scaled_principal_point_offset.y(),
-                                 0.f);
+        // Compute the sample position on the near plane (world space).
+        auto [near_p, inv_near_t] = near_plane_ray(position_sample);
 
         // Convert into a normalized ray direction; adjust the ray interval accordingly.
-        Vector3f d = dr::normalize(Vector3f(near_p));
-
-        ray.o = m_to_world.value().translation();
-        ray.d = m_to_world.value() * d;
-
-        Float inv_z = dr::rcp(d.z());
-        Float near_t = m_near_clip * inv_z,
-              far_t  = m_far_clip * inv_z;
-        ray.o += ray.d * near_t;
-        ray.maxt = far_t - near_t;
+        ray.d = near_p * inv_near_t;
+        ray.o = m_to_world.value().translation() + near_p;
+        ray.maxt = (m_far_clip / m_near_clip - 1.f) * dr::rcp(inv_near_t);
 
         ray.o_x = ray.o_y = ray.o;
 
-        ray.d_x = m_to_world.value() * dr::normalize(Vector3f(near_p) + m_dx);
-        ray.d_y = m_to_world.value() * dr::normalize(Vector3f(near_p) + m_dy);
+        ray.d_x = dr::normalize(near_p + m_world_dx);
+        ray.d_y = dr::normalize(near_p + m_world_dy);
         ray.has_differentials = true;
 
         return { ray, wav_weight };
@@ -412,6 +419,10 @@ private:
     Float m_x_fov;
     Vector3f m_dx, m_dy;
     Vector2f m_principal_point_offset;
+    /// Affine map from sample positions to the near plane (world space)
+    Vector3f m_near_o, m_near_x, m_near_y;
+    /// Position differentials on the near plane (world space)
+    Vector3f m_world_dx, m_world_dy;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(PerspectiveCamera, ProjectiveCamera)
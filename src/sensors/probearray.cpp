@@ -0,0 +1,267 @@
+#include <mitsuba/core/fwd.h>
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/rfilter.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/core/warp.h>
+#include <mitsuba/render/fwd.h>
+#include <mitsuba/render/film.h>
+#include <mitsuba/render/mesh.h>
+#include <mitsuba/render/sensor.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _sensor-probearray:
+
+Probe array (:monosp:`probearray`)
+----------------------------------
+
+.. pluginparameters::
+
+ * - origins
+   - |tensor|
+   - Tensor of shape ``[N, 3]`` with the positions of the probes.
+
+ * - directions
+   - |tensor|
+   - Tensor of shape ``[N, 3]`` with the viewing directions (radiance mode)
+     or the surface normals (irradiance mode) of the probes.
+
+ * - (Nested plugin)
+   - |shape|
+   - Alternative to :monosp:`origins` and :monosp:`directions`: a mesh with
+     vertex normals, whose vertices define the probes.
+
+ * - mode
+   - |string|
+   - Quantity measured by every probe: ``radiance`` (like a
+     :ref:`radiance meter <sensor-radiancemeter>`) or ``irradiance``
+     (incident power per unit area at a point, over the hemisphere around
+     its direction). (Default: ``radiance``)
+
+ * - srf
+   - |spectrum|
+   - Sensor Response Function that defines the :ref:`spectral sensitivity <explanation_srf_sensor>`
+     of the sensor (Default: :monosp:`none`)
+
+This sensor plugin measures many point probes at once. Placing thousands of
+:ref:`radiancemeter <sensor-radiancemeter>` sensors in a scene requires one
+rendering per probe, each with the setup of a film and a kernel launch. This
+plugin instead maps every probe to a pixel of its film, whose size is set to
+``N`` by 1 pixels, so that a single call to :py:func:`mitsuba.render` traces
+all of them in one wavefront. The first row of the resulting image is a
+tensor of shape ``[N, channels]`` with the values of the probes.
+
+Probes specified through a mesh are located at the vertices, oriented along
+the vertex normals. The mesh is not part of the scene. Like
+:ref:`batch <sensor-batch>`, this plugin can only be used in path
+tracing-style integrators.
+
+.. tabs::
+    .. code-tab:: python
+
+        'type': 'probearray',
+        'origins': mi.TensorXf([0, 0, 0, 1, 0, 0], shape=(2, 3)),
+        'directions': mi.TensorXf([0, 0, 1, 0, 0, 1], shape=(2, 3)),
+        'mode': 'irradiance'
+
+*/
+
+MI_VARIANT class ProbeArray final : public Sensor<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Sensor, m_film, m_resolution, m_needs_sample_2,
+                   m_needs_sample_3, sample_wavelengths)
+    MI_IMPORT_TYPES(Shape, Mesh, Film, ReconstructionFilter)
+
+    using FloatStorage = DynamicBuffer<Float>;
+
+    ProbeArray(const Properties &props) : Base(props) {
+        if (props.has_property("to_world"))
+            Throw("ProbeArray: the probes are specified in world space, "
+                  "'to_world' is not supported!");
+
+        std::string mode = props.get<std::string>("mode", "radiance");
+        if (mode == "radiance")
+            m_irradiance = false;
+        else if (mode == "irradiance")
+            m_irradiance = true;
+        else
+            Throw("ProbeArray: invalid mode \"%s\" (must be \"radiance\" or "
+                  "\"irradiance\")!", mode);
+
+        FloatStorage origins, directions;
+        const Mesh *mesh = nullptr;
+        bool has_film = false;
+        for (auto &[name, obj] : props.objects(false)) {
+            if (dynamic_cast<const Film *>(obj.get()))
+                has_film = true;
+            if (const Shape *shape = dynamic_cast<const Shape *>(obj.get())) {
+                mesh = dynamic_cast<const Mesh *>(shape);
+                if (!mesh)
+                    Throw("ProbeArray: only meshes can define the probes!");
+                props.mark_queried(name);
+            }
+        }
+
+        if (mesh) {
+            if (props.has_property("origins") || props.has_property("directions"))
+                Throw("ProbeArray: the probes must either be specified by a "
+                      "mesh or by the 'origins' and 'directions' tensors!");
+            if (!mesh->has_vertex_normals())
+                Throw("ProbeArray: the mesh must have vertex normals!");
+            origins = mesh->vertex_positions_buffer();
+            directions = mesh->vertex_normals_data();
+        } else {
+            auto load = [&](const std::string &name) {
+                TensorXf *tensor = props.tensor<TensorXf>(name);
+                if (tensor->ndim() != 2 || tensor->shape(1) != 3)
+                    Throw("ProbeArray: \"%s\": expected a tensor of shape "
+                          "[N, 3]!", name);
+                FloatStorage result = tensor->array();
+                return result;
+            };
+            origins = load("origins");
+            directions = load("directions");
+        }
+
+        m_count = (uint32_t) (dr::width(origins) / 3);
+        if (m_count == 0)
+            Throw("ProbeArray: at least one probe must be specified!");
+        set_probes(origins, directions);
+
+        /* One pixel per probe. Wider reconstruction filters would blend
+           neighboring probes, hence the default film uses a box filter */
+        if (!has_film) {
+            PluginManager *pmgr = PluginManager::instance();
+            Properties props_film("hdrfilm");
+            props_film.set_int("width", (int) m_count);
+            props_film.set_int("height", 1);
+            props_film.set_object("rfilter",
+                pmgr->create_object<ReconstructionFilter>(Properties("box")));
+            m_film = pmgr->create_object<Film>(props_film);
+        } else {
+            if (m_film->rfilter()->radius() > .5f + math::RayEpsilon<Float>)
+                Throw("ProbeArray: the film must use a reconstruction filter "
+                      "of radius 0.5 or lower (e.g. 'box'), since wider "
+                      "filters blend the values of neighboring probes!");
+            m_film->set_size(ScalarPoint2u(m_count, 1));
+        }
+        m_resolution = ScalarVector2f(m_film->crop_size());
+
+        m_needs_sample_2 = true;
+        m_needs_sample_3 = m_irradiance;
+    }
+
+    std::pair<Ray3f, Spectrum> sample_ray(Float time, Float wavelength_sample,
+                                          const Point2f &position_sample,
+                                          const Point2f &aperture_sample,
+                                          Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::EndpointSampleRay, active);
+
+        // 1. Select the probe of the pixel
+        UInt32 index = dr::minimum(UInt32(position_sample.x() * (ScalarFloat) m_count),
+                                   m_count - 1);
+        Point3f o = dr::gather<Point3f>(m_origins, index, active);
+        Vector3f d = dr::gather<Vector3f>(m_directions, index, active);
+
+        // 2. Sample spectrum
+        auto [wavelengths, wav_weight] =
+            sample_wavelengths(dr::zeros<SurfaceInteraction3f>(),
+                               wavelength_sample,
+                               active);
+        Spectrum weight = wav_weight;
+
+        // 3. Sample the incident direction of irradiance probes
+        if (m_irradiance) {
+            d = Frame3f(d).to_world(warp::square_to_cosine_hemisphere(aperture_sample));
+            weight *= dr::Pi<ScalarFloat>;
+        }
+
+        Ray3f ray(o + d * math::RayEpsilon<Float>, d, time, wavelengths);
+        return { ray, weight };
+    }
+
+    std::pair<RayDifferential3f, Spectrum>
+    sample_ray_differential(Float time, Float wavelength_sample,
+                            const Point2f &position_sample,
+                            const Point2f &aperture_sample,
+                            Mask active) const override {
+        auto [ray, weight] = sample_ray(time, wavelength_sample, position_sample,
+                                        aperture_sample, active);
+
+        // Probes are points, hence there are no differentials
+        RayDifferential3f result(ray);
+        result.has_differentials = false;
+        return { result, weight };
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        Base::traverse(callback);
+        callback->put_parameter("origins", m_origins, +ParamFlags::NonDifferentiable);
+        callback->put_parameter("directions", m_directions, +ParamFlags::NonDifferentiable);
+    }
+
+    void parameters_changed(const std::vector<std::string> &keys) override {
+        if (keys.empty() || string::contains(keys, "origins") ||
+            string::contains(keys, "directions")) {
+            set_probes(FloatStorage(m_origins), FloatStorage(m_directions));
+        }
+        Base::parameters_changed(keys);
+    }
+
+    ScalarBoundingBox3f bbox() const override { return m_bbox; }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "ProbeArray[" << std::endl
+            << "  probes = " << m_count << "," << std::endl
+            << "  mode = " << (m_irradiance ? "irradiance" : "radiance") << "," << std::endl
+            << "  film = " << string::indent(m_film) << "," << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+
+protected:
+    /// Normalize the directions of the probes and compute their bounds
+    void set_probes(const FloatStorage &origins, const FloatStorage &directions) {
+        if (dr::width(origins) != 3 * m_count ||
+            dr::width(directions) != 3 * m_count)
+            Throw("ProbeArray: expected %u origins and directions!", m_count);
+
+        auto &&origins_h = dr::migrate(origins, AllocType::Host);
+        auto &&directions_h = dr::migrate(directions, AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+
+        const ScalarFloat *o = origins_h.data(), *v = directions_h.data();
+        std::unique_ptr<ScalarFloat[]> d(new ScalarFloat[m_count * 3]);
+        m_bbox = ScalarBoundingBox3f();
+        for (uint32_t i = 0; i < m_count; ++i) {
+            ScalarVector3f dir(v[3 * i], v[3 * i + 1], v[3 * i + 2]);
+            if (!(dr::squared_norm(dir) > 0.f))
+                Throw("ProbeArray: probe %u has a degenerate direction!", i);
+            dir = dr::normalize(dir);
+            for (uint32_t j = 0; j < 3; ++j)
+                d[3 * i + j] = dir[j];
+            m_bbox.expand(ScalarPoint3f(o[3 * i], o[3 * i + 1], o[3 * i + 2]));
+        }
+
+        m_origins = dr::load<FloatStorage>(o, m_count * 3);
+        m_directions = dr::load<FloatStorage>(d.get(), m_count * 3);
+    }
+
+private:
+    uint32_t m_count;
+    bool m_irradiance;
+    FloatStorage m_origins;
+    FloatStorage m_directions;
+    ScalarBoundingBox3f m_bbox;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(ProbeArray, Sensor)
+MI_EXPORT_PLUGIN(ProbeArray, "ProbeArray");
+NAMESPACE_END(mitsuba)
@@ -106,3 +106,39 @@ def test02_sample_ray(variants_vec_spectral, s_open, s_time):
     print(f"{ray.d=}")
     print(f"{direction=}")
     assert dr.allclose(ray.d, direction, atol=1e-7)
+
+
+def test03_rig(variants_vec_rgb):
+    """Check that the sub-sensors of a rig follow its transformation"""
+    camera0 = create_perspective(origins[0], directions[0])
+    camera1 = create_perspective(origins[1], directions[1])
+    local = [camera0.world_transform(), camera1.world_transform()]
+
+    rig = mi.ScalarTransform4f().translate([1.0, -2.0, 0.5])
+    camera = mi.load_dict({
+        "type": "batch",
+        "rig": True,
+        "to_world": rig,
+        "film": { "type": "hdrfilm", "width": 512, "height": 256 },
+        "sensor_0": camera0,
+        "sensor_1": camera1,
+    })
+
+    for i, sensor in enumerate(camera.sub_sensors()):
+        assert dr.allclose(sensor.world_transform().matrix,
+                           (mi.Transform4f(rig) @ local[i]).matrix)
+
+    # Moving the rig moves all views
+    params = mi.traverse(camera)
+    rig = mi.ScalarTransform4f().rotate([0, 1, 0], 30).translate([0.0, 1.0, 0.0])
+    params['to_world'] = rig
+    params.update()
+
+    position_sample = mi.Point2f([0.25, 0.75], [0.5, 0.5])
+    ray, _ = camera.sample_ray(0, 0, position_sample, 0)
+
+    for i, sensor in enumerate(camera.sub_sensors()):
+        to_world = mi.Transform4f(rig) @ local[i]
+        assert dr.allclose(sensor.world_transform().matrix, to_world.matrix)
+        d = to_world @ mi.Vector3f(0, 0, 1)
+        assert dr.allclose(dr.gather(mi.Vector3f, ray.d, i), d, atol=1e-6)
@@ -0,0 +1,87 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def make_scene(mode, **kwargs):
+    return mi.load_dict({
+        'type': 'scene',
+        'integrator': {'type': 'path'},
+        'emitter': {
+            'type': 'constant',
+            'radiance': {'type': 'uniform', 'value': 2.0}
+        },
+        # Black floor below the probes
+        'floor': {
+            'type': 'rectangle',
+            'to_world': mi.ScalarTransform4f().translate([0, 0, -3]).scale(100),
+            'bsdf': {
+                'type': 'diffuse',
+                'reflectance': {'type': 'rgb', 'value': 0}
+            }
+        },
+        'sensor': {
+            'type': 'probearray',
+            'mode': mode,
+            'sampler': {'type': 'independent', 'sample_count': 64},
+            **kwargs
+        }
+    })
+
+
+def test01_construct(variant_scalar_rgb):
+    scene = make_scene('radiance',
+                       origins=mi.TensorXf([0, 0, 0, 1, 0, 0, 2, 0, 0], shape=(3, 3)),
+                       directions=mi.TensorXf([0, 0, 2, 0, 0, -1, 1, 0, 0], shape=(3, 3)))
+    sensor = scene.sensors()[0]
+    assert dr.all(sensor.film().size() == [3, 1])
+    assert dr.allclose(sensor.bbox().min, [0, 0, 0])
+    assert dr.allclose(sensor.bbox().max, [2, 0, 0])
+
+    # Every pixel maps to the corresponding probe
+    for i in range(3):
+        ray, _ = sensor.sample_ray(0, 0.5, [(i + 0.5) / 3, 0.5], [0.5, 0.5])
+        assert dr.allclose(ray.o, [i, 0, 0], atol=1e-3)
+    ray, _ = sensor.sample_ray(0, 0.5, [0.1, 0.5], [0.5, 0.5])
+    assert dr.allclose(ray.d, [0, 0, 1])
+
+    with pytest.raises(RuntimeError, match='shape'):
+        make_scene('radiance', origins=mi.TensorXf([0, 0], shape=(1, 2)),
+                   directions=mi.TensorXf([0, 0], shape=(1, 2)))
+    with pytest.raises(RuntimeError, match='invalid mode'):
+        make_scene('flux', origins=mi.TensorXf([0, 0, 0], shape=(1, 3)),
+                   directions=mi.TensorXf([0, 0, 1], shape=(1, 3)))
+    with pytest.raises(RuntimeError, match='reconstruction filter'):
+        make_scene('radiance', origins=mi.TensorXf([0, 0, 0], shape=(1, 3)),
+                   directions=mi.TensorXf([0, 0, 1], shape=(1, 3)),
+                   film={'type': 'hdrfilm', 'rfilter': {'type': 'gaussian'}})
+
+
+@pytest.mark.parametrize('mode', ['radiance', 'irradiance'])
+def test02_render(variants_all_rgb, mode):
+    scene = make_scene(mode,
+                       origins=mi.TensorXf([0, 0, 0, 5, 0, 0], shape=(2, 3)),
+                       directions=mi.TensorXf([0, 0, 1, 0, 0, -1], shape=(2, 3)))
+    image = mi.render(scene)
+    assert dr.shape(image)[:2] == (1, 2)
+
+    # The probe looking up sees the environment, the other one the floor
+    expected = 2 * (dr.pi if mode == 'irradiance' else 1)
+    assert dr.allclose(image[0, 0, 0], expected, rtol=1e-2)
+    assert dr.allclose(image[0, 1, 0], 0, atol=1e-2)
+
+
+def test03_mesh_probes(variants_all_rgb):
+    mesh = mi.Mesh('probes', 3, 1, has_vertex_normals=True)
+    params = mi.traverse(mesh)
+    params['vertex_positions'] = [0, 0, 0, 5, 0, 0, 0, 5, 0]
+    params['vertex_normals'] = [0, 0, 1, 0, 0, -1, 0, 0, 1]
+    params['faces'] = [0, 1, 2]
+    params.update()
+
+    scene = make_scene('irradiance', probes=mesh)
+    image = mi.render(scene)
+    assert dr.shape(image)[:2] == (1, 3)
+    assert dr.allclose(image[0, 0, 0], 2 * dr.pi, rtol=1e-2)
+    assert dr.allclose(image[0, 1, 0], 0, atol=1e-2)
+    assert dr.allclose(image[0, 2, 0], 2 * dr.pi, rtol=1e-2)
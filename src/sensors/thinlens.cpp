@@ -209,8 +209,44 @@ public:
         m_image_rect.expand(Point2f(pmax.x(), pmax.y()) / pmax.z());
         m_normalization = 1.f / m_image_rect.volume();
 
+        /* Precompute data for sample_ray(). The position on the focal plane
+           is an affine function of the sample position, which is evaluated
+           in world space (the camera-to-world transformation has no scale) */
+        Transform4f to_world = m_to_world.value();
+        Float f_dist = m_focus_distance / m_near_clip;
+        m_focus_o = to_world * Vector3f(m_sample_to_camera * Point3f(0.f)) * f_dist;
+        m_focus_x = to_world * Vector3f(m_sample_to_camera * Point3f(1.f, 0.f, 0.f) -
+                                        m_sample_to_camera * Point3f(0.f)) * f_dist;
+        m_focus_y = to_world * Vector3f(m_sample_to_camera * Point3f(0.f, 1.f, 0.f) -
+                                        m_sample_to_camera * Point3f(0.f)) * f_dist;
+        m_focus_dx = to_world * m_dx * f_dist;
+        m_focus_dy = to_world * m_dy * f_dist;
+        m_aperture_x = to_world * Vector3f(m_aperture_radius, 0.f, 0.f);
+        m_aperture_y = to_world * Vector3f(0.f, m_aperture_radius, 0.f);
+
         dr::make_opaque(m_camera_to_sample, m_sample_to_camera, m_dx, m_dy,
-                        m_x_fov, m_image_rect, m_normalization);
+                        m_x_fov, m_image_rect, m_normalization, m_focus_o,
+                        m_focus_x, m_focus_y, m_focus_dx, m_focus_dy,
+                        m_aperture_x, m_aperture_y);
+    }
+
+    /**
+     * \brief Compute the ray through a sample position and an aperture sample
+     *
+     * Returns the aperture position and the unnormalized ray direction, which
+     * ends on the focal plane (both relative to the camera origin in world
+     * space). Since the focal plane is located at distance \c
+     * m_focus_distance along the optical axis, the ray parameter of any plane
+     * parallel to it is proportional to the length of the direction.
+     */
+    std::pair<Vector3f, Vector3f>
+    focal_plane_ray(const Point2f &position_sample,
+                    const Point2f &aperture_sample) const {
+        Point2f tmp = warp::square_to_uniform_disk_concentric(aperture_sample);
+        Vector3f aperture_p = dr::fmadd(m_aperture_x, tmp.x(), m_aperture_y * tmp.y()),
+                 focus_p    = dr::fmadd(m_focus_x, position_sample.x(),
+                              dr::fmadd(m_focus_y, position_sample.y(), m_focus_o));
+        return { aperture_p, focus_p - aperture_p };
     }
 
     std::pair<Ray3f, Spectrum> sample_ray(Float time, Float wavelength_sample,
@@ -227,28 +263,16 @@ public:
         ray.time = time;
         ray.wavelengths = wavelengths;
 
-        // Compute the sample position on the near plane (local camera space).
-        Point3f near_p = m_sample_to_camera *
-                        Point3f(position_sample.x(), position_sample.y(), 0.f);
-
-        // Aperture position
-        Point2f tmp = m_aperture_radius * warp::square_to_uniform_disk_concentric(aperture_sample);
-        Point3f aperture_p(tmp.x(), tmp.y(), 0.f);
-
-        // Sampled position on the focal plane
-        Point3f focus_p = near_p * (m_focus_distance / near_p.z());
+        // Aperture position and direction towards the focal plane (world space)
+        auto [aperture_p, focus_d] = focal_plane_ray(position_sample, aperture_sample);
 
         // Convert into a normalized ray direction; adjust the ray interval accordingly.
-        Vector3f d = dr::normalize(Vector3f(focus_p - aperture_p));
-
-        ray.o = m_to_world.value().transform_affine(aperture_p);
-        ray.d = m_to_world.value() * d;
-
-        Float inv_z = dr::rcp(d.z());
-        Float near_t = m_near_clip * inv_z,
-              far_t  = m_far_clip * inv_z;
-        ray.o += ray.d * near_t;
-        ray.maxt = far_t - near_t;
+        Float dist = dr::norm(focus_d),
+              inv_focus_distance = dr::rcp(m_focus_distance);
+        ray.d = focus_d * dr::rcp(dist);
+        ray.o = m_to_world.value().translation() + aperture_p +
+                focus_d * (m_near_clip * inv_focus_distance);
+        ray.maxt = (m_far_clip - m_near_clip) * inv_focus_distance * dist;
 
         return { ray, wav_weight };
     }
@@ -267,36 +291,21 @@ public:
         ray.time = time;
         ray.wavelengths = wavelengths;
 
-        // Compute the sample position on the near plane (local camera space).
-        Point3f near_p = m_sample_to_camera *
-                        Point3f(position_sample.x(), position_sample.y(), 0.f);
-
-        // Aperture position
-        Point2f tmp = m_aperture_radius * warp::square_to_uniform_disk_concentric(aperture_sample);
-        Point3f aperture_p(tmp.x(), tmp.y(), 0.f);
-
-        // Sampled position on the focal plane
-        Float f_dist = m_focus_distance / near_p.z();
-        Point3f focus_p   = near_p          * f_dist,
-                focus_p_x = (near_p + m_dx) * f_dist,
-                focus_p_y = (near_p + m_dy) * f_dist;
+        // Aperture position and direction towards the focal plane (world space)
+        auto [aperture_p, focus_d] = focal_plane_ray(position_sample, aperture_sample);
 
         // Convert into a normalized ray direction; adjust the ray interval accordingly.
-        Vector3f d = dr::normalize(Vector3f(focus_p - aperture_p));
-
-        ray.o = m_to_world.value().transform_affine(aperture_p);
-        ray.d = m_to_world.value() * d;
-
-        Float inv_z = dr::rcp(d.z());
-        Float near_t = m_near_clip * inv_z,
-              far_t  = m_far_clip * inv_z;
-        ray.o += ray.d * near_t;
-        ray.maxt = far_t - near_t;
+        Float dist = dr::norm(focus_d),
+              inv_focus_distance = dr::rcp(m_focus_distance);
+        ray.d = focus_d * dr::rcp(dist);
+        ray.o = m_to_world.value().translation() + aperture_p +
+                focus_d * (m_near_clip * inv_focus_distance);
+        ray.maxt = (m_far_clip - m_near_clip) * inv_focus_distance * dist;
 
         ray.o_x = ray.o_y = ray.o;
 
-        ray.d_x = m_to_world.value() * dr::normalize(Vector3f(focus_p_x - aperture_p));
-        ray.d_y = m_to_world.value() * dr::normalize(Vector3f(focus_p_y - aperture_p));
+        ray.d_x = dr::normalize(focus_d + m_focus_dx);
+        ray.d_y = dr::normalize(focus_d + m_focus_dy);
         ray.has_differentials = true;
 
         return { ray, wav_weight };
@@ -383,6 +392,12 @@ private:
     Float m_normalization;
     Float m_x_fov;
     Vector3f m_dx, m_dy;
+    /// Affine map from sample positions to the focal plane (world space)
+    Vector3f m_focus_o, m_focus_x, m_focus_y;
+    /// Position differentials on the focal plane (world space)
+    Vector3f m_focus_dx, m_focus_dy;
+    /// Axes of the aperture scaled by its radius (world space)
+    Vector3f m_aperture_x, m_aperture_y;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(ThinLensCamera, ProjectiveCamera)
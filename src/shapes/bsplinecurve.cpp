@@ -39,6 +39,12 @@ B-spline curve (:monosp:`bsplinecurve`)
    - Specifies a linear object-to-world transformation. Note that the control
      points' raddii are invariant to this transformation!
 
+ * - split_ratio
+   - |float|
+   - Curves with a segment whose axis-aligned bounding box is more than this
+     many times larger than the segment itself are subdivided. (Default: 0,
+     i.e. no subdivision)
+
  * - silhouette_sampling_weight
    - |float|
    - Weight associated with this shape when sampling silhoeuttes in the scene. (Default: 1)
@@ -74,6 +80,21 @@ open-ended: they do not have endcaps. They can be made watertight by setting the
 radii of the extremities to 0. This shape should always be preferred over curve
 approximations modeled using triangles.
 
+Scalar variants built without Embree intersect the curves with the native
+kd-tree. There, every segment is approximated by a few linear pieces, whose
+intersection is then refined with Newton iterations on the exact swept surface.
+The kd-tree uses tight bounds of the parts of the segments that overlap its
+nodes.
+
+Long diagonal segments (e.g. of groomed hair) only fill a small fraction of
+their axis-aligned bounding boxes, which are then tested by many rays that
+miss them. When ``split_ratio`` is set, the control points of the curves that
+contain such segments are refined by uniform B-spline subdivision (up to four
+times), which halves their segments while representing exactly the same
+curves. The refined control points are those exposed by the ``control_points``
+parameter. Embree already bounds curves with oriented boxes, hence this is
+mostly beneficial for the other backends.
+
 Although it is possible to define multiple curves as multiple separate objects,
 this plugin was intended to be used as an aggregate of curves. Of course,
 if the individual curves need different materials or other individual
@@ -145,12 +166,6 @@ public:
     using UInt32Storage = DynamicBuffer<UInt32>;
 
     BSplineCurve(const Properties &props) : Base(props) {
-#if !defined(MI_ENABLE_EMBREE)
-        if constexpr (!dr::is_jit_v<Float>)
-            Throw("The B-spline curve is only available with Embree in scalar "
-                  "variants!");
-#endif
-
         auto fs = Thread::thread()->file_resolver();
         fs::path file_path = fs->resolve(props.string("filename"));
         std::string m_name = file_path.filename().string();
@@ -258,6 +273,16 @@ public:
             fail("Empty B-spline file: no control points were read!");
         finish_curve();
 
+        ScalarFloat split_ratio = props.get<ScalarFloat>("split_ratio", 0.f);
+        if (split_ratio < 0.f)
+            fail("\"split_ratio\" must be non-negative!");
+        if (split_ratio > 0.f) {
+            size_t original_count = segment_count;
+            segment_count = split_segments(vertices, radius, curve_1st_idx, split_ratio);
+            Log(Debug, "\"%s\": subdivided %zu segments into %zu", m_name,
+                original_count, segment_count);
+        }
+
         m_control_point_count = (ScalarSize) vertices.size();
 
         std::unique_ptr<ScalarIndex[]> indices = std::make_unique<ScalarIndex[]>(segment_count);
@@ -303,6 +328,7 @@ public:
                 m_control_points[i * 4 + 3] = radius_buffer[i * 1 + 0];
             }
         }
+        dr::eval(m_control_points); // Host access by the native kd-tree
 
         // Compute bounding box
         m_bbox.reset();
@@ -353,6 +379,95 @@ public:
 
     ScalarSize primitive_count() const override { return (ScalarSize) dr::width(m_indices); }
 
+    ScalarBoundingBox3f bbox(ScalarIndex index) const override {
+        if constexpr (dr::is_cuda_v<Float>)
+            NotImplementedError("bbox(ScalarIndex index)");
+
+        // A segment lies in the convex hull of its four control points
+        const InputFloat *cp = control_points_ptr(index);
+        ScalarBoundingBox3f bbox;
+        ScalarFloat r_max = 0.f;
+        for (size_t i = 0; i < 4; ++i) {
+            bbox.expand(ScalarPoint3f(cp[4 * i + 0], cp[4 * i + 1], cp[4 * i + 2]));
+            r_max = dr::maximum(r_max, ScalarFloat(cp[4 * i + 3]));
+        }
+        return ScalarBoundingBox3f(bbox.min - r_max, bbox.max + r_max);
+    }
+
+    ScalarBoundingBox3f bbox(ScalarIndex index,
+                             const ScalarBoundingBox3f &clip) const override {
+        if constexpr (dr::is_cuda_v<Float>)
+            NotImplementedError("bbox(ScalarIndex index, const ScalarBoundingBox3f &clip)");
+
+        /* Split the segment into pieces and convert them to the Bézier form,
+           whose control points have a tighter convex hull. Only the pieces
+           overlapping the clip box contribute to the bounds. */
+        const InputFloat *cp = control_points_ptr(index);
+        ScalarBoundingBox3f result;
+        for (uint32_t i = 0; i < clip_piece_count; ++i) {
+            double a = double(i) / clip_piece_count,
+                   b = double(i + 1) / clip_piece_count,
+                   h = (b - a) / 3.0;
+            auto [ca, dca, dca2] = eval_segment(cp, a);
+            auto [cb, dcb, dcb2] = eval_segment(cp, b);
+            DRJIT_MARK_USED(dca2);
+            DRJIT_MARK_USED(dcb2);
+            Point4d bezier[4] = { ca, ca + h * dca, cb - h * dcb, cb };
+
+            ScalarBoundingBox3f piece;
+            double r_max = 0.0;
+            for (size_t j = 0; j < 4; ++j) {
+                piece.expand(ScalarPoint3f(bezier[j].x(), bezier[j].y(), bezier[j].z()));
+                r_max = dr::maximum(r_max, bezier[j].w());
+            }
+            piece = ScalarBoundingBox3f(piece.min - ScalarFloat(r_max),
+                                        piece.max + ScalarFloat(r_max));
+            if (piece.overlaps(clip))
+                result.expand(piece);
+        }
+        result.clip(clip);
+        return result;
+    }
+
+    // =============================================================
+    //! @{ \name Ray tracing routines
+    // =============================================================
+
+    template <typename FloatP, typename Ray3fP>
+    std::tuple<FloatP, Point<FloatP, 2>, dr::uint32_array_t<FloatP>,
+               dr::uint32_array_t<FloatP>>
+    ray_intersect_preliminary_impl(const Ray3fP &ray,
+                                   ScalarIndex prim_index,
+                                   dr::mask_t<FloatP> active) const {
+        MI_MASK_ARGUMENT(active);
+        if constexpr (!dr::is_array_v<FloatP> && !dr::is_cuda_v<Float>) {
+            auto [t, v] = segment_intersect(ray, prim_index);
+            return { t, Point<FloatP, 2>(v, 0.f), ((uint32_t) -1), prim_index };
+        } else {
+            Throw("BSplineCurve::ray_intersect_preliminary() should only be "
+                  "called with scalar types by the native kd-tree.");
+        }
+    }
+
+    template <typename FloatP, typename Ray3fP>
+    dr::mask_t<FloatP> ray_test_impl(const Ray3fP &ray,
+                                     ScalarIndex prim_index,
+                                     dr::mask_t<FloatP> active) const {
+        MI_MASK_ARGUMENT(active);
+        if constexpr (!dr::is_array_v<FloatP> && !dr::is_cuda_v<Float>) {
+            return segment_intersect(ray, prim_index).first !=
+                   dr::Infinity<ScalarFloat>;
+        } else {
+            Throw("BSplineCurve::ray_test() should only be called with scalar "
+                  "types by the native kd-tree.");
+        }
+    }
+
+    MI_SHAPE_DEFINE_RAY_INTERSECT_METHODS()
+
+    //! @}
+    // =============================================================
+
     SurfaceInteraction3f eval_parameterization(const Point2f &uv,
                                                uint32_t ray_flags,
                                                Mask active) const override {
@@ -1099,6 +1214,306 @@ private:
         *start_ = start;
     }
 
+    using Point4d  = dr::Array<double, 4>;
+    using Vector3d = Vector<double, 3>;
+
+    /// Host pointer to the four control points of a segment
+    const InputFloat *control_points_ptr(ScalarIndex index) const {
+        return m_control_points.data() + 4 * m_indices.data()[index];
+    }
+
+    /// Maximum number of subdivisions of a curve by \ref split_segments()
+    static constexpr size_t MaxCurveSubdivisions = 4;
+
+    /**
+     * \brief Does a segment of the curve with the given control points
+     * (packed with their radii) have a bounding box that is more than \c
+     * ratio times larger than the segment?
+     */
+    static bool needs_split(const std::vector<Point4d> &cp, ScalarFloat ratio) {
+        for (size_t i = 0; i + 3 < cp.size(); ++i) {
+            Vector3d lo(dr::Infinity<double>), hi(-dr::Infinity<double>);
+            double r_max = 0.0, r_mean = 0.0;
+            for (size_t j = i; j < i + 4; ++j) {
+                Vector3d p(cp[j].x(), cp[j].y(), cp[j].z());
+                lo = dr::minimum(lo, p);
+                hi = dr::maximum(hi, p);
+                r_max = dr::maximum(r_max, cp[j].w());
+                r_mean += 0.25 * cp[j].w();
+            }
+            if (!(r_mean > 0.0))
+                continue;
+
+            // Approximate the segment by a cylinder along its chord
+            Point4d e0 = (cp[i] + 4.0 * cp[i + 1] + cp[i + 2]) / 6.0,
+                    e1 = (cp[i + 1] + 4.0 * cp[i + 2] + cp[i + 3]) / 6.0;
+            double length = dr::norm(Vector3d(e1.x() - e0.x(), e1.y() - e0.y(),
+                                              e1.z() - e0.z())),
+                   volume = dr::Pi<double> * r_mean * r_mean *
+                            (length + 4.0 / 3.0 * r_mean);
+
+            if (dr::prod(hi - lo + 2.0 * r_max) > (double) ratio * volume)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * \brief Refine the control points of a uniform cubic B-spline so that
+     * each segment is split in two halves that represent the same curve
+     */
+    static std::vector<Point4d> subdivide(const std::vector<Point4d> &cp) {
+        std::vector<Point4d> result;
+        result.reserve(2 * cp.size() - 3);
+        for (size_t i = 0; i + 1 < cp.size(); ++i) {
+            if (i > 0)
+                result.push_back((cp[i - 1] + 6.0 * cp[i] + cp[i + 1]) * 0.125);
+            result.push_back((cp[i] + cp[i + 1]) * 0.5);
+        }
+        return result;
+    }
+
+    /**
+     * \brief Subdivide the curves that contain a segment whose bounding
+     * box is more than \c ratio times larger than the segment itself
+     *
+     * Returns the new number of segments.
+     */
+    static size_t split_segments(std::vector<InputPoint3f> &vertices,
+                                 std::vector<InputFloat> &radius,
+                                 std::vector<size_t> &curve_1st_idx,
+                                 ScalarFloat ratio) {
+        std::vector<InputPoint3f> new_vertices;
+        std::vector<InputFloat> new_radius;
+        new_vertices.reserve(vertices.size());
+        new_radius.reserve(vertices.size());
+
+        size_t segment_count = 0;
+        for (size_t i = 0; i < curve_1st_idx.size(); ++i) {
+            size_t begin = curve_1st_idx[i],
+                   end = i + 1 < curve_1st_idx.size() ? curve_1st_idx[i + 1]
+                                                      : vertices.size();
+
+            std::vector<Point4d> cp(end - begin);
+            for (size_t j = begin; j < end; ++j)
+                cp[j - begin] = Point4d(vertices[j].x(), vertices[j].y(),
+                                        vertices[j].z(), radius[j]);
+
+            for (size_t level = 0;
+                 level < MaxCurveSubdivisions && needs_split(cp, ratio); ++level)
+                cp = subdivide(cp);
+
+            curve_1st_idx[i] = new_vertices.size();
+            for (const Point4d &p : cp) {
+                new_vertices.push_back(InputPoint3f(p.x(), p.y(), p.z()));
+                new_radius.push_back((InputFloat) p.w());
+            }
+            segment_count += cp.size() - 3;
+        }
+
+        vertices.swap(new_vertices);
+        radius.swap(new_radius);
+        return segment_count;
+    }
+
+    /**
+     * \brief Evaluate the center and radius (packed as 4D points) of a
+     * segment along with their first and second derivatives in double
+     * precision (used by the native kd-tree)
+     */
+    static std::tuple<Point4d, Point4d, Point4d>
+    eval_segment(const InputFloat *cp, double v) {
+        Point4d p[4];
+        for (size_t i = 0; i < 4; ++i)
+            p[i] = Point4d(cp[4 * i + 0], cp[4 * i + 1], cp[4 * i + 2],
+                           cp[4 * i + 3]);
+
+        double v2 = v * v, v3 = v2 * v, w = 1.0 - v;
+        Point4d c = (w * w * w * p[0] + (3.0 * v3 - 6.0 * v2 + 4.0) * p[1] +
+                     (-3.0 * v3 + 3.0 * v2 + 3.0 * v + 1.0) * p[2] + v3 * p[3]) / 6.0;
+        Point4d dc = (-w * w * p[0] + (3.0 * v2 - 4.0 * v) * p[1] +
+                      (-3.0 * v2 + 2.0 * v + 1.0) * p[2] + v2 * p[3]) * 0.5;
+        Point4d dc2 = w * p[0] + (3.0 * v - 2.0) * p[1] +
+                      (1.0 - 3.0 * v) * p[2] + v * p[3];
+        return { c, dc, dc2 };
+    }
+
+    /**
+     * \brief Intersect a ray with the surface swept by a sphere along a
+     * segment (only used by the native kd-tree)
+     *
+     * The segment is first approximated by \ref cone_count linear pieces,
+     * whose swept spheres are intersected exactly (see \ref
+     * round_cone_intersect()). The hit is then refined with Newton
+     * iterations on the envelope of the exact swept sphere: the hit point
+     * lies on the sphere at curve parameter \c v, which is tangent to the
+     * surface. Back faces are culled, and the spheres at the ends of the
+     * segment only count where they coincide with the swept surface. Returns
+     * the hit distance (or infinity) and the curve parameter of the hit.
+     */
+    std::pair<ScalarFloat, ScalarFloat>
+    segment_intersect(const ScalarRay3f &ray_, ScalarIndex index) const {
+        const InputFloat *cp = control_points_ptr(index);
+        ScalarRay3f ray(ray_);
+
+        ScalarFloat t_best = dr::Infinity<ScalarFloat>, v_best = 0.f;
+        Point4d prev = std::get<0>(eval_segment(cp, 0.0));
+        for (uint32_t i = 0; i < cone_count; ++i) {
+            Point4d next = std::get<0>(eval_segment(cp, double(i + 1) / cone_count));
+            auto [t, s] = round_cone_intersect(
+                ray, ScalarPoint3f(prev.x(), prev.y(), prev.z()), ScalarFloat(prev.w()),
+                ScalarPoint3f(next.x(), next.y(), next.z()), ScalarFloat(next.w()));
+            if (t < t_best) {
+                t_best = ray.maxt = t;
+                v_best = (ScalarFloat(i) + s) / cone_count;
+            }
+            prev = next;
+        }
+
+        if (t_best == dr::Infinity<ScalarFloat>)
+            return { t_best, 0.f };
+
+        // Newton iterations on (|p - c|^2 - r^2, (p - c) . c' + r r') = 0
+        Vector3d o(ray_.o), d(ray_.d);
+        double t = t_best, v = v_best;
+        for (int it = 0; it < 8; ++it) {
+            auto [c, dc, dc2] = eval_segment(cp, v);
+            Vector3d p = o + t * d - Vector3d(c.x(), c.y(), c.z()),
+                     c1(dc.x(), dc.y(), dc.z()), c2(dc2.x(), dc2.y(), dc2.z());
+
+            double f1 = dr::squared_norm(p) - c.w() * c.w(),
+                   f2 = dr::dot(p, c1) + c.w() * dc.w(),
+                   j11 = 2.0 * dr::dot(p, d),
+                   j12 = -2.0 * f2,
+                   j21 = dr::dot(d, c1),
+                   j22 = -dr::squared_norm(c1) + dr::dot(p, c2) +
+                         dc.w() * dc.w() + c.w() * dc2.w(),
+                   det = j11 * j22 - j12 * j21;
+
+            if (det == 0.0)
+                break;
+
+            double dt = (f1 * j22 - j12 * f2) / det,
+                   dv = (j11 * f2 - j21 * f1) / det;
+            t -= dt;
+            v -= dv;
+
+            if (!(v >= 0.0 && v <= 1.0 && t > 0.0 && t < double(ray_.maxt)))
+                break;
+
+            if (dr::abs(dt) <= 1e-7 * (1.0 + dr::abs(t))) {
+                // Cull back faces
+                auto [c_, dc_, dc2_] = eval_segment(cp, v);
+                DRJIT_MARK_USED(dc_);
+                DRJIT_MARK_USED(dc2_);
+                Vector3d n = o + t * d - Vector3d(c_.x(), c_.y(), c_.z());
+                if (dr::dot(n, d) < 0.0)
+                    return { ScalarFloat(t), ScalarFloat(v) };
+                break;
+            }
+        }
+
+        /* Fall back to the piecewise linear approximation, except for the
+           spheres at the ends of the segment: curves have no endcaps */
+        if (v_best == 0.f || v_best == 1.f)
+            return { dr::Infinity<ScalarFloat>, 0.f };
+        return { t_best, v_best };
+    }
+
+    /**
+     * \brief Intersect a ray with the surface swept by a sphere whose center
+     * and radius interpolate linearly from <tt>(c0, r0)</tt> to <tt>(c1, r1)</tt>
+     *
+     * The surface consists of the two spheres and of the truncated cone that
+     * is tangent to both of them. Back faces are culled. Returns the hit
+     * distance (or infinity) and the parameter of the sphere that touches the
+     * surface at the hit point. The computation is done in double precision
+     * relative to the point of the ray that is closest to \c c0.
+     */
+    static std::pair<ScalarFloat, ScalarFloat>
+    round_cone_intersect(const ScalarRay3f &ray, const ScalarPoint3f &c0_,
+                         ScalarFloat r0, const ScalarPoint3f &c1_,
+                         ScalarFloat r1) {
+        Vector3d d(ray.d);
+        double dd = dr::squared_norm(d),
+               t_shift = dr::dot(Vector3d(c0_) - Vector3d(ray.o), d) / dd;
+        Vector3d o = Vector3d(ray.o) + t_shift * d;
+
+        // Admissible range of the hit distance relative to 'o'
+        double t_min = -t_shift, t_best = double(ray.maxt) - t_shift, v_best = 0.0;
+        bool found = false;
+
+        Vector3d c0 = Vector3d(c0_) - o, c1 = Vector3d(c1_) - o;
+
+        // Spheres at both ends (only the entering intersection counts)
+        for (int i = 0; i < 2; ++i) {
+            const Vector3d &c = i == 0 ? c0 : c1;
+            double r = double(i == 0 ? r0 : r1),
+                   b = dr::dot(c, d),
+                   disc = b * b - dd * (dr::squared_norm(c) - r * r);
+            if (disc < 0.0)
+                continue;
+            double t = (b - dr::sqrt(disc)) / dd;
+            if (t > t_min && t < t_best) {
+                t_best = t;
+                v_best = i;
+                found = true;
+            }
+        }
+
+        /* Cone tangent to both spheres: a point at axial position 'h' and
+           distance 'rho' from the axis lies on it when rho = k (r0 + dr * h)
+           with k = 1 / sqrt(1 - dr^2). It touches the sphere centered at the
+           axial position s = k^2 (h + r0 * dr). */
+        Vector3d axis = c1 - c0;
+        double length = dr::norm(axis);
+        double slope = (double(r1) - double(r0)) / length;
+        if (length > 0.0 && dr::abs(slope) < 1.0) {
+            axis /= length;
+            double k2 = 1.0 / (1.0 - slope * slope);
+
+            Vector3d q = -c0;
+            double h0 = dr::dot(q, axis), hd = dr::dot(d, axis),
+                   w0 = double(r0) + slope * h0, wd = slope * hd;
+
+            double A = dd - hd * hd - k2 * wd * wd,
+                   B = dr::dot(q, d) - h0 * hd - k2 * w0 * wd,
+                   C = dr::squared_norm(q) - h0 * h0 - k2 * w0 * w0;
+
+            double disc = B * B - A * C;
+            if (A != 0.0 && disc >= 0.0) {
+                double sq = dr::sqrt(disc),
+                       ta = (-B - sq) / A,
+                       tb = (-B + sq) / A;
+                if (ta > tb)
+                    std::swap(ta, tb);
+
+                for (double t : { ta, tb }) {
+                    if (!(t > t_min && t < t_best))
+                        continue;
+                    double h = h0 + t * hd;
+                    if (double(r0) + slope * h < 0.0)
+                        continue; // Other nappe of the cone
+                    double s = k2 * (h + double(r0) * slope);
+                    if (s < 0.0 || s > length)
+                        continue;
+                    // Cull back faces
+                    Vector3d n = q + t * d - s * axis;
+                    if (dr::dot(n, d) >= 0.0)
+                        continue;
+                    t_best = t;
+                    v_best = s / length;
+                    found = true;
+                    break;
+                }
+            }
+        }
+
+        if (!found)
+            return { dr::Infinity<ScalarFloat>, 0.f };
+        return { ScalarFloat(t_best + t_shift), ScalarFloat(v_best) };
+    }
+
     void recompute_bbox() {
         auto&& control_points = dr::migrate(m_control_points, AllocType::Host);
         if constexpr (dr::is_jit_v<Float>)
@@ -1304,6 +1719,11 @@ private:
 
     static constexpr float silhouette_offset = 5e-3f;
 
+    /// Number of linear pieces approximating a segment in the native kd-tree
+    static constexpr uint32_t cone_count = 8;
+    /// Number of pieces of a segment that are bounded when clipping it
+    static constexpr uint32_t clip_piece_count = 4;
+
 #if defined(MI_ENABLE_CUDA)
     // For OptiX build input
     mutable CUdeviceptr* m_vertex_buffer_ptr = nullptr;
@@ -0,0 +1,590 @@
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/mesh.h>
+#include <mitsuba/render/sensor.h>
+#include <mitsuba/render/texture.h>
+#include <nanothread/nanothread.h>
+#include <cstring>
+#include <unordered_map>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _shape-displacement:
+
+Displacement-mapped mesh (:monosp:`displacement`)
+-------------------------------------------------
+
+.. pluginparameters::
+
+ * - (Nested plugin)
+   - |shape|
+   - Base triangle mesh that is tessellated and displaced.
+
+ * - displacement
+   - |texture| or |float|
+   - Displacement along the vertex normals of the base mesh, which is looked
+     up using its texture coordinates.
+
+ * - scale
+   - |float|
+   - Factor by which the displacement is multiplied. (Default: 1.0)
+
+ * - edge_length
+   - |float|
+   - Target length of the edges of the tessellation. When a ``sensor`` is
+     specified, it is measured in pixels on its film, and otherwise in world
+     space units. (Default: 1.0)
+
+ * - sensor
+   - |sensor|
+   - Optional reference to the sensor whose view determines the length of the
+     edges, which makes the detail follow the distance to the camera.
+
+ * - max_level
+   - |int|
+   - Maximum number of refinement passes, each of which splits an edge at most
+     once. (Default: 8)
+
+ * - cache_dir
+   - |string|
+   - Optional directory where tessellated meshes are stored in the PLY format,
+     and from which they are loaded again when the scene is loaded with the
+     same inputs.
+
+This plugin tessellates a base mesh when the scene is loaded and offsets the
+new vertices along the interpolated vertex normals, which avoids storing the
+finely tessellated mesh with the scene. The tessellation is adaptive: every
+refinement pass splits the edges that are longer than ``edge_length``, and
+each triangle is replaced by two, three, or four triangles depending on how
+many of its edges were split. Edges are split based on their end points only,
+so that neighboring triangles always agree and the tessellation has no
+cracks. The edge lengths are measured before displacing the vertices. The
+vertex normals of the result are recomputed from the displaced geometry.
+
+When a perspective or orthographic ``sensor`` is given, the length of an edge
+is the size of its projection onto the film, hence the tessellation becomes
+coarser away from the camera. The plugin is replaced by the tessellated mesh,
+which inherits the BSDF, media, and attached emitter or sensor of the base mesh.
+
+When ``cache_dir`` is set, the result is stored in a file whose name is a hash
+of the base mesh, the parameters, the view of the sensor, and of the values of
+the displacement texture on a regular grid of texture coordinates.
+
+.. tabs::
+    .. code-tab:: xml
+        :name: displacement
+
+        <shape type="displacement">
+            <float name="edge_length" value="2"/>
+            <float name="scale" value="0.05"/>
+            <ref id="camera" name="sensor"/>
+            <texture type="bitmap" name="displacement">
+                <string name="filename" value="rock_height.exr"/>
+                <boolean name="raw" value="true"/>
+            </texture>
+            <shape type="ply">
+                <string name="filename" value="rock.ply"/>
+            </shape>
+        </shape>
+
+    .. code-tab:: python
+
+        'type': 'displacement',
+        'edge_length': 2,
+        'scale': 0.05,
+        'sensor': camera,
+        'displacement': {
+            'type': 'bitmap',
+            'filename': 'rock_height.exr',
+            'raw': True
+        },
+        'base': {
+            'type': 'ply',
+            'filename': 'rock.ply'
+        }
+ */
+
+template <typename Float, typename Spectrum>
+class DisplacementShape final : public Shape<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Shape)
+    MI_IMPORT_TYPES(Mesh, Sensor, ProjectiveCamera, Texture)
+
+    using typename Base::ScalarIndex;
+    using FloatStorage = DynamicBuffer<Float>;
+
+    DisplacementShape(const Properties &props) {
+        // Note: we are *not* calling the `Shape` constructor, since the
+        // result inherits the parameters of the base mesh.
+        ref<Mesh> base;
+        const Sensor *sensor = nullptr;
+        for (auto &[name, obj] : props.objects()) {
+            if (name == "displacement")
+                continue;
+            if (Mesh *mesh = dynamic_cast<Mesh *>(obj.get())) {
+                if (base)
+                    Throw("Only a single base mesh can be specified.");
+                base = mesh;
+            } else if (Sensor *s = dynamic_cast<Sensor *>(obj.get())) {
+                sensor = s;
+            } else {
+                Throw("Unsupported nested object \"%s\".", name);
+            }
+        }
+        if (!base)
+            Throw("A base mesh must be specified.");
+
+        m_displacement = props.texture<Texture>("displacement");
+        m_scale        = props.get<ScalarFloat>("scale", 1.f);
+        m_edge_length  = props.get<ScalarFloat>("edge_length", 1.f);
+        m_max_level    = props.get<uint32_t>("max_level", 8);
+        if (m_edge_length <= 0.f)
+            Throw("The edge length must be positive!");
+
+        if (const ProjectiveCamera *camera =
+                dynamic_cast<const ProjectiveCamera *>(sensor))
+            set_view(camera);
+        else if (sensor)
+            Log(Warn, "Only projective cameras define a view, using world "
+                      "space edge lengths.");
+
+        Timer timer;
+        fs::path cache_file;
+        if (props.has_property("cache_dir")) {
+            uint64_t key = cache_key(base.get());
+            cache_file = fs::path(props.get<std::string>("cache_dir")) /
+                         fs::path(tfm::format("displacement_%016llx.ply",
+                                              (unsigned long long) key));
+            if (fs::exists(cache_file)) {
+                try {
+                    m_mesh = load_cached(base.get(), cache_file, props.id());
+                    Log(Info, "Loaded the tessellation of \"%s\" (%zu faces) "
+                        "from \"%s\"", base->id(), m_mesh->face_count(),
+                        cache_file);
+                } catch (const std::exception &e) {
+                    Log(Warn, "Ignoring the cache file \"%s\": %s", cache_file,
+                        e.what());
+                }
+            }
+        }
+
+        if (!m_mesh) {
+            m_mesh = tessellate(base.get(), props.id());
+            Log(Info, "Tessellated \"%s\" from %zu into %zu faces (took %s)",
+                base->id(), base->face_count(), m_mesh->face_count(),
+                util::time_string((float) timer.value()));
+            if (!cache_file.empty())
+                store_cached(cache_file);
+        }
+
+        if constexpr (dr::is_jit_v<Float>)
+            jit_registry_put(dr::backend_v<Float>, "mitsuba::Shape", this);
+    }
+
+    std::vector<ref<Object>> expand() const override {
+        return { ref<Object>(m_mesh.get()) };
+    }
+
+    ScalarBoundingBox3f bbox() const override { return m_mesh->bbox(); }
+
+    MI_DECLARE_CLASS()
+
+private:
+    /// Record the position and the pixel footprint of a camera
+    void set_view(const ProjectiveCamera *camera) {
+        auto ray = [camera](ScalarFloat x) {
+            auto [r, unused] = camera->sample_ray(
+                Float(camera->shutter_open()), Float(0.5f), Point2f(x, 0.5f),
+                Point2f(0.5f));
+            return std::make_pair(ScalarPoint3f(dr::slice(r.o)),
+                                  ScalarVector3f(dr::slice(r.d)));
+        };
+
+        auto left = ray(0.f), center = ray(.5f), right = ray(1.f);
+        ScalarFloat width = (ScalarFloat) camera->film()->crop_size().x();
+        m_has_view = true;
+        m_orthographic = dr::dot(left.second, right.second) > 1.f - 1e-6f;
+        m_pixel_footprint = (m_orthographic
+                                 ? dr::norm(right.first - left.first)
+                                 : dr::unit_angle(left.second, right.second)) / width;
+        m_view_origin = center.first;
+    }
+
+    /// Length of the edge between two (undisplaced) points
+    ScalarFloat edge_length(const ScalarPoint3f &a, const ScalarPoint3f &b) const {
+        ScalarFloat length = dr::norm(b - a);
+        if (!m_has_view)
+            return length;
+        if (m_orthographic)
+            return length / m_pixel_footprint;
+        ScalarFloat dist = dr::norm(.5f * (a + b) - m_view_origin);
+        return length / (dr::maximum(dist, dr::Epsilon<ScalarFloat>) * m_pixel_footprint);
+    }
+
+    /// Host copy of the vertex attributes of a mesh
+    struct Geometry {
+        std::vector<ScalarFloat> p, n, uv;
+        std::vector<ScalarIndex> faces;
+
+        ScalarPoint3f position(ScalarIndex i) const {
+            return ScalarPoint3f(p[3 * i], p[3 * i + 1], p[3 * i + 2]);
+        }
+    };
+
+    static std::vector<ScalarFloat> to_host(const FloatStorage &buf) {
+        auto host = dr::migrate(buf, AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+        return std::vector<ScalarFloat>(host.data(), host.data() + dr::width(host));
+    }
+
+    Geometry fetch(Mesh *base) const {
+        Geometry g;
+        g.p = to_host(base->vertex_positions_buffer());
+        auto faces = dr::migrate(base->faces_buffer(), AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+        g.faces.assign(faces.data(), faces.data() + dr::width(faces));
+
+        size_t vertex_count = base->vertex_count();
+        if (base->has_vertex_texcoords())
+            g.uv = to_host(base->vertex_texcoords_data());
+        else
+            g.uv.resize(vertex_count * 2, 0.f);
+
+        if (base->has_vertex_normals()) {
+            g.n = to_host(base->vertex_normals_data());
+        } else {
+            // Area-weighted face normals
+            g.n.resize(vertex_count * 3, 0.f);
+            for (size_t f = 0; f < g.faces.size(); f += 3) {
+                ScalarPoint3f p0 = g.position(g.faces[f]),
+                              p1 = g.position(g.faces[f + 1]),
+                              p2 = g.position(g.faces[f + 2]);
+                ScalarVector3f n = dr::cross(p1 - p0, p2 - p0);
+                for (size_t k = 0; k < 3; ++k)
+                    for (size_t j = 0; j < 3; ++j)
+                        g.n[3 * g.faces[f + k] + j] += n[j];
+            }
+        }
+
+        for (size_t i = 0; i < vertex_count; ++i) {
+            ScalarVector3f n = dr::normalize(
+                ScalarVector3f(g.n[3 * i], g.n[3 * i + 1], g.n[3 * i + 2]));
+            for (size_t j = 0; j < 3; ++j)
+                g.n[3 * i + j] = n[j];
+        }
+
+        return g;
+    }
+
+    /// Split the edges that exceed the target length until none are left
+    void refine(Geometry &g) const {
+        for (uint32_t level = 0; level < m_max_level; ++level) {
+            size_t face_count = g.faces.size() / 3;
+
+            // Decide which edges to split (depends on the end points only)
+            std::vector<uint8_t> split(face_count * 3);
+            dr::parallel_for(
+                dr::blocked_range<size_t>(0, face_count, 4096),
+                [&](const dr::blocked_range<size_t> &range) {
+                    for (size_t f = range.begin(); f != range.end(); ++f)
+                        for (size_t k = 0; k < 3; ++k)
+                            split[3 * f + k] =
+                                edge_length(g.position(g.faces[3 * f + k]),
+                                            g.position(g.faces[3 * f + (k + 1) % 3])) >
+                                m_edge_length;
+                }
+            );
+
+            // Allocate one midpoint per split edge
+            std::unordered_map<uint64_t, ScalarIndex> midpoints;
+            std::vector<std::pair<ScalarIndex, ScalarIndex>> edges;
+            std::vector<ScalarIndex> midpoint(face_count * 3, (ScalarIndex) -1);
+            ScalarIndex vertex_count = (ScalarIndex) (g.p.size() / 3);
+            for (size_t i = 0; i < face_count * 3; ++i) {
+                if (!split[i])
+                    continue;
+                ScalarIndex a = g.faces[i], b = g.faces[i - i % 3 + (i + 1) % 3];
+                if (a > b)
+                    std::swap(a, b);
+                auto [it, inserted] = midpoints.try_emplace(
+                    ((uint64_t) a << 32) | b, vertex_count + (ScalarIndex) edges.size());
+                if (inserted)
+                    edges.emplace_back(a, b);
+                midpoint[i] = it->second;
+            }
+
+            if (edges.empty())
+                return;
+
+            size_t new_count = vertex_count + edges.size();
+            g.p.resize(new_count * 3);
+            g.n.resize(new_count * 3);
+            g.uv.resize(new_count * 2);
+            dr::parallel_for(
+                dr::blocked_range<size_t>(0, edges.size(), 4096),
+                [&](const dr::blocked_range<size_t> &range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        auto [a, b] = edges[i];
+                        size_t v = vertex_count + i;
+                        for (size_t j = 0; j < 3; ++j)
+                            g.p[3 * v + j] = .5f * (g.p[3 * a + j] + g.p[3 * b + j]);
+                        ScalarVector3f n = dr::normalize(ScalarVector3f(
+                            g.n[3 * a] + g.n[3 * b], g.n[3 * a + 1] + g.n[3 * b + 1],
+                            g.n[3 * a + 2] + g.n[3 * b + 2]));
+                        for (size_t j = 0; j < 3; ++j)
+                            g.n[3 * v + j] = n[j];
+                        for (size_t j = 0; j < 2; ++j)
+                            g.uv[2 * v + j] = .5f * (g.uv[2 * a + j] + g.uv[2 * b + j]);
+                    }
+                }
+            );
+
+            // Every face is replaced by one triangle more than it has split edges
+            std::vector<size_t> offset(face_count + 1, 0);
+            for (size_t f = 0; f < face_count; ++f)
+                offset[f + 1] = offset[f] + 1 + split[3 * f] + split[3 * f + 1] +
+                                split[3 * f + 2];
+
+            std::vector<ScalarIndex> faces(offset[face_count] * 3);
+            dr::parallel_for(
+                dr::blocked_range<size_t>(0, face_count, 4096),
+                [&](const dr::blocked_range<size_t> &range) {
+                    for (size_t f = range.begin(); f != range.end(); ++f)
+                        split_face(g, &g.faces[3 * f], &midpoint[3 * f],
+                                   &faces[3 * offset[f]]);
+                }
+            );
+            g.faces = std::move(faces);
+        }
+    }
+
+    /// Write the triangles that replace a face given the midpoints of its edges
+    static void split_face(const Geometry &g, const ScalarIndex *v,
+                           const ScalarIndex *m, ScalarIndex *out) {
+        auto emit = [&out](ScalarIndex a, ScalarIndex b, ScalarIndex c) {
+            out[0] = a; out[1] = b; out[2] = c;
+            out += 3;
+        };
+
+        const ScalarIndex none = (ScalarIndex) -1;
+        int count = (m[0] != none) + (m[1] != none) + (m[2] != none);
+
+        // Rotate the face so that edge 0 is split (one split edge) or edge 2 isn't (two)
+        int r = 0;
+        for (int k = 0; k < 3; ++k)
+            if ((count == 1 && m[k] != none) || (count == 2 && m[k] == none))
+                r = count == 1 ? k : (k + 1) % 3;
+
+        ScalarIndex v0 = v[r], v1 = v[(r + 1) % 3], v2 = v[(r + 2) % 3],
+                    m0 = m[r], m1 = m[(r + 1) % 3], m2 = m[(r + 2) % 3];
+
+        switch (count) {
+            case 0:
+                emit(v0, v1, v2);
+                break;
+
+            case 1:
+                emit(v0, m0, v2);
+                emit(m0, v1, v2);
+                break;
+
+            case 2:
+                emit(m0, v1, m1);
+                // Split the remaining quad along its shorter diagonal
+                if (dr::squared_norm(g.position(v0) - g.position(m1)) <
+                    dr::squared_norm(g.position(m0) - g.position(v2))) {
+                    emit(v0, m0, m1);
+                    emit(v0, m1, v2);
+                } else {
+                    emit(v0, m0, v2);
+                    emit(m0, m1, v2);
+                }
+                break;
+
+            default:
+                emit(v0, m0, m2);
+                emit(m0, v1, m1);
+                emit(m2, m1, v2);
+                emit(m0, m1, m2);
+                break;
+        }
+    }
+
+    /// Evaluate the displacement texture at the given texture coordinates
+    std::vector<ScalarFloat> eval_displacement(const std::vector<ScalarFloat> &uv) const {
+        size_t n = uv.size() / 2;
+        std::vector<ScalarFloat> result(n);
+
+        if constexpr (dr::is_jit_v<Float>) {
+            FloatStorage uv_buf = dr::load<FloatStorage>(uv.data(), uv.size());
+            UInt32 index = dr::arange<UInt32>((uint32_t) n);
+            SurfaceInteraction3f si = dr::zeros<SurfaceInteraction3f>(n);
+            si.uv = Point2f(dr::gather<Float>(uv_buf, index * 2),
+                            dr::gather<Float>(uv_buf, index * 2 + 1));
+            std::vector<ScalarFloat> values =
+                to_host(dr::detach(m_displacement->eval_1(si)));
+            std::memcpy(result.data(), values.data(), n * sizeof(ScalarFloat));
+        } else {
+            dr::parallel_for(
+                dr::blocked_range<size_t>(0, n, 4096),
+                [&](const dr::blocked_range<size_t> &range) {
+                    SurfaceInteraction3f si = dr::zeros<SurfaceInteraction3f>();
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        si.uv = Point2f(uv[2 * i], uv[2 * i + 1]);
+                        result[i] = m_displacement->eval_1(si);
+                    }
+                }
+            );
+        }
+
+        return result;
+    }
+
+    /// Properties with the BSDF, media, emitter and sensor of the base mesh
+    static Properties inherited_props(const Mesh *base) {
+        Properties props;
+        if (base->bsdf())
+            props.set_object("bsdf", (Object *) base->bsdf());
+        if (base->interior_medium())
+            props.set_object("interior", (Object *) base->interior_medium());
+        if (base->exterior_medium())
+            props.set_object("exterior", (Object *) base->exterior_medium());
+        if (base->sensor())
+            props.set_object("sensor", (Object *) base->sensor());
+        if (base->emitter())
+            props.set_object("emitter", (Object *) base->emitter());
+        return props;
+    }
+
+    ref<Mesh> tessellate(Mesh *base, const std::string &name) const {
+        Geometry g = fetch(base);
+        refine(g);
+
+        std::vector<ScalarFloat> d = eval_displacement(g.uv);
+        for (size_t i = 0; i < d.size(); ++i)
+            for (size_t j = 0; j < 3; ++j)
+                g.p[3 * i + j] += g.n[3 * i + j] * m_scale * d[i];
+
+        size_t vertex_count = g.p.size() / 3, face_count = g.faces.size() / 3;
+        bool has_texcoords = base->has_vertex_texcoords();
+        ref<Mesh> mesh = new Mesh(name, (uint32_t) vertex_count,
+                                  (uint32_t) face_count, inherited_props(base),
+                                  true, has_texcoords);
+
+        if constexpr (dr::is_jit_v<Float>) {
+            mesh->vertex_positions_buffer() = dr::load<FloatStorage>(g.p.data(), g.p.size());
+            mesh->faces_buffer() = dr::load<DynamicBuffer<UInt32>>(g.faces.data(), g.faces.size());
+            if (has_texcoords)
+                mesh->vertex_texcoords_buffer() = dr::load<FloatStorage>(g.uv.data(), g.uv.size());
+        } else {
+            std::memcpy(mesh->vertex_positions_buffer().data(), g.p.data(),
+                        g.p.size() * sizeof(ScalarFloat));
+            std::memcpy(mesh->faces_buffer().data(), g.faces.data(),
+                        g.faces.size() * sizeof(ScalarIndex));
+            if (has_texcoords)
+                std::memcpy(mesh->vertex_texcoords_buffer().data(), g.uv.data(),
+                            g.uv.size() * sizeof(ScalarFloat));
+        }
+
+        mesh->recompute_vertex_normals();
+        mesh->recompute_bbox();
+        mesh->initialize();
+        return mesh;
+    }
+
+    // =============================================================
+    //! @{ \name On-disk cache
+    // =============================================================
+
+    /// 64-bit FNV-1a hash of the inputs of the tessellation
+    uint64_t cache_key(Mesh *base) const {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        auto combine = [&hash](const void *ptr, size_t size) {
+            const uint8_t *data = (const uint8_t *) ptr;
+            for (size_t i = 0; i < size; ++i) {
+                hash ^= data[i];
+                hash *= 0x100000001b3ull;
+            }
+        };
+
+        Geometry g = fetch(base);
+        combine(g.p.data(), g.p.size() * sizeof(ScalarFloat));
+        combine(g.n.data(), g.n.size() * sizeof(ScalarFloat));
+        combine(g.uv.data(), g.uv.size() * sizeof(ScalarFloat));
+        combine(g.faces.data(), g.faces.size() * sizeof(ScalarIndex));
+        bool has_texcoords = base->has_vertex_texcoords();
+        combine(&has_texcoords, sizeof(bool));
+
+        ScalarFloat params[7] = { m_scale, m_edge_length, m_pixel_footprint,
+                                  m_view_origin.x(), m_view_origin.y(),
+                                  m_view_origin.z(), (ScalarFloat) m_orthographic };
+        combine(params, sizeof(params));
+        combine(&m_max_level, sizeof(uint32_t));
+
+        // The texture is identified by its description and values
+        std::string desc = m_displacement->to_string();
+        combine(desc.data(), desc.size());
+        const size_t res = 64;
+        std::vector<ScalarFloat> uv(res * res * 2);
+        for (size_t i = 0; i < res * res; ++i) {
+            uv[2 * i]     = ((i % res) + .5f) / res;
+            uv[2 * i + 1] = ((i / res) + .5f) / res;
+        }
+        std::vector<ScalarFloat> values = eval_displacement(uv);
+        combine(values.data(), values.size() * sizeof(ScalarFloat));
+
+        return hash;
+    }
+
+    ref<Mesh> load_cached(Mesh *base, const fs::path &filename,
+                          const std::string &name) const {
+        Properties props = inherited_props(base);
+        props.set_plugin_name("ply");
+        props.set_id(name);
+        props.set_string("filename", filename.string());
+        ref<Mesh> mesh = PluginManager::instance()->create_object<Mesh>(props);
+        if (mesh->has_vertex_texcoords() != base->has_vertex_texcoords())
+            Throw("file does not match the base mesh");
+        return mesh;
+    }
+
+    void store_cached(const fs::path &filename) const {
+        /* Write to a temporary file first, so that concurrent processes never
+           observe a partially written cache entry */
+        try {
+            util::write_file_atomic(filename, [&](const fs::path &tmp_file) {
+                m_mesh->write_ply(tmp_file.string());
+            });
+            Log(Info, "Stored the tessellation in \"%s\"", filename);
+        } catch (const std::exception &e) {
+            Log(Warn, "Could not store the cache file \"%s\": %s", filename,
+                e.what());
+        }
+    }
+
+    //! @}
+    // =============================================================
+
+private:
+    ref<Mesh> m_mesh;
+    ref<Texture> m_displacement;
+    ScalarFloat m_scale;
+    ScalarFloat m_edge_length;
+    uint32_t m_max_level;
+
+    bool m_has_view = false;
+    bool m_orthographic = false;
+    ScalarFloat m_pixel_footprint = 0.f;
+    ScalarPoint3f m_view_origin = 0.f;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(DisplacementShape, Shape)
+MI_EXPORT_PLUGIN(DisplacementShape, "Displacement-mapped mesh");
+NAMESPACE_END(mitsuba)
@@ -26,11 +26,27 @@ Instance (:monosp:`instance`)
    - :paramtype:`shapegroup`
    - A reference to a shape group that should be instantiated.
 
+ * - (Nested plugin)
+   - |bsdf|
+   - Material that replaces the BSDFs of all shapes in the shape group for
+     this instance. (Default: none, i.e. the materials of the shape group)
+   - |exposed|, |differentiable|
+
  * - to_world
    - |transform|
    - Specifies a linear object-to-world transformation. (Default: none (i.e. object space = world space))
    - |exposed|, |differentiable|, |discontinuous|
 
+ * - to_world_0, to_world_1, ...
+   - |transform|
+   - Keyframes of a time-dependent object-to-world transformation, which replace
+     ``to_world`` (see below). (Default: none)
+
+ * - time_begin, time_end
+   - |float|
+   - Ray times associated with the first and the last keyframe. Intermediate
+     keyframes are spaced uniformly in between. (Default: 0 and 1)
+
 This plugin implements a geometry instance used to efficiently replicate geometry many times. For
 details on how to create instances, refer to the :ref:`shape-shapegroup` plugin.
 
@@ -43,28 +59,79 @@ details on how to create instances, refer to the :ref:`shape-shapegroup` plugin.
 
 .. warning::
 
-    - Note that it is not possible to assign a different material to each instance — the material
-      assignment specified within the shape group is the one that matters.
     - Shape groups cannot be used to replicate shapes with attached emitters, sensors, or
       subsurface scattering models.
 
+By default, the surfaces of an instance use the materials assigned within the
+shape group. A nested BSDF replaces these for all shapes of the group, which
+makes it possible to render many variations of the same object without
+duplicating its geometry or acceleration data structure: instances only store
+a reference to their material. The function :py:func:`mitsuba.load_instances`
+accepts a table of materials along with an index per instance for this
+purpose.
+
+Transform motion blur is supported by providing two or more keyframes
+``to_world_0``, ``to_world_1``, ... instead of ``to_world``. The transformation
+that applies to a ray is found by linearly interpolating the matrices of the two
+neighboring keyframes at the ray's ``time``, clamped to the range
+``[time_begin, time_end]``. Since the sensor's shutter determines the ray times,
+its ``shutter_open`` and ``shutter_close`` parameters should overlap with this
+range. The Embree and OptiX backends build the instance as a motion BVH
+(multiple time steps and a matrix motion transform, respectively), so that an
+animated frame only requires a single acceleration structure build. Embree
+expects ray times in ``[0, 1]``, and would hide the instance outside of its
+time range: the first and last keyframes are therefore repeated until they
+cover this interval (unless this exceeds Embree's limit of 129 time steps, in
+which case a warning is printed). Linear interpolation of matrices slightly
+shrinks objects during large rotations, hence these should be split into
+several keyframes.
+
+.. tabs::
+    .. code-tab:: xml
+
+        <shape type="instance">
+            <ref id="my_shapegroup"/>
+            <bsdf type="diffuse"/>
+            <transform name="to_world_0">
+                <translate x="0"/>
+            </transform>
+            <transform name="to_world_1">
+                <translate x="1"/>
+            </transform>
+        </shape>
+
+    .. code-tab:: python
+
+        'instance': {
+            'type': 'instance',
+            'group': { 'type': 'ref', 'id': 'my_shapegroup' },
+            'bsdf': { 'type': 'diffuse' },
+            'to_world_0': mi.ScalarTransform4f().translate([0, 0, 0]),
+            'to_world_1': mi.ScalarTransform4f().translate([1, 0, 0])
+        }
+
  */
 
 template <typename Float, typename Spectrum>
 class Instance final: public Shape<Float, Spectrum> {
 public:
     MI_IMPORT_BASE(Shape, m_id, m_to_world, m_to_object, m_shape_type,
-                   mark_dirty)
+                   m_bsdf, mark_dirty)
     MI_IMPORT_TYPES(BSDF)
+    using ScalarMatrix4f = dr::Matrix<ScalarFloat, 4>;
 
     using typename Base::ScalarSize;
     using typename Base::ScalarIndex;
     using ShapeGroup_ = ShapeGroup<Float, Spectrum>;
 
     Instance(const Properties &props) : Base(props) {
+        bool has_bsdf = false;
         for (auto &kv : props.objects()) {
             Base *shape = dynamic_cast<Base *>(kv.second.get());
-            if (shape && shape->is_shapegroup()) {
+            if (dynamic_cast<BSDF *>(kv.second.get())) {
+                // Already assigned by the Shape constructor
+                has_bsdf = true;
+            } else if (shape && shape->is_shapegroup()) {
                 if (m_shapegroup)
                     Throw("Only a single shapegroup can be specified per instance.");
                 m_shapegroup = (ShapeGroup_*) shape;
@@ -76,13 +143,49 @@ public:
         if (!m_shapegroup)
             Throw("A reference to a 'shapegroup' must be specified!");
 
+        /* Discard the default BSDF created by the Shape constructor: a null
+           BSDF means that the shapes of the group keep their own materials */
+        if (!has_bsdf)
+            m_bsdf = nullptr;
+
+        // Keyframes of a time-dependent transformation
+        for (size_t i = 0;; ++i) {
+            std::string name = "to_world_" + std::to_string(i);
+            if (!props.has_property(name))
+                break;
+            m_keyframes.push_back(props.get<ScalarTransform4f>(name).matrix);
+        }
+
+        m_time_begin = props.get<ScalarFloat>("time_begin", 0.f);
+        m_time_end   = props.get<ScalarFloat>("time_end", 1.f);
+
+        if (!m_keyframes.empty()) {
+            if (props.has_property("to_world"))
+                Throw("The 'to_world' and 'to_world_<i>' parameters cannot be "
+                      "specified at the same time!");
+            if (m_keyframes.size() < 2)
+                Throw("An animated instance requires at least two keyframes!");
+            if (!(m_time_end > m_time_begin))
+                Throw("The 'time_end' parameter must be larger than 'time_begin'!");
+            if (m_keyframes.size() > 0xFFFF)
+                Throw("An animated instance can have at most 65535 keyframes!");
+
+            // The first keyframe serves as the static transformation
+            m_to_world = ScalarTransform4f(m_keyframes[0]);
+            m_to_object = m_to_world.scalar().inverse();
+        }
+
         m_shape_type = ShapeType::Instance;
 
         dr::make_opaque(m_to_world, m_to_object);
     }
 
     void traverse(TraversalCallback *callback) override {
-        callback->put_parameter("to_world", *m_to_world.ptr(), +ParamFlags::NonDifferentiable);
+        // Keyframed transformations are not exposed
+        if (m_keyframes.empty())
+            callback->put_parameter("to_world", *m_to_world.ptr(), +ParamFlags::NonDifferentiable);
+        if (m_bsdf)
+            callback->put_object("bsdf", m_bsdf.get(), +ParamFlags::Differentiable);
     }
 
     void parameters_changed(const std::vector<std::string> &keys) override {
@@ -102,12 +205,65 @@ public:
         if (!bbox.valid())
             return bbox;
 
+        /* Transform the tight bounds of the pieces of the shape group, whose
+           union is usually much smaller than the transformed bounding box of
+           the entire group (e.g. under rotations). Interpolated matrices
+           produce convex combinations of the transformed keyframe positions,
+           hence it suffices to bound those */
         ScalarBoundingBox3f result;
-        for (int i = 0; i < 8; ++i)
-            result.expand(m_to_world.scalar() * bbox.corner(i));
+        auto expand = [&](const ScalarTransform4f &trafo) {
+            for (const ScalarBoundingBox3f &b : m_shapegroup->bounds())
+                for (int i = 0; i < 8; ++i)
+                    result.expand(trafo * b.corner(i));
+        };
+
+        if (m_keyframes.empty()) {
+            expand(m_to_world.scalar());
+        } else {
+            for (const ScalarMatrix4f &m : m_keyframes)
+                expand(ScalarTransform4f(m));
+        }
+        return result;
+    }
+
+    bool has_motion() const override { return !m_keyframes.empty(); }
+
+    ScalarTransform4f instance_transform(ScalarFloat time) const override {
+        return m_keyframes.empty() ? m_to_world.scalar() : to_world_at(time);
+    }
+
+    /**
+     * \brief Interpolate the keyframes at the given ray time
+     *
+     * Every keyframe is weighted by a hat function centered at its time,
+     * which avoids gathers in vectorized variants.
+     */
+    template <typename Value>
+    dr::Matrix<Value, 4> interpolate(const Value &time) const {
+        using Matrix = dr::Matrix<Value, 4>;
+        ScalarFloat n = ScalarFloat(m_keyframes.size() - 1);
+        Value x = dr::clamp((time - m_time_begin) *
+                                (n / (m_time_end - m_time_begin)),
+                            ScalarFloat(0), n);
+
+        Matrix result = dr::zeros<Matrix>();
+        for (size_t k = 0; k < m_keyframes.size(); ++k) {
+            Value w = dr::maximum(ScalarFloat(1) - dr::abs(x - ScalarFloat(k)),
+                                  ScalarFloat(0));
+            for (size_t i = 0; i < 4; ++i)
+                for (size_t j = 0; j < 4; ++j)
+                    result(i, j) = dr::fmadd(Value(m_keyframes[k](i, j)), w,
+                                             result(i, j));
+        }
         return result;
     }
 
+    /// Return the object-to-world transformation that applies to a ray
+    template <typename Value>
+    Transform<Point<Value, 4>> to_world_at(const Value &time) const {
+        return Transform<Point<Value, 4>>(interpolate(time));
+    }
+
     ScalarSize primitive_count() const override { return 1; }
 
     ScalarSize effective_primitive_count() const override {
@@ -129,7 +285,10 @@ public:
                                    dr::mask_t<FloatP> active) const {
         MI_MASK_ARGUMENT(active);
         if constexpr (!dr::is_array_v<FloatP>) {
-            return m_shapegroup->ray_intersect_preliminary_scalar(m_to_object.scalar().transform_affine(ray));
+            const ScalarTransform4f to_object =
+                m_keyframes.empty() ? m_to_object.scalar()
+                                    : to_world_at(ray.time).inverse();
+            return m_shapegroup->ray_intersect_preliminary_scalar(to_object.transform_affine(ray), 0);
         } else {
             Throw("Instance::ray_intersect_preliminary() should only be called with scalar types.");
         }
@@ -142,7 +301,10 @@ public:
         MI_MASK_ARGUMENT(active);
 
         if constexpr (!dr::is_array_v<FloatP>) {
-            return m_shapegroup->ray_test_scalar(m_to_object.scalar().transform_affine(ray));
+            const ScalarTransform4f to_object =
+                m_keyframes.empty() ? m_to_object.scalar()
+                                    : to_world_at(ray.time).inverse();
+            return m_shapegroup->ray_test_scalar(to_object.transform_affine(ray), 0);
         } else {
             Throw("Instance::ray_test_impl() should only be called with scalar types.");
         }
@@ -157,8 +319,12 @@ public:
                                                      Mask active) const override {
         MI_MASK_ARGUMENT(active);
 
-        const Transform4f& to_world  = m_to_world.value();
-        const Transform4f& to_object = m_to_object.value();
+        Transform4f to_world  = m_to_world.value();
+        Transform4f to_object = m_to_object.value();
+        if (!m_keyframes.empty()) {
+            to_world  = to_world_at(ray.time);
+            to_object = to_world.inverse();
+        }
 
         constexpr bool IsDiff = dr::is_diff_v<Float>;
         bool grad_enabled = dr::grad_enabled(to_world);
@@ -253,6 +419,8 @@ public:
             oss << "Instance[" << std::endl
                 << "  shapegroup = " << string::indent(m_shapegroup) << std::endl
                 << "  to_world = " << string::indent(m_to_world, 13) << "," << std::endl
+                << "  keyframes = " << m_keyframes.size() << "," << std::endl
+                << "  bsdf = " << (m_bsdf ? string::indent(m_bsdf) : "none") << std::endl
                 << "]";
         return oss.str();
     }
@@ -262,9 +430,42 @@ public:
         DRJIT_MARK_USED(device);
         if constexpr (!dr::is_cuda_v<Float>) {
             RTCGeometry instance = m_shapegroup->embree_geometry(device);
-            rtcSetGeometryTimeStepCount(instance, 1);
-            dr::Matrix<ScalarFloat32, 4> matrix(dr::transpose(m_to_world.scalar().matrix));
-            rtcSetGeometryTransform(instance, 0, RTC_FORMAT_FLOAT4X4_COLUMN_MAJOR, matrix.data());
+            if (m_keyframes.empty()) {
+                rtcSetGeometryTimeStepCount(instance, 1);
+                dr::Matrix<ScalarFloat32, 4> matrix(dr::transpose(m_to_world.scalar().matrix));
+                rtcSetGeometryTransform(instance, 0, RTC_FORMAT_FLOAT4X4_COLUMN_MAJOR, matrix.data());
+            } else {
+                /* Embree linearly interpolates between uniformly spaced time
+                   steps, but hides the instance outside of their time range.
+                   Repeat the first and last keyframes to cover [0, 1], which
+                   clamps the ray time like the other backends. */
+                size_t count = m_keyframes.size(), before = 0, after = 0;
+                ScalarFloat step = (m_time_end - m_time_begin) / ScalarFloat(count - 1);
+                if (m_time_begin > 0.f)
+                    before = (size_t) dr::ceil(m_time_begin / step);
+                if (m_time_end < 1.f)
+                    after = (size_t) dr::ceil((1.f - m_time_end) / step);
+                if (before + count + after > RTC_MAX_TIME_STEP_COUNT) {
+                    Log(Warn, "Instance: too many time steps are needed to cover "
+                              "the shutter interval, Embree will not render the "
+                              "instance at ray times outside of [%f, %f]!",
+                        m_time_begin, m_time_end);
+                    before = after = 0;
+                }
+
+                rtcSetGeometryTimeStepCount(instance,
+                                            (unsigned int) (before + count + after));
+                rtcSetGeometryTimeRange(instance,
+                                        (float) (m_time_begin - before * step),
+                                        (float) (m_time_end + after * step));
+                for (size_t k = 0; k < before + count + after; ++k) {
+                    size_t index = std::min(k - std::min(k, before), count - 1);
+                    dr::Matrix<ScalarFloat32, 4> matrix(dr::transpose(m_keyframes[index]));
+                    rtcSetGeometryTransform(instance, (unsigned int) k,
+                                            RTC_FORMAT_FLOAT4X4_COLUMN_MAJOR,
+                                            matrix.data());
+                }
+            }
             rtcCommitGeometry(instance);
             return instance;
         } else {
@@ -278,8 +479,60 @@ public:
                                    std::vector<OptixInstance>& instances,
                                    uint32_t instance_id,
                                    const ScalarTransform4f& transf) override {
+        if (m_keyframes.empty()) {
+            m_shapegroup->optix_prepare_ias(context, instances, instance_id,
+                                            transf * m_to_world.scalar());
+            return;
+        }
+
+        for (void *ptr : m_optix_motion_transforms)
+            jit_free(ptr);
+        m_optix_motion_transforms.clear();
+
+        /* Wrap the instances of the shape group into matrix motion transforms,
+           which OptiX interpolates linearly between uniformly spaced keys */
+        size_t first = instances.size();
         m_shapegroup->optix_prepare_ias(context, instances, instance_id,
-                                        transf * m_to_world.scalar());
+                                        ScalarTransform4f());
+
+        uint32_t key_count = (uint32_t) m_keyframes.size();
+        size_t size = sizeof(OptixMatrixMotionTransform) +
+                      (key_count - 2) * 12 * sizeof(float);
+
+        for (size_t i = first; i < instances.size(); ++i) {
+            OptixInstance &instance = instances[i];
+
+            std::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+            memset(data.get(), 0, size);
+            OptixMatrixMotionTransform *motion =
+                (OptixMatrixMotionTransform *) data.get();
+            motion->child = instance.traversableHandle;
+            motion->motionOptions.numKeys   = (unsigned short) key_count;
+            motion->motionOptions.flags     = OPTIX_MOTION_FLAG_NONE;
+            motion->motionOptions.timeBegin = (float) m_time_begin;
+            motion->motionOptions.timeEnd   = (float) m_time_end;
+
+            float *keys = &motion->transform[0][0];
+            for (uint32_t k = 0; k < key_count; ++k) {
+                ScalarMatrix4f m = transf.matrix * m_keyframes[k];
+                for (size_t r = 0; r < 3; ++r)
+                    for (size_t c = 0; c < 4; ++c)
+                        keys[k * 12 + r * 4 + c] = (float) m(r, c);
+            }
+
+            void *d_motion = jit_malloc(AllocType::HostPinned, size);
+            jit_memcpy_async(JitBackend::CUDA, d_motion, data.get(), size);
+            d_motion = jit_malloc_migrate(d_motion, AllocType::Device, 1);
+            m_optix_motion_transforms.push_back(d_motion);
+
+            OptixTraversableHandle handle;
+            jit_optix_check(optixConvertPointerToTraversableHandle(
+                context, (CUdeviceptr) d_motion,
+                OPTIX_TRAVERSABLE_TYPE_MATRIX_MOTION_TRANSFORM, &handle));
+
+            // The motion transform carries the full transformation
+            instance.traversableHandle = handle;
+        }
     }
 
     virtual void optix_fill_hitgroup_records(std::vector<HitGroupSbtRecord> &,
@@ -296,9 +549,24 @@ public:
         return dr::grad_enabled(m_to_world) || m_shapegroup->parameters_grad_enabled();
     }
 
+#if defined(MI_ENABLE_CUDA)
+    ~Instance() {
+        for (void *ptr : m_optix_motion_transforms)
+            jit_free(ptr);
+    }
+#endif
+
     MI_DECLARE_CLASS()
 private:
    ref<ShapeGroup_> m_shapegroup;
+   /// Keyframes of a time-dependent object-to-world transformation
+   std::vector<ScalarMatrix4f> m_keyframes;
+   /// Ray times of the first and the last keyframe
+   ScalarFloat m_time_begin, m_time_end;
+#if defined(MI_ENABLE_CUDA)
+   /// Device memory of the OptiX matrix motion transforms
+   std::vector<void *> m_optix_motion_transforms;
+#endif
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(Instance, Shape)
@@ -0,0 +1,541 @@
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/thread.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/mesh.h>
+#include <mitsuba/render/shape.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+#if defined(MI_ENABLE_EMBREE)
+    #include <embree3/rtcore.h>
+#else
+    #include <mitsuba/render/kdtree.h>
+#endif
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _shape-lazymesh:
+
+Lazily loaded mesh (:monosp:`lazymesh`)
+---------------------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename of a mesh in the PLY (``.ply``), serialized (``.serialized``),
+     or Wavefront OBJ (``.obj``) format.
+
+ * - memory_budget
+   - |float|
+   - Total amount of memory (in MiB) that the vertex and index buffers of all
+     lazily loaded meshes may occupy. It is shared by all :monosp:`lazymesh`
+     shapes that currently exist; when several of them specify a budget, the
+     smallest value is used. (Default: unlimited)
+
+ * - (Other parameters)
+   - |string|, |float|, |bool|, |transform|
+   - All other parameters (e.g. ``shape_index``, ``face_normals``,
+     ``flip_normals``, or ``to_world``) are forwarded to the plugin that
+     loads the mesh.
+
+This plugin is a proxy for a mesh that is too large to be kept in memory
+together with the rest of the scene. The mesh is loaded once during scene
+construction to record its bounding box, after which its vertex and index
+buffers are released again. The top-level acceleration structure only refers
+to these bounds: the buffers, along with an acceleration structure over the
+triangles, are read back from disk when the first ray enters them.
+
+Once the buffers of all resident meshes exceed ``memory_budget``, the meshes
+that were least recently intersected are evicted (and loaded again when
+needed). Meshes that are being intersected by another thread at the time are
+never evicted, hence the budget can be exceeded temporarily.
+
+.. tabs::
+    .. code-tab:: xml
+        :name: lazymesh
+
+        <shape type="lazymesh">
+            <string name="filename" value="city_block_17.ply"/>
+            <float name="memory_budget" value="4096"/>
+            <bsdf type="diffuse"/>
+        </shape>
+
+    .. code-tab:: python
+
+        'type': 'lazymesh',
+        'filename': 'city_block_17.ply',
+        'memory_budget': 4096,
+        'material': {
+            'type': 'diffuse'
+        }
+
+.. warning::
+
+    - This plugin is only supported in scalar variants. The vectorized
+      variants record ray tracing kernels that access the mesh buffers
+      directly, which requires them to be resident.
+    - Lazily loaded meshes cannot have attached emitters or sensors.
+ */
+
+template <typename Float, typename Spectrum>
+class LazyMesh final : public Shape<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Shape, is_emitter, is_sensor, initialize)
+    MI_IMPORT_TYPES(Mesh, ShapeKDTree)
+
+    using typename Base::ScalarSize;
+    using typename Base::ScalarIndex;
+    using typename Base::ScalarRay3f;
+
+    LazyMesh(const Properties &props) : Base(props) {
+        if constexpr (dr::is_jit_v<Float>)
+            Throw("The \"lazymesh\" plugin is only supported in scalar variants.");
+        if (is_emitter() || is_sensor())
+            Throw("Lazily loaded meshes cannot have attached emitters or sensors.");
+
+        auto fs = Thread::thread()->file_resolver();
+        fs::path file_path = fs->resolve(props.string("filename"));
+        m_name = file_path.filename().string();
+
+        std::string extension = string::to_lower(file_path.extension().string());
+        std::string plugin;
+        if (extension == ".ply")
+            plugin = "ply";
+        else if (extension == ".serialized")
+            plugin = "serialized";
+        else if (extension == ".obj")
+            plugin = "obj";
+        else
+            Throw("Cannot determine the mesh format of \"%s\"!", m_name);
+
+        // Forward all other parameters to the plugin that loads the mesh
+        m_mesh_props = Properties(plugin);
+        m_mesh_props.set_id(props.id());
+        m_mesh_props.set_string("filename", file_path.string());
+        for (const std::string &name : props.property_names()) {
+            if (name == "filename" || name == "memory_budget" ||
+                props.type(name) == Properties::Type::Object)
+                continue;
+            m_mesh_props.copy_attribute(props, name, name);
+            props.mark_queried(name);
+        }
+
+        // Record the bounds, then release the buffers again
+        ref<Mesh> mesh = load_mesh();
+        m_bbox = mesh->bbox();
+        m_face_count = mesh->face_count();
+        m_bytes = mesh->vertex_data_bytes() + mesh->face_data_bytes();
+        if constexpr (!dr::is_jit_v<Float>)
+            m_surface_area = mesh->surface_area();
+        mesh = nullptr;
+
+        if (props.has_property("memory_budget")) {
+            ScalarFloat budget = props.get<ScalarFloat>("memory_budget");
+            if (budget <= 0.f)
+                Throw("The memory budget must be positive!");
+            m_budget = (size_t) (budget * 1024.0 * 1024.0);
+        }
+
+        initialize();
+
+        Cache &c = cache();
+        std::lock_guard<std::mutex> guard(c.mutex);
+        c.proxies.push_back(this);
+        c.budget = std::min(c.budget, m_budget);
+    }
+
+    ~LazyMesh() {
+        Cache &c = cache();
+        std::lock_guard<std::mutex> guard(c.mutex);
+        auto it = std::find(c.resident.begin(), c.resident.end(), this);
+        if (it != c.resident.end()) {
+            c.resident.erase(it);
+            c.used -= m_bytes;
+        }
+        release();
+
+        // The budgets of destroyed shapes (and their scenes) no longer apply
+        c.proxies.erase(std::find(c.proxies.begin(), c.proxies.end(), this));
+        c.budget = (size_t) -1;
+        for (const LazyMesh *shape : c.proxies)
+            c.budget = std::min(c.budget, shape->m_budget);
+
+#if defined(MI_ENABLE_EMBREE)
+        if (m_device)
+            rtcReleaseDevice(m_device);
+#endif
+    }
+
+    // =============================================================
+    //! @{ \name Bounding box and primitive information
+    // =============================================================
+
+    ScalarBoundingBox3f bbox() const override { return m_bbox; }
+
+    Float surface_area() const override { return m_surface_area; }
+
+    ScalarSize primitive_count() const override { return 1; }
+
+    ScalarSize effective_primitive_count() const override { return m_face_count; }
+
+    //! @}
+    // =============================================================
+
+    // =============================================================
+    //! @{ \name Ray tracing routines
+    // =============================================================
+
+    template <typename FloatP, typename Ray3fP>
+    std::tuple<FloatP, Point<FloatP, 2>, dr::uint32_array_t<FloatP>,
+               dr::uint32_array_t<FloatP>>
+    ray_intersect_preliminary_impl(const Ray3fP &ray,
+                                   ScalarIndex /*prim_index*/,
+                                   dr::mask_t<FloatP> active) const {
+        MI_MASK_ARGUMENT(active);
+
+        if constexpr (!dr::is_array_v<FloatP>) {
+            auto lock = acquire();
+#if defined(MI_ENABLE_EMBREE)
+            RTCRayHit rh = embree_ray(ray);
+            RTCIntersectContext context;
+            rtcInitIntersectContext(&context);
+            rtcIntersect1(m_scene, &context, &rh);
+            if (rh.hit.geomID == RTC_INVALID_GEOMETRY_ID)
+                return { dr::Infinity<FloatP>, Point<FloatP, 2>(0.f), (uint32_t) -1,
+                         (uint32_t) -1 };
+            return { rh.ray.tfar, Point<FloatP, 2>(rh.hit.u, rh.hit.v),
+                     (uint32_t) -1, rh.hit.primID };
+#else
+            auto pi = m_kdtree->template ray_intersect_scalar<false>(ray);
+            return { pi.t, pi.prim_uv, (uint32_t) -1, pi.prim_index };
+#endif
+        } else {
+            Throw("LazyMesh::ray_intersect_preliminary() should only be called "
+                  "with scalar types.");
+        }
+    }
+
+    template <typename FloatP, typename Ray3fP>
+    dr::mask_t<FloatP> ray_test_impl(const Ray3fP &ray,
+                                     ScalarIndex /*prim_index*/,
+                                     dr::mask_t<FloatP> active) const {
+        MI_MASK_ARGUMENT(active);
+
+        if constexpr (!dr::is_array_v<FloatP>) {
+            auto lock = acquire();
+#if defined(MI_ENABLE_EMBREE)
+            RTCRay ray2 = embree_ray(ray).ray;
+            RTCIntersectContext context;
+            rtcInitIntersectContext(&context);
+            rtcOccluded1(m_scene, &context, &ray2);
+            return ray2.tfar == -dr::Infinity<float>;
+#else
+            return m_kdtree->template ray_intersect_scalar<true>(ray).is_valid();
+#endif
+        } else {
+            Throw("LazyMesh::ray_test() should only be called with scalar types.");
+        }
+    }
+
+    MI_SHAPE_DEFINE_RAY_INTERSECT_METHODS()
+
+    SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
+                                                     const PreliminaryIntersection3f &pi,
+                                                     uint32_t ray_flags,
+                                                     uint32_t recursion_depth,
+                                                     Mask active) const override {
+        MI_MASK_ARGUMENT(active);
+
+        if constexpr (!dr::is_jit_v<Float>) {
+            /* The buffers may have been evicted since the ray was traced.
+               Loading the same file again yields the same primitive indices. */
+            auto lock = acquire();
+            SurfaceInteraction3f si = m_mesh->compute_surface_interaction(
+                ray, pi, ray_flags, recursion_depth, active);
+
+            // The material is assigned to the proxy, not to the loaded mesh
+            si.shape = this;
+            return si;
+        } else {
+            DRJIT_MARK_USED(ray);
+            DRJIT_MARK_USED(pi);
+            DRJIT_MARK_USED(ray_flags);
+            DRJIT_MARK_USED(recursion_depth);
+            Throw("LazyMesh::compute_surface_interaction() is only supported "
+                  "in scalar variants.");
+        }
+    }
+
+    //! @}
+    // =============================================================
+
+#if defined(MI_ENABLE_EMBREE)
+    RTCGeometry embree_geometry(RTCDevice device) override {
+        if constexpr (!dr::is_cuda_v<Float>) {
+            if (m_device != device) {
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                release();
+                if (m_device)
+                    rtcReleaseDevice(m_device);
+                rtcRetainDevice(device);
+                m_device = device;
+            }
+
+            RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_USER);
+            rtcSetGeometryUserPrimitiveCount(geom, 1);
+            rtcSetGeometryUserData(geom, (void *) this);
+            rtcSetGeometryBoundsFunction(geom, embree_bbox, nullptr);
+            rtcSetGeometryIntersectFunction(geom, embree_intersect);
+            rtcSetGeometryOccludedFunction(geom, embree_occluded);
+            rtcCommitGeometry(geom);
+            return geom;
+        } else {
+            DRJIT_MARK_USED(device);
+            Throw("embree_geometry() should only be called in CPU mode.");
+        }
+    }
+#endif
+
+    bool parameters_grad_enabled() const override { return false; }
+
+    std::string to_string() const override {
+        size_t budget;
+        {
+            Cache &c = cache();
+            std::lock_guard<std::mutex> guard(c.mutex);
+            budget = c.budget;
+        }
+
+        std::ostringstream oss;
+        oss << "LazyMesh[" << std::endl
+            << "  name = \"" << m_name << "\"," << std::endl
+            << "  bbox = " << string::indent(m_bbox) << "," << std::endl
+            << "  face_count = " << m_face_count << "," << std::endl
+            << "  resident = " << (m_mesh ? "true" : "false") << "," << std::endl
+            << "  memory_budget = "
+            << (budget == (size_t) -1 ? "unlimited" : util::mem_string(budget))
+            << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+private:
+    /// Bookkeeping of the buffers that are currently loaded (shared by all proxies)
+    struct Cache {
+        std::mutex mutex;
+        /// All existing proxies, whose smallest budget is in effect
+        std::vector<const LazyMesh *> proxies;
+        std::vector<const LazyMesh *> resident;
+        size_t used = 0;
+        size_t budget = (size_t) -1;
+        /// Advanced whenever a mesh is loaded, used to order evictions
+        std::atomic<uint64_t> epoch { 0 };
+    };
+
+    static Cache &cache() {
+        static Cache c;
+        return c;
+    }
+
+    ref<Mesh> load_mesh() const {
+        ref<Mesh> mesh = PluginManager::instance()->create_object<Mesh>(m_mesh_props);
+        if (!mesh)
+            Throw("\"%s\" does not contain a triangle mesh!", m_name);
+        return mesh;
+    }
+
+    /**
+     * \brief Ensure that the buffers are resident and prevent their eviction
+     * for as long as the returned lock is held.
+     */
+    std::shared_lock<std::shared_mutex> acquire() const {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        while (unlikely(!m_mesh)) {
+            lock.unlock();
+            {
+                std::unique_lock<std::shared_mutex> guard(m_mutex);
+                if (!m_mesh)
+                    load();
+            }
+            // The buffers could have been evicted again in the meantime
+            lock.lock();
+        }
+        m_last_use.store(cache().epoch.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+        return lock;
+    }
+
+    /// Load the buffers and evict others if needed (with \c m_mutex held)
+    void load() const {
+        Log(Debug, "Loading lazily referenced mesh \"%s\" ..", m_name);
+        ref<Mesh> mesh = load_mesh();
+
+#if defined(MI_ENABLE_EMBREE)
+        if (!m_device)
+            Throw("LazyMesh: the mesh was intersected before the scene was built!");
+        RTCGeometry geom = mesh->embree_geometry(m_device);
+        m_scene = rtcNewScene(m_device);
+        rtcAttachGeometry(m_scene, geom);
+        rtcReleaseGeometry(geom);
+        rtcCommitScene(m_scene);
+#else
+        m_kdtree = new ShapeKDTree(Properties());
+        m_kdtree->add_shape(mesh.get());
+        m_kdtree->build();
+#endif
+        m_mesh = mesh;
+
+        Cache &c = cache();
+        std::lock_guard<std::mutex> guard(c.mutex);
+        m_last_use.store(++c.epoch, std::memory_order_relaxed);
+        c.resident.push_back(this);
+        c.used += m_bytes;
+
+        if (c.used <= c.budget)
+            return;
+
+        // Evict the least recently used meshes that are not currently in use
+        std::sort(c.resident.begin(), c.resident.end(),
+                  [](const LazyMesh *a, const LazyMesh *b) {
+                      return a->m_last_use.load(std::memory_order_relaxed) <
+                             b->m_last_use.load(std::memory_order_relaxed);
+                  });
+
+        for (size_t i = 0; i < c.resident.size() && c.used > c.budget;) {
+            const LazyMesh *shape = c.resident[i];
+            if (shape != this && shape->m_mutex.try_lock()) {
+                Log(Debug, "Evicting lazily referenced mesh \"%s\"", shape->m_name);
+                shape->release();
+                shape->m_mutex.unlock();
+                c.used -= shape->m_bytes;
+                c.resident.erase(c.resident.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    /// Release the buffers (with \c m_mutex held)
+    void release() const {
+#if defined(MI_ENABLE_EMBREE)
+        if (m_scene) {
+            rtcReleaseScene(m_scene);
+            m_scene = nullptr;
+        }
+#else
+        m_kdtree = nullptr;
+#endif
+        m_mesh = nullptr;
+    }
+
+#if defined(MI_ENABLE_EMBREE)
+    static RTCRayHit embree_ray(const ScalarRay3f &ray) {
+        RTCRayHit rh;
+        rh.ray.org_x = (float) ray.o.x();
+        rh.ray.org_y = (float) ray.o.y();
+        rh.ray.org_z = (float) ray.o.z();
+        rh.ray.tnear = 0.f;
+        rh.ray.dir_x = (float) ray.d.x();
+        rh.ray.dir_y = (float) ray.d.y();
+        rh.ray.dir_z = (float) ray.d.z();
+        rh.ray.time  = (float) ray.time;
+        rh.ray.tfar  = (float) ray.maxt;
+        rh.ray.mask  = (unsigned int) -1;
+        rh.ray.id    = 0;
+        rh.ray.flags = 0;
+        rh.hit.geomID = RTC_INVALID_GEOMETRY_ID;
+        rh.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
+        return rh;
+    }
+
+    static void embree_bbox(const RTCBoundsFunctionArguments *args) {
+        const LazyMesh *shape = (const LazyMesh *) args->geometryUserPtr;
+        RTCBounds *bounds = args->bounds_o;
+        bounds->lower_x = (float) shape->m_bbox.min.x();
+        bounds->lower_y = (float) shape->m_bbox.min.y();
+        bounds->lower_z = (float) shape->m_bbox.min.z();
+        bounds->upper_x = (float) shape->m_bbox.max.x();
+        bounds->upper_y = (float) shape->m_bbox.max.y();
+        bounds->upper_z = (float) shape->m_bbox.max.z();
+    }
+
+    /* Unlike the generic user geometry callbacks, these forward the index of
+       the intersected triangle, which compute_surface_interaction() needs. */
+    static void embree_intersect(const RTCIntersectFunctionNArguments *args) {
+        if (args->N != 1)
+            Throw("LazyMesh: only single ray queries are supported!");
+        if (!args->valid[0])
+            return;
+
+        const LazyMesh *shape = (const LazyMesh *) args->geometryUserPtr;
+        RTCRayHit *rh = (RTCRayHit *) args->rayhit;
+        RTCRayHit rh2 = *rh;
+        rh2.hit.geomID = rh2.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
+
+        auto lock = shape->acquire();
+        RTCIntersectContext context;
+        rtcInitIntersectContext(&context);
+        rtcIntersect1(shape->m_scene, &context, &rh2);
+
+        if (rh2.hit.geomID != RTC_INVALID_GEOMETRY_ID) {
+            rh->ray.tfar = rh2.ray.tfar;
+            rh->hit = rh2.hit;
+            rh->hit.geomID = args->geomID;
+            rh->hit.instID[0] = args->context->instID[0];
+        }
+    }
+
+    static void embree_occluded(const RTCOccludedFunctionNArguments *args) {
+        if (args->N != 1)
+            Throw("LazyMesh: only single ray queries are supported!");
+        if (!args->valid[0])
+            return;
+
+        const LazyMesh *shape = (const LazyMesh *) args->geometryUserPtr;
+        RTCRay *ray = (RTCRay *) args->ray;
+        RTCRay ray2 = *ray;
+
+        auto lock = shape->acquire();
+        RTCIntersectContext context;
+        rtcInitIntersectContext(&context);
+        rtcOccluded1(shape->m_scene, &context, &ray2);
+
+        if (ray2.tfar == -dr::Infinity<float>)
+            ray->tfar = -dr::Infinity<float>;
+    }
+#endif
+
+private:
+    std::string m_name;
+    Properties m_mesh_props;
+    ScalarBoundingBox3f m_bbox;
+    ScalarFloat m_surface_area = 0.f;
+    ScalarSize m_face_count = 0;
+    size_t m_bytes = 0;
+    size_t m_budget = (size_t) -1;
+
+    /// Resident state, guarded by \c m_mutex
+    mutable std::shared_mutex m_mutex;
+    mutable std::atomic<uint64_t> m_last_use { 0 };
+    mutable ref<Mesh> m_mesh;
+#if defined(MI_ENABLE_EMBREE)
+    RTCDevice m_device = nullptr;
+    mutable RTCScene m_scene = nullptr;
+#else
+    mutable ref<ShapeKDTree> m_kdtree;
+#endif
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(LazyMesh, Shape)
+MI_EXPORT_PLUGIN(LazyMesh, "Lazily loaded mesh")
+NAMESPACE_END(mitsuba)
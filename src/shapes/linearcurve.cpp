@@ -38,6 +38,12 @@ Linear curve (:monosp:`linearcurve`)
    - Specifies a linear object-to-world transformation. Note that the control
      points' raddii are invariant to this transformation!
 
+ * - split_ratio
+   - |float|
+   - Segments whose axis-aligned bounding box is more than this many times
+     larger than the segment itself are split into shorter ones. (Default: 0,
+     i.e. no splitting)
+
  * - control_point_count
    - |int|
    - Total number of control points
@@ -68,6 +74,20 @@ segments are connected by a smooth spherical joint, and they are also
 terminated by a spherical endcap. This shape should always be preferred over
 curve approximations modeled using triangles.
 
+Scalar variants built without Embree intersect the curves exactly with the
+native kd-tree, which uses tight bounds of the parts of the segments that
+overlap its nodes.
+
+Long diagonal segments (e.g. of groomed hair) only fill a small fraction of
+their axis-aligned bounding boxes, which are then tested by many rays that
+miss them. Setting ``split_ratio`` inserts control points that interpolate
+such segments, so that every part of a segment has a tighter box; the curves
+themselves remain unchanged. Their number of segments grows
+accordingly, which also affects the ``segment_indices`` and ``control_points``
+parameters and the ``v`` texture coordinate. Embree already bounds curves
+with oriented boxes, hence splitting is mostly beneficial for the other
+backends.
+
 Although it is possible to define multiple curves as multiple separate objects,
 this plugin was intended to be used as an aggregate of curves. Of course,
 if the individual curves need different materials or other individual
@@ -132,12 +152,6 @@ public:
     using Index = typename CoreAliases::UInt32;
 
     LinearCurve(const Properties &props) : Base(props) {
-#if !defined(MI_ENABLE_EMBREE)
-        if constexpr (!dr::is_jit_v<Float>)
-            Throw("The linear curve is only available with Embree in scalar "
-                  "variants!");
-#endif
-
         auto fs = Thread::thread()->file_resolver();
         fs::path file_path = fs->resolve(props.string("filename"));
         std::string m_name = file_path.filename().string();
@@ -245,6 +259,16 @@ public:
             fail("Empty curve file: no control points were read!");
         finish_curve();
 
+        ScalarFloat split_ratio = props.get<ScalarFloat>("split_ratio", 0.f);
+        if (split_ratio < 0.f)
+            fail("\"split_ratio\" must be non-negative!");
+        if (split_ratio > 0.f) {
+            size_t original_count = segment_count;
+            segment_count = split_segments(vertices, radius, curve_1st_idx, split_ratio);
+            Log(Debug, "\"%s\": split %zu segments into %zu", m_name,
+                original_count, segment_count);
+        }
+
         m_control_point_count = (ScalarSize) vertices.size();
 
         std::unique_ptr<ScalarIndex[]> indices = std::make_unique<ScalarIndex[]>(segment_count);
@@ -283,6 +307,7 @@ public:
                 m_control_points[i * 4 + 3] = radius_buffer[i * 1 + 0];
             }
         }
+        dr::eval(m_control_points); // Host access by the native kd-tree
 
         // Compute bounding box
         m_bbox.reset();
@@ -312,6 +337,97 @@ public:
 
     ScalarSize primitive_count() const override { return (ScalarSize) dr::width(m_indices); }
 
+    ScalarBoundingBox3f bbox(ScalarIndex index) const override {
+        if constexpr (dr::is_cuda_v<Float>)
+            NotImplementedError("bbox(ScalarIndex index)");
+
+        const InputFloat *cp = control_points_ptr(index);
+        ScalarBoundingBox3f bbox;
+        for (size_t i = 0; i < 2; ++i) {
+            ScalarPoint3f p(cp[4 * i + 0], cp[4 * i + 1], cp[4 * i + 2]);
+            ScalarFloat r(cp[4 * i + 3]);
+            bbox.expand(p - r);
+            bbox.expand(p + r);
+        }
+        return bbox;
+    }
+
+    ScalarBoundingBox3f bbox(ScalarIndex index,
+                             const ScalarBoundingBox3f &clip) const override {
+        if constexpr (dr::is_cuda_v<Float>)
+            NotImplementedError("bbox(ScalarIndex index, const ScalarBoundingBox3f &clip)");
+
+        const InputFloat *cp = control_points_ptr(index);
+        ScalarPoint3f c0(cp[0], cp[1], cp[2]), c1(cp[4], cp[5], cp[6]);
+        ScalarFloat r0(cp[3]), r1(cp[7]);
+
+        /* Spheres whose centers lie outside of the clip box enlarged by the
+           maximum radius cannot overlap it. Clipping the axis accordingly only
+           requires bounding the two spheres at the ends of the clipped part,
+           since centers and radii interpolate linearly. */
+        ScalarFloat r_max = dr::maximum(r0, r1);
+        ScalarBoundingBox3f enlarged(clip.min - r_max, clip.max + r_max);
+
+        ScalarFloat t0, t1;
+        ScalarBoundingBox3f result;
+        if (!clip_segment(c0, c1, enlarged, t0, t1))
+            return result;
+
+        for (ScalarFloat t : { t0, t1 }) {
+            ScalarPoint3f p = dr::lerp(c0, c1, t);
+            ScalarFloat r = dr::lerp(r0, r1, t);
+            result.expand(p - r);
+            result.expand(p + r);
+        }
+        result.clip(clip);
+        return result;
+    }
+
+    // =============================================================
+    //! @{ \name Ray tracing routines
+    // =============================================================
+
+    template <typename FloatP, typename Ray3fP>
+    std::tuple<FloatP, Point<FloatP, 2>, dr::uint32_array_t<FloatP>,
+               dr::uint32_array_t<FloatP>>
+    ray_intersect_preliminary_impl(const Ray3fP &ray,
+                                   ScalarIndex prim_index,
+                                   dr::mask_t<FloatP> active) const {
+        MI_MASK_ARGUMENT(active);
+        if constexpr (!dr::is_array_v<FloatP> && !dr::is_cuda_v<Float>) {
+            const InputFloat *cp = control_points_ptr(prim_index);
+            auto [t, v] = round_cone_intersect(
+                ray, ScalarPoint3f(cp[0], cp[1], cp[2]), cp[3],
+                ScalarPoint3f(cp[4], cp[5], cp[6]), cp[7]);
+            return { t, Point<FloatP, 2>(v, 0.f), ((uint32_t) -1), prim_index };
+        } else {
+            Throw("LinearCurve::ray_intersect_preliminary() should only be "
+                  "called with scalar types by the native kd-tree.");
+        }
+    }
+
+    template <typename FloatP, typename Ray3fP>
+    dr::mask_t<FloatP> ray_test_impl(const Ray3fP &ray,
+                                     ScalarIndex prim_index,
+                                     dr::mask_t<FloatP> active) const {
+        MI_MASK_ARGUMENT(active);
+        if constexpr (!dr::is_array_v<FloatP> && !dr::is_cuda_v<Float>) {
+            const InputFloat *cp = control_points_ptr(prim_index);
+            return round_cone_intersect(
+                       ray, ScalarPoint3f(cp[0], cp[1], cp[2]), cp[3],
+                       ScalarPoint3f(cp[4], cp[5], cp[6]), cp[7]).first !=
+                   dr::Infinity<ScalarFloat>;
+        } else {
+            Throw("LinearCurve::ray_test() should only be called with scalar "
+                  "types by the native kd-tree.");
+        }
+    }
+
+    MI_SHAPE_DEFINE_RAY_INTERSECT_METHODS()
+
+    //! @}
+    // =============================================================
+
     SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
                                                      const PreliminaryIntersection3f &pi,
                                                      uint32_t ray_flags,
@@ -468,6 +584,208 @@ private:
         *start_ = start;
     }
 
+    /// Host pointer to the two control points of a segment
+    const InputFloat *control_points_ptr(ScalarIndex index) const {
+        return m_control_points.data() + 4 * m_indices.data()[index];
+    }
+
+    /// Maximum number of parts a segment is split into by \ref split_segments()
+    static constexpr size_t MaxSegmentSplits = 16;
+
+    /**
+     * \brief Number of equal parts into which the segment from <tt>(c0, r0)</tt>
+     * to <tt>(c1, r1)</tt> must be split so that their bounding boxes are at
+     * most \c ratio times larger than the segment
+     */
+    static size_t split_count(const InputPoint3f &c0, InputFloat r0,
+                              const InputPoint3f &c1, InputFloat r1,
+                              ScalarFloat ratio) {
+        ScalarVector3f d = dr::abs(ScalarVector3f(c1 - c0));
+        ScalarFloat r_max = dr::maximum(r0, r1);
+        if (!(r_max > 0.f))
+            return 1;
+
+        // Truncated cone (approximating the swept spheres) and an end cap
+        ScalarFloat volume =
+            dr::Pi<ScalarFloat> * (dr::norm(d) * (r0 * r0 + r0 * r1 + r1 * r1) / 3.f +
+                                   4.f / 3.f * r_max * r_max * r_max);
+
+        for (size_t parts = 1; parts < MaxSegmentSplits; ++parts) {
+            ScalarVector3f extent = d / (ScalarFloat) parts + 2.f * r_max;
+            if ((ScalarFloat) parts * dr::prod(extent) <= ratio * volume)
+                return parts;
+        }
+        return MaxSegmentSplits;
+    }
+
+    /**
+     * \brief Split the segments whose bounding box is more than \c ratio
+     * times larger than the segment itself
+     *
+     * The inserted control points linearly interpolate the segments, so that
+     * the curves are unchanged. Returns the new number of segments.
+     */
+    static size_t split_segments(std::vector<InputPoint3f> &vertices,
+                                 std::vector<InputFloat> &radius,
+                                 std::vector<size_t> &curve_1st_idx,
+                                 ScalarFloat ratio) {
+        std::vector<InputPoint3f> new_vertices;
+        std::vector<InputFloat> new_radius;
+        new_vertices.reserve(vertices.size());
+        new_radius.reserve(vertices.size());
+
+        size_t segment_count = 0;
+        for (size_t i = 0; i < curve_1st_idx.size(); ++i) {
+            size_t begin = curve_1st_idx[i],
+                   end = i + 1 < curve_1st_idx.size() ? curve_1st_idx[i + 1]
+                                                      : vertices.size();
+            curve_1st_idx[i] = new_vertices.size();
+
+            for (size_t j = begin; j < end; ++j) {
+                if (j > begin) {
+                    size_t parts = split_count(vertices[j - 1], radius[j - 1],
+                                               vertices[j], radius[j], ratio);
+                    for (size_t k = 1; k < parts; ++k) {
+                        InputFloat t = (InputFloat) k / (InputFloat) parts;
+                        new_vertices.push_back(dr::lerp(vertices[j - 1], vertices[j], t));
+                        new_radius.push_back(dr::lerp(radius[j - 1], radius[j], t));
+                    }
+                    segment_count += parts;
+                }
+                new_vertices.push_back(vertices[j]);
+                new_radius.push_back(radius[j]);
+            }
+        }
+
+        vertices.swap(new_vertices);
+        radius.swap(new_radius);
+        return segment_count;
+    }
+
+    /**
+     * \brief Clip the segment from \c c0 to \c c1 against a bounding box
+     *
+     * Returns \c false when they do not overlap, and otherwise the
+     * parameter range <tt>[t0, t1]</tt> of the segment inside the box.
+     */
+    static bool clip_segment(const ScalarPoint3f &c0, const ScalarPoint3f &c1,
+                             const ScalarBoundingBox3f &bbox, ScalarFloat &t0,
+                             ScalarFloat &t1) {
+        t0 = 0.f;
+        t1 = 1.f;
+        ScalarVector3f d = c1 - c0;
+        for (size_t k = 0; k < 3; ++k) {
+            if (d[k] == 0.f) {
+                if (c0[k] < bbox.min[k] || c0[k] > bbox.max[k])
+                    return false;
+                continue;
+            }
+            ScalarFloat inv_d = dr::rcp(d[k]),
+                        ta = (bbox.min[k] - c0[k]) * inv_d,
+                        tb = (bbox.max[k] - c0[k]) * inv_d;
+            t0 = dr::maximum(t0, dr::minimum(ta, tb));
+            t1 = dr::minimum(t1, dr::maximum(ta, tb));
+        }
+        return t0 <= t1;
+    }
+
+    /**
+     * \brief Intersect a ray with the surface swept by a sphere whose center
+     * and radius interpolate linearly from <tt>(c0, r0)</tt> to <tt>(c1, r1)</tt>
+     *
+     * The surface consists of the two spheres and of the truncated cone that
+     * is tangent to both of them. Like in Embree and OptiX, back faces are
+     * culled. Returns the hit distance (or infinity) and the segment-local
+     * parameter of the sphere that touches the surface at the hit point.
+     * The computation is done in double precision relative to the point of
+     * the ray that is closest to \c c0.
+     */
+    static std::pair<ScalarFloat, ScalarFloat>
+    round_cone_intersect(const ScalarRay3f &ray, const ScalarPoint3f &c0_,
+                         ScalarFloat r0, const ScalarPoint3f &c1_,
+                         ScalarFloat r1) {
+        using Vector3d = Vector<double, 3>;
+
+        Vector3d d(ray.d);
+        double dd = dr::squared_norm(d),
+               t_shift = dr::dot(Vector3d(c0_) - Vector3d(ray.o), d) / dd;
+        Vector3d o = Vector3d(ray.o) + t_shift * d;
+
+        // Admissible range of the hit distance relative to 'o'
+        double t_min = -t_shift, t_best = double(ray.maxt) - t_shift, v_best = 0.0;
+        bool found = false;
+
+        Vector3d c0 = Vector3d(c0_) - o, c1 = Vector3d(c1_) - o;
+
+        // Spheres at both ends (only the entering intersection counts)
+        for (int i = 0; i < 2; ++i) {
+            const Vector3d &c = i == 0 ? c0 : c1;
+            double r = double(i == 0 ? r0 : r1),
+                   b = dr::dot(c, d),
+                   disc = b * b - dd * (dr::squared_norm(c) - r * r);
+            if (disc < 0.0)
+                continue;
+            double t = (b - dr::sqrt(disc)) / dd;
+            if (t > t_min && t < t_best) {
+                t_best = t;
+                v_best = i;
+                found = true;
+            }
+        }
+
+        /* Cone tangent to both spheres: a point at axial position 'h' and
+           distance 'rho' from the axis lies on it when rho = k (r0 + dr * h)
+           with k = 1 / sqrt(1 - dr^2). It touches the sphere centered at the
+           axial position s = k^2 (h + r0 * dr). */
+        Vector3d axis = c1 - c0;
+        double length = dr::norm(axis);
+        double slope = (double(r1) - double(r0)) / length;
+        if (length > 0.0 && dr::abs(slope) < 1.0) {
+            axis /= length;
+            double k2 = 1.0 / (1.0 - slope * slope);
+
+            Vector3d q = -c0;
+            double h0 = dr::dot(q, axis), hd = dr::dot(d, axis),
+                   w0 = double(r0) + slope * h0, wd = slope * hd;
+
+            double A = dd - hd * hd - k2 * wd * wd,
+                   B = dr::dot(q, d) - h0 * hd - k2 * w0 * wd,
+                   C = dr::squared_norm(q) - h0 * h0 - k2 * w0 * w0;
+
+            double disc = B * B - A * C;
+            if (A != 0.0 && disc >= 0.0) {
+                double sq = dr::sqrt(disc),
+                       ta = (-B - sq) / A,
+                       tb = (-B + sq) / A;
+                if (ta > tb)
+                    std::swap(ta, tb);
+
+                for (double t : { ta, tb }) {
+                    if (!(t > t_min && t < t_best))
+                        continue;
+                    double h = h0 + t * hd;
+                    if (double(r0) + slope * h < 0.0)
+                        continue; // Other nappe of the cone
+                    double s = k2 * (h + double(r0) * slope);
+                    if (s < 0.0 || s > length)
+                        continue;
+                    // Cull back faces
+                    Vector3d n = q + t * d - s * axis;
+                    if (dr::dot(n, d) >= 0.0)
+                        continue;
+                    t_best = t;
+                    v_best = s / length;
+                    found = true;
+                    break;
+                }
+            }
+        }
+
+        if (!found)
+            return { dr::Infinity<ScalarFloat>, 0.f };
+        return { ScalarFloat(t_best + t_shift), ScalarFloat(v_best) };
+    }
+
     void recompute_bbox() {
         auto&& control_points = dr::migrate(m_control_points, AllocType::Host);
         if constexpr (dr::is_jit_v<Float>)
@@ -0,0 +1,162 @@
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/render/shape.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _shape-lod:
+
+Level of detail (:monosp:`lod`)
+-------------------------------
+
+.. pluginparameters::
+
+ * - (Nested plugins)
+   - |shape|
+   - Two or more versions of the same object, ordered from the finest to the
+     coarsest level of detail. They are sorted by name, e.g. ``level_0``,
+     ``level_1``, etc.
+
+ * - pixel_sizes
+   - |string|
+   - Comma-separated list with the minimum size (in pixels) that the object must
+     cover on the film for each level to be used. The list may omit the value of
+     the coarsest level, which is used for all smaller sizes.
+
+This plugin bundles several versions of an object, of which only one becomes
+part of the scene. When the scene is loaded, it estimates the size of the
+object on the film of its first sensor from the bounding sphere of the finest
+level, and keeps the finest level whose value of ``pixel_sizes`` does not exceed
+it. The other levels are never added to the acceleration data structures.
+When the first sensor is not a projective camera (e.g. a
+:ref:`radiancemeter <sensor-radiancemeter>`), the finest level is used.
+
+The levels are selected only once, and must be direct children of the scene
+(i.e. not of a :ref:`shape group <shape-shapegroup>`). Parameters such as a
+BSDF or a transformation must be specified on the levels themselves.
+
+The same view of the scene also allows skipping shapes that lie outside of it:
+when the scene sets the ``view_culling`` parameter to ``true``, the shapes that
+specify ``view_cullable`` as ``true`` are removed from the scene when their
+bounding box lies completely outside of the view frustum of the first sensor.
+The frustum is dilated by the fraction ``view_culling_margin`` (default: 0.1) of
+the film on every side. This is only correct for shapes that do not affect the
+lighting of the visible parts of the scene (e.g. through shadows or
+interreflections), which is why culling must be requested for every shape.
+Emitters and sensors are never culled.
+
+.. tabs::
+    .. code-tab:: xml
+        :name: lod
+
+        <shape type="lod">
+            <string name="pixel_sizes" value="200, 20"/>
+            <shape type="ply" name="level_0">
+                <string name="filename" value="tree_high.ply"/>
+            </shape>
+            <shape type="ply" name="level_1">
+                <string name="filename" value="tree_medium.ply"/>
+            </shape>
+            <shape type="ply" name="level_2">
+                <string name="filename" value="tree_low.ply"/>
+            </shape>
+        </shape>
+
+    .. code-tab:: python
+
+        'type': 'lod',
+        'pixel_sizes': '200, 20',
+        'level_0': {
+            'type': 'ply',
+            'filename': 'tree_high.ply'
+        },
+        'level_1': {
+            'type': 'ply',
+            'filename': 'tree_medium.ply'
+        },
+        'level_2': {
+            'type': 'ply',
+            'filename': 'tree_low.ply'
+        }
+ */
+
+template <typename Float, typename Spectrum>
+class LODShape final : public Shape<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Shape)
+    MI_IMPORT_TYPES()
+
+    using typename Base::ScalarSize;
+
+    LODShape(const Properties &props) {
+        // Note: we are *not* calling the `Shape` constructor, since the
+        // parameters of the levels are specified on the levels themselves.
+        for (auto [unused, obj] : props.objects()) {
+            Base *shape = dynamic_cast<Base *>(obj.get());
+            if (!shape)
+                Throw("A lod shape can only contain shapes.");
+            if (shape->is_shapegroup())
+                Throw("A lod shape cannot contain shape groups.");
+            m_levels.emplace_back(shape, 0.f);
+        }
+
+        if (m_levels.size() < 2)
+            Throw("A lod shape must contain at least two levels.");
+
+        std::vector<std::string> sizes =
+            string::tokenize(props.get<std::string>("pixel_sizes"), " ,");
+        if (sizes.size() != m_levels.size() && sizes.size() + 1 != m_levels.size())
+            Throw("\"pixel_sizes\": expected %zu or %zu values, got %zu.",
+                  m_levels.size() - 1, m_levels.size(), sizes.size());
+
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            try {
+                m_levels[i].second = string::stof<ScalarFloat>(sizes[i]);
+            } catch (...) {
+                Throw("Could not parse floating point value '%s'", sizes[i]);
+            }
+            if (i > 0 && m_levels[i].second > m_levels[i - 1].second)
+                Throw("\"pixel_sizes\": the values must be decreasing.");
+        }
+
+        if constexpr (dr::is_jit_v<Float>)
+            jit_registry_put(dr::backend_v<Float>, "mitsuba::Shape", this);
+    }
+
+    std::vector<std::pair<ref<Base>, ScalarFloat>> lod_levels() const override {
+        return m_levels;
+    }
+
+    ScalarBoundingBox3f bbox() const override {
+        ScalarBoundingBox3f bbox;
+        for (const auto &[level, size] : m_levels)
+            bbox.expand(level->bbox());
+        return bbox;
+    }
+
+    ScalarSize primitive_count() const override { return 0; }
+
+    ScalarSize effective_primitive_count() const override { return 0; }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "LODShape[" << std::endl
+            << "  levels = [" << std::endl;
+        for (const auto &[level, size] : m_levels)
+            oss << "    " << string::indent(level.get(), 4) << " (" << size
+                << " pixels)," << std::endl;
+        oss << "  ]" << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+private:
+    std::vector<std::pair<ref<Base>, ScalarFloat>> m_levels;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(LODShape, Shape)
+MI_EXPORT_PLUGIN(LODShape, "Level of detail shape");
+NAMESPACE_END(mitsuba)
@@ -13,7 +13,9 @@ public:
     MergeShape(const Properties &props) {
         // Note: we are *not* calling the `Shape` constructor as we do not
         // want to accept various properties such as `to_world`.
-        std::unordered_map<Key, ref<Mesh>, key_hasher> tbl;
+        // Group the meshes by their key (in the order of their first occurrence)
+        std::unordered_map<Key, size_t, key_hasher> tbl;
+        std::vector<std::vector<const Mesh *>> groups;
         size_t visited = 0, ignored = 0;
         Timer timer;
 
@@ -36,21 +38,27 @@ public:
             key.has_texcoords = mesh->has_vertex_texcoords();
             key.has_face_normals = mesh->has_face_normals();
 
-            auto [it, success] = tbl.try_emplace(key, mesh);
-            if (!success)
-                it->second = it->second->merge(mesh);
+            auto [it, success] = tbl.try_emplace(key, groups.size());
+            if (success)
+                groups.emplace_back();
+            groups[it->second].push_back(mesh.get());
 
             visited++;
         }
 
-        for (auto &kv : tbl) {
-            if (tbl.size() == 1)
-                kv.second->set_id(props.id());
-            m_objects.push_back((ref<Object>) kv.second);
+        /* Merge every group in a single pass, which allocates the output
+           buffers once (the inputs stay alive through 'props') */
+        for (auto &group : groups) {
+            ref<Mesh> merged = group.size() == 1
+                                   ? ref<Mesh>(const_cast<Mesh *>(group[0]))
+                                   : Mesh::merge(group);
+            if (groups.size() == 1)
+                merged->set_id(props.id());
+            m_objects.push_back((ref<Object>) merged);
         }
 
         Log(Info, "Collapsed %zu into %zu meshes. (took %s, %zu objects ignored)",
-            visited, tbl.size(), util::time_string((float) timer.value()), ignored);
+            visited, groups.size(), util::time_string((float) timer.value()), ignored);
 
         if constexpr (dr::is_jit_v<Float>)
             jit_registry_put(dr::backend_v<Float>, "mitsuba::Shape", this);
@@ -7,7 +7,10 @@
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/profiler.h>
 
+#include <nanothread/nanothread.h>
 #include <array>
+#include <atomic>
+#include <limits>
 
 
 NAMESPACE_BEGIN(mitsuba)
@@ -32,6 +35,30 @@ Wavefront OBJ mesh loader (:monosp:`obj`)
      discarded and *face normals* will instead be used during rendering.
      This gives the rendered object a faceted appearance. (Default: |false|)
 
+ * - solid_angle_sampling
+   - |bool|
+   - When set to |true| and the mesh is an emitter, directions towards it
+     are sampled by choosing a triangle by area and then uniformly sampling
+     the solid angle it subtends. This reduces noise near large emitters.
+     (Default: |false|)
+
+ * - compact_vertices
+   - |bool|
+   - When set to |true|, vertex normals are stored in a 32 bit octahedral
+     encoding and texture coordinates are quantized to 16 bits per component,
+     which reduces the memory footprint of large meshes. Normals and texture
+     coordinates are then no longer exposed as (differentiable) parameters.
+     (Default: |false|)
+
+ * - interleaved_vertices
+   - |bool|
+   - When set to |true|, scalar variants additionally store the position,
+     normal and texture coordinates of every vertex next to each other, which
+     improves the cache behavior of ray intersections and surface interaction
+     queries on large meshes at the cost of a second copy of the vertex data.
+     It is ignored by the JIT variants and cannot be combined with
+     ``compact_vertices``. (Default: |false|)
+
  * - flip_tex_coords
    - |bool|
    - Treat the vertical component of the texture as inverted? Most OBJ files use this convention. (Default: |true|)
@@ -168,18 +195,45 @@ public:
 
         using ScalarIndex3 = std::array<ScalarIndex, 3>;
 
+        /* Unique (position, texcoord, normal) index triplet. Bindings are
+           chained into per-position lock-free lists, which are built
+           concurrently by all threads. */
         struct VertexBinding {
             ScalarIndex3 key {{ 0, 0, 0 }};
+            /// Global index of the first face corner referencing this binding
+            std::atomic<size_t> first { 0 };
             ScalarIndex value { 0 };
             VertexBinding *next { nullptr };
         };
 
-        /// Temporary buffers for vertices, normals, and texture coordinates
-        std::vector<InputVector3f> vertices;
-        std::vector<InputNormal3f> normals;
-        std::vector<InputVector2f> texcoords;
-        std::vector<ScalarIndex3> triangles;
-        std::vector<VertexBinding> vertex_map;
+        /// Per-chunk output of the parser
+        struct Chunk {
+            const char *begin, *end;
+
+            /// Temporary buffers for vertices, normals, and texture coordinates
+            std::vector<InputVector3f> vertices;
+            std::vector<InputNormal3f> normals;
+            std::vector<InputVector2f> texcoords;
+
+            /// Index triplets of all face corners in file order
+            std::vector<ScalarIndex3> corners;
+            /// Triangles, in terms of chunk-local corner indices
+            std::vector<ScalarIndex3> triangles;
+            /// Vertex binding of every face corner
+            std::vector<VertexBinding *> bindings;
+            /// Storage of the bindings created by this chunk, grown in blocks
+            std::vector<std::unique_ptr<VertexBinding[]>> arena;
+
+            ScalarBoundingBox3f bbox;
+
+            /* Largest difference between a referenced position index and the
+               number of positions in this chunk that precede the reference */
+            int64_t max_excess = std::numeric_limits<int64_t>::min();
+            ScalarIndex max_excess_index = 0;
+
+            size_t vertex_offset = 0, vertex_count = 0, corner_offset = 0,
+                   triangle_offset = 0, value_offset = 0;
+        };
 
  #if !defined(_WIN32)
         ref<MemoryMappedFile> mmap = new MemoryMappedFile(file_path);
@@ -194,165 +248,331 @@ public:
         const char *ptr = tmp.get();
 #endif
 
-        size_t vertex_guess = file_size / 100;
-        const char *eof     = ptr + file_size;
-        char buf[1025];
-
-        vertices.reserve(vertex_guess);
-        normals.reserve(vertex_guess);
-        texcoords.reserve(vertex_guess);
-        triangles.reserve(vertex_guess * 2);
-        vertex_map.resize(vertex_guess);
-
-        ScalarIndex vertex_ctr = 0;
+        const char *eof = ptr + file_size;
 
         Timer timer;
 
-        while (ptr < eof) {
-            // Determine the offset of the next newline
-            const char *next = ptr;
-            advance<false>(&next, eof, "\n");
-
-            // Copy buf into a 0-terminated buffer
-            size_t size = next - ptr;
-            if (size >= sizeof(buf) - 1)
-                fail("file contains an excessively long line! (%i characters)", size);
-            memcpy(buf, ptr, size);
-            buf[size] = '\0';
-
-            // Skip whitespace
-            const char *cur = buf, *eol = buf + size;
-            advance<true>(&cur, eol, " \t\r");
-
-            bool parse_error = false;
-            if (cur[0] == 'v' && (cur[1] == ' ' || cur[1] == '\t')) {
-                // Vertex position
-                InputPoint3f p;
-                cur += 2;
-                for (size_t i = 0; i < 3; ++i) {
-                    const char *orig = cur;
-                    p[i] = string::strtof<InputFloat>(cur, (char **) &cur);
-                    parse_error |= cur == orig;
-                }
-                p = m_to_world.scalar().transform_affine(p);
-                if (unlikely(!all(dr::isfinite(p))))
-                    fail("mesh contains invalid vertex position data");
-                m_bbox.expand(p);
-                vertices.push_back(p);
-            } else if (cur[0] == 'v' && cur[1] == 'n' && (cur[2] == ' ' || cur[2] == '\t')) {
-                if (!m_face_normals) {
-                    cur += 3;
-                    // Vertex normal
-                    InputNormal3f n;
+        /* Split the file into chunks at line boundaries. Small files are
+           parsed by a single thread. */
+        size_t chunk_count = std::max(
+            (size_t) 1, std::min((size_t) pool_size() * 4,
+                                 file_size / (size_t) (1024 * 1024)));
+
+        std::vector<Chunk> chunks(chunk_count);
+        for (size_t i = 0; i < chunk_count; ++i) {
+            const char *begin = i == 0 ? ptr : chunks[i - 1].end;
+            const char *end = eof;
+            if (i + 1 < chunk_count) {
+                end = std::max(begin, ptr + file_size / chunk_count * (i + 1));
+                advance<false>(&end, eof, "\n");
+                if (end < eof)
+                    ++end;
+            }
+            chunks[i].begin = begin;
+            chunks[i].end = end;
+        }
+
+        // Phase 1: parse the chunks independently
+        auto parse_chunk = [&](Chunk &c) {
+            size_t vertex_guess = (c.end - c.begin) / 100;
+            c.vertices.reserve(vertex_guess);
+            c.normals.reserve(vertex_guess);
+            c.texcoords.reserve(vertex_guess);
+            c.corners.reserve(vertex_guess * 2);
+            c.triangles.reserve(vertex_guess * 2);
+
+            const char *line = c.begin;
+            char buf[1025];
+
+            while (line < c.end) {
+                // Determine the offset of the next newline
+                const char *next = line;
+                advance<false>(&next, c.end, "\n");
+
+                // Copy buf into a 0-terminated buffer
+                size_t size = next - line;
+                if (size >= sizeof(buf) - 1)
+                    fail("file contains an excessively long line! (%i characters)", size);
+                memcpy(buf, line, size);
+                buf[size] = '\0';
+
+                // Skip whitespace
+                const char *cur = buf, *eol = buf + size;
+                advance<true>(&cur, eol, " \t\r");
+
+                bool parse_error = false;
+                if (cur[0] == 'v' && (cur[1] == ' ' || cur[1] == '\t')) {
+                    // Vertex position
+                    InputPoint3f p;
+                    cur += 2;
                     for (size_t i = 0; i < 3; ++i) {
                         const char *orig = cur;
-                        n[i] = string::strtof<InputFloat>(cur, (char **) &cur);
+                        p[i] = string::strtof<InputFloat>(cur, (char **) &cur);
                         parse_error |= cur == orig;
                     }
-                    n = dr::normalize(m_to_world.scalar().transform_affine(n));
-                    if (unlikely(!all(dr::isfinite(n))))
-                        fail("mesh contains invalid vertex normal data");
-                    normals.push_back(n);
+                    p = m_to_world.scalar().transform_affine(p);
+                    if (unlikely(!all(dr::isfinite(p))))
+                        fail("mesh contains invalid vertex position data");
+                    c.bbox.expand(p);
+                    c.vertices.push_back(p);
+                } else if (cur[0] == 'v' && cur[1] == 'n' && (cur[2] == ' ' || cur[2] == '\t')) {
+                    if (!m_face_normals) {
+                        cur += 3;
+                        // Vertex normal
+                        InputNormal3f n;
+                        for (size_t i = 0; i < 3; ++i) {
+                            const char *orig = cur;
+                            n[i] = string::strtof<InputFloat>(cur, (char **) &cur);
+                            parse_error |= cur == orig;
+                        }
+                        n = dr::normalize(m_to_world.scalar().transform_affine(n));
+                        if (unlikely(!all(dr::isfinite(n))))
+                            fail("mesh contains invalid vertex normal data");
+                        c.normals.push_back(n);
+                    }
+                } else if (cur[0] == 'v' && cur[1] == 't' && (cur[2] == ' ' || cur[2] == '\t')) {
+                    // Texture coordinate
+                    InputVector2f uv;
+                    cur += 3;
+                    for (size_t i = 0; i < 2; ++i) {
+                        const char *orig = cur;
+                        uv[i] = string::strtof<InputFloat>(cur, (char **) &cur);
+                        parse_error |= cur == orig;
+                    }
+                    if (flip_tex_coords)
+                        uv.y() = 1.f - uv.y();
+
+                    c.texcoords.push_back(uv);
+                } else if (cur[0] == 'f' && (cur[1] == ' ' || cur[1] == '\t')) {
+                    // Face specification
+                    cur += 2;
+                    size_t vertex_index = 0;
+                    size_t type_index = 0;
+                    ScalarIndex3 key {{ (ScalarIndex) 0, (ScalarIndex) 0, (ScalarIndex) 0 }};
+                    ScalarIndex3 tri;
+
+                    while (true) {
+                        const char *next2;
+                        ScalarIndex value = (ScalarIndex) strtoul(cur, (char **) &next2, 10);
+                        if (cur == next2)
+                            break;
+
+                        if (type_index < 3) {
+                            key[type_index] = value;
+                        } else {
+                            parse_error = true;
+                            break;
+                        }
+
+                        while (*next2 == '/') {
+                            type_index++;
+                            next2++;
+                        }
+
+                        if (*next2 == ' ' || *next2 == '\t' || *next2 == '\0' || *next2 == '\r') {
+                            type_index = 0;
+
+                            /* Positions must be defined before they are
+                               referenced. This is checked once the number
+                               of positions in preceding chunks is known. */
+                            int64_t excess = (int64_t) key[0] - (int64_t) c.vertices.size();
+                            if (key[0] == 0)
+                                excess = std::numeric_limits<int64_t>::max();
+                            if (excess > c.max_excess) {
+                                c.max_excess = excess;
+                                c.max_excess_index = key[0];
+                            }
+
+                            ScalarIndex id = (ScalarIndex) c.corners.size();
+                            c.corners.push_back(key);
+
+                            if (vertex_index < 3) {
+                                tri[vertex_index] = id;
+                            } else {
+                                tri[1] = tri[2];
+                                tri[2] = id;
+                            }
+                            vertex_index++;
+
+                            if (vertex_index >= 3)
+                                c.triangles.push_back(tri);
+                        }
+
+                        cur = next2;
+                    }
                 }
-            } else if (cur[0] == 'v' && cur[1] == 't' && (cur[2] == ' ' || cur[2] == '\t')) {
-                // Texture coordinate
-                InputVector2f uv;
-                cur += 3;
-                for (size_t i = 0; i < 2; ++i) {
-                    const char *orig = cur;
-                    uv[i] = string::strtof<InputFloat>(cur, (char **) &cur);
-                    parse_error |= cur == orig;
+
+                if (unlikely(parse_error))
+                    fail("could not parse line \"%s\"", buf);
+                line = next + 1;
+            }
+        };
+
+        auto for_each_chunk = [&](auto func) {
+            dr::parallel_for(
+                dr::blocked_range<size_t>(0, chunk_count, 1),
+                [&](const dr::blocked_range<size_t> &range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i)
+                        func(chunks[i]);
                 }
-                if (flip_tex_coords)
-                    uv.y() = 1.f - uv.y();
-
-                texcoords.push_back(uv);
-            } else if (cur[0] == 'f' && (cur[1] == ' ' || cur[1] == '\t')) {
-                // Face specification
-                cur += 2;
-                size_t vertex_index = 0;
-                size_t type_index = 0;
-                ScalarIndex3 key {{ (ScalarIndex) 0, (ScalarIndex) 0, (ScalarIndex) 0 }};
-                ScalarIndex3 tri;
+            );
+        };
 
-                while (true) {
-                    const char *next2;
-                    ScalarIndex value = (ScalarIndex) strtoul(cur, (char **) &next2, 10);
-                    if (cur == next2)
-                        break;
+        for_each_chunk(parse_chunk);
+
+        // Prefix sums over the per-chunk counts
+        size_t vertex_count = 0, normal_count = 0, texcoord_count = 0,
+               corner_count = 0, triangle_count = 0;
+        for (Chunk &c : chunks) {
+            c.vertex_offset = vertex_count;
+            c.vertex_count = c.vertices.size();
+            c.corner_offset = corner_count;
+            c.triangle_offset = triangle_count;
+
+            if (unlikely(c.max_excess > (int64_t) vertex_count))
+                fail("reference to invalid vertex %i!", c.max_excess_index);
+
+            vertex_count += c.vertices.size();
+            normal_count += c.normals.size();
+            texcoord_count += c.texcoords.size();
+            corner_count += c.corners.size();
+            triangle_count += c.triangles.size();
+            m_bbox.expand(c.bbox);
+        }
 
-                    if (type_index < 3) {
-                        key[type_index] = value;
-                    } else {
-                        parse_error = true;
-                        break;
-                    }
+        if (unlikely(triangle_count > std::numeric_limits<ScalarIndex>::max() / 3 ||
+                     corner_count > std::numeric_limits<ScalarIndex>::max()))
+            fail("mesh is too large!");
 
-                    while (*next2 == '/') {
-                        type_index++;
-                        next2++;
-                    }
+        // Concatenate the attribute buffers
+        std::vector<InputVector3f> vertices;
+        std::vector<InputNormal3f> normals;
+        std::vector<InputVector2f> texcoords;
+        vertices.reserve(vertex_count);
+        normals.reserve(normal_count);
+        texcoords.reserve(texcoord_count);
+        for (Chunk &c : chunks) {
+            vertices.insert(vertices.end(), c.vertices.begin(), c.vertices.end());
+            normals.insert(normals.end(), c.normals.begin(), c.normals.end());
+            texcoords.insert(texcoords.end(), c.texcoords.begin(), c.texcoords.end());
+            std::vector<InputVector3f>().swap(c.vertices);
+            std::vector<InputNormal3f>().swap(c.normals);
+            std::vector<InputVector2f>().swap(c.texcoords);
+        }
 
-                    if (*next2 == ' ' || *next2 == '\t' || *next2 == '\0' || *next2 == '\r') {
-                        type_index = 0;
-                        size_t map_index = key[0] - 1;
+        /* Phase 2: deduplicate index triplets using a concurrent hash table
+           (one lock-free list per vertex position). Every binding records
+           the first corner that references it. */
+        std::unique_ptr<std::atomic<VertexBinding *>[]> vertex_map(
+            new std::atomic<VertexBinding *>[vertex_count]);
+        for (size_t i = 0; i < vertex_count; ++i)
+            vertex_map[i].store(nullptr, std::memory_order_relaxed);
+
+        for_each_chunk([&](Chunk &c) {
+            c.bindings.resize(c.corners.size());
+
+            /* Allocate the bindings in blocks. The first one holds as many
+               as there are positions in the chunk, which is the number of
+               unique vertices unless texture coordinates or normals split
+               them. Every further block is twice as large as the previous
+               one, so that the number of blocks stays logarithmic. Never
+               allocate more than the remaining face corners. */
+            VertexBinding *block = nullptr;
+            size_t block_size = 0, block_ctr = 0,
+                   next_size = std::max(c.vertex_count, (size_t) 256);
+            auto allocate = [&](size_t remaining) {
+                if (block_ctr == block_size) {
+                    block_size = std::min(next_size, remaining);
+                    next_size *= 2;
+                    c.arena.emplace_back(new VertexBinding[block_size]);
+                    block = c.arena.back().get();
+                    block_ctr = 0;
+                }
+                return &block[block_ctr++];
+            };
 
-                        if (unlikely(map_index >= vertices.size()))
-                            fail("reference to invalid vertex %i!", key[0]);
-                        if (unlikely(vertex_map.size() < vertices.size()))
-                            vertex_map.resize(vertices.size());
+            for (size_t i = 0; i < c.corners.size(); ++i) {
+                const ScalarIndex3 &key = c.corners[i];
+                size_t pos = c.corner_offset + i;
+                std::atomic<VertexBinding *> &slot = vertex_map[key[0] - 1];
 
-                        // Hash table lookup
-                        VertexBinding *entry = &vertex_map[map_index];
-                        while (entry->key != key && entry->next != nullptr)
-                            entry = entry->next;
+                VertexBinding *head  = slot.load(std::memory_order_acquire),
+                              *stop  = nullptr,
+                              *entry = nullptr;
 
-                        ScalarIndex id;
-                        if (entry->key == key) {
-                            // Hit
-                            id = entry->value;
-                        } else {
-                            // Miss
-                            if (entry->key != ScalarIndex3{{0, 0, 0}}) {
-                                entry->next = new VertexBinding();
-                                entry = entry->next;
-                            }
-                            entry->key = key;
-                            id = entry->value = vertex_ctr++;
-                        }
+                while (true) {
+                    // Hash table lookup (only entries added since the last attempt)
+                    VertexBinding *v = head;
+                    while (v != stop && v->key != key)
+                        v = v->next;
+
+                    if (v != stop) {
+                        // Hit
+                        size_t first = v->first.load(std::memory_order_relaxed);
+                        while (pos < first &&
+                               !v->first.compare_exchange_weak(
+                                   first, pos, std::memory_order_relaxed))
+                            ;
+                        c.bindings[i] = v;
+                        break;
+                    }
 
-                        if (vertex_index < 3) {
-                            tri[vertex_index] = id;
-                        } else {
-                            tri[1] = tri[2];
-                            tri[2] = id;
-                        }
-                        vertex_index++;
+                    // Miss
+                    if (!entry) {
+                        entry = allocate(c.corners.size() - i);
+                        entry->key = key;
+                    }
+                    entry->first.store(pos, std::memory_order_relaxed);
+                    entry->next = head;
 
-                        if (vertex_index >= 3)
-                            triangles.push_back(tri);
+                    if (slot.compare_exchange_weak(head, entry,
+                                                   std::memory_order_acq_rel,
+                                                   std::memory_order_acquire)) {
+                        c.bindings[i] = entry;
+                        break;
                     }
 
-                    cur = next2;
+                    stop = entry->next;
                 }
             }
 
-            if (unlikely(parse_error))
-                fail("could not parse line \"%s\"", buf);
-            ptr = next + 1;
+            std::vector<ScalarIndex3>().swap(c.corners);
+        });
+
+        /* Phase 3: number the unique vertices in order of their first
+           reference, which matches a sequential pass over the file */
+        for_each_chunk([&](Chunk &c) {
+            size_t count = 0;
+            for (size_t i = 0; i < c.bindings.size(); ++i)
+                count += c.bindings[i]->first.load(std::memory_order_relaxed) ==
+                         c.corner_offset + i;
+            c.value_offset = count;
+        });
+
+        size_t vertex_ctr = 0;
+        for (Chunk &c : chunks) {
+            size_t count = c.value_offset;
+            c.value_offset = vertex_ctr;
+            vertex_ctr += count;
         }
 
-        m_vertex_count = vertex_ctr;
-        m_face_count = (ScalarSize) triangles.size();
+        m_vertex_count = (ScalarSize) vertex_ctr;
+        m_face_count = (ScalarSize) triangle_count;
 
         std::unique_ptr<float[]> vertex_positions(new float[m_vertex_count * 3]);
         std::unique_ptr<float[]> vertex_normals(new float[m_vertex_count * 3]);
         std::unique_ptr<float[]> vertex_texcoords(new float[m_vertex_count * 2]);
+        std::unique_ptr<ScalarIndex3[]> triangles(new ScalarIndex3[m_face_count]);
+
+        for_each_chunk([&](Chunk &c) {
+            ScalarIndex value = (ScalarIndex) c.value_offset;
 
-        for (const auto& v_ : vertex_map) {
-            const VertexBinding *v = &v_;
+            for (size_t i = 0; i < c.bindings.size(); ++i) {
+                VertexBinding *v = c.bindings[i];
+                if (v->first.load(std::memory_order_relaxed) != c.corner_offset + i)
+                    continue;
 
-            while (v && v->key != ScalarIndex3{{0, 0, 0}}) {
+                v->value = value++;
                 InputFloat* position_ptr = vertex_positions.get() + v->value * 3;
                 InputFloat* normal_ptr   = vertex_normals.get() + v->value * 3;
                 InputFloat* texcoord_ptr = vertex_texcoords.get() + v->value * 2;
@@ -373,12 +593,22 @@ public:
                         fail("reference to invalid normal %i!", key[2]);
                     dr::store(normal_ptr, normals[key[2] - 1]);
                 }
-
-                v = v->next;
             }
-        }
+        });
+
+        // Phase 4: resolve the triangle indices
+        for_each_chunk([&](Chunk &c) {
+            for (size_t i = 0; i < c.triangles.size(); ++i) {
+                ScalarIndex3 tri = c.triangles[i];
+                for (size_t j = 0; j < 3; ++j)
+                    tri[j] = c.bindings[tri[j]]->value;
+                triangles[c.triangle_offset + i] = tri;
+            }
+        });
+
+        chunks.clear();
 
-        m_faces = dr::load<DynamicBuffer<UInt32>>(triangles.data(), m_face_count * 3);
+        m_faces = dr::load<DynamicBuffer<UInt32>>(triangles.get(), m_face_count * 3);
         m_vertex_positions = dr::load<FloatStorage>(vertex_positions.get(), m_vertex_count * 3);
         if (!m_face_normals)
             m_vertex_normals   = dr::load<FloatStorage>(vertex_normals.get(), m_vertex_count * 3);
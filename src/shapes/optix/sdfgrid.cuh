@@ -4,35 +4,17 @@
 #include <mitsuba/render/optix/common.h>
 
 struct OptixSDFGridData {
-    uint32_t* voxel_indices;
-    uint32_t res_x;
-    uint32_t res_y;
-    uint32_t res_z;
-    float voxel_size_x;
-    float voxel_size_y;
-    float voxel_size_z;
-    float* grid_data;
+    uint32_t* brick_origins;
+    float* brick_values;
+    uint32_t brick_size;
+    uint32_t voxel_res_x;
+    uint32_t voxel_res_y;
+    uint32_t voxel_res_z;
     optix::Transform4f to_object;
 };
 
 #ifdef __CUDACC__
 
-__device__ unsigned int vec_to_index(const Vector3u &vec,
-                                     const OptixSDFGridData &sdf) {
-    return vec[2] * sdf.res_y * sdf.res_x + vec[1] * sdf.res_x + vec[0];
-}
-
-__device__ Vector3u index_to_vec(unsigned int index,
-                                 const OptixSDFGridData &sdf) {
-    uint32_t x_len = sdf.res_x - 1;
-    uint32_t y_len = sdf.res_y - 1;
-    unsigned int x = index % x_len;
-    unsigned int y = ((index - x) / y_len) % y_len;
-    unsigned int z = (index - x - y * x_len) / (x_len * y_len);
-
-    return Vector3u(x, y, z);
-}
-
 __device__ bool intersect_aabb(const Ray3f &ray,
                                const optix::BoundingBox3f &bbox, float &t_min,
                                float &t_max) {
@@ -151,98 +133,25 @@ __device__ bool sdf_solve_cubic(float t_beg, float t_end, float c3, float c2,
     return true;
 }
 
-extern "C" __global__ void __intersection__sdfgrid() {
-    const OptixHitGroupData *sbt_data =
-        (OptixHitGroupData *) optixGetSbtDataPointer();
-    OptixSDFGridData &sdf = *((OptixSDFGridData *) sbt_data->data);
-    unsigned int voxel_index = sdf.voxel_indices[optixGetPrimitiveIndex()];
-
-    Ray3f ray = get_ray();
-    ray = sdf.to_object.transform_ray(ray); // object-space
-
-    Vector3f bbox_min = index_to_vec(voxel_index, sdf);
-    Vector3f bbox_max = bbox_min + Vector3f(1.f, 1.f, 1.f);
-    Vector3f voxel_size(sdf.voxel_size_x, sdf.voxel_size_y, sdf.voxel_size_z);
-    bbox_min *= voxel_size;
-    bbox_max *= voxel_size;
-
-    BoundingBox3f bbox_local;
-    bbox_local.min[0] = bbox_min[0];
-    bbox_local.min[1] = bbox_min[1];
-    bbox_local.min[2] = bbox_min[2];
-    bbox_local.max[0] = bbox_max[0];
-    bbox_local.max[1] = bbox_max[1];
-    bbox_local.max[2] = bbox_max[2];
-
-    float t_bbox_beg = 0;
-    float t_bbox_end = 0;
-    bool bbox_its = intersect_aabb(ray, bbox_local, t_bbox_beg, t_bbox_end);
-    // This should theoretically always hit, but OptiX might be a bit
-    // less/more tight numerically hence some rays will miss
-    if (!bbox_its) {
-        return;
-    }
-
-    t_bbox_beg = max(t_bbox_beg, 0.f);
-    if (t_bbox_end < t_bbox_beg) {
-        return;
-    }
-
-    optix::Transform4f to_voxel;
-    to_voxel.matrix[0][0] = (float) (sdf.res_x - 1);
-    to_voxel.matrix[1][0] = 0.f;
-    to_voxel.matrix[2][0] = 0.f;
-    to_voxel.matrix[3][0] = 0.f;
-
-    to_voxel.matrix[0][1] = 0.f;
-    to_voxel.matrix[1][1] = (float) (sdf.res_y - 1);
-    to_voxel.matrix[2][1] = 0.f;
-    to_voxel.matrix[3][1] = 0.f;
-
-    to_voxel.matrix[0][2] = 0.f;
-    to_voxel.matrix[1][2] = 0.f;
-    to_voxel.matrix[2][2] = (float) (sdf.res_z - 1);
-    to_voxel.matrix[3][2] = 0.f;
-
-    Vector3u voxel_position = index_to_vec(voxel_index, sdf);
-    to_voxel.matrix[0][3] = -1.f * ((float) voxel_position.x());
-    to_voxel.matrix[1][3] = -1.f * ((float) voxel_position.y());
-    to_voxel.matrix[2][3] = -1.f * ((float) voxel_position.z());
-    to_voxel.matrix[3][3] = 1.f;
-
-    ray = to_voxel.transform_ray(ray); // voxel-space [0, 1] x [0, 1] x [0, 1]
-
+__device__ bool sdf_intersect_voxel(const float o[3], const float d[3],
+                                    const int v[3], const float f[8],
+                                    float t_beg, float t_end, float &t) {
     /**
        Herman Hansson-Söderlund, Alex Evans, and Tomas Akenine-Möller, Ray
        Tracing of Signed Distance Function Grids, Journal of Computer Graphics
        Techniques (JCGT), vol. 11, no. 3, 94-113, 2022
     */
-    Vector3u v000 = voxel_position;
-    Vector3u v100 = v000 + Vector3u(1, 0, 0);
-    Vector3u v010 = v000 + Vector3u(0, 1, 0);
-    Vector3u v110 = v000 + Vector3u(1, 1, 0);
-    Vector3u v001 = v000 + Vector3u(0, 0, 1);
-    Vector3u v101 = v000 + Vector3u(1, 0, 1);
-    Vector3u v011 = v000 + Vector3u(0, 1, 1);
-    Vector3u v111 = v000 + Vector3u(1, 1, 1);
-
-    float s000 = sdf.grid_data[vec_to_index(v000, sdf)];
-    float s100 = sdf.grid_data[vec_to_index(v100, sdf)];
-    float s010 = sdf.grid_data[vec_to_index(v010, sdf)];
-    float s110 = sdf.grid_data[vec_to_index(v110, sdf)];
-    float s001 = sdf.grid_data[vec_to_index(v001, sdf)];
-    float s101 = sdf.grid_data[vec_to_index(v101, sdf)];
-    float s011 = sdf.grid_data[vec_to_index(v011, sdf)];
-    float s111 = sdf.grid_data[vec_to_index(v111, sdf)];
-
-    Vector3f ray_p_in_voxel = ray(t_bbox_beg);
-    float o_x = ray_p_in_voxel.x();
-    float o_y = ray_p_in_voxel.y();
-    float o_z = ray_p_in_voxel.z();
-
-    float d_x = ray.d.x();
-    float d_y = ray.d.y();
-    float d_z = ray.d.z();
+    float s000 = f[0], s100 = f[1], s010 = f[2], s110 = f[3],
+          s001 = f[4], s101 = f[5], s011 = f[6], s111 = f[7];
+
+    // Coordinates relative to the voxel and to the segment start
+    float o_x = fmaf(d[0], t_beg, o[0]) - v[0];
+    float o_y = fmaf(d[1], t_beg, o[1]) - v[1];
+    float o_z = fmaf(d[2], t_beg, o[2]) - v[2];
+
+    float d_x = d[0];
+    float d_y = d[1];
+    float d_z = d[2];
 
     float a  = s101 - s001;
     float k0 = s000;
@@ -266,26 +175,135 @@ extern "C" __global__ void __intersection__sdfgrid() {
     float c2 = fmaf(m1, m5, d_z * (fmaf(k5, d_x, fmaf(k6, d_y, k7 * m2))));
     float c3 = k7 * m1 * d_z;
 
-    float t_beg = 0.f;
-    float t_end = t_bbox_end - t_bbox_beg;
+    float t_max = t_end - t_beg;
 
     if (c3 != 0) {
         // Cubic polynomial
-        float t = 0;
-        bool hit = sdf_solve_cubic(t_beg, t_end, c3, c2, c1, c0, t);
+        float root = 0;
+        bool hit = sdf_solve_cubic(0.f, t_max, c3, c2, c1, c0, root);
 
-        if (hit && t_beg <= t && t <= t_end && t_bbox_beg + t < ray.maxt)
-            optixReportIntersection(t_bbox_beg + t, OPTIX_HIT_KIND_TRIANGLE_FRONT_FACE);
+        if (hit && 0.f <= root && root <= t_max) {
+            t = t_beg + root;
+            return true;
+        }
     } else {
         // Quadratic or linear polynomial
         float root_0;
         float root_1;
         bool hit = solve_quadratic(c2, c1, c0, root_0, root_1);
 
-        if (hit && t_beg <= root_0 && root_0 <= t_end && t_bbox_beg + root_0 < ray.maxt)
-            optixReportIntersection(t_bbox_beg + root_0, OPTIX_HIT_KIND_TRIANGLE_FRONT_FACE);
-        else if (hit && t_beg <= root_1 && root_1 <= t_end && t_bbox_beg + root_1 < ray.maxt)
-            optixReportIntersection(t_bbox_beg + root_1, OPTIX_HIT_KIND_TRIANGLE_FRONT_FACE);
+        if (hit && 0.f <= root_0 && root_0 <= t_max) {
+            t = t_beg + root_0;
+            return true;
+        } else if (hit && 0.f <= root_1 && root_1 <= t_max) {
+            t = t_beg + root_1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+extern "C" __global__ void __intersection__sdfgrid() {
+    const OptixHitGroupData *sbt_data =
+        (OptixHitGroupData *) optixGetSbtDataPointer();
+    OptixSDFGridData &sdf = *((OptixSDFGridData *) sbt_data->data);
+    unsigned int brick = optixGetPrimitiveIndex();
+
+    Ray3f ray = get_ray();
+    ray = sdf.to_object.transform_ray(ray); // object-space
+
+    // Express the ray in grid space, where every voxel is a unit cube
+    const int res[3] = { (int) sdf.voxel_res_x, (int) sdf.voxel_res_y,
+                         (int) sdf.voxel_res_z };
+    Ray3f grid_ray = ray;
+    grid_ray.o = Vector3f(ray.o.x() * res[0], ray.o.y() * res[1], ray.o.z() * res[2]);
+    grid_ray.d = Vector3f(ray.d.x() * res[0], ray.d.y() * res[1], ray.d.z() * res[2]);
+    const float o[3] = { grid_ray.o.x(), grid_ray.o.y(), grid_ray.o.z() };
+    const float d[3] = { grid_ray.d.x(), grid_ray.d.y(), grid_ray.d.z() };
+
+    int lo[3], hi[3];
+    BoundingBox3f brick_bbox;
+    for (int k = 0; k < 3; ++k) {
+        lo[k] = (int) sdf.brick_origins[3 * brick + k];
+        hi[k] = min(lo[k] + (int) sdf.brick_size, res[k]);
+        brick_bbox.min[k] = (float) lo[k];
+        brick_bbox.max[k] = (float) hi[k];
+    }
+
+    float t_beg = 0;
+    float t_end = 0;
+    bool bbox_its = intersect_aabb(grid_ray, brick_bbox, t_beg, t_end);
+    // This should theoretically always hit, but OptiX might be a bit
+    // less/more tight numerically hence some rays will miss
+    if (!bbox_its)
+        return;
+
+    t_beg = max(t_beg, 0.f);
+    t_end = min(t_end, ray.maxt);
+    if (t_end < t_beg)
+        return;
+
+    /**
+       Visit the voxels of the brick in front-to-back order. AMANATIDES, J.,
+       AND WOO, A. 1987. A fast voxel traversal algorithm for ray tracing.
+    */
+    int v[3], step[3];
+    float t_next[3], t_delta[3];
+    for (int k = 0; k < 3; ++k) {
+        v[k] = min(max((int) floorf(fmaf(d[k], t_beg, o[k])), lo[k]), hi[k] - 1);
+        if (d[k] > 0.f) {
+            step[k]    = 1;
+            t_delta[k] = 1.f / d[k];
+            t_next[k]  = (v[k] + 1 - o[k]) * t_delta[k];
+        } else if (d[k] < 0.f) {
+            step[k]    = -1;
+            t_delta[k] = -1.f / d[k];
+            t_next[k]  = (o[k] - v[k]) * t_delta[k];
+        } else {
+            step[k]    = 0;
+            t_delta[k] = t_next[k] = __int_as_float(0x7f800000);
+        }
+    }
+
+    unsigned int n = sdf.brick_size + 1;
+    const float *values = sdf.brick_values + (size_t) brick * n * n * n;
+
+    float t = t_beg;
+    while (true) {
+        float t_exit = fminf(fminf(fminf(t_next[0], t_next[1]), t_next[2]), t_end);
+
+        const float *p = values + (v[0] - lo[0]) +
+                         n * ((v[1] - lo[1]) + n * (v[2] - lo[2]));
+        float f[8] = { p[0],         p[1],
+                       p[n],         p[n + 1],
+                       p[n * n],     p[n * n + 1],
+                       p[n * n + n], p[n * n + n + 1] };
+
+        bool all_positive = true, all_negative = true;
+        for (int i = 0; i < 8; ++i) {
+            all_positive &= f[i] > 0.f;
+            all_negative &= f[i] < 0.f;
+        }
+
+        float t_hit;
+        if (!(all_positive || all_negative) &&
+            sdf_intersect_voxel(o, d, v, f, t, t_exit, t_hit)) {
+            optixReportIntersection(t_hit, OPTIX_HIT_KIND_TRIANGLE_FRONT_FACE);
+            return;
+        }
+
+        if (t_exit >= t_end)
+            return;
+
+        int k = t_next[0] < t_next[1] ? (t_next[0] < t_next[2] ? 0 : 2)
+                                      : (t_next[1] < t_next[2] ? 1 : 2);
+        v[k] += step[k];
+        if (v[k] < lo[k] || v[k] >= hi[k])
+            return;
+
+        t = t_exit;
+        t_next[k] += t_delta[k];
     }
 }
 
@@ -1,15 +1,18 @@
 #include <mitsuba/render/mesh.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/mstream.h>
+#include <mitsuba/core/mmap.h>
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/profiler.h>
 #include <drjit-core/half.h>
+#include <nanothread/nanothread.h>
 #include <unordered_map>
 #include <unordered_set>
 #include <fstream>
+#include <mutex>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -33,6 +36,30 @@ PLY (Stanford Triangle Format) mesh loader (:monosp:`ply`)
      discarded and *face normals* will instead be used during rendering.
      This gives the rendered object a faceted appearance. (Default: |false|)
 
+ * - solid_angle_sampling
+   - |bool|
+   - When set to |true| and the mesh is an emitter, directions towards it
+     are sampled by choosing a triangle by area and then uniformly sampling
+     the solid angle it subtends. This reduces noise near large emitters.
+     (Default: |false|)
+
+ * - compact_vertices
+   - |bool|
+   - When set to |true|, vertex normals are stored in a 32 bit octahedral
+     encoding and texture coordinates are quantized to 16 bits per component,
+     which reduces the memory footprint of large meshes. Normals and texture
+     coordinates are then no longer exposed as (differentiable) parameters.
+     (Default: |false|)
+
+ * - interleaved_vertices
+   - |bool|
+   - When set to |true|, scalar variants additionally store the position,
+     normal and texture coordinates of every vertex next to each other, which
+     improves the cache behavior of ray intersections and surface interaction
+     queries on large meshes at the cost of a second copy of the vertex data.
+     It is ignored by the JIT variants and cannot be combined with
+     ``compact_vertices``. (Default: |false|)
+
  * - flip_tex_coords
    - |bool|
    - Treat the vertical component of the texture as inverted? (Default: |false|)
@@ -168,6 +195,8 @@ public:
     PLYMesh(const Properties &props) : Base(props) {
         /// Process vertex/index records in large batches
         constexpr size_t elements_per_packet = 1024;
+        /// Number of batches processed by a single task
+        constexpr size_t packets_per_block = 16;
 
         /* Causes all texture coordinates to be vertically flipped. */
         bool flip_tex_coords = props.get<bool>("flip_tex_coords", false);
@@ -203,6 +232,44 @@ public:
             fail(e.what());
         }
 
+        /* Element records are processed in place: binary files are memory
+           mapped, while ASCII files were converted to a memory stream above */
+        const uint8_t *data;
+        size_t data_size, data_offset;
+#if !defined(_WIN32)
+        ref<MemoryMappedFile> mmap;
+#else
+        std::unique_ptr<uint8_t[]> tmp;
+#endif
+        if (header.ascii) {
+            data        = ((MemoryStream *) stream.get())->raw_buffer();
+            data_size   = stream->size();
+            data_offset = 0;
+        } else {
+#if !defined(_WIN32)
+            mmap        = new MemoryMappedFile(file_path);
+            data        = (const uint8_t *) mmap->data();
+            data_size   = mmap->size();
+            data_offset = stream->tell();
+#else
+            // Memory-mapped IO performs surprisingly poorly on Windows
+            data_size   = stream->size() - stream->tell();
+            data_offset = 0;
+            tmp.reset(new uint8_t[data_size]);
+            stream->read(tmp.get(), data_size);
+            data = tmp.get();
+#endif
+        }
+
+        auto element_data = [&](const PLYElement &el) {
+            size_t size = el.struct_->size() * el.count;
+            if (unlikely(data_size - data_offset < size))
+                fail("invalid file -- unexpected end of file");
+            const uint8_t *result = data + data_offset;
+            data_offset += size;
+            return result;
+        };
+
         bool has_vertex_normals = false;
         bool has_vertex_texcoords = false;
 
@@ -253,14 +320,28 @@ public:
                 size_t i_struct_size = el.struct_->size();
                 size_t o_struct_size = vertex_struct->size();
 
+                /* Fast path: read the fields straight from the file when
+                   they are stored in the required format */
+                std::vector<size_t> offsets;
+                bool direct = direct_layout(el.struct_, vertex_struct, offsets,
+                                            has_vertex_normals);
+                for (const Struct::Field &f : *el.struct_)
+                    direct &= !has_flag(f.flags, Struct::Flags::Assert);
+
                 ref<StructConverter> conv;
-                try {
-                    conv = new StructConverter(el.struct_, vertex_struct);
-                } catch (const std::exception &e) {
-                    fail(e.what());
+                if (!direct) {
+                    offsets.clear();
+                    for (const Struct::Field &f : *vertex_struct)
+                        offsets.push_back(f.offset);
+                    try {
+                        conv = new StructConverter(el.struct_, vertex_struct);
+                    } catch (const std::exception &e) {
+                        fail(e.what());
+                    }
                 }
 
                 m_vertex_count = (ScalarSize) el.count;
+                const uint8_t *el_data = element_data(el);
 
                 for (auto& descr: vertex_attributes_descriptors)
                     descr.buf.resize(m_vertex_count * descr.dim);
@@ -269,72 +350,75 @@ public:
                 std::unique_ptr<float[]> vertex_normals(new float[m_vertex_count * 3]);
                 std::unique_ptr<float[]> vertex_texcoords(new float[m_vertex_count * 2]);
 
-                InputFloat* position_ptr = vertex_positions.get();
-                InputFloat *normal_ptr   = vertex_normals.get();
-                InputFloat *texcoord_ptr = vertex_texcoords.get();
-
-                size_t packet_count     = el.count / elements_per_packet;
-                size_t remainder_count  = el.count % elements_per_packet;
+                size_t packet_count     = (el.count + elements_per_packet - 1) / elements_per_packet;
                 size_t i_packet_size    = i_struct_size * elements_per_packet;
-                size_t i_remainder_size = i_struct_size * remainder_count;
                 size_t o_packet_size    = o_struct_size * elements_per_packet;
+                size_t attribute_offset = !m_face_normals
+                                              ? (has_vertex_texcoords ? 8 : 6)
+                                              : (has_vertex_texcoords ? 5 : 3);
+                std::mutex mutex;
+
+                dr::parallel_for(
+                    dr::blocked_range<size_t>(0, packet_count, packets_per_block),
+                    [&](const dr::blocked_range<size_t> &range) {
+                        std::unique_ptr<uint8_t[]> buf_o(direct ? nullptr : new uint8_t[o_packet_size]);
+                        ScalarBoundingBox3f bbox;
+
+                        for (size_t i = range.begin(); i != range.end(); ++i) {
+                            const uint8_t *source = el_data + i * i_packet_size;
+                            size_t count = std::min(elements_per_packet, el.count - i * elements_per_packet);
+                            const uint8_t *target = source;
+                            size_t stride = i_struct_size;
+
+                            if (!direct) {
+                                if (unlikely(!conv->convert(count, source, buf_o.get())))
+                                    fail("incompatible contents -- is this a triangle mesh?");
+                                target = buf_o.get();
+                                stride = o_struct_size;
+                            }
 
-                std::unique_ptr<uint8_t[]> buf(new uint8_t[i_packet_size]);
-                std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_packet_size]);
-
-                for (size_t i = 0; i <= packet_count; ++i) {
-                    uint8_t *target = (uint8_t *) buf_o.get();
-                    size_t psize = (i != packet_count) ? i_packet_size : i_remainder_size;
-                    size_t count = (i != packet_count) ? elements_per_packet : remainder_count;
-                    stream->read(buf.get(), psize);
-                    if (unlikely(!conv->convert(count, buf.get(), buf_o.get())))
-                        fail("incompatible contents -- is this a triangle mesh?");
-
-                    for (size_t j = 0; j < count; ++j) {
-                        InputPoint3f p = dr::load<InputPoint3f>(target);
-                        p = m_to_world.scalar().transform_affine(p);
-                        if (unlikely(!all(dr::isfinite(p))))
-                            fail("mesh contains invalid vertex position data");
-                        m_bbox.expand(p);
-                        dr::store(position_ptr, p);
-                        position_ptr += 3;
-
-                        if (has_vertex_normals) {
-                            InputNormal3f n = dr::load<InputNormal3f>(
-                                target + sizeof(InputFloat) * 3);
-                            n = dr::normalize(m_to_world.scalar().transform_affine(n));
-                            dr::store(normal_ptr, n);
-                            normal_ptr += 3;
-                        }
-
-                        if (has_vertex_texcoords) {
-                            InputVector2f uv = dr::load<InputVector2f>(
-                                target + (m_face_normals
-                                              ? sizeof(InputFloat) * 3
-                                              : sizeof(InputFloat) * 6));
-                            if (flip_tex_coords)
-                                uv.y() = 1.f - uv.y();
-                            dr::store(texcoord_ptr, uv);
-                            texcoord_ptr += 2;
-                        }
-
-                        size_t target_offset =
-                            sizeof(InputFloat) *
-                            (!m_face_normals
-                                 ? (has_vertex_texcoords ? 8 : 6)
-                                 : (has_vertex_texcoords ? 5 : 3));
-
-                        for (size_t k = 0; k < vertex_attributes_descriptors.size(); ++k) {
-                            auto& descr = vertex_attributes_descriptors[k];
-                            memcpy(descr.buf.data() + (i * elements_per_packet + j) * descr.dim,
-                                   target + target_offset,
-                                   descr.dim * sizeof(InputFloat));
-                            target_offset += descr.dim * sizeof(InputFloat);
+                            for (size_t j = 0; j < count; ++j) {
+                                size_t index = i * elements_per_packet + j;
+                                auto value = [&](size_t k) {
+                                    InputFloat v;
+                                    memcpy(&v, target + offsets[k], sizeof(InputFloat));
+                                    return v;
+                                };
+
+                                InputPoint3f p(value(0), value(1), value(2));
+                                p = m_to_world.scalar().transform_affine(p);
+                                if (unlikely(!all(dr::isfinite(p))))
+                                    fail("mesh contains invalid vertex position data");
+                                bbox.expand(p);
+                                dr::store(vertex_positions.get() + index * 3, p);
+
+                                if (has_vertex_normals) {
+                                    InputNormal3f n(value(3), value(4), value(5));
+                                    n = dr::normalize(m_to_world.scalar().transform_affine(n));
+                                    dr::store(vertex_normals.get() + index * 3, n);
+                                }
+
+                                if (has_vertex_texcoords) {
+                                    size_t k = m_face_normals ? 3 : 6;
+                                    InputVector2f uv(value(k), value(k + 1));
+                                    if (flip_tex_coords)
+                                        uv.y() = 1.f - uv.y();
+                                    dr::store(vertex_texcoords.get() + index * 2, uv);
+                                }
+
+                                size_t k = attribute_offset;
+                                for (auto &descr : vertex_attributes_descriptors)
+                                    for (size_t l = 0; l < descr.dim; ++l)
+                                        descr.buf[index * descr.dim + l] = value(k++);
+
+                                target += stride;
+                            }
                         }
 
-                        target += o_struct_size;
+                        std::lock_guard<std::mutex> guard(mutex);
+                        m_bbox.expand(bbox);
                     }
-                }
+                );
 
                 for (auto& descr: vertex_attributes_descriptors)
                     add_attribute(descr.name, descr.dim, descr.buf);
@@ -370,56 +454,83 @@ public:
                 size_t i_struct_size = el.struct_->size();
                 size_t o_struct_size = face_struct->size();
 
+                /* Fast path: read the indices straight from the file, which
+                   only requires checking the (8 bit) vertex count of lists */
+                const Struct::Field &count_field = el.struct_->field(field_name + ".count");
+                size_t count_offset = count_field.offset;
+                std::vector<size_t> offsets;
+                bool direct = direct_layout(el.struct_, face_struct, offsets) &&
+                              (count_field.type == Struct::Type::UInt8 ||
+                               count_field.type == Struct::Type::Int8);
+                for (const Struct::Field &f : *el.struct_)
+                    direct &= !has_flag(f.flags, Struct::Flags::Assert) ||
+                              f.name == count_field.name;
+
                 ref<StructConverter> conv;
-                try {
-                    conv = new StructConverter(el.struct_, face_struct);
-                } catch (const std::exception &e) {
-                    fail(e.what());
+                if (!direct) {
+                    offsets.clear();
+                    for (const Struct::Field &f : *face_struct)
+                        offsets.push_back(f.offset);
+                    try {
+                        conv = new StructConverter(el.struct_, face_struct);
+                    } catch (const std::exception &e) {
+                        fail(e.what());
+                    }
                 }
 
                 m_face_count = (ScalarSize) el.count;
+                const uint8_t *el_data = element_data(el);
 
                 for (auto& descr: face_attributes_descriptors)
                     descr.buf.resize(m_face_count * descr.dim);
 
                 std::unique_ptr<uint32_t[]> faces(new uint32_t[m_face_count * 3]);
-                ScalarIndex* face_ptr = faces.get();
 
-                size_t packet_count     = el.count / elements_per_packet;
-                size_t remainder_count  = el.count % elements_per_packet;
-                size_t i_packet_size    = i_struct_size * elements_per_packet;
-                size_t i_remainder_size = i_struct_size * remainder_count;
-                size_t o_packet_size    = o_struct_size * elements_per_packet;
+                size_t packet_count  = (el.count + elements_per_packet - 1) / elements_per_packet;
+                size_t i_packet_size = i_struct_size * elements_per_packet;
+                size_t o_packet_size = o_struct_size * elements_per_packet;
+
+                dr::parallel_for(
+                    dr::blocked_range<size_t>(0, packet_count, packets_per_block),
+                    [&](const dr::blocked_range<size_t> &range) {
+                        std::unique_ptr<uint8_t[]> buf_o(direct ? nullptr : new uint8_t[o_packet_size]);
+
+                        for (size_t i = range.begin(); i != range.end(); ++i) {
+                            const uint8_t *source = el_data + i * i_packet_size;
+                            size_t count = std::min(elements_per_packet, el.count - i * elements_per_packet);
+                            const uint8_t *target = source;
+                            size_t stride = i_struct_size;
+
+                            if (!direct) {
+                                if (unlikely(!conv->convert(count, source, buf_o.get())))
+                                    fail("incompatible contents -- is this a triangle mesh?");
+                                target = buf_o.get();
+                                stride = o_struct_size;
+                            }
 
-                std::unique_ptr<uint8_t[]> buf(new uint8_t[i_packet_size]);
-                std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_packet_size]);
-
-                for (size_t i = 0; i <= packet_count; ++i) {
-                    uint8_t *target = (uint8_t *) buf_o.get();
-                    size_t psize = (i != packet_count) ? i_packet_size : i_remainder_size;
-                    size_t count = (i != packet_count) ? elements_per_packet : remainder_count;
-
-                    stream->read(buf.get(), psize);
-                    if (unlikely(!conv->convert(count, buf.get(), buf_o.get())))
-                        fail("incompatible contents -- is this a triangle mesh?");
-
-                    for (size_t j = 0; j < count; ++j) {
-                        ScalarIndex3 fi = dr::load<ScalarIndex3>(target);
-                        dr::store(face_ptr, fi);
-                        face_ptr += 3;
-
-                        size_t target_offset = sizeof(InputFloat) * 3;
-                        for (size_t k = 0; k < face_attributes_descriptors.size(); ++k) {
-                            auto& descr = face_attributes_descriptors[k];
-                            memcpy(descr.buf.data() + (i * elements_per_packet + j) * descr.dim,
-                                   target + target_offset,
-                                   descr.dim * sizeof(InputFloat));
-                            target_offset += descr.dim * sizeof(InputFloat);
-                        }
+                            for (size_t j = 0; j < count; ++j) {
+                                size_t index = i * elements_per_packet + j;
 
-                        target += o_struct_size;
+                                if (direct && unlikely(target[count_offset] != 3))
+                                    fail("incompatible contents -- is this a triangle mesh?");
+
+                                ScalarIndex3 fi;
+                                for (size_t k = 0; k < 3; ++k)
+                                    memcpy(&fi[k], target + offsets[k], sizeof(ScalarIndex));
+                                dr::store(faces.get() + index * 3, fi);
+
+                                size_t k = 3;
+                                for (auto &descr : face_attributes_descriptors) {
+                                    for (size_t l = 0; l < descr.dim; ++l)
+                                        memcpy(descr.buf.data() + index * descr.dim + l,
+                                               target + offsets[k++], sizeof(InputFloat));
+                                }
+
+                                target += stride;
+                            }
+                        }
                     }
-                }
+                );
 
                 for (auto& descr: face_attributes_descriptors)
                     add_attribute(descr.name, descr.dim, descr.buf);
@@ -427,11 +538,11 @@ public:
                 m_faces = dr::load<DynamicBuffer<UInt32>>(faces.get(), m_face_count * 3);
             } else {
                 Log(Warn, "\"%s\": skipping unknown element \"%s\"", m_name, el.name);
-                stream->seek(stream->tell() + el.struct_->size() * el.count);
+                element_data(el);
             }
         }
 
-        if (stream->tell() != stream->size())
+        if (data_offset != data_size)
             fail("invalid file -- trailing content");
 
         Log(Debug, "\"%s\": read %i faces, %i vertices (%s in %s)",
@@ -452,6 +563,44 @@ public:
     }
 
 private:
+    /**
+     * \brief Check whether the fields of \c target can be read from records
+     * with layout \c source without conversion, and compute their offsets.
+     *
+     * This is the case when all fields are present in the source with the
+     * same type (32 bit integers may differ in signedness), without
+     * normalization, and in the native byte order. Missing vertex normal
+     * fields are permitted when \c need_normals is \c false.
+     */
+    bool direct_layout(const Struct *source, const Struct *target,
+                       std::vector<size_t> &offsets,
+                       bool need_normals = true) const {
+        if (source->byte_order() != Struct::host_byte_order())
+            return false;
+
+        for (const Struct::Field &f : *target) {
+            if (!source->has_field(f.name)) {
+                if (!need_normals && (f.name == "nx" || f.name == "ny" || f.name == "nz")) {
+                    offsets.push_back(0);
+                    continue;
+                }
+                return false;
+            }
+
+            const Struct::Field &sf = source->field(f.name);
+            bool int32 = (sf.type == Struct::Type::Int32 || sf.type == Struct::Type::UInt32) &&
+                         (f.type == Struct::Type::Int32 || f.type == Struct::Type::UInt32);
+            if ((sf.type != f.type && !int32) ||
+                has_flag(sf.flags, Struct::Flags::Normalized) ||
+                has_flag(sf.flags, Struct::Flags::Gamma))
+                return false;
+
+            offsets.push_back(sf.offset);
+        }
+
+        return true;
+    }
+
     PLYHeader parse_ply_header(Stream *stream) {
         Struct::ByteOrder byte_order = Struct::host_byte_order();
         bool ply_tag_seen = false;
@@ -13,6 +13,7 @@
 
 #include <drjit/tensor.h>
 #include <drjit/texture.h>
+#include <nanothread/nanothread.h>
 
 #if defined(MI_ENABLE_EMBREE)
 #include <embree3/rtcore.h>
@@ -51,6 +52,11 @@ SDF Grid (:monosp:`sdfgrid`)
    - Specifies the method for computing shading normals. The options are
      :monosp:`analytic` or :monosp:`smooth`. (Default: :monosp:`smooth`)
 
+ * - brick_size
+   - |int|
+   - Number of voxels along each axis of the bricks that partition the grid
+     for ray tracing. (Default: 8)
+
  * - to_world
    - |transform|
    - Specifies a linear object-to-world transformation. (Default: none (i.e. object space = world space))
@@ -71,6 +77,17 @@ The grid object-space is mapped over the range :math:`[0,1]^3`.
 A smooth method for computing normals :cite:`Hansson-Soderlund2022SDF` is
 selected as the default approach to ensure continuity across grid cells.
 
+For ray tracing, the grid is partitioned into bricks of
+:monosp:`brick_size`\ :sup:`3` voxels, and only the bricks that intersect the
+surface are kept in a sparse list along with a copy of their SDF values. Every
+brick is a single primitive of the acceleration structure and is bounded by
+the union of the tight bounding boxes of its occupied voxels. Rays that enter
+a brick step through its voxels in front-to-back order, so that empty space
+is skipped both between and within bricks. On the CPU, runs of empty voxels
+are furthermore skipped by sphere tracing, and the lanes of ray packets
+traverse a brick together. Larger bricks reduce the size of the acceleration
+structure, while smaller bricks bound the surface more tightly.
+
 .. warning::
     Compared with the other available shape plugins, the SDF grid has a few
     important limitations. Namely:
@@ -116,20 +133,17 @@ public:
     using InputPoint3f   = Point<InputFloat, 3>;
     using InputTensorXf  = dr::Tensor<DynamicBuffer<InputFloat>>;
     using InputBoundingBox3f = BoundingBox<InputPoint3f>;
-    using InputScalarBoundingBox3f = BoundingBox<Point<float, 3>>;
+    using InputScalarPoint3f  = Point<float, 3>;
+    using InputScalarVector3f = Vector<float, 3>;
+    using InputScalarBoundingBox3f = BoundingBox<InputScalarPoint3f>;
 
-    using FloatStorage = DynamicBuffer<InputFloat>;
+    using FloatStorage  = DynamicBuffer<InputFloat>;
+    using UInt32Storage = DynamicBuffer<UInt32>;
 
     using typename Base::ScalarIndex;
     using typename Base::ScalarSize;
 
     SDFGrid(const Properties &props) : Base(props) {
-#if !defined(MI_ENABLE_EMBREE)
-        if constexpr (!dr::is_jit_v<Float>)
-            Throw("In scalar variants, the SDF grid is only available with "
-                  "Embree!");
-#endif
-
         std::string normals_mode_str = props.string("normals", "smooth");
         if (normals_mode_str == "analytic")
             m_normal_method = Analytic;
@@ -140,6 +154,11 @@ public:
                   "or \"smooth\"!",
                   normals_mode_str);
 
+        int brick_size = props.get<int>("brick_size", 8);
+        if (brick_size < 1)
+            Throw("The brick size must be positive!");
+        m_brick_size = (uint32_t) brick_size;
+
         if (props.has_property("filename")) {
             FileResolver *fs   = Thread::thread()->file_resolver();
             fs::path file_path = fs->resolve(props.string("filename"));
@@ -177,13 +196,6 @@ public:
         initialize();
     }
 
-    ~SDFGrid() {
-        if constexpr (!dr::is_jit_v<Float>) {
-            jit_free(m_bboxes_ptr);
-            jit_free(m_voxel_indices_ptr);
-        }
-    }
-
     void update() {
         auto [S, Q, T] =
             dr::transform_decompose(m_to_world.scalar().matrix, 25);
@@ -204,20 +216,8 @@ public:
         m_voxel_size = voxel_size;
         dr::make_opaque(m_inv_shape, m_voxel_size);
 
-        if constexpr (!dr::is_cuda_v<Float>) {
-            dr::eval(m_grid_texture.value()); // Make sure the SDF data is evaluated
-            m_host_grid_data = m_grid_texture.tensor().data();
-        }
-
-        if constexpr (!dr::is_jit_v<Float>){
-            jit_free(m_bboxes_ptr);
-            jit_free(m_voxel_indices_ptr);
-        }
-        std::tie(m_bboxes_ptr,
-                 m_voxel_indices_ptr,
-                 m_filled_voxel_count) = build_bboxes();
-        if (m_filled_voxel_count == 0)
-            Throw("SDFGrid should at least have one non-empty voxel!");
+        dr::eval(m_grid_texture.value()); // Make sure the SDF data is evaluated
+        build_bricks();
 
         mark_dirty();
     }
@@ -246,7 +246,7 @@ public:
         Base::parameters_changed();
     }
 
-    ScalarSize primitive_count() const override { return m_filled_voxel_count; }
+    ScalarSize primitive_count() const override { return m_brick_count; }
 
     ScalarBoundingBox3f bbox() const override {
         ScalarBoundingBox3f bbox;
@@ -271,6 +271,49 @@ public:
         return reinterpret_cast<InputScalarBoundingBox3f*>(m_bboxes_ptr)[index];
     }
 
+    ScalarBoundingBox3f bbox(ScalarIndex index,
+                             const ScalarBoundingBox3f &clip) const override {
+        if constexpr (dr::is_cuda_v<Float>)
+            NotImplementedError("bbox(ScalarIndex index, const ScalarBoundingBox3f &clip)");
+
+        /* Union of the tight bounds of the brick's occupied voxels that
+           overlap the clip box */
+        const uint32_t *origin = m_brick_origins_ptr + 3 * index;
+        uint32_t n = m_brick_size + 1;
+        const float *values = m_brick_values_ptr + (size_t) index * n * n * n;
+        ScalarVector3f voxel_size = dr::rcp(ScalarVector3f(m_voxel_res));
+
+        uint32_t extent[3];
+        for (uint32_t k = 0; k < 3; ++k)
+            extent[k] = std::min(m_brick_size, m_voxel_res[k] - origin[k]);
+
+        ScalarBoundingBox3f result;
+        for (uint32_t z = 0; z < extent[2]; ++z) {
+            for (uint32_t y = 0; y < extent[1]; ++y) {
+                const float *p = values + n * (y + n * z);
+                for (uint32_t x = 0; x < extent[0]; ++x, ++p) {
+                    float f[8] = { p[0],             p[1],
+                                   p[n],             p[n + 1],
+                                   p[n * n],         p[n * n + 1],
+                                   p[n * n + n],     p[n * n + n + 1] };
+                    InputScalarBoundingBox3f voxel_bbox = voxel_tight_bbox(f);
+                    if (!voxel_bbox.valid())
+                        continue;
+                    ScalarPoint3f offset((ScalarFloat) (origin[0] + x),
+                                         (ScalarFloat) (origin[1] + y),
+                                         (ScalarFloat) (origin[2] + z));
+                    ScalarBoundingBox3f bbox = to_world_bbox(ScalarBoundingBox3f(
+                        (ScalarPoint3f(voxel_bbox.min) + offset) * voxel_size,
+                        (ScalarPoint3f(voxel_bbox.max) + offset) * voxel_size));
+                    if (bbox.overlaps(clip))
+                        result.expand(bbox);
+                }
+            }
+        }
+        result.clip(clip);
+        return result;
+    }
+
     Float surface_area() const override {
         return 0;
     }
@@ -555,20 +598,12 @@ public:
                 m_optix_data_ptr =
                     jit_malloc(AllocType::Device, sizeof(OptixSDFGridData));
 
-            auto shape = m_grid_texture.tensor().shape();
-            uint32_t resolution[3] = { static_cast<uint32_t>(shape[2]),
-                                       static_cast<uint32_t>(shape[1]),
-                                       static_cast<uint32_t>(shape[0]) };
-
-            dr::eval(m_grid_texture.value()); // Make sure the SDF data is evaluated
-            OptixSDFGridData data = { (uint32_t *) m_voxel_indices_ptr,
-                                      resolution[0],
-                                      resolution[1],
-                                      resolution[2],
-                                      m_voxel_size.scalar()[0],
-                                      m_voxel_size.scalar()[1],
-                                      m_voxel_size.scalar()[2],
-                                      m_grid_texture.tensor().array().data(),
+            OptixSDFGridData data = { (uint32_t *) m_brick_origins_ptr,
+                                      (float *) m_brick_values_ptr,
+                                      m_brick_size,
+                                      m_voxel_res.x(),
+                                      m_voxel_res.y(),
+                                      m_voxel_res.z(),
                                       m_to_object.scalar() };
             jit_memcpy(JitBackend::CUDA, m_optix_data_ptr, &data,
                        sizeof(OptixSDFGridData));
@@ -578,7 +613,7 @@ public:
     void optix_build_input(OptixBuildInput &build_input) const override {
         build_input.type = OPTIX_BUILD_INPUT_TYPE_CUSTOM_PRIMITIVES;
         build_input.customPrimitiveArray.aabbBuffers   = &m_bboxes_ptr;
-        build_input.customPrimitiveArray.numPrimitives = m_filled_voxel_count;
+        build_input.customPrimitiveArray.numPrimitives = m_brick_count;
         build_input.customPrimitiveArray.strideInBytes = 6 * sizeof(float);
         build_input.customPrimitiveArray.flags         = optix_geometry_flags;
         build_input.customPrimitiveArray.numSbtRecords = 1;
@@ -603,112 +638,209 @@ private:
     std::tuple<dr::mask_t<FloatP>, FloatP, Point<FloatP, 2>,
                dr::uint32_array_t<FloatP>, dr::uint32_array_t<FloatP>>
         MI_INLINE ray_intersect_preliminary_common_impl(
-            const Ray3fP &ray_, ScalarIndex prim_index, dr::mask_t<FloatP> active) const {
+            const Ray3fP &ray, ScalarIndex prim_index, dr::mask_t<FloatP> active) const {
         MI_MASK_ARGUMENT(active);
 
-        using MaskP = dr::mask_t<FloatP>;
-
         // The current implementation doesn't support JIT types so don't try to
         // use this in for instance compute_surface_interaction
         if constexpr (dr::is_jit_v<FloatP>)
             NotImplementedError("ray_intersect_preliminary_common_impl");
 
+        FloatP t = brick_intersect<FloatP>(ray, prim_index, active);
+
+        active = active && t < dr::Infinity<FloatP>;
+
+        return { active, t, Point<FloatP, 2>(0.f, 0.f), ((uint32_t) -1),
+                 prim_index };
+    }
+
+    /* \brief Intersects a ray with the surface inside of a brick and returns
+     * the intersection distance (or infinity).
+     *
+     * The voxels of the brick are visited in front-to-back order along the ray
+     * (3D-DDA). In occupied voxels, the intersection with the trilinear
+     * interpolant is found by solving a cubic polynomial. Runs of empty voxels
+     * are skipped by sphere tracing: no root lies closer than |f(p)| / L to a
+     * point p, where L bounds the norm of the gradient of the interpolant
+     * within the brick. All lanes of a packet traverse the brick at once.
+     *
+     *  AMANATIDES, J., AND WOO, A. 1987. A fast voxel traversal algorithm for
+     *  ray tracing. Eurographics.
+     */
+    template <typename FloatP, typename Ray3fP>
+    FloatP brick_intersect(const Ray3fP &ray_, ScalarIndex brick,
+                           dr::mask_t<FloatP> active) const {
+        using MaskP     = dr::mask_t<FloatP>;
+        using UInt32P   = dr::uint32_array_t<FloatP>;
+        using Point3fP  = Point<FloatP, 3>;
+        using Vector3fP = Vector<FloatP, 3>;
+
         Transform<Point<FloatP, 4>> to_object = m_to_object.scalar();
         Ray3fP ray = to_object.transform_affine(ray_);
 
-        auto shape = m_grid_texture.tensor().shape();
+        // Express the ray in grid space, where every voxel is a unit cube
+        Vector3fP res(ScalarVector3f(m_voxel_res));
+        Point3fP o(ray.o.x() * res.x(), ray.o.y() * res.y(), ray.o.z() * res.z());
+        Vector3fP d = ray.d * res;
+
+        const uint32_t *origin = m_brick_origins_ptr + 3 * brick;
+        ScalarVector3f lo((float) origin[0], (float) origin[1], (float) origin[2]);
+        ScalarVector3f hi = dr::minimum(lo + (float) m_brick_size,
+                                        ScalarVector3f(m_voxel_res));
+
+        ScalarBoundingBox3f brick_bbox((ScalarPoint3f(lo)), ScalarPoint3f(hi));
+        auto [bbox_hit, t_beg, t_end] = brick_bbox.ray_intersect(Ray3fP(o, d));
+        Vector3fP lo_p(lo), hi_p(hi);
+        t_beg = dr::maximum(t_beg, 0.f);
+        t_end = dr::minimum(t_end, ray.maxt);
+        active &= bbox_hit && t_beg <= t_end;
+
+        FloatP t_hit = dr::Infinity<FloatP>;
+        if (!dr::any(active))
+            return t_hit;
+
+        // Voxel containing the entry point (with integer coordinates) and
+        // stepping parameters
+        Vector3fP v(dr::floor(dr::fmadd(d.x(), t_beg, o.x())),
+                    dr::floor(dr::fmadd(d.y(), t_beg, o.y())),
+                    dr::floor(dr::fmadd(d.z(), t_beg, o.z())));
+        v = dr::clip(v, lo_p, hi_p - 1.f);
+
+        Vector3fP step = dr::select(d > 0.f, Vector3fP(1.f),
+                                    dr::select(d < 0.f, Vector3fP(-1.f),
+                                               Vector3fP(0.f)));
+        Vector3fP t_delta = dr::abs(dr::rcp(d));
+        Vector3fP t_next  = dr::select(
+            d > 0.f, (v + 1.f - Vector3fP(o)) * t_delta,
+            dr::select(d < 0.f, (Vector3fP(o) - v) * t_delta,
+                       Vector3fP(dr::Infinity<FloatP>)));
+
+        auto min_next = [&]() {
+            return dr::minimum(dr::minimum(t_next.x(), t_next.y()), t_next.z());
+        };
 
-        uint32_t voxel_index     = m_voxel_indices_ptr[prim_index];
-        ScalarVector3u voxel_pos = to_voxel_position(voxel_index);
+        uint32_t n = m_brick_size + 1;
+        const float *values = m_brick_values_ptr + (size_t) brick * n * n * n;
+        uint32_t corner_offset[8];
+        for (uint32_t i = 0; i < 8; ++i)
+            corner_offset[i] = (i & 1) + n * (((i >> 1) & 1) + n * ((i >> 2) & 1));
+
+        // Inverse speed at which the distance bound shrinks along the ray
+        FloatP inv_speed = dr::rcp(m_brick_lipschitz_ptr[brick] * dr::norm(d));
+
+        FloatP t = t_beg;
+        while (dr::any(active)) {
+            FloatP t_exit = dr::minimum(min_next(), t_end);
+
+            Vector3fP local = v - lo_p;
+            UInt32P base = UInt32P(local.x()) +
+                           n * (UInt32P(local.y()) + n * UInt32P(local.z()));
+            FloatP f[8];
+            for (uint32_t i = 0; i < 8; ++i)
+                f[i] = gather_value<FloatP>(values, base + corner_offset[i], active);
+
+            MaskP all_positive = true, all_negative = true;
+            for (uint32_t i = 0; i < 8; ++i) {
+                all_positive &= f[i] > 0.f;
+                all_negative &= f[i] < 0.f;
+            }
+            MaskP occupied = active && !(all_positive || all_negative);
 
-        // Find voxel AABB in object space
-        ScalarBoundingBox3f bbox_local;
-        {
-            ScalarPoint3f bbox_min =
-                ScalarPoint3f((float) voxel_pos.x(), (float) voxel_pos.y(), (float) voxel_pos.z());
-            ScalarPoint3f bbox_max = bbox_min + ScalarPoint3f(1.f, 1.f, 1.f);
-            bbox_min *= m_voxel_size.scalar();
-            bbox_max *= m_voxel_size.scalar();
-            bbox_local.expand(bbox_min);
-            bbox_local.expand(bbox_max);
-        }
+            if (dr::any(occupied)) {
+                auto [hit, t_voxel] =
+                    voxel_intersect<FloatP>(o, d, v, f, t, t_exit, occupied);
+                t_hit = dr::select(hit, t_voxel, t_hit);
+                active &= !hit;
+            }
 
-        // To determine voxel intersection, we need both near and far AABB
-        // intersections
-        auto [bbox_hit, t_bbox_beg, t_bbox_end] = bbox_local.ray_intersect(ray);
+            // Distance along the ray that is guaranteed to be free of roots
+            FloatP t_target = t_exit;
+            MaskP empty = active && !occupied;
+            if (dr::any(empty)) {
+                FloatP f_p = trilinear<FloatP>(
+                    f, dr::fmadd(d.x(), t, o.x()) - v.x(),
+                    dr::fmadd(d.y(), t, o.y()) - v.y(),
+                    dr::fmadd(d.z(), t, o.z()) - v.z());
+                t_target = dr::select(
+                    empty, dr::maximum(t_exit, dr::fmadd(dr::abs(f_p), inv_speed, t)),
+                    t_target);
+            }
 
-        active = active && bbox_hit;
+            active &= t_target < t_end;
 
-        t_bbox_beg = dr::maximum(t_bbox_beg, decltype(t_bbox_beg)(0.0));
-        MaskP valid_t = t_bbox_beg < t_bbox_end;
-        active &= valid_t;
+            // Step through voxels until the one containing the target distance
+            MaskP advance = active;
+            while (dr::any(advance)) {
+                MaskP step_x = t_next.x() <= t_next.y() && t_next.x() <= t_next.z(),
+                      step_y = !step_x && t_next.y() <= t_next.z(),
+                      step_z = !step_x && !step_y;
 
-        // Convert ray to voxel-space [0, 1] x [0, 1] x [0, 1]
-        {
-            ScalarMatrix4f m{};
-            m[0][0] = (float) (shape[2] - 1);
-            m[1][0] = 0.f;
-            m[2][0] = 0.f;
-            m[3][0] = 0.f;
-
-            m[0][1] = 0.f;
-            m[1][1] = (float) (shape[1] - 1);
-            m[2][1] = 0.f;
-            m[3][1] = 0.f;
-
-            m[0][2] = 0.f;
-            m[1][2] = 0.f;
-            m[2][2] = (float) (shape[0] - 1);
-            m[3][2] = 0.f;
-
-            m[0][3] = -1.f * (float) voxel_pos.x();
-            m[1][3] = -1.f * (float) voxel_pos.y();
-            m[2][3] = -1.f * (float) voxel_pos.z();
-            m[3][3] = 1.f;
-
-            ScalarTransform4f to_voxel = ScalarTransform4f(m);
-
-            ray = to_voxel.transform_affine(ray);
+                t = dr::select(advance, min_next(), t);
+
+                MaskP m[3] = { advance && step_x, advance && step_y,
+                               advance && step_z };
+                for (uint32_t k = 0; k < 3; ++k) {
+                    v[k] = dr::select(m[k], v[k] + step[k], v[k]);
+                    t_next[k] = dr::select(m[k], t_next[k] + t_delta[k], t_next[k]);
+                }
+
+                MaskP outside = dr::any(v < lo_p || v >= hi_p);
+                active &= !(advance && outside);
+                advance &= !outside && min_next() < t_target;
+            }
         }
 
-        /**
-           Voxel intersection expressed as solution of cubic polynomial:
+        return t_hit;
+    }
 
-           Herman Hansson-Söderlund, Alex Evans, and Tomas Akenine-Möller, Ray
-           Tracing of Signed Distance Function Grids, Journal of Computer
-           Graphics Techniques (JCGT), vol. 11, no. 3, 94-113, 2022
-        */
-        FloatP c0;
-        FloatP c1;
-        FloatP c2;
-        FloatP c3;
+    /// Loads values of the brick data for the given indices
+    template <typename FloatP>
+    MI_INLINE static FloatP gather_value(const float *ptr,
+                                         const dr::uint32_array_t<FloatP> &index,
+                                         const dr::mask_t<FloatP> &active) {
+        if constexpr (dr::is_array_v<FloatP>)
+            return FloatP(dr::gather<dr::float32_array_t<FloatP>>(ptr, index, active));
+        else
+            return active ? (FloatP) ptr[index] : 0.f;
+    }
+
+    /// Trilinear interpolation of the corner values of a voxel
+    template <typename FloatP>
+    MI_INLINE static FloatP trilinear(const FloatP f[8], const FloatP &u,
+                                      const FloatP &v, const FloatP &w) {
+        FloatP f00 = dr::lerp(f[0], f[1], u), f10 = dr::lerp(f[2], f[3], u),
+               f01 = dr::lerp(f[4], f[5], u), f11 = dr::lerp(f[6], f[7], u);
+        return dr::lerp(dr::lerp(f00, f10, v), dr::lerp(f01, f11, v), w);
+    }
+
+    /* \brief Intersects a ray in grid space with the trilinear interpolant of
+     * the corner values \c f of the voxel whose first corner is \c v, over the
+     * ray segment <tt>[t_beg, t_end]</tt>.
+     *
+     *  Herman Hansson-Söderlund, Alex Evans, and Tomas Akenine-Möller, Ray
+     *  Tracing of Signed Distance Function Grids, Journal of Computer
+     *  Graphics Techniques (JCGT), vol. 11, no. 3, 94-113, 2022
+     */
+    template <typename FloatP>
+    MI_INLINE std::pair<dr::mask_t<FloatP>, FloatP>
+    voxel_intersect(const Point<FloatP, 3> &o, const Vector<FloatP, 3> &d,
+                    const Vector<FloatP, 3> &v, const FloatP f[8],
+                    const FloatP &t_beg, const FloatP &t_end,
+                    dr::mask_t<FloatP> active) const {
+        /* Voxel intersection expressed as solution of cubic polynomial, using
+           coordinates relative to the voxel and to the segment start */
+        FloatP c0, c1, c2, c3;
         {
-            ScalarVector3u v000 = voxel_pos;
-            ScalarVector3u v100 = v000 + ScalarVector3u(1, 0, 0);
-            ScalarVector3u v010 = v000 + ScalarVector3u(0, 1, 0);
-            ScalarVector3u v110 = v000 + ScalarVector3u(1, 1, 0);
-            ScalarVector3u v001 = v000 + ScalarVector3u(0, 0, 1);
-            ScalarVector3u v101 = v000 + ScalarVector3u(1, 0, 1);
-            ScalarVector3u v011 = v000 + ScalarVector3u(0, 1, 1);
-            ScalarVector3u v111 = v000 + ScalarVector3u(1, 1, 1);
-
-            float s000 = m_host_grid_data[to_voxel_index(v000)];
-            float s100 = m_host_grid_data[to_voxel_index(v100)];
-            float s010 = m_host_grid_data[to_voxel_index(v010)];
-            float s110 = m_host_grid_data[to_voxel_index(v110)];
-            float s001 = m_host_grid_data[to_voxel_index(v001)];
-            float s101 = m_host_grid_data[to_voxel_index(v101)];
-            float s011 = m_host_grid_data[to_voxel_index(v011)];
-            float s111 = m_host_grid_data[to_voxel_index(v111)];
-
-            Vector<FloatP, 3> ray_p_in_voxel = ray(t_bbox_beg);
-            FloatP o_x = ray_p_in_voxel.x();
-            FloatP o_y = ray_p_in_voxel.y();
-            FloatP o_z = ray_p_in_voxel.z();
-
-            FloatP d_x = ray.d.x();
-            FloatP d_y = ray.d.y();
-            FloatP d_z = ray.d.z();
+            FloatP o_x = dr::fmadd(d.x(), t_beg, o.x()) - v.x();
+            FloatP o_y = dr::fmadd(d.y(), t_beg, o.y()) - v.y();
+            FloatP o_z = dr::fmadd(d.z(), t_beg, o.z()) - v.z();
+
+            FloatP d_x = d.x();
+            FloatP d_y = d.y();
+            FloatP d_z = d.z();
+
+            const FloatP &s000 = f[0], &s100 = f[1], &s010 = f[2], &s110 = f[3],
+                         &s001 = f[4], &s101 = f[5], &s011 = f[6], &s111 = f[7];
 
             FloatP a  = s101 - s001;
             FloatP k0 = s000;
@@ -736,19 +868,13 @@ private:
             c3 = k7 * m1 * d_z;
         }
 
-        FloatP t_beg = 0.0;
-        FloatP t_end = t_bbox_end - t_bbox_beg;
+        FloatP t_max = t_end - t_beg;
+        auto [hit, t] = sdf_solve_cubic<FloatP>(FloatP(0.f), t_max, c3, c2, c1,
+                                                c0, active);
 
-        auto [hit, t] = sdf_solve_cubic(t_beg, t_end, c3, c2, c1, c0);
+        hit = hit && active && t >= 0.f && t <= t_max;
 
-        active = active &&
-                 bbox_hit &&
-                 hit &&
-                 t_bbox_beg + t >= 0.f &&
-                 t_bbox_beg + t <= ray.maxt;
-
-        return { active, dr::select(active, t_bbox_beg + t, dr::Infinity<FloatP>),
-                 Point<FloatP, 2>(0.f, 0.f), ((uint32_t) -1), prim_index };
+        return { hit, t_beg + t };
     }
 
     /* \brief Solve cubic polynomial that gives solution to voxel intersection
@@ -760,7 +886,7 @@ private:
     template <typename FloatP>
     MI_INLINE std::tuple<dr::mask_t<FloatP>, FloatP>
     sdf_solve_cubic(FloatP t_beg, FloatP t_end, FloatP c3, FloatP c2, FloatP c1,
-                    FloatP c0) const {
+                    FloatP c0, dr::mask_t<FloatP> active = true) const {
 
         using MaskP = dr::mask_t<FloatP>;
 
@@ -772,15 +898,16 @@ private:
         };
 
         auto numerical_solve = [&](FloatP t_near, FloatP t_far, FloatP f_near,
-                                   FloatP f_far) -> FloatP {
+                                   FloatP f_far, MaskP active_) -> FloatP {
             static constexpr uint32_t num_solve_max_iter = 50;
             static constexpr float num_solve_epsilon     = 1e-5f;
 
             FloatP t   = 0;
             FloatP f_t = 0;
 
+            // Lanes without a sign change in [t_near, t_far] are never iterated
             uint32_t i = 0;
-            MaskP done = false;
+            MaskP done = !active_;
             while (!dr::all(done)) {
                 t   = t_near + (t_far - t_near) * (-f_near / (f_far - f_near));
                 f_t = eval_sdf(t);
@@ -790,8 +917,8 @@ private:
 
                 t_near = dr::select(condition > 0.f, t, t_near);
                 f_near = dr::select(condition > 0.f, f_t, f_near);
-                done   = (dr::abs(t_near - t_far) < num_solve_epsilon) ||
-                       (num_solve_max_iter < ++i);
+                done  |= (dr::abs(t_near - t_far) < num_solve_epsilon) ||
+                         (num_solve_max_iter < ++i);
             }
 
             return t;
@@ -820,48 +947,15 @@ private:
         FloatP f_near = eval_sdf(t_near);
         FloatP f_far  = eval_sdf(t_far);
 
-        MaskP active = f_near * f_far <= 0.f;
+        active &= f_near * f_far <= 0.f;
 
-        FloatP t =
-            dr::select(active, numerical_solve(t_near, t_far, f_near, f_far),
-                       dr::Infinity<Float>);
+        FloatP t = dr::select(
+            active, numerical_solve(t_near, t_far, f_near, f_far, active),
+            dr::Infinity<Float>);
 
         return { active, t };
     }
 
-    /* \brief Given an index of the flat SDFGrid data (voxel corners), return
-     * the associated voxel position
-     */
-    MI_INLINE ScalarVector3u to_voxel_position(uint32_t index) const {
-        auto shape = m_grid_texture.tensor().shape();
-        // Data is packed [Z, Y, X, C]
-        uint32_t shape_v[3] = { (uint32_t) shape[2], (uint32_t) shape[1],
-                                (uint32_t) shape[0] };
-
-        uint32_t resolution_x = shape_v[2] - 1;
-        uint32_t resolution_y = shape_v[1] - 1;
-
-        uint32_t x = index % resolution_x;
-        uint32_t y = ((index - x) / resolution_y) % resolution_y;
-        uint32_t z =
-            (index - x - y * resolution_x) / (resolution_x * resolution_y);
-
-        return { x, y, z };
-    }
-
-    /* \brief Given a voxel position, returns the corresponding voxel index
-     * relative to the flat array of SDFGrid data. In particular, the returned
-     * index maps to the bottom-left corner of the associated voxel
-     */
-    MI_INLINE ScalarIndex to_voxel_index(const ScalarVector3u &v) const {
-        auto shape = m_grid_texture.tensor().shape();
-        // Data is packed [Z, Y, X, C]
-        uint32_t shape_v[3] = { (uint32_t) shape[2], (uint32_t) shape[1],
-                                (uint32_t) shape[0] };
-
-        return v.z() * shape_v[1] * shape_v[0] + v.y() * shape_v[0] + v.x();
-    }
-
     /* \brief Offsets and rescales an point in [0, 1] x [0, 1] x [0, 1] to
      * its corresponding point in the texture. This is usually necessary because
      * dr::Texture objects assume that the value of a pixel is positionned in
@@ -879,190 +973,249 @@ private:
                             InputFloat(rescaled.z()));
     }
 
-    /* \brief Given the voxel position, returns tight bounding box around the
-     * surface.
+    /// Returns world space bounds of a box given in normalized grid coordinates
+    ScalarBoundingBox3f to_world_bbox(const ScalarBoundingBox3f &bbox) const {
+        ScalarTransform4f to_world = m_to_world.scalar();
+        ScalarBoundingBox3f result;
+        for (int i = 0; i < 8; ++i)
+            result.expand(to_world.transform_affine(bbox.corner(i)));
+        return result;
+    }
+
+    /// Returns whether the surface passes through a voxel with the given
+    /// corner values
+    MI_INLINE static bool voxel_occupied(const float f[8]) {
+        bool all_positive = true, all_negative = true;
+        for (size_t i = 0; i < 8; ++i) {
+            all_positive &= f[i] > 0.f;
+            all_negative &= f[i] < 0.f;
+        }
+        return !(all_positive || all_negative);
+    }
+
+    /* \brief Given the corner values of a voxel, returns a tight bounding box
+     * around the surface in voxel units relative to the voxel's first corner
+     * (or an invalid bounding box if the voxel is empty).
      *
      *  Tight Bounding Boxes for Voxels and Bricks in a Signed Distance Field
      *  Ray Tracer. HANSSON-SÖDERLUND, H., AND AKENINE-MÖLLER, T. 2023.
      */
-    std::tuple<Mask, InputBoundingBox3f>
-    compute_tight_bbox(const FloatStorage& grid,
-                       const uint32_t shape[3],
-                       const Vector3f& voxel_size,
-                       const ScalarTransform4f& to_world,
-                       UInt32 x,
-                       UInt32 y,
-                       UInt32 z) {
-        auto value_index = [&](UInt32 x_off,
-                               UInt32 y_off,
-                               UInt32 z_off) {
-            return (x + x_off) + (y + y_off) * shape[0] +
-                   (z + z_off) * shape[0] * shape[1];
-        };
-
-        auto voxel_corner_enc = [&](uint32_t x, uint32_t y, uint32_t z) {
-            return x + (y << 1) + (z << 2);
-        };
+    static InputScalarBoundingBox3f voxel_tight_bbox(const float f[8]) {
+        InputScalarBoundingBox3f bbox;
+        if (!voxel_occupied(f))
+            return bbox;
 
         auto voxel_corner_dec = [&](uint32_t i) {
-            return Point3u(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+            return InputScalarPoint3f((float) (i & 1), (float) ((i >> 1) & 1),
+                                      (float) ((i >> 2) & 1));
         };
 
-        UInt32 v[8];
-        for (size_t i = 0; i < 8; i++)
-            v[i] = value_index(i & 1, (i >> 1) & 1, (i >> 2) & 1);
-
-        InputFloat f[8];
-        for (size_t i = 0; i < 8; i++)
-            f[i] = dr::gather<InputFloat>(grid, v[i]);
-
-        Mask occupied_mask = !((f[0] > 0 && f[1] > 0 && f[2] > 0 && f[3] > 0 &&
-                                f[4] > 0 && f[5] > 0 && f[6] > 0 && f[7] > 0) ||
-                               (f[0] < 0 && f[1] < 0 && f[2] < 0 && f[3] < 0 &&
-                                f[4] < 0 && f[5] < 0 && f[6] < 0 && f[7] < 0));
-
-        InputBoundingBox3f bbox = dr::zeros<InputBoundingBox3f>();
-        if constexpr (!dr::is_jit_v<Float>)
-            if (!occupied_mask)
-                return { false, bbox };
-
-        Mask f_Z[8];
-        for (size_t i = 0; i < 8; i++)
-            f_Z[i] = f[i] == 0;
-
-        bbox.min.x() = dr::select(f_Z[voxel_corner_enc(0, 0, 0)] || f_Z[voxel_corner_enc(0, 0, 1)] || f_Z[voxel_corner_enc(0, 1, 0)] || f_Z[voxel_corner_enc(0, 1, 1)], 0.f, 1.f);
-        bbox.max.x() = dr::select(f_Z[voxel_corner_enc(1, 0, 0)] || f_Z[voxel_corner_enc(1, 0, 1)] || f_Z[voxel_corner_enc(1, 1, 0)] || f_Z[voxel_corner_enc(1, 1, 1)], 1.f, 0.f);
-        bbox.min.y() = dr::select(f_Z[voxel_corner_enc(0, 0, 0)] || f_Z[voxel_corner_enc(0, 0, 1)] || f_Z[voxel_corner_enc(1, 0, 0)] || f_Z[voxel_corner_enc(1, 0, 1)], 0.f, 1.f);
-        bbox.max.y() = dr::select(f_Z[voxel_corner_enc(0, 1, 0)] || f_Z[voxel_corner_enc(0, 1, 1)] || f_Z[voxel_corner_enc(1, 1, 0)] || f_Z[voxel_corner_enc(1, 1, 1)], 1.f, 0.f);
-        bbox.min.z() = dr::select(f_Z[voxel_corner_enc(0, 0, 0)] || f_Z[voxel_corner_enc(1, 0, 0)] || f_Z[voxel_corner_enc(0, 1, 0)] || f_Z[voxel_corner_enc(1, 1, 0)], 0.f, 1.f);
-        bbox.max.z() = dr::select(f_Z[voxel_corner_enc(0, 0, 1)] || f_Z[voxel_corner_enc(1, 0, 1)] || f_Z[voxel_corner_enc(0, 1, 1)] || f_Z[voxel_corner_enc(1, 1, 1)], 1.f, 0.f);
+        // Corners lying exactly on the surface
+        for (uint32_t k = 0; k < 3; ++k) {
+            bool zero_0 = false, zero_1 = false;
+            for (uint32_t i = 0; i < 8; ++i) {
+                if (f[i] != 0.f)
+                    continue;
+                if (i & (1u << k))
+                    zero_1 = true;
+                else
+                    zero_0 = true;
+            }
+            bbox.min[k] = zero_0 ? 0.f : 1.f;
+            bbox.max[k] = zero_1 ? 1.f : 0.f;
+        }
 
         // Generates pairs of neighboring corners and checks for intersection on the edge
         for (uint32_t corner_1 = 0; corner_1 < 8; corner_1++) {
             for (uint32_t shift = 0; shift < 3; shift++) {
-                if (!(corner_1 & (1u << shift))) {
-                    uint32_t corner_2 = corner_1 | (1u << shift);
+                if (corner_1 & (1u << shift))
+                    continue;
+                uint32_t corner_2 = corner_1 | (1u << shift);
 
-                    Mask intersection_mask = f[corner_1] * f[corner_2] <= 0 && f[corner_1] != f[corner_2];
+                if (!(f[corner_1] * f[corner_2] <= 0 && f[corner_1] != f[corner_2]))
+                    continue;
 
-                    if constexpr (!dr::is_jit_v<Float>) {
-                        if (!intersection_mask)
-                            continue;
-                    }
-
-                    Point3u corner_1_pos = voxel_corner_dec(corner_1);
-                    Point3u corner_2_pos = voxel_corner_dec(corner_2);
+                InputScalarPoint3f corner_1_pos = voxel_corner_dec(corner_1);
+                InputScalarPoint3f corner_2_pos = voxel_corner_dec(corner_2);
 
-                    auto intersection_pos = corner_1_pos + f[corner_1] / (f[corner_1] - f[corner_2]) * (corner_2_pos - corner_1_pos);
+                InputScalarPoint3f intersection_pos =
+                    corner_1_pos + f[corner_1] / (f[corner_1] - f[corner_2]) *
+                                       (corner_2_pos - corner_1_pos);
 
-                    bbox.min = dr::select(intersection_mask, dr::minimum(bbox.min, intersection_pos), bbox.min);
-                    bbox.max = dr::select(intersection_mask, dr::maximum(bbox.max, intersection_pos), bbox.max);
-                }
+                bbox.min = dr::minimum(bbox.min, intersection_pos);
+                bbox.max = dr::maximum(bbox.max, intersection_pos);
             }
         }
 
-        bbox.min += Vector3f(Float(x), Float(y), Float(z));
-        bbox.max += Vector3f(Float(x), Float(y), Float(z));
-
-        bbox.min = to_world.transform_affine(bbox.min * voxel_size);
-        bbox.max = to_world.transform_affine(bbox.max * voxel_size);
-
-        return { occupied_mask, bbox };
-    };
+        return bbox;
+    }
 
-    /* \brief Only computes AABBs for voxel that contain a surface in it.
-     * Returns a pointer to the array of AABBs, a pointer to an array of voxel
-     * indices of the former AABBs and the count of voxels with surface in them.
+    /* \brief Builds the sparse representation of the grid that is used for
+     * ray tracing.
      *
-     * Depending on the variant used, the pointer returned is either host or
-     * device visible
+     * The voxels are partitioned into bricks of <tt>brick_size^3</tt> voxels,
+     * and only the bricks that intersect the surface (i.e. the narrow band
+     * around the zero level set) are kept. For each of them, this stores the
+     * SDF values at its voxel corners, the position of its first voxel, and a
+     * bounding box that coalesces the tight bounding boxes of its occupied
+     * voxels. The bricks are the primitives of the acceleration structure.
+     *
+     * The bricks are always built on the host, and are then uploaded to the
+     * device in CUDA variants.
      */
-    std::tuple<void *, uint32_t *, uint32_t> build_bboxes() {
+    void build_bricks() {
         auto shape = m_grid_texture.tensor().shape();
-        uint32_t shape_v[3]  = { static_cast<uint32_t>(shape[2]),
-                                 static_cast<uint32_t>(shape[1]),
-                                 static_cast<uint32_t>(shape[0]) };
-        uint32_t max_voxel_count =
-            (uint32_t)((shape[0] - 1) * (shape[1] - 1) * (shape[2] - 1));
-        ScalarTransform4f to_world = m_to_world.scalar();
-
-        dr::eval(m_grid_texture.value()); // Make sure the SDF data is evaluated
-
-        void *aabbs_ptr = nullptr;
-        uint32_t *voxel_indices_ptr = nullptr;
-
-        uint32_t count = 0;
+        // Data is packed [Z, Y, X, C]
+        size_t sx = shape[2], sy = shape[1];
+        m_voxel_res = ScalarVector3u((uint32_t) shape[2] - 1,
+                                     (uint32_t) shape[1] - 1,
+                                     (uint32_t) shape[0] - 1);
+
+        uint32_t size = m_brick_size;
+        ScalarVector3u brick_res = (m_voxel_res + (size - 1)) / size;
+        uint32_t brick_grid_count = brick_res.x() * brick_res.y() * brick_res.z();
+
+        auto brick_origin = [&](uint32_t b) {
+            return ScalarVector3u(b % brick_res.x(),
+                                  (b / brick_res.x()) % brick_res.y(),
+                                  b / (brick_res.x() * brick_res.y())) * size;
+        };
 
+        FloatStorage grid = m_grid_texture.tensor().array();
         if constexpr (dr::is_jit_v<Float>) {
-            InputFloat grid = m_grid_texture.tensor().array();
-
-            auto [z, y, x] = dr::meshgrid(dr::arange<UInt32>(shape[0] - 1),
-                                          dr::arange<UInt32>(shape[1] - 1),
-                                          dr::arange<UInt32>(shape[2] - 1), false);
-
-            auto [occupied, bbox] = compute_tight_bbox(
-                grid, shape_v, m_voxel_size.value(), to_world, x, y, z);
-
-            UInt32 voxel_idx = x +
-                               y * (shape_v[0] - 1) +
-                               z * (shape_v[0] - 1) * (shape_v[1] - 1);
-
-            UInt32 counter = UInt32(0);
-            UInt32 slot = dr::scatter_inc(counter, UInt32(0), occupied);
-            dr::eval(slot);
-
-            m_jit_voxel_indices = dr::zeros<UInt32>(max_voxel_count);
+            grid = dr::migrate(grid, AllocType::Host);
+            dr::sync_thread();
+        }
+        const float *grid_ptr = grid.data();
+
+        // Find the bricks that contain the surface and their bounds
+        std::vector<InputScalarBoundingBox3f> bounds(brick_grid_count);
+        dr::parallel_for(
+            dr::blocked_range<uint32_t>(0, brick_grid_count, 16),
+            [&](const dr::blocked_range<uint32_t> &range) {
+                for (uint32_t b = range.begin(); b != range.end(); ++b) {
+                    ScalarVector3u lo = brick_origin(b),
+                                   hi = dr::minimum(lo + size, m_voxel_res);
+                    InputScalarBoundingBox3f &bbox = bounds[b];
+                    for (uint32_t z = lo.z(); z < hi.z(); ++z) {
+                        for (uint32_t y = lo.y(); y < hi.y(); ++y) {
+                            const float *p = grid_ptr + lo.x() + sx * (y + sy * z);
+                            for (uint32_t x = lo.x(); x < hi.x(); ++x, ++p) {
+                                float f[8] = { p[0],           p[1],
+                                               p[sx],          p[sx + 1],
+                                               p[sx * sy],     p[sx * sy + 1],
+                                               p[sx * sy + sx], p[sx * sy + sx + 1] };
+                                InputScalarBoundingBox3f voxel_bbox = voxel_tight_bbox(f);
+                                if (!voxel_bbox.valid())
+                                    continue;
+                                InputScalarVector3f offset((float) x, (float) y,
+                                                           (float) z);
+                                bbox.expand(voxel_bbox.min + offset);
+                                bbox.expand(voxel_bbox.max + offset);
+                            }
+                        }
+                    }
+                }
+            }
+        );
 
-            uint32_t stride = 3; // BBobx's Point3f stride
-            if constexpr (dr::is_llvm_v<Float>)
-                stride = sizeof(InputScalarBoundingBox3f) / sizeof(float) / 2u; // Typically 4-wide
+        std::vector<uint32_t> bricks;
+        for (uint32_t b = 0; b < brick_grid_count; ++b) {
+            if (bounds[b].valid())
+                bricks.push_back(b);
+        }
 
-            m_jit_bboxes = dr::zeros<InputFloat>(stride * max_voxel_count);
-            dr::scatter(m_jit_bboxes, bbox.min.x(), stride * (2 * slot + 0) + 0, occupied);
-            dr::scatter(m_jit_bboxes, bbox.min.y(), stride * (2 * slot + 0) + 1, occupied);
-            dr::scatter(m_jit_bboxes, bbox.min.z(), stride * (2 * slot + 0) + 2, occupied);
-            dr::scatter(m_jit_bboxes, bbox.max.x(), stride * (2 * slot + 1) + 0, occupied);
-            dr::scatter(m_jit_bboxes, bbox.max.y(), stride * (2 * slot + 1) + 1, occupied);
-            dr::scatter(m_jit_bboxes, bbox.max.z(), stride * (2 * slot + 1) + 2, occupied);
-            dr::scatter(m_jit_voxel_indices, voxel_idx, slot, occupied);
-            dr::eval(m_jit_voxel_indices, m_jit_bboxes);
+        m_brick_count = (uint32_t) bricks.size();
+        if (m_brick_count == 0)
+            Throw("SDFGrid should at least have one non-empty voxel!");
 
-            aabbs_ptr = (void *) m_jit_bboxes.data();
-            voxel_indices_ptr = (uint32_t*) m_jit_voxel_indices.data();
+        uint32_t n = size + 1;
+        size_t values_per_brick = (size_t) n * n * n;
+
+        size_t stride = 3; // OptiX expects tightly packed AABBs
+        if constexpr (!dr::is_cuda_v<Float>)
+            stride = sizeof(InputScalarBoundingBox3f) / sizeof(float) / 2u; // Typically 4-wide
+
+        std::unique_ptr<float[]> values(new float[m_brick_count * values_per_brick]);
+        std::unique_ptr<uint32_t[]> origins(new uint32_t[3 * m_brick_count]);
+        std::unique_ptr<float[]> lipschitz(new float[m_brick_count]);
+        std::unique_ptr<float[]> bboxes(new float[m_brick_count * 2 * stride]());
+
+        ScalarVector3f voxel_size = dr::rcp(ScalarVector3f(m_voxel_res));
+
+        dr::parallel_for(
+            dr::blocked_range<uint32_t>(0, m_brick_count, 64),
+            [&](const dr::blocked_range<uint32_t> &range) {
+                for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                    uint32_t b = bricks[i];
+                    ScalarVector3u lo = brick_origin(b);
+                    for (uint32_t k = 0; k < 3; ++k)
+                        origins[3 * i + k] = lo[k];
+
+                    /* Corners past the end of the grid are clamped, they only
+                       belong to voxels that are never traversed */
+                    float *out = values.get() + i * values_per_brick;
+                    for (uint32_t z = 0; z < n; ++z) {
+                        size_t gz = std::min(lo.z() + z, m_voxel_res.z());
+                        for (uint32_t y = 0; y < n; ++y) {
+                            size_t gy = std::min(lo.y() + y, m_voxel_res.y());
+                            for (uint32_t x = 0; x < n; ++x) {
+                                size_t gx = std::min(lo.x() + x, m_voxel_res.x());
+                                *out++ = grid_ptr[gx + sx * (gy + sy * gz)];
+                            }
+                        }
+                    }
 
-            count = counter[0];
-        } else {
-            aabbs_ptr = (ScalarBoundingBox3f*) jit_malloc(
-                AllocType::Host, sizeof(ScalarBoundingBox3f) * max_voxel_count);
-            voxel_indices_ptr = (uint32_t *) jit_malloc(
-                AllocType::Host, sizeof(uint32_t) * max_voxel_count);
-
-            FloatStorage grid = m_grid_texture.tensor().array();
-            ScalarVector3f voxel_size = m_voxel_size.scalar();
-
-            for (uint32_t z = 0; z < shape[0] - 1; ++z) {
-                for (uint32_t y = 0; y < shape[1] - 1; ++y) {
-                    for (uint32_t x = 0; x < shape[2] - 1; ++x) {
-                        auto [occupied, bbox] = compute_tight_bbox(
-                            grid, shape_v, voxel_size, to_world, x, y, z);
-
-                        if (!occupied)
-                            continue;
-
-                        uint32_t voxel_idx = x +
-                                             y * (shape_v[0] - 1) +
-                                             z * (shape_v[0] - 1) * (shape_v[1] - 1);
-
-                        voxel_indices_ptr[count] = voxel_idx;
-                        ScalarBoundingBox3f *ptr = (ScalarBoundingBox3f *) aabbs_ptr;
-                        ptr[count] = ScalarBoundingBox3f(bbox);
-                        count++;
+                    /* Bound on the gradient norm of the interpolant: each
+                       partial derivative interpolates the differences along
+                       the edges of a voxel */
+                    const float *brick_values = values.get() + i * values_per_brick;
+                    float grad_max[3] = { 0.f, 0.f, 0.f };
+                    size_t offset[3] = { 1, n, (size_t) n * n };
+                    for (uint32_t z = 0; z < n; ++z) {
+                        for (uint32_t y = 0; y < n; ++y) {
+                            for (uint32_t x = 0; x < n; ++x) {
+                                size_t index = x + n * (y + (size_t) n * z);
+                                uint32_t pos[3] = { x, y, z };
+                                for (uint32_t k = 0; k < 3; ++k) {
+                                    if (pos[k] + 1 < n)
+                                        grad_max[k] = std::max(grad_max[k],
+                                            std::abs(brick_values[index + offset[k]] -
+                                                     brick_values[index]));
+                                }
+                            }
+                        }
+                    }
+                    lipschitz[i] = std::sqrt(grad_max[0] * grad_max[0] +
+                                             grad_max[1] * grad_max[1] +
+                                             grad_max[2] * grad_max[2]);
+
+                    InputScalarBoundingBox3f bbox(to_world_bbox(ScalarBoundingBox3f(
+                        ScalarPoint3f(bounds[b].min) * voxel_size,
+                        ScalarPoint3f(bounds[b].max) * voxel_size)));
+
+                    float *bbox_out = bboxes.get() + 2 * stride * i;
+                    for (uint32_t k = 0; k < 3; ++k) {
+                        bbox_out[k]          = bbox.min[k];
+                        bbox_out[stride + k] = bbox.max[k];
                     }
                 }
             }
-        }
+        );
 
-        return { aabbs_ptr, voxel_indices_ptr, count };
+        m_brick_values =
+            dr::load<FloatStorage>(values.get(), m_brick_count * values_per_brick);
+        m_brick_origins =
+            dr::load<UInt32Storage>(origins.get(), 3 * m_brick_count);
+        m_brick_lipschitz =
+            dr::load<FloatStorage>(lipschitz.get(), m_brick_count);
+        m_bboxes = dr::load<FloatStorage>(bboxes.get(), m_brick_count * 2 * stride);
+        dr::eval(m_brick_values, m_brick_origins, m_brick_lipschitz, m_bboxes);
+
+        m_brick_values_ptr    = m_brick_values.data();
+        m_brick_origins_ptr   = m_brick_origins.data();
+        m_brick_lipschitz_ptr = m_brick_lipschitz.data();
+        m_bboxes_ptr          = (void *) m_bboxes.data();
     }
 
     /// Computes the SDF gradient for a given point and its containing voxel
@@ -1121,23 +1274,30 @@ private:
     /// Local voxel sizes (1 / (tensor_shape - 1))
     field<Vector<InputFloat, 3>> m_voxel_size;
 
-    // Weak pointer to underlying grid texture data. Only used for llvm/scalar
-    // variants. We store this because during raytracing, we don't want to call
-    // Texture3f::tensor().data() which internally calls jit_var_ptr and is
-    // guarded by a global state lock
-    float *m_host_grid_data = nullptr;
-
-    // Non-empty bounding boxes and corresponding indices
-    InputFloat m_jit_bboxes;
-    UInt32 m_jit_voxel_indices;
-
-    // Pointers to non-empty bounding boxes and corresponding indices
-    // (These are just the data pointer to the JIT variables aboves.
-    // In scalar variants, these are allocated  using `jit_malloc`)
+    /// Number of voxels along each axis
+    ScalarVector3u m_voxel_res;
+
+    /// Number of voxels along each axis of a brick
+    uint32_t m_brick_size;
+    /// Number of bricks that intersect the surface
+    uint32_t m_brick_count = 0;
+
+    // SDF values at the voxel corners of every brick ((brick_size + 1)^3
+    // values per brick), first voxel of every brick, bound on the gradient
+    // norm within every brick (in grid space), and brick bounding boxes
+    FloatStorage m_brick_values;
+    UInt32Storage m_brick_origins;
+    FloatStorage m_brick_lipschitz;
+    FloatStorage m_bboxes;
+
+    // Pointers to the data of the buffers above. We store these because
+    // during raytracing, we don't want to call data() which internally calls
+    // jit_var_ptr and is guarded by a global state lock
+    const float *m_brick_values_ptr = nullptr;
+    const uint32_t *m_brick_origins_ptr = nullptr;
+    const float *m_brick_lipschitz_ptr = nullptr;
     void *m_bboxes_ptr = nullptr;
-    uint32_t *m_voxel_indices_ptr = nullptr;
 
-    uint32_t m_filled_voxel_count = 0;
     NormalMethod m_normal_method;
 };
 
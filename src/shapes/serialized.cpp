@@ -1,10 +1,15 @@
 #include <mitsuba/render/mesh.h>
+#include <mitsuba/core/bstream.h>
 #include <mitsuba/core/fstream.h>
+#include <mitsuba/core/mmap.h>
+#include <mitsuba/core/mstream.h>
 #include <mitsuba/core/zstream.h>
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/profiler.h>
+#include <nanothread/nanothread.h>
+#include <mutex>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -33,6 +38,30 @@ Serialized mesh loader (:monosp:`serialized`)
      discarded and \emph{face normals} will instead be used during rendering.
      This gives the rendered object a faceted appearance. (Default: |false|)
 
+ * - solid_angle_sampling
+   - |bool|
+   - When set to |true| and the mesh is an emitter, directions towards it
+     are sampled by choosing a triangle by area and then uniformly sampling
+     the solid angle it subtends. This reduces noise near large emitters.
+     (Default: |false|)
+
+ * - compact_vertices
+   - |bool|
+   - When set to |true|, vertex normals are stored in a 32 bit octahedral
+     encoding and texture coordinates are quantized to 16 bits per component,
+     which reduces the memory footprint of large meshes. Normals and texture
+     coordinates are then no longer exposed as (differentiable) parameters.
+     (Default: |false|)
+
+ * - interleaved_vertices
+   - |bool|
+   - When set to |true|, scalar variants additionally store the position,
+     normal and texture coordinates of every vertex next to each other, which
+     improves the cache behavior of ray intersections and surface interaction
+     queries on large meshes at the cost of a second copy of the vertex data.
+     It is ignored by the JIT variants and cannot be combined with
+     ``compact_vertices``. (Default: |false|)
+
  * - flip_normals
    - |bool|
    - Is the mesh inverted, i.e. should the normal vectors be flipped? (Default:|false|, i.e.
@@ -177,6 +206,55 @@ at the end of the file, which specifies the starting position of each sub-mesh:
         * - :monosp:`uint32`
           - Total number of meshes in the :monosp:`.serialized` file
 
+Version 5
+*********
+
+Version 5 of the format stores the mesh data of every shape in separate blocks
+that are either uncompressed or individually compressed using :monosp:`zlib`.
+Uncompressed blocks start at 64-byte aligned file offsets and are directly
+accessed via memory mapping, while compressed blocks are decompressed in
+parallel. The per-shape header is not compressed and structured as follows:
+
+.. figtable::
+    :label: table-serialized-format-v5
+
+    .. list-table::
+        :widths: 20 80
+        :header-rows: 1
+
+        * - Type
+          - Content
+        * - :monosp:`uint16`
+          - File format identifier: :code:`0x041C`
+        * - :monosp:`uint16`
+          - File version identifier: :code:`0x0005`
+        * - :monosp:`uint32`
+          - Flags (see above)
+        * - :monosp:`uint32`
+          - Compression method of all blocks: :code:`0` (none) or :code:`1` (:monosp:`zlib`)
+        * - :monosp:`string`
+          - A null-terminated string (utf-8), which denotes the name of the shape.
+        * - :monosp:`uint64`
+          - Number of vertices in the mesh
+        * - :monosp:`uint64`
+          - Number of triangles in the mesh
+        * - :math:`\rightarrow`
+          - The following block list is repeated for the vertex positions, normals,
+            texture coordinates, colors, and the :monosp:`uint32` triangle indices (in this order).
+        * - :monosp:`uint32`
+          - Number of blocks storing the array (zero when it is omitted)
+        * - :monosp:`uint64[3]`
+          - For every block: absolute file offset, stored size, and size after
+            decompression (in bytes). Concatenating the decompressed blocks
+            yields the array in the layout described above.
+
+The end-of-file dictionary is identical to version 4. The Python module
+:monosp:`mitsuba.serialized` converts existing files to version 5:
+
+.. code-block:: bash
+
+    python -m mitsuba.serialized --compression none input.serialized output.serialized
+
 .. tabs::
     .. code-tab:: xml
         :name: serialized
@@ -198,6 +276,7 @@ at the end of the file, which specifies the starting position of each sub-mesh:
 #define MI_FILEFORMAT_HEADER     0x041C
 #define MI_FILEFORMAT_VERSION_V3 0x0003
 #define MI_FILEFORMAT_VERSION_V4 0x0004
+#define MI_FILEFORMAT_VERSION_V5 0x0005
 
 template <typename Float, typename Spectrum>
 class SerializedMesh final : public Mesh<Float, Spectrum> {
@@ -227,6 +306,12 @@ public:
         DoublePrecision = 0x2000
     };
 
+    /// Block compression methods of the version 5 format
+    enum class Compression : uint32_t {
+        None    = 0,
+        Deflate = 1
+    };
+
     constexpr bool has_flag(TriMeshFlags flags, TriMeshFlags f) {
         return (static_cast<uint32_t>(flags) & static_cast<uint32_t>(f)) != 0;
     }
@@ -254,7 +339,7 @@ public:
 
         m_name = tfm::format("%s@%i", file_path.filename(), shape_index);
 
-        ref<Stream> stream = new FileStream(file_path);
+        ref<Stream> stream = new BufferedStream(new FileStream(file_path));
         ScopedPhase phase(ProfilerPhase::LoadGeometry);
         Timer timer;
         stream->set_byte_order(Stream::ELittleEndian);
@@ -267,7 +352,8 @@ public:
             fail("encountered an invalid file format!");
 
         if (version != MI_FILEFORMAT_VERSION_V3 &&
-            version != MI_FILEFORMAT_VERSION_V4)
+            version != MI_FILEFORMAT_VERSION_V4 &&
+            version != MI_FILEFORMAT_VERSION_V5)
             fail("encountered an incompatible file version!");
 
         if (shape_index != 0) {
@@ -286,7 +372,7 @@ public:
                                  shape_index, count - 1));
 
             // Seek to the correct position
-            if (version == MI_FILEFORMAT_VERSION_V4) {
+            if (version != MI_FILEFORMAT_VERSION_V3) {
                 stream->seek(file_size -
                              sizeof(uint64_t) * (count - shape_index) -
                              sizeof(uint32_t));
@@ -304,12 +390,26 @@ public:
             stream->skip(sizeof(short) * 2); // Skip the header
         }
 
-        stream = new ZStream(stream);
-        stream->set_byte_order(Stream::ELittleEndian);
-
         uint32_t flags = 0;
-        stream->read(flags);
-        if (version == MI_FILEFORMAT_VERSION_V4) {
+        size_t vertex_count, face_count;
+
+        /// Uncompressed v5 array blocks may be used straight from the mapped file
+#if !defined(_WIN32)
+        ref<MemoryMappedFile> mmap;
+#endif
+        std::unique_ptr<uint8_t[]> array_storage[5];
+        const uint8_t *arrays[5] = { };
+
+        if (version == MI_FILEFORMAT_VERSION_V5) {
+            if (Struct::host_byte_order() != Struct::ByteOrder::LittleEndian)
+                fail("version 5 files can only be loaded on little endian machines");
+
+            uint32_t compression = 0;
+            stream->read(flags);
+            stream->read(compression);
+            if (compression > (uint32_t) Compression::Deflate)
+                fail("encountered an unsupported compression method");
+
             char ch = 0;
             m_name = "";
             do {
@@ -318,11 +418,128 @@ public:
                     break;
                 m_name += ch;
             } while (true);
-        }
 
-        size_t vertex_count, face_count;
-        stream->read(vertex_count);
-        stream->read(face_count);
+            stream->read(vertex_count);
+            stream->read(face_count);
+
+            struct Block {
+                uint64_t offset, stored_size, raw_size;
+                uint8_t *target;
+            };
+
+            std::vector<Block> blocks[5];
+            for (size_t i = 0; i < 5; ++i) {
+                uint32_t block_count = 0;
+                stream->read(block_count);
+                blocks[i].resize(block_count);
+                for (Block &b : blocks[i]) {
+                    stream->read(b.offset);
+                    stream->read(b.stored_size);
+                    stream->read(b.raw_size);
+                }
+            }
+
+            // Expected array sizes (positions, normals, texcoords, colors, faces)
+            size_t value_size = has_flag(flags, TriMeshFlags::DoublePrecision)
+                                    ? sizeof(double) : sizeof(float);
+            size_t array_size[5] = {
+                vertex_count * 3 * value_size,
+                has_flag(flags, TriMeshFlags::HasNormals) ? vertex_count * 3 * value_size : 0,
+                has_flag(flags, TriMeshFlags::HasTexcoords) ? vertex_count * 2 * value_size : 0,
+                has_flag(flags, TriMeshFlags::HasColors) ? vertex_count * 3 * value_size : 0,
+                face_count * 3 * sizeof(ScalarIndex)
+            };
+
+#if !defined(_WIN32)
+            mmap = new MemoryMappedFile(file_path);
+            const uint8_t *file_data = (const uint8_t *) mmap->data();
+            size_t file_size = mmap->size();
+#else
+            // Memory-mapped IO performs surprisingly poorly on Windows
+            size_t file_size = stream->size();
+            std::unique_ptr<uint8_t[]> tmp(new uint8_t[file_size]);
+            stream->seek(0);
+            stream->read(tmp.get(), file_size);
+            const uint8_t *file_data = tmp.get();
+#endif
+
+            std::vector<Block> jobs;
+            for (size_t i = 0; i < 5; ++i) {
+                size_t raw_size = 0;
+                for (const Block &b : blocks[i]) {
+                    if (b.offset > file_size || file_size - b.offset < b.stored_size ||
+                        (compression == (uint32_t) Compression::None &&
+                         b.stored_size != b.raw_size))
+                        fail("encountered an invalid block table");
+                    raw_size += b.raw_size;
+                }
+                if (raw_size != array_size[i])
+                    fail("encountered an invalid block table");
+                if (raw_size == 0)
+                    continue;
+
+                if (compression == (uint32_t) Compression::None && blocks[i].size() == 1) {
+                    arrays[i] = file_data + blocks[i][0].offset;
+                    continue;
+                }
+
+                array_storage[i].reset(new uint8_t[raw_size]);
+                arrays[i] = array_storage[i].get();
+                uint8_t *target = array_storage[i].get();
+                for (Block &b : blocks[i]) {
+                    b.target = target;
+                    target += b.raw_size;
+                    jobs.push_back(b);
+                }
+            }
+
+            // Decompress all blocks in parallel
+            dr::parallel_for(
+                dr::blocked_range<size_t>(0, jobs.size(), 1),
+                [&](const dr::blocked_range<size_t> &range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        const Block &b = jobs[i];
+                        const uint8_t *source = file_data + b.offset;
+                        if (compression == (uint32_t) Compression::None) {
+                            memcpy(b.target, source, b.raw_size);
+                        } else {
+                            ref<ZStream> zs = new ZStream(
+                                new MemoryStream((void *) source, b.stored_size));
+                            zs->read(b.target, b.raw_size);
+                        }
+                    }
+                }
+            );
+
+#if defined(_WIN32)
+            // The temporary copy of the file does not outlive this scope
+            for (size_t i = 0; i < 5; ++i) {
+                if (arrays[i] && !array_storage[i]) {
+                    array_storage[i].reset(new uint8_t[array_size[i]]);
+                    memcpy(array_storage[i].get(), arrays[i], array_size[i]);
+                    arrays[i] = array_storage[i].get();
+                }
+            }
+#endif
+        } else {
+            stream = new ZStream(stream);
+            stream->set_byte_order(Stream::ELittleEndian);
+
+            stream->read(flags);
+            if (version == MI_FILEFORMAT_VERSION_V4) {
+                char ch = 0;
+                m_name = "";
+                do {
+                    stream->read(ch);
+                    if (ch == 0)
+                        break;
+                    m_name += ch;
+                } while (true);
+            }
+
+            stream->read(vertex_count);
+            stream->read(face_count);
+        }
 
         m_vertex_count = (ScalarSize) vertex_count;
         m_face_count   = (ScalarSize) face_count;
@@ -335,43 +552,90 @@ public:
         bool double_precision = has_flag(flags, TriMeshFlags::DoublePrecision);
         bool has_normals      = has_flag(flags, TriMeshFlags::HasNormals);
         bool has_texcoords    = has_flag(flags, TriMeshFlags::HasTexcoords);
-        bool has_colors       = has_flag(flags, TriMeshFlags::HasColors);
 
-        read_helper(stream, double_precision, vertex_positions.get(), 3);
+        /* Source of the per-vertex data. Older versions are decompressed into
+           the output buffers and then processed in place. */
+        const uint8_t *position_src = (const uint8_t *) vertex_positions.get(),
+                      *normal_src   = (const uint8_t *) vertex_normals.get(),
+                      *texcoord_src = (const uint8_t *) vertex_texcoords.get();
+        bool double_src = false;
+
+        if (version == MI_FILEFORMAT_VERSION_V5) {
+            position_src = arrays[0];
+            normal_src   = arrays[1];
+            texcoord_src = arrays[2];
+            double_src   = double_precision;
+            memcpy(faces.get(), arrays[4], m_face_count * sizeof(ScalarIndex) * 3);
+        } else {
+            bool has_colors = has_flag(flags, TriMeshFlags::HasColors);
 
-        if (has_normals) {
-            if (m_face_normals)
-                // Skip over vertex normals provided in the file.
-                advance_helper(stream, double_precision, 3);
-            else
-                read_helper(stream, double_precision, vertex_normals.get(), 3);
-        }
+            read_helper(stream, double_precision, vertex_positions.get(), 3);
 
-        if (has_texcoords)
-            read_helper(stream, double_precision, vertex_texcoords.get(), 2);
+            if (has_normals) {
+                if (m_face_normals)
+                    // Skip over vertex normals provided in the file.
+                    advance_helper(stream, double_precision, 3);
+                else
+                    read_helper(stream, double_precision, vertex_normals.get(), 3);
+            }
 
-        if (has_colors)
-            advance_helper(stream, double_precision, 3); // TODO
+            if (has_texcoords)
+                read_helper(stream, double_precision, vertex_texcoords.get(), 2);
 
-        stream->read(faces.get(), m_face_count * sizeof(ScalarIndex) * 3);
+            if (has_colors)
+                advance_helper(stream, double_precision, 3); // TODO
+
+            stream->read(faces.get(), m_face_count * sizeof(ScalarIndex) * 3);
+        }
 
         // Post-processing
-        InputFloat* position_ptr = vertex_positions.get();
-        InputFloat* normal_ptr   = vertex_normals.get();
-        for (ScalarSize i = 0; i < m_vertex_count; ++i) {
-            InputPoint3f p = m_to_world.scalar().transform_affine(
-                dr::load<InputPoint3f>(position_ptr));
-            dr::store(position_ptr, p);
-            position_ptr += 3;
-            m_bbox.expand(p);
+        auto fetch = [double_src](const uint8_t *src, size_t i) -> InputFloat {
+            if (double_src) {
+                double value;
+                memcpy(&value, src + i * sizeof(double), sizeof(double));
+                return (InputFloat) value;
+            } else {
+                float value;
+                memcpy(&value, src + i * sizeof(float), sizeof(float));
+                return (InputFloat) value;
+            }
+        };
 
-            if (has_normals) {
-                InputNormal3f n = dr::load<InputNormal3f>(normal_ptr);
-                n = dr::normalize(m_to_world.scalar().transform_affine(n));
-                dr::store(normal_ptr, n);
-                normal_ptr += 3;
+        bool copy_texcoords =
+            has_texcoords && texcoord_src != (const uint8_t *) vertex_texcoords.get();
+        std::mutex mutex;
+
+        dr::parallel_for(
+            dr::blocked_range<size_t>(0, m_vertex_count, 16384),
+            [&](const dr::blocked_range<size_t> &range) {
+                ScalarBoundingBox3f bbox;
+
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    InputPoint3f p(fetch(position_src, 3 * i),
+                                   fetch(position_src, 3 * i + 1),
+                                   fetch(position_src, 3 * i + 2));
+                    p = m_to_world.scalar().transform_affine(p);
+                    dr::store(vertex_positions.get() + 3 * i, p);
+                    bbox.expand(p);
+
+                    if (has_normals && !m_face_normals) {
+                        InputNormal3f n(fetch(normal_src, 3 * i),
+                                        fetch(normal_src, 3 * i + 1),
+                                        fetch(normal_src, 3 * i + 2));
+                        n = dr::normalize(m_to_world.scalar().transform_affine(n));
+                        dr::store(vertex_normals.get() + 3 * i, n);
+                    }
+
+                    if (copy_texcoords) {
+                        vertex_texcoords[2 * i]     = fetch(texcoord_src, 2 * i);
+                        vertex_texcoords[2 * i + 1] = fetch(texcoord_src, 2 * i + 1);
+                    }
+                }
+
+                std::lock_guard<std::mutex> guard(mutex);
+                m_bbox.expand(bbox);
             }
-        }
+        );
 
         m_faces = dr::load<DynamicBuffer<UInt32>>(faces.get(), m_face_count * 3);
         m_vertex_positions = dr::load<FloatStorage>(vertex_positions.get(), m_vertex_count * 3);
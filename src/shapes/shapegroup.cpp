@@ -16,11 +16,28 @@ Shape group (:monosp:`shapegroup`)
    - :paramtype:`shape`
    - One or more shapes that should be made available for geometry instancing
 
+ * - accel
+   - |string|
+   - Acceleration data structure of the group when Mitsuba is compiled without
+     Embree: ``kdtree``, ``bvh4`` or ``bvh8`` (see the ``accel`` parameter of
+     the scene). (Default: ``kdtree``)
+
+ * - lazy_build
+   - |bool|
+   - Build the acceleration data structure of the group when it is intersected
+     for the first time rather than while loading the scene. Groups that are
+     never hit by a ray are never built. This is only supported by the scalar
+     variants, and only when Mitsuba is compiled without Embree. (Default: |false|)
+
 This plugin implements a container for shapes that should be made available for geometry instancing.
 Any shapes placed in a shapegroup will not be visible on their own—instead, the renderer will
 precompute ray intersection acceleration data structures so that they can efficiently be referenced
 many times using the :ref:`shape-instance` plugin. This is useful for rendering things like forests,
-where only a few distinct types of trees have to be kept in memory. An example is given below:
+where only a few distinct types of trees have to be kept in memory. When the scene is loaded in parallel
+(the default), the acceleration data structure of a group is built on the CPU as soon as its shapes
+are loaded, while the remaining objects of the scene (e.g. textures) are still loading. Otherwise, the
+ones of all groups of a scene are built concurrently once the scene is loaded, before its top-level one.
+An example is given below:
 
 .. tabs::
     .. code-tab:: xml
@@ -59,6 +59,10 @@ Sphere (:monosp:`sphere`)
 This shape plugin describes a simple sphere intersection primitive. It should
 always be preferred over sphere approximations modeled using triangles.
 
+In CUDA variants, spheres are traced as built-in OptiX primitives, which are
+intersected by the RT cores of recent GPUs. This requires OptiX 7.5 or newer
+(i.e. a recent driver), otherwise a custom intersection program is used.
+
 A sphere can either be configured using a linear :monosp:`to_world` transformation or the :monosp:`center` and :monosp:`radius` parameters (or both).
 The two declarations below are equivalent.
 
@@ -740,7 +744,39 @@ public:
 
             jit_memcpy(JitBackend::CUDA, m_optix_data_ptr, &data,
                        sizeof(OptixSphereData));
+
+            if (optix_builtin_spheres()) {
+                // Center and radius of the built-in sphere primitive
+                if (!m_optix_sphere_ptr)
+                    m_optix_sphere_ptr = jit_malloc(AllocType::Device, 4 * sizeof(float));
+
+                float sphere[4] = { (float) m_center.scalar().x(),
+                                    (float) m_center.scalar().y(),
+                                    (float) m_center.scalar().z(),
+                                    (float) m_radius.scalar() };
+
+                jit_memcpy(JitBackend::CUDA, m_optix_sphere_ptr, sphere,
+                           sizeof(sphere));
+
+                m_optix_center_ptr = m_optix_sphere_ptr;
+                m_optix_radius_ptr = (float *) m_optix_sphere_ptr + 3;
+            }
+        }
+    }
+
+    void optix_build_input(OptixBuildInput &build_input) const override {
+        // Fall back to the custom intersection program on older OptiX versions
+        if (!optix_builtin_spheres()) {
+            Base::optix_build_input(build_input);
+            return;
         }
+
+        build_input.type = OPTIX_BUILD_INPUT_TYPE_SPHERES;
+        build_input.sphereArray.vertexBuffers = (CUdeviceptr *) &m_optix_center_ptr;
+        build_input.sphereArray.numVertices   = 1;
+        build_input.sphereArray.radiusBuffers = (CUdeviceptr *) &m_optix_radius_ptr;
+        build_input.sphereArray.flags         = optix_geometry_flags;
+        build_input.sphereArray.numSbtRecords = 1;
     }
 #endif
 
@@ -756,6 +792,13 @@ public:
         return oss.str();
     }
 
+#if defined(MI_ENABLE_CUDA)
+    ~Sphere() {
+        if constexpr (dr::is_cuda_v<Float>)
+            jit_free(m_optix_sphere_ptr);
+    }
+#endif
+
     MI_DECLARE_CLASS()
 private:
     /// Center in world-space
@@ -766,6 +809,16 @@ private:
     Float m_inv_surface_area;
 
     bool m_flip_normals;
+
+#if defined(MI_ENABLE_CUDA)
+    static constexpr uint32_t optix_geometry_flags[1] = { OPTIX_GEOMETRY_FLAG_NONE };
+
+    /// Device storage of the built-in OptiX sphere (center and radius)
+    void *m_optix_sphere_ptr = nullptr;
+    // For the OptiX build input
+    void *m_optix_center_ptr = nullptr;
+    void *m_optix_radius_ptr = nullptr;
+#endif
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(Sphere, Shape)
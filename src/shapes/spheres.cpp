@@ -0,0 +1,442 @@
+#include <mitsuba/core/distr_1d.h>
+#include <mitsuba/core/fwd.h>
+#include <mitsuba/core/math.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/core/warp.h>
+#include <mitsuba/render/fwd.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/shape.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _shape-spheres:
+
+Sphere collection (:monosp:`spheres`)
+-------------------------------------
+
+.. pluginparameters::
+
+ * - centers
+   - |tensor|
+   - Tensor of shape [N, 3] with the centers of the spheres.
+   - |exposed|
+
+ * - radii
+   - |tensor|
+   - Tensor of shape [N] with the radii of the spheres.
+   - |exposed|
+
+ * - radius
+   - |float|
+   - Radius shared by all spheres, used when :monosp:`radii` isn't specified.
+     (Default: 1)
+
+ * - flip_normals
+   - |bool|
+   - Are the spheres inverted, i.e. should the normal vectors be flipped?
+     (Default:|false|, i.e. the normals point outside)
+
+ * - to_world
+   - |transform|
+   - Specifies an optional linear object-to-world transformation, which is
+     applied to the centers and radii when the shape is loaded. Non-uniform
+     scales and shears are not permitted!
+     (Default: none, i.e. object space = world space)
+
+This shape plugin describes a large number of spheres (e.g. particles or point
+clouds), which are stored as flat arrays of centers and radii in a single
+shape. Compared to as many :ref:`sphere <shape-sphere>` shapes, this avoids the
+cost of one shape per sphere during scene loading and rendering, and supports
+sphere counts that are far beyond what is practical with individual shapes.
+
+Every sphere is a primitive of the shape, i.e. :monosp:`si.prim_index` holds the
+index of the sphere that was hit. The UV parameterization of every sphere is
+the same as that of the :ref:`sphere <shape-sphere>` plugin. When the shape is
+turned into an :ref:`area <emitter-area>` light source, the spheres are sampled
+proportionally to their surface area.
+
+The native kd-tree of scalar variants intersects the spheres of every leaf in
+packets of 4 or 8 lanes when the scene specifies a non-zero value for
+:monosp:`kd_triangle_packets`, just like triangles.
+
+The centers and radii are not differentiable, and the plugin isn't supported by
+the CUDA variants yet.
+
+.. tabs::
+
+    .. code-tab:: python
+
+        'particles': {
+            'type': 'spheres',
+            'centers': mi.TensorXf(centers, shape=(N, 3)),
+            'radii': mi.TensorXf(radii),
+            'bsdf': {
+                'type': 'diffuse'
+            }
+        }
+ */
+
+template <typename Float, typename Spectrum>
+class Spheres final : public Shape<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Shape, m_to_world, m_to_object, m_is_instance, m_shape_type,
+                   initialize, mark_dirty, get_children_string)
+    MI_IMPORT_TYPES()
+
+    using typename Base::ScalarSize;
+    using typename Base::ScalarIndex;
+
+    using FloatStorage = DynamicBuffer<Float>;
+
+    Spheres(const Properties &props) : Base(props) {
+        if constexpr (dr::is_cuda_v<Float>)
+            Throw("The spheres shape is not supported by the CUDA variants.");
+
+        /// Are the sphere normals pointing inwards? default: no
+        m_flip_normals = props.get<bool>("flip_normals", false);
+
+        TensorXf *centers = props.tensor<TensorXf>("centers");
+        if (centers->ndim() != 2 || centers->shape(1) != 3)
+            Throw("\"centers\": expected a tensor of shape [N, 3]!");
+        m_sphere_count = (ScalarSize) centers->shape(0);
+        if (m_sphere_count == 0)
+            Throw("\"centers\": the shape must contain at least one sphere!");
+
+        FloatStorage radii;
+        if (props.has_property("radii")) {
+            TensorXf *tensor = props.tensor<TensorXf>("radii");
+            if (tensor->ndim() != 1 || tensor->shape(0) != m_sphere_count)
+                Throw("\"radii\": expected a tensor of shape [%u]!",
+                      m_sphere_count);
+            radii = tensor->array();
+        } else {
+            radii = dr::full<FloatStorage>(props.get<ScalarFloat>("radius", 1.f),
+                                           m_sphere_count);
+        }
+
+        // Bake the transformation into the centers and radii
+        ScalarTransform4f to_world = m_to_world.scalar();
+        auto [S, Q, T] = dr::transform_decompose(to_world.matrix, 25);
+        if (dr::abs(S[0][1]) > 1e-6f || dr::abs(S[0][2]) > 1e-6f || dr::abs(S[1][0]) > 1e-6f ||
+            dr::abs(S[1][2]) > 1e-6f || dr::abs(S[2][0]) > 1e-6f || dr::abs(S[2][1]) > 1e-6f)
+            Log(Warn, "'to_world' transform shouldn't contain any shearing!");
+        if (!(dr::abs(S[0][0] - S[1][1]) < 1e-6f && dr::abs(S[0][0] - S[2][2]) < 1e-6f))
+            Log(Warn, "'to_world' transform shouldn't contain non-uniform scaling!");
+
+        auto &&centers_h = dr::migrate(centers->array(), AllocType::Host);
+        auto &&radii_h = dr::migrate(radii, AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+
+        ScalarFloat scale = dr::norm(to_world.transform_affine(ScalarVector3f(1.f, 0.f, 0.f)));
+        std::unique_ptr<ScalarFloat[]> c(new ScalarFloat[m_sphere_count * 3]),
+                                       r(new ScalarFloat[m_sphere_count]);
+        for (ScalarSize i = 0; i < m_sphere_count; ++i) {
+            ScalarPoint3f p = to_world.transform_affine(ScalarPoint3f(
+                centers_h.data()[3 * i + 0], centers_h.data()[3 * i + 1],
+                centers_h.data()[3 * i + 2]));
+            for (int j = 0; j < 3; ++j)
+                c[3 * i + j] = p[j];
+            r[i] = radii_h.data()[i] * scale;
+            if (!(r[i] >= 0.f))
+                Throw("\"radii\": the radius of sphere %u is negative!", i);
+        }
+
+        m_centers = dr::load<FloatStorage>(c.get(), m_sphere_count * 3);
+        m_radii = dr::load<FloatStorage>(r.get(), m_sphere_count);
+        m_to_world = ScalarTransform4f();
+        m_to_object = ScalarTransform4f();
+
+        m_shape_type = ShapeType::Spheres;
+
+        update();
+        initialize();
+    }
+
+    void update() {
+        // Host access by the native kd-tree and Embree
+        dr::eval(m_centers, m_radii);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+
+        const ScalarFloat *c = m_centers.data(), *r = m_radii.data();
+        std::unique_ptr<ScalarFloat[]> area(new ScalarFloat[m_sphere_count]);
+
+        m_bbox.reset();
+        for (ScalarSize i = 0; i < m_sphere_count; ++i) {
+            ScalarPoint3f p(c[3 * i + 0], c[3 * i + 1], c[3 * i + 2]);
+            m_bbox.expand(ScalarBoundingBox3f(p - r[i], p + r[i]));
+            area[i] = 4.f * dr::Pi<ScalarFloat> * dr::square(r[i]);
+        }
+
+        m_area_pmf = DiscreteDistribution<Float>(area.get(), m_sphere_count);
+        mark_dirty();
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        Base::traverse(callback);
+        callback->put_parameter("centers", m_centers, +ParamFlags::NonDifferentiable);
+        callback->put_parameter("radii",   m_radii,   +ParamFlags::NonDifferentiable);
+    }
+
+    void parameters_changed(const std::vector<std::string> &keys) override {
+        if (keys.empty() || string::contains(keys, "centers") ||
+            string::contains(keys, "radii")) {
+            if (dr::width(m_centers) != 3 * m_sphere_count ||
+                dr::width(m_radii) != m_sphere_count)
+                Throw("The number of spheres cannot be changed! Expected %u "
+                      "centers and radii.", m_sphere_count);
+            update();
+        }
+
+        Base::parameters_changed(keys);
+    }
+
+    ScalarSize primitive_count() const override { return m_sphere_count; }
+
+    ScalarBoundingBox3f bbox() const override { return m_bbox; }
+
+    ScalarBoundingBox3f bbox(ScalarIndex index) const override {
+        auto [center, radius] = sphere_primitive(index);
+        return ScalarBoundingBox3f(center - radius, center + radius);
+    }
+
+    std::pair<ScalarPoint3f, ScalarFloat>
+    sphere_primitive(ScalarIndex index) const override {
+        const ScalarFloat *c = m_centers.data() + 3 * index;
+        return { ScalarPoint3f(c[0], c[1], c[2]), m_radii.data()[index] };
+    }
+
+    Float surface_area() const override { return m_area_pmf.sum(); }
+
+    // =============================================================
+    //! @{ \name Sampling routines
+    // =============================================================
+
+    PositionSample3f sample_position(Float time, const Point2f &sample_,
+                                     Mask active) const override {
+        MI_MASK_ARGUMENT(active);
+
+        UInt32 index;
+        Point2f sample = sample_;
+        std::tie(index, sample.y()) =
+            m_area_pmf.sample_reuse(sample.y(), active);
+
+        Point3f center = dr::gather<Point3f>(m_centers, index, active);
+        Float radius = dr::gather<Float>(m_radii, index, active);
+        Point3f local = warp::square_to_uniform_sphere(sample);
+
+        PositionSample3f ps = dr::zeros<PositionSample3f>();
+        ps.p = dr::fmadd(local, radius, center);
+        ps.n = local;
+
+        if (m_flip_normals)
+            ps.n = -ps.n;
+
+        ps.time = time;
+        ps.delta = false;
+        ps.pdf = m_area_pmf.normalization();
+        ps.uv = sample;
+        ps.prim_index = index;
+
+        return ps;
+    }
+
+    Float pdf_position(const PositionSample3f & /*ps*/, Mask active) const override {
+        MI_MASK_ARGUMENT(active);
+        return m_area_pmf.normalization();
+    }
+
+    //! @}
+    // =============================================================
+
+    // =============================================================
+    //! @{ \name Ray tracing routines
+    // =============================================================
+
+    template <typename FloatP, typename Ray3fP>
+    std::tuple<FloatP, Point<FloatP, 2>, dr::uint32_array_t<FloatP>,
+               dr::uint32_array_t<FloatP>>
+    ray_intersect_preliminary_impl(const Ray3fP &ray,
+                                   ScalarIndex prim_index,
+                                   dr::mask_t<FloatP> active) const {
+        MI_MASK_ARGUMENT(active);
+        using Value = std::conditional_t<dr::is_cuda_v<FloatP> || dr::is_diff_v<Float>,
+                                         dr::float32_array_t<FloatP>,
+                                         dr::float64_array_t<FloatP>>;
+        using Value3 = Vector<Value, 3>;
+
+        Value radius;
+        Value3 center;
+        if constexpr (!dr::is_jit_v<Value>) {
+            auto [c, r] = sphere_primitive(prim_index);
+            radius = (dr::scalar_t<Value>) r;
+            center = (Vector<dr::scalar_t<Value>, 3>) c;
+        } else {
+            UInt32 index = prim_index;
+            radius = (Value) dr::gather<Float>(m_radii, index);
+            center = (Value3) dr::gather<Point3f>(m_centers, index);
+        }
+
+        Value maxt = Value(ray.maxt);
+
+        // Same plane-based formulation as the 'sphere' plugin, which makes
+        // the intersection routine numerically more robust.
+        Value3 l = ray.o - center;
+        Value3 d(ray.d);
+        Value plane_t = dot(-l, d) / norm(d);
+
+        // Ray is perpendicular to plane
+        dr::mask_t<FloatP> no_hit =
+            plane_t == Value(0) && dr::all(ray.o != center);
+
+        Value3 plane_p = ray(FloatP(plane_t));
+
+        // Intersection with plane outside of the sphere
+        no_hit &= (norm(plane_p - center) > radius);
+
+        Value3 o = plane_p - center;
+
+        Value A = dr::squared_norm(d);
+        Value B = dr::scalar_t<Value>(2.f) * dr::dot(o, d);
+        Value C = dr::squared_norm(o) - dr::square(radius);
+
+        auto [solution_found, near_t, far_t] = math::solve_quadratic(A, B, C);
+
+        near_t += plane_t;
+        far_t += plane_t;
+
+        // Sphere doesn't intersect with the segment on the ray
+        dr::mask_t<FloatP> out_bounds = !(near_t <= maxt && far_t >= Value(0.0)); // NaN-aware conditionals
+
+        // Sphere fully contains the segment of the ray
+        dr::mask_t<FloatP> in_bounds = near_t < Value(0.0) && far_t > maxt;
+
+        active &= solution_found && !no_hit && !out_bounds && !in_bounds;
+
+        FloatP t = dr::select(
+            active, dr::select(near_t < Value(0.0), FloatP(far_t), FloatP(near_t)),
+            dr::Infinity<FloatP>);
+
+        return { t, dr::zeros<Point<FloatP, 2>>(), ((uint32_t) -1), prim_index };
+    }
+
+    template <typename FloatP, typename Ray3fP>
+    dr::mask_t<FloatP> ray_test_impl(const Ray3fP &ray,
+                                     ScalarIndex prim_index,
+                                     dr::mask_t<FloatP> active) const {
+        MI_MASK_ARGUMENT(active);
+        FloatP t = std::get<0>(ray_intersect_preliminary_impl<FloatP>(
+            ray, prim_index, active));
+        return active && t != dr::Infinity<FloatP>;
+    }
+
+    MI_SHAPE_DEFINE_RAY_INTERSECT_METHODS()
+
+    SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
+                                                     const PreliminaryIntersection3f &pi,
+                                                     uint32_t ray_flags,
+                                                     uint32_t recursion_depth,
+                                                     Mask active) const override {
+        MI_MASK_ARGUMENT(active);
+
+        // Early exit when tracing isn't necessary
+        if (!m_is_instance && recursion_depth > 0)
+            return dr::zeros<SurfaceInteraction3f>();
+
+        // Fields requirement dependencies
+        bool need_dn_duv = has_flag(ray_flags, RayFlags::dNSdUV) ||
+                           has_flag(ray_flags, RayFlags::dNGdUV);
+        bool need_dp_duv = has_flag(ray_flags, RayFlags::dPdUV) || need_dn_duv;
+        bool need_uv     = has_flag(ray_flags, RayFlags::UV) || need_dp_duv;
+
+        Point3f center = dr::gather<Point3f>(m_centers, pi.prim_index, active);
+        Float radius = dr::gather<Float>(m_radii, pi.prim_index, active);
+
+        SurfaceInteraction3f si = dr::zeros<SurfaceInteraction3f>();
+        si.t = dr::select(active, pi.t, dr::Infinity<Float>);
+
+        // Re-project onto the sphere to improve accuracy
+        Vector3f local = dr::normalize(ray(pi.t) - center);
+        si.p = dr::fmadd(local, radius, center);
+
+        if (likely(need_uv)) {
+            Float rd_2  = dr::square(local.x()) + dr::square(local.y()),
+                  theta = unit_angle_z(local),
+                  phi   = dr::atan2(local.y(), local.x());
+
+            dr::masked(phi, phi < 0.f) += 2.f * dr::Pi<Float>;
+
+            si.uv = Point2f(phi * dr::InvTwoPi<Float>, theta * dr::InvPi<Float>);
+            if (likely(need_dp_duv)) {
+                si.dp_du = Vector3f(-local.y(), local.x(), 0.f);
+
+                Float rd      = dr::sqrt(rd_2),
+                      inv_rd  = dr::rcp(rd),
+                      cos_phi = local.x() * inv_rd,
+                      sin_phi = local.y() * inv_rd;
+
+                si.dp_dv = Vector3f(local.z() * cos_phi,
+                                    local.z() * sin_phi,
+                                    -rd);
+
+                Mask singularity_mask = active && (rd == 0.f);
+                if (unlikely(dr::any_or<true>(singularity_mask)))
+                    si.dp_dv[singularity_mask] = Vector3f(1.f, 0.f, 0.f);
+
+                si.dp_du *= radius * (2.f * dr::Pi<Float>);
+                si.dp_dv *= radius * dr::Pi<Float>;
+            }
+        }
+
+        si.sh_frame.n = m_flip_normals ? -local : local;
+        si.n = si.sh_frame.n;
+
+        if (need_dn_duv) {
+            Float inv_radius =
+                (m_flip_normals ? -1.f : 1.f) * dr::rcp(radius);
+            si.dn_du = si.dp_du * inv_radius;
+            si.dn_dv = si.dp_dv * inv_radius;
+        }
+
+        si.shape    = this;
+        si.instance = nullptr;
+
+        return si;
+    }
+
+    //! @}
+    // =============================================================
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "Spheres[" << std::endl
+            << "  sphere_count = " << m_sphere_count << "," << std::endl
+            << "  bbox = " << string::indent(m_bbox) << "," << std::endl
+            << "  surface_area = " << surface_area() << "," << std::endl
+            << "  " << string::indent(get_children_string()) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+private:
+    /// Centers in world-space, stored as [x0, y0, z0, x1, ...]
+    mutable FloatStorage m_centers;
+    /// Radii in world-space
+    mutable FloatStorage m_radii;
+
+    ScalarSize m_sphere_count = 0;
+    ScalarBoundingBox3f m_bbox;
+    DiscreteDistribution<Float> m_area_pmf;
+
+    bool m_flip_normals;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(Spheres, Shape)
+MI_EXPORT_PLUGIN(Spheres, "Sphere collection intersection primitive");
+NAMESPACE_END(mitsuba)
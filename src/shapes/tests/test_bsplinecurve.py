@@ -562,3 +562,66 @@ def test21_shape_type(variant_scalar_rgb):
         "filename" : "resources/data/common/meshes/curve.txt",
     })
     assert curve.shape_type() == mi.ShapeType.BSplineCurve.value;
+
+
+def test22_segment_bbox_and_intersection(variant_scalar_rgb, tmpdir):
+    # A straight tube of radius 0.25 along the X axis on [-0.5, 0.5]
+    filename = str(tmpdir.join('tube.txt'))
+    with open(filename, 'w') as f:
+        f.write('-1.5 0 0 0.25\n-0.5 0 0 0.25\n0.5 0 0 0.25\n1.5 0 0 0.25\n')
+
+    curve = mi.load_dict({ 'type' : 'bsplinecurve', 'filename' : filename })
+    bbox = curve.bbox(0)
+    assert dr.allclose(bbox.min, [-1.75, -0.25, -0.25])
+    assert dr.allclose(bbox.max, [1.75, 0.25, 0.25])
+
+    # Clipped bounds are much tighter than the convex hull of the segment
+    clip = mi.ScalarBoundingBox3f([0.2, -1, -1], [3, 1, 1])
+    bbox = curve.bbox(0, clip)
+    assert dr.allclose(bbox.min, [0.2, -0.25, -0.25])
+    assert dr.allclose(bbox.max, [0.75, 0.25, 0.25])
+
+    scene = mi.load_dict({ 'type' : 'scene', 'curve' : curve })
+    for x in [-0.3, 0.0, 0.35]:
+        for y in [0.0, 0.1, 0.2]:
+            ray = mi.Ray3f(o=[x, y, -5], d=[0, 0, 1])
+            si = scene.ray_intersect(ray)
+            assert si.is_valid()
+            assert scene.ray_test(ray)
+
+            z = -dr.sqrt(0.25**2 - y**2)
+            assert dr.allclose(si.p, [x, y, z], atol=1e-4)
+            assert dr.allclose(si.n, [0, y / 0.25, z / 0.25], atol=1e-3)
+            assert dr.allclose(si.uv.y, x + 0.5, atol=1e-3)
+
+    assert not scene.ray_test(mi.Ray3f(o=[0, 0.3, -5], d=[0, 0, 1]))
+    assert not scene.ray_intersect(mi.Ray3f(o=[0, 0, 0], d=[0, 0, 1])).is_valid()
+
+
+def test23_split_segments(variant_scalar_rgb, tmpdir):
+    # A thin diagonal curve with two segments
+    filename = str(tmpdir.join('diagonal.txt'))
+    with open(filename, 'w') as f:
+        for i in range(5):
+            f.write('%i %i %i 0.02\n' % (i, i, i))
+
+    curve_ref = mi.load_dict({ 'type' : 'bsplinecurve', 'filename' : filename })
+    curve = mi.load_dict({ 'type' : 'bsplinecurve', 'filename' : filename,
+                           'split_ratio' : 8.0 })
+    assert curve_ref.primitive_count() == 2
+    # Every subdivision doubles the number of segments
+    count = curve.primitive_count()
+    assert count > 2 and count % 2 == 0 and (count & (count - 1)) == 0
+
+    params = mi.traverse(curve)
+    assert params['control_point_count'] == count + 3
+
+    # The refined curve is the same
+    scene_ref = mi.load_dict({ 'type' : 'scene', 'curve' : curve_ref })
+    scene = mi.load_dict({ 'type' : 'scene', 'curve' : curve })
+    for t in [1.3, 2.0, 2.45, 2.8]:
+        ray = mi.Ray3f(o=[t + 1, t - 1, t], d=dr.normalize(mi.Vector3f(-1, 1, 0)))
+        si_ref, si = scene_ref.ray_intersect(ray), scene.ray_intersect(ray)
+        assert si_ref.is_valid() and si.is_valid()
+        assert dr.allclose(si.t, si_ref.t, rtol=1e-3)
+        assert dr.allclose(si.n, si_ref.n, atol=1e-2)
@@ -0,0 +1,74 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+import numpy as np
+
+from mitsuba.scalar_rgb.test.util import fresolver_append_path
+
+
+def displaced(**kwargs):
+    return mi.load_dict({
+        'type': 'displacement',
+        'base': {
+            'type': 'ply',
+            'filename': 'resources/data/tests/ply/rectangle_normals_uv.ply'
+        },
+        **kwargs
+    })
+
+
+def max_edge_length(mesh):
+    params = mi.traverse(mesh)
+    p = np.array(params['vertex_positions']).reshape(-1, 3)
+    f = np.array(params['faces']).reshape(-1, 3)
+    return max(np.linalg.norm(p[f[:, i]] - p[f[:, (i + 1) % 3]], axis=1).max()
+               for i in range(3))
+
+
+@fresolver_append_path
+def test01_tessellate(variants_all_rgb):
+    base = mi.load_dict({
+        'type': 'ply',
+        'filename': 'resources/data/tests/ply/rectangle_normals_uv.ply'
+    })
+    mesh = displaced(displacement=0.5, scale=0.2, edge_length=0.3)
+    assert isinstance(mesh, mi.Mesh)
+    assert mesh.face_count() > 4 * base.face_count()
+    assert max_edge_length(mesh) <= 0.3 * (1 + 1e-4)
+    assert mesh.has_vertex_texcoords()
+
+    # A constant displacement offsets the rectangle along its normal
+    assert dr.allclose(dr.abs(mesh.bbox().min.z - base.bbox().min.z), 0.1)
+    assert dr.allclose(mesh.bbox().extents().z, 0, atol=1e-6)
+
+
+@fresolver_append_path
+def test02_view_dependent(variants_all_rgb):
+    def face_count(distance):
+        sensor = mi.load_dict({
+            'type': 'perspective',
+            'to_world': mi.ScalarTransform4f().look_at(
+                origin=[0, 0, distance], target=[0, 0, 0], up=[0, 1, 0]),
+            'film': {'type': 'hdrfilm', 'width': 64, 'height': 64}
+        })
+        return displaced(displacement=0.1, edge_length=4,
+                         sensor=sensor).face_count()
+
+    assert face_count(2) > face_count(20)
+
+
+@fresolver_append_path
+def test03_cache(variants_all_rgb, tmp_path):
+    kwargs = dict(displacement=0.5, edge_length=0.5, cache_dir=str(tmp_path))
+    mesh = displaced(**kwargs)
+    files = list(tmp_path.glob('displacement_*.ply'))
+    assert len(files) == 1
+
+    cached = displaced(**kwargs)
+    assert cached.face_count() == mesh.face_count()
+    assert dr.allclose(cached.bbox().min, mesh.bbox().min)
+    assert dr.allclose(cached.bbox().max, mesh.bbox().max)
+
+    # Different parameters produce a different cache entry
+    displaced(displacement=0.5, edge_length=0.25, cache_dir=str(tmp_path))
+    assert len(list(tmp_path.glob('displacement_*.ply'))) == 2
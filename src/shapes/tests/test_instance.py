@@ -216,3 +216,354 @@ def test03_ray_intersect_instance(variants_all_rgb, width):
         assert 'instance=0x0' in str(pi)
     else:
         assert ('instance=[' + '0x0, ' * (width - 1) + '0x0]') in str(pi)
+
+
+@fresolver_append_path
+def test04_instance_transform_update(variants_vec_rgb):
+    from mitsuba import ScalarTransform4f as T
+
+    # A small number of consecutive IAS updates exercises the rebuild policy
+    scene = mi.load_dict({
+        'type' : 'scene',
+        'optix_ias_max_updates': 2,
+        'group_0' : {
+            'type' : 'shapegroup',
+            'shape' : shapes[0]
+        },
+        'instance_0' : {
+            'type' : 'instance',
+            'group' : { 'type' : 'ref', 'id' : 'group_0' },
+        },
+        'instance_1' : {
+            'type' : 'instance',
+            'group' : { 'type' : 'ref', 'id' : 'group_0' },
+            'to_world' : T().translate([10, 0, 4])
+        }
+    })
+    params = mi.traverse(scene)
+
+    x, y = dr.meshgrid(dr.linspace(mi.Float, -2, 2, 32),
+                       dr.linspace(mi.Float, -2, 2, 32))
+    ray = mi.Ray3f(o=mi.Point3f(x, y, -10), d=mi.Vector3f(0, 0, 1))
+
+    for i in range(5):
+        to_world = T().translate([0.1 * i, -0.2 * i, 0]).rotate([0, 0, 1], 10 * i)
+        params['instance_0.to_world'] = to_world
+        params.update()
+
+        ref = mi.load_dict({
+            'type' : 'scene',
+            'shape' : dict(shapes[0], to_world=to_world)
+        })
+
+        # The first instance is always hit before the second one
+        si, si_ref = scene.ray_intersect(ray), ref.ray_intersect(ray)
+        assert dr.all(si.is_valid() == si_ref.is_valid())
+        assert dr.allclose(dr.select(si.is_valid(), si.t, 0),
+                           dr.select(si_ref.is_valid(), si_ref.t, 0), atol=1e-4)
+
+
+def test05_instance_motion(variants_all_rgb):
+    from mitsuba import ScalarTransform4f as T
+
+    # A rectangle that moves along the X axis and rotates during the shutter interval
+    keyframes = [T().translate([2 * i, 0, 0]) @ T().rotate([0, 0, 1], 5 * i)
+                 for i in range(3)]
+
+    scene = mi.load_dict({
+        'type' : 'scene',
+        'group_0' : {
+            'type' : 'shapegroup',
+            'shape' : { 'type' : 'rectangle' }
+        },
+        'instance' : {
+            'type' : 'instance',
+            'group' : { 'type' : 'ref', 'id' : 'group_0' },
+            'to_world_0' : keyframes[0],
+            'to_world_1' : keyframes[1],
+            'to_world_2' : keyframes[2]
+        }
+    })
+
+    shape = scene.shapes()[0]
+    assert shape.has_motion()
+    c, s = dr.cos(dr.deg2rad(10.0)), dr.sin(dr.deg2rad(10.0))
+    assert dr.allclose(shape.bbox().min[0], -1.0)
+    assert dr.allclose(shape.bbox().max[0], 4.0 + c + s)
+
+    for time in [0.0, 0.2, 0.5, 0.8, 1.0]:
+        # Reference: linear interpolation of the neighboring keyframes
+        x = time * 2
+        i = min(int(x), 1)
+        w = x - i
+        to_world = T(keyframes[i].matrix * (1 - w) + keyframes[i + 1].matrix * w)
+
+        ref = mi.load_dict({
+            'type' : 'scene',
+            'shape' : { 'type' : 'rectangle', 'to_world' : to_world }
+        })
+
+        for ox in [-0.9, 0.3, 1.4, 2.95, 4.2]:
+            ray = mi.Ray3f(o=[ox, 0.31, -5], d=[0, 0, 1], time=time)
+            si, si_ref = scene.ray_intersect(ray), ref.ray_intersect(ray)
+            assert dr.all(si.is_valid() == si_ref.is_valid())
+            assert dr.all(scene.ray_test(ray) == ref.ray_test(ray))
+            if dr.any(si_ref.is_valid()):
+                assert dr.allclose(si.p, si_ref.p, atol=1e-4)
+                assert dr.allclose(si.n, si_ref.n, atol=1e-4)
+                assert dr.allclose(si.uv, si_ref.uv, atol=1e-4)
+
+
+def test06_instance_motion_errors(variant_scalar_rgb):
+    from mitsuba import ScalarTransform4f as T
+
+    def load(**kwargs):
+        mi.load_dict({
+            'type' : 'scene',
+            'group_0' : {
+                'type' : 'shapegroup',
+                'shape' : { 'type' : 'rectangle' }
+            },
+            'instance' : {
+                'type' : 'instance',
+                'group' : { 'type' : 'ref', 'id' : 'group_0' },
+                **kwargs
+            }
+        })
+
+    with pytest.raises(RuntimeError, match='at least two keyframes'):
+        load(to_world_0=T())
+    with pytest.raises(RuntimeError, match='cannot be specified at the same time'):
+        load(to_world=T(), to_world_0=T(), to_world_1=T())
+    with pytest.raises(RuntimeError, match='must be larger'):
+        load(to_world_0=T(), to_world_1=T(), time_begin=1.0, time_end=0.5)
+
+
+def test06_instance_motion_time_clamp(variants_all_rgb):
+    from mitsuba import ScalarTransform4f as T
+
+    # The time range only covers part of the shutter interval
+    scene = mi.load_dict({
+        'type' : 'scene',
+        'group_0' : {
+            'type' : 'shapegroup',
+            'shape' : { 'type' : 'rectangle' }
+        },
+        'instance' : {
+            'type' : 'instance',
+            'group' : { 'type' : 'ref', 'id' : 'group_0' },
+            'to_world_0' : T().translate([0, 0, 0]),
+            'to_world_1' : T().translate([4, 0, 0]),
+            'time_begin' : 0.4,
+            'time_end' : 0.6
+        }
+    })
+
+    # Outside of the range, every backend uses the nearest keyframe
+    for time, x in [(0.0, 0), (0.2, 0), (0.5, 2), (0.8, 4), (1.0, 4)]:
+        for ox, hit in [(x - 0.5, True), (x + 1.5, False)]:
+            ray = mi.Ray3f(o=[ox, 0.3, -5], d=[0, 0, 1], time=time)
+            si = scene.ray_intersect(ray)
+            assert dr.all(si.is_valid() == hit)
+            assert dr.all(scene.ray_test(ray) == hit)
+            if hit:
+                assert dr.allclose(si.p, [ox, 0.3, 0], atol=1e-4)
+
+
+@fresolver_append_path
+@pytest.mark.parametrize('accel', ['kdtree', 'bvh4', 'bvh8'])
+@pytest.mark.parametrize('lazy_build', [False, True])
+def test07_shapegroup_accel(variant_scalar_rgb, accel, lazy_build):
+    from mitsuba import ScalarTransform4f as T
+
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    bunny = {
+        'type': 'ply',
+        'filename': 'resources/data/common/meshes/bunny_lowres.ply'
+    }
+
+    def load(**kwargs):
+        scene = {
+            'type': 'scene',
+            'group_0': { 'type': 'shapegroup', 'shape': bunny, **kwargs }
+        }
+        for i in range(16):
+            scene['instance_%i' % i] = {
+                'type': 'instance',
+                'group': { 'type': 'ref', 'id': 'group_0' },
+                'to_world': T().translate([(i % 4) * 0.3, (i // 4) * 0.3, 0]) @
+                            T().rotate([0, 1, 1], 25 * i)
+            }
+        return mi.load_dict(scene)
+
+    ref = load()
+    scene = load(accel=accel, lazy_build=lazy_build)
+
+    b = ref.bbox()
+    n = 32
+    for x in range(n):
+        for y in range(n):
+            o = [b.min[0] + (b.max[0] - b.min[0]) * x / (n - 1),
+                 b.min[1] + (b.max[1] - b.min[1]) * y / (n - 1), b.min[2] - 1]
+            ray = mi.Ray3f(o, [0, 0, 1])
+            si, si_ref = scene.ray_intersect(ray), ref.ray_intersect(ray)
+            assert si.is_valid() == si_ref.is_valid()
+            assert scene.ray_test(ray) == si_ref.is_valid()
+            if si_ref.is_valid():
+                assert dr.allclose(si.t, si_ref.t)
+                assert si.prim_index == si_ref.prim_index
+
+    with pytest.raises(RuntimeError, match='unsupported acceleration data structure'):
+        load(accel='octree')
+
+
+@fresolver_append_path
+def test08_instance_tight_bbox(variant_scalar_rgb):
+    from mitsuba import ScalarTransform4f as T
+
+    mesh = mi.load_dict({
+        'type': 'ply',
+        'filename': 'resources/data/common/meshes/bunny_lowres.ply'
+    })
+    to_world = T().rotate([1, 1, 0], 45)
+
+    scene = mi.load_dict({
+        'type': 'scene',
+        'group_0': { 'type': 'shapegroup', 'shape': mesh },
+        'instance': {
+            'type': 'instance',
+            'group': { 'type': 'ref', 'id': 'group_0' },
+            'to_world': to_world
+        }
+    })
+
+    # Transformed bounding box of the group, and bounds of the vertices
+    b_group, b_mesh = mi.ScalarBoundingBox3f(), mi.ScalarBoundingBox3f()
+    for i in range(8):
+        b_group.expand(to_world @ mesh.bbox().corner(i))
+    p = mi.traverse(mesh)['vertex_positions']
+    for i in range(mesh.vertex_count()):
+        b_mesh.expand(to_world @ mi.ScalarPoint3f(p[3 * i], p[3 * i + 1], p[3 * i + 2]))
+
+    # The instance bounds lie in between, and are tighter than the former
+    b = scene.shapes()[0].bbox()
+    assert dr.all(b.max - b.min < b_group.max - b_group.min)
+    assert dr.all((b.min >= b_group.min - 1e-5) & (b.max <= b_group.max + 1e-5))
+    assert dr.all((b.min <= b_mesh.min + 1e-5) & (b.max >= b_mesh.max - 1e-5))
+
+
+def test09_instance_parallel_load(variants_all_rgb):
+    # Groups loaded in parallel build their acceleration data structure
+    # within their load task, which must not change the result
+    def scene(parallel):
+        scene_dict = {
+            'type': 'scene',
+            'group': {
+                'type': 'shapegroup',
+                'sphere': {'type': 'sphere', 'radius': 0.5},
+                'rect': {
+                    'type': 'rectangle',
+                    'to_world': mi.ScalarTransform4f().translate([0, 0, 1])
+                },
+            },
+        }
+        for i in range(4):
+            scene_dict[f'instance_{i}'] = {
+                'type': 'instance',
+                'shapegroup': {'type': 'ref', 'id': 'group'},
+                'to_world': mi.ScalarTransform4f().translate([2.0 * i, 0, 0])
+            }
+        return mi.load_dict(scene_dict, parallel=parallel)
+
+    x = dr.linspace(mi.Float, -1.0, 7.0, 64)
+    ray = mi.Ray3f(mi.Point3f(x, 0.1, -5.0), mi.Vector3f(0, 0, 1))
+
+    si_ref = scene(False).ray_intersect(ray)
+    si = scene(True).ray_intersect(ray)
+    assert dr.any(si_ref.is_valid())
+    assert dr.all(si.is_valid() == si_ref.is_valid())
+    assert dr.allclose(dr.select(si.is_valid(), si.t, 0),
+                       dr.select(si_ref.is_valid(), si_ref.t, 0))
+
+
+def test10_load_instances(variants_all_rgb):
+    import numpy as np
+
+    group = mi.load_dict({ 'type': 'shapegroup', 'shape': { 'type': 'sphere' } })
+
+    offsets = [[-3, 0, 0], [0, 0, 0], [3, 0, 0]]
+    transforms = np.tile(np.eye(4, dtype=np.float32), (len(offsets), 1, 1))
+    transforms[:, :3, 3] = offsets
+    instances = mi.load_instances(group, mi.TensorXf(transforms))
+    assert len(instances) == len(offsets)
+
+    scene = mi.load_dict({
+        'type': 'scene',
+        **{ 'instance_%i' % i: inst for i, inst in enumerate(instances) }
+    })
+
+    for o in offsets:
+        ray = mi.Ray3f(mi.Point3f(o[0], o[1], o[2] - 5), mi.Vector3f(0, 0, 1))
+        si = scene.ray_intersect(ray)
+        assert dr.all(si.is_valid())
+        assert dr.allclose(si.t, 4)
+        assert dr.allclose(si.p, [o[0], o[1], o[2] - 1])
+
+    with pytest.raises(ValueError, match='shape'):
+        mi.load_instances(group, mi.TensorXf(np.zeros((2, 3, 4), dtype=np.float32)))
+
+
+def test11_instance_bsdf_override(variants_all_rgb):
+    import numpy as np
+
+    def diffuse(color):
+        return mi.load_dict({
+            'type': 'diffuse',
+            'reflectance': { 'type': 'rgb', 'value': color }
+        })
+
+    group = mi.load_dict({
+        'type': 'shapegroup',
+        'shape': { 'type': 'sphere', 'bsdf': diffuse([1, 0, 0]) }
+    })
+    green, blue = diffuse([0, 1, 0]), diffuse([0, 0, 1])
+
+    offsets = [[-3, 0, 0], [0, 0, 0], [3, 0, 0]]
+    transforms = np.tile(np.eye(4, dtype=np.float32), (len(offsets), 1, 1))
+    transforms[:, :3, 3] = offsets
+    instances = mi.load_instances(group, mi.TensorXf(transforms),
+                                  bsdfs=[green, blue], bsdf_indices=[1, 0, 1])
+
+    scene = mi.load_dict({
+        'type': 'scene',
+        'plain': {
+            'type': 'instance',
+            'group': group,
+            'to_world': mi.ScalarTransform4f().translate([0, 3, 0])
+        },
+        **{ 'instance_%i' % i: inst for i, inst in enumerate(instances) }
+    })
+
+    # Color of the material at the front of every sphere
+    def color(o):
+        ray = mi.Ray3f(mi.Point3f(o[0], o[1], o[2] - 5), mi.Vector3f(0, 0, 1))
+        si = scene.ray_intersect(ray)
+        assert dr.all(si.is_valid())
+        value = si.bsdf().eval(mi.BSDFContext(), si, si.wi)
+        return [bool(dr.all(value[i] > 0)) for i in range(3)]
+
+    assert color([0, 3, 0]) == [True, False, False]
+    assert color(offsets[0]) == [False, False, True]
+    assert color(offsets[1]) == [False, True, False]
+    assert color(offsets[2]) == [False, False, True]
+
+    # The override is exposed as a parameter of the instance
+    params = mi.traverse(scene)
+    assert any(k.startswith('instance_') and '.bsdf.' in k for k in params.keys())
+    assert not any(k.startswith('plain.') for k in params.keys())
+
+    with pytest.raises(IndexError, match='out of bounds'):
+        mi.load_instances(group, mi.TensorXf(transforms), bsdfs=[green],
+                          bsdf_indices=[0, 1, 0])
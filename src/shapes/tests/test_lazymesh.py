@@ -0,0 +1,115 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+from mitsuba.scalar_rgb.test.util import fresolver_append_path
+
+
+@fresolver_append_path
+def test01_create(variant_scalar_rgb):
+    m = mi.load_dict({
+        'type': 'ply',
+        'filename': 'resources/data/tests/ply/rectangle_normals_uv.ply'
+    })
+    s = mi.load_dict({
+        'type': 'lazymesh',
+        'filename': 'resources/data/tests/ply/rectangle_normals_uv.ply'
+    })
+
+    assert s.primitive_count() == 1
+    assert s.effective_primitive_count() == m.face_count()
+    assert dr.allclose(s.bbox().min, m.bbox().min)
+    assert dr.allclose(s.bbox().max, m.bbox().max)
+    assert dr.allclose(s.surface_area(), m.surface_area())
+
+
+def test02_ray_intersect(variant_scalar_rgb, tmpdir):
+    # A bumpy grid, stored in a PLY file
+    n = 16
+    mesh = mi.Mesh('grid', (n + 1) * (n + 1), 2 * n * n)
+    positions, faces = [], []
+    for i in range(n + 1):
+        for j in range(n + 1):
+            positions += [i / n - 0.5, j / n - 0.5, 0.1 * ((i * 7 + j * 3) % 5) / 5]
+    for i in range(n):
+        for j in range(n):
+            k = i * (n + 1) + j
+            faces += [k, k + n + 1, k + 1, k + 1, k + n + 1, k + n + 2]
+    params = mi.traverse(mesh)
+    params['vertex_positions'] = positions
+    params['faces'] = faces
+    params.update()
+
+    filename = str(tmpdir.join('grid.ply'))
+    mesh.write_ply(filename)
+
+    # Three copies with a budget that only fits two of them at a time
+    budget = 2.5 * 12 * (mesh.vertex_count() + mesh.face_count()) / (1024 * 1024)
+
+    def scene(type):
+        shapes = {}
+        for i in range(3):
+            shapes['shape_%i' % i] = {
+                'type': type,
+                'filename': filename,
+                'face_normals': True,
+                'to_world': mi.ScalarTransform4f().translate([3 * i, 0, 0]),
+                'bsdf': { 'type': 'diffuse' }
+            }
+            if type == 'lazymesh':
+                shapes['shape_%i' % i]['memory_budget'] = budget
+        return mi.load_dict({ 'type': 'scene', **shapes })
+
+    ref, lazy = scene('ply'), scene('lazymesh')
+
+    for i in range(30):
+        x, y = 3 * (i % 3) + 0.013 * i - 0.2, 0.1 * (i // 3) - 0.45
+        ray = mi.Ray3f([x, y, -5], [0, 0, 1])
+        si_ref = ref.ray_intersect(ray)
+        si = lazy.ray_intersect(ray)
+        assert si.is_valid() == si_ref.is_valid()
+        assert dr.allclose(si.t, si_ref.t)
+        assert dr.allclose(si.p, si_ref.p)
+        assert dr.allclose(si.n, si_ref.n)
+        assert si.prim_index == si_ref.prim_index
+        assert si.shape.bsdf() is not None
+        assert lazy.ray_test(ray) == ref.ray_test(ray)
+
+    # Rays that miss the meshes
+    ray = mi.Ray3f([1.5, 0, -5], [0, 0, 1])
+    assert not lazy.ray_intersect(ray).is_valid()
+    assert not lazy.ray_test(ray)
+
+
+@fresolver_append_path
+def test03_errors(variant_scalar_rgb):
+    with pytest.raises(RuntimeError, match='Cannot determine the mesh format'):
+        mi.load_dict({
+            'type': 'lazymesh',
+            'filename': 'resources/data/tests/ply/rectangle_normals_uv.txt'
+        })
+
+
+@fresolver_append_path
+def test04_budget_lifetime(variant_scalar_rgb):
+    import gc
+
+    def load(**kwargs):
+        return mi.load_dict({
+            'type': 'lazymesh',
+            'filename': 'resources/data/tests/ply/rectangle_normals_uv.ply',
+            **kwargs
+        })
+
+    # The smallest budget of the existing shapes is in effect
+    a, b = load(memory_budget=4), load(memory_budget=8)
+    assert 'memory_budget = 4 MiB' in str(b)
+
+    # .. and no longer applies once its shape has been destroyed
+    del a
+    gc.collect()
+    assert 'memory_budget = 8 MiB' in str(b)
+
+    del b
+    gc.collect()
+    assert 'memory_budget = unlimited' in str(load())
@@ -212,3 +212,78 @@ def test10_shape_type(variant_scalar_rgb):
         "filename" : "resources/data/common/meshes/curve_6.txt",
     })
     assert curve.shape_type() == mi.ShapeType.LinearCurve.value;
+
+
+def test11_segment_bbox_and_intersection(variant_scalar_rgb, tmpdir):
+    # A cone between two spheres of radius 0.2 and 0.4 (as seen by the kd-tree)
+    filename = str(tmpdir.join('cone.txt'))
+    with open(filename, 'w') as f:
+        f.write('-2 0 0 0.2\n2 0 0 0.4\n')
+
+    curve = mi.load_dict({ 'type' : 'linearcurve', 'filename' : filename })
+    bbox = curve.bbox(0)
+    assert dr.allclose(bbox.min, [-2.2, -0.4, -0.4])
+    assert dr.allclose(bbox.max, [2.4, 0.4, 0.4])
+
+    # Clipped bounds only contain the spheres centered near the clip box
+    clip = mi.ScalarBoundingBox3f([-3, -1, -1], [-1, 1, 1])
+    bbox = curve.bbox(0, clip)
+    assert dr.allclose(bbox.min, [-2.2, -0.27, -0.27])
+    assert dr.allclose(bbox.max, [-1, 0.27, 0.27])
+
+    scene = mi.load_dict({ 'type' : 'scene', 'curve' : curve })
+    slope = 0.2 / 4
+    k = 1 / dr.sqrt(1 - slope**2)
+    for x in [-1.5, -0.3, 0.8, 1.9]:
+        for y in [0.0, 0.1, 0.2]:
+            ray = mi.Ray3f(o=[x, y, -5], d=[0, 0, 1])
+            si = scene.ray_intersect(ray)
+            assert si.is_valid()
+            assert scene.ray_test(ray)
+
+            # Distance from the axis on the cone tangent to both spheres
+            rho = k * (0.2 + slope * (x + 2))
+            assert dr.allclose(si.p, [x, y, -dr.sqrt(rho**2 - y**2)], atol=1e-4)
+
+            # The normal points away from the sphere touching the cone
+            s = k**2 * (x + 2 + 0.2 * slope)
+            c = mi.Point3f(-2 + s, 0, 0)
+            assert dr.allclose(si.n, dr.normalize(si.p - c), atol=1e-4)
+
+    # Rays that miss or start inside of the curve
+    assert not scene.ray_test(mi.Ray3f(o=[0, 0.5, -5], d=[0, 0, 1]))
+    assert not scene.ray_intersect(mi.Ray3f(o=[0, 0, 0], d=[0, 0, 1])).is_valid()
+
+
+def test12_split_segments(variant_scalar_rgb, tmpdir):
+    # A thin diagonal segment and a short one that doesn't need to be split
+    filename = str(tmpdir.join('diagonal.txt'))
+    with open(filename, 'w') as f:
+        f.write('0 0 0 0.02\n2 2 2 0.03\n2.01 2 2 0.03\n')
+
+    curve_ref = mi.load_dict({ 'type' : 'linearcurve', 'filename' : filename })
+    curve = mi.load_dict({ 'type' : 'linearcurve', 'filename' : filename,
+                           'split_ratio' : 4.0 })
+    assert curve_ref.primitive_count() == 2
+    assert curve.primitive_count() > 2
+
+    # The parts of the diagonal segment have much tighter bounds
+    volume = lambda b: dr.prod(b.extents())
+    assert sum(volume(curve.bbox(i)) for i in range(curve.primitive_count() - 1)) < \
+           0.25 * volume(curve_ref.bbox(0))
+    assert dr.allclose(curve.bbox().min, curve_ref.bbox().min)
+    assert dr.allclose(curve.bbox().max, curve_ref.bbox().max)
+
+    # But the curve remains the same
+    scene_ref = mi.load_dict({ 'type' : 'scene', 'curve' : curve_ref })
+    scene = mi.load_dict({ 'type' : 'scene', 'curve' : curve })
+    for t in [0.1, 0.37, 0.5, 0.92]:
+        ray = mi.Ray3f(o=[2 * t + 1, 2 * t - 1, 2 * t], d=dr.normalize(mi.Vector3f(-1, 1, 0)))
+        si_ref, si = scene_ref.ray_intersect(ray), scene.ray_intersect(ray)
+        assert si_ref.is_valid() and si.is_valid()
+        assert dr.allclose(si.t, si_ref.t, rtol=1e-4)
+        assert dr.allclose(si.n, si_ref.n, atol=1e-3)
+
+    with pytest.raises(RuntimeError, match='non-negative'):
+        mi.load_dict({ 'type' : 'linearcurve', 'filename' : filename,
+                       'split_ratio' : -1.0 })
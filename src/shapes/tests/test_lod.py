@@ -0,0 +1,49 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def lod_scene(distance, sensor_type='perspective', **kwargs):
+    T = mi.ScalarTransform4f
+    return mi.load_dict({
+        'type': 'scene',
+        'sensor': {
+            'type': sensor_type,
+            'to_world': T().look_at(origin=[0, 0, -distance], target=[0, 0, 0], up=[0, 1, 0]),
+            'film': {'type': 'hdrfilm', 'width': 64, 'height': 64}
+        },
+        'object': {
+            'type': 'lod',
+            'pixel_sizes': '10',
+            'level_0': {'type': 'sphere', 'id': 'fine'},
+            'level_1': {'type': 'cube', 'id': 'coarse'},
+        },
+        **kwargs
+    })
+
+
+def test01_select_level(variants_all_rgb):
+    # The sphere covers ~30 pixels at a distance of 5, and ~2 pixels at 100
+    scene = lod_scene(5)
+    assert [s.id() for s in scene.shapes()] == ['fine']
+    scene = lod_scene(100)
+    assert [s.id() for s in scene.shapes()] == ['coarse']
+
+    # Only the selected level is visible to rays
+    si = scene.ray_intersect(mi.Ray3f([0.95, 0.95, -100], [0, 0, 1]))
+    assert dr.all(si.is_valid())
+
+    # Without a projective camera, the finest level is used
+    scene = lod_scene(100, sensor_type='radiancemeter')
+    assert [s.id() for s in scene.shapes()] == ['fine']
+
+
+def test02_invalid_levels(variant_scalar_rgb):
+    with pytest.raises(RuntimeError, match='at least two levels'):
+        mi.load_dict({'type': 'lod', 'pixel_sizes': '',
+                      'level_0': {'type': 'sphere'}})
+
+    with pytest.raises(RuntimeError, match='expected 1 or 2 values'):
+        mi.load_dict({'type': 'lod', 'pixel_sizes': '10, 5, 1',
+                      'level_0': {'type': 'sphere'},
+                      'level_1': {'type': 'cube'}})
@@ -1,3 +1,4 @@
+import drjit as dr
 import mitsuba as mi
 
 from mitsuba.scalar_rgb.test.util import fresolver_append_path
@@ -95,3 +96,38 @@ def test02_two_shapes(variants_all_rgb):
         }
     })
     assert len(m.shapes()) == 2
+
+
+@fresolver_append_path
+def test03_many_shapes(variants_all_rgb):
+    # Merging many meshes at once matches a sequence of pairwise merges
+    T = mi.ScalarTransform4f
+    scene_dict = {
+        "type": "scene",
+        "bsdf1": { "type": "diffuse" },
+        "bsdf2": { "type": "diffuse" },
+        "parent": { "type": "merge" }
+    }
+    children, bsdf = [], mi.load_dict({ "type": "diffuse" })
+    for i in range(40):
+        child = example_mesh(bsdf={ "type": "ref", "id": "bsdf%i" % (i % 2 + 1) },
+                             to_world=T().translate([i, 0.5 * i, 0]))
+        scene_dict["parent"]["child%02i" % i] = child
+        children.append(mi.load_dict(example_mesh(bsdf=bsdf,
+                                                  to_world=T().translate([i, 0.5 * i, 0]))))
+
+    scene = mi.load_dict(scene_dict)
+    assert len(scene.shapes()) == 2
+
+    for k, shape in enumerate(sorted(scene.shapes(), key=lambda s: s.bbox().min.x)):
+        ref = children[k]
+        for child in children[k + 2::2]:
+            ref = ref.merge(child)
+
+        assert shape.vertex_count() == ref.vertex_count()
+        assert shape.face_count() == ref.face_count()
+        params, params_ref = mi.traverse(shape), mi.traverse(ref)
+        assert dr.all(params['faces'] == params_ref['faces'])
+        assert dr.allclose(params['vertex_positions'], params_ref['vertex_positions'])
+        assert dr.allclose(shape.bbox().min, ref.bbox().min)
+        assert dr.allclose(shape.bbox().max, ref.bbox().max)
@@ -368,3 +368,80 @@ def test09_shape_type(variant_scalar_rgb):
     sdf = mi.load_dict({ "type" : "sdfgrid",
                          "grid" : default_sdf_grid()})
     assert sdf.shape_type() == mi.ShapeType.SDFGrid.value
+
+
+def test10_bricks(variants_all_ad_rgb):
+    pytest.importorskip("numpy")
+    import numpy as np
+
+    # Sphere of radius 0.3 centered in the grid
+    res = 21
+    x = np.linspace(0, 1, res)
+    z, y, x = np.meshgrid(x, x, x, indexing='ij')
+    sdf_grid = np.sqrt((x - 0.5)**2 + (y - 0.5)**2 + (z - 0.5)**2) - 0.3
+    sdf_grid = sdf_grid.reshape((res, res, res, 1)).astype(np.float32)
+
+    scenes = []
+    for brick_size in [1, 3, 8, 32]:
+        shape = mi.load_dict({
+            "type" : "sdfgrid",
+            "grid" : sdf_grid,
+            "brick_size" : brick_size
+        })
+
+        # Only the bricks around the surface are stored
+        n_bricks = -(-(res - 1) // brick_size)
+        assert shape.primitive_count() < n_bricks**3 or n_bricks == 1
+
+        scenes.append(mi.load_dict({ "type" : "scene", "sdf" : shape }))
+
+    n = 9
+    for x in dr.linspace(mi.Float, 0.05, 0.95, n):
+        for y in dr.linspace(mi.Float, 0.05, 0.95, n):
+            ray = mi.Ray3f(o=mi.Vector3f(x, y, 3), d=mi.Vector3f(0.1, -0.05, -1))
+            ref = scenes[0].ray_intersect(ray)
+            for scene in scenes[1:]:
+                si = scene.ray_intersect(ray)
+                assert dr.all(si.is_valid() == ref.is_valid())
+                assert dr.all(scene.ray_test(ray) == ref.is_valid())
+                if dr.all(ref.is_valid()):
+                    assert dr.allclose(si.t, ref.t, atol=1e-5)
+                    assert dr.allclose(si.n, ref.n, atol=1e-4)
+
+
+def test11_ray_intersect_sphere(variants_vec_rgb):
+    pytest.importorskip("numpy")
+    import numpy as np
+
+    # Sphere of radius 0.35 centered in the grid
+    res = 33
+    x = np.linspace(0, 1, res)
+    z, y, x = np.meshgrid(x, x, x, indexing='ij')
+    sdf_grid = np.sqrt((x - 0.5)**2 + (y - 0.5)**2 + (z - 0.5)**2) - 0.35
+    sdf_grid = sdf_grid.reshape((res, res, res, 1)).astype(np.float32)
+
+    scene = mi.load_dict({
+        "type" : "scene",
+        "sdf" : {
+            "type" : "sdfgrid",
+            "grid" : sdf_grid,
+            "brick_size": 16
+        }
+    })
+
+    # A batch of rays, traced with packets in vectorized variants
+    n = 64
+    u, v = dr.meshgrid(dr.linspace(mi.Float, 0.1, 0.9, n),
+                       dr.linspace(mi.Float, 0.1, 0.9, n))
+    ray = mi.Ray3f(o=mi.Point3f(u, v, -1), d=mi.Vector3f(0, 0, 1))
+    si = scene.ray_intersect(ray)
+
+    r2 = (u - 0.5)**2 + (v - 0.5)**2
+    expected_hit = r2 < 0.34**2
+    expected_t = 1.5 - dr.sqrt(dr.maximum(0.35**2 - r2, 0))
+
+    assert dr.all(dr.select(expected_hit, si.is_valid(), True))
+    assert dr.allclose(dr.select(expected_hit, si.t, 0),
+                       dr.select(expected_hit, expected_t, 0), atol=2e-3)
+    assert dr.all(dr.select(r2 > 0.36**2, ~si.is_valid(), True))
+    assert dr.all(scene.ray_test(ray) == si.is_valid())
@@ -72,3 +72,39 @@ def test02_error(variant_scalar_rgb):
                 'sensor' : { 'type' : 'perspective' }
             },
         })
+
+
+def test03_concurrent_builds(variants_all_backends_once):
+    if dr.is_cuda_v(mi.Float):
+        pytest.skip('Shape groups are built by OptiX in the CUDA variants')
+
+    # Many groups, whose acceleration data structures the scene builds
+    # concurrently, one of them nested in the declaration of its instance
+    T = mi.ScalarTransform4f
+    scene_dict = { 'type' : 'scene' }
+    for i in range(16):
+        group = {
+            'type' : 'shapegroup',
+            'sphere' : { 'type' : 'sphere', 'radius' : 0.25 },
+            'rectangle' : {
+                'type' : 'rectangle',
+                'to_world' : T().translate([0, 0, 1]).scale(0.25)
+            }
+        }
+        instance = { 'type' : 'instance', 'to_world' : T().translate([i, 0, 0]) }
+        if i == 0:
+            instance['shapegroup'] = group
+        else:
+            scene_dict['group_%i' % i] = group
+            instance['shapegroup'] = { 'type' : 'ref', 'id' : 'group_%i' % i }
+        scene_dict['instance_%i' % i] = instance
+    scene = mi.load_dict(scene_dict)
+
+    for i in range(16):
+        si = scene.ray_intersect(mi.Ray3f([i, 0, -2], [0, 0, 1]))
+        assert dr.all(si.is_valid())
+        assert dr.allclose(si.t, 1.75)
+
+        # Rays between the spheres and the rectangles only hit the latter
+        si = scene.ray_intersect(mi.Ray3f([i + 0.1, 0.1, 0.5], [0, 0, 1]))
+        assert dr.allclose(si.t, 0.5)
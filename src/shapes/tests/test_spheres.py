@@ -0,0 +1,177 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def flatten(values):
+    return [v for value in values for v in value]
+
+
+def make_spheres(**kwargs):
+    centers = [[0, 0, 0], [3, 0, 0], [0, 3, 1], [-2, -2, 4]]
+    radii = [1.0, 0.5, 1.5, 0.25]
+    return mi.load_dict({
+        'type': 'spheres',
+        'centers': mi.TensorXf(flatten(centers), shape=(4, 3)),
+        'radii': mi.TensorXf(radii),
+        **kwargs
+    }), centers, radii
+
+
+def test01_create(variants_all_backends_once):
+    if dr.is_cuda_v(mi.Float):
+        pytest.skip('Not supported by the CUDA variants')
+
+    s, centers, radii = make_spheres()
+    assert s.primitive_count() == 4
+    assert s.shape_type() == mi.ShapeType.Spheres.value
+    assert dr.allclose(s.surface_area(), 4 * dr.pi * sum(r * r for r in radii))
+
+    for i in range(4):
+        center, radius = s.sphere_primitive(i)
+        assert dr.allclose(center, centers[i])
+        assert dr.allclose(radius, radii[i])
+        bbox = s.bbox(i)
+        assert dr.allclose(bbox.min, mi.ScalarPoint3f(centers[i]) - radii[i])
+        assert dr.allclose(bbox.max, mi.ScalarPoint3f(centers[i]) + radii[i])
+
+    bbox = s.bbox()
+    assert dr.allclose(bbox.min, [-2.25, -2.25, -1])
+    assert dr.allclose(bbox.max, [3.5, 4.5, 4.25])
+
+    # A shared radius and a transformation
+    s = mi.load_dict({
+        'type': 'spheres',
+        'centers': mi.TensorXf([1, 0, 0, 0, 1, 0], shape=(2, 3)),
+        'radius': 0.5,
+        'to_world': mi.ScalarTransform4f().scale(2)
+    })
+    center, radius = s.sphere_primitive(1)
+    assert dr.allclose(center, [0, 2, 0])
+    assert dr.allclose(radius, 1)
+
+    with pytest.raises(RuntimeError, match='shape \\[N, 3\\]'):
+        mi.load_dict({
+            'type': 'spheres',
+            'centers': mi.TensorXf([1, 0, 0, 0], shape=(2, 2))
+        })
+
+
+def test02_ray_intersect(variant_scalar_rgb):
+    s, centers, radii = make_spheres()
+    scene = mi.load_dict({'type': 'scene', 'spheres': s})
+
+    for i in range(4):
+        c = mi.ScalarPoint3f(centers[i])
+        ray = mi.Ray3f(c + [0.1, -0.2, -10], [0, 0, 1])
+        si = scene.ray_intersect(ray)
+        assert si.is_valid()
+        assert si.prim_index == i
+        assert dr.allclose(dr.norm(si.p - c), radii[i])
+        assert dr.allclose(si.n, dr.normalize(si.p - c))
+        assert scene.ray_test(ray)
+
+    ray = mi.Ray3f([10, 10, -10], [0, 0, 1])
+    assert not scene.ray_intersect(ray).is_valid()
+    assert not scene.ray_test(ray)
+
+
+def test03_compare_to_sphere(variant_scalar_rgb):
+    s, centers, radii = make_spheres()
+    scene = mi.load_dict({'type': 'scene', 'spheres': s})
+
+    desc = {'type': 'scene'}
+    for i in range(4):
+        desc['sphere_%i' % i] = {
+            'type': 'sphere',
+            'center': centers[i],
+            'radius': radii[i]
+        }
+    scene_ref = mi.load_dict(desc)
+
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(0)
+    for i in range(256):
+        o = mi.warp.square_to_uniform_sphere(sampler.next_2d()) * 10
+        d = dr.normalize(mi.Vector3f(sampler.next_1d() * 6 - 3,
+                                     sampler.next_1d() * 6 - 3,
+                                     sampler.next_1d() * 6) - o)
+        ray = mi.Ray3f(o, d)
+        si, si_ref = scene.ray_intersect(ray), scene_ref.ray_intersect(ray)
+        assert si.is_valid() == si_ref.is_valid()
+        if si_ref.is_valid():
+            assert dr.allclose(si.t, si_ref.t)
+            assert dr.allclose(si.n, si_ref.n, atol=1e-5)
+            assert dr.allclose(si.uv, si_ref.uv, atol=1e-5)
+            assert dr.allclose(si.dp_du, si_ref.dp_du, atol=1e-4)
+            assert dr.allclose(si.dp_dv, si_ref.dp_dv, atol=1e-4)
+
+
+@pytest.mark.parametrize('width', [4, 8])
+def test04_kdtree_packets(variant_scalar_rgb, width):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    def load(**kwargs):
+        rng = mi.PCG32(initstate=2)
+        centers = [rng.next_float32() * 4 - 2 for i in range(300)]
+        radii = [rng.next_float32() * 0.2 + 0.01 for i in range(100)]
+        return mi.load_dict({
+            'type': 'scene',
+            'spheres': {
+                'type': 'spheres',
+                'centers': mi.TensorXf(centers, shape=(100, 3)),
+                'radii': mi.TensorXf(radii)
+            },
+            'rectangle': {'type': 'rectangle'},
+            **kwargs
+        })
+
+    scene_ref = load()
+    scene = load(kd_triangle_packets=width)
+
+    n = 32
+    for x in range(n):
+        for y in range(n):
+            o = [-2.5 + 5 * x / (n - 1), -2.5 + 5 * y / (n - 1), -3]
+            r = mi.Ray3f(o, [0, 0, 1])
+            res_ref, res = scene_ref.ray_intersect(r), scene.ray_intersect(r)
+            assert res.is_valid() == res_ref.is_valid()
+            if res_ref.is_valid():
+                assert dr.allclose(res.t, res_ref.t)
+                assert res.prim_index == res_ref.prim_index
+            assert scene.ray_test(r) == res_ref.is_valid()
+
+
+def test05_sample_position(variants_vec_backends_once):
+    if dr.is_cuda_v(mi.Float):
+        pytest.skip('Not supported by the CUDA variants')
+
+    s, centers, radii = make_spheres()
+    n = 10000
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(0, n)
+
+    ps = s.sample_position(0, sampler.next_2d())
+    center = dr.gather(mi.Point3f, mi.Float(flatten(centers)), ps.prim_index)
+    radius = dr.gather(mi.Float, mi.Float(radii), ps.prim_index)
+    assert dr.allclose(dr.norm(ps.p - center), radius, atol=1e-5)
+    assert dr.allclose(ps.n, (ps.p - center) / radius, atol=1e-4)
+    assert dr.allclose(ps.pdf, 1 / s.surface_area())
+
+    # Spheres are selected proportionally to their area
+    area = [r * r for r in radii]
+    for i in range(4):
+        count = dr.count(ps.prim_index == i)
+        assert dr.allclose(count / n, area[i] / sum(area), atol=2e-2)
+
+
+def test06_parameters(variant_scalar_rgb):
+    s, centers, radii = make_spheres()
+    params = mi.traverse(s)
+    assert 'centers' in params and 'radii' in params
+
+    params['radii'] = type(params['radii'])([2.0, 0.5, 1.5, 0.25])
+    params.update()
+    assert dr.allclose(s.bbox(0).max, [2, 2, 2])
+    assert dr.allclose(s.sphere_primitive(0)[1], 2)
@@ -292,6 +292,13 @@ public:
             return false;
     }
 
+    uint32_t ray_flags() const override {
+        if (m_nested_texture)
+            return m_nested_texture->ray_flags();
+        else
+            return +RayFlags::Empty;
+    }
+
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "D65Spectrum[" << std::endl;
@@ -0,0 +1,375 @@
+#include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/thread.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/shape.h>
+#include <mitsuba/render/texture.h>
+#include <mitsuba/render/srgb.h>
+#include <cstring>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _texture-atlas:
+
+Texture atlas (:monosp:`atlas`)
+-------------------------------
+
+.. pluginparameters::
+
+ * - filename_0, filename_1, ...
+   - |string|
+   - Filenames of the packed images. The indices must be consecutive,
+     starting at zero.
+
+ * - index
+   - |string|
+   - Name of a mesh attribute (starting with ``vertex_`` or ``face_``) that
+     stores the index of the image used at every point of a shape. When
+     unspecified, the integer part of the U coordinate selects the image, i.e.
+     image :math:`i` covers the UV range :math:`[i, i + 1] \times [0, 1]`.
+     (Default: unused)
+
+ * - filter_type
+   - |string|
+   - Specifies how pixel values are interpolated: ``bilinear`` (default) or
+     ``nearest``.
+
+ * - wrap_mode
+   - |string|
+   - Controls the behavior of lookups outside of the :math:`[0, 1]` range of
+     an image: ``repeat`` (default), ``mirror``, or ``clamp``.
+
+ * - raw
+   - |bool|
+   - Should the transformation to the stored color data (e.g. sRGB to linear,
+     spectral upsampling) be disabled? (Default: false)
+
+ * - to_uv
+   - |transform|
+   - Specifies an optional 3x3 transformation matrix that will be applied to UV
+     values. A 4x4 matrix can also be provided, in which case the extra row and
+     column are ignored.
+   - |exposed|
+
+This plugin packs many small images into a single texture. Scenes with
+thousands of :ref:`bitmap <texture-bitmap>` textures, each referenced by its
+own BSDF, pay for a dispatch over all of these BSDFs and textures at every
+evaluation in the vectorized variants, and for one hardware texture per image
+in the CUDA variants. Instead, the shapes can share a single BSDF with an
+atlas, and store the index of their image in a mesh attribute. A texture
+evaluation then reduces to some index arithmetic and the (gather-based) lookup
+of the texels of one image in a single buffer.
+
+The images are stored back to back rather than on a common 2D canvas: the
+wrap mode and the bilinear filter operate within the bounds of each image,
+hence neighboring images never bleed into each other and no padding is
+needed. The images may have different resolutions, but must all be either
+monochromatic or color images (any alpha channel is ignored). Lookups with an
+invalid index evaluate to zero. The mean of the texture is the average of the
+means of the images.
+
+.. tabs::
+    .. code-tab:: python
+
+        'type': 'atlas',
+        'filename_0': 'textures/wood.png',
+        'filename_1': 'textures/stone.png',
+        'index': 'face_texture'
+ */
+
+template <typename Float, typename Spectrum>
+class AtlasTexture final : public Texture<Float, Spectrum> {
+public:
+    MI_IMPORT_TYPES(Texture, Shape)
+
+    using FloatStorage  = DynamicBuffer<Float>;
+    using UInt32Storage = DynamicBuffer<UInt32>;
+
+    AtlasTexture(const Properties &props) : Texture(props) {
+        m_transform = props.get<ScalarTransform3f>("to_uv", ScalarTransform3f());
+        m_raw = props.get<bool>("raw", false);
+
+        std::string filter_mode_str = props.string("filter_type", "bilinear");
+        if (filter_mode_str == "nearest")
+            m_filter_mode = dr::FilterMode::Nearest;
+        else if (filter_mode_str == "bilinear")
+            m_filter_mode = dr::FilterMode::Linear;
+        else
+            Throw("Invalid filter type \"%s\", must be one of: \"nearest\", or "
+                  "\"bilinear\"!", filter_mode_str);
+
+        std::string wrap_mode_str = props.string("wrap_mode", "repeat");
+        if (wrap_mode_str == "repeat")
+            m_wrap_mode = dr::WrapMode::Repeat;
+        else if (wrap_mode_str == "mirror")
+            m_wrap_mode = dr::WrapMode::Mirror;
+        else if (wrap_mode_str == "clamp")
+            m_wrap_mode = dr::WrapMode::Clamp;
+        else
+            Throw("Invalid wrap mode \"%s\", must be one of: \"repeat\", "
+                  "\"mirror\", or \"clamp\"!", wrap_mode_str);
+
+        if (props.has_property("index")) {
+            m_index = props.string("index");
+            if (m_index.find("vertex_") != 0 && m_index.find("face_") != 0)
+                Throw("Invalid mesh attribute name \"%s\": must start with "
+                      "either \"vertex_\" or \"face_\"!", m_index);
+            m_index_handle = Shape::attribute_handle(m_index);
+        }
+
+        // Pack all images into a single buffer
+        FileResolver *fs = Thread::thread()->file_resolver();
+        std::vector<float> data;
+        std::vector<uint32_t> offsets, widths, heights;
+        double mean = 0.0;
+
+        for (size_t i = 0;; ++i) {
+            std::string name = "filename_" + std::to_string(i);
+            if (!props.has_property(name))
+                break;
+
+            fs::path path = fs->resolve(props.string(name));
+            ref<Bitmap> bitmap = new Bitmap(path);
+            uint32_t channels = (bitmap->pixel_format() == Bitmap::PixelFormat::Y ||
+                                 bitmap->pixel_format() == Bitmap::PixelFormat::YA) ? 1 : 3;
+            if (i == 0)
+                m_channels = channels;
+            else if (channels != m_channels)
+                Throw("The images of a texture atlas must either all be "
+                      "monochromatic or color images (\"%s\" differs)!",
+                      path.string());
+
+            ScalarVector2u res;
+            std::unique_ptr<float[]> texels = read_image(bitmap, res);
+            size_t count = (size_t) dr::prod(res) * m_channels;
+
+            if (data.size() + count > (size_t) 0xFFFFFFFFu)
+                Throw("The images of the texture atlas are too large to be "
+                      "packed into a single buffer!");
+
+            offsets.push_back((uint32_t) data.size());
+            widths.push_back(res.x());
+            heights.push_back(res.y());
+            data.insert(data.end(), texels.get(), texels.get() + count);
+            mean += image_mean(texels.get(), res);
+            m_res = dr::maximum(m_res, ScalarVector2i(res));
+        }
+
+        m_count = (uint32_t) offsets.size();
+        if (m_count == 0)
+            Throw("A texture atlas requires at least one image (\"filename_0\")!");
+
+        m_mean = (ScalarFloat) (mean / (double) m_count);
+        m_offsets = dr::load<UInt32Storage>(offsets.data(), offsets.size());
+        m_widths = dr::load<UInt32Storage>(widths.data(), widths.size());
+        m_heights = dr::load<UInt32Storage>(heights.data(), heights.size());
+        m_data = dr::load<FloatStorage>(data.data(), data.size());
+
+        Log(Debug, "Packed %u images into a texture atlas (%s)", m_count,
+            util::mem_string(data.size() * sizeof(float)));
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_parameter("to_uv", m_transform, +ParamFlags::NonDifferentiable);
+    }
+
+    UnpolarizedSpectrum eval(const SurfaceInteraction3f &si,
+                             Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channels == 3 && is_spectral_v<Spectrum> && m_raw)
+            Throw("The texture atlas %s was queried for a spectrum, but "
+                  "texture conversion into spectra was explicitly disabled! "
+                  "(raw=true)", to_string());
+
+        Color3f color = lookup(si, active);
+
+        if (m_channels == 1)
+            return color.x();
+        else if constexpr (is_monochromatic_v<Spectrum>)
+            return luminance(color);
+        else if constexpr (is_spectral_v<Spectrum>)
+            return srgb_model_eval<UnpolarizedSpectrum>(color, si.wavelengths);
+        else
+            return color;
+    }
+
+    Float eval_1(const SurfaceInteraction3f &si,
+                 Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channels == 3 && is_spectral_v<Spectrum> && !m_raw)
+            Throw("eval_1(): The texture atlas %s was queried for a "
+                  "monochromatic value, but texture conversion to color "
+                  "spectra had previously been requested! (raw=false)",
+                  to_string());
+
+        Color3f color = lookup(si, active);
+        return m_channels == 1 ? color.x() : luminance(color);
+    }
+
+    Color3f eval_3(const SurfaceInteraction3f &si,
+                   Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channels != 3)
+            Throw("eval_3(): The texture atlas %s was queried for a RGB "
+                  "value, but it is monochromatic!", to_string());
+        else if (is_spectral_v<Spectrum> && !m_raw)
+            Throw("eval_3(): The texture atlas %s was queried for a RGB "
+                  "value, but texture conversion to color spectra had "
+                  "previously been requested! (raw=false)", to_string());
+
+        return lookup(si, active);
+    }
+
+    Float mean() const override { return m_mean; }
+
+    ScalarVector2i resolution() const override { return m_res; }
+
+    bool is_spatially_varying() const override { return true; }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "AtlasTexture[" << std::endl
+            << "  images = " << m_count << "," << std::endl;
+        if (!m_index.empty())
+            oss << "  index = \"" << m_index << "\"," << std::endl;
+        oss << "  raw = " << (int) m_raw << "," << std::endl
+            << "  transform = " << string::indent(m_transform) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+private:
+    /// Evaluate the texture at the given surface interaction
+    Color3f lookup(const SurfaceInteraction3f &si, Mask active) const {
+        Point2f uv = m_transform.transform_affine(si.uv);
+
+        // Image used by the lookup
+        Int32 index;
+        if (!m_index.empty()) {
+            index = dr::round2int<Int32>(
+                si.shape->eval_attribute_1(m_index_handle, si, active));
+        } else {
+            index = dr::floor2int<Int32>(uv.x());
+            uv.x() -= Float(index);
+        }
+        active &= index >= 0 && index < (int32_t) m_count;
+
+        UInt32 offset = dr::gather<UInt32>(m_offsets, UInt32(index), active);
+        Vector2i res(Int32(dr::gather<UInt32>(m_widths, UInt32(index), active)),
+                     Int32(dr::gather<UInt32>(m_heights, UInt32(index), active)));
+
+        auto fetch = [&](const Point2i &p_) {
+            Point2i p = wrap(p_, res);
+            UInt32 i = offset + UInt32(p.y() * res.x() + p.x()) * m_channels;
+            Float r = dr::gather<Float>(m_data, i, active);
+            if (m_channels == 1)
+                return Color3f(r);
+            return Color3f(r, dr::gather<Float>(m_data, i + 1u, active),
+                           dr::gather<Float>(m_data, i + 2u, active));
+        };
+
+        Point2f res_f(res);
+        if (m_filter_mode == dr::FilterMode::Nearest)
+            return fetch(dr::floor2int<Point2i>(uv * res_f));
+
+        uv = dr::fmadd(uv, res_f, -.5f);
+        Point2i p = dr::floor2int<Point2i>(uv);
+        Point2f w1 = uv - Point2f(p), w0 = 1.f - w1;
+
+        Color3f v00 = fetch(p),
+                v10 = fetch(p + Point2i(1, 0)),
+                v01 = fetch(p + Point2i(0, 1)),
+                v11 = fetch(p + Point2i(1, 1));
+
+        Color3f v0 = dr::fmadd(w0.x(), v00, w1.x() * v10),
+                v1 = dr::fmadd(w0.x(), v01, w1.x() * v11);
+        return dr::fmadd(w0.y(), v0, w1.y() * v1);
+    }
+
+    /// Apply the wrap mode to integer texel coordinates of an image
+    Point2i wrap(Point2i p, const Vector2i &res) const {
+        if (m_wrap_mode == dr::WrapMode::Clamp)
+            return dr::clip(p, 0, res - 1);
+
+        if (m_wrap_mode == dr::WrapMode::Repeat) {
+            p = p - (p / res) * res;
+            return dr::select(p < 0, p + res, p);
+        }
+
+        // Mirror: the pattern repeats with a period of twice the resolution
+        Vector2i period = 2 * res;
+        p = p - (p / period) * period;
+        p = dr::select(p < 0, p + period, p);
+        return dr::select(p >= res, period - 1 - p, p);
+    }
+
+    /// Convert the texels of an image to (linear) float values
+    std::unique_ptr<float[]> read_image(const Bitmap *bitmap, ScalarVector2u &res) const {
+        ref<Bitmap> converted = bitmap->convert(
+            m_channels == 1 ? Bitmap::PixelFormat::Y : Bitmap::PixelFormat::RGB,
+            Struct::Type::Float32, m_raw ? bitmap->srgb_gamma() : false);
+
+        res = ScalarVector2u(converted->size());
+        size_t count = (size_t) dr::prod(res) * m_channels;
+        std::unique_ptr<float[]> data(new float[count]);
+        std::memcpy(data.get(), converted->data(), count * sizeof(float));
+
+        // Convert RGB texels to spectral coefficients (if requested)
+        if (is_spectral_v<Spectrum> && !m_raw && m_channels == 3) {
+            for (size_t j = 0; j < count; j += 3) {
+                ScalarColor3f value = srgb_model_fetch(
+                    ScalarColor3f(data[j], data[j + 1], data[j + 2]));
+                for (size_t k = 0; k < 3; ++k)
+                    data[j + k] = value[k];
+            }
+        }
+
+        return data;
+    }
+
+    /// Mean value of the converted texels of an image
+    double image_mean(const float *data, const ScalarVector2u &res) const {
+        double sum = 0.0;
+        size_t pixel_count = (size_t) dr::prod(res);
+        for (size_t i = 0; i < pixel_count; ++i) {
+            const float *v = data + i * m_channels;
+            if (m_channels == 1)
+                sum += v[0];
+            else if (is_spectral_v<Spectrum> && !m_raw)
+                sum += srgb_model_mean(ScalarVector3f(v[0], v[1], v[2]));
+            else
+                sum += luminance(ScalarColor3f(v[0], v[1], v[2]));
+        }
+        return sum / (double) pixel_count;
+    }
+
+private:
+    std::string m_index;
+    uint32_t m_index_handle = 0;
+    ScalarTransform3f m_transform;
+    dr::FilterMode m_filter_mode;
+    dr::WrapMode m_wrap_mode;
+    bool m_raw;
+    uint32_t m_channels = 0;
+    uint32_t m_count = 0;
+    ScalarVector2i m_res = 0;
+    ScalarFloat m_mean = 0.f;
+
+    /// Packed texels and layout of the images
+    FloatStorage m_data;
+    UInt32Storage m_offsets, m_widths, m_heights;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(AtlasTexture, Texture)
+MI_EXPORT_PLUGIN(AtlasTexture, "Texture atlas")
+NAMESPACE_END(mitsuba)
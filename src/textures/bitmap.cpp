@@ -2,15 +2,20 @@
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/plugin.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/resource.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/distr_2d.h>
 #include <mitsuba/render/interaction.h>
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/srgb.h>
+#include <drjit/color.h>
 #include <drjit/tensor.h>
 #include <drjit/texture.h>
+#include <nanothread/nanothread.h>
 #include <mutex>
 
+#include "blockcompression.h"
+
 NAMESPACE_BEGIN(mitsuba)
 
 /**!
@@ -49,6 +54,14 @@ Bitmap texture (:monosp:`bitmap`)
      - ``nearest``: disable filtering and interpolation. In this mode, the plugin
        performs nearest neighbor lookups of texture values.
 
+     - ``trilinear``: build a MIP map pyramid when the texture is loaded and
+       blend bilinear lookups into the two levels that match the footprint of
+       the lookup. The footprint is given by the UV partials of the surface
+       interaction (see :code:`SurfaceInteraction3f.duv_dx`), which integrators
+       compute from the ray differentials of camera rays. Lookups without UV
+       partials fall back to bilinear interpolation on the full resolution
+       level.
+
  * - wrap_mode
    - |string|
    - Controls the behavior of texture evaluations that fall outside of the
@@ -76,6 +89,29 @@ Bitmap texture (:monosp:`bitmap`)
 
      - ``fp16``: Forcibly store the texture in half precision
 
+     - ``fp32``: Forcibly store the texture in single precision
+
+     - ``u8_srgb``: Store the texture with 8 bits per channel. Unless
+         :paramtype:`raw` is set, values are sRGB-encoded and linearized by a
+         lookup table on every fetch, so 8-bit sRGB images keep their source
+         size. This format is not differentiable and does not support
+         :code:`sample_position()` or spectral upsampling.
+
+     - ``bc1``: Store a RGB texture with values in :math:`[0, 1]` using block
+         compression (4 bits per pixel, endpoints in RGB565). sRGB-encoded
+         bitmaps stay encoded and are linearized after decoding.
+
+     - ``bc4``: Store a monochromatic texture with values in :math:`[0, 1]`
+         using block compression (4 bits per pixel).
+
+     - ``bc5``: Store a normal map (which requires :paramtype:`raw`) using
+         block compression of its first two channels (8 bits per pixel). The
+         third channel is reconstructed from them.
+
+     The block-compressed formats are compressed in parallel when the
+     texture is loaded and are decoded by every lookup. They are not
+     differentiable and do not support :code:`sample_position()`.
+
  * - raw
    - |bool|
    - Should the transformation to the stored color data (e.g. sRGB to linear,
@@ -95,6 +131,12 @@ Bitmap texture (:monosp:`bitmap`)
      cause small differences as hardware interpolation methods typically have a
      loss of precision (not exactly 32-bit arithmetic). (Default: true)
 
+ * - memoize
+   - |bool|
+   - Remember the most recent lookups of each thread in scalar variants, so
+     that repeated queries at the same shading point (e.g. of a roughness map
+     shared by several BSDF lobes) are free. (Default: false)
+
 This plugin provides a bitmap texture that performs interpolated lookups given
 a JPEG, PNG, OpenEXR, RGBE, TGA, or BMP input file.
 
@@ -132,6 +174,14 @@ at all.
 template <typename Float, typename Spectrum, typename StoredType>
 class BitmapTextureImpl;
 
+// Forward declaration of block-compressed bitmap texture
+template <typename Float, typename Spectrum>
+class BitmapTextureBC;
+
+// Forward declaration of 8-bit bitmap texture
+template <typename Float, typename Spectrum>
+class BitmapTextureU8;
+
 template <typename Float, typename Spectrum>
 class BitmapTexture final : public Texture<Float, Spectrum> {
 public:
@@ -144,17 +194,22 @@ public:
            (e.g. sRGB to linear, spectral upsampling, etc.) */
         m_raw = props.get<bool>("raw", false);
         m_accel = props.get<bool>("accel", true);
+        m_memoize = props.get<bool>("memoize", false);
 
         // Filter mode
         {
             std::string filter_mode_str = props.string("filter_type", "bilinear");
+            m_mipmap = false;
             if (filter_mode_str == "nearest")
                 m_filter_mode = dr::FilterMode::Nearest;
             else if (filter_mode_str == "bilinear")
                 m_filter_mode = dr::FilterMode::Linear;
-            else
-                Throw("Invalid filter type \"%s\", must be one of: \"nearest\", or "
-                      "\"bilinear\"!", filter_mode_str);
+            else if (filter_mode_str == "trilinear") {
+                m_filter_mode = dr::FilterMode::Linear;
+                m_mipmap = true;
+            } else
+                Throw("Invalid filter type \"%s\", must be one of: \"nearest\", "
+                      "\"bilinear\", or \"trilinear\"!", filter_mode_str);
         }
 
         // Wrap mode
@@ -180,9 +235,20 @@ public:
                 m_format = Format::Variant;
             else if (format_str == "fp16")
                 m_format = Format::Float16;
+            else if (format_str == "fp32")
+                m_format = Format::Float32;
+            else if (format_str == "u8_srgb")
+                m_format = Format::UInt8;
+            else if (format_str == "bc1")
+                m_format = Format::BC1;
+            else if (format_str == "bc4")
+                m_format = Format::BC4;
+            else if (format_str == "bc5")
+                m_format = Format::BC5;
             else
                 Throw("Invalid format \"%s\", must be one of: \"auto\", "
-                      "\"variant\", or \"fp16\"!", format_str);
+                      "\"variant\", \"fp16\", \"fp32\", \"u8_srgb\", "
+                      "\"bc1\", \"bc4\", or \"bc5\"!", format_str);
         }
 
         // Store
@@ -204,7 +270,9 @@ public:
                 fs::path file_path = fs->resolve(props.string("filename"));
                 m_name = file_path.filename().string();
                 Log(Debug, "Loading bitmap texture from \"%s\" ..", m_name);
-                m_bitmap = new Bitmap(file_path);
+                // Textures that reference the same file share a single bitmap
+                m_bitmap = ResourceCache::get<Bitmap>(file_path);
+                m_shared = true;
             } else if (props.has_property("data")) {
                 m_tensor = props.tensor<TensorXf>("data");
                 if (m_tensor->ndim() != 3)
@@ -227,6 +295,22 @@ public:
 
 protected:
     Object* expand_1() const {
+        bool compressed = m_format == Format::BC1 || m_format == Format::BC4 ||
+                          m_format == Format::BC5;
+        if (compressed) {
+            if (!m_bitmap)
+                Throw("Block-compressed formats require a \"bitmap\" or "
+                      "\"filename\" parameter!");
+            return expand_compressed();
+        }
+
+        if (m_format == Format::UInt8) {
+            if (!m_bitmap)
+                Throw("The \"u8_srgb\" format requires a \"bitmap\" or "
+                      "\"filename\" parameter!");
+            return expand_uint8();
+        }
+
         if (m_bitmap) {
             Format format = m_format;
             // Format auto means we store texture as FP16 when possible.
@@ -241,12 +325,14 @@ protected:
 
             if (format == Format::Float16)
                 return expand_bitmap<dr::replace_scalar_t<Float, dr::half>>();
+            else if (format == Format::Float32)
+                return expand_bitmap<dr::replace_scalar_t<Float, float>>();
             else
                return expand_bitmap<Float>();
         }
 
         // Otherwise, initializing using tensor
-        Properties props;
+        Properties props = impl_props();
         TensorXf tensor(*m_tensor);
         return new BitmapTextureImpl<Float, Spectrum, Float>(
             props,
@@ -254,6 +340,7 @@ protected:
             m_transform,
             m_filter_mode,
             m_wrap_mode,
+            m_mipmap,
             m_raw,
             m_accel,
             tensor);
@@ -287,7 +374,7 @@ protected:
         if (m_raw) {
             /* Don't undo gamma correction in the conversion below.
                This is needed, e.g., for normal maps. */
-            m_bitmap->set_srgb_gamma(false);
+            disable_srgb_gamma();
         }
 
         // Convert the image into the working floating point representation
@@ -313,47 +400,151 @@ protected:
         size_t shape[3] = { (size_t) res.y(), (size_t) res.x(), channels };
         StoredTensorXf tensor = StoredTensorXf(m_bitmap->data(), 3, shape);
 
-        Properties props;
+        Properties props = impl_props();
         return new BitmapTextureImpl<Float, Spectrum, StoredType>(
             props,
             m_name,
             m_transform,
             m_filter_mode,
             m_wrap_mode,
+            m_mipmap,
             m_raw,
             m_accel,
             tensor);
     }
 
+    Object* expand_uint8() const {
+        if (m_raw)
+            disable_srgb_gamma();
+
+        Bitmap::PixelFormat pixel_format;
+        switch (m_bitmap->pixel_format()) {
+            case Bitmap::PixelFormat::Y:
+            case Bitmap::PixelFormat::YA:
+                pixel_format = Bitmap::PixelFormat::Y;
+                break;
+
+            case Bitmap::PixelFormat::RGB:
+            case Bitmap::PixelFormat::RGBA:
+            case Bitmap::PixelFormat::XYZ:
+            case Bitmap::PixelFormat::XYZA:
+                pixel_format = Bitmap::PixelFormat::RGB;
+                if (is_spectral_v<Spectrum> && !m_raw)
+                    Throw("The \"u8_srgb\" format cannot store spectral "
+                          "upsampling coefficients, use raw=true or another "
+                          "format!");
+                break;
+
+            default:
+                Throw("The texture needs to have a known pixel "
+                      "format (Y[A], RGB[A], XYZ[A] are supported).");
+        }
+
+        /* Keep (or produce) sRGB-encoded bytes, which are linearized when
+           fetched. This is a no-op for 8-bit sRGB images. */
+        ref<Bitmap> bitmap =
+            m_bitmap->convert(pixel_format, Struct::Type::UInt8, !m_raw);
+
+        return new BitmapTextureU8<Float, Spectrum>(
+            impl_props(), m_name, m_transform, m_filter_mode, m_wrap_mode,
+            !m_raw, m_raw, bitmap.get());
+    }
+
+    Object* expand_compressed() const {
+        BlockFormat format = m_format == Format::BC1 ? BlockFormat::BC1 :
+                             m_format == Format::BC4 ? BlockFormat::BC4 :
+                                                       BlockFormat::BC5;
+
+        if (format == BlockFormat::BC5 && !m_raw)
+            Throw("The \"bc5\" format is meant for normal maps and requires "
+                  "raw=true!");
+        if (format == BlockFormat::BC1 && is_spectral_v<Spectrum> && !m_raw)
+            Throw("Block-compressed formats cannot store spectral upsampling "
+                  "coefficients, use raw=true or another format!");
+
+        if (m_raw)
+            disable_srgb_gamma();
+
+        // Compress sRGB-encoded colors as they are (like *_SRGB GPU formats)
+        bool srgb = format == BlockFormat::BC1 && m_bitmap->srgb_gamma();
+        Bitmap::PixelFormat pixel_format = format == BlockFormat::BC4
+                                               ? Bitmap::PixelFormat::Y
+                                               : Bitmap::PixelFormat::RGB;
+        ref<Bitmap> bitmap =
+            m_bitmap->convert(pixel_format, Struct::Type::Float32, srgb);
+
+        return new BitmapTextureBC<Float, Spectrum>(
+            impl_props(), m_name, m_transform, m_filter_mode, m_wrap_mode,
+            format, srgb, m_raw, bitmap.get());
+    }
+
 private:
+    /// Properties of the texture implementation
+    Properties impl_props() const {
+        Properties props;
+        props.set_bool("memoize", m_memoize);
+        return props;
+    }
+
     /// Convert RGB values to spectral coefficients and store them
+    /// Clear the sRGB flag of the bitmap, copying it first if it is shared
+    void disable_srgb_gamma() const {
+        if (!m_bitmap->srgb_gamma())
+            return;
+        if (m_shared) {
+            m_bitmap = new Bitmap(*m_bitmap);
+            m_shared = false;
+        }
+        m_bitmap->set_srgb_gamma(false);
+    }
+
     template <typename StoredScalar> void convert_spectral() const {
         StoredScalar *ptr = (StoredScalar*) m_bitmap->data();
         size_t pixel_count = m_bitmap->pixel_count();
 
-        if (m_bitmap->channel_count() == 3) {
-            for (size_t i = 0; i < pixel_count; ++i) {
-                ScalarColor3f value = dr::load<ScalarColor3f>(ptr);
-                value = srgb_model_fetch(value);
-                dr::store(ptr, value);
-                ptr += 3;
+        if (m_bitmap->channel_count() != 3 || pixel_count == 0)
+            return;
+
+        auto convert = [ptr](size_t i) {
+            StoredScalar *p = ptr + 3 * i;
+            dr::store(p, srgb_model_fetch(dr::load<ScalarColor3f>(p)));
+        };
+
+        /* Convert the first pixel on the current thread, which loads the
+           upsampling model using its file resolver */
+        convert(0);
+
+        dr::parallel_for(
+            dr::blocked_range<size_t>(1, pixel_count, 1 << 14),
+            [&](const dr::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    convert(i);
             }
-        }
+        );
     }
 
     enum class Format {
         Auto,
         Variant,
-        Float16
+        Float16,
+        Float32,
+        UInt8,
+        BC1,
+        BC4,
+        BC5
     } m_format;
 
     bool m_accel;
     bool m_raw;
+    bool m_mipmap;
+    bool m_memoize;
     ScalarTransform3f m_transform;
     std::string m_name;
     dr::FilterMode m_filter_mode;
     dr::WrapMode m_wrap_mode;
     mutable ref<Bitmap> m_bitmap;
+    /// Whether \c m_bitmap is shared through the \ref ResourceCache
+    mutable bool m_shared = false;
     TensorXf* m_tensor;
 };
 
@@ -372,6 +563,7 @@ public:
             const ScalarTransform3f& transform,
             dr::FilterMode filter_mode,
             dr::WrapMode wrap_mode,
+            bool mipmap,
             bool raw,
             bool accel,
             StoredTensorXf& tensor) :
@@ -380,6 +572,7 @@ public:
         m_transform(transform),
         m_accel(accel),
         m_raw(raw),
+        m_mipmap(mipmap),
         m_texture(tensor, accel, accel, filter_mode, wrap_mode) {
 
         /* Compute mean without migrating texture data
@@ -387,6 +580,11 @@ public:
            For CUDA-variants, ideally want to solely keep data as CUDA texture
         */
         rebuild_internals(tensor, true, false);
+
+        if (m_mipmap)
+            build_mipmap(tensor);
+
+        this->set_memoized(props.get<bool>("memoize", false));
     }
 
     void traverse(TraversalCallback *callback) override {
@@ -396,6 +594,8 @@ public:
 
     void
     parameters_changed(const std::vector<std::string> &keys = {}) override {
+        this->reset_memoized();
+
         if (keys.empty() || string::contains(keys, "data")) {
             const size_t channels = m_texture.shape()[2];
             if (channels != 1 && channels != 3)
@@ -410,11 +610,19 @@ public:
 
             m_texture.set_tensor(m_texture.tensor());
             rebuild_internals(m_texture.tensor(), true, m_distr2d != nullptr);
+            if (m_mipmap)
+                build_mipmap(m_texture.tensor());
         }
     }
 
     UnpolarizedSpectrum eval(const SurfaceInteraction3f &si,
                              Mask active) const override {
+        return this->template memoize<UnpolarizedSpectrum>(
+            si, active, [&]() { return eval_direct(si, active); });
+    }
+
+    UnpolarizedSpectrum eval_direct(const SurfaceInteraction3f &si,
+                                    Mask active) const {
         MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
 
         const size_t channels = m_texture.shape()[2];
@@ -449,6 +657,12 @@ public:
 
     Float eval_1(const SurfaceInteraction3f &si,
                  Mask active = true) const override {
+        return this->template memoize<Float>(
+            si, active, [&]() { return eval_1_direct(si, active); });
+    }
+
+    Float eval_1_direct(const SurfaceInteraction3f &si,
+                        Mask active) const {
         MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
 
         const size_t channels = m_texture.shape()[2];
@@ -550,6 +764,12 @@ public:
 
     Color3f eval_3(const SurfaceInteraction3f &si,
                    Mask active = true) const override {
+        return this->template memoize<Color3f>(
+            si, active, [&]() { return eval_3_direct(si, active); });
+    }
+
+    Color3f eval_3_direct(const SurfaceInteraction3f &si,
+                          Mask active) const {
         MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
 
         const size_t channels = m_texture.shape()[2];
@@ -684,12 +904,19 @@ public:
 
     bool is_spatially_varying() const override { return true; }
 
+    /* The MIP map level is selected from the UV partials, which are computed
+       from the position partials (see SurfaceInteraction::compute_uv_partials) */
+    uint32_t ray_flags() const override {
+        return m_mipmap ? (RayFlags::UV | RayFlags::dPdUV) : +RayFlags::UV;
+    }
+
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "BitmapTexture[" << std::endl
             << "  name = \"" << m_name << "\"," << std::endl
             << "  resolution = \"" << resolution() << "\"," << std::endl
             << "  raw = " << (int) m_raw << "," << std::endl
+            << "  mip_levels = " << m_mip_levels.size() + 1 << "," << std::endl
             << "  mean = " << m_mean << "," << std::endl
             << "  transform = " << string::indent(m_transform) << std::endl
             << "]";
@@ -710,7 +937,11 @@ protected:
 
         Point2f uv = m_transform.transform_affine(si.uv);
 
-        if (m_texture.filter_mode() == dr::FilterMode::Linear) {
+        if (!m_mip_levels.empty()) {
+            Color3f out;
+            interpolate_mipmap(si, uv, out.data(), active);
+            return srgb_model_eval<UnpolarizedSpectrum>(out, si.wavelengths);
+        } else if (m_texture.filter_mode() == dr::FilterMode::Linear) {
             Color3f v00, v10, v01, v11;
             dr::Array<Float *, 4> fetch_values;
             fetch_values[0] = v00.data();
@@ -764,7 +995,9 @@ protected:
         Point2f uv = m_transform.transform_affine(si.uv);
 
         Float out;
-        if (m_accel)
+        if (!m_mip_levels.empty())
+            interpolate_mipmap(si, uv, &out, active);
+        else if (m_accel)
             m_texture.template eval<Float>(uv, &out, active);
         else
             m_texture.template eval_nonaccel<Float>(uv, &out, active);
@@ -785,7 +1018,9 @@ protected:
         Point2f uv = m_transform.transform_affine(si.uv);
 
         Color3f out;
-        if (m_accel)
+        if (!m_mip_levels.empty())
+            interpolate_mipmap(si, uv, out.data(), active);
+        else if (m_accel)
             m_texture.template eval<Float>(uv, out.data(), active);
         else
             m_texture.template eval_nonaccel<Float>(uv, out.data(), active);
@@ -793,6 +1028,131 @@ protected:
         return out;
     }
 
+    /**
+     * \brief Trilinear lookup into the MIP map pyramid
+     *
+     * The level is chosen so that the longer axis of the texel-space
+     * footprint given by the UV partials of \c si covers one texel. The two
+     * nearest levels are evaluated with bilinear interpolation and blended
+     * linearly. Writes one value per texture channel to \c out.
+     */
+    void interpolate_mipmap(const SurfaceInteraction3f &si, const Point2f &uv,
+                            Float *out, Mask active) const {
+        const size_t channels = m_texture.shape()[2];
+        ScalarVector2f res = ScalarVector2f(resolution());
+
+        // Footprint in texels (only the linear part of the UV transform applies)
+        const ScalarMatrix3f &m = m_transform.matrix;
+        auto footprint = [&](const Vector2f &d) {
+            return Vector2f(m.entry(0, 0) * d.x() + m.entry(0, 1) * d.y(),
+                            m.entry(1, 0) * d.x() + m.entry(1, 1) * d.y()) * res;
+        };
+        Float width2 = dr::maximum(dr::squared_norm(footprint(si.duv_dx)),
+                                   dr::squared_norm(footprint(si.duv_dy)));
+
+        Float level = dr::clip(.5f * dr::log2(width2), 0.f,
+                               (float) m_mip_levels.size());
+        level = dr::select(dr::isnan(level), 0.f, level);
+
+        Float level_floor = dr::floor(level),
+              w1 = level - level_floor,
+              w0 = 1.f - w1;
+        UInt32 lo = UInt32(level_floor);
+
+        for (size_t c = 0; c < channels; ++c)
+            out[c] = 0.f;
+
+        for (uint32_t i = 0; i <= (uint32_t) m_mip_levels.size(); ++i) {
+            Float weight = dr::select(lo == i, w0, 0.f) +
+                           dr::select(lo + 1u == i, w1, 0.f);
+            Mask active_i = active && weight > 0.f;
+            if (dr::none_or<false>(active_i))
+                continue;
+
+            const StoredTexture2f &texture =
+                i == 0 ? m_texture : m_mip_levels[i - 1];
+
+            Float values[3];
+            if (m_accel)
+                texture.template eval<Float>(uv, values, active_i);
+            else
+                texture.template eval_nonaccel<Float>(uv, values, active_i);
+
+            for (size_t c = 0; c < channels; ++c)
+                out[c] = dr::fmadd(dr::select(active_i, values[c], 0.f),
+                                   weight, out[c]);
+        }
+    }
+
+    /**
+     * \brief Build the levels of the MIP map pyramid below the full
+     * resolution texture
+     *
+     * Every level averages 2x2 texels of the previous one (clamping at the
+     * border of levels with an odd size) until a single texel remains. The
+     * levels are computed on the host in parallel and then uploaded as
+     * separate textures.
+     */
+    void build_mipmap(const StoredTensorXf &tensor) {
+        m_mip_levels.clear();
+
+        const size_t channels = m_texture.shape()[2];
+        ScalarVector2u res = ScalarVector2u(resolution());
+
+        std::vector<float> level(dr::prod(res) * channels);
+        if constexpr (dr::is_jit_v<Float>) {
+            auto &&data = dr::migrate(tensor.array(), AllocType::Host);
+            dr::sync_thread();
+            for (size_t i = 0; i < level.size(); ++i)
+                level[i] = (float) data.data()[i];
+        } else {
+            const StoredScalar *ptr = (const StoredScalar *) tensor.data();
+            for (size_t i = 0; i < level.size(); ++i)
+                level[i] = (float) ptr[i];
+        }
+
+        while (dr::any(res > 1u)) {
+            ScalarVector2u res_next = dr::maximum(res / 2u, 1u);
+            std::vector<float> next(dr::prod(res_next) * channels);
+            std::unique_ptr<StoredScalar[]> stored(
+                new StoredScalar[next.size()]);
+
+            dr::parallel_for(
+                dr::blocked_range<uint32_t>(0, res_next.y(), 16),
+                [&](const dr::blocked_range<uint32_t> &range) {
+                    for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                        uint32_t y0 = dr::minimum(2 * y, res.y() - 1),
+                                 y1 = dr::minimum(2 * y + 1, res.y() - 1);
+                        for (uint32_t x = 0; x < res_next.x(); ++x) {
+                            uint32_t x0 = dr::minimum(2 * x, res.x() - 1),
+                                     x1 = dr::minimum(2 * x + 1, res.x() - 1);
+                            size_t i00 = (y0 * res.x() + x0) * channels,
+                                   i10 = (y0 * res.x() + x1) * channels,
+                                   i01 = (y1 * res.x() + x0) * channels,
+                                   i11 = (y1 * res.x() + x1) * channels,
+                                   o   = (y * res_next.x() + x) * channels;
+                            for (size_t c = 0; c < channels; ++c) {
+                                next[o + c] = .25f * (level[i00 + c] + level[i10 + c] +
+                                                      level[i01 + c] + level[i11 + c]);
+                                stored[o + c] = (StoredScalar) next[o + c];
+                            }
+                        }
+                    }
+                }
+            );
+
+            size_t shape[3] = { (size_t) res_next.y(), (size_t) res_next.x(),
+                                channels };
+            StoredTensorXf level_tensor(stored.get(), 3, shape);
+            m_mip_levels.emplace_back(level_tensor, m_accel, m_accel,
+                                      dr::FilterMode::Linear,
+                                      m_texture.wrap_mode());
+
+            level = std::move(next);
+            res = res_next;
+        }
+    }
+
     /**
      * \brief Recompute mean and 2D sampling distribution (if requested)
      * following an update
@@ -881,25 +1241,536 @@ protected:
     ScalarTransform3f m_transform;
     bool m_accel;
     bool m_raw;
+    bool m_mipmap;
     Float m_mean;
     StoredTexture2f m_texture;
 
+    // Optional: MIP map levels below the full resolution texture
+    std::vector<StoredTexture2f> m_mip_levels;
+
     // Optional: distribution for importance sampling
     mutable std::mutex m_mutex;
     std::unique_ptr<DiscreteDistribution2D<Float>> m_distr2d;
 };
 
+
+NAMESPACE_BEGIN(detail)
+
+/// Map integer texel coordinates into <tt>[0, size)</tt> following \c wrap_mode
+template <typename Int32>
+Int32 wrap_texel(Int32 x, int32_t size, dr::WrapMode wrap_mode) {
+    switch (wrap_mode) {
+        case dr::WrapMode::Clamp:
+            return dr::clip(x, 0, size - 1);
+
+        case dr::WrapMode::Mirror:
+            x = x % (2 * size);
+            x = dr::select(x < 0, x + 2 * size, x);
+            return dr::select(x >= size, 2 * size - 1 - x, x);
+
+        default:
+            x = x % size;
+            return dr::select(x < 0, x + size, x);
+    }
+}
+
+/**
+ * \brief Nearest or bilinear interpolation of the texels returned by
+ * <tt>fetch(Point2i)</tt> at the texture coordinates \c uv
+ */
+template <typename Point2f, typename Fetch>
+auto interpolate_texels(Point2f uv, const dr::Array<int32_t, 2> &res,
+                        dr::FilterMode filter_mode, const Fetch &fetch) {
+    using Point2i = dr::int32_array_t<Point2f>;
+    using Value = decltype(fetch(Point2i()));
+
+    Point2f res_f(res);
+    if (filter_mode == dr::FilterMode::Nearest)
+        return fetch(dr::floor2int<Point2i>(uv * res_f));
+
+    uv = dr::fmadd(uv, res_f, -.5f);
+    Point2i p = dr::floor2int<Point2i>(uv);
+    Point2f w1 = uv - Point2f(p), w0 = 1.f - w1;
+
+    Value v00 = fetch(p),
+          v10 = fetch(p + Point2i(1, 0)),
+          v01 = fetch(p + Point2i(0, 1)),
+          v11 = fetch(p + Point2i(1, 1));
+
+    Value v0 = dr::fmadd(w0.x(), v00, w1.x() * v10),
+          v1 = dr::fmadd(w0.x(), v01, w1.x() * v11);
+    return Value(dr::fmadd(w0.y(), v0, w1.y() * v1));
+}
+
+NAMESPACE_END(detail)
+
+/// Bitmap texture stored in a block-compressed format and decoded per lookup
+template <typename Float, typename Spectrum>
+class BitmapTextureBC final : public Texture<Float, Spectrum> {
+public:
+    MI_IMPORT_TYPES(Texture)
+
+    using UInt32Storage = DynamicBuffer<UInt32>;
+
+    BitmapTextureBC(const Properties &props, const std::string &name,
+                    const ScalarTransform3f &transform,
+                    dr::FilterMode filter_mode, dr::WrapMode wrap_mode,
+                    BlockFormat format, bool srgb, bool raw,
+                    const Bitmap *bitmap)
+        : Texture(props), m_name(name), m_transform(transform),
+          m_filter_mode(filter_mode), m_wrap_mode(wrap_mode), m_format(format),
+          m_srgb(srgb), m_raw(raw) {
+        m_res = ScalarVector2i(bitmap->size());
+        m_block_res = (m_res + 3) / 4;
+
+        const float *data = (const float *) bitmap->data();
+        uint32_t channels = (uint32_t) bitmap->channel_count(),
+                 words = bc::block_words(format);
+
+        if (format != BlockFormat::BC5) {
+            size_t values = bitmap->pixel_count() * channels;
+            float v_max = 0.f;
+            for (size_t i = 0; i < values; ++i)
+                v_max = std::max(v_max, data[i]);
+            if (v_max > 1.f)
+                Throw("BitmapTexture: texture named \"%s\" has values outside "
+                      "of [0, 1], which block compression cannot represent "
+                      "(use the \"fp16\" format instead)!", m_name);
+        }
+
+        std::vector<uint32_t> blocks((size_t) dr::prod(m_block_res) * words);
+
+        dr::parallel_for(
+            dr::blocked_range<int32_t>(0, m_block_res.y(), 4),
+            [&](const dr::blocked_range<int32_t> &range) {
+                float texels[16 * 3];
+                for (int32_t by = range.begin(); by != range.end(); ++by) {
+                    for (int32_t bx = 0; bx < m_block_res.x(); ++bx) {
+                        // Replicate the last row/column of partial blocks
+                        for (int32_t i = 0; i < 16; ++i) {
+                            int32_t x = std::min(4 * bx + (i & 3), m_res.x() - 1),
+                                    y = std::min(4 * by + (i >> 2), m_res.y() - 1);
+                            const float *src =
+                                data + ((size_t) y * m_res.x() + x) * channels;
+                            for (uint32_t c = 0; c < channels; ++c)
+                                texels[i * channels + c] = src[c];
+                        }
+
+                        uint32_t *out = blocks.data() +
+                            ((size_t) by * m_block_res.x() + bx) * words;
+                        switch (m_format) {
+                            case BlockFormat::BC1:
+                                bc::encode_bc1(texels, out);
+                                break;
+                            case BlockFormat::BC4:
+                                bc::encode_bc4(texels, 1, out);
+                                break;
+                            case BlockFormat::BC5:
+                                bc::encode_bc4(texels, 3, out);
+                                bc::encode_bc4(texels + 1, 3, out + 2);
+                                break;
+                        }
+                    }
+                }
+            }
+        );
+
+        m_blocks = dr::load<UInt32Storage>(blocks.data(), blocks.size());
+
+        // Mean of the decoded (linear) values
+        double sum = 0.0;
+        for (int32_t y = 0; y < m_res.y(); ++y) {
+            for (int32_t x = 0; x < m_res.x(); ++x) {
+                uint32_t i = ((y & 3) << 2) | (x & 3);
+                const uint32_t *block = blocks.data() +
+                    ((size_t) (y >> 2) * m_block_res.x() + (x >> 2)) * words;
+                ScalarColor3f v = decode<ScalarFloat>(block[0], block[1],
+                                                      block[2 % words],
+                                                      block[3 % words], i);
+                sum += m_format == BlockFormat::BC4 ? v.x() : luminance(v);
+            }
+        }
+        m_mean = (ScalarFloat) (sum / (double) dr::prod(m_res));
+
+        Log(Debug, "Compressed bitmap texture \"%s\" (%ix%i) to %s", m_name,
+            m_res.x(), m_res.y(), util::mem_string(blocks.size() * sizeof(uint32_t)));
+
+        this->set_memoized(props.get<bool>("memoize", false));
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_parameter("to_uv", m_transform, +ParamFlags::NonDifferentiable);
+    }
+
+    void parameters_changed(const std::vector<std::string> & /*keys*/ = {}) override {
+        this->reset_memoized();
+    }
+
+    UnpolarizedSpectrum eval(const SurfaceInteraction3f &si,
+                             Mask active) const override {
+        return this->template memoize<UnpolarizedSpectrum>(
+            si, active, [&]() { return eval_direct(si, active); });
+    }
+
+    UnpolarizedSpectrum eval_direct(const SurfaceInteraction3f &si,
+                                    Mask active) const {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_format != BlockFormat::BC4 && is_spectral_v<Spectrum>) {
+            DRJIT_MARK_USED(si);
+            Throw("The bitmap texture %s was queried for a spectrum, but "
+                  "texture conversion into spectra was explicitly disabled! "
+                  "(raw=true)",
+                  to_string());
+        }
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<UnpolarizedSpectrum>();
+
+        Color3f v = interpolate(si, active);
+        if (m_format == BlockFormat::BC4)
+            return v.x();
+
+        if constexpr (is_monochromatic_v<Spectrum>)
+            return luminance(v);
+        else if constexpr (!is_spectral_v<Spectrum>)
+            return v;
+        else
+            return dr::zeros<UnpolarizedSpectrum>();
+    }
+
+    Float eval_1(const SurfaceInteraction3f &si,
+                 Mask active = true) const override {
+        return this->template memoize<Float>(
+            si, active, [&]() { return eval_1_direct(si, active); });
+    }
+
+    Float eval_1_direct(const SurfaceInteraction3f &si,
+                        Mask active) const {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<Float>();
+
+        Color3f v = interpolate(si, active);
+        return m_format == BlockFormat::BC4 ? v.x() : luminance(v);
+    }
+
+    Color3f eval_3(const SurfaceInteraction3f &si,
+                   Mask active = true) const override {
+        return this->template memoize<Color3f>(
+            si, active, [&]() { return eval_3_direct(si, active); });
+    }
+
+    Color3f eval_3_direct(const SurfaceInteraction3f &si,
+                          Mask active) const {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_format == BlockFormat::BC4) {
+            DRJIT_MARK_USED(si);
+            Throw("eval_3(): The bitmap texture %s was queried for a RGB "
+                  "value, but it is monochromatic!",
+                  to_string());
+        }
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<Color3f>();
+
+        return interpolate(si, active);
+    }
+
+    ScalarVector2i resolution() const override { return m_res; }
+
+    Float mean() const override { return m_mean; }
+
+    bool is_spatially_varying() const override { return true; }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "BitmapTexture[" << std::endl
+            << "  name = \"" << m_name << "\"," << std::endl
+            << "  resolution = \"" << resolution() << "\"," << std::endl
+            << "  format = bc" << (m_format == BlockFormat::BC1 ? 1 :
+                                   m_format == BlockFormat::BC4 ? 4 : 5) << "," << std::endl
+            << "  raw = " << (int) m_raw << "," << std::endl
+            << "  mean = " << m_mean << "," << std::endl
+            << "  transform = " << string::indent(m_transform) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+
+protected:
+    /// Decode texel \c i of a block given its (up to four) words
+    template <typename Value, typename UInt32_>
+    Color<Value, 3> decode(const UInt32_ &w0, const UInt32_ &w1,
+                           const UInt32_ &w2, const UInt32_ &w3,
+                           const UInt32_ &i) const {
+        switch (m_format) {
+            case BlockFormat::BC1: {
+                Color<Value, 3> c(bc::decode_bc1<Value>(w0, w1, i));
+                if (m_srgb)
+                    c = dr::srgb_to_linear(c);
+                return c;
+            }
+
+            case BlockFormat::BC4:
+                return Color<Value, 3>(bc::decode_bc4<Value>(w0, w1, i));
+
+            default: {
+                // Reconstruct the third component of the normal
+                Value x = bc::decode_bc4<Value>(w0, w1, i),
+                      y = bc::decode_bc4<Value>(w2, w3, i);
+                Value nx = dr::fmadd(x, 2.f, -1.f), ny = dr::fmadd(y, 2.f, -1.f),
+                      nz = dr::safe_sqrt(1.f - dr::square(nx) - dr::square(ny));
+                return { x, y, dr::fmadd(nz, .5f, .5f) };
+            }
+        }
+    }
+
+    /// Fetch and decode the texel at integer coordinates \c p
+    Color3f fetch(const Point2i &p, const Mask &active) const {
+        UInt32 x = UInt32(detail::wrap_texel(p.x(), m_res.x(), m_wrap_mode)),
+               y = UInt32(detail::wrap_texel(p.y(), m_res.y(), m_wrap_mode));
+
+        uint32_t words = bc::block_words(m_format);
+        UInt32 block = ((y >> 2) * (uint32_t) m_block_res.x() + (x >> 2)) * words,
+               i = ((y & 3u) << 2) | (x & 3u);
+
+        UInt32 w0 = dr::gather<UInt32>(m_blocks, block, active),
+               w1 = dr::gather<UInt32>(m_blocks, block + 1u, active), w2, w3;
+        if (m_format == BlockFormat::BC5) {
+            w2 = dr::gather<UInt32>(m_blocks, block + 2u, active);
+            w3 = dr::gather<UInt32>(m_blocks, block + 3u, active);
+        }
+
+        return decode<Float>(w0, w1, w2, w3, i);
+    }
+
+    /// Interpolate the texture at the given surface interaction
+    Color3f interpolate(const SurfaceInteraction3f &si, const Mask &active) const {
+        Point2f uv = m_transform.transform_affine(si.uv);
+        return detail::interpolate_texels(
+            uv, m_res, m_filter_mode,
+            [&](const Point2i &p) { return fetch(p, active); });
+    }
+
+protected:
+    std::string m_name;
+    ScalarTransform3f m_transform;
+    dr::FilterMode m_filter_mode;
+    dr::WrapMode m_wrap_mode;
+    BlockFormat m_format;
+    bool m_srgb;
+    bool m_raw;
+    ScalarVector2i m_res, m_block_res;
+    UInt32Storage m_blocks;
+    Float m_mean;
+};
+
+/// Bitmap texture stored with 8 bits per channel and decoded per lookup
+template <typename Float, typename Spectrum>
+class BitmapTextureU8 final : public Texture<Float, Spectrum> {
+public:
+    MI_IMPORT_TYPES(Texture)
+
+    using UInt8 = dr::uint8_array_t<Float>;
+    using UInt8Storage = DynamicBuffer<UInt8>;
+    using FloatStorage = DynamicBuffer<Float>;
+
+    BitmapTextureU8(const Properties &props, const std::string &name,
+                    const ScalarTransform3f &transform,
+                    dr::FilterMode filter_mode, dr::WrapMode wrap_mode,
+                    bool srgb, bool raw, const Bitmap *bitmap)
+        : Texture(props), m_name(name), m_transform(transform),
+          m_filter_mode(filter_mode), m_wrap_mode(wrap_mode), m_srgb(srgb),
+          m_raw(raw) {
+        m_res = ScalarVector2i(bitmap->size());
+        m_channels = (uint32_t) bitmap->channel_count();
+
+        // Decoding table from 8-bit values to linear values
+        float lut[256];
+        for (uint32_t i = 0; i < 256; ++i) {
+            float v = i / 255.f;
+            lut[i] = m_srgb ? dr::srgb_to_linear(v) : v;
+        }
+        m_lut = dr::load<FloatStorage>(lut, 256);
+
+        const uint8_t *data = (const uint8_t *) bitmap->data();
+        size_t pixel_count = bitmap->pixel_count();
+        m_data = dr::load<UInt8Storage>(data, pixel_count * m_channels);
+
+        double sum = 0.0;
+        for (size_t i = 0; i < pixel_count; ++i) {
+            const uint8_t *v = data + i * m_channels;
+            sum += m_channels == 1
+                ? lut[v[0]]
+                : luminance(ScalarColor3f(lut[v[0]], lut[v[1]], lut[v[2]]));
+        }
+        m_mean = (ScalarFloat) (sum / (double) pixel_count);
+
+        this->set_memoized(props.get<bool>("memoize", false));
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_parameter("to_uv", m_transform, +ParamFlags::NonDifferentiable);
+    }
+
+    void parameters_changed(const std::vector<std::string> & /*keys*/ = {}) override {
+        this->reset_memoized();
+    }
+
+    UnpolarizedSpectrum eval(const SurfaceInteraction3f &si,
+                             Mask active) const override {
+        return this->template memoize<UnpolarizedSpectrum>(
+            si, active, [&]() { return eval_direct(si, active); });
+    }
+
+    UnpolarizedSpectrum eval_direct(const SurfaceInteraction3f &si,
+                                    Mask active) const {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channels == 3 && is_spectral_v<Spectrum>) {
+            DRJIT_MARK_USED(si);
+            Throw("The bitmap texture %s was queried for a spectrum, but "
+                  "texture conversion into spectra was explicitly disabled! "
+                  "(raw=true)",
+                  to_string());
+        }
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<UnpolarizedSpectrum>();
+
+        Color3f v = interpolate(si, active);
+        if (m_channels == 1)
+            return v.x();
+
+        if constexpr (is_monochromatic_v<Spectrum>)
+            return luminance(v);
+        else if constexpr (!is_spectral_v<Spectrum>)
+            return v;
+        else
+            return dr::zeros<UnpolarizedSpectrum>();
+    }
+
+    Float eval_1(const SurfaceInteraction3f &si,
+                 Mask active = true) const override {
+        return this->template memoize<Float>(
+            si, active, [&]() { return eval_1_direct(si, active); });
+    }
+
+    Float eval_1_direct(const SurfaceInteraction3f &si,
+                        Mask active) const {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<Float>();
+
+        Color3f v = interpolate(si, active);
+        return m_channels == 1 ? v.x() : luminance(v);
+    }
+
+    Color3f eval_3(const SurfaceInteraction3f &si,
+                   Mask active = true) const override {
+        return this->template memoize<Color3f>(
+            si, active, [&]() { return eval_3_direct(si, active); });
+    }
+
+    Color3f eval_3_direct(const SurfaceInteraction3f &si,
+                          Mask active) const {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channels != 3) {
+            DRJIT_MARK_USED(si);
+            Throw("eval_3(): The bitmap texture %s was queried for a RGB "
+                  "value, but it is monochromatic!",
+                  to_string());
+        }
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<Color3f>();
+
+        return interpolate(si, active);
+    }
+
+    ScalarVector2i resolution() const override { return m_res; }
+
+    Float mean() const override { return m_mean; }
+
+    bool is_spatially_varying() const override { return true; }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "BitmapTexture[" << std::endl
+            << "  name = \"" << m_name << "\"," << std::endl
+            << "  resolution = \"" << resolution() << "\"," << std::endl
+            << "  format = u8" << (m_srgb ? "_srgb" : "") << "," << std::endl
+            << "  raw = " << (int) m_raw << "," << std::endl
+            << "  mean = " << m_mean << "," << std::endl
+            << "  transform = " << string::indent(m_transform) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+
+protected:
+    /// Fetch and decode the texel at integer coordinates \c p
+    Color3f fetch(const Point2i &p, const Mask &active) const {
+        UInt32 x = UInt32(detail::wrap_texel(p.x(), m_res.x(), m_wrap_mode)),
+               y = UInt32(detail::wrap_texel(p.y(), m_res.y(), m_wrap_mode));
+        UInt32 index = (y * (uint32_t) m_res.x() + x) * m_channels;
+
+        Color3f result;
+        for (uint32_t i = 0; i < m_channels; ++i) {
+            UInt32 value = UInt32(dr::gather<UInt8>(m_data, index + i, active));
+            result[i] = dr::gather<Float>(m_lut, value, active);
+        }
+        if (m_channels == 1)
+            result.y() = result.z() = result.x();
+
+        return result;
+    }
+
+    /// Interpolate the texture at the given surface interaction
+    Color3f interpolate(const SurfaceInteraction3f &si, const Mask &active) const {
+        Point2f uv = m_transform.transform_affine(si.uv);
+        return detail::interpolate_texels(
+            uv, m_res, m_filter_mode,
+            [&](const Point2i &p) { return fetch(p, active); });
+    }
+
+protected:
+    std::string m_name;
+    ScalarTransform3f m_transform;
+    dr::FilterMode m_filter_mode;
+    dr::WrapMode m_wrap_mode;
+    bool m_srgb;
+    bool m_raw;
+    uint32_t m_channels;
+    ScalarVector2i m_res;
+    UInt8Storage m_data;
+    FloatStorage m_lut;
+    Float m_mean;
+};
+
 MI_IMPLEMENT_CLASS_VARIANT(BitmapTexture, Texture)
+MI_IMPLEMENT_CLASS_VARIANT(BitmapTextureBC, Texture)
+MI_IMPLEMENT_CLASS_VARIANT(BitmapTextureU8, Texture)
 MI_EXPORT_PLUGIN(BitmapTexture, "Bitmap texture")
 
 /* This class has a name that depends on extra template parameters, so
    the standard MI_IMPLEMENT_CLASS_VARIANT macro cannot be used */
 
 NAMESPACE_BEGIN(detail)
-template <typename StoredType>
+template <typename Float, typename StoredType>
 constexpr const char * bitmap_class_name() {
     if constexpr (std::is_same_v<dr::scalar_t<StoredType>, dr::half>)
         return "BitmapTextureImpl_FP16";
+    else if constexpr (!std::is_same_v<dr::scalar_t<StoredType>,
+                                       dr::scalar_t<Float>>)
+        return "BitmapTextureImpl_FP32";
 
     return "BitmapTextureImpl";
 }
@@ -907,7 +1778,7 @@ NAMESPACE_END(detail)
 
 template <typename Float, typename Spectrum, typename StoredType>
 Class *BitmapTextureImpl<Float, Spectrum, StoredType>::m_class
-    = new Class(detail::bitmap_class_name<StoredType>(), "Texture",
+    = new Class(detail::bitmap_class_name<Float, StoredType>(), "Texture",
                 ::mitsuba::detail::get_variant<Float, Spectrum>(), nullptr, nullptr);
 
 template <typename Float, typename Spectrum, typename StoredType>
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <mitsuba/core/fwd.h>
+#include <drjit/array.h>
+#include <cmath>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Block compression formats for textures
+ *
+ * All formats encode blocks of 4x4 texels using 4 (BC1, BC4) or 8 (BC5) bits
+ * per texel and follow the layout of the corresponding GPU formats:
+ *
+ * - BC1: RGB colors using two RGB565 endpoints and 2-bit indices
+ * - BC4: a single channel using two 8-bit endpoints and 3-bit indices
+ * - BC5: two channels, each stored as a BC4 block
+ */
+enum class BlockFormat : uint32_t { BC1, BC4, BC5 };
+
+NAMESPACE_BEGIN(bc)
+
+/// Number of 32-bit words per block
+inline uint32_t block_words(BlockFormat format) {
+    return format == BlockFormat::BC5 ? 4 : 2;
+}
+
+/// Decode the RGB565 color \c c to values in [0, 1]
+template <typename Value, typename UInt32>
+MI_INLINE dr::Array<Value, 3> unpack_565(const UInt32 &c) {
+    return { Value((c >> 11) & 31u) * (1.f / 31.f),
+             Value((c >> 5) & 63u) * (1.f / 63.f),
+             Value(c & 31u) * (1.f / 31.f) };
+}
+
+/**
+ * \brief Encode a 4x4 block of RGB values in [0, 1] (16 consecutive triplets)
+ * in the BC1 format
+ *
+ * The endpoints are the extremes of the colors along their principal axis.
+ * The encoder always uses the four-color mode.
+ */
+inline void encode_bc1(const float *rgb, uint32_t *out) {
+    using Vector3 = dr::Array<float, 3>;
+
+    Vector3 mean(0.f);
+    for (int i = 0; i < 16; ++i)
+        mean += dr::load<Vector3>(rgb + 3 * i);
+    mean *= 1.f / 16.f;
+
+    // Principal axis of the colors using a few steps of power iteration
+    float cov[6] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+    for (int i = 0; i < 16; ++i) {
+        Vector3 d = dr::load<Vector3>(rgb + 3 * i) - mean;
+        cov[0] += d.x() * d.x(); cov[1] += d.x() * d.y(); cov[2] += d.x() * d.z();
+        cov[3] += d.y() * d.y(); cov[4] += d.y() * d.z(); cov[5] += d.z() * d.z();
+    }
+
+    Vector3 axis(1.f);
+    for (int it = 0; it < 4; ++it) {
+        axis = Vector3(cov[0] * axis.x() + cov[1] * axis.y() + cov[2] * axis.z(),
+                       cov[1] * axis.x() + cov[3] * axis.y() + cov[4] * axis.z(),
+                       cov[2] * axis.x() + cov[4] * axis.y() + cov[5] * axis.z());
+        float norm = dr::norm(axis);
+        axis = norm > 0.f ? axis / norm : Vector3(0.f);
+    }
+
+    float t_min = 0.f, t_max = 0.f;
+    for (int i = 0; i < 16; ++i) {
+        float t = dr::dot(dr::load<Vector3>(rgb + 3 * i) - mean, axis);
+        t_min = std::min(t_min, t);
+        t_max = std::max(t_max, t);
+    }
+
+    auto pack = [](const Vector3 &v) {
+        Vector3 c = dr::clip(v, 0.f, 1.f);
+        return ((uint32_t) std::lround(c.x() * 31.f) << 11) |
+               ((uint32_t) std::lround(c.y() * 63.f) << 5) |
+               (uint32_t) std::lround(c.z() * 31.f);
+    };
+
+    uint32_t c0 = pack(mean + axis * t_max),
+             c1 = pack(mean + axis * t_min);
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    out[0] = c0 | (c1 << 16);
+    out[1] = 0;
+    if (c0 == c1)
+        return;
+
+    Vector3 palette[4];
+    palette[0] = unpack_565<float>(c0);
+    palette[1] = unpack_565<float>(c1);
+    palette[2] = (2.f * palette[0] + palette[1]) * (1.f / 3.f);
+    palette[3] = (palette[0] + 2.f * palette[1]) * (1.f / 3.f);
+
+    for (int i = 0; i < 16; ++i) {
+        Vector3 v = dr::load<Vector3>(rgb + 3 * i);
+        uint32_t best = 0;
+        float best_dist = dr::Infinity<float>;
+        for (uint32_t j = 0; j < 4; ++j) {
+            float dist = dr::squared_norm(v - palette[j]);
+            if (dist < best_dist) {
+                best_dist = dist;
+                best = j;
+            }
+        }
+        out[1] |= best << (2 * i);
+    }
+}
+
+/// Encode a 4x4 block of values in [0, 1] (given with a stride) in the BC4 format
+inline void encode_bc4(const float *values, size_t stride, uint32_t *out) {
+    float v_min = 1.f, v_max = 0.f;
+    for (int i = 0; i < 16; ++i) {
+        float v = dr::clip(values[i * stride], 0.f, 1.f);
+        v_min = std::min(v_min, v);
+        v_max = std::max(v_max, v);
+    }
+
+    uint64_t r0 = (uint64_t) std::lround(v_max * 255.f),
+             r1 = (uint64_t) std::lround(v_min * 255.f),
+             bits = r0 | (r1 << 8);
+
+    if (r0 > r1) {
+        float palette[8] = { r0 / 255.f, r1 / 255.f };
+        for (int j = 2; j < 8; ++j)
+            palette[j] = ((8 - j) * r0 + (j - 1) * r1) / (7.f * 255.f);
+
+        for (int i = 0; i < 16; ++i) {
+            float v = values[i * stride];
+            uint64_t best = 0;
+            float best_dist = dr::Infinity<float>;
+            for (uint64_t j = 0; j < 8; ++j) {
+                float dist = std::abs(v - palette[j]);
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best = j;
+                }
+            }
+            bits |= best << (16 + 3 * i);
+        }
+    }
+
+    out[0] = (uint32_t) bits;
+    out[1] = (uint32_t) (bits >> 32);
+}
+
+/// Decode texel \c i (in 0..15, row-major) of a BC1 block
+template <typename Value, typename UInt32>
+MI_INLINE dr::Array<Value, 3> decode_bc1(const UInt32 &w0, const UInt32 &w1,
+                                         const UInt32 &i) {
+    using Color = dr::Array<Value, 3>;
+
+    UInt32 c0 = w0 & 0xFFFFu, c1 = w0 >> 16,
+           index = (w1 >> (i * 2u)) & 3u;
+    Color p0 = unpack_565<Value>(c0), p1 = unpack_565<Value>(c1);
+
+    // Three-color mode (with black) when the endpoints are not ordered
+    auto four_colors = c0 > c1;
+    Color p2 = dr::select(four_colors, (2.f * p0 + p1) * (1.f / 3.f), (p0 + p1) * .5f),
+          p3 = dr::select(four_colors, (p0 + 2.f * p1) * (1.f / 3.f), Color(0.f));
+
+    return dr::select(index == 0u, p0,
+           dr::select(index == 1u, p1,
+           dr::select(index == 2u, p2, p3)));
+}
+
+/// Decode texel \c i (in 0..15, row-major) of a BC4 block
+template <typename Value, typename UInt32>
+MI_INLINE Value decode_bc4(const UInt32 &w0, const UInt32 &w1, const UInt32 &i) {
+    using UInt64 = dr::uint64_array_t<UInt32>;
+
+    UInt64 bits = UInt64(w0) | (UInt64(w1) << 32);
+    UInt32 index = UInt32((bits >> UInt64(i * 3u + 16u)) & 7u);
+
+    Value r0 = Value(w0 & 0xFFu), r1 = Value((w0 >> 8) & 0xFFu);
+    Value j = Value(index);
+
+    // Eight interpolated values, or six plus the two extremes
+    Value eight = (r0 * (8.f - j) + r1 * (j - 1.f)) * (1.f / 7.f),
+          six   = (r0 * (6.f - j) + r1 * (j - 1.f)) * (1.f / 5.f);
+    six = dr::select(index == 6u, 0.f, dr::select(index == 7u, 255.f, six));
+
+    Value v = dr::select(r0 > r1, eight, six);
+    v = dr::select(index == 0u, r0, dr::select(index == 1u, r1, v));
+    return v * (1.f / 255.f);
+}
+
+NAMESPACE_END(bc)
+NAMESPACE_END(mitsuba)
@@ -83,6 +83,9 @@ public:
             Throw("Invalid mesh attribute name: must be start with either \"vertex_\" or \"face_\" but was \"%s\".", m_name.c_str());
 
         m_scale = props.get<ScalarFloat>("scale", 1.f);
+
+        // Avoid looking up the attribute by name at every evaluation
+        m_handle = Shape::attribute_handle(m_name);
     }
 
     void traverse(TraversalCallback *callback) override {
@@ -91,19 +94,22 @@ public:
 
     const std::string& name() const { return m_name; }
 
+    // Shapes may interpolate their attributes using the UV coordinates
+    uint32_t ray_flags() const override { return +RayFlags::UV; }
+
     UnpolarizedSpectrum eval(const SurfaceInteraction3f &si, Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
-        return si.shape->eval_attribute(m_name, si, active) * m_scale;
+        return si.shape->eval_attribute(m_handle, si, active) * m_scale;
     }
 
     Float eval_1(const SurfaceInteraction3f &si, Mask active = true) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
-        return si.shape->eval_attribute_1(m_name, si, active) * m_scale;
+        return si.shape->eval_attribute_1(m_handle, si, active) * m_scale;
     }
 
     Color3f eval_3(const SurfaceInteraction3f &si, Mask active = true) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
-        return si.shape->eval_attribute_3(m_name, si, active) * m_scale;
+        return si.shape->eval_attribute_3(m_handle, si, active) * m_scale;
     }
 
     std::string to_string() const override {
@@ -118,6 +124,7 @@ public:
     MI_DECLARE_CLASS()
 protected:
     std::string m_name;
+    uint32_t m_handle;
     float m_scale;
 };
 
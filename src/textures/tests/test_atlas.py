@@ -0,0 +1,95 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def write_images(tmpdir):
+    import numpy as np
+    colors = [[0.1, 0.2, 0.3], [0.4, 0.5, 0.6], [0.7, 0.8, 0.9]]
+    filenames = {}
+    for i, color in enumerate(colors):
+        # Images may have different resolutions
+        size = 8 if i == 1 else 4
+        data = np.tile(np.array(color, dtype=np.float32), (size, size, 1))
+        filename = str(tmpdir.join(f'image_{i}.exr'))
+        mi.Bitmap(data).write(filename)
+        filenames[f'filename_{i}'] = filename
+    return filenames, colors
+
+
+@pytest.mark.parametrize('filter_type', ['nearest', 'bilinear'])
+def test01_eval_uv(variants_all_rgb, tmpdir, filter_type):
+    filenames, colors = write_images(tmpdir)
+    texture = mi.load_dict({
+        'type': 'atlas',
+        'filter_type': filter_type,
+        'raw': True,
+        **filenames
+    })
+
+    # Image i covers [i, i+1] x [0, 1], other images never bleed into it
+    uv = [(0.01, 0.6), (1.99, 0.1), (2.5, 0.99), (3.5, 0.5), (-0.5, 0.5)]
+    expected = [colors[0], colors[1], colors[2], [0, 0, 0], [0, 0, 0]]
+
+    si = dr.zeros(mi.SurfaceInteraction3f)
+    for (u, v), value in zip(uv, expected):
+        si.uv = mi.Point2f(u, v)
+        assert dr.allclose(texture.eval_3(si), value, atol=1e-6)
+
+    assert dr.allclose(texture.mean(),
+                       sum(mi.luminance(c) for c in colors) / 3, rtol=1e-5)
+
+
+def test02_wrap_mode(variant_scalar_rgb, tmpdir):
+    import numpy as np
+    data = np.arange(4, dtype=np.float32).reshape(4, 1, 1)
+    filename = str(tmpdir.join('ramp.exr'))
+    mi.Bitmap(data).write(filename)
+
+    # Texel row 5 lies outside of the image, the wrap mode maps it back
+    si = dr.zeros(mi.SurfaceInteraction3f)
+    si.uv = [0.5, 1.375]
+    for wrap_mode, expected in [('repeat', 1), ('clamp', 3), ('mirror', 2)]:
+        texture = mi.load_dict({
+            'type': 'atlas',
+            'filename_0': filename,
+            'filter_type': 'nearest',
+            'wrap_mode': wrap_mode,
+            'raw': True
+        })
+        assert dr.allclose(texture.eval_1(si), expected)
+
+
+def test03_index_attribute(variants_all_rgb, tmpdir):
+    filenames, colors = write_images(tmpdir)
+
+    mesh = mi.Mesh('mesh', 3, 2, has_vertex_texcoords=True)
+    params = mi.traverse(mesh)
+    params['vertex_positions'] = [0, 0, 0, 1, 0, 0, 0, 1, 0]
+    params['faces'] = [0, 1, 2, 0, 2, 1]
+    params['vertex_texcoords'] = [0, 0, 1, 0, 0, 1]
+    params.update()
+    mesh.add_attribute('face_texture', 1, [2, 1])
+
+    texture = mi.load_dict({
+        'type': 'atlas',
+        'index': 'face_texture',
+        'raw': True,
+        **filenames
+    })
+
+    si = dr.zeros(mi.SurfaceInteraction3f)
+    si.shape = mesh
+    si.uv = [0.25, 0.25]
+    for prim, index in enumerate([2, 1]):
+        si.prim_index = prim
+        assert dr.allclose(texture.eval_3(si), colors[index], atol=1e-6)
+
+
+def test04_errors(variant_scalar_rgb, tmpdir):
+    with pytest.raises(RuntimeError, match='at least one image'):
+        mi.load_dict({ 'type': 'atlas' })
+
+    filenames, _ = write_images(tmpdir)
+    with pytest.raises(RuntimeError, match='Invalid mesh attribute name'):
+        mi.load_dict({ 'type': 'atlas', 'index': 'texture', **filenames })
@@ -248,4 +248,180 @@ def test06_tensor_load(variants_all_rgb):
         'raw' : True
     })
 
-    assert dr.allclose(bitmap.mean(), 3.0);
\ No newline at end of file
+    assert dr.allclose(bitmap.mean(), 3.0);
+
+def test07_trilinear(variant_scalar_rgb):
+    values = [((i * 37) % 64) / 64 for i in range(64)]
+    data = mi.TensorXf(values, shape=[8, 8, 1])
+
+    def load(filter_type):
+        return mi.load_dict({
+            'type' : 'bitmap',
+            'data' : data,
+            'raw' : True,
+            'filter_type' : filter_type
+        })
+
+    bilinear, trilinear = load('bilinear'), load('trilinear')
+
+    # Without UV partials, the full resolution level is used
+    si = mi.SurfaceInteraction3f()
+    for uv in [[0.1, 0.2], [0.5, 0.5], [0.73, 0.31]]:
+        si.uv = uv
+        assert dr.allclose(trilinear.eval_1(si), bilinear.eval_1(si))
+
+    # A footprint covering the whole texture selects the 1x1 level
+    si.duv_dx = [1, 0]
+    si.duv_dy = [0, 1]
+    assert dr.allclose(trilinear.eval_1(si), trilinear.mean())
+
+    # A footprint of two texels selects the first level of the pyramid
+    def level1(x, y):
+        return sum(values[(2 * y + j) * 8 + 2 * x + i]
+                   for i in range(2) for j in range(2)) / 4
+
+    si.uv = [0.5, 0.5]
+    si.duv_dx = [2 / 8, 0]
+    si.duv_dy = [0, 0]
+    ref = sum(level1(x, y) for x in [1, 2] for y in [1, 2]) / 4
+    assert dr.allclose(trilinear.eval_1(si), ref)
+
+
+@pytest.mark.parametrize('format', ['bc1', 'bc4', 'bc5'])
+def test08_block_compression(variants_vec_backends_once_rgb, format):
+    import numpy as np
+    x, y = np.meshgrid(np.linspace(0, 1, 30), np.linspace(0, 1, 22))
+    data = np.stack([x, y, 0.5 * x * y + 0.25], axis=-1).astype(np.float32)
+    if format == 'bc4':
+        data = data[..., :1]
+    bitmap = mi.Bitmap(data)
+
+    def load(format):
+        return mi.load_dict({
+            'type' : 'bitmap',
+            'bitmap' : bitmap,
+            'raw' : True,
+            'format' : format
+        })
+
+    ref, compressed = load('variant'), load(format)
+    assert dr.all(compressed.resolution() == ref.resolution())
+
+    si = dr.zeros(mi.SurfaceInteraction3f, 64)
+    t = dr.arange(mi.Float, 64) / 64
+    si.uv = [t, dr.fmod(t * 7.3, 1.0)]
+
+    if format == 'bc4':
+        assert dr.allclose(compressed.eval_1(si), ref.eval_1(si), atol=2e-2)
+    else:
+        v, v_ref = compressed.eval_3(si), ref.eval_3(si)
+        # BC5 only stores the first two channels
+        channels = 2 if format == 'bc5' else 3
+        for i in range(channels):
+            assert dr.allclose(v[i], v_ref[i], atol=3e-2)
+
+    assert dr.allclose(compressed.mean(), ref.mean(), atol=2e-2)
+
+    with pytest.raises(RuntimeError, match='outside of'):
+        mi.load_dict({
+            'type' : 'bitmap',
+            'bitmap' : mi.Bitmap(data * 2),
+            'raw' : True,
+            'format' : 'bc1' if format == 'bc5' else format
+        })
+
+
+def test09_u8_srgb(variants_vec_backends_once_rgb, tmpdir):
+    import numpy as np
+    x, y = np.meshgrid(np.linspace(0, 255, 17), np.linspace(0, 255, 13))
+    data = np.stack([x, y, (x + y) / 2], axis=-1).astype(np.uint8)
+    filename = str(tmpdir.join('texture.png'))
+    mi.Bitmap(data, mi.Bitmap.PixelFormat.RGB).write(filename)
+
+    def load(format, raw=False):
+        return mi.load_dict({
+            'type' : 'bitmap',
+            'filename' : filename,
+            'raw' : raw,
+            'format' : format
+        })
+
+    si = dr.zeros(mi.SurfaceInteraction3f, 64)
+    t = dr.arange(mi.Float, 64) / 64
+    si.uv = [t, dr.fmod(t * 7.3, 1.0)]
+
+    for raw in [False, True]:
+        ref, u8 = load('fp32', raw), load('u8_srgb', raw)
+        v, v_ref = u8.eval_3(si), ref.eval_3(si)
+        for i in range(3):
+            assert dr.allclose(v[i], v_ref[i], atol=1e-5)
+        assert dr.allclose(u8.mean(), ref.mean(), rtol=1e-4)
+
+
+@fresolver_append_path
+def test10_shared_file(variants_vec_backends_once_rgb):
+    # Both textures are decoded from a single bitmap provided by the
+    # ResourceCache, which must not be affected by the 'raw' texture
+    filename = 'resources/data/common/textures/carrot.png'
+    bsdf = mi.load_dict({
+        'type' : 'principled',
+        'base_color' : { 'type' : 'bitmap', 'filename' : filename },
+        'roughness' : { 'type' : 'bitmap', 'filename' : filename, 'raw' : True }
+    })
+    params = mi.traverse(bsdf)
+
+    for key, raw in [('base_color.data', False), ('roughness.data', True)]:
+        ref = mi.load_dict({ 'type' : 'bitmap', 'filename' : filename, 'raw' : raw })
+        assert dr.allclose(params[key], mi.traverse(ref)['data'])
+
+    # Bitmaps are released once they are no longer used
+    assert mi.ResourceCache.size() == 0
+
+
+def test11_memoize(variant_scalar_rgb, np_rng):
+    data = np_rng.random((8, 8, 1)).astype('float32')
+    desc = { 'type' : 'bitmap', 'data' : mi.TensorXf(data), 'raw' : True }
+    ref = mi.load_dict(desc)
+    bitmap = mi.load_dict(dict(desc, memoize=True))
+
+    si = mi.SurfaceInteraction3f()
+    for uv in [[0.1, 0.2], [0.7, 0.3], [0.1, 0.2], [0.1, 0.2]]:
+        si.uv = uv
+        assert dr.allclose(bitmap.eval_1(si), ref.eval_1(si))
+
+    # Updated data must not be served from previous lookups
+    params = mi.traverse(bitmap)
+    params['data'] = mi.TensorXf(data * 2)
+    params.update()
+    assert dr.allclose(bitmap.eval_1(si), 2 * ref.eval_1(si))
+
+
+def test12_prefetch(variant_scalar_rgb, tmpdir, np_rng):
+    # Files are loaded ahead of the instantiation in parallel mode, which must
+    # produce the same textures (and errors) as sequential loading
+    desc = { 'type' : 'scene' }
+    for i in range(4):
+        filename = str(tmpdir.join('tex_%i.exr' % i))
+        data = np_rng.random((4 + i, 8, 3)).astype('float32')
+        mi.Bitmap(data).write(filename)
+        desc['shape_%i' % i] = {
+            'type' : 'rectangle',
+            'bsdf' : {
+                'type' : 'diffuse',
+                'reflectance' : { 'type' : 'bitmap', 'filename' : filename }
+            }
+        }
+
+    ref, scene = mi.load_dict(desc, parallel=False), mi.load_dict(desc)
+    assert mi.ResourceCache.size() == 0
+
+    shapes_ref = { shape.id() : shape for shape in ref.shapes() }
+    for shape in scene.shapes():
+        texture = mi.traverse(shape.bsdf())['reflectance.data']
+        texture_ref = mi.traverse(shapes_ref[shape.id()].bsdf())['reflectance.data']
+        assert dr.allclose(texture, texture_ref)
+
+    desc['shape_0']['bsdf']['reflectance']['filename'] = str(tmpdir.join('missing.exr'))
+    for parallel in [False, True]:
+        with pytest.raises(Exception, match='missing.exr'):
+            mi.load_dict(desc, parallel=parallel)
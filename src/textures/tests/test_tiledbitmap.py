@@ -0,0 +1,50 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def write_exr(tmpdir, width, height):
+    import numpy as np
+    x, y = np.meshgrid(np.linspace(0, 1, width), np.linspace(0, 1, height))
+    data = np.stack([x, y, np.sin(10 * x) * np.cos(7 * y) * 0.5 + 0.5], axis=-1)
+    filename = str(tmpdir.join('texture.exr'))
+    mi.Bitmap(data.astype(np.float32)).write(filename)
+    return filename
+
+
+@pytest.mark.parametrize('filter_type', ['nearest', 'bilinear'])
+@pytest.mark.parametrize('wrap_mode', ['repeat', 'clamp', 'mirror'])
+def test01_eval(variant_scalar_rgb, tmpdir, filter_type, wrap_mode):
+    filename = write_exr(tmpdir, 300, 200)
+
+    def load(type, **kwargs):
+        return mi.load_dict({
+            'type': type,
+            'filename': filename,
+            'filter_type': filter_type,
+            'wrap_mode': wrap_mode,
+            'raw': True,
+            **kwargs
+        })
+
+    # The cache only holds a fraction of the 5x4 tiles
+    ref = load('bitmap', format='variant')
+    tiled = load('tiledbitmap', cache_size=0.5)
+    assert dr.all(tiled.resolution() == ref.resolution())
+
+    si = mi.SurfaceInteraction3f()
+    for i in range(200):
+        si.uv = [(i * 0.618034) % 1.4 - 0.2, (i * 0.754878) % 1.4 - 0.2]
+        assert dr.allclose(tiled.eval_3(si), ref.eval_3(si), atol=1e-5)
+        assert dr.allclose(tiled.eval_1(si), ref.eval_1(si), atol=1e-5)
+
+    assert dr.allclose(tiled.mean(), ref.mean(), rtol=1e-4)
+
+
+def test02_errors(variant_scalar_rgb, tmpdir):
+    filename = str(tmpdir.join('texture.png'))
+    mi.Bitmap(dr.zeros(mi.TensorXf, [4, 4, 3])).convert(
+        mi.Bitmap.PixelFormat.RGB, mi.Struct.Type.UInt8, True).write(filename)
+
+    with pytest.raises(RuntimeError, match='is not an OpenEXR file'):
+        mi.load_dict({ 'type': 'tiledbitmap', 'filename': filename })
@@ -0,0 +1,46 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def write_tiles(tmpdir):
+    import numpy as np
+    colors = { 1001: [0.1, 0.2, 0.3], 1002: [0.4, 0.5, 0.6], 1011: [0.7, 0.8, 0.9] }
+    for udim, color in colors.items():
+        # Tiles may have different resolutions
+        size = 8 if udim == 1002 else 4
+        data = np.tile(np.array(color, dtype=np.float32), (size, size, 1))
+        mi.Bitmap(data).write(str(tmpdir.join(f'albedo.{udim}.exr')))
+    return str(tmpdir.join('albedo.<UDIM>.exr')), colors
+
+
+@pytest.mark.parametrize('filter_type', ['nearest', 'bilinear'])
+def test01_eval(variants_all_rgb, tmpdir, filter_type):
+    filename, colors = write_tiles(tmpdir)
+    texture = mi.load_dict({
+        'type': 'udim',
+        'filename': filename,
+        'filter_type': filter_type,
+        'raw': True
+    })
+
+    # Tile 1001 + u + 10 v covers [u, u+1] x [-v, 1-v]
+    uv = [(0.3, 0.6), (1.7, 0.1), (0.5, -0.5), (2.5, 0.5), (0.5, 1.5)]
+    expected = [colors[1001], colors[1002], colors[1011], [0, 0, 0], [0, 0, 0]]
+
+    si = dr.zeros(mi.SurfaceInteraction3f)
+    for (u, v), value in zip(uv, expected):
+        si.uv = mi.Point2f(u, v)
+        assert dr.allclose(texture.eval_3(si), value, atol=1e-6)
+
+    assert dr.allclose(texture.mean(),
+                       sum(mi.luminance(c) for c in colors.values()) / 3, rtol=1e-5)
+
+
+def test02_errors(variant_scalar_rgb, tmpdir):
+    with pytest.raises(RuntimeError, match='must contain the token'):
+        mi.load_dict({ 'type': 'udim', 'filename': 'albedo.exr' })
+
+    with pytest.raises(RuntimeError, match='No UDIM tiles'):
+        mi.load_dict({ 'type': 'udim',
+                       'filename': str(tmpdir.join('missing.<UDIM>.exr')) })
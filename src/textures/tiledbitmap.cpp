@@ -0,0 +1,536 @@
+#include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/thread.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/texture.h>
+#include <mitsuba/render/srgb.h>
+#include <drjit/texture.h>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _texture-tiledbitmap:
+
+Tiled bitmap texture (:monosp:`tiledbitmap`)
+--------------------------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename of the OpenEXR image to be loaded. Tiled and MIP-mapped files
+     (of which the full resolution level is used) are read tile by tile,
+     scanline files in bands of scanlines.
+
+ * - filter_type
+   - |string|
+   - Specifies how pixel values are interpolated: ``bilinear`` (default) or
+     ``nearest``.
+
+ * - wrap_mode
+   - |string|
+   - Controls the behavior of texture evaluations that fall outside of the
+     :math:`[0, 1]` range: ``repeat`` (default), ``mirror``, or ``clamp``.
+
+ * - raw
+   - |bool|
+   - Should spectral upsampling of the stored color data be disabled?
+     (Default: false)
+
+ * - to_uv
+   - |transform|
+   - Specifies an optional 3x3 transformation matrix that will be applied to UV
+     values. A 4x4 matrix can also be provided, in which case the extra row and
+     column are ignored.
+   - |exposed|
+
+ * - cache_size
+   - |float|
+   - Total amount of memory (in MiB) of the tile cache. It is shared by all
+     :monosp:`tiledbitmap` textures; when several of them specify a size, the
+     smallest value is used. (Default: 1024)
+
+This plugin provides a bitmap texture for texture sets that are too large to be
+kept in memory. When the scene is loaded, only the header of the image is read.
+The texels are then loaded on demand in tiles of 64x64 pixels when a lookup
+first touches them, and kept in a fixed-size cache shared by all textures and
+rendering threads. Lookups into resident tiles don't take any locks. Once the
+cache is full, the tiles that were least recently used (approximately, using
+the *clock* algorithm) are evicted.
+
+The image data is assumed to be linear, as is the convention for OpenEXR
+files. The texture mean is computed when it is first queried, which streams
+through the entire image once.
+
+.. tabs::
+    .. code-tab:: xml
+        :name: tiledbitmap-texture
+
+        <texture type="tiledbitmap">
+            <string name="filename" value="terrain_albedo_8k.exr"/>
+            <float name="cache_size" value="2048"/>
+        </texture>
+
+    .. code-tab:: python
+
+        'type': 'tiledbitmap',
+        'filename': 'terrain_albedo_8k.exr',
+        'cache_size': 2048
+
+.. warning::
+
+    This plugin is only supported in scalar variants. The vectorized variants
+    record texture lookups into kernels, which requires the texels to be
+    resident in (device) memory.
+ */
+
+template <typename Float, typename Spectrum>
+class TiledBitmapTexture final : public Texture<Float, Spectrum> {
+public:
+    MI_IMPORT_TYPES(Texture)
+
+    /// Resolution of the cached tiles
+    static constexpr uint32_t TileSize = 64;
+
+    TiledBitmapTexture(const Properties &props) : Texture(props) {
+        if constexpr (dr::is_jit_v<Float>)
+            Throw("The \"tiledbitmap\" plugin is only supported in scalar variants.");
+
+        m_transform = props.get<ScalarTransform3f>("to_uv", ScalarTransform3f());
+        m_raw = props.get<bool>("raw", false);
+
+        std::string filter_mode_str = props.string("filter_type", "bilinear");
+        if (filter_mode_str == "nearest")
+            m_filter_mode = dr::FilterMode::Nearest;
+        else if (filter_mode_str == "bilinear")
+            m_filter_mode = dr::FilterMode::Linear;
+        else
+            Throw("Invalid filter type \"%s\", must be one of: \"nearest\", or "
+                  "\"bilinear\"!", filter_mode_str);
+
+        std::string wrap_mode_str = props.string("wrap_mode", "repeat");
+        if (wrap_mode_str == "repeat")
+            m_wrap_mode = dr::WrapMode::Repeat;
+        else if (wrap_mode_str == "mirror")
+            m_wrap_mode = dr::WrapMode::Mirror;
+        else if (wrap_mode_str == "clamp")
+            m_wrap_mode = dr::WrapMode::Clamp;
+        else
+            Throw("Invalid wrap mode \"%s\", must be one of: \"repeat\", "
+                  "\"mirror\", or \"clamp\"!", wrap_mode_str);
+
+        FileResolver *fs = Thread::thread()->file_resolver();
+        fs::path file_path = fs->resolve(props.string("filename"));
+        m_name = file_path.filename().string();
+        m_reader = new BitmapRegionReader(file_path);
+        m_res = ScalarVector2u(m_reader->size());
+        m_channels = m_reader->channel_count();
+
+        m_tile_count = (m_res + TileSize - 1) / TileSize;
+        size_t tile_count = (size_t) dr::prod(m_tile_count);
+        m_tile_slots = std::unique_ptr<std::atomic<uint32_t>[]>(
+            new std::atomic<uint32_t>[tile_count]);
+        for (size_t i = 0; i < tile_count; ++i)
+            m_tile_slots[i].store(0, std::memory_order_relaxed);
+
+        Cache &c = cache();
+        std::lock_guard<std::mutex> guard(c.mutex);
+        if (props.has_property("cache_size")) {
+            ScalarFloat size = props.get<ScalarFloat>("cache_size");
+            if (size <= 0.f)
+                Throw("The tile cache size must be positive!");
+            size_t bytes = (size_t) (size * 1024.0 * 1024.0);
+            if (c.slots && bytes < c.budget)
+                Log(Warn, "The tile cache was already allocated, ignoring the "
+                          "smaller cache size of texture \"%s\".", m_name);
+            c.budget = std::min(c.budget, bytes);
+        }
+    }
+
+    ~TiledBitmapTexture() {
+        Cache &c = cache();
+        std::lock_guard<std::mutex> guard(c.mutex);
+        for (uint32_t i = 0; i < c.used; ++i) {
+            Slot &slot = c.slots[i];
+            if (slot.owner == this) {
+                slot.owner = nullptr;
+                slot.referenced.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_parameter("to_uv", m_transform, +ParamFlags::NonDifferentiable);
+    }
+
+    UnpolarizedSpectrum eval(const SurfaceInteraction3f &si,
+                             Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if constexpr (dr::is_jit_v<Float>) {
+            DRJIT_MARK_USED(si);
+            Throw("TiledBitmapTexture::eval() is only supported in scalar variants.");
+        } else {
+            if (m_channels == 3 && is_spectral_v<Spectrum> && m_raw)
+                Throw("The bitmap texture %s was queried for a spectrum, but "
+                      "texture conversion into spectra was explicitly disabled! "
+                      "(raw=true)", to_string());
+
+            if (!active)
+                return dr::zeros<UnpolarizedSpectrum>();
+
+            float v[3];
+            interpolate(si.uv, v);
+
+            if (m_channels == 1)
+                return v[0];
+
+            Color3f color(v[0], v[1], v[2]);
+            if constexpr (is_monochromatic_v<Spectrum>)
+                return luminance(color);
+            else if constexpr (is_spectral_v<Spectrum>)
+                return srgb_model_eval<UnpolarizedSpectrum>(color, si.wavelengths);
+            else
+                return color;
+        }
+    }
+
+    Float eval_1(const SurfaceInteraction3f &si,
+                 Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if constexpr (dr::is_jit_v<Float>) {
+            DRJIT_MARK_USED(si);
+            Throw("TiledBitmapTexture::eval_1() is only supported in scalar variants.");
+        } else {
+            if (m_channels == 3 && is_spectral_v<Spectrum> && !m_raw)
+                Throw("eval_1(): The bitmap texture %s was queried for a "
+                      "monochromatic value, but texture conversion to color "
+                      "spectra had previously been requested! (raw=false)",
+                      to_string());
+
+            if (!active)
+                return 0.f;
+
+            float v[3];
+            interpolate(si.uv, v);
+
+            if (m_channels == 1)
+                return v[0];
+            return luminance(Color3f(v[0], v[1], v[2]));
+        }
+    }
+
+    Color3f eval_3(const SurfaceInteraction3f &si,
+                   Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if constexpr (dr::is_jit_v<Float>) {
+            DRJIT_MARK_USED(si);
+            Throw("TiledBitmapTexture::eval_3() is only supported in scalar variants.");
+        } else {
+            if (m_channels != 3)
+                Throw("eval_3(): The bitmap texture %s was queried for a RGB "
+                      "value, but it is monochromatic!", to_string());
+            else if (is_spectral_v<Spectrum> && !m_raw)
+                Throw("eval_3(): The bitmap texture %s was queried for a RGB "
+                      "value, but texture conversion to color spectra had "
+                      "previously been requested! (raw=false)", to_string());
+
+            if (!active)
+                return 0.f;
+
+            float v[3];
+            interpolate(si.uv, v);
+            return Color3f(v[0], v[1], v[2]);
+        }
+    }
+
+    Float mean() const override {
+        std::call_once(m_mean_flag, [this] {
+            double sum = 0.0;
+            std::unique_ptr<float[]> band(
+                new float[(size_t) m_res.x() * TileSize * m_channels]);
+
+            // Stream through the image without going through the tile cache
+            for (uint32_t y = 0; y < m_res.y(); y += TileSize) {
+                ScalarVector2u size(m_res.x(), std::min(TileSize, m_res.y() - y));
+                m_reader->read(ScalarVector2u(0, y), size, band.get());
+                convert(band.get(), (size_t) dr::prod(size));
+
+                for (size_t i = 0; i < (size_t) dr::prod(size); ++i) {
+                    const float *v = band.get() + i * m_channels;
+                    if (m_channels == 1)
+                        sum += v[0];
+                    else if (is_spectral_v<Spectrum> && !m_raw)
+                        sum += srgb_model_mean(ScalarVector3f(v[0], v[1], v[2]));
+                    else
+                        sum += luminance(ScalarColor3f(v[0], v[1], v[2]));
+                }
+            }
+            m_mean = (ScalarFloat) (sum / (double) dr::prod(m_res));
+        });
+        return m_mean;
+    }
+
+    ScalarVector2i resolution() const override { return ScalarVector2i(m_res); }
+
+    bool is_spatially_varying() const override { return true; }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "TiledBitmapTexture[" << std::endl
+            << "  name = \"" << m_name << "\"," << std::endl
+            << "  resolution = \"" << resolution() << "\"," << std::endl
+            << "  tiles = " << dr::prod(m_tile_count) << "," << std::endl
+            << "  raw = " << (int) m_raw << "," << std::endl
+            << "  transform = " << string::indent(m_transform) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+private:
+    /**
+     * \brief A tile of the cache
+     *
+     * Lookups don't take any locks. Instead, they validate the texels they
+     * copied using the version counter, which is odd while the slot is being
+     * refilled (i.e. a sequence lock).
+     */
+    struct Slot {
+        std::atomic<uint32_t> version { 0 };
+        std::atomic<bool> referenced { false };
+        const TiledBitmapTexture *owner = nullptr;
+        uint32_t tile = 0;
+        std::unique_ptr<float[]> data;
+    };
+
+    /// Tile storage shared by all textures
+    struct Cache {
+        std::mutex mutex;
+        size_t budget = (size_t) 1024 * 1024 * 1024;
+        std::unique_ptr<Slot[]> slots;
+        uint32_t slot_count = 0, used = 0, hand = 0;
+    };
+
+    static Cache &cache() {
+        static Cache c;
+        return c;
+    }
+
+    /// Value of a tile table entry while the tile is being loaded
+    static constexpr uint32_t Loading = (uint32_t) -1;
+
+    /// Interpolate the texture at the given UV coordinates
+    void interpolate(const ScalarPoint2f &uv_, float *out) const {
+        ScalarPoint2f uv = m_transform.transform_affine(uv_);
+        ScalarVector2i res = ScalarVector2i(m_res);
+
+        if (m_filter_mode == dr::FilterMode::Nearest) {
+            ScalarPoint2i p = dr::floor2int<ScalarPoint2i>(uv * res);
+            fetch(wrap(p.x(), res.x()), wrap(p.y(), res.y()), out);
+            return;
+        }
+
+        uv = dr::fmadd(uv, res, -.5f);
+        ScalarPoint2i p = dr::floor2int<ScalarPoint2i>(uv);
+        ScalarPoint2f w1 = uv - ScalarPoint2f(p), w0 = 1.f - w1;
+
+        uint32_t x0 = wrap(p.x(), res.x()), x1 = wrap(p.x() + 1, res.x()),
+                 y0 = wrap(p.y(), res.y()), y1 = wrap(p.y() + 1, res.y());
+
+        float v00[3], v10[3], v01[3], v11[3];
+        fetch(x0, y0, v00);
+        fetch(x1, y0, v10);
+        fetch(x0, y1, v01);
+        fetch(x1, y1, v11);
+
+        for (uint32_t c = 0; c < m_channels; ++c) {
+            float v0 = dr::fmadd(w0.x(), v00[c], w1.x() * v10[c]),
+                  v1 = dr::fmadd(w0.x(), v01[c], w1.x() * v11[c]);
+            out[c] = dr::fmadd(w0.y(), v0, w1.y() * v1);
+        }
+    }
+
+    /// Map an integer texel coordinate into the texture
+    uint32_t wrap(int32_t x, int32_t size) const {
+        switch (m_wrap_mode) {
+            case dr::WrapMode::Clamp:
+                return (uint32_t) dr::clip(x, 0, size - 1);
+
+            case dr::WrapMode::Mirror:
+                x = x % (2 * size);
+                if (x < 0)
+                    x += 2 * size;
+                return (uint32_t) (x >= size ? 2 * size - 1 - x : x);
+
+            default:
+                x = x % size;
+                return (uint32_t) (x < 0 ? x + size : x);
+        }
+    }
+
+    /// Read the texel (x, y), loading its tile if needed
+    void fetch(uint32_t x, uint32_t y, float *out) const {
+        uint32_t tile = (y / TileSize) * m_tile_count.x() + x / TileSize;
+        size_t offset = ((y % TileSize) * TileSize + x % TileSize) * m_channels;
+        std::atomic<uint32_t> &entry = m_tile_slots[tile];
+
+        while (true) {
+            uint32_t index = entry.load(std::memory_order_acquire);
+
+            if (index == 0) {
+                load_tile(tile);
+                continue;
+            } else if (index == Loading) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            Slot &slot = cache().slots[index - 1];
+            uint32_t version = slot.version.load(std::memory_order_acquire);
+            if (version & 1)
+                continue;
+
+            for (uint32_t c = 0; c < m_channels; ++c)
+                out[c] = slot.data[offset + c];
+
+            // Retry if the slot was refilled while copying
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.version.load(std::memory_order_relaxed) != version ||
+                entry.load(std::memory_order_relaxed) != index)
+                continue;
+
+            if (!slot.referenced.load(std::memory_order_relaxed))
+                slot.referenced.store(true, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    /// Load a tile into the cache, evicting another one if necessary
+    void load_tile(uint32_t tile) const {
+        Cache &c = cache();
+        std::atomic<uint32_t> &entry = m_tile_slots[tile];
+        uint32_t index;
+
+        {
+            std::lock_guard<std::mutex> guard(c.mutex);
+
+            // Another thread may have started loading the tile in the meantime
+            uint32_t expected = 0;
+            if (!entry.compare_exchange_strong(expected, Loading))
+                return;
+
+            if (!c.slots) {
+                size_t slot_bytes = (size_t) TileSize * TileSize * 3 * sizeof(float);
+                c.slot_count = (uint32_t) std::max(c.budget / slot_bytes,
+                                                   (size_t) 16);
+                c.slots = std::unique_ptr<Slot[]>(new Slot[c.slot_count]);
+                Log(Debug, "Allocating a tile cache with %u tiles (%s)",
+                    c.slot_count, util::mem_string(c.slot_count * slot_bytes));
+            }
+
+            index = evict(c);
+            Slot &slot = c.slots[index];
+            slot.version.fetch_add(1, std::memory_order_acq_rel);
+            if (slot.owner)
+                slot.owner->m_tile_slots[slot.tile].store(0, std::memory_order_release);
+            slot.owner = this;
+            slot.tile = tile;
+            if (!slot.data)
+                slot.data = std::unique_ptr<float[]>(
+                    new float[(size_t) TileSize * TileSize * 3]);
+        }
+
+        // Read the tile without holding the lock
+        Slot &slot = c.slots[index];
+        try {
+            ScalarVector2u offset = ScalarVector2u(tile % m_tile_count.x(),
+                                                   tile / m_tile_count.x()) * TileSize,
+                           size = dr::minimum(offset + TileSize, m_res) - offset;
+
+            std::unique_ptr<float[]> texels(
+                new float[(size_t) dr::prod(size) * m_channels]);
+            m_reader->read(offset, size, texels.get());
+            convert(texels.get(), (size_t) dr::prod(size));
+
+            for (uint32_t y = 0; y < size.y(); ++y)
+                std::memcpy(slot.data.get() + (size_t) y * TileSize * m_channels,
+                            texels.get() + (size_t) y * size.x() * m_channels,
+                            sizeof(float) * size.x() * m_channels);
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(c.mutex);
+            slot.owner = nullptr;
+            slot.version.fetch_add(1, std::memory_order_release);
+            entry.store(0, std::memory_order_release);
+            throw;
+        }
+
+        slot.referenced.store(true, std::memory_order_relaxed);
+        slot.version.fetch_add(1, std::memory_order_release);
+        entry.store(index + 1, std::memory_order_release);
+    }
+
+    /// Pick a slot to (re)fill using the clock algorithm. Requires the cache lock.
+    static uint32_t evict(Cache &c) {
+        if (c.used < c.slot_count)
+            return c.used++;
+
+        while (true) {
+            uint32_t index = c.hand;
+            c.hand = (c.hand + 1) % c.slot_count;
+            Slot &slot = c.slots[index];
+
+            // Skip slots that are being filled by other threads
+            if (slot.version.load(std::memory_order_acquire) & 1)
+                continue;
+            if (slot.referenced.exchange(false, std::memory_order_relaxed))
+                continue;
+            return index;
+        }
+    }
+
+    /// Convert RGB texels to spectral coefficients (if requested)
+    void convert(float *data, size_t pixel_count) const {
+        if (!is_spectral_v<Spectrum> || m_raw || m_channels != 3)
+            return;
+
+        for (size_t i = 0; i < pixel_count; ++i, data += 3) {
+            ScalarColor3f value = srgb_model_fetch(ScalarColor3f(data[0], data[1], data[2]));
+            data[0] = value[0];
+            data[1] = value[1];
+            data[2] = value[2];
+        }
+    }
+
+private:
+    std::string m_name;
+    ScalarTransform3f m_transform;
+    ref<BitmapRegionReader> m_reader;
+    ScalarVector2u m_res, m_tile_count;
+    uint32_t m_channels;
+    dr::FilterMode m_filter_mode;
+    dr::WrapMode m_wrap_mode;
+    bool m_raw;
+
+    /// Index of the cache slot holding each tile plus one (zero: not resident)
+    std::unique_ptr<std::atomic<uint32_t>[]> m_tile_slots;
+
+    mutable std::once_flag m_mean_flag;
+    mutable ScalarFloat m_mean = 0.f;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(TiledBitmapTexture, Texture)
+MI_EXPORT_PLUGIN(TiledBitmapTexture, "Tiled bitmap texture")
+NAMESPACE_END(mitsuba)
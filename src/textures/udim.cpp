@@ -0,0 +1,427 @@
+#include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/thread.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/texture.h>
+#include <mitsuba/render/srgb.h>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _texture-udim:
+
+UDIM texture (:monosp:`udim`)
+-----------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename pattern of the tiles. It must contain the token ``<UDIM>``,
+     which is replaced by the four-digit tile number (e.g.
+     ``albedo.<UDIM>.exr`` for ``albedo.1001.exr``, ``albedo.1002.exr``, etc.)
+
+ * - filter_type
+   - |string|
+   - Specifies how pixel values are interpolated: ``bilinear`` (default) or
+     ``nearest``.
+
+ * - raw
+   - |bool|
+   - Should the transformation to the stored color data (e.g. sRGB to linear,
+     spectral upsampling) be disabled? (Default: false)
+
+ * - to_uv
+   - |transform|
+   - Specifies an optional 3x3 transformation matrix that will be applied to UV
+     values. A 4x4 matrix can also be provided, in which case the extra row and
+     column are ignored.
+   - |exposed|
+
+This plugin provides a single texture for a set of images in the UDIM layout,
+where tile :math:`1001 + u + 10 v` (with :math:`0 \le u < 10`) covers the UV
+range :math:`[u, u + 1] \times [v, v + 1]` in the convention of the modeling
+package. The V axis is flipped like the texture coordinates of the mesh
+loaders, hence tile 1001 covers :math:`[0, 1]^2` in Mitsuba's UV space, tile
+1011 the range :math:`[0, 1] \times [-1, 0]`, and so on. Each lookup finds its
+tile in constant time; the tiles may have different resolutions, and lookups
+are clamped to the borders of their tile. Lookups outside of the existing tiles
+evaluate to zero.
+
+All tiles must be either monochromatic or color images (any alpha channel is
+ignored). When the scene is loaded, only the first tile is read. In the scalar
+variants, the other tiles are loaded when a lookup first touches them. The
+vectorized variants load all tiles upfront and pack them into a single device
+buffer, so that a texture evaluation is a single (gather-based) lookup
+regardless of the number of tiles. The mean of the texture is the average over
+all tiles, querying it loads all of them.
+
+.. tabs::
+    .. code-tab:: xml
+        :name: udim-texture
+
+        <texture type="udim">
+            <string name="filename" value="textures/albedo.<UDIM>.exr"/>
+        </texture>
+
+    .. code-tab:: python
+
+        'type': 'udim',
+        'filename': 'textures/albedo.<UDIM>.exr'
+ */
+
+template <typename Float, typename Spectrum>
+class UDIMTexture final : public Texture<Float, Spectrum> {
+public:
+    MI_IMPORT_TYPES(Texture)
+
+    using FloatStorage  = DynamicBuffer<Float>;
+    using Int32Storage  = DynamicBuffer<Int32>;
+    using UInt32Storage = DynamicBuffer<UInt32>;
+
+    /// Number of tiles per row of the UDIM layout
+    static constexpr int32_t Columns = 10;
+
+    /// Largest supported number of tile rows (tiles 1001 to 1999)
+    static constexpr int32_t MaxRows = 100;
+
+    UDIMTexture(const Properties &props) : Texture(props) {
+        m_transform = props.get<ScalarTransform3f>("to_uv", ScalarTransform3f());
+        m_raw = props.get<bool>("raw", false);
+
+        std::string filter_mode_str = props.string("filter_type", "bilinear");
+        if (filter_mode_str == "nearest")
+            m_filter_mode = dr::FilterMode::Nearest;
+        else if (filter_mode_str == "bilinear")
+            m_filter_mode = dr::FilterMode::Linear;
+        else
+            Throw("Invalid filter type \"%s\", must be one of: \"nearest\", or "
+                  "\"bilinear\"!", filter_mode_str);
+
+        m_name = props.string("filename");
+        size_t token = m_name.find("<UDIM>");
+        if (token == std::string::npos)
+            Throw("The filename \"%s\" of the UDIM texture must contain the "
+                  "token \"<UDIM>\"!", m_name);
+
+        // Find the existing tiles
+        FileResolver *fs = Thread::thread()->file_resolver();
+        std::vector<int32_t> slots(Columns * MaxRows, -1);
+        std::vector<fs::path> paths;
+        for (int32_t slot = 0; slot < Columns * MaxRows; ++slot) {
+            std::string name = m_name;
+            name.replace(token, 6, std::to_string(1001 + slot));
+            fs::path path = fs->resolve(name);
+            if (!fs::exists(path))
+                continue;
+            slots[slot] = (int32_t) paths.size();
+            paths.push_back(path);
+            m_rows = slot / Columns + 1;
+        }
+
+        if (paths.empty())
+            Throw("No UDIM tiles matching \"%s\" were found!", m_name);
+        slots.resize(m_rows * Columns);
+
+        // The first tile determines the channel count and the resolution
+        ref<Bitmap> first = new Bitmap(paths[0]);
+        m_channels = (first->pixel_format() == Bitmap::PixelFormat::Y ||
+                      first->pixel_format() == Bitmap::PixelFormat::YA) ? 1 : 3;
+        m_res = ScalarVector2i(first->size());
+
+        if constexpr (!dr::is_jit_v<Float>) {
+            m_slots = std::move(slots);
+            m_tile_count = (uint32_t) paths.size();
+            m_tiles = std::unique_ptr<Tile[]>(new Tile[m_tile_count]);
+            for (uint32_t i = 0; i < m_tile_count; ++i)
+                m_tiles[i].path = paths[i];
+
+            Tile &tile = m_tiles[0];
+            std::call_once(tile.loaded,
+                           [&] { tile.data = read_tile(first, tile.res); });
+        } else {
+            // Pack all tiles into a single buffer
+            std::vector<float> data;
+            std::vector<uint32_t> offsets, widths, heights;
+            double mean = 0.0;
+
+            for (size_t i = 0; i < paths.size(); ++i) {
+                ref<Bitmap> bitmap = i == 0 ? first : ref<Bitmap>(new Bitmap(paths[i]));
+                ScalarVector2u res;
+                std::unique_ptr<float[]> texels = read_tile(bitmap, res);
+                size_t count = (size_t) dr::prod(res) * m_channels;
+
+                if (data.size() + count > (size_t) 0xFFFFFFFFu)
+                    Throw("The UDIM texture \"%s\" is too large to be packed "
+                          "into a single buffer!", m_name);
+
+                offsets.push_back((uint32_t) data.size());
+                widths.push_back(res.x());
+                heights.push_back(res.y());
+                data.insert(data.end(), texels.get(), texels.get() + count);
+                mean += tile_mean(texels.get(), res);
+            }
+
+            m_tile_count = (uint32_t) paths.size();
+            m_mean = (ScalarFloat) (mean / (double) m_tile_count);
+            m_slots = dr::load<Int32Storage>(slots.data(), slots.size());
+            m_offsets = dr::load<UInt32Storage>(offsets.data(), offsets.size());
+            m_widths = dr::load<UInt32Storage>(widths.data(), widths.size());
+            m_heights = dr::load<UInt32Storage>(heights.data(), heights.size());
+            m_data = dr::load<FloatStorage>(data.data(), data.size());
+
+            Log(Debug, "Packed %u UDIM tiles of \"%s\" (%s)", m_tile_count,
+                m_name, util::mem_string(data.size() * sizeof(float)));
+        }
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_parameter("to_uv", m_transform, +ParamFlags::NonDifferentiable);
+    }
+
+    UnpolarizedSpectrum eval(const SurfaceInteraction3f &si,
+                             Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channels == 3 && is_spectral_v<Spectrum> && m_raw)
+            Throw("The UDIM texture %s was queried for a spectrum, but "
+                  "texture conversion into spectra was explicitly disabled! "
+                  "(raw=true)", to_string());
+
+        Color3f color = lookup(si, active);
+
+        if (m_channels == 1)
+            return color.x();
+        else if constexpr (is_monochromatic_v<Spectrum>)
+            return luminance(color);
+        else if constexpr (is_spectral_v<Spectrum>)
+            return srgb_model_eval<UnpolarizedSpectrum>(color, si.wavelengths);
+        else
+            return color;
+    }
+
+    Float eval_1(const SurfaceInteraction3f &si,
+                 Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channels == 3 && is_spectral_v<Spectrum> && !m_raw)
+            Throw("eval_1(): The UDIM texture %s was queried for a "
+                  "monochromatic value, but texture conversion to color "
+                  "spectra had previously been requested! (raw=false)",
+                  to_string());
+
+        Color3f color = lookup(si, active);
+        return m_channels == 1 ? color.x() : luminance(color);
+    }
+
+    Color3f eval_3(const SurfaceInteraction3f &si,
+                   Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channels != 3)
+            Throw("eval_3(): The UDIM texture %s was queried for a RGB "
+                  "value, but it is monochromatic!", to_string());
+        else if (is_spectral_v<Spectrum> && !m_raw)
+            Throw("eval_3(): The UDIM texture %s was queried for a RGB "
+                  "value, but texture conversion to color spectra had "
+                  "previously been requested! (raw=false)", to_string());
+
+        return lookup(si, active);
+    }
+
+    Float mean() const override {
+        if constexpr (!dr::is_jit_v<Float>) {
+            std::call_once(m_mean_flag, [this] {
+                double mean = 0.0;
+                for (uint32_t i = 0; i < m_tile_count; ++i) {
+                    const Tile &tile = load_tile(i);
+                    mean += tile_mean(tile.data.get(), tile.res);
+                }
+                m_mean = (ScalarFloat) (mean / (double) m_tile_count);
+            });
+        }
+        return m_mean;
+    }
+
+    ScalarVector2i resolution() const override { return m_res; }
+
+    bool is_spatially_varying() const override { return true; }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "UDIMTexture[" << std::endl
+            << "  name = \"" << m_name << "\"," << std::endl
+            << "  tiles = " << m_tile_count << "," << std::endl
+            << "  rows = " << m_rows << "," << std::endl
+            << "  raw = " << (int) m_raw << "," << std::endl
+            << "  transform = " << string::indent(m_transform) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+private:
+    /// A lazily loaded tile (scalar variants)
+    struct Tile {
+        fs::path path;
+        ScalarVector2u res = 0;
+        std::unique_ptr<float[]> data;
+        std::once_flag loaded;
+    };
+
+    /// Evaluate the texture at the given surface interaction
+    Color3f lookup(const SurfaceInteraction3f &si, Mask active) const {
+        Point2f uv = m_transform.transform_affine(si.uv);
+
+        // Tile containing the lookup (V is flipped by the mesh loaders)
+        Int32 u_tile = dr::floor2int<Int32>(uv.x()),
+              v_tile = dr::floor2int<Int32>(1.f - uv.y());
+        active &= u_tile >= 0 && u_tile < Columns && v_tile >= 0 &&
+                  v_tile < (int32_t) m_rows;
+
+        Point2f local(uv.x() - Float(u_tile), uv.y() + Float(v_tile));
+        UInt32 slot = UInt32(v_tile * Columns + u_tile);
+
+        if constexpr (!dr::is_jit_v<Float>) {
+            if (!active || m_slots[slot] < 0)
+                return 0.f;
+
+            const Tile &tile = load_tile((uint32_t) m_slots[slot]);
+            const float *data = tile.data.get();
+            return interpolate(local, Vector2i(tile.res), [&](const Point2i &p) {
+                const float *v =
+                    data + ((size_t) p.y() * tile.res.x() + p.x()) * m_channels;
+                return m_channels == 1 ? Color3f(v[0]) : Color3f(v[0], v[1], v[2]);
+            });
+        } else {
+            Int32 index = dr::gather<Int32>(m_slots, slot, active);
+            active &= index >= 0;
+
+            UInt32 offset = dr::gather<UInt32>(m_offsets, index, active);
+            Vector2i res(Int32(dr::gather<UInt32>(m_widths, index, active)),
+                         Int32(dr::gather<UInt32>(m_heights, index, active)));
+
+            return interpolate(local, res, [&](const Point2i &p) {
+                UInt32 i = offset + UInt32(p.y() * res.x() + p.x()) * m_channels;
+                Float r = dr::gather<Float>(m_data, i, active);
+                if (m_channels == 1)
+                    return Color3f(r);
+                return Color3f(r, dr::gather<Float>(m_data, i + 1u, active),
+                               dr::gather<Float>(m_data, i + 2u, active));
+            });
+        }
+    }
+
+    /**
+     * \brief Nearest or bilinear interpolation of the texels returned by
+     * <tt>fetch(Point2i)</tt>, clamped to a tile of resolution \c res
+     */
+    template <typename Fetch>
+    Color3f interpolate(Point2f uv, const Vector2i &res, const Fetch &fetch) const {
+        Point2f res_f(res);
+        Point2i max_texel(res - 1);
+        auto texel = [&](const Point2i &p) {
+            return fetch(dr::minimum(dr::maximum(p, 0), max_texel));
+        };
+
+        if (m_filter_mode == dr::FilterMode::Nearest)
+            return texel(dr::floor2int<Point2i>(uv * res_f));
+
+        uv = dr::fmadd(uv, res_f, -.5f);
+        Point2i p = dr::floor2int<Point2i>(uv);
+        Point2f w1 = uv - Point2f(p), w0 = 1.f - w1;
+
+        Color3f v00 = texel(p),
+                v10 = texel(p + Point2i(1, 0)),
+                v01 = texel(p + Point2i(0, 1)),
+                v11 = texel(p + Point2i(1, 1));
+
+        Color3f v0 = dr::fmadd(w0.x(), v00, w1.x() * v10),
+                v1 = dr::fmadd(w0.x(), v01, w1.x() * v11);
+        return dr::fmadd(w0.y(), v0, w1.y() * v1);
+    }
+
+    /// Return the tile with index \c i, loading it upon first access
+    const Tile &load_tile(uint32_t i) const {
+        Tile &tile = m_tiles[i];
+        std::call_once(tile.loaded, [&] {
+            Log(Debug, "Loading UDIM tile \"%s\"", tile.path.filename().string());
+            ref<Bitmap> bitmap = new Bitmap(tile.path);
+            tile.data = read_tile(bitmap, tile.res);
+        });
+        return tile;
+    }
+
+    /// Convert the texels of a tile to (linear) float values
+    std::unique_ptr<float[]> read_tile(const Bitmap *bitmap, ScalarVector2u &res) const {
+        ref<Bitmap> converted = bitmap->convert(
+            m_channels == 1 ? Bitmap::PixelFormat::Y : Bitmap::PixelFormat::RGB,
+            Struct::Type::Float32, m_raw ? bitmap->srgb_gamma() : false);
+
+        res = ScalarVector2u(converted->size());
+        size_t count = (size_t) dr::prod(res) * m_channels;
+        std::unique_ptr<float[]> data(new float[count]);
+        std::memcpy(data.get(), converted->data(), count * sizeof(float));
+
+        // Convert RGB texels to spectral coefficients (if requested)
+        if (is_spectral_v<Spectrum> && !m_raw && m_channels == 3) {
+            for (size_t j = 0; j < count; j += 3) {
+                ScalarColor3f value = srgb_model_fetch(
+                    ScalarColor3f(data[j], data[j + 1], data[j + 2]));
+                for (size_t k = 0; k < 3; ++k)
+                    data[j + k] = value[k];
+            }
+        }
+
+        return data;
+    }
+
+    /// Mean value of the converted texels of a tile
+    double tile_mean(const float *data, const ScalarVector2u &res) const {
+        double sum = 0.0;
+        size_t pixel_count = (size_t) dr::prod(res);
+        for (size_t i = 0; i < pixel_count; ++i) {
+            const float *v = data + i * m_channels;
+            if (m_channels == 1)
+                sum += v[0];
+            else if (is_spectral_v<Spectrum> && !m_raw)
+                sum += srgb_model_mean(ScalarVector3f(v[0], v[1], v[2]));
+            else
+                sum += luminance(ScalarColor3f(v[0], v[1], v[2]));
+        }
+        return sum / (double) pixel_count;
+    }
+
+private:
+    std::string m_name;
+    ScalarTransform3f m_transform;
+    dr::FilterMode m_filter_mode;
+    bool m_raw;
+    uint32_t m_channels;
+    uint32_t m_rows = 0;
+    uint32_t m_tile_count = 0;
+    ScalarVector2i m_res;
+
+    /// Tile index of each UDIM slot (or -1), resident tiles (scalar variants)
+    std::conditional_t<dr::is_jit_v<Float>, Int32Storage, std::vector<int32_t>> m_slots;
+    std::unique_ptr<Tile[]> m_tiles;
+
+    /// Packed tiles (vectorized variants)
+    FloatStorage m_data;
+    UInt32Storage m_offsets, m_widths, m_heights;
+
+    mutable std::once_flag m_mean_flag;
+    mutable ScalarFloat m_mean = 0.f;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(UDIMTexture, Texture)
+MI_EXPORT_PLUGIN(UDIMTexture, "UDIM texture")
+NAMESPACE_END(mitsuba)
@@ -79,6 +79,9 @@ public:
 
     bool is_spatially_varying() const override { return true; }
 
+    // The volume is looked up at the intersection position
+    uint32_t ray_flags() const override { return +RayFlags::Empty; }
+
     ScalarFloat max() const override { return m_volume->max(); };
 
     std::string to_string() const override {
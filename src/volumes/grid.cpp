@@ -1,5 +1,6 @@
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/resource.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/string.h>
 #include <mitsuba/core/transform.h>
@@ -8,6 +9,7 @@
 #include <mitsuba/render/volumegrid.h>
 #include <drjit/dynamic.h>
 #include <drjit/texture.h>
+#include <nanothread/nanothread.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -78,16 +80,46 @@ Grid-based volume data source (:monosp:`gridvolume`)
    - |transform|
    - Specifies an optional 4x4 transformation matrix that will be applied to volume coordinates.
 
+ * - format
+   - |string|
+   - Specifies the underlying storage of the volume data. The following options
+     are currently available:
+
+     - ``variant`` (default): Use the corresponding floating point
+       representation of the rendering variant.
+
+     - ``fp16``: Store the volume in half precision, which halves its memory
+       footprint. Values are converted back to the variant's precision when
+       fetched. This option is not supported for :paramtype:`data` tensors.
+
  * - accel
    - |bool|
    - Hardware acceleration features can be used in CUDA mode. These features can
      cause small differences as hardware interpolation methods typically have a
      loss of precision (not exactly 32-bit arithmetic). (Default: true)
 
+ * - mip_levels
+   - |int|
+   - Number of levels of a MIP pyramid that is built when the volume is loaded,
+     including the full resolution, see below. A value of 0 builds all levels
+     down to a single voxel. (Default: 1, i.e. no pyramid)
+
 This class implements access to volume data stored on a 3D grid using a
-simple binary exchange format (compatible with Mitsuba 0.6). When appropriate,
+simple binary exchange format (compatible with Mitsuba 0.6). Single precision
+files are memory-mapped, and directly referenced by the volume in the LLVM
+variants rather than copied. When appropriate,
 spectral upsampling is applied at loading time to convert RGB values to
 spectra that can be used in the renderer.
+
+With ``mip_levels`` larger than 1, coarser versions of the grid are built by
+averaging blocks of 2x2x2 voxels of the previous level. Media can look them up
+for paths whose details are not visible, e.g. after the first scattering event
+(see the ``lod_step`` parameter of the :ref:`heterogeneous
+<medium-heterogeneous>` medium), which reduces the memory traffic of each
+lookup. The coarse levels are stored in single precision and are not
+differentiable. They are rebuilt when the data changes, and the upper bounds
+reported for majorants cover all levels. This option is not supported in
+combination with spectral upsampling.
 We provide a small `helper utility <https://github.com/mitsuba-renderer/mitsuba2-vdb-converter>`_
 to convert OpenVDB files to this format. The format uses a
 little endian encoding and is specified as follows:
@@ -103,8 +135,9 @@ little endian encoding and is specified as follows:
    * - Byte 4
      - File format version number (currently 3)
    * - Bytes 5-8
-     - Encoding identified (32-bit integer). Currently, only a value of 1 is
-       supported (float32-based representation)
+     - Encoding identifier (32-bit integer). Supported values are 1
+       (float32-based representation) and 2 (float16-based representation,
+       which halves the size of the file)
    * - Bytes 9-12
      - Number of cells along the X axis (32 bit integer)
    * - Bytes 13-16
@@ -188,6 +221,15 @@ public:
         m_raw = props.get<bool>("raw", false);
         m_accel = props.get<bool>("accel", true);
 
+        std::string format_str = props.string("format", "variant");
+        if (format_str == "variant")
+            m_half = false;
+        else if (format_str == "fp16")
+            m_half = true;
+        else
+            Throw("Invalid format \"%s\", must be one of: \"variant\", or "
+                  "\"fp16\"!", format_str);
+
         // Load volume data
         ref<VolumeGrid> volume_grid = nullptr;
         TensorXf* tensor = nullptr;
@@ -222,7 +264,8 @@ public:
                 fs::path file_path = fs->resolve(props.string("filename"));
                 if (!fs::exists(file_path))
                     Log(Error, "\"%s\": file does not exist!", file_path);
-                volume_grid = new VolumeGrid(file_path);
+                // Volumes that reference the same file share a single grid
+                volume_grid = ResourceCache::get<VolumeGrid>(file_path);
                 res = volume_grid->size();
                 channel_count = (uint32_t) volume_grid->channel_count();
             }
@@ -264,8 +307,7 @@ public:
                     (size_t) res.x(),
                     4
                 };
-                m_texture = Texture3f(TensorXf(scaled_data.get(), 4, shape),
-                                      m_accel, m_accel, filter_mode, wrap_mode);
+                init_texture(scaled_data.get(), shape, filter_mode, wrap_mode);
             } else if (volume_grid) {
                 size_t shape[4] = {
                     (size_t) res.z(),
@@ -273,13 +315,29 @@ public:
                     (size_t) res.x(),
                     channel_count
                 };
-                m_texture = Texture3f(TensorXf(volume_grid->data(), 4, shape),
-                                      m_accel, m_accel, filter_mode, wrap_mode);
+                if constexpr (dr::is_llvm_v<Float>) {
+                    if (volume_grid->is_mapped() && !m_half) {
+                        /* Reference the memory-mapped file from the texture
+                           instead of copying it (the grid owns the mapping) */
+                        using FloatStorage = DynamicBuffer<Float>;
+                        m_grid = volume_grid;
+                        m_texture = Texture3f(
+                            TensorXf(dr::map<FloatStorage>(m_grid->data(),
+                                                           size * channel_count, false),
+                                     4, shape),
+                            m_accel, m_accel, filter_mode, wrap_mode);
+                    }
+                }
+                if (!m_grid)
+                    init_texture(volume_grid->data(), shape, filter_mode, wrap_mode);
                 m_max = volume_grid->max();
                 m_max_per_channel.resize(volume_grid->channel_count());
                 volume_grid->max_per_channel(m_max_per_channel.data());
                 m_channel_count = channel_count;
             } else if (tensor) {
+                if (m_half)
+                    Throw("The \"fp16\" format is not supported for tensor "
+                          "input and requires a volume grid");
                 size_t shape[4] = {
                     (size_t) res.z(),
                     (size_t) res.y(),
@@ -304,10 +362,23 @@ public:
             m_fixed_max = true;
             m_max = props.get<ScalarFloat>("max_value");
         }
+
+        int mip_levels = props.get<int>("mip_levels", 1);
+        if (mip_levels < 0)
+            Throw("The number of MIP levels must be non-negative!");
+        m_mip_levels = (uint32_t) mip_levels;
+        if (m_mip_levels != 1 && is_spectral_v<Spectrum> &&
+            texture_shape()[3] == 4 && !m_raw)
+            Throw("MIP levels are not supported in combination with spectral "
+                  "upsampling.");
+        build_mip();
     }
 
     void traverse(TraversalCallback *callback) override {
-        callback->put_parameter("data", m_texture.tensor(), +ParamFlags::Differentiable);
+        if (m_half)
+            callback->put_parameter("data", m_texture_h.tensor(), +ParamFlags::NonDifferentiable);
+        else
+            callback->put_parameter("data", m_texture.tensor(), +ParamFlags::Differentiable);
         Base::traverse(callback);
     }
 
@@ -319,10 +390,16 @@ public:
                       "to have %d channels, only volumes with 1, 3 or 6 "
                       "channels are supported!", to_string(), channels);
 
-            m_texture.set_tensor(m_texture.tensor());
-
-            if (!m_fixed_max)
-                m_max = (float) dr::max_nested(dr::detach(m_texture.value()));
+            if (m_half) {
+                m_texture_h.set_tensor(m_texture_h.tensor());
+                if (!m_fixed_max)
+                    m_max = (float) dr::max_nested(m_texture_h.value());
+            } else {
+                m_texture.set_tensor(m_texture.tensor());
+                if (!m_fixed_max)
+                    m_max = (float) dr::max_nested(dr::detach(m_texture.value()));
+            }
+            build_mip();
         }
     }
 
@@ -385,6 +462,55 @@ public:
         }
     }
 
+    UnpolarizedSpectrum eval_mip(const Interaction3f &it, UInt32 level,
+                                 Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_mip.empty())
+            return eval(it, active);
+
+        const size_t channels = nchannels();
+        if (channels != 3 && channels != 1)
+            Throw("The GridVolume texture %s was queried for a spectrum, but "
+                  "has a number of channels which is not 1 or 3",
+                  to_string());
+        if (channels == 3 && is_spectral_v<Spectrum>)
+            Throw("The GridVolume texture %s was queried for a spectrum, but "
+                  "texture conversion into spectra was explicitly disabled! "
+                  "(raw=true)", to_string());
+
+        level = dr::minimum(level, (uint32_t) m_mip.size());
+        UnpolarizedSpectrum result = dr::zeros<UnpolarizedSpectrum>();
+
+        Mask active_level = active && level == 0u;
+        if (dr::any_or<true>(active_level))
+            dr::masked(result, active_level) = eval(it, active_level);
+
+        Point3f p = m_to_local * it.p;
+        for (uint32_t i = 0; i < (uint32_t) m_mip.size(); ++i) {
+            active_level = active && level == i + 1;
+            if (dr::none_or<false>(active_level))
+                continue;
+
+            if (channels == 1) {
+                Float value;
+                mip_eval(i, p, &value, active_level);
+                dr::masked(result, active_level) = value;
+            } else {
+                Color3f value;
+                mip_eval(i, p, value.data(), active_level);
+                if constexpr (is_monochromatic_v<Spectrum>)
+                    dr::masked(result, active_level) = luminance(value);
+                else if constexpr (!is_spectral_v<Spectrum>)
+                    dr::masked(result, active_level) = value;
+            }
+        }
+
+        return result;
+    }
+
+    uint32_t mip_levels() const override { return (uint32_t) m_mip.size() + 1; }
+
     void eval_n(const Interaction3f &it, Float *out, Mask active = true) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
 
@@ -434,8 +560,92 @@ public:
             out[i] = m_max_per_channel[i];
     }
 
+    void max_per_cell(const ScalarVector3u &cells, ScalarFloat *out) const override {
+        const size_t *shape = texture_shape();
+        ScalarVector3i res((int32_t) shape[2], (int32_t) shape[1], (int32_t) shape[0]);
+        size_t channels = shape[3];
+
+        // With spectral upsampling, the scale channel bounds the spectrum
+        size_t first_channel =
+            (is_spectral_v<Spectrum> && channels == 4 && !m_raw) ? 3 : 0;
+
+        bool linear = filter_mode() == dr::FilterMode::Linear;
+        dr::WrapMode wrap_mode = this->wrap_mode();
+
+        // Lookups at coarser MIP levels must be bounded as well
+        std::vector<std::pair<ScalarVector3i, std::vector<ScalarFloat>>> levels;
+        levels.emplace_back(res, host_values());
+        for (uint32_t i = 0; i < (uint32_t) m_mip.size(); ++i) {
+            const size_t *mip_shape = m_mip[i].shape();
+            levels.emplace_back(ScalarVector3i((int32_t) mip_shape[2],
+                                               (int32_t) mip_shape[1],
+                                               (int32_t) mip_shape[0]),
+                                host_values(i + 1));
+        }
+
+        auto wrap = [wrap_mode](int32_t x, int32_t size) {
+            switch (wrap_mode) {
+                case dr::WrapMode::Repeat:
+                    x %= size;
+                    return x < 0 ? x + size : x;
+
+                case dr::WrapMode::Mirror:
+                    x %= 2 * size;
+                    if (x < 0)
+                        x += 2 * size;
+                    return x >= size ? 2 * size - 1 - x : x;
+
+                default:
+                    return dr::clip(x, 0, size - 1);
+            }
+        };
+
+        // Range of voxels that lookups in cell 'c' of 'count' can access
+        auto voxel_range = [&](uint32_t c, uint32_t count, int32_t size) {
+            double lo = (double) c * size / count,
+                   hi = (double) (c + 1) * size / count;
+            if (linear)
+                return std::make_pair((int32_t) std::floor(lo - .5),
+                                      (int32_t) std::floor(hi - .5) + 1);
+            return std::make_pair((int32_t) std::floor(lo), (int32_t) std::floor(hi));
+        };
+
+        dr::parallel_for(
+            dr::blocked_range<uint32_t>(0, cells.z(), 1),
+            [&](const dr::blocked_range<uint32_t> &range) {
+                for (uint32_t cz = range.begin(); cz != range.end(); ++cz) {
+                    for (uint32_t cy = 0; cy < cells.y(); ++cy) {
+                        for (uint32_t cx = 0; cx < cells.x(); ++cx) {
+                            ScalarFloat value = -dr::Infinity<ScalarFloat>;
+                            for (const auto &[lres, values] : levels) {
+                                auto [z0, z1] = voxel_range(cz, cells.z(), lres.z());
+                                auto [y0, y1] = voxel_range(cy, cells.y(), lres.y());
+                                auto [x0, x1] = voxel_range(cx, cells.x(), lres.x());
+                                for (int32_t z = z0; z <= z1; ++z) {
+                                    size_t iz = (size_t) wrap(z, lres.z());
+                                    for (int32_t y = y0; y <= y1; ++y) {
+                                        size_t iy = (size_t) wrap(y, lres.y());
+                                        for (int32_t x = x0; x <= x1; ++x) {
+                                            size_t ix = (size_t) wrap(x, lres.x());
+                                            const ScalarFloat *v = values.data() +
+                                                ((iz * lres.y() + iy) * lres.x() + ix) * channels;
+                                            for (size_t ch = first_channel; ch < channels; ++ch)
+                                                value = dr::maximum(value, v[ch]);
+                                        }
+                                    }
+                                }
+                            }
+
+                            out[((size_t) cz * cells.y() + cy) * cells.x() + cx] = value;
+                        }
+                    }
+                }
+            }
+        );
+    }
+
     ScalarVector3i resolution() const override {
-        const size_t *shape = m_texture.shape();
+        const size_t *shape = texture_shape();
         return { (int) shape[2], (int) shape[1], (int) shape[0] };
     };
 
@@ -446,7 +656,9 @@ public:
             << "  bbox = " << string::indent(m_bbox) << "," << std::endl
             << "  dimensions = " << resolution() << "," << std::endl
             << "  max = " << m_max << "," << std::endl
-            << "  channels = " << m_texture.shape()[3] << std::endl
+            << "  channels = " << texture_shape()[3] << "," << std::endl
+            << "  mip_levels = " << mip_levels() << "," << std::endl
+            << "  format = " << (m_half ? "fp16" : "variant") << std::endl
             << "]";
         return oss.str();
     }
@@ -454,6 +666,147 @@ public:
     MI_DECLARE_CLASS()
 
 protected:
+    /// Create the texture from host data in the storage precision
+    void init_texture(const ScalarFloat *data, const size_t shape[4],
+                      dr::FilterMode filter_mode, dr::WrapMode wrap_mode) {
+        if (m_half) {
+            size_t size = shape[0] * shape[1] * shape[2] * shape[3];
+            std::unique_ptr<dr::half[]> data_h(new dr::half[size]);
+            for (size_t i = 0; i < size; ++i)
+                data_h[i] = dr::half(data[i]);
+            m_texture_h = Texture3f16(TensorXf16(data_h.get(), 4, shape),
+                                      m_accel, m_accel, filter_mode, wrap_mode);
+        } else {
+            m_texture = Texture3f(TensorXf(data, 4, shape), m_accel, m_accel,
+                                  filter_mode, wrap_mode);
+        }
+    }
+
+    /**
+     * Build the coarser levels of the MIP pyramid from the current data, by
+     * averaging blocks of 2x2x2 voxels (fewer along the last voxel of an axis
+     * with an odd resolution)
+     */
+    void build_mip() {
+        m_mip.clear();
+        if (m_mip_levels == 1)
+            return;
+
+        const size_t *shape = texture_shape();
+        size_t channels = shape[3];
+        ScalarVector3u res((uint32_t) shape[2], (uint32_t) shape[1],
+                           (uint32_t) shape[0]);
+        std::vector<ScalarFloat> values = host_values();
+
+        while ((m_mip_levels == 0 || m_mip.size() + 1 < m_mip_levels) &&
+               dr::any(res > 1u)) {
+            ScalarVector3u res_c = (res + 1u) / 2u;
+            std::vector<ScalarFloat> coarse((size_t) dr::prod(res_c) * channels);
+
+            dr::parallel_for(
+                dr::blocked_range<uint32_t>(0, res_c.z(), 1),
+                [&](const dr::blocked_range<uint32_t> &range) {
+                    for (uint32_t z = range.begin(); z != range.end(); ++z) {
+                        uint32_t z0 = 2 * z, z1 = dr::minimum(z0 + 2, res.z());
+                        for (uint32_t y = 0; y < res_c.y(); ++y) {
+                            uint32_t y0 = 2 * y, y1 = dr::minimum(y0 + 2, res.y());
+                            for (uint32_t x = 0; x < res_c.x(); ++x) {
+                                uint32_t x0 = 2 * x, x1 = dr::minimum(x0 + 2, res.x());
+                                ScalarFloat *out = coarse.data() +
+                                    (((size_t) z * res_c.y() + y) * res_c.x() + x) * channels;
+                                for (uint32_t iz = z0; iz < z1; ++iz)
+                                    for (uint32_t iy = y0; iy < y1; ++iy)
+                                        for (uint32_t ix = x0; ix < x1; ++ix) {
+                                            const ScalarFloat *v = values.data() +
+                                                (((size_t) iz * res.y() + iy) * res.x() + ix) * channels;
+                                            for (size_t ch = 0; ch < channels; ++ch)
+                                                out[ch] += v[ch];
+                                        }
+                                ScalarFloat inv_count =
+                                    1.f / (ScalarFloat) ((z1 - z0) * (y1 - y0) * (x1 - x0));
+                                for (size_t ch = 0; ch < channels; ++ch)
+                                    out[ch] *= inv_count;
+                            }
+                        }
+                    }
+                }
+            );
+
+            size_t shape_c[4] = { (size_t) res_c.z(), (size_t) res_c.y(),
+                                  (size_t) res_c.x(), channels };
+            m_mip.emplace_back(TensorXf(coarse.data(), 4, shape_c), m_accel,
+                               m_accel, filter_mode(), wrap_mode());
+            values = std::move(coarse);
+            res = res_c;
+        }
+    }
+
+    /// Evaluate the texture of level <tt>index + 1</tt> of the MIP pyramid
+    MI_INLINE void mip_eval(uint32_t index, const Point3f &p, Float *out,
+                            Mask active) const {
+        if (m_accel)
+            m_mip[index].template eval<Float>(p, out, active);
+        else
+            m_mip[index].template eval_nonaccel<Float>(p, out, active);
+    }
+
+    /// Copy the texel values of a MIP level to the host (in single precision)
+    std::vector<ScalarFloat> host_values(uint32_t level = 0) const {
+        using Storage = std::decay_t<decltype(m_texture.value())>;
+        Storage values = level > 0 ? Storage(dr::detach(m_mip[level - 1].value()))
+                         : m_half  ? Storage(m_texture_h.value())
+                                   : Storage(dr::detach(m_texture.value()));
+
+        auto &&host = dr::migrate(values, AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+        return std::vector<ScalarFloat>(host.data(), host.data() + host.size());
+    }
+
+    MI_INLINE const size_t *texture_shape() const {
+        return m_half ? m_texture_h.shape() : m_texture.shape();
+    }
+
+    MI_INLINE dr::FilterMode filter_mode() const {
+        return m_half ? m_texture_h.filter_mode() : m_texture.filter_mode();
+    }
+
+    MI_INLINE dr::WrapMode wrap_mode() const {
+        return m_half ? m_texture_h.wrap_mode() : m_texture.wrap_mode();
+    }
+
+    /// Evaluate the texture in the storage precision given at construction
+    MI_INLINE void texture_eval(const Point3f &p, Float *out, Mask active) const {
+        if (m_half) {
+            if (m_accel)
+                m_texture_h.template eval<Float>(p, out, active);
+            else
+                m_texture_h.template eval_nonaccel<Float>(p, out, active);
+        } else {
+            if (m_accel)
+                m_texture.template eval<Float>(p, out, active);
+            else
+                m_texture.template eval_nonaccel<Float>(p, out, active);
+        }
+    }
+
+    /// Fetch the texels of the trilinear stencil at \c p
+    MI_INLINE void texture_eval_fetch(const Point3f &p,
+                                      dr::Array<Float *, 8> &out,
+                                      Mask active) const {
+        if (m_half) {
+            if (m_accel)
+                m_texture_h.template eval_fetch<Float>(p, out, active);
+            else
+                m_texture_h.template eval_fetch_nonaccel<Float>(p, out, active);
+        } else {
+            if (m_accel)
+                m_texture.template eval_fetch<Float>(p, out, active);
+            else
+                m_texture.template eval_fetch_nonaccel<Float>(p, out, active);
+        }
+    }
+
     /**
      * \brief Returns the number of channels in the grid
      *
@@ -461,7 +814,7 @@ protected:
      * holds all scaling coefficients is omitted.
      */
     MI_INLINE size_t nchannels() const {
-        const size_t channels = m_texture.shape()[3];
+        const size_t channels = texture_shape()[3];
         // When spectral upsampling is requested, a fourth channel is added to
         // the internal texture data to handle scaling coefficients.
         if (is_spectral_v<Spectrum> && channels == 4 && !m_raw)
@@ -480,7 +833,7 @@ protected:
 
         Point3f p = m_to_local * it.p;
 
-        if (m_texture.filter_mode() == dr::FilterMode::Linear) {
+        if (filter_mode() == dr::FilterMode::Linear) {
             dr::Array<Float, 4> d000, d100, d010, d110, d001, d101, d011, d111;
             dr::Array<Float *, 8> fetch_values;
             fetch_values[0] = d000.data();
@@ -492,10 +845,7 @@ protected:
             fetch_values[6] = d011.data();
             fetch_values[7] = d111.data();
 
-            if (m_accel)
-                m_texture.template eval_fetch<Float>(p, fetch_values, active);
-            else
-                m_texture.template eval_fetch_nonaccel<Float>(p, fetch_values, active);
+            texture_eval_fetch(p, fetch_values, active);
 
             UnpolarizedSpectrum v000, v001, v010, v011, v100, v101, v110, v111;
             v000 = srgb_model_eval<UnpolarizedSpectrum>(dr::head<3>(d000), it.wavelengths);
@@ -536,10 +886,7 @@ protected:
             return result;
         } else {
             dr::Array<Float, 4> v;
-            if (m_accel)
-                m_texture.template eval<Float>(p, v.data(), active);
-            else
-                m_texture.template eval_nonaccel<Float>(p, v.data(), active);
+            texture_eval(p, v.data(), active);
 
             return v.w() * srgb_model_eval<UnpolarizedSpectrum>(dr::head<3>(v), it.wavelengths);
         }
@@ -555,10 +902,7 @@ protected:
 
         Point3f p = m_to_local * it.p;
         Float result;
-        if (m_accel)
-            m_texture.template eval<Float>(p, &result, active);
-        else
-            m_texture.template eval_nonaccel<Float>(p, &result, active);
+        texture_eval(p, &result, active);
 
         return result;
     }
@@ -574,10 +918,7 @@ protected:
 
         Point3f p = m_to_local * it.p;
         Color3f result;
-        if (m_accel)
-            m_texture.template eval<Float>(p, result.data(), active);
-        else
-            m_texture.template eval_nonaccel<Float>(p, result.data(), active);
+        texture_eval(p, result.data(), active);
 
         return result;
     }
@@ -593,10 +934,7 @@ protected:
 
         Point3f p = m_to_local * it.p;
         dr::Array<Float, 6> result;
-        if (m_accel)
-            m_texture.template eval<Float>(p, result.data(), active);
-        else
-            m_texture.template eval_nonaccel<Float>(p, result.data(), active);
+        texture_eval(p, result.data(), active);
 
         return result;
     }
@@ -612,17 +950,21 @@ protected:
         MI_MASK_ARGUMENT(active);
 
         Point3f p = m_to_local * it.p;
-        if (m_accel)
-            m_texture.template eval<Float>(p, out, active);
-        else
-            m_texture.template eval_nonaccel<Float>(p, out, active);
+        texture_eval(p, out, active);
     }
 
 protected:
     Texture3f m_texture;
+    Texture3f16 m_texture_h;
+    /// Memory-mapped grid referenced by \c m_texture (LLVM variants)
+    ref<VolumeGrid> m_grid;
+    bool m_half;
     bool m_accel;
     bool m_raw;
     bool m_fixed_max = false;
+    /// Coarser levels of the MIP pyramid and the requested number of levels
+    std::vector<Texture3f> m_mip;
+    uint32_t m_mip_levels;
     ScalarFloat m_max;
     std::vector<ScalarFloat> m_max_per_channel;
 };
@@ -0,0 +1,524 @@
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/volume.h>
+#include <mitsuba/render/volumegrid.h>
+#include <drjit/dynamic.h>
+#include <drjit-core/half.h>
+#include <nanothread/nanothread.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+.. _volume-sparsegridvolume:
+
+Sparse grid-based volume data source (:monosp:`sparsegridvolume`)
+-----------------------------------------------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename of the volume to be loaded (in the format of :ref:`gridvolume <volume-gridvolume>`)
+
+ * - grid
+   - :monosp:`VolumeGrid object`
+   - When creating a sparse grid volume at runtime, e.g. from Python or C++,
+     an existing ``VolumeGrid`` instance can be passed directly rather than
+     loading it from the filesystem with :paramtype:`filename`.
+
+ * - use_grid_bbox
+   - |bool|
+   - When set to ``true``, the bounding box information contained in the
+     ``VolumeGrid`` object (or the file it was loaded from) will be used. By
+     default, it is assumed that the grid is defined in the unit cube spanning
+     (0, 0, 0) x (1, 1, 1). (Default: false)
+
+ * - filter_type
+   - |string|
+   - Specifies how voxel values are interpolated. The following options are
+     currently available:
+
+     - ``trilinear`` (default): perform trilinear interpolation.
+
+     - ``nearest``: disable interpolation. In this mode, the plugin
+       performs nearest neighbor lookups of volume values.
+
+ * - threshold
+   - |float|
+   - Bricks whose values are all at most this threshold (in absolute value)
+     are not stored, and read as zero. (Default: 0)
+
+ * - raw
+   - |bool|
+   - Must be set to ``true`` to evaluate 3-channel volumes in spectral
+     variants, since this plugin does not perform spectral upsampling.
+     (Default: false)
+
+ * - to_world
+   - |transform|
+   - Specifies an optional 4x4 transformation matrix that will be applied to volume coordinates.
+
+This plugin stores volume data with 1 or 3 channels sparsely, in the spirit of
+the leaf nodes of OpenVDB and NanoVDB: the grid is partitioned into bricks of
+:math:`8^3` voxels, and only bricks containing non-zero values are kept in
+memory, which is referenced by a coarse table with one entry per brick. Its
+memory use is therefore proportional to the number of active voxels rather
+than to the resolution of the grid. Files are streamed one layer of bricks
+at a time, so that dense versions of large volumes are never held in memory
+during loading.
+
+Evaluations outside of the :math:`[0, 1]^3` range clamp coordinates to the
+edge of the volume. The per-brick maxima are used to build majorants of the
+volume, e.g. for the majorant grid of the :ref:`heterogeneous <medium-heterogeneous>`
+medium.
+
+.. tabs::
+    .. code-tab:: xml
+
+        <medium type="heterogeneous">
+            <volume type="sparsegridvolume" name="sigma_t">
+                <string name="filename" value="smoke.vol"/>
+            </volume>
+        </medium>
+
+    .. code-tab:: python
+
+        'type': 'heterogeneous',
+        'sigma_t': {
+            'type': 'sparsegridvolume',
+            'filename': 'smoke.vol'
+        }
+
+*/
+
+template <typename Float, typename Spectrum>
+class SparseGridVolume final : public Volume<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Volume, update_bbox, m_to_local, m_bbox, m_channel_count)
+    MI_IMPORT_TYPES(VolumeGrid)
+
+    using FloatStorage = DynamicBuffer<Float>;
+    using Int32Storage = DynamicBuffer<Int32>;
+
+    /// Number of voxels along each axis of a brick (as in NanoVDB leaf nodes)
+    static constexpr int32_t BrickLog2 = 3;
+    static constexpr int32_t BrickSize = 1 << BrickLog2;
+    static constexpr uint32_t BrickVoxels = BrickSize * BrickSize * BrickSize;
+
+    SparseGridVolume(const Properties &props) : Base(props) {
+        std::string filter_type_str = props.string("filter_type", "trilinear");
+        if (filter_type_str == "nearest")
+            m_linear = false;
+        else if (filter_type_str == "trilinear")
+            m_linear = true;
+        else
+            Throw("Invalid filter type \"%s\", must be one of: \"nearest\" or "
+                  "\"trilinear\"!", filter_type_str);
+
+        m_raw = props.get<bool>("raw", false);
+        ScalarFloat threshold = props.get<ScalarFloat>("threshold", 0.f);
+
+        ScalarBoundingBox3f grid_bbox;
+        if (props.has_property("grid")) {
+            if (props.has_property("filename"))
+                Throw("Cannot specify both \"grid\" and \"filename\".");
+            ref<Object> other = props.object("grid");
+            const VolumeGrid *grid = dynamic_cast<VolumeGrid *>(other.get());
+            if (!grid)
+                Throw("Property \"grid\" must be a VolumeGrid instance.");
+
+            ScalarVector3i res(grid->size());
+            size_t slice = (size_t) res.x() * res.y() * grid->channel_count();
+            const ScalarFloat *data = grid->data();
+            build(res, (uint32_t) grid->channel_count(), threshold,
+                  [&](int32_t z0, int32_t z1, ScalarFloat *out) {
+                      std::copy(data + z0 * slice, data + z1 * slice, out);
+                  });
+            ScalarTransform4f to_unit = grid->bbox_transform();
+            grid_bbox = ScalarBoundingBox3f(to_unit.inverse() * ScalarPoint3f(0.f),
+                                            to_unit.inverse() * ScalarPoint3f(1.f));
+        } else {
+            FileResolver *fs = Thread::thread()->file_resolver();
+            fs::path file_path = fs->resolve(props.string("filename"));
+            if (!fs::exists(file_path))
+                Log(Error, "\"%s\": file does not exist!", file_path);
+            grid_bbox = read(file_path, threshold);
+        }
+
+        if (m_channel_count != 1 && m_channel_count != 3)
+            Throw("Only volumes with 1 or 3 channels are supported (found %u)!",
+                  m_channel_count);
+        if (is_spectral_v<Spectrum> && m_channel_count == 3 && !m_raw)
+            Throw("Spectral upsampling of 3-channel volumes is not supported, "
+                  "the \"raw\" parameter must be set to true!");
+
+        if (props.get<bool>("use_grid_bbox", false)) {
+            m_to_local = ScalarTransform4f::scale(dr::rcp(grid_bbox.extents())) *
+                         ScalarTransform4f::translate(-grid_bbox.min) * m_to_local;
+            update_bbox();
+        }
+    }
+
+    UnpolarizedSpectrum eval(const Interaction3f &it,
+                             Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<UnpolarizedSpectrum>();
+
+        if (m_channel_count == 1)
+            return interpolate<1>(it, active)[0];
+
+        Color3f rgb(interpolate<3>(it, active));
+        if constexpr (is_monochromatic_v<Spectrum>)
+            return luminance(rgb);
+        else if constexpr (is_spectral_v<Spectrum>)
+            Throw("The SparseGridVolume %s was queried for a spectrum, but it "
+                  "stores raw 3-channel data!", to_string());
+        else
+            return rgb;
+    }
+
+    Float eval_1(const Interaction3f &it, Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<Float>();
+
+        if (m_channel_count == 1)
+            return interpolate<1>(it, active)[0];
+        return luminance(Color3f(interpolate<3>(it, active)));
+    }
+
+    Vector3f eval_3(const Interaction3f &it,
+                    Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channel_count != 3)
+            Throw("eval_3(): The SparseGridVolume %s was queried for a 3D "
+                  "vector, but it has %u channel(s)", to_string(), m_channel_count);
+        if (dr::none_or<false>(active))
+            return dr::zeros<Vector3f>();
+
+        return Vector3f(interpolate<3>(it, active));
+    }
+
+    void eval_n(const Interaction3f &it, Float *out, Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channel_count == 1) {
+            out[0] = interpolate<1>(it, active)[0];
+        } else {
+            dr::Array<Float, 3> result = interpolate<3>(it, active);
+            for (size_t i = 0; i < 3; ++i)
+                out[i] = result[i];
+        }
+    }
+
+    ScalarFloat max() const override { return m_max; }
+
+    void max_per_channel(ScalarFloat *out) const override {
+        for (size_t i = 0; i < m_max_per_channel.size(); ++i)
+            out[i] = m_max_per_channel[i];
+    }
+
+    void max_per_cell(const ScalarVector3u &cells, ScalarFloat *out) const override {
+        // Range of bricks that lookups in cell 'c' of 'count' can access
+        auto brick_range = [&](uint32_t c, uint32_t count, int32_t size) {
+            double lo = (double) c * size / count,
+                   hi = (double) (c + 1) * size / count;
+            int32_t v0, v1;
+            if (m_linear) {
+                v0 = (int32_t) std::floor(lo - .5);
+                v1 = (int32_t) std::floor(hi - .5) + 1;
+            } else {
+                v0 = (int32_t) std::floor(lo);
+                v1 = (int32_t) std::floor(hi);
+            }
+            v0 = dr::clip(v0, 0, size - 1);
+            v1 = dr::clip(v1, 0, size - 1);
+            return std::make_pair(v0 >> BrickLog2, v1 >> BrickLog2);
+        };
+
+        dr::parallel_for(
+            dr::blocked_range<uint32_t>(0, cells.z(), 1),
+            [&](const dr::blocked_range<uint32_t> &range) {
+                for (uint32_t cz = range.begin(); cz != range.end(); ++cz) {
+                    auto [z0, z1] = brick_range(cz, cells.z(), m_res.z());
+                    for (uint32_t cy = 0; cy < cells.y(); ++cy) {
+                        auto [y0, y1] = brick_range(cy, cells.y(), m_res.y());
+                        for (uint32_t cx = 0; cx < cells.x(); ++cx) {
+                            auto [x0, x1] = brick_range(cx, cells.x(), m_res.x());
+
+                            ScalarFloat value = 0.f;
+                            for (int32_t z = z0; z <= z1; ++z)
+                                for (int32_t y = y0; y <= y1; ++y)
+                                    for (int32_t x = x0; x <= x1; ++x)
+                                        value = dr::maximum(
+                                            value, m_brick_max[brick_index(x, y, z)]);
+
+                            out[((size_t) cz * cells.y() + cy) * cells.x() + cx] = value;
+                        }
+                    }
+                }
+            }
+        );
+    }
+
+    ScalarVector3i resolution() const override { return m_res; }
+
+    std::string to_string() const override {
+        size_t bricks = dr::prod(ScalarVector<size_t, 3>(m_bricks));
+        std::ostringstream oss;
+        oss << "SparseGridVolume[" << std::endl
+            << "  to_local = " << string::indent(m_to_local, 13) << "," << std::endl
+            << "  bbox = " << string::indent(m_bbox) << "," << std::endl
+            << "  dimensions = " << m_res << "," << std::endl
+            << "  max = " << m_max << "," << std::endl
+            << "  channels = " << m_channel_count << "," << std::endl
+            << "  active_bricks = " << m_active_bricks << " / " << bricks << "," << std::endl
+            << "  data = [ " << util::mem_string(
+                   (size_t) m_active_bricks * BrickVoxels * m_channel_count * sizeof(ScalarFloat) +
+                   bricks * sizeof(int32_t)) << " of volume data ]" << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+
+protected:
+    /// Stream the volume from a file in the format of 'gridvolume'
+    ScalarBoundingBox3f read(const fs::path &path, ScalarFloat threshold) {
+        ref<FileStream> stream = new FileStream(path);
+
+        char header[3];
+        stream->read(header, 3);
+        if (header[0] != 'V' || header[1] != 'O' || header[2] != 'L')
+            Throw("Invalid volume file!");
+        uint8_t version;
+        stream->read(version);
+        if (version != 3)
+            Throw("Invalid version, currently only version 3 is supported (found %d)", version);
+        int32_t data_type;
+        stream->read(data_type);
+        if (data_type != 1 && data_type != 2)
+            Throw("Wrong type, currently only type == 1 (Float32) and type == 2 "
+                  "(Float16) data are supported (found type = %d)", data_type);
+
+        ScalarVector3i res;
+        int32_t channel_count;
+        stream->read(res.x());
+        stream->read(res.y());
+        stream->read(res.z());
+        stream->read(channel_count);
+
+        float dims[6];
+        stream->read_array(dims, 6);
+
+        std::vector<float> slab;
+        std::vector<uint16_t> slab_h;
+        build(res, (uint32_t) channel_count, threshold,
+              [&](int32_t z0, int32_t z1, ScalarFloat *out) {
+                  size_t count = (size_t) (z1 - z0) * res.x() * res.y() * channel_count;
+                  if (data_type == 2) {
+                      slab_h.resize(count);
+                      stream->read_array(slab_h.data(), count);
+                      for (size_t i = 0; i < count; ++i)
+                          out[i] = (ScalarFloat) (float) dr::half::from_binary(slab_h[i]);
+                  } else if constexpr (std::is_same_v<ScalarFloat, float>) {
+                      stream->read_array(out, count);
+                  } else {
+                      slab.resize(count);
+                      stream->read_array(slab.data(), count);
+                      std::copy(slab.begin(), slab.end(), out);
+                  }
+              });
+
+        Log(Debug, "Loaded sparse grid volume data from \"%s\": dimensions %s, "
+            "%u active bricks, max value %f", path.filename(), m_res,
+            m_active_bricks, m_max);
+
+        return ScalarBoundingBox3f(ScalarPoint3f(dims[0], dims[1], dims[2]),
+                                   ScalarPoint3f(dims[3], dims[4], dims[5]));
+    }
+
+    /**
+     * \brief Build the sparse representation of a volume
+     *
+     * The function \c load_slab(z0, z1, out) must write the voxels of the
+     * z-slices <tt>[z0, z1)</tt> in the layout of the volume file to \c out.
+     * It is called once per layer of bricks in increasing order of \c z0.
+     */
+    template <typename LoadSlab>
+    void build(const ScalarVector3i &res, uint32_t channels,
+               ScalarFloat threshold, LoadSlab &&load_slab) {
+        if (dr::any(res <= 0))
+            Throw("Invalid volume resolution %s!", res);
+
+        m_res = res;
+        m_res_f = ScalarVector3f(res);
+        m_channel_count = channels;
+        m_bricks = (res + BrickSize - 1) >> BrickLog2;
+
+        size_t brick_count = dr::prod(ScalarVector<size_t, 3>(m_bricks)),
+               brick_floats = (size_t) BrickVoxels * channels,
+               slice = (size_t) res.x() * res.y() * channels;
+
+        std::vector<int32_t> table(brick_count, -1);
+        std::vector<ScalarFloat> data;
+        std::unique_ptr<ScalarFloat[]> slab(new ScalarFloat[slice * BrickSize]);
+        m_brick_max.assign(brick_count, 0.f);
+        m_max_per_channel.assign(channels, 0.f);
+        m_active_bricks = 0;
+
+        for (int32_t bz = 0; bz < m_bricks.z(); ++bz) {
+            int32_t z0 = bz * BrickSize,
+                    z1 = std::min(z0 + BrickSize, res.z());
+            load_slab(z0, z1, slab.get());
+
+            for (int32_t by = 0; by < m_bricks.y(); ++by) {
+                for (int32_t bx = 0; bx < m_bricks.x(); ++bx) {
+                    ScalarFloat brick_max = 0.f;
+                    bool brick_active = false;
+                    size_t offset = data.size();
+                    data.resize(offset + brick_floats, 0.f);
+
+                    // Copy the brick (voxels outside of the volume remain zero)
+                    for (int32_t z = 0; z < z1 - z0; ++z) {
+                        for (int32_t y = 0; y < BrickSize; ++y) {
+                            int32_t gy = by * BrickSize + y;
+                            if (gy >= res.y())
+                                break;
+                            for (int32_t x = 0; x < BrickSize; ++x) {
+                                int32_t gx = bx * BrickSize + x;
+                                if (gx >= res.x())
+                                    break;
+                                const ScalarFloat *src =
+                                    slab.get() + (((size_t) z * res.y() + gy) * res.x() + gx) * channels;
+                                ScalarFloat *dst = data.data() + offset +
+                                    ((size_t) (z * BrickSize + y) * BrickSize + x) * channels;
+                                for (uint32_t ch = 0; ch < channels; ++ch) {
+                                    dst[ch] = src[ch];
+                                    brick_active |= dr::abs(src[ch]) > threshold;
+                                    brick_max = dr::maximum(brick_max, src[ch]);
+                                    m_max_per_channel[ch] =
+                                        dr::maximum(m_max_per_channel[ch], src[ch]);
+                                }
+                            }
+                        }
+                    }
+
+                    if (brick_active) {
+                        uint32_t index = brick_index(bx, by, bz);
+                        table[index] = (int32_t) m_active_bricks++;
+                        m_brick_max[index] = brick_max;
+                    } else {
+                        data.resize(offset);
+                    }
+                }
+            }
+        }
+
+        m_max = 0.f;
+        for (ScalarFloat value : m_max_per_channel)
+            m_max = dr::maximum(m_max, value);
+
+        // Keep at least one element so that gathers are well-defined
+        if (data.empty())
+            data.push_back(0.f);
+
+        m_table = dr::load<Int32Storage>(table.data(), table.size());
+        m_data = dr::load<FloatStorage>(data.data(), data.size());
+    }
+
+    /// Linear index of a brick in the brick table
+    MI_INLINE uint32_t brick_index(int32_t x, int32_t y, int32_t z) const {
+        return (uint32_t) ((z * m_bricks.y() + y) * m_bricks.x() + x);
+    }
+
+    /**
+     * \brief Look up the voxel \c ijk (clamped to the volume)
+     *
+     * Returns the index of its first channel in \c m_data, and whether the
+     * voxel belongs to an active brick.
+     */
+    MI_INLINE std::pair<UInt32, Mask> voxel_index(const Vector3i &ijk,
+                                                  Mask active) const {
+        Vector3i p = dr::clip(ijk, 0, m_res - 1),
+                 brick = p >> BrickLog2,
+                 local = p & (BrickSize - 1);
+
+        UInt32 table_index = UInt32(
+            (brick.z() * m_bricks.y() + brick.y()) * m_bricks.x() + brick.x());
+        Int32 slot = dr::gather<Int32>(m_table, table_index, active);
+        Mask valid = active && slot >= 0;
+
+        UInt32 voxel = UInt32(
+            (local.z() * BrickSize + local.y()) * BrickSize + local.x());
+        return { (UInt32(slot) * BrickVoxels + voxel) * m_channel_count, valid };
+    }
+
+    /// Evaluate the \c N channels of the volume at the given interaction
+    template <size_t N>
+    dr::Array<Float, N> interpolate(const Interaction3f &it, Mask active) const {
+        using Values = dr::Array<Float, N>;
+
+        Point3f p = m_to_local * it.p;
+        Values result(0.f);
+
+        if (!m_linear) {
+            auto [index, valid] =
+                voxel_index(dr::floor2int<Vector3i>(p * m_res_f), active);
+            for (size_t ch = 0; ch < N; ++ch)
+                result[ch] = dr::gather<Float>(m_data, index + (uint32_t) ch, valid);
+            return result;
+        }
+
+        Vector3f pos = dr::fmadd(p, m_res_f, -.5f);
+        Vector3i i0 = dr::floor2int<Vector3i>(pos);
+        Vector3f w1 = pos - Vector3f(i0),
+                 w0 = 1.f - w1;
+
+        for (int32_t k = 0; k < 8; ++k) {
+            Vector3i offset(k & 1, (k >> 1) & 1, k >> 2);
+            Float weight = ((k & 1) ? w1.x() : w0.x()) *
+                           ((k & 2) ? w1.y() : w0.y()) *
+                           ((k & 4) ? w1.z() : w0.z());
+
+            auto [index, valid] = voxel_index(i0 + offset, active);
+            for (size_t ch = 0; ch < N; ++ch)
+                result[ch] = dr::fmadd(
+                    weight, dr::gather<Float>(m_data, index + (uint32_t) ch, valid),
+                    result[ch]);
+        }
+
+        return result;
+    }
+
+protected:
+    bool m_linear;
+    bool m_raw;
+
+    ScalarVector3i m_res, m_bricks;
+    ScalarVector3f m_res_f;
+    uint32_t m_active_bricks = 0;
+
+    /// Index of each brick in \c m_data, or -1 for inactive bricks
+    Int32Storage m_table;
+    /// Voxel values of the active bricks
+    FloatStorage m_data;
+
+    ScalarFloat m_max;
+    std::vector<ScalarFloat> m_max_per_channel;
+    /// Maximum value of each brick (zero for inactive bricks)
+    std::vector<ScalarFloat> m_brick_max;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(SparseGridVolume, Volume)
+MI_EXPORT_PLUGIN(SparseGridVolume, "SparseGridVolume texture")
+
+NAMESPACE_END(mitsuba)
@@ -114,3 +114,140 @@ def test06_eval_per_channel(variants_all_rgb, tmpdir):
     it.p = mi.Point3f(1.0)
     print(vol.eval_n(it))
     assert dr.allclose(vol.eval_n(it), [1.0, 2.0, 3.0, 4.0, 5.0, 6.0])
+
+
+@pytest.mark.parametrize('filter_type', ['nearest', 'trilinear'])
+def test07_fp16_format(variants_all_rgb, tmpdir, filter_type):
+    tmp_file = os.path.join(str(tmpdir), "out.vol")
+    grid = dr.full(mi.TensorXf, 1, [3, 3, 3, 3])
+    grid[0, 0, 0, 0] = 0.0
+    grid[1, 1, 1, 1] = 0.5
+    grid[1, 2, 1, 2] = 0.25
+    mi.VolumeGrid(grid).write(tmp_file)
+
+    def load(format):
+        return mi.load_dict({
+            'type' : 'gridvolume',
+            'filename' : tmp_file,
+            'filter_type' : filter_type,
+            'raw' : True,
+            'format' : format
+        })
+
+    vol, vol_h = load('variant'), load('fp16')
+    assert dr.all(vol_h.resolution() == vol.resolution())
+    assert dr.allclose(vol_h.max(), vol.max())
+
+    it = dr.zeros(mi.Interaction3f, 1)
+    for p in [[0, 0, 0], [1 / 3, 1 / 3, 1 / 3], [0.4, 0.55, 0.7]]:
+        it.p = p
+        assert dr.allclose(vol_h.eval_3(it), vol.eval_3(it), atol=1e-3)
+
+    with pytest.raises(RuntimeError, match='Invalid format'):
+        load('u8')
+
+
+@pytest.mark.parametrize('filter_type', ['nearest', 'trilinear'])
+def test08_max_per_cell(variants_all_rgb, tmpdir, filter_type):
+    import numpy as np
+    tmp_file = os.path.join(str(tmpdir), "out.vol")
+    rng = np.random.default_rng(seed=0)
+    values = rng.random((8, 6, 10, 1)).astype(np.float32) ** 4
+    mi.VolumeGrid(values).write(tmp_file)
+    vol = mi.load_dict({
+        'type' : 'gridvolume',
+        'filename' : tmp_file,
+        'filter_type' : filter_type,
+    })
+
+    cells = [3, 2, 4]
+    majorants = np.array(vol.max_per_cell(cells)).reshape(cells[::-1])
+    assert np.isclose(majorants.max(), vol.max())
+
+    # Lookups within a cell never exceed its majorant
+    n = 10000
+    p = rng.random((n, 3))
+    it = dr.zeros(mi.Interaction3f, n)
+    it.p = mi.Point3f(p[:, 0], p[:, 1], p[:, 2])
+    value = np.array(vol.eval_1(it))
+    cell = np.floor(p * cells).astype(int)
+    assert np.all(value <= majorants[cell[:, 2], cell[:, 1], cell[:, 0]] + 1e-5)
+
+
+def test09_mapped_and_fp16_files(variants_all_rgb, tmpdir):
+    import numpy as np
+    rng = np.random.default_rng(seed=0)
+    values = rng.random((5, 6, 7, 3)).astype(np.float32)
+
+    tmp_file = os.path.join(str(tmpdir), "out.vol")
+    tmp_file_h = os.path.join(str(tmpdir), "out_h.vol")
+    mi.VolumeGrid(values).write(tmp_file)
+    mi.VolumeGrid(values).write(tmp_file_h, half=True)
+    assert os.path.getsize(tmp_file_h) < 0.6 * os.path.getsize(tmp_file)
+
+    grid, grid_h = mi.VolumeGrid(tmp_file), mi.VolumeGrid(tmp_file_h)
+    assert grid.is_mapped() == ('double' not in mi.variant())
+    assert not grid_h.is_mapped()
+    assert np.allclose(np.array(grid), values)
+    assert np.allclose(np.array(grid_h), values, atol=1e-3)
+    assert np.allclose(grid.max_per_channel(), values.reshape(-1, 3).max(axis=0))
+    assert np.isclose(grid_h.max(), values.max(), atol=1e-3)
+
+    # Modifications of mapped grids are not written back to the file
+    np.array(grid, copy=False)[0, 0, 0, 0] = 10
+    assert np.allclose(np.array(mi.VolumeGrid(tmp_file)), values)
+
+    vol, vol_h = [mi.load_dict({ 'type' : 'gridvolume', 'filename' : f, 'raw' : True })
+                  for f in [tmp_file, tmp_file_h]]
+    it = dr.zeros(mi.Interaction3f, 1)
+    it.p = [0.3, 0.6, 0.45]
+    assert dr.allclose(vol_h.eval_3(it), vol.eval_3(it), atol=1e-3)
+
+
+@pytest.mark.parametrize('filter_type', ['nearest', 'trilinear'])
+def test10_mip_levels(variants_all_rgb, tmpdir, filter_type):
+    import numpy as np
+    tmp_file = os.path.join(str(tmpdir), "out.vol")
+    rng = np.random.default_rng(seed=0)
+    values = rng.random((8, 6, 10, 1)).astype(np.float32) ** 4
+    mi.VolumeGrid(values).write(tmp_file)
+
+    def load(mip_levels):
+        return mi.load_dict({
+            'type' : 'gridvolume',
+            'filename' : tmp_file,
+            'filter_type' : filter_type,
+            'mip_levels' : mip_levels
+        })
+
+    vol = load(0)
+    assert load(1).mip_levels() == 1
+    assert load(3).mip_levels() == 3
+    # (10, 6, 8) -> (5, 3, 4) -> (3, 2, 2) -> (2, 1, 1) -> (1, 1, 1)
+    assert vol.mip_levels() == 5
+
+    n = 1000
+    p = rng.random((n, 3))
+    it = dr.zeros(mi.Interaction3f, n)
+    it.p = mi.Point3f(p[:, 0], p[:, 1], p[:, 2])
+    assert dr.allclose(vol.eval_mip(it, 0), vol.eval(it))
+
+    # The first coarser level averages blocks of 2x2x2 voxels
+    if filter_type == 'nearest':
+        block_mean = values[..., 0].reshape(4, 2, 3, 2, 5, 2).mean(axis=(1, 3, 5))
+        cell = np.floor(p * [5, 3, 4]).astype(int)
+        assert np.allclose(np.array(vol.eval_mip(it, 1))[:, 0],
+                           block_mean[cell[:, 2], cell[:, 1], cell[:, 0]], atol=1e-5)
+
+    # Levels are clamped to the coarsest one, which holds a single voxel
+    coarsest = np.array(vol.eval_mip(it, 100))
+    assert np.allclose(coarsest, coarsest[0])
+    assert np.allclose(coarsest, np.array(vol.eval_mip(it, 4)))
+
+    # The majorants bound the lookups at all levels
+    cells = [3, 2, 4]
+    majorants = np.array(vol.max_per_cell(cells)).reshape(cells[::-1])
+    cell = np.floor(p * cells).astype(int)
+    for level in range(5):
+        value = np.array(vol.eval_mip(it, level))[:, 0]
+        assert np.all(value <= majorants[cell[:, 2], cell[:, 1], cell[:, 0]] + 1e-5)
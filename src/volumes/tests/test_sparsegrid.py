@@ -0,0 +1,62 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+import os
+
+
+def write_sparse_volume(tmpdir, channels):
+    import numpy as np
+    rng = np.random.default_rng(seed=0)
+    values = np.zeros((20, 13, 17, channels), dtype=np.float32)
+    values[2:9, 3:10, 1:6] = rng.random((7, 7, 5, channels))
+    values[15:, 10:, 12:] = 2.0
+    tmp_file = os.path.join(str(tmpdir), "sparse.vol")
+    mi.VolumeGrid(values).write(tmp_file)
+    return tmp_file
+
+
+@pytest.mark.parametrize('filter_type', ['nearest', 'trilinear'])
+@pytest.mark.parametrize('channels', [1, 3])
+def test01_eval(variants_all_rgb, tmpdir, filter_type, channels):
+    tmp_file = write_sparse_volume(tmpdir, channels)
+
+    def load(type):
+        return mi.load_dict({
+            'type' : type,
+            'filename' : tmp_file,
+            'filter_type' : filter_type,
+            'raw' : True
+        })
+
+    ref, vol = load('gridvolume'), load('sparsegridvolume')
+    assert dr.all(vol.resolution() == ref.resolution())
+    assert dr.allclose(vol.max(), ref.max())
+    assert 'active_bricks = 8 / 18' in str(vol)
+
+    n = 1000
+    it = dr.zeros(mi.Interaction3f, n)
+    it.p = [(dr.arange(mi.Float, n) * c) % 1.2 - 0.1 for c in [0.618034, 0.754878, 0.569840]]
+    assert dr.allclose(vol.eval_1(it), ref.eval_1(it), atol=1e-5)
+    if channels == 3:
+        assert dr.allclose(vol.eval_3(it), ref.eval_3(it), atol=1e-5)
+
+
+def test02_max_per_cell(variant_scalar_rgb, tmpdir):
+    import numpy as np
+    tmp_file = write_sparse_volume(tmpdir, 1)
+    ref, vol = [mi.load_dict({ 'type' : t, 'filename' : tmp_file })
+                for t in ['gridvolume', 'sparsegridvolume']]
+
+    # The per-brick maxima are conservative w.r.t. the dense per-cell maxima
+    cells = [3, 2, 4]
+    majorants = np.array(vol.max_per_cell(cells))
+    assert np.all(majorants >= np.array(ref.max_per_cell(cells)))
+    assert np.isclose(majorants.max(), 2.0)
+
+
+def test03_grid_object(variant_scalar_rgb, tmpdir):
+    grid = mi.VolumeGrid(write_sparse_volume(tmpdir, 1))
+    vol = mi.load_dict({ 'type' : 'sparsegridvolume', 'grid' : grid })
+    it = dr.zeros(mi.Interaction3f)
+    it.p = [0.95, 0.95, 0.95]
+    assert dr.allclose(vol.eval_1(it), 2.0)